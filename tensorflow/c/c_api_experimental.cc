@@ -8775,3 +8775,114 @@ void TF_AttrBuilderCheckCanRunOnDevice(TF_AttrBuilder* builder,
       tensorflow::DeviceType(device_type), builder->BuildNodeDef(),
       /* def = */ nullptr, /* kernel_class_name = */ nullptr);
 }
+
+struct TF_Callable {
+  TF_Session* session;
+  tensorflow::Session::CallableHandle handle;
+  int num_feeds;
+  int num_fetches;
+};
+
+TF_Callable* TF_SessionNewCallable(TF_Session* session,
+                                   const TF_Buffer* callable_options,
+                                   TF_Status* status) {
+  tensorflow::CallableOptions options;
+  if (!options.ParseFromArray(callable_options->data,
+                              callable_options->length)) {
+    status->status =
+        tensorflow::errors::InvalidArgument("Unparseable CallableOptions");
+    return nullptr;
+  }
+  if (session->extend_before_run &&
+      !tensorflow::ExtendSessionGraphHelper(session, status)) {
+    return nullptr;
+  }
+  tensorflow::Session::CallableHandle handle;
+  status->status = session->session->MakeCallable(options, &handle);
+  if (!status->status.ok()) return nullptr;
+  return new TF_Callable{session, handle, options.feed_size(),
+                         options.fetch_size()};
+}
+
+namespace {
+
+// Points `dst` at the buffer of `src`, without copying it, if the types of
+// both allow it. Returns false otherwise.
+bool ShareTensorBuffer(const tensorflow::Tensor& src, TF_Tensor* dst) {
+  if (src.dtype() == tensorflow::DT_STRING ||
+      src.dtype() == tensorflow::DT_RESOURCE || src.NumElements() == 0) {
+    return false;
+  }
+  tensorflow::TensorBuffer* buffer = tensorflow::TensorCApi::Buffer(src);
+  if (buffer != dst->buffer) {
+    buffer->Ref();
+    dst->buffer->Unref();
+    dst->buffer = buffer;
+  }
+  dst->dtype = static_cast<TF_DataType>(src.dtype());
+  dst->shape = src.shape();
+  return true;
+}
+
+}  // namespace
+
+void TF_CallableRun(TF_Callable* callable, TF_Tensor* const* input_values,
+                    int ninputs, TF_Tensor** output_values, int noutputs,
+                    TF_Buffer* run_metadata, TF_Status* status) {
+  if (ninputs != callable->num_feeds || noutputs != callable->num_fetches) {
+    status->status = tensorflow::errors::InvalidArgument(
+        "Expected ", callable->num_feeds, " inputs and ",
+        callable->num_fetches, " outputs, got ", ninputs, " and ", noutputs);
+    return;
+  }
+  std::vector<tensorflow::Tensor> feeds(ninputs);
+  for (int i = 0; i < ninputs; ++i) {
+    status->status = tensorflow::TF_TensorToTensor(input_values[i], &feeds[i]);
+    if (!status->status.ok()) return;
+  }
+  // The tensors already in `output_values` are passed in, so that a callable
+  // made with `fetch_into_provided_tensors` writes into their memory.
+  std::vector<tensorflow::Tensor> fetches(noutputs);
+  for (int i = 0; i < noutputs; ++i) {
+    if (output_values[i] != nullptr && output_values[i]->dtype != TF_STRING &&
+        output_values[i]->dtype != TF_RESOURCE) {
+      status->status =
+          tensorflow::TF_TensorToTensor(output_values[i], &fetches[i]);
+      if (!status->status.ok()) return;
+    }
+  }
+
+  tensorflow::RunMetadata run_metadata_proto;
+  status->status = callable->session->session->RunCallable(
+      callable->handle, feeds, &fetches,
+      run_metadata != nullptr ? &run_metadata_proto : nullptr);
+  if (!status->status.ok()) return;
+  if (run_metadata != nullptr) {
+    status->status =
+        tensorflow::MessageToBuffer(run_metadata_proto, run_metadata);
+    if (!status->status.ok()) return;
+  }
+
+  for (int i = 0; i < noutputs; ++i) {
+    const tensorflow::Tensor& src = fetches[i];
+    if (output_values[i] != nullptr &&
+        ShareTensorBuffer(src, output_values[i])) {
+      continue;
+    }
+    TF_Tensor* output = tensorflow::TF_TensorFromTensor(src, status);
+    if (!status->status.ok()) return;
+    if (output_values[i] != nullptr) {
+      // Keeps the caller's handle and releases its previous contents.
+      std::swap(*output, *output_values[i]);
+      TF_DeleteTensor(output);
+    } else {
+      output_values[i] = output;
+    }
+  }
+}
+
+void TF_DeleteCallable(TF_Callable* callable, TF_Status* status) {
+  status->status = callable->session->session->ReleaseCallable(
+      callable->handle);
+  delete callable;
+}
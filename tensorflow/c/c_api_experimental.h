@@ -202,6 +202,43 @@ TF_CAPI_EXPORT extern void TF_AttrBuilderSetTypeList(TF_AttrBuilder* builder,
 TF_CAPI_EXPORT extern void TF_AttrBuilderCheckCanRunOnDevice(
     TF_AttrBuilder* builder, const char* device_type, TF_Status* status);
 
+// A subgraph of the graph of a session, with fixed feeds and fetches, that
+// can be run repeatedly at a lower cost per call than TF_SessionRun().
+typedef struct TF_Callable TF_Callable;
+
+// Creates a callable from `callable_options`, a serialized
+// tensorflow.CallableOptions proto. The callable must be deleted with
+// TF_DeleteCallable() before `session` is deleted.
+TF_CAPI_EXPORT extern TF_Callable* TF_SessionNewCallable(
+    TF_Session* session, const TF_Buffer* callable_options, TF_Status* status);
+
+// Runs `callable`, feeding `input_values` in the order of the feeds of its
+// CallableOptions. Inputs of types other than TF_STRING are fed without
+// copying their data, so they can wrap the caller's memory (see
+// TF_NewTensor()); the caller must keep them alive during the call.
+//
+// `output_values` holds an entry for every fetch, in order. A null entry
+// receives a new tensor, which the caller must delete with
+// TF_DeleteTensor(). A non-null entry, e.g. a tensor returned by a previous
+// call, is reused: the handle is kept and now holds the fetched value. If
+// the callable was made with `fetch_into_provided_tensors` and the entry
+// has the dtype and shape of the fetched value, the value is written into
+// the memory of the entry; otherwise the entry releases its previous
+// contents as if by TF_DeleteTensor().
+//
+// If `run_metadata` is non-NULL, it receives a serialized RunMetadata proto.
+TF_CAPI_EXPORT extern void TF_CallableRun(TF_Callable* callable,
+                                          TF_Tensor* const* input_values,
+                                          int ninputs,
+                                          TF_Tensor** output_values,
+                                          int noutputs,
+                                          TF_Buffer* run_metadata,
+                                          TF_Status* status);
+
+// Releases the resources of `callable` in its session, and deletes it.
+TF_CAPI_EXPORT extern void TF_DeleteCallable(TF_Callable* callable,
+                                             TF_Status* status);
+
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
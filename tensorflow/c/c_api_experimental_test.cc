@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/tensorflow_server.pb.h"
 
 namespace tensorflow {
@@ -162,5 +163,66 @@ protocol: "grpc"
   TF_DeleteStatus(status);
 }
 
+TEST(CAPI_EXPERIMENTAL, CallableRunReusesOutputTensors) {
+  TF_Status* s = TF_NewStatus();
+  TF_Graph* graph = TF_NewGraph();
+  TF_Operation* feed = Placeholder(graph, s, "feed", TF_INT32, {3});
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  Neg(feed, graph, s, "neg");
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  CSession csession(graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  CallableOptions options;
+  options.add_feed("feed:0");
+  options.add_fetch("neg:0");
+  options.set_fetch_into_provided_tensors(true);
+  string serialized = options.SerializeAsString();
+  TF_Buffer* options_buffer =
+      TF_NewBufferFromString(serialized.data(), serialized.size());
+  TF_Callable* callable =
+      TF_SessionNewCallable(csession.mutable_session(), options_buffer, s);
+  TF_DeleteBuffer(options_buffer);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  // The output is written into the memory of the caller.
+  TF_Tensor* input = Int32Tensor({1, 2, 3});
+  int32 output_data[3] = {0, 0, 0};
+  const int64_t dims[] = {3};
+  TF_Tensor* output =
+      TF_NewTensor(TF_INT32, dims, 1, output_data, sizeof(output_data),
+                   [](void*, size_t, void*) {}, nullptr);
+  TF_Tensor* output_handle = output;
+  TF_CallableRun(callable, &input, 1, &output, 1, nullptr, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  EXPECT_EQ(output_handle, output);
+  EXPECT_EQ(output_data, TF_TensorData(output));
+  EXPECT_EQ(-1, output_data[0]);
+  EXPECT_EQ(-2, output_data[1]);
+  EXPECT_EQ(-3, output_data[2]);
+  TF_DeleteTensor(output);
+
+  // A null entry receives a new tensor.
+  TF_Tensor* new_output = nullptr;
+  TF_CallableRun(callable, &input, 1, &new_output, 1, nullptr, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  ASSERT_NE(nullptr, new_output);
+  EXPECT_EQ(-3, static_cast<int32*>(TF_TensorData(new_output))[2]);
+  TF_DeleteTensor(new_output);
+
+  // The number of inputs must match the feeds.
+  new_output = nullptr;
+  TF_CallableRun(callable, nullptr, 0, &new_output, 1, nullptr, s);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(s));
+
+  TF_DeleteTensor(input);
+  TF_DeleteCallable(callable, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  csession.CloseAndDelete(s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteGraph(graph);
+  TF_DeleteStatus(s);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -24,6 +24,11 @@ constexpr char kSavedModelAssetsDirectory[] = "assets";
 /// SavedModel assets.extra directory.
 constexpr char kSavedModelAssetsExtraDirectory[] = "assets.extra";
 
+/// Filename of the warmup requests in the assets.extra directory, a TFRecord
+/// file of SavedModelWarmupRequest protos.
+constexpr char kSavedModelWarmupRequestsFilename[] =
+    "saved_model_warmup_requests";
+
 /// SavedModel assets key for graph collection-def.
 constexpr char kSavedModelAssetsKey[] = "saved_model_assets";
 
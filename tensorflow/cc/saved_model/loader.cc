@@ -15,21 +15,26 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/loader.h"
 
+#include <algorithm>
 #include <unordered_set>
 
 #include "tensorflow/cc/saved_model/constants.h"
 #include "tensorflow/cc/saved_model/reader.h"
+#include "tensorflow/cc/saved_model/signature_constants.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/protobuf_internal.h"
 #include "tensorflow/core/protobuf/saved_model.pb.h"
+#include "tensorflow/core/protobuf/saved_model_warmup.pb.h"
 #include "tensorflow/core/protobuf/saver.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -42,6 +47,10 @@ auto* load_latency = monitoring::Counter<1>::New(
     "/tensorflow/cc/saved_model/load_latency",
     "Latency in microseconds for SavedModels that were successfully loaded.",
     "model_path");
+auto* load_phase_latency = monitoring::Counter<2>::New(
+    "/tensorflow/cc/saved_model/load_phase_latency",
+    "Latency in microseconds of each phase of the SavedModel loads.",
+    "model_path", "phase");
 constexpr char kLoadAttemptFail[] = "fail";
 constexpr char kLoadAttemptSuccess[] = "success";
 
@@ -208,16 +217,112 @@ Status GetAssetFileDefs(const MetaGraphDef& meta_graph_def,
   return Status::OK();
 }
 
+// Runs one warmup request. Unlike RunOnce(), this keeps the executors of the
+// request in the session, so that real requests with the same feeds and
+// fetches reuse them.
+Status RunWarmupRequest(const RunOptions& run_options,
+                        const MetaGraphDef& meta_graph_def,
+                        const SavedModelWarmupRequest& request,
+                        Session* session) {
+  const string signature_name = request.signature_name().empty()
+                                    ? kDefaultServingSignatureDefKey
+                                    : request.signature_name();
+  const auto signature_it = meta_graph_def.signature_def().find(signature_name);
+  if (signature_it == meta_graph_def.signature_def().end()) {
+    return errors::InvalidArgument("Warmup request for unknown signature ",
+                                   signature_name);
+  }
+  const SignatureDef& signature = signature_it->second;
+  std::vector<std::pair<string, Tensor>> inputs;
+  for (const auto& input : request.inputs()) {
+    const auto input_it = signature.inputs().find(input.name());
+    if (input_it == signature.inputs().end()) {
+      return errors::InvalidArgument("Warmup request for signature ",
+                                     signature_name, " has unknown input ",
+                                     input.name());
+    }
+    Tensor tensor;
+    if (!tensor.FromProto(input.tensor())) {
+      return errors::InvalidArgument("Warmup request for signature ",
+                                     signature_name, " has a malformed input ",
+                                     input.name());
+    }
+    inputs.emplace_back(input_it->second.name(), tensor);
+  }
+  std::vector<string> output_tensor_names;
+  for (const auto& output : signature.outputs()) {
+    output_tensor_names.push_back(output.second.name());
+  }
+  const int num_runs = std::max(request.num_runs(), 1);
+  for (int i = 0; i < num_runs; ++i) {
+    std::vector<Tensor> outputs;
+    RunMetadata run_metadata;
+    TF_RETURN_IF_ERROR(session->Run(run_options, inputs, output_tensor_names,
+                                    {}, &outputs, &run_metadata));
+  }
+  return Status::OK();
+}
+
+// Runs the warmup requests of the SavedModel in "export_dir", if it has any.
+Status RunWarmupRequests(const RunOptions& run_options,
+                         const string& export_dir,
+                         const MetaGraphDef& meta_graph_def,
+                         int max_warmup_requests, Session* session,
+                         int* num_warmup_requests) {
+  const string warmup_path =
+      io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                   kSavedModelWarmupRequestsFilename);
+  if (!Env::Default()->FileExists(warmup_path).ok()) {
+    return Status::OK();
+  }
+  LOG(INFO) << "Running warmup requests from " << warmup_path;
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(Env::Default()->NewRandomAccessFile(warmup_path, &file));
+  io::RecordReader reader(file.get());
+  uint64 offset = 0;
+  string record;
+  while (*num_warmup_requests < max_warmup_requests) {
+    const Status status = reader.ReadRecord(&offset, &record);
+    if (errors::IsOutOfRange(status)) break;
+    TF_RETURN_IF_ERROR(status);
+    SavedModelWarmupRequest request;
+    if (!request.ParseFromString(record)) {
+      return errors::DataLoss("Malformed warmup request ",
+                              *num_warmup_requests, " in ", warmup_path);
+    }
+    TF_RETURN_IF_ERROR(
+        RunWarmupRequest(run_options, meta_graph_def, request, session));
+    ++*num_warmup_requests;
+  }
+  return Status::OK();
+}
+
+// Returns the microseconds since "*start_microseconds" and resets it to now.
+uint64 ElapsedMicros(uint64* start_microseconds) {
+  const uint64 end_microseconds = Env::Default()->NowMicros();
+  // Avoid clock skew.
+  const uint64 elapsed = end_microseconds < *start_microseconds
+                             ? 0
+                             : end_microseconds - *start_microseconds;
+  *start_microseconds = end_microseconds;
+  return elapsed;
+}
+
 Status LoadSavedModelInternal(const SessionOptions& session_options,
                               const RunOptions& run_options,
                               const string& export_dir,
                               const std::unordered_set<string>& tags,
-                              SavedModelBundle* const bundle) {
+                              const LoadSavedModelOptions& load_options,
+                              SavedModelBundle* const bundle,
+                              SavedModelLoadStats* stats) {
+  uint64 start_microseconds = Env::Default()->NowMicros();
   TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
                                                     &bundle->meta_graph_def));
+  stats->read_meta_graph_micros = ElapsedMicros(&start_microseconds);
 
   TF_RETURN_IF_ERROR(LoadMetaGraphIntoSession(
       bundle->meta_graph_def, session_options, &bundle->session));
+  stats->create_session_micros = ElapsedMicros(&start_microseconds);
 
   std::vector<AssetFileDef> asset_file_defs;
   TF_RETURN_IF_ERROR(
@@ -227,6 +332,8 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                  bundle->meta_graph_def.saver_def().restore_op_name(),
                  bundle->meta_graph_def.saver_def().filename_tensor_name(),
                  asset_file_defs, bundle->session.get()));
+  stats->restore_micros = ElapsedMicros(&start_microseconds);
+
   if (HasMainOp(bundle->meta_graph_def)) {
     TF_RETURN_IF_ERROR(RunMainOp(run_options, export_dir,
                                  bundle->meta_graph_def, asset_file_defs,
@@ -236,19 +343,65 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
         run_options, export_dir, bundle->meta_graph_def, asset_file_defs,
         bundle->session.get(), kSavedModelLegacyInitOpKey));
   }
+  stats->init_op_micros = ElapsedMicros(&start_microseconds);
+
+  if (load_options.run_warmup_requests) {
+    TF_RETURN_IF_ERROR(RunWarmupRequests(
+        run_options, export_dir, bundle->meta_graph_def,
+        load_options.max_warmup_requests, bundle->session.get(),
+        &stats->num_warmup_requests));
+    stats->warmup_micros = ElapsedMicros(&start_microseconds);
+  }
   return Status::OK();
 }
 
 }  // namespace
 
+SavedModelBundle::~SavedModelBundle() {
+  if (session) {
+    session->Close().IgnoreError();
+    // Releases the restored tensors that were only shared with this session;
+    // see TF_RESTORE_SHARE_TENSORS.
+    session.reset();
+    RestoredTensorPool::Global()->Sweep();
+  }
+}
+
 Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
                       const std::unordered_set<string>& tags,
                       SavedModelBundle* const bundle) {
+  return LoadSavedModel(session_options, run_options, export_dir, tags,
+                        LoadSavedModelOptions(), bundle, nullptr);
+}
+
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options, const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      const LoadSavedModelOptions& load_options,
+                      SavedModelBundle* const bundle,
+                      SavedModelLoadStats* stats) {
   // TODO(robson): Add tests for the counters.
   const uint64 start_microseconds = Env::Default()->NowMicros();
-  const Status status = LoadSavedModelInternal(session_options, run_options,
-                                               export_dir, tags, bundle);
+  SavedModelLoadStats phase_stats;
+  const Status status =
+      LoadSavedModelInternal(session_options, run_options, export_dir, tags,
+                             load_options, bundle, &phase_stats);
+  if (stats != nullptr) *stats = phase_stats;
+  const std::pair<const char*, uint64> phases[] = {
+      {"read_meta_graph", phase_stats.read_meta_graph_micros},
+      {"create_session", phase_stats.create_session_micros},
+      {"restore", phase_stats.restore_micros},
+      {"init_op", phase_stats.init_op_micros},
+      {"warmup", phase_stats.warmup_micros},
+  };
+  string phases_str;
+  for (const auto& phase : phases) {
+    load_phase_latency->GetCell(export_dir, phase.first)
+        ->IncrementBy(phase.second);
+    strings::StrAppend(&phases_str, phases_str.empty() ? "" : ", ",
+                       phase.first, " ", phase.second);
+  }
   const uint64 load_latency_microsecs = [&]() -> uint64 {
     const uint64 end_microseconds = Env::Default()->NowMicros();
     // Avoid clock skew.
@@ -258,7 +411,9 @@ Status LoadSavedModel(const SessionOptions& session_options,
   auto log_and_count = [&](const string& status_str) {
     LOG(INFO) << "SavedModel load for tags { " << str_util::Join(tags, " ")
               << " }; Status: " << status_str << ". Took "
-              << load_latency_microsecs << " microseconds.";
+              << load_latency_microsecs << " microseconds (" << phases_str
+              << "; " << phase_stats.num_warmup_requests
+              << " warmup requests).";
     load_attempt_count->GetCell(export_dir, status_str)->IncrementBy(1);
   };
   if (status.ok()) {
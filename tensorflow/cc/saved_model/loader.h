@@ -34,15 +34,34 @@ struct SavedModelBundle {
 
   /// A TensorFlow Session does not Close itself on destruction. To avoid
   /// resource leaks, we explicitly call Close on Sessions that we create.
-  ~SavedModelBundle() {
-    if (session) {
-      session->Close().IgnoreError();
-    }
-  }
+  ~SavedModelBundle();
 
   SavedModelBundle() = default;
 };
 
+/// Options of LoadSavedModel() beyond those of the session and of its runs.
+struct LoadSavedModelOptions {
+  /// Whether to run the warmup requests of the SavedModel, if it has any,
+  /// before returning. They create the kernels and fill the autotuning caches
+  /// that the first real requests would otherwise wait for.
+  bool run_warmup_requests = false;
+
+  /// Maximum number of warmup requests to run.
+  int max_warmup_requests = 1000;
+};
+
+/// Time taken by the phases of LoadSavedModel(), in microseconds.
+struct SavedModelLoadStats {
+  uint64 read_meta_graph_micros = 0;
+  uint64 create_session_micros = 0;
+  uint64 restore_micros = 0;
+  uint64 init_op_micros = 0;
+  uint64 warmup_micros = 0;
+
+  /// Number of warmup requests that were run.
+  int num_warmup_requests = 0;
+};
+
 /// Loads a SavedModel from the specified export directory. The meta graph def
 /// to be loaded is identified by the supplied tags, corresponding exactly to
 /// the set of tags used at SavedModel build time. Returns a SavedModel bundle
@@ -52,6 +71,15 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const std::unordered_set<string>& tags,
                       SavedModelBundle* const bundle);
 
+/// Like above, with `load_options`. If `stats` is not null, it is set to the
+/// time taken by each phase of the load.
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options, const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      const LoadSavedModelOptions& load_options,
+                      SavedModelBundle* const bundle,
+                      SavedModelLoadStats* stats);
+
 /// Checks whether the provided directory could contain a SavedModel. Note that
 /// the method does not load any data by itself. If the method returns `false`,
 /// the export directory definitely does not contain a SavedModel. If the method
@@ -24,8 +24,10 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/saved_model_warmup.pb.h"
 
 namespace tensorflow {
 namespace {
@@ -48,6 +50,41 @@ class LoaderTest : public ::testing::Test {
     return example.SerializeAsString();
   }
 
+  // Copies the half plus two SavedModel to "export_dir".
+  void CopySavedModel(const string& export_dir) {
+    const string src_dir =
+        io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+    Env* env = Env::Default();
+    for (const string& dir :
+         {kSavedModelAssetsDirectory, kSavedModelAssetsExtraDirectory,
+          kSavedModelVariablesDirectory}) {
+      TF_ASSERT_OK(env->RecursivelyCreateDir(io::JoinPath(export_dir, dir)));
+    }
+    for (const string& file :
+         {string(kSavedModelFilenamePb), io::JoinPath("assets", "foo.txt"),
+          io::JoinPath("variables", "variables.index"),
+          io::JoinPath("variables", "variables.data-00000-of-00001")}) {
+      TF_ASSERT_OK(env->CopyFile(io::JoinPath(src_dir, file),
+                                 io::JoinPath(export_dir, file)));
+    }
+  }
+
+  void WriteWarmupRequests(
+      const string& export_dir,
+      const std::vector<SavedModelWarmupRequest>& requests) {
+    std::unique_ptr<WritableFile> file;
+    TF_ASSERT_OK(Env::Default()->NewWritableFile(
+        io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                     kSavedModelWarmupRequestsFilename),
+        &file));
+    io::RecordWriter writer(file.get());
+    for (const auto& request : requests) {
+      TF_ASSERT_OK(writer.WriteRecord(request.SerializeAsString()));
+    }
+    TF_ASSERT_OK(writer.Close());
+    TF_ASSERT_OK(file->Close());
+  }
+
   void ValidateAssets(const string& export_dir,
                       const SavedModelBundle& bundle) {
     const string asset_directory =
@@ -210,6 +247,66 @@ TEST_F(LoaderTest, InvalidExportPath) {
   EXPECT_FALSE(st.ok());
 }
 
+TEST_F(LoaderTest, WarmupRequests) {
+  const string export_dir = io::JoinPath(testing::TmpDir(), "warmup");
+  CopySavedModel(export_dir);
+  SavedModelWarmupRequest request;
+  request.set_signature_name("regress_x_to_y");
+  request.set_num_runs(2);
+  auto* input = request.add_inputs();
+  input->set_name(kRegressInputs);
+  test::AsTensor<string>({MakeSerializedExample(1)}, TensorShape({1}))
+      .AsProtoField(input->mutable_tensor());
+  WriteWarmupRequests(export_dir, {request, request});
+
+  SessionOptions session_options;
+  RunOptions run_options;
+  LoadSavedModelOptions load_options;
+  SavedModelLoadStats stats;
+  {
+    // Warmup requests are only run when asked for.
+    SavedModelBundle bundle;
+    TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                                {kSavedModelTagServe}, load_options, &bundle,
+                                &stats));
+    EXPECT_EQ(0, stats.num_warmup_requests);
+  }
+  {
+    SavedModelBundle bundle;
+    load_options.run_warmup_requests = true;
+    TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                                {kSavedModelTagServe}, load_options, &bundle,
+                                &stats));
+    EXPECT_EQ(2, stats.num_warmup_requests);
+    CheckSavedModelBundle(export_dir, bundle);
+  }
+  {
+    SavedModelBundle bundle;
+    load_options.max_warmup_requests = 1;
+    TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                                {kSavedModelTagServe}, load_options, &bundle,
+                                &stats));
+    EXPECT_EQ(1, stats.num_warmup_requests);
+  }
+}
+
+TEST_F(LoaderTest, WarmupRequestForUnknownSignature) {
+  const string export_dir = io::JoinPath(testing::TmpDir(), "bad_warmup");
+  CopySavedModel(export_dir);
+  SavedModelWarmupRequest request;
+  request.set_signature_name("missing");
+  WriteWarmupRequests(export_dir, {request});
+
+  SavedModelBundle bundle;
+  LoadSavedModelOptions load_options;
+  load_options.run_warmup_requests = true;
+  const Status st =
+      LoadSavedModel(SessionOptions(), RunOptions(), export_dir,
+                     {kSavedModelTagServe}, load_options, &bundle, nullptr);
+  EXPECT_TRUE(errors::IsInvalidArgument(st)) << st;
+  EXPECT_TRUE(str_util::StrContains(st.error_message(), "missing"));
+}
+
 TEST_F(LoaderTest, MaybeSavedModelDirectory) {
   // Valid SavedModel directory.
   const string export_dir =
@@ -107,6 +107,8 @@ void DumpStatsToStdout(const Stats& stats) {
     printf("  %-*s %*.3f us\n", max_label_size, g.first.c_str(), max_digits + 4,
            g.second);
   }
+  printf("Throughput at batch size %lld: %.3f examples/s\n", stats.batch_size,
+         sum_us > 0 ? stats.batch_size * count_us * 1e6 / sum_us : 0.0);
 }
 
 void Benchmark(const Options& options, const BenchmarkFn& fn, Stats* stats) {
@@ -48,12 +48,14 @@ struct Options {
 struct Stats {
   std::vector<int64> per_iter_us;  // Per-iteration deltas in us.
   int64 total_us;                  // Total time in us.
+  int64 batch_size;                // Examples processed per iteration.
 
-  Stats() : total_us(0) { per_iter_us.reserve(5000); }
+  Stats() : total_us(0), batch_size(1) { per_iter_us.reserve(5000); }
 };
 
 // DumpStatsToStdout printfs to stdout stats in a multi-line human-friendly
-// form.
+// form, including the latency per iteration and the throughput in examples
+// per second.
 void DumpStatsToStdout(const Stats& stats);
 
 // BenchmarkFn is the signature of the function generated by tfcompile.
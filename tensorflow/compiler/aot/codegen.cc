@@ -167,6 +167,11 @@ string RewriteWithName(const string& name, string code,
 Status GenArgMethods(const tf2xla::Config& config, const xla::ProgramShape& ps,
                      const CompileResult& compile_result, string* methods) {
   size_t num_args = ps.parameters_size();
+  // The last argument of batch-specialized computations is managed by the
+  // generated set_batch_size method.
+  if (!compile_result.batch_sizes.empty()) {
+    --num_args;
+  }
   if (config.feed_size() != num_args) {
     return errors::InvalidArgument("mismatch between feed_size(",
                                    config.feed_size(), ") and num_args(",
@@ -243,6 +248,45 @@ Status GenResultMethods(const tf2xla::Config& config,
   return Status::OK();
 }
 
+// Generates the bodies of BatchSizes() and set_batch_size(), and the body of
+// the constructor, which selects the largest batch size.
+void GenBatchCode(const std::vector<int64>& batch_sizes,
+                  string* batch_sizes_code, string* set_batch_size_code,
+                  string* constructor_code) {
+  if (batch_sizes.empty()) {
+    *batch_sizes_code = "{\n    return nullptr;\n  }";
+    *set_batch_size_code = "{\n    return false;\n  }";
+    *constructor_code = "{}";
+    return;
+  }
+  *batch_sizes_code = absl::StrCat(
+      "{\n    static const ::tensorflow::int64 kBatchSizes[kNumBatchSizes] = "
+      "{",
+      absl::StrJoin(batch_sizes, ", "), "};\n    return kBatchSizes;\n  }");
+  std::vector<string> indices;
+  for (int i = 0; i < batch_sizes.size(); ++i) {
+    indices.push_back(absl::StrCat("{", i, "}"));
+  }
+  *set_batch_size_code = absl::StrCat(
+      R"({
+    // The index of the specialization is passed as the last argument, which
+    // is aligned like all argument buffers.
+    struct alignas()",
+      cpu_function_runtime::kAlign, R"() Index { ::tensorflow::int32 value; };
+    static const Index kIndices[kNumBatchSizes] = {)",
+      absl::StrJoin(indices, ", "), R"(};
+    for (size_t i = 0; i < kNumBatchSizes; ++i) {
+      if (BatchSizes()[i] == batch_size) {
+        set_arg_data(kNumArgs - 1, const_cast<Index*>(&kIndices[i]));
+        return true;
+      }
+    }
+    return false;
+  })");
+  *constructor_code =
+      "{\n    set_batch_size(BatchSizes()[kNumBatchSizes - 1]);\n  }";
+}
+
 // Generates code implementing {Arg,Result}Names(), where T is one of
 // tf2xla::{Feed,Fetch}. Each feed or fetch name results in a C-style string
 // literal in the array, with nullptr terminating the array.
@@ -366,6 +410,9 @@ Status GenerateHeader(const CodegenOpts& opts, const tf2xla::Config& config,
       GenNameToIndexCode(config.feed(), opts.gen_name_to_index);
   const string result_names_code =
       GenNameToIndexCode(config.fetch(), opts.gen_name_to_index);
+  string batch_sizes_code, set_batch_size_code, constructor_code;
+  GenBatchCode(compile_result.batch_sizes, &batch_sizes_code,
+               &set_batch_size_code, &constructor_code);
   const string include_xla_data_proto =
       opts.gen_program_shape
           ?
@@ -479,11 +526,24 @@ class {{CLASS}} : public tensorflow::XlaCompiledCpuFunction {
   }
 
   {{CLASS}}(AllocMode alloc_mode = AllocMode::ARGS_RESULTS_PROFILES_AND_TEMPS)
-      : XlaCompiledCpuFunction(StaticData(), alloc_mode) {}
+      : XlaCompiledCpuFunction(StaticData(), alloc_mode) {{CONSTRUCTOR_CODE}}
 
   {{CLASS}}(const {{CLASS}}&) = delete;
   {{CLASS}}& operator=(const {{CLASS}}&) = delete;
 
+  // Batch sizes the computation was specialized for with the --batch_sizes
+  // flag of tfcompile, in increasing order. There are kNumBatchSizes entries.
+  static constexpr size_t kNumBatchSizes = {{NUM_BATCH_SIZES}};
+  static const ::tensorflow::int64* BatchSizes() {{BATCH_SIZES_CODE}}
+
+  // Selects the specialization that Run executes, and returns false if there
+  // is none for batch_size. Args that depend on the batch size have the
+  // largest one as leading dimension, and only their first batch_size rows
+  // are read. Results that depend on it are padded to the largest one with
+  // zeros. Initially the largest batch size is selected. The selection is
+  // passed in the last argument, which has no arg methods.
+  bool set_batch_size(::tensorflow::int64 batch_size) {{SET_BATCH_SIZE_CODE}}
+
   // Arg methods for managing input buffers. Buffers are in row-major order.
   // There is a set of methods for each positional argument, with the following
   // general form:
@@ -574,7 +634,9 @@ class {{CLASS}} : public tensorflow::XlaCompiledCpuFunction {
       {"{{ARG_NUM}}", absl::StrCat(arg_index_table.size())},
       {"{{ARG_INDEX_TABLE}}", absl::StrJoin(arg_index_table, ", ")},
       {"{{ASSIGN_PROFILE_COUNTERS_SIZE}}", assign_profile_counters_size},
+      {"{{BATCH_SIZES_CODE}}", batch_sizes_code},
       {"{{CLASS}}", opts.class_name},
+      {"{{CONSTRUCTOR_CODE}}", constructor_code},
       {"{{DECLS_FROM_OBJ_FILE}}",
        absl::StrJoin(metadata_result.header_variable_decls, "\n")},
       {"{{ENTRY}}", compile_result.entry_point},
@@ -587,11 +649,13 @@ class {{CLASS}} : public tensorflow::XlaCompiledCpuFunction {
       {"{{METHODS_RESULT}}\n", methods_result},
       {"{{NS_END}}\n", ns_end},
       {"{{NS_START}}\n", ns_start},
+      {"{{NUM_BATCH_SIZES}}", absl::StrCat(compile_result.batch_sizes.size())},
       {"{{PROGRAM_SHAPE}}", xla::ShapeUtil::HumanString(ps)},
       {"{{PROGRAM_SHAPE_SHIM_EXPRESSION}}",
        metadata_result.program_shape_access_shim},
       {"{{RESULT_INDEX}}", absl::StrCat(result_index)},
       {"{{RESULT_NAMES_CODE}}", result_names_code},
+      {"{{SET_BATCH_SIZE_CODE}}", set_batch_size_code},
       {"{{TEMP_BYTES_ALIGNED}}", absl::StrCat(temp_bytes_aligned)},
       {"{{TEMP_BYTES_TOTAL}}", absl::StrCat(temp_bytes_total)},
       {"{{NUM_BUFFERS}}", absl::StrCat(buffer_infos.size())},
@@ -206,6 +206,47 @@ TEST(CodegenTest, Golden) {
 
   CompareWithGoldenFile("compiler/aot/codegen_test_h.golden", header);
 }
+
+TEST(CodegenTest, BatchSizes) {
+  CodegenOpts opts;
+  opts.class_name = "MyClass";
+  tf2xla::Config config;
+  config.add_feed()->mutable_id()->set_node_name("feed0");
+  config.add_feed()->mutable_id()->set_node_name("feed1");
+  config.add_fetch()->mutable_id()->set_node_name("fetch0");
+  CompileResult compile_result;
+  compile_result.aot.reset(new xla::cpu::CpuAotCompilationResult(
+      {},
+      {BufferInfo::MakeEntryParameter(/*size=*/64, /*param_number=*/0),
+       BufferInfo::MakeEntryParameter(/*size=*/96, /*param_number=*/1),
+       BufferInfo::MakeEntryParameter(/*size=*/4, /*param_number=*/2),
+       BufferInfo::MakeTempBuffer(160)},
+      3, {}));
+  compile_result.program_shape = xla::ShapeUtil::MakeProgramShape(
+      {
+          xla::ShapeUtil::MakeShape(xla::F32, {8, 2}),
+          xla::ShapeUtil::MakeShape(xla::S64, {3, 4}),
+          xla::ShapeUtil::MakeShape(xla::S32, {}),
+      },
+      xla::ShapeUtil::MakeTupleShape(
+          {xla::ShapeUtil::MakeShape(xla::U32, {8, 5})}));
+  compile_result.entry_point = "entry_point";
+  compile_result.pointer_size = 8;
+  compile_result.batch_sizes = {1, 8};
+
+  MetadataResult metadata_result;
+  string header;
+  TF_ASSERT_OK(
+      GenerateHeader(opts, config, compile_result, metadata_result, &header));
+  EXPECT_TRUE(absl::StrContains(header, "kNumArgs = 3;"));
+  EXPECT_TRUE(absl::StrContains(header, "kNumBatchSizes = 2;"));
+  EXPECT_TRUE(absl::StrContains(
+      header, "kBatchSizes[kNumBatchSizes] = {1, 8};"));
+  EXPECT_TRUE(absl::StrContains(
+      header, "set_batch_size(BatchSizes()[kNumBatchSizes - 1]);"));
+  EXPECT_TRUE(absl::StrContains(header, "set_arg1_data"));
+  EXPECT_FALSE(absl::StrContains(header, "set_arg2_data"));
+}
 }  // namespace
 }  // namespace tfcompile
 }  // namespace tensorflow
@@ -15,18 +15,24 @@ limitations under the License.
 
 #include "tensorflow/compiler/aot/compile.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
 #include "tensorflow/compiler/aot/flags.h"
 #include "tensorflow/compiler/tf2xla/tf2xla.h"
 #include "tensorflow/compiler/tf2xla/tf2xla_util.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
 #include "tensorflow/compiler/xla/client/compile_only_client.h"
+#include "tensorflow/compiler/xla/client/lib/constants.h"
+#include "tensorflow/compiler/xla/client/xla_builder.h"
 #include "tensorflow/compiler/xla/client/xla_computation.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_compiler.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
@@ -82,6 +88,195 @@ Status CompileXla(xla::CompileOnlyClient* client,
   return Status::OK();
 }
 
+// Parses the comma-separated --batch_sizes flag into increasing sizes.
+Status ParseBatchSizes(const string& flag, std::vector<int64>* batch_sizes) {
+  for (absl::string_view size : absl::StrSplit(flag, ',', absl::SkipEmpty())) {
+    int64 batch_size;
+    if (!absl::SimpleAtoi(size, &batch_size) || batch_size <= 0) {
+      return errors::InvalidArgument("Invalid batch size in --batch_sizes: ",
+                                     size);
+    }
+    batch_sizes->push_back(batch_size);
+  }
+  std::sort(batch_sizes->begin(), batch_sizes->end());
+  batch_sizes->erase(std::unique(batch_sizes->begin(), batch_sizes->end()),
+                     batch_sizes->end());
+  return Status::OK();
+}
+
+// Returns the shape of a specialization's argument or result as accessed by
+// the dispatching computation. Shapes that depend on the batch size have the
+// largest batch size as leading dimension there.
+xla::StatusOr<xla::Shape> DispatchShape(
+    const std::vector<int64>& batch_sizes,
+    const std::vector<const xla::Shape*>& shapes) {
+  const xla::Shape& max_shape = *shapes.back();
+  bool batched = false;
+  for (const xla::Shape* shape : shapes) {
+    batched |= !xla::ShapeUtil::Compatible(*shape, max_shape);
+  }
+  for (int i = 0; i < shapes.size(); ++i) {
+    xla::Shape expected = max_shape;
+    if (batched) {
+      if (!xla::ShapeUtil::IsArray(max_shape) ||
+          xla::ShapeUtil::Rank(max_shape) == 0 ||
+          max_shape.dimensions(0) != batch_sizes.back()) {
+        return errors::Unimplemented(
+            "Shape ", xla::ShapeUtil::HumanString(max_shape),
+            " depends on the batch size, but not only through its leading "
+            "dimension");
+      }
+      expected.set_dimensions(0, batch_sizes[i]);
+    }
+    if (!xla::ShapeUtil::Compatible(*shapes[i], expected)) {
+      return errors::Unimplemented(
+          "Shape ", xla::ShapeUtil::HumanString(*shapes[i]),
+          " for batch size ", batch_sizes[i],
+          " depends on the batch size, but not only through its leading "
+          "dimension");
+    }
+  }
+  return max_shape;
+}
+
+// Builds the computation that runs specializations[i], compiled for
+// batch_sizes[i], on the leading rows of its arguments. `operand_shape` is a
+// tuple of the arguments at the largest batch size, followed by the S32 index
+// i of the specialization. Results are padded to the largest batch size with
+// zeros.
+xla::StatusOr<xla::XlaComputation> BuildBatchBranch(
+    const xla::Shape& operand_shape, const xla::Shape& result_shape,
+    int64 batch_size, const xla::XlaComputation& specialization) {
+  TF_ASSIGN_OR_RETURN(xla::ProgramShape program_shape,
+                      specialization.GetProgramShape());
+  xla::XlaBuilder builder(absl::StrCat("batch_", batch_size));
+  xla::XlaOp operand = xla::Parameter(&builder, 0, operand_shape, "operand");
+  std::vector<xla::XlaOp> args;
+  for (int i = 0; i < program_shape.parameters_size(); ++i) {
+    const xla::Shape& arg_shape = program_shape.parameters(i);
+    xla::XlaOp arg = xla::GetTupleElement(operand, i);
+    if (!xla::ShapeUtil::Compatible(arg_shape,
+                                    operand_shape.tuple_shapes(i))) {
+      std::vector<int64> start(xla::ShapeUtil::Rank(arg_shape), 0);
+      std::vector<int64> strides(xla::ShapeUtil::Rank(arg_shape), 1);
+      arg = xla::Slice(arg, start, xla::AsInt64Slice(arg_shape.dimensions()),
+                       strides);
+    }
+    args.push_back(arg);
+  }
+  xla::XlaOp call = xla::Call(&builder, specialization, args);
+  std::vector<xla::XlaOp> results;
+  for (int i = 0; i < result_shape.tuple_shapes_size(); ++i) {
+    const xla::Shape& max_shape = result_shape.tuple_shapes(i);
+    const xla::Shape& shape = program_shape.result().tuple_shapes(i);
+    xla::XlaOp result = xla::GetTupleElement(call, i);
+    if (!xla::ShapeUtil::Compatible(shape, max_shape)) {
+      xla::PaddingConfig padding =
+          xla::MakeNoPaddingConfig(xla::ShapeUtil::Rank(shape));
+      padding.mutable_dimensions(0)->set_edge_padding_high(
+          max_shape.dimensions(0) - shape.dimensions(0));
+      result = xla::Pad(result, xla::Zero(&builder, shape.element_type()),
+                        padding);
+    }
+    results.push_back(result);
+  }
+  xla::Tuple(&builder, results);
+  return builder.Build();
+}
+
+// Builds a computation that takes the arguments of the specializations at the
+// largest batch size, followed by an S32 index into batch_sizes, and runs the
+// indexed specialization. The specializations are selected by a chain of
+// conditionals, starting at the one for batch_sizes[first].
+xla::StatusOr<xla::XlaComputation> BuildBatchDispatch(
+    const std::vector<int64>& batch_sizes,
+    const std::vector<xla::XlaComputation>& specializations,
+    const xla::Shape& operand_shape, const xla::Shape& result_shape,
+    int first) {
+  TF_ASSIGN_OR_RETURN(
+      xla::XlaComputation branch,
+      BuildBatchBranch(operand_shape, result_shape, batch_sizes[first],
+                       specializations[first]));
+  if (first + 1 == batch_sizes.size()) {
+    return std::move(branch);
+  }
+  TF_ASSIGN_OR_RETURN(
+      xla::XlaComputation rest,
+      BuildBatchDispatch(batch_sizes, specializations, operand_shape,
+                         result_shape, first + 1));
+  xla::XlaBuilder builder(absl::StrCat("dispatch_", batch_sizes[first]));
+  xla::XlaOp operand = xla::Parameter(&builder, 0, operand_shape, "operand");
+  xla::XlaOp index = xla::GetTupleElement(
+      operand, operand_shape.tuple_shapes_size() - 1);
+  xla::Conditional(xla::Eq(index, xla::ConstantR0<int32>(&builder, first)),
+                   operand, branch, operand, rest);
+  return builder.Build();
+}
+
+// Converts the graph into one XLA computation per batch size, and combines
+// them into a computation that dispatches on an extra S32 index argument.
+Status ConvertGraphDefToBatchedXla(const GraphDef& graph_def,
+                                   const tf2xla::Config& config,
+                                   const std::vector<int64>& batch_sizes,
+                                   xla::Client* client,
+                                   xla::XlaComputation* computation) {
+  std::vector<xla::XlaComputation> specializations(batch_sizes.size());
+  std::vector<xla::ProgramShape> program_shapes(batch_sizes.size());
+  for (int i = 0; i < batch_sizes.size(); ++i) {
+    tf2xla::Config specialized_config = config;
+    for (tf2xla::Feed& feed : *specialized_config.mutable_feed()) {
+      if (feed.shape().dim_size() > 0) {
+        feed.mutable_shape()->mutable_dim(0)->set_size(batch_sizes[i]);
+      }
+    }
+    TF_RETURN_IF_ERROR(ConvertGraphDefToXla(graph_def, specialized_config,
+                                            client, &specializations[i]));
+    TF_ASSIGN_OR_RETURN(program_shapes[i],
+                        specializations[i].GetProgramShape());
+  }
+
+  const xla::ProgramShape& max_program_shape = program_shapes.back();
+  std::vector<xla::Shape> arg_shapes;
+  for (int arg = 0; arg < max_program_shape.parameters_size(); ++arg) {
+    std::vector<const xla::Shape*> shapes;
+    for (const xla::ProgramShape& program_shape : program_shapes) {
+      shapes.push_back(&program_shape.parameters(arg));
+    }
+    TF_ASSIGN_OR_RETURN(xla::Shape shape, DispatchShape(batch_sizes, shapes));
+    arg_shapes.push_back(shape);
+  }
+  std::vector<xla::Shape> result_shapes;
+  for (int result = 0;
+       result < max_program_shape.result().tuple_shapes_size(); ++result) {
+    std::vector<const xla::Shape*> shapes;
+    for (const xla::ProgramShape& program_shape : program_shapes) {
+      shapes.push_back(&program_shape.result().tuple_shapes(result));
+    }
+    TF_ASSIGN_OR_RETURN(xla::Shape shape, DispatchShape(batch_sizes, shapes));
+    result_shapes.push_back(shape);
+  }
+
+  std::vector<xla::Shape> operand_shapes = arg_shapes;
+  operand_shapes.push_back(xla::ShapeUtil::MakeShape(xla::S32, {}));
+  const xla::Shape operand_shape =
+      xla::ShapeUtil::MakeTupleShape(operand_shapes);
+  TF_ASSIGN_OR_RETURN(
+      xla::XlaComputation dispatch,
+      BuildBatchDispatch(batch_sizes, specializations, operand_shape,
+                         xla::ShapeUtil::MakeTupleShape(result_shapes),
+                         /*first=*/0));
+
+  xla::XlaBuilder builder("tfcompile_batched");
+  std::vector<xla::XlaOp> operands;
+  for (int i = 0; i < operand_shapes.size(); ++i) {
+    operands.push_back(xla::Parameter(&builder, i, operand_shapes[i],
+                                      absl::StrCat("arg", i)));
+  }
+  xla::Call(&builder, dispatch, {xla::Tuple(&builder, operands)});
+  TF_ASSIGN_OR_RETURN(*computation, builder.Build());
+  return Status::OK();
+}
+
 }  // namespace
 
 Status CompileGraph(const GraphDef& graph_def, const tf2xla::Config& config,
@@ -94,9 +289,17 @@ Status CompileGraph(const GraphDef& graph_def, const tf2xla::Config& config,
   xla::CompileOnlyClient* client =
       xla::ClientLibrary::GetOrCreateCompileOnlyClient(cpu_platform)
           .ValueOrDie();
+  std::vector<int64> batch_sizes;
+  TF_RETURN_IF_ERROR(ParseBatchSizes(flags.batch_sizes, &batch_sizes));
   xla::XlaComputation computation;
-  TF_RETURN_IF_ERROR(
-      ConvertGraphDefToXla(graph_def, config, client, &computation));
+  if (batch_sizes.empty()) {
+    TF_RETURN_IF_ERROR(
+        ConvertGraphDefToXla(graph_def, config, client, &computation));
+  } else {
+    TF_RETURN_IF_ERROR(ConvertGraphDefToBatchedXla(graph_def, config,
+                                                   batch_sizes, client,
+                                                   &computation));
+  }
   if (!flags.out_session_module.empty()) {
     TF_ASSIGN_OR_RETURN(std::unique_ptr<xla::HloSnapshot> module,
                         computation.Snapshot());
@@ -112,7 +315,10 @@ Status CompileGraph(const GraphDef& graph_def, const tf2xla::Config& config,
       flags.entry_point,
       xla::cpu::CpuAotCompilationOptions::RelocationModel::BigPic);
 
-  return CompileXla(client, computation, aot_opts, compile_result);
+  TF_RETURN_IF_ERROR(
+      CompileXla(client, computation, aot_opts, compile_result));
+  compile_result->batch_sizes = std::move(batch_sizes);
+  return Status::OK();
 }
 
 }  // namespace tfcompile
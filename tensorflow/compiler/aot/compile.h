@@ -18,12 +18,14 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "tensorflow/compiler/aot/flags.h"
 #include "tensorflow/compiler/tf2xla/tf2xla.pb.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_compiler.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 namespace tfcompile {
@@ -36,6 +38,10 @@ struct CompileResult {
   xla::ProgramShape program_shape;  // Static shape of args and results.
   string entry_point;               // Name of generated function.
   int pointer_size = 0;             // Size of a pointer in bytes.
+
+  // Batch sizes of the specializations selected by the last argument, in
+  // increasing order. Empty unless compiled with --batch_sizes.
+  std::vector<int64> batch_sizes;
 };
 
 // CompileGraph compiles the graph_def into an object file containing a function
@@ -68,6 +68,11 @@ void AppendMainFlags(std::vector<Flag>* flag_list, MainFlags* flags) {
        "function."},
       {"out_session_module", &flags->out_session_module,
        "Output session module proto."},
+      {"batch_sizes", &flags->batch_sizes,
+       "Comma-separated batch sizes to specialize the computation for, e.g. "
+       "1,8,32.  Fed tensors with a rank of at least one take the largest "
+       "batch size as leading dimension, and the generated set_batch_size "
+       "method selects the specialization that runs on their leading rows."},
       {"gen_name_to_index", &flags->gen_name_to_index,
        "Generate name-to-index data for Lookup{Arg,Result}Index methods."},
       {"gen_program_shape", &flags->gen_program_shape,
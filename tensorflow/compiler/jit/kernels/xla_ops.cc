@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/kernels/xla_ops.h"
 
+#include <cstring>
+#include <map>
+#include <set>
+
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/jit/defs.h"
@@ -35,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/variable_ops.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
 #include "tensorflow/core/util/stream_executor_util.h"
@@ -101,12 +106,13 @@ class XlaExecutableClosure {
       xla::LocalClient* client, xla::LocalExecutable* executable,
       const XlaCompiler::CompilationResult* compilation_result,
       std::map<int, OptionalTensor> resource_var_snapshots,
-      int num_constant_args)
+      int num_constant_args, XlaCompilationCache::EntryRef entry_ref)
       : client_(client),
         executable_(executable),
         compilation_result_(compilation_result),
         resource_var_snapshots_(std::move(resource_var_snapshots)),
-        num_constant_args_(num_constant_args) {}
+        num_constant_args_(num_constant_args),
+        entry_ref_(std::move(entry_ref)) {}
 
   XlaExecutableClosure(XlaExecutableClosure&&) = default;
   XlaExecutableClosure& operator=(XlaExecutableClosure&&) = default;
@@ -127,6 +133,9 @@ class XlaExecutableClosure {
   const XlaCompiler::CompilationResult* compilation_result_;
   std::map<int, OptionalTensor> resource_var_snapshots_;
   int num_constant_args_;
+  // Keeps executable_ and compilation_result_ alive if the compilation cache
+  // evicts them before the closure runs.
+  XlaCompilationCache::EntryRef entry_ref_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(XlaExecutableClosure);
 };
@@ -217,13 +226,90 @@ static Status BuildCompilationCache(OpKernelContext* ctx,
   return Status::OK();
 }
 
+// Picks the parameters of a cluster whose dimension 0 XlaLaunch treats as
+// dynamic: those of the highest rank, provided they agree on the size of
+// that dimension.  Lower-ranked parameters are broadcast along it.  Returns a
+// map from their input numbers to the next power of two of the size, or an
+// empty map if there are none.
+static std::map<int, int64> DynamicLeadingDimBounds(
+    OpKernelContext* ctx, absl::Span<const int> constants,
+    absl::Span<const int> resources) {
+  std::set<int> excluded(constants.begin(), constants.end());
+  excluded.insert(resources.begin(), resources.end());
+  int rank = 0;
+  for (int i = 0; i < ctx->num_inputs(); ++i) {
+    if (excluded.count(i) == 0) {
+      rank = std::max(rank, ctx->input(i).dims());
+    }
+  }
+  if (rank == 0) {
+    return {};
+  }
+
+  std::map<int, int64> bounds;
+  int64 size = -1;
+  for (int i = 0; i < ctx->num_inputs(); ++i) {
+    const Tensor& input = ctx->input(i);
+    if (excluded.count(i) > 0 || input.dims() != rank) continue;
+    if (!DataTypeCanUseMemcpy(input.dtype()) ||
+        (size != -1 && input.dim_size(0) != size)) {
+      return {};
+    }
+    size = input.dim_size(0);
+    bounds[i] = 0;
+  }
+  const int64 bound = size <= 1 ? 1 : NextPowerOfTwo64(size);
+  for (auto& entry : bounds) {
+    entry.second = bound;
+  }
+  return bounds;
+}
+
+// Copies `input` into `*padded`, which has `bound` rows, and zeroes the rows
+// past those of `input`.
+static Status PadLeadingDim(OpKernelContext* ctx, const Tensor& input,
+                            int64 bound, Tensor* padded) {
+  TensorShape shape = input.shape();
+  shape.set_dim(0, bound);
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(input.dtype(), shape, padded));
+  const uint64 input_bytes = input.TotalBytes();
+  const uint64 padding_bytes = padded->TotalBytes() - input_bytes;
+  char* dst = static_cast<char*>(DMAHelper::base(padded));
+  se::Stream* stream =
+      ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
+  if (stream == nullptr) {
+    if (input_bytes > 0) {
+      std::memcpy(dst, DMAHelper::base(&input), input_bytes);
+    }
+    std::memset(dst + input_bytes, 0, padding_bytes);
+    return Status::OK();
+  }
+  if (input_bytes > 0) {
+    se::DeviceMemoryBase dst_mem(dst, input_bytes);
+    se::DeviceMemoryBase src_mem(const_cast<void*>(DMAHelper::base(&input)),
+                                 input_bytes);
+    stream->ThenMemcpy(&dst_mem, src_mem, input_bytes);
+  }
+  if (padding_bytes > 0) {
+    se::DeviceMemoryBase padding_mem(dst + input_bytes, padding_bytes);
+    stream->ThenMemZero(&padding_mem, padding_bytes);
+  }
+  if (!stream->ok()) {
+    return errors::Internal("Failed to pad XLA launch input");
+  }
+  return Status::OK();
+}
+
 static Status CompileToLocalExecutable(
     OpKernelContext* ctx, const NameAttrList& function,
     const XlaPlatformInfo& platform_info, absl::Span<const int> resources,
-    absl::Span<const int> constants, bool lazy, xla::LocalClient** client,
+    absl::Span<const int> constants,
+    const std::map<int, int64>& dynamic_dim_bounds, bool lazy,
+    xla::LocalClient** client,
     std::map<int, OptionalTensor>* variables,
     const XlaCompiler::CompilationResult** kernel,
-    xla::LocalExecutable** executable) {
+    xla::LocalExecutable** executable,
+    XlaCompilationCache::EntryRef* entry_ref) {
   // We store information about the JIT-compiled XLA computation
   // in the ResourceMgr.
   ResourceMgr* rm = ctx->resource_manager();
@@ -277,11 +363,11 @@ static Status CompileToLocalExecutable(
   // rather than a one-element tuple.
   compile_options.always_return_tuple = false;
 
-  return cache->Compile(options, function, constant_args, *variables, ctx,
-                        compile_options,
+  return cache->Compile(options, function, constant_args, *variables,
+                        dynamic_dim_bounds, ctx, compile_options,
                         lazy ? XlaCompilationCache::CompileMode::kLazy
                              : XlaCompilationCache::CompileMode::kStrict,
-                        kernel, executable);
+                        kernel, executable, entry_ref);
 }
 
 void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
@@ -291,24 +377,56 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
   xla::LocalClient* client;
   const XlaCompiler::CompilationResult* kernel;
   xla::LocalExecutable* executable;
+  XlaCompilationCache::EntryRef entry_ref;
   std::map<int, OptionalTensor> variables;
 
-  OP_REQUIRES_OK(
-      ctx, CompileToLocalExecutable(ctx, function_, platform_info_, resources_,
-                                    constants_, /*lazy=*/false, &client,
-                                    &variables, &kernel, &executable));
+  // With a dynamic leading dimension one compilation serves every size up to
+  // its bound.  If the compiler can't prove that padding the cluster is safe,
+  // compile it for the exact shapes instead.
+  std::map<int, int64> dynamic_dim_bounds;
+  if (legacy_flags::GetXlaOpsCommonFlags().tf_xla_dynamic_leading_dim &&
+      !platform_info_.is_on_xla_device()) {
+    dynamic_dim_bounds = DynamicLeadingDimBounds(ctx, constants_, resources_);
+  }
+  Status s = CompileToLocalExecutable(
+      ctx, function_, platform_info_, resources_, constants_,
+      dynamic_dim_bounds, /*lazy=*/false, &client, &variables, &kernel,
+      &executable, &entry_ref);
+  if (!s.ok() && !dynamic_dim_bounds.empty()) {
+    VLOG(1) << "Compiling " << function_.name()
+            << " for exact shapes: " << s;
+    dynamic_dim_bounds.clear();
+    s = CompileToLocalExecutable(ctx, function_, platform_info_, resources_,
+                                 constants_, dynamic_dim_bounds,
+                                 /*lazy=*/false, &client, &variables, &kernel,
+                                 &executable, &entry_ref);
+  }
+  OP_REQUIRES_OK(ctx, s);
 
   se::Stream* stream =
       ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
 
+  // The padded inputs are passed like the variable snapshots.
+  std::map<int, OptionalTensor> inputs = variables;
+  for (const auto& bound : dynamic_dim_bounds) {
+    OptionalTensor& padded = inputs[bound.first];
+    padded.present = true;
+    OP_REQUIRES_OK(ctx, PadLeadingDim(ctx, ctx->input(bound.first),
+                                      bound.second, &padded.value));
+  }
+
   VLOG(1) << "Executing XLA Computation...";
 
   XlaComputationLaunchContext launch_context(
       client, platform_info_.allocator(),
       /*allocate_xla_tensors=*/platform_info_.is_on_xla_device(),
       platform_info_.UseMultipleStreams());
-  launch_context.PopulateInputs(ctx, kernel, variables,
+  launch_context.PopulateInputs(ctx, kernel, inputs,
                                 /*missing_ctx_input_prefix=*/0);
+  if (!dynamic_dim_bounds.empty()) {
+    launch_context.set_dynamic_leading_dim_size(
+        ctx->input(dynamic_dim_bounds.begin()->first).dim_size(0));
+  }
 
   // Execute the computation.
   VLOG(2) << "Executing computation.";
@@ -407,6 +525,7 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
   xla::LocalClient* client;
   const XlaCompiler::CompilationResult* kernel;
   xla::LocalExecutable* executable;
+  XlaCompilationCache::EntryRef entry_ref;
   std::map<int, OptionalTensor> variables;
 
   if (legacy_flags::GetXlaOpsCommonFlags().tf_xla_always_defer_compilation) {
@@ -414,8 +533,9 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
   } else {
     OP_REQUIRES_OK(ctx, CompileToLocalExecutable(
                             ctx, function_, platform_info_, resources_,
-                            constants_, /*lazy=*/!must_compile_, &client,
-                            &variables, &kernel, &executable));
+                            constants_, /*dynamic_dim_bounds=*/{},
+                            /*lazy=*/!must_compile_, &client, &variables,
+                            &kernel, &executable, &entry_ref));
   }
 
   AllocatorAttributes host_alloc_attrs;
@@ -440,7 +560,8 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
   // variables.
   XlaExecutableClosureStore::KeyT key =
       XlaExecutableClosureStore::Global()->Produce(XlaExecutableClosure(
-          client, executable, kernel, std::move(variables), constants_.size()));
+          client, executable, kernel, std::move(variables), constants_.size(),
+          std::move(entry_ref)));
 
   Tensor compilation_key(cpu_allocator, DT_STRING, TensorShape({}));
   compilation_key.flat<string>()(0) = key;
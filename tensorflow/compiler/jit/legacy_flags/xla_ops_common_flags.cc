@@ -31,9 +31,13 @@ std::once_flag flags_init;
 void AllocateAndParseFlags() {
   flags = new XlaOpsCommonFlags;
   flags->tf_xla_always_defer_compilation = false;
+  flags->tf_xla_dynamic_leading_dim = false;
   flag_list = new std::vector<Flag>({
       Flag("tf_xla_always_defer_compilation",
            &flags->tf_xla_always_defer_compilation, ""),
+      Flag("tf_xla_dynamic_leading_dim", &flags->tf_xla_dynamic_leading_dim,
+           "Compile XlaLaunch clusters for power-of-two bounds of the "
+           "leading dimension of their parameters and pad them to it."),
   });
   xla::legacy_flags::ParseFlagsFromEnv(*flag_list);
 }
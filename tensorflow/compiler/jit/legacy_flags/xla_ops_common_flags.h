@@ -23,6 +23,14 @@ struct XlaOpsCommonFlags {
   // If true, _XlaCompile always refuses to compile the cluster, which means the
   // XLA clusters always run in the TF executor.  Defaults to false.
   bool tf_xla_always_defer_compilation;
+
+  // If true, XlaLaunch treats dimension 0 of the highest-rank parameters of a
+  // cluster as dynamic when they agree on it, and compiles the cluster once
+  // per power-of-two bound of that dimension rather than once per size,
+  // padding the parameters up to the bound.  Clusters the compiler can't
+  // prove row-independent are compiled for their exact shapes as before.
+  // Defaults to false.
+  bool tf_xla_dynamic_leading_dim;
 };
 
 // Parses the flags in XlaOpsCommonFlags from the TF_XLA_FLAGS environment
@@ -16,41 +16,93 @@ limitations under the License.
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 
 #include <numeric>
+#include <set>
 
+#include "absl/strings/str_join.h"
 #include "tensorflow/compiler/tf2xla/dump_graph.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
 #include "tensorflow/compiler/tf2xla/type_util.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/compiler/xla/legacy_flags/debug_options_flags.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/graph_optimizer.h"
 #include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/kernels/variable_ops.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
-XlaCompilationCache::XlaCompilationCache(xla::LocalClient* client,
-                                         DeviceType device_type)
-    : client_(client), device_type_(std::move(device_type)) {}
+namespace {
 
-XlaCompilationCache::~XlaCompilationCache() {
-  // Ensure any use of our programs have completed by waiting for all stream
-  // executors to complete.
-  for (auto* executor : client_->backend().stream_executors()) {
+auto* compile_counter = monitoring::Counter<1>::New(
+    "/tensorflow/compiler/jit/xla_compilation_cache/compiles",
+    "Number of XLA compilations, by cluster.", "cluster");
+
+auto* compile_time_counter = monitoring::Counter<1>::New(
+    "/tensorflow/compiler/jit/xla_compilation_cache/compile_time_usecs",
+    "Time spent on XLA compilations, by cluster.", "cluster");
+
+auto* eviction_counter = monitoring::Counter<1>::New(
+    "/tensorflow/compiler/jit/xla_compilation_cache/evictions",
+    "Number of compiled XLA signatures evicted from the compilation cache, "
+    "by cluster.",
+    "cluster");
+
+// Waits for all programs launched through `client` to complete.
+void SynchronizeAllExecutors(xla::LocalClient* client) {
+  for (auto* executor : client->backend().stream_executors()) {
     bool ok = executor->SynchronizeAllActivity();
     if (!ok) {
       LOG(ERROR) << "Error synchronizing activity while waiting for all "
                     "programs to complete";
     }
   }
+}
+
+}  // namespace
+
+XlaCompilationCache::XlaCompilationCache(xla::LocalClient* client,
+                                         DeviceType device_type)
+    : client_(client),
+      device_type_(std::move(device_type)),
+      max_executables_per_cluster_(0) {
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_XLA_MAX_EXECUTABLES_PER_CLUSTER", 0,
+                                  &max_executables_per_cluster_));
+  int64 async_compile_threads;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_XLA_ASYNC_COMPILATION_THREADS", 0,
+                                  &async_compile_threads));
+  if (async_compile_threads > 0) {
+    async_compile_pool_.reset(new thread::ThreadPool(
+        Env::Default(), "xla_async_compile", async_compile_threads));
+  }
+  string persistent_cache_dir;
+  TF_CHECK_OK(ReadStringFromEnvVar("TF_XLA_PERSISTENT_CACHE_DIR", "",
+                                   &persistent_cache_dir));
+  if (!persistent_cache_dir.empty()) {
+    persistent_cache_.reset(new XlaPersistentCompilationCache(
+        persistent_cache_dir, device_type_.type_string(),
+        client_->platform()->Name()));
+  }
+}
+
+XlaCompilationCache::~XlaCompilationCache() {
+  // Wait for background compilations, which reference this object.
+  async_compile_pool_.reset();
+  // Ensure any use of our programs have completed by waiting for all stream
+  // executors to complete.
+  SynchronizeAllExecutors(client_);
   // TODO(b/110813685): Think about the program ownership model. Programs are
   // currently owned by the compilation cache which means we must wait for
   // program completion in the destructor. There are multiple compilation caches
@@ -75,12 +127,17 @@ string XlaCompilationCache::SignatureDebugString(const Signature& sig) {
   for (const auto& v : sig.arg_values) {
     absl::StrAppend(&result, "; ", v.DebugString());
   }
+  if (!sig.dynamic_args.empty()) {
+    absl::StrAppend(&result, "; dynamic ",
+                    absl::StrJoin(sig.dynamic_args, ","));
+  }
   return result;
 }
 
 bool XlaCompilationCache::Signature::operator==(const Signature& other) const {
   if (name != other.name) return false;
   if (arg_types != other.arg_types) return false;
+  if (dynamic_args != other.dynamic_args) return false;
 
   if (arg_values.size() != other.arg_values.size()) return false;
   for (int i = 0; i < arg_values.size(); ++i) {
@@ -105,12 +162,16 @@ uint64 XlaCompilationCache::Signature::Hash::operator()(
     h = Hash64Combine(
         h, Hash64(arg.tensor_data().data(), arg.tensor_data().size()));
   }
+  for (int arg : signature.dynamic_args) {
+    h = Hash64Combine(h, std::hash<int>()(arg));
+  }
   return h;
 }
 
 Status XlaCompilationCache::BuildSignature(
     const NameAttrList& function, const std::map<int, Tensor>& constant_args,
-    const std::map<int, OptionalTensor>& variable_args, OpKernelContext* ctx,
+    const std::map<int, OptionalTensor>& variable_args,
+    const std::map<int, int64>& dynamic_dim_bounds, OpKernelContext* ctx,
     Signature* signature) {
   signature->name = Canonicalize(function.name(), AttrSlice(&function.attr()));
   signature->arg_values.reserve(constant_args.size());
@@ -129,6 +190,13 @@ Status XlaCompilationCache::BuildSignature(
       } else {
         signature->arg_types.emplace_back(DT_INVALID, TensorShape());
       }
+    } else if (dynamic_dim_bounds.count(i) > 0) {
+      TensorShape shape = ctx->input(i).shape();
+      TF_RET_CHECK(shape.dims() > 0 &&
+                   shape.dim_size(0) <= dynamic_dim_bounds.at(i));
+      shape.set_dim(0, dynamic_dim_bounds.at(i));
+      signature->arg_types.emplace_back(ctx->input_dtype(i), shape);
+      signature->dynamic_args.push_back(i);
     } else {
       signature->arg_types.emplace_back(ctx->input_dtype(i),
                                         ctx->input(i).shape());
@@ -137,11 +205,86 @@ Status XlaCompilationCache::BuildSignature(
   return Status::OK();
 }
 
+Status XlaCompilationCache::BuildPersistentKey(
+    const XlaCompiler::Options& options, const NameAttrList& function,
+    const XlaCompiler::CompileOptions& compile_options,
+    const Signature& signature, string* key) {
+  if (options.flib_def == nullptr) {
+    return errors::FailedPrecondition("No function library to fingerprint");
+  }
+  string result;
+  absl::StrAppend(&result, signature.name, ";");
+  for (const auto& a : signature.arg_types) {
+    absl::StrAppend(&result, DataTypeString(a.first), a.second.DebugString(),
+                    ",");
+  }
+  for (const Tensor& v : signature.arg_values) {
+    if (!DataTypeCanUseMemcpy(v.dtype())) {
+      return errors::Unimplemented("Constant argument of type ",
+                                   DataTypeString(v.dtype()));
+    }
+    absl::StrAppend(&result, ";", DataTypeString(v.dtype()),
+                    v.shape().DebugString(), ":", v.tensor_data().size(), ":",
+                    v.tensor_data());
+  }
+  absl::StrAppend(&result, ";", absl::StrJoin(signature.dynamic_args, ","));
+
+  // Function names are only unique within a graph, so the key must cover the
+  // bodies of every function the cluster may call.
+  std::set<string> reachable;
+  std::vector<string> pending = {function.name()};
+  while (!pending.empty()) {
+    string name = pending.back();
+    pending.pop_back();
+    const FunctionDef* fdef = options.flib_def->Find(name);
+    if (fdef == nullptr || !reachable.insert(name).second) continue;
+    for (const NodeDef& node : fdef->node_def()) {
+      if (options.flib_def->Find(node.op()) != nullptr) {
+        pending.push_back(node.op());
+      }
+      for (const auto& attr : node.attr()) {
+        if (attr.second.has_func()) {
+          pending.push_back(attr.second.func().name());
+        }
+        for (const NameAttrList& f : attr.second.list().func()) {
+          pending.push_back(f.name());
+        }
+      }
+    }
+  }
+  if (reachable.count(function.name()) == 0) {
+    return errors::NotFound("Function ", function.name(), " not found");
+  }
+  for (const string& name : reachable) {
+    absl::StrAppend(&result, ";", name, "=",
+                    FunctionDefHash(*options.flib_def->Find(name)));
+  }
+
+  absl::StrAppend(
+      &result, ";", device_type_.type_string(), ",", options.graph_def_version,
+      ",", static_cast<int>(options.allow_cpu_custom_calls), ",",
+      static_cast<int>(compile_options.use_tuple_arg), ",",
+      static_cast<int>(compile_options.return_updated_values_for_all_resources),
+      ",", static_cast<int>(compile_options.resolve_compile_time_constants),
+      ",", static_cast<int>(compile_options.always_return_tuple), ",",
+      static_cast<int>(compile_options.is_entry_computation), ",",
+      static_cast<int>(compile_options.add_token_input_output), ";");
+  string debug_options;
+  if (!SerializeToStringDeterministic(
+          xla::legacy_flags::GetDebugOptionsFromFlags(), &debug_options)) {
+    return errors::Internal("Unable to serialize XLA debug options");
+  }
+  absl::StrAppend(&result, debug_options);
+  *key = std::move(result);
+  return Status::OK();
+}
+
 namespace {
 
 // Builds a XlaCompiler::Argument vector from the arguments to the XlaLaunch op.
 Status BuildArguments(const std::map<int, Tensor>& constant_args,
                       const std::map<int, OptionalTensor>& variable_args,
+                      const std::map<int, int64>& dynamic_dim_bounds,
                       OpKernelContext* ctx,
                       std::vector<XlaCompiler::Argument>* args) {
   args->resize(ctx->num_inputs());
@@ -160,14 +303,19 @@ Status BuildArguments(const std::map<int, Tensor>& constant_args,
       // Handles the non-constant arguments.
       const Tensor& input = ctx->input(input_num);
       TF_RET_CHECK(input.dtype() != DT_RESOURCE);
-      if (input.NumElements() > 0) {
+      arg.type = input.dtype();
+      arg.shape = input.shape();
+      if (dynamic_dim_bounds.count(input_num) > 0) {
+        // The padded input is passed even if it has no rows.
+        arg.kind = XlaCompiler::Argument::kParameter;
+        arg.shape.set_dim(0, dynamic_dim_bounds.at(input_num));
+        arg.dynamic_leading_dim = true;
+      } else if (input.NumElements() > 0) {
         arg.kind = XlaCompiler::Argument::kParameter;
       } else {
         arg.kind = XlaCompiler::Argument::kConstant;
         arg.constant_value = input;
       }
-      arg.type = input.dtype();
-      arg.shape = input.shape();
     } else {
       // Handles resource variables.
       const Tensor& input = ctx->input(input_num);
@@ -228,18 +376,22 @@ Status XlaCompilationCache::BuildExecutable(
 Status XlaCompilationCache::Compile(
     const XlaCompiler::Options& options, const NameAttrList& function,
     const std::map<int, Tensor>& constant_args,
-    const std::map<int, OptionalTensor>& variable_args, OpKernelContext* ctx,
+    const std::map<int, OptionalTensor>& variable_args,
+    const std::map<int, int64>& dynamic_dim_bounds, OpKernelContext* ctx,
     const XlaCompiler::CompileOptions& compile_options,
     CompileMode compile_mode,
     const XlaCompiler::CompilationResult** out_compilation_result,
-    xla::LocalExecutable** out_executable) {
+    xla::LocalExecutable** out_executable, EntryRef* out_entry_ref) {
   // Set the compile threshold to 1 to implement CompileMode::kStrict.
   int64 compile_threshold =
       compile_mode == CompileMode::kLazy ? kDefaultCompilationThreshold : 1;
-  return CompileImpl(options, function, constant_args, variable_args, ctx,
-                     compile_options, /*compile_single_op=*/false,
-                     /*compile_threshold=*/compile_threshold,
-                     out_compilation_result, out_executable);
+  const bool compile_async =
+      compile_mode == CompileMode::kLazy && async_compile_pool_ != nullptr;
+  return CompileImpl(options, function, constant_args, variable_args,
+                     dynamic_dim_bounds, ctx, compile_options,
+                     /*compile_single_op=*/false,
+                     /*compile_threshold=*/compile_threshold, compile_async,
+                     out_compilation_result, out_executable, out_entry_ref);
 }
 
 Status XlaCompilationCache::CompileSingleOp(
@@ -248,26 +400,29 @@ Status XlaCompilationCache::CompileSingleOp(
     const std::map<int, OptionalTensor>& variable_args, OpKernelContext* ctx,
     const XlaCompiler::CompileOptions& compile_options,
     const XlaCompiler::CompilationResult** out_compilation_result,
-    xla::LocalExecutable** out_executable) {
+    xla::LocalExecutable** out_executable, EntryRef* out_entry_ref) {
   const NodeDef& def = ctx->op_kernel().def();
   NameAttrList name;
   name.set_name(def.op());
   *name.mutable_attr() = def.attr();
-  return CompileImpl(options, name, constant_args, variable_args, ctx,
-                     compile_options,
+  return CompileImpl(options, name, constant_args, variable_args,
+                     /*dynamic_dim_bounds=*/{}, ctx, compile_options,
                      /*compile_single_op=*/true, /*compile_threshold=*/1,
-                     out_compilation_result, out_executable);
+                     /*compile_async=*/false, out_compilation_result,
+                     out_executable, out_entry_ref);
 }
 
 Status XlaCompilationCache::CompileImpl(
     const XlaCompiler::Options& options, const NameAttrList& function,
     const std::map<int, Tensor>& constant_args,
-    const std::map<int, OptionalTensor>& variable_args, OpKernelContext* ctx,
+    const std::map<int, OptionalTensor>& variable_args,
+    const std::map<int, int64>& dynamic_dim_bounds, OpKernelContext* ctx,
     const XlaCompiler::CompileOptions& compile_options, bool compile_single_op,
-    int64 compile_threshold,
+    int64 compile_threshold, bool compile_async,
     const XlaCompiler::CompilationResult** out_compilation_result,
-    xla::LocalExecutable** out_executable) {
+    xla::LocalExecutable** out_executable, EntryRef* out_entry_ref) {
   DCHECK_NE(out_executable, nullptr);
+  DCHECK_NE(out_entry_ref, nullptr);
   VLOG(2) << "XlaCompilationCache::Compile " << DebugString();
 
   if (VLOG_IS_ON(2)) {
@@ -298,20 +453,32 @@ Status XlaCompilationCache::CompileImpl(
 
   Signature signature;
   TF_RETURN_IF_ERROR(
-      BuildSignature(function, constant_args, variable_args, ctx, &signature));
+      BuildSignature(function, constant_args, variable_args,
+                     dynamic_dim_bounds, ctx, &signature));
 
   VLOG(2) << "Signature: " << SignatureDebugString(signature);
   // The outer lock protects the existence of the cache entry. It does not
   // protect the contents of the cache entry.
-  Entry* entry;
+  std::shared_ptr<Entry> entry;
   {
     mutex_lock lock(compile_cache_mu_);
     // Find or create a cache entry.
-    std::unique_ptr<Entry>& e = cache_[signature];
+    std::shared_ptr<Entry>& e = cache_[signature];
     if (!e) {
-      e.reset(new Entry);
+      // An evicted entry may be destroyed while its program is still
+      // running asynchronously, so wait for that before freeing it.
+      xla::LocalClient* client = client_;
+      e = std::shared_ptr<Entry>(new Entry, [client](Entry* dead) {
+        bool has_executable;
+        {
+          mutex_lock lock(dead->mu);
+          has_executable = dead->executable != nullptr;
+        }
+        if (has_executable) SynchronizeAllExecutors(client);
+        delete dead;
+      });
     }
-    entry = e.get();
+    entry = e;
   }
 
   // We always compile a cluster the very first time it is executed.  This is an
@@ -327,70 +494,205 @@ Status XlaCompilationCache::CompileImpl(
     return it->second.execution_count++ == 0;
   }();
 
-  // Acquire the cache entry lock and compile, if necessary.
-  // TODO(phawkins): this locking will need to be restructured when we implement
-  // cache eviction.
+  // Acquire the cache entry lock and compile, if necessary.  Evicting an entry
+  // only drops the reference held by cache_, so `entry` stays valid.
   mutex_lock entry_lock(entry->mu);
   int64 current_request_count = ++entry->request_count;
+  const bool cache_hit = entry->compiled;
   if (!entry->compiled) {
     VLOG(2) << "Compilation cache miss for signature: "
             << SignatureDebugString(signature) << " with request count "
             << current_request_count << " and compile threshold "
             << compile_threshold;
+    if (compile_async) {
+      // Let the caller fall back to the TensorFlow graph until the
+      // background compilation has finished.
+      if (!entry->compiling) {
+        std::vector<XlaCompiler::Argument> args;
+        TF_RETURN_IF_ERROR(BuildArguments(constant_args, variable_args,
+                                          dynamic_dim_bounds, ctx, &args));
+        entry->compiling = true;
+        ScheduleAsyncCompile(options, function, signature, std::move(args),
+                             compile_options, entry);
+      }
+      *out_compilation_result = nullptr;
+      *out_executable = nullptr;
+      out_entry_ref->reset();
+      return Status::OK();
+    }
     if (!is_first_execution && current_request_count < compile_threshold) {
       *out_compilation_result = nullptr;
       *out_executable = nullptr;
+      out_entry_ref->reset();
       return Status::OK();
     }
 
-    tensorflow::Env* env = tensorflow::Env::Default();
-    const uint64 compile_start_us = env->NowMicros();
     // Do the actual JIT compilation without holding the lock (it can take
     // a long time.)
     std::vector<XlaCompiler::Argument> args;
-    TF_RETURN_IF_ERROR(
-        BuildArguments(constant_args, variable_args, ctx, &args));
+    TF_RETURN_IF_ERROR(BuildArguments(constant_args, variable_args,
+                                      dynamic_dim_bounds, ctx, &args));
 
-    XlaCompiler compiler(options);
+    CHECK_EQ(entry->executable.get(), nullptr);
     entry->compiled = true;
+    entry->compilation_status = CompileToExecutable(
+        options, function, signature, args, compile_options, compile_single_op,
+        ctx, &entry->compilation_result, &entry->executable);
+  }
+  TF_RETURN_IF_ERROR(entry->compilation_status);
+  if (max_executables_per_cluster_ > 0) {
+    std::vector<std::shared_ptr<Entry>> evicted;
+    {
+      mutex_lock lock(compile_cache_mu_);
+      TouchLocked(function.name(), signature, entry.get(),
+                  /*insert=*/!cache_hit, &evicted);
+    }
+    // The evicted entries, and their executables, are destroyed here unless
+    // a caller still holds an EntryRef to them.
+  }
+  *out_compilation_result = &entry->compilation_result;
+  *out_executable = entry->executable.get();
+  *out_entry_ref = entry;
+  return Status::OK();
+}
 
+Status XlaCompilationCache::CompileToExecutable(
+    const XlaCompiler::Options& options, const NameAttrList& function,
+    const Signature& signature, const std::vector<XlaCompiler::Argument>& args,
+    const XlaCompiler::CompileOptions& compile_options, bool compile_single_op,
+    OpKernelContext* ctx, XlaCompiler::CompilationResult* result,
+    std::unique_ptr<xla::LocalExecutable>* executable) {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  const uint64 compile_start_us = env->NowMicros();
+
+  // Single ops are cheap to lower, so only functions go to the persistent
+  // tier.
+  string persistent_key;
+  if (persistent_cache_ && !compile_single_op) {
+    Status s = BuildPersistentKey(options, function, compile_options,
+                                  signature, &persistent_key);
+    if (!s.ok()) {
+      VLOG(1) << "Not using the persistent compilation cache for "
+              << function.name() << ": " << s;
+      persistent_key.clear();
+    }
+  }
+
+  if (persistent_key.empty() ||
+      !persistent_cache_->Lookup(persistent_key, result)) {
+    XlaCompiler compiler(options);
     if (compile_single_op) {
-      entry->compilation_status =
-          compiler.CompileSingleOp(compile_options, signature.name, ctx, args,
-                                   &entry->compilation_result);
+      TF_RETURN_IF_ERROR(compiler.CompileSingleOp(
+          compile_options, signature.name, ctx, args, result));
     } else {
-      entry->compilation_status = compiler.CompileFunction(
-          compile_options, function, args, &entry->compilation_result);
+      TF_RETURN_IF_ERROR(
+          compiler.CompileFunction(compile_options, function, args, result));
     }
-    TF_RETURN_IF_ERROR(entry->compilation_status);
-    CHECK_EQ(entry->executable.get(), nullptr);
-    entry->compilation_status =
-        BuildExecutable(options, entry->compilation_result, &entry->executable);
+    if (!persistent_key.empty()) {
+      Status s = persistent_cache_->Store(persistent_key, *result);
+      if (!s.ok()) {
+        LOG(WARNING) << "Unable to persist the compilation of "
+                     << function.name() << ": " << s;
+      }
+    }
+  }
+  Status status = BuildExecutable(options, *result, executable);
 
-    const uint64 compile_end_us = env->NowMicros();
-    const uint64 compile_time_us = compile_end_us - compile_start_us;
+  const uint64 compile_end_us = env->NowMicros();
+  const uint64 compile_time_us = compile_end_us - compile_start_us;
+  compile_counter->GetCell(function.name())->IncrementBy(1);
+  compile_time_counter->GetCell(function.name())->IncrementBy(compile_time_us);
+  metrics::UpdateXlaCompilationTime(compile_time_us);
+  {
+    mutex_lock lock(cluster_compile_stats_mu_);
+    auto it = cluster_compile_stats_.find(function.name());
+    it->second.compile_count++;
+    it->second.cumulative_compile_time_us += compile_time_us;
+    VLOG(1) << "compiled " << function.name() << " "
+            << it->second.compile_count
+            << " times, compile time: " << compile_time_us
+            << " us, cumulative: " << it->second.cumulative_compile_time_us
+            << " us ("
+            << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
+                                                             1.0e6)
+            << " / "
+            << tensorflow::strings::HumanReadableElapsedTime(
+                   it->second.cumulative_compile_time_us / 1.0e6)
+            << ")";
+  }
+  return status;
+}
+
+void XlaCompilationCache::ScheduleAsyncCompile(
+    const XlaCompiler::Options& options, const NameAttrList& function,
+    const Signature& signature, std::vector<XlaCompiler::Argument> args,
+    const XlaCompiler::CompileOptions& compile_options,
+    std::shared_ptr<Entry> entry) {
+  // The function library and the allocator belong to the requesting kernel,
+  // which may be gone by the time the compilation runs.  Without an allocator
+  // the backend compiler allocates any scratch memory it needs itself.
+  XlaCompiler::Options async_options = options;
+  std::shared_ptr<FunctionLibraryDefinition> flib_def;
+  if (options.flib_def != nullptr) {
+    flib_def = std::make_shared<FunctionLibraryDefinition>(*options.flib_def);
+  }
+  async_options.flib_def = flib_def.get();
+  async_options.device_allocator = nullptr;
+  VLOG(1) << "Scheduling background compilation of "
+          << SignatureDebugString(signature);
+  async_compile_pool_->Schedule([this, async_options, flib_def, function,
+                                 signature, args, compile_options, entry]() {
+    XlaCompiler::CompilationResult result;
+    std::unique_ptr<xla::LocalExecutable> executable;
+    Status status = CompileToExecutable(
+        async_options, function, signature, args, compile_options,
+        /*compile_single_op=*/false, /*ctx=*/nullptr, &result, &executable);
+    if (!status.ok()) {
+      LOG(WARNING) << "Background compilation of " << function.name()
+                   << " failed: " << status;
+    }
     {
-      mutex_lock lock(cluster_compile_stats_mu_);
-      auto it = cluster_compile_stats_.find(function.name());
-      it->second.compile_count++;
-      it->second.cumulative_compile_time_us += compile_time_us;
-      VLOG(1) << "compiled " << function.name() << " "
-              << it->second.compile_count
-              << " times, compile time: " << compile_time_us
-              << " us, cumulative: " << it->second.cumulative_compile_time_us
-              << " us ("
-              << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
-                                                               1.0e6)
-              << " / "
-              << tensorflow::strings::HumanReadableElapsedTime(
-                     it->second.cumulative_compile_time_us / 1.0e6)
-              << ")";
+      mutex_lock lock(entry->mu);
+      entry->compilation_result = std::move(result);
+      entry->executable = std::move(executable);
+      entry->compilation_status = status;
+      entry->compiled = true;
+      entry->compiling = false;
     }
+    if (status.ok() && max_executables_per_cluster_ > 0) {
+      std::vector<std::shared_ptr<Entry>> evicted;
+      mutex_lock lock(compile_cache_mu_);
+      TouchLocked(function.name(), signature, entry.get(),
+                  /*insert=*/true, &evicted);
+    }
+  });
+}
+
+void XlaCompilationCache::TouchLocked(
+    const string& cluster, const Signature& signature, Entry* entry,
+    bool insert, std::vector<std::shared_ptr<Entry>>* evicted) {
+  std::list<Signature>& lru = cluster_lru_[cluster];
+  if (entry->in_lru) {
+    lru.splice(lru.begin(), lru, entry->lru_position);
+    return;
+  }
+  // A hit on an entry that is not in the list means another thread evicted
+  // it after this one looked it up; leave it evicted.
+  if (!insert) return;
+  lru.push_front(signature);
+  entry->in_lru = true;
+  entry->lru_position = lru.begin();
+  while (static_cast<int64>(lru.size()) > max_executables_per_cluster_) {
+    auto it = cache_.find(lru.back());
+    CHECK(it != cache_.end());
+    VLOG(1) << "Evicting " << SignatureDebugString(lru.back())
+            << " from the compilation cache";
+    it->second->in_lru = false;
+    evicted->push_back(std::move(it->second));
+    cache_.erase(it);
+    lru.pop_back();
+    eviction_counter->GetCell(cluster)->IncrementBy(1);
   }
-  TF_RETURN_IF_ERROR(entry->compilation_status);
-  *out_compilation_result = &entry->compilation_result;
-  *out_executable = entry->executable.get();
-  return Status::OK();
 }
 
 }  // namespace tensorflow
@@ -16,7 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_JIT_XLA_COMPILATION_CACHE_H_
 #define TENSORFLOW_COMPILER_JIT_XLA_COMPILATION_CACHE_H_
 
+#include <list>
+#include <memory>
+
 #include "absl/container/flat_hash_map.h"
+#include "tensorflow/compiler/jit/xla_persistent_compilation_cache.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
@@ -43,8 +47,19 @@ struct OptionalTensor {
 // Since XLA computations must have static shapes, the cache generates a new
 // XLA computation for each new set of input shapes.
 //
-// Currently no cache eviction policy is implemented and the cache grows without
-// bound.
+// By default the cache grows without bound.  If the
+// TF_XLA_MAX_EXECUTABLES_PER_CLUSTER environment variable is positive, at most
+// that many compiled signatures are kept per cluster and the least recently
+// used one is evicted to make room for a new one.
+//
+// If the TF_XLA_ASYNC_COMPILATION_THREADS environment variable is positive,
+// lazy compilations (see CompileMode) run on a pool of that many background
+// threads.  Until a signature has been compiled, Compile returns no
+// executable for it and the caller runs the cluster as a TensorFlow graph.
+//
+// If the TF_XLA_PERSISTENT_CACHE_DIR environment variable names a directory,
+// compilation results of functions are also persisted there and reused by
+// other processes; see XlaPersistentCompilationCache.
 class XlaCompilationCache : public ResourceBase {
  public:
   XlaCompilationCache(xla::LocalClient* client, DeviceType device_type);
@@ -55,6 +70,11 @@ class XlaCompilationCache : public ResourceBase {
     kStrict,
   };
 
+  // Keeps the compilation result and executable returned by Compile alive
+  // after their cache entry is evicted.  Callers must hold it for as long as
+  // they use either.
+  using EntryRef = std::shared_ptr<const void>;
+
   // Compiles a function into a XlaCompiler::CompilationResult that can be used
   // to execute an XLA Computation. Compilation results are cached.
   // `function` is the name of a Tensorflow function to compile.
@@ -63,28 +83,37 @@ class XlaCompilationCache : public ResourceBase {
   // `variable_args` is a snapshot of the current values of the
   // resource variable arguments to `function`; uninitialized variables are
   // represented by an absent OptionalTensor.
+  // `dynamic_dim_bounds` maps the numbers of parameters whose dimension 0
+  //  is dynamic to its upper bound.  Such parameters are compiled with the
+  //  bound in place of their size (see
+  //  XlaCompiler::Argument::dynamic_leading_dim), and the caller must pad
+  //  them up to it, so one compilation serves every size up to the bound.
   //
   // `compile_mode` controls the behavior of the compilation cache on a cache
   // miss.  If `compile_mode` is `kLazy` then, based on some profitability
   // heuristics, the compilation cache may decide not to compile the cluster at
   // this time.  In this case it returns null into both `out_compilation_result`
   // and `out_executable`.  If `compile_mode` is `kStrict` then the compilation
-  // cache always attempts the compilation on a cache miss.
+  // cache always attempts the compilation on a cache miss.  With background
+  // compilation enabled, `kLazy` schedules the compilation on a miss and
+  // returns null until it has finished.
   //
   // The result of compilation is written to `*compilation_result`, which must
   // be non-null. If `executable` is non-null, also builds an
   // xla::LocalExecutable and sets `executable` to point to it. The resulting
   // executable pointer may be null if the computation has no non-constant
-  // outputs.
+  // outputs.  `*out_entry_ref` is set to keep both alive.
   Status Compile(const XlaCompiler::Options& options,
                  const NameAttrList& function,
                  const std::map<int, Tensor>& constant_args,
                  const std::map<int, OptionalTensor>& variable_args,
+                 const std::map<int, int64>& dynamic_dim_bounds,
                  OpKernelContext* ctx,
                  const XlaCompiler::CompileOptions& compile_options,
                  CompileMode compile_mode,
                  const XlaCompiler::CompilationResult** out_compilation_result,
-                 xla::LocalExecutable** out_executable);
+                 xla::LocalExecutable** out_executable,
+                 EntryRef* out_entry_ref);
 
   // As above, but calls XlaCompiler::CompileSingleOp instead of
   // XlaCompiler::CompileFunction.
@@ -94,7 +123,7 @@ class XlaCompilationCache : public ResourceBase {
       const std::map<int, OptionalTensor>& variable_args, OpKernelContext* ctx,
       const XlaCompiler::CompileOptions& compile_options,
       const XlaCompiler::CompilationResult** out_compilation_result,
-      xla::LocalExecutable** out_executable);
+      xla::LocalExecutable** out_executable, EntryRef* out_entry_ref);
 
   xla::LocalClient* client() const { return client_; }
   const DeviceType& device_type() const { return device_type_; }
@@ -106,11 +135,12 @@ class XlaCompilationCache : public ResourceBase {
   Status CompileImpl(
       const XlaCompiler::Options& options, const NameAttrList& function,
       const std::map<int, Tensor>& constant_args,
-      const std::map<int, OptionalTensor>& variable_args, OpKernelContext* ctx,
+      const std::map<int, OptionalTensor>& variable_args,
+      const std::map<int, int64>& dynamic_dim_bounds, OpKernelContext* ctx,
       const XlaCompiler::CompileOptions& compile_options,
-      bool compile_single_op, int64 compile_threshold,
+      bool compile_single_op, int64 compile_threshold, bool compile_async,
       const XlaCompiler::CompilationResult** out_compilation_result,
-      xla::LocalExecutable** out_executable);
+      xla::LocalExecutable** out_executable, EntryRef* out_entry_ref);
 
   // Takes `result` which has been compiled from a Tensorflow subgraph to a
   // XLA computation already, and generates an XLA LocalExecutable `executable`.
@@ -121,6 +151,9 @@ class XlaCompilationCache : public ResourceBase {
   xla::LocalClient* const client_;
   const DeviceType device_type_;
 
+  // Persistent tier consulted on a miss in cache_, or null if disabled.
+  std::unique_ptr<XlaPersistentCompilationCache> persistent_cache_;
+
   // Describes the types, shapes and any compile-time constant arguments
   // to a kernel. Key that uniquely identifies a compilation output.
   struct Signature {
@@ -132,6 +165,10 @@ class XlaCompilationCache : public ResourceBase {
     // compilation, ordered by argument number. Tensors must be in host memory.
     std::vector<Tensor> arg_values;
 
+    // Numbers of the arguments whose dimension 0 is dynamic, in increasing
+    // order.  Their entry in `arg_types` holds the upper bound.
+    std::vector<int> dynamic_args;
+
     bool operator==(const Signature& other) const;
 
     struct Hash {
@@ -140,10 +177,19 @@ class XlaCompilationCache : public ResourceBase {
   };
   static string SignatureDebugString(const Signature& sig);
 
+  // Builds the key of `signature` in persistent_cache_, which covers the
+  // bodies of `function` and of the functions it reaches, the options and
+  // the XLA debug flags in addition to the signature.
+  Status BuildPersistentKey(const XlaCompiler::Options& options,
+                            const NameAttrList& function,
+                            const XlaCompiler::CompileOptions& compile_options,
+                            const Signature& signature, string* key);
+
   // Builds the signature for a compilation.
   Status BuildSignature(const NameAttrList& function,
                         const std::map<int, Tensor>& constant_args,
                         const std::map<int, OptionalTensor>& variable_args,
+                        const std::map<int, int64>& dynamic_dim_bounds,
                         OpKernelContext* ctx, Signature* signature);
 
   // The value associated with a cache entry.
@@ -156,6 +202,9 @@ class XlaCompilationCache : public ResourceBase {
     // The number of times a compilation with this signature has been requested.
     int64 request_count = 0;
 
+    // Is a background compilation of this entry pending?
+    bool compiling GUARDED_BY(mu) = false;
+
     // Did compilation succeed?
     Status compilation_status GUARDED_BY(mu);
 
@@ -165,10 +214,54 @@ class XlaCompilationCache : public ResourceBase {
     // The XLA executable compiled from <computation>. May be null if no
     // executable has been built.
     std::unique_ptr<xla::LocalExecutable> executable GUARDED_BY(mu);
+
+    // Position of the entry in the LRU list of its cluster, valid if
+    // `in_lru` is true.  Both are protected by compile_cache_mu_.
+    bool in_lru = false;
+    std::list<Signature>::iterator lru_position;
   };
 
+  // Lowers `function` to HLO, consulting persistent_cache_, and builds an
+  // executable for it.  `ctx` is only used to compile single ops.
+  Status CompileToExecutable(const XlaCompiler::Options& options,
+                             const NameAttrList& function,
+                             const Signature& signature,
+                             const std::vector<XlaCompiler::Argument>& args,
+                             const XlaCompiler::CompileOptions& compile_options,
+                             bool compile_single_op, OpKernelContext* ctx,
+                             XlaCompiler::CompilationResult* result,
+                             std::unique_ptr<xla::LocalExecutable>* executable);
+
+  // Compiles `entry` on async_compile_pool_ and publishes the result in it.
+  void ScheduleAsyncCompile(const XlaCompiler::Options& options,
+                            const NameAttrList& function,
+                            const Signature& signature,
+                            std::vector<XlaCompiler::Argument> args,
+                            const XlaCompiler::CompileOptions& compile_options,
+                            std::shared_ptr<Entry> entry);
+
+  // Marks `entry`, whose signature is `signature`, as the most recently used
+  // of `cluster`, adding it to the LRU list if `insert` is true, and evicts
+  // entries beyond max_executables_per_cluster_ into `*evicted`.
+  void TouchLocked(const string& cluster, const Signature& signature,
+                   Entry* entry, bool insert,
+                   std::vector<std::shared_ptr<Entry>>* evicted)
+      EXCLUSIVE_LOCKS_REQUIRED(compile_cache_mu_);
+
+  // Maximum number of compiled entries kept per cluster, or 0 if unbounded.
+  int64 max_executables_per_cluster_;
+
+  // Runs lazy compilations in the background, or null to compile them on the
+  // requesting thread.
+  std::unique_ptr<thread::ThreadPool> async_compile_pool_;
+
   mutex compile_cache_mu_;
-  absl::flat_hash_map<Signature, std::unique_ptr<Entry>, Signature::Hash> cache_
+  absl::flat_hash_map<Signature, std::shared_ptr<Entry>, Signature::Hash> cache_
+      GUARDED_BY(compile_cache_mu_);
+
+  // Signatures of the compiled entries of each cluster, most recently used
+  // first.  Only maintained if max_executables_per_cluster_ is positive.
+  absl::flat_hash_map<string, std::list<Signature>> cluster_lru_
       GUARDED_BY(compile_cache_mu_);
 
   struct ClusterCompileStats {
@@ -0,0 +1,309 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/xla_compilation_cache.h"
+
+#include <stdlib.h>
+
+#include "tensorflow/compiler/tf2xla/xla_op_registry.h"
+#include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns the value of the XlaCompilationCache counter `metric` for
+// `cluster`.
+int64 ClusterCounter(const string& metric, const string& cluster) {
+  auto metrics = monitoring::CollectionRegistry::Default()->CollectMetrics(
+      monitoring::CollectionRegistry::CollectMetricsOptions());
+  auto iter = metrics->point_set_map.find(
+      strings::StrCat("/tensorflow/compiler/jit/xla_compilation_cache/",
+                      metric));
+  if (iter == metrics->point_set_map.end()) return 0;
+  for (const auto& point : iter->second->points) {
+    for (const auto& label : point->labels) {
+      if (label.name == "cluster" && label.value == cluster) {
+        return point->int64_value;
+      }
+    }
+  }
+  return 0;
+}
+
+class XlaCompilationCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    device_.reset(DeviceFactory::NewDevice("CPU", SessionOptions(),
+                                           "/job:localhost/replica:0/task:0"));
+    FunctionDefLibrary fdef_lib;
+    // Each test compiles its own function, so that the cluster counters,
+    // which are labeled by function name, only count its compilations.
+    const string name = strings::StrCat(
+        ::testing::UnitTest::GetInstance()->current_test_info()->name(),
+        "Double");
+    *fdef_lib.add_function() = FunctionDefHelper::Define(
+        name, {"x: float"}, {"y: float"}, {},
+        {{{"y"}, "Add", {"x", "x"}, {{"T", DT_FLOAT}}}});
+    flib_def_.reset(new FunctionLibraryDefinition(OpRegistry::Global(),
+                                                  fdef_lib));
+    function_.set_name(name);
+
+    options_.device_type = DeviceType(DEVICE_CPU_XLA_JIT);
+    client_ = xla::ClientLibrary::LocalClientOrDie();
+    options_.client = client_;
+    options_.flib_def = flib_def_.get();
+    options_.graph_def_version = TF_GRAPH_DEF_VERSION;
+  }
+
+  // Returns a new cache that keeps at most `max_executables` signatures per
+  // cluster and compiles lazily on `async_threads` background threads.
+  XlaCompilationCache* NewCache(int64 max_executables, int64 async_threads) {
+    setenv("TF_XLA_MAX_EXECUTABLES_PER_CLUSTER",
+           strings::StrCat(max_executables).c_str(), 1);
+    setenv("TF_XLA_ASYNC_COMPILATION_THREADS",
+           strings::StrCat(async_threads).c_str(), 1);
+    XlaCompilationCache* cache =
+        new XlaCompilationCache(client_, DeviceType(DEVICE_CPU_XLA_JIT));
+    unsetenv("TF_XLA_MAX_EXECUTABLES_PER_CLUSTER");
+    unsetenv("TF_XLA_ASYNC_COMPILATION_THREADS");
+    return cache;
+  }
+
+  // Compiles the function of this test for an input of `size` floats.
+  Status Compile(XlaCompilationCache* cache, int64 size,
+                 XlaCompilationCache::CompileMode mode,
+                 const XlaCompiler::CompilationResult** result,
+                 xla::LocalExecutable** executable,
+                 XlaCompilationCache::EntryRef* entry_ref) {
+    Tensor input(DT_FLOAT, TensorShape({size}));
+    gtl::InlinedVector<TensorValue, 4> inputs = {TensorValue(&input)};
+    OpKernelContext::Params params;
+    params.device = device_.get();
+    params.inputs = &inputs;
+    OpKernelContext ctx(&params, /*num_outputs=*/1);
+    return cache->Compile(options_, function_, /*constant_args=*/{},
+                          /*variable_args=*/{}, /*dynamic_dim_bounds=*/{},
+                          &ctx, XlaCompiler::CompileOptions(), mode, result,
+                          executable, entry_ref);
+  }
+
+  // Requests a lazy compilation for an input of `size` floats until the
+  // background compilation has published its executable.
+  Status CompileUntilPublished(XlaCompilationCache* cache, int64 size,
+                               xla::LocalExecutable** executable,
+                               XlaCompilationCache::EntryRef* entry_ref) {
+    const XlaCompiler::CompilationResult* result = nullptr;
+    for (int i = 0; i < 10000; ++i) {
+      TF_RETURN_IF_ERROR(Compile(cache, size,
+                                 XlaCompilationCache::CompileMode::kLazy,
+                                 &result, executable, entry_ref));
+      if (*executable != nullptr) return Status::OK();
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    return errors::DeadlineExceeded("The background compilation of ",
+                                    function_.name(), " did not finish");
+  }
+
+  // Compiles the function of this test for an input of `size` floats in
+  // strict mode.
+  Status CompileStrict(XlaCompilationCache* cache, int64 size) {
+    const XlaCompiler::CompilationResult* result = nullptr;
+    xla::LocalExecutable* executable = nullptr;
+    XlaCompilationCache::EntryRef entry_ref;
+    return Compile(cache, size, XlaCompilationCache::CompileMode::kStrict,
+                   &result, &executable, &entry_ref);
+  }
+
+  int64 CompileCount() const {
+    return ClusterCounter("compiles", function_.name());
+  }
+
+  int64 EvictionCount() const {
+    return ClusterCounter("evictions", function_.name());
+  }
+
+  xla::LocalClient* client_;
+  std::unique_ptr<Device> device_;
+  std::unique_ptr<FunctionLibraryDefinition> flib_def_;
+  NameAttrList function_;
+  XlaCompiler::Options options_;
+};
+
+TEST_F(XlaCompilationCacheTest, AsyncCompileFallsBackWhileCompiling) {
+  XlaCompilationCache* cache = NewCache(0, 1);
+  core::ScopedUnref unref(cache);
+
+  // The first request only schedules the compilation, so the caller runs the
+  // cluster as a TensorFlow graph.
+  const XlaCompiler::CompilationResult* result = nullptr;
+  xla::LocalExecutable* executable = nullptr;
+  XlaCompilationCache::EntryRef entry_ref;
+  TF_ASSERT_OK(Compile(cache, 2, XlaCompilationCache::CompileMode::kLazy,
+                       &result, &executable, &entry_ref));
+  EXPECT_EQ(result, nullptr);
+  EXPECT_EQ(executable, nullptr);
+  EXPECT_EQ(entry_ref, nullptr);
+}
+
+TEST_F(XlaCompilationCacheTest, AsyncCompilePublishesExecutable) {
+  XlaCompilationCache* cache = NewCache(0, 1);
+  core::ScopedUnref unref(cache);
+
+  xla::LocalExecutable* executable = nullptr;
+  XlaCompilationCache::EntryRef entry_ref;
+  TF_ASSERT_OK(CompileUntilPublished(cache, 2, &executable, &entry_ref));
+  EXPECT_NE(entry_ref, nullptr);
+
+  // Once published, every request returns the same executable without
+  // compiling again.
+  const XlaCompiler::CompilationResult* result = nullptr;
+  xla::LocalExecutable* cached_executable = nullptr;
+  XlaCompilationCache::EntryRef cached_entry_ref;
+  TF_ASSERT_OK(Compile(cache, 2, XlaCompilationCache::CompileMode::kLazy,
+                       &result, &cached_executable, &cached_entry_ref));
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(result->xla_input_shapes.size(), 1);
+  EXPECT_EQ(cached_executable, executable);
+  EXPECT_EQ(cached_entry_ref, entry_ref);
+  EXPECT_EQ(CompileCount(), 1);
+}
+
+TEST_F(XlaCompilationCacheTest, AsyncCompileRunsOncePerSignature) {
+  XlaCompilationCache* cache = NewCache(0, 4);
+  core::ScopedUnref unref(cache);
+
+  // Requests made while the compilation is pending do not schedule another
+  // one.
+  for (int i = 0; i < 16; ++i) {
+    const XlaCompiler::CompilationResult* result = nullptr;
+    xla::LocalExecutable* executable = nullptr;
+    XlaCompilationCache::EntryRef entry_ref;
+    TF_ASSERT_OK(Compile(cache, 2, XlaCompilationCache::CompileMode::kLazy,
+                         &result, &executable, &entry_ref));
+  }
+  xla::LocalExecutable* executable = nullptr;
+  XlaCompilationCache::EntryRef entry_ref;
+  TF_ASSERT_OK(CompileUntilPublished(cache, 2, &executable, &entry_ref));
+  EXPECT_EQ(CompileCount(), 1);
+
+  // A new signature gets its own compilation.
+  TF_ASSERT_OK(CompileUntilPublished(cache, 3, &executable, &entry_ref));
+  EXPECT_EQ(CompileCount(), 2);
+}
+
+TEST_F(XlaCompilationCacheTest, DestructorWaitsForAsyncCompiles) {
+  XlaCompilationCache* cache = NewCache(0, 2);
+  for (int64 size = 1; size <= 4; ++size) {
+    const XlaCompiler::CompilationResult* result = nullptr;
+    xla::LocalExecutable* executable = nullptr;
+    XlaCompilationCache::EntryRef entry_ref;
+    TF_ASSERT_OK(Compile(cache, size, XlaCompilationCache::CompileMode::kLazy,
+                         &result, &executable, &entry_ref));
+  }
+  // Every scheduled compilation has finished by the time the cache is gone.
+  cache->Unref();
+  EXPECT_EQ(CompileCount(), 4);
+}
+
+TEST_F(XlaCompilationCacheTest, EvictsLeastRecentlyUsedSignature) {
+  XlaCompilationCache* cache = NewCache(2, 0);
+  core::ScopedUnref unref(cache);
+
+  TF_ASSERT_OK(CompileStrict(cache, 1));
+  TF_ASSERT_OK(CompileStrict(cache, 2));
+  EXPECT_EQ(CompileCount(), 2);
+  EXPECT_EQ(EvictionCount(), 0);
+
+  // A hit makes 1 the most recently used signature, so 2 is evicted to make
+  // room for 3.
+  TF_ASSERT_OK(CompileStrict(cache, 1));
+  EXPECT_EQ(CompileCount(), 2);
+  TF_ASSERT_OK(CompileStrict(cache, 3));
+  EXPECT_EQ(CompileCount(), 3);
+  EXPECT_EQ(EvictionCount(), 1);
+
+  TF_ASSERT_OK(CompileStrict(cache, 1));
+  EXPECT_EQ(CompileCount(), 3);
+  EXPECT_EQ(EvictionCount(), 1);
+
+  // The evicted signature is compiled again, and evicts 3 in turn.
+  TF_ASSERT_OK(CompileStrict(cache, 2));
+  EXPECT_EQ(CompileCount(), 4);
+  EXPECT_EQ(EvictionCount(), 2);
+  TF_ASSERT_OK(CompileStrict(cache, 1));
+  TF_ASSERT_OK(CompileStrict(cache, 2));
+  EXPECT_EQ(CompileCount(), 4);
+  TF_ASSERT_OK(CompileStrict(cache, 3));
+  EXPECT_EQ(CompileCount(), 5);
+  EXPECT_EQ(EvictionCount(), 3);
+}
+
+TEST_F(XlaCompilationCacheTest, UnboundedCacheDoesNotEvict) {
+  XlaCompilationCache* cache = NewCache(0, 0);
+  core::ScopedUnref unref(cache);
+
+  for (int64 size = 1; size <= 4; ++size) {
+    TF_ASSERT_OK(CompileStrict(cache, size));
+  }
+  for (int64 size = 1; size <= 4; ++size) {
+    TF_ASSERT_OK(CompileStrict(cache, size));
+  }
+  EXPECT_EQ(CompileCount(), 4);
+  EXPECT_EQ(EvictionCount(), 0);
+}
+
+TEST_F(XlaCompilationCacheTest, EntryRefKeepsEvictedEntryAlive) {
+  XlaCompilationCache* cache = NewCache(1, 0);
+  core::ScopedUnref unref(cache);
+
+  const XlaCompiler::CompilationResult* result = nullptr;
+  xla::LocalExecutable* executable = nullptr;
+  XlaCompilationCache::EntryRef entry_ref;
+  TF_ASSERT_OK(Compile(cache, 1, XlaCompilationCache::CompileMode::kStrict,
+                       &result, &executable, &entry_ref));
+  ASSERT_NE(result, nullptr);
+  ASSERT_NE(executable, nullptr);
+  EXPECT_EQ(entry_ref.use_count(), 2);
+
+  TF_ASSERT_OK(CompileStrict(cache, 2));
+  EXPECT_EQ(EvictionCount(), 1);
+
+  // The cache no longer references the evicted entry, but its compilation
+  // result and executable stay valid while the EntryRef is held.
+  EXPECT_EQ(entry_ref.use_count(), 1);
+  ASSERT_EQ(result->xla_input_shapes.size(), 1);
+  EXPECT_EQ(result->xla_input_shapes[0].dimensions(0), 1);
+  EXPECT_NE(executable->executable(), nullptr);
+
+  // Looking the evicted signature up again compiles a new entry.
+  const XlaCompiler::CompilationResult* new_result = nullptr;
+  xla::LocalExecutable* new_executable = nullptr;
+  XlaCompilationCache::EntryRef new_entry_ref;
+  TF_ASSERT_OK(Compile(cache, 1, XlaCompilationCache::CompileMode::kStrict,
+                       &new_result, &new_executable, &new_entry_ref));
+  EXPECT_NE(new_entry_ref, entry_ref);
+  EXPECT_EQ(CompileCount(), 3);
+}
+
+}  // namespace
+}  // namespace tensorflow
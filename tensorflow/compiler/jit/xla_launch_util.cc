@@ -386,7 +386,11 @@ Status XlaComputationLaunchContext::PopulateOutputs(
         ctx->set_output(i, ctx->input(kernel->outputs[i].input_index));
       } else {
         se::DeviceMemoryBase buffer = output.buffer({output_num});
+        const bool slice_rows = kernel->outputs[i].dynamic_leading_dim &&
+                                dynamic_leading_dim_size_ >= 0;
         if (allocate_xla_tensors_) {
+          TF_RET_CHECK(!slice_rows)
+              << "Dynamic leading dimensions are not supported on XLA devices";
           Tensor* output_tensor;
           TF_RETURN_IF_ERROR(ctx->allocate_output(i, shape, &output_tensor));
           XlaTensor* xla_tensor = XlaTensor::FromTensor(output_tensor);
@@ -405,6 +409,11 @@ Status XlaComputationLaunchContext::PopulateOutputs(
           Tensor output_tensor = XlaTensorBuffer::MakeTensor(
               ctx->expected_output_dtype(i), shape, buffer, allocator);
           output.set_buffer(xla::OwningDeviceMemory(), {output_num});
+          if (slice_rows) {
+            // The leading rows start at the beginning of the buffer, so the
+            // slice stays aligned.
+            output_tensor = output_tensor.Slice(0, dynamic_leading_dim_size_);
+          }
           ctx->set_output(i, output_tensor);
         }
         ++output_num;
@@ -141,6 +141,8 @@ class XlaComputationLaunchContext {
 
   // Add all inputs within `ctx` as XLA arguments (returned by arguments()).
   // `variables` is a map from TensorFlow argument number to resource variable.
+  // Inputs with an entry in `variables` are read from it instead of `ctx`,
+  // which is also how padded inputs are passed.
   //
   // Assumes that the first `missing_ctx_input_prefix` inputs to the kernel are
   // missing and adjusts input indices accordingly.  All elements in kernel's
@@ -170,6 +172,13 @@ class XlaComputationLaunchContext {
   // called.
   const std::vector<xla::ShapedBuffer*>& arguments() const { return arg_ptrs_; }
 
+  // Sets the number of meaningful rows of the outputs with a dynamic leading
+  // dimension, which PopulateOutputs slices them to.  See
+  // XlaCompiler::OutputDescription::dynamic_leading_dim.
+  void set_dynamic_leading_dim_size(int64 size) {
+    dynamic_leading_dim_size_ = size;
+  }
+
  private:
   xla::LocalClient* client_;
   xla::DeviceMemoryAllocator* xla_allocator_;
@@ -177,6 +186,7 @@ class XlaComputationLaunchContext {
   bool use_multiple_streams_;
   std::vector<std::unique_ptr<xla::ShapedBuffer>> arg_buffers_;
   std::vector<xla::ShapedBuffer*> arg_ptrs_;
+  int64 dynamic_leading_dim_size_ = -1;
 };
 
 // A simple TensorBuffer implementation that allows us to create Tensors that
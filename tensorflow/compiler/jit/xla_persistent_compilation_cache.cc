@@ -0,0 +1,249 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/xla_persistent_compilation_cache.h"
+
+#include <memory>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/client/xla_computation.h"
+#include "tensorflow/compiler/xla/service/hlo.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Version of the XlaCompilationCacheEntry layout written by this build.
+constexpr int32 kFormatVersion = 1;
+
+constexpr char kFileSuffix[] = ".xla_cache";
+
+auto* lookup_counter = monitoring::Counter<1>::New(
+    "/tensorflow/compiler/jit/persistent_compilation_cache/lookups",
+    "Lookups in the persistent XLA compilation cache, by result.", "result");
+
+}  // namespace
+
+XlaPersistentCompilationCache::XlaPersistentCompilationCache(
+    string directory, string device_type, string platform_name)
+    : directory_(std::move(directory)),
+      device_type_(std::move(device_type)),
+      platform_name_(std::move(platform_name)) {
+  Status s = Env::Default()->RecursivelyCreateDir(directory_);
+  if (!s.ok() && !errors::IsAlreadyExists(s)) {
+    LOG(WARNING) << "Unable to create XLA compilation cache directory "
+                 << directory_ << ": " << s;
+  }
+}
+
+string XlaPersistentCompilationCache::FilePath(
+    const Fprint128& fingerprint) const {
+  return io::JoinPath(directory_,
+                      absl::StrCat(absl::Hex(fingerprint.high64,
+                                             absl::kZeroPad16),
+                                   absl::Hex(fingerprint.low64,
+                                             absl::kZeroPad16),
+                                   kFileSuffix));
+}
+
+Status XlaPersistentCompilationCache::CheckEntry(
+    const XlaCompilationCacheEntry& entry,
+    const Fprint128& fingerprint) const {
+  if (entry.format_version() != kFormatVersion) {
+    return errors::FailedPrecondition("format version ",
+                                      entry.format_version(), " != ",
+                                      kFormatVersion);
+  }
+  if (entry.tf_version() != TF_VERSION_STRING ||
+      entry.tf_git_version() != tf_git_version()) {
+    return errors::FailedPrecondition(
+        "written by TensorFlow ", entry.tf_version(), " (",
+        entry.tf_git_version(), ")");
+  }
+  if (entry.device_type() != device_type_ ||
+      entry.platform_name() != platform_name_) {
+    return errors::FailedPrecondition("written for ", entry.device_type(),
+                                      " on ", entry.platform_name());
+  }
+  if (entry.key_fingerprint_low() != fingerprint.low64 ||
+      entry.key_fingerprint_high() != fingerprint.high64) {
+    return errors::FailedPrecondition("key fingerprint mismatch");
+  }
+  if (entry.hlo_module_fingerprint() != Fingerprint64(entry.hlo_module())) {
+    return errors::DataLoss("HLO module fingerprint mismatch");
+  }
+  return Status::OK();
+}
+
+bool XlaPersistentCompilationCache::Lookup(
+    const string& key, XlaCompiler::CompilationResult* result) {
+  const Fprint128 fingerprint = Fingerprint128(key);
+  const string path = FilePath(fingerprint);
+  Env* env = Env::Default();
+  if (!env->FileExists(path).ok()) {
+    lookup_counter->GetCell("miss")->IncrementBy(1);
+    return false;
+  }
+  string contents;
+  XlaCompilationCacheEntry entry;
+  Status s = env->ReadFileToString(path, &contents);
+  if (s.ok() && !entry.ParseFromString(contents)) {
+    s = errors::DataLoss("unparseable entry");
+  }
+  if (s.ok()) s = CheckEntry(entry, fingerprint);
+  if (s.ok()) s = FromProto(entry, result);
+  if (!s.ok()) {
+    VLOG(1) << "Ignoring XLA compilation cache entry " << path << ": " << s;
+    lookup_counter->GetCell("rejected")->IncrementBy(1);
+    return false;
+  }
+  VLOG(1) << "Loaded XLA compilation cache entry " << path;
+  lookup_counter->GetCell("hit")->IncrementBy(1);
+  return true;
+}
+
+Status XlaPersistentCompilationCache::Store(
+    const string& key, const XlaCompiler::CompilationResult& result) {
+  const Fprint128 fingerprint = Fingerprint128(key);
+  XlaCompilationCacheEntry entry;
+  TF_RETURN_IF_ERROR(ToProto(result, &entry));
+  entry.set_format_version(kFormatVersion);
+  entry.set_tf_version(TF_VERSION_STRING);
+  entry.set_tf_git_version(tf_git_version());
+  entry.set_device_type(device_type_);
+  entry.set_platform_name(platform_name_);
+  entry.set_key_fingerprint_low(fingerprint.low64);
+  entry.set_key_fingerprint_high(fingerprint.high64);
+  entry.set_hlo_module_fingerprint(Fingerprint64(entry.hlo_module()));
+
+  string contents;
+  if (!entry.SerializeToString(&contents)) {
+    return errors::Internal("Unable to serialize XLA compilation cache entry");
+  }
+  const string path = FilePath(fingerprint);
+  const string tmp_path = absl::StrCat(path, ".tmp.", random::New64());
+  Env* env = Env::Default();
+  TF_RETURN_IF_ERROR(WriteStringToFile(env, tmp_path, contents));
+  Status s = env->RenameFile(tmp_path, path);
+  if (!s.ok()) {
+    env->DeleteFile(tmp_path).IgnoreError();
+    return s;
+  }
+  VLOG(1) << "Stored XLA compilation cache entry " << path;
+  return Status::OK();
+}
+
+/*static*/ Status XlaPersistentCompilationCache::ToProto(
+    const XlaCompiler::CompilationResult& result,
+    XlaCompilationCacheEntry* entry) {
+  if (result.computation == nullptr) {
+    return errors::InvalidArgument("Compilation result has no computation");
+  }
+  if (!result.computation->proto().SerializeToString(
+          entry->mutable_hlo_module())) {
+    return errors::Internal("Unable to serialize HLO module");
+  }
+  for (int index : result.input_mapping) {
+    entry->add_input_mapping(index);
+  }
+  for (const xla::Shape& shape : result.xla_input_shapes) {
+    *entry->add_xla_input_shapes() = shape;
+  }
+  *entry->mutable_xla_output_shape() = result.xla_output_shape;
+  for (const XlaCompiler::OutputDescription& output : result.outputs) {
+    XlaCompilationCacheEntry::Output* out = entry->add_outputs();
+    out->set_type(output.type);
+    output.shape.AsProto(out->mutable_shape());
+    out->set_is_constant(output.is_constant);
+    if (output.is_constant) {
+      output.constant_value.AsProtoTensorContent(out->mutable_constant_value());
+    }
+    out->set_input_index(output.input_index);
+    out->set_dynamic_leading_dim(output.dynamic_leading_dim);
+  }
+  *entry->mutable_host_compute_metadata() = result.host_compute_metadata;
+  for (const XlaCompiler::ResourceUpdate& update : result.resource_updates) {
+    XlaCompilationCacheEntry::ResourceUpdate* out =
+        entry->add_resource_updates();
+    out->set_input_index(update.input_index);
+    out->set_type(update.type);
+    update.shape.AsProto(out->mutable_shape());
+    out->set_modified(update.modified);
+    for (const string& grad : update.tensor_array_gradients_accessed) {
+      out->add_tensor_array_gradients_accessed(grad);
+    }
+  }
+  return Status::OK();
+}
+
+/*static*/ Status XlaPersistentCompilationCache::FromProto(
+    const XlaCompilationCacheEntry& entry,
+    XlaCompiler::CompilationResult* result) {
+  xla::HloModuleProto hlo_module;
+  if (!hlo_module.ParseFromString(entry.hlo_module())) {
+    return errors::DataLoss("Unparseable HLO module");
+  }
+  XlaCompiler::CompilationResult out;
+  out.input_mapping.assign(entry.input_mapping().begin(),
+                           entry.input_mapping().end());
+  out.xla_input_shapes.assign(entry.xla_input_shapes().begin(),
+                              entry.xla_input_shapes().end());
+  out.xla_output_shape = entry.xla_output_shape();
+  for (const auto& output : entry.outputs()) {
+    if (!TensorShape::IsValid(output.shape())) {
+      return errors::DataLoss("Invalid output shape");
+    }
+    XlaCompiler::OutputDescription desc;
+    desc.type = output.type();
+    desc.shape = TensorShape(output.shape());
+    desc.is_constant = output.is_constant();
+    if (desc.is_constant &&
+        !desc.constant_value.FromProto(output.constant_value())) {
+      return errors::DataLoss("Invalid constant output");
+    }
+    desc.input_index = output.input_index();
+    desc.dynamic_leading_dim = output.dynamic_leading_dim();
+    out.outputs.push_back(std::move(desc));
+  }
+  out.host_compute_metadata = entry.host_compute_metadata();
+  for (const auto& update : entry.resource_updates()) {
+    if (!TensorShape::IsValid(update.shape())) {
+      return errors::DataLoss("Invalid resource update shape");
+    }
+    XlaCompiler::ResourceUpdate desc;
+    desc.input_index = update.input_index();
+    desc.type = update.type();
+    desc.shape = TensorShape(update.shape());
+    desc.modified = update.modified();
+    desc.tensor_array_gradients_accessed.insert(
+        update.tensor_array_gradients_accessed().begin(),
+        update.tensor_array_gradients_accessed().end());
+    out.resource_updates.push_back(std::move(desc));
+  }
+  out.computation = std::make_shared<xla::XlaComputation>(hlo_module);
+  *result = std::move(out);
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,82 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_JIT_XLA_PERSISTENT_COMPILATION_CACHE_H_
+#define TENSORFLOW_COMPILER_JIT_XLA_PERSISTENT_COMPILATION_CACHE_H_
+
+#include "tensorflow/compiler/jit/xla_compilation_cache.pb.h"
+#include "tensorflow/compiler/tf2xla/xla_compiler.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A second cache tier behind XlaCompilationCache that persists compilation
+// results in a directory, which may live on a shared filesystem, so that
+// other processes and later runs compiling the same cluster can skip the
+// TensorFlow-to-HLO lowering.
+//
+// Entries are keyed by a fingerprint of a caller-provided key string, which
+// must capture everything the compilation depends on.  An entry is only
+// loaded back by a process with exactly the same TensorFlow version, git
+// version, compilation device type and platform; anything else, including
+// unreadable or corrupt files, is treated as a miss.
+//
+// XLA has no way to serialize a compiled xla::LocalExecutable, so the
+// backend compilation of a loaded HLO module still runs in each process.
+//
+// Thread-safe.
+class XlaPersistentCompilationCache {
+ public:
+  XlaPersistentCompilationCache(string directory, string device_type,
+                                string platform_name);
+
+  // Returns true and fills in `*result` if a valid entry for `key` exists.
+  bool Lookup(const string& key, XlaCompiler::CompilationResult* result);
+
+  // Writes `result` as the entry for `key`.  The file is written under a
+  // temporary name and renamed into place, so concurrent readers never see
+  // a partial entry.
+  Status Store(const string& key,
+               const XlaCompiler::CompilationResult& result);
+
+  const string& directory() const { return directory_; }
+
+  // Conversions between a CompilationResult and the fields of an entry
+  // that mirror it.
+  static Status ToProto(const XlaCompiler::CompilationResult& result,
+                        XlaCompilationCacheEntry* entry);
+  static Status FromProto(const XlaCompilationCacheEntry& entry,
+                          XlaCompiler::CompilationResult* result);
+
+ private:
+  string FilePath(const Fprint128& fingerprint) const;
+
+  // Returns OK if `entry` was written by a compatible process for
+  // `fingerprint` and is intact.
+  Status CheckEntry(const XlaCompilationCacheEntry& entry,
+                    const Fprint128& fingerprint) const;
+
+  const string directory_;
+  const string device_type_;
+  const string platform_name_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(XlaPersistentCompilationCache);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_XLA_PERSISTENT_COMPILATION_CACHE_H_
@@ -0,0 +1,133 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/xla_persistent_compilation_cache.h"
+
+#include "tensorflow/compiler/xla/client/xla_builder.h"
+#include "tensorflow/compiler/xla/client/xla_computation.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+XlaCompiler::CompilationResult MakeResult() {
+  xla::XlaBuilder builder("double");
+  xla::Shape shape = xla::ShapeUtil::MakeShape(xla::F32, {2});
+  xla::XlaOp x = xla::Parameter(&builder, 0, shape, "x");
+  xla::Tuple(&builder, {xla::Add(x, x)});
+
+  XlaCompiler::CompilationResult result;
+  result.computation = std::make_shared<xla::XlaComputation>(
+      builder.Build().ConsumeValueOrDie());
+  result.input_mapping = {1};
+  result.xla_input_shapes = {shape};
+  result.xla_output_shape = xla::ShapeUtil::MakeTupleShape({shape});
+  result.outputs.resize(2);
+  result.outputs[0].type = DT_FLOAT;
+  result.outputs[0].shape = TensorShape({2});
+  result.outputs[0].input_index = -1;
+  result.outputs[0].dynamic_leading_dim = true;
+  result.outputs[1].type = DT_INT32;
+  result.outputs[1].shape = TensorShape({3});
+  result.outputs[1].is_constant = true;
+  result.outputs[1].constant_value = test::AsTensor<int32>({1, 2, 3});
+  result.outputs[1].input_index = -1;
+  XlaCompiler::ResourceUpdate update;
+  update.input_index = 2;
+  update.type = DT_FLOAT;
+  update.shape = TensorShape({4, 5});
+  update.modified = true;
+  update.tensor_array_gradients_accessed = {"grad"};
+  result.resource_updates.push_back(update);
+  return result;
+}
+
+string CacheDir(const string& name) {
+  return io::JoinPath(testing::TmpDir(), name);
+}
+
+TEST(XlaPersistentCompilationCacheTest, RoundTrip) {
+  XlaPersistentCompilationCache cache(CacheDir("round_trip"), "XLA_CPU_JIT",
+                                      "Host");
+  XlaCompiler::CompilationResult result;
+  EXPECT_FALSE(cache.Lookup("key", &result));
+
+  const XlaCompiler::CompilationResult expected = MakeResult();
+  TF_ASSERT_OK(cache.Store("key", expected));
+  ASSERT_TRUE(cache.Lookup("key", &result));
+  EXPECT_FALSE(cache.Lookup("other key", &result));
+
+  EXPECT_EQ(expected.input_mapping, result.input_mapping);
+  ASSERT_EQ(1, result.xla_input_shapes.size());
+  EXPECT_TRUE(xla::ShapeUtil::Equal(expected.xla_input_shapes[0],
+                                    result.xla_input_shapes[0]));
+  EXPECT_TRUE(xla::ShapeUtil::Equal(expected.xla_output_shape,
+                                    result.xla_output_shape));
+  ASSERT_EQ(2, result.outputs.size());
+  EXPECT_EQ(DT_FLOAT, result.outputs[0].type);
+  EXPECT_EQ(TensorShape({2}), result.outputs[0].shape);
+  EXPECT_FALSE(result.outputs[0].is_constant);
+  EXPECT_TRUE(result.outputs[0].dynamic_leading_dim);
+  EXPECT_TRUE(result.outputs[1].is_constant);
+  EXPECT_FALSE(result.outputs[1].dynamic_leading_dim);
+  test::ExpectTensorEqual<int32>(expected.outputs[1].constant_value,
+                                 result.outputs[1].constant_value);
+  ASSERT_EQ(1, result.resource_updates.size());
+  EXPECT_EQ(2, result.resource_updates[0].input_index);
+  EXPECT_EQ(TensorShape({4, 5}), result.resource_updates[0].shape);
+  EXPECT_TRUE(result.resource_updates[0].modified);
+  EXPECT_EQ(expected.resource_updates[0].tensor_array_gradients_accessed,
+            result.resource_updates[0].tensor_array_gradients_accessed);
+  ASSERT_NE(nullptr, result.computation);
+  EXPECT_EQ(expected.computation->proto().SerializeAsString(),
+            result.computation->proto().SerializeAsString());
+}
+
+TEST(XlaPersistentCompilationCacheTest, RejectsOtherDeviceTypes) {
+  const string dir = CacheDir("device_types");
+  XlaPersistentCompilationCache cpu_cache(dir, "XLA_CPU_JIT", "Host");
+  TF_ASSERT_OK(cpu_cache.Store("key", MakeResult()));
+
+  XlaPersistentCompilationCache gpu_cache(dir, "XLA_GPU_JIT", "CUDA");
+  XlaCompiler::CompilationResult result;
+  EXPECT_FALSE(gpu_cache.Lookup("key", &result));
+  EXPECT_TRUE(cpu_cache.Lookup("key", &result));
+}
+
+TEST(XlaPersistentCompilationCacheTest, RejectsCorruptEntries) {
+  const string dir = CacheDir("corrupt");
+  XlaPersistentCompilationCache cache(dir, "XLA_CPU_JIT", "Host");
+  TF_ASSERT_OK(cache.Store("key", MakeResult()));
+
+  std::vector<string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(dir, &children));
+  ASSERT_EQ(1, children.size());
+  const string path = io::JoinPath(dir, children[0]);
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), path, &contents));
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path,
+                                 contents.substr(0, contents.size() / 2)));
+
+  XlaCompiler::CompilationResult result;
+  EXPECT_FALSE(cache.Lookup("key", &result));
+}
+
+}  // namespace
+}  // namespace tensorflow
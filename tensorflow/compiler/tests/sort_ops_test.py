@@ -56,6 +56,18 @@ class XlaSortOpTest(xla_test.XLATestCase):
       self._assertOpOutputMatchesExpected(
           xla.sort, [x], expected=[np.arange(101, dtype=dtype)])
 
+  def testSortMultipleTiles(self):
+    # Rows longer than a shared memory tile, which is not a multiple of it.
+    for length in [1000, 5000]:
+      x = np.stack([np.random.permutation(length) for _ in range(3)])
+      x = x.astype(np.float32)
+      self._assertOpOutputMatchesExpected(
+          xla.sort, [x], expected=[np.sort(x, axis=-1)])
+      y = (-x).astype(np.int32)
+      self._assertOpOutputMatchesExpected(
+          xla.key_value_sort, [x, y],
+          expected=[np.sort(x, axis=-1), -np.sort(x, axis=-1)])
+
   def testKeyValueSort(self):
     supported_key_types = set(
         [dtypes.bfloat16.as_numpy_dtype, np.float32, np.int32, np.uint32])
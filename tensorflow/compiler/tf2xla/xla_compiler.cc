@@ -16,6 +16,8 @@ limitations under the License.
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 
 #include <numeric>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "absl/memory/memory.h"
@@ -68,10 +70,10 @@ Status CheckSignature(const DataTypeVector& types,
 bool XlaCompiler::Argument::operator==(
     const XlaCompiler::Argument& other) const {
   if (std::tie(kind, resource_kind, type, name, initialized, tensor_array_size,
-               tensor_array_gradients) !=
+               tensor_array_gradients, dynamic_leading_dim) !=
       std::tie(other.kind, other.resource_kind, other.type, other.name,
                other.initialized, other.tensor_array_size,
-               other.tensor_array_gradients)) {
+               other.tensor_array_gradients, other.dynamic_leading_dim)) {
     return false;
   }
   if (shape != other.shape) {
@@ -747,6 +749,141 @@ Status ValidateGraph(const Graph* graph,
   return Status::OK();
 }
 
+// Ops whose output is computed elementwise from their inputs, broadcasting
+// inputs of lower rank along the major dimensions. Integer divisions are left
+// out since the zero padding would make them divide by zero.
+bool IsElementwiseOp(const string& op) {
+  static const std::unordered_set<string>* const kOps =
+      new std::unordered_set<string>({
+          "Abs", "Add", "AddN", "AddV2", "BiasAdd", "Cast", "Ceil", "Cos",
+          "DivNoNan", "Elu", "Equal", "Exp", "Expm1", "Floor", "Greater",
+          "GreaterEqual", "Identity", "Less", "LessEqual", "Log", "Log1p",
+          "LogicalAnd", "LogicalNot", "LogicalOr", "Maximum", "Minimum", "Mul",
+          "Neg", "NotEqual", "Pow", "ReadVariableOp", "RealDiv", "Relu",
+          "Relu6", "Round", "Rsqrt", "Selu", "Sigmoid", "Sign", "Sin",
+          "Softplus", "Softsign", "Sqrt", "Square", "SquaredDifference",
+          "StopGradient", "Sub", "Tanh",
+      });
+  return kOps->count(op) > 0;
+}
+
+// What AnalyzeDynamicLeadingDims knows about the outputs of a node.
+struct PaddingState {
+  // Is dimension 0 padded like that of the dynamic arguments?
+  bool dynamic = false;
+  // The rank, or -1 if unknown.
+  int rank = -1;
+};
+
+// Checks that the padding rows of the arguments with a dynamic leading
+// dimension can't affect the other rows of any value computed by `graph`,
+// and sets (*dynamic_retvals)[i] to whether retval i has such a leading
+// dimension. The check is conservative: every node with a padded input must
+// act on each row independently, i.e. be elementwise, a matrix product with
+// a padded left-hand side, or a softmax over the rows of a matrix.
+Status AnalyzeDynamicLeadingDims(
+    const Graph& graph, const std::vector<XlaCompiler::Argument>& args,
+    std::vector<bool>* dynamic_retvals) {
+  int dynamic_rank = -1;
+  for (const XlaCompiler::Argument& arg : args) {
+    if (!arg.dynamic_leading_dim) continue;
+    if (arg.kind != XlaCompiler::Argument::kParameter ||
+        arg.shape.dims() == 0) {
+      return errors::InvalidArgument(
+          "Only non-scalar parameters can have a dynamic leading dimension");
+    }
+    if (dynamic_rank != -1 && dynamic_rank != arg.shape.dims()) {
+      return errors::InvalidArgument(
+          "Parameters with a dynamic leading dimension must have the same "
+          "rank");
+    }
+    dynamic_rank = arg.shape.dims();
+  }
+  if (dynamic_rank == -1) {
+    return Status::OK();
+  }
+
+  std::unordered_map<const Node*, PaddingState> states;
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order);
+  for (const Node* n : order) {
+    if (!n->IsOp()) continue;
+    std::vector<PaddingState> inputs(n->num_inputs());
+    bool any_dynamic = false;
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge()) continue;
+      inputs[e->dst_input()] = states[e->src()];
+      any_dynamic |= inputs[e->dst_input()].dynamic;
+    }
+
+    PaddingState& state = states[n];
+    const string& op = n->type_string();
+    if (op == "_Arg") {
+      int index;
+      TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "index", &index));
+      TF_RET_CHECK(index >= 0 && index < args.size());
+      const XlaCompiler::Argument& arg = args[index];
+      state.dynamic = arg.dynamic_leading_dim;
+      state.rank = arg.kind == XlaCompiler::Argument::kConstant
+                       ? arg.constant_value.dims()
+                       : arg.shape.dims();
+    } else if (op == "_Retval") {
+      int index;
+      TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "index", &index));
+      TF_RET_CHECK(index >= 0);
+      if (index >= dynamic_retvals->size()) {
+        dynamic_retvals->resize(index + 1, false);
+      }
+      (*dynamic_retvals)[index] = inputs[0].dynamic;
+    } else if (op == "Const") {
+      const TensorProto* value;
+      TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "value", &value));
+      state.rank = value->tensor_shape().dim_size();
+    } else if (IsElementwiseOp(op)) {
+      // Lower-ranked inputs are broadcast along the padded dimension, but an
+      // unpadded input of the same rank would be paired with padding rows.
+      state.dynamic = any_dynamic;
+      for (const PaddingState& input : inputs) {
+        if (input.rank == -1) {
+          state.rank = -1;
+          break;
+        }
+        state.rank = std::max(state.rank, input.rank);
+      }
+      for (const PaddingState& input : inputs) {
+        if (any_dynamic && !input.dynamic &&
+            (input.rank == -1 || input.rank >= dynamic_rank)) {
+          return errors::Unimplemented(
+              "Input of ", FormatNodeForError(*n),
+              " may not be broadcast along a dynamic leading dimension");
+        }
+      }
+    } else if (op == "MatMul") {
+      bool transpose_a;
+      TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "transpose_a", &transpose_a));
+      if (inputs[1].dynamic || (inputs[0].dynamic && transpose_a)) {
+        return errors::Unimplemented(
+            FormatNodeForError(*n),
+            " contracts a dynamic leading dimension");
+      }
+      state.dynamic = inputs[0].dynamic;
+      state.rank = 2;
+    } else if (op == "Softmax" || op == "LogSoftmax") {
+      if (any_dynamic && dynamic_rank < 2) {
+        return errors::Unimplemented(FormatNodeForError(*n),
+                                     " reduces a dynamic leading dimension");
+      }
+      state = inputs[0];
+    } else if (any_dynamic) {
+      return errors::Unimplemented(
+          FormatNodeForError(*n),
+          " is not known to compute the rows of a dynamic leading dimension "
+          "independently");
+    }
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 Status XlaCompiler::CompileGraph(const XlaCompiler::CompileOptions& options,
@@ -770,6 +907,8 @@ Status XlaCompiler::CompileGraph(const XlaCompiler::CompileOptions& options,
   // FunctionalizeControlFlow may remove some nodes from the graph.
   TF_RETURN_IF_ERROR(ValidateGraph(graph.get(), *options_.flib_def,
                                    options_.device_type, name));
+  std::vector<bool> dynamic_retvals;
+  TF_RETURN_IF_ERROR(AnalyzeDynamicLeadingDims(*graph, args, &dynamic_retvals));
 
   xla::XlaBuilder builder(name);
   XlaContext* context = new XlaContext(
@@ -848,6 +987,11 @@ Status XlaCompiler::CompileGraph(const XlaCompiler::CompileOptions& options,
       &num_computation_outputs, &num_nonconst_outputs, &result->outputs,
       &result->resource_updates));
 
+  for (int i = 0; i < dynamic_retvals.size() && i < result->outputs.size();
+       ++i) {
+    result->outputs[i].dynamic_leading_dim = dynamic_retvals[i];
+  }
+
   VLOG(2) << "Outputs: total: " << context->retvals().size()
           << " nonconstant: " << num_nonconst_outputs;
 
@@ -154,6 +154,14 @@ class XlaCompiler {
     // as `tensor_array_gradients`.
     std::set<string> tensor_array_gradients;
 
+    // For a kParameter, is dimension 0 of `shape` a static upper bound rather
+    // than the actual size? If so, the runtime value is padded up to the
+    // bound and only its leading rows are meaningful. The compiler rejects
+    // graphs in which the padding rows could affect the meaningful ones, and
+    // marks the outputs whose leading rows are derived from them; see
+    // OutputDescription::dynamic_leading_dim.
+    bool dynamic_leading_dim = false;
+
     bool operator==(const Argument& other) const;
   };
 
@@ -205,6 +213,11 @@ class XlaCompiler {
     // When this output is a resource, i.e. `type == DT_RESOURCE`, this is
     // the index of the input that contains the resource.
     int input_index;
+
+    // If true, dimension 0 of `shape` is the padded bound of the dynamic
+    // arguments, and the output has as many meaningful leading rows as they
+    // do.
+    bool dynamic_leading_dim = false;
   };
 
   // Describes a variable write side effect of the computation.
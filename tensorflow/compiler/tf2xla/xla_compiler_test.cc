@@ -226,6 +226,62 @@ TEST_F(XlaCompilerTest, Simple) {
   EXPECT_TRUE(xla::LiteralTestUtil::Equal(expected_literal, actual_literal));
 }
 
+// Tests that outputs computed row by row from a parameter with a dynamic
+// leading dimension are marked as dynamic.
+TEST_F(XlaCompilerTest, DynamicLeadingDim) {
+  Scope scope = Scope::NewRootScope().ExitOnError();
+  auto a = ops::_Arg(scope.WithOpName("A"), DT_INT32, 0);
+  auto b = ops::_Arg(scope.WithOpName("B"), DT_INT32, 1);
+  auto c = ops::Add(scope.WithOpName("C"), a, b);
+  auto d = ops::_Retval(scope.WithOpName("D"), c, 0);
+  auto e = ops::_Retval(scope.WithOpName("E"), b, 1);
+  std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
+  TF_ASSERT_OK(scope.ToGraph(graph.get()));
+
+  std::vector<XlaCompiler::Argument> args(2);
+  args[0].kind = XlaCompiler::Argument::kParameter;
+  args[0].type = DT_INT32;
+  args[0].shape = TensorShape({4, 2});
+  args[0].dynamic_leading_dim = true;
+  args[1].kind = XlaCompiler::Argument::kParameter;
+  args[1].type = DT_INT32;
+  args[1].shape = TensorShape({2});
+
+  XlaCompiler compiler(DefaultOptions());
+  XlaCompiler::CompilationResult result;
+  TF_ASSERT_OK(compiler.CompileGraph(XlaCompiler::CompileOptions(), "add",
+                                     std::move(graph), args, &result));
+  ASSERT_EQ(2, result.outputs.size());
+  EXPECT_EQ(TensorShape({4, 2}), result.outputs[0].shape);
+  EXPECT_TRUE(result.outputs[0].dynamic_leading_dim);
+  EXPECT_FALSE(result.outputs[1].dynamic_leading_dim);
+}
+
+// Tests that a reduction over a dynamic leading dimension is rejected, since
+// it would include the padding rows.
+TEST_F(XlaCompilerTest, DynamicLeadingDimReductionFails) {
+  Scope scope = Scope::NewRootScope().ExitOnError();
+  auto a = ops::_Arg(scope.WithOpName("A"), DT_FLOAT, 0);
+  auto b = ops::Sum(scope.WithOpName("B"), a, ops::Const(scope, 0));
+  auto c = ops::_Retval(scope.WithOpName("C"), b, 0);
+  std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
+  TF_ASSERT_OK(scope.ToGraph(graph.get()));
+
+  std::vector<XlaCompiler::Argument> args(1);
+  args[0].kind = XlaCompiler::Argument::kParameter;
+  args[0].type = DT_FLOAT;
+  args[0].shape = TensorShape({8, 3});
+  args[0].dynamic_leading_dim = true;
+
+  XlaCompiler compiler(DefaultOptions());
+  XlaCompiler::CompilationResult result;
+  Status status = compiler.CompileGraph(XlaCompiler::CompileOptions(), "sum",
+                                        std::move(graph), args, &result);
+  EXPECT_EQ(error::UNIMPLEMENTED, status.code()) << status;
+  EXPECT_TRUE(absl::StrContains(status.error_message(), "{{node B}}"))
+      << status.error_message();
+}
+
 // Tests compilation of a graph where the _Retval node is not necessarily last
 // amongst the graph nodes in construction order, and always_return_tuple is
 // false. Regression test for bug where the wrong value was returned.
@@ -59,6 +59,7 @@ void SetDebugOptionsDefaults(DebugOptions* flags) {
   flags->set_xla_gpu_enable_fast_math(true);
 
   flags->set_xla_force_host_platform_device_count(1);
+  flags->set_xla_gpu_xfeed_buffer_depth(4);
 }
 
 // Allocates flag_values and flag_objects; this function must not be called more
@@ -241,6 +242,51 @@ void AllocateFlags() {
           bool_setter_for(&DebugOptions::set_xla_gpu_disable_multi_streaming),
           flag_values->xla_gpu_disable_multi_streaming(),
           "If true, multi-streaming in the GPU backend is disabled."),
+      tensorflow::Flag(
+          "xla_gpu_enable_graph_capture",
+          bool_setter_for(&DebugOptions::set_xla_gpu_enable_graph_capture),
+          flag_values->xla_gpu_enable_graph_capture(),
+          "If true, GPU executables record their kernel launches into CUDA "
+          "graphs and replay them while the buffer addresses stay the same."),
+      tensorflow::Flag(
+          "xla_gpu_schedule_memory_limit_bytes",
+          [](int64 value) {
+            flag_values->set_xla_gpu_schedule_memory_limit_bytes(value);
+            return true;
+          },
+          static_cast<int64>(
+              flag_values->xla_gpu_schedule_memory_limit_bytes()),
+          "If positive, GPU executables that would need more memory than "
+          "this when run on several streams are run on one stream, in an "
+          "order that minimizes memory usage."),
+      tensorflow::Flag(
+          "xla_cpu_aot_max_parallelism",
+          int32_setter_for(&DebugOptions::set_xla_cpu_aot_max_parallelism),
+          flag_values->xla_cpu_aot_max_parallelism(),
+          "If positive, ahead-of-time compiled CPU code splits expensive ops "
+          "into up to this many tasks run on its intra-op thread pool.  The "
+          "binary must link //tensorflow/compiler/xla/service/cpu:"
+          "runtime_fork_join."),
+      tensorflow::Flag(
+          "xla_llvm_parallel_codegen_split_count",
+          int32_setter_for(
+              &DebugOptions::set_xla_llvm_parallel_codegen_split_count),
+          flag_values->xla_llvm_parallel_codegen_split_count(),
+          "If greater than 1, split the LLVM module into up to this many "
+          "partitions that are optimized and compiled in parallel."),
+      tensorflow::Flag(
+          "xla_cpu_enable_concurrent_branches",
+          bool_setter_for(
+              &DebugOptions::set_xla_cpu_enable_concurrent_branches),
+          flag_values->xla_cpu_enable_concurrent_branches(),
+          "Run independent, expensive branches of the entry computation "
+          "concurrently on the intra-op thread pool of the CPU JIT."),
+      tensorflow::Flag(
+          "xla_gpu_xfeed_buffer_depth",
+          int32_setter_for(&DebugOptions::set_xla_gpu_xfeed_buffer_depth),
+          flag_values->xla_gpu_xfeed_buffer_depth(),
+          "The number of device and pinned host buffers of each size that "
+          "the GPU infeed and outfeed keep for reuse."),
       tensorflow::Flag(
           "xla_gpu_max_kernel_unroll_factor",
           int32_setter_for(&DebugOptions::set_xla_gpu_max_kernel_unroll_factor),
@@ -0,0 +1,271 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/concurrent_branch_outliner.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/util.h"
+
+namespace xla {
+namespace cpu {
+
+namespace {
+
+// Branches cheaper than this are not worth a task of their own. This is
+// about 100us of work on a 2GHz core, the same minimum per-thread cost as
+// parallel task assignment uses.
+constexpr int64 kMinBranchCost = 100000;
+
+struct Branch {
+  // The instructions of the branch in post order. The last one is the
+  // output.
+  std::vector<HloInstruction*> instructions;
+  int64 cost = 0;
+};
+
+// Returns the instructions, in post order, of the largest set that contains
+// 'output' and in which every instruction other than 'output' is only used
+// by instructions of the set.
+std::vector<HloInstruction*> FindBranch(
+    HloInstruction* output,
+    const absl::flat_hash_map<const HloInstruction*, int64>& positions,
+    const std::function<bool(const HloInstruction*)>& can_outline) {
+  std::vector<HloInstruction*> branch = {output};
+  absl::flat_hash_map<const HloInstruction*, int64> uses_in_branch;
+  std::vector<HloInstruction*> worklist = {output};
+  while (!worklist.empty()) {
+    HloInstruction* instruction = worklist.back();
+    worklist.pop_back();
+    for (HloInstruction* operand : instruction->unique_operands()) {
+      if (can_outline(operand) &&
+          ++uses_in_branch[operand] == operand->user_count()) {
+        branch.push_back(operand);
+        worklist.push_back(operand);
+      }
+    }
+  }
+  std::sort(branch.begin(), branch.end(),
+            [&](const HloInstruction* a, const HloInstruction* b) {
+              return positions.at(a) < positions.at(b);
+            });
+  return branch;
+}
+
+// Outlines each of 'branches' of 'computation' into its own computation and
+// groups the calls to them into a concurrent branch computation.
+Status OutlineConcurrentBranches(const std::vector<Branch>& branches,
+                                 HloModule* module,
+                                 HloComputation* computation) {
+  std::vector<HloInstruction*> calls;
+  for (const Branch& branch : branches) {
+    calls.push_back(module->OutlineExpressionFromComputation(
+        branch.instructions, "concurrent_branch", computation));
+  }
+  std::vector<std::vector<HloInstruction*>> users;
+  for (HloInstruction* call : calls) {
+    users.push_back(call->users());
+  }
+  HloInstruction* tuple =
+      computation->AddInstruction(HloInstruction::CreateTuple(calls));
+  for (int64 i = 0; i < calls.size(); ++i) {
+    HloInstruction* element =
+        computation->AddInstruction(HloInstruction::CreateGetTupleElement(
+            calls[i]->shape(), tuple, i));
+    for (HloInstruction* user : users[i]) {
+      TF_RETURN_IF_ERROR(calls[i]->ReplaceUseWith(user, element));
+    }
+  }
+  std::vector<HloInstruction*> to_outline(calls);
+  to_outline.push_back(tuple);
+  HloInstruction* concurrent_call = module->OutlineExpressionFromComputation(
+      to_outline, "concurrent_branches", computation);
+  concurrent_call->to_apply()->root_instruction()
+      ->set_outer_dimension_partitions({static_cast<int64>(calls.size())});
+  VLOG(2) << "Outlined " << calls.size()
+          << " concurrent branches: " << concurrent_call->ToString();
+  return Status::OK();
+}
+
+}  // namespace
+
+bool IsConcurrentBranchComputation(const HloComputation& computation) {
+  const HloInstruction* root = computation.root_instruction();
+  return root->opcode() == HloOpcode::kTuple &&
+         !root->outer_dimension_partitions().empty();
+}
+
+StatusOr<bool> ConcurrentBranchOutliner::Run(HloModule* module) {
+  if (max_parallelism_ < 2) {
+    return false;
+  }
+  XLA_VLOG_LINES(3, "ConcurrentBranchOutliner ENTRY\n" + module->ToString());
+  HloComputation* computation = module->entry_computation();
+
+  // Estimate the cost of instructions like parallel task assignment does,
+  // falling back to their size if the cost analysis fails.
+  auto cost_analysis = absl::make_unique<HloCostAnalysis>(shape_size_function_);
+  const bool has_cost_analysis =
+      computation->root_instruction()->Accept(cost_analysis.get()).ok();
+  auto cost = [&](const HloInstruction& instruction) -> int64 {
+    if (!has_cost_analysis) {
+      return shape_size_function_(instruction.shape());
+    }
+    return 1 * cost_analysis->flop_count(instruction) +
+           2 * cost_analysis->transcendental_count(instruction) +
+           10 * cost_analysis->bytes_accessed(instruction);
+  };
+
+  const std::vector<HloInstruction*> post_order =
+      computation->MakeInstructionPostOrder();
+  absl::flat_hash_map<const HloInstruction*, int64> positions;
+  for (int64 i = 0; i < post_order.size(); ++i) {
+    positions[post_order[i]] = i;
+  }
+  absl::flat_hash_set<const HloInstruction*> outlined;
+  // Parameters and constants are inputs of the branches rather than part of
+  // them. Instructions with side effects or control dependencies keep their
+  // place in the sequential order. Instructions created by outlining are not
+  // in 'positions'.
+  auto can_outline = [&](const HloInstruction* instruction) {
+    return positions.contains(instruction) && !outlined.contains(instruction) &&
+           instruction != computation->root_instruction() &&
+           instruction->opcode() != HloOpcode::kParameter &&
+           instruction->opcode() != HloOpcode::kConstant &&
+           !instruction->HasSideEffect() &&
+           instruction->control_predecessors().empty() &&
+           instruction->control_successors().empty();
+  };
+
+  bool changed = false;
+  // Visit users before their operands, so that the largest branches are
+  // found first.
+  for (auto it = post_order.rbegin(); it != post_order.rend(); ++it) {
+    HloInstruction* join = *it;
+    if (outlined.contains(join)) {
+      continue;
+    }
+    std::vector<Branch> candidates;
+    for (HloInstruction* operand : join->unique_operands()) {
+      if (!can_outline(operand)) {
+        continue;
+      }
+      Branch branch;
+      branch.instructions = FindBranch(operand, positions, can_outline);
+      for (const HloInstruction* instruction : branch.instructions) {
+        branch.cost += cost(*instruction);
+      }
+      if (branch.cost >= kMinBranchCost) {
+        candidates.push_back(std::move(branch));
+      }
+    }
+    if (candidates.size() < 2) {
+      continue;
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Branch& a, const Branch& b) {
+                       return a.cost > b.cost;
+                     });
+
+    // Branches are disjoint, and only their outputs are used outside of
+    // them, so a branch depends on another one only through its output.
+    // Branches may themselves use the thread pool (e.g. for Eigen matmuls)
+    // and block on it. Running at most 'max_parallelism_' of them keeps a
+    // thread free to make progress on those nested tasks.
+    std::vector<Branch> branches;
+    absl::flat_hash_set<const HloInstruction*> in_branches;
+    absl::flat_hash_set<const HloInstruction*> outputs;
+    for (Branch& candidate : candidates) {
+      if (branches.size() == max_parallelism_) {
+        break;
+      }
+      const HloInstruction* output = candidate.instructions.back();
+      bool independent = std::none_of(
+          output->users().begin(), output->users().end(),
+          [&](const HloInstruction* user) {
+            return in_branches.contains(user);
+          });
+      for (const HloInstruction* instruction : candidate.instructions) {
+        for (const HloInstruction* operand : instruction->operands()) {
+          independent &= !outputs.contains(operand);
+        }
+      }
+      if (!independent) {
+        continue;
+      }
+      in_branches.insert(candidate.instructions.begin(),
+                         candidate.instructions.end());
+      outputs.insert(output);
+      branches.push_back(std::move(candidate));
+    }
+    if (branches.size() < 2) {
+      continue;
+    }
+    outlined.insert(in_branches.begin(), in_branches.end());
+    TF_RETURN_IF_ERROR(
+        OutlineConcurrentBranches(branches, module, computation));
+    changed = true;
+  }
+
+  XLA_VLOG_LINES(3, "ConcurrentBranchOutliner EXIT\n" + module->ToString());
+  return changed;
+}
+
+ConcurrentBranchHloOrdering::ConcurrentBranchHloOrdering(
+    const HloSchedule& schedule)
+    : SequentialHloOrdering(schedule) {
+  for (const HloComputation* computation : module_->computations()) {
+    if (IsConcurrentBranchComputation(*computation)) {
+      concurrent_computations_.insert(computation);
+      for (const HloComputation* callee :
+           computation->MakeEmbeddedComputationsList()) {
+        concurrent_computations_.insert(callee);
+      }
+    }
+  }
+}
+
+const std::vector<const HloInstruction*>*
+ConcurrentBranchHloOrdering::SequentialOrder(
+    const HloComputation& computation) const {
+  if (concurrent_computations_.contains(&computation)) {
+    return nullptr;
+  }
+  return SequentialHloOrdering::SequentialOrder(computation);
+}
+
+string ConcurrentBranchHloOrdering::ToString() const {
+  return absl::StrCat("ConcurrentBranchHloOrdering\n", schedule_.ToString());
+}
+
+bool ConcurrentBranchHloOrdering::ExecutesBeforeInSameComputation(
+    const HloInstruction* a, const HloInstruction* b) const {
+  if (a != b && a->opcode() == HloOpcode::kCall &&
+      b->opcode() == HloOpcode::kCall &&
+      IsConcurrentBranchComputation(*a->parent())) {
+    return false;
+  }
+  return SequentialHloOrdering::ExecutesBeforeInSameComputation(a, b);
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,98 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CONCURRENT_BRANCH_OUTLINER_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CONCURRENT_BRANCH_OUTLINER_H_
+
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_ordering.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+#include "tensorflow/compiler/xla/service/hlo_schedule.h"
+
+namespace xla {
+namespace cpu {
+
+// Returns true if 'computation' was created by ConcurrentBranchOutliner,
+// i.e. its root is a tuple of calls that run concurrently, one per task of
+// the fork/join runtime.
+bool IsConcurrentBranchComputation(const HloComputation& computation);
+
+// ConcurrentBranchOutliner finds operands of an instruction in the entry
+// computation that are computed by disjoint, expensive sets of instructions
+// (branches) and outlines each branch into its own computation. The calls to
+// the branches are grouped into a concurrent branch computation:
+//
+//   %branches = (f32[...], f32[...]) call(...), to_apply=%concurrent_branches
+//
+//   %concurrent_branches {
+//     %b0 = f32[...] call(...), to_apply=%concurrent_branch.0
+//     %b1 = f32[...] call(...), to_apply=%concurrent_branch.1
+//     ROOT %t = (f32[...], f32[...]) tuple(%b0, %b1), outer_partitions={2}
+//   }
+//
+// The IR emitter lowers the call to %concurrent_branches to a fork/join call
+// where task i runs branch i. Buffer assignment must then use a
+// ConcurrentBranchHloOrdering so that the branches do not share buffers.
+class ConcurrentBranchOutliner : public HloModulePass {
+ public:
+  // 'max_parallelism': the maximum number of branches run concurrently.
+  // 'shape_size': shape size function used by HloCostAnalysis to estimate
+  //               the cost of a branch.
+  ConcurrentBranchOutliner(const int64 max_parallelism,
+                           const HloCostAnalysis::ShapeSizeFunction& shape_size)
+      : max_parallelism_(max_parallelism), shape_size_function_(shape_size) {}
+  ~ConcurrentBranchOutliner() override {}
+
+  absl::string_view name() const override {
+    return "cpu-concurrent-branch-outliner";
+  }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  int64 max_parallelism_;
+  HloCostAnalysis::ShapeSizeFunction shape_size_function_;
+};
+
+// A sequential ordering in which the calls of a concurrent branch computation
+// are unordered with respect to each other, so that buffers live in
+// different branches interfere. Concurrent branch computations and the
+// computations they call have no sequential order, which turns off
+// whole-module heap simulation for them.
+class ConcurrentBranchHloOrdering : public SequentialHloOrdering {
+ public:
+  explicit ConcurrentBranchHloOrdering(const HloSchedule& schedule);
+  ~ConcurrentBranchHloOrdering() override = default;
+
+  const std::vector<const HloInstruction*>* SequentialOrder(
+      const HloComputation& computation) const override;
+
+  string ToString() const override;
+
+ protected:
+  bool ExecutesBeforeInSameComputation(const HloInstruction* a,
+                                       const HloInstruction* b) const override;
+
+ private:
+  // The concurrent branch computations and the computations they call.
+  absl::flat_hash_set<const HloComputation*> concurrent_computations_;
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CONCURRENT_BRANCH_OUTLINER_H_
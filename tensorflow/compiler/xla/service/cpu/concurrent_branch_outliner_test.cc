@@ -0,0 +1,147 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/concurrent_branch_outliner.h"
+#include "tensorflow/compiler/xla/service/cpu/cpu_executable.h"
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/hlo_verified_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace op = xla::testing::opcode_matchers;
+
+namespace xla {
+namespace {
+
+class ConcurrentBranchOutlinerTest : public HloVerifiedTestBase {
+ protected:
+  StatusOr<bool> RunConcurrentBranchOutliner(HloModule* module) {
+    return cpu::ConcurrentBranchOutliner(/*max_parallelism=*/4,
+                                         cpu::CpuExecutable::ShapeSizeBytes)
+        .Run(module);
+  }
+};
+
+TEST_F(ConcurrentBranchOutlinerTest, IndependentBranchesAreOutlined) {
+  const string hlo_string = R"(
+    HloModule IndependentBranches
+    ENTRY IndependentBranches {
+      p0 = f32[256,256]{1,0} parameter(0)
+      p1 = f32[256,256]{1,0} parameter(1)
+      dot0 = f32[256,256]{1,0} dot(p0, p0),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+      exp0 = f32[256,256]{1,0} exponential(dot0)
+      dot1 = f32[256,256]{1,0} dot(p1, p1),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+      tanh1 = f32[256,256]{1,0} tanh(dot1)
+      ROOT add = f32[256,256]{1,0} add(exp0, tanh1)
+    }
+  )";
+
+  ParseAndVerifyModule(hlo_string);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunConcurrentBranchOutliner(&module()));
+  EXPECT_TRUE(changed);
+
+  HloInstruction* root = module().entry_computation()->root_instruction();
+  EXPECT_THAT(root, op::Add(op::GetTupleElement(op::Call()),
+                            op::GetTupleElement(op::Call())));
+  const HloInstruction* concurrent_call = root->operand(0)->operand(0);
+  EXPECT_EQ(concurrent_call, root->operand(1)->operand(0));
+  const HloComputation* branches = concurrent_call->to_apply();
+  EXPECT_TRUE(cpu::IsConcurrentBranchComputation(*branches));
+  EXPECT_THAT(branches->root_instruction(), op::Tuple(op::Call(), op::Call()));
+}
+
+TEST_F(ConcurrentBranchOutlinerTest, DependentBranchesAreNotOutlined) {
+  const string hlo_string = R"(
+    HloModule DependentBranches
+    ENTRY DependentBranches {
+      p0 = f32[256,256]{1,0} parameter(0)
+      p1 = f32[256,256]{1,0} parameter(1)
+      dot0 = f32[256,256]{1,0} dot(p0, p0),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+      dot1 = f32[256,256]{1,0} dot(dot0, p1),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+      ROOT add = f32[256,256]{1,0} add(dot0, dot1)
+    }
+  )";
+
+  ParseAndVerifyModule(hlo_string);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunConcurrentBranchOutliner(&module()));
+  EXPECT_FALSE(changed);
+}
+
+TEST_F(ConcurrentBranchOutlinerTest, CheapBranchesAreNotOutlined) {
+  const string hlo_string = R"(
+    HloModule CheapBranches
+    ENTRY CheapBranches {
+      p0 = f32[4,4]{1,0} parameter(0)
+      p1 = f32[4,4]{1,0} parameter(1)
+      exp0 = f32[4,4]{1,0} exponential(p0)
+      tanh1 = f32[4,4]{1,0} tanh(p1)
+      ROOT add = f32[4,4]{1,0} add(exp0, tanh1)
+    }
+  )";
+
+  ParseAndVerifyModule(hlo_string);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunConcurrentBranchOutliner(&module()));
+  EXPECT_FALSE(changed);
+}
+
+TEST_F(ConcurrentBranchOutlinerTest, ConcurrentBranchesAreUnordered) {
+  const string hlo_string = R"(
+    HloModule UnorderedBranches
+    ENTRY UnorderedBranches {
+      p0 = f32[256,256]{1,0} parameter(0)
+      p1 = f32[256,256]{1,0} parameter(1)
+      dot0 = f32[256,256]{1,0} dot(p0, p0),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+      dot1 = f32[256,256]{1,0} dot(p1, p1),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+      ROOT add = f32[256,256]{1,0} add(dot0, dot1)
+    }
+  )";
+
+  ParseAndVerifyModule(hlo_string);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunConcurrentBranchOutliner(&module()));
+  ASSERT_TRUE(changed);
+  TF_ASSERT_OK_AND_ASSIGN(
+      HloSchedule schedule,
+      ScheduleModule(module(), [](const BufferValue& buffer) {
+        return ShapeUtil::ByteSizeOf(buffer.shape(), sizeof(void*));
+      }));
+  cpu::ConcurrentBranchHloOrdering ordering(schedule);
+
+  const HloInstruction* root = module().entry_computation()->root_instruction();
+  const HloComputation* branches = root->operand(0)->operand(0)->to_apply();
+  const HloInstruction* branch0 = branches->root_instruction()->operand(0);
+  const HloInstruction* branch1 = branches->root_instruction()->operand(1);
+  EXPECT_FALSE(ordering.ExecutesBefore(branch0, branch1));
+  EXPECT_FALSE(ordering.ExecutesBefore(branch1, branch0));
+  EXPECT_TRUE(ordering.ExecutesBefore(branch0, branches->root_instruction()));
+
+  // Buffers inside of the branches must not be shared with each other.
+  const HloInstruction* dot0 = branch0->to_apply()->root_instruction();
+  const HloInstruction* dot1 = branch1->to_apply()->root_instruction();
+  EXPECT_FALSE(ordering.ExecutesBefore(dot0, dot1));
+  EXPECT_FALSE(ordering.ExecutesBefore(dot1, dot0));
+
+  EXPECT_EQ(ordering.SequentialOrder(*branches), nullptr);
+  EXPECT_NE(ordering.SequentialOrder(*module().entry_computation()), nullptr);
+}
+
+}  // namespace
+}  // namespace xla
@@ -54,6 +54,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/convolution_feature_group_converter.h"
 #include "tensorflow/compiler/xla/service/cpu/buffer_info_util.h"
 #include "tensorflow/compiler/xla/service/cpu/compiler_functor.h"
+#include "tensorflow/compiler/xla/service/cpu/concurrent_branch_outliner.h"
 #include "tensorflow/compiler/xla/service/cpu/conv_canonicalization.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_copy_insertion.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_executable.h"
@@ -349,14 +350,27 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
       module->config().intra_op_parallelism_threads() > 0
           ? module->config().intra_op_parallelism_threads()
           : tensorflow::port::NumSchedulableCPUs();
+  const int aot_max_parallelism =
+      module->config().debug_options().xla_cpu_aot_max_parallelism();
   if (!is_aot_compile) {
     // Run ParallelTaskAssigner to assign parallel tasks to HLOs in module.
-    // Note this is not run for AOT because it would bring in thread pool
-    // and thread synchronization dependencies which would likely increase
-    // binary size (and most AOT applications are single-threaded).
-    // TODO(b/29630486) Support multi-threaded AOT.
     pipeline.AddPass<ParallelTaskAssigner>(
         max_parallelism, ShapeSizeBytesFunction(), target_machine_features);
+    // Tasks of concurrent branches would race on the profile counters.
+    if (module->config().debug_options().xla_cpu_enable_concurrent_branches() &&
+        !module->config().hlo_profiling_enabled()) {
+      pipeline.AddPass<ConcurrentBranchOutliner>(max_parallelism,
+                                                 ShapeSizeBytesFunction());
+    }
+  } else if (aot_max_parallelism > 0) {
+    // By default this is not run for AOT because it would bring in thread
+    // pool and thread synchronization dependencies which would likely
+    // increase binary size (and most AOT applications are single-threaded).
+    // The number of schedulable CPUs of the compiling machine says nothing
+    // about the target, so the parallelism is given explicitly.
+    pipeline.AddPass<ParallelTaskAssigner>(aot_max_parallelism,
+                                           ShapeSizeBytesFunction(),
+                                           target_machine_features);
   }
   // Copy insertion should be performed immediately before IR emission to
   // avoid inserting unnecessary copies (later pass adds an instruction which
@@ -591,14 +605,16 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
       HloSchedule schedule,
       ScheduleModule(*module, BufferSizeBytesFunction(), DFSMemoryScheduler));
 
-  // Run buffer allocation on the HLO graph.
+  // Run buffer allocation on the HLO graph. The ordering is sequential except
+  // for the branches that ConcurrentBranchOutliner grouped, if any.
   TF_ASSIGN_OR_RETURN(
       std::unique_ptr<BufferAssignment> assignment,
-      BufferAssigner::Run(module.get(),
-                          absl::make_unique<SequentialHloOrdering>(schedule),
-                          BufferSizeBytesFunction(), memory_alignment,
-                          /*allow_input_output_aliasing=*/false,
-                          /*allocate_buffers_for_constants=*/true));
+      BufferAssigner::Run(
+          module.get(),
+          absl::make_unique<ConcurrentBranchHloOrdering>(schedule),
+          BufferSizeBytesFunction(), memory_alignment,
+          /*allow_input_output_aliasing=*/false,
+          /*allocate_buffers_for_constants=*/true));
   // BufferAssignment::ToString() includes a header, so no need for us to
   // print one ourselves.
   XLA_VLOG_LINES(2, assignment->ToString());
@@ -660,8 +676,18 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
 
   XLA_VLOG_LINES(2, "LLVM IR:\n" + llvm_ir::DumpModuleToString(*llvm_module));
 
-  // JIT compile the LLVM IR module to in-memory machine code.
-  jit->AddModule(std::move(llvm_module));
+  // JIT compile the LLVM IR module to in-memory machine code.  Modules split
+  // for parallel compilation are not seen whole by the IR hooks, so they are
+  // only split when there are none.
+  const int split_count = module->config()
+                              .debug_options()
+                              .xla_llvm_parallel_codegen_split_count();
+  if (split_count > 1 && !pre_optimization_ir_hook &&
+      !post_optimization_ir_hook) {
+    jit->AddModuleInParallel(std::move(llvm_module), split_count);
+  } else {
+    jit->AddModule(std::move(llvm_module));
+  }
   cpu_executable.reset(new CpuExecutable(
       std::move(jit), std::move(assignment), std::move(module), function_name,
       std::move(hlo_profile_printer_data), std::move(hlo_profile_index_map)));
@@ -43,6 +43,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/map_util.h"
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
+#include "tensorflow/compiler/xla/service/cpu/concurrent_branch_outliner.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_options.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
@@ -52,6 +53,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/parallel_loop_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/shape_partition.h"
 #include "tensorflow/compiler/xla/service/cpu/simple_orc_jit.h"
+#include "tensorflow/compiler/xla/service/cpu/vector_support_library.h"
 #include "tensorflow/compiler/xla/service/elemental_ir_emitter.h"
 #include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
@@ -60,6 +62,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/llvm_ir/buffer_assignment_util.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/dynamic_update_slice_util.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/fused_ir_emitter.h"
+#include "tensorflow/compiler/xla/service/llvm_ir/kernel_support_library.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_loop.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/tuple_ops.h"
@@ -658,6 +661,17 @@ Status IrEmitter::HandleTuple(HloInstruction* tuple) {
   for (auto operand : tuple->operands()) {
     base_ptrs.push_back(GetEmittedValueFor(operand));
   }
+  if (IsConcurrentBranchComputation(*tuple->parent())) {
+    // Every task of the fork/join call computes the same root tuple; only
+    // the first one writes it.
+    llvm_ir::LlvmIfData if_data = llvm_ir::EmitIfThenElse(
+        ICmpEQ(compute_function_->GetDynamicLoopBound(0), b_.getInt64(0)),
+        "first_branch", &b_, /*emit_else=*/false);
+    SetToFirstInsertPoint(if_data.true_block, &b_);
+    llvm_ir::EmitTuple(GetIrArrayFor(tuple), base_ptrs, &b_, module_);
+    SetToFirstInsertPoint(if_data.after_block, &b_);
+    return Status::OK();
+  }
   llvm_ir::EmitTuple(GetIrArrayFor(tuple), base_ptrs, &b_, module_);
   return Status::OK();
 }
@@ -1749,8 +1763,16 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
       MinimumAlignmentForPrimitiveType(reduce->shape().element_type()));
 
   if (is_reduction_over_minor_dimension) {
-    // TODO(sanjoy): Implement vectorized reduction over the minor dimension.
-    *failure_reason = "reduction over minor dimension not implemented";
+    return EmitVectorizedReduceOverMinorDimensions(
+        reduce, arg, init_value, dimensions, reduction_generator,
+        failure_reason);
+  }
+
+  // The innermost output dimension is vectorized below, so it can't be split
+  // across parallel tasks.
+  if (ShouldEmitParallelLoopFor(*reduce) &&
+      num_dynamic_loop_bounds_ >= ShapeUtil::Rank(reduce->shape())) {
+    *failure_reason = "minor dimension is partitioned across parallel tasks";
     return false;
   }
 
@@ -1780,15 +1802,8 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
   llvm_ir::ForLoopNest loop_nest(IrName(reduce), &b_);
   llvm_ir::IrArray::Index array_index(b_.getInt64Ty(),
                                       reduce->shape().dimensions_size());
-  for (int i = LayoutUtil::MinorToMajor(reduce->shape()).size() - 1; i > 0;
-       --i) {
-    int64 dimension = LayoutUtil::Minor(reduce->shape().layout(), i);
-    int64 start_index = 0;
-    int64 end_index = reduce->shape().dimensions(dimension);
-    std::unique_ptr<llvm_ir::ForLoop> loop = loop_nest.AddLoop(
-        start_index, end_index, absl::StrFormat("dim.%d", dimension));
-    array_index[dimension] = loop->GetIndVarValue();
-  }
+  EmitReduceOutputLoops(*reduce, /*num_inner_dims=*/1, &loop_nest,
+                        &array_index);
 
   int64 innermost_dimension = LayoutUtil::Minor(reduce->shape().layout(), 0);
   int64 innermost_dimension_size =
@@ -1865,6 +1880,177 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
   return true;
 }
 
+void IrEmitter::EmitReduceOutputLoops(const HloInstruction& reduce,
+                                      int64 num_inner_dims,
+                                      llvm_ir::ForLoopNest* loop_nest,
+                                      llvm_ir::IrArray::Index* output_index) {
+  const Shape& shape = reduce.shape();
+  const int64 rank = ShapeUtil::Rank(shape);
+  std::vector<std::pair<llvm::Value*, llvm::Value*>> dynamic_loop_bounds;
+  if (ShouldEmitParallelLoopFor(reduce)) {
+    dynamic_loop_bounds = compute_function_->GetDynamicLoopBounds();
+  }
+  // Add loops from the most major dimension inwards, as ParallelLoopEmitter
+  // does, so that the dynamic loop bounds of a parallel task apply to the
+  // partitioned dimensions.
+  for (int64 i = rank - 1; i >= num_inner_dims; --i) {
+    const int64 dimension = LayoutUtil::Minor(shape.layout(), i);
+    const int64 bounds_index = rank - 1 - i;
+    std::unique_ptr<llvm_ir::ForLoop> loop;
+    if (bounds_index < dynamic_loop_bounds.size()) {
+      loop = loop_nest->AddLoop(absl::StrFormat("dim.%d", dimension),
+                                dynamic_loop_bounds[bounds_index].first,
+                                dynamic_loop_bounds[bounds_index].second);
+    } else {
+      loop = loop_nest->AddLoop(/*start_index=*/0,
+                                /*end_index=*/shape.dimensions(dimension),
+                                absl::StrFormat("dim.%d", dimension));
+    }
+    (*output_index)[dimension] = loop->GetIndVarValue();
+  }
+}
+
+StatusOr<bool> IrEmitter::EmitVectorizedReduceOverMinorDimensions(
+    HloInstruction* reduce, HloInstruction* arg, HloInstruction* init_value,
+    absl::Span<const int64> dimensions,
+    const ReductionGenerator& reduction_generator, string* failure_reason) {
+  // Every output element must reduce a contiguous run of input elements, so
+  // the reduced dimensions have to be the most minor ones.
+  const Shape& arg_shape = arg->shape();
+  int64 reduced_elements = 1;
+  for (int64 i = 0; i < dimensions.size(); ++i) {
+    const int64 dimension = LayoutUtil::Minor(arg_shape.layout(), i);
+    if (std::find(dimensions.begin(), dimensions.end(), dimension) ==
+        dimensions.end()) {
+      *failure_reason =
+          "reduction over minor and non-minor dimensions not implemented";
+      return false;
+    }
+    reduced_elements *= arg_shape.dimensions(dimension);
+  }
+
+  const PrimitiveType element_type = reduce->shape().element_type();
+  const int64 vector_size =
+      target_machine_features_.vector_register_num_elements(
+          *compute_function_->function(), element_type);
+  if (vector_size < 2 || reduced_elements < vector_size) {
+    *failure_reason = "too few elements per output to vectorize";
+    return false;
+  }
+  // Use several accumulators to hide the latency of the reduction function,
+  // as many as fit in the vectorization factor.
+  const int64 num_accumulators = std::max<int64>(
+      1, std::min<int64>(
+             target_machine_features_.vectorization_factor_in_bytes() /
+                 (vector_size *
+                  ShapeUtil::ByteSizeOfPrimitiveType(element_type)),
+             reduced_elements / vector_size));
+  const int64 stride = num_accumulators * vector_size;
+
+  CHECK(!ShapeUtil::IsTuple(reduce->shape()));
+  TF_RETURN_IF_ERROR(EmitTargetAddressForOp(reduce));
+
+  // We lower the reduction of the N elements of input[d1, d0, r1, r0] along R1
+  // and R0 as:
+  //
+  //  for (d1 in D1) {
+  //    for (d0 in D0) {
+  //      acc[k] = input[d1, d0, k * VS : (k + 1) * VS] for k in [0, A)
+  //      for (r in [A * VS, N) with stride A * VS) {
+  //        acc[k] = elementwise_reduce(acc[k], input[d1, d0, r + k * VS : ...])
+  //      }
+  //      result = reduce_lanes(reduce(acc[0], ..., acc[A - 1], <leftovers>))
+  //      output[d1, d0] = reduce(init, result, <scalar leftovers>)
+  //    }
+  //  }
+  //
+  // where VS is the number of elements in a vector register and A is the
+  // number of accumulators.
+  llvm_ir::ForLoopNest loop_nest(IrName(reduce), &b_);
+  llvm_ir::IrArray::Index output_index(b_.getInt64Ty(),
+                                       reduce->shape().dimensions_size());
+  EmitReduceOutputLoops(*reduce, /*num_inner_dims=*/0, &loop_nest,
+                        &output_index);
+  if (llvm::BasicBlock* innermost_body_bb =
+          loop_nest.GetInnerLoopBodyBasicBlock()) {
+    SetToFirstInsertPoint(innermost_body_bb, &b_);
+  }
+  auto outermost_loop_exit_block = loop_nest.GetOuterLoopExitBasicBlock();
+
+  // The address of the first input element reduced into output_index.
+  llvm_ir::IrArray arg_array(GetIrArrayFor(arg));
+  llvm_ir::IrArray::Index input_index(b_.getInt64Ty(),
+                                      arg_shape.dimensions_size());
+  llvm_ir::IrArray::Index::const_iterator it = output_index.begin();
+  for (int64 i = 0; i < input_index.size(); ++i) {
+    if (std::find(dimensions.begin(), dimensions.end(), i) !=
+        dimensions.end()) {
+      input_index[i] = b_.getInt64(0);
+    } else {
+      input_index[i] = *it++;
+    }
+  }
+  CHECK(output_index.end() == it);
+  llvm::Value* input_address =
+      arg_array.EmitArrayElementAddress(input_index, &b_);
+
+  VectorSupportLibrary vsl(element_type, vector_size, &b_, "reduce");
+  auto load_vector = [&](llvm::Value* offset) {
+    llvm::Value* vector = vsl.LoadVector(input_address, offset);
+    arg_array.AnnotateLoadStoreInstructionWithMetadata(
+        llvm::cast<llvm::Instruction>(vector));
+    return vector;
+  };
+  auto reduce_values = [&](llvm::Value* lhs, llvm::Value* rhs) {
+    return reduction_generator(&b_, lhs, rhs);
+  };
+
+  std::vector<llvm::Value*> initial_accumulators;
+  for (int64 k = 0; k < num_accumulators; ++k) {
+    initial_accumulators.push_back(load_vector(b_.getInt64(k * vector_size)));
+  }
+  TileVariable accumulators(&vsl, initial_accumulators);
+  const int64 vectorized_end = reduced_elements / stride * stride;
+  KernelSupportLibrary ksl(&b_);
+  ksl.ForReturnVoid(
+      "reduction", /*start=*/stride, /*end=*/vectorized_end, /*step=*/stride,
+      [&](llvm::Value* offset) {
+        std::vector<llvm::Value*> values = accumulators.Get();
+        for (int64 k = 0; k < num_accumulators; ++k) {
+          values[k] = reduce_values(
+              values[k],
+              load_vector(Add(offset, b_.getInt64(k * vector_size))));
+        }
+        accumulators.Set(values);
+      });
+
+  std::vector<llvm::Value*> values = accumulators.Get();
+  llvm::Value* vector_result = values[0];
+  for (int64 k = 1; k < num_accumulators; ++k) {
+    vector_result = reduce_values(vector_result, values[k]);
+  }
+  int64 offset = vectorized_end;
+  for (; offset + vector_size <= reduced_elements; offset += vector_size) {
+    vector_result =
+        reduce_values(vector_result, load_vector(b_.getInt64(offset)));
+  }
+  llvm::Value* result = reduce_values(Load(GetEmittedValueFor(init_value)),
+                                      vsl.ReduceLanes(vector_result,
+                                                      reduce_values));
+  for (; offset < reduced_elements; ++offset) {
+    llvm::Value* element = vsl.LoadScalar(input_address, offset);
+    arg_array.AnnotateLoadStoreInstructionWithMetadata(
+        llvm::cast<llvm::Instruction>(element));
+    result = reduce_values(result, element);
+  }
+  GetIrArrayFor(reduce).EmitWriteArrayElement(output_index, result, &b_);
+
+  if (outermost_loop_exit_block) {
+    b_.SetInsertPoint(outermost_loop_exit_block);
+  }
+  return true;
+}
+
 StatusOr<llvm::Value*> IrEmitter::EmitTargetElementLoopBodyForReduce(
     HloReduceInstruction* reduce, const llvm_ir::IrArray::Index& index) {
   const HloInstruction* arg = reduce->mutable_operand(0);
@@ -2259,7 +2445,36 @@ Status IrEmitter::HandleCall(HloInstruction* call) {
 
   TF_RETURN_IF_ERROR(EmitTargetAddressForOp(call));
 
-  if (!computation->root_instruction()->outer_dimension_partitions().empty()) {
+  if (IsConcurrentBranchComputation(*call->parent())) {
+    // Task i of the fork/join call to the parent computation runs branch i.
+    const HloInstruction* root = call->parent()->root_instruction();
+    const int64 branch_index = root->operand_index(call);
+    llvm_ir::LlvmIfData if_data = llvm_ir::EmitIfThenElse(
+        ICmpEQ(compute_function_->GetDynamicLoopBound(0),
+               b_.getInt64(branch_index)),
+        "concurrent_branch", &b_, /*emit_else=*/false);
+    SetToFirstInsertPoint(if_data.true_block, &b_);
+    EmitGlobalCall(*computation, computation->name());
+    SetToFirstInsertPoint(if_data.after_block, &b_);
+  } else if (IsConcurrentBranchComputation(*computation)) {
+    // ConcurrentBranchOutliner grouped independent branches, run one per
+    // task of a fork/join call.
+    std::vector<llvm::Value*> call_args = GetArrayFunctionCallArguments(
+        {}, &b_, computation->name(),
+        /*return_value_buffer=*/emitted_value_[call],
+        /*exec_run_options_arg=*/GetExecutableRunOptionsArgument(),
+        /*buffer_table_arg=*/GetBufferTableArgument(),
+        /*profile_counters_arg=*/GetProfileCountersArgument());
+
+    const HloInstruction* root = computation->root_instruction();
+    const int64 num_branches = root->operand_count();
+    TF_RETURN_IF_ERROR(EmitCallToParallelForkJoin(
+        call_args, ShapeUtil::MakeShape(S32, {num_branches}),
+        root->outer_dimension_partitions(), &b_, call_ir_function,
+        computation->name()));
+  } else if (!computation->root_instruction()
+                  ->outer_dimension_partitions()
+                  .empty()) {
     // ParallelTaskAssignment assigned partitions, emit call to
     // ParallelForkJoin.
     std::vector<llvm::Value*> call_args = GetArrayFunctionCallArguments(
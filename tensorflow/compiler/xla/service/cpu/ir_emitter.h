@@ -43,6 +43,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/llvm_ir/alias_analysis.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/ir_array.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/ir_builder_mixin.h"
+#include "tensorflow/compiler/xla/service/llvm_ir/llvm_loop.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/loop_emitter.h"
 #include "tensorflow/compiler/xla/service/name_uniquer.h"
 #include "tensorflow/compiler/xla/statusor.h"
@@ -379,6 +380,24 @@ class IrEmitter : public DfsHloVisitorWithDefault,
       HloInstruction* arg, absl::Span<const int64> dimensions,
       unsigned element_alignment);
 
+  // Tries to emit a vectorized reduction over the most minor dimensions of
+  // `arg`: every output element is accumulated from vector loads of its
+  // contiguous input elements, and the lanes are combined at the end.
+  // Helper function for EmitVectorizedReduce.
+  StatusOr<bool> EmitVectorizedReduceOverMinorDimensions(
+      HloInstruction* reduce, HloInstruction* arg, HloInstruction* init_value,
+      absl::Span<const int64> dimensions,
+      const ReductionGenerator& reduction_generator, string* failure_reason);
+
+  // Adds to `loop_nest` the loops over all but the `num_inner_dims` most minor
+  // dimensions of the output of `reduce`, and sets the matching entries of
+  // `output_index`. If `reduce` is the root of a parallel task, the loops over
+  // the partitioned dimensions use the dynamic loop bounds of the task.
+  void EmitReduceOutputLoops(const HloInstruction& reduce,
+                             int64 num_inner_dims,
+                             llvm_ir::ForLoopNest* loop_nest,
+                             llvm_ir::IrArray::Index* output_index);
+
   // Tries to emit a fast concatenate operation using memcpy.  Returns true if
   // successful, and false on failure.  On failure, sets "failure_reason" to a
   // string describing why it could not emit a fast concatenate.
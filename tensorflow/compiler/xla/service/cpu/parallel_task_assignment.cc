@@ -76,8 +76,11 @@ class DefaultCostModel : public ParallelCostModel {
       // TODO(b/29630486) Develop system bandwidth model.
       max_parallelism =
           std::ceil(std::sqrt(tensorflow::port::NumSchedulableCPUs()));
-      // Use shape size instruction cost and L2 cache size min per-thread cost.
-      instruction_cost = shape_size_(instruction->shape());
+      // Use the bytes read and written as the instruction cost, and the L2
+      // cache size as the min per-thread cost, so that each task streams
+      // roughly one L2-sized tile of its operands and output. Sizing by the
+      // output alone would never split reductions, whose outputs are small.
+      instruction_cost = bytes_accessed;
       min_cost_per_thread = 256LL << 10;  // 256KB L2 Cache size.
     } else {
       // Use max parallelism for compute bound instructions.
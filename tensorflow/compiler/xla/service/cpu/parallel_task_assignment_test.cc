@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/test.h"
 #include "tensorflow/compiler/xla/tests/hlo_verified_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/cpu_info.h"
 
 namespace xla {
 namespace {
@@ -121,5 +122,30 @@ TEST_F(ParallelTaskAssignmentTest, InfeedOutfeedOperationNotParallelized) {
   EXPECT_FALSE(changed);
 }
 
+TEST_F(ParallelTaskAssignmentTest, ReduceToVectorParallelized) {
+  // I/O bound instructions get at most sqrt(#cpus) tasks.
+  if (tensorflow::port::NumSchedulableCPUs() < 2) {
+    return;
+  }
+  const string hlo_string = R"(
+    HloModule TestTaskParallel_reduce
+    add {
+      lhs = f32[] parameter(0)
+      rhs = f32[] parameter(1)
+      ROOT add = f32[] add(lhs, rhs)
+    }
+    ENTRY Reduce {
+      input = f32[4096,4096]{1,0} parameter(0)
+      zero = f32[] constant(0)
+      ROOT reduce = f32[4096]{0} reduce(input, zero), dimensions={1},
+        to_apply=add
+    }
+  )";
+
+  ParseAndVerifyModule(hlo_string);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(&module()));
+  EXPECT_TRUE(changed);
+}
+
 }  // namespace
 }  // namespace xla
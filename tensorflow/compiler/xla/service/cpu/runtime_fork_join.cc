@@ -76,6 +76,17 @@ TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_ParallelForkJoin(
   // Compute partition stride in 'partitions' array.
   const int64 stride = 2 * num_partitioned_dims;
 
+  // Ahead-of-time compiled functions may be run without a thread pool, in
+  // which case the partitions run one after the other.
+  if (run_options->intra_op_thread_pool() == nullptr) {
+    for (int32 i = 0; i < num_partitions; ++i) {
+      function(result_ptr, run_options_ptr, params, buffer_table,
+               &partitions[i * stride], prof_counters);
+    }
+    VLOG(2) << "ParallelForkJoin EXIT";
+    return;
+  }
+
   // Dispatch 'num_partitions - 1' compute functions to run in parallel.
   tensorflow::BlockingCounter bc(num_partitions - 1);
   for (int32 i = 1; i < num_partitions; ++i) {
@@ -21,6 +21,7 @@ limitations under the License.
 #include <utility>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/JITSymbol.h"
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
@@ -42,7 +43,10 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_fft.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_matmul.h"
 #include "tensorflow/compiler/xla/service/cpu/windows_compatibility.h"
+#include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
 #include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -97,13 +101,18 @@ SimpleOrcJIT::SimpleOrcJIT(const llvm::TargetOptions& target_options,
                            bool disable_expensive_passes,
                            LLVMCompiler::ModuleHook pre_optimization_hook,
                            LLVMCompiler::ModuleHook post_optimization_hook)
-    : target_machine_(InferTargetMachineForJIT(target_options, opt_level)),
+    : target_options_(target_options),
+      opt_level_(opt_level),
+      optimize_for_size_(optimize_for_size),
+      enable_fast_math_(enable_fast_math),
+      disable_expensive_passes_(disable_expensive_passes),
+      target_machine_(InferTargetMachineForJIT(target_options, opt_level)),
       disassembler_(*target_machine_),
       data_layout_(target_machine_->createDataLayout()),
       symbol_resolver_(llvm::orc::createLegacyLookupResolver(
           execution_session_,
           [this](const std::string& name) -> llvm::JITSymbol {
-            return this->ResolveRuntimeSymbol(name);
+            return this->ResolveSymbol(name);
           },
           [](llvm::Error Err) {
             cantFail(std::move(Err), "lookupFlags failed");
@@ -137,6 +146,20 @@ llvm::JITSymbol SimpleOrcJIT::ResolveRuntimeSymbol(const std::string& name) {
   return symbol_info;
 }
 
+llvm::JITSymbol SimpleOrcJIT::ResolveSymbol(const std::string& name) {
+  if (llvm::JITSymbol symbol = ResolveRuntimeSymbol(name)) {
+    return symbol;
+  }
+  for (auto& key : module_keys_) {
+    if (llvm::JITSymbol symbol =
+            compile_layer_.findSymbolIn(key, name,
+                                        /*ExportedSymbolsOnly=*/false)) {
+      return symbol;
+    }
+  }
+  return nullptr;
+}
+
 SimpleOrcJIT::VModuleKeyT SimpleOrcJIT::AddModule(
     std::unique_ptr<llvm::Module> module) {
   auto key = execution_session_.allocateVModule();
@@ -145,6 +168,52 @@ SimpleOrcJIT::VModuleKeyT SimpleOrcJIT::AddModule(
   return key;
 }
 
+std::vector<SimpleOrcJIT::VModuleKeyT> SimpleOrcJIT::AddModuleInParallel(
+    std::unique_ptr<llvm::Module> module, int num_partitions) {
+  const std::vector<string> partitions = llvm_ir::SplitModuleToBitcode(
+      *module, num_partitions, /*preserve_locals=*/false);
+  module.reset();
+
+  // Neither LLVMContexts nor TargetMachines are thread-safe, so each
+  // partition is loaded into its own context and compiled by its own target
+  // machine.
+  std::vector<std::unique_ptr<llvm::TargetMachine>> target_machines;
+  for (int i = 0; i < partitions.size(); ++i) {
+    target_machines.push_back(
+        InferTargetMachineForJIT(target_options_, opt_level_));
+  }
+  std::vector<ObjLayerT::ObjectPtr> objects(partitions.size());
+  {
+    tensorflow::thread::ThreadPool pool(tensorflow::Env::Default(),
+                                        "xla_cpu_codegen",
+                                        std::max<int>(partitions.size(), 1));
+    for (int i = 0; i < partitions.size(); ++i) {
+      pool.Schedule([this, i, &partitions, &target_machines, &objects] {
+        llvm::LLVMContext context;
+        std::unique_ptr<llvm::Module> partition =
+            llvm_ir::LoadModuleFromBitcode(
+                partitions[i], absl::StrCat("__compute_module_partition_", i),
+                &context)
+                .ConsumeValueOrDie();
+        const Disassembler disassembler(*target_machines[i]);
+        objects[i] = CompilerFunctor(target_machines[i].get(), &disassembler,
+                                     opt_level_, optimize_for_size_,
+                                     enable_fast_math_,
+                                     disable_expensive_passes_)(*partition);
+      });
+    }
+  }
+
+  std::vector<VModuleKeyT> keys;
+  for (auto& object : objects) {
+    auto key = execution_session_.allocateVModule();
+    cantFail(object_layer_.addObject(key, std::move(object)));
+    module_keys_.push_back(key);
+    keys.push_back(key);
+  }
+  return keys;
+}
+
 void SimpleOrcJIT::RemoveModule(SimpleOrcJIT::VModuleKeyT key) {
   module_keys_.erase(std::remove(module_keys_.begin(), module_keys_.end(), key),
                      module_keys_.end());
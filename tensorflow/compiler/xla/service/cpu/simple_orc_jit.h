@@ -39,7 +39,8 @@ namespace cpu {
 // This class wraps Orc's functionality into a single interface that only
 // exposes what we need for XLA.
 //
-// Supports JIT-ing multiple modules but without cross-module linking.
+// Supports JIT-ing multiple modules, whose undefined symbols are resolved
+// against the XLA runtime and then against the other modules of the JIT.
 // Implements eager compilation - the module is lowered to binary as soon as
 // it's added to the JIT.
 class SimpleOrcJIT {
@@ -81,6 +82,13 @@ class SimpleOrcJIT {
   // remove this module.
   VModuleKeyT AddModule(std::unique_ptr<llvm::Module> module);
 
+  // Same as AddModule, but splits the module into up to |num_partitions|
+  // modules that are optimized and lowered to binary in parallel, each on
+  // its own thread.  The pre- and post-optimization hooks are not run on
+  // these modules.  Returns the keys of the modules.
+  std::vector<VModuleKeyT> AddModuleInParallel(
+      std::unique_ptr<llvm::Module> module, int num_partitions);
+
   // Remove a module from the JIT and free the memory associated with it.
   void RemoveModule(VModuleKeyT key);
 
@@ -99,6 +107,19 @@ class SimpleOrcJIT {
  private:
   llvm::JITSymbol ResolveRuntimeSymbol(const std::string& name);
 
+  // Resolves |name| against the XLA runtime, then against all the symbols of
+  // the modules of the JIT, which may be hidden if they come from modules
+  // split by AddModuleInParallel.
+  llvm::JITSymbol ResolveSymbol(const std::string& name);
+
+  // Parameters of the code generation of the modules added in parallel,
+  // which each get their own TargetMachine.
+  const llvm::TargetOptions target_options_;
+  const llvm::CodeGenOpt::Level opt_level_;
+  const bool optimize_for_size_;
+  const bool enable_fast_math_;
+  const bool disable_expensive_passes_;
+
   std::vector<VModuleKeyT> module_keys_;
   std::unique_ptr<llvm::TargetMachine> target_machine_;
   const Disassembler disassembler_;
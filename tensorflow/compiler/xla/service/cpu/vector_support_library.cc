@@ -252,10 +252,18 @@ llvm::Value* VectorSupportLibrary::LoadBroadcast(llvm::Value* pointer) {
 }
 
 llvm::Value* VectorSupportLibrary::AddReduce(llvm::Value* vector) {
+  return ReduceLanes(vector, [this](llvm::Value* lhs, llvm::Value* rhs) {
+    return Add(lhs, rhs);
+  });
+}
+
+llvm::Value* VectorSupportLibrary::ReduceLanes(
+    llvm::Value* vector,
+    const std::function<llvm::Value*(llvm::Value*, llvm::Value*)>& combine) {
   llvm::SmallVector<llvm::Constant*, 32> mask(vector_size(), nullptr);
   for (unsigned i = vector_size(); i != 1; i >>= 1) {
     // On every iteration, we shuffle half of the remaining lanes to the top
-    // half of shuffle, and add two old and the new vector.
+    // half of shuffle, and combine the old and the new vector.
 
     for (unsigned j = 0; j < vector_size(); ++j) {
       if (j < (i / 2)) {
@@ -268,53 +276,12 @@ llvm::Value* VectorSupportLibrary::AddReduce(llvm::Value* vector) {
     llvm::Value* half_remaining_lanes =
         b()->CreateShuffleVector(vector, llvm::UndefValue::get(vector_type()),
                                  llvm::ConstantVector::get(mask), "");
-    vector = Add(vector, half_remaining_lanes);
+    vector = combine(vector, half_remaining_lanes);
   }
 
   return b()->CreateExtractElement(vector, b()->getInt32(0), name());
 }
 
-llvm::Value* VectorSupportLibrary::AvxStyleHorizontalAdd(llvm::Value* lhs,
-                                                         llvm::Value* rhs) {
-  CHECK_EQ(lhs->getType(), vector_type());
-  CHECK_EQ(rhs->getType(), vector_type());
-  CHECK_EQ(vector_size() % 2, 0);
-
-  llvm::SmallVector<llvm::Constant*, 32> mask_a, mask_b;
-
-  // Adding the values shuffled using mask_a and mask_b gives us the
-  // AVX-style horizontal add we want.  The masks work as documented
-  // in https://llvm.org/docs/LangRef.html#shufflevector-instruction
-  //
-  // Here are the masks for vector_width() == 8:
-  //
-  //    index: |0 |1 |2 | 3 |4 |5 | 6 | 7
-  //   --------+--+--+--+---+--+--+---+---
-  //   mask_a: |0 |2 |8 |10 |4 |6 |12 |14
-  //   mask_b: |1 |3 |9 |11 |5 |7 |13 |16
-  //
-  // So, as an example, the value at lane 3 of the result vector is
-  // the result of adding lane 10 and lane 11 in the combined lhs++rhs
-  // vector, which are the lanes 2 and 3 in the rhs vector.
-  for (int i = 0; i < vector_size(); i += 2) {
-    int increment = i < vector_size() / 2 ? 0 : (vector_size() / 2);
-    mask_a.push_back(b()->getInt32(increment + i));
-    mask_b.push_back(b()->getInt32(increment + i + 1));
-  }
-  for (int i = 0; i < vector_size(); i += 2) {
-    int increment = i < vector_size() / 2 ? (vector_size() / 2) : vector_size();
-    mask_a.push_back(b()->getInt32(increment + i));
-    mask_b.push_back(b()->getInt32(increment + i + 1));
-  }
-
-  llvm::Value* shuffle_0 =
-      b()->CreateShuffleVector(lhs, rhs, llvm::ConstantVector::get(mask_a));
-  llvm::Value* shuffle_1 =
-      b()->CreateShuffleVector(lhs, rhs, llvm::ConstantVector::get(mask_b));
-
-  return Add(shuffle_0, shuffle_1);
-}
-
 llvm::Value* VectorSupportLibrary::ExtractLowHalf(llvm::Value* vector) {
   llvm::SmallVector<llvm::Constant*, 32> mask;
   for (int i = 0; i < vector_size() / 2; i++) {
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_VECTOR_SUPPORT_LIBRARY_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_VECTOR_SUPPORT_LIBRARY_H_
 
+#include <functional>
 #include <string>
 
 #include "absl/types/span.h"
@@ -215,6 +216,15 @@ class VectorSupportLibrary {
   std::vector<llvm::Value*> ComputeHorizontalSums(
       std::vector<llvm::Value*> vectors, llvm::Value* init_values = nullptr);
 
+  // Reduces the lanes of `vector` to a scalar in log2(vector_size()) steps,
+  // each of which combines the upper half of the remaining lanes into the
+  // lower half with `combine`. `combine` must be associative and commutative,
+  // and is called on vectors of vector_type(). vector_size() must be a power
+  // of two.
+  llvm::Value* ReduceLanes(
+      llvm::Value* vector,
+      const std::function<llvm::Value*(llvm::Value*, llvm::Value*)>& combine);
+
   llvm::Value* GetZeroVector();
   llvm::Value* GetZeroScalar();
 
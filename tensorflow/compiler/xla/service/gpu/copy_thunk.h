@@ -67,6 +67,7 @@ class DeviceToDeviceCopyThunk : public Thunk {
   Status ExecuteOnStream(const BufferAllocations& buffer_allocations,
                          se::Stream* stream,
                          HloExecutionProfiler* profiler) override;
+  bool IsCapturable() const override { return true; }
 
  private:
   const BufferAllocation::Slice source_buffer_;
@@ -23,8 +23,11 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/convolution_thunk.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/window_util.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/autotune_cache.h"
 
 namespace xla {
 namespace gpu {
@@ -132,19 +135,55 @@ tensorflow::mutex_lock LockGpu(const se::StreamExecutor* stream_exec) {
   return tensorflow::mutex_lock{it->second};
 }
 
+// Returns the AutotuneCache device key of the GPU of `stream_exec`. The GPU
+// model and the cuDNN version both change which algorithm is the fastest.
+string AutotuneDevice(se::StreamExecutor* stream_exec) {
+  const se::DeviceDescription& description =
+      stream_exec->GetDeviceDescription();
+  int cc_major = 0;
+  int cc_minor = 0;
+  description.cuda_compute_capability(&cc_major, &cc_minor);
+  string dnn_version = "unknown";
+  if (auto* dnn = stream_exec->AsDnn()) {
+    auto version_or = dnn->GetVersion();
+    if (version_or.ok()) {
+      se::dnn::VersionInfo version = version_or.ValueOrDie();
+      dnn_version = absl::StrCat(version.major_version(), ".",
+                                 version.minor_version(), ".", version.patch());
+    }
+  }
+  return tensorflow::AutotuneDeviceKey(description.name(), cc_major,
+                                       cc_minor, dnn_version);
+}
+
+// Returns the AutotuneCache key of a convolution: everything that the
+// instruction passes to cuDNN, but not its name or the algorithm it uses.
+StatusOr<string> AutotuneKey(const HloCustomCallInstruction& instr) {
+  TF_ASSIGN_OR_RETURN(CudnnConvBackendConfig backend_config,
+                      instr.backend_config<CudnnConvBackendConfig>());
+  backend_config.clear_algorithm();
+  backend_config.clear_tensor_ops_enabled();
+  string key = absl::StrCat(
+      "xla:", instr.custom_call_target(), ";",
+      ShapeUtil::HumanStringWithLayout(instr.shape().tuple_shapes(0)));
+  for (const HloInstruction* operand : instr.operands()) {
+    absl::StrAppend(&key, ";", ShapeUtil::HumanStringWithLayout(
+                                   operand->shape()));
+  }
+  absl::StrAppend(
+      &key, ";", window_util::ToString(instr.window()), ";",
+      ConvolutionDimensionNumbersToString(
+          instr.convolution_dimension_numbers()),
+      ";feature_group_count=", instr.feature_group_count(), ";",
+      backend_config.ShortDebugString());
+  return key;
+}
+
 }  // anonymous namespace
 
-// We could have caching here so that we don't redo this work for two identical
-// convolutions.  Unfortunately our cache key would have to be a tuple
-// containing the protos passed to this function, and we have no utility for
-// hashing protos.  We could write our own hash functions, but they'd silently
-// break if we ever added a field to one of the protos.  Perhaps we could hack
-// using the binary-encoded proto as the hash key, on the assumption that two
-// protos being binary-equal is a sufficient, if not necessary, condition for
-// proper equality.  But that would still leave us open to having unnecessary
-// cache misses and doing extra work.  Overall, caching doesn't seem worth the
-// trouble, but we may want to revisit this if we ever find a model where
-// caching would speed up compilation a lot.
+// The results are kept in the global tensorflow::AutotuneCache, so
+// identical convolutions are only autotuned once per kind of GPU, and not at
+// all if the cache is persistent and another process already did it.
 StatusOr<CudnnConvAlgorithmPicker::AutotuneResult>
 CudnnConvAlgorithmPicker::PickBestAlgorithm(HloCustomCallInstruction* instr) {
   // TODO(timshen): for now only check fp16. It can be expanded to other types,
@@ -152,6 +191,19 @@ CudnnConvAlgorithmPicker::PickBestAlgorithm(HloCustomCallInstruction* instr) {
   const bool cross_check_enabled =
       instr->shape().tuple_shapes(0).element_type() == xla::F16;
 
+  tensorflow::AutotuneCache* cache = tensorflow::AutotuneCache::Global();
+  const string device = AutotuneDevice(stream_exec_);
+  TF_ASSIGN_OR_RETURN(const string key, AutotuneKey(*instr));
+  tensorflow::AutotuneCacheEntry cached;
+  if (cache->Find(device, key, &cached)) {
+    VLOG(2) << "Using cached algorithm for " << instr->ToString() << ": "
+            << AlgorithmToString(AlgorithmDesc(cached.algorithm(),
+                                               cached.tensor_ops_enabled()))
+            << ", uses " << cached.scratch_bytes() << "B of scratch memory.";
+    return AutotuneResult{cached.algorithm(), cached.tensor_ops_enabled(),
+                          cached.scratch_bytes(), absl::ZeroDuration()};
+  }
+
   // Don't run this function concurrently on the same GPU.
   //
   // This is a bit of a hack and doesn't protect us against arbitrary concurrent
@@ -315,6 +367,14 @@ CudnnConvAlgorithmPicker::PickBestAlgorithm(HloCustomCallInstruction* instr) {
             << AlgorithmToString(best_result.algorithm()) << ", takes "
             << best_result.elapsed_time_in_ms() << "ms, and uses "
             << best_result_bytes_used << "B of scratch memory.";
+    tensorflow::AutotuneCacheEntry entry;
+    entry.set_device(device);
+    entry.set_key(key);
+    entry.set_algorithm(best_result.algorithm().algo_id());
+    entry.set_tensor_ops_enabled(best_result.algorithm().tensor_ops_enabled());
+    entry.set_algorithm_no_scratch(AlgorithmDesc().algo_id());
+    entry.set_scratch_bytes(best_result_bytes_used);
+    cache->Insert(entry);
     return AutotuneResult{best_result.algorithm().algo_id(),
                           best_result.algorithm().tensor_ops_enabled(),
                           best_result_bytes_used,
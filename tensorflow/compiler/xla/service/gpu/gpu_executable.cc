@@ -43,6 +43,31 @@ namespace {
 
 using tensorflow::tracing::ScopedAnnotation;
 
+// Shorter runs of capturable thunks aren't worth a graph launch.
+constexpr int64 kMinThunksPerGraph = 2;
+
+// The number of sets of buffer addresses for which an executable records
+// graphs. Callers whose addresses change on every run stop paying for the
+// recording once it is reached.
+constexpr int64 kMaxCapturedGraphs = 8;
+
+std::vector<std::pair<int64, int64>> FindGraphSegments(
+    const std::vector<Thunk*>& thunks) {
+  std::vector<std::pair<int64, int64>> segments;
+  int64 begin = 0;
+  while (begin < thunks.size()) {
+    int64 end = begin;
+    while (end < thunks.size() && thunks[end]->IsCapturable()) {
+      ++end;
+    }
+    if (end - begin >= kMinThunksPerGraph) {
+      segments.emplace_back(begin, end);
+    }
+    begin = end + 1;
+  }
+  return segments;
+}
+
 }  // namespace
 
 // Implementation note: HLO profiling is always enabled for GPU executables,
@@ -61,7 +86,72 @@ GpuExecutable::GpuExecutable(
       cubin_(cubin),
       compute_capability_(compute_capability),
       thunk_schedule_(std::move(thunk_schedule)),
-      assignment_(std::move(assignment)) {}
+      assignment_(std::move(assignment)),
+      graph_segments_(FindGraphSegments(thunk_schedule_->TotalOrder())) {}
+
+bool GpuExecutable::ShouldUseGraphs(se::StreamExecutor* executor,
+                                    bool do_profile) {
+  // Profiling times every thunk separately, and events recorded across
+  // streams would become part of the graphs, so we only record the simple
+  // single-stream case.
+  if (graph_segments_.empty() || do_profile ||
+      thunk_schedule_->StreamCount() != 1 ||
+      !hlo_module_->config().debug_options().xla_gpu_enable_graph_capture() ||
+      !executor->SupportsGraphCapture()) {
+    return false;
+  }
+  tensorflow::mutex_lock lock(graph_mutex_);
+  return !graph_capture_failed_;
+}
+
+Status GpuExecutable::ExecuteGraphSegment(
+    int64 segment, bool replay, const BufferAllocations& buffer_allocations,
+    se::Stream* stream, HloExecutionProfiler* profiler,
+    CapturedGraphs* graphs) {
+  se::StreamExecutor* executor = stream->parent();
+  if (replay) {
+    VLOG(2) << "Replaying the graph of thunks ["
+            << graph_segments_[segment].first << ", "
+            << graph_segments_[segment].second << ")";
+    return executor->LaunchGraph(stream, *(*graphs)[segment]);
+  }
+
+  const std::vector<Thunk*>& total_order = thunk_schedule_->TotalOrder();
+  for (int64 i = graph_segments_[segment].first;
+       i < graph_segments_[segment].second; ++i) {
+    TF_RETURN_IF_ERROR(total_order[i]->Initialize(*this, executor));
+  }
+  auto execute_segment = [&]() -> Status {
+    for (int64 i = graph_segments_[segment].first;
+         i < graph_segments_[segment].second; ++i) {
+      TF_RETURN_IF_ERROR(total_order[i]->ExecuteOnStream(buffer_allocations,
+                                                         stream, profiler));
+    }
+    return Status::OK();
+  };
+
+  // None of the recorded work runs until the graph is launched, so if the
+  // recording fails we can still run the thunks directly.
+  Status status = executor->BeginGraphCapture(stream);
+  if (status.ok()) {
+    Status execute_status = execute_segment();
+    auto graph_or = executor->EndGraphCapture(stream);
+    TF_RETURN_IF_ERROR(execute_status);
+    if (graph_or.ok()) {
+      graphs->push_back(std::move(graph_or.ValueOrDie()));
+      return executor->LaunchGraph(stream, *graphs->back());
+    }
+    status = graph_or.status();
+  }
+  LOG(WARNING) << "Disabling graph capture for " << module().name() << ": "
+               << status;
+  {
+    tensorflow::mutex_lock lock(graph_mutex_);
+    graph_capture_failed_ = true;
+  }
+  graphs->clear();
+  return execute_segment();
+}
 
 Status GpuExecutable::ExecuteThunks(
     const ServiceExecutableRunOptions* run_options,
@@ -105,8 +195,51 @@ Status GpuExecutable::ExecuteThunks(
   //     tracing is disabled.
   ScopedAnnotation top_level_annotation(hlo_module_->name(), "XLA GPU module");
 
+  // When graph capture is on, the runs of thunks in graph_segments_ are
+  // replayed from the graphs recorded for the current buffer addresses, or
+  // recorded if there are none yet.
+  CapturedGraphs* replayed_graphs = nullptr;
+  std::unique_ptr<CapturedGraphs> recorded_graphs;
+  CapturedGraphsKey graphs_key;
+  if (ShouldUseGraphs(executor, do_profile)) {
+    graphs_key.first = executor;
+    for (BufferAllocation::Index i = 0; i < assignment_->Allocations().size();
+         ++i) {
+      graphs_key.second.push_back(
+          buffer_allocations.GetDeviceAddress(i).opaque());
+    }
+    tensorflow::mutex_lock lock(graph_mutex_);
+    auto it = graphs_.find(graphs_key);
+    if (it != graphs_.end()) {
+      replayed_graphs = it->second.get();
+    } else if (graphs_.size() < kMaxCapturedGraphs) {
+      recorded_graphs = absl::make_unique<CapturedGraphs>();
+    }
+  }
+
   std::map<const Thunk*, std::unique_ptr<se::Event>> thunk_to_finish_event;
-  for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
+  const std::vector<Thunk*>& total_order = thunk_schedule_->TotalOrder();
+  int64 next_segment = 0;
+  for (int64 thunk_index = 0; thunk_index < total_order.size();
+       ++thunk_index) {
+    if ((replayed_graphs != nullptr || recorded_graphs != nullptr) &&
+        next_segment < graph_segments_.size() &&
+        graph_segments_[next_segment].first == thunk_index) {
+      TF_RETURN_IF_ERROR(ExecuteGraphSegment(
+          next_segment, replayed_graphs != nullptr, buffer_allocations,
+          main_stream, &profiler,
+          replayed_graphs != nullptr ? replayed_graphs
+                                     : recorded_graphs.get()));
+      // Run the remaining segments thunk by thunk if the recording failed.
+      if (recorded_graphs != nullptr && recorded_graphs->empty()) {
+        recorded_graphs.reset();
+      }
+      thunk_index = graph_segments_[next_segment].second - 1;
+      ++next_segment;
+      continue;
+    }
+
+    Thunk* thunk = total_order[thunk_index];
     // Annotate execution of this op if tracing was enabled when we started
     // running this module.  If tracing is enabled *while* we're running the
     // module, we won't get any data, but that's probably an OK trade-off.
@@ -144,6 +277,14 @@ Status GpuExecutable::ExecuteThunks(
             << stream_no;
     TF_RETURN_IF_ERROR(
         thunk->ExecuteOnStream(buffer_allocations, stream, &profiler));
+    if (do_profile) {
+      // The profiler waits for all streams around each HLO, so this measures
+      // how the work is balanced over the streams rather than how much of it
+      // overlaps.
+      hlo_execution_profile->AddCyclesTakenOnStream(
+          *hlo_module_->entry_computation(), stream_no,
+          hlo_execution_profile->GetCyclesTakenBy(*thunk->hlo_instruction()));
+    }
     if (thunk_schedule_->Depended(thunk)) {
       auto finish_event = absl::make_unique<se::Event>(main_stream->parent());
       finish_event->Init();
@@ -152,6 +293,12 @@ Status GpuExecutable::ExecuteThunks(
     }
   }
 
+  if (recorded_graphs != nullptr &&
+      recorded_graphs->size() == graph_segments_.size()) {
+    tensorflow::mutex_lock lock(graph_mutex_);
+    graphs_.emplace(std::move(graphs_key), std::move(recorded_graphs));
+  }
+
   main_stream->ThenWaitFor(&sub_streams);
   // Make sure kernels are completed before deallocating temporary buffers.
   // TODO(b/30100571): we could potentially postpone deallocating the temp
@@ -100,6 +100,27 @@ class GpuExecutable : public Executable {
   // computation. Uses points-to analysis from buffer assignment.
   const PointsToSet& GetRootPointsToSet() const;
 
+  // The graphs recorded for one executor and one set of buffer addresses: one
+  // graph per entry of graph_segments_, in the same order.
+  using CapturedGraphs =
+      std::vector<std::unique_ptr<se::internal::GraphExecInterface>>;
+  using CapturedGraphsKey =
+      std::pair<se::StreamExecutor*, std::vector<const void*>>;
+
+  // Returns whether this run of ExecuteThunks should replay or record graphs.
+  bool ShouldUseGraphs(se::StreamExecutor* executor, bool do_profile);
+
+  // Runs the thunks of graph_segments_[segment] on `stream`. If `replay` is
+  // true, it launches (*graphs)[segment]; otherwise it records the thunks into
+  // a new graph, appends it to `graphs`, and launches it. If the recording
+  // fails, the thunks are run directly, graph capture is disabled for this
+  // executable and `graphs` is cleared.
+  Status ExecuteGraphSegment(int64 segment, bool replay,
+                             const BufferAllocations& buffer_allocations,
+                             se::Stream* stream,
+                             HloExecutionProfiler* profiler,
+                             CapturedGraphs* graphs);
+
   using BufferAllocToDeviceMemoryMap =
       absl::flat_hash_map<BufferAllocation::Index, se::DeviceMemoryBase>;
 
@@ -137,6 +158,19 @@ class GpuExecutable : public Executable {
   // memory for every output/temp buffers.
   const std::unique_ptr<const BufferAssignment> assignment_;
 
+  // The [begin, end) ranges of thunk_schedule_->TotalOrder() that are recorded
+  // into graphs when graph capture is enabled: the maximal runs of at least
+  // two capturable thunks.
+  std::vector<std::pair<int64, int64>> graph_segments_;
+
+  // The recorded graphs. At most kMaxCapturedGraphs sets of buffer addresses
+  // are recorded per executable; runs with other addresses launch the thunks
+  // one by one.
+  tensorflow::mutex graph_mutex_;
+  std::map<CapturedGraphsKey, std::unique_ptr<CapturedGraphs>> graphs_
+      GUARDED_BY(graph_mutex_);
+  bool graph_capture_failed_ GUARDED_BY(graph_mutex_) = false;
+
   // Cache of module handles and constant buffer allocation maps used by
   // `ResolveConstantGlobals`.
   tensorflow::mutex module_handle_mutex_;
@@ -13,24 +13,30 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-#include <deque>
 #include <memory>
+#include <set>
+#include <tuple>
 #include <unordered_map>
 
 #include "tensorflow/compiler/xla/service/gpu/gpu_hlo_schedule.h"
 
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/xla/service/buffer_value.h"
+#include "tensorflow/compiler/xla/service/heap_simulator.h"
 #include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
 #include "tensorflow/compiler/xla/service/hlo_reachability.h"
 #include "tensorflow/compiler/xla/service/hlo_schedule.h"
+#include "tensorflow/compiler/xla/service/tuple_points_to_analysis.h"
 #include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 
 namespace xla {
 namespace gpu {
 
 namespace {
 
+using ::tensorflow::strings::HumanReadableNumBytes;
+
 // An HLO partial ordering based on the actual stream assignment and thunk
 // launch order.
 class GpuHloOrdering : public PredecessorHloOrdering {
@@ -148,20 +154,47 @@ GpuHloOrdering::GpuHloOrdering(
 // because C completes before D starts in stream 0, and E depends on D.
 // However, if the total order is A,B,D,C,E, then C and E can run
 // concurrently.
+//
+// When `stream_assignment` has run time estimates, the ready HLO that starts
+// the longest remaining path of estimated run time is launched first, and
+// ties are broken in breadth-first order. Launching the critical path early
+// lets the HLOs off the critical path overlap with it on the other streams,
+// instead of queuing in front of it.
 void BFSLaunchOrder(const HloComputation* computation,
+                    const StreamAssignment& stream_assignment,
                     std::vector<const HloInstruction*>* launch_order) {
+  // The estimated run time of the longest path from each HLO to the root, the
+  // HLO included.
+  std::unordered_map<const HloInstruction*, double> remaining_seconds;
+  const std::vector<HloInstruction*> post_order =
+      computation->MakeInstructionPostOrder();
+  for (auto it = post_order.rbegin(); it != post_order.rend(); ++it) {
+    const HloInstruction* hlo = *it;
+    double users_seconds = 0;
+    for (const HloInstruction* user : hlo->users()) {
+      users_seconds = std::max(users_seconds, remaining_seconds[user]);
+    }
+    remaining_seconds[hlo] =
+        stream_assignment.EstimatedSecondsForHlo(*hlo) + users_seconds;
+  }
+
   // This topological sort uses two data structures:
   // 1. `incoming_edge_count` which keeps track of the number of incoming
   // edges to each HLO;
-  // 2. `queue` which contains all HLOs with no incoming edges.
+  // 2. `ready` which contains all HLOs with no incoming edges, ordered by
+  // decreasing remaining time, and then by the time they became ready.
   //
-  // The sorting algorithm repeatedly pops the top from the queue and deletes
+  // The sorting algorithm repeatedly pops the top from `ready` and deletes
   // that HLO from the graph, making more HLOs incoming-edge free.
-  std::deque<const HloInstruction*> queue;
+  std::set<std::tuple<double, int64, const HloInstruction*>> ready;
+  int64 ready_count = 0;
+  auto make_ready = [&](const HloInstruction* hlo) {
+    ready.emplace(-remaining_seconds[hlo], ready_count++, hlo);
+  };
   std::unordered_map<const HloInstruction*, int64> incoming_edge_count;
   for (const auto& hlo : computation->instructions()) {
     if (hlo->operand_count() == 0) {
-      queue.push_back(hlo);
+      make_ready(hlo);
     } else {
       incoming_edge_count[hlo] =
           std::set<HloInstruction*>(hlo->operands().begin(),
@@ -170,19 +203,38 @@ void BFSLaunchOrder(const HloComputation* computation,
     }
   }
 
-  while (!queue.empty()) {
-    const HloInstruction* x = queue.front();
-    queue.pop_front();
+  while (!ready.empty()) {
+    const HloInstruction* x = std::get<2>(*ready.begin());
+    ready.erase(ready.begin());
     launch_order->push_back(x);
     for (const HloInstruction* y : x->users()) {
       --incoming_edge_count[y];
       if (incoming_edge_count[y] == 0) {
-        queue.push_back(y);
+        make_ready(y);
       }
     }
   }
 }
 
+LogicalBuffer::SizeFunction BufferSizeFunction(int64 pointer_size) {
+  return [pointer_size](const BufferValue& buffer) {
+    return ShapeUtil::ByteSizeOf(buffer.shape(), pointer_size);
+  };
+}
+
+// Returns the peak memory of running the HLOs of `computation` one at a time
+// in `launch_order`, assuming no fragmentation.
+StatusOr<int64> PeakMemoryForLaunchOrder(
+    const HloComputation& computation,
+    const std::vector<const HloInstruction*>& launch_order,
+    int64 pointer_size) {
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<TuplePointsToAnalysis> points_to_analysis,
+                      TuplePointsToAnalysis::Run(computation.parent()));
+  return HeapSimulator::MinimumMemoryForComputation(
+      computation, HloInstructionSequence(launch_order), *points_to_analysis,
+      BufferSizeFunction(pointer_size));
+}
+
 }  // end namespace
 
 GpuHloSchedule::GpuHloSchedule() {}
@@ -198,16 +250,14 @@ StatusOr<std::unique_ptr<GpuHloSchedule>> GpuHloSchedule::Build(
   if (stream_assignment.StreamCount() == 1) {
     // All kernels are launched on a single stream, so there's no loss of
     // concurrency by optimizing for minimal memory usage.
-    TF_ASSIGN_OR_RETURN(
-        HloInstructionSequence sequence,
-        ScheduleComputation(
-            *entry_computation, [pointer_size](const BufferValue& buffer) {
-              return ShapeUtil::ByteSizeOf(buffer.shape(), pointer_size);
-            }));
+    TF_ASSIGN_OR_RETURN(HloInstructionSequence sequence,
+                        ScheduleComputation(*entry_computation,
+                                            BufferSizeFunction(pointer_size)));
     schedule->thunk_launch_order_ = sequence.instructions();
   } else {
     // BFS tends to increase concurrency, but also increases memory usage.
-    BFSLaunchOrder(entry_computation, &schedule->thunk_launch_order_);
+    BFSLaunchOrder(entry_computation, stream_assignment,
+                   &schedule->thunk_launch_order_);
   }
 
   schedule->hlo_ordering_ = absl::make_unique<GpuHloOrdering>(
@@ -216,5 +266,41 @@ StatusOr<std::unique_ptr<GpuHloSchedule>> GpuHloSchedule::Build(
   return std::move(schedule);
 }
 
+/* static */
+StatusOr<std::unique_ptr<GpuHloSchedule>> GpuHloSchedule::Build(
+    const HloModule& module, StreamAssignment* stream_assignment,
+    int64 pointer_size, int64 memory_limit_bytes) {
+  const HloComputation* entry_computation = module.entry_computation();
+  if (memory_limit_bytes > 0 && stream_assignment->StreamCount() > 1) {
+    std::vector<const HloInstruction*> bfs_order;
+    BFSLaunchOrder(entry_computation, *stream_assignment, &bfs_order);
+    TF_ASSIGN_OR_RETURN(
+        const int64 bfs_memory,
+        PeakMemoryForLaunchOrder(*entry_computation, bfs_order, pointer_size));
+    VLOG(2) << "Min-memory of the concurrent launch order: "
+            << HumanReadableNumBytes(bfs_memory);
+    if (bfs_memory > memory_limit_bytes) {
+      TF_ASSIGN_OR_RETURN(
+          HloInstructionSequence sequence,
+          ScheduleComputation(*entry_computation,
+                              BufferSizeFunction(pointer_size)));
+      TF_ASSIGN_OR_RETURN(const int64 sequential_memory,
+                          PeakMemoryForLaunchOrder(*entry_computation,
+                                                   sequence.instructions(),
+                                                   pointer_size));
+      if (sequential_memory < bfs_memory) {
+        VLOG(1) << "Running " << module.name() << " on a single stream: "
+                << "the concurrent launch order needs at least "
+                << HumanReadableNumBytes(bfs_memory) << ", more than the "
+                << HumanReadableNumBytes(memory_limit_bytes)
+                << " limit, and the sequential one needs "
+                << HumanReadableNumBytes(sequential_memory);
+        stream_assignment->AssignAllToMainStream();
+      }
+    }
+  }
+  return Build(module, *stream_assignment, pointer_size);
+}
+
 }  // namespace gpu
 }  // namespace xla
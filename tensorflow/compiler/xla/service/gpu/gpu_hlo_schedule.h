@@ -44,6 +44,18 @@ class GpuHloSchedule {
       const HloModule& module, const StreamAssignment& stream_assignment,
       int64 pointer_size);
 
+  // Same as above, but trades concurrency for memory when needed: if
+  // `memory_limit_bytes` is positive, and the concurrency-maximizing launch
+  // order used for several streams is estimated to need more memory than
+  // that, and a memory-minimizing order needs less, all HLOs are moved onto
+  // the main stream of `stream_assignment` and launched in the
+  // memory-minimizing order. The memory estimates come from HeapSimulator
+  // and assume the HLOs run one at a time in launch order, so they are lower
+  // bounds for several streams.
+  static StatusOr<std::unique_ptr<GpuHloSchedule>> Build(
+      const HloModule& module, StreamAssignment* stream_assignment,
+      int64 pointer_size, int64 memory_limit_bytes);
+
   // Returns the total order of thunk launches, represented in terms of HLO
   // instructions.
   const std::vector<const HloInstruction*>& ThunkLaunchOrder() const {
@@ -401,5 +401,92 @@ TEST_F(GpuHloScheduleTest, LatticeMatMul) {
   }
 }
 
+// Test that the launch order starts the longest path of estimated run time
+// first, so that the other streams can overlap with it.
+TEST_F(GpuHloScheduleTest, CriticalPathFirst) {
+  HloComputation::Builder builder("entry_computation");
+  HloInstruction* x = builder.AddInstruction(HloInstruction::CreateParameter(
+      /*parameter_number=*/0, f32_2x2_, /*name=*/"x"));
+  HloInstruction* y = builder.AddInstruction(HloInstruction::CreateParameter(
+      /*parameter_number=*/1, f32_2x2_, /*name=*/"y"));
+  HloInstruction* short_add = builder.AddInstruction(
+      HloInstruction::CreateBinary(f32_2x2_, HloOpcode::kAdd, x, y));
+  HloInstruction* long_mul1 = builder.AddInstruction(
+      HloInstruction::CreateBinary(f32_2x2_, HloOpcode::kMultiply, x, y));
+  HloInstruction* long_mul2 = builder.AddInstruction(
+      HloInstruction::CreateBinary(f32_2x2_, HloOpcode::kMultiply, long_mul1,
+                                   y));
+  HloInstruction* root = builder.AddInstruction(HloInstruction::CreateBinary(
+      f32_2x2_, HloOpcode::kAdd, short_add, long_mul2));
+
+  auto module = CreateNewModule();
+  module->AddEntryComputation(builder.Build(root));
+
+  StreamAssignment streams;
+  streams.AssignStreamToHlo(short_add, 0);
+  streams.AssignStreamToHlo(long_mul1, 1);
+  streams.AssignStreamToHlo(long_mul2, 1);
+  streams.AssignStreamToHlo(root, 0);
+
+  // Without estimates, the launch order is breadth-first.
+  EXPECT_EQ(RemoveHlo(BuildGpuHloSchedule(*module, streams)->ThunkLaunchOrder(),
+                      {x, y}),
+            HloVec({short_add, long_mul1, long_mul2, root}));
+
+  streams.SetEstimatedSecondsForHlo(short_add, 1e-6);
+  streams.SetEstimatedSecondsForHlo(long_mul1, 1e-4);
+  streams.SetEstimatedSecondsForHlo(long_mul2, 1e-4);
+  streams.SetEstimatedSecondsForHlo(root, 1e-6);
+  EXPECT_EQ(RemoveHlo(BuildGpuHloSchedule(*module, streams)->ThunkLaunchOrder(),
+                      {x, y}),
+            HloVec({long_mul1, long_mul2, short_add, root}));
+}
+
+// Tests that concurrent GEMMs are moved onto one stream when their launch
+// order needs more memory than the limit and a sequential order needs less.
+TEST_F(GpuHloScheduleTest, MemoryLimitSerializesConcurrentMatMuls) {
+  HloComputation::Builder builder("entry_computation");
+  HloInstruction* x = builder.AddInstruction(HloInstruction::CreateParameter(
+      /*parameter_number=*/0, f32_2x2_, /*name=*/"x"));
+  HloInstruction* z = builder.AddInstruction(HloInstruction::CreateParameter(
+      /*parameter_number=*/1, f32_2x2_, /*name=*/"z"));
+  // Four independent chains of three dots each, summed up at the end. The
+  // breadth-first launch order keeps the intermediate results of all chains
+  // alive at the same time.
+  HloInstruction* sum = nullptr;
+  for (int i = 0; i < 4; ++i) {
+    HloInstruction* dot = x;
+    for (int j = 0; j < 3; ++j) {
+      dot = builder.AddInstruction(CreateCanonicalDot(f32_2x2_, dot, z));
+    }
+    sum = sum == nullptr
+              ? dot
+              : builder.AddInstruction(HloInstruction::CreateBinary(
+                    f32_2x2_, HloOpcode::kAdd, sum, dot));
+  }
+  auto module = CreateNewModule();
+  module->AddEntryComputation(builder.Build(sum));
+
+  std::unique_ptr<StreamAssignment> streams = AssignStreams(*module);
+  EXPECT_GT(streams->StreamCount(), 1);
+
+  // A generous limit keeps the concurrent schedule.
+  EXPECT_TRUE(GpuHloSchedule::Build(*module, streams.get(), /*pointer_size=*/8,
+                                    /*memory_limit_bytes=*/1 << 20)
+                  .ok());
+  EXPECT_GT(streams->StreamCount(), 1);
+
+  std::unique_ptr<GpuHloSchedule> schedule =
+      GpuHloSchedule::Build(*module, streams.get(), /*pointer_size=*/8,
+                            /*memory_limit_bytes=*/1)
+          .ConsumeValueOrDie();
+  EXPECT_EQ(1, streams->StreamCount());
+  for (const HloInstruction* hlo : schedule->ThunkLaunchOrder()) {
+    if (streams->HasStreamAssigned(*hlo)) {
+      EXPECT_EQ(0, streams->StreamNumberForHlo(*hlo));
+    }
+  }
+}
+
 }  // namespace gpu
 }  // namespace xla
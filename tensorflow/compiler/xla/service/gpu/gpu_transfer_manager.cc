@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/gpu/gpu_transfer_manager.h"
 
+#include <cstring>
 #include <string>
 #include <utility>
 #include <vector>
@@ -77,19 +78,16 @@ Status GpuTransferManager::EnqueueBuffersToInfeed(
   gpu::InfeedManager* infeed_manager = gpu::GetOrCreateInfeedManager();
   se::Stream* stream = infeed_manager->GetStream(executor);
 
-  // TODO(b/30467474): Since this stream is shared across different
-  // infeed requests, blocking on the stream might be
-  // heavy-handed. Figure out if finer-grained acknowledgement is
-  // possible.
-  Status block_status = stream->BlockHostUntilDone();
-  if (!block_status.ok()) {
-    return InternalError("Failed to complete data transfer on stream %p: %s",
-                         stream, block_status.error_message());
+  // The copies are still in flight; the infeed thunk waits for the ready
+  // events of the buffers on the device rather than the host waiting here.
+  if (!stream->ok()) {
+    return InternalError("Failed to enqueue data transfer on stream %p",
+                         stream);
   }
 
   infeed_manager->EnqueueDestination(std::move(buffers));
 
-  VLOG(2) << "Infeed data transferred";
+  VLOG(2) << "Infeed data enqueued";
 
   return Status::OK();
 }
@@ -110,8 +108,14 @@ StatusOr<InfeedBuffer> GpuTransferManager::TransferBufferToInfeedInternal(
     return InternalError("Failed to obtain a stream");
   }
 
-  InfeedBuffer buffer(executor, size);
-  stream->ThenMemcpy(buffer.device_memory(), source, size);
+  // Stage the data in pinned memory, so that the copy to the device runs
+  // asynchronously and the caller may free 'source' when we return.
+  TF_ASSIGN_OR_RETURN(XfeedBufferHandle xfeed_buffer,
+                      infeed_manager->buffer_pool()->Acquire(executor, size));
+  InfeedBuffer buffer(std::move(xfeed_buffer));
+  std::memcpy(buffer.host_memory(), source, size);
+  stream->ThenMemcpy(buffer.device_memory(), buffer.host_memory(), size)
+      .ThenRecordEvent(buffer.ready_event());
 
   VLOG(2) << "Queued infeed data on stream " << stream;
 
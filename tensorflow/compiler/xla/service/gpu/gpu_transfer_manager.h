@@ -45,13 +45,13 @@ class GpuTransferManager : public GenericTransferManager {
                                     MutableBorrowingLiteral literal) override;
 
  private:
-  // Initiates the infeed data transfers. InfeedBuffer->Done() must be
-  // called to clean up the memory allocated for InfeedBuffer.
+  // Initiates the infeed data transfers. The returned buffer's ready event
+  // is recorded once its data is on the device.
   StatusOr<InfeedBuffer> TransferBufferToInfeedInternal(
       se::StreamExecutor* executor, int64 size, const void* source);
 
-  // Enqueues infeed data buffers with the infeed manager after their
-  // transfer completes.
+  // Enqueues infeed data buffers with the infeed manager. Their transfers
+  // may still be in flight.
   Status EnqueueBuffersToInfeed(se::StreamExecutor* executor,
                                 ShapeTree<InfeedBuffer> buffers);
 
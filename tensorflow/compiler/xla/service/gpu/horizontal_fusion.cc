@@ -0,0 +1,151 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/horizontal_fusion.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/hlo_reachability.h"
+#include "tensorflow/compiler/xla/service/llvm_ir/kernel_tiling.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+// The maximum number of fusions merged into one kernel. Every output adds a
+// branch to each thread of the kernel.
+constexpr int64 kMaxFusedOutputs = 32;
+
+// The parameter space on the GPU device is limited, so we cap the number of
+// distinct operands and outputs of a fused kernel. This is the same
+// conservative limit as in VariadicOpSplitter.
+constexpr int64 kMaxParameters = 128;
+
+// Kernels with more elements than this run long enough for their launch
+// overhead not to matter, and are better emitted on their own, possibly
+// unrolled.
+constexpr int64 kMaxElementsPerOutput = 1 << 20;
+
+bool IsHorizontalFusionCandidate(const HloInstruction& instr) {
+  if (instr.opcode() != HloOpcode::kFusion ||
+      instr.fusion_kind() != HloInstruction::FusionKind::kLoop ||
+      !ShapeUtil::IsArray(instr.shape()) ||
+      ShapeUtil::IsZeroElementArray(instr.shape()) ||
+      ShapeUtil::ElementsIn(instr.shape()) > kMaxElementsPerOutput) {
+    return false;
+  }
+  // Fusions without users can't be turned into an output of a multi-output
+  // fusion.
+  if (instr.user_count() == 0) {
+    return false;
+  }
+  // Dynamic-update-slice roots may be emitted in place.
+  if (instr.fused_expression_root()->opcode() ==
+      HloOpcode::kDynamicUpdateSlice) {
+    return false;
+  }
+  // Transposes are emitted with tiles in shared memory.
+  return absl::c_none_of(instr.operands(), [&](const HloInstruction* operand) {
+    return llvm_ir::FindTranspose021(operand->shape(), instr.shape())
+        .has_value();
+  });
+}
+
+// Returns a group of at least two candidate fusions of `computation` that
+// don't depend on each other, or an empty vector if there is none.
+std::vector<HloInstruction*> FindFusionGroup(HloComputation* computation) {
+  std::vector<HloInstruction*> candidates;
+  for (HloInstruction* instr : computation->MakeInstructionPostOrder()) {
+    if (IsHorizontalFusionCandidate(*instr)) {
+      candidates.push_back(instr);
+    }
+  }
+  if (candidates.size() < 2) {
+    return {};
+  }
+
+  // Every thread of the fused kernel handles one element of each output, so
+  // group fusions of similar sizes to keep few threads idle.
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const HloInstruction* a, const HloInstruction* b) {
+                     return ShapeUtil::ElementsIn(a->shape()) >
+                            ShapeUtil::ElementsIn(b->shape());
+                   });
+
+  std::unique_ptr<HloReachabilityMap> reachability =
+      computation->ComputeReachability();
+  for (int64 i = 0; i < candidates.size(); ++i) {
+    std::vector<HloInstruction*> group = {candidates[i]};
+    absl::flat_hash_set<const HloInstruction*> operands(
+        candidates[i]->operands().begin(), candidates[i]->operands().end());
+    for (int64 j = i + 1;
+         j < candidates.size() && group.size() < kMaxFusedOutputs; ++j) {
+      HloInstruction* candidate = candidates[j];
+      if (absl::c_any_of(group, [&](const HloInstruction* member) {
+            return reachability->IsConnected(member, candidate);
+          })) {
+        continue;
+      }
+      absl::flat_hash_set<const HloInstruction*> new_operands = operands;
+      new_operands.insert(candidate->operands().begin(),
+                          candidate->operands().end());
+      if (new_operands.size() + group.size() + 1 > kMaxParameters) {
+        continue;
+      }
+      operands = std::move(new_operands);
+      group.push_back(candidate);
+    }
+    if (group.size() > 1) {
+      return group;
+    }
+  }
+  return {};
+}
+
+}  // namespace
+
+StatusOr<bool> GpuHorizontalFusion::Run(HloModule* module) {
+  bool changed = false;
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    // Merging a group adds dependencies between its operands and users, so
+    // reachability is recomputed before looking for the next group. The
+    // merged fusion is a multi-output fusion and no longer a candidate, so
+    // this terminates.
+    for (std::vector<HloInstruction*> group = FindFusionGroup(computation);
+         !group.empty(); group = FindFusionGroup(computation)) {
+      HloInstruction* fusion = group[0];
+      VLOG(2) << "Horizontally fusing " << group.size() << " fusions into "
+              << fusion->name();
+      for (int64 i = 1; i < group.size(); ++i) {
+        fusion->MergeFusionInstructionIntoMultiOutput(group[i]);
+      }
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,45 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HORIZONTAL_FUSION_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HORIZONTAL_FUSION_H_
+
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+
+namespace xla {
+namespace gpu {
+
+// An HLO pass that merges small loop fusions which don't depend on each other
+// into multi-output loop fusions, so that they run in one kernel launch
+// instead of one launch each. This targets graphs such as optimizer weight
+// updates, which consist of many independent elementwise kernels that are too
+// small to amortize their launch overhead.
+//
+// The outputs of a horizontally fused instruction may have different shapes.
+// IrEmitterUnnested launches enough threads for the largest output, and every
+// thread computes the element at its linear index of each output that is
+// large enough to have one.
+class GpuHorizontalFusion : public HloModulePass {
+ public:
+  absl::string_view name() const override { return "horizontal-fusion"; }
+
+  StatusOr<bool> Run(HloModule* module) override;
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HORIZONTAL_FUSION_H_
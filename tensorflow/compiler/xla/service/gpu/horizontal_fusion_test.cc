@@ -0,0 +1,129 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/horizontal_fusion.h"
+
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/test_helpers.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+namespace op = xla::testing::opcode_matchers;
+
+class HorizontalFusionTest : public HloTestBase {};
+
+TEST_F(HorizontalFusionTest, FusesIndependentLoopFusions) {
+  auto module = ParseHloString(R"(
+HloModule FusesIndependentLoopFusions
+
+fused_computation.1 {
+  p0.1 = f32[1024]{0} parameter(0)
+  p1.1 = f32[1024]{0} parameter(1)
+  ROOT add.1 = f32[1024]{0} add(p0.1, p1.1)
+}
+
+fused_computation.2 {
+  p0.2 = f16[32,16]{1,0} parameter(0)
+  p1.2 = f16[32,16]{1,0} parameter(1)
+  ROOT multiply.2 = f16[32,16]{1,0} multiply(p0.2, p1.2)
+}
+
+ENTRY entry {
+  arg.0 = f32[1024]{0} parameter(0)
+  arg.1 = f32[1024]{0} parameter(1)
+  arg.2 = f16[32,16]{1,0} parameter(2)
+  arg.3 = f16[32,16]{1,0} parameter(3)
+  fusion.1 = f32[1024]{0} fusion(arg.0, arg.1), kind=kLoop,
+    calls=fused_computation.1
+  fusion.2 = f16[32,16]{1,0} fusion(arg.2, arg.3), kind=kLoop,
+    calls=fused_computation.2
+  ROOT tuple = (f32[1024]{0}, f16[32,16]{1,0}) tuple(fusion.1, fusion.2)
+})")
+                    .ValueOrDie();
+  EXPECT_TRUE(GpuHorizontalFusion().Run(module.get()).ValueOrDie());
+
+  const HloInstruction* root = module->entry_computation()->root_instruction();
+  EXPECT_THAT(root, op::Tuple(op::GetTupleElement(op::Fusion()),
+                              op::GetTupleElement(op::Fusion())));
+  const HloInstruction* fusion = root->operand(0)->operand(0);
+  EXPECT_EQ(fusion, root->operand(1)->operand(0));
+  EXPECT_TRUE(fusion->IsMultiOutputFusion());
+  EXPECT_EQ(4, fusion->operand_count());
+  EXPECT_THAT(fusion->fused_expression_root(),
+              op::Tuple(op::Add(), op::Multiply()));
+}
+
+TEST_F(HorizontalFusionTest, DoesNotFuseDependentLoopFusions) {
+  auto module = ParseHloString(R"(
+HloModule DoesNotFuseDependentLoopFusions
+
+fused_computation.1 {
+  p0.1 = f32[1024]{0} parameter(0)
+  p1.1 = f32[1024]{0} parameter(1)
+  ROOT add.1 = f32[1024]{0} add(p0.1, p1.1)
+}
+
+fused_computation.2 {
+  p0.2 = f32[1024]{0} parameter(0)
+  ROOT negate.2 = f32[1024]{0} negate(p0.2)
+}
+
+ENTRY entry {
+  arg.0 = f32[1024]{0} parameter(0)
+  arg.1 = f32[1024]{0} parameter(1)
+  fusion.1 = f32[1024]{0} fusion(arg.0, arg.1), kind=kLoop,
+    calls=fused_computation.1
+  fusion.2 = f32[1024]{0} fusion(fusion.1), kind=kLoop,
+    calls=fused_computation.2
+  ROOT tuple = (f32[1024]{0}, f32[1024]{0}) tuple(fusion.1, fusion.2)
+})")
+                    .ValueOrDie();
+  EXPECT_FALSE(GpuHorizontalFusion().Run(module.get()).ValueOrDie());
+}
+
+TEST_F(HorizontalFusionTest, DoesNotFuseLargeLoopFusions) {
+  auto module = ParseHloString(R"(
+HloModule DoesNotFuseLargeLoopFusions
+
+fused_computation.1 {
+  p0.1 = f32[2048,1024]{1,0} parameter(0)
+  ROOT negate.1 = f32[2048,1024]{1,0} negate(p0.1)
+}
+
+fused_computation.2 {
+  p0.2 = f32[2048,1024]{1,0} parameter(0)
+  ROOT exp.2 = f32[2048,1024]{1,0} exponential(p0.2)
+}
+
+ENTRY entry {
+  arg.0 = f32[2048,1024]{1,0} parameter(0)
+  fusion.1 = f32[2048,1024]{1,0} fusion(arg.0), kind=kLoop,
+    calls=fused_computation.1
+  fusion.2 = f32[2048,1024]{1,0} fusion(arg.0), kind=kLoop,
+    calls=fused_computation.2
+  ROOT tuple = (f32[2048,1024]{1,0}, f32[2048,1024]{1,0})
+    tuple(fusion.1, fusion.2)
+})")
+                    .ValueOrDie();
+  EXPECT_FALSE(GpuHorizontalFusion().Run(module.get()).ValueOrDie());
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
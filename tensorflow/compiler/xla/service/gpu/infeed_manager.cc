@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/infeed_manager.h"
 
 #include "absl/memory/memory.h"
+#include "tensorflow/compiler/xla/legacy_flags/debug_options_flags.h"
 
 namespace xla {
 namespace gpu {
@@ -38,7 +39,8 @@ se::Stream* InfeedManager::GetStream(se::StreamExecutor* executor) {
 }
 
 InfeedManager* GetOrCreateInfeedManager() {
-  static InfeedManager* manager = new InfeedManager;
+  static InfeedManager* manager = new InfeedManager(
+      legacy_flags::GetDebugOptionsFromFlags().xla_gpu_xfeed_buffer_depth());
   return manager;
 }
 
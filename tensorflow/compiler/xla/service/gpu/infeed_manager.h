@@ -20,6 +20,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_INFEED_MANAGER_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_INFEED_MANAGER_H_
 
+#include "tensorflow/compiler/xla/service/gpu/xfeed_buffer_pool.h"
 #include "tensorflow/compiler/xla/service/gpu/xfeed_queue.h"
 #include "tensorflow/compiler/xla/shape_tree.h"
 #include "tensorflow/compiler/xla/types.h"
@@ -35,41 +36,55 @@ namespace gpu {
 // Current limitations:
 // * Does not handle multiple devices/replicas.
 //
-// * Buffer space on GPU is allocated on every infeed enqueue request,
-// and it does not handle the case when it runs out of
-// memory. Potential solution is to pre-allocate a fixed amount of
-// memory and block when that memory is full.
-
-// Defines an infeed buffer that is passed to the runtime by
-// the client. The client manages the memory of the buffer.
+// * Device buffers are reused, but more of them are allocated whenever
+// the client runs ahead of the computation, and it does not handle the
+// case when it runs out of memory. Potential solution is to block when a
+// fixed amount of memory is in use.
+
+// Defines an infeed buffer that is passed to the runtime by the client. The
+// client copies the data into it on the host-to-device stream and records
+// ready_event() once the copy is enqueued. The buffer returns to the pool of
+// the infeed manager when it is destroyed, so it must outlive the copies out
+// of it.
 class InfeedBuffer {
  public:
   InfeedBuffer() = default;
-  InfeedBuffer(se::StreamExecutor* executor, int64 length)
-      : device_memory_(executor, executor->AllocateArray<uint8>(length)),
-        length_(length) {
-    CHECK(!device_memory_->is_null());
-  }
+  explicit InfeedBuffer(XfeedBufferHandle buffer)
+      : buffer_(std::move(buffer)) {}
+
+  int64 length() const { return buffer_->length(); }
+
+  se::DeviceMemoryBase* device_memory() { return buffer_->device_memory(); }
 
-  int64 length() const { return length_; }
+  // Pinned host memory that stages the copy to device_memory().
+  void* host_memory() { return buffer_->host_memory(); }
 
-  se::DeviceMemoryBase* device_memory() { return device_memory_.ptr(); }
+  // Event that is ready once device_memory() holds the data.
+  se::Event* ready_event() { return buffer_->event(); }
 
  private:
-  se::ScopedDeviceMemory<uint8> device_memory_;
-  int64 length_;
+  XfeedBufferHandle buffer_;
 };
 
 // Client-side class used to enqueue infeed buffers.
 class InfeedManager : public XfeedQueue<ShapeTree<InfeedBuffer>> {
  public:
+  // 'buffer_depth' is the number of device buffers of each size kept for
+  // reuse.
+  explicit InfeedManager(int64 buffer_depth) : buffer_pool_(buffer_depth) {}
+
   // Returns a cached stream associated with an executor. Allocates a
   // new stream on the first invocation. On subsequent invocations, if
   // the cached executor is not the same as the requested executor,
   // returns null.
   se::Stream* GetStream(se::StreamExecutor* executor);
 
+  // Returns the pool that infeed buffers are allocated from.
+  XfeedBufferPool* buffer_pool() { return &buffer_pool_; }
+
  private:
+  XfeedBufferPool buffer_pool_;
+
   // Mutex for serializing the creation of host_to_device_stream_.
   tensorflow::mutex host_to_device_stream_mu_;
 
@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/compiler/xla/service/gpu/infeed_thunk.h"
+
+#include <memory>
+
 #include "tensorflow/compiler/xla/service/gpu/hlo_execution_profiler.h"
 #include "tensorflow/compiler/xla/service/gpu/infeed_manager.h"
 #include "tensorflow/compiler/xla/util.h"
@@ -53,8 +56,9 @@ Status InfeedThunk::ExecuteOnStream(const BufferAllocations& buffer_allocations,
 
             InfeedBuffer* buffer =
                 infeed_buffers.mutable_element(ShapeIndexView(index, 1));
-            stream->ThenMemcpy(&tuple_element_address,
-                               *(buffer->device_memory()), buffer->length());
+            stream->ThenWaitFor(buffer->ready_event())
+                .ThenMemcpy(&tuple_element_address, *(buffer->device_memory()),
+                            buffer->length());
             tuple_element_addresses->push_back(tuple_element_address.opaque());
             return;
           }
@@ -93,13 +97,17 @@ Status InfeedThunk::ExecuteOnStream(const BufferAllocations& buffer_allocations,
       buffer_allocations.GetDeviceAddress(infeed_slices_.element({}));
   stream->ThenMemcpy(&top_level_address, infeed_addresses, 2 * sizeof(void*));
 
-  Status block_status = stream->BlockHostUntilDone();
-  if (!block_status.ok()) {
-    return InternalError("Failed to complete data transfer on stream %p: %s",
-                         stream, block_status.error_message());
+  // Rather than blocking the host until the copies are done, return the
+  // infeed buffers to their pool from a callback that runs after them.
+  auto done_buffers =
+      std::make_shared<ShapeTree<InfeedBuffer>>(std::move(infeed_buffers));
+  stream->ThenDoHostCallback([done_buffers]() {});
+  if (!stream->ok()) {
+    return InternalError("Failed to enqueue data transfer on stream %p",
+                         stream);
   }
 
-  VLOG(2) << "Infeeding to GPU complete";
+  VLOG(2) << "Infeeding to GPU enqueued";
   return Status::OK();
 }
 
@@ -148,6 +148,45 @@ bool ImplementedAsLibraryCall(const HloInstruction& hlo) {
          IsCustomCallToDnnConvolution(hlo);
 }
 
+namespace {
+
+// Returns true if the dimensions to keep, in the order of the layout, are a
+// contiguous group starting at the minor-most dimension followed by a
+// contiguous group of reduced dimensions and a contiguous group of kept
+// dimensions, i.e. if the input can be bitcast to [depth, height, width] with
+// the height being reduced.
+bool IsBatchedColumnReduction(const Shape& input_shape,
+                              absl::Span<const int64> dims_to_reduce) {
+  const auto minor_to_major = LayoutUtil::MinorToMajor(input_shape);
+  const int64 rank = minor_to_major.size();
+  auto is_reduced = [&](int64 i) {
+    return std::count(dims_to_reduce.begin(), dims_to_reduce.end(),
+                      minor_to_major[i]) > 0;
+  };
+  int64 i = 0;
+  while (i < rank && !is_reduced(i)) {
+    ++i;
+  }
+  if (i == 0) {
+    // The minor-most dimension is reduced.
+    return false;
+  }
+  const int64 first_reduced = i;
+  while (i < rank && is_reduced(i)) {
+    ++i;
+  }
+  if (i == first_reduced || i == rank) {
+    // There is no major group of dimensions to keep.
+    return false;
+  }
+  while (i < rank && !is_reduced(i)) {
+    ++i;
+  }
+  return i == rank;
+}
+
+}  // namespace
+
 bool IsReductionToVector(const HloInstruction& reduce) {
   if (HloOpcode::kReduce != reduce.opcode()) {
     return false;
@@ -160,8 +199,9 @@ bool IsReductionToVector(const HloInstruction& reduce) {
       dims_to_keep.push_back(dim);
     }
   }
-  return LayoutUtil::AreDimensionsConsecutive(input->shape().layout(),
-                                              dims_to_keep) &&
+  return (LayoutUtil::AreDimensionsConsecutive(input->shape().layout(),
+                                               dims_to_keep) ||
+          IsBatchedColumnReduction(input->shape(), reduce.dimensions())) &&
          ShapeUtil::Equal(reduce.shape(), ShapeUtil::FilterDimensions(
                                               [&dims_to_keep](int64 dim) {
                                                 return std::count(
@@ -171,6 +211,21 @@ bool IsReductionToVector(const HloInstruction& reduce) {
                                               input->shape()));
 }
 
+bool IsHorizontalLoopFusion(const HloInstruction& fusion) {
+  if (fusion.opcode() != HloOpcode::kFusion ||
+      fusion.fusion_kind() != HloInstruction::FusionKind::kLoop ||
+      !fusion.IsMultiOutputFusion()) {
+    return false;
+  }
+  const Shape& first_shape = ShapeUtil::GetSubshape(fusion.shape(), {0});
+  for (const Shape& shape : fusion.shape().tuple_shapes()) {
+    if (!ShapeUtil::SameDimensions(shape, first_shape)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 // This emits a device-side call to
 // "i32 vprintf(i8* fmt, arguments_type* arguments)" in the driver; see
 // http://docs.nvidia.com/cuda/ptx-writers-guide-to-interoperability/index.html#system-calls
@@ -135,8 +135,18 @@ bool IsCustomCallToDnnConvolution(const HloInstruction& hlo);
 // or cuDNN convolution.
 bool ImplementedAsLibraryCall(const HloInstruction& hlo);
 
+// Returns true if `reduce` is a kReduce whose dimensions to keep are
+// contiguous in the input layout, or form two contiguous groups that include
+// the minor-most dimension and surround the reduced dimensions, e.g. reducing
+// dimension 1 of a [a, r, b]{2,1,0} array. These reductions are emitted as
+// row or (batched) column reductions.
 bool IsReductionToVector(const HloInstruction& reduce);
 
+// Returns true if `fusion` is a multi-output loop fusion whose outputs don't
+// all have the same dimensions, as built by GpuHorizontalFusion. Such fusions
+// can't be emitted as a loop over the index space of a single output.
+bool IsHorizontalLoopFusion(const HloInstruction& fusion);
+
 // Emits call to "vprintf" with given format and arguments.
 llvm::Value* EmitPrintf(absl::string_view fmt,
                         absl::Span<llvm::Value* const> arguments,
@@ -696,6 +696,10 @@ Status IrEmitterUnnested::HandleFusion(HloInstruction* fusion) {
 
   CHECK_EQ(fusion->fusion_kind(), HloInstruction::FusionKind::kLoop);
 
+  if (IsHorizontalLoopFusion(*fusion)) {
+    return EmitHorizontalLoopFusion(fusion);
+  }
+
   if (CheckAndEmitHloWithTile021(fusion)) {
     return Status::OK();
   }
@@ -952,8 +956,43 @@ Status IrEmitterUnnested::EmitReductionToScalar(
       .EmitLoop(IrName(reduce), index_ty);
 }
 
+namespace {
+
+// Reads thread_idx.x and converts it to a (y,x) coordinate, assuming that the
+// thread lives within a square tile of size tile_size (so thread blocks are of
+// size tile_size * tile_size).
+std::tuple<llvm::Value*, llvm::Value*> CalculateYXCoordinateWithinTile(
+    llvm::IRBuilder<>* builder, llvm::Value* tile_size,
+    int64 threads_per_tile) {
+  // Calculate the starting element coordinate within a tile for the current
+  // thread, (y, x) from thread_id.
+  llvm::Value* thread_id = llvm_ir::EmitCallToIntrinsic(
+      llvm::Intrinsic::nvvm_read_ptx_sreg_tid_x, {}, {}, builder);
+  llvm_ir::AddRangeMetadata(0, threads_per_tile,
+                            llvm::cast<llvm::Instruction>(thread_id));
+  thread_id = builder->CreateIntCast(thread_id, tile_size->getType(),
+                                     /*isSigned=*/true, "thread.id.x");
+  auto x = builder->CreateURem(thread_id, tile_size);
+  auto y = builder->CreateUDiv(thread_id, tile_size);
+  return std::make_tuple(y, x);
+}
+
+// Reads block_idx.x, casts it to type index_ty, and adds the assumption that
+// it's in the range [0, num_blocks].
+llvm::Value* GetBlockIdx(llvm::IRBuilder<>* builder, llvm::Type* index_ty,
+                         int64 num_blocks) {
+  llvm::Value* block_id = llvm_ir::EmitCallToIntrinsic(
+      llvm::Intrinsic::nvvm_read_ptx_sreg_ctaid_x, {}, {}, builder);
+  llvm_ir::AddRangeMetadata(0, num_blocks,
+                            llvm::cast<llvm::Instruction>(block_id));
+  return builder->CreateIntCast(block_id, index_ty, /*isSigned=*/true,
+                                "block.id.x");
+}
+
+}  // namespace
+
 Status IrEmitterUnnested::EmitColumnReduction(
-    KernelThunk* kernel_thunk, int64 height, int64 width,
+    KernelThunk* kernel_thunk, int64 depth, int64 height, int64 width,
     HloInstruction* reduce, const Shape& input_shape,
     absl::Span<const llvm_ir::ElementGenerator> input_gens,
     absl::Span<const llvm_ir::ElementGenerator> init_value_gens,
@@ -961,256 +1000,259 @@ Status IrEmitterUnnested::EmitColumnReduction(
     absl::Span<const ShapeIndex> reduce_output_shapes,
     absl::Span<const std::pair<llvm_ir::ElementGenerator, ShapeIndex>>
         extra_output_gens) {
-  // Divide the input matrix into tiles of size KxL. For example, when the
-  // input matrix is 4x4, K=2, and L=1 the tiled matrix looks like
+  // The input is viewed as `depth` matrices of shape [height x width], each of
+  // which is reduced along its height. Every thread block reduces one tile of
+  // one matrix, as described by llvm_ir::ColumnReductionTiling, in two steps:
   //
-  //   0123
-  //   0123
-  //   4567
-  //   4567  // Numbers indicate tile IDs.
+  //   1. Each thread accumulates columns_per_thread adjacent columns over every
+  //      num_thread_rows-th row of the tile in registers. The threads of a
+  //      warp read adjacent elements, so the loads are coalesced.
+  //   2. The partial results are written to a shared memory buffer of shape
+  //      [num_thread_rows][tile_width * columns_per_thread]. The threads of
+  //      the first row fold the other rows into their own partial results and
+  //      accumulate them to the output with one atomic operation per column.
   //
-  // Each tile is first partially reduced to a scalar by a thread, and then the
-  // scalar is accumulated to the output vector using atomic operations.
-  //
-  // We choose 128 as the tile size based on empirical evidence. It's big enough
-  // to reduce the amount of atomic adds in the end, maximizing the memory
-  // bandwidth. A tile width of 2 allows for high memory bandwidth utilization
-  // on 16b input data.
-  constexpr int64 kTileHeight = 128;
-  constexpr int64 kTileWidth = 2;
-
-  // If the height is not a multiple of kTileHeight, we pad the bottom of the
-  // input matrix.
-  const int64 height_in_tiles = CeilOfRatio(height, kTileHeight);
-  // If width is not a multiple of kTileWidth the rightmost thread will process
-  // fewer input elements.
-  const int64 width_in_tiles = CeilOfRatio(width, kTileWidth);
-  Shape tiled_input_shape =
-      ShapeUtil::MakeShapeWithLayout(reduce->shape().element_type(),
-                                     {height_in_tiles, width_in_tiles}, {1, 0});
-  LaunchDimensions launch_dimensions = CalculateLaunchDimensions(
-      tiled_input_shape, ir_emitter_context_->device_description());
+  // for (y_offset : range(rows_per_thread)) {
+  //   y = tile_y * tile_height + y_offset * num_thread_rows + thread_row;
+  //   for (x_offset : range(columns_per_thread)) {
+  //     x = (tile_x * tile_width + thread_column) * columns_per_thread +
+  //         x_offset;
+  //     if (y < height && x < width) {
+  //       partial_result[x_offset] =
+  //           Reducer(partial_result[x_offset], input[z][y][x]);
+  //     }
+  //   }
+  // }
+  // shared[thread_row][thread_column * columns_per_thread + x_offset] =
+  //     partial_result[x_offset];
+  // __syncthreads();
+  // if (thread_row == 0) {
+  //   for (row : range(1, num_thread_rows)) {
+  //     partial_result[x_offset] = Reducer(
+  //         partial_result[x_offset],
+  //         shared[row][thread_column * columns_per_thread + x_offset]);
+  //   }
+  //   if (x < width) {
+  //     AtomicReducer(&output[z][x], partial_result[x_offset]);
+  //   }
+  // }
+  const llvm_ir::ColumnReductionTiling tiling =
+      llvm_ir::ComputeColumnReductionTiling(
+          depth, height, width,
+          ShapeUtil::ByteSizeOfPrimitiveType(input_shape.element_type()),
+          ir_emitter_context_->device_description().core_count());
+  const int64 tile_width_in_elements =
+      tiling.tile_width * tiling.columns_per_thread;
+  const int64 num_blocks = depth * tiling.num_tiles_y * tiling.num_tiles_x;
+  VLOG(3) << "Emitting column reduction of " << depth << "x" << height << "x"
+          << width << " in " << num_blocks << " blocks of "
+          << tiling.num_thread_rows << "x" << tiling.tile_width
+          << " threads; each thread reduces " << tiling.rows_per_thread
+          << " rows of " << tiling.columns_per_thread << " columns";
+  if (depth * height * width == 0) {
+    // Nothing to reduce: the initializer thunk writes the whole output.
+    UpdateLaunchDimensions(LaunchDimensions(), kernel_thunk,
+                           ir_emitter_context_->llvm_module());
+    return Status::OK();
+  }
+  UpdateLaunchDimensions(
+      LaunchDimensions(num_blocks, tiling.threads_per_block()), kernel_thunk,
+      ir_emitter_context_->llvm_module());
 
   // TODO(b/110211620): Convert to use i32 index_type when it is possible.
   llvm::Type* index_ty = b_.getInt64Ty();
-
   auto index_typed_constant = [&](uint64 c) -> llvm::Constant* {
     return llvm::ConstantInt::get(index_ty, c);
   };
 
-  // for (linear_index = threadIdx.x + blockIdx.x * blockDim.x;
-  //      linear_index < height_in_tiles * width_in_tiles;
-  //      linear_index += blockDim.x * gridDim.x) {
-  //   y_in_tiles = linear_index / width_in_tiles;
-  //   x_in_tiles = linear_index % width_in_tiles;
-  //
-  //   partial_results[kTileWidth] = init_values;
-  //   tile_in_y_bounds = height % kTileHeight == 0 ||
-  //       y_in_tiles * kTileHeight + kTileHeight <= height;
-  //   tile_in_x_bounds = width % kTileWidth == 0 ||
-  //       x_in_tiles * kTileWidth + kTileWidth <= width;
-  //   // The implementation handles y and x bound checks separately.
-  //   if (tile_in_y_bounds && tile_in_x_bounds) {
-  //     for (y_offset : range(kTileHeight)) {
-  //       y = y_in_tiles * kTileHeight + y_offset;
-  //       for (x_offset : range(kTileWidth)) {
-  //         x = x_in_tiles * kTileWidth + x_offset;
-  //         partial_result = Reducer(partial_result[x_offset], input[y][x]);
-  //       }
-  //     }
-  //   } else {
-  //     for (y_offset : range(kTileHeight)) {
-  //       y = y_in_tiles * kTileHeight + y_offset;
-  //       for (y_offset : range(kTileHeight)) {
-  //         x = x_in_tiles * kTileWidth + x_offset;
-  //         if (y < height && x < width) {
-  //           partial_result = Reducer(partial_result, input[y][x]);
-  //         }
-  //       }
-  //     }
-  //   }
-  //   for (x_offset : range(kTileWidth)) {
-  //     AtomicReducer(&output[x + x_offset], partial_result[x_offset]);
-  //   }
-  // }
-  auto loop_body_emitter = [=](const IrArray::Index& tile_index) -> Status {
-    const int num_reduces = reducers.size();
-    // Emit the loop body that reduces one tile.
-    llvm::Type* element_ir_type =
-        llvm_ir::PrimitiveTypeToIrType(input_shape.element_type(), module_);
-    std::vector<llvm::Value*> partial_reduction_result_addresses;
-    for (int i = 0; i != num_reduces; ++i) {
-      for (int x_offset = 0; x_offset < kTileWidth; ++x_offset) {
-        llvm::Value* partial_reduction_result_address =
-            Alloca(element_ir_type, /*ArraySize=*/nullptr,
-                   "partial_reduction_result." +
-                       llvm::Twine(i * kTileWidth + x_offset));
-        TF_ASSIGN_OR_RETURN(llvm::Value* const init_ir_value,
-                            init_value_gens[i](IrArray::Index(index_ty)));
-        Store(init_ir_value, partial_reduction_result_address);
-        partial_reduction_result_addresses.push_back(
-            partial_reduction_result_address);
-      }
+  llvm::Value* thread_row;
+  llvm::Value* thread_column;
+  std::tie(thread_row, thread_column) = CalculateYXCoordinateWithinTile(
+      &b_, index_typed_constant(tiling.tile_width),
+      tiling.threads_per_block());
+  const IrArray::Index block_index(
+      GetBlockIdx(&b_, index_ty, num_blocks),
+      ShapeUtil::MakeShapeWithDescendingLayout(
+          PRED /*arbitrary*/, {depth, tiling.num_tiles_y, tiling.num_tiles_x}),
+      &b_);
+  llvm::Value* z = block_index[0];
+  // The first row and the first column reduced by this thread.
+  llvm::Value* y_base =
+      NSWAdd(NSWMul(block_index[1], index_typed_constant(tiling.tile_height())),
+             thread_row);
+  llvm::Value* column_in_tile =
+      NSWMul(thread_column, index_typed_constant(tiling.columns_per_thread));
+  llvm::Value* x_base = NSWAdd(
+      NSWMul(block_index[2], index_typed_constant(tile_width_in_elements)),
+      column_in_tile);
+
+  const int num_reduces = reducers.size();
+  const int64 columns_per_thread = tiling.columns_per_thread;
+  llvm::Type* element_ir_type =
+      llvm_ir::PrimitiveTypeToIrType(input_shape.element_type(), module_);
+  // partial_result_addresses[i * columns_per_thread + x_offset] holds the
+  // partial result of reducer i for column x_base + x_offset.
+  std::vector<llvm::Value*> partial_result_addresses;
+  for (int i = 0; i != num_reduces; ++i) {
+    for (int64 x_offset = 0; x_offset < columns_per_thread; ++x_offset) {
+      llvm::Value* partial_result_address =
+          llvm_ir::EmitAllocaAtFunctionEntry(
+              element_ir_type,
+              StrCat("partial_reduction_result.",
+                     i * columns_per_thread + x_offset),
+              &b_);
+      TF_ASSIGN_OR_RETURN(llvm::Value* const init_ir_value,
+                          init_value_gens[i](IrArray::Index(index_ty)));
+      Store(init_ir_value, partial_result_address);
+      partial_result_addresses.push_back(partial_result_address);
     }
+  }
+  llvm::Value* input_address = llvm_ir::EmitAllocaAtFunctionEntry(
+      element_ir_type, "reduction_input_address", &b_);
+
+  // {z,y,x} is an index to input_3d_shape [depth,height,width]. We need to
+  // convert that to an index to input_shape (the shape of the operand of
+  // "reduce"). This conversion is composed of a transposition from
+  // input_shape to normalized_input_shape and a reshape from
+  // normalized_input_shape to input_3d_shape.
+  const Shape normalized_input_shape =
+      ShapeUtil::MakeShapeWithDescendingLayoutAndSamePhysicalLayout(
+          input_shape);
+  auto input_shape_min2maj = LayoutUtil::MinorToMajor(input_shape);
+  const std::vector<int64> transpose_dimension_mapping(
+      input_shape_min2maj.rbegin(), input_shape_min2maj.rend());
+  const Shape input_3d_shape = ShapeUtil::MakeShapeWithDescendingLayout(
+      input_shape.element_type(), {depth, height, width});
 
-    // Emit an inner for-loop that partially reduces the elements in the given
-    // tile.
-    llvm::Value* y_in_tiles = tile_index[0];
-    llvm::Value* x_in_tiles = tile_index[1];
-
-    y_in_tiles = ZExtOrTrunc(y_in_tiles, index_ty);
-    x_in_tiles = ZExtOrTrunc(x_in_tiles, index_ty);
-
-    auto emit_tile_element_loop = [=](bool tile_in_y_bounds,
-                                      bool tile_in_x_bounds) -> Status {
-      std::unique_ptr<llvm_ir::ForLoop> tile_element_loop =
-          llvm_ir::ForLoop::EmitForLoop(
-              "element_id_in_tile", index_typed_constant(0),
-              index_typed_constant(kTileHeight), index_typed_constant(1), &b_);
-
-      // Emit the body of the partial reduction loop.
-      llvm_ir::SetToFirstInsertPoint(tile_element_loop->GetBodyBasicBlock(),
-                                     &b_);
-      llvm::Value* y =
-          NSWAdd(NSWMul(y_in_tiles, index_typed_constant(kTileHeight)),
-                 tile_element_loop->GetIndVarValue());
-
-      // Unless we know that y is in bounds, we have to emit a check before
-      // reading from the input.
-      if (!tile_in_y_bounds) {
-        llvm_ir::LlvmIfData if_data = llvm_ir::EmitIfThenElse(
-            ICmpULT(y, index_typed_constant(height)), "y_in_bounds", &b_);
-
-        // Emit code that reads the input element and accumulates it to
-        // the partial reduction result.
-        llvm_ir::SetToFirstInsertPoint(if_data.true_block, &b_);
-      }
-      for (int x_offset = 0; x_offset < kTileWidth; ++x_offset) {
-        llvm::Value* x =
-            NSWAdd(NSWMul(x_in_tiles, index_typed_constant(kTileWidth)),
-                   index_typed_constant(x_offset));
-        // Unless we know that x is in bounds, we have to emit a check before
-        // reading from the input.
-        if (!tile_in_x_bounds) {
-          llvm_ir::LlvmIfData if_data = llvm_ir::EmitIfThenElse(
-              ICmpULT(x, index_typed_constant(width)), "x_in_bounds", &b_);
-          llvm_ir::SetToFirstInsertPoint(if_data.true_block, &b_);
-        }
-        llvm::Value* input_address = Alloca(element_ir_type);
-        // {y,x} is an index to input_matrix_shape [height,width]. We need to
-        // convert that to an index to input_shape (the shape of the operand of
-        // "reduce"). This conversion is composed of a transposition from
-        // input_shape to normalized_input_shape and a reshape from
-        // normalized_input_shape to input_matrix_shape.
-        const Shape normalized_input_shape =
-            ShapeUtil::MakeShapeWithDescendingLayoutAndSamePhysicalLayout(
-                input_shape);
-        auto input_shape_min2maj = LayoutUtil::MinorToMajor(input_shape);
-        const std::vector<int64> transpose_dimension_mapping(
-            input_shape_min2maj.rbegin(), input_shape_min2maj.rend());
-
-        const Shape input_matrix_shape =
-            ShapeUtil::MakeShapeWithDescendingLayout(input_shape.element_type(),
-                                                     {height, width});
-        const IrArray::Index input_matrix_index({y, x}, input_matrix_shape,
-                                                &b_);
-        const IrArray::Index input_index =
-            input_matrix_index
-                .SourceIndexOfReshape(input_matrix_shape,
-                                      normalized_input_shape, &b_)
-                .SourceIndexOfTranspose(normalized_input_shape, input_shape,
-                                        transpose_dimension_mapping, &b_);
-        for (int i = 0; i != num_reduces; ++i) {
-          TF_ASSIGN_OR_RETURN(llvm::Value* const input_ir_value,
-                              input_gens[i](input_index));
-          Store(input_ir_value, input_address);
-          TF_RETURN_IF_ERROR(EmitCallToNestedComputation(
-              *reducers[i],
-              {partial_reduction_result_addresses[i * kTileWidth + x_offset],
-               input_address},
-              partial_reduction_result_addresses[i * kTileWidth + x_offset]));
-          TF_RETURN_IF_ERROR(EmitExtraOutputsForReduce(reduce, input_index,
-                                                       extra_output_gens));
-        }
-      }
-      return Status::OK();
-    };
-
-    // y_end = kTileHeight + y_in_tiles * kTileHeight, i.e., the y location
-    // that's immediately beyond the tile.
-    llvm::Value* y_end =
-        NSWAdd(index_typed_constant(kTileHeight),
-               NSWMul(y_in_tiles, index_typed_constant(kTileHeight)));
-    // x_end = kTileWidth + x_in_tiles * kTileWidth, i.e., the x location
-    // that's immediately beyond the tile.
-    llvm::Value* x_end =
-        NSWAdd(index_typed_constant(kTileWidth),
-               NSWMul(x_in_tiles, index_typed_constant(kTileWidth)));
-    llvm::Value* tile_in_y_bounds =
-        Or(ICmpULE(y_end, index_typed_constant(height)),
-           b_.getInt1(height % kTileHeight == 0));
-    llvm::Value* tile_in_x_bounds =
-        Or(ICmpULE(x_end, index_typed_constant(width)),
-           b_.getInt1(width % kTileWidth == 0));
-    // The tile is in y bounds if "height" is a multiple of kTileHeight or
-    // y_end <= height.
-    llvm_ir::LlvmIfData if_tile_in_y_bounds_data =
-        llvm_ir::EmitIfThenElse(tile_in_y_bounds, "tile_in_y_bounds", &b_);
-    llvm_ir::SetToFirstInsertPoint(if_tile_in_y_bounds_data.true_block, &b_);
-    // The tile is in x bounds if "width" is a multiple of kTileWidth or
-    // x_end <= width.
-    llvm_ir::LlvmIfData if_tile_in_x_bounds_data =
-        llvm_ir::EmitIfThenElse(tile_in_x_bounds, "tile_in_x_bounds", &b_);
-    llvm_ir::SetToFirstInsertPoint(if_tile_in_x_bounds_data.true_block, &b_);
-    TF_RETURN_IF_ERROR(emit_tile_element_loop(/*tile_in_y_bounds=*/true,
-                                              /*tile_in_x_bounds=*/true));
-    llvm_ir::SetToFirstInsertPoint(if_tile_in_x_bounds_data.false_block, &b_);
-    TF_RETURN_IF_ERROR(emit_tile_element_loop(/*tile_in_y_bounds=*/true,
-                                              /*tile_in_x_bounds=*/false));
-    llvm_ir::SetToFirstInsertPoint(if_tile_in_y_bounds_data.false_block, &b_);
-    if_tile_in_x_bounds_data =
-        llvm_ir::EmitIfThenElse(tile_in_x_bounds, "tile_in_x_bounds", &b_);
-    llvm_ir::SetToFirstInsertPoint(if_tile_in_x_bounds_data.true_block, &b_);
-    TF_RETURN_IF_ERROR(emit_tile_element_loop(/*tile_in_y_bounds=*/false,
-                                              /*tile_in_x_bounds=*/true));
-    llvm_ir::SetToFirstInsertPoint(if_tile_in_x_bounds_data.false_block, &b_);
-    TF_RETURN_IF_ERROR(emit_tile_element_loop(/*tile_in_y_bounds=*/false,
-                                              /*tile_in_x_bounds=*/false));
-
-    // After the nested if-then-else statement on tile_in_y_bounds and
-    // tile_in_x_bounds, emit atomic operations to accumulate the partial
-    // reduction result to the output element.
-    llvm_ir::SetToFirstInsertPoint(if_tile_in_y_bounds_data.after_block, &b_);
-    const HloInstruction* output =
-        reduce->IsFused() ? reduce->parent()->FusionInstruction() : reduce;
+  KernelSupportLibrary ksl(&b_, llvm_ir::UnrollMode::kDefaultUnroll);
+  // Unless the tiles evenly divide the input, the threads of the last tiles
+  // have to check the bounds before reading.
+  auto if_in_bounds = [&](bool in_bounds, absl::string_view name,
+                          llvm::Value* index, int64 bound,
+                          const std::function<Status()>& emit) -> Status {
+    if (in_bounds) {
+      return emit();
+    }
+    return ksl.If(name, ICmpULT(index, index_typed_constant(bound)), emit);
+  };
+  // Accumulates input element {z,y,x} to the partial results of column
+  // x_base + x_offset.
+  auto reduce_element = [&](llvm::Value* y, llvm::Value* x,
+                            int64 x_offset) -> Status {
+    const IrArray::Index input_3d_index({z, y, x}, input_3d_shape, &b_);
+    const IrArray::Index input_index =
+        input_3d_index
+            .SourceIndexOfReshape(input_3d_shape, normalized_input_shape, &b_)
+            .SourceIndexOfTranspose(normalized_input_shape, input_shape,
+                                    transpose_dimension_mapping, &b_);
     for (int i = 0; i != num_reduces; ++i) {
-      for (int x_offset = 0; x_offset < kTileWidth; ++x_offset) {
-        llvm::Value* x =
-            NSWAdd(NSWMul(x_in_tiles, index_typed_constant(kTileWidth)),
-                   index_typed_constant(x_offset));
-        llvm::Value* output_address =
-            GetIrArray(*output, *output, reduce_output_shapes[i])
-                .EmitArrayElementAddress(
-                    IrArray::Index(
-                        x,
-                        ShapeUtil::GetSubshape(output->shape(),
-                                               reduce_output_shapes[i]),
-                        &b_),
-                    &b_, "output_element_address");
-        TF_RETURN_IF_ERROR(EmitAtomicOperationForNestedComputation(
-            *reducers[i], output_address,
-            partial_reduction_result_addresses[i * kTileWidth + x_offset]));
-      }
+      TF_ASSIGN_OR_RETURN(llvm::Value* const input_ir_value,
+                          input_gens[i](input_index));
+      Store(input_ir_value, input_address);
+      llvm::Value* partial_result_address =
+          partial_result_addresses[i * columns_per_thread + x_offset];
+      TF_RETURN_IF_ERROR(EmitCallToNestedComputation(
+          *reducers[i], {partial_result_address, input_address},
+          partial_result_address));
     }
-    return Status::OK();
+    return EmitExtraOutputsForReduce(reduce, input_index, extra_output_gens);
   };
+  const bool tiles_in_y_bounds = height % tiling.tile_height() == 0;
+  const bool tiles_in_x_bounds = width % tile_width_in_elements == 0;
+  TF_RETURN_IF_ERROR(ksl.For(
+      "row_in_thread", /*start=*/0, /*end=*/tiling.rows_per_thread,
+      /*step=*/1, [&](llvm::Value* y_offset) -> Status {
+        llvm::Value* y = NSWAdd(
+            y_base,
+            NSWMul(y_offset, index_typed_constant(tiling.num_thread_rows)));
+        return if_in_bounds(
+            tiles_in_y_bounds, "y_in_bounds", y, height, [&]() -> Status {
+              for (int64 x_offset = 0; x_offset < columns_per_thread;
+                   ++x_offset) {
+                llvm::Value* x =
+                    NSWAdd(x_base, index_typed_constant(x_offset));
+                TF_RETURN_IF_ERROR(if_in_bounds(
+                    tiles_in_x_bounds, "x_in_bounds", x, width,
+                    [&]() { return reduce_element(y, x, x_offset); }));
+              }
+              return Status::OK();
+            });
+      }));
 
-  // Emit a parallel loop that iterate through all input tiles.
-  UpdateLaunchDimensions(launch_dimensions, kernel_thunk,
-                         ir_emitter_context_->llvm_module());
-  return ParallelLoopEmitter(loop_body_emitter, tiled_input_shape,
-                             launch_dimensions, &b_)
-      .EmitLoop(IrName(reduce), index_ty);
+  // Exchange the partial results of the block through shared memory.
+  llvm::Type* shared_tile_type = llvm::ArrayType::get(
+      llvm::ArrayType::get(element_ir_type, tile_width_in_elements),
+      tiling.num_thread_rows);
+  std::vector<llvm::Value*> shared_tiles;
+  for (int i = 0; i != num_reduces; ++i) {
+    shared_tiles.push_back(llvm_ir::AllocateSharedMemoryTile(
+        module_, shared_tile_type,
+        IrName(reduce, StrCat("partial_results", i))));
+  }
+  auto shared_element_address = [&](int i, llvm::Value* row,
+                                    int64 x_offset) -> llvm::Value* {
+    return GEP(shared_tiles[i],
+               {index_typed_constant(0), row,
+                NSWAdd(column_in_tile, index_typed_constant(x_offset))});
+  };
+  for (int i = 0; i != num_reduces; ++i) {
+    for (int64 x_offset = 0; x_offset < columns_per_thread; ++x_offset) {
+      Store(Load(partial_result_addresses[i * columns_per_thread + x_offset]),
+            shared_element_address(i, thread_row, x_offset));
+    }
+  }
+  llvm_ir::EmitCallToIntrinsic(llvm::Intrinsic::nvvm_barrier0, {}, {}, &b_);
+
+  const HloInstruction* output =
+      reduce->IsFused() ? reduce->parent()->FusionInstruction() : reduce;
+  return ksl.If(
+      "first_thread_row", ICmpEQ(thread_row, index_typed_constant(0)),
+      [&]() -> Status {
+        TF_RETURN_IF_ERROR(ksl.For(
+            "shared_row", /*start=*/1, /*end=*/tiling.num_thread_rows,
+            /*step=*/1, [&](llvm::Value* row) -> Status {
+              for (int i = 0; i != num_reduces; ++i) {
+                for (int64 x_offset = 0; x_offset < columns_per_thread;
+                     ++x_offset) {
+                  llvm::Value* partial_result_address =
+                      partial_result_addresses[i * columns_per_thread +
+                                               x_offset];
+                  Store(Load(shared_element_address(i, row, x_offset)),
+                        input_address);
+                  TF_RETURN_IF_ERROR(EmitCallToNestedComputation(
+                      *reducers[i], {partial_result_address, input_address},
+                      partial_result_address));
+                }
+              }
+              return Status::OK();
+            }));
+        for (int64 x_offset = 0; x_offset < columns_per_thread; ++x_offset) {
+          llvm::Value* x = NSWAdd(x_base, index_typed_constant(x_offset));
+          TF_RETURN_IF_ERROR(if_in_bounds(
+              tiles_in_x_bounds, "x_in_bounds", x, width, [&]() -> Status {
+                // The output is laid out as [depth x width] in memory.
+                llvm::Value* output_linear_index =
+                    NSWAdd(NSWMul(z, index_typed_constant(width)), x);
+                for (int i = 0; i != num_reduces; ++i) {
+                  llvm::Value* output_address =
+                      GetIrArray(*output, *output, reduce_output_shapes[i])
+                          .EmitArrayElementAddress(
+                              IrArray::Index(
+                                  output_linear_index,
+                                  ShapeUtil::GetSubshape(
+                                      output->shape(), reduce_output_shapes[i]),
+                                  &b_),
+                              &b_, "output_element_address");
+                  TF_RETURN_IF_ERROR(EmitAtomicOperationForNestedComputation(
+                      *reducers[i], output_address,
+                      partial_result_addresses[i * columns_per_thread +
+                                               x_offset]));
+                }
+                return Status::OK();
+              }));
+        }
+        return Status::OK();
+      });
 }
 
 static std::pair<int64, int64> ComputeTilingSchemeForReduction(
@@ -1584,9 +1626,8 @@ Status IrEmitterUnnested::EmitRowReduction(
 // Figures out whether `reduce` is a row or column reduction, and which
 // dimensions to reduce, and calls either `EmitRowReduction` or
 // `EmitColumnReduction` as appropriate.
-// Prerequisite: all the dimensions to keep are contiguous in the input layout
-//               and, if `reduce` is fused, the fused subgraph is pure
-//               elementwise.
+// Prerequisite: `IsReductionToVector(*reduce)` and, if `reduce` is fused, the
+//               fused subgraph is pure elementwise.
 Status IrEmitterUnnested::EmitReductionToVector(
     KernelThunk* kernel_thunk, HloInstruction* reduce, const Shape& input_shape,
     absl::Span<const llvm_ir::ElementGenerator> input_gens,
@@ -1625,33 +1666,44 @@ Status IrEmitterUnnested::EmitReductionToVector(
   // Now, if output rank is at least 1, `input_dims_to_keep.front()` is
   // minormost and `input_dims_to_keep.back()` is majormost.
 
-  // If the dimensions to keep are minormost, emit a column reduction. As all
-  // the dimensions to keep are contiguous, by prerequisite of
-  // `EmitReductionToVector`, we only need to check whether the minormost
-  // dimension of the input is to keep.
+  // If the minormost dimension of the input is to keep, emit a column
+  // reduction. By prerequisite of `EmitReductionToVector`, the dimensions to
+  // keep are either contiguous, or form two contiguous groups around the
+  // reduced dimensions, in which case the reduction is a batch of column
+  // reductions.
   if (input_dims_to_keep.empty()) {
     return EmitReductionToScalar(kernel_thunk, reduce, input_shape, input_gens,
                                  init_value_gens, reducers,
                                  reduce_output_shapes, extra_output_gens);
   } else if (input_dims_to_keep.front() ==
              LayoutUtil::Minor(input_shape.layout(), 0)) {
-    // Column reduction. Treat the result of "input" as a matrix whose width
-    // is the most minor dimension and height the product of other dimensions,
-    // and treat "reduce" as a column reduction of the input matrix.
-    const int64 width = ShapeUtil::ElementsIn(reduce->shape());
-    // "width" can be zero, so don't do
-    //   height = ShapeUtil::ElementsIn(input_shape) / width;
+    // Column reduction. Treat the result of "input" as `depth` matrices whose
+    // width is the product of the minor dimensions to keep and height the
+    // product of the dimensions to reduce, and treat "reduce" as a column
+    // reduction of each of the matrices. `depth` is the product of the
+    // dimensions to keep that are major to the dimensions to reduce, and is 1
+    // unless the reduced dimensions are in the middle.
+    int64 depth = 1;
     int64 height = 1;
-    for (int64 input_dim = 0; input_dim < ShapeUtil::Rank(input_shape);
-         ++input_dim) {
-      if (!std::count(input_dims_to_keep.begin(), input_dims_to_keep.end(),
-                      input_dim)) {
-        height *= input_shape.dimensions(input_dim);
+    int64 width = 1;
+    for (int64 i = 0; i < input_dims_to_keep.size(); ++i) {
+      const int64 input_dim = input_dims_to_keep[i];
+      if (PositionInContainer(LayoutUtil::MinorToMajor(input_shape),
+                              input_dim) == i) {
+        width *= input_shape.dimensions(input_dim);
+      } else {
+        depth *= input_shape.dimensions(input_dim);
       }
     }
-    return EmitColumnReduction(kernel_thunk, height, width, reduce, input_shape,
-                               input_gens, init_value_gens, reducers,
-                               reduce_output_shapes, extra_output_gens);
+    // "width" can be zero, so don't do
+    //   height = ShapeUtil::ElementsIn(input_shape) / width;
+    for (int64 input_dim : dimensions_to_reduce) {
+      height *= input_shape.dimensions(input_dim);
+    }
+    return EmitColumnReduction(kernel_thunk, depth, height, width, reduce,
+                               input_shape, input_gens, init_value_gens,
+                               reducers, reduce_output_shapes,
+                               extra_output_gens);
   } else {
     // Reduce the row dimension of a matrix or reduce dimension 0 and 2 in a
     // 3D tensor. The size of dimension 1 (the height) is the size of the
@@ -2191,6 +2243,87 @@ Status IrEmitterUnnested::EmitScatter(
                                       &b_));
 }
 
+Status IrEmitterUnnested::EmitHorizontalLoopFusion(HloInstruction* fusion) {
+  CHECK(IsHorizontalLoopFusion(*fusion));
+  std::unique_ptr<KernelThunk> kernel_thunk =
+      BuildKernelThunk(fusion, /*implements_whole_instruction=*/true);
+
+  std::vector<IrArray> parameter_arrays = ConstructIrArrayForInputs(*fusion);
+  GpuElementalIrEmitter elemental_emitter(hlo_module_config_,
+                                          ir_emitter_context_->llvm_module(),
+                                          &b_, GetNestedComputer());
+  FusedIrEmitter fused_emitter(parameter_arrays, &elemental_emitter);
+  HloInstruction* root = fusion->fused_expression_root();
+  TF_RETURN_IF_ERROR(root->Accept(&fused_emitter));
+
+  // Launch one thread per element of the largest output.
+  std::vector<IrArray> output_arrays = ConstructIrArrayForOutputs(*fusion);
+  const Shape* loop_shape = &output_arrays[0].GetShape();
+  for (const IrArray& output_array : output_arrays) {
+    if (ShapeUtil::ElementsIn(output_array.GetShape()) >
+        ShapeUtil::ElementsIn(*loop_shape)) {
+      loop_shape = &output_array.GetShape();
+    }
+  }
+  LaunchDimensions launch_dimensions = CalculateLaunchDimensions(
+      *loop_shape, ir_emitter_context_->device_description());
+  UpdateLaunchDimensions(launch_dimensions, kernel_thunk.get(),
+                         ir_emitter_context_->llvm_module());
+
+  std::vector<llvm::Value*> value_addresses;
+  for (int64 i = 0; i < output_arrays.size(); ++i) {
+    value_addresses.push_back(llvm_ir::EmitAllocaAtFunctionEntry(
+        llvm_ir::PrimitiveTypeToIrType(
+            output_arrays[i].GetShape().element_type(), module_),
+        StrCat("horizontal_fusion.value.", i), &b_));
+  }
+
+  auto loop_body_emitter = [&](const IrArray::Index& index) -> Status {
+    KernelSupportLibrary ksl(&b_);
+    llvm::Value* linear_index = index.linear();
+    CHECK(linear_index != nullptr);
+    auto output_index = [&](int64 i) {
+      return IrArray::Index(linear_index, output_arrays[i].GetShape(), &b_);
+    };
+    auto in_bounds = [&](int64 i) {
+      return ICmpULT(linear_index,
+                     index.GetConstantWithIndexType(
+                         ShapeUtil::ElementsIn(output_arrays[i].GetShape())));
+    };
+    for (int64 i = 0; i < output_arrays.size(); ++i) {
+      TF_RETURN_IF_ERROR(ksl.If(
+          StrCat("horizontal_fusion.compute.", i), in_bounds(i), [&]() {
+            TF_ASSIGN_OR_RETURN(
+                llvm::Value* const value,
+                fused_emitter.GetGenerator(root->operand(i))(output_index(i)));
+            Store(value, value_addresses[i]);
+            return Status::OK();
+          }));
+    }
+    for (int64 i = 0; i < output_arrays.size(); ++i) {
+      TF_RETURN_IF_ERROR(ksl.If(
+          StrCat("horizontal_fusion.store.", i), in_bounds(i), [&]() {
+            output_arrays[i].EmitWriteArrayElement(
+                output_index(i), Load(value_addresses[i]), &b_);
+            return Status::OK();
+          }));
+    }
+    return Status::OK();
+  };
+
+  AddThunkToThunkSequence(std::move(kernel_thunk));
+  TF_RETURN_IF_ERROR(
+      ParallelLoopEmitter(loop_body_emitter, *loop_shape, launch_dimensions,
+                          &b_)
+          .EmitLoop(IrName(fusion),
+                    GetIndexTypeForKernel(
+                        fusion, launch_dimensions.launch_bound(), &b_)));
+
+  b_.SetInsertPoint(b_.GetInsertBlock()->getTerminator());
+  llvm_ir::EmitTuple(GetIrArray(*fusion, *fusion), output_arrays, &b_, module_);
+  return Status::OK();
+}
+
 Status IrEmitterUnnested::HandleSelect(HloInstruction* select) {
   AddThunkToThunkSequence(
       BuildKernelThunk(select, /*implements_whole_instruction=*/true));
@@ -2228,7 +2361,7 @@ Status IrEmitterUnnested::HandleSort(HloInstruction* sort) {
   int64 dimension_to_sort = sort->dimensions(0);
   int64 dimension_to_sort_bound = keys_shape.dimensions(dimension_to_sort);
   int64 num_stages = tensorflow::Log2Ceiling(dimension_to_sort_bound);
-  auto index_type = b_.getInt64Ty();
+  const auto& device_description = ir_emitter_context_->device_description();
 
   // Naive C++ code for the outer loops:
   //
@@ -2244,40 +2377,94 @@ Status IrEmitterUnnested::HandleSort(HloInstruction* sort) {
   //
   // This follows the algorithm described on Wikipedia:
   // https://en.wikipedia.org/wiki/Bitonic_sorter
-
+  //
+  // Each thread compares one pair of elements, so the dimension to sort is
+  // covered by 2^(num_stages - 1) iterations per mask.
+  int64 standard_num_iterations_in_sort_dim =
+      num_stages > 0 ? 1LL << (num_stages - 1) : 0;
+  Shape standard_iteration_shape = keys_shape;
+  standard_iteration_shape.set_dimensions(dimension_to_sort,
+                                          standard_num_iterations_in_sort_dim);
+  LaunchDimensions standard_launch_dimensions = CalculateLaunchDimensions(
+      standard_iteration_shape, device_description);
+
+  // Consecutive masks that are smaller than the tile size only compare
+  // elements within a tile, so they are run by a single kernel which keeps the
+  // tile in shared memory. A tile of tile_size elements is sorted by
+  // tile_size / 2 threads, and the tiles of all operands must fit in the
+  // shared memory of a block.
+  int64 tile_size = std::min(
+      2 * static_cast<int64>(device_description.threads_per_block_limit()),
+      int64{1} << std::max<int64>(num_stages, 0));
+  int64 bytes_per_tile_element = 0;
+  for (const HloInstruction* operand : sort->operands()) {
+    bytes_per_tile_element +=
+        ShapeUtil::ByteSizeOfPrimitiveType(operand->shape().element_type());
+  }
+  while (tile_size > 1 &&
+         tile_size * bytes_per_tile_element >
+             static_cast<int64>(device_description.shared_memory_per_block())) {
+    tile_size /= 2;
+  }
+  int64 num_tiles_in_sort_dim =
+      CeilOfRatio(dimension_to_sort_bound, tile_size);
+  int64 tiled_num_iterations_in_sort_dim =
+      num_tiles_in_sort_dim * (tile_size / 2);
+  LaunchDimensions tiled_launch_dimensions(
+      ShapeUtil::ElementsIn(keys_shape) / dimension_to_sort_bound *
+          num_tiles_in_sort_dim,
+      tile_size / 2);
+
+  auto emit_kernel = [&](absl::Span<const int64> xor_masks) {
+    thunks.push_back(
+        BuildKernelThunk(sort, /*implements_whole_instruction=*/false));
+    bool tiled = xor_masks.size() > 1;
+    const LaunchDimensions& launch_dimensions =
+        tiled ? tiled_launch_dimensions : standard_launch_dimensions;
+    UpdateLaunchDimensions(launch_dimensions, thunks.back().get(),
+                           ir_emitter_context_->llvm_module());
+    IrArray keys_array;
+    std::vector<IrArray> values_arrays;
+    values_arrays.reserve(sort->operand_count() - 1);
+    for (int64 i = 0; i < sort->operand_count(); ++i) {
+      ShapeIndex shape_index =
+          sort->operand_count() > 1 ? ShapeIndex({i}) : ShapeIndex({});
+      if (i == 0) {
+        keys_array = GetIrArray(*sort, *sort, shape_index);
+      } else {
+        values_arrays.push_back(GetIrArray(*sort, *sort, shape_index));
+      }
+    }
+    return llvm_ir::EmitSortInPlace(
+        dimension_to_sort, keys_array, values_arrays, IrName(sort), xor_masks,
+        &b_, launch_dimensions,
+        tiled ? tiled_num_iterations_in_sort_dim
+              : standard_num_iterations_in_sort_dim,
+        tile_size);
+  };
+  std::vector<int64> xor_masks;
   for (int64 stage = 0; stage < num_stages; ++stage) {
     for (int64 mask = stage; mask >= 0; --mask) {
-      thunks.push_back(
-          BuildKernelThunk(sort, /*implements_whole_instruction=*/false));
-      LaunchDimensions launch_dimensions = CalculateLaunchDimensions(
-          keys_shape, ir_emitter_context_->device_description());
-      UpdateLaunchDimensions(launch_dimensions, thunks.back().get(),
-                             ir_emitter_context_->llvm_module());
-
-      llvm::Value* xor_mask;
+      int64 xor_mask;
       if (mask == stage) {
-        xor_mask = llvm::ConstantInt::get(index_type, (1LL << (stage + 1)) - 1);
+        xor_mask = (1LL << (stage + 1)) - 1;
       } else {
-        xor_mask = llvm::ConstantInt::get(index_type, 1LL << mask);
+        xor_mask = 1LL << mask;
       }
-
-      IrArray keys_array;
-      std::vector<IrArray> values_arrays;
-      values_arrays.reserve(sort->operand_count() - 1);
-      for (int64 i = 0; i < sort->operand_count(); ++i) {
-        ShapeIndex shape_index =
-            sort->operand_count() > 1 ? ShapeIndex({i}) : ShapeIndex({});
-        if (i == 0) {
-          keys_array = GetIrArray(*sort, *sort, shape_index);
-        } else {
-          values_arrays.push_back(GetIrArray(*sort, *sort, shape_index));
+      if (xor_mask >= tile_size) {
+        if (!xor_masks.empty()) {
+          TF_RETURN_IF_ERROR(emit_kernel(xor_masks));
+          xor_masks.clear();
         }
+        TF_RETURN_IF_ERROR(emit_kernel({xor_mask}));
+      } else {
+        xor_masks.push_back(xor_mask);
       }
-      TF_RETURN_IF_ERROR(llvm_ir::EmitSortInPlace(
-          dimension_to_sort, keys_array, values_arrays, IrName(sort), xor_mask,
-          &b_, &launch_dimensions));
     }
   }
+  if (!xor_masks.empty()) {
+    TF_RETURN_IF_ERROR(emit_kernel(xor_masks));
+  }
 
   AddThunkToThunkSequence(
       absl::make_unique<SequentialThunk>(std::move(thunks), sort));
@@ -3105,37 +3292,6 @@ int IrEmitterUnnested::ConstructInputReducedShapeAndCastInputIrArrayToShape(
 
 namespace {
 
-// Reads thread_idx.x and converts it to a (y,x) coordinate, assuming that the
-// thread lives within a square tile of size tile_size (so thread blocks are of
-// size tile_size * tile_size).
-std::tuple<llvm::Value*, llvm::Value*> CalculateYXCoordinateWithinTile(
-    llvm::IRBuilder<>* builder, llvm::Value* tile_size,
-    int64 threads_per_tile) {
-  // Calculate the starting element coordinate within a tile for the current
-  // thread, (y, x) from thread_id.
-  llvm::Value* thread_id = llvm_ir::EmitCallToIntrinsic(
-      llvm::Intrinsic::nvvm_read_ptx_sreg_tid_x, {}, {}, builder);
-  llvm_ir::AddRangeMetadata(0, threads_per_tile,
-                            llvm::cast<llvm::Instruction>(thread_id));
-  thread_id = builder->CreateIntCast(thread_id, tile_size->getType(),
-                                     /*isSigned=*/true, "thread.id.x");
-  auto x = builder->CreateURem(thread_id, tile_size);
-  auto y = builder->CreateUDiv(thread_id, tile_size);
-  return std::make_tuple(y, x);
-}
-
-// Reads block_idx.x, casts it to type index_ty, and adds the assumption that
-// it's in the range [0, num_blocks].
-llvm::Value* GetBlockIdx(llvm::IRBuilder<>* builder, llvm::Type* index_ty,
-                         int64 num_blocks) {
-  llvm::Value* block_id = llvm_ir::EmitCallToIntrinsic(
-      llvm::Intrinsic::nvvm_read_ptx_sreg_ctaid_x, {}, {}, builder);
-  llvm_ir::AddRangeMetadata(0, num_blocks,
-                            llvm::cast<llvm::Instruction>(block_id));
-  return builder->CreateIntCast(block_id, index_ty, /*isSigned=*/true,
-                                "block.id.x");
-}
-
 // Emits code to process up to (tile_size/num_rows) elements in a tile, given
 // `emit_elem_function` is the function to emit code to process one element, `y`
 // and `x` are the coordinates for the first element to process, and `index` is
@@ -3245,13 +3401,9 @@ LaunchDimensions IrEmitterUnnested::EmitHlo021Tile(
                                  param->shape().element_type(), module_),
                              kTileSize + 1),
         kTileSize);
-    const int kNVPTXSharedMemoryAddrSpace = 3;
-    auto* tile_base_ptr = new llvm::GlobalVariable(
-        *b_.GetInsertBlock()->getParent()->getParent(), tile_type,
-        /*isConstant=*/false, llvm::GlobalValue::PrivateLinkage,
-        llvm::UndefValue::get(tile_type),
-        llvm_ir::AsStringRef(IrName(hlo, StrCat("tile", id))), nullptr,
-        llvm::GlobalValue::NotThreadLocal, kNVPTXSharedMemoryAddrSpace);
+    auto* tile_base_ptr = llvm_ir::AllocateSharedMemoryTile(
+        b_.GetInsertBlock()->getModule(), tile_type,
+        IrName(hlo, StrCat("tile", id)));
     param_shmem_buffers[id] = tile_base_ptr;
     VLOG(3) << "Added shmem buffer for parameter " << id << ": "
             << llvm_ir::DumpToString(*tile_base_ptr);
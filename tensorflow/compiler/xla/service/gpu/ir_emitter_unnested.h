@@ -120,13 +120,16 @@ class IrEmitterUnnested : public IrEmitter {
   // different memory access pattern, so for performance their implementations
   // are significantly different.
   //
-  // Emits code that reduces a matrix of shape [height x width] to a vector of
-  // [width]. Other parameters have the same meaning as those of
+  // Emits code that reduces a 3D tensor of shape [depth x height x width] to a
+  // matrix of shape [depth x width], i.e. reduces each of `depth` matrices of
+  // shape [height x width] to a vector of [width]. The partial results of a
+  // thread block are combined in shared memory before they are accumulated
+  // to the output. Other parameters have the same meaning as those of
   // `EmitReductionToVector`. Note that input shape might not be
-  // [height x width], but can be bitcast to [height x width] with "height"
-  // being the major dimension.
+  // [depth x height x width], but can be bitcast to [depth x height x width]
+  // with "depth" being the most major dimension.
   Status EmitColumnReduction(
-      KernelThunk* kernel_thunk, int64 height, int64 width,
+      KernelThunk* kernel_thunk, int64 depth, int64 height, int64 width,
       HloInstruction* reduce, const Shape& input_shape,
       absl::Span<const llvm_ir::ElementGenerator> input_gens,
       absl::Span<const llvm_ir::ElementGenerator> init_value_gens,
@@ -196,6 +199,14 @@ class IrEmitterUnnested : public IrEmitter {
                      const llvm_ir::ElementGenerator& scatter_indices_gen,
                      const llvm_ir::ElementGenerator& updates_gen);
 
+  // Emits a kernel for a horizontally fused loop fusion, i.e. one for which
+  // `IsHorizontalLoopFusion` holds. The kernel has one thread per element of
+  // the largest output, and each thread computes the element at its linear
+  // index of every output that has one. All of a thread's elements are
+  // computed before any is stored, as an output may share its buffer with the
+  // operand another output reads at the same index.
+  Status EmitHorizontalLoopFusion(HloInstruction* fusion);
+
   // Returns true if a 0-2-1 tiling algorithm is already used to emit the kernel
   // for the hlo instruction.
   bool CheckAndEmitHloWithTile021(HloInstruction* hlo);
@@ -65,6 +65,7 @@ class KernelThunk : public Thunk {
   Status ExecuteOnStream(const BufferAllocations& buffer_allocations,
                          se::Stream* stream,
                          HloExecutionProfiler* profiler) override;
+  bool IsCapturable() const override { return true; }
 
  private:
   // Buffers passed to the kernel as arguments.
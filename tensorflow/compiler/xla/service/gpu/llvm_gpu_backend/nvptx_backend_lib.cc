@@ -39,6 +39,7 @@ limitations under the License.
 #include "llvm/CodeGen/CommandFlags.inc"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Linker/Linker.h"
@@ -56,6 +57,7 @@ limitations under the License.
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/Scalar.h"
 #include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
@@ -338,27 +340,17 @@ Status LinkLibdeviceIfNecessary(llvm::Module* module,
   return Status::OK();
 }
 
-StatusOr<string> CompileModuleToPtx(llvm::Module* module,
-                                    std::pair<int, int> compute_capability,
-                                    const HloModuleConfig& hlo_module_config,
-                                    const string& libdevice_dir_path) {
-  // If the module has no functions or globals, there's nothing to compile. Just
-  // return an empty string.
-  if (module->empty() && module->global_empty()) {
-    VLOG(2) << "Module '" << llvm_ir::AsString(module->getName())
-            << "' is empty. Skipping compilation.";
-    return string();
-  }
+// Links `module` with libdevice and runs the optimization passes on it.
+Status LinkAndOptimizeModule(llvm::Module* module,
+                             const llvm::Triple& target_triple,
+                             std::pair<int, int> compute_capability,
+                             const HloModuleConfig& hlo_module_config,
+                             const string& libdevice_dir_path) {
   // Link the input module with libdevice, to pull in implementations of some
   // builtins.
   TF_RETURN_IF_ERROR(
       LinkLibdeviceIfNecessary(module, compute_capability, libdevice_dir_path));
 
-  // Set the flush-denormals-to-zero flag on the module so the NVVM reflect pass
-  // can access it.
-  module->addModuleFlag(llvm::Module::Override, "nvvm-reflect-ftz",
-                        hlo_module_config.debug_options().xla_gpu_ftz());
-
   // If ftz is enabled, set it as an attribute on every function in the module.
   if (hlo_module_config.debug_options().xla_gpu_ftz()) {
     for (llvm::Function& fn : *module) {
@@ -374,14 +366,6 @@ StatusOr<string> CompileModuleToPtx(llvm::Module* module,
           llvm::Triple(module->getTargetTriple()));
   module_passes.add(tliwp);
 
-  // Try to fetch the target triple from the module. If not present, set a
-  // default target triple.
-  llvm::Triple target_triple = llvm::Triple(module->getTargetTriple());
-  if (target_triple.getArch() == llvm::Triple::UnknownArch) {
-    LOG(WARNING) << "target triple not found in the module";
-    target_triple = llvm::Triple("nvptx64-unknown-unknown");
-  }
-
   // Figure out the exact name of the processor as known to the NVPTX backend
   // from the gpu_architecture flag.
   std::unique_ptr<llvm::TargetMachine> target_machine = GetTargetMachine(
@@ -432,8 +416,165 @@ StatusOr<string> CompileModuleToPtx(llvm::Module* module,
   }
   function_passes.doFinalization();
   module_passes.run(*module);
+  return Status::OK();
+}
+
+// Drops the entries of the nvvm.annotations metadata of `module` that don't
+// annotate a definition of the module.
+void DropAnnotationsOfDeclarations(llvm::Module* module) {
+  llvm::NamedMDNode* annotations =
+      module->getNamedMetadata("nvvm.annotations");
+  if (annotations == nullptr) {
+    return;
+  }
+  std::vector<llvm::MDNode*> kept;
+  for (llvm::MDNode* annotation : annotations->operands()) {
+    auto* annotated =
+        annotation->getNumOperands() == 0
+            ? nullptr
+            : llvm::mdconst::dyn_extract_or_null<llvm::GlobalValue>(
+                  annotation->getOperand(0));
+    if (annotated != nullptr && !annotated->isDeclaration()) {
+      kept.push_back(annotation);
+    }
+  }
+  annotations->clearOperands();
+  for (llvm::MDNode* annotation : kept) {
+    annotations->addOperand(annotation);
+  }
+}
+
+// Same as LinkAndOptimizeModule, but splits `module` into up to
+// `num_partitions` partitions that are linked and optimized in parallel, each
+// in its own LLVMContext, then links them back into `module`.
+Status LinkAndOptimizeModuleInParallel(llvm::Module* module,
+                                       int num_partitions,
+                                       const llvm::Triple& target_triple,
+                                       std::pair<int, int> compute_capability,
+                                       const HloModuleConfig& hlo_module_config,
+                                       const string& libdevice_dir_path) {
+  // Kernels are split apart, but keep the local functions they call, so that
+  // these can still be inlined.
+  const std::vector<string> partitions = llvm_ir::SplitModuleToBitcode(
+      *module, num_partitions, /*preserve_locals=*/true);
+  const string module_id = llvm_ir::AsString(module->getModuleIdentifier());
+  std::vector<string> optimized_partitions(partitions.size());
+  std::vector<Status> statuses(partitions.size());
+  {
+    tensorflow::thread::ThreadPool pool(tensorflow::Env::Default(),
+                                        "xla_gpu_codegen",
+                                        std::max<int>(partitions.size(), 1));
+    for (int i = 0; i < partitions.size(); ++i) {
+      pool.Schedule([&, i] {
+        statuses[i] = [&]() -> Status {
+          llvm::LLVMContext context;
+          TF_ASSIGN_OR_RETURN(
+              std::unique_ptr<llvm::Module> partition,
+              llvm_ir::LoadModuleFromBitcode(
+                  partitions[i], absl::StrCat(module_id, "-partition-", i),
+                  &context));
+          TF_RETURN_IF_ERROR(LinkAndOptimizeModule(
+              partition.get(), target_triple, compute_capability,
+              hlo_module_config, libdevice_dir_path));
+          DropAnnotationsOfDeclarations(partition.get());
+          std::string bitcode;  // need a std::string instead of a ::string.
+          {
+            llvm::raw_string_ostream stream(bitcode);
+            llvm::WriteBitcodeToFile(*partition, stream);
+          }
+          optimized_partitions[i] = bitcode;
+          return Status::OK();
+        }();
+      });
+    }
+  }
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+
+  // Replace the contents of the module by the optimized partitions, which
+  // define all of its global values.
+  if (llvm::NamedMDNode* annotations =
+          module->getNamedMetadata("nvvm.annotations")) {
+    module->eraseNamedMetadata(annotations);
+  }
+  for (llvm::Function& function : *module) {
+    function.dropAllReferences();
+  }
+  for (llvm::GlobalVariable& global : module->globals()) {
+    global.dropAllReferences();
+  }
+  for (llvm::GlobalAlias& alias : module->aliases()) {
+    alias.dropAllReferences();
+  }
+  while (!module->alias_empty()) {
+    module->alias_begin()->removeDeadConstantUsers();
+    module->alias_begin()->eraseFromParent();
+  }
+  while (!module->empty()) {
+    module->begin()->removeDeadConstantUsers();
+    module->begin()->eraseFromParent();
+  }
+  while (!module->global_empty()) {
+    module->global_begin()->removeDeadConstantUsers();
+    module->global_begin()->eraseFromParent();
+  }
+  llvm::Linker linker(*module);
+  for (int i = 0; i < optimized_partitions.size(); ++i) {
+    TF_ASSIGN_OR_RETURN(
+        std::unique_ptr<llvm::Module> partition,
+        llvm_ir::LoadModuleFromBitcode(
+            optimized_partitions[i],
+            absl::StrCat(module_id, "-partition-", i), &module->getContext()));
+    if (linker.linkInModule(std::move(partition))) {
+      return tensorflow::errors::Internal(
+          absl::StrCat("Error linking partition ", i, " of ", module_id));
+    }
+  }
+  return Status::OK();
+}
+
+StatusOr<string> CompileModuleToPtx(llvm::Module* module,
+                                    std::pair<int, int> compute_capability,
+                                    const HloModuleConfig& hlo_module_config,
+                                    const string& libdevice_dir_path) {
+  // If the module has no functions or globals, there's nothing to compile. Just
+  // return an empty string.
+  if (module->empty() && module->global_empty()) {
+    VLOG(2) << "Module '" << llvm_ir::AsString(module->getName())
+            << "' is empty. Skipping compilation.";
+    return string();
+  }
+
+  // Set the flush-denormals-to-zero flag on the module so the NVVM reflect pass
+  // can access it.
+  module->addModuleFlag(llvm::Module::Override, "nvvm-reflect-ftz",
+                        hlo_module_config.debug_options().xla_gpu_ftz());
+
+  // Try to fetch the target triple from the module. If not present, set a
+  // default target triple.
+  llvm::Triple target_triple = llvm::Triple(module->getTargetTriple());
+  if (target_triple.getArch() == llvm::Triple::UnknownArch) {
+    LOG(WARNING) << "target triple not found in the module";
+    target_triple = llvm::Triple("nvptx64-unknown-unknown");
+  }
+
+  const int split_count =
+      hlo_module_config.debug_options().xla_llvm_parallel_codegen_split_count();
+  if (split_count > 1) {
+    TF_RETURN_IF_ERROR(LinkAndOptimizeModuleInParallel(
+        module, split_count, target_triple, compute_capability,
+        hlo_module_config, libdevice_dir_path));
+  } else {
+    TF_RETURN_IF_ERROR(LinkAndOptimizeModule(module, target_triple,
+                                             compute_capability,
+                                             hlo_module_config,
+                                             libdevice_dir_path));
+  }
 
   // Finally, produce PTX.
+  std::unique_ptr<llvm::TargetMachine> target_machine = GetTargetMachine(
+      target_triple, GetSmName(compute_capability), hlo_module_config);
   return EmitModuleToPTX(module, target_machine.get());
 }
 
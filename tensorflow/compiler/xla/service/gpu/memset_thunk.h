@@ -39,6 +39,7 @@ class MemzeroThunk : public Thunk {
   Status ExecuteOnStream(const BufferAllocations& buffer_allocations,
                          se::Stream* stream,
                          HloExecutionProfiler* profiler) override;
+  bool IsCapturable() const override { return true; }
 
  private:
   const BufferAllocation::Slice dest_;
@@ -56,6 +57,7 @@ class Memset32BitValueThunk : public Thunk {
   Status ExecuteOnStream(const BufferAllocations& buffer_allocations,
                          se::Stream* stream,
                          HloExecutionProfiler* profiler) override;
+  bool IsCapturable() const override { return true; }
 
  private:
   uint32 value_;
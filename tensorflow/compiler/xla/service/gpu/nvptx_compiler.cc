@@ -50,6 +50,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/gpu_hlo_schedule.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_hlo_support_checker.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_layout_assignment.h"
+#include "tensorflow/compiler/xla/service/gpu/horizontal_fusion.h"
 #include "tensorflow/compiler/xla/service/gpu/instruction_fusion.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emitter_context.h"
@@ -321,6 +322,15 @@ Status OptimizeHloModule(HloModule* hlo_module, se::StreamExecutor* stream_exec,
       // fuse the new ReducePrecision operations.
       TF_RETURN_IF_ERROR(fusion.Run(hlo_module).status());
     }
+
+    // Merge the independent loop fusions that are left into fewer kernels to
+    // reduce the launch overhead.
+    HloPassPipeline horizontal_fusion("horizontal-fusion");
+    horizontal_fusion.AddInvariantChecker<HloVerifier>(
+        /*layout_sensitive=*/true,
+        /*allow_mixed_precision=*/false, nullptr);
+    horizontal_fusion.AddPass<GpuHorizontalFusion>();
+    TF_RETURN_IF_ERROR(horizontal_fusion.Run(hlo_module).status());
   }
 
   return Status::OK();
@@ -580,10 +590,21 @@ StatusOr<std::unique_ptr<Executable>> NVPTXCompiler::RunBackend(
   // Determine the HLO schedule, which is an ordering of HLO instructions.  This
   // is used by buffer assignment to enable buffer reuse, and the same ordering
   // must also be used to determine the thunk launch schedule.
-  std::unique_ptr<StreamAssignment> stream_assignment = AssignStreams(*module);
+  //
+  // The cost analysis lets the stream assignment overlap the kernels that are
+  // too small to use the whole GPU, and is also used by the profiler.
+  HloCostAnalysis cost_analysis(ShapeSizeBytesFunction());
+  cost_analysis.set_bytes_per_second(
+      stream_exec->GetDeviceDescription().memory_bandwidth());
+  TF_RETURN_IF_ERROR(module->entry_computation()->Accept(&cost_analysis));
+  std::unique_ptr<StreamAssignment> stream_assignment = AssignStreams(
+      *module, cost_analysis, stream_exec->GetDeviceDescription());
   TF_ASSIGN_OR_RETURN(
       std::unique_ptr<GpuHloSchedule> hlo_schedule,
-      GpuHloSchedule::Build(*module, *stream_assignment, pointer_size_));
+      GpuHloSchedule::Build(*module, stream_assignment.get(), pointer_size_,
+                            module->config()
+                                .debug_options()
+                                .xla_gpu_schedule_memory_limit_bytes()));
 
   // Run buffer analysis on the HLO graph. This analysis figures out which
   // temporary buffers are required to run the computation.
@@ -738,10 +759,6 @@ StatusOr<std::unique_ptr<Executable>> NVPTXCompiler::RunBackend(
   std::unique_ptr<HloProfilePrinterData> profile_printer;
 
   if (module->config().hlo_profiling_enabled()) {
-    HloCostAnalysis cost_analysis(ShapeSizeBytesFunction());
-    cost_analysis.set_bytes_per_second(
-        stream_exec->GetDeviceDescription().memory_bandwidth());
-    TF_RETURN_IF_ERROR(module->entry_computation()->Accept(&cost_analysis));
     profile_index_map = absl::make_unique<HloProfileIndexMap>(*module);
     profile_printer =
         CreateHloProfilePrinterData(*profile_index_map, cost_analysis);
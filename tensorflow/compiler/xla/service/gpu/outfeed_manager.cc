@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/outfeed_manager.h"
 
 #include "absl/memory/memory.h"
+#include "tensorflow/compiler/xla/legacy_flags/debug_options_flags.h"
 #include "tensorflow/compiler/xla/map_util.h"
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/core/platform/logging.h"
@@ -23,8 +24,26 @@ limitations under the License.
 namespace xla {
 namespace gpu {
 
+se::Stream* OutfeedManager::GetStream(se::StreamExecutor* executor) {
+  tensorflow::mutex_lock l(device_to_host_stream_mu_);
+  if (device_to_host_executor_ == nullptr) {
+    device_to_host_executor_ = executor;
+    device_to_host_stream_ = absl::make_unique<se::Stream>(executor);
+    device_to_host_stream_->Init();
+  }
+
+  if (executor != device_to_host_executor_) {
+    // The requested executor must be the same as the one for which
+    // the stream is cached.
+    return nullptr;
+  }
+
+  return device_to_host_stream_.get();
+}
+
 OutfeedManager* GetOrCreateOutfeedManager() {
-  static auto* manager = new OutfeedManager;
+  static auto* manager = new OutfeedManager(
+      legacy_flags::GetDebugOptionsFromFlags().xla_gpu_xfeed_buffer_depth());
   return manager;
 }
 
@@ -17,10 +17,12 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_OUTFEED_MANAGER_H_
 
 #include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/service/gpu/xfeed_buffer_pool.h"
 #include "tensorflow/compiler/xla/service/gpu/xfeed_queue.h"
 #include "tensorflow/compiler/xla/shape_tree.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
 
 namespace xla {
 namespace gpu {
@@ -55,7 +57,35 @@ class OutfeedBuffer {
 
 // Manages a thread-safe queue of buffers. The buffers are supposed to be
 // produced by the transfer manager and consumed by the device.
-using OutfeedManager = XfeedQueue<ShapeTree<std::unique_ptr<OutfeedBuffer>>*>;
+class OutfeedManager
+    : public XfeedQueue<ShapeTree<std::unique_ptr<OutfeedBuffer>>*> {
+ public:
+  // 'buffer_depth' is the number of device buffers of each size kept for
+  // reuse.
+  explicit OutfeedManager(int64 buffer_depth) : buffer_pool_(buffer_depth) {}
+
+  // Returns a cached stream associated with an executor, which copies
+  // outfeed data to the host off the compute stream. Allocates a new stream
+  // on the first invocation. On subsequent invocations, if the cached
+  // executor is not the same as the requested executor, returns null.
+  se::Stream* GetStream(se::StreamExecutor* executor);
+
+  // Returns the pool of buffers that outfeed data is staged in.
+  XfeedBufferPool* buffer_pool() { return &buffer_pool_; }
+
+ private:
+  XfeedBufferPool buffer_pool_;
+
+  // Mutex for serializing the creation of device_to_host_stream_.
+  tensorflow::mutex device_to_host_stream_mu_;
+
+  // Cached device to host stream for copying outfeed data.
+  std::unique_ptr<se::Stream> device_to_host_stream_
+      GUARDED_BY(device_to_host_stream_mu_);
+
+  // Executor that the device_to_host_stream belongs to. Not owned.
+  se::StreamExecutor* device_to_host_executor_ = nullptr;
+};
 
 // Singleton creator-or-accessor: Returns the GPU outfeed manager.
 OutfeedManager* GetOrCreateOutfeedManager();
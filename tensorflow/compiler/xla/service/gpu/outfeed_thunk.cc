@@ -14,6 +14,10 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/compiler/xla/service/gpu/outfeed_thunk.h"
+
+#include <cstring>
+#include <memory>
+
 #include "tensorflow/compiler/xla/literal.h"
 #include "tensorflow/compiler/xla/service/gpu/hlo_execution_profiler.h"
 #include "tensorflow/compiler/xla/service/gpu/outfeed_manager.h"
@@ -44,6 +48,11 @@ Status OutfeedThunk::ExecuteOnStream(
   }
   CHECK(ShapeUtil::Compatible(hlo_instruction()->operand(0)->shape(),
                               outfeed_buffers->shape()));
+  se::Stream* device_to_host_stream =
+      outfeed_manager->GetStream(stream->parent());
+  if (device_to_host_stream == nullptr) {
+    return InternalError("Failed to obtain a stream");
+  }
 
   TF_RETURN_IF_ERROR(outfeed_buffers->ForEachMutableElementWithStatus(
       [&](const ShapeIndex& index, std::unique_ptr<OutfeedBuffer>* buffer) {
@@ -83,23 +92,36 @@ Status OutfeedThunk::ExecuteOnStream(
                                    (*buffer)->length());
         }
 
-        // TODO(b/111309141): Run this on a separate stream so it doesn't block
-        // the GPU from doing work during the transfer. This could be handled by
-        // making StreamAssignment do something intelligent with outfeed thunks.
+        // Snapshot the data on the compute stream, which may overwrite it
+        // while the snapshot is copied to pinned host memory on the
+        // device-to-host stream. Neither the GPU nor the host waits for the
+        // copy to the host.
+        TF_ASSIGN_OR_RETURN(XfeedBufferHandle staging_buffer,
+                            outfeed_manager->buffer_pool()->Acquire(
+                                stream->parent(), (*buffer)->length()));
+        auto staging = std::make_shared<XfeedBufferHandle>(
+            std::move(staging_buffer));
         stream
-            ->ThenMemcpy((*buffer)->destination()->untyped_data(), data_address,
+            ->ThenMemcpy((*staging)->device_memory(), data_address,
                          (*buffer)->length())
-            .ThenDoHostCallback([buffer]() { (*buffer)->Done(); });
+            .ThenRecordEvent((*staging)->event());
+        device_to_host_stream->ThenWaitFor((*staging)->event())
+            .ThenMemcpy((*staging)->host_memory(), *(*staging)->device_memory(),
+                        (*buffer)->length())
+            .ThenDoHostCallback([buffer, staging]() {
+              std::memcpy((*buffer)->destination()->untyped_data(),
+                          (*staging)->host_memory(), (*buffer)->length());
+              (*buffer)->Done();
+            });
         return Status::OK();
       }));
 
-  Status block_status = stream->BlockHostUntilDone();
-  if (!block_status.ok()) {
-    return InternalError("Failed to complete data transfer on stream %p: %s",
-                         stream, block_status.error_message());
+  if (!stream->ok() || !device_to_host_stream->ok()) {
+    return InternalError("Failed to enqueue data transfer on stream %p",
+                         stream);
   }
 
-  VLOG(2) << "Outfeeding from GPU complete";
+  VLOG(2) << "Outfeeding from GPU enqueued";
   return Status::OK();
 }
 
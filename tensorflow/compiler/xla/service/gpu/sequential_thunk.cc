@@ -33,6 +33,15 @@ Status SequentialThunk::Initialize(const GpuExecutable& executable,
   return Status::OK();
 }
 
+bool SequentialThunk::IsCapturable() const {
+  for (const auto& thunk : thunks_) {
+    if (!thunk->IsCapturable()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 Status SequentialThunk::ExecuteOnStream(
     const BufferAllocations& buffer_allocations, se::Stream* stream,
     HloExecutionProfiler* profiler) {
@@ -44,6 +44,7 @@ class SequentialThunk : public Thunk {
   Status ExecuteOnStream(const BufferAllocations& buffer_allocations,
                          se::Stream* stream,
                          HloExecutionProfiler* profiler) override;
+  bool IsCapturable() const override;
 
  private:
   // The list of sub-thunks.
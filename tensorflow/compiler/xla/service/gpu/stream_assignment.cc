@@ -18,8 +18,10 @@ limitations under the License.
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/xla/map_util.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
+#include "tensorflow/compiler/xla/service/gpu/partition_assignment.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_reachability.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 
 namespace xla {
 namespace gpu {
@@ -42,6 +44,24 @@ void StreamAssignment::AssignStreamToHlo(const HloInstruction* hlo,
   VLOG(2) << "Assign stream #" << stream_num << " to " << hlo->ToString();
 }
 
+double StreamAssignment::EstimatedSecondsForHlo(
+    const HloInstruction& hlo) const {
+  auto it = hlo_to_estimated_seconds_.find(&hlo);
+  return it == hlo_to_estimated_seconds_.end() ? 0.0 : it->second;
+}
+
+void StreamAssignment::SetEstimatedSecondsForHlo(const HloInstruction* hlo,
+                                                 double seconds) {
+  hlo_to_estimated_seconds_[hlo] = seconds;
+}
+
+void StreamAssignment::AssignAllToMainStream() {
+  for (auto& hlo_and_stream_number : hlo_to_stream_number_) {
+    hlo_and_stream_number.second = 0;
+  }
+  stream_count_ = 1;
+}
+
 namespace {
 
 // Returns whether the two HLOs can run concurrently, i.e., neither is a
@@ -57,14 +77,98 @@ inline bool IsStreamNumValid(int stream_num) {
   return stream_num != kInvalidStreamNum;
 }
 
+// Kernels estimated to run for less than this aren't worth spreading over
+// streams: the cross-stream synchronization costs about as much as the
+// overlap saves.
+constexpr double kMinConcurrentKernelSeconds = 10e-6;
+
+// What cost-aware stream assignment knows about the instructions and the
+// device.
+struct CostModel {
+  const HloCostAnalysis& cost_analysis;
+  const se::DeviceDescription& device_description;
+};
+
+// Returns the largest array in `shape`.
+const Shape& LargestArraySubshape(const Shape& shape) {
+  const Shape* largest = &shape;
+  int64 largest_elements = -1;
+  ShapeUtil::ForEachSubshape(
+      shape, [&](const Shape& subshape, const ShapeIndex& /*index*/) {
+        if (ShapeUtil::IsArray(subshape) &&
+            ShapeUtil::ElementsIn(subshape) > largest_elements) {
+          largest = &subshape;
+          largest_elements = ShapeUtil::ElementsIn(subshape);
+        }
+      });
+  return *largest;
+}
+
+// Returns the number of thread blocks the kernel of `hlo` launches. Input
+// fusions, e.g. reductions, are parallelized over their largest operand, and
+// the other kernels over their largest output.
+int64 EstimatedBlockCount(const HloInstruction& hlo,
+                          const se::DeviceDescription& device_description) {
+  const Shape* shape = &LargestArraySubshape(hlo.shape());
+  if (hlo.opcode() == HloOpcode::kFusion &&
+      hlo.fusion_kind() == HloInstruction::FusionKind::kInput) {
+    for (const HloInstruction* operand : hlo.operands()) {
+      const Shape& operand_shape = LargestArraySubshape(operand->shape());
+      if (ShapeUtil::IsArray(operand_shape) &&
+          (!ShapeUtil::IsArray(*shape) || ShapeUtil::ElementsIn(operand_shape) >
+                                              ShapeUtil::ElementsIn(*shape))) {
+        shape = &operand_shape;
+      }
+    }
+  }
+  if (!ShapeUtil::IsArray(*shape) || ShapeUtil::IsZeroElementArray(*shape)) {
+    return 0;
+  }
+  return CalculateLaunchDimensions(*shape, device_description).block_count();
+}
+
+// Returns the estimated run time of `hlo`, taking into account that a kernel
+// with fewer blocks than the device has cores doesn't get all of the memory
+// bandwidth the cost analysis assumes.
+double EstimatedSeconds(const HloInstruction& hlo, const CostModel& model) {
+  double seconds = model.cost_analysis.optimal_seconds(hlo);
+  const int64 core_count = model.device_description.core_count();
+  if (hlo.opcode() == HloOpcode::kFusion && core_count > 0) {
+    const int64 block_count =
+        EstimatedBlockCount(hlo, model.device_description);
+    if (block_count > 0 && block_count < core_count) {
+      seconds *= static_cast<double>(core_count) / block_count;
+    }
+  }
+  return seconds;
+}
+
+// Returns whether `hlo` is a fusion kernel that leaves cores of the device
+// idle, and runs long enough that running independent kernels next to it is
+// worth the synchronization.
+bool IsUnderutilizingKernel(const HloInstruction& hlo, double seconds,
+                            const CostModel& model) {
+  if (hlo.opcode() != HloOpcode::kFusion ||
+      seconds < kMinConcurrentKernelSeconds) {
+    return false;
+  }
+  const int64 block_count = EstimatedBlockCount(hlo, model.device_description);
+  return block_count > 0 &&
+         block_count < model.device_description.core_count();
+}
+
 // Returns which existing stream to assign to `hlo`, or -1 if a stream is not
 // needed. `stream_assignment` is the existing stream assignment for all
-// instructions topologically before `hlo`. `seen_gemms` contains all GEMMs that
-// are topologically before `hlo`.
+// instructions topologically before `hlo`. `seen_concurrent` contains all
+// instructions topologically before `hlo` that were spread over streams. If
+// `concurrent` is true, `hlo` is spread over streams too, on the one with the
+// least estimated load in `stream_load` among those it can use.
 int ComputeStreamToAssign(
-    const HloInstruction& hlo, const StreamAssignment& stream_assignment,
+    const HloInstruction& hlo, bool concurrent,
+    const StreamAssignment& stream_assignment,
     const HloReachabilityMap& reachability,
-    const std::vector<const HloInstruction*>& seen_gemms) {
+    const std::vector<const HloInstruction*>& seen_concurrent,
+    const std::vector<double>& stream_load) {
   if (hlo.opcode() == HloOpcode::kParameter ||
       hlo.opcode() == HloOpcode::kConstant) {
     // kParameter and kConstant do not need a thunk.
@@ -78,8 +182,8 @@ int ComputeStreamToAssign(
     return 0;
   }
 
-  if (!ImplementedAsGemm(hlo)) {
-    // If `hlo` is not implemented as a GEMM, keep it close to its operands to
+  if (!concurrent) {
+    // If `hlo` is not spread over streams, keep it close to its operands to
     // avoid excessive synchronization.
     int stream_num = -1;
     for (const auto* operand : hlo.operands()) {
@@ -94,36 +198,46 @@ int ComputeStreamToAssign(
     return stream_num;
   }
 
-  // Assign different streams to concurrent GEMMs. The code below uses a
-  // greedy approach. First, we compute as forbidden_stream_numbers the
-  // streams assigned to GEMMs that are concurrent with `hlo`. Then, we assign
-  // `hlo` a different stream.
+  // Assign different streams to concurrent GEMMs and kernels. The code below
+  // uses a greedy approach. First, we compute as forbidden_stream_numbers the
+  // streams assigned to such instructions that are concurrent with `hlo`.
+  // Then, we assign `hlo` a different stream.
   std::set<int> forbidden_stream_numbers;
-  for (const auto* seen_gemm : seen_gemms) {
-    int stream_num = stream_assignment.StreamNumberForHlo(*seen_gemm);
+  for (const auto* seen : seen_concurrent) {
+    int stream_num = stream_assignment.StreamNumberForHlo(*seen);
     if (!forbidden_stream_numbers.count(stream_num) &&
-        CanRunConcurrently(*seen_gemm, hlo, reachability)) {
+        CanRunConcurrently(*seen, hlo, reachability)) {
       forbidden_stream_numbers.insert(stream_num);
     }
   }
 
+  int best_stream_num = kInvalidStreamNum;
   for (int stream_num = 0; stream_num < stream_assignment.StreamCount();
        ++stream_num) {
-    if (!forbidden_stream_numbers.count(stream_num)) {
+    if (forbidden_stream_numbers.count(stream_num)) {
+      continue;
+    }
+    if (stream_load.empty()) {
       return stream_num;
     }
+    if (!IsStreamNumValid(best_stream_num) ||
+        stream_load[stream_num] < stream_load[best_stream_num]) {
+      best_stream_num = stream_num;
+    }
   }
-  return stream_assignment.StreamCount();
+  return IsStreamNumValid(best_stream_num) ? best_stream_num
+                                           : stream_assignment.StreamCount();
 }
 
-}  // namespace
-
-std::unique_ptr<StreamAssignment> AssignStreams(const HloModule& module) {
+std::unique_ptr<StreamAssignment> AssignStreams(const HloModule& module,
+                                                const CostModel* model) {
   auto stream_assignment = absl::make_unique<StreamAssignment>();
   const HloComputation& computation = *module.entry_computation();
   std::unique_ptr<HloReachabilityMap> reachability =
       computation.ComputeReachability();
-  std::vector<const HloInstruction*> seen_gemms;
+  std::vector<const HloInstruction*> seen_concurrent;
+  // The estimated time each stream is busy, if the assignment is cost-aware.
+  std::vector<double> stream_load;
   // The execution of different RNG Hlo instructions in the same module updates
   // a common global variable. To avoid a race condition, we simply assign all
   // RNG kernels to the same stream to make them run sequentially.
@@ -132,26 +246,55 @@ std::unique_ptr<StreamAssignment> AssignStreams(const HloModule& module) {
   // clean up the code here.
   int stream_num_for_rng = kInvalidStreamNum;
   for (const auto* hlo : computation.MakeInstructionPostOrder()) {
+    double seconds = 0;
+    bool concurrent = ImplementedAsGemm(*hlo);
+    if (model != nullptr) {
+      seconds = EstimatedSeconds(*hlo, *model);
+      concurrent |= IsUnderutilizingKernel(*hlo, seconds, *model);
+      if (stream_load.empty()) {
+        stream_load.push_back(0);
+      }
+    }
     // If we ever enable fusion of RNG instructions, we will need to extend this
     // code to look inside a fused instruction.
     int stream_num = (hlo->opcode() == HloOpcode::kRng &&
                       IsStreamNumValid(stream_num_for_rng))
                          ? stream_num_for_rng
-                         : ComputeStreamToAssign(*hlo, *stream_assignment,
-                                                 *reachability, seen_gemms);
+                         : ComputeStreamToAssign(*hlo, concurrent,
+                                                 *stream_assignment,
+                                                 *reachability,
+                                                 seen_concurrent, stream_load);
     if (IsStreamNumValid(stream_num)) {
       stream_assignment->AssignStreamToHlo(hlo, stream_num);
       if (hlo->opcode() == HloOpcode::kRng &&
           !IsStreamNumValid(stream_num_for_rng)) {
         stream_num_for_rng = stream_num;
       }
+      if (model != nullptr) {
+        stream_assignment->SetEstimatedSecondsForHlo(hlo, seconds);
+        stream_load.resize(stream_assignment->StreamCount(), 0);
+        stream_load[stream_num] += seconds;
+      }
     }
-    if (ImplementedAsGemm(*hlo)) {
-      seen_gemms.push_back(hlo);
+    if (concurrent) {
+      seen_concurrent.push_back(hlo);
     }
   }
   return stream_assignment;
 }
 
+}  // namespace
+
+std::unique_ptr<StreamAssignment> AssignStreams(const HloModule& module) {
+  return AssignStreams(module, /*model=*/nullptr);
+}
+
+std::unique_ptr<StreamAssignment> AssignStreams(
+    const HloModule& module, const HloCostAnalysis& cost_analysis,
+    const se::DeviceDescription& device_description) {
+  CostModel model{cost_analysis, device_description};
+  return AssignStreams(module, &model);
+}
+
 }  // namespace gpu
 }  // namespace xla
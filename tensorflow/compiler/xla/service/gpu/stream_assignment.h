@@ -17,8 +17,10 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_STREAM_ASSIGNMENT_H_
 
 #include "absl/container/flat_hash_map.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
 
 namespace xla {
 namespace gpu {
@@ -32,14 +34,35 @@ class StreamAssignment {
   // `hlo` needs to outlive this StreamAssignment object.
   void AssignStreamToHlo(const HloInstruction* hlo, int stream_no);
 
+  // Returns the estimated time `hlo` takes to run on its stream, or 0 if the
+  // assignment wasn't cost-aware.
+  double EstimatedSecondsForHlo(const HloInstruction& hlo) const;
+  void SetEstimatedSecondsForHlo(const HloInstruction* hlo, double seconds);
+
+  // Moves every HLO that has a stream onto the main stream.
+  void AssignAllToMainStream();
+
  private:
   int stream_count_ = 1;  // At least the main stream.
   absl::flat_hash_map<const HloInstruction*, int> hlo_to_stream_number_;
+  absl::flat_hash_map<const HloInstruction*, double> hlo_to_estimated_seconds_;
 };
 
-// Assigns GPU streams to instructions in `module`.
+// Assigns GPU streams to instructions in `module`. GEMMs that can run
+// concurrently are assigned different streams, and the other instructions
+// follow their operands.
 std::unique_ptr<StreamAssignment> AssignStreams(const HloModule& module);
 
+// Same as above, but also spreads over several streams the independent
+// kernels that are too small to occupy all the cores of `device_description`
+// yet run long enough for the overlap to pay for the synchronization. Each
+// such kernel goes to the least loaded stream it can use. The run times are
+// estimated from `cost_analysis`, which must have visited the entry
+// computation with its bytes per second set.
+std::unique_ptr<StreamAssignment> AssignStreams(
+    const HloModule& module, const HloCostAnalysis& cost_analysis,
+    const se::DeviceDescription& device_description);
+
 }  // namespace gpu
 }  // namespace xla
 
@@ -18,8 +18,10 @@ limitations under the License.
 #include "absl/memory/memory.h"
 #include "absl/strings/str_format.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
 #include "tensorflow/compiler/xla/test_helpers.h"
 #include "tensorflow/compiler/xla/tests/hlo_verified_test_base.h"
 #include "tensorflow/compiler/xla/tests/test_utils.h"
@@ -38,6 +40,67 @@ class StreamAssignmentTest : public HloVerifiedTestBase {
     return absl::make_unique<HloModule>("test_module", config);
   }
 
+  // Parses a module of two independent loop fusions over f32[`rows`,1024],
+  // whose results are added.
+  std::unique_ptr<HloModule> CreateConcurrentFusionsModule(int rows) {
+    HloModuleConfig config;
+    auto debug_options = GetDebugOptionsForTest();
+    debug_options.set_xla_gpu_disable_multi_streaming(false);
+    config.set_debug_options(debug_options);
+    const string shape = absl::StrFormat("f32[%d,1024]{1,0}", rows);
+    return ParseHloString(absl::StrFormat(R"(
+HloModule test_module
+
+fused_exp {
+  p = %s parameter(0)
+  ROOT e = %s exponential(p)
+}
+
+fused_log {
+  p = %s parameter(0)
+  ROOT l = %s log(p)
+}
+
+ENTRY entry {
+  x = %s parameter(0)
+  y = %s parameter(1)
+  exp = %s fusion(x), kind=kLoop, calls=fused_exp
+  log = %s fusion(y), kind=kLoop, calls=fused_log
+  ROOT add = %s add(exp, log)
+}
+)",
+                                          shape, shape, shape, shape, shape,
+                                          shape, shape, shape, shape),
+                          config)
+        .ValueOrDie();
+  }
+
+  // Returns the streams assigned to the two fusions of `module`, taking into
+  // account costs for a GPU with 80 cores and `bytes_per_second` of memory
+  // bandwidth.
+  std::pair<int, int> AssignFusionStreams(HloModule* module,
+                                          float bytes_per_second) {
+    se::internal::DeviceDescriptionBuilder builder;
+    builder.set_core_count(80);
+    builder.set_threads_per_block_limit(1024);
+    builder.set_threads_per_warp(32);
+    builder.set_memory_bandwidth(bytes_per_second);
+    std::unique_ptr<se::DeviceDescription> device_description =
+        builder.Build();
+    HloCostAnalysis cost_analysis(
+        [](const Shape& shape) { return ShapeUtil::ByteSizeOf(shape, 8); });
+    cost_analysis.set_bytes_per_second(bytes_per_second);
+    HloComputation* entry = module->entry_computation();
+    TF_CHECK_OK(entry->Accept(&cost_analysis));
+    std::unique_ptr<StreamAssignment> assignment =
+        AssignStreams(*module, cost_analysis, *device_description);
+    const HloInstruction& exp = *entry->GetInstructionWithName("exp");
+    const HloInstruction& log = *entry->GetInstructionWithName("log");
+    EXPECT_GT(assignment->EstimatedSecondsForHlo(exp), 0);
+    return {assignment->StreamNumberForHlo(exp),
+            assignment->StreamNumberForHlo(log)};
+  }
+
   // Pre-canned shapes.
   Shape f32_2x2_ = ShapeUtil::MakeShape(F32, {2, 2});
 };
@@ -139,5 +202,27 @@ TEST_F(StreamAssignmentTest, LatticeMatMul) {
             assignment->StreamNumberForHlo(*d31));
 }
 
+TEST_F(StreamAssignmentTest, ConcurrentUnderutilizingFusions) {
+  // Each fusion launches 64 blocks of 1024 threads, which leaves 16 of the 80
+  // cores idle, and reads and writes 512KB, which takes about 512us.
+  std::unique_ptr<HloModule> module = CreateConcurrentFusionsModule(64);
+  std::pair<int, int> streams = AssignFusionStreams(module.get(), 1e9);
+  EXPECT_NE(streams.first, streams.second);
+}
+
+TEST_F(StreamAssignmentTest, SequentialFullFusions) {
+  // Each fusion launches 1024 blocks, enough for all the cores.
+  std::unique_ptr<HloModule> module = CreateConcurrentFusionsModule(1024);
+  std::pair<int, int> streams = AssignFusionStreams(module.get(), 1e9);
+  EXPECT_EQ(streams.first, streams.second);
+}
+
+TEST_F(StreamAssignmentTest, SequentialShortFusions) {
+  // Each fusion takes about 512ns, too little to be worth overlapping.
+  std::unique_ptr<HloModule> module = CreateConcurrentFusionsModule(64);
+  std::pair<int, int> streams = AssignFusionStreams(module.get(), 1e12);
+  EXPECT_EQ(streams.first, streams.second);
+}
+
 }  // namespace gpu
 }  // namespace xla
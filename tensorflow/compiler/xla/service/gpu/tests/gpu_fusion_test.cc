@@ -54,6 +54,46 @@ TEST_F(GpuFusionTest, FusedReshape) {
       )");
 }
 
+TEST_F(GpuFusionTest, HorizontallyFusedLoopFusions) {
+  // The two independent loop fusions have different shapes, and are emitted
+  // as a single kernel that computes both.
+  const char* hlo_text = R"(
+    HloModule test_module
+
+    fused_computation.1 {
+      p0.1 = f32[1024]{0} parameter(0)
+      p1.1 = f32[1024]{0} parameter(1)
+      ROOT add.1 = f32[1024]{0} add(p0.1, p1.1)
+    }
+
+    fused_computation.2 {
+      p0.2 = f16[32,16]{1,0} parameter(0)
+      p1.2 = f16[32,16]{1,0} parameter(1)
+      ROOT multiply.2 = f16[32,16]{1,0} multiply(p0.2, p1.2)
+    }
+
+    ENTRY HorizontalFusion {
+      arg.0 = f32[1024]{0} parameter(0)
+      arg.1 = f32[1024]{0} parameter(1)
+      arg.2 = f16[32,16]{1,0} parameter(2)
+      arg.3 = f16[32,16]{1,0} parameter(3)
+      fusion.1 = f32[1024]{0} fusion(arg.0, arg.1), kind=kLoop,
+                                                    calls=fused_computation.1
+      fusion.2 = f16[32,16]{1,0} fusion(arg.2, arg.3), kind=kLoop,
+                                                       calls=fused_computation.2
+      ROOT tuple = (f32[1024]{0}, f16[32,16]{1,0}) tuple(fusion.1, fusion.2)
+    }
+)";
+
+  CompileAndVerifyIr(hlo_text,
+                     R"(
+; CHECK-LABEL: @fusion
+; CHECK: fadd float
+; CHECK: fmul half
+; CHECK: }
+      )");
+}
+
 }  // namespace
 }  // namespace gpu
 }  // namespace xla
@@ -193,6 +193,107 @@ TEST_F(GpuKernelTilingTest,
                      /*match_optimized_ir=*/true);
 }
 
+TEST_F(GpuKernelTilingTest, ColumnReductionTiledInSharedMemory) {
+  const char *const kHloString = R"(
+    HloModule column_reduce
+
+    add {
+      x = f32[] parameter(0)
+      y = f32[] parameter(1)
+      ROOT add = f32[] add(x, y)
+    }
+
+    ENTRY column_reduce {
+      para0 = f32[1024,67]{1,0} parameter(0)
+      zero = f32[] constant(0)
+      ROOT reduce = f32[67]{0} reduce(para0, zero), dimensions={0},
+        to_apply=add
+    })";
+
+  // Check that the partial results are combined in shared memory.
+  auto hlo_module =
+      ParseHloString(kHloString, ConfigWithoutLayoutAssignment()).ValueOrDie();
+  CompileAndVerifyIr(std::move(hlo_module),
+                     R"(
+; CHECK-LABEL: define void @reduce
+; CHECK: addrspace(3)
+; CHECK: tail call void @llvm.nvvm.barrier0()
+; CHECK: }
+)",
+                     /*match_optimized_ir=*/true);
+
+  // Check that the kernel runs correctly.
+  EXPECT_TRUE(RunAndCompareNoHloPasses(kHloString, ErrorSpec{1e-5, 1e-5}));
+}
+
+TEST_F(GpuKernelTilingTest, MiddleDimensionReductionTiledInSharedMemory) {
+  const char *const kHloString = R"(
+    HloModule middle_dim_reduce
+
+    add {
+      x = f16[] parameter(0)
+      y = f16[] parameter(1)
+      ROOT add = f16[] add(x, y)
+    }
+
+    ENTRY middle_dim_reduce {
+      para0 = f16[4,300,128]{2,1,0} parameter(0)
+      zero = f16[] constant(0)
+      ROOT reduce = f16[4,128]{1,0} reduce(para0, zero), dimensions={1},
+        to_apply=add
+    })";
+
+  auto hlo_module =
+      ParseHloString(kHloString, ConfigWithoutLayoutAssignment()).ValueOrDie();
+  CompileAndVerifyIr(std::move(hlo_module),
+                     R"(
+; CHECK-LABEL: define void @reduce
+; CHECK: tail call void @llvm.nvvm.barrier0()
+; CHECK: }
+)",
+                     /*match_optimized_ir=*/true);
+
+  EXPECT_TRUE(RunAndCompareNoHloPasses(kHloString, ErrorSpec{1e-2, 1e-2}));
+}
+
+TEST_F(GpuKernelTilingTest, MultiOutputColumnReductionFusion) {
+  const char *const kHloString = R"(
+    HloModule multi_output_column_reduce
+
+    add {
+      x = f32[] parameter(0)
+      y = f32[] parameter(1)
+      ROOT add = f32[] add(x, y)
+    }
+
+    fused_computation {
+      param0 = f32[8,96,33]{2,1,0} parameter(0)
+      exp = f32[8,96,33]{2,1,0} exponential(param0)
+      zero = f32[] constant(0)
+      reduce = f32[8,33]{1,0} reduce(exp, zero), dimensions={1},
+        to_apply=add
+      ROOT tuple = (f32[8,33]{1,0}, f32[8,96,33]{2,1,0}) tuple(reduce, exp)
+    }
+
+    ENTRY multi_output_column_reduce {
+      para0 = f32[8,96,33]{2,1,0} parameter(0)
+      ROOT fusion = (f32[8,33]{1,0}, f32[8,96,33]{2,1,0}) fusion(para0),
+        kind=kInput, calls=fused_computation
+    })";
+
+  auto hlo_module =
+      ParseHloString(kHloString, ConfigWithoutLayoutAssignment()).ValueOrDie();
+  CompileAndVerifyIr(std::move(hlo_module),
+                     R"(
+; CHECK-LABEL: define void @fusion
+; CHECK: tail call void @llvm.nvvm.barrier0()
+; CHECK: }
+)",
+                     /*match_optimized_ir=*/true);
+
+  EXPECT_TRUE(RunAndCompareNoHloPasses(kHloString, ErrorSpec{1e-5, 1e-5}));
+}
+
 }  // namespace
 }  // namespace gpu
 }  // namespace xla
@@ -86,6 +86,14 @@ class Thunk {
   // time it is run.
   virtual bool WillAutotuneKernel(se::Stream* /*stream*/) { return false; }
 
+  // Returns true if ExecuteOnStream only enqueues device work that is fully
+  // determined by the buffer addresses (kernel launches, memsets and
+  // device-to-device copies). Such thunks can be recorded into a graph once
+  // and replayed while the buffer addresses stay the same. Thunks that read
+  // host memory, synchronize with the host or call into libraries that may do
+  // so must keep the default.
+  virtual bool IsCapturable() const { return false; }
+
   // Execute the kernel for the thunk on the given stream. This method must be
   // called after Initialize and can be called multiple times over Thunk's
   // lifetime. 'stream' and 'profiler' must be non-null.
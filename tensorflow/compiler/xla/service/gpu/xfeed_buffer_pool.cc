@@ -0,0 +1,105 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/xfeed_buffer_pool.h"
+
+#include "tensorflow/compiler/xla/util.h"
+
+namespace xla {
+namespace gpu {
+
+XfeedBuffer::XfeedBuffer(se::StreamExecutor* executor, int64 length)
+    : executor_(executor),
+      length_(length),
+      device_memory_(executor->AllocateArray<uint8>(length)),
+      host_memory_(executor->HostMemoryAllocate(length)),
+      event_(executor) {}
+
+XfeedBuffer::~XfeedBuffer() {
+  if (!device_memory_.is_null()) {
+    executor_->Deallocate(&device_memory_);
+  }
+  if (host_memory_ != nullptr) {
+    executor_->HostMemoryDeallocate(host_memory_);
+  }
+}
+
+XfeedBufferPool::~XfeedBufferPool() {
+  tensorflow::mutex_lock l(mu_);
+  free_buffers_.clear();
+  deferred_frees_.clear();
+}
+
+StatusOr<XfeedBufferHandle> XfeedBufferPool::Acquire(
+    se::StreamExecutor* executor, int64 length) {
+  std::unique_ptr<XfeedBuffer> buffer;
+  // The buffers whose freeing was deferred, freed on return outside the lock.
+  std::vector<std::unique_ptr<XfeedBuffer>> to_free;
+  {
+    tensorflow::mutex_lock l(mu_);
+    to_free.swap(deferred_frees_);
+    auto it = free_buffers_.find({executor, length});
+    if (it != free_buffers_.end() && !it->second.empty()) {
+      buffer = std::move(it->second.back());
+      it->second.pop_back();
+    }
+  }
+  for (auto& deferred : to_free) {
+    if (buffer != nullptr) break;
+    if (deferred->executor_ == executor && deferred->length() == length) {
+      buffer = std::move(deferred);
+    }
+  }
+  if (buffer == nullptr) {
+    buffer.reset(new XfeedBuffer(executor, length));
+    if (buffer->device_memory()->is_null() ||
+        buffer->host_memory() == nullptr) {
+      return ResourceExhausted("Failed to allocate %d bytes for xfeed",
+                               length);
+    }
+    if (!buffer->event()->Init()) {
+      return InternalError("Failed to initialize an event for xfeed");
+    }
+  }
+  return XfeedBufferHandle(buffer.release(),
+                           [this](XfeedBuffer* b) { Release(b); });
+}
+
+void XfeedBufferPool::Release(XfeedBuffer* buffer) {
+  std::unique_ptr<XfeedBuffer> released(buffer);
+  tensorflow::mutex_lock l(mu_);
+  auto& free_buffers = free_buffers_[{buffer->executor_, buffer->length()}];
+  if (free_buffers.size() < depth_) {
+    free_buffers.push_back(std::move(released));
+  } else {
+    // This may run in a stream callback, so the buffer cannot be freed here.
+    deferred_frees_.push_back(std::move(released));
+  }
+}
+
+int64 XfeedBufferPool::NumFreeBuffers(se::StreamExecutor* executor,
+                                      int64 length) {
+  tensorflow::mutex_lock l(mu_);
+  auto it = free_buffers_.find({executor, length});
+  return it == free_buffers_.end() ? 0 : it->second.size();
+}
+
+int64 XfeedBufferPool::NumDeferredFrees() {
+  tensorflow::mutex_lock l(mu_);
+  return deferred_frees_.size();
+}
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,112 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_XFEED_BUFFER_POOL_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_XFEED_BUFFER_POOL_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace xla {
+namespace gpu {
+
+// A device buffer together with a pinned host buffer of the same length and
+// an event. Staging infeed and outfeed data in pinned memory lets their
+// host/device copies run asynchronously, and the event orders the copies on
+// the transfer stream with the computation that uses the device buffer.
+class XfeedBuffer {
+ public:
+  ~XfeedBuffer();
+
+  int64 length() const { return length_; }
+  se::DeviceMemoryBase* device_memory() { return &device_memory_; }
+  void* host_memory() { return host_memory_; }
+  se::Event* event() { return &event_; }
+
+ private:
+  friend class XfeedBufferPool;
+
+  XfeedBuffer(se::StreamExecutor* executor, int64 length);
+
+  se::StreamExecutor* const executor_;
+  const int64 length_;
+  se::DeviceMemoryBase device_memory_;
+  void* host_memory_ = nullptr;
+  se::Event event_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(XfeedBuffer);
+};
+
+// An XfeedBuffer borrowed from an XfeedBufferPool, which it is returned to
+// when the handle is destroyed.
+using XfeedBufferHandle =
+    std::unique_ptr<XfeedBuffer, std::function<void(XfeedBuffer*)>>;
+
+// A thread-safe pool of XfeedBuffers, so that steady-state infeed and
+// outfeed transfers do not allocate device or pinned memory, or synchronize
+// the device to free it.
+//
+// Handles may be destroyed in stream callbacks, where CUDA forbids freeing
+// memory or destroying events. Buffers released beyond the depth of the pool
+// are therefore only freed by the next Acquire() or by the destructor, which
+// must not run in a stream callback.
+class XfeedBufferPool {
+ public:
+  // 'depth' is the number of released buffers of each length and executor
+  // that are kept for reuse.
+  explicit XfeedBufferPool(int64 depth) : depth_(depth) {}
+  ~XfeedBufferPool();
+
+  // Returns a buffer of 'length' bytes on 'executor', reusing a released
+  // one if possible. Never blocks on buffers in use.
+  StatusOr<XfeedBufferHandle> Acquire(se::StreamExecutor* executor,
+                                      int64 length);
+
+  // Returns the number of released buffers kept for reuse, for tests.
+  int64 NumFreeBuffers(se::StreamExecutor* executor, int64 length);
+
+  // Returns the number of released buffers waiting to be freed, for tests.
+  int64 NumDeferredFrees();
+
+ private:
+  // Keeps 'buffer' for reuse, or defers freeing it. Safe to call in a stream
+  // callback.
+  void Release(XfeedBuffer* buffer);
+
+  const int64 depth_;
+
+  tensorflow::mutex mu_;
+  std::map<std::pair<se::StreamExecutor*, int64>,
+           std::vector<std::unique_ptr<XfeedBuffer>>>
+      free_buffers_ GUARDED_BY(mu_);
+  std::vector<std::unique_ptr<XfeedBuffer>> deferred_frees_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(XfeedBufferPool);
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_XFEED_BUFFER_POOL_H_
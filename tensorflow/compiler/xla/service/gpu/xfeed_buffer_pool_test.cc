@@ -0,0 +1,102 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/xfeed_buffer_pool.h"
+
+#include <vector>
+
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+class XfeedBufferPoolTest : public ::testing::Test {
+ protected:
+  XfeedBufferPoolTest() {
+    executor_ = se::MultiPlatformManager::PlatformWithName("CUDA")
+                    .ValueOrDie()
+                    ->ExecutorForDevice(0)
+                    .ValueOrDie();
+  }
+
+  XfeedBufferHandle Acquire(XfeedBufferPool* pool, int64 length) {
+    return pool->Acquire(executor_, length).ConsumeValueOrDie();
+  }
+
+  se::StreamExecutor* executor_;
+};
+
+TEST_F(XfeedBufferPoolTest, ReusesReleasedBuffers) {
+  XfeedBufferPool pool(/*depth=*/2);
+  XfeedBufferHandle buffer = Acquire(&pool, 1024);
+  ASSERT_NE(nullptr, buffer->host_memory());
+  ASSERT_FALSE(buffer->device_memory()->is_null());
+  EXPECT_EQ(1024, buffer->length());
+  XfeedBuffer* raw_buffer = buffer.get();
+  buffer.reset();
+  EXPECT_EQ(1, pool.NumFreeBuffers(executor_, 1024));
+
+  EXPECT_EQ(raw_buffer, Acquire(&pool, 1024).get());
+  // Buffers of other lengths are not reused.
+  EXPECT_NE(raw_buffer, Acquire(&pool, 2048).get());
+}
+
+TEST_F(XfeedBufferPoolTest, KeepsAtMostDepthBuffers) {
+  XfeedBufferPool pool(/*depth=*/2);
+  std::vector<XfeedBufferHandle> buffers;
+  for (int i = 0; i < 3; ++i) {
+    buffers.push_back(Acquire(&pool, 1024));
+  }
+  buffers.clear();
+  EXPECT_EQ(2, pool.NumFreeBuffers(executor_, 1024));
+  EXPECT_EQ(1, pool.NumDeferredFrees());
+
+  // Acquiring frees the buffers beyond the depth.
+  XfeedBufferHandle buffer = Acquire(&pool, 1024);
+  EXPECT_EQ(1, pool.NumFreeBuffers(executor_, 1024));
+  EXPECT_EQ(0, pool.NumDeferredFrees());
+}
+
+TEST_F(XfeedBufferPoolTest, ReleasesInStreamCallbacks) {
+  // Transfers that run ahead of the pool depth release their buffers in
+  // stream callbacks, where they must not be freed.
+  XfeedBufferPool pool(/*depth=*/1);
+  se::Stream stream(executor_);
+  stream.Init();
+  std::vector<XfeedBufferHandle> buffers;
+  for (int i = 0; i < 4; ++i) {
+    buffers.push_back(Acquire(&pool, 1024));
+    XfeedBuffer* buffer = buffers.back().get();
+    stream.ThenMemcpy(buffer->device_memory(), buffer->host_memory(),
+                      buffer->length());
+    stream.ThenRecordEvent(buffer->event());
+  }
+  auto* released = new std::vector<XfeedBufferHandle>(std::move(buffers));
+  stream.ThenDoHostCallback([released]() { delete released; });
+  ASSERT_TRUE(stream.BlockHostUntilDone().ok());
+  EXPECT_EQ(1, pool.NumFreeBuffers(executor_, 1024));
+  EXPECT_EQ(3, pool.NumDeferredFrees());
+
+  // Acquiring, outside the callback, frees the deferred buffers.
+  XfeedBufferHandle buffer = Acquire(&pool, 1024);
+  EXPECT_EQ(0, pool.NumFreeBuffers(executor_, 1024));
+  EXPECT_EQ(0, pool.NumDeferredFrees());
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
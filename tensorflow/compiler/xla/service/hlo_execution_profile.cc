@@ -21,6 +21,7 @@ limitations under the License.
 
 #include "absl/algorithm/container.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_format.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/human_readable_profile_builder.h"
@@ -127,4 +128,40 @@ uint64 HloExecutionProfile::GetCyclesTakenBy(const HloInstruction& hlo) const {
   return profile_counters_[hlo_profile_index_map_.GetProfileIndexFor(hlo)];
 }
 
+void HloExecutionProfile::AddCyclesTakenOnStream(
+    const HloComputation& computation, int stream, uint64 cycles_taken) {
+  CHECK_GE(stream, 0);
+  CHECK(stream_computation_ == nullptr || stream_computation_ == &computation)
+      << "Streams are only profiled for one computation.";
+  stream_computation_ = &computation;
+  if (stream >= static_cast<int>(stream_cycles_.size())) {
+    stream_cycles_.resize(stream + 1, 0);
+  }
+  stream_cycles_[stream] += cycles_taken;
+}
+
+string HloExecutionProfile::ToString(
+    const DeviceDescription& device_description) const {
+  string result =
+      PrintHloProfile(hlo_profile_printer_data_, profile_counters_.data(),
+                      device_description.clock_rate_ghz());
+  if (stream_cycles_.size() < 2) {
+    return result;
+  }
+  // The utilization of a stream is the fraction of the computation's cycles
+  // during which it was running HLOs.
+  const uint64 total_cycles = total_cycles_executed(*stream_computation_);
+  absl::StrAppendFormat(&result, "Stream utilization for %s:\n",
+                        stream_computation_->name());
+  for (int stream = 0; stream < static_cast<int>(stream_cycles_.size());
+       ++stream) {
+    const double percent =
+        total_cycles == 0 ? 0.0
+                          : 100.0 * stream_cycles_[stream] / total_cycles;
+    absl::StrAppendFormat(&result, "  stream %d: %d cycles (%.2f%%)\n", stream,
+                          stream_cycles_[stream], percent);
+  }
+  return result;
+}
+
 }  // namespace xla
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_HLO_EXECUTION_PROFILE_H_
 
 #include <unordered_map>
+#include <vector>
 
 #include "tensorflow/compiler/xla/map_util.h"
 #include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
@@ -113,15 +114,26 @@ class HloExecutionProfile {
         total_cycles_executed;
   }
 
+  // Record that an HLO of `computation` assigned to stream `stream` took
+  // `cycles_taken` cycles to execute, for backends that run the instructions
+  // of a computation on several streams.
+  void AddCyclesTakenOnStream(const HloComputation& computation, int stream,
+                              uint64 cycles_taken);
+
+  // Returns how many cycles the HLOs assigned to `stream` took to execute.
+  uint64 GetCyclesTakenOnStream(int stream) const {
+    return stream < static_cast<int>(stream_cycles_.size())
+               ? stream_cycles_[stream]
+               : 0;
+  }
+
   // Returns a version of the execution profile suitable for performance
   // debugging; e.g. emits cycle counts, execution time at the nominal device
   // frequency, and the effective throughput given the provided cost_analysis
-  // for the operations in a given computation. Returns an empty string if it
+  // for the operations in a given computation, followed by the utilization of
+  // each stream if the HLOs ran on several. Returns an empty string if it
   // wasn't possible to generate a printable version.
-  string ToString(const DeviceDescription& device_description) const {
-    return PrintHloProfile(hlo_profile_printer_data_, profile_counters_.data(),
-                           device_description.clock_rate_ghz());
-  }
+  string ToString(const DeviceDescription& device_description) const;
 
   std::vector<int64>* mutable_profile_counters() { return &profile_counters_; }
   const std::vector<int64>& profile_counters() const {
@@ -135,6 +147,11 @@ class HloExecutionProfile {
   // Stores per-Hlo profile counters.  This is the only thing that changes when
   // we execute an XLA computation.
   std::vector<int64> profile_counters_;
+
+  // The computation whose HLOs ran on several streams, and the cycles taken
+  // by the HLOs of each stream.
+  const HloComputation* stream_computation_ = nullptr;
+  std::vector<uint64> stream_cycles_;
 };
 
 }  // namespace xla
@@ -25,6 +25,8 @@ namespace {
 using absl::StrCat;
 using ::testing::AllOf;
 using ::testing::ContainsRegex;
+using ::testing::HasSubstr;
+using ::testing::Not;
 
 class HloExecutionProfileTest : public HloTestBase {};
 
@@ -71,5 +73,48 @@ TEST_F(HloExecutionProfileTest, Basic) {
                     ContainsRegex(StrCat(add_cycles, R"(\b.*%)",
                                          add_instruction->name()))));
 }
+
+TEST_F(HloExecutionProfileTest, StreamUtilization) {
+  auto hlo_module = ParseHloString(R"(
+  HloModule test_module
+  ENTRY entry_computation {
+    lhs = f32[30,30]{1,0} parameter(0)
+    rhs = f32[30,30]{1,0} parameter(1)
+    add = f32[30,30]{1,0} add(lhs, rhs)
+    ROOT dot = f32[30,30]{1,0} dot(lhs, rhs), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  })")
+                        .ValueOrDie();
+  HloComputation* computation = hlo_module->entry_computation();
+  const HloInstruction* dot_instruction = computation->root_instruction();
+  const HloInstruction* add_instruction =
+      computation->GetInstructionWithName("add");
+
+  HloCostAnalysis cost_analysis(
+      [](const Shape& shape) { return ShapeUtil::ByteSizeOf(shape, 8); });
+  HloProfileIndexMap profile_index_map(*hlo_module);
+  std::unique_ptr<HloProfilePrinterData> profile_printer =
+      CreateHloProfilePrinterData(profile_index_map, cost_analysis);
+  HloExecutionProfile execution_profile(profile_printer.get(),
+                                        &profile_index_map);
+  const se::DeviceDescription& device_description =
+      backend().default_stream_executor()->GetDeviceDescription();
+
+  execution_profile.set_total_cycles_executed(*computation, 5000);
+  execution_profile.SetCyclesTakenBy(add_instruction, 1000);
+  execution_profile.AddCyclesTakenOnStream(*computation, 0, 1000);
+  // A single stream isn't worth reporting.
+  EXPECT_THAT(execution_profile.ToString(device_description),
+              Not(HasSubstr("Stream utilization")));
+
+  execution_profile.SetCyclesTakenBy(dot_instruction, 4000);
+  execution_profile.AddCyclesTakenOnStream(*computation, 1, 4000);
+  EXPECT_EQ(1000, execution_profile.GetCyclesTakenOnStream(0));
+  EXPECT_EQ(4000, execution_profile.GetCyclesTakenOnStream(1));
+  EXPECT_EQ(0, execution_profile.GetCyclesTakenOnStream(2));
+  EXPECT_THAT(execution_profile.ToString(device_description),
+              AllOf(HasSubstr("Stream utilization for entry_computation"),
+                    HasSubstr("stream 0: 1000 cycles (20.00%)"),
+                    HasSubstr("stream 1: 4000 cycles (80.00%)")));
+}
 }  // namespace
 }  // namespace xla
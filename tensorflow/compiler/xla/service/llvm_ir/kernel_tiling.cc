@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -113,5 +114,56 @@ IrArray::Index GetUnreducedOutputIndex(
   return IrArray::Index(linear_index, unreduced_output_shape, b);
 }
 
+llvm::GlobalVariable* AllocateSharedMemoryTile(llvm::Module* module,
+                                               llvm::Type* tile_type,
+                                               absl::string_view name) {
+  const int kNVPTXSharedMemoryAddrSpace = 3;
+  return new llvm::GlobalVariable(
+      *module, tile_type,
+      /*isConstant=*/false, llvm::GlobalValue::PrivateLinkage,
+      llvm::UndefValue::get(tile_type), AsStringRef(name), nullptr,
+      llvm::GlobalValue::NotThreadLocal, kNVPTXSharedMemoryAddrSpace);
+}
+
+ColumnReductionTiling ComputeColumnReductionTiling(int64 depth, int64 height,
+                                                   int64 width,
+                                                   int64 element_bytes,
+                                                   int64 core_count) {
+  constexpr int64 kWarpSize = 32;
+  constexpr int64 kThreadsPerBlock = 256;
+  // Eight blocks of 256 threads fill the 2048 thread slots of a core.
+  constexpr int64 kBlocksPerCore = 8;
+  // Each thread reduces at least this many rows, so that the partial results
+  // are combined and written out rarely compared to the input reads.
+  constexpr int64 kMinRowsPerThread = 8;
+
+  ColumnReductionTiling tiling;
+  // Two 16-bit elements make one 32-bit load, as long as every thread reads
+  // an aligned pair and a warp still has a full row to read.
+  tiling.columns_per_thread =
+      element_bytes <= 2 && width % 2 == 0 && width >= 2 * kWarpSize ? 2 : 1;
+  const int64 thread_columns =
+      std::max<int64>(CeilOfRatio(width, tiling.columns_per_thread), 1);
+  tiling.tile_width = std::min<int64>(
+      kWarpSize, tensorflow::NextPowerOfTwo64(thread_columns));
+  tiling.num_thread_rows =
+      std::min<int64>(kThreadsPerBlock / tiling.tile_width,
+                      tensorflow::NextPowerOfTwo64(std::max<int64>(height, 1)));
+  tiling.num_tiles_x = CeilOfRatio(thread_columns, tiling.tile_width);
+
+  // Split the rows over enough tiles to give every core a few blocks.
+  const int64 column_tiles = std::max<int64>(depth * tiling.num_tiles_x, 1);
+  const int64 wanted_tiles_y = CeilOfRatio(
+      std::max<int64>(core_count, 1) * kBlocksPerCore, column_tiles);
+  const int64 max_tiles_y = std::max<int64>(
+      CeilOfRatio(height, tiling.num_thread_rows * kMinRowsPerThread), 1);
+  const int64 tiles_y = std::min(wanted_tiles_y, max_tiles_y);
+  tiling.rows_per_thread = std::max<int64>(
+      CeilOfRatio(height, tiles_y * tiling.num_thread_rows), 1);
+  tiling.num_tiles_y =
+      std::max<int64>(CeilOfRatio(height, tiling.tile_height()), 1);
+  return tiling;
+}
+
 }  // namespace llvm_ir
 }  // namespace xla
@@ -16,6 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_LLVM_IR_KERNEL_TILING_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_LLVM_IR_KERNEL_TILING_H_
 
+#include "absl/strings/string_view.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Type.h"
 #include "llvm/IR/Value.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/ir_array.h"
@@ -74,6 +78,51 @@ class TiledParameterInfo {
   llvm::Value* x_;
 };
 
+// Adds to `module` a global of type `tile_type` that lives in the shared
+// memory of a thread block (the NVPTX address space 3). The contents of the
+// tile are undefined until the block writes them.
+llvm::GlobalVariable* AllocateSharedMemoryTile(llvm::Module* module,
+                                               llvm::Type* tile_type,
+                                               absl::string_view name);
+
+// Describes how a column reduction is mapped to GPU threads. The input is
+// viewed as `depth` matrices of shape [height, width] in row-major order, and
+// each matrix is reduced along its height to a vector of `width` elements.
+//
+// A thread block covers a tile of num_thread_rows * rows_per_thread rows and
+// tile_width * columns_per_thread columns of one of the matrices. Its threads
+// are arranged as num_thread_rows rows of tile_width threads; each thread
+// accumulates columns_per_thread adjacent columns over the rows
+// {thread_row, thread_row + num_thread_rows, ...} of the tile. The partial
+// results of the block are then combined through shared memory, so that only
+// one atomic update per column leaves the block.
+struct ColumnReductionTiling {
+  // Adjacent columns are loaded together, which lets LLVM use vector loads
+  // for narrow element types.
+  int64 columns_per_thread;
+  // A power of two that is at most the warp size, so that the threads of a
+  // warp read adjacent elements of a row, or of adjacent rows if the matrix is
+  // narrower than a warp.
+  int64 tile_width;
+  int64 num_thread_rows;
+  int64 rows_per_thread;
+  // The number of tiles along the width and height of each matrix.
+  int64 num_tiles_x;
+  int64 num_tiles_y;
+
+  int64 threads_per_block() const { return tile_width * num_thread_rows; }
+  int64 tile_height() const { return num_thread_rows * rows_per_thread; }
+};
+
+// Picks the tiling for a column reduction of `depth` [height, width] matrices
+// with elements of `element_bytes` bytes on a GPU with `core_count` cores.
+// Tiles are made tall enough to amortize the final atomic updates, and short
+// enough to launch a few blocks per core.
+ColumnReductionTiling ComputeColumnReductionTiling(int64 depth, int64 height,
+                                                   int64 width,
+                                                   int64 element_bytes,
+                                                   int64 core_count);
+
 }  // namespace llvm_ir
 }  // namespace xla
 
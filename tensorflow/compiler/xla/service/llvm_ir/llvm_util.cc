@@ -21,12 +21,17 @@ limitations under the License.
 
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/GlobalValue.h"
 #include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Operator.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/literal.h"
 #include "tensorflow/compiler/xla/service/name_uniquer.h"
@@ -601,6 +606,48 @@ Status DumpIRToDirectory(const string& directory_name,
       DumpModuleToString(*DropConstantInitializers(llvm_module)));
 }
 
+std::vector<string> SplitModuleToBitcode(const llvm::Module& module,
+                                         int num_partitions,
+                                         bool preserve_locals) {
+  std::vector<string> partitions;
+  llvm::SplitModule(
+      llvm::CloneModule(module), num_partitions,
+      [&partitions](std::unique_ptr<llvm::Module> partition) {
+        const bool has_definitions =
+            std::any_of(partition->begin(), partition->end(),
+                        [](const llvm::Function& function) {
+                          return !function.isDeclaration();
+                        }) ||
+            std::any_of(partition->global_begin(), partition->global_end(),
+                        [](const llvm::GlobalVariable& global) {
+                          return !global.isDeclaration();
+                        });
+        if (!has_definitions) {
+          return;
+        }
+        std::string bitcode;  // Need a std::string instead of a ::string.
+        {
+          llvm::raw_string_ostream stream(bitcode);
+          llvm::WriteBitcodeToFile(*partition, stream);
+        }
+        partitions.push_back(bitcode);
+      },
+      preserve_locals);
+  return partitions;
+}
+
+StatusOr<std::unique_ptr<llvm::Module>> LoadModuleFromBitcode(
+    const string& bitcode, absl::string_view name, llvm::LLVMContext* context) {
+  llvm::Expected<std::unique_ptr<llvm::Module>> module = llvm::parseBitcodeFile(
+      llvm::MemoryBufferRef(AsStringRef(bitcode), AsStringRef(name)),
+      *context);
+  if (!module) {
+    return InternalError("Failed to load the bitcode of %s: %s", name,
+                         llvm::toString(module.takeError()));
+  }
+  return std::move(module.get());
+}
+
 llvm::Function* CreateFunction(llvm::FunctionType* function_type,
                                llvm::GlobalValue::LinkageTypes linkage,
                                bool enable_fast_math, bool optimize_for_size,
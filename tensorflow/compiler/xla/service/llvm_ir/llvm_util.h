@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_LLVM_IR_LLVM_UTIL_H_
 
 #include <stdint.h>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -283,6 +284,23 @@ Status DumpIRToDirectory(const string& directory_name,
                          const string& hlo_module_name,
                          const llvm::Module& llvm_module, bool optimized);
 
+// Splits `module` into up to `num_partitions` modules that can be optimized
+// and compiled independently, and returns them as bitcode so that each can be
+// loaded into an LLVMContext of its own, e.g. to be compiled on another
+// thread.  Partitions without any definition are dropped.
+//
+// Global values used across partitions are given external linkage and hidden
+// visibility, unless `preserve_locals` is true: local values then stay in the
+// partition of the values that use them, and are never shared.
+std::vector<string> SplitModuleToBitcode(const llvm::Module& module,
+                                         int num_partitions,
+                                         bool preserve_locals);
+
+// Loads a module from bitcode returned by SplitModuleToBitcode() into
+// `context`.
+StatusOr<std::unique_ptr<llvm::Module>> LoadModuleFromBitcode(
+    const string& bitcode, absl::string_view name, llvm::LLVMContext* context);
+
 llvm::Function* CreateFunction(llvm::FunctionType* function_type,
                                llvm::GlobalValue::LinkageTypes linkage,
                                bool enable_fast_math, bool optimize_for_size,
@@ -15,22 +15,29 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/llvm_ir/sort_util.h"
 
+#include <functional>
 #include <vector>
 
 // IWYU pragma: no_include "llvm/IR/Intrinsics.gen.inc"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/Value.h"
+#include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/primitive_util.h"
 #include "tensorflow/compiler/xla/service/gpu/parallel_loop_emitter.h"
 #include "tensorflow/compiler/xla/service/gpu/partition_assignment.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/ir_array.h"
+#include "tensorflow/compiler/xla/service/llvm_ir/kernel_support_library.h"
+#include "tensorflow/compiler/xla/service/llvm_ir/kernel_tiling.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_loop.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
-#include "tensorflow/compiler/xla/service/llvm_ir/loop_emitter.h"
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/types.h"
@@ -39,31 +46,13 @@ namespace xla {
 namespace llvm_ir {
 
 namespace {
-// Adds the inner comparison loop where we compare elements pointed to by
-// 'keys_index' and 'compare_keys_index'.
-void EmitCompareLoop(int64 dimension_to_sort, const IrArray::Index& keys_index,
-                     const IrArray::Index& compare_keys_index,
-                     const IrArray& keys_array,
-                     const std::vector<IrArray>& values_arrays,
-                     llvm::IRBuilder<>* b) {
-  // if (is_smaller_index &&
-  //     compare_keys[dimension_to_sort] < dimension_to_sort_bound)
-  llvm::Value* is_smaller_index = b->CreateICmpSLT(
-      keys_index[dimension_to_sort], compare_keys_index[dimension_to_sort]);
-  int64 dimension_to_sort_bound =
-      keys_array.GetShape().dimensions(dimension_to_sort);
-  auto if_data = EmitIfThenElse(
-      b->CreateAnd(is_smaller_index,
-                   b->CreateICmpSLT(compare_keys_index[dimension_to_sort],
-                                    keys_index.GetConstantWithIndexType(
-                                        dimension_to_sort_bound))),
-      "smaller_comparison_index", b, /*emit_else=*/false);
-  SetToFirstInsertPoint(if_data.true_block, b);
-  auto key1 = keys_array.EmitReadArrayElement(keys_index, b);
-  auto key2 = keys_array.EmitReadArrayElement(compare_keys_index, b);
+
+// Returns whether 'key2' is ordered before 'key1'. Keys of floating point type
+// are compared with a total order, see below.
+llvm::Value* EmitKeyLessThan(PrimitiveType key_type, llvm::Value* key1,
+                             llvm::Value* key2, llvm::IRBuilder<>* b) {
   auto compare_key1 = key1;
   auto compare_key2 = key2;
-  auto key_type = keys_array.GetShape().element_type();
   bool is_signed_comparison = true;
   if (primitive_util::IsFloatingPointType(key_type)) {
     // We would like a total order of floating point numbers so that the sort
@@ -90,55 +79,37 @@ void EmitCompareLoop(int64 dimension_to_sort, const IrArray::Index& keys_index,
   } else if (!primitive_util::IsSignedIntegralType(key_type)) {
     is_signed_comparison = false;
   }
-  auto comparison =
-      b->CreateICmp(is_signed_comparison ? llvm::ICmpInst::ICMP_SLT
-                                         : llvm::ICmpInst::ICMP_ULT,
-                    compare_key2, compare_key1);
-  // If key2 < key1
-  auto if_smaller_data =
-      EmitIfThenElse(comparison, "is_smaller_than", b, /*emit_else=*/false);
-  SetToFirstInsertPoint(if_smaller_data.true_block, b);
-  // Swap key1 with key2.
-  keys_array.EmitWriteArrayElement(keys_index, key2, b);
-  keys_array.EmitWriteArrayElement(compare_keys_index, key1, b);
-  for (const auto& values_array : values_arrays) {
-    // Also swap the values.
-    auto value1 = values_array.EmitReadArrayElement(keys_index, b);
-    auto value2 = values_array.EmitReadArrayElement(compare_keys_index, b);
-    values_array.EmitWriteArrayElement(keys_index, value2, b);
-    values_array.EmitWriteArrayElement(compare_keys_index, value1, b);
-  }
+  return b->CreateICmp(is_signed_comparison ? llvm::ICmpInst::ICMP_SLT
+                                            : llvm::ICmpInst::ICMP_ULT,
+                       compare_key2, compare_key1);
 }
-}  // namespace
-
-Status EmitSortInPlace(int64 dimension_to_sort, const IrArray& keys_array,
-                       const std::vector<IrArray>& values_arrays,
-                       absl::string_view name, llvm::Value* xor_mask,
-                       llvm::IRBuilder<>* b,
-                       const gpu::LaunchDimensions* launch_dimensions) {
-  const Shape& keys_shape = keys_array.GetShape();
-
-  // Create loop nests which loop through the operand dimensions. The sort
-  // dimension is handled in the innermost loop which performs the sorting.
-  ForLoopNest loop_nest(name, b);
-  IrArray::Index keys_index =
-      loop_nest.EmitOperandArrayLoopNest(keys_array, dimension_to_sort, "keys");
-  if (loop_nest.GetInnerLoopBodyBasicBlock() != nullptr) {
-    SetToFirstInsertPoint(loop_nest.GetInnerLoopBodyBasicBlock(), b);
-  }
 
-  // 'compare_keys_index' is the index of the element that 'keys_index' should
-  // be compared to.
-  IrArray::Index compare_keys_index(keys_index.GetType());
-  for (size_t dimension = 0; dimension < keys_index.size(); ++dimension) {
-    if (dimension != dimension_to_sort) {
-      compare_keys_index.push_back(keys_index[dimension]);
-    } else {
-      compare_keys_index.push_back(nullptr);
-    }
-  }
+// Reads or writes element 'index' of the dimension to sort of operand
+// 'operand', where operand 0 holds the keys.
+using ReadElementFn =
+    std::function<llvm::Value*(int64 operand, llvm::Value* index)>;
+using WriteElementFn = std::function<void(int64 operand, llvm::Value* index,
+                                          llvm::Value* value)>;
 
-  // Naive C++ code for the inner compare loop:
+// Emits the comparison of the pair 'element_pair_index' for 'xor_mask' within
+// a dimension to sort with 'iteration_bound' elements, and swaps the elements
+// of all operands if they are out of order.
+void EmitCompareLoopBody(int64 iteration_bound, PrimitiveType key_type,
+                         int64 num_operands, llvm::Value* element_pair_index,
+                         int64 xor_mask, llvm::Type* index_type,
+                         const ReadElementFn& read_element,
+                         const WriteElementFn& write_element,
+                         llvm::IRBuilder<>* b,
+                         bool needs_bounds_checks = true) {
+  auto index_typed_constant = [&](int64 value) {
+    return llvm::ConstantInt::get(index_type, value);
+  };
+  // The element pairs are laid out in blocks of 2 * block_size elements, and
+  // the left element of each pair is in the first half of its block. For a
+  // mask 2^k - 1, the pairs are (i, i ^ mask) within blocks of mask + 1
+  // elements; for a mask 2^k, they are (i, i + mask).
+  //
+  // Naive C++ code for the compare loop over all the pairs:
   //
   // for (int64 i = 0; i < dimension_to_sort_bound; ++i) {
   //   int64 j = i ^ xor_mask;
@@ -151,35 +122,213 @@ Status EmitSortInPlace(int64 dimension_to_sort, const IrArray& keys_array,
   //
   // This follows the algorithm described on Wikipedia:
   // https://en.wikipedia.org/wiki/Bitonic_sorter
-
-  int64 dimension_to_sort_bound =
-      keys_array.GetShape().dimensions(dimension_to_sort);
-  Shape compare_shape = ShapeUtil::MakeShape(keys_shape.element_type(),
-                                             {dimension_to_sort_bound});
-  auto compare_loop_body_emitter =
-      [&](const IrArray::Index& compare_index) -> Status {
-    keys_index[dimension_to_sort] = compare_index[0];
-    compare_keys_index[dimension_to_sort] =
-        b->CreateXor(compare_index[0], xor_mask);
-    EmitCompareLoop(dimension_to_sort, keys_index, compare_keys_index,
-                    keys_array, values_arrays, b);
-    return Status::OK();
+  int64 block_size = xor_mask;
+  if ((xor_mask & (xor_mask + 1)) == 0) {
+    block_size = (xor_mask + 1) / 2;
+  }
+  llvm::Value* current_keys_index;
+  if (block_size == 1) {
+    current_keys_index = b->CreateMul(element_pair_index,
+                                      index_typed_constant(2));
+  } else if (block_size * 2 < iteration_bound) {
+    // current_keys_index = (element_pair_index / block_size) * 2 * block_size
+    //                      + element_pair_index % block_size
+    current_keys_index = b->CreateAdd(
+        b->CreateMul(
+            b->CreateUDiv(element_pair_index, index_typed_constant(block_size)),
+            index_typed_constant(2 * block_size)),
+        b->CreateURem(element_pair_index, index_typed_constant(block_size)));
+  } else {
+    // There is a single block.
+    current_keys_index = element_pair_index;
+  }
+  llvm::Value* compare_keys_index =
+      b->CreateXor(current_keys_index, index_typed_constant(xor_mask));
+  // current_keys_index < compare_keys_index holds by construction.
+  KernelSupportLibrary ksl(b);
+  auto compare_and_swap = [&]() {
+    auto key1 = read_element(0, current_keys_index);
+    auto key2 = read_element(0, compare_keys_index);
+    // If key2 < key1, swap the elements of all operands.
+    ksl.IfReturnVoid(
+        "is_smaller_than", EmitKeyLessThan(key_type, key1, key2, b), [&]() {
+          for (int64 i = 0; i < num_operands; ++i) {
+            auto value1 = read_element(i, current_keys_index);
+            auto value2 = read_element(i, compare_keys_index);
+            write_element(i, current_keys_index, value2);
+            write_element(i, compare_keys_index, value1);
+          }
+        });
   };
-  if (launch_dimensions != nullptr) {
-    TF_RETURN_IF_ERROR(gpu::ParallelLoopEmitter(compare_loop_body_emitter,
-                                                compare_shape,
-                                                *launch_dimensions, b)
-                           .EmitLoop(name));
+  if (needs_bounds_checks) {
+    ksl.IfReturnVoid("smaller_comparison_index",
+                     b->CreateICmpSLT(compare_keys_index,
+                                      index_typed_constant(iteration_bound)),
+                     compare_and_swap);
   } else {
-    TF_RETURN_IF_ERROR(LoopEmitter(compare_loop_body_emitter, compare_shape, b)
-                           .EmitLoop(name));
+    compare_and_swap();
+  }
+}
+
+}  // namespace
+
+Status EmitSortInPlace(int64 dimension_to_sort, const IrArray& keys_array,
+                       const std::vector<IrArray>& values_arrays,
+                       absl::string_view name,
+                       absl::Span<const int64> xor_masks, llvm::IRBuilder<>* b,
+                       const gpu::LaunchDimensions& launch_dimensions,
+                       int64 num_iterations_in_sort_dim, int64 tile_size) {
+  const Shape& keys_shape = keys_array.GetShape();
+  const int64 dimension_to_sort_bound =
+      keys_shape.dimensions(dimension_to_sort);
+  std::vector<const IrArray*> operands;
+  operands.push_back(&keys_array);
+  for (const auto& values_array : values_arrays) {
+    operands.push_back(&values_array);
+  }
+  const int64 num_operands = operands.size();
+
+  // Iterate over all dimensions except the dimension to sort in
+  // major-to-minor order, then over the element pairs of the dimension to
+  // sort. This way a thread block processes a contiguous range of pairs of a
+  // single row of the dimension to sort.
+  std::vector<int64> iteration_dimensions;
+  std::vector<int64> iteration_order_to_logical_order;
+  for (int64 dimension : LayoutUtil::MinorToMajor(keys_shape)) {
+    if (dimension != dimension_to_sort) {
+      iteration_dimensions.insert(iteration_dimensions.begin(),
+                                  keys_shape.dimensions(dimension));
+      iteration_order_to_logical_order.insert(
+          iteration_order_to_logical_order.begin(), dimension);
+    }
   }
+  iteration_dimensions.push_back(num_iterations_in_sort_dim);
+  iteration_order_to_logical_order.push_back(dimension_to_sort);
+  Shape iteration_shape =
+      ShapeUtil::MakeShape(keys_shape.element_type(), iteration_dimensions);
 
-  // Set the IR builder insert point to the exit basic block of the outer most
-  // loop. This ensures later instructions are inserted after this loop nest.
-  b->SetInsertPoint(loop_nest.GetOuterLoopExitBasicBlock());
+  auto compare_loop_body_emitter =
+      [&](const IrArray::Index& tiles_index) -> Status {
+    // The index to sort, without the element pair index in the dimension to
+    // sort, which is filled in below.
+    IrArray::Index keys_index(tiles_index.GetType(),
+                              ShapeUtil::Rank(keys_shape));
+    for (size_t i = 0; i < tiles_index.size(); ++i) {
+      keys_index[iteration_order_to_logical_order[i]] = tiles_index[i];
+    }
+    llvm::Type* index_type = tiles_index.GetType();
+    auto index_typed_constant = [&](int64 value) {
+      return llvm::ConstantInt::get(index_type, value);
+    };
+    llvm::Value* sort_index = tiles_index[tiles_index.size() - 1];
+    auto read_global = [&](int64 operand, llvm::Value* index) {
+      keys_index[dimension_to_sort] = index;
+      return operands[operand]->EmitReadArrayElement(keys_index, b);
+    };
+    auto write_global = [&](int64 operand, llvm::Value* index,
+                            llvm::Value* value) {
+      keys_index[dimension_to_sort] = index;
+      operands[operand]->EmitWriteArrayElement(keys_index, value, b);
+    };
+    if (xor_masks.size() == 1) {
+      EmitCompareLoopBody(dimension_to_sort_bound, keys_shape.element_type(),
+                          num_operands, sort_index, xor_masks[0], index_type,
+                          read_global, write_global, b);
+      return Status::OK();
+    }
 
-  return Status::OK();
+    // Load the tile of this thread block into shared memory, run all the
+    // masks on it, then store it back. Each of the tile_size / 2 threads of
+    // the block copies two elements and compares one pair per mask.
+    llvm::Module* module = b->GetInsertBlock()->getModule();
+    std::vector<llvm::GlobalVariable*> param_shmem_buffers(num_operands);
+    for (int64 i = 0; i < num_operands; ++i) {
+      llvm::Type* tile_type = llvm::ArrayType::get(
+          PrimitiveTypeToIrType(operands[i]->GetShape().element_type(),
+                                module),
+          tile_size);
+      param_shmem_buffers[i] = AllocateSharedMemoryTile(
+          module, tile_type, absl::StrCat(name, "_tile_param_", i));
+    }
+    auto shared_memory_address = [&](int64 operand, llvm::Value* index) {
+      return b->CreateInBoundsGEP(param_shmem_buffers[operand],
+                                  {index_typed_constant(0), index});
+    };
+    auto read_shared = [&](int64 operand, llvm::Value* index) {
+      return b->CreateLoad(shared_memory_address(operand, index));
+    };
+    auto write_shared = [&](int64 operand, llvm::Value* index,
+                            llvm::Value* value) {
+      b->CreateStore(value, shared_memory_address(operand, index));
+    };
+
+    // thread_index is the index of the thread within its block, which is
+    // also its element pair index within the tile.
+    llvm::Value* thread_index =
+        b->CreateURem(sort_index, index_typed_constant(tile_size / 2));
+    llvm::Value* tile_start = b->CreateMul(
+        b->CreateSub(sort_index, thread_index), index_typed_constant(2));
+    KernelSupportLibrary ksl(b);
+    // Adjacent threads copy adjacent elements so that the accesses to global
+    // memory are coalesced.
+    auto for_each_element_of_thread = [&](const std::function<void(
+                                              llvm::Value*, llvm::Value*)>&
+                                              fn) {
+      for (int64 half = 0; half < 2; ++half) {
+        llvm::Value* index_in_tile = b->CreateAdd(
+            thread_index, index_typed_constant(half * tile_size / 2));
+        llvm::Value* global_index = b->CreateAdd(tile_start, index_in_tile);
+        ksl.IfReturnVoid(
+            "in_bounds",
+            b->CreateICmpSLT(global_index,
+                             index_typed_constant(dimension_to_sort_bound)),
+            [&]() { fn(index_in_tile, global_index); });
+      }
+    };
+    for_each_element_of_thread(
+        [&](llvm::Value* index_in_tile, llvm::Value* global_index) {
+          for (int64 i = 0; i < num_operands; ++i) {
+            write_shared(i, index_in_tile, read_global(i, global_index));
+          }
+        });
+    EmitCallToIntrinsic(llvm::Intrinsic::nvvm_barrier0, {}, {}, b);
+
+    auto emit_masks = [&](int64 iteration_bound, bool needs_bounds_checks) {
+      for (int64 xor_mask : xor_masks) {
+        EmitCompareLoopBody(iteration_bound, keys_shape.element_type(),
+                            num_operands, thread_index, xor_mask, index_type,
+                            read_shared, write_shared, b, needs_bounds_checks);
+        EmitCallToIntrinsic(llvm::Intrinsic::nvvm_barrier0, {}, {}, b);
+      }
+    };
+    // Only the last tile of a row can be partial. The condition is the same
+    // for all threads of a block, so the barriers are reached by all of them.
+    if (dimension_to_sort_bound % tile_size != 0) {
+      ksl.IfReturnVoid(
+          "is_last_tile",
+          b->CreateICmpUGT(
+              b->CreateAdd(tile_start, index_typed_constant(tile_size)),
+              index_typed_constant(dimension_to_sort_bound)),
+          [&]() {
+            emit_masks(dimension_to_sort_bound % tile_size,
+                       /*needs_bounds_checks=*/true);
+          },
+          [&]() { emit_masks(tile_size, /*needs_bounds_checks=*/false); });
+    } else {
+      emit_masks(tile_size, /*needs_bounds_checks=*/false);
+    }
+
+    for_each_element_of_thread(
+        [&](llvm::Value* index_in_tile, llvm::Value* global_index) {
+          for (int64 i = 0; i < num_operands; ++i) {
+            write_global(i, global_index, read_shared(i, index_in_tile));
+          }
+        });
+    return Status::OK();
+  };
+  return gpu::ParallelLoopEmitter(compare_loop_body_emitter, iteration_shape,
+                                  launch_dimensions, b)
+      .EmitLoop(name);
 }
 
 }  // namespace llvm_ir
@@ -19,6 +19,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "llvm/IR/Value.h"
 #include "tensorflow/compiler/xla/service/gpu/partition_assignment.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/ir_array.h"
@@ -28,14 +29,25 @@ limitations under the License.
 namespace xla {
 namespace llvm_ir {
 // Emits llvm IR to do pairwise comparisons/swaps in the 'dimension_to_sort'
-// dimension of 'keys_array'. All other dimensions are kept as-is. This
-// implements the inner loop of BitonicSort. If 'launch_dimensions' is nullptr,
-// the inner compare loop will not be parallelized.
+// dimension of 'keys_array', and the same swaps in 'values_arrays'. All other
+// dimensions are kept as-is. This implements the inner loop of BitonicSort.
+// Every element of 'xor_masks' must be a power of 2 or a value 2^k - 1.
+//
+// Each thread compares one pair of elements of the dimension to sort per
+// mask; 'num_iterations_in_sort_dim' is the number of pairs per row and
+// 'launch_dimensions' must cover them. With a single mask, the pairs are
+// compared in place in global memory. With several masks, the dimension to
+// sort is processed in tiles of 'tile_size' elements, a power of 2 greater
+// than every mask: each thread block loads a tile into shared memory, runs
+// all the masks on it and writes it back. Then 'launch_dimensions' must have
+// tile_size / 2 threads per block, and 'num_iterations_in_sort_dim' must be
+// tile_size / 2 times the number of tiles per row.
 Status EmitSortInPlace(int64 dimension_to_sort, const IrArray& keys_array,
                        const std::vector<IrArray>& values_arrays,
-                       absl::string_view name, llvm::Value* xor_mask,
-                       llvm::IRBuilder<>* b,
-                       const gpu::LaunchDimensions* launch_dimensions);
+                       absl::string_view name,
+                       absl::Span<const int64> xor_masks, llvm::IRBuilder<>* b,
+                       const gpu::LaunchDimensions& launch_dimensions,
+                       int64 num_iterations_in_sort_dim, int64 tile_size);
 }  // namespace llvm_ir
 }  // namespace xla
 
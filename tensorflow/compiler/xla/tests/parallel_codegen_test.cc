@@ -0,0 +1,88 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/compiler/xla/types.h"
+
+namespace xla {
+namespace {
+
+class ParallelCodegenTest : public HloTestBase {
+ protected:
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = HloTestBase::GetDebugOptionsForTest();
+    debug_options.set_xla_llvm_parallel_codegen_split_count(4);
+    return debug_options;
+  }
+};
+
+// A module with several computations and kernels, which end up in different
+// partitions and call each other or share constants across partitions.
+TEST_F(ParallelCodegenTest, ComputationsInDifferentPartitions) {
+  const string hlo_string = R"(
+HloModule ParallelCodegen
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+max {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT max = f32[] maximum(lhs, rhs)
+}
+
+body {
+  state = (s32[], f32[8]) parameter(0)
+  i = s32[] get-tuple-element(state), index=0
+  one = s32[] constant(1)
+  next_i = s32[] add(i, one)
+  values = f32[8] get-tuple-element(state), index=1
+  scale = f32[8] constant({1, 2, 3, 4, 5, 6, 7, 8})
+  scaled = f32[8] multiply(values, scale)
+  ROOT next = (s32[], f32[8]) tuple(next_i, scaled)
+}
+
+cond {
+  state = (s32[], f32[8]) parameter(0)
+  i = s32[] get-tuple-element(state), index=0
+  limit = s32[] constant(3)
+  ROOT less = pred[] less-than(i, limit)
+}
+
+ENTRY main {
+  x = f32[8] parameter(0)
+  zero = s32[] constant(0)
+  init = (s32[], f32[8]) tuple(zero, x)
+  loop = (s32[], f32[8]) while(init), condition=cond, body=body
+  result = f32[8] get-tuple-element(loop), index=1
+  exp = f32[8] exponential(x)
+  init_sum = f32[] constant(0)
+  sum = f32[] reduce(result, init_sum), dimensions={0}, to_apply=add
+  init_max = f32[] constant(-inf)
+  largest = f32[] reduce(exp, init_max), dimensions={0}, to_apply=max
+  ROOT out = (f32[], f32[]) tuple(sum, largest)
+}
+)";
+  EXPECT_TRUE(RunAndCompare(hlo_string, ErrorSpec{1e-3, 1e-3}));
+}
+
+}  // namespace
+}  // namespace xla
@@ -37,6 +37,7 @@ limitations under the License.
 #include "absl/types/span.h"
 #include "tensorflow/compiler/xla/array2d.h"
 #include "tensorflow/compiler/xla/array4d.h"
+#include "tensorflow/compiler/xla/client/client_library.h"
 #include "tensorflow/compiler/xla/client/global_data.h"
 #include "tensorflow/compiler/xla/client/lib/arithmetic.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
@@ -45,6 +46,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/literal_util.h"
 #include "tensorflow/compiler/xla/reference_util.h"
+#include "tensorflow/compiler/xla/service/platform_util.h"
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/statusor.h"
@@ -55,6 +57,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace xla {
@@ -855,7 +858,13 @@ INSTANTIATE_TEST_CASE_P(
                       BoundsLayout{{8, 16, 256}, {2, 1, 0}, {2}},
                       BoundsLayout{{2, 300, 784}, {2, 1, 0}, {2}},
                       BoundsLayout{{2, 300, 784}, {2, 1, 0}, {1}},
-                      BoundsLayout{{2, 300, 784}, {2, 1, 0}, {0}}));
+                      BoundsLayout{{2, 300, 784}, {2, 1, 0}, {0}},
+                      // Middle dimension reductions, emitted as batches of
+                      // column reductions on GPU.
+                      BoundsLayout{{4, 1000, 33}, {2, 1, 0}, {1}},
+                      BoundsLayout{{64, 64, 2}, {2, 1, 0}, {1}},
+                      BoundsLayout{{3, 7, 1025}, {2, 1, 0}, {1}},
+                      BoundsLayout{{16, 24, 8}, {0, 1, 2}, {1}}));
 
 XLA_TEST_F(ReduceTest, OperationOnConstantAsInitValue) {
   XlaBuilder builder(TestName());
@@ -980,5 +989,96 @@ XLA_TEST_F(ReduceTest, OrReduceU64) {
   ComputeAndCompareR1<uint64>(&builder, expected, {});
 }
 
+// Benchmarks the reduction of a F32 array of shape `dims` and layout
+// `minor_to_major` along `dims_to_reduce`. If `with_extra_output` is true, the
+// reduced array is computed by an elementwise op whose result is also returned,
+// which makes the reduction a multi-output fusion.
+void BenchmarkReduce(int num_iters, absl::Span<const int64> dims,
+                     absl::Span<const int64> minor_to_major,
+                     absl::Span<const int64> dims_to_reduce,
+                     bool with_extra_output) {
+  tensorflow::testing::StopTiming();
+
+  se::Platform* platform = PlatformUtil::GetDefaultPlatform().ValueOrDie();
+  auto executors = PlatformUtil::GetStreamExecutors(platform).ValueOrDie();
+  StreamExecutorMemoryAllocator allocator(platform, executors);
+  LocalClient* client =
+      ClientLibrary::GetOrCreateLocalClient(platform).ValueOrDie();
+  const int device_ordinal = client->default_device_ordinal();
+
+  const Shape shape = ShapeUtil::MakeShapeWithLayout(F32, dims, minor_to_major);
+  XlaBuilder builder("BenchmarkReduce");
+  auto input = Parameter(&builder, 0, shape, "input");
+  auto to_reduce = with_extra_output ? Exp(input) : input;
+  auto reduce = Reduce(to_reduce, ConstantR0<float>(&builder, 0.0f),
+                       CreateScalarAddComputation(F32, &builder),
+                       dims_to_reduce);
+  if (with_extra_output) {
+    Tuple(&builder, {reduce, to_reduce});
+  }
+  XlaComputation computation = builder.Build().ConsumeValueOrDie();
+
+  ScopedShapedBuffer input_buffer =
+      client
+          ->LiteralToShapedBuffer(Literal::CreateFromShape(shape),
+                                  device_ordinal)
+          .ConsumeValueOrDie();
+  std::unique_ptr<LocalExecutable> executable =
+      client
+          ->Compile(computation, {&input_buffer.on_host_shape()},
+                    ExecutableBuildOptions())
+          .ConsumeValueOrDie();
+
+  se::Stream stream(executors[device_ordinal]);
+  stream.Init();
+  ExecutableRunOptions options;
+  options.set_allocator(&allocator).set_stream(&stream);
+
+  // Run some warm-up executions.
+  const int kWarmups = 2;
+  for (int i = 0; i < kWarmups; ++i) {
+    ASSERT_TRUE(executable->Run({&input_buffer}, options).ok());
+  }
+
+  tensorflow::testing::BytesProcessed(static_cast<int64>(num_iters) *
+                                      ShapeUtil::ByteSizeOf(shape));
+  tensorflow::testing::UseRealTime();
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < num_iters; ++i) {
+    ASSERT_TRUE(executable->Run({&input_buffer}, options).ok());
+  }
+}
+
+void BM_ColumnReduce(int num_iters) {
+  BenchmarkReduce(num_iters, {4096, 1024}, {1, 0}, {0},
+                  /*with_extra_output=*/false);
+}
+
+void BM_NarrowColumnReduce(int num_iters) {
+  BenchmarkReduce(num_iters, {262144, 16}, {1, 0}, {0},
+                  /*with_extra_output=*/false);
+}
+
+void BM_RowReduce(int num_iters) {
+  BenchmarkReduce(num_iters, {1024, 4096}, {1, 0}, {1},
+                  /*with_extra_output=*/false);
+}
+
+void BM_MiddleDimensionReduce(int num_iters) {
+  BenchmarkReduce(num_iters, {32, 1024, 128}, {2, 1, 0}, {1},
+                  /*with_extra_output=*/false);
+}
+
+void BM_MultiOutputColumnReduce(int num_iters) {
+  BenchmarkReduce(num_iters, {4096, 1024}, {1, 0}, {0},
+                  /*with_extra_output=*/true);
+}
+
+BENCHMARK(BM_ColumnReduce);
+BENCHMARK(BM_NarrowColumnReduce);
+BENCHMARK(BM_RowReduce);
+BENCHMARK(BM_MiddleDimensionReduce);
+BENCHMARK(BM_MultiOutputColumnReduce);
+
 }  // namespace
 }  // namespace xla
@@ -13,12 +13,16 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "tensorflow/compiler/tf2xla/xla_op_registry.h"
+#include "tensorflow/compiler/xla/literal.h"
 #include "tensorflow/compiler/xla/service/computation_placer.h"
+#include "tensorflow/compiler/xla/service/service_executable_run_options.h"
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/statusor.h"
@@ -241,6 +245,251 @@ Status XRTExecuteOp::DoWork(OpKernelContext* context) {
 
 XRTExecuteOp::~XRTExecuteOp() = default;
 
+// Returns the value an input or output of a chained execution step refers
+// to, with a reference owned by the caller.
+Status GetChainedValue(XRTTupleAllocation* value, int64 output_index,
+                       XRTTupleAllocation** allocation) {
+  if (output_index == 0) {
+    value->Ref();
+    *allocation = value;
+    return Status::OK();
+  }
+  const xla::Shape& shape = value->on_host_shape();
+  if (!xla::ShapeUtil::IsTuple(shape) || output_index < 0 ||
+      output_index > xla::ShapeUtil::TupleElementCount(shape)) {
+    return errors::InvalidArgument(
+        "Invalid output index ", output_index, " of a value with shape ",
+        xla::ShapeUtil::HumanString(shape));
+  }
+  return XRTTupleAllocation::MakeSubBuffer(value, {output_index - 1},
+                                           allocation,
+                                           /*alias_parent_allocation=*/true);
+}
+
+// XRTExecuteChainedOp
+
+class XRTExecuteChainedOp : public AsyncOpKernel {
+ public:
+  explicit XRTExecuteChainedOp(OpKernelConstruction* context);
+  ~XRTExecuteChainedOp() override;
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override;
+
+ private:
+  Status DoWork(OpKernelContext* context);
+};
+
+XRTExecuteChainedOp::XRTExecuteChainedOp(OpKernelConstruction* context)
+    : AsyncOpKernel(context) {}
+
+void XRTExecuteChainedOp::ComputeAsync(OpKernelContext* context,
+                                       DoneCallback done) {
+  // Schedule onto the default queue, for unbounded concurrency. See b/73520706
+  Env::Default()->SchedClosure([this, context, done]() {
+    OP_REQUIRES_OK_ASYNC(context, DoWork(context), done);
+    done();
+  });
+}
+
+Status XRTExecuteChainedOp::DoWork(OpKernelContext* context) {
+  VLOG(1) << "XRTExecuteChainedOp::Compute";
+  ResourceMgr* rm;
+  TF_RETURN_IF_ERROR(
+      XRTGenericDeviceAccessor::GetResourceManager(context, &rm));
+
+  const Tensor& execution_plan = context->input(0);
+  TF_RET_CHECK(TensorShapeUtils::IsScalar(execution_plan.shape()));
+  xrt::XRTChainedExecutePlan plan;
+  TF_RET_CHECK(plan.ParseFromString(execution_plan.scalar<string>()()));
+
+  const Tensor& execution_config = context->input(1);
+  TF_RET_CHECK(TensorShapeUtils::IsScalar(execution_config.shape()));
+  xrt::XRTChainedExecuteConfig config;
+  TF_RET_CHECK(config.ParseFromString(execution_config.scalar<string>()()));
+  TF_RET_CHECK(config.core_index_in_replica() == 0);
+
+  XRTCompilationCache* cache;
+  TF_RETURN_IF_ERROR(rm->Lookup<XRTCompilationCache>(
+      rm->default_container(), kXRTCompilationCacheResourceName, &cache));
+  core::ScopedUnref cache_unref(cache);
+
+  class XRTGenericDeviceAccessor::ScopedRef device_ref;
+  TF_RETURN_IF_ERROR(
+      XRTGenericDeviceAccessor::InitScopedRef(context, 0, &device_ref));
+  xla::Backend* backend = device_ref.backend();
+  const int device_ordinal = device_ref.device_ordinal();
+
+  // All computations are enqueued on one stream without waiting for earlier
+  // ones, and literals are transferred on a second stream so that their
+  // transfers overlap with the computations enqueued before them.
+  xla::StreamPool::Ptr borrowed_stream;
+  se::Stream* stream = context->op_device_context()
+                           ? context->op_device_context()->stream()
+                           : nullptr;
+  if (stream == nullptr) {
+    TF_ASSIGN_OR_RETURN(borrowed_stream, backend->BorrowStream(device_ordinal));
+    stream = borrowed_stream.get();
+  }
+  xla::StreamPool::Ptr transfer_stream;
+
+  // The value produced by each step, or nullptr once no later step uses it.
+  const int num_ops = plan.ops_size();
+  std::vector<XRTTupleAllocation*> values(num_ops, nullptr);
+  auto value_releaser = gtl::MakeCleanup([&values]() {
+    for (XRTTupleAllocation* value : values) {
+      if (value != nullptr) {
+        value->Unref();
+      }
+    }
+  });
+  std::vector<int> last_use(num_ops, -1);
+  int64 num_results = 0;
+  for (int i = 0; i < num_ops; ++i) {
+    const xrt::XRTChainedExecuteOp& op = plan.ops(i);
+    for (const auto& input : op.inputs()) {
+      if (input.op_index() < 0 || input.op_index() >= i) {
+        return errors::InvalidArgument("Step ", i, " refers to step ",
+                                       input.op_index(),
+                                       ", which does not precede it");
+      }
+      last_use[input.op_index()] = i;
+    }
+    for (const auto& output : op.outputs()) {
+      num_results = std::max<int64>(num_results, output.result_index() + 1);
+    }
+  }
+  std::vector<int64> results(num_results, -1);
+  std::vector<std::unique_ptr<se::Event>> transfer_events(num_ops);
+  std::vector<xla::Literal> literals;
+  literals.reserve(num_ops);
+
+  int rng_seed = config.rng_seed();
+  if (rng_seed == 0) {
+    rng_seed = GetXLARandomSeed();
+  }
+  xla::ExecutableRunOptions run_options;
+  run_options.set_stream(stream);
+  run_options.set_allocator(backend->memory_allocator());
+  run_options.set_intra_op_thread_pool(&context->eigen_cpu_device());
+  run_options.set_rng_seed(rng_seed);
+  xla::ServiceExecutableRunOptions service_run_options(
+      run_options, backend->StreamBorrower(),
+      backend->eigen_intra_op_thread_pool());
+
+  for (int i = 0; i < num_ops; ++i) {
+    const xrt::XRTChainedExecuteOp& op = plan.ops(i);
+    switch (op.op_oneof_case()) {
+      case xrt::XRTChainedExecuteOp::kDataHandle:
+        TF_RETURN_IF_ERROR(
+            XRTTupleAllocation::Lookup(rm, op.data_handle(), &values[i]));
+        break;
+      case xrt::XRTChainedExecuteOp::kLiteral: {
+        TF_ASSIGN_OR_RETURN(xla::Literal literal,
+                            xla::Literal::CreateFromProto(op.literal()));
+        literals.push_back(std::move(literal));
+        if (transfer_stream == nullptr) {
+          TF_ASSIGN_OR_RETURN(transfer_stream,
+                              backend->BorrowStream(device_ordinal));
+        }
+        TF_RETURN_IF_ERROR(XRTTupleAllocation::CreateAndTransferAsync(
+            literals.back(), backend, device_ordinal, transfer_stream.get(),
+            &values[i]));
+        transfer_events[i] =
+            absl::make_unique<se::Event>(transfer_stream->parent());
+        TF_RET_CHECK(transfer_events[i]->Init());
+        transfer_stream->ThenRecordEvent(transfer_events[i].get());
+        break;
+      }
+      case xrt::XRTChainedExecuteOp::kComputationHandle: {
+        std::unique_ptr<XRTCompilationCacheEntryRef> entry;
+        TF_RETURN_IF_ERROR(cache->Lookup(op.computation_handle(), &entry));
+
+        std::vector<XRTTupleAllocation*> input_tuples;
+        auto input_releaser = gtl::MakeCleanup([&input_tuples]() {
+          for (XRTTupleAllocation* tuple : input_tuples) {
+            tuple->Unref();
+          }
+        });
+        std::vector<xla::ShapedBuffer> input_allocations;
+        for (const auto& input : op.inputs()) {
+          const int64 op_index = input.op_index();
+          TF_RET_CHECK(values[op_index] != nullptr);
+          XRTTupleAllocation* tuple;
+          TF_RETURN_IF_ERROR(
+              GetChainedValue(values[op_index], input.output_index(), &tuple));
+          input_tuples.push_back(tuple);
+          input_allocations.push_back(tuple->ToShapedBuffer());
+          if (transfer_events[op_index] != nullptr) {
+            stream->ThenWaitFor(transfer_events[op_index].get());
+          }
+        }
+        std::vector<xla::ShapedBuffer*> input_pointers;
+        for (xla::ShapedBuffer& allocation : input_allocations) {
+          input_pointers.push_back(&allocation);
+        }
+
+        VLOG(2) << "Enqueuing computation of step " << i;
+        xla::Executable* executable =
+            entry->get().get_executable()->executable();
+        TF_ASSIGN_OR_RETURN(xla::ScopedShapedBuffer result,
+                            executable->ExecuteAsyncOnStream(
+                                &service_run_options, input_pointers));
+        auto shaped_buffer = result.release();
+        TF_RETURN_IF_ERROR(XRTTupleAllocation::CreateFromBuffer(
+            shaped_buffer, backend, device_ordinal, &values[i]));
+        break;
+      }
+      default:
+        return errors::InvalidArgument("Step ", i, " has no operation");
+    }
+
+    for (const auto& output : op.outputs()) {
+      if (output.result_index() < 0) {
+        return errors::InvalidArgument("Invalid result index ",
+                                       output.result_index());
+      }
+      XRTTupleAllocation* result;
+      TF_RETURN_IF_ERROR(
+          GetChainedValue(values[i], output.output_index(), &result));
+      // Intern takes ownership of our reference to result.
+      TF_RETURN_IF_ERROR(result->Intern(rm, &results[output.result_index()]));
+    }
+
+    // Buffers of values that are no longer needed are freed right away, so
+    // that later steps can reuse their memory. This is safe because all steps
+    // that used them are enqueued on the same stream.
+    for (const auto& input : op.inputs()) {
+      const int64 op_index = input.op_index();
+      if (last_use[op_index] == i && values[op_index] != nullptr) {
+        values[op_index]->Unref();
+        values[op_index] = nullptr;
+      }
+    }
+    if (last_use[i] < 0 && transfer_events[i] == nullptr) {
+      values[i]->Unref();
+      values[i] = nullptr;
+    }
+  }
+
+  if (transfer_stream != nullptr) {
+    TF_RETURN_IF_ERROR(transfer_stream->BlockHostUntilDone());
+  }
+  TF_RETURN_IF_ERROR(stream->BlockHostUntilDone());
+
+  Tensor* output_tensor;
+  TF_RETURN_IF_ERROR(context->allocate_output(
+      0, TensorShape({static_cast<int64>(results.size())}), &output_tensor));
+  for (int64 i = 0; i < results.size(); ++i) {
+    if (results[i] < 0) {
+      return errors::InvalidArgument("No step returns result ", i);
+    }
+    output_tensor->vec<int64>()(i) = results[i];
+  }
+  return Status::OK();
+}
+
+XRTExecuteChainedOp::~XRTExecuteChainedOp() = default;
+
 }  // namespace
 
 REGISTER_KERNEL_BUILDER(Name("XRTExecute")
@@ -259,4 +508,18 @@ REGISTER_KERNEL_BUILDER(Name("XRTExecute")
                             .HostMemory("output_handle"),
                         XRTExecuteOp);
 
+REGISTER_KERNEL_BUILDER(Name("XRTExecuteChained")
+                            .Device(DEVICE_XLA_CPU)
+                            .HostMemory("execution_plan")
+                            .HostMemory("execution_config")
+                            .HostMemory("output_handles"),
+                        XRTExecuteChainedOp);
+
+REGISTER_KERNEL_BUILDER(Name("XRTExecuteChained")
+                            .Device(DEVICE_XLA_GPU)
+                            .HostMemory("execution_plan")
+                            .HostMemory("execution_config")
+                            .HostMemory("output_handles"),
+                        XRTExecuteChainedOp);
+
 }  // namespace tensorflow
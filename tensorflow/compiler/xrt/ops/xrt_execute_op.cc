@@ -50,4 +50,28 @@ computation.
 'Ninputs' is the number of input handles.
 )");
 
+REGISTER_OP("XRTExecuteChained")
+    .Input("execution_plan: string")
+    .Input("execution_config: string")
+    .Output("output_handles: int64")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+      c->set_output(0, c->UnknownShapeOfRank(1));
+      return Status::OK();
+    })
+    .Doc(
+        R"(
+Runs a sequence of previously-compiled computations on a core, where the
+outputs of earlier computations can be inputs of later ones without leaving the
+device. All computations are enqueued on one stream, and literals in the plan
+are transferred while earlier computations run.
+
+'execution_plan' is a serialized xrt::XRTChainedExecutePlan proto.
+'execution_config' is a serialized xrt::XRTChainedExecuteConfig proto.
+'output_handles' are the ids of the allocations returned by the plan, indexed
+by their result_index.
+)");
+
 }  // namespace tensorflow
@@ -671,6 +671,89 @@ TEST(RawApiTest, CompileAndExecuteReturnTuple) {
   EXPECT_TRUE(CompareLiteralToLiteralProto(expected, response));
 }
 
+TEST(RawApiTest, ExecuteChained) {
+  xrt::XLAAllocation p0;
+  p0.set_device_ordinal(0);
+  *p0.mutable_value() = FloatVector({1.0f, 2.0f});
+
+  xrt::XLAComputation c;
+  auto config = c.mutable_config();
+  auto shapes = config->mutable_program_shape();
+  *shapes->add_parameters() = xla::ShapeUtil::MakeShape(xla::F32, {2});
+  *shapes->add_parameters() = xla::ShapeUtil::MakeShape(xla::F32, {2});
+  *shapes->mutable_result() = xla::ShapeUtil::MakeShape(xla::F32, {2});
+  StoreComputationSnapshot(AddAndScale(), c.mutable_hlo_snapshot());
+
+  Scope root = Scope::NewRootScope().WithDevice(DeviceFromFlag());
+  auto computation =
+      ops::Const(root.WithDevice("/device:CPU:0"), c.SerializeAsString());
+  auto c_handle = ops::XRTCompile(root, computation);
+  auto p0_value =
+      ops::Const(root.WithDevice("/device:CPU:0"), p0.SerializeAsString());
+  auto p0_handle = ops::XRTAllocate(root, p0_value);
+  TF_ASSERT_OK(root.status());
+
+  ClientSession session(root);
+  std::vector<Tensor> outputs;
+  TF_EXPECT_OK(session.Run({c_handle.handle, p0_handle}, &outputs));
+  const int64 compilation_handle = outputs[0].scalar<int64>()();
+  const int64 p0_data_handle = outputs[1].scalar<int64>()();
+
+  // (p0 + p1) * 3 = {27, 21}, then ({27, 21} + p2) * 3 = {84, 66}.
+  xrt::XRTChainedExecutePlan plan;
+  plan.add_ops()->set_data_handle(p0_data_handle);
+  *plan.add_ops()->mutable_literal() = FloatVector({8.0f, 5.0f});
+  xrt::XRTChainedExecuteOp* first = plan.add_ops();
+  first->set_computation_handle(compilation_handle);
+  first->add_inputs()->set_op_index(0);
+  first->add_inputs()->set_op_index(1);
+  xrt::XRTChainedExecuteOp::Output* first_output = first->add_outputs();
+  first_output->set_result_index(1);
+  *plan.add_ops()->mutable_literal() = FloatVector({1.0f, 1.0f});
+  xrt::XRTChainedExecuteOp* second = plan.add_ops();
+  second->set_computation_handle(compilation_handle);
+  second->add_inputs()->set_op_index(2);
+  second->add_inputs()->set_op_index(3);
+  second->add_outputs()->set_result_index(0);
+
+  xrt::XRTChainedExecuteConfig e;
+  Scope chained_root = Scope::NewRootScope().WithDevice(DeviceFromFlag());
+  auto plan_value = ops::Const(chained_root.WithDevice("/device:CPU:0"),
+                               plan.SerializeAsString());
+  auto e_config = ops::Const(chained_root.WithDevice("/device:CPU:0"),
+                             e.SerializeAsString());
+  auto results = ops::XRTExecuteChained(chained_root, plan_value, e_config);
+  auto handles = ops::Unstack(chained_root, results, 2);
+  auto read_back0 =
+      ops::XRTReadLiteralAndRelease(chained_root, handles.output[0]);
+  auto read_back1 =
+      ops::XRTReadLiteralAndRelease(chained_root, handles.output[1]);
+  auto p0_handle_value =
+      ops::Const(chained_root.WithDevice("/device:CPU:0"), p0_data_handle);
+  auto c_handle_value =
+      ops::Const(chained_root.WithDevice("/device:CPU:0"), compilation_handle);
+  auto release = ops::XRTReleaseAllocationHandle(
+      chained_root.WithControlDependencies({read_back0, read_back1}),
+      p0_handle_value);
+  auto release_computation = ops::XRTReleaseCompilationHandle(
+      chained_root.WithControlDependencies({read_back0, read_back1}),
+      c_handle_value);
+  TF_ASSERT_OK(chained_root.status());
+
+  ClientSession chained_session(chained_root);
+  TF_EXPECT_OK(chained_session.Run(ClientSession::FeedType(),
+                                   {read_back0, read_back1},
+                                   {release, release_computation}, &outputs));
+
+  xla::LiteralProto response;
+  EXPECT_TRUE(response.ParseFromString(outputs[0].scalar<string>()()));
+  EXPECT_TRUE(CompareLiteralToLiteralProto(
+      xla::LiteralUtil::CreateR1<float>({84.0f, 66.0f}), response));
+  EXPECT_TRUE(response.ParseFromString(outputs[1].scalar<string>()()));
+  EXPECT_TRUE(CompareLiteralToLiteralProto(
+      xla::LiteralUtil::CreateR1<float>({27.0f, 21.0f}), response));
+}
+
 TEST(RawApiTest, LeakCompilationReference) {
   xrt::XLAComputation c;
   auto config = c.mutable_config();
@@ -147,18 +147,41 @@ XRTTupleAllocation::~XRTTupleAllocation() {
   TF_ASSIGN_OR_RETURN(auto stream, backend->BorrowStream(device_ordinal));
   TF_RETURN_IF_ERROR(transfer_manager->TransferLiteralToDevice(
       stream.get(), literal, *scoped_buffer));
+  *allocation = CreateFromScopedBuffer(scoped_buffer.get(), allocator,
+                                       device_ordinal);
+  return Status::OK();
+}
+
+/*static*/ Status XRTTupleAllocation::CreateAndTransferAsync(
+    const xla::Literal& literal, xla::Backend* backend, int device_ordinal,
+    se::Stream* stream, XRTTupleAllocation** allocation) {
+  auto transfer_manager = backend->transfer_manager();
+  auto allocator = backend->memory_allocator();
 
+  std::unique_ptr<xla::ScopedShapedBuffer> scoped_buffer;
+  TF_RETURN_IF_ERROR(AllocateScopedShapedBuffer(
+      backend, device_ordinal, literal.shape(), &scoped_buffer));
+  TF_RETURN_IF_ERROR(transfer_manager->TransferLiteralToDeviceAsync(
+      stream, literal, *scoped_buffer));
+  *allocation = CreateFromScopedBuffer(scoped_buffer.get(), allocator,
+                                       device_ordinal);
+  return Status::OK();
+}
+
+/*static*/ XRTTupleAllocation* XRTTupleAllocation::CreateFromScopedBuffer(
+    xla::ScopedShapedBuffer* scoped_buffer,
+    xla::DeviceMemoryAllocator* allocator, int device_ordinal) {
   // By releasing the ScopedShapedBuffer we ensure that the underlying storage
   // won't be freed when the buffer goes out of scope at the end of this
   // call. To avoid a leak, there must be no error-case returns from here until
   // the end of the method.
   auto shaped_buffer = scoped_buffer->release();
-  *allocation = new XRTTupleAllocation(device_ordinal, allocator,
-                                       shaped_buffer.on_host_shape(),
-                                       shaped_buffer.on_device_shape());
-  (*allocation)
-      ->InitializeFromShapedBuffer(shaped_buffer, allocator, device_ordinal);
-  return Status::OK();
+  XRTTupleAllocation* allocation = new XRTTupleAllocation(
+      device_ordinal, allocator, shaped_buffer.on_host_shape(),
+      shaped_buffer.on_device_shape());
+  allocation->InitializeFromShapedBuffer(shaped_buffer, allocator,
+                                         device_ordinal);
+  return allocation;
 }
 
 /*static*/ Status XRTTupleAllocation::CreateFromBuffer(
@@ -84,6 +84,14 @@ class XRTTupleAllocation : public ResourceBase {
                                   xla::Backend* backend, int device_ordinal,
                                   XRTTupleAllocation** allocation);
 
+  // Like CreateAndTransfer, but only enqueues the transfer on stream. The
+  // literal must stay alive until the transfer completes, and users of the
+  // allocation on other streams must wait for it.
+  static Status CreateAndTransferAsync(const xla::Literal& literal,
+                                       xla::Backend* backend,
+                                       int device_ordinal, se::Stream* stream,
+                                       XRTTupleAllocation** allocation);
+
   // Wraps an existing ShapeBuffer in a new XRTTupleAllocation handle.
   static Status CreateFromBuffer(const xla::ShapedBuffer& shaped_buffer,
                                  xla::Backend* backend, int device_ordinal,
@@ -173,6 +181,12 @@ class XRTTupleAllocation : public ResourceBase {
                      const xla::Shape& on_host_shape,
                      const xla::Shape& on_device_shape);
 
+  // Transfers the buffers of scoped_buffer, whose contents have been
+  // transferred or enqueued for transfer, to a new handle.
+  static XRTTupleAllocation* CreateFromScopedBuffer(
+      xla::ScopedShapedBuffer* scoped_buffer,
+      xla::DeviceMemoryAllocator* allocator, int device_ordinal);
+
   // Inherits the allocations represented in buffer, which must have the same
   // shape as buffers_.
   void InitializeFromShapedBuffer(const xla::ShapedBuffer& shaped_buffer,
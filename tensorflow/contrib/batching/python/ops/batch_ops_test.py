@@ -345,6 +345,90 @@ class BatchOpsTest(test.TestCase):
                                    ".*2 arguments.*but 1.*"):
         sess.run([result], feed_dict={inp: [2]})
 
+  def testBatchFunctionOpWithCopiedOutputs(self):
+    """Tests that batch_function op works with copy_split_outputs."""
+    with self.cached_session() as sess:
+
+      @function.Defun(dtypes.float32)
+      def computation(in_t):
+        return in_t * 2
+
+      inp = array_ops.placeholder(dtype=dtypes.float32, shape=[1, 3])
+      result = gen_batch_ops.batch_function(
+          [inp],
+          num_batch_threads=1,
+          max_batch_size=10,
+          batch_timeout_micros=100000,  # 100ms
+          copy_split_outputs=True,
+          Tout=[dtypes.float32],
+          f=computation,
+          captured_tensors=computation.captured_inputs)
+      thread_results = []
+
+      def worker():
+        thread_results.extend(
+            sess.run([result], feed_dict={inp: [[1, 2, 3]]}))
+
+      worker_thread = threading.Thread(target=worker)
+      worker_thread.start()
+      main_results = sess.run([result], feed_dict={inp: [[4, 5, 6]]})
+      worker_thread.join()
+      self.assertAllEqual(thread_results[0], [[2, 4, 6]])
+      self.assertAllEqual(main_results[0], [[8, 10, 12]])
+
+  def testBatchFunctionOpWithBuckets(self):
+    """Tests that batch_function pads and cuts inputs of a bucket."""
+    with self.cached_session() as sess:
+      inp = array_ops.placeholder(dtype=dtypes.int32, shape=[1, None])
+
+      @function.Defun(dtypes.int32)
+      def computation(in_t):
+        return in_t + 1
+
+      result = gen_batch_ops.batch_function(
+          [inp],
+          num_batch_threads=1,
+          max_batch_size=10,
+          batch_timeout_micros=100000,  # 100ms
+          bucket_boundaries=[4, 8],
+          Tout=[dtypes.int32],
+          f=computation,
+          captured_tensors=computation.captured_inputs)
+      thread_results = []
+
+      def worker():
+        thread_results.extend(sess.run([result], feed_dict={inp: [[1, 2]]}))
+
+      worker_thread = threading.Thread(target=worker)
+      worker_thread.start()
+      main_results = sess.run([result], feed_dict={inp: [[1, 2, 3]]})
+      worker_thread.join()
+      self.assertAllEqual(thread_results[0], [[2, 3]])
+      self.assertAllEqual(main_results[0], [[2, 3, 4]])
+
+  def testBatchFunctionOpWithLargeBatchSplitting(self):
+    """Tests that batch_function splits invocations over max_batch_size."""
+    with self.cached_session() as sess:
+      inp = array_ops.placeholder(dtype=dtypes.int32, shape=[None])
+
+      @function.Defun(dtypes.int32)
+      def computation(in_t):
+        return in_t + 1
+
+      result = gen_batch_ops.batch_function(
+          [inp],
+          num_batch_threads=2,
+          max_batch_size=2,
+          batch_timeout_micros=100000,  # 100ms
+          max_enqueued_batches=4,
+          enable_large_batch_splitting=True,
+          Tout=[dtypes.int32],
+          f=computation,
+          captured_tensors=computation.captured_inputs)
+      self.assertAllEqual(
+          sess.run([result], feed_dict={inp: [1, 2, 3, 4, 5]})[0],
+          [2, 3, 4, 5, 6])
+
   def testBasicUnbatchDecoratedWithReshape(self):
     """Tests that the batch_function decorator works."""
     with self.cached_session() as sess:
@@ -22,7 +22,30 @@ namespace {
 
 class BigtableScanDatasetOp : public DatasetOpKernel {
  public:
-  using DatasetOpKernel::DatasetOpKernel;
+  explicit BigtableScanDatasetOp(OpKernelConstruction* ctx)
+      : DatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("start_timestamp_micros",
+                                     &start_timestamp_micros_));
+    OP_REQUIRES_OK(
+        ctx, ctx->GetAttr("end_timestamp_micros", &end_timestamp_micros_));
+    // Cloud Bigtable stores timestamps with a millisecond granularity.
+    OP_REQUIRES(ctx,
+                start_timestamp_micros_ >= 0 &&
+                    start_timestamp_micros_ % 1000 == 0 &&
+                    end_timestamp_micros_ >= 0 &&
+                    end_timestamp_micros_ % 1000 == 0,
+                errors::InvalidArgument(
+                    "Timestamps must be non-negative multiples of 1000 "
+                    "microseconds. Got: [",
+                    start_timestamp_micros_, ", ", end_timestamp_micros_,
+                    ")"));
+    OP_REQUIRES(ctx,
+                end_timestamp_micros_ == 0 ||
+                    start_timestamp_micros_ < end_timestamp_micros_,
+                errors::InvalidArgument("Empty timestamp range: [",
+                                        start_timestamp_micros_, ", ",
+                                        end_timestamp_micros_, ")"));
+  }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
     string prefix;
@@ -82,7 +105,9 @@ class BigtableScanDatasetOp : public DatasetOpKernel {
     *output = new Dataset(ctx, resource, std::move(prefix),
                           std::move(start_key), std::move(end_key),
                           std::move(column_families), std::move(columns),
-                          probability, output_types, std::move(output_shapes));
+                          probability, start_timestamp_micros_,
+                          end_timestamp_micros_, output_types,
+                          std::move(output_shapes));
   }
 
  private:
@@ -92,6 +117,7 @@ class BigtableScanDatasetOp : public DatasetOpKernel {
                      string prefix, string start_key, string end_key,
                      std::vector<string> column_families,
                      std::vector<string> columns, float probability,
+                     int64 start_timestamp_micros, int64 end_timestamp_micros,
                      const DataTypeVector& output_types,
                      std::vector<PartialTensorShape> output_shapes)
         : DatasetBase(DatasetContext(ctx)),
@@ -104,6 +130,8 @@ class BigtableScanDatasetOp : public DatasetOpKernel {
           column_family_regex_(RegexFromStringSet(column_families_)),
           column_regex_(RegexFromStringSet(columns_)),
           probability_(probability),
+          start_timestamp_micros_(start_timestamp_micros),
+          end_timestamp_micros_(end_timestamp_micros),
           output_types_(output_types),
           output_shapes_(std::move(output_shapes)) {
       table_->Ref();
@@ -159,7 +187,17 @@ class BigtableScanDatasetOp : public DatasetOpKernel {
       }
       ::google::cloud::bigtable::Filter MakeFilter() override {
         // TODO(saeta): Investigate optimal ordering here.
+        // The timestamp range goes first, so that the latest cell within the
+        // range is read rather than the latest cell overall.
+        const bool has_timestamp_range =
+            dataset()->start_timestamp_micros_ != 0 ||
+            dataset()->end_timestamp_micros_ != 0;
         return ::google::cloud::bigtable::Filter::Chain(
+            has_timestamp_range
+                ? ::google::cloud::bigtable::Filter::TimestampRangeMicros(
+                      dataset()->start_timestamp_micros_,
+                      dataset()->end_timestamp_micros_)
+                : ::google::cloud::bigtable::Filter::PassAllFilter(),
             ::google::cloud::bigtable::Filter::Latest(1),
             ::google::cloud::bigtable::Filter::FamilyRegex(
                 dataset()->column_family_regex_),
@@ -217,9 +255,15 @@ class BigtableScanDatasetOp : public DatasetOpKernel {
     const string column_family_regex_;
     const string column_regex_;
     const float probability_;
+    // A range of 0 to 0 reads cells of all timestamps.
+    const int64 start_timestamp_micros_;
+    const int64 end_timestamp_micros_;
     const DataTypeVector output_types_;
     const std::vector<PartialTensorShape> output_shapes_;
   };
+
+  int64 start_timestamp_micros_;
+  int64 end_timestamp_micros_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("BigtableScanDataset").Device(DEVICE_CPU),
@@ -239,6 +239,9 @@ class ReadRowsResponse : public grpc::ClientReaderInterface<
           case google::bigtable::v2::RowFilter::kRowSampleFilter:
             LOG(INFO) << "Ignoring row sample directive.";
             break;
+          case google::bigtable::v2::RowFilter::kTimestampRangeFilter:
+            LOG(INFO) << "Ignoring timestamp range directive.";
+            break;
           case google::bigtable::v2::RowFilter::kPassAllFilter:
             break;
           case google::bigtable::v2::RowFilter::kCellsPerRowLimitFilter:
@@ -100,6 +100,8 @@ REGISTER_OP("BigtableScanDataset")
     .Input("columns: string")
     .Input("probability: float")
     .Output("handle: variant")
+    .Attr("start_timestamp_micros: int = 0")
+    .Attr("end_timestamp_micros: int = 0")
     .SetIsStateful()  // TODO(b/65524810): Source dataset ops must be marked
                       // stateful to inhibit constant folding.
     .SetShapeFn(shape_inference::ScalarShape);
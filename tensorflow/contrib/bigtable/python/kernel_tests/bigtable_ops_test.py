@@ -117,6 +117,19 @@ class BigtableOpsTest(test.TestCase):
   def testScanRangeTupleCol(self):
     self.runScanTest(self._table.scan_range("r1", "r4", columns=("cf1", "c1")))
 
+  def testScanRangeWithTimestampRange(self):
+    # The test client does not store timestamps, and ignores the range.
+    self.runScanTest(
+        self._table.scan_range(
+            "r1", "r4", cf1="c1", timestamp_range=(1000, 0)))
+
+  def testScanRangeWithInvalidTimestampRange(self):
+    ds = self._table.scan_range("r1", "r4", cf1="c1", timestamp_range=(1, 0))
+    itr = ds.make_initializable_iterator()
+    with self.cached_session() as sess:
+      with self.assertRaisesOpError("multiples of 1000"):
+        sess.run(itr.initializer)
+
   def testLookup(self):
     ds = self._table.keys_by_prefix_dataset("r")
     ds = ds.apply(self._table.lookup_columns(cf1="c1"))
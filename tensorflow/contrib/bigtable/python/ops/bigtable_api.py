@@ -236,7 +236,12 @@ class BigtableTable(object):
     """
     return _BigtableSampleKeysDataset(self)
 
-  def scan_prefix(self, prefix, probability=None, columns=None, **kwargs):
+  def scan_prefix(self,
+                  prefix,
+                  probability=None,
+                  columns=None,
+                  timestamp_range=None,
+                  **kwargs):
     """Retrieves row (including values) from the Bigtable service.
 
     Rows with row-key prefixed by `prefix` will be retrieved.
@@ -267,6 +272,10 @@ class BigtableTable(object):
         kwargs. Use the columns value if you are using column families that are
         reserved. The value of columns and kwargs are merged. Columns is a list
         of tuples of strings ("column_family", "column_qualifier").
+      timestamp_range: (Optional.) A pair of integers `(start, end)`. Only cells
+        with timestamps in `[start, end)` microseconds are read, which the
+        Cloud Bigtable server filters out before sending them. Both must be
+        multiples of 1000, and an `end` of 0 means no upper bound.
       **kwargs: The column families and columns to read. Keys are treated as
         column_families, and values can be either lists of strings, or strings
         that are treated as the column qualifier (column name).
@@ -279,9 +288,16 @@ class BigtableTable(object):
     """
     probability = _normalize_probability(probability)
     normalized = _normalize_columns(columns, kwargs)
-    return _BigtableScanDataset(self, prefix, "", "", normalized, probability)
-
-  def scan_range(self, start, end, probability=None, columns=None, **kwargs):
+    return _BigtableScanDataset(self, prefix, "", "", normalized, probability,
+                                timestamp_range)
+
+  def scan_range(self,
+                 start,
+                 end,
+                 probability=None,
+                 columns=None,
+                 timestamp_range=None,
+                 **kwargs):
     """Retrieves rows (including values) from the Bigtable service.
 
     Rows with row-keys between `start` and `end` will be retrieved.
@@ -312,6 +328,10 @@ class BigtableTable(object):
         kwargs. Use the columns value if you are using column families that are
         reserved. The value of columns and kwargs are merged. Columns is a list
         of tuples of strings ("column_family", "column_qualifier").
+      timestamp_range: (Optional.) A pair of integers `(start, end)`. Only cells
+        with timestamps in `[start, end)` microseconds are read, which the
+        Cloud Bigtable server filters out before sending them. Both must be
+        multiples of 1000, and an `end` of 0 means no upper bound.
       **kwargs: The column families and columns to read. Keys are treated as
         column_families, and values can be either lists of strings, or strings
         that are treated as the column qualifier (column name).
@@ -324,13 +344,15 @@ class BigtableTable(object):
     """
     probability = _normalize_probability(probability)
     normalized = _normalize_columns(columns, kwargs)
-    return _BigtableScanDataset(self, "", start, end, normalized, probability)
+    return _BigtableScanDataset(self, "", start, end, normalized, probability,
+                                timestamp_range)
 
   def parallel_scan_prefix(self,
                            prefix,
                            num_parallel_scans=None,
                            probability=None,
                            columns=None,
+                           timestamp_range=None,
                            **kwargs):
     """Retrieves row (including values) from the Bigtable service at high speed.
 
@@ -368,6 +390,10 @@ class BigtableTable(object):
         kwargs. Use the columns value if you are using column families that are
         reserved. The value of columns and kwargs are merged. Columns is a list
         of tuples of strings ("column_family", "column_qualifier").
+      timestamp_range: (Optional.) A pair of integers `(start, end)`. Only cells
+        with timestamps in `[start, end)` microseconds are read, which the
+        Cloud Bigtable server filters out before sending them. Both must be
+        multiples of 1000, and an `end` of 0 means no upper bound.
       **kwargs: The column families and columns to read. Keys are treated as
         column_families, and values can be either lists of strings, or strings
         that are treated as the column qualifier (column name).
@@ -382,7 +408,7 @@ class BigtableTable(object):
     normalized = _normalize_columns(columns, kwargs)
     ds = _BigtableSampleKeyPairsDataset(self, prefix, "", "")
     return self._make_parallel_scan_dataset(ds, num_parallel_scans, probability,
-                                            normalized)
+                                            normalized, timestamp_range)
 
   def parallel_scan_range(self,
                           start,
@@ -390,6 +416,7 @@ class BigtableTable(object):
                           num_parallel_scans=None,
                           probability=None,
                           columns=None,
+                          timestamp_range=None,
                           **kwargs):
     """Retrieves rows (including values) from the Bigtable service.
 
@@ -430,6 +457,10 @@ class BigtableTable(object):
         kwargs. Use the columns value if you are using column families that are
         reserved. The value of columns and kwargs are merged. Columns is a list
         of tuples of strings ("column_family", "column_qualifier").
+      timestamp_range: (Optional.) A pair of integers `(start, end)`. Only cells
+        with timestamps in `[start, end)` microseconds are read, which the
+        Cloud Bigtable server filters out before sending them. Both must be
+        multiples of 1000, and an `end` of 0 means no upper bound.
       **kwargs: The column families and columns to read. Keys are treated as
         column_families, and values can be either lists of strings, or strings
         that are treated as the column qualifier (column name).
@@ -444,7 +475,7 @@ class BigtableTable(object):
     normalized = _normalize_columns(columns, kwargs)
     ds = _BigtableSampleKeyPairsDataset(self, "", start, end)
     return self._make_parallel_scan_dataset(ds, num_parallel_scans, probability,
-                                            normalized)
+                                            normalized, timestamp_range)
 
   def write(self, dataset, column_families, columns, timestamp=None):
     """Writes a dataset to the table.
@@ -491,8 +522,12 @@ class BigtableTable(object):
         columns,
         timestamp)
 
-  def _make_parallel_scan_dataset(self, ds, num_parallel_scans,
-                                  normalized_probability, normalized_columns):
+  def _make_parallel_scan_dataset(self,
+                                  ds,
+                                  num_parallel_scans,
+                                  normalized_probability,
+                                  normalized_columns,
+                                  timestamp_range=None):
     """Builds a parallel dataset from a given range.
 
     Args:
@@ -500,6 +535,7 @@ class BigtableTable(object):
       num_parallel_scans: The number of concurrent parallel scans to use.
       normalized_probability: A number between 0 and 1 for the keep probability.
       normalized_columns: The column families and column qualifiers to retrieve.
+      timestamp_range: (Optional.) The range of cell timestamps to retrieve.
 
     Returns:
       A `tf.data.Dataset` representing the result of the parallel scan.
@@ -516,7 +552,8 @@ class BigtableTable(object):
           start=start,
           end=end,
           normalized=normalized_columns,
-          probability=normalized_probability)
+          probability=normalized_probability,
+          timestamp_range=timestamp_range)
 
     # Note prefetch_input_elements must be set in order to avoid rpc timeouts.
     ds = ds.apply(
@@ -682,7 +719,14 @@ class _BigtableScanDataset(dataset_ops.DatasetSource):
   """_BigtableScanDataset represents a dataset that retrieves keys and values.
   """
 
-  def __init__(self, table, prefix, start, end, normalized, probability):
+  def __init__(self,
+               table,
+               prefix,
+               start,
+               end,
+               normalized,
+               probability,
+               timestamp_range=None):
     self._table = table
     self._prefix = prefix
     self._start = start
@@ -690,6 +734,9 @@ class _BigtableScanDataset(dataset_ops.DatasetSource):
     self._column_families = [i[0] for i in normalized]
     self._columns = [i[1] for i in normalized]
     self._probability = probability
+    if timestamp_range is None:
+      timestamp_range = (0, 0)
+    self._start_timestamp_micros, self._end_timestamp_micros = timestamp_range
     self._num_outputs = len(normalized) + 1  # 1 for row key
 
   @property
@@ -712,7 +759,9 @@ class _BigtableScanDataset(dataset_ops.DatasetSource):
         end_key=self._end,
         column_families=self._column_families,
         columns=self._columns,
-        probability=self._probability)
+        probability=self._probability,
+        start_timestamp_micros=self._start_timestamp_micros,
+        end_timestamp_micros=self._end_timestamp_micros)
 
 
 class _BigtableSampleKeyPairsDataset(dataset_ops.DatasetSource):
@@ -560,6 +560,35 @@ class CudnnRNNTestInference(TensorFlowTestCase):
             shape["input_size"], shape["batch_size"], shape["seq_length"],
             shape["dir_count"], dropout, expected, tolerance)
 
+  @unittest.skipUnless(test.is_built_with_cuda(),
+                       "Test only applicable when running on GPUs")
+  def testFrozenCanonicalToParams(self):
+    old_env_state = os.environ.get("TF_CUDNN_RNN_CACHE_FROZEN_PARAMS", "0")
+    os.environ["TF_CUDNN_RNN_CACHE_FROZEN_PARAMS"] = "1"
+    try:
+      model = _CreateModel(cudnn_rnn_ops.CUDNN_LSTM, 2, 8, 4)
+      with self.test_session(use_gpu=True) as sess:
+        params_size_v = sess.run(model.params_size())
+        params = constant_op.constant(
+            np.random.rand(params_size_v), dtype=dtypes.float32)
+        weights_v, biases_v = sess.run(model.params_to_canonical(params))
+      # The weights are constants, so the conversion runs only once.
+      with ops.Graph().as_default(), self.test_session(
+          use_gpu=True, graph=ops.get_default_graph()) as sess:
+        opaque_params = model.canonical_to_params(
+            [constant_op.constant(w) for w in weights_v],
+            [constant_op.constant(b) for b in biases_v])
+        weights, biases = model.params_to_canonical(opaque_params)
+        first_v = sess.run(opaque_params)
+        self.assertAllEqual(first_v, sess.run(opaque_params))
+        new_weights_v, new_biases_v = sess.run([weights, biases])
+        for w, new_w in zip(weights_v, new_weights_v):
+          self.assertAllEqual(w, new_w)
+        for b, new_b in zip(biases_v, new_biases_v):
+          self.assertAllEqual(b, new_b)
+    finally:
+      os.environ["TF_CUDNN_RNN_CACHE_FROZEN_PARAMS"] = old_env_state
+
 
 class CudnnRNNTestTraining(TensorFlowTestCase):
 
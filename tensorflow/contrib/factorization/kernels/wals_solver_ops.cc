@@ -20,9 +20,6 @@
 #include <numeric>
 #include <vector>
 
-// This is only used for std::this_thread::get_id()
-#include <thread>  // NOLINT
-
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -31,7 +28,6 @@
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/threadpool.h"
-#include "tensorflow/core/platform/mutex.h"
 
 using tensorflow::DEVICE_CPU;
 using tensorflow::DT_BOOL;
@@ -163,129 +159,113 @@ class WALSComputePartialLhsAndRhsOp : public OpKernel {
     // and machinery for iterating over groups, but the fact that class
     // SparseTensor makes a complete copy of the matrix makes me reluctant to
     // use it.
+    //
+    // Group the entries by input index with a counting sort. Entries of row r
+    // are perm[row_starts[r]], ..., perm[row_starts[r + 1] - 1], in their
+    // original order to preserve spatial locality.
+    std::vector<int64> row_starts(block_size + 1, 0);
+    for (int64 i = 0; i < num_nonzero_elements; ++i) {
+      const int64 input_index = get_input_index(i);
+      OP_REQUIRES(context, input_index >= 0 && input_index < block_size,
+                  InvalidArgument("Input index ", input_index,
+                                  " is out of range [0, ", block_size, ")."));
+      ++row_starts[input_index + 1];
+    }
+    for (int64 r = 0; r < block_size; ++r) {
+      row_starts[r + 1] += row_starts[r];
+    }
     std::vector<int64> perm(num_nonzero_elements);
-    std::iota(perm.begin(), perm.end(), 0);
+    {
+      std::vector<int64> next(row_starts.begin(), row_starts.end() - 1);
+      for (int64 i = 0; i < num_nonzero_elements; ++i) {
+        perm[next[get_input_index(i)]++] = i;
+      }
+    }
 
-    typedef std::pair<int64, int64> Shard;
-    std::vector<Shard> shards;
+    // Split the rows into contiguous blocks of about the same number of
+    // entries, a few per thread, so that rows with many entries do not hold
+    // up the other threads and each block costs a single closure.
     auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
-    int64 shard_total = 0;
-    // Compute a permutation such that get_input_index(perm[i]) is sorted, use
-    // stable_sort to preserve spatial locality.
-    std::stable_sort(perm.begin(), perm.end(),
-                     [&get_input_index](int64 i, int64 j) {
-                       return get_input_index(i) < get_input_index(j);
-                     });
-
-    // Compute the start and end of runs with identical input_index.
-    // These are the shards of work that can be processed in parallel
-    // without locking.
-    int64 start = 0;
-    int64 end = 0;
-    while (end < num_nonzero_elements) {
-      start = end;
-      while (end < num_nonzero_elements &&
-             get_input_index(perm[start]) == get_input_index(perm[end])) {
-        ++end;
+    const int64 num_blocks_target =
+        std::max(1, 4 * worker_threads.workers->NumThreads());
+    const int64 entries_per_block = std::max<int64>(
+        1, (num_nonzero_elements + num_blocks_target - 1) / num_blocks_target);
+    typedef std::pair<int64, int64> RowBlock;
+    std::vector<RowBlock> row_blocks;
+    for (int64 r = 0; r < block_size;) {
+      const int64 first_row = r;
+      while (r < block_size &&
+             row_starts[r + 1] - row_starts[first_row] < entries_per_block) {
+        ++r;
+      }
+      // Always include the row that fills the block.
+      r = std::min(r + 1, block_size);
+      if (row_starts[r] > row_starts[first_row]) {
+        row_blocks.emplace_back(first_row, r);
       }
-      shards.emplace_back(start, end);
-      shard_total += end - start;
     }
-    CHECK_EQ(shard_total, num_nonzero_elements);
-    CHECK_LE(shards.size(), num_nonzero_elements);
-    CHECK_GT(shards.size(), 0);
+    if (row_blocks.empty()) return;
 
     // Batch the rank-one updates into a rank-k update to lower memory traffic
     const int kMaxBatchSize = 128;
 
-    // Since we do not have an easy way of generating thread id's within the
-    // range [0,num_threads), we can instead call out to an std::unordered_map
-    // of matrices and initialize the matrix on the first call.
-    // However, this might have a performance penalty, as memory allocation can
-    // cause the OS kernel to enter a critical section and temporarily disable
-    // parallelism, and the unordered_map must be protected with a read/write
-    // mutex.
-    //
-    // TODO(jpoulson): Simplify after the thread rank can be queried
-    std::unordered_map<size_t, Eigen::MatrixXf> factor_batch_map;
-    mutex map_mutex;
-
-    BlockingCounter counter(shards.size());
-    // Lambda encapsulating the per-shard computation.
-    auto work = [&](const Shard& shard) {
-      const std::thread::id thread_id = std::this_thread::get_id();
-      const size_t id_hash = std::hash<std::thread::id>()(thread_id);
-      // If this thread's unique factors_mat.rows() x kMaxBatchSize
-      // batching matrix has not yet been created, then emplace it into the
-      // map using the hash of the thread id as the key.
-      //
-      // TODO(jpoulson): Switch to try_emplace once C++17 is supported
-      // TODO(b/72952120): Check whether the 3 lock-unlock pairs can be
-      // consolidated into just one.
-      map_mutex.lock();
-      const auto key_count = factor_batch_map.count(id_hash);
-      map_mutex.unlock();
-      if (!key_count) {
-        map_mutex.lock();
-        factor_batch_map.emplace(
-            std::piecewise_construct, std::forward_as_tuple(id_hash),
-            std::forward_as_tuple(factors_mat.rows(), kMaxBatchSize));
-        map_mutex.unlock();
-      }
-      map_mutex.lock();
-      auto& factor_batch = factor_batch_map[id_hash];
-      map_mutex.unlock();
+    BlockingCounter counter(row_blocks.size());
+    // Lambda encapsulating the computation for the rows of a block.
+    auto work = [&](const RowBlock& row_block) {
+      // The factors of a batch of entries, scaled by the square roots of
+      // their weights.
+      Eigen::MatrixXf factor_batch(factors_mat.rows(), kMaxBatchSize);
+      for (int64 input_index = row_block.first;
+           input_index < row_block.second; ++input_index) {
+        const int64 row_start = row_starts[input_index];
+        const int64 row_end = row_starts[input_index + 1];
+        if (row_start == row_end) continue;
+        const float input_weight =
+            use_entry_weights ? 1.0 : input_weights_vec(input_index);
+        // Accumulate the rhs and lhs terms in the normal equations
+        // for the non-zero elements in the row or column of the sparse matrix
+        // corresponding to input_index.
+        int num_batched = 0;
+        EigenMatrixFloatMap lhs_mat(output_lhs_tensor->flat<float>().data() +
+                                        input_index * factor_dim * factor_dim,
+                                    factor_dim, factor_dim);
+        auto lhs_symm = lhs_mat.selfadjointView<Eigen::Lower>();
+        for (int64 p = row_start; p < row_end; ++p) {
+          const int64 i = perm[p];
+          const int64 factor_index = get_factor_index(i);
+          const float input_value = input_values_vec(i);
+          const float weight =
+              use_entry_weights
+                  ? entry_weights_vec(i)
+                  : input_weight * factor_weights_vec(factor_index);
+          CHECK_GE(weight, 0);
+          factor_batch.col(num_batched) =
+              factors_mat.col(factor_index) * std::sqrt(weight);
+          ++num_batched;
+          if (num_batched == kMaxBatchSize) {
+            lhs_symm.rankUpdate(factor_batch);
+            num_batched = 0;
+          }
 
-      CHECK_GE(shard.first, 0);
-      CHECK_LE(shard.second, perm.size());
-      CHECK_LE(shard.first, shard.second);
-      const int64 input_index = get_input_index(perm[shard.first]);
-      const float input_weight =
-          use_entry_weights ? 1.0 : input_weights_vec(input_index);
-      // Accumulate the rhs and lhs terms in the normal equations
-      // for the non-zero elements in the row or column of the sparse matrix
-      // corresponding to input_index.
-      int num_batched = 0;
-      EigenMatrixFloatMap lhs_mat(output_lhs_tensor->flat<float>().data() +
-                                      input_index * factor_dim * factor_dim,
-                                  factor_dim, factor_dim);
-      auto lhs_symm = lhs_mat.selfadjointView<Eigen::Lower>();
-      for (int64 p = shard.first; p < shard.second; ++p) {
-        const int64 i = perm[p];
-        // Check that all entries in the shard have the same input index.
-        CHECK_EQ(input_index, get_input_index(i));
-        const int64 factor_index = get_factor_index(i);
-        const float input_value = input_values_vec(i);
-        const float weight =
-            use_entry_weights ? entry_weights_vec(i)
-                              : input_weight * factor_weights_vec(factor_index);
-        CHECK_GE(weight, 0);
-        factor_batch.col(num_batched) =
-            factors_mat.col(factor_index) * std::sqrt(weight);
-        ++num_batched;
-        if (num_batched == kMaxBatchSize) {
-          lhs_symm.rankUpdate(factor_batch);
-          num_batched = 0;
+          rhs_mat.col(input_index) +=
+              input_value * (w_0 + weight) * factors_mat.col(factor_index);
         }
-
-        rhs_mat.col(input_index) +=
-            input_value * (w_0 + weight) * factors_mat.col(factor_index);
-      }
-      if (num_batched != 0) {
-        auto factor_block =
-            factor_batch.block(0, 0, factors_mat.rows(), num_batched);
-        lhs_symm.rankUpdate(factor_block);
+        if (num_batched != 0) {
+          auto factor_block =
+              factor_batch.block(0, 0, factors_mat.rows(), num_batched);
+          lhs_symm.rankUpdate(factor_block);
+        }
+        // Copy lower triangular to upper triangular part of normal equation
+        // matrix.
+        lhs_mat = lhs_symm;
       }
-      // Copy lower triangular to upper triangular part of normal equation
-      // matrix.
-      lhs_mat = lhs_symm;
       counter.DecrementCount();
     };
-    for (size_t i = 1; i < shards.size(); ++i) {
-      worker_threads.workers->Schedule(std::bind(work, shards[i]));
+    for (size_t i = 1; i < row_blocks.size(); ++i) {
+      worker_threads.workers->Schedule(std::bind(work, row_blocks[i]));
     }
-    // Inline execute the 1st shard.
-    work(shards[0]);
+    // Inline execute the 1st block.
+    work(row_blocks[0]);
     counter.Wait();
   }
 };
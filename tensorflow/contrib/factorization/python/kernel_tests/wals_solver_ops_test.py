@@ -112,6 +112,62 @@ class WalsSolverOpsTest(test.TestCase):
                                               [0.160400, 0.220000, 0.279600],
                                               [0.492800, 0.563200, 0.633600]])
 
+  def testWalsSolverLhsManyRows(self):
+    rng = np.random.RandomState(0)
+    num_rows = 50
+    num_cols = 300
+    factor_dim = 4
+    # Some rows are empty, and some have more than one batch of entries.
+    dense = rng.rand(num_rows, num_cols) * (rng.rand(num_rows, 1) < 0.8)
+    dense *= rng.rand(num_rows, num_cols) < 0.5
+    indices = np.array(np.nonzero(dense)).T.astype(np.int64)
+    # The op must not depend on the order of the entries.
+    indices = indices[rng.permutation(len(indices))]
+    values = dense[indices[:, 0], indices[:, 1]].astype(np.float32)
+    entry_weights = rng.rand(len(indices)).astype(np.float32)
+    factors = rng.rand(num_cols, factor_dim).astype(np.float32)
+
+    expected_lhs = np.zeros([num_rows, factor_dim, factor_dim])
+    expected_rhs = np.zeros([num_rows, factor_dim])
+    for (row, col), value, weight in zip(indices, values, entry_weights):
+      expected_lhs[row] += weight * np.outer(factors[col], factors[col])
+      expected_rhs[row] += (value * (self._unobserved_weights + weight) *
+                            factors[col])
+
+    with self.cached_session():
+      [lhs_tensor,
+       rhs_matrix] = gen_factorization_ops.wals_compute_partial_lhs_and_rhs(
+           factors, [], self._unobserved_weights, [], indices, values,
+           entry_weights,
+           input_block_size=num_rows,
+           input_is_transpose=False)
+      self.assertAllClose(lhs_tensor.eval(), expected_lhs, rtol=1e-4)
+      self.assertAllClose(rhs_matrix.eval(), expected_rhs, rtol=1e-4)
+
+  def testWalsSolverLhsNoEntries(self):
+    with self.cached_session():
+      [lhs_tensor,
+       rhs_matrix] = gen_factorization_ops.wals_compute_partial_lhs_and_rhs(
+           self._column_factors, [], self._unobserved_weights, [],
+           np.zeros([0, 2], dtype=np.int64), np.zeros([0], dtype=np.float32),
+           np.zeros([0], dtype=np.float32),
+           input_block_size=2,
+           input_is_transpose=False)
+      self.assertAllClose(lhs_tensor.eval(), np.zeros([2, 3, 3]))
+      self.assertAllClose(rhs_matrix.eval(), np.zeros([2, 3]))
+
+  def testWalsSolverLhsInputIndexOutOfRange(self):
+    sparse_block = SparseBlock3x3()
+    with self.cached_session():
+      [lhs_tensor, _] = gen_factorization_ops.wals_compute_partial_lhs_and_rhs(
+          self._column_factors, self._column_weights, self._unobserved_weights,
+          self._row_weights, sparse_block.indices, sparse_block.values,
+          [],
+          input_block_size=3,
+          input_is_transpose=False)
+      with self.assertRaisesOpError("out of range"):
+        lhs_tensor.eval()
+
 
 if __name__ == "__main__":
   test.main()
@@ -13,11 +13,86 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <map>
+#include <set>
+#include <utility>
+
 #include "tensorflow/core/framework/dataset.h"
 
 #include "rdkafkacpp.h"
 
 namespace tensorflow {
+namespace {
+
+// A subscription of the form [topic:partition:offset:length].
+struct Subscription {
+  string topic;
+  int32 partition = 0;
+  int64 offset = 0;
+  // The last offset to read, or -1 to read until the end of the partition.
+  int64 limit = -1;
+};
+
+Status ParseSubscription(const string& entry, Subscription* subscription) {
+  std::vector<string> parts = str_util::Split(entry, ":");
+  if (parts.size() < 1) {
+    return errors::InvalidArgument("Invalid parameters: ", entry);
+  }
+  subscription->topic = parts[0];
+  subscription->partition = 0;
+  if (parts.size() > 1) {
+    if (!strings::safe_strto32(parts[1], &subscription->partition)) {
+      return errors::InvalidArgument("Invalid parameters: ", entry);
+    }
+  }
+  subscription->offset = 0;
+  if (parts.size() > 2) {
+    if (!strings::safe_strto64(parts[2], &subscription->offset)) {
+      return errors::InvalidArgument("Invalid parameters: ", entry);
+    }
+  }
+  subscription->limit = -1;
+  if (parts.size() > 3) {
+    if (!strings::safe_strto64(parts[3], &subscription->limit)) {
+      return errors::InvalidArgument("Invalid parameters: ", entry);
+    }
+  }
+  return Status::OK();
+}
+
+Status CreateConsumer(const string& servers, const string& group,
+                      std::unique_ptr<RdKafka::KafkaConsumer>* consumer) {
+  std::unique_ptr<RdKafka::Conf> conf(
+      RdKafka::Conf::create(RdKafka::Conf::CONF_GLOBAL));
+  std::unique_ptr<RdKafka::Conf> topic_conf(
+      RdKafka::Conf::create(RdKafka::Conf::CONF_TOPIC));
+
+  std::string errstr;
+
+  RdKafka::Conf::ConfResult result =
+      conf->set("default_topic_conf", topic_conf.get(), errstr);
+  if (result != RdKafka::Conf::CONF_OK) {
+    return errors::Internal("Failed to set default_topic_conf:", errstr);
+  }
+
+  result = conf->set("bootstrap.servers", servers, errstr);
+  if (result != RdKafka::Conf::CONF_OK) {
+    return errors::Internal("Failed to set bootstrap.servers ", servers, ":",
+                            errstr);
+  }
+  result = conf->set("group.id", group, errstr);
+  if (result != RdKafka::Conf::CONF_OK) {
+    return errors::Internal("Failed to set group.id ", group, ":", errstr);
+  }
+
+  consumer->reset(RdKafka::KafkaConsumer::create(conf.get(), errstr));
+  if (!consumer->get()) {
+    return errors::Internal("Failed to create consumer:", errstr);
+  }
+  return Status::OK();
+}
+
+}  // namespace
 
 class KafkaDatasetOp : public DatasetOpKernel {
  public:
@@ -218,65 +293,18 @@ class KafkaDatasetOp : public DatasetOpKernel {
         }
 
         // Actually move on to next topic.
-        string entry = dataset()->topics_[current_topic_index_];
-
-        std::vector<string> parts = str_util::Split(entry, ":");
-        if (parts.size() < 1) {
-          return errors::InvalidArgument("Invalid parameters: ", entry);
-        }
-        string topic = parts[0];
-        int32 partition = 0;
-        if (parts.size() > 1) {
-          if (!strings::safe_strto32(parts[1], &partition)) {
-            return errors::InvalidArgument("Invalid parameters: ", entry);
-          }
-        }
-        int64 offset = 0;
-        if (parts.size() > 2) {
-          if (!strings::safe_strto64(parts[2], &offset)) {
-            return errors::InvalidArgument("Invalid parameters: ", entry);
-          }
-        }
+        Subscription subscription;
+        TF_RETURN_IF_ERROR(ParseSubscription(
+            dataset()->topics_[current_topic_index_], &subscription));
 
-        topic_partition_.reset(
-            RdKafka::TopicPartition::create(topic, partition, offset));
+        topic_partition_.reset(RdKafka::TopicPartition::create(
+            subscription.topic, subscription.partition, subscription.offset));
 
         offset_ = topic_partition_->offset();
-        limit_ = -1;
-        if (parts.size() > 3) {
-          if (!strings::safe_strto64(parts[3], &limit_)) {
-            return errors::InvalidArgument("Invalid parameters: ", entry);
-          }
-        }
-
-        std::unique_ptr<RdKafka::Conf> conf(
-            RdKafka::Conf::create(RdKafka::Conf::CONF_GLOBAL));
-        std::unique_ptr<RdKafka::Conf> topic_conf(
-            RdKafka::Conf::create(RdKafka::Conf::CONF_TOPIC));
+        limit_ = subscription.limit;
 
-        std::string errstr;
-
-        RdKafka::Conf::ConfResult result =
-            conf->set("default_topic_conf", topic_conf.get(), errstr);
-        if (result != RdKafka::Conf::CONF_OK) {
-          return errors::Internal("Failed to set default_topic_conf:", errstr);
-        }
-
-        result = conf->set("bootstrap.servers", dataset()->servers_, errstr);
-        if (result != RdKafka::Conf::CONF_OK) {
-          return errors::Internal("Failed to set bootstrap.servers ",
-                                  dataset()->servers_, ":", errstr);
-        }
-        result = conf->set("group.id", dataset()->group_, errstr);
-        if (result != RdKafka::Conf::CONF_OK) {
-          return errors::Internal("Failed to set group.id ", dataset()->group_,
-                                  ":", errstr);
-        }
-
-        consumer_.reset(RdKafka::KafkaConsumer::create(conf.get(), errstr));
-        if (!consumer_.get()) {
-          return errors::Internal("Failed to create consumer:", errstr);
-        }
+        TF_RETURN_IF_ERROR(CreateConsumer(dataset()->servers_,
+                                          dataset()->group_, &consumer_));
 
         std::vector<RdKafka::TopicPartition*> partitions;
         partitions.emplace_back(topic_partition_.get());
@@ -314,7 +342,333 @@ class KafkaDatasetOp : public DatasetOpKernel {
   };
 };
 
+// Reads all the subscribed partitions concurrently through a single
+// consumer, whose background threads fetch from the partition leaders in
+// parallel, and emits the messages that arrive within `timeout` as one
+// batch. The next offset of every partition is part of the iterator state,
+// so a restored iterator replays exactly the messages after the last batch.
+class KafkaBatchDatasetOp : public DatasetOpKernel {
+ public:
+  using DatasetOpKernel::DatasetOpKernel;
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
+    const Tensor* topics_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("topics", &topics_tensor));
+    OP_REQUIRES(
+        ctx, topics_tensor->dims() <= 1,
+        errors::InvalidArgument("`topics` must be a scalar or a vector."));
+
+    std::vector<Subscription> subscriptions;
+    subscriptions.reserve(topics_tensor->NumElements());
+    std::set<std::pair<string, int32>> partitions;
+    for (int i = 0; i < topics_tensor->NumElements(); ++i) {
+      Subscription subscription;
+      OP_REQUIRES_OK(ctx, ParseSubscription(topics_tensor->flat<string>()(i),
+                                            &subscription));
+      OP_REQUIRES(
+          ctx,
+          partitions
+              .emplace(subscription.topic, subscription.partition)
+              .second,
+          errors::InvalidArgument("Partition ", subscription.partition,
+                                  " of topic ", subscription.topic,
+                                  " is subscribed more than once."));
+      subscriptions.push_back(std::move(subscription));
+    }
+
+    std::string servers = "";
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<std::string>(ctx, "servers", &servers));
+    std::string group = "";
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<std::string>(ctx, "group", &group));
+    bool eof = false;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<bool>(ctx, "eof", &eof));
+    int64 timeout = -1;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "timeout", &timeout));
+    OP_REQUIRES(ctx, (timeout > 0),
+                errors::InvalidArgument(
+                    "Timeout value should be large than 0, got ", timeout));
+    int64 batch_size = 0;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int64>(ctx, "batch_size", &batch_size));
+    OP_REQUIRES(ctx, batch_size > 0,
+                errors::InvalidArgument("Batch size must be greater than zero, "
+                                        "got ",
+                                        batch_size));
+    *output = new Dataset(ctx, std::move(subscriptions), servers, group, eof,
+                          timeout, batch_size);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, std::vector<Subscription> subscriptions,
+            const string& servers, const string& group, const bool eof,
+            const int64 timeout, const int64 batch_size)
+        : DatasetBase(DatasetContext(ctx)),
+          subscriptions_(std::move(subscriptions)),
+          servers_(servers),
+          group_(group),
+          eof_(eof),
+          timeout_(timeout),
+          batch_size_(batch_size) {}
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return std::unique_ptr<IteratorBase>(
+          new Iterator({this, strings::StrCat(prefix, "::KafkaBatch")}));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      static DataTypeVector* dtypes = new DataTypeVector({DT_STRING});
+      return *dtypes;
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      static std::vector<PartialTensorShape>* shapes =
+          new std::vector<PartialTensorShape>({PartialTensorShape({-1})});
+      return *shapes;
+    }
+
+    string DebugString() const override {
+      return "KafkaBatchDatasetOp::Dataset";
+    }
+
+   protected:
+    Status AsGraphDefInternal(SerializationContext* ctx,
+                              DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      std::vector<string> entries;
+      entries.reserve(subscriptions_.size());
+      for (const Subscription& subscription : subscriptions_) {
+        entries.push_back(strings::StrCat(
+            subscription.topic, ":", subscription.partition, ":",
+            subscription.offset, ":", subscription.limit));
+      }
+      Node* topics = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(entries, &topics));
+      Node* servers = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(servers_, &servers));
+      Node* group = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(group_, &group));
+      Node* eof = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(eof_, &eof));
+      Node* timeout = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(timeout_, &timeout));
+      Node* batch_size = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(batch_size_, &batch_size));
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this, {topics, servers, group, eof, timeout, batch_size}, output));
+      return Status::OK();
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {
+        const std::vector<Subscription>& subscriptions =
+            dataset()->subscriptions_;
+        partitions_.resize(subscriptions.size());
+        for (size_t i = 0; i < subscriptions.size(); ++i) {
+          const Subscription& subscription = subscriptions[i];
+          partitions_[i].next_offset = subscription.offset;
+          partitions_[i].done = subscription.limit >= 0 &&
+                                subscription.offset > subscription.limit;
+          if (partitions_[i].done) ++num_done_;
+          partition_index_[{subscription.topic, subscription.partition}] = i;
+        }
+      }
+
+      ~Iterator() override {
+        mutex_lock l(mu_);
+        if (consumer_) ResetStreamsLocked();
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        if (num_done_ == partitions_.size()) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        if (!consumer_) {
+          TF_RETURN_IF_ERROR(SetupStreamsLocked());
+        }
+
+        std::vector<string> batch;
+        batch.reserve(dataset()->batch_size_);
+        const uint64 deadline_micros =
+            ctx->env()->NowMicros() + dataset()->timeout_ * 1000;
+        while (static_cast<int64>(batch.size()) < dataset()->batch_size_ &&
+               num_done_ < partitions_.size()) {
+          // Once a message has arrived, wait until the deadline at most, so
+          // that a slow topic still yields partial batches; before that,
+          // keep waiting like KafkaDataset does.
+          int timeout_ms = static_cast<int>(dataset()->timeout_);
+          if (!batch.empty()) {
+            const uint64 now_micros = ctx->env()->NowMicros();
+            if (now_micros >= deadline_micros) break;
+            timeout_ms = static_cast<int>(
+                (deadline_micros - now_micros + 999) / 1000);
+          }
+          std::unique_ptr<RdKafka::Message> message(
+              consumer_->consume(timeout_ms));
+          const RdKafka::ErrorCode err = message->err();
+          if (err == RdKafka::ERR__TIMED_OUT) {
+            continue;
+          }
+          if (err != RdKafka::ERR_NO_ERROR &&
+              err != RdKafka::ERR__PARTITION_EOF) {
+            return errors::Internal("Failed to consume:", message->errstr());
+          }
+          auto it =
+              partition_index_.find({message->topic_name(),
+                                     message->partition()});
+          if (it == partition_index_.end()) continue;
+          PartitionState& state = partitions_[it->second];
+          if (state.done) continue;
+          if (err == RdKafka::ERR__PARTITION_EOF) {
+            if (dataset()->eof_) {
+              TF_RETURN_IF_ERROR(MarkDoneLocked(it->second));
+            }
+            continue;
+          }
+          // Messages before the next offset were already emitted before the
+          // iterator was restored.
+          if (message->offset() < state.next_offset) continue;
+          batch.emplace_back(static_cast<const char*>(message->payload()),
+                             message->len());
+          state.next_offset = message->offset() + 1;
+          const int64 limit = dataset()->subscriptions_[it->second].limit;
+          if (limit >= 0 && message->offset() >= limit) {
+            TF_RETURN_IF_ERROR(MarkDoneLocked(it->second));
+          }
+        }
+
+        if (batch.empty()) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        Tensor batch_tensor(cpu_allocator(), DT_STRING,
+                            TensorShape({static_cast<int64>(batch.size())}));
+        auto batch_flat = batch_tensor.flat<string>();
+        for (size_t i = 0; i < batch.size(); ++i) {
+          batch_flat(i).swap(batch[i]);
+        }
+        out_tensors->emplace_back(std::move(batch_tensor));
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+     protected:
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        for (size_t i = 0; i < partitions_.size(); ++i) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name(strings::StrCat("next_offset_", i)),
+                                  partitions_[i].next_offset));
+          if (partitions_[i].done) {
+            TF_RETURN_IF_ERROR(writer->WriteScalar(
+                full_name(strings::StrCat("done_", i)), ""));
+          }
+        }
+        return Status::OK();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        if (consumer_) ResetStreamsLocked();
+        num_done_ = 0;
+        for (size_t i = 0; i < partitions_.size(); ++i) {
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(full_name(strings::StrCat("next_offset_", i)),
+                                 &partitions_[i].next_offset));
+          partitions_[i].done =
+              reader->Contains(full_name(strings::StrCat("done_", i)));
+          if (partitions_[i].done) ++num_done_;
+        }
+        // The consumer is recreated by the next GetNext, starting every
+        // partition at its restored offset.
+        return Status::OK();
+      }
+
+     private:
+      struct PartitionState {
+        int64 next_offset = 0;
+        bool done = false;
+      };
+
+      // Assigns the partitions that are not done yet to a new consumer,
+      // starting at their next offsets.
+      Status SetupStreamsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        TF_RETURN_IF_ERROR(CreateConsumer(dataset()->servers_,
+                                          dataset()->group_, &consumer_));
+        std::vector<std::unique_ptr<RdKafka::TopicPartition>> owned;
+        std::vector<RdKafka::TopicPartition*> assignment;
+        for (size_t i = 0; i < partitions_.size(); ++i) {
+          if (partitions_[i].done) continue;
+          const Subscription& subscription = dataset()->subscriptions_[i];
+          owned.emplace_back(RdKafka::TopicPartition::create(
+              subscription.topic, subscription.partition,
+              partitions_[i].next_offset));
+          assignment.push_back(owned.back().get());
+        }
+        RdKafka::ErrorCode err = consumer_->assign(assignment);
+        if (err != RdKafka::ERR_NO_ERROR) {
+          return errors::Internal("Failed to assign ", assignment.size(),
+                                  " partitions:", RdKafka::err2str(err));
+        }
+        return Status::OK();
+      }
+
+      // Marks the partition at `index` as done and stops fetching from it.
+      Status MarkDoneLocked(size_t index) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        partitions_[index].done = true;
+        ++num_done_;
+        const Subscription& subscription = dataset()->subscriptions_[index];
+        std::unique_ptr<RdKafka::TopicPartition> partition(
+            RdKafka::TopicPartition::create(subscription.topic,
+                                            subscription.partition));
+        std::vector<RdKafka::TopicPartition*> partitions = {partition.get()};
+        RdKafka::ErrorCode err = consumer_->pause(partitions);
+        if (err != RdKafka::ERR_NO_ERROR) {
+          return errors::Internal("Failed to pause partition [",
+                                  subscription.topic, ", ",
+                                  subscription.partition,
+                                  "]:", RdKafka::err2str(err));
+        }
+        return Status::OK();
+      }
+
+      void ResetStreamsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        consumer_->unassign();
+        consumer_->close();
+        consumer_.reset(nullptr);
+      }
+
+      mutex mu_;
+      std::vector<PartitionState> partitions_ GUARDED_BY(mu_);
+      size_t num_done_ GUARDED_BY(mu_) = 0;
+      // Maps a (topic, partition) pair to its index in `partitions_`.
+      std::map<std::pair<string, int32>, size_t> partition_index_;
+      std::unique_ptr<RdKafka::KafkaConsumer> consumer_ GUARDED_BY(mu_);
+    };
+
+    const std::vector<Subscription> subscriptions_;
+    const std::string servers_;
+    const std::string group_;
+    const bool eof_;
+    const int64 timeout_;
+    const int64 batch_size_;
+  };
+};
+
 REGISTER_KERNEL_BUILDER(Name("KafkaDataset").Device(DEVICE_CPU),
                         KafkaDatasetOp);
+REGISTER_KERNEL_BUILDER(Name("KafkaBatchDataset").Device(DEVICE_CPU),
+                        KafkaBatchDatasetOp);
 
 }  // namespace tensorflow
@@ -41,4 +41,35 @@ timeout: The timeout value for the Kafka Consumer to wait
   (in millisecond).
 )doc");
 
+REGISTER_OP("KafkaBatchDataset")
+    .Input("topics: string")
+    .Input("servers: string")
+    .Input("group: string")
+    .Input("eof: bool")
+    .Input("timeout: int64")
+    .Input("batch_size: int64")
+    .Output("handle: variant")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that emits batches of the messages of Kafka partitions.
+
+All the partitions are consumed concurrently. Each element is a vector of
+at most `batch_size` messages; a smaller batch is emitted when no more
+messages arrive within `timeout` of the first one. Saving the iterator
+records the next offset of every partition.
+
+topics: A `tf.string` tensor containing one or more subscriptions,
+  in the format of [topic:partition:offset:length],
+  by default length is -1 for unlimited. Each partition may be
+  subscribed at most once.
+servers: A list of bootstrap servers.
+group: The consumer group id.
+eof: If True, the kafka reader will stop once it reaches the end of
+  every partition.
+timeout: The timeout value for the Kafka Consumer to wait
+  (in millisecond).
+batch_size: The maximum number of messages in a batch.
+)doc");
+
 }  // namespace tensorflow
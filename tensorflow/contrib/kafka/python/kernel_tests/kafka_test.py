@@ -110,6 +110,40 @@ class KafkaDatasetTest(test.TestCase):
         self.assertAllEqual(["D" + str(i + 5) for i in range(5)],
                             sess.run(get_next))
 
+  def testKafkaBatchDataset(self):
+    topics = array_ops.placeholder(dtypes.string, shape=[None])
+    batch_size = array_ops.placeholder(dtypes.int64, shape=[])
+
+    dataset = kafka_dataset_ops.KafkaBatchDataset(
+        topics, batch_size, group="test", eof=True)
+    iterator = dataset.make_initializable_iterator()
+    get_next = iterator.get_next()
+
+    with self.cached_session() as sess:
+      # Messages D0 to D9 are read in batches, the last of which is partial.
+      sess.run(
+          iterator.initializer,
+          feed_dict={topics: ["test:0:0:-1"], batch_size: 4})
+      for begin, end in [(0, 4), (4, 8), (8, 10)]:
+        self.assertAllEqual(["D" + str(i) for i in range(begin, end)],
+                            sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+      # The length of a subscription bounds the messages read.
+      sess.run(
+          iterator.initializer,
+          feed_dict={topics: ["test:0:3:5"], batch_size: 10})
+      self.assertAllEqual(["D3", "D4", "D5"], sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+      # A partition can only be subscribed once.
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(
+            iterator.initializer,
+            feed_dict={topics: ["test:0:0:4", "test:0:5:-1"], batch_size: 4})
+
 
 if __name__ == "__main__":
   test.main()
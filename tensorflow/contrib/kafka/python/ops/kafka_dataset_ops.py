@@ -73,3 +73,66 @@ class KafkaDataset(dataset_ops.DatasetSource):
   @property
   def output_types(self):
     return dtypes.string
+
+
+class KafkaBatchDataset(dataset_ops.DatasetSource):
+  """A Kafka Dataset that consumes partitions concurrently in batches.
+
+  Unlike `KafkaDataset`, which reads its subscriptions one after another, all
+  the subscribed partitions are read at the same time, and each element is a
+  vector of up to `batch_size` messages. Saving an iterator over this dataset
+  records the next offset of every partition, so a restored iterator resumes
+  right after the last emitted batch.
+  """
+
+  def __init__(self,
+               topics,
+               batch_size,
+               servers="localhost",
+               group="",
+               eof=False,
+               timeout=1000):
+    """Create a KafkaBatchDataset.
+
+    Args:
+      topics: A `tf.string` tensor containing one or more subscriptions,
+              in the format of [topic:partition:offset:length],
+              by default length is -1 for unlimited. Each partition may be
+              subscribed at most once.
+      batch_size: The maximum number of messages in a batch.
+      servers: A list of bootstrap servers.
+      group: The consumer group id.
+      eof: If True, the kafka reader will stop once it reaches the end of
+           every partition.
+      timeout: The time to wait for a batch to fill up once its first
+               message has arrived (in millisecond).
+    """
+    super(KafkaBatchDataset, self).__init__()
+    self._topics = ops.convert_to_tensor(
+        topics, dtype=dtypes.string, name="topics")
+    self._batch_size = ops.convert_to_tensor(
+        batch_size, dtype=dtypes.int64, name="batch_size")
+    self._servers = ops.convert_to_tensor(
+        servers, dtype=dtypes.string, name="servers")
+    self._group = ops.convert_to_tensor(
+        group, dtype=dtypes.string, name="group")
+    self._eof = ops.convert_to_tensor(eof, dtype=dtypes.bool, name="eof")
+    self._timeout = ops.convert_to_tensor(
+        timeout, dtype=dtypes.int64, name="timeout")
+
+  def _as_variant_tensor(self):
+    return gen_dataset_ops.kafka_batch_dataset(
+        self._topics, self._servers, self._group, self._eof, self._timeout,
+        self._batch_size)
+
+  @property
+  def output_classes(self):
+    return ops.Tensor
+
+  @property
+  def output_shapes(self):
+    return tensor_shape.vector(None)
+
+  @property
+  def output_types(self):
+    return dtypes.string
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include "tensorflow/contrib/lite/arena_planner.h"
+#include <algorithm>
 #include <utility>
 
 namespace tflite {
@@ -50,6 +51,31 @@ int64_t ArenaPlanner::BasePointer(TfLiteAllocationType type) {
   return 0;
 }
 
+void ArenaPlanner::SetExecutionStages(const std::vector<int>& stages) {
+  stage_start_.clear();
+  stage_end_.clear();
+  for (size_t i = 0; i + 1 < stages.size(); ++i) {
+    for (int node = stages[i]; node < stages[i + 1]; ++node) {
+      stage_start_.push_back(stages[i]);
+      stage_end_.push_back(stages[i + 1] - 1);
+    }
+  }
+}
+
+int ArenaPlanner::StageStart(int node_index) const {
+  if (node_index < 0 || node_index >= static_cast<int>(stage_start_.size())) {
+    return node_index;
+  }
+  return stage_start_[node_index];
+}
+
+int ArenaPlanner::StageEnd(int node_index) const {
+  if (node_index < 0 || node_index >= static_cast<int>(stage_end_.size())) {
+    return node_index;
+  }
+  return stage_end_[node_index];
+}
+
 TfLiteStatus ArenaPlanner::ResetAllocations() {
   TF_LITE_ENSURE_STATUS(arena_.Clear());
   TF_LITE_ENSURE_STATUS(persistent_arena_.Clear());
@@ -147,27 +173,32 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
       TF_LITE_ENSURE_STATUS(allocate(0, tensor_index));
     }
   }
-  // Go through the graph in execution order.
-  for (int i = 0; i < graph_info_->num_nodes(); ++i) {
-    const TfLiteNode& node = graph_info_->node(i);
-
-    // First queue output tensors for allocation.
-    TfLiteIntArray* node_outputs = node.outputs;
-    for (int j = 0; j < node_outputs->size; ++j) {
-      int tensor_index = node_outputs->data[j];
-      TF_LITE_ENSURE_STATUS(allocate(i, tensor_index));
+  // Go through the graph in execution order, one stage at a time.
+  const int num_nodes = graph_info_->num_nodes();
+  for (int first = 0; first < num_nodes; first = StageEnd(first) + 1) {
+    const int last = std::min(StageEnd(first), num_nodes - 1);
+
+    // First queue output tensors of the stage for allocation.
+    for (int i = first; i <= last; ++i) {
+      TfLiteIntArray* node_outputs = graph_info_->node(i).outputs;
+      for (int j = 0; j < node_outputs->size; ++j) {
+        int tensor_index = node_outputs->data[j];
+        TF_LITE_ENSURE_STATUS(allocate(i, tensor_index));
+      }
     }
 
-    // Then update the ref-counts of the node's inputs, and if necessary queue
-    // them for deallocation.
+    // Then update the ref-counts of the stage's inputs, and if necessary
+    // queue them for deallocation once the whole stage has run.
     if (!preserve_intermediates_) {
-      TfLiteIntArray* node_inputs = node.inputs;
-      for (int j = 0; j < node_inputs->size; ++j) {
-        int tensor_index = node_inputs->data[j];
-        if (tensor_index != kOptionalTensor) {
-          refcounts[tensor_index]--;
-          if (refcounts[tensor_index] == 0) {
-            TF_LITE_ENSURE_STATUS(deallocate(i, tensor_index));
+      for (int i = first; i <= last; ++i) {
+        TfLiteIntArray* node_inputs = graph_info_->node(i).inputs;
+        for (int j = 0; j < node_inputs->size; ++j) {
+          int tensor_index = node_inputs->data[j];
+          if (tensor_index != kOptionalTensor) {
+            refcounts[tensor_index]--;
+            if (refcounts[tensor_index] == 0) {
+              TF_LITE_ENSURE_STATUS(deallocate(last, tensor_index));
+            }
           }
         }
       }
@@ -217,9 +248,11 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
     if (alloc_info.node == active_node) {
       // This is the first allocation/deallocation for a given node.  It is
       // time to deallocate the previous temporaries and allocate new ones.
-      if (active_node != first_node) {
-        TF_LITE_ENSURE_STATUS(
-            CalculateDeallocationOfInternalTensors(active_node - 1));
+      // Temporaries of nodes in the same stage are all kept alive until the
+      // stage ends.
+      if (active_node != first_node && StageStart(active_node) == active_node) {
+        TF_LITE_ENSURE_STATUS(CalculateDeallocationOfStageInternalTensors(
+            first_node, active_node - 1));
       }
       TF_LITE_ENSURE_STATUS(CalculateAllocationOfInternalTensors(active_node));
       ++active_node;
@@ -232,9 +265,9 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
     }
   }
 
-  // Don't forget to deallocate temporaries of last node.
+  // Don't forget to deallocate temporaries of last stage.
   TF_LITE_ENSURE_STATUS(
-      CalculateDeallocationOfInternalTensors(active_node - 1));
+      CalculateDeallocationOfStageInternalTensors(first_node, active_node - 1));
 
   return kTfLiteOk;
 }
@@ -303,4 +336,13 @@ TfLiteStatus ArenaPlanner::CalculateDeallocationOfInternalTensors(
   return kTfLiteOk;
 }
 
+TfLiteStatus ArenaPlanner::CalculateDeallocationOfStageInternalTensors(
+    int first_node, int last_node) {
+  for (int i = std::max(first_node, StageStart(last_node)); i <= last_node;
+       ++i) {
+    TF_LITE_ENSURE_STATUS(CalculateDeallocationOfInternalTensors(i));
+  }
+  return kTfLiteOk;
+}
+
 }  // namespace tflite
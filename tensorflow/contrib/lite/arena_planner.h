@@ -64,6 +64,14 @@ class ArenaPlanner : public MemoryPlanner {
   // Returns the base arena location for a given allocation type.
   int64_t BasePointer(TfLiteAllocationType type);
 
+  // Groups the nodes into stages whose nodes may run concurrently: tensors
+  // used by a node are kept alive until the end of its stage, so no two
+  // tensors used within a stage share memory. `stages` holds the index of the
+  // first node of each stage, in increasing order, followed by the number of
+  // nodes. Must be called before PlanAllocations(); by default every node is
+  // a stage of its own.
+  void SetExecutionStages(const std::vector<int>& stages);
+
  private:
   // Make sure all the arenas have reserved enough memory to store all their
   // tensors.
@@ -91,6 +99,15 @@ class ArenaPlanner : public MemoryPlanner {
   // 'node_index'.
   TfLiteStatus CalculateDeallocationOfInternalTensors(int node_index);
 
+  // Register a deallocation for the internal tensors of the nodes in
+  // [first_node, last_node] that belong to the stage of 'last_node'.
+  TfLiteStatus CalculateDeallocationOfStageInternalTensors(int first_node,
+                                                           int last_node);
+
+  // Returns the first and last node of the stage of 'node_index'.
+  int StageStart(int node_index) const;
+  int StageEnd(int node_index) const;
+
   TfLiteContext* context_;
   std::unique_ptr<GraphInfo> graph_info_;
 
@@ -120,6 +137,11 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Number of bytes that tensor buffers should be aligned to.
   int tensor_alignment_;
+
+  // The first and last node of the stage of each node, or empty if every node
+  // is a stage of its own.
+  std::vector<int> stage_start_;
+  std::vector<int> stage_end_;
 };
 
 }  // namespace tflite
@@ -153,12 +153,14 @@ void ReportError(TfLiteContext* context, const char* format, ...) {
 
 class ArenaPlannerTest : public ::testing::Test {
  protected:
-  void SetGraph(TestGraph* graph, bool preserve_inputs = false) {
+  void SetGraph(TestGraph* graph, bool preserve_inputs = false,
+                const std::vector<int>& stages = {}) {
     graph_ = graph;
     context_.ReportError = ReportError;
     planner_.reset(new ArenaPlanner(
         &context_, std::unique_ptr<GraphInfo>(new TestGraphInfo(graph)),
         preserve_inputs, /*preserve intermediates*/ false, kTensorAlignment));
+    if (!stages.empty()) planner_->SetExecutionStages(stages);
     CHECK(planner_->ResetAllocations() == kTfLiteOk);
     CHECK(planner_->PlanAllocations() == kTfLiteOk);
   }
@@ -291,6 +293,41 @@ TEST_F(ArenaPlannerTest, SimpleGraphWithTemporary) {
   EXPECT_EQ(GetOffset(3), 0);
 }
 
+TEST_F(ArenaPlannerTest, SimpleGraphWithStages) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {}},     // First op
+                      {{1}, {2}, {4}},    // Second op, with temporary
+                      {{1}, {3}, {}},     // Third op
+                      {{2, 3}, {5}, {}},  // Fourth op
+                  },
+                  {5});
+
+  auto overlap = [this](int a, int b) {
+    return GetOffset(a) < GetOffsetAfter(b) && GetOffset(b) < GetOffsetAfter(a);
+  };
+
+  // Run in sequence, the third op's output reuses the temporary of the
+  // second.
+  SetGraph(&graph);
+  Execute(0, 10);
+  EXPECT_EQ(GetOffset(3), GetOffset(4));
+
+  // The second and third op may run concurrently, so everything they use must
+  // stay apart until both are done.
+  SetGraph(&graph, /*preserve_inputs=*/false, /*stages=*/{0, 1, 3, 4});
+  Execute(0, 10);
+  EXPECT_FALSE(overlap(1, 2));
+  EXPECT_FALSE(overlap(1, 3));
+  EXPECT_FALSE(overlap(1, 4));
+  EXPECT_FALSE(overlap(2, 3));
+  EXPECT_FALSE(overlap(2, 4));
+  EXPECT_FALSE(overlap(3, 4));
+  EXPECT_FALSE(overlap(5, 2));
+  EXPECT_FALSE(overlap(5, 3));
+}
+
 TEST_F(ArenaPlannerTest, SimpleGraphWithOptionals) {
   TestGraph graph({0, -1, 1},
                   {
@@ -0,0 +1,265 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/best_fit_arena_planner.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace tflite {
+namespace {
+
+constexpr int kNotUsed = -1;
+constexpr int kLiveForever = std::numeric_limits<int>::max();
+
+}  // namespace
+
+BestFitArenaPlanner::BestFitArenaPlanner(TfLiteContext* context,
+                                         std::unique_ptr<GraphInfo> graph_info,
+                                         bool preserve_inputs,
+                                         int tensor_alignment)
+    : context_(context),
+      graph_info_(std::move(graph_info)),
+      arena_(kDefaultArenaAlignment),
+      persistent_arena_(kDefaultArenaAlignment),
+      preserve_inputs_(preserve_inputs),
+      tensor_alignment_(tensor_alignment) {}
+
+BestFitArenaPlanner::~BestFitArenaPlanner() {}
+
+int64_t BestFitArenaPlanner::BasePointer(TfLiteAllocationType type) {
+  if (type == kTfLiteArenaRwPersistent) {
+    return persistent_arena_.BasePointer();
+  }
+  if (type == kTfLiteArenaRw) {
+    return arena_.BasePointer();
+  }
+  return 0;
+}
+
+void BestFitArenaPlanner::SetExecutionStages(const std::vector<int>& stages) {
+  stage_start_.clear();
+  stage_end_.clear();
+  for (size_t i = 0; i + 1 < stages.size(); ++i) {
+    for (int node = stages[i]; node < stages[i + 1]; ++node) {
+      stage_start_.push_back(stages[i]);
+      stage_end_.push_back(stages[i + 1] - 1);
+    }
+  }
+}
+
+int BestFitArenaPlanner::StageStart(int node_index) const {
+  if (node_index < 0 || node_index >= static_cast<int>(stage_start_.size())) {
+    return node_index;
+  }
+  return stage_start_[node_index];
+}
+
+int BestFitArenaPlanner::StageEnd(int node_index) const {
+  if (node_index < 0 || node_index >= static_cast<int>(stage_end_.size())) {
+    return node_index;
+  }
+  return stage_end_[node_index];
+}
+
+TfLiteStatus BestFitArenaPlanner::ResetAllocations() {
+  TF_LITE_ENSURE_STATUS(arena_.Clear());
+  TF_LITE_ENSURE_STATUS(persistent_arena_.Clear());
+  allocs_.clear();
+  allocs_.resize(graph_info_->num_tensors());
+  placed_.assign(graph_info_->num_tensors(), false);
+  return kTfLiteOk;
+}
+
+TfLiteStatus BestFitArenaPlanner::PlanAllocations() {
+  // Invalidate any existing data.
+  TF_LITE_ENSURE_STATUS(ResetAllocations());
+
+  const int num_tensors = graph_info_->num_tensors();
+  first_node_.assign(num_tensors, kNotUsed);
+  last_node_.assign(num_tensors, kLiveForever);
+
+  // Keeps track of references to each tensor.
+  std::vector<int> refcounts(num_tensors, 0);
+
+  auto use = [this](int node, int tensor) {
+    if (first_node_[tensor] == kNotUsed) {
+      first_node_[tensor] = node;
+    }
+  };
+
+  // Outputs and variable tensors must never be overwritten, which their
+  // extra reference guarantees. If preserve_inputs_ is true, the same goes
+  // for the inputs.
+  for (int tensor_index : graph_info_->outputs()) {
+    refcounts[tensor_index]++;
+  }
+  for (int tensor_index : graph_info_->variables()) {
+    if (tensor_index != kOptionalTensor) {
+      refcounts[tensor_index]++;
+      use(0, tensor_index);
+    }
+  }
+  for (int tensor_index : graph_info_->inputs()) {
+    if (tensor_index != kOptionalTensor) {
+      if (preserve_inputs_) {
+        refcounts[tensor_index]++;
+      }
+      use(0, tensor_index);
+    }
+  }
+
+  // Count references to node input tensors.
+  for (int i = 0; i < graph_info_->num_nodes(); ++i) {
+    TfLiteIntArray* node_inputs = graph_info_->node(i).inputs;
+    for (int j = 0; j < node_inputs->size; ++j) {
+      int tensor_index = node_inputs->data[j];
+      if (tensor_index != kOptionalTensor) {
+        refcounts[tensor_index]++;
+      }
+    }
+  }
+
+  // Go through the graph in execution order, one stage at a time. A tensor
+  // is in use from the stage that produces it to the end of the stage that
+  // last consumes it.
+  const int num_nodes = graph_info_->num_nodes();
+  for (int first = 0; first < num_nodes; first = StageEnd(first) + 1) {
+    const int last = std::min(StageEnd(first), num_nodes - 1);
+    for (int i = first; i <= last; ++i) {
+      TfLiteIntArray* node_outputs = graph_info_->node(i).outputs;
+      for (int j = 0; j < node_outputs->size; ++j) {
+        use(i, node_outputs->data[j]);
+      }
+    }
+    for (int i = first; i <= last; ++i) {
+      TfLiteIntArray* node_inputs = graph_info_->node(i).inputs;
+      for (int j = 0; j < node_inputs->size; ++j) {
+        int tensor_index = node_inputs->data[j];
+        if (tensor_index != kOptionalTensor &&
+            --refcounts[tensor_index] == 0 &&
+            first_node_[tensor_index] != kNotUsed) {
+          last_node_[tensor_index] = last;
+        }
+      }
+    }
+  }
+
+  // Outputs that no node consumes are only in use by the stage producing
+  // them.
+  for (int i = 0; i < num_tensors; ++i) {
+    if (first_node_[i] != kNotUsed && refcounts[i] == 0 &&
+        last_node_[i] == kLiveForever) {
+      last_node_[i] = StageEnd(first_node_[i]);
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BestFitArenaPlanner::ExecuteAllocations(int first_node,
+                                                     int last_node) {
+  // Grow the per-tensor data if necessary. This allows allocating temporary
+  // tensors in op's `prepare` function.
+  const int num_tensors = graph_info_->num_tensors();
+  TF_LITE_ENSURE(context_, num_tensors >= allocs_.size());
+  allocs_.resize(num_tensors);
+  placed_.resize(num_tensors, false);
+  first_node_.resize(num_tensors, kNotUsed);
+  last_node_.resize(num_tensors, kLiveForever);
+
+  // Temporaries are only known once their node has been prepared, and are
+  // in use for the node's stage.
+  const int last_prepared =
+      std::min<int>(last_node, graph_info_->num_nodes() - 1);
+  for (int i = first_node; i <= last_prepared; ++i) {
+    TfLiteIntArray* node_temporaries = graph_info_->node(i).temporaries;
+    for (int j = 0; j < node_temporaries->size; ++j) {
+      int tensor_index = node_temporaries->data[j];
+      first_node_[tensor_index] = i;
+      last_node_[tensor_index] = StageEnd(i);
+    }
+  }
+
+  TF_LITE_ENSURE_STATUS(CalculateAllocations(first_node, last_node));
+  TF_LITE_ENSURE_STATUS(arena_.Commit(context_));
+  TF_LITE_ENSURE_STATUS(persistent_arena_.Commit(context_));
+
+  for (int i = 0; i < num_tensors; ++i) {
+    TF_LITE_ENSURE_STATUS(ResolveTensorAllocation(i));
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BestFitArenaPlanner::CalculateAllocations(int first_node,
+                                                       int last_node) {
+  // Collect the tensors first used in the interval, releasing any place they
+  // got the last time the interval was planned.
+  std::vector<int> tensors;
+  for (int i = 0; i < allocs_.size(); ++i) {
+    if (first_node_[i] < first_node || first_node_[i] > last_node) continue;
+    if (placed_[i]) {
+      TfLiteTensor& tensor = *graph_info_->tensor(i);
+      SimpleMemoryArena& arena = tensor.allocation_type == kTfLiteArenaRw
+                                     ? arena_
+                                     : persistent_arena_;
+      TF_LITE_ENSURE_STATUS(arena.Deallocate(context_, allocs_[i]));
+      placed_[i] = false;
+    }
+    tensors.push_back(i);
+  }
+
+  // Place the largest tensors first, breaking ties in execution order.
+  std::stable_sort(tensors.begin(), tensors.end(), [this](int a, int b) {
+    const size_t a_bytes = graph_info_->tensor(a)->bytes;
+    const size_t b_bytes = graph_info_->tensor(b)->bytes;
+    if (a_bytes != b_bytes) return a_bytes > b_bytes;
+    return first_node_[a] < first_node_[b];
+  });
+
+  for (int tensor_index : tensors) {
+    TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+    if (tensor.allocation_type == kTfLiteArenaRw) {
+      TF_LITE_ENSURE_STATUS(arena_.AllocateForNodes(
+          context_, tensor_alignment_, tensor.bytes,
+          StageStart(first_node_[tensor_index]), last_node_[tensor_index],
+          &allocs_[tensor_index]));
+      placed_[tensor_index] = true;
+    } else if (tensor.allocation_type == kTfLiteArenaRwPersistent) {
+      TF_LITE_ENSURE_STATUS(persistent_arena_.Allocate(
+          context_, tensor_alignment_, tensor.bytes, &allocs_[tensor_index]));
+      placed_[tensor_index] = true;
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BestFitArenaPlanner::ResolveTensorAllocation(int tensor_index) {
+  TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+  if (tensor.allocation_type == kTfLiteArenaRw) {
+    // Skip resolution if the size of the tensor is zero, leaving it as a
+    // nullptr.
+    if (allocs_[tensor_index].size != 0) {
+      TF_LITE_ENSURE_STATUS(arena_.ResolveAlloc(context_, allocs_[tensor_index],
+                                                &tensor.data.raw));
+    }
+  }
+  if (tensor.allocation_type == kTfLiteArenaRwPersistent) {
+    TF_LITE_ENSURE_STATUS(persistent_arena_.ResolveAlloc(
+        context_, allocs_[tensor_index], &tensor.data.raw));
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
@@ -0,0 +1,118 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CONTRIB_LITE_BEST_FIT_ARENA_PLANNER_H_
+#define TENSORFLOW_CONTRIB_LITE_BEST_FIT_ARENA_PLANNER_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/contrib/lite/arena_planner.h"
+#include "tensorflow/contrib/lite/c/c_api_internal.h"
+#include "tensorflow/contrib/lite/graph_info.h"
+#include "tensorflow/contrib/lite/memory_planner.h"
+#include "tensorflow/contrib/lite/simple_memory_arena.h"
+
+namespace tflite {
+
+// A memory planner that places tensors in an arena knowing their whole
+// lifetimes.
+//
+// Where ArenaPlanner replays allocations and deallocations in execution
+// order, this class first determines the first and last node that uses each
+// tensor (the PlanAllocations phase), and then places the tensors from the
+// largest to the smallest, each in the smallest gap left by the tensors
+// already placed whose lifetimes intersect its own (the ExecuteAllocations
+// phase). Placing large tensors first avoids most of the fragmentation that
+// execution order placement leaves, which often makes the arena noticeably
+// smaller.
+//
+// Like ArenaPlanner it supports incremental planning for dynamic tensors:
+// each ExecuteAllocations() call places the tensors produced by its nodes
+// around the tensors placed by previous calls.
+class BestFitArenaPlanner : public MemoryPlanner {
+ public:
+  // Ownership of 'context' is not taken and it must remain util the
+  // BestFitArenaPlanner is destroyed. If 'preserve_inputs' is true the
+  // inputs to the graph will not share memory with any other tensor,
+  // effectively preserving them until the end of inference.
+  BestFitArenaPlanner(TfLiteContext* context,
+                      std::unique_ptr<GraphInfo> graph_info,
+                      bool preserve_inputs,
+                      int tensor_alignment = kDefaultTensorAlignment);
+  ~BestFitArenaPlanner() override;
+  BestFitArenaPlanner(const BestFitArenaPlanner&) = delete;
+  BestFitArenaPlanner& operator=(const BestFitArenaPlanner&) = delete;
+
+  TfLiteStatus ResetAllocations() override;
+  TfLiteStatus PlanAllocations() override;
+  TfLiteStatus ExecuteAllocations(int first_node, int last_node) override;
+
+  // Returns the base arena location for a given allocation type.
+  int64_t BasePointer(TfLiteAllocationType type);
+
+  // Same as ArenaPlanner::SetExecutionStages().
+  void SetExecutionStages(const std::vector<int>& stages);
+
+ private:
+  // Place all the tensors first used by nodes in [first_node, last_node].
+  TfLiteStatus CalculateAllocations(int first_node, int last_node);
+
+  // Assign absolute memory location to a tensor, based on its relative
+  // position inside the corresponding arena buffer.
+  TfLiteStatus ResolveTensorAllocation(int tensor_index);
+
+  // Returns the first and last node of the stage of 'node_index'.
+  int StageStart(int node_index) const;
+  int StageEnd(int node_index) const;
+
+  TfLiteContext* context_;
+  std::unique_ptr<GraphInfo> graph_info_;
+
+  // Stores allocation data for all tensors.
+  std::vector<ArenaAlloc> allocs_;
+
+  // Whether each tensor currently has a place in one of the arenas.
+  std::vector<int> placed_;
+
+  // The first and last node that use each tensor. Tensors that aren't used
+  // by any node have a first node of -1, and tensors that must never be
+  // overwritten a last node of std::numeric_limits<int>::max().
+  std::vector<int> first_node_;
+  std::vector<int> last_node_;
+
+  // Raw memory buffer that is allocated for all temporary and graph outputs.
+  // that are declared kTfLiteArenaRw.
+  SimpleMemoryArena arena_;
+
+  // Raw memory buffer that is allocated for persistent tensors that are
+  // declared as kTfLiteArenaRwPersistent.
+  SimpleMemoryArena persistent_arena_;
+
+  // Ensure that the memory self-allocated for inputs is never reused by the
+  // allocator.
+  bool preserve_inputs_;
+
+  // Number of bytes that tensor buffers should be aligned to.
+  int tensor_alignment_;
+
+  // The first and last node of the stage of each node, or empty if every node
+  // is a stage of its own.
+  std::vector<int> stage_start_;
+  std::vector<int> stage_end_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_CONTRIB_LITE_BEST_FIT_ARENA_PLANNER_H_
@@ -0,0 +1,401 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/delegates/gpu/gl_delegate.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/contrib/lite/builtin_ops.h"
+#include "tensorflow/contrib/lite/c/c_api_internal.h"
+#include "tensorflow/contrib/lite/context_util.h"
+#include "tensorflow/contrib/lite/delegates/gpu/shaders.h"
+
+#ifdef __ANDROID__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl31.h>
+#endif
+
+namespace tflite {
+namespace {
+
+#ifdef __ANDROID__
+// An EGL context which is only used for compute shaders. It has no surface if
+// EGL_KHR_surfaceless_context is supported, and a 1x1 pbuffer surface
+// otherwise.
+class GlEnvironment {
+ public:
+  // Returns nullptr if no OpenGL ES 3.1 context can be created.
+  static std::unique_ptr<GlEnvironment> Create() {
+    std::unique_ptr<GlEnvironment> env(new GlEnvironment);
+    env->display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (env->display_ == EGL_NO_DISPLAY ||
+        !eglInitialize(env->display_, nullptr, nullptr)) {
+      env->display_ = EGL_NO_DISPLAY;
+      return nullptr;
+    }
+    const char* extensions = eglQueryString(env->display_, EGL_EXTENSIONS);
+    const bool surfaceless =
+        extensions != nullptr &&
+        strstr(extensions, "EGL_KHR_surfaceless_context") != nullptr;
+    const EGLint config_attributes[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR, EGL_SURFACE_TYPE,
+        surfaceless ? 0 : EGL_PBUFFER_BIT, EGL_NONE};
+    EGLConfig config;
+    EGLint num_configs = 0;
+    if (!eglChooseConfig(env->display_, config_attributes, &config, 1,
+                         &num_configs) ||
+        num_configs == 0) {
+      return nullptr;
+    }
+    if (!surfaceless) {
+      const EGLint surface_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1,
+                                           EGL_NONE};
+      env->surface_ =
+          eglCreatePbufferSurface(env->display_, config, surface_attributes);
+      if (env->surface_ == EGL_NO_SURFACE) return nullptr;
+    }
+    const EGLint context_attributes[] = {EGL_CONTEXT_CLIENT_VERSION, 3,
+                                         EGL_NONE};
+    env->context_ = eglCreateContext(env->display_, config, EGL_NO_CONTEXT,
+                                     context_attributes);
+    if (env->context_ == EGL_NO_CONTEXT || !env->MakeCurrent()) {
+      return nullptr;
+    }
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    env->ReleaseCurrent();
+    if (major < 3 || (major == 3 && minor < 1)) {
+      return nullptr;
+    }
+    return env;
+  }
+
+  ~GlEnvironment() {
+    if (display_ == EGL_NO_DISPLAY) return;
+    if (context_ != EGL_NO_CONTEXT) eglDestroyContext(display_, context_);
+    if (surface_ != EGL_NO_SURFACE) eglDestroySurface(display_, surface_);
+  }
+
+  // The context is only current on the thread of the interpreter while the
+  // delegate kernel runs, so that the interpreter may move between threads.
+  bool MakeCurrent() {
+    return eglMakeCurrent(display_, surface_, surface_, context_);
+  }
+  void ReleaseCurrent() {
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  }
+
+ private:
+  GlEnvironment() = default;
+
+  EGLDisplay display_ = EGL_NO_DISPLAY;
+  EGLSurface surface_ = EGL_NO_SURFACE;
+  EGLContext context_ = EGL_NO_CONTEXT;
+};
+
+class ScopedCurrentContext {
+ public:
+  explicit ScopedCurrentContext(GlEnvironment* env)
+      : env_(env), ok_(env->MakeCurrent()) {}
+  ~ScopedCurrentContext() { env_->ReleaseCurrent(); }
+  bool ok() const { return ok_; }
+
+ private:
+  GlEnvironment* env_;
+  bool ok_;
+};
+
+TfLiteStatus CheckGlError(TfLiteContext* context, const char* operation) {
+  GLenum error = glGetError();
+  if (error != GL_NO_ERROR) {
+    context->ReportError(context, "GPU delegate: %s failed with error 0x%x.",
+                         operation, error);
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+// The largest number of work groups that is guaranteed to be supported in
+// each dimension of a dispatch.
+constexpr int kMaxWorkGroupCount = 65535;
+
+// The state of a delegated subgraph: a compiled program per node and a
+// shader storage buffer per tensor.
+class GpuDelegateKernel {
+ public:
+  ~GpuDelegateKernel() {
+    if (env_ == nullptr) return;
+    ScopedCurrentContext current(env_.get());
+    FreeResources();
+  }
+
+  TfLiteStatus Init(TfLiteContext* context,
+                    const TfLiteDelegateParams* params) {
+    env_ = GlEnvironment::Create();
+    if (env_ == nullptr) {
+      context->ReportError(context, "GPU delegate: no OpenGL ES 3.1 context.");
+      return kTfLiteError;
+    }
+    for (int node_index : TfLiteIntArrayView(params->nodes_to_replace)) {
+      nodes_.push_back(node_index);
+    }
+    return kTfLiteOk;
+  }
+
+  // Generates and compiles the shaders for the current tensor shapes, and
+  // allocates the buffers of all tensors of the subgraph.
+  TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+    TF_LITE_ENSURE(context, env_ != nullptr);
+    ScopedCurrentContext current(env_.get());
+    TF_LITE_ENSURE(context, current.ok());
+    FreeResources();
+    for (int node_index : nodes_) {
+      TfLiteNode* delegated_node;
+      TfLiteRegistration* registration;
+      TF_LITE_ENSURE_STATUS(context->GetNodeAndRegistration(
+          context, node_index, &delegated_node, &registration));
+      Program program;
+      TF_LITE_ENSURE_STATUS(gpu::GenerateShader(context, delegated_node,
+                                                registration, &program.shader));
+      TF_LITE_ENSURE_STATUS(Compile(context, &program));
+      programs_.push_back(program);
+      for (int tensor : program.shader.input_tensors) {
+        TF_LITE_ENSURE_STATUS(AllocateBuffer(context, tensor));
+      }
+      TF_LITE_ENSURE_STATUS(
+          AllocateBuffer(context, program.shader.output_tensor));
+    }
+    return kTfLiteOk;
+  }
+
+  // Uploads the inputs of the subgraph, runs its programs in order and reads
+  // back its outputs.
+  TfLiteStatus Invoke(TfLiteContext* context, TfLiteNode* node) {
+    ScopedCurrentContext current(env_.get());
+    TF_LITE_ENSURE(context, current.ok());
+    for (int tensor_index : TfLiteIntArrayView(node->inputs)) {
+      if (tensor_index == kOptionalTensor) continue;
+      const TfLiteTensor& tensor = context->tensors[tensor_index];
+      // Constant tensors were uploaded by Prepare().
+      if (tensor.allocation_type == kTfLiteMmapRo) continue;
+      auto it = buffers_.find(tensor_index);
+      if (it == buffers_.end()) continue;
+      glBindBuffer(GL_SHADER_STORAGE_BUFFER, it->second);
+      glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, tensor.bytes,
+                      tensor.data.raw);
+    }
+    TF_LITE_ENSURE_STATUS(CheckGlError(context, "Uploading inputs"));
+
+    for (const Program& program : programs_) {
+      if (program.num_groups_x == 0) continue;
+      glUseProgram(program.program);
+      const int num_inputs = program.shader.input_tensors.size();
+      for (int i = 0; i < num_inputs; ++i) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i,
+                         buffers_[program.shader.input_tensors[i]]);
+      }
+      glBindBufferBase(GL_SHADER_STORAGE_BUFFER, num_inputs,
+                       buffers_[program.shader.output_tensor]);
+      glDispatchCompute(program.num_groups_x, program.num_groups_y, 1);
+      // Later programs read the outputs of this one.
+      glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+    TF_LITE_ENSURE_STATUS(CheckGlError(context, "Dispatching programs"));
+
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    for (int tensor_index : TfLiteIntArrayView(node->outputs)) {
+      TfLiteTensor& tensor = context->tensors[tensor_index];
+      glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers_[tensor_index]);
+      const void* data = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0,
+                                          tensor.bytes, GL_MAP_READ_BIT);
+      if (data == nullptr) {
+        return CheckGlError(context, "Mapping outputs");
+      }
+      memcpy(tensor.data.raw, data, tensor.bytes);
+      glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    }
+    return CheckGlError(context, "Reading outputs");
+  }
+
+ private:
+  struct Program {
+    gpu::Shader shader;
+    GLuint program = 0;
+    int num_groups_x = 0;
+    int num_groups_y = 0;
+  };
+
+  TfLiteStatus Compile(TfLiteContext* context, Program* program) {
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    const char* source = program->shader.source.c_str();
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE) {
+      char log[1024];
+      glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+      glDeleteShader(shader);
+      context->ReportError(context, "GPU delegate: compiling failed: %s", log);
+      return kTfLiteError;
+    }
+    program->program = glCreateProgram();
+    glAttachShader(program->program, shader);
+    glLinkProgram(program->program);
+    glDeleteShader(shader);
+    glGetProgramiv(program->program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+      char log[1024];
+      glGetProgramInfoLog(program->program, sizeof(log), nullptr, log);
+      glDeleteProgram(program->program);
+      context->ReportError(context, "GPU delegate: linking failed: %s", log);
+      return kTfLiteError;
+    }
+    const int num_groups = (program->shader.num_elements +
+                            gpu::kWorkGroupSize - 1) /
+                           gpu::kWorkGroupSize;
+    program->num_groups_x = std::min(num_groups, kMaxWorkGroupCount);
+    if (num_groups > 0) {
+      program->num_groups_y = (num_groups + program->num_groups_x - 1) /
+                              program->num_groups_x;
+    }
+    return CheckGlError(context, "Compiling programs");
+  }
+
+  // Allocates the buffer of 'tensor_index' if it has none, and uploads the
+  // contents of constant tensors.
+  TfLiteStatus AllocateBuffer(TfLiteContext* context, int tensor_index) {
+    if (buffers_.count(tensor_index) != 0) return kTfLiteOk;
+    const TfLiteTensor& tensor = context->tensors[tensor_index];
+    const bool is_constant = tensor.allocation_type == kTfLiteMmapRo;
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    buffers_[tensor_index] = buffer;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    // Empty buffers cannot be bound.
+    glBufferData(GL_SHADER_STORAGE_BUFFER,
+                 std::max<size_t>(tensor.bytes, sizeof(float)),
+                 is_constant ? tensor.data.raw : nullptr,
+                 is_constant ? GL_STATIC_DRAW : GL_DYNAMIC_COPY);
+    return CheckGlError(context, "Allocating buffers");
+  }
+
+  // Requires the context to be current.
+  void FreeResources() {
+    for (const Program& program : programs_) {
+      glDeleteProgram(program.program);
+    }
+    programs_.clear();
+    for (const auto& tensor_and_buffer : buffers_) {
+      glDeleteBuffers(1, &tensor_and_buffer.second);
+    }
+    buffers_.clear();
+  }
+
+  std::unique_ptr<GlEnvironment> env_;
+  std::vector<int> nodes_;
+  std::vector<Program> programs_;
+  std::map<int, GLuint> buffers_;
+};
+
+bool IsGpuAvailable() {
+  static const bool is_available = GlEnvironment::Create() != nullptr;
+  return is_available;
+}
+#endif  // __ANDROID__
+
+}  // namespace
+
+// Return a GPU Delegate struct that can check for support of ops.
+TfLiteDelegate* GpuDelegate() {
+  static TfLiteDelegate delegate = {
+      .data_ = nullptr,
+      .Prepare = [](TfLiteContext* context,
+                    TfLiteDelegate* delegate) -> TfLiteStatus {
+#ifdef __ANDROID__
+        if (!IsGpuAvailable()) {
+          return kTfLiteOk;
+        }
+
+        std::vector<int> supported_nodes(1);
+        TfLiteIntArray* plan;
+        TF_LITE_ENSURE_STATUS(context->GetExecutionPlan(context, &plan));
+        for (int node_index : TfLiteIntArrayView(plan)) {
+          TfLiteNode* node;
+          TfLiteRegistration* registration;
+          TF_LITE_ENSURE_STATUS(context->GetNodeAndRegistration(
+              context, node_index, &node, &registration));
+          if (gpu::IsNodeSupported(context, node, registration)) {
+            supported_nodes.push_back(node_index);
+          }
+        }
+        // Put the size at the beginning of the array.
+        supported_nodes[0] = supported_nodes.size() - 1;
+
+        static const TfLiteRegistration gpu_delegate_kernel = {
+            .init = [](TfLiteContext* context, const char* buffer,
+                       size_t length) -> void* {
+              const TfLiteDelegateParams* params =
+                  reinterpret_cast<const TfLiteDelegateParams*>(buffer);
+              GpuDelegateKernel* kernel_state = new GpuDelegateKernel;
+              if (kernel_state->Init(context, params) != kTfLiteOk) {
+                delete kernel_state;
+                return nullptr;
+              }
+              return kernel_state;
+            },
+
+            .free = [](TfLiteContext* context, void* buffer) -> void {
+              delete reinterpret_cast<GpuDelegateKernel*>(buffer);
+            },
+
+            .prepare = [](TfLiteContext* context,
+                          TfLiteNode* node) -> TfLiteStatus {
+              TF_LITE_ENSURE(context, node->user_data != nullptr);
+              GpuDelegateKernel* state =
+                  reinterpret_cast<GpuDelegateKernel*>(node->user_data);
+              return state->Prepare(context, node);
+            },
+
+            .invoke = [](TfLiteContext* context,
+                         TfLiteNode* node) -> TfLiteStatus {
+              GpuDelegateKernel* state =
+                  reinterpret_cast<GpuDelegateKernel*>(node->user_data);
+              return state->Invoke(context, node);
+            },
+
+            .builtin_code = kTfLiteBuiltinDelegate,
+        };
+
+        // Request TFLite to partition the graph and make kernels for each
+        // independent subgraph a new gpu_delegate_kernel.
+        context->ReplaceSubgraphsWithDelegateKernels(
+            context, gpu_delegate_kernel,
+            reinterpret_cast<TfLiteIntArray*>(supported_nodes.data()),
+            delegate);
+#endif  // __ANDROID__
+        return kTfLiteOk;
+      }};
+
+  return &delegate;
+}
+
+}  // namespace tflite
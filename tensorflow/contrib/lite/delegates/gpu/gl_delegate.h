@@ -0,0 +1,34 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CONTRIB_LITE_DELEGATES_GPU_GL_DELEGATE_H_
+#define TENSORFLOW_CONTRIB_LITE_DELEGATES_GPU_GL_DELEGATE_H_
+
+#include "tensorflow/contrib/lite/c/c_api_internal.h"
+
+namespace tflite {
+
+// Return a delegate that runs the float convolutions, depthwise convolutions,
+// additions, concatenations, poolings and bilinear resizes of a graph on the
+// GPU with OpenGL ES 3.1 compute shaders. Each delegated subgraph keeps its
+// intermediate tensors in GPU buffers; only its inputs and outputs are copied
+// between the CPU and the GPU. e.g.
+//   interpreter->ModifyGraphWithDelegate(GpuDelegate());
+// GpuDelegate() returns a singleton, so you should not free this pointer or
+// worry about its lifetime. On platforms other than Android, or if OpenGL ES
+// 3.1 is not available, the delegate leaves the graph unchanged.
+TfLiteDelegate* GpuDelegate();
+}  // namespace tflite
+
+#endif  // TENSORFLOW_CONTRIB_LITE_DELEGATES_GPU_GL_DELEGATE_H_
@@ -0,0 +1,457 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/delegates/gpu/shaders.h"
+
+#include <cstdio>
+#include <memory>
+
+#include "tensorflow/contrib/lite/builtin_ops.h"
+#include "tensorflow/contrib/lite/c/builtin_op_data.h"
+#include "tensorflow/contrib/lite/context_util.h"
+#include "tensorflow/contrib/lite/kernels/kernel_util.h"
+#include "tensorflow/contrib/lite/kernels/padding.h"
+
+namespace tflite {
+namespace gpu {
+namespace {
+
+// Returns the GLSL literal of an int or a float constant.
+std::string Int(int value) { return std::to_string(value); }
+
+std::string Float(float value) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.9g", value);
+  std::string literal = buffer;
+  if (literal.find_first_of(".e") == std::string::npos) {
+    literal += ".0";
+  }
+  return literal;
+}
+
+bool IsSupportedActivation(TfLiteFusedActivation activation) {
+  switch (activation) {
+    case kTfLiteActNone:
+    case kTfLiteActRelu:
+    case kTfLiteActRelu1:
+    case kTfLiteActRelu6:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns the GLSL expression applying 'activation' to 'value'.
+std::string ApplyActivation(TfLiteFusedActivation activation,
+                            const std::string& value) {
+  switch (activation) {
+    case kTfLiteActRelu:
+      return "max(" + value + ", 0.0)";
+    case kTfLiteActRelu1:
+      return "clamp(" + value + ", -1.0, 1.0)";
+    case kTfLiteActRelu6:
+      return "clamp(" + value + ", 0.0, 6.0)";
+    default:
+      return value;
+  }
+}
+
+bool IsFloatTensor(TfLiteContext* context, int tensor_index, int max_rank) {
+  if (tensor_index == kOptionalTensor) return false;
+  const TfLiteTensor& tensor = context->tensors[tensor_index];
+  return tensor.type == kTfLiteFloat32 && tensor.dims != nullptr &&
+         tensor.dims->size <= max_rank && !IsDynamicTensor(&tensor);
+}
+
+const TfLiteTensor& InputTensor(TfLiteContext* context,
+                                const TfLiteNode* node, int input) {
+  return context->tensors[node->inputs->data[input]];
+}
+
+const TfLiteTensor& OutputTensor(TfLiteContext* context,
+                                 const TfLiteNode* node) {
+  return context->tensors[node->outputs->data[0]];
+}
+
+// The NHWC dimensions of a 4D tensor.
+struct Dims4 {
+  explicit Dims4(const TfLiteTensor& tensor)
+      : batches(tensor.dims->data[0]),
+        height(tensor.dims->data[1]),
+        width(tensor.dims->data[2]),
+        depth(tensor.dims->data[3]) {}
+  int batches, height, width, depth;
+};
+
+// Emits the declarations of the buffers of the shader inputs, named in<i>,
+// and of the output buffer, named out_buf.
+std::string Header(const Shader& shader) {
+  std::string source =
+      "#version 310 es\n"
+      "layout(local_size_x = " +
+      Int(kWorkGroupSize) + ") in;\n";
+  const int num_inputs = shader.input_tensors.size();
+  for (int i = 0; i < num_inputs; ++i) {
+    source += "layout(std430, binding = " + Int(i) +
+              ") readonly buffer Input" + Int(i) + " { float data[]; } in" +
+              Int(i) + ";\n";
+  }
+  source += "layout(std430, binding = " + Int(num_inputs) +
+            ") writeonly buffer Output { float data[]; } out_buf;\n";
+  return source;
+}
+
+// Emits the main function computing 'value' with 'body' for the output
+// element 'gid', whose NHWC coordinates are b, y, x, c if 'output_dims' is
+// set.
+std::string Main(const Shader& shader, const Dims4* output_dims,
+                 const std::string& body, TfLiteFusedActivation activation) {
+  std::string source =
+      "void main() {\n"
+      "  int gid = int(gl_GlobalInvocationID.y * gl_NumWorkGroups.x * " +
+      Int(kWorkGroupSize) +
+      "u + gl_GlobalInvocationID.x);\n"
+      "  if (gid >= " +
+      Int(shader.num_elements) + ") return;\n";
+  if (output_dims != nullptr) {
+    const std::string depth = Int(output_dims->depth);
+    const std::string width = Int(output_dims->width);
+    const std::string height = Int(output_dims->height);
+    source += "  int c = gid % " + depth + ";\n" + "  int x = (gid / " +
+              depth + ") % " + width + ";\n" + "  int y = (gid / " + depth +
+              " / " + width + ") % " + height + ";\n" + "  int b = gid / " +
+              depth + " / " + width + " / " + height + ";\n";
+  }
+  source += "  float value = 0.0;\n" + body +
+            "  out_buf.data[gid] = " + ApplyActivation(activation, "value") +
+            ";\n}\n";
+  return source;
+}
+
+std::string ConvolutionBody(TfLiteContext* context, const TfLiteNode* node,
+                            bool depthwise, Shader* shader) {
+  const Dims4 input(InputTensor(context, node, 0));
+  const Dims4 filter(InputTensor(context, node, 1));
+  const Dims4 output(OutputTensor(context, node));
+  int stride_width, stride_height, dilation_width, dilation_height;
+  TfLitePadding padding;
+  if (depthwise) {
+    auto* params =
+        reinterpret_cast<TfLiteDepthwiseConvParams*>(node->builtin_data);
+    stride_width = params->stride_width;
+    stride_height = params->stride_height;
+    dilation_width = params->dilation_width_factor;
+    dilation_height = params->dilation_height_factor;
+    padding = params->padding;
+  } else {
+    auto* params = reinterpret_cast<TfLiteConvParams*>(node->builtin_data);
+    stride_width = params->stride_width;
+    stride_height = params->stride_height;
+    dilation_width = params->dilation_width_factor;
+    dilation_height = params->dilation_height_factor;
+    padding = params->padding;
+  }
+  int pad_height = 0;
+  int pad_width = 0;
+  if (padding == kTfLitePaddingSame) {
+    pad_height = ComputePadding(stride_height, dilation_height, input.height,
+                                filter.height, output.height);
+    pad_width = ComputePadding(stride_width, dilation_width, input.width,
+                               filter.width, output.width);
+  }
+
+  std::string body;
+  const bool has_bias = node->inputs->size > 2 &&
+                        node->inputs->data[2] != kOptionalTensor;
+  if (has_bias) {
+    body += "  value = in2.data[c];\n";
+  }
+  body += "  for (int fy = 0; fy < " + Int(filter.height) + "; ++fy) {\n" +
+          "    int iy = y * " + Int(stride_height) + " - " + Int(pad_height) +
+          " + fy * " + Int(dilation_height) + ";\n" +
+          "    if (iy < 0 || iy >= " + Int(input.height) + ") continue;\n" +
+          "    for (int fx = 0; fx < " + Int(filter.width) + "; ++fx) {\n" +
+          "      int ix = x * " + Int(stride_width) + " - " + Int(pad_width) +
+          " + fx * " + Int(dilation_width) + ";\n" +
+          "      if (ix < 0 || ix >= " + Int(input.width) + ") continue;\n" +
+          "      int input_base = ((b * " + Int(input.height) + " + iy) * " +
+          Int(input.width) + " + ix) * " + Int(input.depth) + ";\n";
+  if (depthwise) {
+    // The filter is [1, filter_height, filter_width, output_depth], and
+    // output channel c reads input channel c / depth_multiplier.
+    const int depth_multiplier = output.depth / input.depth;
+    body += "      value += in0.data[input_base + c / " +
+            Int(depth_multiplier) + "] * in1.data[(fy * " +
+            Int(filter.width) + " + fx) * " + Int(output.depth) + " + c];\n";
+  } else {
+    // The filter is [output_depth, filter_height, filter_width, input_depth].
+    body += "      int filter_base = ((c * " + Int(filter.height) +
+            " + fy) * " + Int(filter.width) + " + fx) * " + Int(input.depth) +
+            ";\n" + "      for (int ic = 0; ic < " + Int(input.depth) +
+            "; ++ic) {\n" +
+            "        value += in0.data[input_base + ic] * "
+            "in1.data[filter_base + ic];\n" +
+            "      }\n";
+  }
+  body += "    }\n  }\n";
+  shader->input_tensors = {node->inputs->data[0], node->inputs->data[1]};
+  if (has_bias) {
+    shader->input_tensors.push_back(node->inputs->data[2]);
+  }
+  return body;
+}
+
+std::string PoolingBody(TfLiteContext* context, const TfLiteNode* node,
+                        bool max_pool, Shader* shader) {
+  auto* params = reinterpret_cast<TfLitePoolParams*>(node->builtin_data);
+  const Dims4 input(InputTensor(context, node, 0));
+  const Dims4 output(OutputTensor(context, node));
+  int pad_height = 0;
+  int pad_width = 0;
+  if (params->padding == kTfLitePaddingSame) {
+    pad_height = ComputePadding(params->stride_height, 1, input.height,
+                                params->filter_height, output.height);
+    pad_width = ComputePadding(params->stride_width, 1, input.width,
+                               params->filter_width, output.width);
+  }
+  // Like the builtin kernels, the average only counts the elements within
+  // the input.
+  std::string body = max_pool ? "  value = -3.402823466e38;\n"
+                              : "  float count = 0.0;\n";
+  body += "  for (int fy = 0; fy < " + Int(params->filter_height) +
+          "; ++fy) {\n" + "    int iy = y * " + Int(params->stride_height) +
+          " - " + Int(pad_height) + " + fy;\n" +
+          "    if (iy < 0 || iy >= " + Int(input.height) + ") continue;\n" +
+          "    for (int fx = 0; fx < " + Int(params->filter_width) +
+          "; ++fx) {\n" + "      int ix = x * " + Int(params->stride_width) +
+          " - " + Int(pad_width) + " + fx;\n" +
+          "      if (ix < 0 || ix >= " + Int(input.width) + ") continue;\n" +
+          "      float element = in0.data[((b * " + Int(input.height) +
+          " + iy) * " + Int(input.width) + " + ix) * " + Int(input.depth) +
+          " + c];\n";
+  if (max_pool) {
+    body += "      value = max(value, element);\n";
+  } else {
+    body += "      value += element;\n      count += 1.0;\n";
+  }
+  body += "    }\n  }\n";
+  if (!max_pool) {
+    body += "  value = count > 0.0 ? value / count : 0.0;\n";
+  }
+  shader->input_tensors = {node->inputs->data[0]};
+  return body;
+}
+
+std::string ResizeBilinearBody(TfLiteContext* context, const TfLiteNode* node,
+                               Shader* shader) {
+  auto* params =
+      reinterpret_cast<TfLiteResizeBilinearParams*>(node->builtin_data);
+  const Dims4 input(InputTensor(context, node, 0));
+  const Dims4 output(OutputTensor(context, node));
+  auto scale = [&](int input_size, int output_size) {
+    if (params->align_corners && output_size > 1) {
+      return static_cast<float>(input_size - 1) / (output_size - 1);
+    }
+    return static_cast<float>(input_size) / output_size;
+  };
+  // Like the reference kernel, the neighbors are clamped to the input.
+  auto element = [&](const std::string& iy, const std::string& ix) {
+    return "in0.data[((b * " + Int(input.height) + " + " + iy + ") * " +
+           Int(input.width) + " + " + ix + ") * " + Int(input.depth) + " + c]";
+  };
+  std::string body =
+      "  float in_y = float(y) * " + Float(scale(input.height, output.height)) +
+      ";\n" + "  float in_x = float(x) * " +
+      Float(scale(input.width, output.width)) + ";\n" +
+      "  int y0 = int(floor(in_y));\n" + "  int x0 = int(floor(in_x));\n" +
+      "  int y1 = min(y0 + 1, " + Int(input.height - 1) + ");\n" +
+      "  int x1 = min(x0 + 1, " + Int(input.width - 1) + ");\n" +
+      "  float dy = in_y - float(y0);\n" + "  float dx = in_x - float(x0);\n" +
+      "  value = " + element("y0", "x0") + " * (1.0 - dy) * (1.0 - dx) + " +
+      element("y1", "x0") + " * dy * (1.0 - dx) + " + element("y0", "x1") +
+      " * (1.0 - dy) * dx + " + element("y1", "x1") + " * dy * dx;\n";
+  shader->input_tensors = {node->inputs->data[0]};
+  return body;
+}
+
+std::string ConcatenationBody(TfLiteContext* context, const TfLiteNode* node,
+                              Shader* shader) {
+  auto* params =
+      reinterpret_cast<TfLiteConcatenationParams*>(node->builtin_data);
+  const TfLiteTensor& output = OutputTensor(context, node);
+  const int rank = output.dims->size;
+  const int axis = params->axis < 0 ? params->axis + rank : params->axis;
+  // The output is viewed as [outer, axis_size, inner] and each input as
+  // [outer, input_axis_size, inner].
+  int inner = 1;
+  for (int i = axis + 1; i < rank; ++i) {
+    inner *= output.dims->data[i];
+  }
+  const int axis_size = output.dims->data[axis];
+  std::string body = "  int inner = gid % " + Int(inner) + ";\n" +
+                     "  int a = (gid / " + Int(inner) + ") % " +
+                     Int(axis_size) + ";\n" + "  int outer = gid / " +
+                     Int(inner * axis_size) + ";\n";
+  int offset = 0;
+  shader->input_tensors.clear();
+  for (int i = 0; i < node->inputs->size; ++i) {
+    const int input_axis_size = InputTensor(context, node, i).dims->data[axis];
+    body += std::string(i == 0 ? "  " : "  else ") + "if (a < " +
+            Int(offset + input_axis_size) + ") {\n" + "    value = in" +
+            Int(i) + ".data[(outer * " + Int(input_axis_size) + " + a - " +
+            Int(offset) + ") * " + Int(inner) + " + inner];\n  }\n";
+    offset += input_axis_size;
+    shader->input_tensors.push_back(node->inputs->data[i]);
+  }
+  return body;
+}
+
+}  // namespace
+
+bool IsNodeSupported(TfLiteContext* context, const TfLiteNode* node,
+                     const TfLiteRegistration* registration) {
+  if (node->outputs->size != 1 ||
+      !IsFloatTensor(context, node->outputs->data[0], 4)) {
+    return false;
+  }
+  const TfLiteTensor& output = OutputTensor(context, node);
+  auto is_4d_float_input = [&](int input) {
+    return node->inputs->size > input &&
+           IsFloatTensor(context, node->inputs->data[input], 4) &&
+           InputTensor(context, node, input).dims->size == 4;
+  };
+  switch (registration->builtin_code) {
+    case kTfLiteBuiltinAdd: {
+      auto* params = reinterpret_cast<TfLiteAddParams*>(node->builtin_data);
+      return node->inputs->size == 2 &&
+             IsFloatTensor(context, node->inputs->data[0], 4) &&
+             IsFloatTensor(context, node->inputs->data[1], 4) &&
+             TfLiteIntArrayEqual(InputTensor(context, node, 0).dims,
+                                 InputTensor(context, node, 1).dims) &&
+             IsSupportedActivation(params->activation);
+    }
+    case kTfLiteBuiltinConv2d:
+    case kTfLiteBuiltinDepthwiseConv2d: {
+      if (!is_4d_float_input(0) || !is_4d_float_input(1) ||
+          output.dims->size != 4) {
+        return false;
+      }
+      if (node->inputs->size > 2 && node->inputs->data[2] != kOptionalTensor &&
+          !IsFloatTensor(context, node->inputs->data[2], 1)) {
+        return false;
+      }
+      TfLiteFusedActivation activation;
+      if (registration->builtin_code == kTfLiteBuiltinConv2d) {
+        activation =
+            reinterpret_cast<TfLiteConvParams*>(node->builtin_data)->activation;
+      } else {
+        activation = reinterpret_cast<TfLiteDepthwiseConvParams*>(
+                         node->builtin_data)
+                         ->activation;
+        const int input_depth = InputTensor(context, node, 0).dims->data[3];
+        if (InputTensor(context, node, 1).dims->data[0] != 1 ||
+            output.dims->data[3] % input_depth != 0) {
+          return false;
+        }
+      }
+      return IsSupportedActivation(activation);
+    }
+    case kTfLiteBuiltinConcatenation: {
+      auto* params =
+          reinterpret_cast<TfLiteConcatenationParams*>(node->builtin_data);
+      const int rank = output.dims->size;
+      if (params->axis < -rank || params->axis >= rank) return false;
+      for (int input : TfLiteIntArrayView(node->inputs)) {
+        if (!IsFloatTensor(context, input, 4) ||
+            context->tensors[input].dims->size != rank) {
+          return false;
+        }
+      }
+      return IsSupportedActivation(params->activation);
+    }
+    case kTfLiteBuiltinAveragePool2d:
+    case kTfLiteBuiltinMaxPool2d: {
+      auto* params = reinterpret_cast<TfLitePoolParams*>(node->builtin_data);
+      return is_4d_float_input(0) && output.dims->size == 4 &&
+             IsSupportedActivation(params->activation);
+    }
+    case kTfLiteBuiltinResizeBilinear:
+      return is_4d_float_input(0) && output.dims->size == 4;
+    default:
+      return false;
+  }
+}
+
+TfLiteStatus GenerateShader(TfLiteContext* context, const TfLiteNode* node,
+                            const TfLiteRegistration* registration,
+                            Shader* shader) {
+  const TfLiteTensor& output = OutputTensor(context, node);
+  shader->output_tensor = node->outputs->data[0];
+  shader->num_elements = NumElements(&output);
+  std::string body;
+  TfLiteFusedActivation activation = kTfLiteActNone;
+  bool needs_coordinates = true;
+  switch (registration->builtin_code) {
+    case kTfLiteBuiltinAdd:
+      activation =
+          reinterpret_cast<TfLiteAddParams*>(node->builtin_data)->activation;
+      shader->input_tensors = {node->inputs->data[0], node->inputs->data[1]};
+      body = "  value = in0.data[gid] + in1.data[gid];\n";
+      needs_coordinates = false;
+      break;
+    case kTfLiteBuiltinConv2d:
+      activation =
+          reinterpret_cast<TfLiteConvParams*>(node->builtin_data)->activation;
+      body = ConvolutionBody(context, node, /*depthwise=*/false, shader);
+      break;
+    case kTfLiteBuiltinDepthwiseConv2d:
+      activation =
+          reinterpret_cast<TfLiteDepthwiseConvParams*>(node->builtin_data)
+              ->activation;
+      body = ConvolutionBody(context, node, /*depthwise=*/true, shader);
+      break;
+    case kTfLiteBuiltinConcatenation:
+      activation =
+          reinterpret_cast<TfLiteConcatenationParams*>(node->builtin_data)
+              ->activation;
+      body = ConcatenationBody(context, node, shader);
+      needs_coordinates = false;
+      break;
+    case kTfLiteBuiltinAveragePool2d:
+    case kTfLiteBuiltinMaxPool2d:
+      activation =
+          reinterpret_cast<TfLitePoolParams*>(node->builtin_data)->activation;
+      body = PoolingBody(
+          context, node,
+          registration->builtin_code == kTfLiteBuiltinMaxPool2d, shader);
+      break;
+    case kTfLiteBuiltinResizeBilinear:
+      body = ResizeBilinearBody(context, node, shader);
+      break;
+    default:
+      context->ReportError(context, "Op %d is not supported by the GPU.",
+                           registration->builtin_code);
+      return kTfLiteError;
+  }
+  std::unique_ptr<Dims4> output_dims;
+  if (needs_coordinates) {
+    output_dims.reset(new Dims4(output));
+  }
+  shader->source =
+      Header(*shader) + Main(*shader, output_dims.get(), body, activation);
+  return kTfLiteOk;
+}
+
+}  // namespace gpu
+}  // namespace tflite
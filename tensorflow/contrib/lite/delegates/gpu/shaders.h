@@ -0,0 +1,61 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CONTRIB_LITE_DELEGATES_GPU_SHADERS_H_
+#define TENSORFLOW_CONTRIB_LITE_DELEGATES_GPU_SHADERS_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/contrib/lite/c/c_api_internal.h"
+
+namespace tflite {
+namespace gpu {
+
+// Number of invocations in the x dimension of a work group of the generated
+// compute shaders.
+constexpr int kWorkGroupSize = 64;
+
+// A GLSL ES 3.1 compute shader computing the output of a single node. Tensors
+// are stored in shader storage buffers as densely packed floats, in the
+// layout of the TfLiteTensor. The shader reads the tensors 'input_tensors'
+// from the buffer bindings 0 to n - 1 and writes 'output_tensor' to the
+// binding n. Each invocation computes one output element; the invocations are
+// numbered row-major over the dispatched work groups, so any dispatch of at
+// least ceil(num_elements / kWorkGroupSize) groups of kWorkGroupSize
+// invocations is valid.
+struct Shader {
+  std::string source;
+  std::vector<int> input_tensors;
+  int output_tensor = -1;
+  int num_elements = 0;
+};
+
+// Returns whether the node can be computed by GenerateShader(): a float
+// CONV_2D, DEPTHWISE_CONV_2D, ADD of two tensors of the same shape,
+// CONCATENATION, AVERAGE_POOL_2D, MAX_POOL_2D or RESIZE_BILINEAR, with no
+// fused activation or a fused ReLU, ReLU1 or ReLU6.
+bool IsNodeSupported(TfLiteContext* context, const TfLiteNode* node,
+                     const TfLiteRegistration* registration);
+
+// Generates the shader computing 'node' with the current shapes of its
+// tensors. The node must be supported.
+TfLiteStatus GenerateShader(TfLiteContext* context, const TfLiteNode* node,
+                            const TfLiteRegistration* registration,
+                            Shader* shader);
+
+}  // namespace gpu
+}  // namespace tflite
+
+#endif  // TENSORFLOW_CONTRIB_LITE_DELEGATES_GPU_SHADERS_H_
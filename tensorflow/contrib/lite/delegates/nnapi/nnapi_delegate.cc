@@ -12,7 +12,9 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
 #include <cstdarg>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <vector>
@@ -23,6 +25,7 @@ limitations under the License.
 #include "tensorflow/contrib/lite/c/c_api_internal.h"
 #include "tensorflow/contrib/lite/context_util.h"
 #include "tensorflow/contrib/lite/delegates/nnapi/nnapi_delegate.h"
+#include "tensorflow/contrib/lite/graph_info.h"
 #include "tensorflow/contrib/lite/kernels/kernel_util.h"
 #include "tensorflow/contrib/lite/nnapi/NeuralNetworksShim.h"
 
@@ -65,6 +68,7 @@ int32_t GetAndroidSdkVersion() {
 
 constexpr int32_t kMinSdkVersionForNNAPI = 27;
 constexpr int32_t kMinSdkVersionForNNAPI11 = 28;
+constexpr int32_t kMinSdkVersionForNNAPI12 = 29;
 static const int32_t kAndroidSdkVersion = GetAndroidSdkVersion();
 
 }  // namespace
@@ -374,6 +378,56 @@ struct NNAPIOpMappingArgs {
   std::vector<int>* model_state_tfl_inputs;
 };
 
+// Returns the options of `delegate`, or the defaults of the NnApiDelegate()
+// singleton, which has no options.
+NnApiDelegateOptions GetOptions(const TfLiteDelegate* delegate) {
+  if (delegate == nullptr || delegate->data_ == nullptr) {
+    NnApiDelegateOptions options;
+    options.skip_small_partitions = false;
+    return options;
+  }
+  return *reinterpret_cast<const NnApiDelegateOptions*>(delegate->data_);
+}
+
+// Fills the ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN bytes of `token` with a
+// fingerprint of the model token and of the delegated subgraph, so that each
+// subgraph of a model gets its own cache entry. It uses FNV-1a, seeded
+// differently for each 8 bytes of the token.
+void ComputeCacheToken(TfLiteContext* context, const std::string& model_token,
+                       const TfLiteDelegateParams* params, uint8_t* token) {
+  std::vector<int32_t> signature;
+  auto append = [&signature](const TfLiteIntArray* array) {
+    signature.push_back(array->size);
+    signature.insert(signature.end(), array->data, array->data + array->size);
+  };
+  append(params->nodes_to_replace);
+  for (const TfLiteIntArray* tensors :
+       {params->input_tensors, params->output_tensors}) {
+    append(tensors);
+    for (int i : TfLiteIntArrayView(tensors)) {
+      if (i == kOptionalTensor) continue;
+      signature.push_back(context->tensors[i].type);
+      if (context->tensors[i].dims) append(context->tensors[i].dims);
+    }
+  }
+
+  constexpr int kHashSize = sizeof(uint64_t);
+  constexpr int kNumHashes =
+      ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN / kHashSize;
+  for (int part = 0; part < kNumHashes; ++part) {
+    uint64_t hash = 0xcbf29ce484222325ULL + part;
+    auto mix = [&hash](const void* data, size_t size) {
+      const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+      for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+      }
+    };
+    mix(model_token.data(), model_token.size());
+    mix(signature.data(), signature.size() * sizeof(int32_t));
+    memcpy(token + part * kHashSize, &hash, kHashSize);
+  }
+}
+
 // The kernel that represents the subgraph of TF Lite being run on NN API.
 class NNAPIDelegateKernel {
  public:
@@ -940,6 +994,16 @@ class NNAPIDelegateKernel {
       ANeuralNetworksCompilation* compilation;
       CHECK_NN(context, ANeuralNetworksCompilation_create(nn_model_.get(),
                                                           &compilation));
+      // Let the driver reuse the compilation of a previous run of the model.
+      const NnApiDelegateOptions options = GetOptions(params->delegate);
+      if (kAndroidSdkVersion >= kMinSdkVersionForNNAPI12 &&
+          !options.cache_dir.empty() && !options.model_token.empty()) {
+        uint8_t token[ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN];
+        ComputeCacheToken(context, options.model_token, params, token);
+        CHECK_NN(context,
+                 ANeuralNetworksCompilation_setCaching(
+                     compilation, options.cache_dir.c_str(), token));
+      }
       CHECK_NN(context, ANeuralNetworksCompilation_finish(compilation));
       nn_compilation_.reset(compilation);
     }
@@ -1135,86 +1199,220 @@ class NNAPIDelegateKernel {
   }
 };
 
+// Exposes the nodes of the execution plan to the graph partitioner. Node
+// `i` of the graph is the `i`th node of the plan.
+class ExecutionPlanInfo : public GraphInfo {
+ public:
+  ExecutionPlanInfo(TfLiteContext* context, const TfLiteIntArray* plan)
+      : context_(context), plan_(plan) {}
+
+  size_t num_tensors() const override { return context_->tensors_size; }
+  TfLiteTensor* tensor(size_t index) override {
+    return &context_->tensors[index];
+  }
+  size_t num_nodes() const override { return plan_->size; }
+  const TfLiteNode& node(size_t index) const override {
+    TfLiteNode* node;
+    TfLiteRegistration* registration;
+    context_->GetNodeAndRegistration(context_, plan_->data[index], &node,
+                                     &registration);
+    return *node;
+  }
+  // The partitioner only needs the nodes and tensors.
+  const std::vector<int>& inputs() const override { return empty_; }
+  const std::vector<int>& outputs() const override { return empty_; }
+  const std::vector<int>& variables() const override { return empty_; }
+
+ private:
+  TfLiteContext* context_;
+  const TfLiteIntArray* plan_;
+  const std::vector<int> empty_;
+};
+
+// Rough cost model deciding whether a partition is worth delegating. Running
+// a partition on NN API costs a fixed overhead for the execution plus a copy
+// of its inputs and outputs, which a partition of few cheap ops (e.g. a lone
+// elementwise op between two unsupported ops) doesn't recover.
+constexpr int64_t kPartitionOverheadOps = 100000;
+constexpr int64_t kOpsPerTransferredElement = 4;
+
+// Returns an estimate of the multiply-adds computed by `node`.
+int64_t EstimateOps(TfLiteContext* context, int builtin_code,
+                    const TfLiteNode& node) {
+  if (node.outputs->size == 0) return 0;
+  const int64_t output_elements =
+      NumElements(&context->tensors[node.outputs->data[0]]);
+  if (node.inputs->size < 2 || node.inputs->data[1] == kOptionalTensor) {
+    return output_elements;
+  }
+  const TfLiteTensor& filter = context->tensors[node.inputs->data[1]];
+  switch (builtin_code) {
+    case kTfLiteBuiltinConv2d:
+    case kTfLiteBuiltinFullyConnected:
+      // The filter has the output channels in its first dimension.
+      return output_elements * NumElements(&filter) /
+             std::max(1, SizeOfDimension(&filter, 0));
+    case kTfLiteBuiltinDepthwiseConv2d:
+      // The filter has the output channels in its last dimension.
+      return output_elements * NumElements(&filter) /
+             std::max(1, SizeOfDimension(&filter, NumDimensions(&filter) - 1));
+    default:
+      return output_elements;
+  }
+}
+
+// Returns true if running `subgraph`, whose nodes are positions in `plan`, on
+// NN API is estimated to be faster than running it on the CPU.
+bool IsWorthDelegating(TfLiteContext* context, const TfLiteIntArray* plan,
+                       const Subgraph& subgraph) {
+  // Without partitions left on the CPU there is nothing to save.
+  if (subgraph.nodes.size() == plan->size) return true;
+
+  int64_t ops = 0;
+  std::vector<int> produced;
+  std::vector<int> consumed;
+  for (int position : subgraph.nodes) {
+    TfLiteNode* node;
+    TfLiteRegistration* registration;
+    context->GetNodeAndRegistration(context, plan->data[position], &node,
+                                    &registration);
+    ops += EstimateOps(context, registration->builtin_code, *node);
+    produced.insert(produced.end(), node->outputs->data,
+                    node->outputs->data + node->outputs->size);
+    consumed.insert(consumed.end(), node->inputs->data,
+                    node->inputs->data + node->inputs->size);
+  }
+
+  int64_t transferred_elements = 0;
+  for (int i : subgraph.input_tensors) {
+    if (i != kOptionalTensor &&
+        context->tensors[i].allocation_type != kTfLiteMmapRo) {
+      transferred_elements += NumElements(&context->tensors[i]);
+    }
+  }
+  // Outputs of the partition are the tensors it produces but does not use.
+  for (int i : produced) {
+    if (std::find(consumed.begin(), consumed.end(), i) == consumed.end()) {
+      transferred_elements += NumElements(&context->tensors[i]);
+    }
+  }
+  return ops >= kPartitionOverheadOps +
+                    kOpsPerTransferredElement * transferred_elements;
+}
+
+TfLiteStatus DelegatePrepare(TfLiteContext* context,
+                             TfLiteDelegate* delegate) {
+  // Do not check nodes_ if NN API is unavailable.
+  if (kAndroidSdkVersion < kMinSdkVersionForNNAPI || !NNAPIExists()) {
+    return kTfLiteOk;
+  }
+
+  // Positions in the plan of the supported nodes, size first.
+  std::vector<int> supported_nodes(1);
+  // We don't care about all nodes_, we only care about ones in the
+  // current plan.
+  TfLiteIntArray* plan;
+  TF_LITE_ENSURE_STATUS(context->GetExecutionPlan(context, &plan));
+
+  // Check for every node if it is supported
+  // TODO(b/80625235): Fix this to do more careful checking of versioning.
+  for (int position = 0; position < plan->size; ++position) {
+    TfLiteNode* node;
+    TfLiteRegistration* registration;
+    TF_LITE_ENSURE_STATUS(context->GetNodeAndRegistration(
+        context, plan->data[position], &node, &registration));
+    NNAPIDelegateKernel dummy_kernel;
+    if (dummy_kernel.Map(context, registration->builtin_code,
+                         registration->version, node)) {
+      supported_nodes.push_back(position);
+    }
+  }
+  // Put the size at the beginning of the array.
+  supported_nodes[0] = supported_nodes.size() - 1;
+
+  // Split the supported nodes into the partitions between unsupported nodes,
+  // and keep those worth the cost of running on NN API.
+  ExecutionPlanInfo info(context, plan);
+  std::vector<Subgraph> subgraphs;
+  TF_LITE_ENSURE_STATUS(PartitionGraphIntoIndependentSubgraphs(
+      &info, reinterpret_cast<TfLiteIntArray*>(supported_nodes.data()),
+      &subgraphs));
+  const bool skip_small_partitions =
+      GetOptions(delegate).skip_small_partitions;
+  std::vector<int> nodes_to_replace(1);
+  for (const Subgraph& subgraph : subgraphs) {
+    if (subgraph.type != Subgraph::kTfPartition) continue;
+    if (skip_small_partitions &&
+        !IsWorthDelegating(context, plan, subgraph)) {
+      continue;
+    }
+    for (int position : subgraph.nodes) {
+      nodes_to_replace.push_back(plan->data[position]);
+    }
+  }
+  nodes_to_replace[0] = nodes_to_replace.size() - 1;
+  if (nodes_to_replace[0] == 0) return kTfLiteOk;
+
+  // NN API Delegate Registration (the pseudo kernel that will invoke NN
+  // API subgraphs)
+  static const TfLiteRegistration nnapi_delegate_kernel = {
+      .init = [](TfLiteContext* context, const char* buffer,
+                 size_t length) -> void* {
+        const TfLiteDelegateParams* params =
+            reinterpret_cast<const TfLiteDelegateParams*>(buffer);
+        NNAPIDelegateKernel* kernel_state = new NNAPIDelegateKernel;
+        kernel_state->Init(context, params);
+        return kernel_state;
+      },
+
+      .free = [](TfLiteContext* context, void* buffer) -> void {
+        delete reinterpret_cast<NNAPIDelegateKernel*>(buffer);
+      },
+
+      .prepare = [](TfLiteContext* context, TfLiteNode* node) -> TfLiteStatus {
+        // Since the underlying resize happened ahead of delegation
+        // worked. This does nothing.
+        return kTfLiteOk;
+      },
+
+      .invoke = [](TfLiteContext* context, TfLiteNode* node) -> TfLiteStatus {
+        NNAPIDelegateKernel* state =
+            reinterpret_cast<NNAPIDelegateKernel*>(node->user_data);
+        return state->Invoke(context, node);
+      },
+
+      .builtin_code = kTfLiteBuiltinDelegate,
+  };
+
+  // Request TFLite to partition the graph and make kernels
+  // for each independent subgraph a new nnapi_delegate_kernel.
+  return context->ReplaceSubgraphsWithDelegateKernels(
+      context, nnapi_delegate_kernel,
+      reinterpret_cast<TfLiteIntArray*>(nodes_to_replace.data()), delegate);
+}
+
 }  // namespace
 
 // Return a NN API Delegate struct that can check for support of ops.
 TfLiteDelegate* NnApiDelegate() {
   static TfLiteDelegate delegate = {
       .data_ = nullptr,
-      .Prepare = [](TfLiteContext* context,
-                    TfLiteDelegate* delegate) -> TfLiteStatus {
-        // Do not check nodes_ if NN API is unavailable.
-        if (kAndroidSdkVersion < kMinSdkVersionForNNAPI || !NNAPIExists()) {
-          return kTfLiteOk;
-        }
-
-        std::vector<int> supported_nodes(1);
-        // We don't care about all nodes_, we only care about ones in the
-        // current plan.
-        TfLiteIntArray* plan;
-        TF_LITE_ENSURE_STATUS(context->GetExecutionPlan(context, &plan));
-        int total_supported_nodes = 0;
-
-        // Check for every node if it is supported
-        // TODO(b/80625235): Fix this to do more careful checking of versioning.
-        for (int node_index : TfLiteIntArrayView(plan)) {
-          TfLiteNode* node;
-          TfLiteRegistration* registration;
-          TF_LITE_ENSURE_STATUS(context->GetNodeAndRegistration(
-              context, node_index, &node, &registration));
-          NNAPIDelegateKernel dummy_kernel;
-          if (dummy_kernel.Map(context, registration->builtin_code,
-                               registration->version, node)) {
-            supported_nodes.push_back(node_index);
-          }
-          total_supported_nodes += 1;
-        }
-        // Put the size at the beginning of the array.
-        supported_nodes[0] = supported_nodes.size() - 1;
-
-        // NN API Delegate Registration (the pseudo kernel that will invoke NN
-        // API subgraphs)
-        static const TfLiteRegistration nnapi_delegate_kernel = {
-            .init = [](TfLiteContext* context, const char* buffer,
-                       size_t length) -> void* {
-              const TfLiteDelegateParams* params =
-                  reinterpret_cast<const TfLiteDelegateParams*>(buffer);
-              NNAPIDelegateKernel* kernel_state = new NNAPIDelegateKernel;
-              kernel_state->Init(context, params);
-              return kernel_state;
-            },
-
-            .free = [](TfLiteContext* context, void* buffer) -> void {
-              delete reinterpret_cast<NNAPIDelegateKernel*>(buffer);
-            },
-
-            .prepare = [](TfLiteContext* context,
-                          TfLiteNode* node) -> TfLiteStatus {
-              // Since the underlying resize happened ahead of delegation
-              // worked. This does nothing.
-              return kTfLiteOk;
-            },
-
-            .invoke = [](TfLiteContext* context,
-                         TfLiteNode* node) -> TfLiteStatus {
-              NNAPIDelegateKernel* state =
-                  reinterpret_cast<NNAPIDelegateKernel*>(node->user_data);
-              return state->Invoke(context, node);
-            },
-
-            .builtin_code = kTfLiteBuiltinDelegate,
-        };
-
-        // Request TFLite to partition the graph and make kernels
-        // for each independent subgraph a new nnapi_delegate_kernel.
-        context->ReplaceSubgraphsWithDelegateKernels(
-            context, nnapi_delegate_kernel,
-            reinterpret_cast<TfLiteIntArray*>(supported_nodes.data()),
-            delegate);
-        return kTfLiteOk;
-      }};
+      .Prepare = DelegatePrepare,
+  };
 
   return &delegate;
 }
 
+std::unique_ptr<TfLiteDelegate, void (*)(TfLiteDelegate*)> CreateNnApiDelegate(
+    const NnApiDelegateOptions& options) {
+  TfLiteDelegate* delegate = new TfLiteDelegate();
+  delegate->data_ = new NnApiDelegateOptions(options);
+  delegate->Prepare = DelegatePrepare;
+  return std::unique_ptr<TfLiteDelegate, void (*)(TfLiteDelegate*)>(
+      delegate, [](TfLiteDelegate* delegate) {
+        delete reinterpret_cast<NnApiDelegateOptions*>(delegate->data_);
+        delete delegate;
+      });
+}
+
 }  // namespace tflite
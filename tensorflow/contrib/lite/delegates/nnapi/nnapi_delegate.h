@@ -15,17 +15,40 @@ limitations under the License.
 #ifndef TENSORFLOW_CONTRIB_LITE_DELEGATES_NNAPI_NNAPI_DELEGATE_H_
 #define TENSORFLOW_CONTRIB_LITE_DELEGATES_NNAPI_NNAPI_DELEGATE_H_
 
+#include <memory>
+#include <string>
+
 #include "tensorflow/contrib/lite/c/c_api_internal.h"
 
 namespace tflite {
 
+// Options of a delegate returned by CreateNnApiDelegate().
+struct NnApiDelegateOptions {
+  // Directory in which the NN API driver may cache compiled models, and a
+  // token identifying the model (e.g. a hash of the model file). Compilation
+  // caching requires both, and Android Q (API level 29) or later.
+  std::string cache_dir;
+  std::string model_token;
+
+  // If true, subgraphs whose estimated compute is too small to pay for
+  // moving their inputs and outputs to the NN API device stay on the CPU.
+  bool skip_small_partitions = true;
+};
+
 // Return a delegate that can be used to use the NN API.
 // e.g.
 //   NnApiDelegate* delegate = NnApiDelegate();
 //   interpreter->ModifyGraphWithDelegate(&delegate);
 // NnApiDelegate() returns a singleton, so you should not free this
 // pointer or worry about its lifetime.
+// It delegates every supported node and does not cache compilations.
 TfLiteDelegate* NnApiDelegate();
+
+// Return a NN API delegate configured with `options`. Unlike NnApiDelegate(),
+// the caller owns the delegate, which must outlive any interpreter using it.
+std::unique_ptr<TfLiteDelegate, void (*)(TfLiteDelegate*)> CreateNnApiDelegate(
+    const NnApiDelegateOptions& options);
+
 }  // namespace tflite
 
 #endif  // TENSORFLOW_CONTRIB_LITE_DELEGATES_NNAPI_NNAPI_DELEGATE_H_
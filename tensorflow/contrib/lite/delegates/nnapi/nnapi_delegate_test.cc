@@ -29,9 +29,9 @@ using ::testing::ElementsAreArray;
 
 class SingleOpModelWithNNAPI : public SingleOpModel {
  public:
-  SingleOpModelWithNNAPI() {
-    this->SetApplyDelegate([](Interpreter* interpreter) {
-      interpreter->ModifyGraphWithDelegate(NnApiDelegate(), false);
+  explicit SingleOpModelWithNNAPI(TfLiteDelegate* delegate = NnApiDelegate()) {
+    this->SetApplyDelegate([delegate](Interpreter* interpreter) {
+      interpreter->ModifyGraphWithDelegate(delegate, false);
     });
   }
 };
@@ -41,7 +41,9 @@ class FloatAddOpModel : public SingleOpModelWithNNAPI {
   FloatAddOpModel(const TensorData& input1, const TensorData& input2,
                   const TensorData& output,
                   ActivationFunctionType activation_type,
-                  bool allow_fp32_relax_to_fp16 = false) {
+                  bool allow_fp32_relax_to_fp16 = false,
+                  TfLiteDelegate* delegate = NnApiDelegate())
+      : SingleOpModelWithNNAPI(delegate) {
     input1_ = AddInput(input1);
     input2_ = AddInput(input2);
     output_ = AddOutput(output);
@@ -97,6 +99,42 @@ TEST(NNAPIDelegate, AddWithRelu) {
   EXPECT_THAT(m.GetOutput(), ElementsAreArray({0.0, 0.4, 1.0, 1.3}));
 }
 
+// Do a test with a delegate caching its compilations, twice with the same
+// model token.
+TEST(NNAPIDelegate, AddWithCompilationCaching) {
+  NnApiDelegateOptions options;
+  options.cache_dir = ::testing::TempDir();
+  options.model_token = "add_with_compilation_caching";
+  auto delegate = CreateNnApiDelegate(options);
+  for (int run = 0; run < 2; ++run) {
+    FloatAddOpModel m({TensorType_FLOAT32, {1, 2, 2, 1}},
+                      {TensorType_FLOAT32, {1, 2, 2, 1}},
+                      {TensorType_FLOAT32, {}}, ActivationFunctionType_NONE,
+                      /*allow_fp32_relax_to_fp16=*/false, delegate.get());
+    m.PopulateTensor<float>(m.input1(), {-2.0, 0.2, 0.7, 0.8});
+    m.PopulateTensor<float>(m.input2(), {0.1, 0.2, 0.3, 0.5});
+    m.Invoke();
+    EXPECT_THAT(m.GetOutput(),
+                ElementsAreArray(ArrayFloatNear({-1.9, 0.4, 1.0, 1.3})));
+  }
+}
+
+// Do a test with a delegate that may leave small partitions on the CPU.
+TEST(NNAPIDelegate, AddSkippingSmallPartitions) {
+  NnApiDelegateOptions options;
+  options.skip_small_partitions = true;
+  auto delegate = CreateNnApiDelegate(options);
+  FloatAddOpModel m({TensorType_FLOAT32, {1, 2, 2, 1}},
+                    {TensorType_FLOAT32, {1, 2, 2, 1}},
+                    {TensorType_FLOAT32, {}}, ActivationFunctionType_RELU,
+                    /*allow_fp32_relax_to_fp16=*/false, delegate.get());
+  m.PopulateTensor<float>(m.input1(), {-2.0, 0.2, 0.7, 0.8});
+  m.PopulateTensor<float>(m.input2(), {0.1, 0.2, 0.3, 0.5});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear({0.0, 0.4, 1.0, 1.3})));
+}
+
 class FloatMulOpModel : public SingleOpModelWithNNAPI {
  public:
   FloatMulOpModel(const TensorData& input1, const TensorData& input2,
@@ -41,6 +41,35 @@ void TFL_InterpreterOptionsAddCustomOp(TFL_InterpreterOptions* options,
   options->op_resolver.AddCustom(name, registration, min_version, max_version);
 }
 
+TFL_Status TFL_InterpreterSetOpStatsWindowSize(TFL_Interpreter* interpreter,
+                                               int32_t window_size) {
+  return interpreter->impl->SetOpStatsWindowSize(window_size);
+}
+
+int32_t TFL_InterpreterUpdateOpStats(TFL_Interpreter* interpreter,
+                                     int32_t by_op_type) {
+  interpreter->op_stats = interpreter->impl->GetOpStats(by_op_type != 0);
+  return static_cast<int32_t>(interpreter->op_stats.size());
+}
+
+TFL_Status TFL_InterpreterGetOpStats(const TFL_Interpreter* interpreter,
+                                     int32_t index, TFL_OpStats* stats) {
+  if (index < 0 || index >= interpreter->op_stats.size()) {
+    return kTfLiteError;
+  }
+  const tflite::profiling::OpStats& op_stats = interpreter->op_stats[index];
+  stats->name = op_stats.name.c_str();
+  stats->op_type = op_stats.op_type.c_str();
+  stats->num_nodes = op_stats.num_nodes;
+  stats->count = op_stats.count;
+  stats->mean_us = op_stats.mean_us;
+  stats->p50_us = op_stats.p50_us;
+  stats->p99_us = op_stats.p99_us;
+  stats->max_us = op_stats.max_us;
+  stats->memory_bytes = op_stats.memory_bytes;
+  return kTfLiteOk;
+}
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -50,6 +50,36 @@ void TFL_InterpreterOptionsAddCustomOp(TFL_InterpreterOptions* options,
                                        const TFL_Registration* registration,
                                        int min_version, int max_version);
 
+// Latency and memory statistics of a node, or of all nodes of one op type.
+// Latencies are in microseconds. See tflite::profiling::OpStats.
+typedef struct {
+  const char* name;
+  const char* op_type;
+  int32_t num_nodes;
+  int64_t count;
+  double mean_us;
+  int64_t p50_us;
+  int64_t p99_us;
+  int64_t max_us;
+  int64_t memory_bytes;
+} TFL_OpStats;
+
+// Starts collecting per-op latency statistics over the last `window_size`
+// invocations, or stops collecting them if `window_size` is 0.
+TFL_CAPI_EXPORT extern TFL_Status TFL_InterpreterSetOpStatsWindowSize(
+    TFL_Interpreter* interpreter, int32_t window_size);
+
+// Takes a snapshot of the collected per-op statistics, per node or per op type
+// if `by_op_type` is non-zero, and returns the number of entries in it.
+TFL_CAPI_EXPORT extern int32_t TFL_InterpreterUpdateOpStats(
+    TFL_Interpreter* interpreter, int32_t by_op_type);
+
+// Fills in `stats` with entry `index` of the last snapshot taken by
+// TFL_InterpreterUpdateOpStats(). Its strings are valid until the next
+// snapshot.
+TFL_CAPI_EXPORT extern TFL_Status TFL_InterpreterGetOpStats(
+    const TFL_Interpreter* interpreter, int32_t index, TFL_OpStats* stats);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
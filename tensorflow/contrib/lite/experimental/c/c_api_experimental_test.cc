@@ -47,6 +47,17 @@ TEST(CApiExperimentalSimple, Smoke) {
   EXPECT_EQ(TFL_InterpreterResetVariableTensors(interpreter), kTfLiteOk);
   EXPECT_EQ(TFL_InterpreterInvoke(interpreter), kTfLiteOk);
 
+  EXPECT_EQ(TFL_InterpreterSetOpStatsWindowSize(interpreter, 4), kTfLiteOk);
+  EXPECT_EQ(TFL_InterpreterInvoke(interpreter), kTfLiteOk);
+  EXPECT_EQ(TFL_InterpreterInvoke(interpreter), kTfLiteOk);
+  ASSERT_EQ(TFL_InterpreterUpdateOpStats(interpreter, /*by_op_type=*/1), 1);
+  TFL_OpStats stats;
+  ASSERT_EQ(TFL_InterpreterGetOpStats(interpreter, 0, &stats), kTfLiteOk);
+  EXPECT_STREQ(stats.op_type, "ADD");
+  EXPECT_EQ(stats.num_nodes, 2);
+  EXPECT_EQ(stats.count, 2);
+  EXPECT_EQ(TFL_InterpreterGetOpStats(interpreter, 1, &stats), kTfLiteError);
+
   TFL_DeleteInterpreter(interpreter);
   TFL_DeleteInterpreterOptions(options);
   TFL_DeleteModel(model);
@@ -56,6 +56,9 @@ struct TFL_Interpreter {
   std::unique_ptr<tflite::ErrorReporter> optional_error_reporter;
 
   std::unique_ptr<tflite::Interpreter> impl;
+
+  // Last snapshot taken by TFL_InterpreterUpdateOpStats().
+  std::vector<tflite::profiling::OpStats> op_stats;
 };
 
 #endif  // TENSORFLOW_CONTRIB_LITE_EXPERIMENTAL_C_C_API_INTERNAL_H_
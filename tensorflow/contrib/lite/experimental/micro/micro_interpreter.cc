@@ -61,7 +61,8 @@ void ReportOpError(struct TfLiteContext* context, const char* format, ...) {
 MicroInterpreter::MicroInterpreter(const Model* model,
                                    const OpResolver& op_resolver,
                                    SimpleTensorAllocator* tensor_allocator,
-                                   ErrorReporter* error_reporter)
+                                   ErrorReporter* error_reporter,
+                                   const MicroMemoryPlan* memory_plan)
     : model_(model),
       op_resolver_(op_resolver),
       tensor_allocator_(tensor_allocator),
@@ -83,12 +84,44 @@ MicroInterpreter::MicroInterpreter(const Model* model,
   context_.tensors =
       reinterpret_cast<TfLiteTensor*>(tensor_allocator_->AllocateMemory(
           sizeof(TfLiteTensor) * context_.tensors_size, 4));
+
+  // Reserve the planned part of the arena, and look up the place of each
+  // tensor in it.
+  uint8_t* planned_arena = nullptr;
+  if (memory_plan) {
+    if (memory_plan->tensors_size != tensors_->Length()) {
+      error_reporter->Report(
+          "Memory plan has %d tensors, but the model has %d.\n",
+          memory_plan->tensors_size, tensors_->Length());
+      initialization_status_ = kTfLiteError;
+      return;
+    }
+    planned_arena = tensor_allocator_->AllocateMemory(
+        memory_plan->arena_size, kMicroMemoryPlanAlignment);
+    if (planned_arena == nullptr) {
+      error_reporter->Report(
+          "Couldn't allocate the %d bytes of the memory plan.\n",
+          memory_plan->arena_size);
+      initialization_status_ = kTfLiteError;
+      return;
+    }
+  }
+  auto planned_data = [memory_plan,
+                       planned_arena](int tensor_index) -> uint8_t* {
+    if (planned_arena == nullptr ||
+        memory_plan->tensor_offsets[tensor_index] ==
+            kMicroMemoryPlanNotPlanned) {
+      return nullptr;
+    }
+    return planned_arena + memory_plan->tensor_offsets[tensor_index];
+  };
+
   for (int i = 0; i < subgraph_->inputs()->Length(); ++i) {
     const int tensor_index = subgraph_->inputs()->Get(i);
     const auto* tensor = tensors_->Get(tensor_index);
     initialization_status_ = tensor_allocator_->AllocateTensor(
         *tensor, 0, operators_->Length(), buffers, error_reporter,
-        &context_.tensors[tensor_index]);
+        &context_.tensors[tensor_index], planned_data(tensor_index));
     if (initialization_status_ != kTfLiteOk) {
       return;
     }
@@ -122,7 +155,7 @@ MicroInterpreter::MicroInterpreter(const Model* model,
       if (!tensor->is_variable()) {
         initialization_status_ = tensor_allocator_->AllocateTensor(
             *tensor, create_before, destroy_after, buffers, error_reporter,
-            &context_.tensors[tensor_index]);
+            &context_.tensors[tensor_index], planned_data(tensor_index));
         if (initialization_status_ != kTfLiteOk) {
           return;
         }
@@ -137,7 +170,7 @@ MicroInterpreter::MicroInterpreter(const Model* model,
     if (tensor->is_variable() || is_read_only) {
       initialization_status_ = tensor_allocator_->AllocateTensor(
           *tensor, 0, operators_->Length(), buffers, error_reporter,
-          &context_.tensors[i]);
+          &context_.tensors[i], planned_data(i));
       if (initialization_status_ != kTfLiteOk) {
         return;
       }
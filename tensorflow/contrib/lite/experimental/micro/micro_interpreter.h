@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/contrib/lite/c/c_api_internal.h"
 #include "tensorflow/contrib/lite/core/api/error_reporter.h"
 #include "tensorflow/contrib/lite/core/api/op_resolver.h"
+#include "tensorflow/contrib/lite/experimental/micro/micro_memory_plan.h"
 #include "tensorflow/contrib/lite/experimental/micro/simple_tensor_allocator.h"
 #include "tensorflow/contrib/lite/schema/schema_generated.h"
 
@@ -33,9 +34,14 @@ class MicroInterpreter {
   // function.
   // The interpreter doesn't do any deallocation of any of the pointed-to
   // objects, ownership remains with the caller.
+  //
+  // If `memory_plan` is given, the tensors it places share a block of
+  // memory_plan->arena_size bytes from the allocator, at the offsets of the
+  // plan, instead of each getting its own memory.
   MicroInterpreter(const Model* model, const OpResolver& op_resolver,
                    SimpleTensorAllocator* tensor_allocator,
-                   ErrorReporter* error_reporter);
+                   ErrorReporter* error_reporter,
+                   const MicroMemoryPlan* memory_plan = nullptr);
 
   TfLiteStatus Invoke();
 
@@ -155,13 +155,19 @@ const Model* BuildMockModel() {
   return model;
 }
 
+// The stack allocator only has room for one model, so tests share it.
+const Model* GetMockModel() {
+  static const Model* model = BuildMockModel();
+  return model;
+}
+
 }  // namespace
 }  // namespace tflite
 
 TF_LITE_MICRO_TESTS_BEGIN
 
 TF_LITE_MICRO_TEST(TestInterpreter) {
-  const tflite::Model* model = tflite::BuildMockModel();
+  const tflite::Model* model = tflite::GetMockModel();
   TF_LITE_MICRO_EXPECT_NE(nullptr, model);
   tflite::MockOpResolver mock_resolver;
   constexpr size_t allocator_buffer_size = 1024;
@@ -194,4 +200,50 @@ TF_LITE_MICRO_TEST(TestInterpreter) {
   TF_LITE_MICRO_EXPECT_EQ(42, output->data.i32[0]);
 }
 
+TF_LITE_MICRO_TEST(TestInterpreterWithMemoryPlan) {
+  const tflite::Model* model = tflite::GetMockModel();
+  TF_LITE_MICRO_EXPECT_NE(nullptr, model);
+  tflite::MockOpResolver mock_resolver;
+  constexpr size_t allocator_buffer_size = 1024;
+  uint8_t allocator_buffer[allocator_buffer_size];
+  tflite::SimpleTensorAllocator simple_tensor_allocator(allocator_buffer,
+                                                        allocator_buffer_size);
+  // The weights are constant, so only the input and output are planned.
+  constexpr int32_t tensor_offsets[] = {0, tflite::kMicroMemoryPlanNotPlanned,
+                                        16};
+  const tflite::MicroMemoryPlan memory_plan = {32, 3, tensor_offsets};
+  tflite::MicroInterpreter interpreter(model, mock_resolver,
+                                       &simple_tensor_allocator,
+                                       micro_test::reporter, &memory_plan);
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.initialization_status());
+
+  TfLiteTensor* input = interpreter.input(0);
+  TfLiteTensor* output = interpreter.output(0);
+  TF_LITE_MICRO_EXPECT_NE(nullptr, input);
+  TF_LITE_MICRO_EXPECT_NE(nullptr, output);
+  TF_LITE_MICRO_EXPECT_EQ(0, reinterpret_cast<size_t>(input->data.raw) %
+                                 tflite::kMicroMemoryPlanAlignment);
+  TF_LITE_MICRO_EXPECT_EQ(16, output->data.raw - input->data.raw);
+  input->data.i32[0] = 21;
+
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+  TF_LITE_MICRO_EXPECT_EQ(42, output->data.i32[0]);
+}
+
+TF_LITE_MICRO_TEST(TestInterpreterWithMismatchedMemoryPlan) {
+  const tflite::Model* model = tflite::GetMockModel();
+  TF_LITE_MICRO_EXPECT_NE(nullptr, model);
+  tflite::MockOpResolver mock_resolver;
+  constexpr size_t allocator_buffer_size = 1024;
+  uint8_t allocator_buffer[allocator_buffer_size];
+  tflite::SimpleTensorAllocator simple_tensor_allocator(allocator_buffer,
+                                                        allocator_buffer_size);
+  constexpr int32_t tensor_offsets[] = {0, 16};
+  const tflite::MicroMemoryPlan memory_plan = {32, 2, tensor_offsets};
+  tflite::MicroInterpreter interpreter(model, mock_resolver,
+                                       &simple_tensor_allocator,
+                                       micro_test::reporter, &memory_plan);
+  TF_LITE_MICRO_EXPECT_NE(kTfLiteOk, interpreter.initialization_status());
+}
+
 TF_LITE_MICRO_TESTS_END
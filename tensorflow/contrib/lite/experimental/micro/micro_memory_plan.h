@@ -0,0 +1,45 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CONTRIB_LITE_EXPERIMENTAL_MICRO_MICRO_MEMORY_PLAN_H_
+#define TENSORFLOW_CONTRIB_LITE_EXPERIMENTAL_MICRO_MICRO_MEMORY_PLAN_H_
+
+#include <stdint.h>
+
+namespace tflite {
+
+// Offsets in the arena must be multiples of this, relative to a start that
+// is aligned to it, so that every tensor type is aligned.
+constexpr int kMicroMemoryPlanAlignment = 16;
+
+// The offset of tensors that aren't in the planned arena, like constants.
+constexpr int32_t kMicroMemoryPlanNotPlanned = -1;
+
+// The layout of the tensors of a model in the arena, usually computed offline
+// by the generate_micro_model tool so the device doesn't plan at startup.
+// Tensors that are never live at the same time share memory.
+struct MicroMemoryPlan {
+  // Bytes of the planned part of the arena.
+  int arena_size;
+  // The number of tensors of the model's subgraph.
+  int tensors_size;
+  // The offset of each tensor in the planned part of the arena, or
+  // kMicroMemoryPlanNotPlanned.
+  const int32_t* tensor_offsets;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_CONTRIB_LITE_EXPERIMENTAL_MICRO_MICRO_MEMORY_PLAN_H_
@@ -0,0 +1,52 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/lite/experimental/micro/micro_static_op_resolver.h"
+
+namespace tflite {
+
+const TfLiteRegistration* MicroStaticOpResolver::FindOp(
+    tflite::BuiltinOperator op, int version) const {
+  for (int i = 0; i < registrations_len_; ++i) {
+    const MicroOpRegistration& entry = registrations_[i];
+    if ((entry.custom_name == nullptr) && (entry.op == op) &&
+        (entry.min_version <= version) && (version <= entry.max_version)) {
+      TfLiteRegistration* registration = entry.registration();
+      registration->builtin_code = op;
+      registration->version = version;
+      return registration;
+    }
+  }
+  return nullptr;
+}
+
+const TfLiteRegistration* MicroStaticOpResolver::FindOp(const char* op,
+                                                        int version) const {
+  for (int i = 0; i < registrations_len_; ++i) {
+    const MicroOpRegistration& entry = registrations_[i];
+    if ((entry.custom_name != nullptr) &&
+        (strcmp(entry.custom_name, op) == 0) &&
+        (entry.min_version <= version) && (version <= entry.max_version)) {
+      TfLiteRegistration* registration = entry.registration();
+      registration->builtin_code = -1;
+      registration->custom_name = entry.custom_name;
+      registration->version = version;
+      return registration;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace tflite
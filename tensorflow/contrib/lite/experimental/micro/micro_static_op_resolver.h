@@ -0,0 +1,64 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CONTRIB_LITE_EXPERIMENTAL_MICRO_MICRO_STATIC_OP_RESOLVER_H_
+#define TENSORFLOW_CONTRIB_LITE_EXPERIMENTAL_MICRO_MICRO_STATIC_OP_RESOLVER_H_
+
+#include "tensorflow/contrib/lite/core/api/op_resolver.h"
+#include "tensorflow/contrib/lite/experimental/micro/compatibility.h"
+
+namespace tflite {
+
+// An entry of the op table of a MicroStaticOpResolver.
+struct MicroOpRegistration {
+  tflite::BuiltinOperator op;
+  // The name of a custom op, or nullptr for a builtin op.
+  const char* custom_name;
+  int min_version;
+  int max_version;
+  TfLiteRegistration* (*registration)();
+};
+
+// An op resolver over a fixed table of ops, usually generated for a model by
+// the generate_micro_model tool so that only the model's kernels are linked
+// in. Unlike MicroMutableOpResolver, the table can be a constexpr array in
+// flash, and nothing is copied into RAM at startup:
+//
+//   constexpr MicroOpRegistration kOps[] = {
+//       {BuiltinOperator_SOFTMAX, nullptr, 1, 1, Register_SOFTMAX},
+//   };
+//   MicroStaticOpResolver resolver(kOps);
+//
+// FindOp() sets the op and version of the registration it returns, as
+// MicroMutableOpResolver does on its copies.
+class MicroStaticOpResolver : public OpResolver {
+ public:
+  template <int N>
+  explicit MicroStaticOpResolver(const MicroOpRegistration (&registrations)[N])
+      : registrations_(registrations), registrations_len_(N) {}
+
+  const TfLiteRegistration* FindOp(tflite::BuiltinOperator op,
+                                   int version) const override;
+  const TfLiteRegistration* FindOp(const char* op, int version) const override;
+
+ private:
+  const MicroOpRegistration* registrations_;
+  int registrations_len_;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_CONTRIB_LITE_EXPERIMENTAL_MICRO_MICRO_STATIC_OP_RESOLVER_H_
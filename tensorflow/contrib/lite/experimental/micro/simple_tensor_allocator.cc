@@ -78,7 +78,8 @@ TfLiteStatus SimpleTensorAllocator::AllocateTensor(
     const tflite::Tensor& flatbuffer_tensor, int create_before,
     int destroy_after,
     const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
-    ErrorReporter* error_reporter, TfLiteTensor* result) {
+    ErrorReporter* error_reporter, TfLiteTensor* result,
+    uint8_t* planned_data) {
   TF_LITE_ENSURE_STATUS(ConvertTensorType(flatbuffer_tensor.type(),
                                           &result->type, error_reporter));
   result->is_variable = flatbuffer_tensor.is_variable();
@@ -108,8 +109,12 @@ TfLiteStatus SimpleTensorAllocator::AllocateTensor(
     TF_LITE_ENSURE_STATUS(BytesRequired(flatbuffer_tensor, data_size,
                                         &result->bytes, &type_size,
                                         error_reporter));
-    result->data.raw =
-        reinterpret_cast<char*>(AllocateMemory(result->bytes, type_size));
+    if (planned_data) {
+      result->data.raw = reinterpret_cast<char*>(planned_data);
+    } else {
+      result->data.raw =
+          reinterpret_cast<char*>(AllocateMemory(result->bytes, type_size));
+    }
     if (result->data.raw == nullptr) {
       const char* tensor_name = flatbuffer_tensor.name()->c_str();
       if (tensor_name == nullptr) {
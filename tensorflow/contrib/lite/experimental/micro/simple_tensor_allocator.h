@@ -22,9 +22,10 @@ limitations under the License.
 
 namespace tflite {
 
-// TODO(petewarden): This allocator never frees up or reuses  any memory, even
-// though we have enough information about lifetimes of the tensors to do so.
-// This makes it pretty wasteful, so we should use a more intelligent method.
+// This allocator never frees up or reuses any memory by itself. Tensors only
+// share memory when the interpreter is given a MicroMemoryPlan, which places
+// them in the arena according to their lifetimes, and passes their place in
+// the arena to AllocateTensor().
 class SimpleTensorAllocator {
  public:
   SimpleTensorAllocator(uint8_t* buffer, int buffer_size)
@@ -34,7 +35,8 @@ class SimpleTensorAllocator {
       const tflite::Tensor& flatbuffer_tensor, int create_before,
       int destroy_after,
       const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
-      ErrorReporter* error_reporter, TfLiteTensor* result);
+      ErrorReporter* error_reporter, TfLiteTensor* result,
+      uint8_t* planned_data = nullptr);
 
   uint8_t* AllocateMemory(size_t size, size_t alignment);
 
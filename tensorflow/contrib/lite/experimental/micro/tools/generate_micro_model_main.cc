@@ -0,0 +1,72 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Generates the op table and memory plan of a model for the micro runtime:
+//
+//   generate_micro_model --input_model=tiny_conv.tflite --name=tiny_conv \
+//       --output_header=tiny_conv_micro_model.h
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tensorflow/contrib/lite/experimental/micro/tools/micro_model_codegen.h"
+#include "tensorflow/contrib/lite/stderr_reporter.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+using tensorflow::Flag;
+using tensorflow::Flags;
+using tensorflow::string;
+
+int main(int argc, char** argv) {
+  string input_model;
+  string output_header;
+  string name = "model";
+  std::vector<Flag> flag_list = {
+      Flag("input_model", &input_model, "path to the tflite model"),
+      Flag("output_header", &output_header,
+           "filename for the generated header"),
+      Flag("name", &name, "name of the model in the generated symbols"),
+  };
+  const bool parsed = Flags::Parse(&argc, argv, flag_list);
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  if (!parsed || input_model.empty() || output_header.empty()) {
+    fprintf(stderr, "%s", Flags::Usage(argv[0], flag_list).c_str());
+    return 1;
+  }
+
+  std::ifstream fin(input_model, std::ios::binary);
+  std::stringstream content;
+  content << fin.rdbuf();
+  // Need to store content data first, otherwise, it won't work in bazel.
+  const string content_str = content.str();
+  const ::tflite::Model* model = ::tflite::GetModel(content_str.data());
+  if (content_str.empty() || model == nullptr) {
+    fprintf(stderr, "Couldn't read the model %s\n", input_model.c_str());
+    return 1;
+  }
+
+  string header;
+  if (::tflite::GenerateMicroModelHeader(model, name,
+                                         ::tflite::DefaultErrorReporter(),
+                                         &header) != kTfLiteOk) {
+    return 1;
+  }
+  std::ofstream fout(output_header);
+  fout << header;
+  return fout.good() ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/lite/experimental/micro/tools/micro_model_codegen.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <utility>
+
+#include "tensorflow/contrib/lite/experimental/micro/micro_memory_plan.h"
+#include "tensorflow/contrib/lite/tools/gen_op_registration.h"
+
+namespace tflite {
+namespace {
+
+TfLiteStatus TensorTypeSize(TensorType type, int* size,
+                            ErrorReporter* reporter) {
+  switch (type) {
+    case TensorType_FLOAT32:
+    case TensorType_INT32:
+      *size = 4;
+      break;
+    case TensorType_INT16:
+      *size = 2;
+      break;
+    case TensorType_UINT8:
+    case TensorType_BOOL:
+      *size = 1;
+      break;
+    case TensorType_INT64:
+    case TensorType_COMPLEX64:
+      *size = 8;
+      break;
+    default:
+      reporter->Report("Type %s is not supported by the micro runtime.",
+                       EnumNameTensorType(type));
+      return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+bool HasConstantData(const Model* model, const Tensor& tensor) {
+  const Buffer* buffer = model->buffers()->Get(tensor.buffer());
+  return buffer && buffer->data() && buffer->data()->size() > 0;
+}
+
+// A tensor to place in the arena, used by operators first to last inclusive.
+struct PlannedTensor {
+  int index;
+  int bytes;
+  int first;
+  int last;
+};
+
+int AlignUp(int value) {
+  return (value + kMicroMemoryPlanAlignment - 1) / kMicroMemoryPlanAlignment *
+         kMicroMemoryPlanAlignment;
+}
+
+}  // namespace
+
+TfLiteStatus PlanMicroMemory(const Model* model, ErrorReporter* reporter,
+                             std::vector<int32_t>* tensor_offsets,
+                             int* arena_size) {
+  if (model->subgraphs()->size() != 1) {
+    reporter->Report("Only 1 subgraph is currently supported.");
+    return kTfLiteError;
+  }
+  const SubGraph* subgraph = model->subgraphs()->Get(0);
+  const auto* tensors = subgraph->tensors();
+  const auto* operators = subgraph->operators();
+  const int num_tensors = tensors->size();
+  const int last_operator = static_cast<int>(operators->size()) - 1;
+
+  // Compute the lifetimes like the MicroInterpreter's constructor does.
+  std::vector<int> first(num_tensors, -1);
+  std::vector<int> last(num_tensors, -1);
+  for (int i = 0; i <= last_operator; ++i) {
+    const Operator* op = operators->Get(i);
+    for (int tensor_index : *op->inputs()) {
+      if (tensor_index >= 0) last[tensor_index] = i;
+    }
+    for (int tensor_index : *op->outputs()) {
+      if (first[tensor_index] == -1) first[tensor_index] = i;
+    }
+  }
+  // Outputs are read after the run, so they live until its end.
+  for (int tensor_index : *subgraph->outputs()) {
+    last[tensor_index] = last_operator + 1;
+  }
+  std::vector<bool> whole_run(num_tensors, false);
+  for (int tensor_index : *subgraph->inputs()) whole_run[tensor_index] = true;
+
+  std::vector<PlannedTensor> planned;
+  tensor_offsets->assign(num_tensors, kMicroMemoryPlanNotPlanned);
+  for (int i = 0; i < num_tensors; ++i) {
+    const Tensor* tensor = tensors->Get(i);
+    if (HasConstantData(model, *tensor)) continue;
+    const bool read_only =
+        (first[i] == -1) && (last[i] != -1) && (last[i] <= last_operator);
+    if (tensor->is_variable() || read_only) whole_run[i] = true;
+    if (!whole_run[i] && first[i] == -1) continue;
+
+    int bytes;
+    TF_LITE_ENSURE_STATUS(TensorTypeSize(tensor->type(), &bytes, reporter));
+    if (tensor->shape()) {
+      for (int dim : *tensor->shape()) bytes *= dim;
+    }
+    PlannedTensor planned_tensor = {i, bytes, first[i], last[i]};
+    if (whole_run[i]) {
+      planned_tensor.first = 0;
+      planned_tensor.last = last_operator + 1;
+    } else if (planned_tensor.last < planned_tensor.first) {
+      // An output nobody reads still has to be written.
+      planned_tensor.last = last_operator + 1;
+    }
+    planned.push_back(planned_tensor);
+  }
+
+  std::stable_sort(planned.begin(), planned.end(),
+                   [](const PlannedTensor& a, const PlannedTensor& b) {
+                     return a.bytes > b.bytes;
+                   });
+  *arena_size = 0;
+  for (int i = 0; i < planned.size(); ++i) {
+    const PlannedTensor& tensor = planned[i];
+    // The ranges of the arena used by placed tensors live at the same time.
+    std::vector<std::pair<int, int>> used;
+    for (int j = 0; j < i; ++j) {
+      const PlannedTensor& other = planned[j];
+      if (other.first <= tensor.last && tensor.first <= other.last) {
+        const int offset = (*tensor_offsets)[other.index];
+        used.emplace_back(offset, offset + other.bytes);
+      }
+    }
+    std::sort(used.begin(), used.end());
+    int offset = 0;
+    for (const auto& range : used) {
+      if (offset + tensor.bytes <= range.first) break;
+      offset = std::max(offset, AlignUp(range.second));
+    }
+    (*tensor_offsets)[tensor.index] = offset;
+    *arena_size = std::max(*arena_size, offset + tensor.bytes);
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus GenerateMicroModelHeader(const Model* model, const string& name,
+                                      ErrorReporter* reporter,
+                                      string* header) {
+  std::vector<int32_t> tensor_offsets;
+  int arena_size;
+  TF_LITE_ENSURE_STATUS(
+      PlanMicroMemory(model, reporter, &tensor_offsets, &arena_size));
+
+  // The versions of each kernel used by the model, keyed by the name of its
+  // registration function.
+  std::map<string, std::pair<int, int>> versions;
+  std::map<string, string> table_entries;
+  for (const OperatorCode* opcode : *model->operator_codes()) {
+    const int version = opcode->version();
+    string kernel;
+    string entry;
+    if (opcode->builtin_code() == BuiltinOperator_CUSTOM) {
+      const string custom_name = opcode->custom_code()->str();
+      kernel = NormalizeCustomOpName(custom_name);
+      entry = "tflite::BuiltinOperator_CUSTOM, \"" + custom_name + "\"";
+    } else {
+      kernel = EnumNameBuiltinOperator(opcode->builtin_code());
+      entry = "tflite::BuiltinOperator_" + kernel + ", nullptr";
+    }
+    auto inserted = versions.emplace(kernel, std::make_pair(version, version));
+    auto& range = inserted.first->second;
+    range.first = std::min(range.first, version);
+    range.second = std::max(range.second, version);
+    table_entries[kernel] = entry;
+  }
+  if (versions.empty()) {
+    reporter->Report("The model has no operators.");
+    return kTfLiteError;
+  }
+
+  string guard = name + "_MICRO_MODEL_H_";
+  std::transform(guard.begin(), guard.end(), guard.begin(), ::toupper);
+  std::ostringstream out;
+  out << "// Generated by generate_micro_model, do not edit.\n"
+      << "#ifndef " << guard << "\n#define " << guard << "\n\n"
+      << "#include \"tensorflow/contrib/lite/experimental/micro/"
+         "micro_memory_plan.h\"\n"
+      << "#include \"tensorflow/contrib/lite/experimental/micro/"
+         "micro_static_op_resolver.h\"\n\n"
+      << "namespace tflite {\nnamespace ops {\nnamespace micro {\n";
+  for (const auto& kernel : versions) {
+    out << "TfLiteRegistration* Register_" << kernel.first << "();\n";
+  }
+  out << "}  // namespace micro\n}  // namespace ops\n"
+      << "}  // namespace tflite\n\n";
+
+  out << "constexpr tflite::MicroOpRegistration g_" << name << "_ops[] = {\n";
+  for (const auto& kernel : versions) {
+    out << "    {" << table_entries[kernel.first] << ", "
+        << kernel.second.first << ", " << kernel.second.second
+        << ", tflite::ops::micro::Register_" << kernel.first << "},\n";
+  }
+  out << "};\n\n";
+
+  out << "constexpr int32_t g_" << name << "_tensor_offsets[] = {";
+  for (int i = 0; i < tensor_offsets.size(); ++i) {
+    out << (i % 8 == 0 ? "\n    " : " ") << tensor_offsets[i] << ",";
+  }
+  out << "\n};\n\n";
+
+  out << "constexpr tflite::MicroMemoryPlan g_" << name << "_memory_plan = {\n"
+      << "    " << arena_size << ", " << tensor_offsets.size() << ", g_"
+      << name << "_tensor_offsets};\n\n"
+      << "#endif  // " << guard << "\n";
+  *header = out.str();
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
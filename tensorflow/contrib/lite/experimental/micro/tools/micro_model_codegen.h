@@ -0,0 +1,56 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CONTRIB_LITE_EXPERIMENTAL_MICRO_TOOLS_MICRO_MODEL_CODEGEN_H_
+#define TENSORFLOW_CONTRIB_LITE_EXPERIMENTAL_MICRO_TOOLS_MICRO_MODEL_CODEGEN_H_
+
+#include <vector>
+
+#include "tensorflow/contrib/lite/core/api/error_reporter.h"
+#include "tensorflow/contrib/lite/schema/schema_generated.h"
+#include "tensorflow/contrib/lite/string.h"
+
+namespace tflite {
+
+// Plans the layout in the arena of the tensors that the MicroInterpreter
+// allocates for the subgraph of `model`, so that tensors which are never live
+// at the same time share memory. Lifetimes follow the interpreter's: inputs,
+// variables and other tensors that no operator produces live for the whole
+// run, and an operator's output lives from that operator to its last reader,
+// or to the end of the run for the outputs of the subgraph. Tensors are placed greedily, largest first, at the lowest offset
+// that doesn't overlap a tensor with an overlapping lifetime.
+//
+// On success, `tensor_offsets` holds the offset of each tensor of the
+// subgraph, or kMicroMemoryPlanNotPlanned for tensors with constant data
+// and unused tensors, and `arena_size` the bytes the planned tensors span.
+TfLiteStatus PlanMicroMemory(const Model* model, ErrorReporter* reporter,
+                             std::vector<int32_t>* tensor_offsets,
+                             int* arena_size);
+
+// Generates a header for the micro runtime with the constexpr op table and
+// memory plan of `model`, named g_<name>_ops and g_<name>_memory_plan:
+//
+//   tflite::MicroStaticOpResolver resolver(g_<name>_ops);
+//   tflite::MicroInterpreter interpreter(model, resolver, &allocator,
+//                                        reporter, &g_<name>_memory_plan);
+//
+// Kernels are referenced as tflite::ops::micro::Register_<OP>(), with custom
+// op names normalized as by NormalizeCustomOpName().
+TfLiteStatus GenerateMicroModelHeader(const Model* model, const string& name,
+                                      ErrorReporter* reporter,
+                                      string* header);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_CONTRIB_LITE_EXPERIMENTAL_MICRO_TOOLS_MICRO_MODEL_CODEGEN_H_
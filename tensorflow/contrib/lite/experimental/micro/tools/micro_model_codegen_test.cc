@@ -0,0 +1,124 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/lite/experimental/micro/tools/micro_model_codegen.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/contrib/lite/experimental/micro/micro_memory_plan.h"
+#include "tensorflow/contrib/lite/stderr_reporter.h"
+#include "tensorflow/contrib/lite/version.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::HasSubstr;
+
+// Builds a model computing
+//   hidden1 = FULLY_CONNECTED(input, weights)      (version 1)
+//   hidden2 = FULLY_CONNECTED(hidden1, weights)    (version 2)
+//   output = SOFTMAX(hidden2)
+// with 100 floats in each of input, hidden1, hidden2 and output, and an
+// unused tensor.
+class MicroModelCodegenTest : public ::testing::Test {
+ protected:
+  enum { kInput, kWeights, kHidden1, kHidden2, kOutput, kUnused };
+
+  MicroModelCodegenTest() {
+    using flatbuffers::Offset;
+    const std::vector<uint8_t> weights_data(sizeof(float), 0);
+    const std::vector<Offset<Buffer>> buffers = {
+        CreateBuffer(builder_), CreateBufferDirect(builder_, &weights_data)};
+
+    const std::vector<int32_t> shape = {100};
+    const std::vector<int32_t> weights_shape = {1};
+    const std::vector<int32_t> unused_shape = {50};
+    auto tensor = [this](const std::vector<int32_t>& dims, int buffer,
+                         const char* name) {
+      return CreateTensorDirect(builder_, &dims, TensorType_FLOAT32, buffer,
+                                name);
+    };
+    const std::vector<Offset<Tensor>> tensors = {
+        tensor(shape, 0, "input"),   tensor(weights_shape, 1, "weights"),
+        tensor(shape, 0, "hidden1"), tensor(shape, 0, "hidden2"),
+        tensor(shape, 0, "output"),  tensor(unused_shape, 0, "unused")};
+
+    auto op = [this](int opcode_index, const std::vector<int32_t>& inputs,
+                     int32_t output) {
+      const std::vector<int32_t> outputs = {output};
+      return CreateOperatorDirect(builder_, opcode_index, &inputs, &outputs);
+    };
+    const std::vector<Offset<Operator>> operators = {
+        op(0, {kInput, kWeights}, kHidden1),
+        op(1, {kHidden1, kWeights}, kHidden2), op(2, {kHidden2}, kOutput)};
+
+    const std::vector<int32_t> inputs = {kInput};
+    const std::vector<int32_t> outputs = {kOutput};
+    const std::vector<Offset<SubGraph>> subgraphs = {CreateSubGraphDirect(
+        builder_, &tensors, &inputs, &outputs, &operators, "subgraph")};
+    const std::vector<Offset<OperatorCode>> opcodes = {
+        CreateOperatorCode(builder_, BuiltinOperator_FULLY_CONNECTED, 0, 1),
+        CreateOperatorCode(builder_, BuiltinOperator_FULLY_CONNECTED, 0, 2),
+        CreateOperatorCode(builder_, BuiltinOperator_SOFTMAX, 0, 1)};
+    FinishModelBuffer(
+        builder_, CreateModelDirect(builder_, TFLITE_SCHEMA_VERSION, &opcodes,
+                                    &subgraphs, "model", &buffers));
+    model_ = GetModel(builder_.GetBufferPointer());
+  }
+
+  flatbuffers::FlatBufferBuilder builder_;
+  const Model* model_;
+};
+
+TEST_F(MicroModelCodegenTest, PlanSharesMemoryOfDisjointLifetimes) {
+  std::vector<int32_t> offsets;
+  int arena_size;
+  ASSERT_EQ(kTfLiteOk, PlanMicroMemory(model_, DefaultErrorReporter(),
+                                       &offsets, &arena_size));
+  ASSERT_EQ(6, offsets.size());
+
+  // The input lives for the whole run, and hidden1 and hidden2 are live
+  // together in the second operator, but the output reuses hidden1.
+  EXPECT_EQ(kMicroMemoryPlanNotPlanned, offsets[kWeights]);
+  EXPECT_EQ(kMicroMemoryPlanNotPlanned, offsets[kUnused]);
+  EXPECT_EQ(offsets[kHidden1], offsets[kOutput]);
+  EXPECT_NE(offsets[kInput], offsets[kHidden1]);
+  EXPECT_NE(offsets[kInput], offsets[kHidden2]);
+  EXPECT_NE(offsets[kHidden1], offsets[kHidden2]);
+  for (int offset : offsets) {
+    EXPECT_EQ(0, offset % kMicroMemoryPlanAlignment);
+  }
+  EXPECT_EQ(3 * 100 * sizeof(float), arena_size);
+}
+
+TEST_F(MicroModelCodegenTest, HeaderHasOpTableAndMemoryPlan) {
+  string header;
+  ASSERT_EQ(kTfLiteOk, GenerateMicroModelHeader(
+                           model_, "test", DefaultErrorReporter(), &header));
+  EXPECT_THAT(header, HasSubstr("TfLiteRegistration* Register_SOFTMAX();"));
+  EXPECT_THAT(header,
+              HasSubstr("constexpr tflite::MicroOpRegistration g_test_ops[]"));
+  EXPECT_THAT(header,
+              HasSubstr("{tflite::BuiltinOperator_FULLY_CONNECTED, nullptr, "
+                        "1, 2, tflite::ops::micro::Register_FULLY_CONNECTED}"));
+  EXPECT_THAT(header, HasSubstr("{tflite::BuiltinOperator_SOFTMAX, nullptr, "
+                                "1, 1, tflite::ops::micro::Register_SOFTMAX}"));
+  EXPECT_THAT(header,
+              HasSubstr("constexpr tflite::MicroMemoryPlan g_test_memory_plan"
+                        " = {\n    1200, 6, g_test_tensor_offsets};"));
+}
+
+}  // namespace
+}  // namespace tflite
@@ -0,0 +1,87 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/lite/inter_op_thread_pool.h"
+
+namespace tflite {
+
+InterOpThreadPool::InterOpThreadPool(int num_threads) {
+  for (int i = 1; i < num_threads; ++i) {
+    workers_.emplace_back(&InterOpThreadPool::WorkerLoop, this);
+  }
+}
+
+InterOpThreadPool::~InterOpThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutting_down_ = true;
+  }
+  work_available_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void InterOpThreadPool::Run(int num_tasks,
+                            const std::function<void(int)>& task) {
+  // Don't wake up the workers for work the calling thread can do alone.
+  if (num_tasks <= 1 || workers_.empty()) {
+    for (int i = 0; i < num_tasks; ++i) {
+      task(i);
+    }
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  task_ = &task;
+  num_tasks_ = num_tasks;
+  next_task_ = 0;
+  num_pending_ = num_tasks;
+  work_available_.notify_all();
+
+  while (next_task_ < num_tasks_) {
+    const int index = next_task_++;
+    lock.unlock();
+    task(index);
+    lock.lock();
+    --num_pending_;
+  }
+  work_done_.wait(lock, [this] { return num_pending_ == 0; });
+
+  task_ = nullptr;
+  num_tasks_ = 0;
+  next_task_ = 0;
+}
+
+void InterOpThreadPool::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_available_.wait(lock, [this] {
+      return shutting_down_ || next_task_ < num_tasks_;
+    });
+    if (shutting_down_) return;
+
+    const std::function<void(int)>* task = task_;
+    const int index = next_task_++;
+    lock.unlock();
+    (*task)(index);
+    lock.lock();
+    if (--num_pending_ == 0) {
+      work_done_.notify_all();
+    }
+  }
+}
+
+}  // namespace tflite
@@ -0,0 +1,65 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CONTRIB_LITE_INTER_OP_THREAD_POOL_H_
+#define TENSORFLOW_CONTRIB_LITE_INTER_OP_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tflite {
+
+// A fork-join pool used by the interpreter to run independent nodes of the
+// graph concurrently. The thread calling Run() takes part in the work, so a
+// pool of `num_threads` owns `num_threads - 1` worker threads.
+//
+// Run() must not be called concurrently or from inside a task.
+class InterOpThreadPool {
+ public:
+  explicit InterOpThreadPool(int num_threads);
+  ~InterOpThreadPool();
+  InterOpThreadPool(const InterOpThreadPool&) = delete;
+  InterOpThreadPool& operator=(const InterOpThreadPool&) = delete;
+
+  int num_threads() const { return static_cast<int>(workers_.size()) + 1; }
+
+  // Calls `task(i)` for every i in [0, num_tasks) and returns once all the
+  // calls have finished.
+  void Run(int num_tasks, const std::function<void(int)>& task);
+
+ private:
+  void WorkerLoop();
+
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  // Signaled when tasks are published or the pool is shutting down.
+  std::condition_variable work_available_;
+  // Signaled when the last task of a Run() call finishes.
+  std::condition_variable work_done_;
+
+  // The tasks of the current Run() call, all guarded by `mutex_`.
+  const std::function<void(int)>* task_ = nullptr;
+  int num_tasks_ = 0;
+  int next_task_ = 0;
+  int num_pending_ = 0;
+  bool shutting_down_ = false;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_CONTRIB_LITE_INTER_OP_THREAD_POOL_H_
@@ -0,0 +1,77 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/inter_op_thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/contrib/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+TEST(InterOpThreadPoolTest, RunsEveryTaskOnce) {
+  InterOpThreadPool pool(4);
+  EXPECT_EQ(pool.num_threads(), 4);
+  for (int num_tasks : {0, 1, 3, 4, 17}) {
+    std::vector<std::atomic<int>> calls(num_tasks);
+    for (auto& count : calls) count = 0;
+    pool.Run(num_tasks, [&calls](int i) { ++calls[i]; });
+    for (int i = 0; i < num_tasks; ++i) {
+      EXPECT_EQ(calls[i].load(), 1) << "task " << i << " of " << num_tasks;
+    }
+  }
+}
+
+TEST(InterOpThreadPoolTest, SingleThreadRunsInline) {
+  InterOpThreadPool pool(1);
+  EXPECT_EQ(pool.num_threads(), 1);
+  const std::thread::id caller = std::this_thread::get_id();
+  std::vector<int> order;
+  pool.Run(3, [&order, caller](int i) {
+    EXPECT_EQ(std::this_thread::get_id(), caller);
+    order.push_back(i);
+  });
+  EXPECT_THAT(order, ::testing::ElementsAre(0, 1, 2));
+}
+
+TEST(InterOpThreadPoolTest, TasksRunConcurrently) {
+  InterOpThreadPool pool(2);
+  // Each task waits for the other one to start, which only succeeds if they
+  // run at the same time.
+  std::atomic<int> started(0);
+  std::atomic<int> met(0);
+  pool.Run(2, [&started, &met](int) {
+    ++started;
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (started < 2 && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+    if (started == 2) ++met;
+  });
+  EXPECT_EQ(met.load(), 2);
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
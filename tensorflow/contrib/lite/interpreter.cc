@@ -15,19 +15,25 @@ limitations under the License.
 
 #include "tensorflow/contrib/lite/interpreter.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdarg>
 #include <cstdint>
 #include <cstring>
+#include <map>
+#include <string>
 
 #include "tensorflow/contrib/lite/arena_planner.h"
+#include "tensorflow/contrib/lite/best_fit_arena_planner.h"
 #include "tensorflow/contrib/lite/c/c_api_internal.h"
 #include "tensorflow/contrib/lite/context_util.h"
 #include "tensorflow/contrib/lite/core/api/error_reporter.h"
 #include "tensorflow/contrib/lite/graph_info.h"
+#include "tensorflow/contrib/lite/inter_op_thread_pool.h"
 #include "tensorflow/contrib/lite/memory_planner.h"
 #include "tensorflow/contrib/lite/nnapi_delegate.h"
 #include "tensorflow/contrib/lite/profiling/profiler.h"
+#include "tensorflow/contrib/lite/profiling/time.h"
 #include "tensorflow/contrib/lite/schema/schema_generated.h"
 #include "tensorflow/contrib/lite/util.h"
 
@@ -259,6 +265,8 @@ TfLiteStatus Interpreter::ReplaceSubgraphsWithDelegateKernels(
   PartitionGraphIntoIndependentSubgraphs(&info, nodes_to_replace, &subgraphs);
 
   execution_plan_.clear();
+  // The stages no longer match the execution plan; run it in sequence.
+  execution_stages_.clear();
   for (auto& subgraph : subgraphs) {
     // Subgraphs calimed by the delegate should have a "macro" op created, the
     // other subgraphs (kTfNonPartition) just have their nodes added back to
@@ -598,11 +606,124 @@ TfLiteStatus Interpreter::PrepareOpsStartingAt(
   return kTfLiteOk;
 }
 
+void Interpreter::ComputeExecutionStages() {
+  execution_stages_.clear();
+  // The stage that produces each tensor, or -1 for tensors no node produces.
+  std::vector<int> producer_stage(tensors_.size(), -1);
+  int stage = -1;
+  // Whether the last node must run alone in its stage.
+  bool exclusive = true;
+  for (int execution_plan_index = 0;
+       execution_plan_index < execution_plan_.size(); execution_plan_index++) {
+    const TfLiteNode& node =
+        nodes_and_registration_[execution_plan_[execution_plan_index]].first;
+    // Delegate kernels and nodes updating variable tensors in place run alone.
+    bool alone = node.delegate != nullptr;
+    bool joins_stage = !exclusive;
+    for (int i = 0; i < node.inputs->size; ++i) {
+      int tensor_index = node.inputs->data[i];
+      if (tensor_index == kOptionalTensor) continue;
+      if (tensors_[tensor_index].is_variable) alone = true;
+      if (producer_stage[tensor_index] == stage) joins_stage = false;
+    }
+    if (alone || !joins_stage) {
+      execution_stages_.push_back(execution_plan_index);
+      ++stage;
+    }
+    exclusive = alone;
+    for (int i = 0; i < node.outputs->size; ++i) {
+      producer_stage[node.outputs->data[i]] = stage;
+    }
+  }
+  execution_stages_.push_back(execution_plan_.size());
+}
+
+bool Interpreter::CanInvokeStagesInParallel() const {
+  if (!inter_op_thread_pool_ || profiler_ != nullptr ||
+      execution_stages_.empty() ||
+      execution_stages_.back() != execution_plan_.size() ||
+      next_execution_plan_index_to_prepare_ != execution_plan_.size()) {
+    return false;
+  }
+  // Dynamic tensors are resized and reallocated while ops run, which isn't
+  // safe to do concurrently.
+  for (const TfLiteTensor& tensor : tensors_) {
+    if (tensor.allocation_type == kTfLiteDynamic) return false;
+  }
+  return true;
+}
+
+TfLiteStatus Interpreter::InvokeStagesInParallel() {
+  TfLiteStatus status = kTfLiteOk;
+  std::vector<TfLiteStatus> node_status;
+  for (int stage = 0; stage + 1 < execution_stages_.size(); ++stage) {
+    const int first_index = execution_stages_[stage];
+    const int num_nodes = execution_stages_[stage + 1] - first_index;
+
+    for (int execution_plan_index = first_index;
+         execution_plan_index < first_index + num_nodes;
+         execution_plan_index++) {
+      const TfLiteNode& node =
+          nodes_and_registration_[execution_plan_[execution_plan_index]].first;
+      for (int i = 0; i < node.inputs->size; ++i) {
+        int tensor_index = node.inputs->data[i];
+        if (tensor_index == kOptionalTensor) {
+          continue;
+        }
+        TfLiteTensor* tensor = &tensors_[tensor_index];
+        if (tensor->delegate && tensor->delegate != node.delegate &&
+            tensor->data_is_stale) {
+          EnsureTensorDataIsReadable(tensor_index);
+        }
+      }
+    }
+
+    EnsureTensorsVectorCapacity();
+    node_status.assign(num_nodes, kTfLiteOk);
+    inter_op_thread_pool_->Run(num_nodes, [this, first_index,
+                                           &node_status](int i) {
+      const int node_index = execution_plan_[first_index + i];
+      auto& node_and_registration = nodes_and_registration_[node_index];
+      const uint64_t start_us =
+          op_latency_recorder_ ? profiling::time::NowMicros() : 0;
+      node_status[i] =
+          OpInvoke(node_and_registration.second, &node_and_registration.first);
+      if (op_latency_recorder_) {
+        op_latency_recorder_->Record(node_index,
+                                     profiling::time::NowMicros() - start_us);
+      }
+    });
+
+    for (int i = 0; i < num_nodes; ++i) {
+      if (node_status[i] == kTfLiteOk) continue;
+      int node_index = execution_plan_[first_index + i];
+      auto& node_and_registration = nodes_and_registration_[node_index];
+      status = ReportOpError(&context_, node_and_registration.first,
+                             node_and_registration.second, node_index,
+                             "failed to invoke");
+    }
+  }
+  return status;
+}
+
 TfLiteStatus Interpreter::PrepareOpsAndTensors() {
   if (!memory_planner_) {
-    memory_planner_.reset(new ArenaPlanner(
-        &context_, std::unique_ptr<GraphInfo>(new InterpreterInfo(this)),
-        /*preserve_inputs=*/true, /*preserve_intermediates*/ false));
+    if (inter_op_thread_pool_) {
+      ComputeExecutionStages();
+    }
+    std::unique_ptr<GraphInfo> graph_info(new InterpreterInfo(this));
+    if (use_best_fit_memory_planner_) {
+      BestFitArenaPlanner* planner = new BestFitArenaPlanner(
+          &context_, std::move(graph_info), /*preserve_inputs=*/true);
+      planner->SetExecutionStages(execution_stages_);
+      memory_planner_.reset(planner);
+    } else {
+      ArenaPlanner* planner = new ArenaPlanner(
+          &context_, std::move(graph_info),
+          /*preserve_inputs=*/true, /*preserve_intermediates*/ false);
+      planner->SetExecutionStages(execution_stages_);
+      memory_planner_.reset(planner);
+    }
     memory_planner_->PlanAllocations();
   }
 
@@ -642,6 +763,10 @@ TfLiteStatus Interpreter::Invoke() {
     }
   }
 
+  if (op_latency_recorder_) {
+    op_latency_recorder_->EnsureNodes(nodes_and_registration_.size());
+  }
+
   // Invocations are always done in node order.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
@@ -649,47 +774,58 @@ TfLiteStatus Interpreter::Invoke() {
   // TODO(b/71913981): we should force recalculation in the presence of dynamic
   // tensors, because they may have new value which in turn may affect shapes
   // and allocations.
-  for (int execution_plan_index = 0;
-       execution_plan_index < execution_plan_.size(); execution_plan_index++) {
-    if (execution_plan_index == next_execution_plan_index_to_prepare_) {
-      TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
-      TF_LITE_ENSURE(&context_, next_execution_plan_index_to_prepare_ >=
-                                    execution_plan_index);
-    }
-    int node_index = execution_plan_[execution_plan_index];
-    TfLiteNode& node = nodes_and_registration_[node_index].first;
-    const TfLiteRegistration& registration =
-        nodes_and_registration_[node_index].second;
-    SCOPED_OPERATOR_PROFILE(profiler_, node_index);
-
-    // TODO(ycling): This is an extra loop through inputs to check if the data
-    // need to be copied from Delegate buffer to raw memory, which is often not
-    // needed. We may want to cache this in prepare to know if this needs to be
-    // done for a node or not.
-    for (int i = 0; i < node.inputs->size; ++i) {
-      int tensor_index = node.inputs->data[i];
-      if (tensor_index == kOptionalTensor) {
-        continue;
+  if (CanInvokeStagesInParallel()) {
+    status = InvokeStagesInParallel();
+  } else {
+    for (int execution_plan_index = 0;
+         execution_plan_index < execution_plan_.size();
+         execution_plan_index++) {
+      if (execution_plan_index == next_execution_plan_index_to_prepare_) {
+        TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
+        TF_LITE_ENSURE(&context_, next_execution_plan_index_to_prepare_ >=
+                                      execution_plan_index);
       }
-      TfLiteTensor* tensor = &tensors_[tensor_index];
-      if (tensor->delegate && tensor->delegate != node.delegate &&
-          tensor->data_is_stale) {
-        EnsureTensorDataIsReadable(tensor_index);
+      int node_index = execution_plan_[execution_plan_index];
+      TfLiteNode& node = nodes_and_registration_[node_index].first;
+      const TfLiteRegistration& registration =
+          nodes_and_registration_[node_index].second;
+      SCOPED_OPERATOR_PROFILE(profiler_, node_index);
+
+      // TODO(ycling): This is an extra loop through inputs to check if the
+      // data need to be copied from Delegate buffer to raw memory, which is
+      // often not needed. We may want to cache this in prepare to know if this
+      // needs to be done for a node or not.
+      for (int i = 0; i < node.inputs->size; ++i) {
+        int tensor_index = node.inputs->data[i];
+        if (tensor_index == kOptionalTensor) {
+          continue;
+        }
+        TfLiteTensor* tensor = &tensors_[tensor_index];
+        if (tensor->delegate && tensor->delegate != node.delegate &&
+            tensor->data_is_stale) {
+          EnsureTensorDataIsReadable(tensor_index);
+        }
       }
-    }
 
-    EnsureTensorsVectorCapacity();
-    tensor_resized_since_op_invoke_ = false;
-    if (OpInvoke(registration, &node) == kTfLiteError) {
-      status = ReportOpError(&context_, node, registration, node_index,
-                             "failed to invoke");
-    }
+      EnsureTensorsVectorCapacity();
+      tensor_resized_since_op_invoke_ = false;
+      const uint64_t start_us =
+          op_latency_recorder_ ? profiling::time::NowMicros() : 0;
+      if (OpInvoke(registration, &node) == kTfLiteError) {
+        status = ReportOpError(&context_, node, registration, node_index,
+                               "failed to invoke");
+      }
+      if (op_latency_recorder_) {
+        op_latency_recorder_->Record(node_index,
+                                     profiling::time::NowMicros() - start_us);
+      }
 
-    // Force execution prep for downstream ops if the latest op triggered the
-    // resize of a dynamic tensor.
-    if (tensor_resized_since_op_invoke_ &&
-        HasDynamicTensor(context_, node.outputs)) {
-      next_execution_plan_index_to_prepare_ = execution_plan_index + 1;
+      // Force execution prep for downstream ops if the latest op triggered the
+      // resize of a dynamic tensor.
+      if (tensor_resized_since_op_invoke_ &&
+          HasDynamicTensor(context_, node.outputs)) {
+        next_execution_plan_index_to_prepare_ = execution_plan_index + 1;
+      }
     }
   }
 
@@ -699,9 +835,99 @@ TfLiteStatus Interpreter::Invoke() {
     }
   }
 
+  if (op_latency_recorder_ && status == kTfLiteOk) {
+    op_latency_recorder_->EndInvocation();
+  }
+
   return status;
 }
 
+TfLiteStatus Interpreter::SetOpStatsWindowSize(int window_size) {
+  if (window_size < 0) {
+    ReportError(&context_, "Invalid op stats window size %d.", window_size);
+    return kTfLiteError;
+  }
+  if (window_size == 0) {
+    op_latency_recorder_.reset();
+  } else {
+    op_latency_recorder_.reset(new profiling::OpLatencyRecorder(window_size));
+  }
+  return kTfLiteOk;
+}
+
+std::vector<profiling::OpStats> Interpreter::GetOpStats(
+    bool by_op_type) const {
+  std::vector<profiling::OpStats> node_stats;
+  if (!op_latency_recorder_) return node_stats;
+  // Per-type latencies are the sums of those of their nodes in each
+  // invocation.
+  std::vector<std::vector<int64_t>> latencies;
+  for (int node_index : execution_plan_) {
+    const TfLiteNode& node = nodes_and_registration_[node_index].first;
+    const TfLiteRegistration& registration =
+        nodes_and_registration_[node_index].second;
+    profiling::OpStats stats;
+    stats.op_type = registration.custom_name
+                        ? registration.custom_name
+                        : EnumNameBuiltinOperator(static_cast<BuiltinOperator>(
+                              registration.builtin_code));
+    stats.name = "[";
+    for (int i = 0; i < node.outputs->size; ++i) {
+      const char* name = tensors_[node.outputs->data[i]].name;
+      if (i > 0) stats.name += ", ";
+      stats.name += name ? name : "Unknown";
+    }
+    stats.name += "]";
+    stats.num_nodes = 1;
+    for (const TfLiteIntArray* tensor_indices :
+         {node.outputs, node.temporaries}) {
+      if (!tensor_indices) continue;
+      for (int i = 0; i < tensor_indices->size; ++i) {
+        const TfLiteTensor& tensor = tensors_[tensor_indices->data[i]];
+        if (tensor.allocation_type == kTfLiteArenaRw ||
+            tensor.allocation_type == kTfLiteArenaRwPersistent ||
+            tensor.allocation_type == kTfLiteDynamic) {
+          stats.memory_bytes += tensor.bytes;
+        }
+      }
+    }
+    latencies.push_back(op_latency_recorder_->GetLatencies(node_index));
+    profiling::ComputeLatencyStats(latencies.back(), &stats);
+    node_stats.push_back(stats);
+  }
+  if (!by_op_type) return node_stats;
+
+  std::vector<profiling::OpStats> type_stats;
+  std::vector<std::vector<int64_t>> type_latencies;
+  std::map<std::string, int> type_index;
+  for (int i = 0; i < node_stats.size(); ++i) {
+    const std::string& op_type = node_stats[i].op_type;
+    auto it = type_index.find(op_type);
+    if (it == type_index.end()) {
+      it = type_index.emplace(op_type, type_stats.size()).first;
+      type_stats.emplace_back();
+      type_stats.back().name = op_type;
+      type_stats.back().op_type = op_type;
+      type_latencies.push_back(latencies[i]);
+    } else {
+      for (int j = 0; j < latencies[i].size(); ++j) {
+        type_latencies[it->second][j] += latencies[i][j];
+      }
+    }
+    type_stats[it->second].num_nodes++;
+    type_stats[it->second].memory_bytes += node_stats[i].memory_bytes;
+  }
+  for (int i = 0; i < type_stats.size(); ++i) {
+    profiling::ComputeLatencyStats(type_latencies[i], &type_stats[i]);
+  }
+  std::stable_sort(
+      type_stats.begin(), type_stats.end(),
+      [](const profiling::OpStats& a, const profiling::OpStats& b) {
+        return a.mean_us > b.mean_us;
+      });
+  return type_stats;
+}
+
 TfLiteStatus Interpreter::ResizeTensor(TfLiteContext* context,
                                        TfLiteTensor* tensor,
                                        TfLiteIntArray* new_size) {
@@ -857,6 +1083,7 @@ TfLiteStatus Interpreter::SetExecutionPlan(const std::vector<int>& new_plan) {
     TF_LITE_ENSURE(&context_, node_index >= 0 && node_index < nodes_size());
   }
   execution_plan_ = new_plan;
+  execution_stages_.clear();
   return kTfLiteOk;
 }
 
@@ -920,6 +1147,39 @@ void Interpreter::SetNumThreads(int num_threads) {
   }
 }
 
+TfLiteStatus Interpreter::SetNumInterOpThreads(int num_threads) {
+  if (state_ == kStateInvokableAndImmutable) {
+    ReportError(&context_,
+                "SetNumInterOpThreads is disallowed when graph is immutable.");
+    return kTfLiteError;
+  }
+  if (num_threads > 1) {
+    inter_op_thread_pool_.reset(new InterOpThreadPool(num_threads));
+  } else {
+    inter_op_thread_pool_.reset();
+  }
+  // The memory plan depends on which nodes may run concurrently, so it has to
+  // be redone.
+  execution_stages_.clear();
+  memory_planner_.reset();
+  state_ = kStateUninvokable;
+  return kTfLiteOk;
+}
+
+TfLiteStatus Interpreter::SetUseBestFitMemoryPlanner(bool enable) {
+  if (state_ == kStateInvokableAndImmutable) {
+    ReportError(
+        &context_,
+        "SetUseBestFitMemoryPlanner is disallowed when graph is immutable.");
+    return kTfLiteError;
+  }
+  use_best_fit_memory_planner_ = enable;
+  execution_stages_.clear();
+  memory_planner_.reset();
+  state_ = kStateUninvokable;
+  return kTfLiteOk;
+}
+
 void Interpreter::SwitchToDelegateContext() {
   context_.GetNodeAndRegistration = GetNodeAndRegistration;
   context_.ReplaceSubgraphsWithDelegateKernels =
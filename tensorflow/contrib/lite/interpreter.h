@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/contrib/lite/c/c_api_internal.h"
 #include "tensorflow/contrib/lite/core/api/error_reporter.h"
 #include "tensorflow/contrib/lite/memory_planner.h"
+#include "tensorflow/contrib/lite/profiling/op_stats.h"
 #include "tensorflow/contrib/lite/profiling/profiler.h"
 #include "tensorflow/contrib/lite/stderr_reporter.h"
 
@@ -69,6 +70,8 @@ constexpr TfLiteType typeToTfLiteType<string>() {
   return kTfLiteString;
 }
 
+class InterOpThreadPool;
+
 // Forward declare since NNAPIDelegate uses Interpreter.
 class NNAPIDelegate;
 
@@ -336,6 +339,22 @@ class Interpreter {
   // Set the number of threads available to the interpreter.
   void SetNumThreads(int num_threads);
 
+  // Set the number of threads used to run independent nodes of the graph
+  // concurrently; 1 or less runs the nodes one after the other. The threads
+  // set by SetNumThreads() are available to each of the concurrently running
+  // nodes. Invoke() falls back to running nodes in sequence while the graph
+  // has dynamic tensors or a profiler is set. Requires AllocateTensors()
+  // to be called again.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetNumInterOpThreads(int num_threads);
+
+  // Plan the tensor arena from the lifetimes of all the tensors, placing the
+  // largest ones first (see BestFitArenaPlanner), instead of in execution
+  // order. This usually makes the arena smaller, at the cost of a slower
+  // AllocateTensors(). Requires AllocateTensors() to be called again.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetUseBestFitMemoryPlanner(bool enable);
+
   // Allow float16 precision for FP32 calculation when possible.
   // default: not allow.
   // WARNING: This is an experimental API and subject to change.
@@ -405,6 +424,19 @@ class Interpreter {
 
   profiling::Profiler* GetProfiler() { return profiler_; }
 
+  // Starts collecting per-op latency statistics over the last `window_size`
+  // invocations, discarding those collected so far, or stops collecting them
+  // if `window_size` is 0. Unlike SetProfiler(), this works in builds without
+  // TFLITE_PROFILING_ENABLED, at the cost of two clock reads per op.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetOpStatsWindowSize(int window_size);
+
+  // Returns the statistics collected by SetOpStatsWindowSize() for each node
+  // of the execution plan, in plan order, or if `by_op_type` for each op type,
+  // by decreasing mean time per invocation.
+  // WARNING: This is an experimental API and subject to change.
+  std::vector<profiling::OpStats> GetOpStats(bool by_op_type) const;
+
   // The default capacity of `tensors_` vector.
   static constexpr int kTensorsReservedCapacity = 128;
   // The capacity headroom of `tensors_` vector before calling ops'
@@ -482,6 +514,18 @@ class Interpreter {
     return op_reg.invoke(&context_, node);
   }
 
+  // Groups the execution plan into stages of consecutive nodes that don't
+  // depend on each other, filling `execution_stages_`.
+  void ComputeExecutionStages();
+
+  // Returns true if the next Invoke() can run the nodes of each stage
+  // concurrently.
+  bool CanInvokeStagesInParallel() const;
+
+  // Runs the execution plan one stage at a time, invoking the nodes of each
+  // stage concurrently on `inter_op_thread_pool_`.
+  TfLiteStatus InvokeStagesInParallel();
+
   // Call OpPrepare() for as many ops as possible, allocating memory for their
   // tensors. If an op containing dynamic tensors is found, preparation will be
   // postponed until this function is called again. This allows the interpreter
@@ -677,6 +721,18 @@ class Interpreter {
 
   std::unique_ptr<MemoryPlanner> memory_planner_;
 
+  // Whether memory_planner_ is a BestFitArenaPlanner.
+  bool use_best_fit_memory_planner_ = false;
+
+  // Runs independent nodes concurrently, or null to run nodes in sequence.
+  std::unique_ptr<InterOpThreadPool> inter_op_thread_pool_;
+
+  // The execution plan index of the first node of each stage, followed by the
+  // size of the execution plan the stages were computed for, as passed to
+  // ArenaPlanner::SetExecutionStages(). Empty unless `inter_op_thread_pool_`
+  // is set.
+  std::vector<int> execution_stages_;
+
   bool allow_buffer_handle_output_ = false;
 
   // Tracking bit for whether a tensor was resized in the course of an op
@@ -687,6 +743,9 @@ class Interpreter {
   // Profiler for this interpreter instance.
   profiling::Profiler* profiler_ = nullptr;
 
+  // Latencies of the last invocations, or null if not collecting op stats.
+  std::unique_ptr<profiling::OpLatencyRecorder> op_latency_recorder_;
+
   // List of active external contexts.
   TfLiteExternalContext* external_contexts_[kTfLiteMaxExternalContexts];
 };
@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/contrib/lite/interpreter.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <gtest/gtest.h>
 #include "tensorflow/contrib/lite/core/api/error_reporter.h"
 #include "tensorflow/contrib/lite/kernels/internal/compatibility.h"
@@ -279,6 +282,109 @@ TEST(BasicInterpreter, CheckArenaAllocation) {
   ASSERT_EQ(interpreter.tensor(9)->data.raw, interpreter.tensor(5)->data.raw);
 }
 
+TEST(BasicInterpreter, CheckBestFitArenaAllocation) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(10), kTfLiteOk);
+
+  TfLiteQuantizationParams quant;
+  TfLiteRegistration reg = {nullptr, nullptr, nullptr, nullptr};
+
+  std::vector<int> sizes{2048, 4096, 1023, 2047, 1021,
+                         2047, 1023, 2046, 0,    2048};
+  for (int i = 0; i < sizes.size(); ++i) {
+    interpreter.SetTensorParametersReadWrite(i, kTfLiteUInt8, "", {sizes[i]},
+                                             quant);
+  }
+  interpreter.SetInputs({0, 1});
+  interpreter.SetOutputs({9, 4});
+  interpreter.AddNodeWithParameters({0, 1}, {2, 3}, nullptr, 0, nullptr, &reg);
+  interpreter.AddNodeWithParameters({2, 1}, {4, 5}, nullptr, 0, nullptr, &reg);
+  interpreter.AddNodeWithParameters({4, 3}, {6, 7}, nullptr, 0, nullptr, &reg);
+  interpreter.AddNodeWithParameters({6, 5}, {8}, nullptr, 0, nullptr, &reg);
+  interpreter.AddNodeWithParameters({8, 7}, {9}, nullptr, 0, nullptr, &reg);
+
+  // Returns the number of bytes spanned by the tensors.
+  auto arena_span = [&interpreter]() {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    for (int i = 0; i < interpreter.tensors_size(); ++i) {
+      const TfLiteTensor* tensor = interpreter.tensor(i);
+      if (tensor->data.raw == nullptr) continue;
+      if (begin == nullptr || tensor->data.raw < begin) {
+        begin = tensor->data.raw;
+      }
+      if (end == nullptr || tensor->data.raw + tensor->bytes > end) {
+        end = tensor->data.raw + tensor->bytes;
+      }
+    }
+    return end - begin;
+  };
+
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  const auto default_span = arena_span();
+
+  ASSERT_EQ(interpreter.SetUseBestFitMemoryPlanner(true), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_LT(arena_span(), default_span);
+  // The inputs are preserved, and #3 is in use while #4 is produced.
+  EXPECT_NE(interpreter.tensor(0)->data.raw, interpreter.tensor(2)->data.raw);
+  EXPECT_NE(interpreter.tensor(1)->data.raw, interpreter.tensor(4)->data.raw);
+  EXPECT_NE(interpreter.tensor(3)->data.raw, interpreter.tensor(4)->data.raw);
+  ASSERT_EQ(interpreter.tensor(8)->data.raw, nullptr);
+}
+
+TEST(BasicInterpreter, OpStats) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(3), kTfLiteOk);
+  TfLiteQuantizationParams quant;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(
+                  i, kTfLiteFloat32, i == 2 ? "out" : "", {16}, quant),
+              kTfLiteOk);
+  }
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({2}), kTfLiteOk);
+
+  TfLiteRegistration reg = {nullptr, nullptr, nullptr, nullptr};
+  reg.custom_name = "Sleep";
+  reg.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return kTfLiteOk;
+  };
+  interpreter.AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr, &reg);
+  interpreter.AddNodeWithParameters({1}, {2}, nullptr, 0, nullptr, &reg);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  EXPECT_TRUE(interpreter.GetOpStats(/*by_op_type=*/false).empty());
+  ASSERT_EQ(interpreter.SetOpStatsWindowSize(-1), kTfLiteError);
+  ASSERT_EQ(interpreter.SetOpStatsWindowSize(2), kTfLiteOk);
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  }
+
+  std::vector<profiling::OpStats> node_stats =
+      interpreter.GetOpStats(/*by_op_type=*/false);
+  ASSERT_EQ(node_stats.size(), 2);
+  EXPECT_EQ(node_stats[0].op_type, "Sleep");
+  EXPECT_EQ(node_stats[1].name, "[out]");
+  EXPECT_EQ(node_stats[1].count, 2);
+  EXPECT_GE(node_stats[1].p50_us, 1000);
+  EXPECT_GE(node_stats[1].p99_us, node_stats[1].p50_us);
+  EXPECT_EQ(node_stats[1].memory_bytes, 16 * sizeof(float));
+
+  std::vector<profiling::OpStats> type_stats =
+      interpreter.GetOpStats(/*by_op_type=*/true);
+  ASSERT_EQ(type_stats.size(), 1);
+  EXPECT_EQ(type_stats[0].name, "Sleep");
+  EXPECT_EQ(type_stats[0].num_nodes, 2);
+  EXPECT_EQ(type_stats[0].count, 2);
+  EXPECT_GE(type_stats[0].mean_us, 2000);
+  EXPECT_EQ(type_stats[0].memory_bytes, 2 * 16 * sizeof(float));
+
+  ASSERT_EQ(interpreter.SetOpStatsWindowSize(0), kTfLiteOk);
+  EXPECT_TRUE(interpreter.GetOpStats(/*by_op_type=*/false).empty());
+}
+
 TEST(BasicInterpreter, BufferAccess) {
   Interpreter interpreter;
   ASSERT_EQ(interpreter.AddTensors(1), kTfLiteOk);
@@ -765,6 +871,104 @@ TEST(BasicInterpreter, DynamicTensorsResizeDescendants) {
   ASSERT_EQ(interpreter.tensor(3)->bytes, sizeof(float) * 10 * 14);
 }
 
+// Number of nodes that have started running TestRendezvousOp.
+std::atomic<int> rendezvous_arrivals(0);
+
+TEST(BasicInterpreter, InterOpParallelism) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(4), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({3}), kTfLiteOk);
+  TfLiteQuantizationParams quant;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {1}, quant),
+              kTfLiteOk);
+  }
+
+  // Waits a bounded time for the other node of its stage to start, then
+  // outputs 1 if it did and 0 otherwise. Run concurrently, both nodes output
+  // ones; run in sequence, only the second one does.
+  TfLiteRegistration reg_rendezvous = {nullptr, nullptr, nullptr, nullptr};
+  reg_rendezvous.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    ++rendezvous_arrivals;
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (rendezvous_arrivals < 2 &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+    TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+    output->data.f[0] = rendezvous_arrivals >= 2 ? 1.0f : 0.0f;
+    return kTfLiteOk;
+  };
+  TfLiteRegistration reg_add = {nullptr, nullptr, nullptr, nullptr};
+  reg_add.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    TfLiteTensor* a0 = &context->tensors[node->inputs->data[0]];
+    TfLiteTensor* a1 = &context->tensors[node->inputs->data[1]];
+    TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+    output->data.f[0] = a0->data.f[0] + a1->data.f[0];
+    return kTfLiteOk;
+  };
+
+  // tensor[1] and tensor[2] don't depend on each other.
+  ASSERT_EQ(interpreter.AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr,
+                                              &reg_rendezvous),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({0}, {2}, nullptr, 0, nullptr,
+                                              &reg_rendezvous),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({1, 2}, {3}, nullptr, 0, nullptr,
+                                              &reg_add),
+            kTfLiteOk);
+
+  ASSERT_EQ(interpreter.SetNumInterOpThreads(2), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  rendezvous_arrivals = 0;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(interpreter.typed_tensor<float>(3)[0], 2.0f);
+
+  // Outputs of nodes that may run concurrently never share memory.
+  EXPECT_NE(interpreter.tensor(1)->data.raw, interpreter.tensor(2)->data.raw);
+
+  // Changing the number of threads requires a new allocation.
+  ASSERT_EQ(interpreter.SetNumInterOpThreads(1), kTfLiteOk);
+  EXPECT_NE(interpreter.Invoke(), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  rendezvous_arrivals = 0;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(interpreter.typed_tensor<float>(3)[0], 1.0f);
+}
+
+TEST(BasicInterpreter, InterOpParallelismWithDynamicTensors) {
+  // Graphs with dynamic tensors are run in sequence.
+  Interpreter interpreter;
+  interpreter.AddTensors(4);
+  interpreter.SetInputs({0, 1});
+  interpreter.SetOutputs({3});
+  TfLiteQuantizationParams quant;
+  interpreter.SetTensorParametersReadWrite(0, kTfLiteFloat32, "", {2, 2, 1, 1},
+                                           quant);
+  interpreter.SetTensorParametersReadWrite(1, kTfLiteInt32, "", {4, 2}, quant);
+  interpreter.SetTensorParametersReadWrite(2, kTfLiteFloat32, "", {}, quant);
+  interpreter.SetTensorParametersReadWrite(3, kTfLiteFloat32, "", {}, quant);
+
+  TfLiteRegistration* pad_op = tflite::ops::builtin::Register_PADV2();
+  TfLiteRegistration* neg_op = tflite::ops::builtin::Register_NEG();
+  interpreter.AddNodeWithParameters({0, 1}, {2}, nullptr, 0, nullptr, pad_op);
+  interpreter.AddNodeWithParameters({2}, {3}, nullptr, 0, nullptr, neg_op);
+  ASSERT_EQ(interpreter.SetNumInterOpThreads(4), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  // Configure [[2,2],[4,4]] padding and execute the graph.
+  for (int i = 0; i < 8; ++i) {
+    interpreter.typed_tensor<int>(1)[i] = i < 4 ? i / 2 * 2 + 2 : 0;
+  }
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  ASSERT_EQ(interpreter.tensor(2)->bytes, sizeof(float) * 6 * 10);
+  ASSERT_EQ(interpreter.tensor(3)->bytes, sizeof(float) * 6 * 10);
+}
+
 TEST(InterpreterTensorsCapacityTest, TestWithinHeadroom) {
   Interpreter interpreter;
   ASSERT_EQ(interpreter.AddTensors(Interpreter::kTensorsReservedCapacity),
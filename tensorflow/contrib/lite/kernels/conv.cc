@@ -19,6 +19,7 @@ limitations under the License.
 #include <cstdlib>
 #include <iostream>
 #include <limits>
+#include <memory>
 
 #include "tensorflow/contrib/lite/c/builtin_op_data.h"
 #include "tensorflow/contrib/lite/c/c_api_internal.h"
@@ -33,6 +34,7 @@ limitations under the License.
 #include "tensorflow/contrib/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/contrib/lite/kernels/kernel_util.h"
 #include "tensorflow/contrib/lite/kernels/op_macros.h"
+#include "tensorflow/contrib/lite/kernels/packed_weights_cache.h"
 #include "tensorflow/contrib/lite/kernels/padding.h"
 
 namespace tflite {
@@ -81,6 +83,10 @@ struct OpData {
   int32_t scaling_factors_index;
   bool need_hwcn_weights;
   bool have_weights_been_transposed;
+  // Transposed copy of a read-only filter, shared through
+  // packed_weights_cache with all ops transposing the same filter. Replaces
+  // the `hwcn_weights` temporary when set.
+  std::shared_ptr<const void> shared_hwcn_weights;
   bool need_im2col;
 
   bool run_multithreaded_kernel;
@@ -117,11 +123,8 @@ void Free(TfLiteContext* context, void* buffer) {
 // Naive implementation of transpose for floats. Could be optimized to be more
 // cache friendly, but for now it's a one-time cost on first run, and we would
 // prefer to remove the need to do this at all eventually.
-void TransposeFloatTensor(TfLiteTensor* input, TfLiteTensor* output) {
-  const int rows = output->dims->data[1];
-  const int cols = output->dims->data[0];
-  const float* input_data = GetTensorData<float>(input);
-  float* output_data = GetTensorData<float>(output);
+void TransposeFloatMatrix(const float* input_data, int rows, int cols,
+                          float* output_data) {
   for (int i = 0; i < rows; ++i) {
     for (int j = 0; j < cols; ++j) {
       const float in_value = input_data[i * cols + j];
@@ -130,6 +133,11 @@ void TransposeFloatTensor(TfLiteTensor* input, TfLiteTensor* output) {
   }
 }
 
+void TransposeFloatTensor(TfLiteTensor* input, TfLiteTensor* output) {
+  TransposeFloatMatrix(GetTensorData<float>(input), output->dims->data[1],
+                       output->dims->data[0], GetTensorData<float>(output));
+}
+
 // Allocate temporary tensors (`im2col`, `hwcn_weights` if necessary).
 // Note: `context->AddTensors` might invalidate pointers to existing tensors.
 // Therefore the logic to add tensors are isolated into this function.
@@ -167,6 +175,14 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(TfLiteContext* context,
   // we're running with that data type.
   data->need_hwcn_weights = (input->type == kTfLiteFloat32 &&
                              data->run_multithreaded_kernel && !is_hybrid);
+  // A filter stored in the model is transposed once for all interpreters
+  // built from it, into a buffer shared through packed_weights_cache, so
+  // only the other filters need a temporary.
+  const bool need_hwcn_weights_temporary =
+      data->need_hwcn_weights && filter->allocation_type != kTfLiteMmapRo;
+  if (!data->need_hwcn_weights || need_hwcn_weights_temporary) {
+    data->shared_hwcn_weights.reset();
+  }
 
   int temporaries_count = 0;
   if (data->need_im2col) {
@@ -176,7 +192,7 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(TfLiteContext* context,
     }
     ++temporaries_count;
   }
-  if (data->need_hwcn_weights) {
+  if (need_hwcn_weights_temporary) {
     data->hwcn_weights_index = temporaries_count;
     if (data->hwcn_weights_id == kTensorNotAllocated) {
       context->AddTensors(context, 1, &data->hwcn_weights_id);
@@ -342,7 +358,19 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     if (im2col_status != kTfLiteOk) return im2col_status;
   }
 
-  if (data->need_hwcn_weights) {
+  if (data->need_hwcn_weights && filter->allocation_type == kTfLiteMmapRo) {
+    const int rows = channels_out;
+    const int cols = filter_height * filter_width * input->dims->data[3];
+    const float* filter_data = GetTensorData<float>(filter);
+    const size_t size = filter->bytes;
+    data->shared_hwcn_weights = packed_weights_cache::GetOrPack(
+        filter_data, size,
+        packed_weights_cache::Layout::kTransposedFloatMatrix, size,
+        [filter_data, rows, cols](void* packed) {
+          TransposeFloatMatrix(filter_data, rows, cols,
+                               static_cast<float*>(packed));
+        });
+  } else if (data->need_hwcn_weights) {
     node->temporaries->data[data->hwcn_weights_index] = data->hwcn_weights_id;
     TfLiteIntArray* hwcn_weights_size = TfLiteIntArrayCreate(2);
 
@@ -532,7 +560,10 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
     }
     case kMultithreadOptimized: {
       const float* filter_data;
-      if (data->need_hwcn_weights) {
+      if (data->shared_hwcn_weights) {
+        filter_data =
+            static_cast<const float*>(data->shared_hwcn_weights.get());
+      } else if (data->need_hwcn_weights) {
         filter_data = GetTensorData<float>(hwcn_weights);
       } else {
         filter_data = GetTensorData<float>(filter);
@@ -637,11 +668,11 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           ? &context->tensors[node->temporaries->data[data->im2col_index]]
           : nullptr;
   TfLiteTensor* hwcn_weights =
-      data->need_hwcn_weights
+      data->need_hwcn_weights && !data->shared_hwcn_weights
           ? &context->tensors[node->temporaries->data[data->hwcn_weights_index]]
           : nullptr;
 
-  if (data->need_hwcn_weights && !data->have_weights_been_transposed) {
+  if (hwcn_weights && !data->have_weights_been_transposed) {
     TransposeFloatTensor(filter, hwcn_weights);
     data->have_weights_been_transposed = true;
   }
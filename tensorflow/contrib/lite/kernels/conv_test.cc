@@ -142,6 +142,77 @@ TEST_P(ConvolutionOpTest, SimpleTestFloat32) {
                              }));
 }
 
+// A convolution whose filter is stored in the model, as it is for models
+// converted from a trained graph.
+class ConstFilterConvolutionOpModel : public SingleOpModel {
+ public:
+  ConstFilterConvolutionOpModel(TfLiteRegistration* registration,
+                                const TensorData& input,
+                                std::initializer_list<int> filter_shape,
+                                std::initializer_list<float> filter_data,
+                                int stride) {
+    input_ = AddInput(input);
+    filter_ = AddConstInput(TensorType_FLOAT32, filter_data, filter_shape);
+    bias_ = AddInput({TensorType_FLOAT32, {GetShape(filter_)[0]}});
+    output_ = AddOutput({TensorType_FLOAT32, {}});
+
+    SetBuiltinOp(BuiltinOperator_CONV_2D, BuiltinOptions_Conv2DOptions,
+                 CreateConv2DOptions(builder_, Padding_VALID, stride, stride,
+                                     ActivationFunctionType_NONE, 1, 1)
+                     .Union());
+
+    resolver_ = absl::make_unique<SingleOpResolver>(BuiltinOperator_CONV_2D,
+                                                    registration);
+    // The filter is stored in the model and can't be resized.
+    BuildInterpreter({GetShape(input_), {}, GetShape(bias_)});
+  }
+
+  void SetBias(std::initializer_list<float> f) { PopulateTensor(bias_, f); }
+
+  void SetInput(std::initializer_list<float> data) {
+    PopulateTensor(input_, data);
+  }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ private:
+  int input_;
+  int filter_;
+  int bias_;
+  int output_;
+};
+
+TEST_P(ConvolutionOpTest, ConstFilterFloat32) {
+  ConstFilterConvolutionOpModel m(GetRegistration(),
+                                  {TensorType_FLOAT32, {2, 2, 4, 1}},
+                                  {3, 2, 2, 1},
+                                  {
+                                      1, 2, 3, 4,    // first 2x2 filter
+                                      -1, 1, -1, 1,  // second 2x2 filter
+                                      -1, -1, 1, 1,  // third 2x2 filter
+                                  },
+                                  /*stride=*/2);
+  m.SetInput({
+      // First batch
+      1, 1, 1, 1,  // row = 1
+      2, 2, 2, 2,  // row = 2
+      // Second batch
+      1, 2, 3, 4,  // row = 1
+      1, 2, 3, 4,  // row = 2
+  });
+  m.SetBias({1, 2, 3});
+
+  // Invoke twice, since the multithreaded kernel transposes the filter once.
+  for (int i = 0; i < 2; ++i) {
+    m.Invoke();
+    EXPECT_THAT(m.GetOutput(), ElementsAreArray({
+                                   18, 2, 5,  // first batch, left
+                                   18, 2, 5,  // first batch, right
+                                   17, 4, 3,  // second batch, left
+                                   37, 4, 3,  // second batch, right
+                               }));
+  }
+}
+
 // This test's output is equivalent to the SimpleTestFloat32
 // because we break each input into two channels, each with half of the value,
 // while keeping the filters for each channel equivalent.
@@ -17,8 +17,10 @@ limitations under the License.
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <limits>
+#include <memory>
 
 #include "tensorflow/contrib/lite/c/builtin_op_data.h"
 #include "tensorflow/contrib/lite/c/c_api_internal.h"
@@ -31,6 +33,7 @@ limitations under the License.
 #include "tensorflow/contrib/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/contrib/lite/kernels/kernel_util.h"
 #include "tensorflow/contrib/lite/kernels/op_macros.h"
+#include "tensorflow/contrib/lite/kernels/packed_weights_cache.h"
 
 namespace tflite {
 namespace ops {
@@ -56,6 +59,12 @@ struct OpData {
   int32_t output_activation_max;
   // The index of the temporary tensor where the quantized inputs are cached.
   int scratch_tensor_index;
+  // Block-sparse copy of a read-only float filter with enough zero blocks,
+  // shared through packed_weights_cache. It holds the ledger, of
+  // `sparse_filter_ledger_size` entries, followed by the kept blocks, as taken
+  // by tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate.
+  std::shared_ptr<const void> sparse_filter;
+  int sparse_filter_ledger_size = 0;
 };
 
 constexpr int kInputTensor = 0;
@@ -64,6 +73,10 @@ constexpr int kBiasTensor = 2;
 constexpr int kOutputTensor = 0;
 constexpr int kShuffledInputWorkspaceTensor = 1;
 
+// Float filters with at least this fraction of all-zero blocks, as left by
+// block pruning, are multiplied as sparse matrices.
+constexpr float kMinZeroBlockFractionForSparseFilter = 0.5f;
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   // This is a builtin op, so we don't use the contents in 'buffer', if any.
   // Instead, we allocate a new object to carry information from Prepare() to
@@ -80,6 +93,59 @@ void Free(TfLiteContext* context, void* buffer) {
   delete reinterpret_cast<OpData*>(buffer);
 }
 
+// Sets up data->sparse_filter if `filter` is a read-only float matrix with
+// enough all-zero blocks for the sparse kernel to pay off.
+void PrepareSparseFilter(const TfLiteTensor* filter, OpData* data) {
+  data->sparse_filter.reset();
+  const int kBlockSize = tensor_utils::kSparseMatrixBlockSize;
+  if (filter->type != kTfLiteFloat32 ||
+      filter->allocation_type != kTfLiteMmapRo) {
+    return;
+  }
+  const int rows = SizeOfDimension(filter, 0);
+  const int cols = SizeOfDimension(filter, 1);
+  if (cols % kBlockSize != 0) return;
+
+  const float* filter_data = GetTensorData<float>(filter);
+  const int num_blocks = rows * cols / kBlockSize;
+  int num_kept_blocks = 0;
+  for (int i = 0; i < num_blocks; ++i) {
+    if (!tensor_utils::IsZeroVector(filter_data + i * kBlockSize,
+                                    kBlockSize)) {
+      ++num_kept_blocks;
+    }
+  }
+  if (num_kept_blocks >
+      (1.0f - kMinZeroBlockFractionForSparseFilter) * num_blocks) {
+    return;
+  }
+
+  const int ledger_size = rows + num_kept_blocks;
+  const size_t packed_size = ledger_size * sizeof(int32_t) +
+                             num_kept_blocks * kBlockSize * sizeof(float);
+  data->sparse_filter = packed_weights_cache::GetOrPack(
+      filter_data, filter->bytes,
+      packed_weights_cache::Layout::kBlockSparseFloatMatrix, packed_size,
+      [filter_data, rows, cols, ledger_size, kBlockSize](void* packed) {
+        int32_t* ledger = static_cast<int32_t*>(packed);
+        float* blocks = reinterpret_cast<float*>(ledger + ledger_size);
+        const float* block = filter_data;
+        for (int r = 0; r < rows; ++r) {
+          int32_t* num_row_blocks = ledger++;
+          *num_row_blocks = 0;
+          for (int c = 0; c < cols / kBlockSize; ++c, block += kBlockSize) {
+            if (tensor_utils::IsZeroVector(block, kBlockSize)) continue;
+            *ledger++ = c;
+            ++*num_row_blocks;
+            memcpy(blocks, block, kBlockSize * sizeof(float));
+            blocks += kBlockSize;
+          }
+        }
+      });
+  data->sparse_filter_ledger_size = ledger_size;
+}
+
+template <KernelType kernel_type>
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   auto* params =
       reinterpret_cast<TfLiteFullyConnectedParams*>(node->builtin_data);
@@ -160,6 +226,11 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     }
   }
 
+  // The reference kernel always multiplies the filter as stored.
+  if (kernel_type != kReference) {
+    PrepareSparseFilter(filter, data);
+  }
+
   // Resize output.
   TfLiteIntArray* output_size_array = TfLiteIntArrayCreate(2);
   output_size_array->data[0] = batch_size;
@@ -202,6 +273,44 @@ TfLiteStatus EvalPie(TfLiteContext* context, TfLiteNode* node,
   return kTfLiteOk;
 }
 
+TfLiteStatus EvalSparseFloat(TfLiteContext* context, TfLiteNode* node,
+                             TfLiteFullyConnectedParams* params, OpData* data,
+                             const TfLiteTensor* input,
+                             const TfLiteTensor* filter,
+                             const TfLiteTensor* bias, TfLiteTensor* output) {
+  int total_input_size = 1;
+  for (int i = 0; i < input->dims->size; i++) {
+    total_input_size *= input->dims->data[i];
+  }
+
+  const int input_size = filter->dims->data[1];
+  const int batch_size = total_input_size / filter->dims->data[1];
+  const int num_units = filter->dims->data[0];
+
+  // Output = bias if bias tensor exists.
+  if (bias) {
+    tensor_utils::VectorBatchVectorAssign(bias->data.f, num_units, batch_size,
+                                          output->data.f);
+  } else {
+    tensor_utils::ZeroVector(output->data.f, batch_size * num_units);
+  }
+
+  // Compute output += weight * input, skipping the zero blocks of weight.
+  const int32_t* ledger =
+      static_cast<const int32_t*>(data->sparse_filter.get());
+  const float* blocks =
+      reinterpret_cast<const float*>(ledger + data->sparse_filter_ledger_size);
+  tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate(
+      blocks, ledger, num_units, input_size, input->data.f, batch_size,
+      output->data.f, /*result_stride=*/1);
+
+  // Apply activation function
+  tensor_utils::ApplyActivationToVector(output->data.f, batch_size * num_units,
+                                        params->activation, output->data.f);
+
+  return kTfLiteOk;
+}
+
 TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
                         TfLiteFullyConnectedParams* params, OpData* data,
                         const TfLiteTensor* input, const TfLiteTensor* filter,
@@ -408,6 +517,9 @@ TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
   }
   if (kernel_type == kReference) {
     TF_LITE_FULLY_CONNECTED(reference_ops);
+  } else if (data->sparse_filter) {
+    return EvalSparseFloat(context, node, params, data, input, filter, bias,
+                           output);
   } else if (kernel_type == kPie) {
     return EvalPie(context, node, params, data, input, filter, bias, output);
   } else {
@@ -464,29 +576,33 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 
 TfLiteRegistration* Register_FULLY_CONNECTED_REF() {
   static TfLiteRegistration r = {
-      fully_connected::Init, fully_connected::Free, fully_connected::Prepare,
+      fully_connected::Init, fully_connected::Free,
+      fully_connected::Prepare<fully_connected::kReference>,
       fully_connected::Eval<fully_connected::kReference>};
   return &r;
 }
 
 TfLiteRegistration* Register_FULLY_CONNECTED_NEON_OPT() {
   static TfLiteRegistration r = {
-      fully_connected::Init, fully_connected::Free, fully_connected::Prepare,
+      fully_connected::Init, fully_connected::Free,
+      fully_connected::Prepare<fully_connected::kNeonOptimized>,
       fully_connected::Eval<fully_connected::kNeonOptimized>};
   return &r;
 }
 
 TfLiteRegistration* Register_FULLY_CONNECTED_GENERIC_OPT() {
   static TfLiteRegistration r = {
-      fully_connected::Init, fully_connected::Free, fully_connected::Prepare,
+      fully_connected::Init, fully_connected::Free,
+      fully_connected::Prepare<fully_connected::kGenericOptimized>,
       fully_connected::Eval<fully_connected::kGenericOptimized>};
   return &r;
 }
 
 TfLiteRegistration* Register_FULLY_CONNECTED_PIE() {
-  static TfLiteRegistration r = {fully_connected::Init, fully_connected::Free,
-                                 fully_connected::Prepare,
-                                 fully_connected::Eval<fully_connected::kPie>};
+  static TfLiteRegistration r = {
+      fully_connected::Init, fully_connected::Free,
+      fully_connected::Prepare<fully_connected::kPie>,
+      fully_connected::Eval<fully_connected::kPie>};
   return &r;
 }
 
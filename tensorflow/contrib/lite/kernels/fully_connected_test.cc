@@ -393,6 +393,61 @@ TEST_P(FloatFullyConnectedOpTest, SimpleTest2) {
   EXPECT_THAT(m.GetOutput(), ElementsAre(11, 9));
 }
 
+// A fully connected op whose weights are stored in the model.
+class ConstWeightsFullyConnectedOpModel : public SingleOpModel {
+ public:
+  ConstWeightsFullyConnectedOpModel(TfLiteRegistration* registration,
+                                    int units, int batches, int input_size,
+                                    std::initializer_list<float> weights) {
+    input_ = AddInput({TensorType_FLOAT32, {batches, input_size}});
+    AddConstInput(TensorType_FLOAT32, weights, {units, input_size});
+    bias_ = AddInput({TensorType_FLOAT32, {units}});
+    output_ = AddOutput({TensorType_FLOAT32});
+    SetBuiltinOp(BuiltinOperator_FULLY_CONNECTED,
+                 BuiltinOptions_FullyConnectedOptions,
+                 CreateFullyConnectedOptions(builder_,
+                                             ActivationFunctionType_NONE)
+                     .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(
+        BuiltinOperator_FULLY_CONNECTED, registration);
+    // The weights are stored in the model and can't be resized.
+    BuildInterpreter({GetShape(input_), {}, GetShape(bias_)});
+  }
+
+  void SetBias(const std::vector<float>& f) { PopulateTensor(bias_, f); }
+  void SetInput(const std::vector<float>& data) {
+    PopulateTensor(input_, data);
+  }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ private:
+  int input_;
+  int bias_;
+  int output_;
+};
+
+// Half of the weight blocks are zero, so the optimized kernels run the sparse
+// multiplication.
+TEST_P(FloatFullyConnectedOpTest, BlockSparseWeights) {
+  ConstWeightsFullyConnectedOpModel m(
+      GetRegistration(), /*units=*/4, /*batches=*/2, /*input_size=*/16,
+      {
+          1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15, 16,  //
+          0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,   //
+          -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+          0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,   //
+      });
+  m.SetBias({1, 2, 3, 4});
+  m.SetInput({
+      1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  1,  1,  1,  1,  1,  1,   // b = 0
+      0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,  // b = 1
+  });
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutput(), ElementsAre(137, 2, -13, 4, 1361, 2, -117, 4));
+}
+
 TEST_P(QuantizedFullyConnectedOpTest, SimpleTestQuantized) {
   QuantizedFullyConnectedOpModel m(
       GetRegistration(), /*units=*/3, /*batches*/ 2,
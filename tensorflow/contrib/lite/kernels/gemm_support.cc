@@ -15,6 +15,9 @@ limitations under the License.
 #include "tensorflow/contrib/lite/kernels/gemm_support.h"
 
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #include "tensorflow/contrib/lite/kernels/op_macros.h"
 
@@ -22,8 +25,13 @@ namespace tflite {
 namespace gemm_support {
 namespace {
 
+// A GemmContext can't be used by two ops at once, which happens when the
+// interpreter runs independent nodes concurrently, so every thread running
+// ops gets a GemmContext of its own.
 struct RefCountedGemmContext : public TfLiteExternalContext {
-  std::unique_ptr<gemmlowp::GemmContext> gemm_context;
+  std::mutex mutex;
+  std::unordered_map<std::thread::id, std::unique_ptr<gemmlowp::GemmContext>>
+      gemm_contexts;
   int num_references = 0;
 };
 
@@ -35,7 +43,11 @@ RefCountedGemmContext* GetGemmLowpContext(TfLiteContext* context) {
 TfLiteStatus Refresh(TfLiteContext* context) {
   auto* ptr = GetGemmLowpContext(context);
   if (ptr != nullptr) {
-    ptr->gemm_context->set_max_num_threads(context->recommended_num_threads);
+    std::lock_guard<std::mutex> lock(ptr->mutex);
+    for (auto& gemm_context : ptr->gemm_contexts) {
+      gemm_context.second->set_max_num_threads(
+          context->recommended_num_threads);
+    }
   }
   return kTfLiteOk;
 }
@@ -48,10 +60,6 @@ void IncrementUsageCounter(TfLiteContext* context) {
     ptr = new RefCountedGemmContext;
     ptr->type = kTfLiteGemmLowpContext;
     ptr->Refresh = Refresh;
-    ptr->gemm_context.reset(new gemmlowp::GemmContext());
-    if (context->recommended_num_threads != -1) {
-      ptr->gemm_context->set_max_num_threads(context->recommended_num_threads);
-    }
     ptr->num_references = 0;
     context->SetExternalContext(context, kTfLiteGemmLowpContext, ptr);
   }
@@ -77,7 +85,15 @@ gemmlowp::GemmContext* GetFromContext(TfLiteContext* context) {
     TF_LITE_FATAL(
         "Call to GetFromContext() not preceded by IncrementUsageCounter()");
   }
-  return ptr->gemm_context.get();
+  std::lock_guard<std::mutex> lock(ptr->mutex);
+  auto& gemm_context = ptr->gemm_contexts[std::this_thread::get_id()];
+  if (gemm_context == nullptr) {
+    gemm_context.reset(new gemmlowp::GemmContext());
+    if (context->recommended_num_threads != -1) {
+      gemm_context->set_max_num_threads(context->recommended_num_threads);
+    }
+  }
+  return gemm_context.get();
 }
 
 }  // namespace gemm_support
@@ -192,6 +192,39 @@ void NeonMatrixBatchVectorMultiplyAccumulate(
   free(aligned_vec_free);
 }
 
+void NeonSparseMatrixBatchVectorMultiplyAccumulate(
+    const float* __restrict__ matrix, const int32_t* __restrict__ ledger,
+    int m_rows, int m_cols, const float* __restrict__ vector, int n_batch,
+    float* __restrict__ result, int result_stride) {
+  // Must match kSparseMatrixBlockSize in tensor_utils.h.
+  const int kBlockSize = 16;
+  for (int b = 0; b < n_batch; b++) {
+    const float* matrix_ptr = matrix;
+    const int32_t* ledger_ptr = ledger;
+    const float* vector_in_batch = vector + b * m_cols;
+    for (int r = 0; r < m_rows; r++) {
+      float32x4_t acc_32x4 = vmovq_n_f32(0.0);
+      const int num_blocks = *ledger_ptr++;
+      for (int i = 0; i < num_blocks; i++) {
+        const float* vector_block =
+            vector_in_batch + *ledger_ptr++ * kBlockSize;
+        for (int c = 0; c < kBlockSize; c += kFloatWeightsPerNeonLane) {
+          // Load 4 float values from the vector and the matrix block.
+          float32x4_t vector_f32x4 = vld1q_f32(vector_block + c);
+          float32x4_t matrix_f32x4 = vld1q_f32(matrix_ptr + c);
+          // Multiply them and add to the accumulator.
+          acc_32x4 = vmlaq_f32(acc_32x4, matrix_f32x4, vector_f32x4);
+        }
+        matrix_ptr += kBlockSize;
+      }
+      *result +=
+          (vgetq_lane_f32(acc_32x4, 0) + vgetq_lane_f32(acc_32x4, 1) +
+           vgetq_lane_f32(acc_32x4, 2) + vgetq_lane_f32(acc_32x4, 3));
+      result += result_stride;
+    }
+  }
+}
+
 void NeonVectorVectorCwiseProduct(const float* vector1, const float* vector2,
                                   int v_size, float* result) {
   // If v_size is not divisible by kWeightsPerNeonLane, we cannot use the main
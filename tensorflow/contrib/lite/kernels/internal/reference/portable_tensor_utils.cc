@@ -110,6 +110,32 @@ void PortableMatrixBatchVectorMultiplyAccumulate(
   }    // for batch
 }
 
+void PortableSparseMatrixBatchVectorMultiplyAccumulate(
+    const float* __restrict__ matrix, const int32_t* __restrict__ ledger,
+    int m_rows, int m_cols, const float* __restrict__ vector, int n_batch,
+    float* __restrict__ result, int result_stride) {
+  // Must match kSparseMatrixBlockSize in tensor_utils.h.
+  const int kBlockSize = 16;
+  for (int b = 0; b < n_batch; b++) {
+    const float* matrix_ptr = matrix;
+    const int32_t* ledger_ptr = ledger;
+    const float* vector_in_batch = vector + b * m_cols;
+    for (int r = 0; r < m_rows; r++) {
+      float dot_prod = 0.0f;
+      const int num_blocks = *ledger_ptr++;
+      for (int i = 0; i < num_blocks; i++) {
+        const float* vector_block =
+            vector_in_batch + *ledger_ptr++ * kBlockSize;
+        for (int c = 0; c < kBlockSize; c++) {
+          dot_prod += *matrix_ptr++ * vector_block[c];
+        }
+      }
+      *result += dot_prod;
+      result += result_stride;
+    }
+  }
+}
+
 void PortableVectorVectorCwiseProduct(const float* vector1,
                                       const float* vector2, int v_size,
                                       float* result) {
@@ -67,6 +67,21 @@ void MatrixBatchVectorMultiplyAccumulate(
     const int8_t* __restrict__ vectors, const float* scaling_factors,
     int n_batch, float* __restrict__ result, int result_stride);
 
+// Number of consecutive columns in the blocks of the sparse matrices taken by
+// SparseMatrixBatchVectorMultiplyAccumulate.
+constexpr int kSparseMatrixBlockSize = 16;
+
+// Same as MatrixBatchVectorMultiplyAccumulate, but for a matrix stored in
+// 1 x kSparseMatrixBlockSize blocks, of which only the non-zero ones are kept.
+// `matrix` holds the kept blocks, row by row, and `ledger` describes them: for
+// each row, the number of blocks kept followed by their column indices, in
+// units of blocks and in increasing order. `m_cols` must be a multiple of
+// kSparseMatrixBlockSize.
+void SparseMatrixBatchVectorMultiplyAccumulate(
+    const float* __restrict__ matrix, const int32_t* __restrict__ ledger,
+    int m_rows, int m_cols, const float* __restrict__ vector, int n_batch,
+    float* __restrict__ result, int result_stride);
+
 // Cwise product of two vectors.
 void VectorVectorCwiseProduct(const float* vector1, const float* vector2,
                               int v_size, float* result);
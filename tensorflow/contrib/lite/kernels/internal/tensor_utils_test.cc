@@ -143,6 +143,38 @@ TEST(uKernels, MatrixBatchVectorMultiplyAccumulateTest) {
                                                -1., 3., 7., 3., 23., 3.})));
 }
 
+TEST(uKernels, SparseMatrixBatchVectorMultiplyAccumulateTest) {
+  constexpr int kRow = 3;
+  constexpr int kCol = 2 * kSparseMatrixBlockSize;
+  constexpr int kBatch = 2;
+  // Row 0 keeps its second block, row 1 both blocks and row 2 none.
+  std::vector<float> dense_matrix(kRow * kCol, 0.0);
+  std::vector<float> sparse_matrix;
+  for (int c = kSparseMatrixBlockSize; c < kCol; ++c) {
+    dense_matrix[c] = c;
+    sparse_matrix.push_back(c);
+  }
+  for (int c = 0; c < kCol; ++c) {
+    dense_matrix[kCol + c] = -c;
+    sparse_matrix.push_back(-c);
+  }
+  const int32_t ledger[] = {1, 1, 2, 0, 1, 0};
+  std::vector<float> vector(kCol * kBatch);
+  for (int i = 0; i < kCol * kBatch; ++i) {
+    vector[i] = (i % 3) - 1;
+  }
+
+  std::vector<float> expected(kRow * kBatch * 2, 3.0);
+  MatrixBatchVectorMultiplyAccumulate(dense_matrix.data(), kRow, kCol,
+                                      vector.data(), kBatch, expected.data(),
+                                      /*result_stride=*/2);
+  std::vector<float> output(kRow * kBatch * 2, 3.0);
+  SparseMatrixBatchVectorMultiplyAccumulate(
+      sparse_matrix.data(), ledger, kRow, kCol, vector.data(), kBatch,
+      output.data(), /*result_stride=*/2);
+  EXPECT_THAT(output, ElementsAreArray(ArrayFloatNear(expected)));
+}
+
 #ifdef __ANDROID__
 TEST(uKernels, MatrixBatchVectorMultiplyAccumulateSymmetricQuantizedTest) {
   // Note we use 29 columns as this exercises all the neon kernel: the
@@ -27,30 +27,13 @@ namespace lstm_eval {
 
 namespace {
 
-// Performs an LSTM batch inference step for input specified by input_ptr_batch.
-// The LSTM cell is specified by the pointers to its weights (*_weights_ptr) and
-// biases (*_bias_ptr), and buffers (*_scratch), along with additional
-// parameters:
-//  - params: various LSTM params including activation, clipping, etc.,
-//  - n_batch: size of batch,
-//  - n_cell: number of cells (or units),
-//  - n_input: the input size,
-//  - n_output: the output size.
-//  - output_batch_leading_dim: the leading dimension of the output buffer.
-//
-// The pointers to the cell and output state and the output are updated.
-//
-// The pointers with the suffix "_batch" point to data aligned in batch_major
-// order, and each step processes batch_size many inputs from input_ptr_batch,
-// and updates batch_size many cell and output states.
-//
-// The output_batch_dim is output.shape[-1], i.e. the outermost dimension of the
-// output tensor, and in most cases will be equal to n_output. It is usually not
-// when we want to store the LSTM output into a slice of the output tensor, e.g.
-// for bidirectional LSTMs with merge_outputs. In this case, the batched
-// operations cannot be used since they assume that the batched outputs are
-// contiguous, and we manually loop over the batched outputs.
-inline void LstmStepWithAuxInput(
+// Initializes the gate scratch buffers of an LSTM step with the gate biases
+// and adds the projections of input_ptr_batch (and of aux_input_ptr_batch if
+// it is not null) to them. The projections do not depend on the recurrent
+// state, so this can be done for all the steps of a sequence at once by
+// passing n_batch * max_time as n_batch, which turns the per-step
+// matrix-vector products into one matrix-matrix product per gate.
+inline void CalculateLstmGateInputs(
     const float* input_ptr_batch, const float* input_to_input_weights_ptr,
     const float* input_to_forget_weights_ptr,
     const float* input_to_cell_weights_ptr,
@@ -59,25 +42,12 @@ inline void LstmStepWithAuxInput(
     const float* aux_input_to_forget_weights_ptr,
     const float* aux_input_to_cell_weights_ptr,
     const float* aux_input_to_output_weights_ptr,
-    const float* recurrent_to_input_weights_ptr,
-    const float* recurrent_to_forget_weights_ptr,
-    const float* recurrent_to_cell_weights_ptr,
-    const float* recurrent_to_output_weights_ptr,
-    const float* cell_to_input_weights_ptr,
-    const float* cell_to_forget_weights_ptr,
-    const float* cell_to_output_weights_ptr, const float* input_gate_bias_ptr,
-    const float* forget_gate_bias_ptr, const float* cell_bias_ptr,
-    const float* output_gate_bias_ptr, const float* projection_weights_ptr,
-    const float* projection_bias_ptr, const TfLiteLSTMParams* params,
-    int n_batch, int n_cell, int n_input, int n_aux_input, int n_output,
-    int output_batch_leading_dim, float* output_state_ptr,
-    float* cell_state_ptr, float* input_gate_scratch,
-    float* forget_gate_scratch, float* cell_scratch, float* output_gate_scratch,
-    float* output_ptr_batch) {
-  // Since we have already checked that weights are all there or none, we can
-  // check the existense of only one to the get the condition.
+    const float* input_gate_bias_ptr, const float* forget_gate_bias_ptr,
+    const float* cell_bias_ptr, const float* output_gate_bias_ptr, int n_batch,
+    int n_cell, int n_input, int n_aux_input, float* input_gate_scratch,
+    float* forget_gate_scratch, float* cell_scratch,
+    float* output_gate_scratch) {
   const bool use_cifg = (input_to_input_weights_ptr == nullptr);
-  const bool use_peephole = (cell_to_output_weights_ptr != nullptr);
   // Initialize scratch buffers with bias.
   if (!use_cifg) {
     tensor_utils::VectorBatchVectorAssign(input_gate_bias_ptr, n_cell, n_batch,
@@ -126,6 +96,213 @@ inline void LstmStepWithAuxInput(
         aux_input_to_output_weights_ptr, n_cell, n_aux_input,
         aux_input_ptr_batch, n_batch, output_gate_scratch, /*result_stride=*/1);
   }
+}
+
+// Same as above but with quantized input weight matrices. The inputs are
+// quantized per batch row into quantized_input_ptr_batch and
+// quantized_aux_input_ptr_batch, and scaling_factors and
+// product_scaling_factors must have room for n_batch values.
+inline void CalculateLstmGateInputs(
+    const float* input_ptr_batch, const int8_t* input_to_input_weights_ptr,
+    float input_to_input_weights_scale,
+    const int8_t* input_to_forget_weights_ptr,
+    float input_to_forget_weights_scale,
+    const int8_t* input_to_cell_weights_ptr, float input_to_cell_weights_scale,
+    const int8_t* input_to_output_weights_ptr,
+    float input_to_output_weights_scale, const float* aux_input_ptr_batch,
+    const int8_t* aux_input_to_input_weights_ptr,
+    float aux_input_to_input_weights_scale,
+    const int8_t* aux_input_to_forget_weights_ptr,
+    float aux_input_to_forget_weights_scale,
+    const int8_t* aux_input_to_cell_weights_ptr,
+    float aux_input_to_cell_weights_scale,
+    const int8_t* aux_input_to_output_weights_ptr,
+    float aux_input_to_output_weights_scale, const float* input_gate_bias_ptr,
+    const float* forget_gate_bias_ptr, const float* cell_bias_ptr,
+    const float* output_gate_bias_ptr, int n_batch, int n_cell, int n_input,
+    int n_aux_input, float* input_gate_scratch, float* forget_gate_scratch,
+    float* cell_scratch, float* output_gate_scratch, float* scaling_factors,
+    float* product_scaling_factors, int8_t* quantized_input_ptr_batch,
+    int8_t* quantized_aux_input_ptr_batch) {
+  const bool use_cifg = (input_to_input_weights_ptr == nullptr);
+  // Initialize scratch buffers with bias.
+  if (!use_cifg) {
+    tensor_utils::VectorBatchVectorAssign(input_gate_bias_ptr, n_cell, n_batch,
+                                          input_gate_scratch);
+  }
+  tensor_utils::VectorBatchVectorAssign(forget_gate_bias_ptr, n_cell, n_batch,
+                                        forget_gate_scratch);
+  tensor_utils::VectorBatchVectorAssign(cell_bias_ptr, n_cell, n_batch,
+                                        cell_scratch);
+  tensor_utils::VectorBatchVectorAssign(output_gate_bias_ptr, n_cell, n_batch,
+                                        output_gate_scratch);
+
+  if (!tensor_utils::IsZeroVector(input_ptr_batch, n_batch * n_input)) {
+    // Save quantization and matmul computation for all zero input.
+    float unused_min, unused_max;
+    for (int b = 0; b < n_batch; ++b) {
+      const int offset = b * n_input;
+      tensor_utils::SymmetricQuantizeFloats(
+          input_ptr_batch + offset, n_input, quantized_input_ptr_batch + offset,
+          &unused_min, &unused_max, &scaling_factors[b]);
+    }
+    // For each batch and cell: compute input_weight * input.
+    if (!use_cifg) {
+      for (int b = 0; b < n_batch; ++b) {
+        product_scaling_factors[b] =
+            scaling_factors[b] * input_to_input_weights_scale;
+      }
+      tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+          input_to_input_weights_ptr, n_cell, n_input,
+          quantized_input_ptr_batch, product_scaling_factors, n_batch,
+          input_gate_scratch, /*result_stride=*/1);
+    }
+
+    for (int b = 0; b < n_batch; ++b) {
+      product_scaling_factors[b] =
+          scaling_factors[b] * input_to_forget_weights_scale;
+    }
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        input_to_forget_weights_ptr, n_cell, n_input, quantized_input_ptr_batch,
+        product_scaling_factors, n_batch, forget_gate_scratch,
+        /*result_stride=*/1);
+
+    for (int b = 0; b < n_batch; ++b) {
+      product_scaling_factors[b] =
+          scaling_factors[b] * input_to_cell_weights_scale;
+    }
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        input_to_cell_weights_ptr, n_cell, n_input, quantized_input_ptr_batch,
+        product_scaling_factors, n_batch, cell_scratch, /*result_stride=*/1);
+
+    for (int b = 0; b < n_batch; ++b) {
+      product_scaling_factors[b] =
+          scaling_factors[b] * input_to_output_weights_scale;
+    }
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        input_to_output_weights_ptr, n_cell, n_input, quantized_input_ptr_batch,
+        product_scaling_factors, n_batch, output_gate_scratch,
+        /*result_stride=*/1);
+  }
+
+  if (aux_input_ptr_batch != nullptr &&
+      !tensor_utils::IsZeroVector(aux_input_ptr_batch, n_batch * n_aux_input)) {
+    // Save quantization and matmul computation for all zero input.
+    float unused_min, unused_max;
+    for (int b = 0; b < n_batch; ++b) {
+      const int offset = b * n_aux_input;
+      tensor_utils::SymmetricQuantizeFloats(
+          aux_input_ptr_batch + offset, n_aux_input,
+          quantized_aux_input_ptr_batch + offset, &unused_min, &unused_max,
+          &scaling_factors[b]);
+    }
+    // For each batch and cell: compute input_weight * input.
+    if (!use_cifg) {
+      for (int b = 0; b < n_batch; ++b) {
+        product_scaling_factors[b] =
+            scaling_factors[b] * aux_input_to_input_weights_scale;
+      }
+      tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+          aux_input_to_input_weights_ptr, n_cell, n_aux_input,
+          quantized_aux_input_ptr_batch, product_scaling_factors, n_batch,
+          input_gate_scratch, /*result_stride=*/1);
+    }
+
+    for (int b = 0; b < n_batch; ++b) {
+      product_scaling_factors[b] =
+          scaling_factors[b] * aux_input_to_forget_weights_scale;
+    }
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        aux_input_to_forget_weights_ptr, n_cell, n_aux_input,
+        quantized_aux_input_ptr_batch, product_scaling_factors, n_batch,
+        forget_gate_scratch, /*result_stride=*/1);
+
+    for (int b = 0; b < n_batch; ++b) {
+      product_scaling_factors[b] =
+          scaling_factors[b] * aux_input_to_cell_weights_scale;
+    }
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        aux_input_to_cell_weights_ptr, n_cell, n_aux_input,
+        quantized_aux_input_ptr_batch, product_scaling_factors, n_batch,
+        cell_scratch, /*result_stride=*/1);
+
+    for (int b = 0; b < n_batch; ++b) {
+      product_scaling_factors[b] =
+          scaling_factors[b] * aux_input_to_output_weights_scale;
+    }
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        aux_input_to_output_weights_ptr, n_cell, n_aux_input,
+        quantized_aux_input_ptr_batch, product_scaling_factors, n_batch,
+        output_gate_scratch, /*result_stride=*/1);
+  }
+}
+
+// Performs an LSTM batch inference step for input specified by input_ptr_batch.
+// The LSTM cell is specified by the pointers to its weights (*_weights_ptr) and
+// biases (*_bias_ptr), and buffers (*_scratch), along with additional
+// parameters:
+//  - params: various LSTM params including activation, clipping, etc.,
+//  - n_batch: size of batch,
+//  - n_cell: number of cells (or units),
+//  - n_input: the input size,
+//  - n_output: the output size.
+//  - output_batch_leading_dim: the leading dimension of the output buffer.
+//  - precomputed_gate_inputs: whether CalculateLstmGateInputs() has already
+//    filled in the gate scratch buffers for this step, in which case
+//    input_ptr_batch and aux_input_ptr_batch are not read.
+//
+// The pointers to the cell and output state and the output are updated.
+//
+// The pointers with the suffix "_batch" point to data aligned in batch_major
+// order, and each step processes batch_size many inputs from input_ptr_batch,
+// and updates batch_size many cell and output states.
+//
+// The output_batch_dim is output.shape[-1], i.e. the outermost dimension of the
+// output tensor, and in most cases will be equal to n_output. It is usually not
+// when we want to store the LSTM output into a slice of the output tensor, e.g.
+// for bidirectional LSTMs with merge_outputs. In this case, the batched
+// operations cannot be used since they assume that the batched outputs are
+// contiguous, and we manually loop over the batched outputs.
+inline void LstmStepWithAuxInput(
+    const float* input_ptr_batch, const float* input_to_input_weights_ptr,
+    const float* input_to_forget_weights_ptr,
+    const float* input_to_cell_weights_ptr,
+    const float* input_to_output_weights_ptr, const float* aux_input_ptr_batch,
+    const float* aux_input_to_input_weights_ptr,
+    const float* aux_input_to_forget_weights_ptr,
+    const float* aux_input_to_cell_weights_ptr,
+    const float* aux_input_to_output_weights_ptr,
+    const float* recurrent_to_input_weights_ptr,
+    const float* recurrent_to_forget_weights_ptr,
+    const float* recurrent_to_cell_weights_ptr,
+    const float* recurrent_to_output_weights_ptr,
+    const float* cell_to_input_weights_ptr,
+    const float* cell_to_forget_weights_ptr,
+    const float* cell_to_output_weights_ptr, const float* input_gate_bias_ptr,
+    const float* forget_gate_bias_ptr, const float* cell_bias_ptr,
+    const float* output_gate_bias_ptr, const float* projection_weights_ptr,
+    const float* projection_bias_ptr, const TfLiteLSTMParams* params,
+    bool precomputed_gate_inputs, int n_batch, int n_cell, int n_input,
+    int n_aux_input, int n_output, int output_batch_leading_dim,
+    float* output_state_ptr, float* cell_state_ptr, float* input_gate_scratch,
+    float* forget_gate_scratch, float* cell_scratch, float* output_gate_scratch,
+    float* output_ptr_batch) {
+  // Since we have already checked that weights are all there or none, we can
+  // check the existense of only one to the get the condition.
+  const bool use_cifg = (input_to_input_weights_ptr == nullptr);
+  const bool use_peephole = (cell_to_output_weights_ptr != nullptr);
+  if (!precomputed_gate_inputs) {
+    CalculateLstmGateInputs(
+        input_ptr_batch, input_to_input_weights_ptr,
+        input_to_forget_weights_ptr, input_to_cell_weights_ptr,
+        input_to_output_weights_ptr, aux_input_ptr_batch,
+        aux_input_to_input_weights_ptr, aux_input_to_forget_weights_ptr,
+        aux_input_to_cell_weights_ptr, aux_input_to_output_weights_ptr,
+        input_gate_bias_ptr, forget_gate_bias_ptr, cell_bias_ptr,
+        output_gate_bias_ptr, n_batch, n_cell, n_input, n_aux_input,
+        input_gate_scratch, forget_gate_scratch, cell_scratch,
+        output_gate_scratch);
+  }
 
   // For each batch and cell: compute recurrent_weight * output_state.
   if (!use_cifg) {
@@ -348,9 +525,10 @@ inline void LstmStepWithAuxInput(
     const float* forget_gate_bias_ptr, const float* cell_bias_ptr,
     const float* output_gate_bias_ptr, const int8_t* projection_weights_ptr,
     float projection_weights_scale, const float* projection_bias_ptr,
-    const TfLiteLSTMParams* params, int n_batch, int n_cell, int n_input,
-    int n_aux_input, int n_output, int output_batch_leading_dim,
-    float* input_gate_scratch, float* forget_gate_scratch, float* cell_scratch,
+    const TfLiteLSTMParams* params, bool precomputed_gate_inputs, int n_batch,
+    int n_cell, int n_input, int n_aux_input, int n_output,
+    int output_batch_leading_dim, float* input_gate_scratch,
+    float* forget_gate_scratch, float* cell_scratch,
     float* output_gate_scratch, float* scaling_factors,
     float* product_scaling_factors, float* recovered_cell_weights,
     int8_t* quantized_input_ptr_batch, int8_t* quantized_aux_input_ptr_batch,
@@ -360,115 +538,22 @@ inline void LstmStepWithAuxInput(
   // can check the existense of only one to the get the condition.
   const bool use_cifg = (input_to_input_weights_ptr == nullptr);
   const bool use_peephole = (cell_to_output_weights_ptr != nullptr);
-  // Initialize scratch buffers with bias.
-  if (!use_cifg) {
-    tensor_utils::VectorBatchVectorAssign(input_gate_bias_ptr, n_cell, n_batch,
-                                          input_gate_scratch);
-  }
-  tensor_utils::VectorBatchVectorAssign(forget_gate_bias_ptr, n_cell, n_batch,
-                                        forget_gate_scratch);
-  tensor_utils::VectorBatchVectorAssign(cell_bias_ptr, n_cell, n_batch,
-                                        cell_scratch);
-  tensor_utils::VectorBatchVectorAssign(output_gate_bias_ptr, n_cell, n_batch,
-                                        output_gate_scratch);
-
-  if (!tensor_utils::IsZeroVector(input_ptr_batch, n_batch * n_input)) {
-    // Save quantization and matmul computation for all zero input.
-    float unused_min, unused_max;
-    for (int b = 0; b < n_batch; ++b) {
-      const int offset = b * n_input;
-      tensor_utils::SymmetricQuantizeFloats(
-          input_ptr_batch + offset, n_input, quantized_input_ptr_batch + offset,
-          &unused_min, &unused_max, &scaling_factors[b]);
-    }
-    // For each batch and cell: compute input_weight * input.
-    if (!use_cifg) {
-      for (int b = 0; b < n_batch; ++b) {
-        product_scaling_factors[b] =
-            scaling_factors[b] * input_to_input_weights_scale;
-      }
-      tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-          input_to_input_weights_ptr, n_cell, n_input,
-          quantized_input_ptr_batch, product_scaling_factors, n_batch,
-          input_gate_scratch, /*result_stride=*/1);
-    }
-
-    for (int b = 0; b < n_batch; ++b) {
-      product_scaling_factors[b] =
-          scaling_factors[b] * input_to_forget_weights_scale;
-    }
-    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-        input_to_forget_weights_ptr, n_cell, n_input, quantized_input_ptr_batch,
-        product_scaling_factors, n_batch, forget_gate_scratch,
-        /*result_stride=*/1);
-
-    for (int b = 0; b < n_batch; ++b) {
-      product_scaling_factors[b] =
-          scaling_factors[b] * input_to_cell_weights_scale;
-    }
-    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-        input_to_cell_weights_ptr, n_cell, n_input, quantized_input_ptr_batch,
-        product_scaling_factors, n_batch, cell_scratch, /*result_stride=*/1);
-
-    for (int b = 0; b < n_batch; ++b) {
-      product_scaling_factors[b] =
-          scaling_factors[b] * input_to_output_weights_scale;
-    }
-    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-        input_to_output_weights_ptr, n_cell, n_input, quantized_input_ptr_batch,
-        product_scaling_factors, n_batch, output_gate_scratch,
-        /*result_stride=*/1);
-  }
-
-  if (aux_input_ptr_batch != nullptr &&
-      !tensor_utils::IsZeroVector(aux_input_ptr_batch, n_batch * n_input)) {
-    // Save quantization and matmul computation for all zero input.
-    float unused_min, unused_max;
-    for (int b = 0; b < n_batch; ++b) {
-      const int offset = b * n_input;
-      tensor_utils::SymmetricQuantizeFloats(
-          aux_input_ptr_batch + offset, n_input,
-          quantized_aux_input_ptr_batch + offset, &unused_min, &unused_max,
-          &scaling_factors[b]);
-    }
-    // For each batch and cell: compute input_weight * input.
-    if (!use_cifg) {
-      for (int b = 0; b < n_batch; ++b) {
-        product_scaling_factors[b] =
-            scaling_factors[b] * aux_input_to_input_weights_scale;
-      }
-      tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-          aux_input_to_input_weights_ptr, n_cell, n_input,
-          quantized_aux_input_ptr_batch, product_scaling_factors, n_batch,
-          input_gate_scratch, /*result_stride=*/1);
-    }
-
-    for (int b = 0; b < n_batch; ++b) {
-      product_scaling_factors[b] =
-          scaling_factors[b] * aux_input_to_forget_weights_scale;
-    }
-    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-        aux_input_to_forget_weights_ptr, n_cell, n_input,
-        quantized_aux_input_ptr_batch, product_scaling_factors, n_batch,
-        forget_gate_scratch, /*result_stride=*/1);
-
-    for (int b = 0; b < n_batch; ++b) {
-      product_scaling_factors[b] =
-          scaling_factors[b] * aux_input_to_cell_weights_scale;
-    }
-    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-        aux_input_to_cell_weights_ptr, n_cell, n_input,
-        quantized_aux_input_ptr_batch, product_scaling_factors, n_batch,
-        cell_scratch, /*result_stride=*/1);
-
-    for (int b = 0; b < n_batch; ++b) {
-      product_scaling_factors[b] =
-          scaling_factors[b] * aux_input_to_output_weights_scale;
-    }
-    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-        aux_input_to_output_weights_ptr, n_cell, n_input,
-        quantized_aux_input_ptr_batch, product_scaling_factors, n_batch,
-        output_gate_scratch, /*result_stride=*/1);
+  if (!precomputed_gate_inputs) {
+    CalculateLstmGateInputs(
+        input_ptr_batch, input_to_input_weights_ptr,
+        input_to_input_weights_scale, input_to_forget_weights_ptr,
+        input_to_forget_weights_scale, input_to_cell_weights_ptr,
+        input_to_cell_weights_scale, input_to_output_weights_ptr,
+        input_to_output_weights_scale, aux_input_ptr_batch,
+        aux_input_to_input_weights_ptr, aux_input_to_input_weights_scale,
+        aux_input_to_forget_weights_ptr, aux_input_to_forget_weights_scale,
+        aux_input_to_cell_weights_ptr, aux_input_to_cell_weights_scale,
+        aux_input_to_output_weights_ptr, aux_input_to_output_weights_scale,
+        input_gate_bias_ptr, forget_gate_bias_ptr, cell_bias_ptr,
+        output_gate_bias_ptr, n_batch, n_cell, n_input, n_aux_input,
+        input_gate_scratch, forget_gate_scratch, cell_scratch,
+        output_gate_scratch, scaling_factors, product_scaling_factors,
+        quantized_input_ptr_batch, quantized_aux_input_ptr_batch);
   }
 
   if (!tensor_utils::IsZeroVector(output_state_ptr, n_batch * n_output)) {
@@ -689,6 +774,18 @@ inline void LstmStepWithAuxInput(
     }
   }
 }
+
+// Returns true if the gate inputs of all the steps of a time-major sequence
+// can be computed up front, i.e. the scratch buffer has room for the gates of
+// max_time * n_batch rows rather than just n_batch.
+bool CanPrecomputeGateInputs(bool time_major, int max_time, int n_batch,
+                             int n_cell, bool use_cifg,
+                             const TfLiteTensor* scratch_buffer) {
+  if (!time_major || max_time <= 1) return false;
+  const int n_gates = use_cifg ? 3 : 4;
+  return scratch_buffer->bytes >=
+         sizeof(float) * n_gates * n_cell * n_batch * max_time;
+}
 }  // namespace
 
 TfLiteStatus EvalFloat(
@@ -736,6 +833,13 @@ TfLiteStatus EvalFloat(
   const bool use_cifg = (input_to_input_weights == nullptr);
   const bool use_peephole = (cell_to_output_weights != nullptr);
 
+  // If the scratch buffer has room for the gates of every step, the input
+  // projections of the whole sequence are computed before the recurrence.
+  const bool precompute_gate_inputs = CanPrecomputeGateInputs(
+      time_major, max_time, n_batch, n_cell, use_cifg, scratch_buffer);
+  const int scratch_rows =
+      precompute_gate_inputs ? max_time * n_batch : n_batch;
+
   // Index the scratch buffers pointers to the global scratch buffer.
   float* input_gate_scratch = nullptr;
   float* cell_scratch = nullptr;
@@ -743,13 +847,13 @@ TfLiteStatus EvalFloat(
   float* output_gate_scratch = nullptr;
   if (use_cifg) {
     cell_scratch = scratch_buffer->data.f;
-    forget_gate_scratch = scratch_buffer->data.f + n_cell * n_batch;
-    output_gate_scratch = scratch_buffer->data.f + 2 * n_cell * n_batch;
+    forget_gate_scratch = scratch_buffer->data.f + n_cell * scratch_rows;
+    output_gate_scratch = scratch_buffer->data.f + 2 * n_cell * scratch_rows;
   } else {
     input_gate_scratch = scratch_buffer->data.f;
-    cell_scratch = scratch_buffer->data.f + n_cell * n_batch;
-    forget_gate_scratch = scratch_buffer->data.f + 2 * n_cell * n_batch;
-    output_gate_scratch = scratch_buffer->data.f + 3 * n_cell * n_batch;
+    cell_scratch = scratch_buffer->data.f + n_cell * scratch_rows;
+    forget_gate_scratch = scratch_buffer->data.f + 2 * n_cell * scratch_rows;
+    output_gate_scratch = scratch_buffer->data.f + 3 * n_cell * scratch_rows;
   }
 
   // Check optional tensors, the respective pointers can be null.
@@ -787,6 +891,19 @@ TfLiteStatus EvalFloat(
   const int output_batch_leading_dim =
       output->dims->data[output->dims->size - 1];
   if (time_major) {
+    if (precompute_gate_inputs) {
+      CalculateLstmGateInputs(
+          input->data.f, input_to_input_weights_ptr,
+          input_to_forget_weights->data.f, input_to_cell_weights->data.f,
+          input_to_output_weights->data.f,
+          aux_input ? aux_input->data.f : nullptr,
+          aux_input_to_input_weights_ptr, aux_input_to_forget_weights_ptr,
+          aux_input_to_cell_weights_ptr, aux_input_to_output_weights_ptr,
+          input_gate_bias_ptr, forget_gate_bias->data.f, cell_bias->data.f,
+          output_gate_bias->data.f, max_time * n_batch, n_cell, n_input,
+          aux_input_size, input_gate_scratch, forget_gate_scratch,
+          cell_scratch, output_gate_scratch);
+    }
     // Loop through the sequence.
     const int input_step = n_batch * n_input;
     const int output_step = n_batch * output_batch_leading_dim;
@@ -800,6 +917,8 @@ TfLiteStatus EvalFloat(
       }
       float* output_ptr_time =
           output->data.f + t_rel * output_step + output_offset;
+      const int gate_offset =
+          precompute_gate_inputs ? t_rel * n_batch * n_cell : 0;
 
       LstmStepWithAuxInput(
           input_ptr, input_to_input_weights_ptr,
@@ -813,10 +932,12 @@ TfLiteStatus EvalFloat(
           cell_to_forget_weights_ptr, cell_to_output_weights_ptr,
           input_gate_bias_ptr, forget_gate_bias->data.f, cell_bias->data.f,
           output_gate_bias->data.f, projection_weights_ptr, projection_bias_ptr,
-          params, n_batch, n_cell, n_input, aux_input_size, n_output,
-          output_batch_leading_dim, activation_state->data.f,
-          cell_state->data.f, input_gate_scratch, forget_gate_scratch,
-          cell_scratch, output_gate_scratch, output_ptr_time);
+          params, precompute_gate_inputs, n_batch, n_cell, n_input,
+          aux_input_size, n_output, output_batch_leading_dim,
+          activation_state->data.f, cell_state->data.f,
+          use_cifg ? nullptr : input_gate_scratch + gate_offset,
+          forget_gate_scratch + gate_offset, cell_scratch + gate_offset,
+          output_gate_scratch + gate_offset, output_ptr_time);
     }
   } else {
     for (int b = 0; b < n_batch; b++) {
@@ -845,11 +966,11 @@ TfLiteStatus EvalFloat(
             cell_to_forget_weights_ptr, cell_to_output_weights_ptr,
             input_gate_bias_ptr, forget_gate_bias->data.f, cell_bias->data.f,
             output_gate_bias->data.f, projection_weights_ptr,
-            projection_bias_ptr, params, /*n_batch=*/1, n_cell, n_input,
-            aux_input_size, n_output, output_batch_leading_dim,
-            activation_state->data.f, cell_state->data.f, input_gate_scratch,
-            forget_gate_scratch, cell_scratch, output_gate_scratch,
-            output_ptr_time);
+            projection_bias_ptr, params, /*precomputed_gate_inputs=*/false,
+            /*n_batch=*/1, n_cell, n_input, aux_input_size, n_output,
+            output_batch_leading_dim, activation_state->data.f,
+            cell_state->data.f, input_gate_scratch, forget_gate_scratch,
+            cell_scratch, output_gate_scratch, output_ptr_time);
       }
     }
   }
@@ -903,19 +1024,30 @@ TfLiteStatus EvalHybrid(
   const bool use_cifg = (input_to_input_weights == nullptr);
   const bool use_peephole = (cell_to_output_weights != nullptr);
 
+  // The input projections of the whole sequence are computed before the
+  // recurrence if the scratch buffer has room for the gates of every step and
+  // the scaling factors have room for every input row.
+  const bool precompute_gate_inputs =
+      CanPrecomputeGateInputs(time_major, max_time, n_batch, n_cell, use_cifg,
+                              scratch_buffer) &&
+      scaling_factors->bytes >= sizeof(float) * max_time * n_batch &&
+      prod_scaling_factors->bytes >= sizeof(float) * max_time * n_batch;
+  const int scratch_rows =
+      precompute_gate_inputs ? max_time * n_batch : n_batch;
+
   float* input_gate_scratch = nullptr;
   float* cell_scratch = nullptr;
   float* forget_gate_scratch = nullptr;
   float* output_gate_scratch = nullptr;
   if (use_cifg) {
     cell_scratch = scratch_buffer->data.f;
-    forget_gate_scratch = scratch_buffer->data.f + n_cell * n_batch;
-    output_gate_scratch = scratch_buffer->data.f + 2 * n_cell * n_batch;
+    forget_gate_scratch = scratch_buffer->data.f + n_cell * scratch_rows;
+    output_gate_scratch = scratch_buffer->data.f + 2 * n_cell * scratch_rows;
   } else {
     input_gate_scratch = scratch_buffer->data.f;
-    cell_scratch = scratch_buffer->data.f + n_cell * n_batch;
-    forget_gate_scratch = scratch_buffer->data.f + 2 * n_cell * n_batch;
-    output_gate_scratch = scratch_buffer->data.f + 3 * n_cell * n_batch;
+    cell_scratch = scratch_buffer->data.f + n_cell * scratch_rows;
+    forget_gate_scratch = scratch_buffer->data.f + 2 * n_cell * scratch_rows;
+    output_gate_scratch = scratch_buffer->data.f + 3 * n_cell * scratch_rows;
   }
 
   // Check optional tensors, the respective pointers can be null.
@@ -1044,6 +1176,27 @@ TfLiteStatus EvalHybrid(
   const int output_batch_leading_dim =
       output->dims->data[output->dims->size - 1];
   if (time_major) {
+    if (precompute_gate_inputs) {
+      // The quantized inputs of the whole sequence are kept, so the quantized
+      // input buffers must be as large as the inputs.
+      CalculateLstmGateInputs(
+          input->data.f, input_to_input_weights_ptr,
+          input_to_input_weights_scale, input_to_forget_weights_ptr,
+          input_to_forget_weights_scale, input_to_cell_weights_ptr,
+          input_to_cell_weights_scale, input_to_output_weights_ptr,
+          input_to_output_weights_scale,
+          aux_input ? aux_input->data.f : nullptr,
+          aux_input_to_input_weights_ptr, aux_input_to_input_weights_scale,
+          aux_input_to_forget_weights_ptr, aux_input_to_forget_weights_scale,
+          aux_input_to_cell_weights_ptr, aux_input_to_cell_weights_scale,
+          aux_input_to_output_weights_ptr, aux_input_to_output_weights_scale,
+          input_gate_bias_ptr, forget_gate_bias_ptr, cell_bias_ptr,
+          output_gate_bias_ptr, max_time * n_batch, n_cell, n_input,
+          aux_input_size, input_gate_scratch, forget_gate_scratch,
+          cell_scratch, output_gate_scratch, scaling_factors_ptr,
+          prod_scaling_factors_ptr, quantized_input_ptr,
+          quantized_aux_input_ptr);
+    }
     // Feed the sequence into the LSTM step-by-step.
     const int input_step = n_batch * n_input;
     const int output_step = n_batch * output_batch_leading_dim;
@@ -1056,6 +1209,8 @@ TfLiteStatus EvalHybrid(
         aux_input_ptr = aux_input->data.f + t_rel * input_step;
       }
       float* output_ptr = output->data.f + t_rel * output_step + output_offset;
+      const int gate_offset =
+          precompute_gate_inputs ? t_rel * n_batch * n_cell : 0;
 
       LstmStepWithAuxInput(
           input_ptr, input_to_input_weights_ptr, input_to_input_weights_scale,
@@ -1076,9 +1231,11 @@ TfLiteStatus EvalHybrid(
           cell_to_output_weights_scale, input_gate_bias_ptr,
           forget_gate_bias_ptr, cell_bias_ptr, output_gate_bias_ptr,
           projection_weights_ptr, projection_weights_scale, projection_bias_ptr,
-          params, n_batch, n_cell, n_input, aux_input_size, n_output,
-          output_batch_leading_dim, input_gate_scratch, forget_gate_scratch,
-          cell_scratch, output_gate_scratch, scaling_factors_ptr,
+          params, precompute_gate_inputs, n_batch, n_cell, n_input,
+          aux_input_size, n_output, output_batch_leading_dim,
+          use_cifg ? nullptr : input_gate_scratch + gate_offset,
+          forget_gate_scratch + gate_offset, cell_scratch + gate_offset,
+          output_gate_scratch + gate_offset, scaling_factors_ptr,
           prod_scaling_factors_ptr, recovered_cell_weights_ptr,
           quantized_input_ptr, quantized_aux_input_ptr,
           quantized_output_state_ptr, quantized_cell_state_ptr,
@@ -1118,14 +1275,14 @@ TfLiteStatus EvalHybrid(
             cell_to_output_weights_scale, input_gate_bias_ptr,
             forget_gate_bias_ptr, cell_bias_ptr, output_gate_bias_ptr,
             projection_weights_ptr, projection_weights_scale,
-            projection_bias_ptr, params, n_batch, n_cell, n_input,
-            aux_input_size, n_output, output_batch_leading_dim,
-            input_gate_scratch, forget_gate_scratch, cell_scratch,
-            output_gate_scratch, scaling_factors_ptr, prod_scaling_factors_ptr,
-            recovered_cell_weights_ptr, quantized_input_ptr,
-            quantized_aux_input_ptr, quantized_output_state_ptr,
-            quantized_cell_state_ptr, output_state_ptr, cell_state_ptr,
-            output_ptr);
+            projection_bias_ptr, params, /*precomputed_gate_inputs=*/false,
+            n_batch, n_cell, n_input, aux_input_size, n_output,
+            output_batch_leading_dim, input_gate_scratch, forget_gate_scratch,
+            cell_scratch, output_gate_scratch, scaling_factors_ptr,
+            prod_scaling_factors_ptr, recovered_cell_weights_ptr,
+            quantized_input_ptr, quantized_aux_input_ptr,
+            quantized_output_state_ptr, quantized_cell_state_ptr,
+            output_state_ptr, cell_state_ptr, output_ptr);
       }
     }
   }
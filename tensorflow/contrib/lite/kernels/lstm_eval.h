@@ -23,6 +23,12 @@ namespace ops {
 namespace builtin {
 namespace lstm_eval {
 
+// Evaluates an LSTM over a sequence, one step at a time. `scratch_buffer`
+// holds the gates of n_batch rows. If the input is time-major and the buffer
+// has room for max_time * n_batch rows instead, the bias and input
+// projections of every step are computed before the recurrence with one
+// matrix multiplication per gate, and each step only adds the recurrent and
+// peephole terms.
 TfLiteStatus EvalFloat(
     const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
     const TfLiteTensor* input_to_forget_weights,
@@ -47,6 +53,9 @@ TfLiteStatus EvalFloat(
     TfLiteTensor* activation_state, TfLiteTensor* cell_state,
     TfLiteTensor* output);
 
+// Same as above but with quantized weights. The input projections are only
+// precomputed if `scaling_factors` and `prod_scaling_factors` also have room
+// for max_time * n_batch values.
 TfLiteStatus EvalHybrid(
     const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
     const TfLiteTensor* input_to_forget_weights,
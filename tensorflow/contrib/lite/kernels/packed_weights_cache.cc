@@ -0,0 +1,83 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/kernels/packed_weights_cache.h"
+
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace tflite {
+namespace packed_weights_cache {
+namespace {
+
+typedef std::tuple<const void*, size_t, Layout, size_t> Key;
+
+struct Cache {
+  std::mutex mutex;
+  // Entries expire when the last op using them lets go; they are swept on
+  // the next insertion.
+  std::map<Key, std::weak_ptr<const void>> entries;
+};
+
+Cache* GetCache() {
+  static Cache* cache = new Cache;
+  return cache;
+}
+
+}  // namespace
+
+std::shared_ptr<const void> GetOrPack(
+    const void* source, size_t source_size, Layout layout, size_t packed_size,
+    const std::function<void(void* packed)>& pack) {
+  Cache* cache = GetCache();
+  const Key key(source, source_size, layout, packed_size);
+  // Packing happens under the lock so that interpreters preparing the same
+  // model concurrently don't pack the same weights twice. It is a one-time
+  // cost per model.
+  std::lock_guard<std::mutex> lock(cache->mutex);
+  auto it = cache->entries.find(key);
+  if (it != cache->entries.end()) {
+    std::shared_ptr<const void> packed = it->second.lock();
+    if (packed) return packed;
+  }
+
+  for (auto entry = cache->entries.begin(); entry != cache->entries.end();) {
+    if (entry->second.expired()) {
+      entry = cache->entries.erase(entry);
+    } else {
+      ++entry;
+    }
+  }
+
+  std::shared_ptr<char> buffer(new char[packed_size],
+                               std::default_delete<char[]>());
+  pack(buffer.get());
+  std::shared_ptr<const void> packed = buffer;
+  cache->entries[key] = packed;
+  return packed;
+}
+
+int NumLiveEntries() {
+  Cache* cache = GetCache();
+  std::lock_guard<std::mutex> lock(cache->mutex);
+  int num_live = 0;
+  for (const auto& entry : cache->entries) {
+    if (!entry.second.expired()) ++num_live;
+  }
+  return num_live;
+}
+
+}  // namespace packed_weights_cache
+}  // namespace tflite
@@ -0,0 +1,53 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CONTRIB_LITE_KERNELS_PACKED_WEIGHTS_CACHE_H_
+#define TENSORFLOW_CONTRIB_LITE_KERNELS_PACKED_WEIGHTS_CACHE_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace tflite {
+namespace packed_weights_cache {
+
+// Layouts that ops repack read-only weights into. Part of the cache key, so
+// that different repackings of the same weights don't collide.
+enum class Layout {
+  // A [rows, cols] float matrix transposed into [cols, rows].
+  kTransposedFloatMatrix,
+  // A float matrix with its all-zero blocks dropped, as taken by
+  // tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate.
+  kBlockSparseFloatMatrix,
+};
+
+// Returns a `packed_size`-byte buffer holding the weights at `source`, of
+// `source_size` bytes, repacked into `layout`. The first request for a given
+// source fills the buffer by calling `pack`; later ones share it, across ops
+// and interpreters, for as long as any caller holds on to the result.
+//
+// This is meant for kTfLiteMmapRo tensors, whose data lives in the model and
+// is shared by all interpreters built from it. The source must not be modified
+// while any packed copy of it is alive. Thread-safe.
+std::shared_ptr<const void> GetOrPack(
+    const void* source, size_t source_size, Layout layout, size_t packed_size,
+    const std::function<void(void* packed)>& pack);
+
+// Returns the number of packed buffers alive. Intended for tests.
+int NumLiveEntries();
+
+}  // namespace packed_weights_cache
+}  // namespace tflite
+
+#endif  // TENSORFLOW_CONTRIB_LITE_KERNELS_PACKED_WEIGHTS_CACHE_H_
@@ -0,0 +1,94 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/kernels/packed_weights_cache.h"
+
+#include <cstring>
+
+#include <gtest/gtest.h>
+#include "tensorflow/contrib/lite/testing/util.h"
+
+namespace tflite {
+namespace packed_weights_cache {
+namespace {
+
+// Packs by copying `source` and counting the calls in `*num_packs`.
+std::function<void(void*)> CopyPacker(const float* source, int size,
+                                      int* num_packs) {
+  return [source, size, num_packs](void* packed) {
+    std::memcpy(packed, source, size * sizeof(float));
+    ++*num_packs;
+  };
+}
+
+TEST(PackedWeightsCacheTest, SharesPackedWeights) {
+  const float weights[] = {1, 2, 3, 4};
+  const size_t size = sizeof(weights);
+  int num_packs = 0;
+  std::shared_ptr<const void> first =
+      GetOrPack(weights, size, Layout::kTransposedFloatMatrix, size,
+                CopyPacker(weights, 4, &num_packs));
+  std::shared_ptr<const void> second =
+      GetOrPack(weights, size, Layout::kTransposedFloatMatrix, size,
+                CopyPacker(weights, 4, &num_packs));
+  EXPECT_EQ(num_packs, 1);
+  EXPECT_EQ(first.get(), second.get());
+  EXPECT_EQ(static_cast<const float*>(first.get())[3], 4);
+  EXPECT_EQ(NumLiveEntries(), 1);
+}
+
+TEST(PackedWeightsCacheTest, KeysOnSourceAndSize) {
+  const float weights[] = {1, 2, 3, 4};
+  int num_packs = 0;
+  std::shared_ptr<const void> whole = GetOrPack(
+      weights, sizeof(weights), Layout::kTransposedFloatMatrix,
+      sizeof(weights), CopyPacker(weights, 4, &num_packs));
+  std::shared_ptr<const void> half = GetOrPack(
+      weights, sizeof(weights) / 2, Layout::kTransposedFloatMatrix,
+      sizeof(weights) / 2, CopyPacker(weights, 2, &num_packs));
+  std::shared_ptr<const void> tail = GetOrPack(
+      weights + 2, sizeof(weights) / 2, Layout::kTransposedFloatMatrix,
+      sizeof(weights) / 2, CopyPacker(weights + 2, 2, &num_packs));
+  EXPECT_EQ(num_packs, 3);
+  EXPECT_NE(whole.get(), half.get());
+  EXPECT_NE(half.get(), tail.get());
+  EXPECT_EQ(static_cast<const float*>(tail.get())[0], 3);
+}
+
+TEST(PackedWeightsCacheTest, RepacksAfterRelease) {
+  const float weights[] = {1, 2, 3, 4};
+  const size_t size = sizeof(weights);
+  int num_packs = 0;
+  std::shared_ptr<const void> packed =
+      GetOrPack(weights, size, Layout::kTransposedFloatMatrix, size,
+                CopyPacker(weights, 4, &num_packs));
+  EXPECT_EQ(NumLiveEntries(), 1);
+  packed.reset();
+  EXPECT_EQ(NumLiveEntries(), 0);
+
+  packed = GetOrPack(weights, size, Layout::kTransposedFloatMatrix, size,
+                     CopyPacker(weights, 4, &num_packs));
+  EXPECT_EQ(num_packs, 2);
+  EXPECT_EQ(NumLiveEntries(), 1);
+}
+
+}  // namespace
+}  // namespace packed_weights_cache
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
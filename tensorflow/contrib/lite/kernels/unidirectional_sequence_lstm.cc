@@ -264,6 +264,7 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       reinterpret_cast<TfLiteUnidirectionalSequenceLSTMParams*>(
           node->builtin_data);
   const bool time_major = params->time_major;
+  const int max_time = time_major ? input->dims->data[0] : input->dims->data[1];
   const int n_batch = time_major ? input->dims->data[1] : input->dims->data[0];
   const int n_input = input->dims->data[2];
 
@@ -325,8 +326,12 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   const TfLiteTensor* input_to_input_weights =
       GetOptionalInputTensor(context, node, kInputToInputWeightsTensor);
   const bool use_cifg = (input_to_input_weights == nullptr);
+  // For time-major inputs, the scratch buffer holds the gates of every step so
+  // that lstm_eval can compute the input projections of the whole sequence
+  // before the recurrence.
+  const int scratch_rows = time_major ? max_time * n_batch : n_batch;
   TfLiteIntArray* scratch_buffer_size = TfLiteIntArrayCreate(2);
-  scratch_buffer_size->data[0] = n_batch;
+  scratch_buffer_size->data[0] = scratch_rows;
   if (use_cifg) {
     // Reserving space for Cell, Forget, Output gates
     scratch_buffer_size->data[1] = n_cell * 3;
@@ -390,10 +395,12 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
         GetTemporary(context, node, kScalingFactors);
     scaling_factors->type = kTfLiteFloat32;
     scaling_factors->allocation_type = kTfLiteArenaRw;
-    int scaling_dims[1] = {n_batch};
+    // Like the scratch buffer, these have room for every step of time-major
+    // inputs.
+    int scaling_dims[1] = {scratch_rows};
     if (!TfLiteIntArrayEqualsArray(scaling_factors->dims, 1, scaling_dims)) {
       TfLiteIntArray* scaling_factors_size = TfLiteIntArrayCreate(1);
-      scaling_factors_size->data[0] = n_batch;
+      scaling_factors_size->data[0] = scratch_rows;
       TF_LITE_ENSURE_OK(context, context->ResizeTensor(context, scaling_factors,
                                                        scaling_factors_size));
     }
@@ -406,7 +413,7 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     if (!TfLiteIntArrayEqualsArray(prod_scaling_factors->dims, 1,
                                    scaling_dims)) {
       TfLiteIntArray* prod_scaling_factors_size = TfLiteIntArrayCreate(1);
-      prod_scaling_factors_size->data[0] = n_batch;
+      prod_scaling_factors_size->data[0] = scratch_rows;
       TF_LITE_ENSURE_OK(context,
                         context->ResizeTensor(context, prod_scaling_factors,
                                               prod_scaling_factors_size));
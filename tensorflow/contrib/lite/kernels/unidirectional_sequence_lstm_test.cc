@@ -1522,6 +1522,97 @@ TEST_F(NoCifgPeepholeProjectionClippingLstmTest, HybridLstmBlackBoxTest) {
   VerifyGoldens(lstm_input_, lstm_golden_output_, &lstm, /*tolerance=*/0.00467);
 }
 
+// Time-major inputs have the input projections of the whole sequence computed
+// before the recurrence, while batch-major inputs are evaluated one step at a
+// time. Both must produce the same outputs from the same quantized weights.
+TEST_F(NoCifgPeepholeProjectionClippingLstmTest,
+       HybridLstmPrecomputedMatchesPerStep) {
+  const int n_batch = 2;
+  const int n_input = 5;
+  const int n_cell = 20;
+  const int n_output = 16;
+  const int sequence_length = 4;
+
+  std::vector<std::unique_ptr<HybridUnidirectionalLSTMOpModel>> models;
+  for (const bool time_major : {false, true}) {
+    const std::vector<int> input_shape =
+        time_major ? std::vector<int>{sequence_length, n_batch, n_input}
+                   : std::vector<int>{n_batch, sequence_length, n_input};
+    models.emplace_back(new HybridUnidirectionalLSTMOpModel(
+        n_batch, n_input, n_cell, n_output, sequence_length, time_major,
+        /*use_cifg=*/false, /*use_peephole=*/true,
+        /*use_projection_weights=*/true,
+        /*use_projection_bias=*/false,
+        /*cell_clip=*/0.0, /*proj_clip=*/0.0,
+        {
+            input_shape,  // input tensor
+
+            {n_cell, n_input},  // input_to_input_weight tensor
+            {n_cell, n_input},  // input_to_forget_weight tensor
+            {n_cell, n_input},  // input_to_cell_weight tensor
+            {n_cell, n_input},  // input_to_output_weight tensor
+
+            {n_cell, n_output},  // recurrent_to_input_weight tensor
+            {n_cell, n_output},  // recurrent_to_forget_weight tensor
+            {n_cell, n_output},  // recurrent_to_cell_weight tensor
+            {n_cell, n_output},  // recurrent_to_output_weight tensor
+
+            {n_cell},  // cell_to_input_weight tensor
+            {n_cell},  // cell_to_forget_weight tensor
+            {n_cell},  // cell_to_output_weight tensor
+
+            {n_cell},  // input_gate_bias tensor
+            {n_cell},  // forget_gate_bias tensor
+            {n_cell},  // cell_bias tensor
+            {n_cell},  // output_gate_bias tensor
+
+            {n_output, n_cell},  // projection_weight tensor
+            {0},                 // projection_bias tensor
+
+            {n_batch, n_output},  // activation_state tensor
+            {n_batch, n_cell},    // cell_state tensor
+        }));
+    HybridUnidirectionalLSTMOpModel& lstm = *models.back();
+
+    lstm.SetInputToInputWeights(input_to_input_weights_);
+    lstm.SetInputToCellWeights(input_to_cell_weights_);
+    lstm.SetInputToForgetWeights(input_to_forget_weights_);
+    lstm.SetInputToOutputWeights(input_to_output_weights_);
+
+    lstm.SetInputGateBias(input_gate_bias_);
+    lstm.SetCellBias(cell_gate_bias_);
+    lstm.SetForgetGateBias(forget_gate_bias_);
+    lstm.SetOutputGateBias(output_gate_bias_);
+
+    lstm.SetRecurrentToInputWeights(recurrent_to_input_weights_);
+    lstm.SetRecurrentToCellWeights(recurrent_to_cell_weights_);
+    lstm.SetRecurrentToForgetWeights(recurrent_to_forget_weights_);
+    lstm.SetRecurrentToOutputWeights(recurrent_to_output_weights_);
+
+    lstm.SetCellToInputWeights(cell_to_input_weights_);
+    lstm.SetCellToForgetWeights(cell_to_forget_weights_);
+    lstm.SetCellToOutputWeights(cell_to_output_weights_);
+
+    lstm.SetProjectionWeights(projection_weights_);
+  }
+
+  // The per-step outputs are still close to the float goldens.
+  VerifyGoldens(lstm_input_, lstm_golden_output_, models[0].get(),
+                /*tolerance=*/0.00467, /*time_major=*/false);
+
+  // They are batch-major, so split them by batch to use them as the goldens
+  // of the time-major model.
+  const std::vector<float> per_step_output = models[0]->GetOutput();
+  const int batch_size = sequence_length * n_output;
+  std::vector<std::vector<float>> per_step_goldens;
+  for (int b = 0; b < n_batch; ++b) {
+    const auto batch_start = per_step_output.begin() + b * batch_size;
+    per_step_goldens.emplace_back(batch_start, batch_start + batch_size);
+  }
+  VerifyGoldens(lstm_input_, per_step_goldens, models[1].get(),
+                /*tolerance=*/1e-6);
+}
+
 }  // namespace
 }  // namespace tflite
 
@@ -165,6 +165,14 @@ enum {
   ANEURALNETWORKS_PREFER_SUSTAINED_SPEED = 2,
 };
 
+/**
+ * Size of the cache token of a compilation, see
+ * {@link ANeuralNetworksCompilation_setCaching}.
+ */
+enum {
+  ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN = 32,
+};
+
 /**
  * Result codes.
  */
@@ -349,6 +357,10 @@ typedef void (*ANeuralNetworksCompilation_free_fn)(
 typedef int (*ANeuralNetworksCompilation_setPreference_fn)(
     ANeuralNetworksCompilation* compilation, int32_t preference);
 
+typedef int (*ANeuralNetworksCompilation_setCaching_fn)(
+    ANeuralNetworksCompilation* compilation, const char* cacheDir,
+    const uint8_t* token);
+
 typedef int (*ANeuralNetworksCompilation_finish_fn)(
     ANeuralNetworksCompilation* compilation);
 
@@ -761,6 +773,32 @@ inline int ANeuralNetworksCompilation_setPreference(
   EXECUTE_FUNCTION_RETURN(compilation, preference);
 }
 
+/**
+ * Sets the compilation caching signature and the cache directory.
+ *
+ * <p>Provides optional caching information to the runtime for faster repeated
+ * compilation. The driver may store its compiled model in the cache
+ * directory, and load it instead of compiling a later compilation with the
+ * same token.</p>
+ *
+ * <p>Available since API level 29 (NNAPI 1.2).</p>
+ *
+ * @param compilation The compilation to be modified.
+ * @param cacheDir The cache directory for the runtime to store and retrieve
+ *                 caching data. It must not be shared between applications.
+ * @param token The token of ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN bytes
+ *              identifying the model. It must be unique to the model within
+ *              the application.
+ *
+ * @return ANEURALNETWORKS_NO_ERROR if successful.
+ */
+inline int ANeuralNetworksCompilation_setCaching(
+    ANeuralNetworksCompilation* compilation, const char* cacheDir,
+    const uint8_t* token) {
+  LOAD_FUNCTION(ANeuralNetworksCompilation_setCaching);
+  EXECUTE_FUNCTION_RETURN(compilation, cacheDir, token);
+}
+
 /**
  * Waits until the compilation completes.
  *
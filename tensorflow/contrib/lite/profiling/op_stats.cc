@@ -0,0 +1,116 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/profiling/op_stats.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+// Returns the nearest-rank `percentile` of the sorted `values`.
+int64_t Percentile(const std::vector<int64_t>& values, int percentile) {
+  const size_t rank = (values.size() * percentile + 99) / 100;
+  return values[rank == 0 ? 0 : rank - 1];
+}
+
+}  // namespace
+
+OpLatencyRecorder::OpLatencyRecorder(int window_size)
+    : window_size_(std::max(window_size, 1)) {}
+
+void OpLatencyRecorder::EnsureNodes(int num_nodes) {
+  if (static_cast<int>(latencies_.size()) < num_nodes) {
+    latencies_.resize(num_nodes, std::vector<int64_t>(NumSlots(), 0));
+  }
+}
+
+void OpLatencyRecorder::Record(int node_index, int64_t duration_us) {
+  if (node_index < 0 || node_index >= static_cast<int>(latencies_.size())) {
+    return;
+  }
+  latencies_[node_index][num_invocations_ % NumSlots()] = duration_us;
+}
+
+void OpLatencyRecorder::EndInvocation() {
+  ++num_invocations_;
+  // Clear the slot of the next invocation, in case it doesn't run every node.
+  const int slot = num_invocations_ % NumSlots();
+  for (std::vector<int64_t>& node_latencies : latencies_) {
+    node_latencies[slot] = 0;
+  }
+}
+
+int OpLatencyRecorder::NumInvocations() const {
+  return std::min<int64_t>(num_invocations_, window_size_);
+}
+
+std::vector<int64_t> OpLatencyRecorder::GetLatencies(int node_index) const {
+  std::vector<int64_t> latencies;
+  if (node_index < 0 || node_index >= static_cast<int>(latencies_.size())) {
+    return latencies;
+  }
+  const std::vector<int64_t>& node_latencies = latencies_[node_index];
+  const int current_slot = num_invocations_ % NumSlots();
+  for (int slot = 0; slot < NumSlots(); ++slot) {
+    if (slot == current_slot) continue;
+    // Until the window fills, only the slots before the current one are used.
+    if (num_invocations_ < window_size_ && slot > current_slot) continue;
+    latencies.push_back(node_latencies[slot]);
+  }
+  return latencies;
+}
+
+void ComputeLatencyStats(std::vector<int64_t> latencies, OpStats* stats) {
+  stats->count = latencies.size();
+  if (latencies.empty()) {
+    stats->mean_us = 0;
+    stats->p50_us = stats->p99_us = stats->max_us = 0;
+    return;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  int64_t sum = 0;
+  for (int64_t latency : latencies) sum += latency;
+  stats->mean_us = static_cast<double>(sum) / latencies.size();
+  stats->p50_us = Percentile(latencies, 50);
+  stats->p99_us = Percentile(latencies, 99);
+  stats->max_us = latencies.back();
+}
+
+std::string OpStatsToString(const std::vector<OpStats>& stats) {
+  std::string result;
+  char line[512];
+  snprintf(line, sizeof(line), "%-24s %6s %8s %10s %8s %8s %8s %12s  %s\n",
+           "[op type]", "[nodes]", "[count]", "[mean us]", "[p50 us]",
+           "[p99 us]", "[max us]", "[mem bytes]", "[name]");
+  result += line;
+  for (const OpStats& op_stats : stats) {
+    snprintf(line, sizeof(line),
+             "%-24s %6d %8lld %10.1f %8lld %8lld %8lld %12lld  %s\n",
+             op_stats.op_type.c_str(), op_stats.num_nodes,
+             static_cast<long long>(op_stats.count), op_stats.mean_us,
+             static_cast<long long>(op_stats.p50_us),
+             static_cast<long long>(op_stats.p99_us),
+             static_cast<long long>(op_stats.max_us),
+             static_cast<long long>(op_stats.memory_bytes),
+             op_stats.name.c_str());
+    result += line;
+  }
+  return result;
+}
+
+}  // namespace profiling
+}  // namespace tflite
@@ -0,0 +1,89 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CONTRIB_LITE_PROFILING_OP_STATS_H_
+#define TENSORFLOW_CONTRIB_LITE_PROFILING_OP_STATS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tflite {
+namespace profiling {
+
+// Latency and memory statistics of a node, or of all the nodes running one op
+// type, over a window of invocations. Latencies are in microseconds.
+struct OpStats {
+  // The outputs of the node, or the op type for per-type statistics.
+  std::string name;
+  std::string op_type;
+  // Number of nodes covered; always 1 for per-node statistics.
+  int num_nodes = 0;
+  // Number of invocations covered.
+  int64_t count = 0;
+  double mean_us = 0;
+  int64_t p50_us = 0;
+  int64_t p99_us = 0;
+  int64_t max_us = 0;
+  // Bytes of the outputs and temporaries of the nodes.
+  int64_t memory_bytes = 0;
+};
+
+// Keeps the latency of every node over the last `window_size` invocations.
+//
+// Record() may be called concurrently for different nodes; the other methods
+// must not run concurrently with anything else.
+class OpLatencyRecorder {
+ public:
+  explicit OpLatencyRecorder(int window_size);
+
+  int window_size() const { return window_size_; }
+
+  // Makes room for nodes [0, num_nodes).
+  void EnsureNodes(int num_nodes);
+
+  // Records the latency of `node_index` in the current invocation.
+  void Record(int node_index, int64_t duration_us);
+
+  // Completes the current invocation, which then replaces the oldest one in
+  // the window.
+  void EndInvocation();
+
+  // Returns the number of completed invocations in the window.
+  int NumInvocations() const;
+
+  // Returns the latency of `node_index` in each completed invocation of the
+  // window, or 0 for invocations that did not run it.
+  std::vector<int64_t> GetLatencies(int node_index) const;
+
+ private:
+  // One slot per invocation in the window, plus one for the current one.
+  int NumSlots() const { return window_size_ + 1; }
+
+  const int window_size_;
+  int64_t num_invocations_ = 0;
+  // Latencies of each node, indexed by invocation modulo NumSlots().
+  std::vector<std::vector<int64_t>> latencies_;
+};
+
+// Fills in the count and latency fields of `stats` from `latencies`.
+void ComputeLatencyStats(std::vector<int64_t> latencies, OpStats* stats);
+
+// Returns `stats` as a table with one row per entry.
+std::string OpStatsToString(const std::vector<OpStats>& stats);
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_CONTRIB_LITE_PROFILING_OP_STATS_H_
@@ -0,0 +1,94 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/profiling/op_stats.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/contrib/lite/testing/util.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::UnorderedElementsAre;
+
+TEST(OpLatencyRecorderTest, KeepsLastInvocations) {
+  OpLatencyRecorder recorder(/*window_size=*/2);
+  recorder.EnsureNodes(2);
+  EXPECT_EQ(recorder.NumInvocations(), 0);
+  EXPECT_THAT(recorder.GetLatencies(0), ElementsAre());
+
+  recorder.Record(0, 10);
+  recorder.Record(1, 100);
+  recorder.EndInvocation();
+  EXPECT_EQ(recorder.NumInvocations(), 1);
+  EXPECT_THAT(recorder.GetLatencies(0), ElementsAre(10));
+
+  recorder.Record(0, 20);
+  recorder.Record(1, 200);
+  recorder.EndInvocation();
+  recorder.Record(0, 30);
+  recorder.EndInvocation();
+  EXPECT_EQ(recorder.NumInvocations(), 2);
+  EXPECT_THAT(recorder.GetLatencies(0), UnorderedElementsAre(20, 30));
+  // Node 1 didn't run in the last invocation.
+  EXPECT_THAT(recorder.GetLatencies(1), UnorderedElementsAre(200, 0));
+  // Nodes out of range are ignored.
+  recorder.Record(2, 1);
+  EXPECT_THAT(recorder.GetLatencies(2), ElementsAre());
+}
+
+TEST(OpStatsTest, ComputeLatencyStats) {
+  std::vector<int64_t> latencies;
+  for (int i = 100; i > 0; --i) latencies.push_back(i);
+  OpStats stats;
+  ComputeLatencyStats(latencies, &stats);
+  EXPECT_EQ(stats.count, 100);
+  EXPECT_DOUBLE_EQ(stats.mean_us, 50.5);
+  EXPECT_EQ(stats.p50_us, 50);
+  EXPECT_EQ(stats.p99_us, 99);
+  EXPECT_EQ(stats.max_us, 100);
+
+  ComputeLatencyStats({7}, &stats);
+  EXPECT_EQ(stats.count, 1);
+  EXPECT_EQ(stats.p50_us, 7);
+  EXPECT_EQ(stats.p99_us, 7);
+}
+
+TEST(OpStatsTest, ToString) {
+  OpStats stats;
+  stats.name = "[conv_out]";
+  stats.op_type = "CONV_2D";
+  stats.num_nodes = 1;
+  stats.memory_bytes = 4096;
+  ComputeLatencyStats({5, 15}, &stats);
+  const std::string table = OpStatsToString({stats});
+  EXPECT_THAT(table, HasSubstr("[p99 us]"));
+  EXPECT_THAT(table, HasSubstr("CONV_2D"));
+  EXPECT_THAT(table, HasSubstr("4096"));
+  EXPECT_THAT(table, HasSubstr("[conv_out]"));
+}
+
+}  // namespace
+}  // namespace profiling
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -80,6 +80,56 @@ TfLiteStatus SimpleMemoryArena::Allocate(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+TfLiteStatus SimpleMemoryArena::AllocateForNodes(
+    TfLiteContext* context, size_t alignment, size_t size, int first_node,
+    int last_node, ArenaAlloc* new_alloc) {
+  TF_LITE_ENSURE(context, alignment <= arena_alignment_);
+  TF_LITE_ENSURE(context, first_node <= last_node);
+
+  new_alloc->first_node = first_node;
+  new_alloc->last_node = last_node;
+  if (size == 0) {
+    new_alloc->offset = 0;
+    new_alloc->size = 0;
+    return kTfLiteOk;
+  }
+
+  // Go through the allocs in use at the same time, sorted by offset, and look
+  // at the gaps between them. Since they may overlap each other the end of a
+  // gap is the furthest end seen so far.
+  size_t best_offset = std::numeric_limits<size_t>::max();
+  size_t best_offset_fit = std::numeric_limits<size_t>::max();
+  size_t current_offset = 0;
+  for (const ArenaAlloc& alloc : allocs_) {
+    if (alloc.last_node < first_node || alloc.first_node > last_node) {
+      continue;
+    }
+    size_t aligned_current_offset = AlignTo(alignment, current_offset);
+    if (aligned_current_offset + size <= alloc.offset &&
+        alloc.offset - current_offset < best_offset_fit) {
+      best_offset = aligned_current_offset;
+      best_offset_fit = alloc.offset - current_offset;
+    }
+    current_offset = std::max(current_offset, alloc.offset + alloc.size);
+  }
+  // If we don't find a gap just allocate above everything in use.
+  if (best_offset == std::numeric_limits<size_t>::max()) {
+    best_offset = AlignTo(alignment, current_offset);
+  }
+
+  high_water_mark_ = std::max(high_water_mark_, best_offset + size);
+
+  new_alloc->offset = best_offset;
+  new_alloc->size = size;
+  auto insertion_it = allocs_.begin();
+  while (insertion_it != allocs_.end() && insertion_it->offset <= best_offset) {
+    ++insertion_it;
+  }
+  allocs_.insert(insertion_it, *new_alloc);
+
+  return kTfLiteOk;
+}
+
 TfLiteStatus SimpleMemoryArena::Deallocate(TfLiteContext* context,
                                            const ArenaAlloc& alloc) {
   if (alloc.size == 0) {
@@ -89,7 +139,8 @@ TfLiteStatus SimpleMemoryArena::Deallocate(TfLiteContext* context,
   int erased_allocs_count = 0;
   auto it = allocs_.begin();
   while (it != allocs_.end()) {
-    if (it->offset == alloc.offset) {
+    if (it->offset == alloc.offset && it->first_node == alloc.first_node &&
+        it->last_node == alloc.last_node) {
       TF_LITE_ENSURE_EQ(context, it->size, alloc.size);
       erased_allocs_count++;
       it = allocs_.erase(it);
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CONTRIB_LITE_SIMPLE_MEMORY_ARENA_H_
 #define TENSORFLOW_CONTRIB_LITE_SIMPLE_MEMORY_ARENA_H_
 
+#include <limits>
 #include <list>
 #include <memory>
 #include "tensorflow/contrib/lite/c/c_api_internal.h"
@@ -26,11 +27,20 @@ namespace tflite {
 // underlying buffer is set, the alloc can be resolved into an actual memory
 // pointer.
 struct ArenaAlloc {
-  ArenaAlloc() : offset(0), size(0) {}
+  ArenaAlloc()
+      : offset(0),
+        size(0),
+        first_node(0),
+        last_node(std::numeric_limits<int>::max()) {}
 
   size_t offset;
   size_t size;
 
+  // The nodes during which the allocation is in use. Allocations made with
+  // SimpleMemoryArena::Allocate() are in use by all the nodes.
+  int first_node;
+  int last_node;
+
   inline bool operator<(const ArenaAlloc& other) const {
     return offset < other.offset;
   }
@@ -53,6 +63,14 @@ class SimpleMemoryArena {
   TfLiteStatus Allocate(TfLiteContext* context, size_t alignment, size_t size,
                         ArenaAlloc* new_alloc);
 
+  // Like Allocate(), for memory only in use from `first_node` to `last_node`:
+  // the allocation may overlap other allocations whose nodes don't intersect
+  // these, and takes the smallest gap between the others that fits it. An
+  // arena must only be used with one of Allocate() and AllocateForNodes().
+  TfLiteStatus AllocateForNodes(TfLiteContext* context, size_t alignment,
+                                size_t size, int first_node, int last_node,
+                                ArenaAlloc* new_alloc);
+
   TfLiteStatus Deallocate(TfLiteContext* context, const ArenaAlloc& alloc);
 
   inline size_t RequiredBufferSize() {
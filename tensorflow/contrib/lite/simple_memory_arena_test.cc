@@ -123,6 +123,32 @@ TEST(SimpleMemoryArenaTest, TestAfterClear) {
   EXPECT_EQ(allocs[8].offset, 8192);
 }
 
+TEST(SimpleMemoryArenaTest, AllocateForNodes) {
+  TfLiteContext context;
+  SimpleMemoryArena arena(64);
+  ArenaAlloc allocs[5];
+
+  arena.AllocateForNodes(&context, 32, 2047, 0, 1, &allocs[0]);
+  arena.AllocateForNodes(&context, 32, 2047, 1, 2, &allocs[1]);
+  // Not in use at the same time as #0, so it can take its place.
+  arena.AllocateForNodes(&context, 32, 1023, 2, 3, &allocs[2]);
+  // In use at the same time as all of them.
+  arena.AllocateForNodes(&context, 32, 2047, 0, 3, &allocs[3]);
+  // Fits in the gap #2 leaves in #0's place, which #0 doesn't use.
+  arena.AllocateForNodes(&context, 32, 1023, 3, 3, &allocs[4]);
+
+  EXPECT_EQ(allocs[0].offset, 0);
+  EXPECT_EQ(allocs[1].offset, 2048);
+  EXPECT_EQ(allocs[2].offset, 0);
+  EXPECT_EQ(allocs[3].offset, 4096);
+  EXPECT_EQ(allocs[4].offset, 1024);
+
+  EXPECT_EQ(arena.Deallocate(&context, allocs[2]), kTfLiteOk);
+  // #1 is no longer in use by then.
+  arena.AllocateForNodes(&context, 32, 2047, 3, 4, &allocs[2]);
+  EXPECT_EQ(allocs[2].offset, 2048);
+}
+
 }  // namespace
 }  // namespace tflite
 
@@ -23,6 +23,7 @@ limitations under the License.
 #include <unordered_set>
 #include <vector>
 
+#include "tensorflow/contrib/lite/delegates/gpu/gl_delegate.h"
 #include "tensorflow/contrib/lite/kernels/register.h"
 #include "tensorflow/contrib/lite/model.h"
 #include "tensorflow/contrib/lite/op_resolver.h"
@@ -62,6 +63,34 @@ void ProfilingListener::OnSingleRunEnd() {
   summarizer_.ProcessProfiles(profile_events, *interpreter_);
 }
 
+void OpStatsListener::SetInterpreter(tflite::Interpreter* interpreter,
+                                     int window_size) {
+  TFLITE_BENCHMARK_CHECK(interpreter);
+  interpreter_ = interpreter;
+  window_size_ = window_size;
+}
+
+void OpStatsListener::OnSingleRunStart(RunType run_type) {
+  // Start collecting on the first regular run so that warmup runs are left
+  // out of the statistics.
+  if (run_type == REGULAR && window_size_ > 0 && !started_) {
+    interpreter_->SetOpStatsWindowSize(window_size_);
+    started_ = true;
+  }
+}
+
+void OpStatsListener::OnBenchmarkEnd(const BenchmarkResults& results) {
+  if (!started_) return;
+  TFLITE_LOG(INFO) << "Per-node latency over the last " << window_size_
+                   << " runs:\n"
+                   << profiling::OpStatsToString(
+                          interpreter_->GetOpStats(/*by_op_type=*/false));
+  TFLITE_LOG(INFO) << "Per-op-type latency over the last " << window_size_
+                   << " runs:\n"
+                   << profiling::OpStatsToString(
+                          interpreter_->GetOpStats(/*by_op_type=*/true));
+}
+
 namespace {
 
 std::vector<std::string> Split(const std::string& str, const char delim) {
@@ -170,6 +199,9 @@ BenchmarkParams GetDefaultParams() {
   default_params.AddParam("input_layer_shape",
                           BenchmarkParam::Create<std::string>(""));
   default_params.AddParam("use_nnapi", BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("use_gpu", BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("op_stats_window",
+                          BenchmarkParam::Create<int32_t>(0));
   return default_params;
 }
 
@@ -178,11 +210,13 @@ BenchmarkParams GetDefaultParams() {
 BenchmarkTfLiteModel::BenchmarkTfLiteModel()
     : BenchmarkModel(GetDefaultParams()) {
   AddListener(&profiling_listener_);
+  AddListener(&op_stats_listener_);
 }
 
 BenchmarkTfLiteModel::BenchmarkTfLiteModel(BenchmarkParams params)
     : BenchmarkModel(std::move(params)) {
   AddListener(&profiling_listener_);
+  AddListener(&op_stats_listener_);
 }
 
 std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
@@ -192,7 +226,11 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
       CreateFlag<std::string>("input_layer", &params_, "input layer names"),
       CreateFlag<std::string>("input_layer_shape", &params_,
                               "input layer shape"),
-      CreateFlag<bool>("use_nnapi", &params_, "use nnapi api")};
+      CreateFlag<bool>("use_nnapi", &params_, "use nnapi api"),
+      CreateFlag<bool>("use_gpu", &params_, "use gpu delegate"),
+      CreateFlag<int32_t>("op_stats_window", &params_,
+                          "number of runs to collect per-op latency "
+                          "statistics over, 0 to disable")};
 
   flags.insert(flags.end(), specific_flags.begin(), specific_flags.end());
   return flags;
@@ -206,6 +244,9 @@ void BenchmarkTfLiteModel::LogParams() {
   TFLITE_LOG(INFO) << "Input shapes: ["
                    << params_.Get<std::string>("input_layer_shape") << "]";
   TFLITE_LOG(INFO) << "Use nnapi : [" << params_.Get<bool>("use_nnapi") << "]";
+  TFLITE_LOG(INFO) << "Use gpu : [" << params_.Get<bool>("use_gpu") << "]";
+  TFLITE_LOG(INFO) << "Op stats window: ["
+                   << params_.Get<int32_t>("op_stats_window") << "]";
 }
 
 bool BenchmarkTfLiteModel::ValidateParams() {
@@ -291,6 +332,8 @@ void BenchmarkTfLiteModel::Init() {
     TFLITE_LOG(FATAL) << "Failed to construct interpreter";
   }
   profiling_listener_.SetInterpreter(interpreter.get());
+  op_stats_listener_.SetInterpreter(interpreter.get(),
+                                    params_.Get<int32_t>("op_stats_window"));
 
   const int32_t num_threads = params_.Get<int32_t>("num_threads");
 
@@ -330,6 +373,13 @@ void BenchmarkTfLiteModel::Init() {
     }
   }
 
+  // The delegate prepares the graph with the resized inputs, after which the
+  // graph is immutable.
+  if (params_.Get<bool>("use_gpu") &&
+      interpreter->ModifyGraphWithDelegate(GpuDelegate()) != kTfLiteOk) {
+    TFLITE_LOG(FATAL) << "Failed to apply the GPU delegate!";
+  }
+
   if (interpreter->AllocateTensors() != kTfLiteOk) {
     TFLITE_LOG(FATAL) << "Failed to allocate tensors!";
   }
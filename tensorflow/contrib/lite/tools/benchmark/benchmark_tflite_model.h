@@ -21,6 +21,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/contrib/lite/model.h"
+#include "tensorflow/contrib/lite/profiling/op_stats.h"
 #include "tensorflow/contrib/lite/profiling/profile_summarizer.h"
 #include "tensorflow/contrib/lite/tools/benchmark/benchmark_model.h"
 
@@ -47,6 +48,25 @@ class ProfilingListener : public BenchmarkListener {
   bool has_profiles_;
 };
 
+// Dumps the interpreter's per-op latency statistics over the regular runs if
+// `window_size` is positive. Unlike ProfilingListener, this works in builds
+// without TFLITE_PROFILING_ENABLED.
+class OpStatsListener : public BenchmarkListener {
+ public:
+  OpStatsListener() : interpreter_(nullptr), window_size_(0) {}
+
+  void SetInterpreter(Interpreter* interpreter, int window_size);
+
+  void OnSingleRunStart(RunType run_type) override;
+
+  void OnBenchmarkEnd(const BenchmarkResults& results) override;
+
+ private:
+  Interpreter* interpreter_;
+  int window_size_;
+  bool started_ = false;
+};
+
 // Benchmarks a TFLite model by running tflite interpreter.
 class BenchmarkTfLiteModel : public BenchmarkModel {
  public:
@@ -74,6 +94,7 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   std::unique_ptr<tflite::Interpreter> interpreter;
   std::vector<InputLayerInfo> inputs;
   ProfilingListener profiling_listener_;
+  OpStatsListener op_stats_listener_;
 };
 
 }  // namespace benchmark
@@ -28,6 +28,8 @@
 @@HashTable
 @@MutableHashTable
 @@MutableDenseHashTable
+@@MutableStripedHashTable
+@@DynamicEmbeddingTable
 @@TableInitializerBase
 @@KeyValueTensorInitializer
 @@TextFileIndex
@@ -754,3 +754,492 @@ class MutableDenseHashTable(LookupInterface, checkpointable.CheckpointableBase):
       with ops.colocate_with(self.op._table_ref):
         return gen_lookup_ops.lookup_table_import_v2(
             self.op._table_ref, restored_tensors[0], restored_tensors[1])
+
+
+class MutableStripedHashTable(LookupInterface,
+                              checkpointable.CheckpointableBase):
+  """A mutable hash table for many concurrent readers and writers.
+
+  Keys are split into `num_shards` shards, each an open-addressing hash table
+  with its own reader-writer lock, so lookups never contend with each other
+  and inserts only contend with operations on the same shard. Batches of keys
+  are grouped by shard so that each shard is locked once per operation. When
+  a shard grows, its entries are moved to the larger table a few buckets at a
+  time by subsequent inserts instead of all at once.
+
+  Only integer keys and scalar numeric values are supported. Unlike
+  `MutableDenseHashTable`, no key values are reserved.
+
+  Example usage:
+
+  ```python
+  table = tf.contrib.lookup.MutableStripedHashTable(key_dtype=tf.int64,
+                                                    value_dtype=tf.float32,
+                                                    default_value=0.0)
+
+  sess.run(table.insert(keys, values))
+  out = table.lookup(query_keys)
+  print(out.eval())
+  ```
+  """
+
+  def __init__(self,
+               key_dtype,
+               value_dtype,
+               default_value,
+               num_shards=None,
+               initial_num_buckets=None,
+               max_load_factor=None,
+               shared_name=None,
+               name="MutableStripedHashTable",
+               checkpoint=True):
+    """Creates an empty `MutableStripedHashTable` object.
+
+    Args:
+      key_dtype: the type of the key tensors, `int32` or `int64`.
+      value_dtype: the type of the value tensors.
+      default_value: The scalar value to use if a key is missing in the table.
+      num_shards: the number of independently locked shards. Must be a power
+        of 2.
+      initial_num_buckets: the initial number of buckets across all shards.
+        Must be a power of 2.
+      max_load_factor: the fraction of used buckets at which a shard grows.
+      shared_name: If non-empty, this table will be shared under
+        the given name across multiple sessions.
+      name: A name for the operation (optional).
+      checkpoint: if True, the contents of the table are saved to and restored
+        from checkpoints. If `shared_name` is empty for a checkpointed table, it
+        is shared using the table node name.
+
+    Returns:
+      A `MutableStripedHashTable` object.
+    """
+    self._default_value = ops.convert_to_tensor(
+        default_value, dtype=value_dtype, name="default_value")
+    self._value_shape = self._default_value.get_shape()
+
+    use_node_name_sharing = checkpoint and shared_name is None
+    executing_eagerly = context.executing_eagerly()
+    if executing_eagerly and shared_name is None:
+      shared_name = "table_%d" % (ops.uid(),)
+    self._table_ref = gen_lookup_ops.mutable_striped_hash_table(
+        shared_name=shared_name,
+        use_node_name_sharing=use_node_name_sharing,
+        key_dtype=key_dtype,
+        value_dtype=value_dtype,
+        num_shards=num_shards,
+        initial_num_buckets=initial_num_buckets,
+        max_load_factor=max_load_factor,
+        name=name)
+    if executing_eagerly:
+      op_name = None
+    else:
+      op_name = self._table_ref.op.name.split("/")[-1]
+    super(MutableStripedHashTable, self).__init__(
+        key_dtype, value_dtype, op_name)
+
+    if checkpoint:
+      saveable = MutableStripedHashTable._Saveable(self, name)
+      ops.add_to_collection(ops.GraphKeys.SAVEABLE_OBJECTS, saveable)
+
+  def size(self, name=None):
+    """Compute the number of elements in this table.
+
+    Args:
+      name: A name for the operation (optional).
+
+    Returns:
+      A scalar tensor containing the number of elements in this table.
+    """
+    with ops.name_scope(name, "%s_Size" % self._name,
+                        [self._table_ref]) as name:
+      with ops.colocate_with(self._table_ref):
+        return gen_lookup_ops.lookup_table_size_v2(self._table_ref, name=name)
+
+  def lookup(self, keys, name=None):
+    """Looks up `keys` in a table, outputs the corresponding values.
+
+    The `default_value` is used for keys not present in the table.
+
+    Args:
+      keys: Keys to look up. Can be a tensor of any shape. Must match the
+        table's key_dtype.
+      name: A name for the operation (optional).
+
+    Returns:
+      A tensor containing the values in the same shape as `keys` using the
+        table's value type.
+    """
+    with ops.name_scope(name, "%s_lookup_table_find" % self._name,
+                        [self._table_ref, keys]) as name:
+      keys = ops.convert_to_tensor(keys, dtype=self._key_dtype, name="keys")
+      with ops.colocate_with(self._table_ref):
+        values = gen_lookup_ops.lookup_table_find_v2(
+            self._table_ref, keys, self._default_value, name=name)
+
+    return values
+
+  def insert(self, keys, values, name=None):
+    """Associates `keys` with `values`.
+
+    Args:
+      keys: Keys to insert. Can be a tensor of any shape. Must match the
+        table's key type.
+      values: Values to be associated with keys. Must be a tensor of the same
+        shape as `keys` and match the table's value type.
+      name: A name for the operation (optional).
+
+    Returns:
+      The created Operation.
+    """
+    with ops.name_scope(name, "%s_lookup_table_insert" % self._name,
+                        [self._table_ref, keys, values]) as name:
+      keys = ops.convert_to_tensor(keys, dtype=self._key_dtype, name="keys")
+      values = ops.convert_to_tensor(
+          values, dtype=self._value_dtype, name="values")
+      with ops.colocate_with(self._table_ref):
+        op = gen_lookup_ops.lookup_table_insert_v2(
+            self._table_ref, keys, values, name=name)
+      return op
+
+  def remove(self, keys, name=None):
+    """Removes `keys` and its associated values from the table.
+
+    If a key is not present in the table, it is silently ignored.
+
+    Args:
+      keys: Keys to remove. Can be a tensor of any shape. Must match the table's
+        key type.
+      name: A name for the operation (optional).
+
+    Returns:
+      The created Operation.
+    """
+    with ops.name_scope(name, "%s_lookup_table_remove" % self._name,
+                        [self._table_ref, keys]) as name:
+      keys = ops.convert_to_tensor(keys, dtype=self._key_dtype, name="keys")
+      with ops.colocate_with(self._table_ref):
+        op = gen_lookup_ops.lookup_table_remove_v2(
+            self._table_ref, keys, name=name)
+
+    return op
+
+  def export(self, name=None):
+    """Returns tensors of all keys and values in the table.
+
+    Args:
+      name: A name for the operation (optional).
+
+    Returns:
+      A pair of tensors with the first tensor containing all keys and the
+        second tensors containing all values in the table.
+    """
+    with ops.name_scope(name, "%s_lookup_table_export_values" % self._name,
+                        [self._table_ref]) as name:
+      with ops.colocate_with(self._table_ref):
+        exported_keys, exported_values = gen_lookup_ops.lookup_table_export_v2(
+            self._table_ref, self._key_dtype, self._value_dtype, name=name)
+
+    return exported_keys, exported_values
+
+  def _gather_saveables_for_checkpoint(self):
+    """For object-based checkpointing."""
+    return {"table": functools.partial(
+        MutableStripedHashTable._Saveable, table=self)}
+
+  class _Saveable(BaseSaverBuilder.SaveableObject):
+    """SaveableObject implementation for MutableStripedHashTable."""
+
+    def __init__(self, table, name):
+      tensors = table.export()
+      specs = [
+          BaseSaverBuilder.SaveSpec(tensors[0], "", name + "-keys"),
+          BaseSaverBuilder.SaveSpec(tensors[1], "", name + "-values")
+      ]
+      # pylint: disable=protected-access
+      super(MutableStripedHashTable._Saveable, self).__init__(
+          table, specs, name)
+
+    def restore(self, restored_tensors, restored_shapes):
+      del restored_shapes  # unused
+      # pylint: disable=protected-access
+      with ops.colocate_with(self.op._table_ref):
+        return gen_lookup_ops.lookup_table_import_v2(
+            self.op._table_ref, restored_tensors[0], restored_tensors[1])
+
+
+class DynamicEmbeddingTable(LookupInterface,
+                            checkpointable.CheckpointableBase):
+  """A growing table of embeddings keyed by `int64` ids.
+
+  Rows are only allocated for ids that have been looked up with
+  `embedding_lookup` at least `admit_threshold` times. When `max_rows` is set,
+  the least recently (`"lru"`) or least frequently (`"lfu"`) looked up rows are
+  evicted once the table grows beyond it. Memory use thus follows the number of
+  active ids rather than the size of the id space, and ids don't need to be
+  hashed into a fixed-size `Variable`.
+
+  Each row can hold `num_slots` vectors of optimizer state, which the fused
+  `apply_*` methods update in place. They are checkpointed together with the
+  embeddings.
+
+  Example usage:
+
+  ```python
+  table = tf.contrib.lookup.DynamicEmbeddingTable(
+      value_dtype=tf.float32, default_value=tf.zeros([16]), admit_threshold=2,
+      max_rows=1000000, num_slots=1, slot_initial_value=0.1)
+
+  embeddings = table.embedding_lookup(ids)
+  loss = ...
+  grad, = tf.gradients(loss, embeddings)
+  train_op = table.apply_adagrad(0.1, grad, ids)
+  ```
+  """
+
+  def __init__(self,
+               value_dtype,
+               default_value,
+               admit_threshold=None,
+               max_rows=None,
+               eviction_policy=None,
+               num_slots=None,
+               slot_initial_value=None,
+               shared_name=None,
+               name="DynamicEmbeddingTable",
+               checkpoint=True):
+    """Creates an empty `DynamicEmbeddingTable` object.
+
+    Args:
+      value_dtype: the type of the embeddings, `float32` or `float64`.
+      default_value: A vector used as the embedding of ids without a row and as
+        the initial embedding of newly admitted ids. Its shape is the shape of
+        an embedding.
+      admit_threshold: the number of lookups after which an id gets a row.
+        Defaults to 1.
+      max_rows: if positive, the maximum number of rows kept in the table.
+      eviction_policy: `"lru"` or `"lfu"`, which rows to evict first.
+      num_slots: the number of vectors of optimizer state kept with every
+        embedding. `apply_adagrad` needs at least one.
+      slot_initial_value: the initial value of the optimizer state.
+      shared_name: If non-empty, this table will be shared under
+        the given name across multiple sessions.
+      name: A name for the operation (optional).
+      checkpoint: if True, the contents of the table are saved to and restored
+        from checkpoints. If `shared_name` is empty for a checkpointed table, it
+        is shared using the table node name.
+
+    Returns:
+      A `DynamicEmbeddingTable` object.
+    """
+    self._default_value = ops.convert_to_tensor(
+        default_value, dtype=value_dtype, name="default_value")
+    self._value_shape = self._default_value.get_shape().with_rank(1)
+
+    use_node_name_sharing = checkpoint and shared_name is None
+    executing_eagerly = context.executing_eagerly()
+    if executing_eagerly and shared_name is None:
+      shared_name = "table_%d" % (ops.uid(),)
+    self._table_ref = gen_lookup_ops.dynamic_embedding_table(
+        shared_name=shared_name,
+        use_node_name_sharing=use_node_name_sharing,
+        value_dtype=value_dtype,
+        value_shape=self._value_shape,
+        admit_threshold=admit_threshold,
+        max_rows=max_rows,
+        eviction_policy=eviction_policy,
+        num_slots=num_slots,
+        slot_initial_value=slot_initial_value,
+        name=name)
+    if executing_eagerly:
+      op_name = None
+    else:
+      op_name = self._table_ref.op.name.split("/")[-1]
+    super(DynamicEmbeddingTable, self).__init__(
+        dtypes.int64, value_dtype, op_name)
+
+    if checkpoint:
+      saveable = DynamicEmbeddingTable._Saveable(self, name)
+      ops.add_to_collection(ops.GraphKeys.SAVEABLE_OBJECTS, saveable)
+
+  def size(self, name=None):
+    """Compute the number of rows in this table.
+
+    Args:
+      name: A name for the operation (optional).
+
+    Returns:
+      A scalar tensor containing the number of rows in this table.
+    """
+    with ops.name_scope(name, "%s_Size" % self._name,
+                        [self._table_ref]) as name:
+      with ops.colocate_with(self._table_ref):
+        return gen_lookup_ops.lookup_table_size_v2(self._table_ref, name=name)
+
+  def lookup(self, keys, name=None):
+    """Looks up `keys` without counting towards admission or eviction.
+
+    The `default_value` is used for keys not present in the table.
+
+    Args:
+      keys: Keys to look up. Can be a tensor of any shape.
+      name: A name for the operation (optional).
+
+    Returns:
+      A tensor of the shape of `keys` with the embedding shape appended.
+    """
+    with ops.name_scope(name, "%s_lookup_table_find" % self._name,
+                        [self._table_ref, keys]) as name:
+      keys = ops.convert_to_tensor(keys, dtype=self._key_dtype, name="keys")
+      with ops.colocate_with(self._table_ref):
+        values = gen_lookup_ops.lookup_table_find_v2(
+            self._table_ref, keys, self._default_value, name=name)
+    values.set_shape(keys.get_shape().concatenate(self._value_shape))
+    return values
+
+  def embedding_lookup(self, keys, name=None):
+    """Looks up `keys`, admitting ids that have been seen often enough.
+
+    Args:
+      keys: Keys to look up. Can be a tensor of any shape.
+      name: A name for the operation (optional).
+
+    Returns:
+      A tensor of the shape of `keys` with the embedding shape appended.
+    """
+    with ops.name_scope(name, "%s_embedding_lookup" % self._name,
+                        [self._table_ref, keys]) as name:
+      keys = ops.convert_to_tensor(keys, dtype=self._key_dtype, name="keys")
+      with ops.colocate_with(self._table_ref):
+        return gen_lookup_ops.dynamic_embedding_lookup(
+            self._table_ref, keys, self._default_value, name=name)
+
+  def apply_gradient_descent(self, learning_rate, grad, keys, name=None):
+    """Applies a gradient descent step to the embeddings of `keys`.
+
+    Args:
+      learning_rate: A scalar learning rate.
+      grad: The gradient of the embeddings returned by `embedding_lookup`.
+      keys: The keys that were looked up.
+      name: A name for the operation (optional).
+
+    Returns:
+      The created Operation.
+    """
+    with ops.name_scope(name, "%s_apply_gradient_descent" % self._name,
+                        [self._table_ref, learning_rate, grad, keys]) as name:
+      learning_rate = ops.convert_to_tensor(
+          learning_rate, dtype=self._value_dtype, name="learning_rate")
+      keys = ops.convert_to_tensor(keys, dtype=self._key_dtype, name="keys")
+      with ops.colocate_with(self._table_ref):
+        return gen_lookup_ops.dynamic_embedding_apply_gradient_descent(
+            self._table_ref, learning_rate, grad, keys, name=name)
+
+  def apply_adagrad(self, learning_rate, grad, keys, name=None):
+    """Applies an Adagrad step to the embeddings of `keys`.
+
+    The accumulator is kept in the first slot, so the table must have been
+    created with `num_slots >= 1`.
+
+    Args:
+      learning_rate: A scalar learning rate.
+      grad: The gradient of the embeddings returned by `embedding_lookup`.
+      keys: The keys that were looked up.
+      name: A name for the operation (optional).
+
+    Returns:
+      The created Operation.
+    """
+    with ops.name_scope(name, "%s_apply_adagrad" % self._name,
+                        [self._table_ref, learning_rate, grad, keys]) as name:
+      learning_rate = ops.convert_to_tensor(
+          learning_rate, dtype=self._value_dtype, name="learning_rate")
+      keys = ops.convert_to_tensor(keys, dtype=self._key_dtype, name="keys")
+      with ops.colocate_with(self._table_ref):
+        return gen_lookup_ops.dynamic_embedding_apply_adagrad(
+            self._table_ref, learning_rate, grad, keys, name=name)
+
+  def insert(self, keys, values, name=None):
+    """Sets the embeddings of `keys`, admitting them if necessary.
+
+    Args:
+      keys: Keys to insert. Can be a tensor of any shape.
+      values: Embeddings of the keys, of the shape of `keys` with the embedding
+        shape appended.
+      name: A name for the operation (optional).
+
+    Returns:
+      The created Operation.
+    """
+    with ops.name_scope(name, "%s_lookup_table_insert" % self._name,
+                        [self._table_ref, keys, values]) as name:
+      keys = ops.convert_to_tensor(keys, dtype=self._key_dtype, name="keys")
+      values = ops.convert_to_tensor(
+          values, dtype=self._value_dtype, name="values")
+      with ops.colocate_with(self._table_ref):
+        return gen_lookup_ops.lookup_table_insert_v2(
+            self._table_ref, keys, values, name=name)
+
+  def remove(self, keys, name=None):
+    """Removes `keys` and their rows from the table.
+
+    Args:
+      keys: Keys to remove. Can be a tensor of any shape.
+      name: A name for the operation (optional).
+
+    Returns:
+      The created Operation.
+    """
+    with ops.name_scope(name, "%s_lookup_table_remove" % self._name,
+                        [self._table_ref, keys]) as name:
+      keys = ops.convert_to_tensor(keys, dtype=self._key_dtype, name="keys")
+      with ops.colocate_with(self._table_ref):
+        return gen_lookup_ops.lookup_table_remove_v2(
+            self._table_ref, keys, name=name)
+
+  def export(self, name=None):
+    """Returns tensors of all keys and rows in the table.
+
+    Args:
+      name: A name for the operation (optional).
+
+    Returns:
+      A pair of tensors with the first tensor containing all keys and the
+        second tensor of shape `[size, 1 + num_slots, dim]` containing each
+        embedding followed by its optimizer state.
+    """
+    with ops.name_scope(name, "%s_lookup_table_export_values" % self._name,
+                        [self._table_ref]) as name:
+      with ops.colocate_with(self._table_ref):
+        exported_keys, exported_values = gen_lookup_ops.lookup_table_export_v2(
+            self._table_ref, self._key_dtype, self._value_dtype, name=name)
+
+    return exported_keys, exported_values
+
+  def _gather_saveables_for_checkpoint(self):
+    """For object-based checkpointing."""
+    return {"table": functools.partial(
+        DynamicEmbeddingTable._Saveable, table=self)}
+
+  class _Saveable(BaseSaverBuilder.SaveableObject):
+    """SaveableObject implementation for DynamicEmbeddingTable."""
+
+    def __init__(self, table, name):
+      tensors = table.export()
+      specs = [
+          BaseSaverBuilder.SaveSpec(tensors[0], "", name + "-keys"),
+          BaseSaverBuilder.SaveSpec(tensors[1], "", name + "-values")
+      ]
+      # pylint: disable=protected-access
+      super(DynamicEmbeddingTable._Saveable, self).__init__(table, specs, name)
+
+    def restore(self, restored_tensors, restored_shapes):
+      del restored_shapes  # unused
+      # pylint: disable=protected-access
+      with ops.colocate_with(self.op._table_ref):
+        return gen_lookup_ops.lookup_table_import_v2(
+            self.op._table_ref, restored_tensors[0], restored_tensors[1])
+
+
+ops.NotDifferentiable("DynamicEmbeddingTable")
+ops.NotDifferentiable("DynamicEmbeddingLookup")
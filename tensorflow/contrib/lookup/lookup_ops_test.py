@@ -1532,6 +1532,233 @@ class MutableDenseHashTableOpTest(test.TestCase):
         self.assertAllEqual(0, table5.size().eval())
 
 
+class MutableStripedHashTableOpTest(test.TestCase):
+
+  def testBasic(self):
+    with self.cached_session():
+      keys = constant_op.constant([0, 11, 12, 13, -1], dtypes.int64)
+      values = constant_op.constant([0.5, 1.0, 2.0, 3.0, 4.0], dtypes.float32)
+      table = lookup.MutableStripedHashTable(
+          dtypes.int64, dtypes.float32, default_value=-1.0)
+      self.assertAllEqual(0, table.size().eval())
+
+      table.insert(keys, values).run()
+      self.assertAllEqual(5, table.size().eval())
+
+      table.remove(constant_op.constant([12, 15], dtypes.int64)).run()
+      self.assertAllEqual(4, table.size().eval())
+
+      output = table.lookup(constant_op.constant([0, 12, -1, 15],
+                                                 dtypes.int64))
+      self.assertAllEqual([4], output.get_shape())
+      self.assertAllClose([0.5, -1.0, 4.0, -1.0], output.eval())
+
+  def testGrowWhileInserting(self):
+    with self.cached_session():
+      table = lookup.MutableStripedHashTable(
+          dtypes.int32,
+          dtypes.int64,
+          default_value=-1,
+          num_shards=4,
+          initial_num_buckets=8)
+      num_keys = 10000
+      for i in range(0, num_keys, 1000):
+        keys = np.arange(i, i + 1000, dtype=np.int32)
+        table.insert(keys, keys.astype(np.int64) * 2).run()
+        self.assertAllEqual(i + 1000, table.size().eval())
+        # Lookups must see every key while shards are being migrated.
+        output = table.lookup(np.arange(0, i + 1000, dtype=np.int32))
+        self.assertAllEqual(np.arange(0, i + 1000) * 2, output.eval())
+
+      exported_keys, exported_values = table.export()
+      sorted_keys = np.sort(exported_keys.eval())
+      sorted_values = np.sort(exported_values.eval())
+      self.assertAllEqual(np.arange(num_keys), sorted_keys)
+      self.assertAllEqual(np.arange(num_keys) * 2, sorted_values)
+
+  def testOverwrite(self):
+    with self.cached_session():
+      table = lookup.MutableStripedHashTable(
+          dtypes.int64, dtypes.int32, default_value=0)
+      table.insert(
+          constant_op.constant([7, 8], dtypes.int64),
+          constant_op.constant([1, 2], dtypes.int32)).run()
+      table.insert(
+          constant_op.constant([8, 9], dtypes.int64),
+          constant_op.constant([3, 4], dtypes.int32)).run()
+      self.assertAllEqual(3, table.size().eval())
+      output = table.lookup(constant_op.constant([7, 8, 9], dtypes.int64))
+      self.assertAllEqual([1, 3, 4], output.eval())
+
+  def testSaveRestore(self):
+    save_dir = os.path.join(self.get_temp_dir(), "save_restore")
+    save_path = os.path.join(tempfile.mkdtemp(prefix=save_dir), "hash")
+
+    with self.session(graph=ops.Graph()) as sess:
+      table = lookup.MutableStripedHashTable(
+          dtypes.int64, dtypes.int64, default_value=-1, name="t1")
+      save = saver.Saver()
+      table.insert(
+          constant_op.constant([11, 12, 13], dtypes.int64),
+          constant_op.constant([0, 1, 2], dtypes.int64)).run()
+      val = save.save(sess, save_path)
+      self.assertTrue(isinstance(val, six.string_types))
+      self.assertEqual(save_path, val)
+
+    with self.session(graph=ops.Graph()) as sess:
+      table = lookup.MutableStripedHashTable(
+          dtypes.int64, dtypes.int64, default_value=-1, name="t1")
+      table.insert(
+          constant_op.constant([11, 14], dtypes.int64),
+          constant_op.constant([12, 24], dtypes.int64)).run()
+      save = saver.Saver()
+      save.restore(sess, save_path)
+      self.assertAllEqual(3, table.size().eval())
+      output = table.lookup(
+          constant_op.constant([10, 11, 12, 13, 14], dtypes.int64))
+      self.assertAllEqual([-1, 0, 1, 2, -1], output.eval())
+
+  def testInvalidNumShards(self):
+    with self.cached_session():
+      table = lookup.MutableStripedHashTable(
+          dtypes.int64, dtypes.int64, default_value=-1, num_shards=3)
+      with self.assertRaisesOpError("num_shards must be a power of 2"):
+        table.size().eval()
+
+
+class DynamicEmbeddingTableOpTest(test.TestCase):
+
+  def testAdmission(self):
+    with self.cached_session():
+      table = lookup.DynamicEmbeddingTable(
+          dtypes.float32, default_value=[0.5, 0.5], admit_threshold=2)
+      keys = constant_op.constant([1, 2, 1], dtypes.int64)
+      output = table.embedding_lookup(keys)
+      self.assertAllEqual([3, 2], output.get_shape())
+      self.assertAllClose([[0.5, 0.5]] * 3, output.eval())
+      # Id 1 was seen twice, id 2 only once.
+      self.assertAllEqual(1, table.size().eval())
+
+      table.embedding_lookup(constant_op.constant([2], dtypes.int64)).eval()
+      self.assertAllEqual(2, table.size().eval())
+
+      table.insert(
+          constant_op.constant([1, 3], dtypes.int64),
+          constant_op.constant([[1, 2], [3, 4]], dtypes.float32)).run()
+      self.assertAllEqual(3, table.size().eval())
+      output = table.lookup(constant_op.constant([1, 2, 3, 4], dtypes.int64))
+      self.assertAllClose([[1, 2], [0.5, 0.5], [3, 4], [0.5, 0.5]],
+                          output.eval())
+
+  def testLruEviction(self):
+    with self.cached_session():
+      table = lookup.DynamicEmbeddingTable(
+          dtypes.float32, default_value=[0.0], max_rows=4)
+      for i in range(4):
+        table.embedding_lookup(constant_op.constant([i], dtypes.int64)).eval()
+      table.embedding_lookup(constant_op.constant([0], dtypes.int64)).eval()
+      table.embedding_lookup(constant_op.constant([4], dtypes.int64)).eval()
+      self.assertAllEqual(4, table.size().eval())
+      exported_keys, _ = table.export()
+      self.assertAllEqual([0, 2, 3, 4], np.sort(exported_keys.eval()))
+
+  def testLfuEviction(self):
+    with self.cached_session():
+      table = lookup.DynamicEmbeddingTable(
+          dtypes.float32,
+          default_value=[0.0],
+          max_rows=2,
+          eviction_policy="lfu")
+      table.embedding_lookup(
+          constant_op.constant([7, 7, 7, 8, 8], dtypes.int64)).eval()
+      for _ in range(3):
+        table.embedding_lookup(
+            constant_op.constant([7, 8], dtypes.int64)).eval()
+      table.embedding_lookup(
+          constant_op.constant([7, 7, 8, 8, 9], dtypes.int64)).eval()
+      exported_keys, _ = table.export()
+      self.assertAllEqual([7, 8], np.sort(exported_keys.eval()))
+
+  def testApplyGradientDescent(self):
+    with self.cached_session():
+      table = lookup.DynamicEmbeddingTable(
+          dtypes.float32, default_value=[1.0, 2.0], admit_threshold=2)
+      keys = constant_op.constant([3, 3, 5], dtypes.int64)
+      table.embedding_lookup(keys).eval()
+      grad = constant_op.constant([[1, 1], [1, 1], [2, 2]], dtypes.float32)
+      table.apply_gradient_descent(0.5, grad, keys).run()
+      output = table.lookup(constant_op.constant([3, 5], dtypes.int64))
+      # Only id 3 was admitted, and both its gradients are applied.
+      self.assertAllClose([[0.0, 1.0], [1.0, 2.0]], output.eval())
+
+  def testApplyAdagrad(self):
+    with self.cached_session():
+      table = lookup.DynamicEmbeddingTable(
+          dtypes.float32,
+          default_value=[1.0, 2.0],
+          num_slots=1,
+          slot_initial_value=0.1)
+      keys = constant_op.constant([4], dtypes.int64)
+      table.embedding_lookup(keys).eval()
+      grad = constant_op.constant([[0.1, 0.2]], dtypes.float32)
+      table.apply_adagrad(3.0, grad, keys).run()
+
+      accum = np.array([0.1, 0.1]) + np.array([0.1, 0.2])**2
+      var = np.array([1.0, 2.0]) - 3.0 * np.array([0.1, 0.2]) / np.sqrt(accum)
+      _, exported_values = table.export()
+      self.assertAllClose([[var, accum]], exported_values.eval())
+
+  def testAdagradNeedsSlot(self):
+    with self.cached_session():
+      table = lookup.DynamicEmbeddingTable(dtypes.float32, default_value=[0.0])
+      keys = constant_op.constant([4], dtypes.int64)
+      grad = constant_op.constant([[0.1]], dtypes.float32)
+      with self.assertRaisesOpError("at least one slot"):
+        table.apply_adagrad(1.0, grad, keys).run()
+
+  def testSaveRestore(self):
+    save_dir = os.path.join(self.get_temp_dir(), "save_restore")
+    save_path = os.path.join(tempfile.mkdtemp(prefix=save_dir), "embedding")
+
+    with self.session(graph=ops.Graph()) as sess:
+      table = lookup.DynamicEmbeddingTable(
+          dtypes.float32,
+          default_value=[0.0, 0.0],
+          num_slots=1,
+          slot_initial_value=0.1,
+          name="t1")
+      keys = constant_op.constant([11, 12], dtypes.int64)
+      table.insert(keys,
+                   constant_op.constant([[1, 2], [3, 4]], dtypes.float32)).run()
+      table.apply_adagrad(
+          1.0, constant_op.constant([[0, 1], [0, 1]], dtypes.float32),
+          keys).run()
+      expected = table.lookup(keys).eval()
+      save = saver.Saver()
+      val = save.save(sess, save_path)
+      self.assertTrue(isinstance(val, six.string_types))
+
+    with self.session(graph=ops.Graph()) as sess:
+      table = lookup.DynamicEmbeddingTable(
+          dtypes.float32,
+          default_value=[0.0, 0.0],
+          num_slots=1,
+          slot_initial_value=0.1,
+          name="t1")
+      table.insert(
+          constant_op.constant([13], dtypes.int64),
+          constant_op.constant([[5, 6]], dtypes.float32)).run()
+      save = saver.Saver()
+      save.restore(sess, save_path)
+      self.assertAllEqual(2, table.size().eval())
+      output = table.lookup(constant_op.constant([11, 12, 13], dtypes.int64))
+      self.assertAllClose(np.concatenate([expected, [[0, 0]]]), output.eval())
+      # The accumulator was restored as well.
+      _, exported_values = table.export()
+      self.assertAllClose([[0.1, 1.1], [0.1, 1.1]],
+                          exported_values.eval()[:, 1, :])
+
+
 class IndexTableFromFile(test.TestCase):
 
   def _createVocabFile(self, basename, values=("brain", "salad", "surgery")):
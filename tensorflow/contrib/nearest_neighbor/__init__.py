@@ -25,6 +25,10 @@ The following ops generate multiprobe sequences for various hash families.
 
 @@hyperplane_lsh_hash
 
+### Inverted file index
+
+@@IVFIndex
+
 """
 
 from __future__ import absolute_import
@@ -0,0 +1,258 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/nearest_neighbor/kernels/ivf_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace nearest_neighbor {
+
+constexpr int64 IVFIndex::kMaxTrainingPointsPerList;
+
+namespace {
+
+using ConstVectorMap = Eigen::Map<const Eigen::VectorXf>;
+
+float SquaredDistance(const float* a, const float* b, int64 dim) {
+  return (ConstVectorMap(a, dim) - ConstVectorMap(b, dim)).squaredNorm();
+}
+
+int64 NearestCentroid(const float* point, const std::vector<float>& centroids,
+                      int64 dim) {
+  const int64 num_lists = centroids.size() / dim;
+  int64 nearest = 0;
+  float nearest_distance = std::numeric_limits<float>::infinity();
+  for (int64 i = 0; i < num_lists; ++i) {
+    const float distance = SquaredDistance(point, &centroids[i * dim], dim);
+    if (distance < nearest_distance) {
+      nearest = i;
+      nearest_distance = distance;
+    }
+  }
+  return nearest;
+}
+
+// Sets (*lists)[i] to the nearest centroid of point i.
+void AssignToLists(const float* points, int64 num_points, int64 dim,
+                   const std::vector<float>& centroids,
+                   thread::ThreadPool* pool, std::vector<int64>* lists) {
+  lists->resize(num_points);
+  auto assign = [&](int64 start, int64 end) {
+    for (int64 i = start; i < end; ++i) {
+      (*lists)[i] = NearestCentroid(points + i * dim, centroids, dim);
+    }
+  };
+  if (pool == nullptr) {
+    assign(0, num_points);
+  } else {
+    pool->ParallelFor(num_points, 3 * centroids.size(), assign);
+  }
+}
+
+}  // namespace
+
+Status IVFIndex::Build(const float* points, const int64* ids, int64 num_points,
+                       int64 dim, int64 num_lists, int num_iterations,
+                       thread::ThreadPool* pool,
+                       std::unique_ptr<IVFIndex>* index) {
+  if (dim < 1) {
+    return errors::InvalidArgument("Points must have at least one dimension");
+  }
+  if (num_lists < 1) {
+    return errors::InvalidArgument("num_lists must be at least 1, got ",
+                                   num_lists);
+  }
+  if (num_lists > num_points) {
+    return errors::InvalidArgument("Cannot partition ", num_points,
+                                   " points into ", num_lists, " lists");
+  }
+  if (num_iterations < 0) {
+    return errors::InvalidArgument("num_iterations must be non-negative, got ",
+                                   num_iterations);
+  }
+
+  // Train on evenly spaced points, which is cheaper than training on all of
+  // them and good enough for picking the lists.
+  const int64 num_training =
+      std::min(num_points, num_lists * kMaxTrainingPointsPerList);
+  std::vector<float> training(num_training * dim);
+  for (int64 i = 0; i < num_training; ++i) {
+    const float* point = points + (i * num_points / num_training) * dim;
+    std::copy(point, point + dim, &training[i * dim]);
+  }
+  std::unique_ptr<IVFIndex> result(new IVFIndex);
+  result->dim_ = dim;
+  result->centroids_.resize(num_lists * dim);
+  for (int64 i = 0; i < num_lists; ++i) {
+    const float* point = &training[(i * num_training / num_lists) * dim];
+    std::copy(point, point + dim, &result->centroids_[i * dim]);
+  }
+
+  std::vector<int64> lists;
+  std::vector<double> sums(num_lists * dim);
+  std::vector<int64> counts(num_lists);
+  for (int iteration = 0; iteration < num_iterations; ++iteration) {
+    AssignToLists(training.data(), num_training, dim, result->centroids_, pool,
+                  &lists);
+    std::fill(sums.begin(), sums.end(), 0.0);
+    std::fill(counts.begin(), counts.end(), 0);
+    for (int64 i = 0; i < num_training; ++i) {
+      double* sum = &sums[lists[i] * dim];
+      for (int64 j = 0; j < dim; ++j) {
+        sum[j] += training[i * dim + j];
+      }
+      ++counts[lists[i]];
+    }
+    // Centroids that lost all their points stay where they are.
+    for (int64 i = 0; i < num_lists; ++i) {
+      if (counts[i] == 0) continue;
+      for (int64 j = 0; j < dim; ++j) {
+        result->centroids_[i * dim + j] = sums[i * dim + j] / counts[i];
+      }
+    }
+  }
+
+  // Counting sort of all the points by list, keeping their order.
+  AssignToLists(points, num_points, dim, result->centroids_, pool, &lists);
+  result->list_offsets_.assign(num_lists + 1, 0);
+  for (int64 i = 0; i < num_points; ++i) {
+    ++result->list_offsets_[lists[i] + 1];
+  }
+  for (int64 i = 0; i < num_lists; ++i) {
+    result->list_offsets_[i + 1] += result->list_offsets_[i];
+  }
+  std::vector<int64> list_next(result->list_offsets_.begin(),
+                               result->list_offsets_.end() - 1);
+  result->points_.resize(num_points * dim);
+  result->ids_.resize(num_points);
+  for (int64 i = 0; i < num_points; ++i) {
+    const int64 position = list_next[lists[i]]++;
+    std::copy(points + i * dim, points + (i + 1) * dim,
+              &result->points_[position * dim]);
+    result->ids_[position] = ids[i];
+  }
+  *index = std::move(result);
+  return Status::OK();
+}
+
+Status IVFIndex::FromLists(int64 dim, std::vector<float> centroids,
+                           std::vector<int64> list_offsets,
+                           std::vector<float> points, std::vector<int64> ids,
+                           std::unique_ptr<IVFIndex>* index) {
+  if (dim < 1) {
+    return errors::InvalidArgument("Points must have at least one dimension");
+  }
+  if (list_offsets.size() < 2) {
+    return errors::InvalidArgument("An index needs at least one list");
+  }
+  const int64 num_lists = list_offsets.size() - 1;
+  const int64 num_points = ids.size();
+  if (centroids.size() != num_lists * dim) {
+    return errors::InvalidArgument("Expected ", num_lists * dim,
+                                   " centroid coordinates for ", num_lists,
+                                   " lists, got ", centroids.size());
+  }
+  if (points.size() != num_points * dim) {
+    return errors::InvalidArgument("Expected ", num_points * dim,
+                                   " point coordinates for ", num_points,
+                                   " ids, got ", points.size());
+  }
+  if (list_offsets.front() != 0 || list_offsets.back() != num_points) {
+    return errors::InvalidArgument("List offsets must go from 0 to ",
+                                   num_points, ", got ", list_offsets.front(),
+                                   " to ", list_offsets.back());
+  }
+  for (int64 i = 0; i < num_lists; ++i) {
+    if (list_offsets[i] > list_offsets[i + 1]) {
+      return errors::InvalidArgument("List offsets must be non-decreasing, "
+                                     "got ", list_offsets[i], " before ",
+                                     list_offsets[i + 1]);
+    }
+  }
+  std::unique_ptr<IVFIndex> result(new IVFIndex);
+  result->dim_ = dim;
+  result->centroids_ = std::move(centroids);
+  result->list_offsets_ = std::move(list_offsets);
+  result->points_ = std::move(points);
+  result->ids_ = std::move(ids);
+  *index = std::move(result);
+  return Status::OK();
+}
+
+void IVFIndex::Search(const float* query, int k, int num_probes,
+                      float* distances, int64* ids) const {
+  // (distance, position) pairs, so that ties go to the lower position.
+  typedef std::pair<float, int64> Candidate;
+  const int64 lists = num_lists();
+  const int64 probes = std::min<int64>(std::max(num_probes, 1), lists);
+  std::vector<Candidate> centroid_distances(lists);
+  for (int64 i = 0; i < lists; ++i) {
+    centroid_distances[i] = {
+        SquaredDistance(query, &centroids_[i * dim_], dim_), i};
+  }
+  std::partial_sort(centroid_distances.begin(),
+                    centroid_distances.begin() + probes,
+                    centroid_distances.end());
+
+  // A max-heap of the k nearest points scanned so far.
+  std::vector<Candidate> nearest;
+  nearest.reserve(k);
+  for (int64 p = 0; p < probes; ++p) {
+    const int64 list = centroid_distances[p].second;
+    for (int64 j = list_offsets_[list]; j < list_offsets_[list + 1]; ++j) {
+      const Candidate candidate(
+          SquaredDistance(query, &points_[j * dim_], dim_), j);
+      if (nearest.size() < static_cast<size_t>(k)) {
+        nearest.push_back(candidate);
+        std::push_heap(nearest.begin(), nearest.end());
+      } else if (k > 0 && candidate < nearest.front()) {
+        std::pop_heap(nearest.begin(), nearest.end());
+        nearest.back() = candidate;
+        std::push_heap(nearest.begin(), nearest.end());
+      }
+    }
+  }
+  std::sort_heap(nearest.begin(), nearest.end());
+
+  for (int i = 0; i < k; ++i) {
+    if (i < static_cast<int>(nearest.size())) {
+      distances[i] = nearest[i].first;
+      ids[i] = ids_[nearest[i].second];
+    } else {
+      distances[i] = std::numeric_limits<float>::infinity();
+      ids[i] = -1;
+    }
+  }
+}
+
+int64 IVFIndex::SearchCost(int k, int num_probes) const {
+  const int64 lists = num_lists();
+  const int64 probes = std::min<int64>(std::max(num_probes, 1), lists);
+  const int64 num_scanned = probes * num_points() / lists;
+  return 3 * dim_ * (lists + num_scanned) +
+         static_cast<int64>(
+             (num_scanned + k) *
+             std::log2(static_cast<double>(std::max(k, 1) + 1)));
+}
+
+}  // namespace nearest_neighbor
+}  // namespace tensorflow
@@ -0,0 +1,92 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CONTRIB_NEAREST_NEIGHBOR_KERNELS_IVF_INDEX_H_
+#define TENSORFLOW_CONTRIB_NEAREST_NEIGHBOR_KERNELS_IVF_INDEX_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace nearest_neighbor {
+
+// An inverted file index for approximate nearest neighbor search under the
+// squared Euclidean distance. The points are partitioned into lists by their
+// nearest centroid, where the centroids are trained with k-means. A query
+// only scans the lists of its num_probes nearest centroids, so with about
+// sqrt(num_points) lists a search costs O(sqrt(num_points)) distances
+// instead of num_points. Searching all the lists is exact.
+//
+// The points of every list are stored contiguously, in the order in which
+// they were given.
+class IVFIndex {
+ public:
+  // Builds an index of the row major [num_points, dim] `points` with the
+  // given `ids`. The num_lists centroids are trained with num_iterations
+  // Lloyd iterations over a sample of at most kMaxTrainingPointsPerList
+  // points per list, starting from evenly spaced points. `pool` may be null.
+  static Status Build(const float* points, const int64* ids, int64 num_points,
+                      int64 dim, int64 num_lists, int num_iterations,
+                      thread::ThreadPool* pool,
+                      std::unique_ptr<IVFIndex>* index);
+
+  // Creates an index from the state returned by the accessors below, e.g.
+  // when restoring it from a checkpoint. `list_offsets` has num_lists + 1
+  // entries, and the points of list i are the rows
+  // [list_offsets[i], list_offsets[i + 1]) of `points`.
+  static Status FromLists(int64 dim, std::vector<float> centroids,
+                          std::vector<int64> list_offsets,
+                          std::vector<float> points, std::vector<int64> ids,
+                          std::unique_ptr<IVFIndex>* index);
+
+  // Writes the ids of the k points nearest to the `dim` coordinates of
+  // `query` among the lists of its num_probes nearest centroids, with their
+  // squared distances, nearest first. Ties go to the point stored first.
+  // If fewer than k points are scanned, the rest of `distances` is +inf and
+  // the rest of `ids` is -1.
+  void Search(const float* query, int k, int num_probes, float* distances,
+              int64* ids) const;
+
+  // Approximate number of operations of a Search, for sharding.
+  int64 SearchCost(int k, int num_probes) const;
+
+  int64 dim() const { return dim_; }
+  int64 num_lists() const { return list_offsets_.size() - 1; }
+  int64 num_points() const { return ids_.size(); }
+  const std::vector<float>& centroids() const { return centroids_; }
+  const std::vector<int64>& list_offsets() const { return list_offsets_; }
+  const std::vector<float>& points() const { return points_; }
+  const std::vector<int64>& ids() const { return ids_; }
+
+  static constexpr int64 kMaxTrainingPointsPerList = 256;
+
+ private:
+  IVFIndex() {}
+
+  int64 dim_ = 0;
+  std::vector<float> centroids_;
+  std::vector<int64> list_offsets_;
+  std::vector<float> points_;
+  std::vector<int64> ids_;
+};
+
+}  // namespace nearest_neighbor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CONTRIB_NEAREST_NEIGHBOR_KERNELS_IVF_INDEX_H_
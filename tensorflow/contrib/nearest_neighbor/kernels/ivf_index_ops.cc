@@ -0,0 +1,311 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/contrib/nearest_neighbor/kernels/ivf_index.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+using errors::FailedPrecondition;
+using errors::InvalidArgument;
+
+using nearest_neighbor::IVFIndex;
+
+// Holds the current IVFIndex. Searches take a reference to it, so they
+// never block a build or a restore that replaces it.
+class IVFIndexResource : public ResourceBase {
+ public:
+  string DebugString() override {
+    tf_shared_lock l(mu_);
+    if (index_ == nullptr) return "IVFIndex (empty)";
+    return strings::StrCat("IVFIndex with ", index_->num_points(),
+                           " points of dimension ", index_->dim(), " in ",
+                           index_->num_lists(), " lists");
+  }
+
+  int64 MemoryUsed() const override {
+    tf_shared_lock l(mu_);
+    if (index_ == nullptr) return 0;
+    return (index_->centroids().size() + index_->points().size()) *
+               sizeof(float) +
+           (index_->list_offsets().size() + index_->ids().size()) *
+               sizeof(int64);
+  }
+
+  void Set(std::unique_ptr<IVFIndex> index) {
+    mutex_lock l(mu_);
+    index_ = std::move(index);
+  }
+
+  std::shared_ptr<const IVFIndex> Get() {
+    tf_shared_lock l(mu_);
+    return index_;
+  }
+
+ private:
+  mutable mutex mu_;
+  std::shared_ptr<const IVFIndex> index_ GUARDED_BY(mu_);
+};
+
+namespace {
+
+Status LookupOrCreateIndex(OpKernelContext* context,
+                           IVFIndexResource** resource) {
+  return LookupOrCreateResource<IVFIndexResource>(
+      context, HandleFromInput(context, 0), resource,
+      [](IVFIndexResource** ptr) {
+        *ptr = new IVFIndexResource;
+        return Status::OK();
+      });
+}
+
+// Returns the index held by the resource of input 0, which must be
+// initialized.
+Status GetIndex(OpKernelContext* context,
+                std::shared_ptr<const IVFIndex>* index) {
+  IVFIndexResource* resource = nullptr;
+  TF_RETURN_IF_ERROR(
+      LookupResource(context, HandleFromInput(context, 0), &resource));
+  core::ScopedUnref unref(resource);
+  *index = resource->Get();
+  if (*index == nullptr) {
+    return FailedPrecondition("The IVFIndex has not been built or restored");
+  }
+  return Status::OK();
+}
+
+template <typename T>
+std::vector<T> TensorToVector(const Tensor& tensor) {
+  auto flat = tensor.flat<T>();
+  return std::vector<T>(flat.data(), flat.data() + flat.size());
+}
+
+template <typename T>
+Status VectorToOutput(OpKernelContext* context, int index,
+                      const TensorShape& shape, const std::vector<T>& values) {
+  Tensor* output = nullptr;
+  TF_RETURN_IF_ERROR(context->allocate_output(index, shape, &output));
+  std::copy(values.begin(), values.end(), output->flat<T>().data());
+  return Status::OK();
+}
+
+}  // namespace
+
+class IVFIndexIsInitializedOp : public OpKernel {
+ public:
+  explicit IVFIndexIsInitializedOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, TensorShape(), &output));
+    IVFIndexResource* resource = nullptr;
+    if (!LookupResource(context, HandleFromInput(context, 0), &resource)
+             .ok()) {
+      output->scalar<bool>()() = false;
+      return;
+    }
+    core::ScopedUnref unref(resource);
+    output->scalar<bool>()() = resource->Get() != nullptr;
+  }
+};
+
+class IVFIndexBuildOp : public OpKernel {
+ public:
+  explicit IVFIndexBuildOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_lists", &num_lists_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("num_iterations", &num_iterations_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& points = context->input(1);
+    const Tensor& ids = context->input(2);
+    OP_REQUIRES(context, points.dims() == 2,
+                InvalidArgument("Need a two-dimensional points tensor, got ",
+                                points.dims(), " dimensions."));
+    OP_REQUIRES(context, ids.dims() == 1,
+                InvalidArgument("Need a one-dimensional ids tensor, got ",
+                                ids.dims(), " dimensions."));
+    OP_REQUIRES(context, ids.dim_size(0) == points.dim_size(0),
+                InvalidArgument("Got ", ids.dim_size(0), " ids for ",
+                                points.dim_size(0), " points."));
+
+    std::unique_ptr<IVFIndex> index;
+    OP_REQUIRES_OK(
+        context,
+        IVFIndex::Build(points.matrix<float>().data(),
+                        ids.vec<int64>().data(), points.dim_size(0),
+                        points.dim_size(1), num_lists_, num_iterations_,
+                        context->device()->tensorflow_cpu_worker_threads()
+                            ->workers,
+                        &index));
+    IVFIndexResource* resource = nullptr;
+    OP_REQUIRES_OK(context, LookupOrCreateIndex(context, &resource));
+    core::ScopedUnref unref(resource);
+    resource->Set(std::move(index));
+  }
+
+ private:
+  int num_lists_;
+  int num_iterations_;
+};
+
+class IVFIndexSearchOp : public OpKernel {
+ public:
+  explicit IVFIndexSearchOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    std::shared_ptr<const IVFIndex> index;
+    OP_REQUIRES_OK(context, GetIndex(context, &index));
+
+    const Tensor& queries = context->input(1);
+    OP_REQUIRES(context, queries.dims() == 2,
+                InvalidArgument("Need a two-dimensional queries tensor, got ",
+                                queries.dims(), " dimensions."));
+    OP_REQUIRES(context, queries.dim_size(1) == index->dim(),
+                InvalidArgument("Queries have dimension ", queries.dim_size(1),
+                                " but the indexed points have dimension ",
+                                index->dim(), "."));
+    const Tensor& k_tensor = context->input(2);
+    OP_REQUIRES(context, k_tensor.dims() == 0,
+                InvalidArgument("Need a scalar k tensor, got ",
+                                k_tensor.dims(), " dimensions."));
+    const int k = k_tensor.scalar<int32>()();
+    OP_REQUIRES(context, k >= 0,
+                InvalidArgument("k must be non-negative, got ", k, "."));
+    const Tensor& num_probes_tensor = context->input(3);
+    OP_REQUIRES(context, num_probes_tensor.dims() == 0,
+                InvalidArgument("Need a scalar num_probes tensor, got ",
+                                num_probes_tensor.dims(), " dimensions."));
+    const int num_probes = num_probes_tensor.scalar<int32>()();
+    OP_REQUIRES(context, num_probes >= 1,
+                InvalidArgument("num_probes must be at least 1, got ",
+                                num_probes, "."));
+
+    const int64 batch_size = queries.dim_size(0);
+    Tensor* distances = nullptr;
+    Tensor* ids = nullptr;
+    TensorShape output_shape({batch_size, k});
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, output_shape, &distances));
+    OP_REQUIRES_OK(context, context->allocate_output(1, output_shape, &ids));
+    if (output_shape.num_elements() == 0) {
+      return;
+    }
+
+    const float* queries_data = queries.matrix<float>().data();
+    float* distances_data = distances->matrix<float>().data();
+    int64* ids_data = ids->matrix<int64>().data();
+    const int64 dim = index->dim();
+    context->device()->tensorflow_cpu_worker_threads()->workers->ParallelFor(
+        batch_size, index->SearchCost(k, num_probes),
+        [&](int64 start, int64 end) {
+          for (int64 i = start; i < end; ++i) {
+            index->Search(queries_data + i * dim, k, num_probes,
+                          distances_data + i * k, ids_data + i * k);
+          }
+        });
+  }
+};
+
+class IVFIndexExportOp : public OpKernel {
+ public:
+  explicit IVFIndexExportOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    std::shared_ptr<const IVFIndex> index;
+    OP_REQUIRES_OK(context, GetIndex(context, &index));
+    const int64 dim = index->dim();
+    OP_REQUIRES_OK(context,
+                   VectorToOutput(context, 0,
+                                  TensorShape({index->num_lists(), dim}),
+                                  index->centroids()));
+    OP_REQUIRES_OK(
+        context,
+        VectorToOutput(context, 1, TensorShape({index->num_lists() + 1}),
+                       index->list_offsets()));
+    OP_REQUIRES_OK(context,
+                   VectorToOutput(context, 2,
+                                  TensorShape({index->num_points(), dim}),
+                                  index->points()));
+    OP_REQUIRES_OK(context,
+                   VectorToOutput(context, 3,
+                                  TensorShape({index->num_points()}),
+                                  index->ids()));
+  }
+};
+
+class IVFIndexImportOp : public OpKernel {
+ public:
+  explicit IVFIndexImportOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& centroids = context->input(1);
+    const Tensor& list_offsets = context->input(2);
+    const Tensor& points = context->input(3);
+    const Tensor& ids = context->input(4);
+    OP_REQUIRES(context,
+                centroids.dims() == 2 && list_offsets.dims() == 1 &&
+                    points.dims() == 2 && ids.dims() == 1,
+                InvalidArgument("Need two-dimensional centroids and points, "
+                                "and one-dimensional list_offsets and ids."));
+    OP_REQUIRES(context, centroids.dim_size(1) == points.dim_size(1),
+                InvalidArgument("Centroids have dimension ",
+                                centroids.dim_size(1), " but points have ",
+                                "dimension ", points.dim_size(1), "."));
+
+    std::unique_ptr<IVFIndex> index;
+    OP_REQUIRES_OK(context,
+                   IVFIndex::FromLists(points.dim_size(1),
+                                       TensorToVector<float>(centroids),
+                                       TensorToVector<int64>(list_offsets),
+                                       TensorToVector<float>(points),
+                                       TensorToVector<int64>(ids), &index));
+    IVFIndexResource* resource = nullptr;
+    OP_REQUIRES_OK(context, LookupOrCreateIndex(context, &resource));
+    core::ScopedUnref unref(resource);
+    resource->Set(std::move(index));
+  }
+};
+
+REGISTER_RESOURCE_HANDLE_KERNEL(IVFIndexResource);
+
+REGISTER_KERNEL_BUILDER(Name("IVFIndexIsInitialized").Device(DEVICE_CPU),
+                        IVFIndexIsInitializedOp);
+REGISTER_KERNEL_BUILDER(Name("IVFIndexBuild").Device(DEVICE_CPU),
+                        IVFIndexBuildOp);
+REGISTER_KERNEL_BUILDER(Name("IVFIndexSearch").Device(DEVICE_CPU),
+                        IVFIndexSearchOp);
+REGISTER_KERNEL_BUILDER(Name("IVFIndexExport").Device(DEVICE_CPU),
+                        IVFIndexExportOp);
+REGISTER_KERNEL_BUILDER(Name("IVFIndexImport").Device(DEVICE_CPU),
+                        IVFIndexImportOp);
+
+}  // namespace tensorflow
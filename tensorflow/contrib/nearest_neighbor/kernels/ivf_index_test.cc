@@ -0,0 +1,160 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/nearest_neighbor/kernels/ivf_index.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace {
+
+using tensorflow::int64;
+using tensorflow::nearest_neighbor::IVFIndex;
+
+// Points 0, 1, ..., 9 and 100, 101, ..., 109 on a line, with ids 10 * x.
+void MakeTwoClusters(std::vector<float>* points, std::vector<int64>* ids) {
+  for (int i = 0; i < 10; ++i) {
+    points->push_back(i);
+    ids->push_back(10 * i);
+    points->push_back(100 + i);
+    ids->push_back(10 * (100 + i));
+  }
+}
+
+TEST(IVFIndexTest, BuildPartitionsClusters) {
+  std::vector<float> points;
+  std::vector<int64> ids;
+  MakeTwoClusters(&points, &ids);
+  std::unique_ptr<IVFIndex> index;
+  TF_ASSERT_OK(IVFIndex::Build(points.data(), ids.data(), ids.size(), 1, 2,
+                               10, nullptr, &index));
+  ASSERT_EQ(2, index->num_lists());
+  EXPECT_EQ(std::vector<int64>({0, 10, 20}), index->list_offsets());
+  const float c0 = index->centroids()[0];
+  const float c1 = index->centroids()[1];
+  EXPECT_NEAR(4.5, std::min(c0, c1), 1e-5);
+  EXPECT_NEAR(104.5, std::max(c0, c1), 1e-5);
+}
+
+TEST(IVFIndexTest, SearchOneProbe) {
+  std::vector<float> points;
+  std::vector<int64> ids;
+  MakeTwoClusters(&points, &ids);
+  std::unique_ptr<IVFIndex> index;
+  TF_ASSERT_OK(IVFIndex::Build(points.data(), ids.data(), ids.size(), 1, 2,
+                               10, nullptr, &index));
+  // Only the list of the lower cluster is scanned, so 100 is missed
+  // although it is as near as 8.
+  const float query = 54;
+  std::vector<float> distances(2);
+  std::vector<int64> result(2);
+  index->Search(&query, 2, 1, distances.data(), result.data());
+  EXPECT_EQ(std::vector<int64>({90, 80}), result);
+  EXPECT_EQ(std::vector<float>({45 * 45, 46 * 46}), distances);
+}
+
+TEST(IVFIndexTest, SearchAllProbesIsExact) {
+  std::vector<float> points;
+  std::vector<int64> ids;
+  MakeTwoClusters(&points, &ids);
+  std::unique_ptr<IVFIndex> index;
+  TF_ASSERT_OK(IVFIndex::Build(points.data(), ids.data(), ids.size(), 1, 4,
+                               10, nullptr, &index));
+  const float query = 55;
+  std::vector<float> distances(2);
+  std::vector<int64> result(2);
+  index->Search(&query, 2, 4, distances.data(), result.data());
+  EXPECT_EQ(std::vector<int64>({1000, 90}), result);
+  EXPECT_EQ(std::vector<float>({45 * 45, 46 * 46}), distances);
+}
+
+TEST(IVFIndexTest, SearchPadsMissingNeighbors) {
+  const std::vector<float> points = {0, 1};
+  const std::vector<int64> ids = {7, 8};
+  std::unique_ptr<IVFIndex> index;
+  TF_ASSERT_OK(IVFIndex::Build(points.data(), ids.data(), 2, 1, 1, 0, nullptr,
+                               &index));
+  const float query = 0.75;
+  std::vector<float> distances(3);
+  std::vector<int64> result(3);
+  index->Search(&query, 3, 1, distances.data(), result.data());
+  EXPECT_EQ(std::vector<int64>({8, 7, -1}), result);
+  EXPECT_EQ(std::numeric_limits<float>::infinity(), distances[2]);
+}
+
+TEST(IVFIndexTest, SearchBreaksTiesByPosition) {
+  const std::vector<float> points = {1, -1, 1};
+  const std::vector<int64> ids = {1, 2, 3};
+  std::unique_ptr<IVFIndex> index;
+  TF_ASSERT_OK(IVFIndex::Build(points.data(), ids.data(), 3, 1, 1, 0, nullptr,
+                               &index));
+  const float query = 0;
+  std::vector<float> distances(3);
+  std::vector<int64> result(3);
+  index->Search(&query, 3, 1, distances.data(), result.data());
+  EXPECT_EQ(std::vector<int64>({1, 2, 3}), result);
+}
+
+TEST(IVFIndexTest, BuildErrors) {
+  const std::vector<float> points = {0, 1};
+  const std::vector<int64> ids = {0, 1};
+  std::unique_ptr<IVFIndex> index;
+  EXPECT_FALSE(IVFIndex::Build(points.data(), ids.data(), 2, 1, 3, 10,
+                               nullptr, &index)
+                   .ok());
+  EXPECT_FALSE(IVFIndex::Build(points.data(), ids.data(), 2, 1, 0, 10,
+                               nullptr, &index)
+                   .ok());
+}
+
+TEST(IVFIndexTest, FromListsRoundTrip) {
+  std::vector<float> points;
+  std::vector<int64> ids;
+  MakeTwoClusters(&points, &ids);
+  std::unique_ptr<IVFIndex> index;
+  TF_ASSERT_OK(IVFIndex::Build(points.data(), ids.data(), ids.size(), 1, 2,
+                               10, nullptr, &index));
+  std::unique_ptr<IVFIndex> copy;
+  TF_ASSERT_OK(IVFIndex::FromLists(1, index->centroids(),
+                                   index->list_offsets(), index->points(),
+                                   index->ids(), &copy));
+  const float query = 103.2;
+  std::vector<float> distances(2);
+  std::vector<int64> result(2);
+  std::vector<float> copy_distances(2);
+  std::vector<int64> copy_result(2);
+  index->Search(&query, 2, 1, distances.data(), result.data());
+  copy->Search(&query, 2, 1, copy_distances.data(), copy_result.data());
+  EXPECT_EQ(result, copy_result);
+  EXPECT_EQ(distances, copy_distances);
+}
+
+TEST(IVFIndexTest, FromListsErrors) {
+  std::unique_ptr<IVFIndex> index;
+  // Offsets that do not end at the number of points.
+  EXPECT_FALSE(
+      IVFIndex::FromLists(1, {0}, {0, 1}, {0, 1}, {0, 1}, &index).ok());
+  // Decreasing offsets.
+  EXPECT_FALSE(IVFIndex::FromLists(1, {0, 1}, {0, 2, 1}, {0}, {0}, &index)
+                   .ok());
+  // Wrong number of centroid coordinates.
+  EXPECT_FALSE(IVFIndex::FromLists(2, {0}, {0, 1}, {0, 1}, {0}, &index).ok());
+}
+
+}  // namespace
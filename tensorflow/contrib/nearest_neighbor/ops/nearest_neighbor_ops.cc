@@ -13,7 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/shape_inference.h"
 
 namespace tensorflow {
 
@@ -46,4 +49,134 @@ probes: the output matrix of probes. Size `batch_size` times `num_probes`.
 table_ids: the output matrix of tables ids. Size `batch_size` times `num_probes`.
 )doc");
 
+using shape_inference::InferenceContext;
+using shape_inference::ShapeHandle;
+
+REGISTER_RESOURCE_HANDLE_OP(IVFIndexResource);
+
+REGISTER_OP("IVFIndexIsInitialized")
+    .Input("index: resource")
+    .Output("is_initialized: bool")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Checks whether an inverted file index has been built or restored.
+
+index: handle to the index.
+is_initialized: true if the index has points.
+)doc");
+
+REGISTER_OP("IVFIndexBuild")
+    .Attr("num_lists: int >= 1")
+    .Attr("num_iterations: int >= 0 = 10")
+    .Input("index: resource")
+    .Input("points: float")
+    .Input("ids: int64")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle points;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &points));
+      ShapeHandle ids;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &ids));
+      return c->Merge(c->Vector(c->Dim(points, 0)), ids, &ids);
+    })
+    .Doc(R"doc(
+Builds an inverted file index for approximate nearest neighbor search.
+
+The points are partitioned into `num_lists` lists by their nearest centroid,
+where the centroids are trained with k-means on a sample of the points. A
+search only scans the lists of the centroids nearest to the query, so with
+about `sqrt(num_points)` lists its cost grows like `sqrt(num_points)`.
+Building replaces the points the index had.
+
+index: handle to the index.
+points: the `[num_points, dim]` points to index.
+ids: the `[num_points]` ids returned for the points.
+num_lists: the number of lists, at most `num_points`.
+num_iterations: the number of k-means iterations to train the centroids.
+)doc");
+
+REGISTER_OP("IVFIndexSearch")
+    .Input("index: resource")
+    .Input("queries: float")
+    .Input("k: int32")
+    .Input("num_probes: int32")
+    .Output("distances: float")
+    .Output("ids: int64")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle queries;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &queries));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
+      shape_inference::DimensionHandle k;
+      TF_RETURN_IF_ERROR(c->MakeDimForScalarInput(2, &k));
+      ShapeHandle output = c->Matrix(c->Dim(queries, 0), k);
+      c->set_output(0, output);
+      c->set_output(1, output);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Finds approximate nearest neighbors of a batch of queries in an index.
+
+Every query scans the lists of its `num_probes` nearest centroids for its `k`
+nearest points under the squared Euclidean distance. Probing all the lists
+gives the exact nearest neighbors. The queries are searched in parallel.
+
+index: handle to the index.
+queries: the `[batch_size, dim]` queries.
+k: the number of neighbors to return per query.
+num_probes: the number of lists to scan per query.
+distances: `[batch_size, k]` squared distances to the neighbors, nearest
+  first. Missing neighbors, when fewer than `k` points were scanned, have
+  distance `inf`.
+ids: `[batch_size, k]` ids of the neighbors, or -1 for missing neighbors.
+)doc");
+
+REGISTER_OP("IVFIndexExport")
+    .Input("index: resource")
+    .Output("centroids: float")
+    .Output("list_offsets: int64")
+    .Output("points: float")
+    .Output("ids: int64")
+    .SetShapeFn([](InferenceContext* c) {
+      c->set_output(0, c->Matrix(c->UnknownDim(), c->UnknownDim()));
+      c->set_output(1, c->Vector(c->UnknownDim()));
+      c->set_output(2, c->Matrix(c->UnknownDim(), c->UnknownDim()));
+      c->set_output(3, c->Vector(c->UnknownDim()));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Exports the state of an inverted file index, e.g. to save it in checkpoints.
+
+index: handle to the index.
+centroids: the `[num_lists, dim]` centroids.
+list_offsets: the `[num_lists + 1]` offsets of the lists into `points`; list
+  `i` holds rows `[list_offsets[i], list_offsets[i + 1])`.
+points: the `[num_points, dim]` points, grouped by list.
+ids: the `[num_points]` ids of the points.
+)doc");
+
+REGISTER_OP("IVFIndexImport")
+    .Input("index: resource")
+    .Input("centroids: float")
+    .Input("list_offsets: int64")
+    .Input("points: float")
+    .Input("ids: int64")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 2, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 1, &unused));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Replaces the state of an inverted file index with exported tensors.
+
+index: handle to the index.
+centroids: the `[num_lists, dim]` centroids.
+list_offsets: the `[num_lists + 1]` offsets of the lists into `points`.
+points: the `[num_points, dim]` points, grouped by list.
+ids: the `[num_points]` ids of the points.
+)doc");
+
 }  // namespace tensorflow
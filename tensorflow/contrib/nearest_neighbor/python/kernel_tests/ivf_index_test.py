@@ -0,0 +1,123 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for IVFIndex."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+import numpy as np
+
+from tensorflow.contrib.nearest_neighbor.python.ops.nearest_neighbor_ops import IVFIndex
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import resources
+from tensorflow.python.platform import test
+from tensorflow.python.training import saver
+
+
+class IVFIndexTest(test.TestCase):
+
+  def _brute_force(self, points, queries, k):
+    distances = np.sum(
+        np.square(queries[:, np.newaxis, :] - points[np.newaxis, :, :]),
+        axis=2)
+    nearest = np.argsort(distances, axis=1, kind="mergesort")[:, :k]
+    return np.sort(distances, axis=1)[:, :k], nearest
+
+  def testAllProbesIsExact(self):
+    np.random.seed(0)
+    points = np.random.rand(500, 8).astype(np.float32)
+    queries = np.random.rand(20, 8).astype(np.float32)
+    with self.cached_session():
+      index = IVFIndex(points, np.arange(500, dtype=np.int64), num_lists=16)
+      index.initializer.run()
+      distances, ids = index.search(queries, k=5, num_probes=16)
+      expected_distances, expected_ids = self._brute_force(points, queries, 5)
+      self.assertAllEqual(expected_ids, ids.eval())
+      self.assertAllClose(expected_distances, distances.eval(), rtol=1e-4)
+
+  def testFewProbesFindsClusters(self):
+    # Well separated clusters, so scanning the nearest list is enough.
+    np.random.seed(0)
+    centers = np.array([[0, 0], [10, 0], [0, 10], [10, 10]], np.float32)
+    points = (np.repeat(centers, 50, axis=0) +
+              np.random.rand(200, 2).astype(np.float32))
+    queries = centers + 0.5
+    with self.cached_session():
+      index = IVFIndex(points, 100 + np.arange(200, dtype=np.int64),
+                       num_lists=4)
+      index.initializer.run()
+      _, ids = index.search(queries, k=3, num_probes=1)
+      _, expected_ids = self._brute_force(points, queries, 3)
+      self.assertAllEqual(100 + expected_ids, ids.eval())
+
+  def testMissingNeighbors(self):
+    with self.cached_session():
+      index = IVFIndex([[0.], [1.]], [7, 8], num_lists=1)
+      index.initializer.run()
+      distances, ids = index.search([[0.75]], k=3)
+      self.assertAllEqual([[8, 7, -1]], ids.eval())
+      self.assertAllClose([[0.0625, 0.5625, np.inf]], distances.eval())
+
+  def testSearchBeforeBuild(self):
+    with self.cached_session():
+      index = IVFIndex([[0.], [1.]], [7, 8], num_lists=1)
+      self.assertEqual(1,
+                       resources.report_uninitialized_resources().eval().size)
+      _, ids = index.search([[0.75]], k=1)
+      with self.assertRaisesOpError("has not been built"):
+        ids.eval()
+
+  def testWrongDimension(self):
+    with self.cached_session():
+      index = IVFIndex([[0.], [1.]], [7, 8], num_lists=1)
+      index.initializer.run()
+      _, ids = index.search([[0.75, 1.]], k=1)
+      with self.assertRaisesOpError("Queries have dimension 2"):
+        ids.eval()
+
+  def testTooManyLists(self):
+    with self.cached_session():
+      index = IVFIndex([[0.], [1.]], [7, 8], num_lists=3)
+      with self.assertRaisesOpError("Cannot partition 2 points"):
+        index.initializer.run()
+
+  def testSaveRestore(self):
+    np.random.seed(0)
+    points = np.random.rand(100, 4).astype(np.float32)
+    queries = np.random.rand(5, 4).astype(np.float32)
+    save_path = os.path.join(self.get_temp_dir(), "ivf_index")
+    with self.session(graph=ops.Graph()) as sess:
+      index = IVFIndex(points, np.arange(100, dtype=np.int64), num_lists=8,
+                       name="index")
+      distances, ids = index.search(queries, k=4, num_probes=2)
+      index.initializer.run()
+      expected_distances, expected_ids = sess.run([distances, ids])
+      saver.Saver().save(sess, save_path)
+
+    with self.session(graph=ops.Graph()) as sess:
+      # Different points, which the restore replaces.
+      index = IVFIndex(np.zeros([10, 4], np.float32),
+                       np.zeros([10], np.int64), num_lists=2, name="index")
+      distances, ids = index.search(queries, k=4, num_probes=2)
+      saver.Saver().restore(sess, save_path)
+      self.assertAllEqual(expected_ids, ids.eval())
+      self.assertAllEqual(expected_distances, distances.eval())
+
+
+if __name__ == "__main__":
+  test.main()
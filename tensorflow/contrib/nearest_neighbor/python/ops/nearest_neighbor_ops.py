@@ -20,7 +20,9 @@ from __future__ import print_function
 
 from tensorflow.contrib.util import loader
 from tensorflow.python.framework import ops
+from tensorflow.python.ops import resources
 from tensorflow.python.platform import resource_loader
+from tensorflow.python.training import saver
 
 _nearest_neighbor_ops = loader.load_op_library(
     resource_loader.get_path_to_datafile("_nearest_neighbor_ops.so"))
@@ -62,3 +64,112 @@ def hyperplane_lsh_probes(point_hyperplane_product,
                                                      name=name)
 
 ops.NotDifferentiable("HyperplaneLSHProbes")
+
+
+ops.NotDifferentiable("IVFIndexResourceHandleOp")
+ops.NotDifferentiable("IVFIndexIsInitialized")
+ops.NotDifferentiable("IVFIndexBuild")
+ops.NotDifferentiable("IVFIndexSearch")
+ops.NotDifferentiable("IVFIndexExport")
+ops.NotDifferentiable("IVFIndexImport")
+
+
+class _IVFIndexSaveable(saver.BaseSaverBuilder.SaveableObject):
+  """SaveableObject implementation for IVFIndex."""
+
+  def __init__(self, index_handle, name):
+    centroids, list_offsets, points, ids = (
+        _nearest_neighbor_ops.ivf_index_export(index_handle))
+    # The index is saved as a whole, so there are no slices.
+    slice_spec = ""
+    specs = [
+        saver.BaseSaverBuilder.SaveSpec(centroids, slice_spec,
+                                        name + "_centroids"),
+        saver.BaseSaverBuilder.SaveSpec(list_offsets, slice_spec,
+                                        name + "_list_offsets"),
+        saver.BaseSaverBuilder.SaveSpec(points, slice_spec, name + "_points"),
+        saver.BaseSaverBuilder.SaveSpec(ids, slice_spec, name + "_ids"),
+    ]
+    super(_IVFIndexSaveable, self).__init__(index_handle, specs, name)
+    self._index_handle = index_handle
+
+  def restore(self, restored_tensors, unused_restored_shapes):
+    centroids, list_offsets, points, ids = restored_tensors
+    return _nearest_neighbor_ops.ivf_index_import(
+        self._index_handle, centroids, list_offsets, points, ids)
+
+
+class IVFIndex(object):
+  """An inverted file index for approximate nearest neighbor search.
+
+  The indexed points are partitioned into `num_lists` lists by their nearest
+  centroid, where the centroids are trained with k-means. A search only scans
+  the lists of the `num_probes` centroids nearest to each query, so with about
+  `sqrt(num_points)` lists its cost grows like `sqrt(num_points)` rather than
+  `num_points`. Probing all the lists gives the exact nearest neighbors under
+  the squared Euclidean distance.
+
+  The index is a resource: `initializer` builds it, and it is saved in and
+  restored from checkpoints like a variable.
+  """
+
+  def __init__(self,
+               points,
+               ids,
+               num_lists,
+               num_iterations=10,
+               container=None,
+               name=None):
+    """Creates an index of `points`.
+
+    Args:
+      points: a float32 `Tensor` of shape `[num_points, dim]`.
+      ids: an int64 `Tensor` of shape `[num_points]`, the ids returned for
+        the points.
+      num_lists: the number of lists, at most `num_points`.
+      num_iterations: the number of k-means iterations to train the
+        centroids.
+      container: an optional container for the index resource.
+      name: A name for the index (optional).
+    """
+    with ops.name_scope(name, "IVFIndex", [points, ids]) as name:
+      self._handle = _nearest_neighbor_ops.ivf_index_resource_handle_op(
+          container=container, shared_name=name, name=name)
+      self._initializer = _nearest_neighbor_ops.ivf_index_build(
+          self._handle,
+          points,
+          ids,
+          num_lists=num_lists,
+          num_iterations=num_iterations)
+      is_initialized = _nearest_neighbor_ops.ivf_index_is_initialized(
+          self._handle)
+      ops.add_to_collection(ops.GraphKeys.SAVEABLE_OBJECTS,
+                            _IVFIndexSaveable(self._handle, self._handle.name))
+      resources.register_resource(self._handle, self._initializer,
+                                  is_initialized)
+
+  @property
+  def handle(self):
+    return self._handle
+
+  @property
+  def initializer(self):
+    return self._initializer
+
+  def search(self, queries, k, num_probes=1, name=None):
+    """Finds approximate nearest neighbors of a batch of queries.
+
+    Args:
+      queries: a float32 `Tensor` of shape `[batch_size, dim]`.
+      k: the number of neighbors to return per query.
+      num_probes: the number of lists to scan per query.
+      name: A name for the operation (optional).
+
+    Returns:
+      distances: `[batch_size, k]` squared distances to the neighbors,
+        nearest first, or `inf` if fewer than `k` points were scanned.
+      ids: `[batch_size, k]` ids of the neighbors, or -1 if fewer than `k`
+        points were scanned.
+    """
+    return _nearest_neighbor_ops.ivf_index_search(
+        self._handle, queries, k, num_probes, name=name)
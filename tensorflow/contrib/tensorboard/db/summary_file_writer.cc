@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/contrib/tensorboard/db/summary_file_writer.h"
 
+#include <deque>
+
 #include "tensorflow/contrib/tensorboard/db/summary_converter.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -21,6 +23,8 @@ limitations under the License.
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/events_writer.h"
 #include "tensorflow/core/util/ptr_util.h"
 
@@ -34,7 +38,12 @@ class SummaryFileWriter : public SummaryWriterInterface {
         is_initialized_(false),
         max_queue_(max_queue),
         flush_millis_(flush_millis),
-        env_(env) {}
+        env_(env) {
+    // Summaries that can be dropped under load are refused once the events
+    // waiting to be written hold this many bytes of tensors.
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_SUMMARY_WRITER_MAX_QUEUE_BYTES",
+                                    64 << 20, &max_queue_bytes_));
+  }
 
   Status Initialize(const string& logdir, const string& filename_suffix) {
     const Status is_dir = env_->IsDirectory(logdir);
@@ -50,21 +59,37 @@ class SummaryFileWriter : public SummaryWriterInterface {
     TF_RETURN_WITH_CONTEXT_IF_ERROR(
         events_writer_->InitWithSuffix(filename_suffix),
         "Could not initialize events writer.");
-    last_flush_ = env_->NowMicros();
     is_initialized_ = true;
+    writer_thread_.reset(env_->StartThread(ThreadOptions(), "summary_writer",
+                                           [this]() { WriterLoop(); }));
     return Status::OK();
   }
 
+  // Blocks until the events written before the call are in the file.
   Status Flush() override {
     mutex_lock ml(mu_);
     if (!is_initialized_) {
       return errors::FailedPrecondition("Class was not properly initialized.");
     }
-    return InternalFlush();
+    const uint64 target = num_enqueued_;
+    flush_target_ = std::max(flush_target_, target);
+    writer_cond_.notify_one();
+    while (num_written_ < target) {
+      written_cond_.wait(ml);
+    }
+    Status s = status_;
+    status_ = Status::OK();
+    return s;
   }
 
   ~SummaryFileWriter() override {
     (void)Flush();  // Ignore errors.
+    {
+      mutex_lock ml(mu_);
+      stopped_ = true;
+      writer_cond_.notify_one();
+    }
+    writer_thread_.reset();
   }
 
   Status WriteTensor(int64 global_step, Tensor t, const string& tag,
@@ -72,13 +97,19 @@ class SummaryFileWriter : public SummaryWriterInterface {
     std::unique_ptr<Event> e{new Event};
     e->set_step(global_step);
     e->set_wall_time(GetWallTime());
-    Summary::Value* v = e->mutable_summary()->add_value();
-    t.AsProtoTensorContent(v->mutable_tensor());
-    v->set_tag(tag);
-    if (!serialized_metadata.empty()) {
-      v->mutable_metadata()->ParseFromString(serialized_metadata);
-    }
-    return WriteEvent(std::move(e));
+    const bool droppable = t.NumElements() > 1;
+    return Enqueue(
+        std::move(e),
+        [t, tag, serialized_metadata](Summary* s) {
+          Summary::Value* v = s->add_value();
+          t.AsProtoTensorContent(v->mutable_tensor());
+          v->set_tag(tag);
+          if (!serialized_metadata.empty()) {
+            v->mutable_metadata()->ParseFromString(serialized_metadata);
+          }
+          return Status::OK();
+        },
+        t.TotalBytes(), droppable);
   }
 
   Status WriteScalar(int64 global_step, Tensor t, const string& tag) override {
@@ -95,9 +126,11 @@ class SummaryFileWriter : public SummaryWriterInterface {
     std::unique_ptr<Event> e{new Event};
     e->set_step(global_step);
     e->set_wall_time(GetWallTime());
-    TF_RETURN_IF_ERROR(
-        AddTensorAsHistogramToSummary(t, tag, e->mutable_summary()));
-    return WriteEvent(std::move(e));
+    return Enqueue(std::move(e),
+                   [t, tag](Summary* s) {
+                     return AddTensorAsHistogramToSummary(t, tag, s);
+                   },
+                   t.TotalBytes(), /*droppable=*/true);
   }
 
   Status WriteImage(int64 global_step, Tensor t, const string& tag,
@@ -105,9 +138,12 @@ class SummaryFileWriter : public SummaryWriterInterface {
     std::unique_ptr<Event> e{new Event};
     e->set_step(global_step);
     e->set_wall_time(GetWallTime());
-    TF_RETURN_IF_ERROR(AddTensorAsImageToSummary(t, tag, max_images, bad_color,
-                                                 e->mutable_summary()));
-    return WriteEvent(std::move(e));
+    return Enqueue(std::move(e),
+                   [t, tag, max_images, bad_color](Summary* s) {
+                     return AddTensorAsImageToSummary(t, tag, max_images,
+                                                      bad_color, s);
+                   },
+                   t.TotalBytes(), /*droppable=*/true);
   }
 
   Status WriteAudio(int64 global_step, Tensor t, const string& tag,
@@ -115,9 +151,12 @@ class SummaryFileWriter : public SummaryWriterInterface {
     std::unique_ptr<Event> e{new Event};
     e->set_step(global_step);
     e->set_wall_time(GetWallTime());
-    TF_RETURN_IF_ERROR(AddTensorAsAudioToSummary(
-        t, tag, max_outputs, sample_rate, e->mutable_summary()));
-    return WriteEvent(std::move(e));
+    return Enqueue(std::move(e),
+                   [t, tag, max_outputs, sample_rate](Summary* s) {
+                     return AddTensorAsAudioToSummary(t, tag, max_outputs,
+                                                      sample_rate, s);
+                   },
+                   t.TotalBytes(), /*droppable=*/true);
   }
 
   Status WriteGraph(int64 global_step,
@@ -130,13 +169,7 @@ class SummaryFileWriter : public SummaryWriterInterface {
   }
 
   Status WriteEvent(std::unique_ptr<Event> event) override {
-    mutex_lock ml(mu_);
-    queue_.emplace_back(std::move(event));
-    if (queue_.size() > max_queue_ ||
-        env_->NowMicros() - last_flush_ > 1000 * flush_millis_) {
-      return InternalFlush();
-    }
-    return Status::OK();
+    return Enqueue(std::move(event), nullptr, 0, /*droppable=*/false);
   }
 
   string DebugString() override { return "SummaryFileWriter"; }
@@ -146,26 +179,105 @@ class SummaryFileWriter : public SummaryWriterInterface {
     return static_cast<double>(env_->NowMicros()) / 1.0e6;
   }
 
-  Status InternalFlush() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    for (const std::unique_ptr<Event>& e : queue_) {
-      events_writer_->WriteEvent(*e);
+  // An event waiting to be written. Converting tensors to summaries, which
+  // for histograms and images costs far more than queueing them, is left to
+  // the writer thread through `fill`.
+  struct QueuedEvent {
+    std::unique_ptr<Event> event;
+    std::function<Status(Summary*)> fill;
+    int64 bytes;
+  };
+
+  // Queues an event for the writer thread. A droppable event is dropped
+  // instead when the queue already holds max_queue_bytes_ of tensors, so a
+  // slow file system bounds memory rather than stalling training steps.
+  Status Enqueue(std::unique_ptr<Event> event,
+                 std::function<Status(Summary*)> fill, int64 bytes,
+                 bool droppable) {
+    mutex_lock ml(mu_);
+    if (droppable && !queue_.empty() &&
+        queued_bytes_ + bytes > max_queue_bytes_) {
+      if (num_dropped_++ % 1000 == 0) {
+        LOG(WARNING) << "Dropped " << num_dropped_ << " summaries because "
+                     << "the summary writer is falling behind; increase "
+                     << "TF_SUMMARY_WRITER_MAX_QUEUE_BYTES to keep them.";
+      }
+      return Status::OK();
+    }
+    queue_.push_back({std::move(event), std::move(fill), bytes});
+    queued_bytes_ += bytes;
+    ++num_enqueued_;
+    if (queue_.size() > max_queue_) {
+      writer_cond_.notify_one();
     }
-    queue_.clear();
-    TF_RETURN_WITH_CONTEXT_IF_ERROR(events_writer_->Flush(),
-                                    "Could not flush events file.");
-    last_flush_ = env_->NowMicros();
     return Status::OK();
   }
 
+  // Writes the queued events in batches, flushing the file once per batch,
+  // whenever the queue is longer than max_queue_, a Flush() is waiting, or
+  // flush_millis_ has passed.
+  void WriterLoop() {
+    std::deque<QueuedEvent> batch;
+    while (true) {
+      {
+        mutex_lock ml(mu_);
+        if (queue_.size() <= max_queue_ && flush_target_ <= num_written_ &&
+            !stopped_) {
+          writer_cond_.wait_for(ml,
+                                std::chrono::milliseconds(flush_millis_));
+        }
+        if (stopped_ && queue_.empty()) return;
+        batch.swap(queue_);
+      }
+      Status s;
+      int64 bytes = 0;
+      for (QueuedEvent& e : batch) {
+        bytes += e.bytes;
+        if (e.fill) {
+          Status fill_status = e.fill(e.event->mutable_summary());
+          if (!fill_status.ok()) {
+            s.Update(fill_status);
+            continue;
+          }
+        }
+        events_writer_->WriteEvent(*e.event);
+      }
+      s.Update(events_writer_->Flush());
+      if (!s.ok()) {
+        errors::AppendToMessage(&s, "Could not write events file.");
+      }
+      {
+        mutex_lock ml(mu_);
+        num_written_ += batch.size();
+        queued_bytes_ -= bytes;
+        status_.Update(s);
+        written_cond_.notify_all();
+      }
+      batch.clear();
+    }
+  }
+
   bool is_initialized_;
   const int max_queue_;
   const int flush_millis_;
-  uint64 last_flush_;
+  int64 max_queue_bytes_;
   Env* env_;
   mutex mu_;
-  std::vector<std::unique_ptr<Event>> queue_ GUARDED_BY(mu_);
-  // A pointer to allow deferred construction.
-  std::unique_ptr<EventsWriter> events_writer_ GUARDED_BY(mu_);
+  condition_variable writer_cond_;
+  condition_variable written_cond_;
+  std::deque<QueuedEvent> queue_ GUARDED_BY(mu_);
+  int64 queued_bytes_ GUARDED_BY(mu_) = 0;
+  uint64 num_enqueued_ GUARDED_BY(mu_) = 0;
+  uint64 num_written_ GUARDED_BY(mu_) = 0;
+  uint64 num_dropped_ GUARDED_BY(mu_) = 0;
+  uint64 flush_target_ GUARDED_BY(mu_) = 0;
+  bool stopped_ GUARDED_BY(mu_) = false;
+  // The first error of the writer thread since the last Flush().
+  Status status_ GUARDED_BY(mu_);
+  // A pointer to allow deferred construction. Only the writer thread uses it
+  // once it has started.
+  std::unique_ptr<EventsWriter> events_writer_;
+  std::unique_ptr<Thread> writer_thread_;
   std::vector<std::pair<string, SummaryMetadata>> registered_summaries_
       GUARDED_BY(mu_);
 };
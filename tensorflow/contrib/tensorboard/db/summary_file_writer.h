@@ -28,7 +28,11 @@ namespace tensorflow {
 /// makes this summary writer suitable for file systems like GCS.
 ///
 /// It will enqueue up to max_queue summaries, and flush at least every
-/// flush_millis milliseconds. The summaries will be written to the
+/// flush_millis milliseconds. Summaries are converted and written by a
+/// background thread, so only Flush() waits for the file system. Under
+/// load, image, audio, histogram and non-scalar tensor summaries are
+/// dropped once the queued tensors exceed TF_SUMMARY_WRITER_MAX_QUEUE_BYTES
+/// (64MB by default). The summaries will be written to the
 /// directory specified by logdir and with the filename suffixed by
 /// filename_suffix. The caller owns a reference to result if the
 /// returned status is ok. The Env object must not be destroyed until
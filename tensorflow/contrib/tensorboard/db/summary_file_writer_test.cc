@@ -199,6 +199,46 @@ TEST_F(SummaryFileWriterTest, WriteEvent) {
                         }));
 }
 
+TEST_F(SummaryFileWriterTest, DropsSummariesWhenFallingBehind) {
+  setenv("TF_SUMMARY_WRITER_MAX_QUEUE_BYTES", "1", 1);
+  SummaryWriterInterface* writer;
+  // The writer thread only wakes up for Flush(), so the queue fills up.
+  TF_CHECK_OK(CreateSummaryFileWriter(1000, 1000000, testing::TmpDir(),
+                                      "drop_test", &env_, &writer));
+  unsetenv("TF_SUMMARY_WRITER_MAX_QUEUE_BYTES");
+  core::ScopedUnref deleter(writer);
+  Tensor t(DT_FLOAT, TensorShape({2}));
+  t.flat<float>().setConstant(1.0);
+  TF_CHECK_OK(writer->WriteHistogram(1, t, "kept"));
+  TF_CHECK_OK(writer->WriteHistogram(2, t, "dropped"));
+  Tensor one(DT_FLOAT, TensorShape({}));
+  one.scalar<float>()() = 1.0;
+  TF_CHECK_OK(writer->WriteScalar(3, one, "scalar"));
+  TF_CHECK_OK(writer->Flush());
+
+  std::vector<string> files;
+  TF_CHECK_OK(env_.GetChildren(testing::TmpDir(), &files));
+  string path;
+  for (const string& f : files) {
+    if (str_util::StrContains(f, "drop_test")) {
+      path = io::JoinPath(testing::TmpDir(), f);
+    }
+  }
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env_.NewRandomAccessFile(path, &read_file));
+  io::RecordReader reader(read_file.get(), io::RecordReaderOptions());
+  string record;
+  uint64 offset = 0;
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));  // The file version.
+  std::vector<int64> steps;
+  while (reader.ReadRecord(&offset, &record).ok()) {
+    Event e;
+    e.ParseFromString(record);
+    steps.push_back(e.step());
+  }
+  EXPECT_EQ(std::vector<int64>({1, 3}), steps);
+}
+
 TEST_F(SummaryFileWriterTest, WallTime) {
   env_.AdvanceByMillis(7023);
   TF_CHECK_OK(SummaryTestHelper(
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/contrib/tensorrt/convert/convert_graph.h"
 
+#include <algorithm>
 #include <fstream>
 #include <list>
 #include <map>
@@ -42,6 +43,8 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/utils.h"
 #include "tensorflow/core/grappler/devices.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
@@ -146,6 +149,68 @@ tensorflow::Status BuildNodeMap(
   return tensorflow::Status::OK();
 }
 
+// Estimates, with the grappler cost model, the time a node takes in
+// TensorFlow and the time spent moving a tensor across the boundary of a
+// TensorRT segment, both in nanoseconds. Unknown dimensions count as 1, so
+// that the estimates of a graph with an unknown batch size are per example.
+class SegmentCostModel {
+ public:
+  SegmentCostModel(const tensorflow::GraphDef& graph_def,
+                   const grappler::GraphProperties& graph_properties)
+      : graph_properties_(graph_properties) {
+    for (const auto& node : graph_def.node()) {
+      name_to_node_[node.name()] = &node;
+    }
+  }
+
+  double NodeBenefit(const tensorflow::Node* node) const {
+    if (!graph_properties_.HasInputProperties(node->name())) return 0;
+    grappler::OpContext op_context;
+    op_context.op_info = grappler::BuildOpInfoWithoutDevice(
+        node->def(), name_to_node_,
+        graph_properties_.GetInputProperties(node->name()));
+    if (graph_properties_.HasOutputProperties(node->name())) {
+      for (const auto& output :
+           graph_properties_.GetOutputProperties(node->name())) {
+        *op_context.op_info.add_outputs() = output;
+      }
+    }
+    *op_context.op_info.mutable_device() = DeviceOf(node);
+    return estimator_.PredictCosts(op_context).execution_time.count();
+  }
+
+  double BoundaryCost(const tensorflow::Edge* edge) const {
+    const tensorflow::Node* src = edge->src();
+    if (!graph_properties_.HasOutputProperties(src->name())) return 0;
+    const auto& outputs = graph_properties_.GetOutputProperties(src->name());
+    if (edge->src_output() >= static_cast<int>(outputs.size())) return 0;
+    const auto& output = outputs[edge->src_output()];
+    double bytes = DataTypeSize(output.dtype());
+    for (const auto& dim : output.shape().dim()) {
+      bytes *= std::max<int64>(dim.size(), 1);
+    }
+    // The tensor is written on one side of the boundary and read on the
+    // other. 1 GB/s is 1 byte per nanosecond.
+    const double gb_per_sec =
+        estimator_.GetDeviceInfo(DeviceOf(edge->dst())).gb_per_sec;
+    return gb_per_sec > 0 ? 2 * bytes / gb_per_sec : 0;
+  }
+
+ private:
+  DeviceProperties DeviceOf(const tensorflow::Node* node) const {
+    string device = node->has_assigned_device_name()
+                        ? node->assigned_device_name()
+                        : node->requested_device();
+    // Segments run on a GPU when no device is set.
+    if (device.empty()) device = "/device:GPU:0";
+    return grappler::GetDeviceInfo(device);
+  }
+
+  const grappler::GraphProperties& graph_properties_;
+  std::unordered_map<string, const tensorflow::NodeDef*> name_to_node_;
+  grappler::OpLevelCostEstimator estimator_;
+};
+
 }  // namespace
 
 // Function to get calibration from ResourceMgr and put them into nodedef.
@@ -845,10 +910,28 @@ tensorflow::Status ConvertAfterShapes(ConversionParams& params) {
     segment_options.exclude_node_list.insert(node);
   }
   segment_options.minimum_segment_size = params.minimum_segment_size;
+  std::unique_ptr<SegmentCostModel> cost_model;
+  if (params.cost_aware_segmentation) {
+    cost_model.reset(new SegmentCostModel(*params.input_graph_def,
+                                          *params.graph_properties));
+    segment_options.node_benefit_fn = [&cost_model](const Node* node) {
+      return cost_model->NodeBenefit(node);
+    };
+    segment_options.boundary_cost_fn = [&cost_model](const Edge* edge) {
+      return cost_model->BoundaryCost(edge);
+    };
+  }
   tensorflow::tensorrt::segment::SegmentNodesVector initial_segments;
+  tensorflow::tensorrt::segment::UnsegmentedNodesMap unsegmented_nodes;
   TF_RETURN_IF_ERROR(tensorrt::segment::SegmentGraph(
       &graph, IsTensorRTCandidate, InputEdgeValidator(*params.graph_properties),
-      OutputEdgeValidator(), segment_options, &initial_segments));
+      OutputEdgeValidator(), segment_options, &initial_segments,
+      &unsegmented_nodes));
+  if (VLOG_IS_ON(1)) {
+    for (const auto& it : unsegmented_nodes) {
+      VLOG(1) << "Not converting " << it.first << ": " << it.second;
+    }
+  }
   if (initial_segments.size() > 1) {
     VLOG(0) << "MULTIPLE tensorrt candidate conversion: "
             << initial_segments.size();
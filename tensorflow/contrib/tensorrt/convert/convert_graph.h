@@ -43,7 +43,8 @@ struct ConversionParams {
         cluster(nullptr),
         is_dyn_op(false),
         fixed_input_size(true),
-        max_cached_engines(1) {}
+        max_cached_engines(1),
+        cost_aware_segmentation(false) {}
   const tensorflow::GraphDef* input_graph_def;
   const std::vector<string>* output_names;
   size_t max_batch_size;
@@ -57,6 +58,9 @@ struct ConversionParams {
   bool fixed_input_size;   // Assume non-batch ranks of input tensors are fixed
   int max_cached_engines;  // maximum number of cached engines
   std::vector<int> cached_engine_batches;  // list of cached engines
+  // Whether to drop the segments that the grappler cost model estimates to
+  // cost more at their TF/TRT boundary than they save.
+  bool cost_aware_segmentation;
 };
 
 // This method extracts calibration information from the resource managers
@@ -50,6 +50,9 @@ tensorflow::Status TRTOptimizationPass::Init(
   if (params.count("is_dynamic_op")) {
     is_dynamic_op_ = params.at("is_dynamic_op").b();
   }
+  if (params.count("cost_aware_segmentation")) {
+    cost_aware_segmentation_ = params.at("cost_aware_segmentation").b();
+  }
   if (params.count("cached_engine_batches")) {
     auto batch_vec = params.at("cached_engine_batches").list();
     batches_.reserve(batch_vec.i_size());
@@ -251,6 +254,7 @@ tensorflow::Status TRTOptimizationPass::Optimize(
   cp.is_dyn_op = is_dynamic_op_;
   cp.cached_engine_batches = batches_;
   cp.max_cached_engines = max_cached_batches_;
+  cp.cost_aware_segmentation = cost_aware_segmentation_;
   auto status = tensorflow::tensorrt::convert::ConvertAfterShapes(cp);
   VLOG(1) << "Returning from " << name_;
   return status;
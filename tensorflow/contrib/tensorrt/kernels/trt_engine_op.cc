@@ -20,16 +20,21 @@ limitations under the License.
 #include "tensorflow/contrib/tensorrt/convert/utils.h"
 #include "tensorflow/contrib/tensorrt/log/trt_logger.h"
 #include "tensorflow/contrib/tensorrt/plugin/trt_plugin_factory.h"
+#include "tensorflow/contrib/tensorrt/resources/trt_engine_cache.h"
 #include "tensorflow/contrib/tensorrt/resources/trt_resource_manager.h"
 #include "tensorflow/contrib/tensorrt/resources/trt_resources.h"
 #include "tensorflow/contrib/tensorrt/test/utils.h"
 #include "tensorflow/core/framework/graph_to_functiondef.h"
 #include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 #if GOOGLE_CUDA
 #if GOOGLE_TENSORRT
@@ -53,6 +58,12 @@ class AsyncHelper : public tensorflow::core::RefCounted {
   AsyncOpKernel::DoneCallback done_;
 };
 
+// Copied from cuda_kernel_helper since it seems only valid in *.cu.cc files
+static cudaStream_t GetCudaStream(se::Stream* stream) {
+  return *CHECK_NOTNULL(reinterpret_cast<const cudaStream_t*>(
+      stream->implementation()->GpuStreamMemberHack()));
+}
+
 #define TYPECASE(dt, X, Y)                                                \
   case dt: {                                                              \
     return (void*)X->flat<tensorflow::EnumToDataType<dt>::Type>().data(); \
@@ -105,6 +116,7 @@ TRTEngineOp::TRTEngineOp(OpKernelConstruction* context)
   OP_REQUIRES_OK(context,
                  context->GetAttr("workspace_size_bytes", &workspace_size_));
   OP_REQUIRES_OK(context, context->GetAttr("static_engine", &static_engine_));
+  segment_fingerprint_ = Fingerprint64(serialized_segment_);
   if (!static_engine_) {
     if (!segment_graph_.ParseFromString(serialized_segment_)) {
       LOG(ERROR) << "Parsing segment graph failed!";
@@ -124,6 +136,12 @@ TRTEngineOp::TRTEngineOp(OpKernelConstruction* context)
   OP_REQUIRES_OK(context,
                  context->GetAttr("segment_funcdef_name", &funcdef_name_));
   OP_REQUIRES_OK(context, GetPrecisionMode(precision_string, &precision_mode_));
+  segment_fingerprint_ =
+      FingerprintCat64(segment_fingerprint_, Fingerprint64(calibration_data));
+  OP_REQUIRES_OK(context, ReadStringFromEnvVar("TF_TRT_ENGINE_CACHE_DIR", "",
+                                               &engine_cache_dir_));
+  OP_REQUIRES_OK(context, ReadInt64FromEnvVar("TF_TRT_NUM_EXECUTION_STREAMS",
+                                              0, &max_execution_streams_));
   calibration_mode_ =
       (precision_mode_ == INT8MODE && calibration_data.size() == 0);
   if (calibration_data.size()) {
@@ -289,20 +307,94 @@ void TRTEngineOp::ComputeAsync(OpKernelContext* ctx,
     ExecuteNativeSegment(ctx, helper);
     return;
   }
-  const bool retry = ExecuteTrtEngine(ctx, num_batch, trt_engine_ptr.get(),
-                                      engine_ctx_pair.second.get());
+  se::Stream* compute_stream = ctx->op_device_context()->stream();
+  ExecutionSlot* slot =
+      AcquireExecutionSlot(smallest_engine, trt_engine_ptr.get(), ctx);
+  if (slot == nullptr) {
+    // Synchronization will be done by TF.
+    const bool retry =
+        ExecuteTrtEngine(ctx, num_batch, trt_engine_ptr.get(),
+                         engine_ctx_pair.second.get(),
+                         GetCudaStream(compute_stream));
+    if (retry) {
+      LOG(WARNING) << "Failed to execute engine, "
+                   << "retrying with native segment for " << name();
+      ExecuteNativeSegment(ctx, helper);
+    }
+    return;
+  }
+  // The stream of the slot runs the engine after the work queued so far on
+  // the compute stream, which produces the inputs and last used the memory of
+  // the outputs, but does not hold back later work of the compute stream.
+  slot->stream->ThenWaitFor(compute_stream);
+  const bool retry =
+      ExecuteTrtEngine(ctx, num_batch, trt_engine_ptr.get(),
+                       slot->context.get(), GetCudaStream(slot->stream.get()));
   if (retry) {
+    ReleaseExecutionSlot(slot);
     LOG(WARNING) << "Failed to execute engine, "
                  << "retrying with native segment for " << name();
     ExecuteNativeSegment(ctx, helper);
     return;
   }
+  // The consumers of the outputs run on the compute stream, so done() is only
+  // called once the engine has finished. The inputs are kept alive until then.
+  std::vector<Tensor> inputs;
+  for (int i = 0; i < ctx->num_inputs(); i++) {
+    inputs.push_back(ctx->input(i));
+  }
+  auto* workers = ctx->device()->tensorflow_cpu_worker_threads()->workers;
+  helper->Ref();
+  slot->stream->ThenDoHostCallback([this, slot, helper, inputs, workers]() {
+    // done() may enqueue GPU work, which is not allowed in a stream callback.
+    workers->Schedule([this, slot, helper, inputs]() {
+      ReleaseExecutionSlot(slot);
+      helper->Unref();
+    });
+  });
+}
+
+TRTEngineOp::ExecutionSlot* TRTEngineOp::AcquireExecutionSlot(
+    int batch_size, nvinfer1::ICudaEngine* engine, OpKernelContext* ctx) {
+  if (max_execution_streams_ <= 0) return nullptr;
+  mutex_lock lock(slot_mutex_);
+  auto& slots = execution_slots_[batch_size];
+  for (auto& slot : slots) {
+    if (!slot->busy) {
+      slot->busy = true;
+      return slot.get();
+    }
+  }
+  if (slots.size() >= max_execution_streams_) return nullptr;
+  // The execution context allocates its scratch space through the allocator
+  // of the engine, so every slot has its own.
+  std::unique_ptr<ExecutionSlot> slot(new ExecutionSlot);
+  slot->context.reset(engine->createExecutionContext());
+  slot->stream.reset(
+      new se::Stream(ctx->op_device_context()->stream()->parent()));
+  slot->stream->Init();
+  if (!slot->context || !slot->stream->ok()) {
+    LOG(WARNING) << "Failed to create an execution stream for " << name()
+                 << ", running on the compute stream";
+    return nullptr;
+  }
+  VLOG(1) << "Created execution stream " << slots.size() << " of " << name()
+          << " for batch size " << batch_size;
+  slot->busy = true;
+  slots.push_back(std::move(slot));
+  return slots.back().get();
+}
+
+void TRTEngineOp::ReleaseExecutionSlot(ExecutionSlot* slot) {
+  mutex_lock lock(slot_mutex_);
+  slot->busy = false;
 }
 
 bool TRTEngineOp::ExecuteTrtEngine(
     OpKernelContext* ctx, const int num_batch,
     nvinfer1::ICudaEngine* trt_engine_ptr,
-    nvinfer1::IExecutionContext* trt_execution_context_ptr) {
+    nvinfer1::IExecutionContext* trt_execution_context_ptr,
+    cudaStream_t stream) {
   const bool kRetry = true;
   const int num_binding = ctx->num_inputs() + ctx->num_outputs();
   std::vector<void*> buffers(num_binding);
@@ -394,28 +486,24 @@ bool TRTEngineOp::ExecuteTrtEngine(
         return kRetry;
     }
   }
-  // Copied from cuda_kernel_helper since it seems only valid in *.cu.cc files
-  const cudaStream_t* stream = CHECK_NOTNULL(
-      reinterpret_cast<const cudaStream_t*>(ctx->op_device_context()
-                                                ->stream()
-                                                ->implementation()
-                                                ->GpuStreamMemberHack()));
-
   // TODO(jie): trt enqueue does not return error
-  auto ret = trt_execution_context_ptr->enqueue(num_batch, &buffers[0], *stream,
+  auto ret = trt_execution_context_ptr->enqueue(num_batch, &buffers[0], stream,
                                                 nullptr);
   if (!ret) {
     LOG(WARNING) << "Failed to enqueue batch for TRT engine: " << name();
     return kRetry;
   }
   test::AddTestValue(StrCat(name(), ":ExecuteTrtEngine"), "done");
-  // Synchronization will be done by TF.
   return !kRetry;
 }
 
 TRTEngineOp::~TRTEngineOp() {
   // We need to manually destroy the engine and execution context before
   // the allocator is destructed.
+  {
+    mutex_lock lock(slot_mutex_);
+    execution_slots_.clear();
+  }
   for (auto& eng : engine_map_) {
     eng.second.first.reset();
     eng.second.second.reset();
@@ -436,6 +524,75 @@ nvinfer1::IGpuAllocator* TRTEngineOp::GetAllocator(OpKernelContext* ctx) {
   return allocator_.get();
 }
 
+string TRTEngineOp::EngineCachePath(
+    OpKernelContext* ctx, int batch_size,
+    const std::vector<PartialTensorShape>& shapes) {
+  if (engine_cache_dir_.empty()) return "";
+  const auto* gpu_info = ctx->device()->tensorflow_gpu_device_info();
+  cudaDeviceProp properties;
+  if (gpu_info == nullptr ||
+      cudaGetDeviceProperties(&properties, gpu_info->gpu_id) != cudaSuccess) {
+    LOG(WARNING) << "Can't get the GPU model of " << ctx->device()->name()
+                 << ", not caching the engines of " << name();
+    return "";
+  }
+  TrtEngineCacheKey key;
+  key.segment_fingerprint = segment_fingerprint_;
+  key.precision_mode = precision_mode_;
+  key.batch_size = batch_size;
+  key.workspace_size = workspace_size_;
+  key.gpu_model = StrCat(properties.name, ",", properties.major, ".",
+                         properties.minor);
+  key.trt_version = getInferLibVersion();
+  for (const auto& shape : shapes) {
+    key.input_shapes.push_back(shape.DebugString());
+  }
+  return io::JoinPath(engine_cache_dir_, TrtEngineCacheFileName(key));
+}
+
+TrtUniquePtrType<nvinfer1::ICudaEngine> TRTEngineOp::LoadCachedEngine(
+    const string& path, nvinfer1::IGpuAllocator* allocator) {
+  Env* env = Env::Default();
+  string contents;
+  if (!env->FileExists(path).ok()) return nullptr;
+  auto status = ReadFileToString(env, path, &contents);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to read cached engine " << path << ": " << status;
+    return nullptr;
+  }
+  StringPiece serialized;
+  status = DecodeTrtEngineCacheEntry(contents, &serialized);
+  if (!status.ok()) {
+    LOG(WARNING) << "Ignoring cached engine " << path << ": " << status;
+    return nullptr;
+  }
+  TrtUniquePtrType<IRuntime> infer(nvinfer1::createInferRuntime(logger));
+  infer->setGpuAllocator(allocator);
+  TrtUniquePtrType<nvinfer1::ICudaEngine> engine(infer->deserializeCudaEngine(
+      serialized.data(), serialized.size(),
+      PluginFactoryTensorRT::GetInstance()));
+  if (!engine) {
+    LOG(WARNING) << "Failed to deserialize cached engine " << path;
+  }
+  return engine;
+}
+
+void TRTEngineOp::SaveCachedEngine(const string& path,
+                                   nvinfer1::ICudaEngine* engine) {
+  TrtUniquePtrType<nvinfer1::IHostMemory> serialized(engine->serialize());
+  if (!serialized) {
+    LOG(WARNING) << "Failed to serialize the engine of " << name();
+    return;
+  }
+  const string contents = EncodeTrtEngineCacheEntry(
+      StringPiece(static_cast<const char*>(serialized->data()),
+                  serialized->size()));
+  auto status = WriteTrtEngineCacheEntry(Env::Default(), path, contents);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to write cached engine " << path << ": " << status;
+  }
+}
+
 TRTEngineOp::EngineCtxPair& TRTEngineOp::GetEngine(int batch_size,
                                                    OpKernelContext* ctx) {
   static EngineCtxPair null_pair = {
@@ -489,27 +646,41 @@ TRTEngineOp::EngineCtxPair& TRTEngineOp::GetEngine(int batch_size,
     for (int i = 0; i < ctx->num_inputs(); ++i) {
       shapes.emplace_back(ctx->input(i).shape());
     }
+    const string cache_path = EngineCachePath(ctx, batch_size, shapes);
     TrtUniquePtrType<nvinfer1::ICudaEngine> engine;
-    bool convert_successfully = false;
-    VLOG(0) << name() << " Constructing a new engine with batch size "
-            << batch_size;
-    // Up to this point, calibrator_ can never be empty, since otherwise it
-    // means calibration_mode_ is true and this path won't get executed.
-    auto status = convert::ConvertGraphDefToEngine(
-        segment_graph_, precision_mode_, batch_size, workspace_size_, shapes,
-        &logger, allocator, calibrator_.get(), &engine, &convert_successfully);
-    if (!status.ok()) {
-      if (convert_successfully) {
-        // This means it fail to build the engine even when the network is built
-        // successfully, probably due to internal issues. In this case we don't
-        // retry in the future.
-        engine_map_[batch_size] = {nullptr, nullptr};
+    if (!cache_path.empty()) {
+      engine = LoadCachedEngine(cache_path, allocator);
+      if (engine) {
+        VLOG(1) << name() << " Loaded the engine with batch size "
+                << batch_size << " from " << cache_path;
+      }
+    }
+    if (!engine) {
+      bool convert_successfully = false;
+      VLOG(0) << name() << " Constructing a new engine with batch size "
+              << batch_size;
+      // Up to this point, calibrator_ can never be empty, since otherwise it
+      // means calibration_mode_ is true and this path won't get executed.
+      auto status = convert::ConvertGraphDefToEngine(
+          segment_graph_, precision_mode_, batch_size, workspace_size_, shapes,
+          &logger, allocator, calibrator_.get(), &engine,
+          &convert_successfully);
+      if (!status.ok()) {
+        if (convert_successfully) {
+          // This means it fail to build the engine even when the network is
+          // built successfully, probably due to internal issues. In this case
+          // we don't retry in the future.
+          engine_map_[batch_size] = {nullptr, nullptr};
+        }
+        LOG(WARNING) << "Engine creation for batch size " << batch_size
+                     << " failed " << status;
+        return null_pair;
+      }
+      VLOG(1) << "Conversion is done";
+      if (!cache_path.empty()) {
+        SaveCachedEngine(cache_path, engine.get());
       }
-      LOG(WARNING) << "Engine creation for batch size " << batch_size
-                   << " failed " << status;
-      return null_pair;
     }
-    VLOG(1) << "Conversion is done";
     TrtUniquePtrType<nvinfer1::IExecutionContext> exec_context(
         engine->createExecutionContext());
     engine_map_[batch_size] = {std::move(engine), std::move(exec_context)};
@@ -27,6 +27,8 @@ limitations under the License.
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 #if GOOGLE_CUDA
 #if GOOGLE_TENSORRT
@@ -60,11 +62,12 @@ class TRTEngineOp : public AsyncOpKernel {
   // Execute replaced native segment as function Op.
   void ExecuteNativeSegment(OpKernelContext* ctx, AsyncHelper* helper);
 
-  // Execute the tensorrt engine. Returns whether we need to retry by running
-  // the native segment.
+  // Execute the tensorrt engine on "stream". Returns whether we need to retry
+  // by running the native segment.
   bool ExecuteTrtEngine(OpKernelContext* ctx, const int num_batch,
                         nvinfer1::ICudaEngine* trt_engine_ptr,
-                        nvinfer1::IExecutionContext* trt_execution_context_ptr);
+                        nvinfer1::IExecutionContext* trt_execution_context_ptr,
+                        cudaStream_t stream);
 
   // Allocate necessary resources for calibration
   Status AllocateCalibrationResources(OpKernelContext* ctx,
@@ -81,6 +84,37 @@ class TRTEngineOp : public AsyncOpKernel {
 
   nvinfer1::IGpuAllocator* GetAllocator(OpKernelContext* ctx);
 
+  // Returns the path of the on-disk cache entry of the engine for
+  // "batch_size" and the input "shapes", or an empty string if engines are
+  // not cached on disk.
+  string EngineCachePath(OpKernelContext* ctx, int batch_size,
+                         const std::vector<PartialTensorShape>& shapes);
+
+  // Returns the engine cached at "path", or nullptr if there is none.
+  TrtUniquePtrType<nvinfer1::ICudaEngine> LoadCachedEngine(
+      const string& path, nvinfer1::IGpuAllocator* allocator);
+
+  // Writes "engine" to the cache entry at "path".
+  void SaveCachedEngine(const string& path, nvinfer1::ICudaEngine* engine);
+
+  // An extra execution context of an engine with a stream of its own, so that
+  // concurrent runs of the engine do not serialize on the compute stream.
+  struct ExecutionSlot {
+    TrtUniquePtrType<nvinfer1::IExecutionContext> context;
+    std::unique_ptr<se::Stream> stream;
+    bool busy = false;
+  };
+
+  // Returns an idle execution slot of "engine", the engine for "batch_size",
+  // creating one if it has fewer than max_execution_streams_. Returns nullptr
+  // if all of them are busy, in which case the shared execution context runs
+  // on the compute stream.
+  ExecutionSlot* AcquireExecutionSlot(int batch_size,
+                                      nvinfer1::ICudaEngine* engine,
+                                      OpKernelContext* ctx);
+
+  void ReleaseExecutionSlot(ExecutionSlot* slot);
+
   // map to keep engines and their execution context for given batch size.
   std::unordered_map<int, EngineCtxPair> engine_map_;
   std::vector<string> input_nodes_;
@@ -125,7 +159,27 @@ class TRTEngineOp : public AsyncOpKernel {
   int max_cached_engines_;
 
   int64 workspace_size_;
+
+  // Directory of the on-disk cache of the dynamic engines, shared by the
+  // processes serving the model, or empty. Read from the
+  // TF_TRT_ENGINE_CACHE_DIR environment variable.
+  string engine_cache_dir_;
+
+  // Fingerprint of the segment and its calibration data.
+  uint64 segment_fingerprint_;
+
   mutex engine_mutex_;
+
+  // Maximum number of extra execution slots per engine. Read from the
+  // TF_TRT_NUM_EXECUTION_STREAMS environment variable; 0 runs every request
+  // on the compute stream.
+  int64 max_execution_streams_;
+
+  mutex slot_mutex_;
+  // Extra execution slots of the engines, by batch size.
+  std::unordered_map<int, std::vector<std::unique_ptr<ExecutionSlot>>>
+      execution_slots_ GUARDED_BY(slot_mutex_);
+
   FunctionLibraryRuntime::Handle native_func_;
 
   // The finalized calibrator for inference.
@@ -27,4 +27,5 @@ from tensorflow.contrib.tensorrt.python.trt_convert import create_inference_grap
 from tensorflow.contrib.tensorrt.python.trt_convert import enable_test_value
 from tensorflow.contrib.tensorrt.python.trt_convert import get_test_value
 from tensorflow.contrib.tensorrt.python.trt_convert import is_tensorrt_enabled
+from tensorflow.contrib.tensorrt.python.trt_convert import warm_up_engine_cache
 # pylint: enable=unused-import,line-too-long
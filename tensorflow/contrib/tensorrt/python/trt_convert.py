@@ -18,6 +18,9 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import os
+
+import numpy as np
 import six as _six
 # pylint: disable=unused-import,line-too-long
 from tensorflow.contrib.tensorrt.wrap_conversion import add_test_value
@@ -34,6 +37,7 @@ from tensorflow.core.protobuf import config_pb2
 from tensorflow.core.protobuf import meta_graph_pb2
 from tensorflow.core.protobuf import rewriter_config_pb2
 from tensorflow.python.client import session
+from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import errors_impl as _impl
 from tensorflow.python.framework import graph_util
 from tensorflow.python.framework import importer
@@ -70,7 +74,8 @@ def tensorrt_rewriter_config(rewriter_config=None,
                              minimum_segment_size=3,
                              is_dynamic_op=False,
                              maximum_cached_engines=1,
-                             cached_engine_batch_sizes=None):
+                             cached_engine_batch_sizes=None,
+                             cost_aware_segmentation=False):
   """Returns a RewriterConfig proto for TRT transformation.
 
   Args:
@@ -95,6 +100,9 @@ def tensorrt_rewriter_config(rewriter_config=None,
       use this list to determine the batch sizes of the cached engines, instead
       of making the decision on the fly. This is useful when we know the most
       common batch size(s) the application is going to generate.
+    cost_aware_segmentation: whether to keep only the subgraphs that the
+      Grappler cost model estimates to save more time than moving their input
+      and output tensors across the TensorRT boundary costs.
 
   Returns:
     A RewriterConfig proto which sets a TensorRTOptimizer to run Grappler.
@@ -126,6 +134,7 @@ def tensorrt_rewriter_config(rewriter_config=None,
       "max_workspace_size_bytes"].i = max_workspace_size_bytes
   optimizer.parameter_map["precision_mode"].s = _to_bytes(precision_mode)
   optimizer.parameter_map["maximum_cached_engines"].i = maximum_cached_engines
+  optimizer.parameter_map["cost_aware_segmentation"].b = cost_aware_segmentation
   if cached_engine_batch_sizes:
     if not isinstance(cached_engine_batch_sizes, list):
       raise TypeError("cached_engine_batch_sizes should be a list.")
@@ -150,7 +159,8 @@ def create_inference_graph(input_graph_def,
                            input_saved_model_dir=None,
                            input_saved_model_tags=None,
                            output_saved_model_dir=None,
-                           session_config=None):
+                           session_config=None,
+                           cost_aware_segmentation=False):
   """Python wrapper for the TRT transformation.
 
   Args:
@@ -189,6 +199,9 @@ def create_inference_graph(input_graph_def,
       input_saved_model_dir is specified and input_graph_def is None.
     session_config: the ConfigProto used to create a Session. If not specified,
       a default ConfigProto will be used.
+    cost_aware_segmentation: whether to keep only the subgraphs that the
+      Grappler cost model estimates to save more time than moving their input
+      and output tensors across the TensorRT boundary costs.
 
   Returns:
     A GraphDef transformed from input_graph_def (or the SavedModel graph def
@@ -322,7 +335,7 @@ def create_inference_graph(input_graph_def,
   rewriter_config = tensorrt_rewriter_config(
       rewriter_config, max_batch_size, max_workspace_size_bytes, precision_mode,
       minimum_segment_size, is_dynamic_op, maximum_cached_engines,
-      cached_engine_batch_sizes)
+      cached_engine_batch_sizes, cost_aware_segmentation)
 
   # Run Grappler.
   transformed_graph_def = tf_optimizer.OptimizeGraph(
@@ -384,3 +397,51 @@ def calib_graph_to_infer_graph(calibration_graph_def, is_dynamic_op=False):
   output_graph_def.ParseFromString(output_graph_def_string)
   del output_graph_def_string  # Save some memory
   return output_graph_def
+
+
+def warm_up_engine_cache(inference_graph_def, input_shapes, output_names,
+                         batch_sizes, engine_cache_dir):
+  """Builds the dynamic engines of a converted graph into an engine cache.
+
+  Runs `inference_graph_def` once for each batch size with zero-valued
+  inputs, so that its dynamic TRTEngineOps build their engines and write them
+  to `engine_cache_dir`. Processes that run the graph with the
+  TF_TRT_ENGINE_CACHE_DIR environment variable set to the same directory then
+  load the engines instead of building them. The engines are only reused on
+  the same GPU model and TensorRT version.
+
+  Args:
+    inference_graph_def: a GraphDef returned by `create_inference_graph` with
+      `is_dynamic_op=True`.
+    input_shapes: a dict from the names of the placeholders feeding the graph
+      to the shapes of their inputs, without the batch dimension.
+    output_names: the names of the tensors to fetch.
+    batch_sizes: the batch sizes to build engines for.
+    engine_cache_dir: the directory of the cache. It may be on a filesystem
+      shared by the serving processes.
+
+  Raises:
+    ValueError: if an input of `input_shapes` is not a placeholder of the
+      graph.
+  """
+  placeholders = {
+      node.name: node
+      for node in inference_graph_def.node
+      if node.op == "Placeholder"
+  }
+  for name in input_shapes:
+    if name not in placeholders:
+      raise ValueError("%s is not a placeholder of the graph" % name)
+  # TRTEngineOp reads the cache directory when it is created, which happens
+  # on the first run.
+  os.environ["TF_TRT_ENGINE_CACHE_DIR"] = engine_cache_dir
+  with ops.Graph().as_default() as graph:
+    importer.import_graph_def(inference_graph_def, name="")
+    with session.Session(graph=graph) as sess:
+      for batch_size in batch_sizes:
+        feed_dict = {}
+        for name, shape in input_shapes.items():
+          dtype = dtypes.as_dtype(placeholders[name].attr["dtype"].type)
+          feed_dict[name + ":0"] = np.zeros([batch_size] + list(shape),
+                                            dtype=dtype.as_numpy_dtype)
+        sess.run(output_names, feed_dict=feed_dict)
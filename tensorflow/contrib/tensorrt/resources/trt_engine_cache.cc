@@ -0,0 +1,81 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/tensorrt/resources/trt_engine_cache.h"
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/fingerprint.h"
+
+namespace tensorflow {
+namespace tensorrt {
+
+namespace {
+
+// Starts every entry of the on-disk engine cache. Bump the version when the
+// layout of the entries changes.
+const char kEngineCacheHeader[] = "TFTRT engine cache v1\n";
+
+}  // namespace
+
+string TrtEngineCacheFileName(const TrtEngineCacheKey& key) {
+  uint64 fingerprint = FingerprintCat64(
+      key.segment_fingerprint,
+      Fingerprint64(strings::StrCat(kEngineCacheHeader, key.precision_mode,
+                                    ",", key.batch_size, ",",
+                                    key.workspace_size, ",", key.gpu_model,
+                                    ",", key.trt_version)));
+  for (const string& shape : key.input_shapes) {
+    fingerprint = FingerprintCat64(fingerprint, Fingerprint64(shape));
+  }
+  return strings::Printf("%016llx.trtengine",
+                         static_cast<unsigned long long>(fingerprint));
+}
+
+string EncodeTrtEngineCacheEntry(StringPiece serialized_engine) {
+  return strings::StrCat(kEngineCacheHeader, serialized_engine);
+}
+
+Status DecodeTrtEngineCacheEntry(StringPiece contents,
+                                 StringPiece* serialized_engine) {
+  if (!str_util::ConsumePrefix(&contents, kEngineCacheHeader)) {
+    return errors::DataLoss(
+        "Unknown or corrupt header of a TensorRT engine cache entry");
+  }
+  if (contents.empty()) {
+    return errors::DataLoss("TensorRT engine cache entry without an engine");
+  }
+  *serialized_engine = contents;
+  return Status::OK();
+}
+
+Status WriteTrtEngineCacheEntry(Env* env, const string& path,
+                                StringPiece contents) {
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(string(io::Dirname(path))));
+  const string tmp_path = strings::Printf(
+      "%s.tmp%016llx", path.c_str(),
+      static_cast<unsigned long long>(random::New64()));
+  Status status = WriteStringToFile(env, tmp_path, contents);
+  if (status.ok()) status = env->RenameFile(tmp_path, path);
+  if (!status.ok()) env->DeleteFile(tmp_path).IgnoreError();
+  return status;
+}
+
+}  // namespace tensorrt
+}  // namespace tensorflow
@@ -0,0 +1,70 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CONTRIB_TENSORRT_RESOURCES_TRT_ENGINE_CACHE_H_
+#define TENSORFLOW_CONTRIB_TENSORRT_RESOURCES_TRT_ENGINE_CACHE_H_
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace tensorrt {
+
+// Everything a serialized TensorRT engine depends on, and that therefore
+// tells the entries of the on-disk engine cache apart.
+struct TrtEngineCacheKey {
+  // Fingerprint of the segment and of its calibration data.
+  uint64 segment_fingerprint = 0;
+  int precision_mode = 0;
+  int batch_size = 0;
+  int64 workspace_size = 0;
+  // Model and compute capability of the GPU, since an engine only runs on the
+  // GPU model it was built for.
+  string gpu_model;
+  // Version of the loaded TensorRT library.
+  int trt_version = 0;
+  // DebugString() of the shape of each input.
+  std::vector<string> input_shapes;
+};
+
+// Returns the name of the cache entry of the engine built for `key`, relative
+// to the cache directory.
+string TrtEngineCacheFileName(const TrtEngineCacheKey& key);
+
+// Returns the contents of a cache entry holding `serialized_engine`: a
+// versioned header followed by the engine.
+string EncodeTrtEngineCacheEntry(StringPiece serialized_engine);
+
+// Points `*serialized_engine` into `contents`, the contents of a cache entry.
+// Returns a DataLoss error if the entry was not written by
+// EncodeTrtEngineCacheEntry, with the same version of the header.
+Status DecodeTrtEngineCacheEntry(StringPiece contents,
+                                 StringPiece* serialized_engine);
+
+// Writes `contents` to `path`, creating its directory if needed. The contents
+// go to a temporary file first, which is then renamed to `path`, so that the
+// processes sharing the cache never read a partial entry. The temporary file
+// is removed on error.
+Status WriteTrtEngineCacheEntry(Env* env, const string& path,
+                                StringPiece contents);
+
+}  // namespace tensorrt
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CONTRIB_TENSORRT_RESOURCES_TRT_ENGINE_CACHE_H_
@@ -0,0 +1,148 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/tensorrt/resources/trt_engine_cache.h"
+
+#include <set>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace tensorrt {
+namespace {
+
+TrtEngineCacheKey TestKey() {
+  TrtEngineCacheKey key;
+  key.segment_fingerprint = 0x1234;
+  key.precision_mode = 1;
+  key.batch_size = 8;
+  key.workspace_size = 1 << 30;
+  key.gpu_model = "Tesla V100-SXM2-16GB,7.0";
+  key.trt_version = 4004;
+  key.input_shapes = {"[8,3,224,224]", "[8,10]"};
+  return key;
+}
+
+TEST(TrtEngineCacheTest, FileNameIsAFingerprintOfTheKey) {
+  const string name = TrtEngineCacheFileName(TestKey());
+  EXPECT_TRUE(str_util::EndsWith(name, ".trtengine")) << name;
+  EXPECT_EQ(16 + strlen(".trtengine"), name.size()) << name;
+  EXPECT_EQ(name, TrtEngineCacheFileName(TestKey()));
+}
+
+TEST(TrtEngineCacheTest, FileNameDependsOnEveryField) {
+  std::vector<TrtEngineCacheKey> keys(9, TestKey());
+  keys[1].segment_fingerprint = 0x4321;
+  keys[2].precision_mode = 2;
+  keys[3].batch_size = 16;
+  keys[4].workspace_size = 1 << 29;
+  keys[5].gpu_model = "Tesla P100-PCIE-16GB,6.0";
+  keys[6].trt_version = 5000;
+  keys[7].input_shapes = {"[8,3,224,224]", "[8,11]"};
+  // The order of the inputs matters too.
+  keys[8].input_shapes = {"[8,10]", "[8,3,224,224]"};
+  std::set<string> names;
+  for (const TrtEngineCacheKey& key : keys) {
+    names.insert(TrtEngineCacheFileName(key));
+  }
+  EXPECT_EQ(keys.size(), names.size());
+}
+
+TEST(TrtEngineCacheTest, DecodesEncodedEntry) {
+  const string engine("serialized\0engine", 17);
+  const string entry = EncodeTrtEngineCacheEntry(engine);
+  StringPiece decoded;
+  TF_ASSERT_OK(DecodeTrtEngineCacheEntry(entry, &decoded));
+  EXPECT_EQ(engine, decoded);
+}
+
+TEST(TrtEngineCacheTest, RejectsMismatchedOrCorruptHeader) {
+  const string entry = EncodeTrtEngineCacheEntry("engine");
+  const size_t header_size = entry.size() - strlen("engine");
+  string other_version = entry;
+  other_version[header_size - 2] = '9';
+  string corrupt = entry;
+  corrupt[0] ^= 0x20;
+  const std::vector<string> bad_entries = {
+      "",
+      "engine",
+      entry.substr(0, header_size / 2),
+      entry.substr(0, header_size),
+      other_version,
+      corrupt,
+  };
+  for (const string& bad_entry : bad_entries) {
+    StringPiece decoded;
+    Status status = DecodeTrtEngineCacheEntry(bad_entry, &decoded);
+    EXPECT_TRUE(errors::IsDataLoss(status))
+        << str_util::CEscape(bad_entry) << ": " << status;
+  }
+}
+
+class TrtEngineCacheWriteTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = io::JoinPath(testing::TmpDir(),
+                        ::testing::UnitTest::GetInstance()
+                            ->current_test_info()
+                            ->name());
+    int64 undeleted_files, undeleted_dirs;
+    env_->DeleteRecursively(dir_, &undeleted_files, &undeleted_dirs)
+        .IgnoreError();
+  }
+
+  Env* env_ = Env::Default();
+  string dir_;
+};
+
+TEST_F(TrtEngineCacheWriteTest, WritesThenRenames) {
+  // The cache directory is created if needed.
+  const string path = io::JoinPath(dir_, "cache", "entry.trtengine");
+  TF_ASSERT_OK(WriteTrtEngineCacheEntry(env_, path, "first"));
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(env_, path, &contents));
+  EXPECT_EQ("first", contents);
+
+  // An existing entry is replaced as a whole.
+  TF_ASSERT_OK(WriteTrtEngineCacheEntry(env_, path, "second"));
+  TF_ASSERT_OK(ReadFileToString(env_, path, &contents));
+  EXPECT_EQ("second", contents);
+
+  // No temporary file is left behind.
+  std::vector<string> children;
+  TF_ASSERT_OK(env_->GetChildren(io::JoinPath(dir_, "cache"), &children));
+  EXPECT_EQ(std::vector<string>({"entry.trtengine"}), children);
+}
+
+TEST_F(TrtEngineCacheWriteTest, RemovesTemporaryFileOnError) {
+  // The rename fails, since a directory already sits at the path of the entry.
+  const string path = io::JoinPath(dir_, "entry.trtengine");
+  TF_ASSERT_OK(env_->RecursivelyCreateDir(path));
+  EXPECT_FALSE(WriteTrtEngineCacheEntry(env_, path, "contents").ok());
+
+  std::vector<string> children;
+  TF_ASSERT_OK(env_->GetChildren(dir_, &children));
+  EXPECT_EQ(std::vector<string>({"entry.trtengine"}), children);
+  EXPECT_TRUE(env_->IsDirectory(path).ok());
+}
+
+}  // namespace
+}  // namespace tensorrt
+}  // namespace tensorflow
@@ -33,6 +33,7 @@ namespace tensorflow {
 namespace tensorrt {
 namespace segment {
 using ::tensorflow::strings::StrAppend;
+using ::tensorflow::strings::StrCat;
 
 // A simple graph representation to mirror tensorflow::Graph. This structure
 // helps saving memory since segmenter modifies the graph in place, preventing
@@ -393,13 +394,34 @@ tensorflow::Status SegmentGraph(
     const std::function<bool(const tensorflow::Edge*)>& input_candidate_fn,
     const std::function<bool(const tensorflow::Edge*)>& output_candidate_fn,
     const SegmentOptions& options, SegmentNodesVector* segments) {
+  return SegmentGraph(tf_graph, candidate_fn, input_candidate_fn,
+                      output_candidate_fn, options, segments, nullptr);
+}
+
+tensorflow::Status SegmentGraph(
+    const tensorflow::Graph* tf_graph,
+    const std::function<bool(const tensorflow::Node*)>& candidate_fn,
+    const std::function<bool(const tensorflow::Edge*)>& input_candidate_fn,
+    const std::function<bool(const tensorflow::Edge*)>& output_candidate_fn,
+    const SegmentOptions& options, SegmentNodesVector* segments,
+    UnsegmentedNodesMap* unsegmented_nodes) {
   // Steps:
   // 1. run the segmentation algorithm to find all the segments, which uses
   //    candidate_fn to determine the candidates segment nodes;
   // 2. for each segments, remove the nodes that are inputs/outputs of the
   //    segment but are not eligible, using input/output_candidate_fn to
   //    determine the eligibilities;
-  // 3. convert the segment into expected return format and return the result.
+  // 3. drop the segments that are too small or, with a cost model, not
+  //    worth their boundary, then convert the rest into the expected return
+  //    format and return the result.
+
+  // Records the first reason why a node is in no segment.
+  auto set_reason = [unsegmented_nodes](const tensorflow::Node* node,
+                                        const string& reason) {
+    if (unsegmented_nodes != nullptr) {
+      unsegmented_nodes->emplace(node->name(), reason);
+    }
+  };
 
   // --------------------------------- Step 1 ---------------------------------
   auto graph = std::unique_ptr<SimpleGraph>(new SimpleGraph(tf_graph));
@@ -409,8 +431,14 @@ tensorflow::Status SegmentGraph(
   std::vector<UnionFind<SimpleNode*>> node_segments;
   for (int i = 0; i < graph->num_node_ids(); ++i) {
     SimpleNode* node = graph->FindNodeId(i);
-    if (options.exclude_node_list.count(node->name()) != 0 ||
-        !candidate_fn(node->tf_node())) {
+    const tensorflow::Node* tf_node = node->tf_node();
+    if (options.exclude_node_list.count(node->name()) != 0) {
+      if (tf_node->IsOp()) set_reason(tf_node, "it is in exclude_node_list");
+      node = nullptr;
+    } else if (!candidate_fn(tf_node)) {
+      if (tf_node->IsOp()) {
+        set_reason(tf_node, "it is not supported by TensorRT");
+      }
       node = nullptr;
     }
     node_segments.emplace_back(node);
@@ -586,12 +614,17 @@ tensorflow::Status SegmentGraph(
       // remove all their inputs, and for non-const output nodes remove all
       // their outputs. In this way, for common cases the number of removed
       // nodes should be minimum.
-      auto remove_nodes = [&segment_nodes](
+      auto remove_nodes = [&segment_nodes, &set_reason](
                               bool is_input_nodes,
                               std::deque<const tensorflow::Node*>* que) {
         // Run a BFS on the queue to find all the input/output nodes.
         std::set<const tensorflow::Node*> visited;
         std::set<const tensorflow::Node*> logged(que->begin(), que->end());
+        for (auto node : *que) {
+          set_reason(node, StrCat("it has an ",
+                                  is_input_nodes ? "input" : "output",
+                                  " that cannot cross the TensorRT boundary"));
+        }
         while (!que->empty()) {
           auto node = que->front();
           que->pop_front();
@@ -601,6 +634,8 @@ tensorflow::Status SegmentGraph(
                              ? node->in_nodes()
                              : node->out_nodes()) {
             if (segment_nodes.count(in)) {
+              set_reason(in, StrCat("it depends on ", node->name(),
+                                    ", which was removed from its segment"));
               que->push_back(in);
               if (VLOG_IS_ON(2)) {
                 if (!logged.count(in)) {
@@ -636,9 +671,48 @@ tensorflow::Status SegmentGraph(
     if (static_cast<int>(segment_nodes.size()) < options.minimum_segment_size) {
       VLOG(1) << "Segment " << segments->size() << " has only "
               << segment_nodes.size() << " nodes, dropping";
+      for (auto node : segment_nodes) {
+        set_reason(node, StrCat("its segment has ", segment_nodes.size(),
+                                " nodes, fewer than minimum_segment_size=",
+                                options.minimum_segment_size));
+      }
       continue;
     }
 
+    // Don't use segments that would cost more at their boundary than they
+    // save.
+    if (options.node_benefit_fn && options.boundary_cost_fn) {
+      double benefit = 0;
+      double cost = 0;
+      for (auto node : segment_nodes) {
+        benefit += options.node_benefit_fn(node);
+        for (const tensorflow::Edge* edge : node->in_edges()) {
+          if (!edge->IsControlEdge() && !edge->src()->IsSource() &&
+              !segment_nodes.count(edge->src())) {
+            cost += options.boundary_cost_fn(edge);
+          }
+        }
+        for (const tensorflow::Edge* edge : node->out_edges()) {
+          if (!edge->IsControlEdge() && !edge->dst()->IsSink() &&
+              !segment_nodes.count(edge->dst())) {
+            cost += options.boundary_cost_fn(edge);
+          }
+        }
+      }
+      if (benefit < cost) {
+        VLOG(1) << "Segment " << segments->size() << " has an estimated"
+                << " benefit of " << benefit << " for a boundary cost of "
+                << cost << ", dropping";
+        for (auto node : segment_nodes) {
+          set_reason(node,
+                     StrCat("its segment of ", segment_nodes.size(),
+                            " nodes is estimated to save ", benefit,
+                            ", less than its boundary costs, ", cost));
+        }
+        continue;
+      }
+    }
+
     // TODO(sami): Make segmenter placement aware once trtscopes are in place
     std::set<string> segment_node_names;
     for (auto node : itr.second) segment_node_names.insert(node->name());
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CONTRIB_TENSORRT_SEGMENT_SEGMENT_H_
 #define TENSORFLOW_CONTRIB_TENSORRT_SEGMENT_SEGMENT_H_
 
+#include <functional>
+#include <map>
 #include <set>
 #include <vector>
 
@@ -38,8 +40,20 @@ struct SegmentOptions {
   // Segment must contain at least this many nodes.
   int minimum_segment_size = 2;
   std::set<string> exclude_node_list;
+
+  // If both are set, a segment is only used if the estimated time its nodes
+  // take in TensorFlow, the sum of node_benefit_fn over the nodes, is at
+  // least the estimated time of passing its input and output tensors across
+  // the TensorFlow/TensorRT boundary, the sum of boundary_cost_fn over the
+  // non-control edges that cross it. Both are in the same unit.
+  std::function<double(const tensorflow::Node*)> node_benefit_fn;
+  std::function<double(const tensorflow::Edge*)> boundary_cost_fn;
 };
 
+// Map from the name of a TensorRT candidate node that is in no returned
+// segment to the reason why.
+using UnsegmentedNodesMap = std::map<string, string>;
+
 // Get the subgraphs of a graph that can be handled by TensorRT.
 //
 // @param graph tensorflow::Graph of the network
@@ -56,6 +70,16 @@ tensorflow::Status SegmentGraph(
     const std::function<bool(const tensorflow::Edge*)>& output_candidate_fn,
     const SegmentOptions& options, SegmentNodesVector* segments);
 
+// As above, and if "unsegmented_nodes" is not null, also explains why each
+// node of the graph is in no segment.
+tensorflow::Status SegmentGraph(
+    const tensorflow::Graph* tf_graph,
+    const std::function<bool(const tensorflow::Node*)>& candidate_fn,
+    const std::function<bool(const tensorflow::Edge*)>& input_candidate_fn,
+    const std::function<bool(const tensorflow::Edge*)>& output_candidate_fn,
+    const SegmentOptions& options, SegmentNodesVector* segments,
+    UnsegmentedNodesMap* unsegmented_nodes);
+
 }  // namespace segment
 }  // namespace tensorrt
 }  // namespace tensorflow
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/types.h"
@@ -255,6 +256,68 @@ TEST_F(SegmentTest, BigIfElse) {
           {{"add0", "add1"}, {"add3", "add4", "add5", "add6", "add7"}});
 }
 
+TEST_F(SegmentTest, DropsSegmentsNotWorthTheirBoundary) {
+  //           feed
+  //            ||
+  //           add0
+  //            ||
+  //           add1
+  //            ||
+  //           add2
+  //            ||
+  //           add3
+  //            ||
+  //           add4
+  //            ||
+  //           add5
+  //            ||
+  //          <sink>
+  Scope s = Scope::NewRootScope();
+  auto feed = ops::Placeholder(s.WithOpName("feed"), DT_FLOAT);
+  auto add0 = ops::Add(s.WithOpName("add0"), feed, feed);
+  auto add1 = ops::Add(s.WithOpName("add1"), add0, add0);
+  auto add2 = ops::Add(s.WithOpName("add2"), add1, add1);
+  auto add3 = ops::Add(s.WithOpName("add3"), add2, add2);
+  auto add4 = ops::Add(s.WithOpName("add4"), add3, add3);
+  auto add5 = ops::Add(s.WithOpName("add5"), add4, add4);
+  tensorflow::Graph g(OpRegistry::Global());
+  TF_EXPECT_OK(s.ToGraph(&g));
+
+  // Each node saves 1 and each boundary tensor costs 1, so {add0} with its
+  // four boundary tensors is dropped, while {add2, ..., add5} with two is
+  // kept.
+  const std::set<string> all_adds = {"add0", "add1", "add2",
+                                     "add3", "add4", "add5"};
+  SegmentOptions options;
+  options.node_benefit_fn = [](const Node* node) { return 1.0; };
+  options.boundary_cost_fn = [](const Edge* edge) { return 1.0; };
+  options.minimum_segment_size = 1;
+  SegmentNodesVector segments;
+  UnsegmentedNodesMap unsegmented_nodes;
+  const auto without_add1 = all_adds - "add1";
+  TF_EXPECT_OK(SegmentGraph(&g, MakeCandidateFn(without_add1),
+                            MakeInputEdgeCandidateFn(all_adds),
+                            MakeOutputEdgeCandidateFn(all_adds), options,
+                            &segments, &unsegmented_nodes));
+  ValidateSegment(segments, {{"add2", "add3", "add4", "add5"}});
+
+  EXPECT_EQ(3, unsegmented_nodes.size());
+  EXPECT_EQ("it is not supported by TensorRT", unsegmented_nodes["feed"]);
+  EXPECT_EQ("it is not supported by TensorRT", unsegmented_nodes["add1"]);
+  EXPECT_TRUE(str_util::StrContains(unsegmented_nodes["add0"],
+                                    "less than its boundary costs"))
+      << unsegmented_nodes["add0"];
+
+  // Without a cost model, both segments are used.
+  options.node_benefit_fn = nullptr;
+  segments.clear();
+  TF_EXPECT_OK(SegmentGraph(&g, MakeCandidateFn(without_add1),
+                            MakeInputEdgeCandidateFn(all_adds),
+                            MakeOutputEdgeCandidateFn(all_adds), options,
+                            &segments));
+  EXPECT_EQ(2, segments.size());
+}
+
 }  // namespace test
 }  // namespace segment
 }  // namespace tensorrt
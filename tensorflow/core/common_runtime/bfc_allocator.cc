@@ -18,21 +18,49 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
 
 #include "tensorflow/core/common_runtime/allocator_retry.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
+namespace {
+
+int64 NextAllocatorId() {
+  static std::atomic<int64> next_id{0};
+  return next_id.fetch_add(1);
+}
+
+int64 MemoryTimelineSize() {
+  int64 size;
+  Status s = ReadInt64FromEnvVar("TF_BFC_MEMORY_TIMELINE_SIZE", 0, &size);
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+    return 0;
+  }
+  return std::max<int64>(size, 0);
+}
+
+}  // namespace
+
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
-                           bool allow_growth, const string& name)
+                           bool allow_growth, const string& name,
+                           bool use_thread_local_cache)
     : sub_allocator_(sub_allocator),
       name_(name),
+      use_thread_local_cache_(use_thread_local_cache),
+      allocator_id_(NextAllocatorId()),
+      memory_timeline_size_(MemoryTimelineSize()),
+      bytes_in_use_cell_(metrics::GetAllocatorBytesInUseCell(name)),
       free_chunks_list_(kInvalidChunkHandle),
       next_allocation_id_(1) {
   if (allow_growth) {
@@ -181,27 +209,17 @@ void BFCAllocator::DeallocateChunk(ChunkHandle h) {
 }
 
 void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes) {
-  // Fast path: Try once to allocate without getting the retry_helper_ involved
-  void* r = AllocateRawInternal(unused_alignment, num_bytes, false);
-  if (r != nullptr) {
-    return r;
-  } else {
-    static const int64 kMaxMillisToWait = 10000;  // 10 seconds
-    return retry_helper_.AllocateRaw(
-        [this](size_t a, size_t nb, bool v) {
-          return AllocateRawInternal(a, nb, v);
-        },
-        kMaxMillisToWait, unused_alignment, num_bytes);
-  }
+  return AllocateRaw(unused_alignment, num_bytes, AllocationAttributes());
 }
 
 void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
                                 const AllocationAttributes& allocation_attr) {
+  void* result;
   if (allocation_attr.no_retry_on_failure) {
     // Return immediately upon the first failure if this is for allocating an
     // optional scratch space.
     bool dump_log_on_failure = VLOG_IS_ON(2);
-    void* result =
+    result =
         AllocateRawInternal(unused_alignment, num_bytes, dump_log_on_failure);
     if (result == nullptr) {
       static std::atomic<int32> log_counter{0};
@@ -216,9 +234,28 @@ void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
             << " memory were available.";
       }
     }
-    return result;
   } else {
-    return AllocateRaw(unused_alignment, num_bytes);
+    result = AllocateRawWithRetry(unused_alignment, num_bytes);
+  }
+  if (result != nullptr && memory_timeline_size_ > 0) {
+    RecordMemoryTimeline(num_bytes, allocation_attr.op_name);
+  }
+  return result;
+}
+
+void* BFCAllocator::AllocateRawWithRetry(size_t unused_alignment,
+                                         size_t num_bytes) {
+  // Fast path: Try once to allocate without getting the retry_helper_ involved
+  void* r = AllocateRawInternal(unused_alignment, num_bytes, false);
+  if (r != nullptr) {
+    return r;
+  } else {
+    static const int64 kMaxMillisToWait = 10000;  // 10 seconds
+    return retry_helper_.AllocateRaw(
+        [this](size_t a, size_t nb, bool v) {
+          return AllocateRawInternal(a, nb, v);
+        },
+        kMaxMillisToWait, unused_alignment, num_bytes);
   }
 }
 
@@ -246,16 +283,54 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // The BFC allocator tries to find the best fit first.
   BinNum bin_num = BinNumForSize(rounded_bytes);
 
+  // Small allocations are first served from the thread's cache, without
+  // taking lock_.
+  ThreadCache* cache = nullptr;
+  int size_class = -1;
+  if (use_thread_local_cache_ && rounded_bytes <= kMaxCachedChunkBytes) {
+    cache = GetThreadCache(/*create=*/true);
+    size_class = rounded_bytes / kMinAllocationSize - 1;
+    void* ptr = AllocateFromThreadCache(cache, size_class);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
+
   mutex_lock l(lock_);
-  void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
-  if (ptr != nullptr) {
-    return ptr;
+  if (cache != nullptr) {
+    void* ptr = RefillThreadCache(cache, size_class, unused_alignment,
+                                  rounded_bytes, num_bytes);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  } else {
+    void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+
+    // Try to extend
+    if (Extend(unused_alignment, rounded_bytes)) {
+      ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
+      if (ptr != nullptr) {
+        return ptr;
+      }
+    }
   }
 
-  // Try to extend
-  if (Extend(unused_alignment, rounded_bytes)) {
-    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
+  // Chunks held free by the thread caches may be enough to satisfy the
+  // request once they are returned to the bins and coalesced.
+  if (!thread_caches_.empty()) {
+    FlushThreadCaches();
+    void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
     if (ptr != nullptr) {
+      if (cache != nullptr) {
+        BFCAllocator::Chunk* c =
+            ChunkFromHandle(region_manager_.get_handle(ptr));
+        c->thread_cache = cache;
+        mutex_lock cl(cache->mu);
+        cache->live[ptr] = {size_class, c->size};
+      }
       return ptr;
     }
   }
@@ -313,6 +388,7 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
         stats_.bytes_in_use += chunk->size;
         stats_.max_bytes_in_use =
             std::max(stats_.max_bytes_in_use, stats_.bytes_in_use);
+        UpdateBytesInUseMetric();
         stats_.max_alloc_size =
             std::max<std::size_t>(stats_.max_alloc_size, chunk->size);
 
@@ -364,7 +440,13 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
 }
 
 void BFCAllocator::DeallocateRaw(void* ptr) {
-  DeallocateRawInternal(ptr);
+  if (memory_timeline_size_ > 0 && ptr != nullptr) {
+    const int64 num_bytes = RequestedSize(ptr);
+    DeallocateRawInternal(ptr);
+    RecordMemoryTimeline(-num_bytes, StringPiece());
+  } else {
+    DeallocateRawInternal(ptr);
+  }
   retry_helper_.NotifyDealloc();
 }
 
@@ -373,12 +455,24 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     LOG(ERROR) << "tried to deallocate nullptr";
     return;
   }
+  if (use_thread_local_cache_ && DeallocateToThreadCache(ptr)) {
+    return;
+  }
   mutex_lock l(lock_);
 
   // Find the chunk from the ptr.
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle);
 
+  // A chunk handed out by another thread's cache is returned to the bins
+  // directly.
+  BFCAllocator::Chunk* c = ChunkFromHandle(h);
+  if (c->thread_cache != nullptr) {
+    mutex_lock cl(c->thread_cache->mu);
+    c->thread_cache->live.erase(ptr);
+    c->thread_cache = nullptr;
+  }
+
   // Consider coalescing it.
   FreeAndMaybeCoalesce(h);
 
@@ -462,6 +556,7 @@ void BFCAllocator::FreeAndMaybeCoalesce(BFCAllocator::ChunkHandle h) {
 
   // Updates the stats.
   stats_.bytes_in_use -= c->size;
+  UpdateBytesInUseMetric();
 
   ChunkHandle coalesced_chunk = h;
 
@@ -486,6 +581,132 @@ void BFCAllocator::FreeAndMaybeCoalesce(BFCAllocator::ChunkHandle h) {
   InsertFreeChunkIntoBin(coalesced_chunk);
 }
 
+BFCAllocator::ThreadCache* BFCAllocator::GetThreadCache(bool create) {
+  // Most threads use very few allocators, so a linear scan is cheap.
+  static thread_local gtl::InlinedVector<std::pair<int64, ThreadCache*>, 4>
+      thread_caches;
+  for (const auto& entry : thread_caches) {
+    if (entry.first == allocator_id_) return entry.second;
+  }
+  if (!create) return nullptr;
+  ThreadCache* cache = new ThreadCache;
+  {
+    mutex_lock l(lock_);
+    thread_caches_.emplace_back(cache);
+  }
+  thread_caches.emplace_back(allocator_id_, cache);
+  return cache;
+}
+
+void* BFCAllocator::AllocateFromThreadCache(ThreadCache* cache,
+                                            int size_class) {
+  mutex_lock l(cache->mu);
+  std::vector<ThreadCache::CachedChunk>& free_chunks =
+      cache->free_chunks[size_class];
+  if (free_chunks.empty()) return nullptr;
+  const ThreadCache::CachedChunk chunk = free_chunks.back();
+  free_chunks.pop_back();
+  cache->live[chunk.ptr] = {size_class, chunk.size};
+  cached_bytes_.fetch_sub(chunk.size, std::memory_order_relaxed);
+  num_cached_allocs_.fetch_add(1, std::memory_order_relaxed);
+  return chunk.ptr;
+}
+
+void* BFCAllocator::RefillThreadCache(ThreadCache* cache, int size_class,
+                                      size_t alignment, size_t rounded_bytes,
+                                      size_t num_bytes) {
+  const BinNum bin_num = BinNumForSize(rounded_bytes);
+  void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
+  if (ptr == nullptr) {
+    if (!Extend(alignment, rounded_bytes)) return nullptr;
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
+    if (ptr == nullptr) return nullptr;
+  }
+  BFCAllocator::Chunk* chunk = ChunkFromHandle(region_manager_.get_handle(ptr));
+  chunk->thread_cache = cache;
+  const size_t chunk_size = chunk->size;
+
+  // The spares are taken from the existing free chunks only; a refill
+  // never grows the allocator beyond what the caller's request needs.
+  // FindChunkPtr accounts every chunk as an allocation, so the spares are
+  // taken back out of num_allocs and max_bytes_in_use here.
+  const int64 max_bytes_in_use = stats_.max_bytes_in_use;
+  gtl::InlinedVector<ThreadCache::CachedChunk, kCacheRefillChunks> spares;
+  for (int i = 1; i < kCacheRefillChunks; ++i) {
+    void* spare = FindChunkPtr(bin_num, rounded_bytes, rounded_bytes);
+    if (spare == nullptr) break;
+    BFCAllocator::Chunk* c = ChunkFromHandle(region_manager_.get_handle(spare));
+    c->thread_cache = cache;
+    --stats_.num_allocs;
+    spares.push_back({spare, c->size});
+  }
+  if (!spares.empty()) {
+    stats_.max_bytes_in_use = max_bytes_in_use;
+  }
+
+  mutex_lock l(cache->mu);
+  cache->live[ptr] = {size_class, chunk_size};
+  std::vector<ThreadCache::CachedChunk>& free_chunks =
+      cache->free_chunks[size_class];
+  for (const ThreadCache::CachedChunk& spare : spares) {
+    free_chunks.push_back(spare);
+    cached_bytes_.fetch_add(spare.size, std::memory_order_relaxed);
+  }
+  return ptr;
+}
+
+bool BFCAllocator::DeallocateToThreadCache(void* ptr) {
+  ThreadCache* cache = GetThreadCache(/*create=*/false);
+  if (cache == nullptr) return false;
+  {
+    mutex_lock l(cache->mu);
+    auto it = cache->live.find(ptr);
+    if (it == cache->live.end()) return false;
+    const int size_class = it->second.first;
+    const size_t chunk_size = it->second.second;
+    cache->live.erase(it);
+    std::vector<ThreadCache::CachedChunk>& free_chunks =
+        cache->free_chunks[size_class];
+    free_chunks.push_back({ptr, chunk_size});
+    cached_bytes_.fetch_add(chunk_size, std::memory_order_relaxed);
+    if (free_chunks.size() <= static_cast<size_t>(kMaxCachedChunksPerClass)) {
+      return true;
+    }
+  }
+  mutex_lock l(lock_);
+  DrainThreadCache(cache, kMaxCachedChunksPerClass / 2);
+  return true;
+}
+
+void BFCAllocator::DrainThreadCache(ThreadCache* cache, int max_chunks) {
+  gtl::InlinedVector<void*, kMaxCachedChunksPerClass> drained;
+  {
+    mutex_lock l(cache->mu);
+    for (int i = 0; i < kNumCachedSizeClasses; ++i) {
+      std::vector<ThreadCache::CachedChunk>& free_chunks =
+          cache->free_chunks[i];
+      while (free_chunks.size() > static_cast<size_t>(max_chunks)) {
+        drained.push_back(free_chunks.back().ptr);
+        cached_bytes_.fetch_sub(free_chunks.back().size,
+                                std::memory_order_relaxed);
+        free_chunks.pop_back();
+      }
+    }
+  }
+  for (void* ptr : drained) {
+    BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
+    CHECK(h != kInvalidChunkHandle);
+    ChunkFromHandle(h)->thread_cache = nullptr;
+    FreeAndMaybeCoalesce(h);
+  }
+}
+
+void BFCAllocator::FlushThreadCaches() {
+  for (const auto& cache : thread_caches_) {
+    DrainThreadCache(cache.get(), 0);
+  }
+}
+
 bool BFCAllocator::TracksAllocationSizes() { return true; }
 
 size_t BFCAllocator::RequestedSize(const void* ptr) {
@@ -606,6 +827,14 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
               << " client-requested in use in bin.";
   }
 
+  const FragmentationStats fragmentation = ComputeFragmentationStats();
+  LOG(INFO) << "Largest free chunk: "
+            << strings::HumanReadableNumBytes(
+                   fragmentation.largest_free_chunk_bytes)
+            << " of "
+            << strings::HumanReadableNumBytes(fragmentation.free_bytes)
+            << " free, fragmentation: " << fragmentation.fragmentation;
+
   // Find the bin that we would have liked to allocate in, so we
   // can get some further analysis about fragmentation.
   Bin* b = BinForSize(num_bytes);
@@ -647,13 +876,24 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
   LOG(INFO) << "Stats: \n" << stats_.DebugString();
 }
 
+void BFCAllocator::UpdateBytesInUseMetric() {
+  bytes_in_use_cell_->Set(stats_.bytes_in_use -
+                          cached_bytes_.load(std::memory_order_relaxed));
+}
+
 void BFCAllocator::GetStats(AllocatorStats* stats) {
   mutex_lock l(lock_);
   *stats = stats_;
+  // Chunks that are free in a thread cache are in use as far as the bins are
+  // concerned, but not for the allocator's clients.
+  stats->num_allocs += num_cached_allocs_.load(std::memory_order_relaxed);
+  stats->bytes_in_use -= cached_bytes_.load(std::memory_order_relaxed);
+  stats->largest_free_block_bytes = LargestFreeChunkBytes();
 }
 
 void BFCAllocator::ClearStats() {
   mutex_lock l(lock_);
+  num_cached_allocs_.store(0, std::memory_order_relaxed);
   stats_.num_allocs = 0;
   stats_.max_bytes_in_use = stats_.bytes_in_use;
   stats_.max_alloc_size = 0;
@@ -685,4 +925,75 @@ BFCAllocator::get_bin_debug_info() {
   return bin_infos;
 }
 
+size_t BFCAllocator::LargestFreeChunkBytes() {
+  // The free chunks of a bin are sorted by size, and are larger than those of
+  // the smaller bins.
+  for (BinNum bin_num = kNumBins - 1; bin_num >= 0; bin_num--) {
+    const Bin* b = BinFromIndex(bin_num);
+    if (!b->free_chunks.empty()) {
+      return ChunkFromHandle(*b->free_chunks.rbegin())->size;
+    }
+  }
+  return 0;
+}
+
+BFCAllocator::FragmentationStats BFCAllocator::ComputeFragmentationStats() {
+  const std::array<BinDebugInfo, kNumBins> bin_infos = get_bin_debug_info();
+  FragmentationStats stats;
+  stats.bins.resize(kNumBins);
+  for (BinNum bin_num = 0; bin_num < kNumBins; bin_num++) {
+    const Bin* b = BinFromIndex(bin_num);
+    const BinDebugInfo& bin_info = bin_infos[bin_num];
+    FragmentationStats::BinStats& bin_stats = stats.bins[bin_num];
+    bin_stats.bin_size = b->bin_size;
+    bin_stats.free_chunks = b->free_chunks.size();
+    bin_stats.free_bytes =
+        bin_info.total_bytes_in_bin - bin_info.total_bytes_in_use;
+    if (!b->free_chunks.empty()) {
+      bin_stats.largest_free_chunk_bytes =
+          ChunkFromHandle(*b->free_chunks.rbegin())->size;
+    }
+    bin_stats.wasted_bytes =
+        bin_info.total_bytes_in_use - bin_info.total_requested_bytes_in_use;
+    stats.free_bytes += bin_stats.free_bytes;
+    stats.largest_free_chunk_bytes = std::max(
+        stats.largest_free_chunk_bytes, bin_stats.largest_free_chunk_bytes);
+  }
+  if (stats.free_bytes > 0) {
+    stats.fragmentation =
+        1.0 - static_cast<double>(stats.largest_free_chunk_bytes) /
+                  stats.free_bytes;
+  }
+  return stats;
+}
+
+BFCAllocator::FragmentationStats BFCAllocator::GetFragmentationStats() {
+  mutex_lock l(lock_);
+  return ComputeFragmentationStats();
+}
+
+void BFCAllocator::RecordMemoryTimeline(int64 alloc_bytes,
+                                        StringPiece op_name) {
+  MemoryTimelineRecord record;
+  record.micros = Env::Default()->NowMicros();
+  record.alloc_bytes = alloc_bytes;
+  record.op_name = string(op_name);
+  mutex_lock l(lock_);
+  record.bytes_in_use =
+      stats_.bytes_in_use - cached_bytes_.load(std::memory_order_relaxed);
+  record.largest_free_block_bytes = LargestFreeChunkBytes();
+  if (memory_timeline_.size() ==
+      static_cast<size_t>(memory_timeline_size_)) {
+    memory_timeline_.pop_front();
+  }
+  memory_timeline_.push_back(std::move(record));
+}
+
+std::vector<BFCAllocator::MemoryTimelineRecord>
+BFCAllocator::GetMemoryTimeline() {
+  mutex_lock l(lock_);
+  return std::vector<MemoryTimelineRecord>(memory_timeline_.begin(),
+                                           memory_timeline_.end());
+}
+
 }  // namespace tensorflow
@@ -17,6 +17,8 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
 #include <array>
+#include <atomic>
+#include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -24,7 +26,9 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -42,11 +46,27 @@ namespace tensorflow {
 // coalescing.  One assumption we make is that the process using this
 // allocator owns pretty much all of the memory, and that nearly
 // all requests to allocate memory go through this interface.
+//
+// If 'use_thread_local_cache' is true, small allocations (up to
+// kMaxCachedChunkBytes) are served from a per-thread cache of chunks that
+// does not take the allocator-wide lock.  The cache is refilled from, and
+// drained back to, the bins in batches; chunks held by a cache count as in
+// use from the point of view of the bins, but are not reported in
+// GetStats().bytes_in_use while they are free.  RequestedSize() and
+// AllocationId() are not refreshed when a cached chunk is reused.
+//
+// If the TF_BFC_MEMORY_TIMELINE_SIZE environment variable is set to N > 0,
+// the allocator keeps the N most recent points of its memory timeline: the
+// bytes in use and the largest free chunk after each allocation and
+// deallocation, tagged with the op that made the allocation.  Together with
+// GetFragmentationStats(), this tells an out of memory error caused by the
+// peak usage from one caused by fragmentation.
 class BFCAllocator : public Allocator {
  public:
   // Takes ownership of sub_allocator.
   BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
-               bool allow_growth, const string& name);
+               bool allow_growth, const string& name,
+               bool use_thread_local_cache = false);
   ~BFCAllocator() override;
 
   string Name() override { return name_; }
@@ -67,13 +87,60 @@ class BFCAllocator : public Allocator {
 
   void ClearStats() override;
 
+  // A point of the memory timeline.
+  struct MemoryTimelineRecord {
+    int64 micros = 0;
+    // Bytes requested by the allocation, or deallocated if negative.
+    int64 alloc_bytes = 0;
+    // GetStats().bytes_in_use and largest_free_block_bytes after the
+    // allocation or deallocation.
+    int64 bytes_in_use = 0;
+    int64 largest_free_block_bytes = 0;
+    // AllocationAttributes::op_name of the allocation, empty if it is unknown
+    // or for a deallocation.
+    string op_name;
+  };
+
+  // Returns the recorded points of the memory timeline, oldest first. Empty
+  // unless TF_BFC_MEMORY_TIMELINE_SIZE is set.
+  std::vector<MemoryTimelineRecord> GetMemoryTimeline();
+
+  // The free chunks of the memory allocated so far, by bin.  The memory that
+  // the allocator may still allocate with allow_growth, and the free chunks
+  // held by thread caches, are not counted.
+  struct FragmentationStats {
+    struct BinStats {
+      size_t bin_size = 0;
+      int64 free_chunks = 0;
+      int64 free_bytes = 0;
+      int64 largest_free_chunk_bytes = 0;
+      // Bytes of the chunks in use beyond what their clients requested.
+      int64 wasted_bytes = 0;
+    };
+    std::vector<BinStats> bins;
+    int64 free_bytes = 0;
+    int64 largest_free_chunk_bytes = 0;
+    // 1 - largest_free_chunk_bytes / free_bytes: 0 if the free memory is
+    // contiguous, close to 1 if it is scattered in small chunks.
+    double fragmentation = 0;
+  };
+  FragmentationStats GetFragmentationStats();
+
  private:
   struct Bin;
 
+  void* AllocateRawWithRetry(size_t alignment, size_t num_bytes);
   void* AllocateRawInternal(size_t alignment, size_t num_bytes,
                             bool dump_log_on_failure);
   void DeallocateRawInternal(void* ptr);
 
+  // Appends a point to the memory timeline.
+  void RecordMemoryTimeline(int64 alloc_bytes, StringPiece op_name)
+      LOCKS_EXCLUDED(lock_);
+
+  // Exports the bytes in use to the allocator bytes metric.
+  void UpdateBytesInUseMetric() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // A ChunkHandle is an index into the chunks_ vector in BFCAllocator
   // kInvalidChunkHandle means an invalid chunk
   typedef size_t ChunkHandle;
@@ -83,6 +150,8 @@ class BFCAllocator : public Allocator {
   static const int kInvalidBinNum = -1;
   static const int kNumBins = 21;
 
+  struct ThreadCache;
+
   // A Chunk points to a piece of memory that's either entirely free or entirely
   // in use by one user memory allocation.
   //
@@ -126,6 +195,9 @@ class BFCAllocator : public Allocator {
     // What bin are we in?
     BinNum bin_num = kInvalidBinNum;
 
+    // The thread-local cache that owns this (in use) chunk, if any.
+    ThreadCache* thread_cache = nullptr;
+
     bool in_use() const { return allocation_id != -1; }
 
     string DebugString(BFCAllocator* a,
@@ -181,6 +253,36 @@ class BFCAllocator : public Allocator {
   static const size_t kMinAllocationBits = 8;
   static const size_t kMinAllocationSize = 1 << kMinAllocationBits;
 
+  // Allocations of at most this many (rounded) bytes use the thread-local
+  // cache, with one size class per multiple of kMinAllocationSize.
+  static const size_t kMaxCachedChunkBytes = 4096;
+  static const int kNumCachedSizeClasses =
+      kMaxCachedChunkBytes / kMinAllocationSize;
+  // Number of chunks moved from the bins into a cache on a miss.
+  static const int kCacheRefillChunks = 8;
+  // A size class holding more free chunks than this is drained back to the
+  // bins down to half of it.
+  static const int kMaxCachedChunksPerClass = 32;
+
+  // A per-thread, per-allocator cache of in-use chunks.  'mu' is only
+  // contended when another thread frees one of the cache's live chunks or
+  // when the caches are flushed; when both locks are taken, lock_ is always
+  // acquired first.
+  struct ThreadCache {
+    struct CachedChunk {
+      void* ptr;
+      size_t size;  // Full size of the underlying chunk.
+    };
+
+    mutex mu;
+    // free_chunks[i] holds chunks for allocations of
+    // (i + 1) * kMinAllocationSize rounded bytes.
+    std::vector<CachedChunk> free_chunks[kNumCachedSizeClasses] GUARDED_BY(mu);
+    // Chunks handed out from this cache that are still allocated, mapped to
+    // their size class and full chunk size.
+    gtl::FlatMap<const void*, std::pair<int, size_t>> live GUARDED_BY(mu);
+  };
+
   // BFCAllocator allocates memory into a collection of disjoint
   // AllocationRegions.  Each AllocationRegion corresponds to one call to
   // SubAllocator::Alloc().
@@ -344,6 +446,33 @@ class BFCAllocator : public Allocator {
   // Removes the chunk metadata represented by 'h'.
   void DeleteChunk(ChunkHandle h) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Returns the calling thread's cache for this allocator, creating it if
+  // 'create' is true.  Returns nullptr if there is none.
+  ThreadCache* GetThreadCache(bool create) LOCKS_EXCLUDED(lock_);
+
+  // Pops a free chunk of size class 'size_class' from 'cache' without
+  // taking lock_.  Returns nullptr if the size class is empty.
+  void* AllocateFromThreadCache(ThreadCache* cache, int size_class)
+      LOCKS_EXCLUDED(lock_);
+
+  // Allocates a chunk for the caller plus up to kCacheRefillChunks - 1
+  // spares of the same size, which are added to 'cache'.
+  void* RefillThreadCache(ThreadCache* cache, int size_class,
+                          size_t alignment, size_t rounded_bytes,
+                          size_t num_bytes) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns 'ptr' to the calling thread's cache if the cache handed it
+  // out.  Returns false if the chunk has to be freed the regular way.
+  bool DeallocateToThreadCache(void* ptr) LOCKS_EXCLUDED(lock_);
+
+  // Returns free chunks above 'max_chunks' in each size class of 'cache'
+  // to the bins.
+  void DrainThreadCache(ThreadCache* cache, int max_chunks)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns all free chunks of all thread caches to the bins.
+  void FlushThreadCaches() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   string RenderOccupancy() EXCLUSIVE_LOCKS_REQUIRED(lock_);
   void DumpMemoryLog(size_t num_bytes) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
@@ -365,6 +494,12 @@ class BFCAllocator : public Allocator {
   std::array<BinDebugInfo, kNumBins> get_bin_debug_info()
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Returns the size of the largest chunk in the bins.
+  size_t LargestFreeChunkBytes() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  FragmentationStats ComputeFragmentationStats()
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   AllocatorRetry retry_helper_;
 
   // Structures immutable after construction
@@ -421,6 +556,16 @@ class BFCAllocator : public Allocator {
   std::unique_ptr<SubAllocator> sub_allocator_;
   string name_;
 
+  const bool use_thread_local_cache_;
+  // Unique among all BFCAllocators created by this process; used to key the
+  // thread-local cache lookup so that a cache of a destroyed allocator is
+  // never found by a new allocator at the same address.
+  const int64 allocator_id_;
+  // The number of points of the memory timeline to keep, or 0 for none.
+  const int64 memory_timeline_size_;
+  // The bytes in use, exported as a metric. Not owned.
+  monitoring::GaugeCell<int64>* const bytes_in_use_cell_;
+
   // Structures mutable after construction
   mutable mutex lock_;
   RegionManager region_manager_ GUARDED_BY(lock_);
@@ -437,6 +582,16 @@ class BFCAllocator : public Allocator {
   // Stats.
   AllocatorStats stats_ GUARDED_BY(lock_);
 
+  // All thread caches of this allocator.
+  std::vector<std::unique_ptr<ThreadCache>> thread_caches_ GUARDED_BY(lock_);
+
+  // Bytes of the chunks currently free in thread caches, and number of
+  // allocations served by thread caches without lock_.
+  std::atomic<int64> cached_bytes_{0};
+  std::atomic<int64> num_cached_allocs_{0};
+
+  std::deque<MemoryTimelineRecord> memory_timeline_ GUARDED_BY(lock_);
+
   friend class GPUBFCAllocatorPrivateMethodsTest;
   TF_DISALLOW_COPY_AND_ASSIGN(BFCAllocator);
 };
@@ -72,6 +72,30 @@ void CollectiveExecutorMgr::Cleanup(int64 step_id) {
   if (ce) ce->Unref();
 }
 
+void CollectiveExecutorMgr::StartAbort(int64 step_id, const Status& s) {
+  CollectiveExecutor* ce = nullptr;
+  {
+    mutex_lock l(exec_mu_);
+    auto it = executor_table_.find(step_id);
+    if (it == executor_table_.end()) return;
+    ce = it->second;
+    ce->Ref();
+  }
+  // Abort outside of exec_mu_, since aborting runs pending callbacks.
+  ce->StartAbort(s);
+  ce->Unref();
+}
+
+std::vector<int64> CollectiveExecutorMgr::ActiveStepIds() {
+  std::vector<int64> step_ids;
+  mutex_lock l(exec_mu_);
+  step_ids.reserve(executor_table_.size());
+  for (const auto& it : executor_table_) {
+    step_ids.push_back(it.first);
+  }
+  return step_ids;
+}
+
 void CollectiveExecutorMgr::GetStepSequenceAsync(
     const GetStepSequenceRequest* request, GetStepSequenceResponse* response,
     const StatusCallback& done) {
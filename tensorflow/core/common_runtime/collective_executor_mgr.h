@@ -34,6 +34,8 @@ class CollectiveExecutorMgr : public CollectiveExecutorMgrInterface {
 
   void Cleanup(int64 step_id) override;
 
+  void StartAbort(int64 step_id, const Status& s) override;
+
   ParamResolverInterface* GetParamResolver() const override {
     return param_resolver_.get();
   }
@@ -59,6 +61,9 @@ class CollectiveExecutorMgr : public CollectiveExecutorMgrInterface {
   // Called by FindOrCreate when table entry does not yet exist.
   virtual CollectiveExecutor* Create(int64 step_id);
 
+  // Returns the step_ids of all CollectiveExecutors in the table.
+  std::vector<int64> ActiveStepIds();
+
   const DeviceMgr* dev_mgr_;
   std::unique_ptr<DeviceResolverInterface> dev_resolver_;
   std::unique_ptr<ParamResolverInterface> param_resolver_;
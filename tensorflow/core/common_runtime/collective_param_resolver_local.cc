@@ -610,10 +610,15 @@ void CollectiveParamResolverLocal::CompleteInstanceFromInitializedIRec(
   CompleteTaskIsLocal(task_name_, cp);
   // TODO(b/113171733): we need a better way to pick the collective
   // implementation.  The ideal way would depend upon the topology and link
-  // strength before picking a particular implementation.
-  cp->instance.impl_details.collective_name =
-      (cp->instance.type == BROADCAST_COLLECTIVE) ? "HierarchicalTreeBroadcast"
-                                                  : "RingReduce";
+  // strength before picking a particular implementation.  Until then an
+  // implementation requested by the op, e.g. "HierarchicalReduce", is used
+  // as is.
+  if (cp->instance.impl_details.collective_name.empty()) {
+    cp->instance.impl_details.collective_name =
+        (cp->instance.type == BROADCAST_COLLECTIVE)
+            ? "HierarchicalTreeBroadcast"
+            : "RingReduce";
+  }
   CollectiveImplementationInterface* col_impl;
   Status lookup_status = CollectiveRegistry::LookupParamResolverInstance(
       cp->instance.impl_details.collective_name, &col_impl);
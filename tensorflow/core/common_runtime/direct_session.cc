@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/direct_session.h"
 
 #include <atomic>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -33,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/optimization_registry.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
+#include "tensorflow/core/common_runtime/static_plan_allocator.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb_text.h"
@@ -77,6 +79,12 @@ auto* direct_session_runs = monitoring::Counter<0>::New(
     "/tensorflow/core/direct_session_runs",
     "The number of times DirectSession::Run() has been called.");
 
+auto* direct_session_executor_cache = monitoring::Counter<1>::New(
+    "/tensorflow/core/direct_session_executor_cache",
+    "The number of lookups of the executors of DirectSession by their "
+    "signature, and of evictions of executors.",
+    "result");
+
 Status NewThreadPoolFromThreadPoolOptions(
     const SessionOptions& options,
     const ThreadPoolOptionProto& thread_pool_options, int pool_number,
@@ -228,7 +236,8 @@ std::atomic_int_fast64_t DirectSession::step_id_counter_(1);
 // devices that run concurrently, in which case we will need to
 // revisit this decision.
 void DirectSession::SchedClosure(thread::ThreadPool* pool,
-                                 std::function<void()> c) {
+                                 std::function<void()> c,
+                                 thread::ThreadPool::Priority priority) {
 // TODO(sanjay): Get rid of __ANDROID__ path
 #ifdef __ANDROID__
   // On Android, there is no implementation of ThreadPool that takes
@@ -239,7 +248,7 @@ void DirectSession::SchedClosure(thread::ThreadPool* pool,
   c();
 #else
   if (pool != nullptr) {
-    pool->Schedule(std::move(c));
+    pool->Schedule(std::move(c), priority);
   } else {
     c();
   }
@@ -286,6 +295,12 @@ DirectSession::DirectSession(const SessionOptions& options,
   } else {
     thread_pools_.emplace_back(GlobalThreadPool(options), false /* owned */);
   }
+  const int32 autotune_steps =
+      options_.config.experimental().inter_op_autotune_steps();
+  if (autotune_steps > 0 && thread_pool_size == 0) {
+    inter_op_pool_tuner_.reset(new InterOpThreadPoolTuner(
+        options_.env, thread_pools_[0].first, autotune_steps));
+  }
   // The default value of sync_on_finish will be flipped soon and this
   // environment variable will be removed as well.
   const Status status =
@@ -607,12 +622,31 @@ Status DirectSession::RunInternal(int64 step_id, const RunOptions& run_options,
       run_options.experimental().use_run_handler_pool()) {
     // Non-null only when a global inter-op pool is used.
     VLOG(1) << "Using RunHandler to scheduler inter-op closures.";
-    handler = GetOrCreateRunHandlerPool(options_)->Get();
+    handler = GetOrCreateRunHandlerPool(options_)->Get(
+        run_options.experimental().run_handler_priority());
   }
   auto* handler_ptr = handler.get();
 
+  // While the inter-op thread pool is tuned, steps run on the candidate
+  // pools in turn.
+  std::shared_ptr<thread::ThreadPool> tuned_pool;
+  int tuning_trial = -1;
+  if (inter_op_pool_tuner_ != nullptr && pool == thread_pools_[0].first &&
+      handler_ptr == nullptr) {
+    tuned_pool = inter_op_pool_tuner_->GetPool(&tuning_trial);
+    pool = tuned_pool.get();
+  }
+  const uint64 step_start_micros = options_.env->NowMicros();
+
   Executor::Args::Runner default_runner = nullptr;
 
+  // Without a RunHandler, runs with a negative priority, e.g. those that
+  // save checkpoints or write summaries, yield to the others.
+  const thread::ThreadPool::Priority priority =
+      run_options.experimental().run_handler_priority() < 0
+          ? thread::ThreadPool::Priority::kLow
+          : thread::ThreadPool::Priority::kNormal;
+
   if (pool == nullptr) {
     default_runner = [](Executor::Args::Closure c) { c(); };
   } else if (handler_ptr != nullptr) {
@@ -620,11 +654,24 @@ Status DirectSession::RunInternal(int64 step_id, const RunOptions& run_options,
       handler_ptr->ScheduleInterOpClosure(std::move(c));
     };
   } else {
-    default_runner = [this, pool](Executor::Args::Closure c) {
-      SchedClosure(pool, std::move(c));
+    default_runner = [this, pool, priority](Executor::Args::Closure c) {
+      SchedClosure(pool, std::move(c), priority);
     };
   }
 
+  // Serve the step from static memory plans on the devices that make them.
+  // The plans are specific to the subgraphs being run.
+  std::vector<StaticPlanAllocator*> plan_allocators;
+  const uint64 plan_key = reinterpret_cast<uintptr_t>(executors_and_keys);
+  for (const auto& item : executors_and_keys->items) {
+    auto* plan_allocator = dynamic_cast<StaticPlanAllocator*>(
+        item.device->GetAllocator(AllocatorAttributes()));
+    if (plan_allocator != nullptr &&
+        plan_allocator->BeginStep(step_id, plan_key)) {
+      plan_allocators.push_back(plan_allocator);
+    }
+  }
+
   for (const auto& item : executors_and_keys->items) {
     // TODO(azaks): support partial run.
     // TODO(azaks): if the device picks its own threadpool, we need to assign
@@ -636,8 +683,9 @@ Status DirectSession::RunInternal(int64 step_id, const RunOptions& run_options,
     if (!device_thread_pool) {
       args.runner = default_runner;
     } else {
-      args.runner = [this, device_thread_pool](Executor::Args::Closure c) {
-        SchedClosure(device_thread_pool, std::move(c));
+      args.runner = [this, device_thread_pool,
+                     priority](Executor::Args::Closure c) {
+        SchedClosure(device_thread_pool, std::move(c), priority);
       };
     }
     item.executor->RunAsync(args, barrier->Get());
@@ -648,6 +696,10 @@ Status DirectSession::RunInternal(int64 step_id, const RunOptions& run_options,
                           ? run_options.timeout_in_ms()
                           : operation_timeout_in_ms_);
 
+  for (StaticPlanAllocator* plan_allocator : plan_allocators) {
+    plan_allocator->EndStep(step_id);
+  }
+
   if (!cancellation_manager_->DeregisterCallback(cancellation_token)) {
     // The step has been cancelled: make sure we don't attempt to receive the
     // outputs as this would make it block forever.
@@ -665,6 +717,11 @@ Status DirectSession::RunInternal(int64 step_id, const RunOptions& run_options,
     TF_RETURN_IF_ERROR(run_state.status);
   }
 
+  if (tuning_trial >= 0) {
+    inter_op_pool_tuner_->ReportStep(
+        tuning_trial, options_.env->NowMicros() - step_start_micros);
+  }
+
   // Save the output tensors of this run we choose to keep.
   if (!run_state.tensor_store.empty()) {
     TF_RETURN_IF_ERROR(run_state.tensor_store.SaveTensors(
@@ -731,7 +788,7 @@ Status DirectSession::Run(const RunOptions& run_options,
   }
 
   // Check if we already have an executor for these arguments.
-  ExecutorsAndKeys* executors_and_keys;
+  std::shared_ptr<ExecutorsAndKeys> executors_and_keys;
   RunStateArgs run_state_args(run_options.debug_options());
   run_state_args.collective_graph_key =
       run_options.experimental().collective_graph_key();
@@ -774,7 +831,7 @@ Status DirectSession::Run(const RunOptions& run_options,
   }
 
   TF_RETURN_IF_ERROR(RunInternal(step_id, run_options, &call_frame,
-                                 executors_and_keys, run_metadata));
+                                 executors_and_keys.get(), run_metadata));
 
   // Receive outputs.
   if (outputs) {
@@ -829,8 +886,9 @@ Status DirectSession::PRunSetup(const std::vector<string>& input_names,
   // RunOptions is not available in PRunSetup, so use thread pool 0.
   thread::ThreadPool* pool = thread_pools_[0].first;
 
-  // Check if we already have an executor for these arguments.
-  ExecutorsAndKeys* executors_and_keys;
+  // Check if we already have an executor for these arguments. Executors of
+  // partial runs are never evicted, so PRun finds them under the handle.
+  std::shared_ptr<ExecutorsAndKeys> executors_and_keys;
   // TODO(cais): TFDBG support for partial runs.
   DebugOptions debug_options;
   RunStateArgs run_state_args(debug_options);
@@ -1222,6 +1280,17 @@ Status DirectSession::CreateExecutors(
       func_info->flib_def.get(), optimizer_opts, thread_pools_[0].first));
 
   GraphOptimizer optimizer(optimizer_opts);
+  const DebugOptions& debug_options =
+      options.callable_options.run_options().debug_options();
+  // The partitions are optimized and their executors created in parallel on
+  // the inter-op pool, as are the kernels of large partitions. Graphs
+  // decorated for the debugger are published one by one.
+  thread::ThreadPool* pool = debug_options.debug_tensor_watch_opts().empty()
+                                 ? thread_pools_[0].first
+                                 : nullptr;
+  std::vector<std::unique_ptr<Graph>*> partition_graphs;
+  std::vector<LocalExecutorParams> partition_params;
+  ek->items.resize(graphs.size());
   for (auto iter = graphs.begin(); iter != graphs.end(); ++iter) {
     const string& partition_name = iter->first;
     std::unique_ptr<Graph>& partition_graph = iter->second;
@@ -1229,8 +1298,7 @@ Status DirectSession::CreateExecutors(
     Device* device;
     TF_RETURN_IF_ERROR(device_mgr_->LookupDevice(partition_name, &device));
 
-    ek->items.resize(ek->items.size() + 1);
-    auto* item = &(ek->items.back());
+    auto* item = &ek->items[partition_params.size()];
     auto lib = func_info->proc_flr->GetFLR(partition_name);
     if (lib == nullptr) {
       return errors::Internal("Could not find device: ", partition_name);
@@ -1263,28 +1331,42 @@ Status DirectSession::CreateExecutors(
       if (kernel && !OpSegment::ShouldOwnKernel(lib, kernel->type_string()))
         delete kernel;
     };
+    params.create_kernel_pool = pool;
+
+    item->graph = nullptr;
+    item->executor = nullptr;
+    item->device = device;
+    partition_graphs.push_back(&partition_graph);
+    partition_params.push_back(std::move(params));
+  }
 
-    optimizer.Optimize(lib, options_.env, device, &partition_graph,
-                       /*shape_map=*/nullptr);
+  std::vector<Status> statuses(partition_params.size());
+  auto executor_type = options_.config.experimental().executor_type();
+  ParallelCall(pool, partition_params.size(), [&](int64 i) {
+    const LocalExecutorParams& params = partition_params[i];
+    std::unique_ptr<Graph>& partition_graph = *partition_graphs[i];
+    auto* item = &ek->items[i];
+    optimizer.Optimize(params.function_library, options_.env, params.device,
+                       &partition_graph, /*shape_map=*/nullptr);
 
     // TensorFlow Debugger (tfdbg) inserts debug nodes in the graph.
-    const DebugOptions& debug_options =
-        options.callable_options.run_options().debug_options();
     if (!debug_options.debug_tensor_watch_opts().empty()) {
-      TF_RETURN_IF_ERROR(DecorateAndPublishGraphForDebug(
-          debug_options, partition_graph.get(), params.device));
+      statuses[i] = DecorateAndPublishGraphForDebug(
+          debug_options, partition_graph.get(), params.device);
+      if (!statuses[i].ok()) return;
     }
 
-    TF_RETURN_IF_ERROR(EnsureMemoryTypes(DeviceType(device->device_type()),
-                                         device->name(),
-                                         partition_graph.get()));
+    statuses[i] = EnsureMemoryTypes(DeviceType(params.device->device_type()),
+                                    params.device->name(),
+                                    partition_graph.get());
+    if (!statuses[i].ok()) return;
     // NewLocalExecutor takes ownership of partition_graph.
     item->graph = partition_graph.get();
-    item->executor = nullptr;
-    item->device = device;
-    auto executor_type = options_.config.experimental().executor_type();
-    TF_RETURN_IF_ERROR(NewExecutor(
-        executor_type, params, std::move(partition_graph), &item->executor));
+    statuses[i] = NewExecutor(executor_type, params, std::move(partition_graph),
+                              &item->executor);
+  });
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
   }
 
   // Cache the mapping from input/output names to graph elements to
@@ -1327,7 +1409,8 @@ Status DirectSession::CreateExecutors(
 
 Status DirectSession::GetOrCreateExecutors(
     gtl::ArraySlice<string> inputs, gtl::ArraySlice<string> outputs,
-    gtl::ArraySlice<string> target_nodes, ExecutorsAndKeys** executors_and_keys,
+    gtl::ArraySlice<string> target_nodes,
+    std::shared_ptr<ExecutorsAndKeys>* executors_and_keys,
     RunStateArgs* run_state_args) {
   int64 handle_name_counter_value = -1;
   if (LogMemory::IsEnabled() || run_state_args->is_partial_run) {
@@ -1353,10 +1436,12 @@ Status DirectSession::GetOrCreateExecutors(
 
   // See if we already have the executors for this run.
   {
-    mutex_lock l(executor_lock_);  // could use reader lock
+    mutex_lock l(executor_lock_);
     auto it = executors_.find(key);
     if (it != executors_.end()) {
-      *executors_and_keys = it->second.get();
+      *executors_and_keys = it->second;
+      TouchExecutors(it->second.get());
+      direct_session_executor_cache->GetCell("hit")->IncrementBy(1);
       return Status::OK();
     }
   }
@@ -1389,12 +1474,17 @@ Status DirectSession::GetOrCreateExecutors(
     mutex_lock l(executor_lock_);
     auto it = executors_.find(sorted_key);
     if (it != executors_.end()) {
-      *executors_and_keys = it->second.get();
+      *executors_and_keys = it->second;
+      TouchExecutors(it->second.get());
       // Insert this under the original key.
-      executors_.emplace(key, it->second);
+      if (executors_.emplace(key, *executors_and_keys).second) {
+        (*executors_and_keys)->cache_keys.push_back(key);
+      }
+      direct_session_executor_cache->GetCell("hit")->IncrementBy(1);
       return Status::OK();
     }
   }
+  direct_session_executor_cache->GetCell("miss")->IncrementBy(1);
 
   // Nothing found, so create the executors and store in the cache.
   // The executor_lock_ is intentionally released while executors are
@@ -1418,23 +1508,70 @@ Status DirectSession::GetOrCreateExecutors(
   std::unique_ptr<FunctionInfo> func_info;
   TF_RETURN_IF_ERROR(
       CreateExecutors(callable_options, &ek, &func_info, run_state_args));
+  for (const PerPartitionExecutorsAndLib& item : ek->items) {
+    ek->num_nodes += item.graph->num_nodes();
+  }
+  ek->evictable = !run_state_args->is_partial_run;
 
   // Reacquire the lock, try to insert into the map.
   mutex_lock l(executor_lock_);
+  // Evicted executors may still be referenced by the resources their kernels
+  // created, so their function libraries live as long as the session.
   functions_.push_back(std::move(func_info));
 
   // Another thread may have created the entry before us, in which case we will
   // reuse the already created one.
   auto insert_result = executors_.emplace(
       sorted_key, std::shared_ptr<ExecutorsAndKeys>(std::move(ek)));
+  *executors_and_keys = insert_result.first->second;
+  ExecutorsAndKeys* entry = executors_and_keys->get();
+  if (insert_result.second) {
+    entry->cache_keys.push_back(sorted_key);
+    if (entry->evictable) {
+      executors_lru_.push_front(entry);
+      entry->lru_position = executors_lru_.begin();
+      executors_num_nodes_ += entry->num_nodes;
+    }
+  } else {
+    TouchExecutors(entry);
+  }
   // Insert the value under the original key, so the fast path lookup will work
   // if the user uses the same order of inputs, outputs, and targets again.
-  executors_.emplace(key, insert_result.first->second);
-  *executors_and_keys = insert_result.first->second.get();
+  if (executors_.emplace(key, *executors_and_keys).second) {
+    entry->cache_keys.push_back(key);
+  }
+  MaybeEvictExecutors(entry);
 
   return Status::OK();
 }
 
+void DirectSession::TouchExecutors(ExecutorsAndKeys* executors_and_keys) {
+  if (executors_and_keys->evictable) {
+    executors_lru_.splice(executors_lru_.begin(), executors_lru_,
+                          executors_and_keys->lru_position);
+  }
+}
+
+void DirectSession::MaybeEvictExecutors(const ExecutorsAndKeys* keep) {
+  const int64 max_nodes =
+      options_.config.experimental().executor_cache_max_nodes();
+  if (max_nodes <= 0) return;
+  while (executors_num_nodes_ > max_nodes && !executors_lru_.empty() &&
+         executors_lru_.back() != keep) {
+    ExecutorsAndKeys* evicted = executors_lru_.back();
+    executors_lru_.pop_back();
+    executors_num_nodes_ -= evicted->num_nodes;
+    VLOG(1) << "Evicting the executors of " << evicted->cache_keys[0]
+            << " with " << evicted->num_nodes << " nodes";
+    // Erasing the last key deletes `evicted`, unless a step still runs it.
+    const std::vector<string> cache_keys = std::move(evicted->cache_keys);
+    for (const string& cache_key : cache_keys) {
+      executors_.erase(cache_key);
+    }
+    direct_session_executor_cache->GetCell("evicted")->IncrementBy(1);
+  }
+}
+
 Status DirectSession::CreateGraphs(
     const BuildGraphOptions& subgraph_options,
     std::unordered_map<string, std::unique_ptr<Graph>>* outputs,
@@ -1548,15 +1685,15 @@ Status DirectSession::CreateGraphs(
     }
   }
 
-  for (const auto& partition : partitions) {
+  for (auto& partition : partitions) {
     std::unique_ptr<Graph> device_graph(
         new Graph(client_graph->flib_def.get()));
     GraphConstructorOptions device_opts;
     // There are internal operations (e.g., send/recv) that we now allow.
     device_opts.allow_internal_ops = true;
     device_opts.expect_device_spec = true;
-    TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(device_opts, partition.second,
-                                              device_graph.get()));
+    TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(
+        device_opts, std::move(partition.second), device_graph.get()));
     outputs->emplace(partition.first, std::move(device_graph));
   }
 
@@ -1702,6 +1839,12 @@ Status DirectSession::MakeCallable(const CallableOptions& callable_options,
                                    CallableHandle* out_handle) {
   TF_RETURN_IF_ERROR(CheckNotClosed());
   TF_RETURN_IF_ERROR(CheckGraphCreated("MakeCallable()"));
+  if (callable_options.fetch_into_provided_tensors() &&
+      !callable_options.fetch_devices().empty()) {
+    return errors::InvalidArgument(
+        "`fetch_into_provided_tensors` cannot be combined with "
+        "`fetch_devices`.");
+  }
 
   std::unique_ptr<ExecutorsAndKeys> ek;
   std::unique_ptr<FunctionInfo> func_info;
@@ -1750,7 +1893,19 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
     if (index > fetch_tensors_->size()) {
       return errors::Internal("RetVal index out of bounds: ", index);
     }
-    (*fetch_tensors_)[index] = val;
+    Tensor* fetch = &(*fetch_tensors_)[index];
+    if (executors_and_keys_->callable_options.fetch_into_provided_tensors() &&
+        fetch->IsInitialized() && fetch->dtype() == val.dtype() &&
+        DataTypeCanUseMemcpy(val.dtype()) && fetch->shape() == val.shape()) {
+      // Writes the value into the memory of the caller's tensor.
+      const StringPiece src = val.tensor_data();
+      const StringPiece dst = fetch->tensor_data();
+      if (src.data() != dst.data() && !src.empty()) {
+        std::memcpy(const_cast<char*>(dst.data()), src.data(), src.size());
+      }
+      return Status::OK();
+    }
+    *fetch = val;
     return Status::OK();
   }
 
@@ -1815,9 +1970,32 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
     LogMemory::RecordStep(step_id, run_state_args.handle);
   }
 
-  TF_RETURN_IF_ERROR(
-      RunInternal(step_id, executors_and_keys->callable_options.run_options(),
-                  &call_frame, executors_and_keys.get(), run_metadata));
+  const CallableOptions& callable_options =
+      executors_and_keys->callable_options;
+  if (callable_options.steps_per_run() > 1) {
+    // Only the last step is traced, and its fetches are the ones returned.
+    RunOptions untraced_options = callable_options.run_options();
+    untraced_options.set_trace_level(RunOptions::NO_TRACE);
+    untraced_options.set_output_partition_graphs(false);
+    RunMetadata unused_metadata;
+    TF_RETURN_IF_ERROR(RunInternal(step_id, untraced_options, &call_frame,
+                                   executors_and_keys.get(),
+                                   &unused_metadata));
+    for (int64 i = 2; i < callable_options.steps_per_run(); ++i) {
+      TF_RETURN_IF_ERROR(RunInternal(step_id_counter_.fetch_add(1),
+                                     untraced_options, &call_frame,
+                                     executors_and_keys.get(),
+                                     &unused_metadata));
+    }
+    TF_RETURN_IF_ERROR(RunInternal(
+        step_id_counter_.fetch_add(1), callable_options.run_options(),
+        &call_frame, executors_and_keys.get(), run_metadata));
+    return Status::OK();
+  }
+
+  TF_RETURN_IF_ERROR(RunInternal(step_id, callable_options.run_options(),
+                                 &call_frame, executors_and_keys.get(),
+                                 run_metadata));
 
   return Status::OK();
 }
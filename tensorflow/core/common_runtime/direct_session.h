@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_DIRECT_SESSION_H_
 
 #include <atomic>
+#include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_set.h"
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/graph_execution_state.h"
+#include "tensorflow/core/common_runtime/inter_op_thread_pool_tuner.h"
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/session_factory.h"
@@ -155,6 +157,14 @@ class DirectSession : public Session {
     CallableOptions callable_options;
 
     int64 collective_graph_key = BuildGraphOptions::kNoCollectiveGraphKey;
+
+    // Bookkeeping of the executors_ cache, guarded by executor_lock_: the
+    // keys of this object in executors_, the number of nodes in its partition
+    // graphs, and its position in executors_lru_ if it may be evicted.
+    std::vector<string> cache_keys;
+    int64 num_nodes = 0;
+    bool evictable = false;
+    std::list<ExecutorsAndKeys*>::iterator lru_position;
   };
 
   // A FunctionInfo object is created for every unique set of feeds/fetches.
@@ -218,11 +228,23 @@ class DirectSession : public Session {
       EXCLUSIVE_LOCKS_REQUIRED(graph_state_lock_);
 
   // Retrieves an already existing set of executors to run 'inputs' and
-  // 'outputs', or creates and caches them for future use.
+  // 'outputs', or creates and caches them for future use. The caller shares
+  // ownership, so the executors stay alive if they are evicted from the cache
+  // while running.
   ::tensorflow::Status GetOrCreateExecutors(
       gtl::ArraySlice<string> inputs, gtl::ArraySlice<string> outputs,
       gtl::ArraySlice<string> target_nodes,
-      ExecutorsAndKeys** executors_and_keys, RunStateArgs* run_state_args);
+      std::shared_ptr<ExecutorsAndKeys>* executors_and_keys,
+      RunStateArgs* run_state_args);
+
+  // Marks `executors_and_keys` as the most recently used executors.
+  void TouchExecutors(ExecutorsAndKeys* executors_and_keys)
+      EXCLUSIVE_LOCKS_REQUIRED(executor_lock_);
+
+  // Evicts the least recently used executors, other than `keep`, until the
+  // cached ones fit in ConfigProto.Experimental.executor_cache_max_nodes.
+  void MaybeEvictExecutors(const ExecutorsAndKeys* keep)
+      EXCLUSIVE_LOCKS_REQUIRED(executor_lock_);
 
   // Creates a set of executors to run the subgraph defined by
   // `callable_options`.
@@ -323,12 +345,18 @@ class DirectSession : public Session {
   // is owned.
   std::vector<std::pair<thread::ThreadPool*, bool>> thread_pools_;
 
+  // If ConfigProto.Experimental.inter_op_autotune_steps is positive, picks
+  // the pool that runs the steps which would run on thread_pools_[0].
+  std::unique_ptr<InterOpThreadPoolTuner> inter_op_pool_tuner_;
+
   Status init_error_;  // Set to an error if construction failed.
 
   // If true, blocks until device has finished all queued operations in a step.
   bool sync_on_finish_ = true;
-  // Schedules 'c' for execution on pool.
-  void SchedClosure(thread::ThreadPool* pool, std::function<void()> c);
+  // Schedules 'c' for execution on pool with 'priority'.
+  void SchedClosure(thread::ThreadPool* pool, std::function<void()> c,
+                    thread::ThreadPool::Priority priority =
+                        thread::ThreadPool::Priority::kNormal);
 
   std::vector<std::unique_ptr<FunctionInfo>> functions_
       GUARDED_BY(executor_lock_);
@@ -341,6 +369,10 @@ class DirectSession : public Session {
   // same ExecutorsAndKey object.
   std::unordered_map<string, std::shared_ptr<ExecutorsAndKeys>> executors_
       GUARDED_BY(executor_lock_);
+  // The evictable executors in executors_, most recently used first, and the
+  // total number of nodes in their partition graphs.
+  std::list<ExecutorsAndKeys*> executors_lru_ GUARDED_BY(executor_lock_);
+  int64 executors_num_nodes_ GUARDED_BY(executor_lock_) = 0;
 
   class RunCallableCallFrame;
   struct Callable {
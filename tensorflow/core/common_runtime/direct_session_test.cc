@@ -40,7 +40,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -79,6 +81,22 @@ std::unique_ptr<Session> CreateSession() {
   return std::unique_ptr<Session>(NewSession(options));
 }
 
+// Returns the value of the counter `metric` whose "result" label is `result`.
+int64 ResultCounterValue(const string& metric, const string& result) {
+  auto metrics = monitoring::CollectionRegistry::Default()->CollectMetrics(
+      monitoring::CollectionRegistry::CollectMetricsOptions());
+  auto iter = metrics->point_set_map.find(metric);
+  if (iter == metrics->point_set_map.end()) return 0;
+  for (const auto& point : iter->second->points) {
+    for (const auto& label : point->labels) {
+      if (label.name == "result" && label.value == result) {
+        return point->int64_value;
+      }
+    }
+  }
+  return 0;
+}
+
 class DirectSessionMinusAXTest : public ::testing::Test {
  public:
   void Initialize(std::initializer_list<float> a_values) {
@@ -142,6 +160,43 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork) {
   EXPECT_FLOAT_EQ(5.0, mat(0, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, RunWithStaticMemoryPlan) {
+  Initialize({3, 2, -1, 0});
+  setenv("TF_CPU_STATIC_MEMORY_PLAN", "1", 1);
+  auto session = CreateSession();
+  unsetenv("TF_CPU_STATIC_MEMORY_PLAN");
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // The first run records the plan, which serves the later ones.
+  for (int i = 0; i < 3; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {y_ + ":0", z_ + ":0"}, {}, &outputs));
+    ASSERT_EQ(2, outputs.size());
+    test::ExpectTensorEqual<float>(
+        test::AsTensor<float>({5, -1}, TensorShape({2, 1})), outputs[0]);
+    test::ExpectTensorEqual<float>(
+        test::AsTensor<float>({-5, 1}, TensorShape({2, 1})), outputs[1]);
+  }
+}
+
+TEST_F(DirectSessionMinusAXTest, RunWithLowPriority) {
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  RunOptions run_options;
+  run_options.mutable_experimental()->set_run_handler_priority(-1);
+  std::vector<Tensor> outputs;
+  RunMetadata run_metadata;
+  TF_ASSERT_OK(session->Run(run_options, {}, {z_ + ":0"}, {}, &outputs,
+                            &run_metadata));
+  ASSERT_EQ(1, outputs.size());
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({-5, 1}, TensorShape({2, 1})), outputs[0]);
+}
+
 TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_Callable) {
   Initialize({3, 2, -1, 0});
   auto session = CreateSession();
@@ -505,6 +560,35 @@ TEST_F(DirectSessionMinusAXTest, TestPerSessionThreads) {
   delete tp;
 }
 
+TEST_F(DirectSessionMinusAXTest, TestNUMAAffinity) {
+  Initialize({1, 2, 3, 4});
+
+  SessionOptions options;
+  options.config.mutable_experimental()->set_use_numa_affinity(true);
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  std::vector<DeviceAttributes> devices;
+  TF_ASSERT_OK(session->ListDevices(&devices));
+  int num_cpus = 0;
+  for (const DeviceAttributes& device : devices) {
+    if (device.device_type() != DEVICE_CPU) continue;
+    if (port::NUMAEnabled()) {
+      EXPECT_EQ(num_cpus % port::NUMANumNodes(),
+                device.locality().numa_node());
+    }
+    ++num_cpus;
+  }
+  EXPECT_EQ(2, num_cpus);
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({}, {y_ + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_FLOAT_EQ(3.0, outputs[0].matrix<float>()(0, 0));
+}
+
 TEST_F(DirectSessionMinusAXTest, TwoCreateCallsFails) {
   Initialize({1, 2, 3, 4});
   auto session = CreateSession();
@@ -692,6 +776,75 @@ TEST(DirectSessionTest, KeepsStateAcrossRunsOfSession) {
   EXPECT_EQ(20.0, outputs[0].flat<float>()(0));
 }
 
+TEST(DirectSessionTest, ExtendKeepsOptimizedSubgraphsValid) {
+  Graph g(OpRegistry::Global());
+  Tensor a_tensor(DT_FLOAT, TensorShape({2}));
+  test::FillValues<float>(&a_tensor, {1, 2});
+  Node* a = test::graph::Constant(&g, a_tensor, "a");
+  Node* b = test::graph::Unary(&g, "Square", a);
+  Tensor c_tensor(DT_FLOAT, TensorShape({2}));
+  test::FillValues<float>(&c_tensor, {3, 4});
+  Node* c = test::graph::Constant(&g, c_tensor, "c");
+  Node* d = test::graph::Multi(&g, "Add", {b, c});
+  GraphDef full;
+  test::graph::ToGraphDef(&g, &full);
+
+  // Create the session with a and b, and extend it with c and d.
+  GraphDef def, extension;
+  *def.mutable_versions() = full.versions();
+  *extension.mutable_versions() = full.versions();
+  for (const NodeDef& node : full.node()) {
+    if (node.name() == c->name() || node.name() == d->name()) {
+      *extension.add_node() = node;
+    } else {
+      *def.add_node() = node;
+    }
+  }
+
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({}, {b->name() + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({1, 4}), outputs[0]);
+
+  TF_ASSERT_OK(session->Extend(extension));
+  // The subgraph of b didn't change, and may reuse its optimized graph.
+  TF_ASSERT_OK(session->Run({}, {b->name() + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({1, 4}), outputs[0]);
+  TF_ASSERT_OK(session->Run({}, {d->name() + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({4, 8}), outputs[0]);
+
+  // A session created with the extended graph reuses the graphs optimized for
+  // the same fetches.
+  const string lookups =
+      "/tensorflow/core/grappler_optimized_graph_cache_lookups";
+  const int64 hits = ResultCounterValue(lookups, "hit");
+  const int64 misses = ResultCounterValue(lookups, "miss");
+  auto full_session = CreateSession();
+  ASSERT_TRUE(full_session != nullptr);
+  TF_ASSERT_OK(full_session->Create(full));
+  TF_ASSERT_OK(full_session->Run({}, {b->name() + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({1, 4}), outputs[0]);
+  EXPECT_EQ(hits + 1, ResultCounterValue(lookups, "hit"));
+  TF_ASSERT_OK(full_session->Run({}, {d->name() + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({4, 8}), outputs[0]);
+  EXPECT_EQ(hits + 2, ResultCounterValue(lookups, "hit"));
+  EXPECT_EQ(misses, ResultCounterValue(lookups, "miss"));
+
+  // The targets are part of the key.
+  TF_ASSERT_OK(
+      full_session->Run({}, {b->name() + ":0"}, {d->name()}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_EQ(hits + 2, ResultCounterValue(lookups, "hit"));
+  EXPECT_EQ(misses + 1, ResultCounterValue(lookups, "miss"));
+}
+
 TEST(DirectSessionTest, MultipleFeedTest) {
   GraphDef def;
   Graph g(OpRegistry::Global());
@@ -848,6 +1001,104 @@ TEST(DirectSessionTest, MultipleFeedTest_Callable) {
   EXPECT_TRUE(str_util::StrContains(s.error_message(), "fed more than once"));
 }
 
+TEST(DirectSessionTest, EvictsLeastRecentlyUsedExecutors) {
+  Graph g(OpRegistry::Global());
+  Node* a = test::graph::Identity(
+      &g, test::graph::Constant(&g, test::AsScalar<float>(1.0f)));
+  Node* b = test::graph::Identity(
+      &g, test::graph::Constant(&g, test::AsScalar<float>(2.0f)));
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  SessionOptions options;
+  // Enough for the executors of a single fetch.
+  options.config.mutable_experimental()->set_executor_cache_max_nodes(5);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  const std::vector<std::vector<string>> fetches = {
+      {a->name() + ":0"},
+      {b->name() + ":0"},
+      {b->name() + ":0", a->name() + ":0"},
+      {a->name() + ":0"}};
+  const std::vector<std::vector<float>> expected = {
+      {1.0f}, {2.0f}, {2.0f, 1.0f}, {1.0f}};
+  const string cache = "/tensorflow/core/direct_session_executor_cache";
+  const int64 hits = ResultCounterValue(cache, "hit");
+  const int64 misses = ResultCounterValue(cache, "miss");
+  const int64 evictions = ResultCounterValue(cache, "evicted");
+  for (int repeat = 0; repeat < 2; ++repeat) {
+    for (int i = 0; i < fetches.size(); ++i) {
+      std::vector<Tensor> outputs;
+      TF_ASSERT_OK(session->Run({}, fetches[i], {}, &outputs));
+      ASSERT_EQ(expected[i].size(), outputs.size());
+      for (int j = 0; j < outputs.size(); ++j) {
+        EXPECT_EQ(expected[i][j], outputs[j].scalar<float>()());
+      }
+    }
+  }
+  // Each new signature evicts the executors of the previous one, so only the
+  // repeated fetch of a at the start of the second round finds them cached.
+  // Every other run recreates the executors that were evicted before it.
+  EXPECT_EQ(hits + 1, ResultCounterValue(cache, "hit"));
+  EXPECT_EQ(misses + 7, ResultCounterValue(cache, "miss"));
+  EXPECT_EQ(evictions + 6, ResultCounterValue(cache, "evicted"));
+}
+
+TEST(DirectSessionTest, AutotunesInterOpThreadPool) {
+  Graph g(OpRegistry::Global());
+  Node* a = test::graph::Constant(&g, test::AsScalar<float>(1.0f));
+  Node* b = test::graph::Constant(&g, test::AsScalar<float>(2.0f));
+  Node* c = test::graph::Add(&g, test::graph::Identity(&g, a),
+                             test::graph::Identity(&g, b));
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  SessionOptions options;
+  options.config.set_inter_op_parallelism_threads(4);
+  options.config.set_use_per_session_threads(true);
+  options.config.mutable_experimental()->set_inter_op_autotune_steps(2);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  // Enough steps to try each pool size and to run on the one picked.
+  for (int step = 0; step < 20; ++step) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {c->name() + ":0"}, {}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_EQ(3.0f, outputs[0].scalar<float>()());
+  }
+}
+
+TEST(DirectSessionTest, LargePartitions) {
+  // Large enough for the kernels of each partition to be created in chunks.
+  const int kNumAdds = 1000;
+  Graph g(OpRegistry::Global());
+  Node* x;
+  TF_ASSERT_OK(NodeBuilder(g.NewName("x"), "Placeholder")
+                   .Attr("shape", TensorShape())
+                   .Attr("dtype", DT_FLOAT)
+                   .Finalize(&g, &x));
+  Node* y = x;
+  for (int i = 0; i < kNumAdds; ++i) {
+    y = test::graph::Add(&g, y, x);
+    y->set_requested_device(i < kNumAdds / 2 ? "/cpu:0" : "/cpu:1");
+  }
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({{x->name(), test::AsScalar<float>(1.0f)}},
+                            {y->name() + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_EQ(kNumAdds + 1, outputs[0].scalar<float>()());
+}
+
 TEST(DirectSessionTest, TestTensorConnectionUseTwice) {
   Graph graph(OpRegistry::Global());
 
@@ -1355,6 +1606,41 @@ TEST(DirectSessionTest, RunHandleTest_Callable) {
   ASSERT_TRUE(s.ok());
 }
 
+TEST(DirectSessionTest, RunCallableWithStepsPerRun) {
+  Graph g(OpRegistry::Global());
+  Tensor zero(DT_FLOAT, TensorShape({}));
+  zero.scalar<float>()() = 0.0;
+  Tensor one(DT_FLOAT, TensorShape({}));
+  one.scalar<float>()() = 1.0;
+  // var = 0; each step runs var = var + 1.
+  Node* var = test::graph::Var(&g, DT_FLOAT, TensorShape({}));
+  Node* init = test::graph::Assign(&g, var, test::graph::Constant(&g, zero));
+  Node* increment = test::graph::Assign(
+      &g, var, test::graph::Add(&g, var, test::graph::Constant(&g, one)));
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+  std::vector<Tensor> unused_outputs;
+  TF_ASSERT_OK(session->Run({}, {}, {init->name()}, &unused_outputs));
+
+  CallableOptions callable_options =
+      MakeCallableOptions({}, {increment->name() + ":0"}, {});
+  callable_options.set_steps_per_run(3);
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(callable_options, &handle));
+  for (int i = 1; i <= 2; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->RunCallable(handle, {}, &outputs, nullptr));
+    ASSERT_EQ(1, outputs.size());
+    // The fetch holds the value of the last step.
+    EXPECT_EQ(3.0 * i, outputs[0].scalar<float>()());
+  }
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+}
+
 TEST(DirectSessionTest, CreateGraphFailsWhenAssigningAFedVar) {
   Graph graph(OpRegistry::Global());
 
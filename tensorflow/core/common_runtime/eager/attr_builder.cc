@@ -96,10 +96,51 @@ Status AttrTypeMapForOp(const char* op_name, const AttrTypeMap** out) {
   return Status::OK();
 }
 
+namespace {
+inline tensorflow::Fprint128 FingerprintCat128(const tensorflow::Fprint128& a,
+                                               const tensorflow::Fprint128& b) {
+  return {tensorflow::FingerprintCat64(a.low64, b.low64),
+          tensorflow::FingerprintCat64(a.high64, b.high64)};
+}
+
+void CombineUnordered(const tensorflow::Fprint128& a,
+                      tensorflow::Fprint128* b) {
+  b->low64 += a.low64;
+  b->high64 += a.high64;
+}
+
+inline tensorflow::Fprint128 CacheKeyHelper(StringPiece s,
+                                            const tensorflow::Fprint128& b) {
+  tensorflow::Fprint128 a = tensorflow::Fingerprint128(s);
+  return FingerprintCat128(a, b);
+}
+
+inline tensorflow::Fprint128 CacheKeyHelper(StringPiece s, uint64 b) {
+  return CacheKeyHelper(s, {b, b});
+}
+
+inline uint64 AttrFingerprint(int value) { return static_cast<uint64>(value); }
+
+inline uint64 AttrFingerprint(float value) {
+  static std::hash<float> float_hasher;
+  return static_cast<uint64>(float_hasher(value));
+}
+
+inline uint64 AttrFingerprint(bool value) { return value ? 1u : 0u; }
+
+inline uint64 AttrFingerprint(tensorflow::DataType value) {
+  return static_cast<uint64>(value);
+}
+
+}  // namespace
+
 #define DEFINE_SET_ATTR(value_type, value_field)                             \
   template <>                                                                \
   AttrBuilder& AttrBuilder::Set(StringPiece attr_name, value_type&& value) { \
     value_field.push_back(std::make_pair(attr_name, value));                 \
+    CombineUnordered(CacheKeyHelper(attr_name, AttrFingerprint(value)),      \
+                     &attrs_fingerprint_);                                   \
+    cached_cache_key_.reset();                                               \
     return *this;                                                            \
   }
 
@@ -162,6 +203,7 @@ const NodeDef& AttrBuilder::BuildNodeDef() {
   }
   FillAttrValueMap(node_def_->mutable_attr(), false);
   node_def_finalized_ = true;
+  cached_cache_key_.reset();
   return *node_def_;
 }
 
@@ -181,32 +223,16 @@ Status AttrTypeByName(const AttrTypeMap& m, const string& attr_name,
   return Status::OK();
 }
 
-namespace {
-inline tensorflow::Fprint128 FingerprintCat128(const tensorflow::Fprint128& a,
-                                               const tensorflow::Fprint128& b) {
-  return {tensorflow::FingerprintCat64(a.low64, b.low64),
-          tensorflow::FingerprintCat64(a.low64, b.low64)};
-}
-
-void CombineUnordered(const tensorflow::Fprint128& a,
-                      tensorflow::Fprint128* b) {
-  b->low64 += a.low64;
-  b->high64 += a.high64;
-}
-
-inline tensorflow::Fprint128 CacheKeyHelper(StringPiece s,
-                                            const tensorflow::Fprint128& b) {
-  tensorflow::Fprint128 a = tensorflow::Fingerprint128(s);
-  return FingerprintCat128(a, b);
-}
-
-inline tensorflow::Fprint128 CacheKeyHelper(StringPiece s, uint64 b) {
-  return CacheKeyHelper(s, {b, b});
+tensorflow::Fprint128 AttrBuilder::CacheKey(const string& device) const {
+  if (!cached_cache_key_ || device != device_for_cached_cache_key_) {
+    cached_cache_key_ = BuildCacheKeyForDevice(device);
+    device_for_cached_cache_key_ = device;
+  }
+  return *cached_cache_key_;
 }
 
-}  // namespace
-
-tensorflow::Fprint128 AttrBuilder::CacheKey(const string& device) const {
+tensorflow::Fprint128 AttrBuilder::BuildCacheKeyForDevice(
+    const string& device) const {
   tensorflow::Fprint128 f = tensorflow::Fingerprint128(op_name_);
   f = tensorflow::FingerprintCat128(f, tensorflow::Fingerprint128(device));
   if (node_def_ != nullptr) {
@@ -223,23 +249,7 @@ tensorflow::Fprint128 AttrBuilder::CacheKey(const string& device) const {
     // not been called.
     if (node_def_finalized_) return f;
   }
-  for (const auto& p : int_attrs_) {
-    CombineUnordered(CacheKeyHelper(p.first, static_cast<uint64>(p.second)),
-                     &f);
-  }
-  static std::hash<float> float_hasher;
-  for (const auto& p : float_attrs_) {
-    CombineUnordered(
-        CacheKeyHelper(p.first, static_cast<uint64>(float_hasher(p.second))),
-        &f);
-  }
-  for (const auto& p : bool_attrs_) {
-    CombineUnordered(CacheKeyHelper(p.first, p.second ? 1u : 0u), &f);
-  }
-  for (const auto& p : type_attrs_) {
-    CombineUnordered(CacheKeyHelper(p.first, static_cast<uint64>(p.second)),
-                     &f);
-  }
+  CombineUnordered(attrs_fingerprint_, &f);
   return f;
 }
 
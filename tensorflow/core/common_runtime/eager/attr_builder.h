@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/lib/gtl/optional.h"
 #include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 
@@ -78,6 +79,10 @@ Status AttrTypeByName(const AttrTypeMap& m, const string& attr_name,
 // BuildNodeDef. Also, calls to NumInputs or Set between multiple invocations
 // to CacheKey may cause different values to be returned by CacheKey.
 //
+// The fingerprint of the int, float, bool and type attributes is updated as
+// they are Set, and the last key is memoized per device, so computing the
+// cache key on every execution of an op is cheap.
+//
 // For performance reasons, the class internally delays the actual construction
 // of the NodeDef till BuildNodeDef is called, or Set is called with certain
 // uncommon types (see template specializations of Set to see which types
@@ -85,7 +90,8 @@ Status AttrTypeByName(const AttrTypeMap& m, const string& attr_name,
 class AttrBuilder {
  public:
   explicit AttrBuilder(const char* op)
-      : op_name_(op),
+      : attrs_fingerprint_{0, 0},
+        op_name_(op),
         num_inputs_(0),
         node_def_(nullptr),
         node_def_finalized_(false) {}
@@ -95,6 +101,7 @@ class AttrBuilder {
 
   template <class T>
   AttrBuilder& Set(StringPiece attr_name, T&& value) {
+    cached_cache_key_.reset();
     MayBeInitializeNodeDef();
     SetInAttrValueMap(node_def_->mutable_attr(), attr_name, value);
     return *this;
@@ -110,6 +117,7 @@ class AttrBuilder {
   using AttrVec = tensorflow::gtl::InlinedVector<std::pair<StringPiece, T>, 2>;
 
   void MayBeInitializeNodeDef();
+  tensorflow::Fprint128 BuildCacheKeyForDevice(const string& device) const;
   // Fill `m` with the attr-value pairs set via AttrBuilder::Set() so far, as
   // well as any default attr-value pairs from the associated op_def, if there
   // is one.
@@ -141,10 +149,17 @@ class AttrBuilder {
   AttrVec<float> float_attrs_;
   AttrVec<bool> bool_attrs_;
   AttrVec<tensorflow::DataType> type_attrs_;
+  // Unordered combination of the fingerprints of the attributes above.
+  tensorflow::Fprint128 attrs_fingerprint_;
   const string op_name_;
   int num_inputs_;
   std::unique_ptr<NodeDef> node_def_;
   bool node_def_finalized_;
+
+  // The key last returned by CacheKey, and the device it was computed for.
+  // Reset whenever an attribute is set or the NodeDef is built.
+  mutable gtl::optional<tensorflow::Fprint128> cached_cache_key_;
+  mutable string device_for_cached_cache_key_;
 };  // namespace tensorflow
 
 template <>
@@ -58,5 +58,34 @@ TEST(AttrTypeMap, Lookup) {
   EXPECT_NE(is_list, 0);
 }
 
+TEST(AttrBuilder, CacheKey) {
+  AttrBuilder a("MatMul");
+  a.Set("transpose_a", true).Set("T", DT_FLOAT);
+  AttrBuilder b("MatMul");
+  b.Set("T", DT_FLOAT).Set("transpose_a", true);
+  const Fprint128 key = a.CacheKey("cpu:0");
+  EXPECT_EQ(key, a.CacheKey("cpu:0"));
+  // The order in which attributes are set does not matter.
+  EXPECT_EQ(key, b.CacheKey("cpu:0"));
+  EXPECT_FALSE(key == a.CacheKey("gpu:0"));
+  EXPECT_EQ(key, a.CacheKey("cpu:0"));
+
+  b.Set("transpose_b", true);
+  EXPECT_FALSE(key == b.CacheKey("cpu:0"));
+  AttrBuilder c("MatMul");
+  c.Set("transpose_a", false).Set("T", DT_FLOAT);
+  EXPECT_FALSE(key == c.CacheKey("cpu:0"));
+}
+
+void BM_CacheKey(int iters) {
+  const string device = "/job:localhost/replica:0/task:0/device:CPU:0";
+  for (int i = 0; i < iters; ++i) {
+    AttrBuilder a("MatMul");
+    a.Set("T", DT_FLOAT).Set("transpose_a", false).Set("transpose_b", false);
+    tensorflow::testing::DoNotOptimize(a.CacheKey(device));
+  }
+}
+BENCHMARK(BM_CacheKey);
+
 }  // namespace
 }  // namespace tensorflow
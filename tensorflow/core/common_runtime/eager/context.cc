@@ -66,6 +66,7 @@ EagerContext::EagerContext(const SessionOptions& opts,
           device_mgr, opts.env, TF_GRAPH_DEF_VERSION, &func_lib_def_, {},
           thread_pool_.get())),
       log_device_placement_(opts.config.log_device_placement()),
+      executor_(ReadBoolFromEnvVar("TF_EAGER_ASYNC_PER_DEVICE_QUEUES", true)),
       num_active_steps_(0),
       async_default_(async),
       log_memory_(LogMemory::IsEnabled()),
@@ -111,6 +112,9 @@ void EagerContext::InitDeviceMapAndAsync() {
 }
 
 bool EagerContext::Async() const {
+  if (!has_thread_local_async_.load(std::memory_order_acquire)) {
+    return async_default_;
+  }
   mutex_lock l(async_map_mu_);
   return gtl::FindWithDefault(thread_local_async_, std::this_thread::get_id(),
                               async_default_);
@@ -120,6 +124,7 @@ Status EagerContext::SetAsyncForThread(bool async) {
   {
     tensorflow::mutex_lock l(async_map_mu_);
     thread_local_async_[std::this_thread::get_id()] = async;
+    has_thread_local_async_.store(true, std::memory_order_release);
   }
   if (async) {
     executor_.EnableAsync();
@@ -266,6 +266,9 @@ class EagerContext {
   mutable mutex async_map_mu_;
   std::unordered_map<std::thread::id, bool> thread_local_async_
       GUARDED_BY(async_map_mu_);
+  // Set once any thread overrides the default, so that Async() need not take
+  // async_map_mu_ on every op while there are no overrides.
+  std::atomic<bool> has_thread_local_async_{false};
 
   const bool log_memory_;
 
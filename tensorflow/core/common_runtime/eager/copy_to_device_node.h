@@ -55,6 +55,8 @@ class CopyToDeviceNode : public EagerNode {
     return Status::OK();
   }
 
+  Device* device() const override { return dstd_; }
+
   TensorHandle* dst() { return dst_; }
 
  private:
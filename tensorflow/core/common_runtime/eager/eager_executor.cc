@@ -15,14 +15,33 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/eager/eager_executor.h"
 
+#include <vector>
+
 namespace tensorflow {
 
 EagerNode::EagerNode(tensorflow::uint64 id) : id(id) {}
 
+EagerExecutor::EagerExecutor(bool per_device_queues)
+    : per_device_queues_(per_device_queues) {}
+
 EagerExecutor::~EagerExecutor() {
-  tensorflow::mutex_lock l(node_queue_mutex_);
-  thread_done_ = true;
-  nodes_pending_.notify_all();
+  std::vector<Queue*> queues;
+  {
+    tensorflow::mutex_lock l(node_queue_mutex_);
+    thread_done_ = true;
+    if (default_queue_ != nullptr) queues.push_back(default_queue_.get());
+    for (auto& device_and_queue : device_queues_) {
+      queues.push_back(device_and_queue.second.get());
+    }
+    for (Queue* queue : queues) {
+      queue->nodes_pending.notify_all();
+    }
+  }
+  // Join every thread before any queue is destroyed, since a thread hitting an
+  // error clears the queues of the others.
+  for (Queue* queue : queues) {
+    queue->thread.reset();
+  }
 }
 
 tensorflow::uint64 EagerExecutor::NextId() {
@@ -32,33 +51,42 @@ tensorflow::uint64 EagerExecutor::NextId() {
 
 void EagerExecutor::EnableAsync() {
   tensorflow::mutex_lock l(node_queue_mutex_);
-  if (thread_ == nullptr) {
-    thread_.reset(tensorflow::Env::Default()->StartThread(
+  GetQueue(nullptr);
+}
+
+EagerExecutor::Queue* EagerExecutor::GetQueue(Device* device) {
+  std::unique_ptr<Queue>* queue =
+      (device == nullptr || !per_device_queues_) ? &default_queue_
+                                                 : &device_queues_[device];
+  if (*queue == nullptr) {
+    queue->reset(new Queue);
+    Queue* q = queue->get();
+    q->thread.reset(tensorflow::Env::Default()->StartThread(
         tensorflow::ThreadOptions(), "eager_async_executor",
-        std::bind(&EagerExecutor::Run, this)));
+        [this, q]() { Run(q); }));
   }
+  return queue->get();
 }
 
 void EagerExecutor::Add(EagerNode* node) {
   tensorflow::mutex_lock l(node_queue_mutex_);
-  DCHECK(thread_) << "EnableAsync should have been called before Add";
+  DCHECK(default_queue_) << "EnableAsync should have been called before Add";
   if (!status_.ok()) {
     delete node;
     return;
   }
-  int64 qlen = node_queue_.size();
-  if (qlen > 0) {
-    if (node_queue_.back()->id >= node->id) {
-      status_ = tensorflow::errors::InvalidArgument(
-          "Inserting EagerNode with non-increasing ids:",
-          node_queue_.back()->id, " vs ", node->id);
-      delete node;
-      return;
-    }
-    node_queue_.push(node);
-  } else {
-    node_queue_.push(node);
-    nodes_pending_.notify_all();
+  if (!pending_ids_.empty() && *pending_ids_.rbegin() >= node->id) {
+    status_ = tensorflow::errors::InvalidArgument(
+        "Inserting EagerNode with non-increasing ids:", *pending_ids_.rbegin(),
+        " vs ", node->id);
+    delete node;
+    return;
+  }
+  Queue* queue = GetQueue(node->device());
+  pending_ids_.insert(node->id);
+  queue->nodes.push(node);
+  if (queue->nodes.size() == 1) {
+    queue->nodes_pending.notify_all();
   }
 }
 
@@ -70,36 +98,40 @@ tensorflow::Status EagerExecutor::WaitForAllPendingNodes() {
   return WaitImpl(true, 0);
 }
 
+bool EagerExecutor::Done(bool wait_all, tensorflow::uint64 node_id) {
+  if (wait_all) {
+    return pending_ids_.empty() || *pending_ids_.begin() > node_id;
+  }
+  return pending_ids_.count(node_id) == 0;
+}
+
 tensorflow::Status EagerExecutor::WaitImpl(bool wait_all,
                                            tensorflow::uint64 node_id) {
-  tensorflow::condition_variable cond;
   tensorflow::mutex_lock l(node_queue_mutex_);
   // Don't wait if an error is already set.
   if (!status_.ok()) return status_;
-  if (node_queue_.empty()) return tensorflow::Status::OK();
-  if (wait_all) {
-    node_id = node_queue_.back()->id;
-  } else if (node_id < node_queue_.front()->id) {
-    // Note that we are relying on the ops being dispatched sequentially from
-    // the queue.
-    return tensorflow::Status::OK();
-  }
-  node_done_notifications_.insert(std::make_pair(node_id, &cond));
-  cond.wait(l);
+  if (pending_ids_.empty()) return tensorflow::Status::OK();
+  if (wait_all) node_id = *pending_ids_.rbegin();
+  ++num_waiters_;
   // Note that we could be woken up if an error occurs, even though the node has
   // not actually executed.
+  while (status_.ok() && !Done(wait_all, node_id)) {
+    nodes_done_.wait(l);
+  }
+  --num_waiters_;
   return status_;
 }
 
 void EagerExecutor::ClearError() {
   tensorflow::mutex_lock l(node_queue_mutex_);
   if (status_.ok()) return;
-  // If an error was set, node_done_notifications_ and node_queue_ should have
-  // been cleared, and no new entries should have been added since.
-  DCHECK(node_done_notifications_.empty());
-  DCHECK(node_queue_.empty());
+  // If an error was set, the queues should have been cleared, and no new
+  // entries should have been added since.
+  DCHECK(default_queue_ == nullptr || default_queue_->nodes.empty());
+  for (const auto& device_and_queue : device_queues_) {
+    DCHECK(device_and_queue.second->nodes.empty());
+  }
   status_ = tensorflow::Status::OK();
-  nodes_pending_.notify_all();
 }
 
 tensorflow::Status EagerExecutor::status() {
@@ -107,44 +139,47 @@ tensorflow::Status EagerExecutor::status() {
   return status_;
 }
 
-void EagerExecutor::Run() {
+void EagerExecutor::Run(Queue* queue) {
   while (true) {
     std::unique_ptr<EagerNode> curr_node;
     {
       tensorflow::mutex_lock l(node_queue_mutex_);
-      while (node_queue_.empty() || !status_.ok()) {
+      while (queue->nodes.empty() || !status_.ok()) {
         if (thread_done_) return;
-        nodes_pending_.wait(l);
+        queue->nodes_pending.wait(l);
       }
-      curr_node.reset(node_queue_.front());
+      // The node is taken off the queue while it runs, so that an error in
+      // another queue does not delete it.
+      curr_node.reset(queue->nodes.front());
+      queue->nodes.pop();
     }
     tensorflow::Status status = curr_node->Run();
     const bool ok = status.ok();
     tensorflow::mutex_lock l(node_queue_mutex_);
-    node_queue_.pop();
-    if (!ok) {
+    pending_ids_.erase(curr_node->id);
+    if (!ok && status_.ok()) {
       status_ = status;
       // TODO(agarwal): mark all affected handles as corrupted before clearing
-      // this queue.
+      // the queues.
       // We remove any pending ops so that we don't try to execute them if
       // ClearError is called.
-      for (int i = 0; i < node_queue_.size(); ++i) {
-        delete node_queue_.front();
-        node_queue_.pop();
+      auto clear = [this](Queue* q) {
+        while (!q->nodes.empty()) {
+          pending_ids_.erase(q->nodes.front()->id);
+          delete q->nodes.front();
+          q->nodes.pop();
+        }
+      };
+      clear(default_queue_.get());
+      for (auto& device_and_queue : device_queues_) {
+        clear(device_and_queue.second.get());
       }
     }
-    if (!node_done_notifications_.empty()) {
-      tensorflow::uint64 node_id = curr_node->id;
-      // Note that we notify all waiting threads in case an error has occurred.
-      // These calling threads are responsible for checking status_ before
-      // proceeding.
-      const auto range = ok ? node_done_notifications_.equal_range(node_id)
-                            : make_pair(node_done_notifications_.begin(),
-                                        node_done_notifications_.end());
-      for (auto it = range.first; it != range.second; ++it) {
-        it->second->notify_all();
-      }
-      node_done_notifications_.erase(range.first, range.second);
+    // Note that we notify all waiting threads in case an error has occurred.
+    // These calling threads are responsible for checking status_ before
+    // proceeding.
+    if (num_waiters_ > 0 || !ok) {
+      nodes_done_.notify_all();
     }
   }
 }
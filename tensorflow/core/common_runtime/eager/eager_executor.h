@@ -20,8 +20,10 @@ limitations under the License.
 #include <map>
 #include <memory>
 #include <queue>
+#include <set>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/device_factory.h"
@@ -50,6 +52,10 @@ class EagerNode {
   // execution is done.
   virtual Status Run() = 0;
 
+  // The device whose queue this node is executed in. Nodes returning nullptr
+  // share a single queue.
+  virtual Device* device() const { return nullptr; }
+
   // An id unique to the TFE_Context under which this node is created. Allocated
   // monotonically.
   const uint64 id;
@@ -57,15 +63,21 @@ class EagerNode {
 
 // A class for handling async execution (see TFE_ContextSetAsync).
 // Note that this class is thread-safe.
+//
+// If `per_device_queues` is true, the EagerNodes of each device are executed
+// in order by a thread of their own, so that a slow node on one device does
+// not hold back dispatch to the others. Nodes depend on nodes of other
+// devices only through their input TensorHandles, whose accessors wait for the
+// producing node. Since those always have a smaller id, the pending node with
+// the smallest id can always run and the queues cannot deadlock.
 // TODO(agarwal): TFE_OpAddInput may currently block if it tries to access the
 // device of the input handle. Fix that.
 // TODO(agarwal): On error, mark all affected handles as corrupted.
 // TODO(agarwal): Implement support for control dependencies.
-// TODO(agarwal): Support out-of-order execution and dispatching multiple
-// EagerNode in parallel.
 // TODO(agarwal): Implement optimizations over EagerNode traces.
 class EagerExecutor {
  public:
+  explicit EagerExecutor(bool per_device_queues = false);
   ~EagerExecutor();
 
   // This is called whenever async mode is enabled. Note that it may be called
@@ -95,40 +107,59 @@ class EagerExecutor {
   Status status();
 
  private:
-  // Starts execution of pending EagerNodes. This function loops till
-  // thread_done_ is set to true. If any errors are encontered, these are set
-  // inside `status_`. The loop blocks anytime there are no pending nodes, or if
-  // `status_` is not ok.
-  void Run();
+  // The nodes of one device, and the thread executing them.
+  struct Queue {
+    // Used to signal that some EagerNodes are pending execution.
+    condition_variable nodes_pending;
 
-  Status WaitImpl(bool wait_all, uint64 node_id);
+    std::queue<EagerNode*> nodes;
 
-  mutex node_queue_mutex_;
+    // Joined by ~EagerExecutor, before any queue is destroyed.
+    std::unique_ptr<Thread> thread;
+  };
+
+  // Returns the queue of `device`, starting its thread if it is new.
+  Queue* GetQueue(Device* device) EXCLUSIVE_LOCKS_REQUIRED(node_queue_mutex_);
+
+  // Starts execution of the EagerNodes pending in `queue`. This function loops
+  // till thread_done_ is set to true. If any errors are encontered, these are
+  // set inside `status_`. The loop blocks anytime there are no pending nodes,
+  // or if `status_` is not ok.
+  void Run(Queue* queue);
+
+  // Returns true if `node_id`, or with `wait_all` every node up to it, has
+  // finished executing.
+  bool Done(bool wait_all, uint64 node_id)
+      EXCLUSIVE_LOCKS_REQUIRED(node_queue_mutex_);
 
-  // Used to signal that some EagerNodes are pending execution.
-  condition_variable nodes_pending_ GUARDED_BY(node_queue_mutex_);
+  Status WaitImpl(bool wait_all, uint64 node_id);
+
+  const bool per_device_queues_;
 
-  // Queue of pending EagerNodes.
-  std::queue<EagerNode*> node_queue_ GUARDED_BY(node_queue_mutex_);
+  mutex node_queue_mutex_;
 
   // `status_` is set based on any errors raised during execution of a
   // EagerNode.  It remains set until ClearError is called.
   Status status_ GUARDED_BY(node_queue_mutex_);
 
-  // Map from id of a EagerNode to condition_variables (not owned by the map).
-  // These condition_variables are notified and removed when that EagerNode is
-  // done executing, or if an error is found in execution of any EagerNode.
-  std::multimap<uint64, condition_variable*> node_done_notifications_
-      GUARDED_BY(node_queue_mutex_);
+  // Ids of the EagerNodes that were added and have not finished executing.
+  std::set<uint64> pending_ids_ GUARDED_BY(node_queue_mutex_);
 
-  // Thread object that calls the `Run` method. Currently we use only one thread
-  // for executing the EagerNodes one-by-one.
-  std::unique_ptr<Thread> thread_ GUARDED_BY(node_queue_mutex_);
+  // Notified whenever an EagerNode finishes while `num_waiters_` is non-zero,
+  // and if an error is found in execution of any EagerNode.
+  condition_variable nodes_done_;
+  int num_waiters_ GUARDED_BY(node_queue_mutex_) = 0;
 
-  // Indicates that `thread_` should stop as soon as it is done executing the
-  // current EagerNode.
+  // Indicates that the threads should stop as soon as they are done executing
+  // their current EagerNode.
   bool thread_done_ GUARDED_BY(node_queue_mutex_) = false;
 
+  // Queue of the nodes without a device, which is also the queue of every node
+  // when `per_device_queues_` is false.
+  std::unique_ptr<Queue> default_queue_ GUARDED_BY(node_queue_mutex_);
+  std::unordered_map<Device*, std::unique_ptr<Queue>> device_queues_
+      GUARDED_BY(node_queue_mutex_);
+
   mutex next_id_mutex_;
   uint64 next_id_ GUARDED_BY(next_id_mutex_) = 1;
 };
@@ -0,0 +1,138 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/eager/eager_executor.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+class TestNode : public EagerNode {
+ public:
+  TestNode(uint64 id, Device* device, std::function<Status()> fn)
+      : EagerNode(id), device_(device), fn_(std::move(fn)) {}
+
+  Status Run() override { return fn_(); }
+
+  Device* device() const override { return device_; }
+
+ private:
+  Device* const device_;
+  const std::function<Status()> fn_;
+};
+
+class EagerExecutorTest : public ::testing::Test {
+ protected:
+  EagerExecutorTest()
+      : device0_(
+            DeviceFactory::NewDevice("CPU", {}, "/job:a/replica:0/task:0")),
+        device1_(
+            DeviceFactory::NewDevice("CPU", {}, "/job:a/replica:0/task:1")) {}
+
+  std::unique_ptr<Device> device0_;
+  std::unique_ptr<Device> device1_;
+};
+
+TEST_F(EagerExecutorTest, SlowDeviceDoesNotBlockOthers) {
+  EagerExecutor executor(/*per_device_queues=*/true);
+  executor.EnableAsync();
+  Notification unblock;
+  const uint64 slow_id = executor.NextId();
+  executor.Add(new TestNode(slow_id, device0_.get(), [&unblock]() {
+    unblock.WaitForNotification();
+    return Status::OK();
+  }));
+  bool fast_done = false;
+  const uint64 fast_id = executor.NextId();
+  executor.Add(new TestNode(fast_id, device1_.get(), [&fast_done]() {
+    fast_done = true;
+    return Status::OK();
+  }));
+  TF_EXPECT_OK(executor.WaitFor(fast_id));
+  EXPECT_TRUE(fast_done);
+  unblock.Notify();
+  TF_EXPECT_OK(executor.WaitForAllPendingNodes());
+}
+
+TEST_F(EagerExecutorTest, NodesOfOneDeviceRunInOrder) {
+  EagerExecutor executor(/*per_device_queues=*/true);
+  executor.EnableAsync();
+  std::vector<int> order;
+  for (int i = 0; i < 10; ++i) {
+    executor.Add(new TestNode(executor.NextId(), device0_.get(), [&order, i]() {
+      order.push_back(i);
+      return Status::OK();
+    }));
+  }
+  TF_EXPECT_OK(executor.WaitForAllPendingNodes());
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}), order);
+}
+
+TEST_F(EagerExecutorTest, WaitForNodeOfOtherDevice) {
+  EagerExecutor executor(/*per_device_queues=*/true);
+  executor.EnableAsync();
+  bool producer_done = false;
+  const uint64 producer_id = executor.NextId();
+  executor.Add(new TestNode(producer_id, device0_.get(), [&producer_done]() {
+    Env::Default()->SleepForMicroseconds(10000);
+    producer_done = true;
+    return Status::OK();
+  }));
+  bool saw_producer = false;
+  executor.Add(new TestNode(
+      executor.NextId(), device1_.get(),
+      [&executor, &producer_done, &saw_producer, producer_id]() {
+        TF_RETURN_IF_ERROR(executor.WaitFor(producer_id));
+        saw_producer = producer_done;
+        return Status::OK();
+      }));
+  TF_EXPECT_OK(executor.WaitForAllPendingNodes());
+  EXPECT_TRUE(saw_producer);
+}
+
+TEST_F(EagerExecutorTest, ErrorCancelsPendingNodes) {
+  EagerExecutor executor(/*per_device_queues=*/true);
+  executor.EnableAsync();
+  Notification unblock;
+  executor.Add(new TestNode(executor.NextId(), device0_.get(), [&unblock]() {
+    unblock.WaitForNotification();
+    return errors::Internal("failed");
+  }));
+  bool ran = false;
+  executor.Add(new TestNode(executor.NextId(), device0_.get(), [&ran]() {
+    ran = true;
+    return Status::OK();
+  }));
+  unblock.Notify();
+  EXPECT_EQ(error::INTERNAL, executor.WaitForAllPendingNodes().code());
+  EXPECT_FALSE(ran);
+  EXPECT_EQ(error::INTERNAL, executor.status().code());
+  executor.ClearError();
+  TF_EXPECT_OK(executor.status());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -48,6 +48,12 @@ namespace {
 // depend on it directly.
 const char* const kXlaCompileAttr = "_XlaCompile";
 
+// Device name used in the kernel cache key of ops without a requested device.
+const string& UnspecifiedDeviceName() {
+  static const string* const name = new string("unspecified");
+  return *name;
+}
+
 // Initializes the step stats if needed.
 void MaybeInitializeStepStats(StepStats* step_stats, EagerContext* ctx) {
   // Lazily initialize the RunMetadata with information about all devices if
@@ -254,8 +260,10 @@ Status EagerLocalExecute(EagerOperation* op,
   if (!status.ok()) return status;
   Device* device = op->Device();
 
+  // The kernel, and so the device selected for an op without a requested
+  // device, is memoized under this key.
   Fprint128 cache_key = op->MutableAttrs()->CacheKey(
-      device == nullptr ? "unspecified" : device->name());
+      device == nullptr ? UnspecifiedDeviceName() : device->name());
   KernelAndDevice* kernel = ctx->GetCachedKernel(cache_key);
   if (kernel == nullptr) {
     // If we are running a function on explicitly requested TPU,
@@ -63,6 +63,8 @@ class ExecuteNode : public EagerNode {
     }
   }
 
+  Device* device() const override { return kernel_->device(); }
+
   tensorflow::Status Run() override {
     const Status status = EagerExecute(
         ctx_, op_device_, inputs_, kernel_, maybe_stats_.get(),
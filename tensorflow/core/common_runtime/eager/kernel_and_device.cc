@@ -131,6 +131,8 @@ Status KernelAndDevice::Run(ScopedStepContainer* step_container,
       AllocatorStats allocator_stats;
       allocator_pair.first->GetStats(&allocator_stats);
       memory->set_allocator_bytes_in_use(allocator_stats.bytes_in_use);
+      memory->set_allocator_largest_free_block_bytes(
+          allocator_stats.largest_free_block_bytes);
       allocator_pair.second->GetRecordsAndUnRef();
     }
     auto* ms = stats->mutable_memory_stats();
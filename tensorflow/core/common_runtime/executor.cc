@@ -15,8 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/executor.h"
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -25,6 +27,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/common_runtime/sampled_profiler.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/allocator.h"
@@ -34,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/log_memory.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/op_segment.h"
@@ -55,12 +60,14 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 
 namespace tensorflow {
@@ -73,6 +80,44 @@ bool IsInitializationOp(const Node* node) {
   return node->op_def().allows_uninitialized_input();
 }
 
+// Returns the execution time from which a node whose times were measured is
+// run on its own thread rather than inline, as set by
+// TF_EXECUTOR_EXPENSIVE_NODE_MICROS.
+int64 ExpensiveNodeThresholdMicros() {
+  static const int64 threshold = []() {
+    int64 micros;
+    Status s =
+        ReadInt64FromEnvVar("TF_EXECUTOR_EXPENSIVE_NODE_MICROS", 10, &micros);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return int64{10};
+    }
+    return micros;
+  }();
+  return threshold;
+}
+
+// The compute times of the synchronous kernels of an executor are measured in
+// one out of every kNodeCostSamplingSteps steps, so that the other steps do not
+// pay for reading the clock around every kernel.
+static constexpr int64 kNodeCostSamplingSteps = 16;
+
+// Returns true if the compute times of the synchronous kernels are sampled to
+// decide which nodes run inline, as set by TF_EXECUTOR_MEASURE_NODE_COSTS.
+bool ShouldMeasureNodeCosts() {
+  static const bool measure = []() {
+    bool enabled;
+    Status s = ReadBoolFromEnvVar("TF_EXECUTOR_MEASURE_NODE_COSTS", true,
+                                  &enabled);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return true;
+    }
+    return enabled;
+  }();
+  return measure;
+}
+
 // Helper routines for collecting step stats.
 namespace nodestats {
 inline int64 NowInNsec() { return Env::Default()->NowNanos(); }
@@ -166,6 +211,28 @@ struct NodeItem {
 
   PendingCounts::Handle pending_id;
 
+  // An exponentially weighted moving average of the compute time of the
+  // synchronous kernel, in nanoseconds capped to kint32max, or -1 until it
+  // was measured. It is updated by concurrent steps without synchronization,
+  // so some measurements may be lost.
+  mutable std::atomic<int32> measured_cost_nsec{-1};
+
+  // Returns true if the node should run on its own thread rather than inline
+  // after the node that made it ready.
+  bool IsExpensive(int64 threshold_nsec) const {
+    const int32 cost = measured_cost_nsec.load(std::memory_order_relaxed);
+    return cost < 0 ? kernel_is_expensive : cost >= threshold_nsec;
+  }
+
+  // Adds a measured compute time to measured_cost_nsec.
+  void RecordCost(int64 nsec) const {
+    const int64 sample = std::min<int64>(nsec, kint32max);
+    const int32 cost = measured_cost_nsec.load(std::memory_order_relaxed);
+    measured_cost_nsec.store(
+        static_cast<int32>(cost < 0 ? sample : cost + (sample - cost) / 8),
+        std::memory_order_relaxed);
+  }
+
   const EdgeInfo* output_edge_list() const { return output_edge_base(); }
 
   // ith output edge.
@@ -275,8 +342,12 @@ class GraphView {
 
 class ExecutorImpl : public Executor {
  public:
-  ExecutorImpl(const LocalExecutorParams& p, std::unique_ptr<const Graph> g)
-      : params_(p), graph_(std::move(g)), gview_() {
+  ExecutorImpl(const LocalExecutorParams& p, std::unique_ptr<const Graph> g,
+               bool use_work_stealing = false)
+      : params_(p),
+        graph_(std::move(g)),
+        gview_(),
+        use_work_stealing_(use_work_stealing) {
     CHECK(p.create_kernel != nullptr);
     CHECK(p.delete_kernel != nullptr);
   }
@@ -295,6 +366,11 @@ class ExecutorImpl : public Executor {
 
   Status Initialize();
 
+  // Creates the kernels of the nodes in chunks on params_.create_kernel_pool,
+  // if the graph is large enough for that to pay off. Initialize creates the
+  // kernels left null.
+  Status CreateKernelsInParallel();
+
   // Process all Nodes in the current graph, attempting to infer the
   // memory allocation attributes to be used wherever they may allocate
   // a tensor buffer.
@@ -360,6 +436,13 @@ class ExecutorImpl : public Executor {
   // A cached value of params_
   bool device_record_tensor_accesses_ = false;
 
+  // The number of steps started, used to sample the node compute times.
+  mutable std::atomic<int64> num_steps_started_{0};
+
+  // If true, ready nodes are dispatched through per-thread work-stealing
+  // deques instead of one runner closure per node.
+  const bool use_work_stealing_;
+
   // Root nodes (with no in edges) that should form the initial ready queue
   std::vector<const Node*> root_nodes_;
 
@@ -583,6 +666,44 @@ void GetMaxPendingCounts(const Node* n, size_t* max_pending,
   *max_dead_count = num_in_edges;
 }
 
+Status ExecutorImpl::CreateKernelsInParallel() {
+  // Enough nodes for creating their kernels to outweigh scheduling a closure.
+  static const int kNodesPerChunk = 256;
+  if (params_.create_kernel_pool == nullptr ||
+      graph_->num_nodes() < 2 * kNodesPerChunk) {
+    return Status::OK();
+  }
+  std::vector<const Node*> nodes;
+  nodes.reserve(graph_->num_nodes());
+  for (const Node* n : graph_->nodes()) nodes.push_back(n);
+  const int64 num_chunks =
+      (nodes.size() + kNodesPerChunk - 1) / kNodesPerChunk;
+  // Each chunk stops at its first error. The error of the earliest chunk is
+  // returned, which is the error the sequential loop would have hit first.
+  std::vector<Status> statuses(num_chunks);
+  ParallelCall(params_.create_kernel_pool, num_chunks, [&](int64 chunk) {
+    const int64 end =
+        std::min<int64>(nodes.size(), (chunk + 1) * kNodesPerChunk);
+    for (int64 i = chunk * kNodesPerChunk; i < end; ++i) {
+      const Node* n = nodes[i];
+      NodeItem* item = gview_.node(n->id());
+      Status s = params_.create_kernel(n->def(), &item->kernel);
+      if (!s.ok()) {
+        item->kernel = nullptr;
+        statuses[chunk] = AttachDef(s, *n);
+        return;
+      }
+    }
+  });
+  for (const Status& s : statuses) {
+    if (!s.ok()) {
+      LOG(ERROR) << "Executor failed to create kernel. " << s;
+      return s;
+    }
+  }
+  return Status::OK();
+}
+
 Status ExecutorImpl::Initialize() {
   gview_.Initialize(graph_.get());
 
@@ -599,6 +720,8 @@ Status ExecutorImpl::Initialize() {
     EnsureFrameInfo(it)->nodes = new std::vector<const Node*>;
   }
 
+  TF_RETURN_IF_ERROR(CreateKernelsInParallel());
+
   // Preprocess every node in the graph to create an instance of op
   // kernel for each node.
   for (const Node* n : graph_->nodes()) {
@@ -617,15 +740,32 @@ Status ExecutorImpl::Initialize() {
     item->input_start = frame_info->total_inputs;
     frame_info->total_inputs += n->num_inputs();
 
-    Status s = params_.create_kernel(n->def(), &item->kernel);
-    if (!s.ok()) {
-      item->kernel = nullptr;
-      s = AttachDef(s, *n);
-      LOG(ERROR) << "Executor failed to create kernel. " << s;
-      return s;
+    if (item->kernel == nullptr) {
+      Status s = params_.create_kernel(n->def(), &item->kernel);
+      if (!s.ok()) {
+        item->kernel = nullptr;
+        s = AttachDef(s, *n);
+        LOG(ERROR) << "Executor failed to create kernel. " << s;
+        return s;
+      }
     }
     CHECK(item->kernel);
     item->kernel_is_expensive = item->kernel->IsExpensive();
+    if (params_.cost_model != nullptr) {
+      // Only override the kernel when all the shapes it ran with agree.
+      const int64 threshold = ExpensiveNodeThresholdMicros();
+      bool all_cheap = true;
+      bool all_expensive = true;
+      const std::vector<Microseconds> times =
+          params_.cost_model->ShapeTimePercentiles(n, 50);
+      for (Microseconds time : times) {
+        all_cheap = all_cheap && time.value() < threshold;
+        all_expensive = all_expensive && time.value() >= threshold;
+      }
+      if (!times.empty() && (all_cheap || all_expensive)) {
+        item->kernel_is_expensive = all_expensive;
+      }
+    }
     item->kernel_is_async = (item->kernel->AsAsync() != nullptr);
     item->is_merge = IsMerge(n);
     item->is_enter = IsEnter(n);
@@ -834,6 +974,167 @@ Status InferAllocAttr(const Node* n, const Node* dst,
   return s;
 }
 
+// The calling thread's membership in a WorkStealingReadyQueues worker set.
+struct WorkStealingWorker {
+  const void* owner = nullptr;
+  int index = -1;
+};
+
+WorkStealingWorker* CurrentWorkStealingWorker() {
+  static thread_local WorkStealingWorker worker;
+  return &worker;
+}
+
+// A set of ready queues used by the "WORK_STEALING" executor type.
+//
+// Every worker owns a deque. A worker pushes the nodes it makes ready to
+// the back of its own deque and pops from the back as well, so a consumer
+// usually runs on the thread (and hence the core and cache) that produced
+// its inputs. Items pushed from threads that are not workers of this set
+// (e.g. the thread starting the step or completion callbacks of async
+// kernels) go to a shared injection queue. An idle worker takes work from
+// the injection queue first and then steals from the front of the other
+// workers' deques.
+//
+// Workers are started lazily through 'runner', at most 'max_workers' at a
+// time, and return to the runner's pool as soon as no queued work is left.
+// The object is reference counted: a worker keeps it alive while it looks
+// for work, so a worker never touches the (possibly deleted) owner of
+// 'process' unless it has actually dequeued an item.
+template <typename T>
+class WorkStealingReadyQueues
+    : public std::enable_shared_from_this<WorkStealingReadyQueues<T>> {
+ public:
+  typedef std::function<void(std::function<void()>)> Runner;
+  typedef std::function<void(const T&)> ProcessFn;
+
+  WorkStealingReadyQueues(int max_workers, Runner runner, ProcessFn process)
+      : max_workers_(std::max(1, max_workers)),
+        runner_(std::move(runner)),
+        process_(std::move(process)),
+        queues_(new Queue[max_workers_ + 1]) {
+    free_slots_.reserve(max_workers_);
+    for (int i = max_workers_; i > 0; --i) {
+      free_slots_.push_back(i);
+    }
+  }
+
+  // Enqueues 'item' and starts another worker if one is available.
+  void Push(const T& item) {
+    const WorkStealingWorker* worker = CurrentWorkStealingWorker();
+    Queue* q = &queues_[worker->owner == this ? worker->index : 0];
+    {
+      mutex_lock l(q->mu);
+      num_queued_.fetch_add(1);
+      q->items.push_back(item);
+    }
+    MaybeStartWorker();
+  }
+
+ private:
+  struct Queue {
+    mutex mu;
+    // Live items are items[head, items.size()). The owner pops from the
+    // back, thieves take from the front.
+    std::vector<T> items GUARDED_BY(mu);
+    size_t head GUARDED_BY(mu) = 0;
+  };
+
+  void MaybeStartWorker() {
+    int index;
+    if (!AcquireSlot(&index)) return;
+    auto self = this->shared_from_this();
+    runner_([self, index]() { self->WorkerLoop(index); });
+  }
+
+  bool AcquireSlot(int* index) {
+    mutex_lock l(slots_mu_);
+    if (free_slots_.empty()) return false;
+    *index = free_slots_.back();
+    free_slots_.pop_back();
+    return true;
+  }
+
+  void ReleaseSlot(int index) {
+    mutex_lock l(slots_mu_);
+    free_slots_.push_back(index);
+  }
+
+  void WorkerLoop(int index) {
+    WorkStealingWorker* worker = CurrentWorkStealingWorker();
+    const WorkStealingWorker saved = *worker;
+    worker->owner = this;
+    worker->index = index;
+    T item;
+    while (true) {
+      while (Pop(index, &item)) {
+        process_(item);
+      }
+      // Give up the slot, then check again for items pushed while this
+      // worker was still counted as running (and so no new worker was
+      // started for them).
+      ReleaseSlot(index);
+      if (num_queued_.load() <= 0 || !AcquireSlot(&index)) break;
+      worker->index = index;
+    }
+    *worker = saved;
+  }
+
+  bool Pop(int index, T* item) {
+    if (num_queued_.load(std::memory_order_relaxed) <= 0) return false;
+    {
+      Queue* q = &queues_[index];
+      mutex_lock l(q->mu);
+      if (q->head < q->items.size()) {
+        *item = q->items.back();
+        q->items.pop_back();
+        if (q->head == q->items.size()) {
+          q->items.clear();
+          q->head = 0;
+        }
+        num_queued_.fetch_sub(1);
+        return true;
+      }
+    }
+    // Take from the injection queue first, then steal from the other
+    // workers' deques, starting next to this worker to spread contention.
+    for (int i = 0; i <= max_workers_; ++i) {
+      const int victim = (i == 0) ? 0 : (index + i) % (max_workers_ + 1);
+      if (victim == index || (i > 0 && victim == 0)) continue;
+      if (StealFrom(&queues_[victim], item)) return true;
+    }
+    return false;
+  }
+
+  bool StealFrom(Queue* q, T* item) {
+    mutex_lock l(q->mu);
+    if (q->head == q->items.size()) return false;
+    *item = q->items[q->head++];
+    if (q->head == q->items.size()) {
+      q->items.clear();
+      q->head = 0;
+    }
+    num_queued_.fetch_sub(1);
+    return true;
+  }
+
+  const int max_workers_;
+  const Runner runner_;
+  const ProcessFn process_;
+
+  // queues_[0] is the injection queue; queues_[i] for i in [1, max_workers_]
+  // is owned by the worker running in slot i.
+  std::unique_ptr<Queue[]> queues_;
+
+  // Number of items in all queues.
+  std::atomic<int64> num_queued_{0};
+
+  mutex slots_mu_;
+  std::vector<int> free_slots_ GUARDED_BY(slots_mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(WorkStealingReadyQueues);
+};
+
 // The state associated with one invocation of ExecutorImpl::Run.
 // ExecutorState dispatches nodes when they become ready and keeps
 // track of how many predecessors of a node have not done (pending_).
@@ -983,6 +1284,17 @@ class ExecutorState {
                                     dead_result);
     }
 
+    // Returns a finished iteration to the state of a new one, so that its
+    // storage can be reused for a later iteration of the same frame.
+    void Reset(const PendingCounts* pending_counts, int total_input_tensors) {
+      for (int i = 0; i < total_input_tensors; ++i) {
+        input_tensors[i] = Entry();
+      }
+      outstanding_ops = 0;
+      outstanding_frame_count = 0;
+      counts_.CopyFrom(*pending_counts);
+    }
+
     ~IterationState() { delete[] input_tensors; }
 
    private:
@@ -1075,6 +1387,10 @@ class ExecutorState {
     // will only "execute" the dead exits of the final iteration.
     std::vector<const Node*> dead_exits GUARDED_BY(mu);
 
+    // Finished iterations kept for reuse, so that long-running loops do not
+    // allocate their input tensors and pending counts on every iteration.
+    std::vector<IterationState*> free_iterations GUARDED_BY(mu);
+
     // Static information specific to this frame.
     PendingCounts* pending_counts = nullptr;
     int total_input_tensors = 0;
@@ -1107,6 +1423,27 @@ class ExecutorState {
       iterations[index] = state;
     }
 
+    // Returns the state for a new iteration, reusing a finished one if any.
+    IterationState* NewIteration() EXCLUSIVE_LOCKS_REQUIRED(mu) {
+      if (free_iterations.empty()) {
+        return new IterationState(pending_counts, total_input_tensors);
+      }
+      IterationState* state = free_iterations.back();
+      free_iterations.pop_back();
+      state->Reset(pending_counts, total_input_tensors);
+      return state;
+    }
+
+    // Keeps a finished iteration for reuse. At most `iterations.size()`
+    // iterations are live at once, so that bounds the number kept.
+    void ReleaseIteration(IterationState* state) EXCLUSIVE_LOCKS_REQUIRED(mu) {
+      if (free_iterations.size() < iterations.size()) {
+        free_iterations.push_back(state);
+      } else {
+        delete state;
+      }
+    }
+
     // Decrement the outstanding op count and clean up the iterations in the
     // frame. Return true iff the execution of the frame is done.
     inline bool DecrementOutstandingOps(const GraphView* gview, int64 iter,
@@ -1169,6 +1506,9 @@ class ExecutorState {
         delete iterations[i];
         iterations[i] = nullptr;
       }
+      for (IterationState* state : free_iterations) {
+        delete state;
+      }
     }
   };
 
@@ -1223,6 +1563,17 @@ class ExecutorState {
     int front_index_;
   };
 
+  // A ready node together with the time it was scheduled, as queued by the
+  // work-stealing dispatch mode.
+  struct ScheduledNode {
+    ScheduledNode() : tagged_node(nullptr, nullptr, -1, false) {}
+    ScheduledNode(const TaggedNode& node, int64 nsec)
+        : tagged_node(node), scheduled_nsec(nsec) {}
+
+    TaggedNode tagged_node;
+    int64 scheduled_nsec = 0;
+  };
+
   struct AsyncState;
 
   const bool vlog_;  // true if VLOG_IS_ON(1). Used to check vlog cheaply.
@@ -1231,6 +1582,8 @@ class ExecutorState {
   const bool log_memory_;
 
   int64 step_id_;
+  // When RunAsync() was called, for the graph run time metric.
+  uint64 start_time_usecs_ = 0;
   // Not owned.
   Rendezvous* rendezvous_;
   CollectiveExecutor* collective_executor_ = nullptr;
@@ -1250,8 +1603,13 @@ class ExecutorState {
   const ExecutorImpl* impl_;
   CancellationManager* cancellation_manager_;
   Executor::Args::Runner runner_;
+  // Non-null iff the executor uses the work-stealing dispatch mode.
+  std::shared_ptr<WorkStealingReadyQueues<ScheduledNode>> ready_queues_;
   bool sync_on_finish_;
   const bool trace_using_annotations_;
+  // Whether to measure the compute time of the synchronous kernels in this
+  // step.
+  const bool measure_node_costs_;
 
   // Owned.
 
@@ -1327,6 +1685,10 @@ class ExecutorState {
   void ScheduleReady(const TaggedNodeSeq& ready,
                      TaggedNodeReadyQueue* inline_ready);
 
+  // Arranges for 'tagged_node' to be processed by another thread, either
+  // through runner_ or, in the work-stealing mode, through ready_queues_.
+  void ScheduleProcess(const TaggedNode& tagged_node, int64 scheduled_nsec);
+
   // For debugging/logging only.
   inline void MaybeMarkCompleted(FrameState* frame, int64 iter, int64 id);
 
@@ -1377,7 +1739,19 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       runner_(args.runner),
       sync_on_finish_(args.sync_on_finish),
       trace_using_annotations_(impl->params_.device->TraceUsingAnnotations()),
+      measure_node_costs_(ShouldMeasureNodeCosts() &&
+                          impl->num_steps_started_.fetch_add(
+                              1, std::memory_order_relaxed) %
+                                  kNodeCostSamplingSteps ==
+                              0),
       num_outstanding_ops_(0) {
+  if (impl->use_work_stealing_) {
+    ready_queues_ = std::make_shared<WorkStealingReadyQueues<ScheduledNode>>(
+        port::NumSchedulableCPUs(), runner_,
+        [this](const ScheduledNode& n) {
+          Process(n.tagged_node, n.scheduled_nsec);
+        });
+  }
   // We start the entire execution in iteration 0 of the root frame
   // so let us create the root frame and the state for iteration 0.
   // We assume root_frame_->frame_name.empty().
@@ -1488,6 +1862,7 @@ void ExecutorImpl::InitializePending(const Graph* graph,
 void ExecutorState::RunAsync(Executor::DoneCallback done) {
   const Graph* graph = impl_->graph_.get();
   TaggedNodeSeq ready;
+  start_time_usecs_ = Env::Default()->NowMicros();
 
   // Ask the device to fill in the device context map.
   Device* device = impl_->params_.device;
@@ -1590,6 +1965,8 @@ bool MightTrace(const NodeItem& item,
 
 void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
   WithContext wc(context_);
+  metrics::UpdateExecutorQueueingTime(
+      std::max<int64>(0, nodestats::NowInNsec() - scheduled_nsec) / 1000);
   const GraphView& gview = impl_->gview_;
   TaggedNodeSeq ready;
   TaggedNodeReadyQueue inline_ready;
@@ -1760,6 +2137,8 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
         // Synchronous computes.
         OpKernelContext ctx(&params, item.num_outputs);
         nodestats::SetOpStart(stats);
+        const int64 compute_start_nsec =
+            measure_node_costs_ ? nodestats::NowInNsec() : 0;
 
         if (TF_PREDICT_FALSE(MightTrace(item, trace_collector_,
                                         event_collector_,
@@ -1789,6 +2168,9 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
           // In the common case, avoid creating any tracing objects.
           device->Compute(op_kernel, &ctx);
         }
+        if (measure_node_costs_) {
+          item.RecordCost(nodestats::NowInNsec() - compute_start_nsec);
+        }
 
         nodestats::SetOpEnd(stats);
         s = ProcessOutputs(item, &ctx, &outputs, stats);
@@ -2198,30 +2580,28 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
                                   TaggedNodeReadyQueue* inline_ready) {
   if (ready.empty()) return;
 
-  int64 scheduled_nsec = 0;
-  if (stats_collector_) {
-    scheduled_nsec = nodestats::NowInNsec();
-  }
+  // Taken even without a stats collector, for the queueing time metric.
+  const int64 scheduled_nsec = nodestats::NowInNsec();
   if (inline_ready == nullptr) {
     // Schedule to run all the ready ops in thread pool.
     for (auto& tagged_node : ready) {
-      runner_([=]() { Process(tagged_node, scheduled_nsec); });
+      ScheduleProcess(tagged_node, scheduled_nsec);
     }
     return;
   }
   const GraphView& gview = impl_->gview_;
+  const int64 threshold_nsec = ExpensiveNodeThresholdMicros() * 1000;
   const TaggedNode* curr_expensive_node = nullptr;
   for (auto& tagged_node : ready) {
     const NodeItem& item = *gview.node(tagged_node.node->id());
-    if (tagged_node.is_dead || !item.kernel_is_expensive) {
+    if (tagged_node.is_dead || !item.IsExpensive(threshold_nsec)) {
       // Inline this inexpensive node.
       inline_ready->push_back(tagged_node);
     } else {
       if (curr_expensive_node) {
         // Dispatch to another thread since there is plenty of work to
         // do for this thread.
-        runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                          scheduled_nsec));
+        ScheduleProcess(*curr_expensive_node, scheduled_nsec);
       }
       curr_expensive_node = &tagged_node;
     }
@@ -2233,12 +2613,23 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
     } else {
       // There are inline nodes to run already. We dispatch this expensive
       // node to other thread.
-      runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                        scheduled_nsec));
+      ScheduleProcess(*curr_expensive_node, scheduled_nsec);
     }
   }
 }
 
+void ExecutorState::ScheduleProcess(const TaggedNode& tagged_node,
+                                    int64 scheduled_nsec) {
+  if (ready_queues_) {
+    // Keeps the node on this thread's deque when called from one of the
+    // step's workers, so it is likely to run where its inputs were produced.
+    ready_queues_->Push(ScheduledNode(tagged_node, scheduled_nsec));
+  } else {
+    runner_(std::bind(&ExecutorState::Process, this, tagged_node,
+                      scheduled_nsec));
+  }
+}
+
 inline void ExecutorState::MaybeMarkCompleted(FrameState* frame, int64 iter,
                                               int64 node_id) {
   // TODO(misard) Replace with a finer-grain enabling flag once we
@@ -2384,6 +2775,7 @@ void ExecutorState::Finish() {
     // the user until the step (and its side-effects) has actually completed.
     status.Update(device->Sync());
   }
+  metrics::UpdateGraphExecTime(Env::Default()->NowMicros() - start_time_usecs_);
 
   delete this;
   CHECK(done_cb != nullptr);
@@ -2682,9 +3074,7 @@ void ExecutorState::FrameState::IncrementIteration(const GraphView* gview,
   const int64 next_iter = iteration_count;
 
   // Initialize the next iteration.
-  IterationState* iter_state =
-      new IterationState(pending_counts, total_input_tensors);
-  SetIteration(next_iter, iter_state);
+  SetIteration(next_iter, NewIteration());
   num_outstanding_iterations++;
   dead_exits.clear();
 
@@ -2700,8 +3090,8 @@ bool ExecutorState::FrameState::CleanupIterations(const GraphView* gview,
                                                   TaggedNodeSeq* ready) {
   int64 curr_iter = iter;
   while (curr_iter <= iteration_count && IsIterationDone(curr_iter)) {
-    // Delete the iteration curr_iter.
-    delete GetIteration(curr_iter);
+    // Release the iteration curr_iter.
+    ReleaseIteration(GetIteration(curr_iter));
     SetIteration(curr_iter, nullptr);
     --num_outstanding_iterations;
     ++curr_iter;
@@ -2721,10 +3111,16 @@ void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
 
 }  // namespace
 
-Status NewLocalExecutor(const LocalExecutorParams& params,
-                        std::unique_ptr<const Graph> graph,
-                        Executor** executor) {
-  ExecutorImpl* impl = new ExecutorImpl(params, std::move(graph));
+namespace {
+
+Status NewExecutorImpl(const LocalExecutorParams& params,
+                       std::unique_ptr<const Graph> graph,
+                       bool use_work_stealing, Executor** executor) {
+  // Installs the sampled profiler before the first step runs, if it is
+  // enabled by the environment.
+  SampledProfiler::Global();
+  ExecutorImpl* impl =
+      new ExecutorImpl(params, std::move(graph), use_work_stealing);
   const Status s = impl->Initialize();
   if (s.ok()) {
     *executor = impl;
@@ -2734,6 +3130,15 @@ Status NewLocalExecutor(const LocalExecutorParams& params,
   return s;
 }
 
+}  // namespace
+
+Status NewLocalExecutor(const LocalExecutorParams& params,
+                        std::unique_ptr<const Graph> graph,
+                        Executor** executor) {
+  return NewExecutorImpl(params, std::move(graph),
+                         /*use_work_stealing=*/false, executor);
+}
+
 Status CreateNonCachedKernel(Device* device, FunctionLibraryRuntime* flib,
                              const NodeDef& ndef, int graph_def_version,
                              OpKernel** kernel) {
@@ -2769,6 +3174,29 @@ class DefaultExecutorRegistrar {
 };
 static DefaultExecutorRegistrar registrar;
 
+// Registers the default executor with work-stealing dispatch of ready nodes
+// under the "WORK_STEALING" executor type.
+class WorkStealingExecutorRegistrar {
+ public:
+  WorkStealingExecutorRegistrar() {
+    ExecutorFactory::Register("WORK_STEALING", new Factory);
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params,
+                       std::unique_ptr<const Graph> graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      Executor* ret = nullptr;
+      TF_RETURN_IF_ERROR(NewExecutorImpl(params, std::move(graph),
+                                         /*use_work_stealing=*/true, &ret));
+      out_executor->reset(ret);
+      return Status::OK();
+    }
+  };
+};
+static WorkStealingExecutorRegistrar work_stealing_registrar;
+
 }  // namespace
 
 }  // namespace tensorflow
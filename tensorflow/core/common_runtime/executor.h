@@ -23,11 +23,13 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 
 namespace tensorflow {
 
+class CostModel;
 class StepStatsCollector;
 
 // Executor runs a graph computation.
@@ -132,6 +134,16 @@ struct LocalExecutorParams {
   // when the executor is deleted.
   std::function<Status(const NodeDef&, OpKernel**)> create_kernel;
   std::function<void(OpKernel*)> delete_kernel;
+
+  // If set, the kernels of large graphs are created in parallel on this pool,
+  // so create_kernel must be thread-safe.
+  thread::ThreadPool* create_kernel_pool = nullptr;
+
+  // If set, the measured per-shape execution times of the nodes of the graph
+  // in this model, e.g. merged from a CostGraphDef saved by an earlier run,
+  // override OpKernel::IsExpensive() when deciding whether to run the nodes
+  // inline.
+  const CostModel* cost_model = nullptr;
 };
 ::tensorflow::Status NewLocalExecutor(const LocalExecutorParams& params,
                                       std::unique_ptr<const Graph> graph,
@@ -14,18 +14,22 @@ limitations under the License.
 ==============================================================================*/
 
 #include <algorithm>
+#include <atomic>
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -56,8 +60,10 @@ class ExecutorTest : public ::testing::Test {
     delete device_;
   }
 
-  // Resets executor_ with a new executor based on a graph 'gdef'.
-  void Create(std::unique_ptr<const Graph> graph) {
+  // Resets executor_ with a new executor of type 'executor_type' based on a
+  // graph 'gdef'.
+  void Create(std::unique_ptr<const Graph> graph,
+              const string& executor_type = "") {
     const int version = graph->versions().producer();
     LocalExecutorParams params;
     params.device = device_;
@@ -69,7 +75,9 @@ class ExecutorTest : public ::testing::Test {
       DeleteNonCachedKernel(kernel);
     };
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, std::move(graph), &exec_));
+    std::unique_ptr<Executor> exec;
+    TF_CHECK_OK(NewExecutor(executor_type, params, std::move(graph), &exec));
+    exec_ = exec.release();
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
     rendez_ = NewLocalRendezvous();
   }
@@ -142,6 +150,28 @@ Rendezvous::ParsedKey Key(const string& sender, const uint64 incarnation,
 #define ALICE "/job:j/replica:0/task:0/cpu:0"
 #define BOB "/job:j/replica:0/task:0/device:GPU:0"
 
+// Adds to 'g' a while loop that counts from 0 to 'num_iterations' and
+// returns its Exit node, whose output is 'num_iterations'.
+Node* CountingLoop(Graph* g, int32 num_iterations) {
+  Node* zero = test::graph::Constant(g, VI(0));
+  Node* enter = test::graph::Enter(g, zero, "loop");
+  Node* limit;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Enter")
+                  .Input(test::graph::Constant(g, VI(num_iterations)))
+                  .Attr("frame_name", "loop")
+                  .Attr("is_constant", true)
+                  .Finalize(g, &limit));
+  const string next_name = g->NewName("next");
+  Node* merge = test::graph::Merge(g, enter, {next_name});
+  Node* cond = test::graph::LoopCond(g, test::graph::Less(g, merge, limit));
+  Node* sw = test::graph::Switch(g, merge, cond);
+  Node* body = test::graph::Identity(g, sw, 1);
+  Node* one = test::graph::Constant(g, VI(1));
+  g->AddControlEdge(body, one);
+  test::graph::Next(g, next_name, test::graph::Add(g, body, one));
+  return test::graph::Exit(g, sw);
+}
+
 TEST_F(ExecutorTest, SimpleAdd) {
   // c = a + b
   std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
@@ -243,6 +273,25 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, WorkStealingRandomTree) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  BuildTree(4096, g.get());
+  Create(std::move(g), "WORK_STEALING");
+  for (int iters = 0; iters < 4; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+    rendez->Unref();
+  }
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -278,6 +327,23 @@ TEST_F(ExecutorTest, ConcurrentAddAssign) {
     rendez->Unref();
   }
 }
+
+TEST_F(ExecutorTest, WorkStealingConcurrentAddAssign) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  BuildConcurrentAddAssign(g.get());
+  Create(std::move(g), "WORK_STEALING");
+  for (int iters = 0; iters < 16; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    TF_ASSERT_OK(Run(rendez));
+    Rendezvous::Args args;
+    Tensor out;
+    bool is_dead;
+    TF_ASSERT_OK(rendez->Recv(Key(ALICE, kIncarnation, BOB, "out"), args, &out,
+                              &is_dead));
+    EXPECT_LE(V(out), 1025.0);
+    rendez->Unref();
+  }
+}
 #endif
 
 TEST_F(ExecutorTest, SimpleSwitchLive) {
@@ -410,6 +476,89 @@ TEST_F(ExecutorTest, RecvInvalidRefDtype) {
   rendez->Unref();
 }
 
+TEST_F(ExecutorTest, WhileLoop) {
+  // Many more iterations than run in parallel, so iteration states are
+  // recycled many times.
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  test::graph::Send(g.get(), CountingLoop(g.get(), 1000), "c", BOB, 1, ALICE);
+  Create(std::move(g));
+  TF_ASSERT_OK(Run(rendez_));
+  Rendezvous::Args args;
+  Tensor out;
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out, &is_dead));
+  EXPECT_FALSE(is_dead);
+  EXPECT_EQ(1000, out.scalar<int32>()());
+}
+
+REGISTER_OP("ExecutorTestDelay").Input("x: float").Output("y: float");
+
+// Forwards its input after sleeping for `delay_micros`.
+class ExecutorTestDelayOp : public OpKernel {
+ public:
+  explicit ExecutorTestDelayOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const int64 micros = delay_micros.load();
+    if (micros > 0) Env::Default()->SleepForMicroseconds(micros);
+    ctx->set_output(0, ctx->input(0));
+  }
+
+  static std::atomic<int64> delay_micros;
+};
+
+std::atomic<int64> ExecutorTestDelayOp::delay_micros(0);
+
+REGISTER_KERNEL_BUILDER(Name("ExecutorTestDelay").Device(DEVICE_CPU),
+                        ExecutorTestDelayOp);
+
+TEST_F(ExecutorTest, MeasuredCostsChooseInlineNodes) {
+  // Two delay nodes become ready together when the constant is computed.
+  // Unless both are cheap, one of them is dispatched through the runner.
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  Node* in = test::graph::Constant(g.get(), V(1.0));
+  for (int i = 0; i < 2; ++i) {
+    Node* delay;
+    TF_ASSERT_OK(NodeBuilder(g->NewName("delay"), "ExecutorTestDelay")
+                     .Input(in)
+                     .Finalize(g.get(), &delay));
+  }
+  Create(std::move(g));
+  std::atomic<int> num_scheduled(0);
+  runner_ = [this, &num_scheduled](std::function<void()> fn) {
+    ++num_scheduled;
+    thread_pool_->Schedule(std::move(fn));
+  };
+  // Runs a step and returns the number of closures it passed to the runner.
+  auto run_step = [this, &num_scheduled]() {
+    num_scheduled = 0;
+    TF_CHECK_OK(Run(rendez_));
+    return num_scheduled.load();
+  };
+
+  // Before their costs are measured, the delay nodes are expensive like every
+  // CPU kernel.
+  ExecutorTestDelayOp::delay_micros = 0;
+  const int num_scheduled_if_expensive = run_step();
+  int steps = 0;
+  int count = num_scheduled_if_expensive;
+  while (count == num_scheduled_if_expensive && steps++ < 1000) {
+    count = run_step();
+  }
+  EXPECT_EQ(count, num_scheduled_if_expensive - 1);
+
+  // Costs are only measured in sampled steps, so it takes a few steps to
+  // notice that the delay nodes became expensive.
+  ExecutorTestDelayOp::delay_micros = 1000;
+  steps = 0;
+  while (count != num_scheduled_if_expensive && steps++ < 100) {
+    count = run_step();
+  }
+  EXPECT_EQ(count, num_scheduled_if_expensive);
+  ExecutorTestDelayOp::delay_micros = 0;
+}
+
 // Create a graph that is 'depth' deep. At each level, fan-in and fan-out a
 // maximum of 'width' nodes. All nodes are no-ops and all dependencies are
 // control dependencies.
@@ -461,6 +610,21 @@ BENCHMARK(BM_executor)->ArgPair(8192, 32);
 // Tall fat graph
 BENCHMARK(BM_executor)->ArgPair(1024, 1024);
 
+// A while loop of 'loop_iters' cheap iterations, to measure the executor's
+// per-iteration overhead.
+static void BM_WhileLoop(int iters, int loop_iters) {
+#ifdef PLATFORM_GOOGLE
+  BenchmarkUseRealTime();
+#endif  // PLATFORM_GOOGLE
+  Graph* g = new Graph(OpRegistry::Global());
+  CountingLoop(g, loop_iters);
+#ifdef PLATFORM_GOOGLE
+  SetBenchmarkItemsProcessed(static_cast<int64>(iters) * loop_iters);
+#endif  // PLATFORM_GOOGLE
+  test::Benchmark("cpu", g).Run(iters);
+}
+BENCHMARK(BM_WhileLoop)->Arg(100)->Arg(10000);
+
 static void BM_FeedInputFetchOutput(int iters) {
   Graph* g = new Graph(OpRegistry::Global());
   // z = x + y: x and y are provided as benchmark inputs.  z is the
@@ -39,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/util/env_var.h"
 
 // See core/kernels/function_ops.cc for related kernels.
 
@@ -630,6 +631,67 @@ void PruneFunctionBody(Graph* g) {
     FixupSourceAndSinkEdges(g);
   }
 }
+
+// The executor that small function bodies are run on when the caller did
+// not ask for a particular one. It is registered by the tf.data kernels.
+constexpr char kSingleThreadedExecutor[] = "SINGLE_THREADED_EXECUTOR";
+
+// Function bodies with at most this many op nodes are run synchronously on
+// the caller thread, where dispatching each kernel through the inter-op
+// thread pool would cost more than the kernels themselves. Setting
+// TF_FUNCTION_SINGLE_THREADED_EXECUTOR_MAX_NODES to 0 turns this off.
+int64 MaxNodesForSingleThreadedExecutor() {
+  static const int64 max_nodes = [] {
+    int64 value;
+    Status s = ReadInt64FromEnvVar(
+        "TF_FUNCTION_SINGLE_THREADED_EXECUTOR_MAX_NODES", 32, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return static_cast<int64>(0);
+    }
+    return value;
+  }();
+  return max_nodes;
+}
+
+bool HasFunctionAttr(const Node& n) {
+  for (const auto& attr : n.attrs()) {
+    if (attr.second.has_func() || attr.second.list().func_size() > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns true if `g`, an optimized function body for `device`, is small
+// enough to benefit from the single-threaded executor and uses nothing that
+// executor lacks. Stateful ops and calls into other functions are left to
+// the default executor, since they may block waiting on other work.
+bool UseSingleThreadedExecutor(const Graph& g, const Device& device,
+                               const FunctionLibraryDefinition& lib_def) {
+  if (device.device_type() != DEVICE_CPU ||
+      g.num_op_nodes() > MaxNodesForSingleThreadedExecutor()) {
+    return false;
+  }
+  for (const Node* n : g.op_nodes()) {
+    if (n->IsControlFlow() || n->IsSend() || n->IsRecv() ||
+        n->IsCollective()) {
+      return false;
+    }
+    if (n->op_def().is_stateful() && n->type_string() != kArgOp &&
+        n->type_string() != kRetOp) {
+      return false;
+    }
+    if (lib_def.Find(n->type_string()) != nullptr || HasFunctionAttr(*n)) {
+      return false;
+    }
+    for (DataType dt : n->output_types()) {
+      if (IsRefType(dt)) return false;
+    }
+  }
+  ExecutorFactory* factory;
+  return ExecutorFactory::GetFactory(kSingleThreadedExecutor, &factory).ok();
+}
 }  // namespace
 
 Status FunctionLibraryRuntimeImpl::CreateItem(Handle handle, Item** item) {
@@ -652,6 +714,10 @@ Status FunctionLibraryRuntimeImpl::CreateItem(Handle handle, Item** item) {
   optimizer_.Optimize(this, env(), device(), &g, /*shape_map=*/nullptr);
   TF_RETURN_IF_ERROR(EnsureMemoryTypes(DeviceType(device()->device_type()),
                                        device()->name(), g.get()));
+  if (executor_type.empty() &&
+      UseSingleThreadedExecutor(*g, *device(), *lib_def)) {
+    executor_type = kSingleThreadedExecutor;
+  }
 
   // Creates an executor based on the g.  This must be done without
   // holding mu_ because create_kernel_ calls back into the library.
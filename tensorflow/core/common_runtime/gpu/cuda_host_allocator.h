@@ -18,11 +18,14 @@ limitations under the License.
 
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/stream_executor.h"
 
 namespace tensorflow {
 // Allocator for pinned CPU RAM that is made known to CUDA for the
-// purpose of efficient DMA with a GPU.
+// purpose of efficient DMA with a GPU. When NUMA is enabled, the memory is
+// pinned from a thread bound to numa_node, so that its pages are placed on
+// that node.
 class CUDAHostAllocator : public SubAllocator {
  public:
   // Note: stream_exec cannot be null.
@@ -39,7 +42,12 @@ class CUDAHostAllocator : public SubAllocator {
   void* Alloc(size_t alignment, size_t num_bytes) override {
     void* ptr = nullptr;
     if (num_bytes > 0) {
+      const int affinity = port::NUMAGetThreadNodeAffinity();
+      const bool rebind = port::NUMAEnabled() && numa_node_ >= 0 &&
+                          affinity != numa_node_;
+      if (rebind) port::NUMASetThreadNodeAffinity(numa_node_);
       ptr = stream_exec_->HostMemoryAllocate(num_bytes);
+      if (rebind) port::NUMASetThreadNodeAffinity(affinity);
       if (ptr == nullptr) {
         LOG(WARNING) << "could not allocate pinned host memory of size: "
                      << num_bytes;
@@ -63,7 +63,9 @@ GPUBFCAllocator::GPUBFCAllocator(GPUMemAllocator* sub_allocator,
                                  size_t total_memory,
                                  const GPUOptions& gpu_options,
                                  const string& name)
-    : BFCAllocator(sub_allocator, total_memory,
-                   GPUBFCAllocator::GetAllowGrowthValue(gpu_options), name) {}
+    : BFCAllocator(
+          sub_allocator, total_memory,
+          GPUBFCAllocator::GetAllowGrowthValue(gpu_options), name,
+          gpu_options.experimental().use_thread_local_allocator_cache()) {}
 
 }  // namespace tensorflow
@@ -312,6 +312,121 @@ TEST(GPUBFCAllocatorTest, DISABLED_AllocatorReceivesZeroMemory) {
   b.DeallocateRaw(bmem);
 }
 
+TEST(GPUBFCAllocatorTest, ThreadLocalCache) {
+  PlatformGpuId platform_gpu_id(0);
+  GPUMemAllocator* sub_allocator = new GPUMemAllocator(
+      GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+      platform_gpu_id, false /*use_unified_memory*/, {}, {});
+  GPUOptions options;
+  options.mutable_experimental()->set_use_thread_local_allocator_cache(true);
+  GPUBFCAllocator a(sub_allocator, 1 << 30, options, "GPU_0_bfc");
+
+  // Allocations served from the cache are still counted, and free cached
+  // chunks are not reported as in use.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 64; i++) {
+    void* raw = a.AllocateRaw(1, 1024);
+    ASSERT_NE(raw, nullptr);
+    ptrs.push_back(raw);
+  }
+  std::sort(ptrs.begin(), ptrs.end());
+  for (size_t i = 1; i < ptrs.size(); i++) {
+    ASSERT_NE(ptrs[i], ptrs[i - 1]);  // No dups
+    ASSERT_GE(static_cast<char*>(ptrs[i]) - static_cast<char*>(ptrs[i - 1]),
+              1024);
+  }
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(64, stats.num_allocs);
+  EXPECT_EQ(64 * 1024, stats.bytes_in_use);
+
+  // Free half of the chunks on this thread and half on another thread,
+  // which returns them to the bins directly.
+  for (size_t i = 0; i < ptrs.size() / 2; i++) {
+    a.DeallocateRaw(ptrs[i]);
+  }
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 1);
+    pool.Schedule([&a, &ptrs]() {
+      for (size_t i = ptrs.size() / 2; i < ptrs.size(); i++) {
+        a.DeallocateRaw(ptrs[i]);
+      }
+    });
+  }
+  a.GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+
+  // Reallocating reuses the cached chunks.
+  void* raw = a.AllocateRaw(1, 1024);
+  ASSERT_NE(raw, nullptr);
+  a.GetStats(&stats);
+  EXPECT_EQ(65, stats.num_allocs);
+  EXPECT_EQ(1024, stats.bytes_in_use);
+  a.DeallocateRaw(raw);
+}
+
+TEST(GPUBFCAllocatorTest, MemoryTimelineAndFragmentation) {
+  PlatformGpuId platform_gpu_id(0);
+  GPUMemAllocator* sub_allocator = new GPUMemAllocator(
+      GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+      platform_gpu_id, false /*use_unified_memory*/, {}, {});
+  setenv("TF_BFC_MEMORY_TIMELINE_SIZE", "3", 1);
+  GPUBFCAllocator a(sub_allocator, 1 << 30, "GPU_0_bfc");
+  unsetenv("TF_BFC_MEMORY_TIMELINE_SIZE");
+
+  const int64 kChunkBytes = 1 << 20;
+  std::vector<void*> ptrs;
+  for (const string op_name : {"a", "b", "c"}) {
+    AllocationAttributes attr;
+    attr.op_name = op_name;
+    void* raw = a.AllocateRaw(1, kChunkBytes, attr);
+    ASSERT_NE(raw, nullptr);
+    ptrs.push_back(raw);
+  }
+  // Freeing the chunk in the middle leaves a hole before the rest of the
+  // region.
+  a.DeallocateRaw(ptrs[1]);
+
+  const int64 largest_free_bytes = (1 << 30) - 3 * kChunkBytes;
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(largest_free_bytes, stats.largest_free_block_bytes);
+
+  // Only the last 3 points are kept.
+  std::vector<BFCAllocator::MemoryTimelineRecord> timeline =
+      a.GetMemoryTimeline();
+  ASSERT_EQ(3, timeline.size());
+  EXPECT_EQ("b", timeline[0].op_name);
+  EXPECT_EQ(kChunkBytes, timeline[0].alloc_bytes);
+  EXPECT_EQ(2 * kChunkBytes, timeline[0].bytes_in_use);
+  EXPECT_EQ("c", timeline[1].op_name);
+  EXPECT_EQ(largest_free_bytes, timeline[1].largest_free_block_bytes);
+  EXPECT_EQ("", timeline[2].op_name);
+  EXPECT_EQ(-kChunkBytes, timeline[2].alloc_bytes);
+  EXPECT_EQ(2 * kChunkBytes, timeline[2].bytes_in_use);
+  EXPECT_LE(timeline[0].micros, timeline[2].micros);
+
+  BFCAllocator::FragmentationStats fragmentation = a.GetFragmentationStats();
+  EXPECT_EQ(largest_free_bytes + kChunkBytes, fragmentation.free_bytes);
+  EXPECT_EQ(largest_free_bytes, fragmentation.largest_free_chunk_bytes);
+  EXPECT_NEAR(1.0 - static_cast<double>(largest_free_bytes) /
+                        fragmentation.free_bytes,
+              fragmentation.fragmentation, 1e-9);
+  for (const auto& bin : fragmentation.bins) {
+    if (bin.bin_size == kChunkBytes) {
+      EXPECT_EQ(1, bin.free_chunks);
+      EXPECT_EQ(kChunkBytes, bin.free_bytes);
+      EXPECT_EQ(kChunkBytes, bin.largest_free_chunk_bytes);
+    }
+  }
+
+  a.DeallocateRaw(ptrs[0]);
+  a.DeallocateRaw(ptrs[2]);
+  fragmentation = a.GetFragmentationStats();
+  EXPECT_EQ(1 << 30, fragmentation.free_bytes);
+  EXPECT_EQ(0, fragmentation.fragmentation);
+}
+
 static void BM_Allocation(int iters) {
   PlatformGpuId platform_gpu_id(0);
   GPUMemAllocator* sub_allocator = new GPUMemAllocator(
@@ -370,6 +485,61 @@ static void BM_AllocationThreaded(int iters, int num_threads) {
 }
 BENCHMARK(BM_AllocationThreaded)->Arg(1)->Arg(4)->Arg(16);
 
+// Measures lock contention on small allocations, with (use_cache = 1) and
+// without (use_cache = 0) the thread-local chunk cache.
+static void BM_SmallAllocationThreaded(int iters, int num_threads,
+                                       int use_cache) {
+  PlatformGpuId platform_gpu_id(0);
+  GPUMemAllocator* sub_allocator = new GPUMemAllocator(
+      GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+      platform_gpu_id, false /*use_unified_memory*/, {}, {});
+  GPUOptions options;
+  options.mutable_experimental()->set_use_thread_local_allocator_cache(
+      use_cache != 0);
+  GPUBFCAllocator a(sub_allocator, 1uLL << 33, options, "GPU_0_bfc");
+  thread::ThreadPool pool(Env::Default(), "test", num_threads);
+  std::atomic_int_fast32_t count(iters);
+  mutex done_lock;
+  condition_variable done;
+  bool done_flag = false;
+
+  for (int t = 0; t < num_threads; t++) {
+    pool.Schedule([&a, &count, &done_lock, &done, &done_flag, iters]() {
+      // Sizes typical of shape tensors and small temporaries; keep a few
+      // allocations live so chunks are not immediately coalesced.
+      std::vector<int> sizes = {256, 512, 1024, 4096, 768, 2048};
+      gtl::InlinedVector<void*, 4> live;
+      int size_index = 0;
+      for (int i = 0; i < iters; i++) {
+        int bytes = sizes[size_index++ % sizes.size()];
+        live.push_back(a.AllocateRaw(1, bytes));
+        if (live.size() == 4) {
+          for (void* p : live) a.DeallocateRaw(p);
+          live.clear();
+        }
+        if (count.fetch_sub(1) == 1) {
+          mutex_lock l(done_lock);
+          done_flag = true;
+          done.notify_all();
+          break;
+        }
+      }
+      for (void* p : live) a.DeallocateRaw(p);
+    });
+  }
+  mutex_lock l(done_lock);
+  if (!done_flag) {
+    done.wait(l);
+  }
+}
+BENCHMARK(BM_SmallAllocationThreaded)
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(4, 0)
+    ->ArgPair(4, 1)
+    ->ArgPair(16, 0)
+    ->ArgPair(16, 1);
+
 // A more complex benchmark that defers deallocation of an object for
 // "delay" allocations.
 static void BM_AllocationDelayed(int iters, int delay) {
@@ -51,6 +51,7 @@ limitations under the License.
 #include "tensorflow/core/graph/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
@@ -458,6 +459,49 @@ string BaseGPUDevice::ComputeOpKernelDebugString(const OpKernel& op_kernel,
                          "]");
 }
 
+Status BaseGPUDevice::WaitForInputStreams(OpKernelContext* context,
+                                          se::Stream* stream, int stream_id,
+                                          bool vlog_inputs) {
+  if (streams_.size() <= 1) return Status::OK();
+  // If this op's device context is different from the other contexts,
+  // we must wait on the stream. Each producer stream is waited on once,
+  // however many of the inputs it produced.
+  gtl::InlinedVector<se::Stream*, 4> waited_streams;
+  for (int i = 0; i < context->num_inputs(); ++i) {
+    const GPUDeviceContext* idc =
+        static_cast<GPUDeviceContext*>(context->input_device_context(i));
+    if (idc == nullptr) {
+      return errors::Internal("Input device context ", i,
+                              " was not set properly.");
+    }
+    if (vlog_inputs && context->has_input(i)) {
+      const void* base;
+      size_t len;
+      if (IsRefType(context->input_dtype(i))) {
+        Tensor tensor = context->mutable_input(i, false);
+        base = DMAHelper::base(&tensor);
+        len = tensor.TotalBytes();
+      } else {
+        const Tensor& tensor = context->input(i);
+        base = DMAHelper::base(&tensor);
+        len = tensor.TotalBytes();
+      }
+      LOG(INFO) << "Input " << i << " " << base << "  " << len;
+      LOG(INFO) << "  stream[" << stream_id << "].ThenWaitFor(stream["
+                << idc->stream_id() << "])"
+                << ((idc->stream() == stream) ? " not needed" : "");
+    }
+    se::Stream* input_stream = idc->stream();
+    if (input_stream != stream &&
+        std::find(waited_streams.begin(), waited_streams.end(),
+                  input_stream) == waited_streams.end()) {
+      stream->ThenWaitFor(input_stream);
+      waited_streams.push_back(input_stream);
+    }
+  }
+  return Status::OK();
+}
+
 void BaseGPUDevice::ComputeHelper(OpKernel* op_kernel,
                                   OpKernelContext* context) {
   GPUDeviceContext* gpu_device_context = device_contexts_[0];
@@ -476,38 +520,8 @@ void BaseGPUDevice::ComputeHelper(OpKernel* op_kernel,
             << ComputeOpKernelDebugString(*op_kernel, stream_id);
   }
 
-  const auto num_streams = streams_.size();
-  if (num_streams > 1) {
-    // If this op's device context is different from the other contexts,
-    // we must wait on the stream.
-    for (int i = 0; i < context->num_inputs(); ++i) {
-      const GPUDeviceContext* idc =
-          static_cast<GPUDeviceContext*>(context->input_device_context(i));
-      OP_REQUIRES(context, idc != nullptr,
-                  errors::Internal("Input device context ", i,
-                                   " was not set properly."));
-      if (vlog_2) {
-        const void* base;
-        size_t len;
-        if (context->has_input(i)) {
-          if (IsRefType(context->input_dtype(i))) {
-            Tensor tensor = context->mutable_input(i, false);
-            base = DMAHelper::base(&tensor);
-            len = tensor.TotalBytes();
-          } else {
-            const Tensor& tensor = context->input(i);
-            base = DMAHelper::base(&tensor);
-            len = tensor.TotalBytes();
-          }
-          LOG(INFO) << "Input " << i << " " << base << "  " << len;
-          LOG(INFO) << "  stream[" << stream_id << "].ThenWaitFor(stream["
-                    << idc->stream_id() << "])"
-                    << ((idc->stream() == stream) ? " not needed" : "");
-        }
-      }
-      if (idc->stream() != stream) stream->ThenWaitFor(idc->stream());
-    }
-  }
+  OP_REQUIRES_OK(context,
+                 WaitForInputStreams(context, stream, stream_id, vlog_2));
   se::cuda::ScopedActivateExecutorContext scoped_activation{stream->parent()};
   op_kernel->Compute(context);
   if (context->status().ok()) {
@@ -562,6 +576,11 @@ void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
           << op_kernel->type_string() << " on GPU" << tf_gpu_id_ << " stream["
           << stream_id << "]";
 
+  OP_REQUIRES_OK_ASYNC(context,
+                       WaitForInputStreams(context, stream, stream_id,
+                                           VLOG_IS_ON(2)),
+                       done);
+
   // When Xprof profiling is off (which is the default), constructing the
   // activity is simple enough that its overhead is negligible.
   tracing::ScopedActivity activity(op_kernel->name(), op_kernel->type_string(),
@@ -148,6 +148,11 @@ class BaseGPUDevice : public LocalDevice {
   void ReinitializeDevice(OpKernelContext* context, PerOpGpuDevice* device,
                           int stream_id, Allocator* allocator);
 
+  // Makes `stream` wait for the streams that produced the inputs of
+  // `context` when the device has more than one compute stream.
+  Status WaitForInputStreams(OpKernelContext* context, se::Stream* stream,
+                             int stream_id, bool vlog_inputs);
+
   void ComputeHelper(OpKernel* op_kernel, OpKernelContext* context);
 
   string ComputeOpKernelDebugString(const OpKernel& op_kernel,
@@ -24,6 +24,24 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// Returns the number of compute streams requested by
+// GPUOptions.experimental.num_compute_streams.
+int32 NumComputeStreams(const SessionOptions& options) {
+  int32 num_streams =
+      options.config.gpu_options().experimental().num_compute_streams();
+  if (num_streams == 0) num_streams = 1;
+  if (num_streams < 1 || num_streams > 8) {
+    LOG(ERROR) << "Illegal GPUOptions.experimental.num_compute_streams="
+               << num_streams << " set to 1 instead.";
+    num_streams = 1;
+  }
+  return num_streams;
+}
+
+}  // namespace
+
 class GPUDevice : public BaseGPUDevice {
  public:
   GPUDevice(const SessionOptions& options, const string& name,
@@ -32,7 +50,9 @@ class GPUDevice : public BaseGPUDevice {
             Allocator* gpu_allocator, Allocator* cpu_allocator)
       : BaseGPUDevice(options, name, memory_limit, locality, tf_gpu_id,
                       physical_device_desc, gpu_allocator, cpu_allocator,
-                      false /* sync every op */, 1 /* max_streams */) {
+                      false /* sync every op */,
+                      NumComputeStreams(options)),
+        numa_node_(locality.numa_node()) {
     if (options.config.has_gpu_options()) {
       force_gpu_compatible_ =
           options.config.gpu_options().force_gpu_compatible();
@@ -44,7 +64,7 @@ class GPUDevice : public BaseGPUDevice {
     if (attr.on_host()) {
       if (attr.gpu_compatible() || force_gpu_compatible_) {
         GPUProcessState* ps = GPUProcessState::singleton();
-        return ps->GetCUDAHostAllocator(0);
+        return ps->GetCUDAHostAllocator(numa_node_);
       } else {
         return cpu_allocator_;
       }
@@ -55,6 +75,8 @@ class GPUDevice : public BaseGPUDevice {
 
  private:
   bool force_gpu_compatible_ = false;
+  // Pinned host memory comes from the NUMA node of the GPU.
+  const int numa_node_;
 };
 
 class GPUDeviceFactory : public BaseGPUDeviceFactory {
@@ -20,6 +20,10 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_id_utils.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
+#include "tensorflow/core/common_runtime/gpu_device_context.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -224,6 +228,39 @@ TEST_F(GPUDeviceTest, MultipleVirtualDevices) {
 
 // Enabling unified memory on pre-Pascal GPUs results in an initialization
 // error.
+TEST_F(GPUDeviceTest, MultipleComputeStreams) {
+  SessionOptions opts = MakeSessionOptions("0");
+  opts.config.mutable_gpu_options()
+      ->mutable_experimental()
+      ->set_num_compute_streams(2);
+  std::vector<tensorflow::Device*> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices));
+  ASSERT_EQ(1, devices.size());
+
+  // Two independent constants feeding an add.
+  Graph graph(OpRegistry::Global());
+  Node* a = test::graph::Constant(&graph, test::AsScalar<float>(1.0f));
+  Node* b = test::graph::Constant(&graph, test::AsScalar<float>(2.0f));
+  test::graph::Add(&graph, a, b);
+  FixupSourceAndSinkEdges(&graph);
+
+  DeviceContextMap context_map;
+  TF_ASSERT_OK(devices[0]->FillContextMap(&graph, &context_map));
+  ASSERT_EQ(graph.num_node_ids(), context_map.size());
+  const auto* a_context =
+      static_cast<const GPUDeviceContext*>(context_map[a->id()]);
+  const auto* b_context =
+      static_cast<const GPUDeviceContext*>(context_map[b->id()]);
+  EXPECT_NE(a_context->stream_id(), b_context->stream_id());
+  EXPECT_NE(a_context->stream(), b_context->stream());
+
+  for (DeviceContext* context : context_map) {
+    if (context != nullptr) context->Unref();
+  }
+  gtl::STLDeleteElements(&devices);
+}
+
 TEST_F(GPUDeviceTest, UnifiedMemoryUnavailableOnPrePascalGpus) {
   int cc_major, cc_minor;
   TF_ASSERT_OK(GetComputeCapability(PlatformGpuId(0), &cc_major, &cc_minor));
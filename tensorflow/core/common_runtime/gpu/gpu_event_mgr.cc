@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 
+#include <algorithm>
+
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/stacktrace.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -27,6 +31,21 @@ namespace {
 //  - Is this the right number of threads?
 //  - Should EventMgrs be shared between GPUDevices on a multi-GPU machine?
 static const int kNumThreads = 2;
+
+// The polling delay backs off up to this many microseconds while events stay
+// pending, unless GPUOptions.polling_active_delay_usecs is larger. Since the
+// delay only doubles, the latency this adds to retiring an event is at most
+// the time the event has already been pending.
+static const int32 kMaxPollingDelayUsecs = 1000;
+
+auto* event_latency_sampler = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/gpu_event_mgr/event_latency_us",
+     "Time from queueing an EventMgr event behind the pending work of a "
+     "stream until the event was retired and its tensors, buffers and "
+     "callbacks released, by GPU.",
+     "device_ordinal"},
+    // Power of 2 buckets from 1us to ~1000s.
+    monitoring::Buckets::Exponential(1, 2, 30));
 }  // namespace
 
 namespace gpu_event_mgr {
@@ -97,6 +116,10 @@ EventMgr::EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options)
       polling_active_delay_usecs_(gpu_options.polling_active_delay_usecs()
                                       ? gpu_options.polling_active_delay_usecs()
                                       : 10),
+      polling_max_delay_usecs_(
+          std::max(polling_active_delay_usecs_, kMaxPollingDelayUsecs)),
+      event_latency_cell_(event_latency_sampler->GetCell(
+          strings::StrCat(se->device_ordinal()))),
       accumulated_stream_(nullptr),
       accumulated_tensors_(new TensorReferenceVector),
       accumulated_tensor_bytes_(0),
@@ -189,12 +212,52 @@ void EventMgr::FlushAccumulatedTensors() {
   accumulated_stream_ = nullptr;
 }
 
+void EventMgr::FreeMemory(const ToFreeVector& to_free) {
+  if (to_free.empty()) return;
+  const int64 now_micros = Env::Default()->NowMicros();
+  std::vector<std::function<void()>> funcs;
+  for (const auto& iu : to_free) {
+    event_latency_cell_->Add(now_micros - iu.queued_micros);
+    if (iu.mem != nullptr) {
+      for (auto& t : *(iu.mem)) {
+        t.Unref();
+      }
+      delete iu.mem;
+    }
+    if (iu.bufrec.buf) {
+      if (LogMemory::IsEnabled()) {
+        LogMemory::RecordRawDeallocation(iu.bufrec.operation,
+                                         iu.bufrec.step_id, iu.bufrec.buf,
+                                         iu.bufrec.alloc, false);
+      }
+      iu.bufrec.alloc->DeallocateRaw(iu.bufrec.buf);
+    }
+    if (iu.func != nullptr) funcs.push_back(iu.func);
+  }
+  // The functions must be called in another thread. The other thread of the
+  // pool runs the polling loop, so they run one after the other anyway, and
+  // scheduling them as a single closure wakes the pool only once.
+  if (funcs.size() == 1) {
+    threadpool_.Schedule(std::move(funcs[0]));
+  } else if (funcs.size() > 1) {
+    threadpool_.Schedule(std::bind(
+        [](const std::vector<std::function<void()>>& funcs) {
+          for (const auto& func : funcs) func();
+        },
+        std::move(funcs)));
+  }
+}
+
 // A polling loop to detect completion of GPU events.
 //
 // While one or more events is outstanding, poll for completed events.  When no
-// events are outstanding, we sleep until one is enqueued.
+// events are outstanding, we sleep until one is enqueued. The delay between
+// polls starts at polling_active_delay_usecs_ and doubles, up to
+// polling_max_delay_usecs_, after every poll that retires nothing, so that
+// long running kernels do not keep this thread spinning.
 void EventMgr::PollLoop() {
   ToFreeVector to_free;
+  int32 delay_usecs = polling_active_delay_usecs_;
   while (true) {
     bool events_still_pending;
     {
@@ -208,11 +271,16 @@ void EventMgr::PollLoop() {
       PollEvents(true, &to_free);
       events_still_pending = !used_events_.empty();
     }
+    if (!to_free.empty() || !events_still_pending) {
+      delay_usecs = polling_active_delay_usecs_;
+    } else {
+      delay_usecs = std::min(2 * delay_usecs, polling_max_delay_usecs_);
+    }
     FreeMemory(to_free);
     to_free.clear();
 
     if (events_still_pending) {
-      Env::Default()->SleepForMicroseconds(polling_active_delay_usecs_);
+      Env::Default()->SleepForMicroseconds(delay_usecs);
     }
   }
   polling_stopped_->Notify();
@@ -231,6 +299,7 @@ void EventMgr::QueueInUse(se::Stream* stream, InUse iu) {
   free_events_.pop_back();
   stream->ThenRecordEvent(e);
   iu.event = e;
+  iu.queued_micros = Env::Default()->NowMicros();
   bool was_empty = used_events_.empty();
   used_events_.push_back(iu);
   // Maybe wake up the polling thread
@@ -39,6 +39,10 @@ namespace tensorflow {
 
 class GPUOptions;
 
+namespace monitoring {
+class SamplerCell;
+}  // namespace monitoring
+
 // The callback provided to EventMgr::ThenExecute must not block or take a long
 // time.  If it does, performance may be impacted and GPU memory may be
 // exhausted.  This macro is for checking that an EventMgr thread is not
@@ -96,6 +100,8 @@ class EventMgr {
   // Execute func when all pending stream actions have completed.
   // func must be brief and non-blocking since it executes in the one
   // thread used for all such callbacks and also buffer deletions.
+  // Callbacks whose events are retired by the same poll run in order, in
+  // a single closure scheduled on that thread.
   inline void ThenExecute(se::Stream* stream, std::function<void()> func) {
     ToFreeVector to_free;
     {
@@ -111,6 +117,11 @@ class EventMgr {
   se::StreamExecutor* const exec_;
   const int64 deferred_bytes_threshold_;
   const int32 polling_active_delay_usecs_;
+  // Upper bound of the polling delay, which doubles after every poll of
+  // the dedicated polling thread that retires no event.
+  const int32 polling_max_delay_usecs_;
+  // Time from queueing an event until it is retired, for this GPU.
+  monitoring::SamplerCell* const event_latency_cell_;
   mutex mu_;
   condition_variable events_pending_ GUARDED_BY(mu_);
 
@@ -121,30 +132,15 @@ class EventMgr {
     TensorReferenceVector* mem;
     BufRec bufrec;
     std::function<void()> func;
+    // When the event was queued, from Env::NowMicros().
+    int64 queued_micros;
   };
 
   typedef gtl::InlinedVector<InUse, 4> ToFreeVector;
 
-  void FreeMemory(const ToFreeVector& to_free) {
-    for (const auto& iu : to_free) {
-      if (iu.mem != nullptr) {
-        for (auto& t : *(iu.mem)) {
-          t.Unref();
-        }
-        delete iu.mem;
-      }
-      if (iu.bufrec.buf) {
-        if (LogMemory::IsEnabled()) {
-          LogMemory::RecordRawDeallocation(iu.bufrec.operation,
-                                           iu.bufrec.step_id, iu.bufrec.buf,
-                                           iu.bufrec.alloc, false);
-        }
-        iu.bufrec.alloc->DeallocateRaw(iu.bufrec.buf);
-      }
-      // The function must be called in another thread.
-      if (iu.func != nullptr) threadpool_.Schedule(iu.func);
-    }
-  }
+  // Releases the tensors and buffers of `to_free` and schedules their
+  // callbacks.
+  void FreeMemory(const ToFreeVector& to_free);
 
   // Stream-enqueue an unused Event and save with it a collection of
   // Tensors and/or a BufRec to be deleted only after the Event
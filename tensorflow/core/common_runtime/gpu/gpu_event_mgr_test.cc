@@ -18,6 +18,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 
 #include <atomic>
+#include <vector>
+
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/platform/stream_executor.h"
@@ -51,6 +53,11 @@ class TEST_EventMgrHelper {
     em_->QueueTensors(stream, tensors);
   }
 
+  void QueueFunc(se::Stream* stream, std::function<void()> func) {
+    mutex_lock l(em_->mu_);
+    em_->QueueFunc(stream, std::move(func));
+  }
+
   void PollEvents(bool is_dedicated_poller) {
     while (queue_size() > 0) {
       // For ordinary tensor frees, this function
@@ -266,6 +273,32 @@ TEST(EventMgr, WarnIfInCallback) {
   EXPECT_TRUE(hit);
 }
 
+// Callbacks retired by the same poll run in the order they were queued.
+TEST(EventMgr, BatchedCallbacksRunInOrder) {
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  EventMgr em(stream_exec, GPUOptions());
+  TEST_EventMgrHelper th(&em);
+  std::unique_ptr<se::Stream> stream(new se::Stream(stream_exec));
+  CHECK(stream);
+  stream->Init();
+  std::vector<int> order;
+  Notification note;
+  const int kNumCallbacks = 10;
+  for (int i = 0; i < kNumCallbacks; ++i) {
+    th.QueueFunc(stream.get(), [i, &order, &note]() {
+      order.push_back(i);
+      if (i == kNumCallbacks - 1) note.Notify();
+    });
+  }
+  stream->BlockHostUntilDone().IgnoreError();
+  th.PollEvents(false);
+  note.WaitForNotification();
+  ASSERT_EQ(kNumCallbacks, order.size());
+  for (int i = 0; i < kNumCallbacks; ++i) {
+    EXPECT_EQ(i, order[i]);
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
 
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
 
+#include <algorithm>
 #include <cstring>
 #include <vector>
 
@@ -174,13 +175,13 @@ Allocator* GPUProcessState::GetCUDAHostAllocator(int numa_node) {
     // we take a unique lock and populate these vectors.
     tf_shared_lock lock(mu_);
 
-    if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types &&
-        !cuda_host_allocators_.empty() &&
-        cuda_host_allocators_[0].recording_allocator != nullptr) {
-      return cuda_host_allocators_[0].recording_allocator.get();
-    }
     if (static_cast<int>(cuda_host_allocators_.size()) > numa_node) {
-      return cuda_host_allocators_[0].allocator.get();
+      const AllocatorParts& allocator_parts = cuda_host_allocators_[numa_node];
+      if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types &&
+          allocator_parts.recording_allocator != nullptr) {
+        return allocator_parts.recording_allocator.get();
+      }
+      return allocator_parts.allocator.get();
     }
   }
 
@@ -202,16 +203,28 @@ Allocator* GPUProcessState::GetCUDAHostAllocator(int numa_node) {
 
   CHECK_NE(nullptr, se);
 
+  // Pinned memory to set aside when the allocator of a NUMA node is
+  // created, so that the first copies do not each pay for a cudaHostAlloc
+  // while the allocator grows. The BFC allocator keeps the region, and
+  // rounds it up to a power of two MiB.
+  int64 cuda_host_mem_reserve_in_mb = 0;
+  Status reserve_status = ReadInt64FromEnvVar(
+      "TF_CUDA_HOST_MEM_RESERVE_IN_MB", 0, &cuda_host_mem_reserve_in_mb);
+  if (!reserve_status.ok()) {
+    LOG(ERROR) << "GetCUDAHostAllocator: " << reserve_status.error_message();
+  }
+
   while (static_cast<int>(cuda_host_allocators_.size()) <= numa_node) {
-    while (cuda_host_alloc_visitors_.size() <= numa_node) {
+    const int node = cuda_host_allocators_.size();
+    while (cuda_host_alloc_visitors_.size() <= node) {
       cuda_host_alloc_visitors_.push_back({});
     }
-    while (cuda_host_free_visitors_.size() <= numa_node) {
+    while (cuda_host_free_visitors_.size() <= node) {
       cuda_host_free_visitors_.push_back({});
     }
-    SubAllocator* sub_allocator = new CUDAHostAllocator(
-        se, numa_node, cuda_host_alloc_visitors_[numa_node],
-        cuda_host_free_visitors_[numa_node]);
+    SubAllocator* sub_allocator =
+        new CUDAHostAllocator(se, node, cuda_host_alloc_visitors_[node],
+                              cuda_host_free_visitors_[node]);
     // TODO(zheng-xq): evaluate whether 64GB by default is the best choice.
     int64 cuda_host_mem_limit_in_mb = -1;
     Status status = ReadInt64FromEnvVar("TF_CUDA_HOST_MEM_LIMIT_IN_MB",
@@ -224,6 +237,19 @@ Allocator* GPUProcessState::GetCUDAHostAllocator(int numa_node) {
     Allocator* allocator =
         new BFCAllocator(sub_allocator, cuda_host_mem_limit,
                          true /*allow_growth*/, "cuda_host_bfc" /*name*/);
+    if (cuda_host_mem_reserve_in_mb > 0) {
+      const size_t reserve_bytes =
+          std::min(cuda_host_mem_reserve_in_mb, cuda_host_mem_limit_in_mb) *
+          (1LL << 20);
+      void* reserved =
+          allocator->AllocateRaw(Allocator::kAllocatorAlignment, reserve_bytes);
+      if (reserved == nullptr) {
+        LOG(WARNING) << "Could not reserve " << cuda_host_mem_reserve_in_mb
+                     << "MiB of pinned host memory on NUMA node " << node;
+      } else {
+        allocator->DeallocateRaw(reserved);
+      }
+    }
 
     if (LogMemory::IsEnabled() && !allocator->TracksAllocationSizes()) {
       // Wrap the allocator to track allocation ids for better logging
@@ -247,9 +273,9 @@ Allocator* GPUProcessState::GetCUDAHostAllocator(int numa_node) {
     }
   }
   if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types) {
-    return cuda_host_allocators_[0].recording_allocator.get();
+    return cuda_host_allocators_[numa_node].recording_allocator.get();
   } else {
-    return cuda_host_allocators_[0].allocator.get();
+    return cuda_host_allocators_[numa_node].allocator.get();
   }
 }
 
@@ -15,9 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/graph_execution_state.h"
 
+#include <list>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -47,10 +49,141 @@ limitations under the License.
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/env_var.h"
 #endif  // IS_MOBILE_PLATFORM
 
 namespace tensorflow {
 
+#ifndef IS_MOBILE_PLATFORM
+namespace {
+
+auto* optimized_graph_cache_lookups = monitoring::Counter<1>::New(
+    "/tensorflow/core/grappler_optimized_graph_cache_lookups",
+    "The number of lookups in the cache of graphs optimized by grappler, by "
+    "result.",
+    "result");
+
+// Process-wide cache of the graphs optimized by grappler. Every new feed and
+// fetch signature, and every graph extended by DirectSession::Extend, runs
+// the meta optimizer again. The entries are keyed by the part of the graph
+// that the fetches depend on, so that the signatures whose subgraph wasn't
+// changed reuse their optimized graph. The number of entries is set by the
+// TF_GRAPPLER_OPTIMIZED_GRAPH_CACHE_SIZE environment variable, and 0 disables
+// the cache.
+class OptimizedGraphCache {
+ public:
+  static OptimizedGraphCache* Global() {
+    static OptimizedGraphCache* cache = new OptimizedGraphCache();
+    return cache;
+  }
+
+  bool enabled() const { return capacity_ > 0; }
+
+  // Copies the graph cached under `key` into `graph`, and returns false if
+  // there is none.
+  bool Lookup(const Fprint128& key, GraphDef* graph) {
+    mutex_lock l(mu_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return false;
+    }
+    // Keep the least recently used entries at the back.
+    entries_.splice(entries_.begin(), entries_, it->second);
+    *graph = it->second->second;
+    return true;
+  }
+
+  void Insert(const Fprint128& key, const GraphDef& graph) {
+    mutex_lock l(mu_);
+    if (!enabled() || index_.count(key) > 0) {
+      return;
+    }
+    entries_.emplace_front(key, graph);
+    index_[key] = entries_.begin();
+    while (entries_.size() > capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+  }
+
+ private:
+  typedef std::list<std::pair<Fprint128, GraphDef>> EntryList;
+
+  OptimizedGraphCache() {
+    Status s = ReadInt64FromEnvVar("TF_GRAPPLER_OPTIMIZED_GRAPH_CACHE_SIZE",
+                                   8, &capacity_);
+    if (!s.ok()) {
+      LOG(WARNING) << s;
+      capacity_ = 0;
+    }
+  }
+
+  int64 capacity_;
+  mutex mu_;
+  EntryList entries_ GUARDED_BY(mu_);
+  std::unordered_map<Fprint128, EntryList::iterator, Fprint128Hasher> index_
+      GUARDED_BY(mu_);
+};
+
+// Returns a fingerprint of everything the optimization of `item` for
+// `callable_options` depends on: the nodes the fetches depend on, the function
+// library, the graph version, the names of the feeds, fetches and targets, the
+// rewriter config and the devices.
+Fprint128 OptimizationFingerprint(const grappler::GrapplerItem& item,
+                                  const CallableOptions& callable_options,
+                                  const RewriterConfig& rewrite_options,
+                                  const DeviceSet& device_set) {
+  GraphDef pruned;
+  *pruned.mutable_versions() = item.graph.versions();
+  *pruned.mutable_library() = item.graph.library();
+  for (const NodeDef* node : item.MainOpsFanin()) {
+    *pruned.add_node() = *node;
+  }
+  string key;
+  SerializeToStringDeterministic(pruned, &key);
+  string config;
+  SerializeToStringDeterministic(rewrite_options, &config);
+  strings::StrAppend(&key, ";", config);
+  const VersionDef& versions = item.graph.versions();
+  strings::StrAppend(&key, ";version=", versions.producer(), ":",
+                     versions.min_consumer());
+  for (int bad_consumer : versions.bad_consumers()) {
+    strings::StrAppend(&key, ",", bad_consumer);
+  }
+  for (const string& feed : callable_options.feed()) {
+    strings::StrAppend(&key, ";feed_name=", feed);
+  }
+  for (const string& fetch : callable_options.fetch()) {
+    strings::StrAppend(&key, ";fetch=", fetch);
+  }
+  for (const string& target : callable_options.target()) {
+    strings::StrAppend(&key, ";target=", target);
+  }
+  for (const TensorConnection& connection :
+       callable_options.tensor_connection()) {
+    strings::StrAppend(&key, ";connection=", connection.from_tensor(), ">",
+                       connection.to_tensor());
+  }
+  for (const auto& feed : item.feed) {
+    strings::StrAppend(&key, ";feed=", feed.first, ":",
+                       DataTypeString(feed.second.dtype()),
+                       feed.second.shape().DebugString());
+  }
+  for (const Device* device : device_set.devices()) {
+    strings::StrAppend(&key, ";device=", device->name(), ":",
+                       device->attributes().memory_limit());
+  }
+  return Fingerprint128(key);
+}
+
+}  // namespace
+#endif  // IS_MOBILE_PLATFORM
+
 GraphExecutionState::GraphExecutionState(
     GraphDef* graph_def, const GraphExecutionStateOptions& options)
     : stateful_placements_(options.stateful_placements),
@@ -635,10 +768,25 @@ Status GraphExecutionState::OptimizeGraph(
         cpu_device = device;
       }
     }
-    grappler::VirtualCluster cluster(device_set_);
+    OptimizedGraphCache* cache = OptimizedGraphCache::Global();
+    Fprint128 cache_key = {0, 0};
     GraphDef new_graph;
-    TF_RETURN_IF_ERROR(grappler::RunMetaOptimizer(
-        item, rewrite_options, cpu_device, &cluster, &new_graph));
+    if (cache->enabled()) {
+      cache_key = OptimizationFingerprint(item, options.callable_options,
+                                          rewrite_options, *device_set_);
+    }
+    if (cache->enabled() && cache->Lookup(cache_key, &new_graph)) {
+      optimized_graph_cache_lookups->GetCell("hit")->IncrementBy(1);
+      VLOG(1) << "Reusing the graph optimized for an identical subgraph";
+    } else {
+      if (cache->enabled()) {
+        optimized_graph_cache_lookups->GetCell("miss")->IncrementBy(1);
+      }
+      grappler::VirtualCluster cluster(device_set_);
+      TF_RETURN_IF_ERROR(grappler::RunMetaOptimizer(
+          item, rewrite_options, cpu_device, &cluster, &new_graph));
+      cache->Insert(cache_key, new_graph);
+    }
 
     // Merge optimized graph function library with an original library.
     // Optimized graph might have new functions specialized for it's
@@ -662,8 +810,8 @@ Status GraphExecutionState::OptimizeGraph(
 
     GraphConstructorOptions opts;
     opts.allow_internal_ops = true;
-    TF_RETURN_IF_ERROR(
-        ConvertGraphDefToGraph(opts, new_graph, optimized_graph->get()));
+    TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, std::move(new_graph),
+                                              optimized_graph->get()));
     // The graph conversion sets the requested device names but not the
     // assigned device names. However, since at this point the graph is placed
     // TF expects an assigned device name for every node. Therefore we copy
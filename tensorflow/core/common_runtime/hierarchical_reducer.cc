@@ -0,0 +1,429 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_reducer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/types.h"
+
+// Set true for greater intelligibility of debug mode log messages.
+#define READABLE_KEYS false
+
+namespace tensorflow {
+namespace {
+// Phases of the hierarchical reduction, used to keep the BufRendezvous keys
+// of different phases apart.
+enum Phase {
+  kLocalReduceScatter = 0,
+  kCrossTaskReduceScatter = 1,
+  kCrossTaskAllGather = 2,
+  kLocalAllGather = 3,
+};
+
+string HierarchicalReduceBufKey(const string& exec_key, int phase, int subdiv,
+                                int step, int source_rank) {
+  if (READABLE_KEYS) {
+    return strings::StrCat("hred(", exec_key, "):phase(", phase, "):subdiv(",
+                           subdiv, "):step(", step, "):srcrank(", source_rank,
+                           ")");
+  } else {
+    return strings::StrCat(exec_key, ":h", phase, ":", subdiv, ":", step, ":",
+                           source_rank);
+  }
+}
+
+}  // namespace
+
+HierarchicalReducer::HierarchicalReducer()
+    : col_ctx_(nullptr),
+      col_params_(nullptr),
+      done_(nullptr),
+      group_size_(-1),
+      num_tasks_(-1),
+      dev_per_task_(-1),
+      chunk_elts_(0) {}
+
+HierarchicalReducer::~HierarchicalReducer() {}
+
+Status HierarchicalReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  CHECK_EQ(col_params->instance.type, REDUCTION_COLLECTIVE);
+  CHECK_EQ(col_params->instance.impl_details.collective_name,
+           "HierarchicalReduce");
+  if (!col_params->instance.wire_format.empty()) {
+    return errors::Unimplemented("HierarchicalReduce does not support ",
+                                 "wire_format ",
+                                 col_params->instance.wire_format);
+  }
+  const int group_size = col_params->group.group_size;
+  // Count the devices in each task.
+  // Precondition: device_names must be sorted so that all devices in
+  // the same task are adjacent.
+  std::vector<int> dev_per_task;
+  const string* prior_task_name = &col_params->instance.task_names[0];
+  int dev_count = 1;
+  for (int di = 1; di < group_size; ++di) {
+    if (col_params->instance.task_names[di] != *prior_task_name) {
+      dev_per_task.push_back(dev_count);
+      dev_count = 1;
+      prior_task_name = &col_params->instance.task_names[di];
+    } else {
+      ++dev_count;
+    }
+  }
+  dev_per_task.push_back(dev_count);
+  for (int count : dev_per_task) {
+    if (count != dev_per_task[0]) {
+      return errors::InvalidArgument(
+          "HierarchicalReduce requires the same number of devices in every "
+          "task, but ", col_params->name, " spans tasks with ", dev_per_task[0],
+          " and ", count, " devices");
+    }
+  }
+  const int num_tasks = static_cast<int>(dev_per_task.size());
+  const int num_local = dev_per_task[0];
+
+  // Subdiv t < num_tasks is the ring of the devices of task t.  Subdiv
+  // num_tasks + l is the ring of the devices with local rank l in every
+  // task.
+  std::vector<std::vector<int>>& perms =
+      col_params->instance.impl_details.subdiv_permutations;
+  perms.clear();
+  perms.resize(num_tasks + num_local);
+  col_params->subdiv_rank.assign(num_tasks + num_local, -1);
+  for (int ti = 0; ti < num_tasks; ++ti) {
+    for (int li = 0; li < num_local; ++li) {
+      const int device_idx = ti * num_local + li;
+      perms[ti].push_back(device_idx);
+      perms[num_tasks + li].push_back(device_idx);
+      if (device_idx == col_params->default_rank) {
+        col_params->subdiv_rank[ti] = li;
+        col_params->subdiv_rank[num_tasks + li] = ti;
+      }
+    }
+  }
+
+  VLOG(2) << collective_util::SubdivPermDebugString(*col_params);
+  return Status::OK();
+}
+
+Status HierarchicalReducer::InitializeCollectiveContext(
+    CollectiveContext* col_ctx) {
+  CHECK(col_ctx->dev_mgr);
+  col_ctx_ = col_ctx;
+  col_params_ = &col_ctx->col_params;
+  return collective_util::InitializeDeviceAndLocality(
+      col_ctx->dev_mgr, col_ctx->device_name, &col_ctx->device,
+      &col_ctx->device_locality);
+}
+
+void HierarchicalReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  done_ = std::move(done);
+  group_size_ = col_params_->group.group_size;
+  const auto& perms = col_params_->instance.impl_details.subdiv_permutations;
+  CHECK(!perms.empty());
+  dev_per_task_ = static_cast<int>(perms[0].size());
+  num_tasks_ = static_cast<int>(perms.size()) - dev_per_task_;
+  CHECK_EQ(group_size_, num_tasks_ * dev_per_task_);
+
+  // Start by copying input to output if they're not already the same, i.e. if
+  // we're not computing in-place on the input tensor.
+  if ((col_ctx_->input != col_ctx_->output) &&
+      (DMAHelper::base(col_ctx_->input) != DMAHelper::base(col_ctx_->output))) {
+    // We are running in a blockable thread and the callback can't block so
+    // just wait here on the copy.
+    Notification note;
+    Status status;
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        col_ctx_->op_ctx->input_device_context(0),
+        col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+        col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+        col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+        col_ctx_->output, 0 /*dev_to_dev_stream_index*/,
+        [&note, &status](const Status& s) {
+          status.Update(s);
+          note.Notify();
+        });
+    note.WaitForNotification();
+    if (!status.ok()) {
+      done_(status);
+      return;
+    }
+  }
+
+  AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+  ca_.reset(MakeCollectiveAdapter(col_ctx_->output, group_size_,
+                                  col_ctx_->device->GetAllocator(attr)));
+  flat_ = ca_->Value();
+  chunk_elts_ = CollectiveAdapter::AlignedChunkElts(
+      DataTypeSize(flat_.dtype()), flat_.NumElements(), group_size_);
+
+  if (col_params_->final_op) {
+    // Create an on-device scalar value from group_size_ for the final_op.
+    Tensor group_size_val = ca_->Scalar(group_size_);
+    if (col_params_->group.device_type != "CPU") {
+      group_size_tensor_ = ca_->Scalar(col_ctx_->device->GetAllocator(
+          col_ctx_->op_ctx->input_alloc_attr(0)));
+      DeviceContext* op_dev_ctx = col_ctx_->op_ctx->op_device_context();
+      op_dev_ctx->CopyCPUTensorToDevice(&group_size_val, col_ctx_->device,
+                                        &group_size_tensor_,
+                                        [this](const Status& s) {
+                                          if (!s.ok()) {
+                                            StartAbort(s);
+                                          }
+                                          group_size_tensor_ready_.Notify();
+                                        });
+    } else {
+      group_size_tensor_ = group_size_val;
+      group_size_tensor_ready_.Notify();
+    }
+  } else {
+    // Value won't be used, so no need to initialize.
+    group_size_tensor_ready_.Notify();
+  }
+
+  RunHierarchy();
+
+  group_size_tensor_ready_.WaitForNotification();
+  flat_ = Tensor();  // Give up the Ref on the output buffer.
+  ca_->ConsumeFinalValue(col_ctx_->output);
+  ca_.reset();
+  done_(status());
+}
+
+void HierarchicalReducer::StartAbort(const Status& s) {
+  bool abort_started = false;
+  {
+    mutex_lock l(status_mu_);
+    if (status_.ok()) {
+      LOG(ERROR) << "Aborting HierarchicalReduce with " << s;
+      abort_started = true;
+      status_.Update(s);
+    }
+  }
+  // If this is the initial entry to abort mode then invoke StartAbort
+  // on the CollectiveExecutor that invoked us.  That should start
+  // cancellation on all of the outstanding CollectiveRemoteAccess
+  // actions.
+  if (abort_started) {
+    col_ctx_->col_exec->StartAbort(s);
+  }
+}
+
+Status HierarchicalReducer::status() {
+  mutex_lock l(status_mu_);
+  return status_;
+}
+
+Tensor HierarchicalReducer::ChunkRangeAlias(int first_chunk, int num_chunks) {
+  const int64 total_elts = flat_.NumElements();
+  const int64 start = std::min(total_elts, first_chunk * chunk_elts_);
+  const int64 limit =
+      std::min(total_elts, (first_chunk + num_chunks) * chunk_elts_);
+  // As in CollectiveAdapter::ChunkAlias, take empty slices from the front
+  // of the tensor to avoid an illegal offset.
+  return (limit > start) ? flat_.Slice(start, limit) : flat_.Slice(0, 0);
+}
+
+// Note that this function is blocking and must not run in any thread
+// which cannot be blocked.
+void HierarchicalReducer::RunHierarchy() {
+  int local_subdiv = -1;
+  for (int ti = 0; ti < num_tasks_; ++ti) {
+    if (col_params_->subdiv_rank[ti] >= 0) local_subdiv = ti;
+  }
+  CHECK_GE(local_subdiv, 0);
+  const int local_rank = col_params_->subdiv_rank[local_subdiv];
+  const int cross_task_subdiv = num_tasks_ + local_rank;
+  const int task_rank = col_params_->subdiv_rank[cross_task_subdiv];
+  VLOG(1) << "HierarchicalReducer::Run for device " << col_ctx_->device_name
+          << " default_rank " << col_params_->default_rank << " local_rank "
+          << local_rank << " task_rank " << task_rank;
+
+  // The output is divided into group_size_ chunks.  Within a task each
+  // device starts responsible for a segment of num_tasks_ consecutive
+  // chunks, and across tasks for one chunk of the segment it owns.
+  std::vector<Tensor> segments;
+  for (int li = 0; li < dev_per_task_; ++li) {
+    segments.push_back(ChunkRangeAlias(li * num_tasks_, num_tasks_));
+  }
+  RingReduceScatter(kLocalReduceScatter, local_subdiv, local_rank, &segments);
+  if (!status().ok()) return;
+
+  const int owned_segment = (local_rank + 1) % dev_per_task_;
+  std::vector<Tensor> pieces;
+  for (int ti = 0; ti < num_tasks_; ++ti) {
+    pieces.push_back(ChunkRangeAlias(owned_segment * num_tasks_ + ti, 1));
+  }
+  RingReduceScatter(kCrossTaskReduceScatter, cross_task_subdiv, task_rank,
+                    &pieces);
+  if (!status().ok()) return;
+
+  Tensor* owned_piece = &pieces[(task_rank + 1) % num_tasks_];
+  if (col_params_->final_op && owned_piece->NumElements() > 0) {
+    group_size_tensor_ready_.WaitForNotification();
+    Status s = collective_util::ComputeBinOp(
+        col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+        col_params_->final_op.get(), owned_piece, &group_size_tensor_);
+    if (!s.ok()) {
+      StartAbort(s);
+      return;
+    }
+  }
+
+  RingAllGather(kCrossTaskAllGather, cross_task_subdiv, task_rank, &pieces);
+  if (!status().ok()) return;
+  RingAllGather(kLocalAllGather, local_subdiv, local_rank, &segments);
+}
+
+void HierarchicalReducer::RingReduceScatter(int phase, int subdiv, int rank,
+                                            std::vector<Tensor>* fields) {
+  const int num_fields = static_cast<int>(fields->size());
+  if (num_fields < 2) return;
+  // Allocate the receive buffers up front.  On a GPU, wait for the compute
+  // stream before using them: they are not guaranteed to be valid, e.g. for
+  // RDMA writes, until then.
+  AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+  Allocator* allocator = col_ctx_->device->GetAllocator(attr);
+  std::vector<Tensor> tmp_fields(num_fields);
+  for (int fi = 0; fi < num_fields; ++fi) {
+    if (fi != rank && (*fields)[fi].NumElements() > 0) {
+      tmp_fields[fi] =
+          Tensor(allocator, (*fields)[fi].dtype(), (*fields)[fi].shape());
+    }
+  }
+  const DeviceBase::GpuDeviceInfo* gpu_info =
+      col_ctx_->device->tensorflow_gpu_device_info();
+  if (gpu_info) {
+    Notification note;
+    Status s = gpu_info->default_context->ThenExecute(
+        col_ctx_->device, gpu_info->stream, [&note]() { note.Notify(); });
+    if (!s.ok()) {
+      StartAbort(errors::Internal(
+          "Failed to dispatch ThenExecute in HierarchicalReducer"));
+      return;
+    }
+    note.WaitForNotification();
+  }
+
+  // At each step every member sends the field it reduced last and reduces
+  // the field received from its predecessor into its own copy.
+  for (int step = 0; step < num_fields - 1; ++step) {
+    const int send_idx = (rank + num_fields - step) % num_fields;
+    const int recv_idx = (rank + num_fields - step - 1) % num_fields;
+    SendRecv(phase, subdiv, rank, step, (*fields)[send_idx],
+             &tmp_fields[recv_idx]);
+    if (!status().ok()) return;
+    if (tmp_fields[recv_idx].NumElements() > 0) {
+      Status s = collective_util::ComputeBinOp(
+          col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+          col_params_->merge_op.get(), &(*fields)[recv_idx],
+          &tmp_fields[recv_idx]);
+      if (!s.ok()) {
+        StartAbort(s);
+        return;
+      }
+    }
+  }
+}
+
+void HierarchicalReducer::RingAllGather(int phase, int subdiv, int rank,
+                                        std::vector<Tensor>* fields) {
+  const int num_fields = static_cast<int>(fields->size());
+  // At each step every member forwards the last field it received, starting
+  // with the one it owns, and receives the next one in place.
+  for (int step = 0; step < num_fields - 1; ++step) {
+    const int send_idx = (rank + 1 + num_fields - step) % num_fields;
+    const int recv_idx = (rank + num_fields - step) % num_fields;
+    SendRecv(phase, subdiv, rank, step, (*fields)[send_idx],
+             &(*fields)[recv_idx]);
+    if (!status().ok()) return;
+  }
+}
+
+void HierarchicalReducer::SendRecv(int phase, int subdiv, int rank, int step,
+                                   const Tensor& send_field,
+                                   Tensor* recv_field) {
+  const std::vector<int>& perm =
+      col_params_->instance.impl_details.subdiv_permutations[subdiv];
+  const int ring_size = static_cast<int>(perm.size());
+  const int send_to_idx = perm[(rank + 1) % ring_size];
+  const int recv_from_rank = (rank + ring_size - 1) % ring_size;
+  const int recv_from_idx = perm[recv_from_rank];
+
+  mutex mu;
+  condition_variable all_done;
+  int pending_count = 0;  // GUARDED_BY(mu)
+  auto callback = [this, &mu, &all_done, &pending_count](const Status& s) {
+    if (!s.ok()) StartAbort(s);
+    mutex_lock l(mu);
+    if (--pending_count == 0) all_done.notify_all();
+  };
+  const bool do_send = send_field.NumElements() > 0;
+  const bool do_recv = recv_field->NumElements() > 0;
+  {
+    mutex_lock l(mu);
+    pending_count = (do_send ? 1 : 0) + (do_recv ? 1 : 0);
+  }
+  if (do_send) {
+    string send_buf_key = HierarchicalReduceBufKey(col_ctx_->exec_key, phase,
+                                                   subdiv, step, rank);
+    VLOG(3) << "DispatchSend " << send_buf_key << " to_device "
+            << col_params_->instance.device_names[send_to_idx];
+    col_ctx_->col_exec->PostToPeer(
+        col_params_->instance.device_names[send_to_idx],
+        col_params_->instance.task_names[send_to_idx], send_buf_key,
+        col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->output_alloc_attr(0), &send_field,
+        col_ctx_->device_locality, callback);
+  }
+  if (do_recv) {
+    string recv_buf_key = HierarchicalReduceBufKey(
+        col_ctx_->exec_key, phase, subdiv, step, recv_from_rank);
+    VLOG(3) << "DispatchRecv " << recv_buf_key << " from_device "
+            << col_params_->instance.device_names[recv_from_idx];
+    col_ctx_->col_exec->RecvFromPeer(
+        col_params_->instance.device_names[recv_from_idx],
+        col_params_->instance.task_names[recv_from_idx],
+        col_params_->task.is_local[recv_from_idx], recv_buf_key,
+        col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->output_alloc_attr(0), recv_field,
+        col_ctx_->device_locality, 0 /*stream_index*/, callback);
+  }
+  mutex_lock l(mu);
+  while (pending_count > 0) {
+    all_done.wait(l);
+  }
+}
+
+REGISTER_COLLECTIVE(HierarchicalReduce, HierarchicalReducer);
+
+}  // namespace tensorflow
@@ -0,0 +1,113 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+// Two-level implementation of collective all-reduce, for groups that span
+// several tasks with fast links between the devices of a task and slower
+// links between tasks.  The reduction runs in three phases:
+//   1. a ring reduce-scatter among the devices of each task, after which
+//      each device owns the task-wide sum of 1/D of the tensor, where D is
+//      the number of devices per task;
+//   2. a ring all-reduce of that part among the devices with the same
+//      local rank in every task;
+//   3. a ring all-gather among the devices of each task.
+// Only 1/D of the tensor crosses task boundaries per device, and all
+// devices of a task send across task boundaries at the same time.
+//
+// Selected by setting the "implementation" attr of CollectiveReduce to
+// "HierarchicalReduce".  Requires the same number of devices in every task.
+class HierarchicalReducer : public CollectiveImplementationInterface {
+ public:
+  HierarchicalReducer();
+  ~HierarchicalReducer() override;
+
+  // Establishes one subdiv per task, holding the devices of that task in
+  // default rank order, followed by one subdiv per local rank, holding the
+  // device of that local rank in every task.  The default rank order of
+  // the devices within a task is the ring order derived from their
+  // DeviceLocality links by the param resolver.
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+  // Initializes members of CollectiveContext not yet initialized, i.e. device
+  // and device_locality.  Also saves the CollectiveContext in this object.
+  Status InitializeCollectiveContext(CollectiveContext* col_ctx) override;
+
+  // Begins execution of the hierarchical reduction.
+  // Must be called in a blockable thread.
+  // TODO(b/80529858): remove the previous warning when we have a dedicated
+  // collective threadpool.
+  void Run(StatusCallback done) override;
+
+ private:
+  // Called when a bad status is received that implies we should terminate
+  // execution and return a bad status.
+  void StartAbort(const Status& s);
+  Status status();
+
+  // Executes the three phases on the value held by ca_.
+  void RunHierarchy();
+
+  // Returns an alias of chunks [first_chunk, first_chunk + num_chunks) of
+  // the flattened output, where the output is divided into group_size
+  // aligned chunks.
+  Tensor ChunkRangeAlias(int first_chunk, int num_chunks);
+
+  // Ring reduce-scatter of `fields` among the members of `subdiv`, in
+  // which this device has rank `rank`.  On return this device holds the
+  // reduction of fields[(rank + 1) % fields.size()].
+  void RingReduceScatter(int phase, int subdiv, int rank,
+                         std::vector<Tensor>* fields);
+
+  // Ring all-gather of `fields` among the members of `subdiv`, where this
+  // device holds the final value of fields[(rank + 1) % fields.size()].
+  void RingAllGather(int phase, int subdiv, int rank,
+                     std::vector<Tensor>* fields);
+
+  // Sends `send_field` to the next member of `subdiv` and receives
+  // `recv_field` from the previous one, waiting for both.  Empty fields are
+  // skipped on both ends.
+  void SendRecv(int phase, int subdiv, int rank, int step,
+                const Tensor& send_field, Tensor* recv_field);
+
+  CollectiveContext* col_ctx_;          // Not owned
+  const CollectiveParams* col_params_;  // Not owned
+  StatusCallback done_;
+  int group_size_;
+  int num_tasks_;
+  int dev_per_task_;
+  Tensor group_size_tensor_;
+  Notification group_size_tensor_ready_;
+  std::unique_ptr<CollectiveAdapter> ca_;
+  Tensor flat_;  // Alias of the value held by ca_.
+  int64 chunk_elts_;
+  mutex status_mu_;
+  Status status_ GUARDED_BY(status_mu_);
+
+  friend class HierarchicalReducerTest;
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
@@ -0,0 +1,294 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_reducer.h"
+
+#include <atomic>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/device_resolver_local.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/common_runtime/test_collective_executor_mgr.h"
+#include "tensorflow/core/common_runtime/threadpool_device.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+static int64 kStepId = 123;
+
+std::unique_ptr<OpKernel> GetBinOp(const string& op, DataType dtype,
+                                   DeviceBase* device) {
+  NodeDef node_def;
+  NodeDefBuilder builder(strings::StrCat(op, "_node"), op);
+  TF_CHECK_OK(builder.Attr("T", dtype)
+                  .Input(FakeInput(dtype))
+                  .Input(FakeInput(dtype))
+                  .Finalize(&node_def));
+  Status status;
+  std::unique_ptr<OpKernel> k = CreateOpKernel(
+      DEVICE_CPU, device, device->GetAllocator(AllocatorAttributes()),
+      node_def, TF_GRAPH_DEF_VERSION, &status);
+  TF_CHECK_OK(status);
+  return k;
+}
+
+// Describes num_workers tasks of num_devices CPU devices each, in default
+// rank order.
+CollectiveParams SetUpCollectiveParams(int num_workers, int num_devices) {
+  CollectiveParams cp;
+  cp.name = "test_collective";
+  cp.group.group_key = 5;
+  cp.group.group_size = num_workers * num_devices;
+  cp.group.device_type = DEVICE_CPU;
+  cp.group.num_tasks = num_workers;
+  cp.instance.instance_key = 17;
+  cp.instance.type = REDUCTION_COLLECTIVE;
+  cp.instance.data_type = DT_FLOAT;
+  cp.instance.impl_details.collective_name = "HierarchicalReduce";
+  for (int wi = 0; wi < num_workers; ++wi) {
+    const string task_name =
+        strings::StrCat("/job:worker/replica:0/task:", wi);
+    for (int di = 0; di < num_devices; ++di) {
+      cp.instance.task_names.push_back(task_name);
+      cp.instance.device_names.push_back(
+          strings::StrCat(task_name, "/device:CPU:", di));
+      // This test runs in a single process so is_local is always true.
+      cp.task.is_local.push_back(true);
+    }
+  }
+  return cp;
+}
+
+}  // namespace
+
+class HierarchicalReducerTest : public ::testing::Test {
+ protected:
+  ~HierarchicalReducerTest() override {
+    for (auto* di : instances_) delete di;
+    if (col_exec_) col_exec_->Unref();
+  }
+
+  void Init(int num_workers, int num_devices) {
+    col_params_ = SetUpCollectiveParams(num_workers, num_devices);
+    std::vector<Device*> local_devices;
+    SessionOptions sess_opts;
+    sess_opts.env = Env::Default();
+    Bytes mem_limit(4 << 20);
+    DeviceLocality dev_locality;
+    for (const string& dev_name : col_params_.instance.device_names) {
+      local_devices.push_back(new ThreadPoolDevice(
+          sess_opts, dev_name, mem_limit, dev_locality, cpu_allocator()));
+    }
+    dev_mgr_.reset(new DeviceMgr(local_devices));
+    dev_resolver_.reset(new DeviceResolverLocal(dev_mgr_.get()));
+    rma_ = new CollectiveRemoteAccessLocal(dev_mgr_.get(), dev_resolver_.get(),
+                                           kStepId);
+    col_exec_ = new BaseCollectiveExecutor(&col_exec_mgr_, rma_, kStepId,
+                                           dev_mgr_.get());
+    for (int rank = 0; rank < col_params_.group.group_size; ++rank) {
+      instances_.push_back(new DeviceInstance(rank, this));
+    }
+  }
+
+  void RunTest(int num_workers, int num_devices, int tensor_len) {
+    Init(num_workers, num_devices);
+    const int group_size = num_workers * num_devices;
+    std::vector<float> expected(tensor_len, 0.0f);
+    for (int di = 0; di < group_size; ++di) {
+      Tensor* t = &instances_[di]->tensor_;
+      *t = Tensor(DT_FLOAT, TensorShape({tensor_len}));
+      for (int i = 0; i < tensor_len; ++i) {
+        const float value = di * 10 + i;
+        t->flat<float>()(i) = value;
+        expected[i] += value;
+      }
+    }
+    std::atomic<int> done(0);
+    for (auto* di : instances_) {
+      SchedClosure([di, &done] {
+        di->DoReduce();
+        ++done;
+      });
+    }
+    while (done < group_size) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    for (int di = 0; di < group_size; ++di) {
+      TF_EXPECT_OK(instances_[di]->status_);
+      const Tensor& actual = instances_[di]->tensor_;
+      ASSERT_EQ(tensor_len, actual.NumElements());
+      for (int i = 0; i < tensor_len; ++i) {
+        EXPECT_FLOAT_EQ(expected[i] / group_size, actual.flat<float>()(i))
+            << "Mismatch at device " << di << " index " << i;
+      }
+    }
+  }
+
+  class DeviceInstance {
+   public:
+    DeviceInstance(int rank, HierarchicalReducerTest* parent)
+        : parent_(parent) {
+      col_params_.name = parent_->col_params_.name;
+      col_params_.group = parent_->col_params_.group;
+      col_params_.instance = parent_->col_params_.instance;
+      col_params_.instance.impl_details.collective_name =
+          parent_->col_params_.instance.impl_details.collective_name;
+      col_params_.task.is_local = parent_->col_params_.task.is_local;
+      col_params_.default_rank = rank;
+      TF_CHECK_OK(parent_->dev_mgr_->LookupDevice(
+          col_params_.instance.device_names[rank], &device_));
+      HierarchicalReducer reducer;
+      TF_CHECK_OK(reducer.InitializeCollectiveParams(&col_params_));
+    }
+
+    void DoReduce() {
+      col_params_.merge_op = GetBinOp("Add", DT_FLOAT, device_);
+      col_params_.final_op = GetBinOp("Div", DT_FLOAT, device_);
+
+      // Prepare an OpKernelContext.
+      OpKernelContext::Params op_params;
+      op_params.step_id = kStepId;
+      op_params.device = device_;
+      gtl::InlinedVector<TensorValue, 4> inputs;
+      inputs.push_back(TensorValue(&tensor_));
+      op_params.inputs = &inputs;
+      gtl::InlinedVector<AllocatorAttributes, 4> input_aa(
+          {AllocatorAttributes()});
+      op_params.input_alloc_attrs = &input_aa;
+      DeviceContext* dev_ctx = new DeviceContext;
+      gtl::InlinedVector<DeviceContext*, 4> input_dc({dev_ctx});
+      op_params.input_device_contexts = &input_dc;
+      op_params.op_device_context = dev_ctx;
+      int forward_from = 0;
+      op_params.forward_from_array = &forward_from;
+      AllocatorAttributes generic_alloc_attr;
+      op_params.output_attr_array = &generic_alloc_attr;
+      std::unique_ptr<OpKernel> op = parent_->GetCollectiveReduce(
+          col_params_, device_);
+      op_params.op_kernel = op.get();
+      OpKernelContext ctx(&op_params, 1);
+
+      // We never actually execute the kernel, so we need to do the output
+      // allocation it would do, ourselves.
+      Tensor* output_tensor_ptr = nullptr;
+      TF_CHECK_OK(ctx.forward_input_or_allocate_output({0}, 0, tensor_.shape(),
+                                                       &output_tensor_ptr));
+
+      string exec_key =
+          strings::StrCat(col_params_.instance.instance_key, ":0:0");
+      HierarchicalReducer reducer;
+      CollectiveContext col_ctx(parent_->col_exec_, parent_->dev_mgr_.get(),
+                                &ctx, &op_params, col_params_, exec_key,
+                                kStepId, &tensor_, &tensor_);
+      TF_CHECK_OK(reducer.InitializeCollectiveContext(&col_ctx));
+      reducer.Run([this](Status s) { status_ = s; });
+      if (status_.ok()) {
+        CHECK(tensor_.CopyFrom(*ctx.mutable_output(0), tensor_.shape()));
+      }
+      dev_ctx->Unref();
+    }
+
+    HierarchicalReducerTest* parent_;
+    Device* device_;
+    CollectiveParams col_params_;
+    Tensor tensor_;
+    Status status_;
+  };
+
+  std::unique_ptr<OpKernel> GetCollectiveReduce(const CollectiveParams& params,
+                                                DeviceBase* device) {
+    mutex_lock l(mu_);
+    NodeDef node_def;
+    NodeDefBuilder builder(
+        strings::StrCat("collective_reduce_", reduce_counter_++),
+        "CollectiveReduce");
+    TF_CHECK_OK(
+        builder.Attr("T", params.instance.data_type)
+            .Attr("merge_op", "Add")
+            .Attr("final_op", "Div")
+            .Attr("group_size", params.group.group_size)
+            .Attr("group_key", params.group.group_key)
+            .Attr("instance_key", params.instance.instance_key)
+            .Attr("subdiv_offsets", std::vector<int>())
+            .Attr("implementation", "HierarchicalReduce")
+            .Input(FakeInput(params.instance.data_type))
+            .Finalize(&node_def));
+    Status status;
+    std::unique_ptr<OpKernel> k = CreateOpKernel(
+        DEVICE_CPU, device, device->GetAllocator(AllocatorAttributes()),
+        node_def, TF_GRAPH_DEF_VERSION, &status);
+    TF_CHECK_OK(status);
+    return k;
+  }
+
+  TestCollectiveExecutorMgr col_exec_mgr_;
+  CollectiveExecutor* col_exec_ = nullptr;
+  CollectiveRemoteAccessLocal* rma_;
+  std::unique_ptr<DeviceResolverLocal> dev_resolver_;
+  std::unique_ptr<DeviceMgr> dev_mgr_;
+  std::vector<DeviceInstance*> instances_;
+  CollectiveParams col_params_;
+  mutex mu_;
+  int32 reduce_counter_ GUARDED_BY(mu_) = 0;
+};
+
+TEST_F(HierarchicalReducerTest, InitializeParams) {
+  CollectiveParams cp = SetUpCollectiveParams(3, 2);
+  cp.default_rank = 3;
+  HierarchicalReducer reducer;
+  TF_ASSERT_OK(reducer.InitializeCollectiveParams(&cp));
+  std::vector<std::vector<int>> expected_perms = {
+      {0, 1}, {2, 3}, {4, 5}, {0, 2, 4}, {1, 3, 5}};
+  EXPECT_EQ(expected_perms, cp.instance.impl_details.subdiv_permutations);
+  std::vector<int> expected_rank = {-1, 1, -1, -1, 1};
+  EXPECT_EQ(expected_rank, cp.subdiv_rank);
+}
+
+TEST_F(HierarchicalReducerTest, RejectsUnevenTasks) {
+  CollectiveParams cp = SetUpCollectiveParams(2, 2);
+  cp.instance.task_names[1] = cp.instance.task_names[2];
+  cp.default_rank = 0;
+  HierarchicalReducer reducer;
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(reducer.InitializeCollectiveParams(&cp)));
+}
+
+#define DEF_TEST(W, D, L)                                     \
+  TEST_F(HierarchicalReducerTest, Wkr##W##_Dev##D##_Len##L) { \
+    RunTest(W, D, L);                                         \
+  }
+
+DEF_TEST(1, 2, 1001)
+DEF_TEST(1, 4, 4096)
+DEF_TEST(2, 1, 1001)
+DEF_TEST(2, 2, 1)
+DEF_TEST(2, 2, 7)
+DEF_TEST(2, 4, 4095)
+DEF_TEST(3, 2, 1001)
+DEF_TEST(4, 4, 1045991)
+
+}  // namespace tensorflow
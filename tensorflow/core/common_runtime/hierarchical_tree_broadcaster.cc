@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/hierarchical_tree_broadcaster.h"
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <string>
@@ -32,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 // Set true for greater intelligibility of debug mode log messages.
 #define READABLE_KEYS false
@@ -41,15 +43,56 @@ namespace tensorflow {
 namespace {
 // Key to be used for BufRendezvous by Broadcaster.
 string BroadcastBufKey(const string& exec_key, int subdiv, int src_rank,
-                       int dst_rank) {
+                       int dst_rank, int chunk) {
   if (READABLE_KEYS) {
     return strings::StrCat("broadcast(", exec_key, "):subdiv(", subdiv,
-                           "):src(", src_rank, "):dst(", dst_rank, ")");
+                           "):src(", src_rank, "):dst(", dst_rank, "):chunk(",
+                           chunk, ")");
   } else {
     // TODO(b/78352018): Try a denser format, e.g. a 64 or 128 bit hash.
-    return strings::StrCat(exec_key, ":", subdiv, ":", src_rank, ":", dst_rank);
+    return strings::StrCat(exec_key, ":", subdiv, ":", src_rank, ":", dst_rank,
+                           ":", chunk);
   }
 }
+
+// Tensors larger than this many bytes are broadcast in chunks of about this
+// size, so that each device forwards a chunk while receiving the next one.
+// Must be the same on all tasks.  0 disables chunking.
+int64 BroadcastChunkBytes() {
+  static int64 chunk_bytes = []() {
+    int64 value;
+    Status s = ReadInt64FromEnvVar("TF_COLLECTIVE_BROADCAST_CHUNK_BYTES",
+                                   4 << 20, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return static_cast<int64>(4 << 20);
+    }
+    return value;
+  }();
+  return chunk_bytes;
+}
+
+// Returns aligned aliases of consecutive pieces of tensor, each of about
+// chunk_bytes, or just tensor if it is not larger than chunk_bytes.
+std::vector<Tensor> SplitIntoChunks(const Tensor& tensor, int64 chunk_bytes) {
+  std::vector<Tensor> chunks;
+  const int64 total_bytes = tensor.TotalBytes();
+  if (chunk_bytes <= 0 || total_bytes <= chunk_bytes) {
+    chunks.push_back(tensor);
+    return chunks;
+  }
+  const int64 total_elts = tensor.NumElements();
+  const int64 chunk_elts = CollectiveAdapter::AlignedChunkElts(
+      DataTypeSize(tensor.dtype()), total_elts,
+      (total_bytes + chunk_bytes - 1) / chunk_bytes);
+  Tensor flat;
+  CHECK(flat.CopyFrom(tensor, TensorShape({total_elts})));
+  for (int64 begin = 0; begin < total_elts; begin += chunk_elts) {
+    chunks.push_back(flat.Slice(begin, std::min(begin + chunk_elts,
+                                                total_elts)));
+  }
+  return chunks;
+}
 }  // namespace
 
 HierarchicalTreeBroadcaster::HierarchicalTreeBroadcaster()
@@ -313,31 +356,39 @@ void HierarchicalTreeBroadcaster::RunTree() {
     int pending_count = 0;  // GUARDED_BY(mu)
     condition_variable all_done;
 
-    if (my_rank >= 0 && my_rank != source_rank) {
-      // Begin by receiving the value.
-      int recv_from_rank = TreeRecvFrom(*col_params_, si);
-      Notification note;
-      DispatchRecv(si, recv_from_rank, my_rank, col_ctx_->output,
-                   [this, &mu, &note](const Status& s) {
-                     mutex_lock l(mu);
-                     status_.Update(s);
-                     note.Notify();
-                   });
-      note.WaitForNotification();
-    }
+    // The value moves through the tree chunk by chunk: a device forwards
+    // each chunk to its descendents as soon as it has received it, while it
+    // receives the next one.  The chunks alias the output (or, at the
+    // source, the input) and must outlive the pending sends.
+    std::vector<Tensor> recv_chunks =
+        SplitIntoChunks(*col_ctx_->output, BroadcastChunkBytes());
+    std::vector<Tensor> send_chunks =
+        is_source_ ? SplitIntoChunks(*col_ctx_->input, BroadcastChunkBytes())
+                   : recv_chunks;
+    std::vector<int> send_to_ranks;
+    TreeSendTo(*col_params_, si, &send_to_ranks);
+    const int recv_from_rank =
+        (my_rank != source_rank) ? TreeRecvFrom(*col_params_, si) : -1;
+    for (int ci = 0; ci < send_chunks.size(); ++ci) {
+      if (recv_from_rank >= 0) {
+        Notification note;
+        DispatchRecv(si, recv_from_rank, my_rank, ci, &recv_chunks[ci],
+                     [this, &mu, &note](const Status& s) {
+                       mutex_lock l(mu);
+                       status_.Update(s);
+                       note.Notify();
+                     });
+        note.WaitForNotification();
+      }
+      {
+        mutex_lock l(mu);
+        if (!status_.ok()) break;
+        pending_count += send_to_ranks.size();
+      }
 
-    // Then forward value to all descendent devices.
-    if (my_rank >= 0 && status_.ok()) {
-      std::vector<int> send_to_ranks;
-      TreeSendTo(*col_params_, si, &send_to_ranks);
-      for (int i = 0; i < send_to_ranks.size(); ++i) {
-        int target_rank = send_to_ranks[i];
-        {
-          mutex_lock l(mu);
-          ++pending_count;
-        }
-        DispatchSend(si, target_rank, my_rank,
-                     (is_source_ ? col_ctx_->input : col_ctx_->output),
+      // Then forward the chunk to all descendent devices.
+      for (int target_rank : send_to_ranks) {
+        DispatchSend(si, target_rank, my_rank, ci, &send_chunks[ci],
                      [this, &mu, &pending_count, &all_done](const Status& s) {
                        mutex_lock l(mu);
                        status_.Update(s);
@@ -386,7 +437,7 @@ void HierarchicalTreeBroadcaster::RunTree() {
     // Then wait for all pending actions to complete.
     {
       mutex_lock l(mu);
-      if (pending_count > 0) {
+      while (pending_count > 0) {
         all_done.wait(l);
       }
     }
@@ -396,11 +447,11 @@ void HierarchicalTreeBroadcaster::RunTree() {
 }
 
 void HierarchicalTreeBroadcaster::DispatchSend(int subdiv, int dst_rank,
-                                               int src_rank,
+                                               int src_rank, int chunk,
                                                const Tensor* src_tensor,
                                                const StatusCallback& done) {
   string send_buf_key =
-      BroadcastBufKey(col_ctx_->exec_key, subdiv, src_rank, dst_rank);
+      BroadcastBufKey(col_ctx_->exec_key, subdiv, src_rank, dst_rank, chunk);
   int dst_idx =
       col_params_->instance.impl_details.subdiv_permutations[subdiv][dst_rank];
   VLOG(3) << "DispatchSend " << send_buf_key << " from_device "
@@ -416,10 +467,11 @@ void HierarchicalTreeBroadcaster::DispatchSend(int subdiv, int dst_rank,
 }
 
 void HierarchicalTreeBroadcaster::DispatchRecv(int subdiv, int src_rank,
-                                               int dst_rank, Tensor* dst_tensor,
+                                               int dst_rank, int chunk,
+                                               Tensor* dst_tensor,
                                                const StatusCallback& done) {
   string recv_buf_key =
-      BroadcastBufKey(col_ctx_->exec_key, subdiv, src_rank, dst_rank);
+      BroadcastBufKey(col_ctx_->exec_key, subdiv, src_rank, dst_rank, chunk);
   int src_idx =
       col_params_->instance.impl_details.subdiv_permutations[subdiv][src_rank];
   VLOG(3) << "DispatchRecv " << recv_buf_key << " from_device "
@@ -876,9 +876,14 @@ DEF_TEST(DOUBLE, CPU, 2, 4, 128, 0, false)
 DEF_TEST(INT32, CPU, 2, 4, 128, 0, true)
 DEF_TEST(INT64, CPU, 2, 4, 128, 0, false)
 
+// Tensors larger than the broadcast chunk size are pipelined in chunks.
+DEF_TEST(FLOAT, CPU, 2, 4, 2500000, 0, false)
+DEF_TEST(INT64, CPU, 1, 3, 1300001, 0, true)
+
 // Failure cases
 DEF_TEST(FLOAT, CPU, 2, 4, 128, 1, true)
 DEF_TEST(FLOAT, CPU, 2, 4, 128, 5, false)
+DEF_TEST(FLOAT, CPU, 2, 4, 2500000, 9, true)
 #endif
 
 #ifdef GOOGLE_CUDA
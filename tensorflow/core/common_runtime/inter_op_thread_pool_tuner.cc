@@ -0,0 +1,117 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/inter_op_thread_pool_tuner.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+InterOpThreadPoolTuner::InterOpThreadPoolTuner(Env* env,
+                                               thread::ThreadPool* default_pool,
+                                               int steps_per_size)
+    : steps_per_size_(std::max(1, steps_per_size)) {
+  const int32 default_size = default_pool->NumThreads();
+  // Fewer threads than cores often win when the ops themselves use the
+  // intra-op pool, and lose when the graph is wide, so smaller pools are
+  // tried against the default.
+  for (int32 size : {default_size / 4, default_size / 2}) {
+    size = std::max(1, size);
+    if (size < default_size &&
+        (sizes_.empty() || sizes_.back() != size)) {
+      sizes_.push_back(size);
+    }
+  }
+  sizes_.push_back(default_size);
+
+  mutex_lock l(mu_);
+  for (int32 size : sizes_) {
+    Candidate candidate;
+    if (size == default_size) {
+      candidate.pool.reset(default_pool, [](thread::ThreadPool*) {});
+    } else {
+      candidate.pool = std::make_shared<thread::ThreadPool>(
+          env, strings::StrCat("InterOpTuning", size), size);
+    }
+    candidates_.push_back(std::move(candidate));
+  }
+  if (candidates_.size() == 1) {
+    // Nothing to tune.
+    chosen_pool_ = candidates_[0].pool;
+    chosen_size_ = default_size;
+    candidates_.clear();
+  }
+}
+
+std::shared_ptr<thread::ThreadPool> InterOpThreadPoolTuner::GetPool(
+    int* trial) {
+  mutex_lock l(mu_);
+  if (chosen_pool_ != nullptr) {
+    *trial = -1;
+    return chosen_pool_;
+  }
+  // Interleaving the candidates keeps slow drifts of the step time, e.g.
+  // from input pipelines filling up, from favoring any of them.
+  *trial = next_step_ % candidates_.size();
+  ++next_step_;
+  return candidates_[*trial].pool;
+}
+
+void InterOpThreadPoolTuner::ReportStep(int trial, int64 step_micros) {
+  mutex_lock l(mu_);
+  if (chosen_pool_ != nullptr) return;
+  Candidate& candidate = candidates_[trial];
+  if (candidate.num_reports++ == 0) return;
+  candidate.step_micros.push_back(step_micros);
+  for (const Candidate& c : candidates_) {
+    if (c.step_micros.size() < static_cast<size_t>(steps_per_size_)) return;
+  }
+  Choose();
+}
+
+void InterOpThreadPoolTuner::Choose() {
+  int best = -1;
+  int64 best_median = 0;
+  for (int i = 0; i < candidates_.size(); ++i) {
+    std::vector<int64>& step_micros = candidates_[i].step_micros;
+    auto middle = step_micros.begin() + step_micros.size() / 2;
+    std::nth_element(step_micros.begin(), middle, step_micros.end());
+    VLOG(1) << "Inter-op thread pool of " << sizes_[i]
+            << " threads: median step time " << *middle << "us";
+    if (best == -1 || *middle < best_median) {
+      best = i;
+      best_median = *middle;
+    }
+  }
+  chosen_pool_ = candidates_[best].pool;
+  chosen_size_ = sizes_[best];
+  // Steps still running on the other pools keep them alive until they are
+  // done.
+  candidates_.clear();
+  LOG(INFO) << "Picked an inter-op thread pool of " << chosen_size_
+            << " threads, with a median step time of " << best_median
+            << "us. Set ConfigProto.inter_op_parallelism_threads to "
+            << chosen_size_ << " to skip tuning.";
+}
+
+int32 InterOpThreadPoolTuner::chosen_size() const {
+  mutex_lock l(mu_);
+  return chosen_size_;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,86 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_INTER_OP_THREAD_POOL_TUNER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_INTER_OP_THREAD_POOL_TUNER_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Picks the number of inter-op threads of a session from its first steps.
+// The steps run in turn on pools of a few sizes up to the size of the
+// default pool. Once each size has run `steps_per_size` steps, not counting
+// its first step, which warms up caches and allocators, the size with the
+// lowest median step time is kept for the remaining steps and logged so
+// that it can be pinned with ConfigProto.inter_op_parallelism_threads.
+//
+// Thread-safe: steps may run concurrently.
+class InterOpThreadPoolTuner {
+ public:
+  // `default_pool` serves as the candidate of its own size and must outlive
+  // the tuner. The other candidates are created by the tuner.
+  InterOpThreadPoolTuner(Env* env, thread::ThreadPool* default_pool,
+                         int steps_per_size);
+
+  // Returns the pool to run the next step on. While tuning, sets `*trial` to
+  // the index of the candidate, to be passed to ReportStep(); afterwards,
+  // sets it to -1. Callers hold on to the returned pool until the step is
+  // done, since the candidates that lose are destroyed once they are
+  // released.
+  std::shared_ptr<thread::ThreadPool> GetPool(int* trial);
+
+  // Records that a step of candidate `trial` took `step_micros`.
+  void ReportStep(int trial, int64 step_micros);
+
+  // Returns the sizes of the candidate pools.
+  const std::vector<int32>& sizes() const { return sizes_; }
+
+  // Returns the size picked, or 0 while tuning.
+  int32 chosen_size() const;
+
+ private:
+  struct Candidate {
+    std::shared_ptr<thread::ThreadPool> pool;
+    int64 num_reports = 0;
+    std::vector<int64> step_micros;
+  };
+
+  // Keeps the candidate with the lowest median step time.
+  void Choose() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int steps_per_size_;
+  std::vector<int32> sizes_;
+
+  mutable mutex mu_;
+  std::vector<Candidate> candidates_ GUARDED_BY(mu_);
+  int64 next_step_ GUARDED_BY(mu_) = 0;
+  std::shared_ptr<thread::ThreadPool> chosen_pool_ GUARDED_BY(mu_);
+  int32 chosen_size_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(InterOpThreadPoolTuner);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_INTER_OP_THREAD_POOL_TUNER_H_
@@ -0,0 +1,71 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/inter_op_thread_pool_tuner.h"
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(InterOpThreadPoolTunerTest, CandidateSizes) {
+  thread::ThreadPool pool(Env::Default(), "test", 8);
+  InterOpThreadPoolTuner tuner(Env::Default(), &pool, 3);
+  EXPECT_EQ(std::vector<int32>({2, 4, 8}), tuner.sizes());
+  EXPECT_EQ(0, tuner.chosen_size());
+}
+
+TEST(InterOpThreadPoolTunerTest, NothingToTuneWithOneThread) {
+  thread::ThreadPool pool(Env::Default(), "test", 1);
+  InterOpThreadPoolTuner tuner(Env::Default(), &pool, 3);
+  EXPECT_EQ(1, tuner.chosen_size());
+  int trial;
+  EXPECT_EQ(&pool, tuner.GetPool(&trial).get());
+  EXPECT_EQ(-1, trial);
+}
+
+TEST(InterOpThreadPoolTunerTest, PicksFastestPool) {
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  const int kStepsPerSize = 3;
+  InterOpThreadPoolTuner tuner(Env::Default(), &pool, kStepsPerSize);
+  ASSERT_EQ(std::vector<int32>({1, 2, 4}), tuner.sizes());
+
+  // Steps run fastest on 2 threads, except for warm-up steps and outliers.
+  const int64 kStepMicros[] = {300, 200, 250};
+  for (int step = 0; step < 3 * (kStepsPerSize + 1); ++step) {
+    int trial;
+    std::shared_ptr<thread::ThreadPool> step_pool = tuner.GetPool(&trial);
+    ASSERT_EQ(step % 3, trial);
+    EXPECT_EQ(tuner.sizes()[trial], step_pool->NumThreads());
+    if (trial == 2) EXPECT_EQ(&pool, step_pool.get());
+    int64 micros = kStepMicros[trial];
+    if (step < 3 || step == 4) micros = 1000000;
+    EXPECT_EQ(0, tuner.chosen_size());
+    tuner.ReportStep(trial, micros);
+  }
+  EXPECT_EQ(2, tuner.chosen_size());
+
+  int trial;
+  std::shared_ptr<thread::ThreadPool> chosen_pool = tuner.GetPool(&trial);
+  EXPECT_EQ(-1, trial);
+  EXPECT_EQ(2, chosen_pool->NumThreads());
+  // Reports of steps that were still running are ignored.
+  tuner.ReportStep(0, 1);
+  EXPECT_EQ(2, tuner.chosen_size());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -78,12 +78,14 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
   while (cpu_allocators_.size() <= static_cast<size_t>(numa_node)) {
     // If visitors have been defined we need an Allocator built from
     // a SubAllocator.  Prefer BFCAllocator, but fall back to PoolAllocator
-    // depending on env var setting.
+    // depending on env var setting.  The same goes for NUMA, where each node
+    // needs its own SubAllocator binding memory to the node.
     const bool alloc_visitors_defined =
         (!cpu_alloc_visitors_.empty() || !cpu_free_visitors_.empty());
     bool use_bfc_allocator = false;
-    Status status = ReadBoolFromEnvVar(
-        "TF_CPU_ALLOCATOR_USE_BFC", alloc_visitors_defined, &use_bfc_allocator);
+    Status status = ReadBoolFromEnvVar("TF_CPU_ALLOCATOR_USE_BFC",
+                                       alloc_visitors_defined || numa_enabled_,
+                                       &use_bfc_allocator);
     if (!status.ok()) {
       LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
     }
@@ -62,8 +62,8 @@ class ProcessState {
   // If we know nothing, it's called CPU 0 with no other attributes.
   MemDesc PtrType(const void* ptr);
 
-  // Returns the one CPUAllocator used for the given numa_node.
-  // TEMPORARY: ignores numa_node.
+  // Returns the one CPUAllocator used for the given numa_node.  Ignores
+  // numa_node unless EnableNUMA() has been called.
   Allocator* GetCPUAllocator(int numa_node);
 
   // Registers alloc visitor for the CPU allocator(s).
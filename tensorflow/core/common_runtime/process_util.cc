@@ -22,10 +22,15 @@ limitations under the License.
 #endif  // INTEL_MKL
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/util.h"
@@ -105,4 +110,45 @@ void SchedNonBlockingClosureAfter(int64 micros, std::function<void()> closure) {
   Env::Default()->SchedClosureAfter(micros, std::move(closure));
 }
 
+void ParallelCall(thread::ThreadPool* pool, int64 n,
+                  const std::function<void(int64)>& fn) {
+  if (pool == nullptr || n <= 1) {
+    for (int64 i = 0; i < n; ++i) fn(i);
+    return;
+  }
+  // Shared with the scheduled closures, which may start only after all the
+  // calls are done and this function has returned.
+  struct State {
+    State(int64 n, const std::function<void(int64)>& fn) : n(n), fn(fn) {}
+    const int64 n;
+    const std::function<void(int64)>& fn;
+    std::atomic<int64> next{0};
+    mutex mu;
+    condition_variable all_done;
+    int64 num_done GUARDED_BY(mu) = 0;
+  };
+  auto state = std::make_shared<State>(n, fn);
+  auto work = [state]() {
+    int64 num_done = 0;
+    for (int64 i = state->next.fetch_add(1); i < state->n;
+         i = state->next.fetch_add(1)) {
+      state->fn(i);
+      ++num_done;
+    }
+    if (num_done == 0) return;
+    mutex_lock l(state->mu);
+    state->num_done += num_done;
+    if (state->num_done == state->n) state->all_done.notify_all();
+  };
+  const int64 num_closures = std::min<int64>(n, pool->NumThreads()) - 1;
+  for (int64 i = 0; i < num_closures; ++i) {
+    pool->Schedule(work);
+  }
+  work();
+  mutex_lock l(state->mu);
+  while (state->num_done < n) {
+    state->all_done.wait(l);
+  }
+}
+
 }  // namespace tensorflow
@@ -44,6 +44,14 @@ void SchedClosure(std::function<void()> closure);
 // fixed-size ThreadPool used for non-blocking compute tasks.
 void SchedNonBlockingClosureAfter(int64 micros, std::function<void()> closure);
 
+// Calls fn(0), ..., fn(n - 1) on threads of `pool` and on the calling thread,
+// and returns when all the calls are done. The caller only waits for calls
+// that have started, so this cannot deadlock when the threads of `pool` are
+// busy or when it is called from one of them. Runs everything on the calling
+// thread if `pool` is nullptr.
+void ParallelCall(thread::ThreadPool* pool, int64 n,
+                  const std::function<void(int64)>& fn);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_COMMON_RUNTIME_PROCESS_UTIL_H_
@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/process_util.h"
 
+#include <atomic>
+#include <vector>
+
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -34,5 +37,26 @@ TEST(ProcessUtilTest, ThreadPool) {
   delete pool;
 }
 
+TEST(ProcessUtilTest, ParallelCall) {
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  const std::vector<thread::ThreadPool*> pools = {&pool, nullptr};
+  for (thread::ThreadPool* p : pools) {
+    std::vector<std::atomic<int>> calls(100);
+    for (auto& c : calls) c = 0;
+    ParallelCall(p, calls.size(), [&calls](int64 i) { ++calls[i]; });
+    for (const auto& c : calls) EXPECT_EQ(1, c.load());
+  }
+}
+
+TEST(ProcessUtilTest, ParallelCallFromPoolThread) {
+  // Every thread of the pool calls ParallelCall on the pool itself.
+  thread::ThreadPool pool(Env::Default(), "test", 2);
+  std::atomic<int> calls(0);
+  ParallelCall(&pool, 4, [&pool, &calls](int64) {
+    ParallelCall(&pool, 10, [&calls](int64) { ++calls; });
+  });
+  EXPECT_EQ(40, calls.load());
+}
+
 }  // anonymous namespace
 }  // namespace tensorflow
@@ -98,7 +98,8 @@ RingReducer::RingReducer()
       col_params_(nullptr),
       done_(nullptr),
       group_size_(-1),
-      num_subdivs_(-1) {}
+      num_subdivs_(-1),
+      fp16_wire_(false) {}
 
 RingReducer::~RingReducer() { group_size_tensor_ready_.WaitForNotification(); }
 
@@ -160,6 +161,23 @@ Status RingReducer::InitializeCollectiveParams(CollectiveParams* col_params) {
   // TODO(b/113171733): change CHECKs to return errors.
   CHECK_EQ(col_params->instance.type, REDUCTION_COLLECTIVE);
   CHECK_EQ(col_params->instance.impl_details.collective_name, "RingReduce");
+  const string& wire_format = col_params->instance.wire_format;
+  if (!wire_format.empty()) {
+    if (wire_format != "fp16") {
+      return errors::InvalidArgument("Unknown wire_format ", wire_format,
+                                     " for RingReduce");
+    }
+    if (col_params->instance.data_type != DT_FLOAT) {
+      return errors::InvalidArgument(
+          "wire_format fp16 requires float values but got ",
+          DataTypeString(col_params->instance.data_type));
+    }
+    if (col_params->group.device_type != DEVICE_CPU) {
+      return errors::Unimplemented(
+          "wire_format fp16 is only implemented for CPU devices, not ",
+          col_params->group.device_type);
+    }
+  }
   const string& device_name =
       col_params->instance.device_names[col_params->default_rank];
   // Each subdiv permutation is a ring formed by rotating each
@@ -255,6 +273,12 @@ void RingReducer::Run(StatusCallback done) {
   num_subdivs_ = static_cast<int>(
       col_params_->instance.impl_details.subdiv_permutations.size());
   CHECK_GT(num_subdivs_, 0);
+  fp16_wire_ = false;
+  if (col_params_->instance.wire_format == "fp16") {
+    for (bool is_local : col_params_->task.is_local) {
+      fp16_wire_ |= !is_local;
+    }
+  }
 
   if (VLOG_IS_ON(1)) {
     string buf;
@@ -394,35 +418,10 @@ void RingReducer::Finish(bool ok) {
   done_(s);
 }
 
-RingReducer::SubContext::SubContext(OpKernelContext* ctx,
-                                    OpKernelContext::Params* params,
-                                    OpKernel* op, Tensor* output, Tensor* input)
-    : sub_params_(*params),
-      sub_inputs_({output, input}),
-      sub_input_attr_({ctx->input_alloc_attr(0), ctx->input_alloc_attr(0)}),
-      sub_input_dc_(
-          {ctx->input_device_context(0), ctx->input_device_context(0)}) {
-  sub_params_.op_kernel = op;
-  sub_params_.inputs = &sub_inputs_;
-  sub_params_.input_alloc_attrs = &sub_input_attr_;
-  sub_params_.input_device_contexts = &sub_input_dc_;
-  sub_params_.eigen_gpu_device = nullptr;
-  sub_params_.ensure_eigen_gpu_device();
-  sub_params_.forward_from_array = &forward_from_;
-  sub_ctx_ = new OpKernelContext(&sub_params_, 1);
-}
-
 Status RingReducer::ComputeBinOp(Device* device, OpKernel* op, Tensor* output,
                                  Tensor* input) {
-  // Prepare an OpKernelContext that is identical to that of the original Op
-  // (i.e. the collective), except for the input output sizes and identities and
-  // the Op itself.
-  // TODO(tucker): Is it possible to cache and reuse these objects?  They're
-  // mostly identical inside one device execution.
-  std::unique_ptr<SubContext> sub_ctx(
-      new SubContext(col_ctx_->op_ctx, col_ctx_->op_params, op, output, input));
-  device->Compute(op, sub_ctx->sub_ctx_);
-  return sub_ctx->sub_ctx_->status();
+  return collective_util::ComputeBinOp(col_ctx_->op_ctx, col_ctx_->op_params,
+                                       device, op, output, input);
 }
 
 // At the beginning of the algorithm initialize a RingField struct for
@@ -469,6 +468,12 @@ void RingReducer::InitRingField(RingField* rf, int chunk_idx, int subdiv_idx,
     rf->tmp_chunk = ca_->TempChunk(rf->sc_idx);
     CHECK(rf->tmp_chunk.IsAligned()) << rf->DebugString();
   }
+  if (fp16_wire_ && (rf->do_send || rf->do_recv) &&
+      (rf->send_is_remote || rf->recv_is_remote)) {
+    AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+    rf->wire_chunk = Tensor(col_ctx_->device->GetAllocator(attr), DT_HALF,
+                            rf->chunk.shape());
+  }
   VLOG(2) << this << " InitRingField " << rf->DebugString() << " chunk "
           << ca_->TBounds(rf->chunk);
 }
@@ -513,11 +518,17 @@ void RingReducer::DispatchSend(RingField* rf, const StatusCallback& done) {
   int send_to_rank = (rf->rank + 1) % group_size_;
   int send_to_dev_idx = col_params_->instance.impl_details
                             .subdiv_permutations[rf->subdiv_idx][send_to_rank];
+  Tensor* src_tensor = &rf->chunk;
+  if (fp16_wire_ && rf->send_is_remote) {
+    rf->wire_chunk.flat<Eigen::half>() =
+        rf->chunk.flat<float>().cast<Eigen::half>();
+    src_tensor = &rf->wire_chunk;
+  }
   col_ctx_->col_exec->PostToPeer(
       col_params_->instance.device_names[send_to_dev_idx],
       col_params_->instance.task_names[send_to_dev_idx], send_buf_key,
       col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
-      col_ctx_->op_ctx->output_alloc_attr(0), &rf->chunk,
+      col_ctx_->op_ctx->output_alloc_attr(0), src_tensor,
       col_ctx_->device_locality, done);
 }
 
@@ -532,6 +543,25 @@ void RingReducer::DispatchRecv(RingField* rf, const StatusCallback& done) {
   Tensor* dst_tensor = (!rf->second_pass && (col_params_->merge_op != nullptr))
                            ? &rf->tmp_chunk
                            : &rf->chunk;
+  if (fp16_wire_ && rf->recv_is_remote) {
+    // Receive the halves and widen them once they have arrived.
+    Tensor* wire_tensor = &rf->wire_chunk;
+    col_ctx_->col_exec->RecvFromPeer(
+        col_params_->instance.device_names[rf->recv_dev_idx],
+        col_params_->instance.task_names[rf->recv_dev_idx],
+        col_params_->task.is_local[rf->recv_dev_idx], recv_buf_key,
+        col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->output_alloc_attr(0), wire_tensor,
+        col_ctx_->device_locality, rf->subdiv_idx,
+        [wire_tensor, dst_tensor, done](const Status& s) {
+          if (s.ok()) {
+            dst_tensor->flat<float>() =
+                wire_tensor->flat<Eigen::half>().cast<float>();
+          }
+          done(s);
+        });
+    return;
+  }
   col_ctx_->col_exec->RecvFromPeer(
       col_params_->instance.device_names[rf->recv_dev_idx],
       col_params_->instance.task_names[rf->recv_dev_idx],
@@ -541,6 +571,11 @@ void RingReducer::DispatchRecv(RingField* rf, const StatusCallback& done) {
       col_ctx_->device_locality, rf->subdiv_idx, done);
 }
 
+void RingReducer::RoundToWireFormat(RingField* rf) {
+  rf->chunk.flat<float>() =
+      rf->chunk.flat<float>().cast<Eigen::half>().cast<float>();
+}
+
 string RingReducer::FieldState() {
   string s = strings::StrCat(
       "RingReducer ", strings::Hex(reinterpret_cast<uint64>(this)), " exec ",
@@ -691,6 +726,9 @@ bool RingReducer::RunAsyncParts() {
           ++field_done_count;
           break;  // from do while(!dispatched)
         } else {
+          if (fp16_wire_ && rf->is_final && ca_->ChunkBytes(rf->sc_idx) > 0) {
+            RoundToWireFormat(rf);
+          }
           AdvanceToSecondPass(rf);
         }
       }
@@ -56,23 +56,6 @@ class RingReducer : public CollectiveImplementationInterface {
                       Tensor* input);
   bool RunAsyncParts();
 
-  // Used for executing a sub-operation, e.g. a merge_op instance, with
-  // an OpKernelContext based on the one passed into this Op.
-  class SubContext {
-   public:
-    OpKernelContext::Params sub_params_;
-    gtl::InlinedVector<TensorValue, 4> sub_inputs_;
-    gtl::InlinedVector<AllocatorAttributes, 4> sub_input_attr_;
-    gtl::InlinedVector<DeviceContext*, 4> sub_input_dc_;
-    // Used only for Binary and Unary Ops for which we require
-    // the calculation to be in-place on the first input.
-    int forward_from_ = 0;
-    OpKernelContext* sub_ctx_;
-    SubContext(OpKernelContext* ctx, OpKernelContext::Params* params,
-               OpKernel* op, Tensor* output, Tensor* input);
-    ~SubContext() { delete sub_ctx_; }
-  };
-
   // Current status of a RingField
   enum RingFieldAction {
     RF_INIT = 0,    // Just initialized for a pass
@@ -100,6 +83,7 @@ class RingReducer : public CollectiveImplementationInterface {
     bool is_final = false;  // is the last field in the pass for this rank
     Tensor chunk;           // alias to field values
     Tensor tmp_chunk;
+    Tensor wire_chunk;  // chunk values as sent to or recv'd from other tasks
     Status status;
     string DebugString() const;
   };
@@ -108,6 +92,9 @@ class RingReducer : public CollectiveImplementationInterface {
                      int field_idx);
   void DispatchSend(RingField* rf, const StatusCallback& done);
   void DispatchRecv(RingField* rf, const StatusCallback& done);
+  // Rounds the final value of a field to the wire format, so that the
+  // lossy transfers of the second pass give every device the same result.
+  void RoundToWireFormat(RingField* rf);
 
   // For constructing log messages for debugging.
   string FieldState();
@@ -131,6 +118,8 @@ class RingReducer : public CollectiveImplementationInterface {
   StatusCallback done_;
   int group_size_;
   int num_subdivs_;
+  // True if chunks sent between tasks are converted to halves.
+  bool fp16_wire_;
   Tensor group_size_tensor_;
   Notification group_size_tensor_ready_;
   std::unique_ptr<CollectiveAdapter> ca_;
@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/public/version.h"
 
@@ -70,10 +71,11 @@ class FailTestRMA : public CollectiveRemoteAccessLocal {
                     int dev_to_dev_stream_index,
                     const StatusCallback& done) override {
     if (MaybeFail(done)) return;
+    // Every peer is in this process, even those a test treats as remote.
     CollectiveRemoteAccessLocal::RecvFromPeer(
-        peer_device, peer_task, peer_is_local, key, to_device, to_device_ctx,
-        to_alloc_attr, to_tensor, client_locality, dev_to_dev_stream_index,
-        done);
+        peer_device, peer_task, true /*peer_is_local*/, key, to_device,
+        to_device_ctx, to_alloc_attr, to_tensor, client_locality,
+        dev_to_dev_stream_index, done);
   }
 
   void PostToPeer(const string& peer_device, const string& peer_task,
@@ -203,6 +205,7 @@ class RingReducerTest : public ::testing::Test {
     col_params_.instance.type = REDUCTION_COLLECTIVE;
     col_params_.instance.impl_details.collective_name = "RingReduce";
     col_params_.instance.data_type = dtype;
+    col_params_.instance.wire_format = wire_format_;
     col_params_.instance.impl_details.subdiv_permutations.resize(num_subdivs);
     col_params_.subdiv_rank.resize(num_subdivs);
     int subdiv_stride = num_devices / num_subdivs;
@@ -240,8 +243,9 @@ class RingReducerTest : public ::testing::Test {
         col_params_.instance.device_names.push_back(dev_name);
         col_params_.instance.task_names.push_back(task_name);
         // Normally each device would set is_local to its own perspective but
-        // this test runs in a single process so is_local is always true.
-        col_params_.task.is_local.push_back(true);
+        // this test runs in a single process so is_local is always true,
+        // unless the test needs transfers in the wire format.
+        col_params_.task.is_local.push_back(wire_format_.empty());
         for (int sdi = 0; sdi < num_subdivs; ++sdi) {
           int rotated_di =
               (di + col_params_.instance.impl_details.subdiv_offsets[sdi]) %
@@ -394,6 +398,14 @@ class RingReducerTest : public ::testing::Test {
     reducer.group_size_tensor_ready_.Notify();  // To unblock destructor.
   }
 
+  Status InitializeParams(CollectiveParams* cp) {
+    cp->instance.impl_details.subdiv_permutations.clear();
+    cp->subdiv_rank.clear();
+    RingReducer reducer;
+    reducer.group_size_tensor_ready_.Notify();  // To unblock destructor.
+    return reducer.InitializeCollectiveParams(cp);
+  }
+
   class DeviceInstance {
    public:
     DeviceInstance(int rank, const string& dev_name,
@@ -536,6 +548,7 @@ class RingReducerTest : public ::testing::Test {
   };
 
   bool stop_ = false;
+  string wire_format_;
   DeviceType device_type_;
   TestCollectiveExecutorMgr col_exec_mgr_;
   CollectiveExecutor* col_exec_;
@@ -650,6 +663,83 @@ TEST_F(RingReducerTest, AutomaticSubdivUpperBound) {
   RunSubdivPermsTest(&cp, {{0, 1, 2, 3}, {0, 1, 2, 3}}, {0, 0});
 }
 
+TEST_F(RingReducerTest, InitializeParamsChecksWireFormat) {
+  CollectiveParams cp = SetUpCollectiveParams(2, 2);
+  cp.default_rank = 0;
+  cp.instance.wire_format = "int8";
+  EXPECT_TRUE(errors::IsInvalidArgument(InitializeParams(&cp)));
+  // SetUpCollectiveParams uses GPU devices.
+  cp.instance.wire_format = "fp16";
+  EXPECT_TRUE(errors::IsUnimplemented(InitializeParams(&cp)));
+  cp.instance.data_type = DT_DOUBLE;
+  EXPECT_TRUE(errors::IsInvalidArgument(InitializeParams(&cp)));
+  cp.instance.data_type = DT_FLOAT;
+  cp.group.device_type = DEVICE_CPU;
+  TF_EXPECT_OK(InitializeParams(&cp));
+}
+
+TEST_F(RingReducerTest, Fp16WireFormat) {
+  wire_format_ = "fp16";
+  const int kNumWorkers = 2;
+  const int kNumDevices = 2;
+  const int kNumDevs = kNumWorkers * kNumDevices;
+  const int kTensorLen = 1001;
+  Init(kNumWorkers, kNumDevices, DT_FLOAT, DEVICE_CPU, 1, 0);
+  std::vector<float> expected(kTensorLen, 0.0f);
+  for (int di = 0; di < kNumDevs; ++di) {
+    instances_[di]->InitTensor(
+        DT_FLOAT, TensorShape({kTensorLen}), [&expected, di](Tensor* t) {
+          for (int i = 0; i < kTensorLen; ++i) {
+            // Small integers, whose partial sums are exact in halves.
+            float value = (di + 1) * (i % 16);
+            t->flat<float>()(i) = value;
+            expected[i] += value / kNumDevs;
+          }
+        });
+  }
+  Reduce(0);
+  for (int di = 0; di < kNumDevs; ++di) {
+    TF_EXPECT_OK(instances_[di]->status_);
+    const Tensor& actual = instances_[di]->tensor();
+    for (int i = 0; i < kTensorLen; ++i) {
+      EXPECT_EQ(expected[i], actual.flat<float>()(i))
+          << "Mismatch at device " << di << " index " << i;
+    }
+  }
+}
+
+TEST_F(RingReducerTest, Fp16WireFormatGivesEveryDeviceTheSameResult) {
+  wire_format_ = "fp16";
+  const int kNumWorkers = 2;
+  const int kNumDevices = 2;
+  const int kNumDevs = kNumWorkers * kNumDevices;
+  const int kTensorLen = 1001;
+  Init(kNumWorkers, kNumDevices, DT_FLOAT, DEVICE_CPU, 1, 0);
+  std::vector<float> expected(kTensorLen, 0.0f);
+  for (int di = 0; di < kNumDevs; ++di) {
+    instances_[di]->InitTensor(
+        DT_FLOAT, TensorShape({kTensorLen}), [&expected, di](Tensor* t) {
+          for (int i = 0; i < kTensorLen; ++i) {
+            float value = (di + 1) * (i + 1) / 3.0f;
+            t->flat<float>()(i) = value;
+            expected[i] += value / kNumDevs;
+          }
+        });
+  }
+  Reduce(0);
+  const Tensor& first = instances_[0]->tensor();
+  for (int di = 0; di < kNumDevs; ++di) {
+    TF_EXPECT_OK(instances_[di]->status_);
+    const Tensor& actual = instances_[di]->tensor();
+    for (int i = 0; i < kTensorLen; ++i) {
+      EXPECT_EQ(first.flat<float>()(i), actual.flat<float>()(i))
+          << "Mismatch at device " << di << " index " << i;
+      EXPECT_NEAR(expected[i], actual.flat<float>()(i), expected[i] * 4e-3)
+          << "Mismatch at device " << di << " index " << i;
+    }
+  }
+}
+
 // TODO(b/113171733): change to use TEST_P.
 #define DEF_TEST(B, T, W, D, S, L, A)                                         \
   TEST_F(RingReducerTest,                                                     \
@@ -725,4 +815,49 @@ DEF_TEST(FLOAT, GPU, 1, 8, 1, 9408, 2)
 DEF_TEST(FLOAT, GPU, 1, 8, 2, 9408, 5)
 #endif
 
+#ifndef GOOGLE_CUDA
+// Drives the RingReducerTest fixture from benchmarks, which compare
+// reducing many small tensors one collective at a time against reducing
+// them packed into a single buffer, as ScopedAllocatorOptimizer does.
+class RingReducerBenchmark : public RingReducerTest {
+ public:
+  void TestBody() override {}
+
+  void Run(int iters, int num_devices, int num_tensors, int tensor_len,
+           bool fused) {
+    testing::StopTiming();
+    Init(1 /*num_workers*/, num_devices, DT_FLOAT, DEVICE_CPU,
+         1 /*num_subdivs*/, 0 /*fail_after*/);
+    const int64 len = fused ? static_cast<int64>(num_tensors) * tensor_len
+                            : static_cast<int64>(tensor_len);
+    const int num_reductions = fused ? 1 : num_tensors;
+    for (DeviceInstance* di : instances_) {
+      di->InitTensor(DT_FLOAT, TensorShape({len}),
+                     [](Tensor* t) { t->flat<float>().setConstant(1.0f); });
+    }
+    testing::BytesProcessed(static_cast<int64>(iters) * num_tensors *
+                            tensor_len * sizeof(float));
+    testing::StartTiming();
+    for (int i = 0; i < iters; ++i) {
+      for (int r = 0; r < num_reductions; ++r) {
+        Reduce(0 /*fail_after*/);
+      }
+    }
+    testing::StopTiming();
+  }
+};
+
+static void BM_RingReduceUnfused(int iters, int num_tensors, int tensor_len) {
+  RingReducerBenchmark benchmark;
+  benchmark.Run(iters, 4 /*num_devices*/, num_tensors, tensor_len, false);
+}
+BENCHMARK(BM_RingReduceUnfused)->RangePair(1, 256, 64, 16384);
+
+static void BM_RingReduceFused(int iters, int num_tensors, int tensor_len) {
+  RingReducerBenchmark benchmark;
+  benchmark.Run(iters, 4 /*num_devices*/, num_tensors, tensor_len, true);
+}
+BENCHMARK(BM_RingReduceFused)->RangePair(1, 256, 64, 16384);
+#endif
+
 }  // namespace tensorflow
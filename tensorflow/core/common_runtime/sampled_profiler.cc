@@ -0,0 +1,244 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/sampled_profiler.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+constexpr int SampledProfiler::kMaxOpTypeLength;
+constexpr int SampledProfiler::kBufferSize;
+
+struct SampledProfiler::ThreadState {
+  // The id of the profiler that `buffer` belongs to.
+  uint64 profiler_id = 0;
+  ThreadBuffer* buffer = nullptr;
+  // The number of kernels to skip before the next sample.
+  int64 countdown = 0;
+  // Set by `IsEnabledForActivities()` for the activity that is sampled.
+  bool sampled = false;
+};
+
+// Records the execution time of a sampled kernel when it is destroyed.
+class SampledProfiler::ActivityHandle : public tracing::TraceCollector::Handle {
+ public:
+  ActivityHandle(const SampledProfiler* profiler, StringPiece op_type)
+      : profiler_(profiler),
+        // The label passed to `CreateActivityHandle()` may not outlive the
+        // activity, so copy the op type.
+        op_type_length_(
+            std::min<size_t>(op_type.size(), kMaxOpTypeLength - 1)),
+        start_micros_(profiler->env_->NowMicros()) {
+    memcpy(op_type_, op_type.data(), op_type_length_);
+  }
+
+  ~ActivityHandle() override {
+    profiler_->Record(StringPiece(op_type_, op_type_length_),
+                      profiler_->env_->NowMicros() - start_micros_);
+  }
+
+ private:
+  const SampledProfiler* const profiler_;
+  char op_type_[kMaxOpTypeLength];
+  const size_t op_type_length_;
+  const uint64 start_micros_;
+};
+
+namespace {
+
+std::atomic<uint64> next_profiler_id{1};
+
+}  // namespace
+
+SampledProfiler::SampledProfiler(Env* env, int64 sampling_interval,
+                                 int64 export_interval_micros)
+    : env_(env),
+      sampling_interval_(std::max<int64>(1, sampling_interval)),
+      export_interval_micros_(export_interval_micros),
+      id_(next_profiler_id++) {
+  if (export_interval_micros_ > 0) {
+    export_thread_.reset(env_->StartThread(
+        {}, "sampled_profiler_export", [this]() { ExportLoop(); }));
+  }
+}
+
+SampledProfiler::~SampledProfiler() {
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    cancelled_cond_var_.notify_all();
+  }
+  export_thread_.reset();
+}
+
+SampledProfiler* SampledProfiler::Global() {
+  static SampledProfiler* global_profiler = []() -> SampledProfiler* {
+    int64 sampling_interval;
+    Status s = ReadInt64FromEnvVar("TF_SAMPLED_PROFILER_INTERVAL", 0,
+                                   &sampling_interval);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return nullptr;
+    }
+    if (sampling_interval <= 0) {
+      return nullptr;
+    }
+    int64 export_secs;
+    s = ReadInt64FromEnvVar("TF_SAMPLED_PROFILER_EXPORT_SECS", 60,
+                            &export_secs);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      export_secs = 60;
+    }
+    SampledProfiler* profiler = new SampledProfiler(
+        Env::Default(), sampling_interval, export_secs * 1000000);
+    tracing::SetTraceCollector(profiler);
+    LOG(INFO) << "Sampling the execution time of one in " << sampling_interval
+              << " op kernels";
+    return profiler;
+  }();
+  return global_profiler;
+}
+
+SampledProfiler::ThreadState* SampledProfiler::GetThreadState() const {
+  static thread_local ThreadState state;
+  if (state.profiler_id != id_) {
+    // Spread the first samples of the threads over the interval.
+    state = ThreadState();
+    state.profiler_id = id_;
+    state.countdown = 1 + (id_ + reinterpret_cast<uintptr_t>(&state) / 64) %
+                              sampling_interval_;
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer);
+    state.buffer = buffer.get();
+    mutex_lock l(buffers_mu_);
+    buffers_.push_back(std::move(buffer));
+  }
+  return &state;
+}
+
+bool SampledProfiler::IsEnabledForActivities(bool is_expensive) const {
+  ThreadState* state = GetThreadState();
+  if (--state->countdown > 0) {
+    return false;
+  }
+  state->countdown = sampling_interval_;
+  state->sampled = true;
+  return true;
+}
+
+std::unique_ptr<tracing::TraceCollector::Handle>
+SampledProfiler::CreateActivityHandle(StringPiece name_part1,
+                                      StringPiece name_part2,
+                                      bool is_expensive) const {
+  ThreadState* state = GetThreadState();
+  if (!state->sampled) {
+    // The activity was not sampled by `IsEnabledForActivities()`.
+    return nullptr;
+  }
+  state->sampled = false;
+  // The executor labels kernels with "<node name>:<op type>#id=<step id>#".
+  StringPiece op_type = name_part2.empty() ? name_part1 : name_part2;
+  op_type = op_type.substr(0, op_type.find('#'));
+  return std::unique_ptr<Handle>(new ActivityHandle(this, op_type));
+}
+
+void SampledProfiler::Record(StringPiece op_type, int64 micros) const {
+  ThreadBuffer* buffer = GetThreadState()->buffer;
+  const uint64 head = buffer->head.load(std::memory_order_relaxed);
+  if (head - buffer->tail.load(std::memory_order_acquire) >= kBufferSize) {
+    ++num_dropped_samples_;
+    return;
+  }
+  Sample& sample = buffer->samples[head % kBufferSize];
+  const size_t length =
+      std::min<size_t>(op_type.size(), kMaxOpTypeLength - 1);
+  memcpy(sample.op_type, op_type.data(), length);
+  sample.op_type[length] = '\0';
+  sample.micros = micros;
+  buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void SampledProfiler::Collect() {
+  std::vector<ThreadBuffer*> buffers;
+  {
+    mutex_lock l(buffers_mu_);
+    for (const auto& buffer : buffers_) {
+      buffers.push_back(buffer.get());
+    }
+  }
+  mutex_lock l(mu_);
+  for (ThreadBuffer* buffer : buffers) {
+    const uint64 tail = buffer->tail.load(std::memory_order_relaxed);
+    const uint64 head = buffer->head.load(std::memory_order_acquire);
+    for (uint64 i = tail; i < head; ++i) {
+      const Sample& sample = buffer->samples[i % kBufferSize];
+      std::unique_ptr<histogram::Histogram>& histogram =
+          histograms_[sample.op_type];
+      if (!histogram) {
+        histogram.reset(new histogram::Histogram);
+      }
+      histogram->Add(sample.micros);
+    }
+    buffer->tail.store(head, std::memory_order_release);
+  }
+}
+
+std::map<string, HistogramProto> SampledProfiler::GetHistograms() const {
+  mutex_lock l(mu_);
+  std::map<string, HistogramProto> result;
+  for (const auto& it : histograms_) {
+    it.second->EncodeToProto(&result[it.first],
+                             false /* preserve_zero_buckets */);
+  }
+  return result;
+}
+
+void SampledProfiler::ExportLoop() {
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      const uint64 deadline_micros =
+          env_->NowMicros() + export_interval_micros_;
+      while (!cancelled_ && env_->NowMicros() < deadline_micros) {
+        cancelled_cond_var_.wait_for(
+            l, std::chrono::microseconds(deadline_micros - env_->NowMicros()));
+      }
+      if (cancelled_) {
+        return;
+      }
+    }
+    Collect();
+    string summary;
+    for (const auto& it : GetHistograms()) {
+      const HistogramProto& histogram = it.second;
+      strings::StrAppend(&summary, "\n  ", it.first, ": ", histogram.num(),
+                         " samples, ", histogram.sum() / histogram.num(),
+                         "us average, ", histogram.max(), "us max");
+    }
+    if (!summary.empty()) {
+      LOG(INFO) << "Sampled op kernel execution times (one in "
+                << sampling_interval_ << " kernels, " << num_dropped_samples_
+                << " samples dropped):" << summary;
+    }
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,133 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_SAMPLED_PROFILER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_SAMPLED_PROFILER_H_
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/lib/histogram/histogram.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/tracing.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A `tracing::TraceCollector` that records the execution time of one in
+// `sampling_interval` op kernels run by each executor thread, and aggregates
+// them into a histogram per op type. Unlike collecting `StepStats`, it does not
+// allocate per node and its cost for the kernels that are not sampled is a
+// thread-local counter, so it can stay enabled in production.
+//
+// Each thread records its samples into a preallocated ring buffer that only it
+// writes, and `Collect()` drains the buffers of all threads into the
+// histograms. Samples are dropped while the buffer of a thread is full.
+//
+// Only synchronous kernels whose execution the executor traces through
+// `tracing::ScopedActivity` are sampled.
+class SampledProfiler : public tracing::TraceCollector {
+ public:
+  // If `export_interval_micros` is positive, a background thread collects
+  // the samples and logs the histograms at that interval.
+  SampledProfiler(Env* env, int64 sampling_interval,
+                  int64 export_interval_micros);
+  ~SampledProfiler() override;
+
+  // Returns the profiler of the process, or nullptr if it is disabled, and
+  // registers it as the trace collector on the first call.
+  //
+  // The profiler samples one in TF_SAMPLED_PROFILER_INTERVAL kernels and is
+  // disabled if the variable is unset or 0. It logs the histograms every
+  // TF_SAMPLED_PROFILER_EXPORT_SECS seconds, 60 by default.
+  static SampledProfiler* Global();
+
+  std::unique_ptr<Handle> CreateAnnotationHandle(
+      StringPiece name_part1, StringPiece name_part2) const override {
+    return nullptr;
+  }
+  std::unique_ptr<Handle> CreateActivityHandle(
+      StringPiece name_part1, StringPiece name_part2,
+      bool is_expensive) const override;
+  bool IsEnabledForAnnotations() const override { return false; }
+  bool IsEnabledForActivities(bool is_expensive) const override;
+
+  // Moves the samples recorded by all threads into the histograms.
+  void Collect() LOCKS_EXCLUDED(mu_);
+
+  // Returns the histograms of the sampled execution times, in microseconds,
+  // by op type. Call `Collect()` first to include the latest samples.
+  std::map<string, HistogramProto> GetHistograms() const LOCKS_EXCLUDED(mu_);
+
+  // Returns the number of samples dropped because a buffer was full.
+  int64 num_dropped_samples() const { return num_dropped_samples_; }
+
+ private:
+  class ActivityHandle;
+
+  static constexpr int kMaxOpTypeLength = 48;
+  static constexpr int kBufferSize = 1024;
+
+  struct Sample {
+    char op_type[kMaxOpTypeLength];
+    int64 micros;
+  };
+
+  // A single-producer single-consumer ring of samples. `head` is only
+  // advanced by the thread recording the samples, and `tail` by `Collect()`.
+  struct ThreadBuffer {
+    Sample samples[kBufferSize];
+    std::atomic<uint64> head{0};
+    std::atomic<uint64> tail{0};
+  };
+
+  struct ThreadState;
+
+  // Returns the state of the calling thread for this profiler.
+  ThreadState* GetThreadState() const;
+
+  void Record(StringPiece op_type, int64 micros) const;
+
+  void ExportLoop();
+
+  Env* const env_;
+  const int64 sampling_interval_;
+  const int64 export_interval_micros_;
+  // Distinguishes the profilers, so that threads notice when the profiler
+  // their state was created for is replaced.
+  const uint64 id_;
+
+  mutable mutex buffers_mu_;
+  mutable std::vector<std::unique_ptr<ThreadBuffer>> buffers_
+      GUARDED_BY(buffers_mu_);
+  mutable std::atomic<int64> num_dropped_samples_{0};
+
+  mutable mutex mu_;
+  std::map<string, std::unique_ptr<histogram::Histogram>> histograms_
+      GUARDED_BY(mu_);
+  condition_variable cancelled_cond_var_;
+  bool cancelled_ GUARDED_BY(mu_) = false;
+  std::unique_ptr<Thread> export_thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SampledProfiler);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_SAMPLED_PROFILER_H_
@@ -0,0 +1,98 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/sampled_profiler.h"
+
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Runs `num_kernels` activities the way the executor traces kernels, and
+// returns the number of them that were sampled.
+int RunKernels(const SampledProfiler& profiler, const string& op_type,
+               int num_kernels) {
+  int num_sampled = 0;
+  for (int i = 0; i < num_kernels; ++i) {
+    if (!profiler.IsEnabledForActivities(/*is_expensive=*/true)) {
+      continue;
+    }
+    auto handle = profiler.CreateActivityHandle(
+        "node", strings::StrCat(op_type, "#id=1#"), /*is_expensive=*/true);
+    if (handle) {
+      ++num_sampled;
+    }
+  }
+  return num_sampled;
+}
+
+TEST(SampledProfilerTest, SamplesOneInInterval) {
+  SampledProfiler profiler(Env::Default(), 10,
+                           /*export_interval_micros=*/0);
+  EXPECT_EQ(5, RunKernels(profiler, "MatMul", 50));
+  EXPECT_EQ(3, RunKernels(profiler, "MatMul", 30));
+}
+
+TEST(SampledProfilerTest, IgnoresActivitiesNotSampled) {
+  SampledProfiler profiler(Env::Default(), 1000000,
+                           /*export_interval_micros=*/0);
+  EXPECT_EQ(nullptr, profiler.CreateActivityHandle("node", "MatMul#id=1#",
+                                                   /*is_expensive=*/true));
+}
+
+TEST(SampledProfilerTest, HistogramsByOpType) {
+  SampledProfiler profiler(Env::Default(), 1,
+                           /*export_interval_micros=*/0);
+  RunKernels(profiler, "MatMul", 4);
+  RunKernels(profiler, "Add", 2);
+  profiler.Collect();
+  std::map<string, HistogramProto> histograms = profiler.GetHistograms();
+  ASSERT_EQ(2, histograms.size());
+  EXPECT_EQ(4, histograms["MatMul"].num());
+  EXPECT_EQ(2, histograms["Add"].num());
+  EXPECT_EQ(0, profiler.num_dropped_samples());
+
+  // Collecting again only adds the new samples.
+  RunKernels(profiler, "Add", 1);
+  profiler.Collect();
+  EXPECT_EQ(3, profiler.GetHistograms()["Add"].num());
+}
+
+TEST(SampledProfilerTest, DropsSamplesWhileBufferIsFull) {
+  SampledProfiler profiler(Env::Default(), 1,
+                           /*export_interval_micros=*/0);
+  RunKernels(profiler, "MatMul", 1500);
+  profiler.Collect();
+  EXPECT_EQ(1024, profiler.GetHistograms()["MatMul"].num());
+  EXPECT_EQ(1500 - 1024, profiler.num_dropped_samples());
+
+  // The buffer can be reused once it has been collected.
+  RunKernels(profiler, "MatMul", 10);
+  profiler.Collect();
+  EXPECT_EQ(1034, profiler.GetHistograms()["MatMul"].num());
+}
+
+TEST(SampledProfilerTest, TruncatesLongOpTypes) {
+  SampledProfiler profiler(Env::Default(), 1,
+                           /*export_interval_micros=*/0);
+  RunKernels(profiler, string(100, 'a'), 1);
+  profiler.Collect();
+  std::map<string, HistogramProto> histograms = profiler.GetHistograms();
+  ASSERT_EQ(1, histograms.size());
+  EXPECT_EQ(string(47, 'a'), histograms.begin()->first);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,12 +15,15 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/shape_refiner.h"
 
 #include <deque>
+#include <map>
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/eval_const_tensor.h"
 #include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
@@ -30,7 +33,11 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/public/session.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -58,6 +65,186 @@ ShapeRefiner::~ShapeRefiner() {
 namespace {
 
 constexpr char kArgOp[] = "_Arg";
+
+// Keys longer than this, e.g. of nodes with large attributes, are not cached.
+constexpr size_t kMaxShapeFnCacheKeySize = 16 * 1024;
+
+// A shape in the shape inference cache. The known dimensions are stored as
+// their value, and the unknown ones as -1 - i for the i-th distinct unknown
+// dimension of the outputs of the node, so that the result of the shape
+// function is restored with the same unknown dimensions shared between
+// outputs.
+struct CachedShape {
+  bool rank_known = false;
+  std::vector<int64> dims;
+};
+
+struct CachedShapeFnResult {
+  std::vector<CachedShape> outputs;
+  // The shapes and types of the handles of the outputs, empty for the outputs
+  // without handle data.
+  std::vector<std::vector<std::pair<CachedShape, DataType>>> handle_data;
+  std::vector<bool> has_handle_data;
+  // The time the shape function took, which a hit in the cache saves.
+  uint64 run_time_usecs = 0;
+};
+
+// The results of shape functions, by op, attributes and input shapes, shared
+// by all the ShapeRefiners of the process. Only the results of shape functions
+// that depend on nothing else, in particular not on the value of their inputs,
+// are cached.
+class ShapeFnCache {
+ public:
+  static ShapeFnCache* Global() {
+    static ShapeFnCache* cache = [] {
+      // The maximum number of results in the cache, 0 to disable it.
+      int64 capacity;
+      TF_CHECK_OK(ReadInt64FromEnvVar("TF_SHAPE_INFERENCE_CACHE_SIZE",
+                                      100000, &capacity));
+      return new ShapeFnCache(capacity);
+    }();
+    return cache;
+  }
+
+  bool enabled() const { return capacity_ > 0; }
+
+  bool Lookup(const string& key, CachedShapeFnResult* result) {
+    mutex_lock l(mu_);
+    auto it = results_.find(key);
+    if (it == results_.end()) return false;
+    *result = it->second;
+    return true;
+  }
+
+  // Once the cache is full, new results are dropped: the results of the
+  // first graphs of a process are the most likely to be seen again.
+  void Insert(const string& key, CachedShapeFnResult result) {
+    mutex_lock l(mu_);
+    if (static_cast<int64>(results_.size()) < capacity_) {
+      results_.emplace(key, std::move(result));
+    }
+  }
+
+ private:
+  explicit ShapeFnCache(int64 capacity) : capacity_(capacity) {}
+
+  const int64 capacity_;
+  mutex mu_;
+  std::unordered_map<string, CachedShapeFnResult> results_ GUARDED_BY(mu_);
+};
+
+void AppendShapeToKey(InferenceContext* c, ShapeHandle s, string* key) {
+  strings::StrAppend(key, "[");
+  for (int i = 0; i < c->Rank(s); ++i) {
+    strings::StrAppend(key, c->Value(c->Dim(s, i)), ",");
+  }
+  strings::StrAppend(key, "]");
+}
+
+// Computes the key of the result of the shape function of `node` in the
+// ShapeFnCache. Returns false if the result can't be cached because some
+// input shape isn't fully defined: the shape function could then relate its
+// output dimensions to the unknown input ones, which the cache can't
+// represent.
+bool GetShapeFnCacheKey(const Node* node, int graph_def_version,
+                        InferenceContext* c, string* key) {
+  if (c->num_inputs() == 0) return false;
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    if (!c->FullyDefined(c->input(i))) return false;
+    const auto* handle_data = c->input_handle_shapes_and_types(i);
+    if (handle_data == nullptr) continue;
+    for (const ShapeAndType& shape_and_type : *handle_data) {
+      if (!c->FullyDefined(shape_and_type.shape)) return false;
+    }
+  }
+
+  *key = strings::StrCat(node->type_string(), ";", graph_def_version, ";");
+  const std::map<string, AttrValue> attrs(node->def().attr().begin(),
+                                          node->def().attr().end());
+  string serialized;
+  for (const auto& attr : attrs) {
+    SerializeToStringDeterministic(attr.second, &serialized);
+    strings::StrAppend(key, attr.first, "=", serialized.size(), ":",
+                       serialized, ";");
+    if (key->size() > kMaxShapeFnCacheKeySize) return false;
+  }
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    AppendShapeToKey(c, c->input(i), key);
+    const auto* handle_data = c->input_handle_shapes_and_types(i);
+    if (handle_data == nullptr) continue;
+    strings::StrAppend(key, "{");
+    for (const ShapeAndType& shape_and_type : *handle_data) {
+      strings::StrAppend(key, static_cast<int>(shape_and_type.dtype));
+      AppendShapeToKey(c, shape_and_type.shape, key);
+    }
+    strings::StrAppend(key, "}");
+  }
+  return key->size() <= kMaxShapeFnCacheKeySize;
+}
+
+// Stores the output shapes and handle data of `c` in `result`.
+void SaveShapeFnResult(InferenceContext* c, CachedShapeFnResult* result) {
+  std::unordered_map<std::size_t, int> unknown_dims;
+  auto save_shape = [c, &unknown_dims](ShapeHandle s) {
+    CachedShape cached;
+    cached.rank_known = c->RankKnown(s);
+    for (int i = 0; i < c->Rank(s); ++i) {
+      DimensionHandle d = c->Dim(s, i);
+      if (c->ValueKnown(d)) {
+        cached.dims.push_back(c->Value(d));
+      } else {
+        auto it = unknown_dims.emplace(d.Handle(), unknown_dims.size()).first;
+        cached.dims.push_back(-1 - it->second);
+      }
+    }
+    return cached;
+  };
+  result->outputs.clear();
+  result->handle_data.assign(c->num_outputs(), {});
+  result->has_handle_data.assign(c->num_outputs(), false);
+  for (int i = 0; i < c->num_outputs(); ++i) {
+    result->outputs.push_back(save_shape(c->output(i)));
+    const auto* handle_data = c->output_handle_shapes_and_types(i);
+    if (handle_data == nullptr) continue;
+    result->has_handle_data[i] = true;
+    for (const ShapeAndType& shape_and_type : *handle_data) {
+      result->handle_data[i].emplace_back(save_shape(shape_and_type.shape),
+                                          shape_and_type.dtype);
+    }
+  }
+}
+
+// Sets the output shapes and handle data of `c` from `result`.
+void RestoreShapeFnResult(const CachedShapeFnResult& result,
+                          InferenceContext* c) {
+  std::vector<DimensionHandle> unknown_dims;
+  auto restore_shape = [c, &unknown_dims](const CachedShape& cached) {
+    if (!cached.rank_known) return c->UnknownShape();
+    std::vector<DimensionHandle> dims;
+    for (int64 d : cached.dims) {
+      if (d >= 0) {
+        dims.push_back(c->MakeDim(d));
+        continue;
+      }
+      const int id = -1 - d;
+      while (unknown_dims.size() <= id) {
+        unknown_dims.push_back(c->UnknownDim());
+      }
+      dims.push_back(unknown_dims[id]);
+    }
+    return c->MakeShape(dims);
+  };
+  for (int i = 0; i < result.outputs.size(); ++i) {
+    c->set_output(i, restore_shape(result.outputs[i]));
+    if (!result.has_handle_data[i]) continue;
+    std::vector<ShapeAndType> handle_data;
+    for (const auto& shape_and_type : result.handle_data[i]) {
+      handle_data.emplace_back(restore_shape(shape_and_type.first),
+                               shape_and_type.second);
+    }
+    c->set_output_handle_shapes_and_types(i, handle_data);
+  }
+}
 constexpr char kRetvalOp[] = "_Retval";
 
 // Runs shape inference for the given node using the given ShapeRefiner.
@@ -633,6 +820,31 @@ Status ShapeRefiner::RunShapeFn(const Node* node,
   c->set_input_tensors(input_tensors);
   c->set_input_tensors_as_shapes(input_tensors_as_shapes);
 
+  // The results of function ops depend on the function library, and those
+  // of ops of other registries than the global one may come from different
+  // shape functions, so neither are cached.
+  ShapeFnCache* cache = ShapeFnCache::Global();
+  string cache_key;
+  bool cacheable = false;
+  if (cache->enabled() && !op_reg_data->is_function_op &&
+      GetShapeFnCacheKey(node, graph_def_version_, c, &cache_key)) {
+    const OpRegistrationData* global_op_reg_data;
+    cacheable = OpRegistry::Global()
+                    ->LookUp(node->type_string(), &global_op_reg_data)
+                    .ok() &&
+                global_op_reg_data == op_reg_data;
+  }
+  if (cacheable) {
+    CachedShapeFnResult result;
+    if (cache->Lookup(cache_key, &result)) {
+      RestoreShapeFnResult(result, c);
+      metrics::RecordShapeInferenceCacheLookup(true, result.run_time_usecs);
+      return Status::OK();
+    }
+    metrics::RecordShapeInferenceCacheLookup(false, 0);
+  }
+  const uint64 start_time_usecs = Env::Default()->NowMicros();
+
   // Run the shape inference function, and return if there was an error.
   // Capture as lambda, because we might need to re-run inference later on.
   auto run_inference_lambda = [&]() {
@@ -718,6 +930,21 @@ Status ShapeRefiner::RunShapeFn(const Node* node,
     }
   } while (rerun_shape_fn);
 
+  if (cacheable) {
+    for (int i = 0; i < c->num_inputs(); ++i) {
+      if (c->requested_input_tensor(i) ||
+          c->requested_input_tensor_as_partial_shape(i)) {
+        cacheable = false;
+      }
+    }
+  }
+  if (cacheable) {
+    CachedShapeFnResult result;
+    SaveShapeFnResult(c, &result);
+    result.run_time_usecs = Env::Default()->NowMicros() - start_time_usecs;
+    cache->Insert(cache_key, std::move(result));
+  }
+
   return Status::OK();
 }
 
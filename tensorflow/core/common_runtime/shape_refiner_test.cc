@@ -379,6 +379,51 @@ TEST_F(ShapeRefinerTest, InputTensorDependencies) {
 
 namespace {
 
+int num_cached_shape_fn_runs = 0;
+
+// An op whose outputs share an unknown dimension.
+REGISTER_OP("CachedShapeFn")
+    .Input("a: float")
+    .Output("o: float")
+    .Output("p: float")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      ++num_cached_shape_fn_runs;
+      shape_inference::DimensionHandle unknown = c->UnknownDim();
+      c->set_output(0, c->MakeShape({c->Dim(c->input(0), 0), unknown}));
+      c->set_output(1, c->Vector(unknown));
+      return Status::OK();
+    });
+
+}  // namespace
+
+TEST_F(ShapeRefinerTest, ShapeFnResultsAreCachedAcrossRefiners) {
+  auto add_node = [this](const TensorShape& shape, int expected_runs,
+                         const string& expected_shape) {
+    Graph graph(OpRegistry::Global());
+    Node* input = test::graph::Constant(&graph, Tensor(DT_FLOAT, shape));
+    Node* node;
+    TF_ASSERT_OK(NodeBuilder("cached", "CachedShapeFn")
+                     .Input(input)
+                     .Finalize(&graph, &node));
+    ShapeRefiner m(TF_GRAPH_DEF_VERSION, OpRegistry::Global());
+    TF_ASSERT_OK(m.AddNode(input));
+    TF_ASSERT_OK(m.AddNode(node));
+    EXPECT_EQ(expected_runs, num_cached_shape_fn_runs);
+    shape_inference::InferenceContext* ctx = m.GetContext(node);
+    EXPECT_EQ(expected_shape, ctx->DebugString(ctx->output(0)));
+    EXPECT_TRUE(SameHandle(ctx->Dim(ctx->output(0), 1),
+                           ctx->Dim(ctx->output(1), 0)));
+  };
+  num_cached_shape_fn_runs = 0;
+  add_node(TensorShape({2, 3}), 1, "[2,?]");
+  // The second refiner reuses the result of the first one.
+  add_node(TensorShape({2, 3}), 1, "[2,?]");
+  // Other input shapes run the shape function again.
+  add_node(TensorShape({5, 3}), 2, "[5,?]");
+}
+
+namespace {
+
 // An op with a shape function that looks at its input tensor
 // data and makes a Shape out of it.
 REGISTER_OP("ShapeData")
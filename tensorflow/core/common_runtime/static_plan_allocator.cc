@@ -0,0 +1,279 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_plan_allocator.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
+
+namespace tensorflow {
+
+struct StaticPlanAllocator::Buffer {
+  // The size of the buffer, rounded up to kAllocatorAlignment.
+  size_t size;
+  // The clock of the step when the buffer was allocated and freed, or -1 if
+  // it was not freed within the step.
+  int64 alloc_time;
+  int64 free_time = -1;
+  // Whether the buffer was given an offset in the slab.
+  bool planned = false;
+  size_t offset = 0;
+  // The planned buffers that share bytes with this one in the slab.
+  std::vector<int> conflicts;
+};
+
+struct StaticPlanAllocator::Plan {
+  ~Plan() {
+    if (slab != nullptr) port::AlignedFree(slab);
+  }
+
+  enum class State { kRecording, kPlanned, kDisabled };
+  State state = State::kRecording;
+  std::vector<Buffer> buffers;
+  // The buffers allocated by each op, in the order of allocation.
+  std::unordered_map<uint64, std::vector<int>> op_buffers;
+  char* slab = nullptr;
+  size_t slab_bytes = 0;
+  // Whether each buffer is currently handed out from the slab.
+  std::vector<bool> live;
+  // The buffers currently handed out from the slab, by offset.
+  std::unordered_map<size_t, int> live_offsets;
+};
+
+namespace {
+
+size_t RoundUp(size_t num_bytes) {
+  const size_t alignment = Allocator::kAllocatorAlignment;
+  return (std::max<size_t>(num_bytes, 1) + alignment - 1) & ~(alignment - 1);
+}
+
+}  // namespace
+
+StaticPlanAllocator::StaticPlanAllocator(Allocator* base)
+    : base_(base), active_step_id_(-1) {}
+
+StaticPlanAllocator::~StaticPlanAllocator() {
+  for (const auto& it : plans_) {
+    if (!it.second->live_offsets.empty()) {
+      LOG(ERROR) << "StaticPlanAllocator destroyed with "
+                 << it.second->live_offsets.size() << " live buffers";
+    }
+  }
+}
+
+bool StaticPlanAllocator::BeginStep(int64 step_id, uint64 plan_key) {
+  mutex_lock l(mu_);
+  if (active_plan_ != nullptr) return false;
+  std::unique_ptr<Plan>& plan = plans_[plan_key];
+  if (plan == nullptr) {
+    plan.reset(new Plan);
+  } else if (plan->state == Plan::State::kDisabled) {
+    return false;
+  }
+  active_plan_ = plan.get();
+  clock_ = 0;
+  op_counts_.clear();
+  active_step_id_.store(step_id, std::memory_order_release);
+  return true;
+}
+
+void StaticPlanAllocator::EndStep(int64 step_id) {
+  mutex_lock l(mu_);
+  if (active_plan_ == nullptr ||
+      active_step_id_.load(std::memory_order_relaxed) != step_id) {
+    return;
+  }
+  active_step_id_.store(-1, std::memory_order_release);
+  if (active_plan_->state == Plan::State::kRecording) {
+    // The buffers that are still live escape the step, e.g. as its outputs,
+    // and are left out of the plan.
+    recorded_buffers_.clear();
+    MakePlanLocked(active_plan_);
+  }
+  active_plan_ = nullptr;
+}
+
+size_t StaticPlanAllocator::PlannedBytes(uint64 plan_key) {
+  mutex_lock l(mu_);
+  auto it = plans_.find(plan_key);
+  return it == plans_.end() ? 0 : it->second->slab_bytes;
+}
+
+void* StaticPlanAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+}
+
+void* StaticPlanAllocator::AllocateRaw(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  const int64 step_id = allocation_attr.step_id;
+  if (step_id == -1 ||
+      step_id != active_step_id_.load(std::memory_order_acquire) ||
+      allocation_attr.op_name.empty() || alignment > kAllocatorAlignment) {
+    return base_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  }
+  const uint64 op_key = Hash64(allocation_attr.op_name.data(),
+                               allocation_attr.op_name.size());
+  {
+    mutex_lock l(mu_);
+    if (active_plan_ != nullptr &&
+        step_id == active_step_id_.load(std::memory_order_relaxed)) {
+      if (active_plan_->state == Plan::State::kRecording) {
+        void* ptr = base_->AllocateRaw(alignment, num_bytes, allocation_attr);
+        if (ptr != nullptr) {
+          const int index = active_plan_->buffers.size();
+          Buffer buffer;
+          buffer.size = RoundUp(num_bytes);
+          buffer.alloc_time = clock_++;
+          active_plan_->buffers.push_back(std::move(buffer));
+          active_plan_->op_buffers[op_key].push_back(index);
+          recorded_buffers_[ptr] = index;
+        }
+        return ptr;
+      }
+      void* ptr = AllocateFromPlanLocked(num_bytes, op_key);
+      if (ptr != nullptr) return ptr;
+      VLOG(2) << "Allocation of " << num_bytes << " bytes by "
+              << allocation_attr.op_name << " does not match the plan";
+    }
+  }
+  return base_->AllocateRaw(alignment, num_bytes, allocation_attr);
+}
+
+void* StaticPlanAllocator::AllocateFromPlanLocked(size_t num_bytes,
+                                                  uint64 op_key) {
+  Plan* plan = active_plan_;
+  const int count = op_counts_[op_key]++;
+  auto it = plan->op_buffers.find(op_key);
+  if (it == plan->op_buffers.end() || count >= it->second.size()) {
+    return nullptr;
+  }
+  const int index = it->second[count];
+  const Buffer& buffer = plan->buffers[index];
+  if (!buffer.planned || RoundUp(num_bytes) > buffer.size ||
+      plan->live[index]) {
+    return nullptr;
+  }
+  for (int conflict : buffer.conflicts) {
+    if (plan->live[conflict]) return nullptr;
+  }
+  plan->live[index] = true;
+  plan->live_offsets[buffer.offset] = index;
+  return plan->slab + buffer.offset;
+}
+
+void StaticPlanAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  {
+    mutex_lock l(mu_);
+    char* p = static_cast<char*>(ptr);
+    for (const auto& it : plans_) {
+      Plan* plan = it.second.get();
+      if (p >= plan->slab && p < plan->slab + plan->slab_bytes) {
+        auto live = plan->live_offsets.find(p - plan->slab);
+        CHECK(live != plan->live_offsets.end());
+        plan->live[live->second] = false;
+        plan->live_offsets.erase(live);
+        return;
+      }
+    }
+    if (!recorded_buffers_.empty()) {
+      auto recorded = recorded_buffers_.find(ptr);
+      if (recorded != recorded_buffers_.end()) {
+        active_plan_->buffers[recorded->second].free_time = clock_++;
+        recorded_buffers_.erase(recorded);
+      }
+    }
+  }
+  base_->DeallocateRaw(ptr);
+}
+
+void StaticPlanAllocator::MakePlanLocked(Plan* plan) {
+  std::vector<Buffer>& buffers = plan->buffers;
+  std::vector<int> order;
+  for (int i = 0; i < buffers.size(); ++i) {
+    if (buffers[i].free_time >= 0) order.push_back(i);
+  }
+  if (order.empty()) {
+    plan->state = Plan::State::kDisabled;
+    return;
+  }
+
+  // Places the largest buffers first, each at the lowest offset that does
+  // not overlap a buffer placed before it with an overlapping lifetime.
+  std::stable_sort(order.begin(), order.end(), [&buffers](int a, int b) {
+    return buffers[a].size > buffers[b].size;
+  });
+  std::vector<int> placed;
+  std::vector<int> overlapping;
+  size_t slab_bytes = 0;
+  for (int i : order) {
+    Buffer& buffer = buffers[i];
+    overlapping.clear();
+    for (int j : placed) {
+      if (buffers[j].alloc_time < buffer.free_time &&
+          buffer.alloc_time < buffers[j].free_time) {
+        overlapping.push_back(j);
+      }
+    }
+    std::sort(overlapping.begin(), overlapping.end(), [&buffers](int a, int b) {
+      return buffers[a].offset < buffers[b].offset;
+    });
+    size_t offset = 0;
+    for (int j : overlapping) {
+      if (offset + buffer.size <= buffers[j].offset) break;
+      offset = std::max(offset, buffers[j].offset + buffers[j].size);
+    }
+    buffer.planned = true;
+    buffer.offset = offset;
+    slab_bytes = std::max(slab_bytes, offset + buffer.size);
+    placed.push_back(i);
+  }
+
+  // Within a step, buffers may be allocated in another order than when
+  // recording, so buffers that share bytes must be checked at runtime.
+  std::sort(placed.begin(), placed.end(), [&buffers](int a, int b) {
+    return buffers[a].offset < buffers[b].offset;
+  });
+  for (int a = 0; a < placed.size(); ++a) {
+    Buffer& first = buffers[placed[a]];
+    for (int b = a + 1; b < placed.size(); ++b) {
+      Buffer& second = buffers[placed[b]];
+      if (second.offset >= first.offset + first.size) break;
+      first.conflicts.push_back(placed[b]);
+      second.conflicts.push_back(placed[a]);
+    }
+  }
+
+  plan->slab = static_cast<char*>(
+      port::AlignedMalloc(slab_bytes, kAllocatorAlignment));
+  if (plan->slab == nullptr) {
+    LOG(WARNING) << "Failed to allocate a slab of " << slab_bytes
+                 << " bytes for a static memory plan";
+    plan->state = Plan::State::kDisabled;
+    return;
+  }
+  plan->slab_bytes = slab_bytes;
+  plan->live.assign(buffers.size(), false);
+  plan->state = Plan::State::kPlanned;
+  VLOG(1) << "Planned " << placed.size() << " of " << buffers.size()
+          << " buffers into a slab of " << slab_bytes << " bytes";
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,106 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_PLAN_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_PLAN_ALLOCATOR_H_
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator that serves the steps of a graph with fixed shapes from a
+// single preallocated slab, at offsets planned ahead of time.
+//
+// The first step run with a given plan key records the size, the op and
+// the lifetime of each allocation made on behalf of that step. At the end
+// of the step, the buffers that were freed during it are assigned offsets
+// in a slab, greedily by decreasing size, so that buffers with overlapping
+// lifetimes never overlap in memory. Later steps with the same key then
+// get the n-th allocation of each op from its planned offset.
+//
+// Steps are not required to replay the recorded step exactly. An
+// allocation falls back to the wrapped allocator if it is larger than the
+// planned one, e.g. because shapes diverged, if its op allocates more
+// buffers than it did when recording, or if one of the buffers that share
+// its bytes in the slab is still live. A buffer from the slab may then
+// safely outlive its step.
+//
+// Only one step at a time is served from the plans. Allocations that are
+// not made on behalf of that step go to the wrapped allocator.
+class StaticPlanAllocator : public Allocator {
+ public:
+  // "base" must outlive this.
+  explicit StaticPlanAllocator(Allocator* base);
+  ~StaticPlanAllocator() override;
+
+  // Starts serving the allocations of "step_id" from the plan recorded for
+  // "plan_key", or records one if there is none. Returns false if another
+  // step is being served or if the plan could not be made, in which case
+  // the step is served by the wrapped allocator.
+  bool BeginStep(int64 step_id, uint64 plan_key) LOCKS_EXCLUDED(mu_);
+
+  // Stops serving "step_id", and makes the plan if it was recorded.
+  // REQUIRES: All the kernels of the step are done.
+  void EndStep(int64 step_id) LOCKS_EXCLUDED(mu_);
+
+  // Returns the size of the slab planned for "plan_key", or 0 if there is
+  // none.
+  size_t PlannedBytes(uint64 plan_key) LOCKS_EXCLUDED(mu_);
+
+  string Name() override { return "static_plan"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override;
+  void DeallocateRaw(void* ptr) override;
+  void GetStats(AllocatorStats* stats) override { base_->GetStats(stats); }
+
+ private:
+  struct Buffer;
+  struct Plan;
+
+  void* AllocateFromPlanLocked(size_t num_bytes, uint64 op_key)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void MakePlanLocked(Plan* plan) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Allocator* const base_;  // Not owned.
+
+  // The step being served, or -1. Read without "mu_" to forward the
+  // allocations of other steps quickly.
+  std::atomic<int64> active_step_id_;
+
+  mutex mu_;
+  std::unordered_map<uint64, std::unique_ptr<Plan>> plans_ GUARDED_BY(mu_);
+  Plan* active_plan_ GUARDED_BY(mu_) = nullptr;
+  // The number of allocations and deallocations of the step so far.
+  int64 clock_ GUARDED_BY(mu_) = 0;
+  // The number of allocations of each op in the step so far.
+  std::unordered_map<uint64, int> op_counts_ GUARDED_BY(mu_);
+  // The buffers of the step being recorded that are live.
+  std::unordered_map<void*, int> recorded_buffers_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StaticPlanAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_PLAN_ALLOCATOR_H_
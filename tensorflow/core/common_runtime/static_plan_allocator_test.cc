@@ -0,0 +1,125 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_plan_allocator.h"
+
+#include <cstdlib>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class StaticPlanAllocatorTest : public ::testing::Test {
+ protected:
+  StaticPlanAllocatorTest() : allocator_(cpu_allocator()) {}
+
+  void* Allocate(int64 step_id, StringPiece op_name, size_t num_bytes) {
+    AllocationAttributes attr;
+    attr.op_name = op_name;
+    attr.step_id = step_id;
+    return allocator_.AllocateRaw(Allocator::kAllocatorAlignment, num_bytes,
+                                  attr);
+  }
+
+  StaticPlanAllocator allocator_;
+};
+
+TEST_F(StaticPlanAllocatorTest, ReusesMemoryOfDisjointLifetimes) {
+  // Records "a" and "c", which are never live together, and "b", which
+  // overlaps both.
+  ASSERT_TRUE(allocator_.BeginStep(1, 0));
+  void* a = Allocate(1, "a", 1000);
+  void* b = Allocate(1, "b", 1000);
+  allocator_.DeallocateRaw(a);
+  void* c = Allocate(1, "c", 1000);
+  allocator_.DeallocateRaw(b);
+  allocator_.DeallocateRaw(c);
+  allocator_.EndStep(1);
+  EXPECT_EQ(2048, allocator_.PlannedBytes(0));
+
+  for (int64 step_id = 2; step_id < 4; ++step_id) {
+    ASSERT_TRUE(allocator_.BeginStep(step_id, 0));
+    a = Allocate(step_id, "a", 1000);
+    b = Allocate(step_id, "b", 1000);
+    allocator_.DeallocateRaw(a);
+    c = Allocate(step_id, "c", 1000);
+    EXPECT_EQ(a, c);
+    EXPECT_EQ(1024, std::abs(static_cast<char*>(b) - static_cast<char*>(c)));
+    allocator_.DeallocateRaw(b);
+    allocator_.DeallocateRaw(c);
+    allocator_.EndStep(step_id);
+  }
+}
+
+TEST_F(StaticPlanAllocatorTest, FallsBackWhenStepDiverges) {
+  ASSERT_TRUE(allocator_.BeginStep(1, 0));
+  void* a = Allocate(1, "a", 1000);
+  allocator_.DeallocateRaw(a);
+  void* b = Allocate(1, "b", 1000);
+  allocator_.DeallocateRaw(b);
+  allocator_.EndStep(1);
+  EXPECT_EQ(1024, allocator_.PlannedBytes(0));
+
+  ASSERT_TRUE(allocator_.BeginStep(2, 0));
+  a = Allocate(2, "a", 1000);
+  // "b" shares its bytes with "a", which is still live.
+  b = Allocate(2, "b", 1000);
+  EXPECT_NE(a, b);
+  // "a" was allocated once when recording, and "c" not at all.
+  void* second_a = Allocate(2, "a", 10);
+  void* c = Allocate(2, "c", 10);
+  allocator_.DeallocateRaw(a);
+  allocator_.DeallocateRaw(b);
+  allocator_.DeallocateRaw(second_a);
+  allocator_.DeallocateRaw(c);
+  allocator_.EndStep(2);
+
+  ASSERT_TRUE(allocator_.BeginStep(3, 0));
+  // A larger buffer than the planned one.
+  void* large_a = Allocate(3, "a", 2000);
+  b = Allocate(3, "b", 1000);
+  EXPECT_NE(large_a, b);
+  allocator_.DeallocateRaw(large_a);
+  allocator_.DeallocateRaw(b);
+  allocator_.EndStep(3);
+}
+
+TEST_F(StaticPlanAllocatorTest, LeavesEscapingBuffersOutOfPlan) {
+  ASSERT_TRUE(allocator_.BeginStep(1, 0));
+  void* output = Allocate(1, "output", 1000);
+  allocator_.EndStep(1);
+  allocator_.DeallocateRaw(output);
+  EXPECT_EQ(0, allocator_.PlannedBytes(0));
+  // There is nothing to plan.
+  EXPECT_FALSE(allocator_.BeginStep(2, 0));
+}
+
+TEST_F(StaticPlanAllocatorTest, ServesOneStepAtATime) {
+  ASSERT_TRUE(allocator_.BeginStep(1, 0));
+  EXPECT_FALSE(allocator_.BeginStep(2, 1));
+  void* a = Allocate(1, "a", 1000);
+  void* other = Allocate(2, "a", 1000);
+  allocator_.DeallocateRaw(a);
+  allocator_.DeallocateRaw(other);
+  allocator_.EndStep(2);
+  allocator_.EndStep(1);
+  EXPECT_EQ(1024, allocator_.PlannedBytes(0));
+  EXPECT_EQ(0, allocator_.PlannedBytes(1));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,147 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
+
+namespace tensorflow {
+
+// The header at the start of each chunk. Chunks are aligned to their size,
+// so the chunk of a buffer is found by masking the low bits of its address.
+struct StepArenaAllocator::Chunk {
+  // The offset of the first unused byte of the chunk.
+  size_t offset;
+  // The number of allocations of the chunk that have not been deallocated.
+  int64 live;
+};
+
+namespace {
+
+// Allocations are rounded up to this, so that all of them are aligned to it.
+constexpr size_t kArenaAlignment = Allocator::kAllocatorAlignment;
+
+size_t RoundUp(size_t num_bytes) {
+  return (num_bytes + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+}
+
+}  // namespace
+
+constexpr size_t StepArenaAllocator::kDefaultChunkBytes;
+
+StepArenaAllocator::StepArenaAllocator(Allocator* base, size_t chunk_bytes,
+                                       int max_free_chunks)
+    : base_(base),
+      chunk_bytes_(chunk_bytes),
+      max_arena_bytes_(chunk_bytes / 8),
+      max_free_chunks_(max_free_chunks) {
+  CHECK_EQ(chunk_bytes & (chunk_bytes - 1), 0)
+      << "chunk_bytes must be a power of 2: " << chunk_bytes;
+  CHECK_GE(chunk_bytes, 8 * kArenaAlignment);
+}
+
+StepArenaAllocator::~StepArenaAllocator() {
+  for (Chunk* chunk : chunks_) {
+    if (chunk->live > 0) {
+      LOG(ERROR) << "StepArenaAllocator destroyed with " << chunk->live
+                 << " live allocations";
+    }
+    port::AlignedFree(chunk);
+  }
+}
+
+void* StepArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+}
+
+void* StepArenaAllocator::AllocateRaw(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  const size_t rounded_bytes = RoundUp(num_bytes == 0 ? 1 : num_bytes);
+  if (alignment > kArenaAlignment || rounded_bytes > max_arena_bytes_) {
+    return base_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  }
+  mutex_lock l(mu_);
+  if (current_ == nullptr ||
+      current_->offset + rounded_bytes > chunk_bytes_) {
+    Chunk* chunk = NewChunkLocked();
+    if (chunk == nullptr) return nullptr;
+    if (current_ != nullptr && current_->live == 0) {
+      ReleaseChunkLocked(current_);
+    }
+    current_ = chunk;
+  }
+  char* ptr = reinterpret_cast<char*>(current_) + current_->offset;
+  current_->offset += rounded_bytes;
+  ++current_->live;
+  return ptr;
+}
+
+void StepArenaAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  Chunk* chunk = reinterpret_cast<Chunk*>(reinterpret_cast<uintptr_t>(ptr) &
+                                          ~(chunk_bytes_ - 1));
+  {
+    mutex_lock l(mu_);
+    if (chunks_.count(chunk) > 0) {
+      DCHECK_GT(chunk->live, 0);
+      if (--chunk->live == 0) {
+        if (chunk == current_) {
+          // Every buffer carved out so far is dead, so start over.
+          chunk->offset = kArenaAlignment;
+        } else {
+          ReleaseChunkLocked(chunk);
+        }
+      }
+      return;
+    }
+  }
+  base_->DeallocateRaw(ptr);
+}
+
+int64 StepArenaAllocator::NumChunks() {
+  mutex_lock l(mu_);
+  return chunks_.size();
+}
+
+StepArenaAllocator::Chunk* StepArenaAllocator::NewChunkLocked() {
+  static_assert(sizeof(Chunk) <= kArenaAlignment,
+                "Chunk header must fit before the first allocation");
+  Chunk* chunk;
+  if (!free_chunks_.empty()) {
+    chunk = free_chunks_.back();
+    free_chunks_.pop_back();
+  } else {
+    chunk = static_cast<Chunk*>(port::AlignedMalloc(chunk_bytes_,
+                                                    chunk_bytes_));
+    if (chunk == nullptr) return nullptr;
+    chunks_.insert(chunk);
+  }
+  chunk->offset = kArenaAlignment;
+  chunk->live = 0;
+  return chunk;
+}
+
+void StepArenaAllocator::ReleaseChunkLocked(Chunk* chunk) {
+  if (free_chunks_.size() < static_cast<size_t>(max_free_chunks_)) {
+    free_chunks_.push_back(chunk);
+  } else {
+    chunks_.erase(chunk);
+    port::AlignedFree(chunk);
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,88 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator for the short-lived temporaries that kernels allocate while
+// a step runs. Small allocations are carved out of large chunks by bumping
+// a pointer, in the spirit of core::Arena, while large ones are forwarded to
+// the wrapped allocator.
+//
+// Unlike core::Arena, a chunk counts its live allocations, and is reset
+// once they have all been deallocated, which usually happens when the
+// kernels of a step are done with their temporaries. A buffer that outlives
+// its step, e.g. a temporary that a kernel sets as an output, keeps its
+// chunk alive until it is released, so any buffer may be safely returned by
+// this allocator.
+class StepArenaAllocator : public Allocator {
+ public:
+  static constexpr size_t kDefaultChunkBytes = 1 << 20;
+
+  // Allocations of at most "chunk_bytes / 8" are served from chunks of
+  // "chunk_bytes", of which at most "max_free_chunks" unused ones are kept
+  // for reuse. Others are forwarded to "base", which must outlive this.
+  // REQUIRES: "chunk_bytes" is a power of 2.
+  explicit StepArenaAllocator(Allocator* base,
+                              size_t chunk_bytes = kDefaultChunkBytes,
+                              int max_free_chunks = 4);
+  ~StepArenaAllocator() override;
+
+  string Name() override { return "step_arena"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override;
+  void DeallocateRaw(void* ptr) override;
+
+  // Returns the number of chunks allocated by this, including free ones.
+  int64 NumChunks() LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Chunk;
+
+  Chunk* NewChunkLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void ReleaseChunkLocked(Chunk* chunk) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Allocator* const base_;  // Not owned.
+  const size_t chunk_bytes_;
+  const size_t max_arena_bytes_;
+  const int max_free_chunks_;
+
+  mutex mu_;
+  // The chunk that allocations are currently carved out of.
+  Chunk* current_ GUARDED_BY(mu_) = nullptr;
+  // Chunks with no live allocations, ready for reuse.
+  std::vector<Chunk*> free_chunks_ GUARDED_BY(mu_);
+  // All the chunks allocated by this, to tell apart the buffers of the
+  // wrapped allocator on deallocation.
+  std::unordered_set<Chunk*> chunks_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepArenaAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
@@ -0,0 +1,109 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr size_t kChunkBytes = 1 << 16;
+
+TEST(StepArenaAllocatorTest, AllocatesAlignedBuffers) {
+  StepArenaAllocator a(cpu_allocator(), kChunkBytes);
+  std::vector<void*> ptrs;
+  for (size_t n : {0, 1, 7, 64, 100, 1000}) {
+    void* p = a.AllocateRaw(Allocator::kAllocatorAlignment, n);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % Allocator::kAllocatorAlignment,
+              0);
+    ptrs.push_back(p);
+  }
+  EXPECT_EQ(1, a.NumChunks());
+  for (void* p : ptrs) a.DeallocateRaw(p);
+}
+
+TEST(StepArenaAllocatorTest, ReusesChunkOnceAllBuffersAreDeallocated) {
+  StepArenaAllocator a(cpu_allocator(), kChunkBytes);
+  void* first = a.AllocateRaw(Allocator::kAllocatorAlignment, 128);
+  void* second = a.AllocateRaw(Allocator::kAllocatorAlignment, 128);
+  EXPECT_NE(first, second);
+  a.DeallocateRaw(first);
+  a.DeallocateRaw(second);
+  // The chunk is reset, as it would be at the end of a step.
+  EXPECT_EQ(first, a.AllocateRaw(Allocator::kAllocatorAlignment, 128));
+  a.DeallocateRaw(first);
+  EXPECT_EQ(1, a.NumChunks());
+}
+
+TEST(StepArenaAllocatorTest, LiveBufferKeepsItsChunk) {
+  StepArenaAllocator a(cpu_allocator(), kChunkBytes, /*max_free_chunks=*/0);
+  const size_t n = kChunkBytes / 8;
+  void* escaped = a.AllocateRaw(Allocator::kAllocatorAlignment, n);
+  memset(escaped, 1, n);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 20; ++i) {
+    ptrs.push_back(a.AllocateRaw(Allocator::kAllocatorAlignment, n));
+    memset(ptrs.back(), 2, n);
+  }
+  for (void* p : ptrs) a.DeallocateRaw(p);
+  // The buffer that outlives the others is left untouched.
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_EQ(1, static_cast<char*>(escaped)[i]);
+  }
+  a.DeallocateRaw(escaped);
+  EXPECT_EQ(1, a.NumChunks());
+}
+
+TEST(StepArenaAllocatorTest, ForwardsLargeAllocations) {
+  StepArenaAllocator a(cpu_allocator(), kChunkBytes);
+  void* large = a.AllocateRaw(Allocator::kAllocatorAlignment, kChunkBytes);
+  ASSERT_NE(large, nullptr);
+  void* overaligned = a.AllocateRaw(4096, 16);
+  ASSERT_NE(overaligned, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(overaligned) % 4096, 0);
+  EXPECT_EQ(0, a.NumChunks());
+  a.DeallocateRaw(large);
+  a.DeallocateRaw(overaligned);
+}
+
+void BM_Allocate(int iters, int num_bytes, Allocator* a) {
+  std::vector<void*> ptrs(16);
+  for (int i = 0; i < iters; ++i) {
+    for (void*& p : ptrs) {
+      p = a->AllocateRaw(Allocator::kAllocatorAlignment, num_bytes);
+    }
+    for (void* p : ptrs) a->DeallocateRaw(p);
+  }
+}
+
+void BM_StepArenaAllocate(int iters, int num_bytes) {
+  StepArenaAllocator a(cpu_allocator());
+  BM_Allocate(iters, num_bytes, &a);
+}
+BENCHMARK(BM_StepArenaAllocate)->Arg(64)->Arg(4096)->Arg(65536);
+
+void BM_CpuAllocate(int iters, int num_bytes) {
+  BM_Allocate(iters, num_bytes, cpu_allocator());
+}
+BENCHMARK(BM_CpuAllocate)->Arg(64)->Arg(4096)->Arg(65536);
+
+}  // namespace
+}  // namespace tensorflow
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/scanner.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
@@ -39,6 +40,60 @@ struct AllocStats {
   int64 total_bytes = 0;
   int64 total_nodes = 0;
 };
+
+// Returns true if the hardware performance counters of the nodes should be
+// recorded, as requested by TF_PROFILE_HARDWARE_COUNTERS.
+bool ShouldRecordPerfCounters() {
+  static const bool record = []() {
+    bool requested;
+    Status s = ReadBoolFromEnvVar("TF_PROFILE_HARDWARE_COUNTERS", false,
+                                  &requested);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return false;
+    }
+    if (requested && !port::PerfCountersEnabled()) {
+      LOG(WARNING) << "TF_PROFILE_HARDWARE_COUNTERS is set, but the hardware "
+                      "performance counters cannot be read by this process.";
+      return false;
+    }
+    return requested;
+  }();
+  return record;
+}
+
+// Returns true if `node` only converts tensors between data layouts, as the
+// nodes inserted by the MKL layout passes do.
+bool IsLayoutConversion(const Node* node) {
+  if (node == nullptr) return false;
+  const string& op = node->type_string();
+  return op == "_MklToTf" || op == "_MklInputConversion";
+}
+
+// Returns the shapes of the inputs of "node", taken from the stats of the
+// nodes producing them. The shapes of the inputs whose producer has no stats
+// are unknown.
+std::vector<TensorShapeProto> InputShapes(
+    const Node* node,
+    const std::unordered_map<StringPiece, const NodeExecStats*,
+                             StringPieceHasher>& name_to_node_stats) {
+  std::vector<TensorShapeProto> shapes(node->num_inputs());
+  for (TensorShapeProto& shape : shapes) {
+    shape.set_unknown_rank(true);
+  }
+  for (const Edge* e : node->in_edges()) {
+    if (e->IsControlEdge()) continue;
+    auto it = name_to_node_stats.find(e->src()->name());
+    if (it == name_to_node_stats.end()) continue;
+    for (const auto& output : it->second->output()) {
+      if (output.slot() == e->src_output()) {
+        shapes[e->dst_input()] = output.tensor_description().shape();
+        break;
+      }
+    }
+  }
+  return shapes;
+}
 }  // namespace
 
 NodeExecStatsWrapper::NodeExecStatsWrapper(
@@ -113,6 +168,10 @@ void NodeExecStatsWrapper::RecordComputeStarted() {
   stats_->set_op_start_rel_micros(now_nanos / EnvTime::kMicrosToNanos -
                                   stats_->all_start_micros());
   stats_->set_op_start_rel_nanos(now_nanos - stats_->all_start_nanos());
+  if (TF_PREDICT_FALSE(ShouldRecordPerfCounters()) &&
+      port::ReadThreadPerfCounters(&compute_start_counters_)) {
+    compute_start_thread_ = std::this_thread::get_id();
+  }
 }
 
 void NodeExecStatsWrapper::RecordComputeEnded() {
@@ -122,6 +181,21 @@ void NodeExecStatsWrapper::RecordComputeEnded() {
   stats_->set_op_end_rel_micros(now_nanos / EnvTime::kMicrosToNanos -
                                 stats_->all_start_micros());
   stats_->set_op_end_rel_nanos(now_nanos - stats_->all_start_nanos());
+  // The counters are per thread, so they only measure the computation if it
+  // ended on the thread it started on.
+  port::PerfCounterValues end_counters;
+  if (TF_PREDICT_FALSE(compute_start_thread_ != std::thread::id()) &&
+      compute_start_thread_ == std::this_thread::get_id() &&
+      port::ReadThreadPerfCounters(&end_counters)) {
+    HardwareCounters* counters = stats_->mutable_hardware_counters();
+    counters->set_cycles(end_counters.cycles - compute_start_counters_.cycles);
+    counters->set_instructions(end_counters.instructions -
+                               compute_start_counters_.instructions);
+    counters->set_cache_references(end_counters.cache_references -
+                                   compute_start_counters_.cache_references);
+    counters->set_cache_misses(end_counters.cache_misses -
+                               compute_start_counters_.cache_misses);
+  }
 }
 
 void NodeExecStatsWrapper::RecordExecutorEnded() {
@@ -179,6 +253,8 @@ void NodeExecStatsWrapper::AddAllocation(
   AllocatorStats stats;
   allocator->GetStats(&stats);
   memory->set_allocator_bytes_in_use(stats.bytes_in_use);
+  memory->set_allocator_largest_free_block_bytes(
+      stats.largest_free_block_bytes);
   allocations_.push_back(std::make_pair(memory, tracking_allocator));
 }
 
@@ -346,6 +422,12 @@ void StepStatsCollector::BuildCostModel(
       }
     }
 
+    std::unordered_map<StringPiece, const NodeExecStats*, StringPieceHasher>
+        name_to_node_stats;
+    for (const auto& node_stats : dev_stats.regular_stats->node_stats()) {
+      name_to_node_stats.emplace(node_stats.node_name(), &node_stats);
+    }
+
     for (int i = 0; i < dev_stats.regular_stats->node_stats_size(); ++i) {
       const NodeExecStats& stats = dev_stats.regular_stats->node_stats(i);
       const Node* node = name_to_node[stats.node_name()];
@@ -368,15 +450,14 @@ void StepStatsCollector::BuildCostModel(
         // Use hardware stats to record the execution time if they're available,
         // otherwise use the regular (less accurate) stats
         string node_name = dev_stats.regular_stats->node_stats(i).node_name();
+        Microseconds time(stats.op_end_rel_micros());
         if (dev_stats.hardware_stats && name_to_hw_node_stats.find(node_name) !=
                                             name_to_hw_node_stats.end()) {
           const NodeExecStats& hw_stats = name_to_hw_node_stats[node_name];
-          cm->RecordMaxExecutionTime(
-              node, Microseconds(hw_stats.op_end_rel_micros()));
-        } else {
-          cm->RecordMaxExecutionTime(node,
-                                     Microseconds(stats.op_end_rel_micros()));
+          time = Microseconds(hw_stats.op_end_rel_micros());
         }
+        cm->RecordMaxExecutionTime(node, time);
+        cm->RecordShapeTime(node, InputShapes(node, name_to_node_stats), time);
       }
     }
   }
@@ -403,6 +484,14 @@ void StepStatsCollector::Save(const string& device,
       delete node_stats;
       return;
     }
+    if (IsLayoutConversion(node_stats->node_)) {
+      const NodeExecStats& stats = *node_stats->stats();
+      LayoutConversionStats& conversions = layout_conversions_[device];
+      conversions.set_count(conversions.count() + 1);
+      conversions.set_total_nanos(conversions.total_nanos() +
+                                  stats.op_end_rel_nanos() -
+                                  stats.op_start_rel_nanos());
+    }
     auto& device_stats = dev_stats_[device];
     device_stats.push_back(std::unique_ptr<NodeExecStatsWrapper>(node_stats));
     collected_nodes_++;
@@ -530,6 +619,10 @@ void StepStatsCollector::FinalizeInternal() {
       stats->Finalize();
       stats->stats()->Swap(dss->add_node_stats());
     }
+    auto conversions = layout_conversions_.find(dev_stat.first);
+    if (conversions != layout_conversions_.end()) {
+      dss->mutable_layout_conversions()->Swap(&conversions->second);
+    }
   }
 }
 }  // namespace tensorflow
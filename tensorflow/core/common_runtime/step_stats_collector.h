@@ -16,6 +16,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_STATS_COLLECTOR_H_
 
 #include <memory>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 #include "tensorflow/core/framework/step_stats.pb.h"
@@ -23,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/perf_counters.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -125,6 +127,10 @@ class NodeExecStatsWrapper : public NodeExecStatsInterface {
   gtl::InlinedVector<std::pair<AllocatorMemoryUsed*, TrackingAllocator*>, 2>
       allocations_;
   std::unique_ptr<NodeExecStats> stats_;
+  // The hardware performance counters read by `RecordComputeStarted()`, and
+  // the thread they were read on, if they are recorded.
+  port::PerfCounterValues compute_start_counters_;
+  std::thread::id compute_start_thread_;
   const Node* const node_;                          // Not owned.
   StepStatsCollector* const step_stats_collector_;  // Not owned.
 };
@@ -191,6 +197,8 @@ class StepStatsCollector : public StepStatsCollectorInterface {
   mutex mu_;
   bool finalized_ GUARDED_BY(mu_);
   std::unordered_map<string, NodeStatsVector> dev_stats_ GUARDED_BY(mu_);
+  std::unordered_map<string, LayoutConversionStats> layout_conversions_
+      GUARDED_BY(mu_);
   StepStats* step_stats_ GUARDED_BY(mu_);
   uint64 collected_nodes_ GUARDED_BY(mu_) = 0;
 };
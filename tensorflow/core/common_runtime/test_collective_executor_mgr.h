@@ -82,6 +82,14 @@ class TestCollectiveExecutorMgr : public CollectiveExecutorMgrInterface {
     }
   }
 
+  void StartAbort(int64 step_id, const Status& s) override {
+    mutex_lock l(mu_);
+    auto iter = table_.find(step_id);
+    if (iter != table_.end()) {
+      iter->second->StartAbort(s);
+    }
+  }
+
   ParamResolverInterface* GetParamResolver() const override {
     LOG(FATAL);
     return nullptr;
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/util.h"
 
 #ifdef INTEL_MKL
@@ -49,6 +50,24 @@ ThreadPoolDevice::ThreadPoolDevice(const SessionOptions& options,
                                name, DEVICE_CPU, memory_limit, locality)),
       allocator_(allocator),
       scoped_allocator_mgr_(new ScopedAllocatorMgr(name)) {
+  bool use_step_arena = false;
+  Status s = ReadBoolFromEnvVar("TF_CPU_STEP_ARENA_ALLOCATOR",
+                                /*default_val=*/false, &use_step_arena);
+  if (!s.ok()) {
+    LOG(ERROR) << s.error_message();
+  }
+  if (use_step_arena) {
+    temp_allocator_.reset(new StepArenaAllocator(allocator_));
+  }
+  bool use_static_plan = false;
+  s = ReadBoolFromEnvVar("TF_CPU_STATIC_MEMORY_PLAN", /*default_val=*/false,
+                         &use_static_plan);
+  if (!s.ok()) {
+    LOG(ERROR) << s.error_message();
+  }
+  if (use_static_plan) {
+    plan_allocator_.reset(new StaticPlanAllocator(allocator_));
+  }
 #ifdef INTEL_MKL
   // Early return when MKL is disabled
   if (DisableMKL()) return;
@@ -74,9 +93,20 @@ ThreadPoolDevice::ThreadPoolDevice(const SessionOptions& options,
 ThreadPoolDevice::~ThreadPoolDevice() {}
 
 Allocator* ThreadPoolDevice::GetAllocator(AllocatorAttributes attr) {
+  if (plan_allocator_ != nullptr) return plan_allocator_.get();
   return allocator_;
 }
 
+Allocator* ThreadPoolDevice::GetTempAllocator(AllocatorAttributes attr) {
+  Allocator* allocator = GetAllocator(attr);
+  // Subclasses may return special memory, e.g. for copies to a GPU, which
+  // the arena does not provide, and static plans serve temporaries too.
+  if (temp_allocator_ != nullptr && allocator == allocator_) {
+    return temp_allocator_.get();
+  }
+  return allocator;
+}
+
 Allocator* ThreadPoolDevice::GetScopedAllocator(AllocatorAttributes attr,
                                                 int64 step_id) {
   if (attr.scope_id > 0) {
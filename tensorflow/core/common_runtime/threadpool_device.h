@@ -18,6 +18,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/local_device.h"
+#include "tensorflow/core/common_runtime/static_plan_allocator.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 
 namespace tensorflow {
 
@@ -30,6 +32,7 @@ class ThreadPoolDevice : public LocalDevice {
   ~ThreadPoolDevice() override;
 
   Allocator* GetAllocator(AllocatorAttributes attr) override;
+  Allocator* GetTempAllocator(AllocatorAttributes attr) override;
   Allocator* GetScopedAllocator(AllocatorAttributes attr,
                                 int64 step_id) override;
   ScopedAllocatorMgr* GetScopedAllocatorMgr() const override {
@@ -44,6 +47,12 @@ class ThreadPoolDevice : public LocalDevice {
  private:
   Allocator* allocator_;  // Not owned
   std::unique_ptr<ScopedAllocatorMgr> scoped_allocator_mgr_;
+  // Serves the temporaries of kernels when TF_CPU_STEP_ARENA_ALLOCATOR is
+  // set, and is null otherwise.
+  std::unique_ptr<StepArenaAllocator> temp_allocator_;
+  // Serves the steps of a DirectSession from static memory plans when
+  // TF_CPU_STATIC_MEMORY_PLAN is set, and is null otherwise.
+  std::unique_ptr<StaticPlanAllocator> plan_allocator_;
 };
 
 }  // namespace tensorflow
@@ -18,7 +18,9 @@ limitations under the License.
 
 #include <vector>
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/process_state.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/public/session_options.h"
 
 namespace tensorflow {
@@ -28,17 +30,28 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
  public:
   Status CreateDevices(const SessionOptions& options, const string& name_prefix,
                        std::vector<Device*>* devices) override {
-    // TODO(zhifengc/tucker): Figure out the number of available CPUs
-    // and/or NUMA configuration.
-    int n = 1;
+    // With NUMA affinity there is one device per node by default, and
+    // device i is bound to node i modulo the number of nodes.
+    const bool use_numa = options.config.experimental().use_numa_affinity() &&
+                          port::NUMAEnabled();
+    const int num_numa_nodes = use_numa ? port::NUMANumNodes() : 1;
+    if (use_numa) ProcessState::singleton()->EnableNUMA();
+    int n = num_numa_nodes;
     auto iter = options.config.device_count().find("CPU");
     if (iter != options.config.device_count().end()) {
       n = iter->second;
     }
     for (int i = 0; i < n; i++) {
       string name = strings::StrCat(name_prefix, "/device:CPU:", i);
-      devices->push_back(new ThreadPoolDevice(
-          options, name, Bytes(256 << 20), DeviceLocality(), cpu_allocator()));
+      DeviceLocality locality;
+      Allocator* allocator = cpu_allocator();
+      if (use_numa) {
+        const int numa_node = i % num_numa_nodes;
+        locality.set_numa_node(numa_node);
+        allocator = ProcessState::singleton()->GetCPUAllocator(numa_node);
+      }
+      devices->push_back(new ThreadPoolDevice(options, name, Bytes(256 << 20),
+                                              locality, allocator));
     }
 
     return Status::OK();
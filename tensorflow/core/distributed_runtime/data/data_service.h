@@ -0,0 +1,65 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_DATA_SERVICE_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_DATA_SERVICE_H_
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/data_service.pb.h"
+
+namespace tensorflow {
+namespace data {
+
+// The methods of the tf.data service dispatcher; see
+// "//tensorflow/core/protobuf/data_service.proto". This is implemented both
+// by the dispatcher itself and by the clients that call a remote dispatcher.
+// The methods block until they complete, and are thread-safe.
+class DataDispatcherInterface {
+ public:
+  virtual ~DataDispatcherInterface() {}
+#define DISPATCHER_METHOD(method)                           \
+  virtual Status method(const method##Request* request,     \
+                        method##Response* response) = 0;
+
+  DISPATCHER_METHOD(CreateJob);
+  DISPATCHER_METHOD(GetJob);
+  DISPATCHER_METHOD(GetSplit);
+  DISPATCHER_METHOD(RegisterWorker);
+  DISPATCHER_METHOD(GetWorkers);
+
+#undef DISPATCHER_METHOD
+};
+
+// The methods of a tf.data service worker, implemented by the worker itself
+// and by the clients that call a remote worker. The methods block until they
+// complete, and are thread-safe.
+class DataWorkerInterface {
+ public:
+  virtual ~DataWorkerInterface() {}
+
+  // Returns the next element of job `job_id` that the worker produced in
+  // `components`, or sets `*end_of_sequence` once the worker has produced all
+  // its elements of the job.
+  virtual Status GetElement(int64 job_id, std::vector<Tensor>* components,
+                            bool* end_of_sequence) = 0;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_DATA_SERVICE_H_
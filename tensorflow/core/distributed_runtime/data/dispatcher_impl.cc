@@ -0,0 +1,129 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/data/dispatcher_impl.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace data {
+
+Status DataDispatcherImpl::CreateJob(const CreateJobRequest* request,
+                                     CreateJobResponse* response) {
+  if (request->num_splits() < 1) {
+    return errors::InvalidArgument("A job needs at least one split, got ",
+                                   request->num_splits());
+  }
+  mutex_lock l(mu_);
+  if (!request->job_name().empty()) {
+    auto it = job_ids_by_name_.find(request->job_name());
+    if (it != job_ids_by_name_.end()) {
+      const Job& job = jobs_[it->second];
+      if (job.num_splits != request->num_splits()) {
+        return errors::InvalidArgument(
+            "Job ", request->job_name(), " has ", job.num_splits,
+            " splits, but the request asked for ", request->num_splits());
+      }
+      response->set_job_id(it->second);
+      return Status::OK();
+    }
+  }
+  const int64 job_id = next_job_id_++;
+  Job& job = jobs_[job_id];
+  job.dataset = request->dataset();
+  job.num_splits = request->num_splits();
+  if (!request->job_name().empty()) {
+    job_ids_by_name_[request->job_name()] = job_id;
+  }
+  VLOG(1) << "Created job " << job_id << " (" << request->job_name()
+          << ") with " << job.num_splits << " splits";
+  response->set_job_id(job_id);
+  return Status::OK();
+}
+
+Status DataDispatcherImpl::GetJob(const GetJobRequest* request,
+                                  GetJobResponse* response) {
+  mutex_lock l(mu_);
+  auto it = jobs_.find(request->job_id());
+  if (it == jobs_.end()) {
+    return errors::NotFound("Unknown job ", request->job_id());
+  }
+  *response->mutable_dataset() = it->second.dataset;
+  response->set_num_splits(it->second.num_splits);
+  return Status::OK();
+}
+
+Status DataDispatcherImpl::GetSplit(const GetSplitRequest* request,
+                                    GetSplitResponse* response) {
+  mutex_lock l(mu_);
+  auto it = jobs_.find(request->job_id());
+  if (it == jobs_.end()) {
+    return errors::NotFound("Unknown job ", request->job_id());
+  }
+  Job& job = it->second;
+  std::vector<int64>& splits = job.splits_by_worker[request->worker_address()];
+  const int64 position = request->split_position();
+  if (position < 0 || position > splits.size()) {
+    return errors::InvalidArgument(
+        request->worker_address(), " asked for the split at position ",
+        position, " of job ", request->job_id(), ", but was handed out ",
+        splits.size(), " splits");
+  }
+  if (position < splits.size()) {
+    VLOG(1) << "Replaying split " << splits[position] << " of job "
+            << request->job_id() << " to " << request->worker_address();
+    response->set_split_index(splits[position]);
+    return Status::OK();
+  }
+  if (job.next_split >= job.num_splits) {
+    response->set_end_of_splits(true);
+    return Status::OK();
+  }
+  VLOG(2) << "Assigned split " << job.next_split << " of job "
+          << request->job_id() << " to " << request->worker_address();
+  splits.push_back(job.next_split);
+  response->set_split_index(job.next_split++);
+  return Status::OK();
+}
+
+Status DataDispatcherImpl::RegisterWorker(const RegisterWorkerRequest* request,
+                                          RegisterWorkerResponse* response) {
+  if (request->worker_address().empty()) {
+    return errors::InvalidArgument("A worker needs an address");
+  }
+  mutex_lock l(mu_);
+  if (std::find(workers_.begin(), workers_.end(),
+                request->worker_address()) == workers_.end()) {
+    LOG(INFO) << "Registered tf.data service worker "
+              << request->worker_address();
+    workers_.push_back(request->worker_address());
+  }
+  return Status::OK();
+}
+
+Status DataDispatcherImpl::GetWorkers(const GetWorkersRequest* request,
+                                      GetWorkersResponse* response) {
+  mutex_lock l(mu_);
+  for (const string& worker : workers_) {
+    response->add_worker_addresses(worker);
+  }
+  return Status::OK();
+}
+
+}  // namespace data
+}  // namespace tensorflow
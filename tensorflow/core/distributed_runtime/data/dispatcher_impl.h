@@ -0,0 +1,69 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_DISPATCHER_IMPL_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_DISPATCHER_IMPL_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/distributed_runtime/data/data_service.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace data {
+
+// The dispatcher of the tf.data service, which keeps the jobs and hands out
+// their splits to the workers. The state is kept in memory, so the jobs are
+// lost when the dispatcher restarts.
+class DataDispatcherImpl : public DataDispatcherInterface {
+ public:
+  DataDispatcherImpl() {}
+
+  Status CreateJob(const CreateJobRequest* request,
+                   CreateJobResponse* response) override;
+  Status GetJob(const GetJobRequest* request,
+                GetJobResponse* response) override;
+  Status GetSplit(const GetSplitRequest* request,
+                  GetSplitResponse* response) override;
+  Status RegisterWorker(const RegisterWorkerRequest* request,
+                        RegisterWorkerResponse* response) override;
+  Status GetWorkers(const GetWorkersRequest* request,
+                    GetWorkersResponse* response) override;
+
+ private:
+  struct Job {
+    DatasetDef dataset;
+    int64 num_splits;
+    // The index of the next split to hand out.
+    int64 next_split = 0;
+    // The splits handed out to each worker, in order.
+    std::unordered_map<string, std::vector<int64>> splits_by_worker;
+  };
+
+  mutex mu_;
+  int64 next_job_id_ GUARDED_BY(mu_) = 0;
+  std::unordered_map<int64, Job> jobs_ GUARDED_BY(mu_);
+  std::unordered_map<string, int64> job_ids_by_name_ GUARDED_BY(mu_);
+  std::vector<string> workers_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DataDispatcherImpl);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_DISPATCHER_IMPL_H_
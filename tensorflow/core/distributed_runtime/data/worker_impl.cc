@@ -0,0 +1,174 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/data/worker_impl.h"
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/graph_runner.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace data {
+
+DataWorkerImpl::Job::~Job() {
+  iterator.reset();
+  if (dataset != nullptr) {
+    dataset->Unref();
+  }
+}
+
+DataWorkerImpl::DataWorkerImpl(
+    const string& address, std::unique_ptr<DataDispatcherInterface> dispatcher,
+    int num_threads, Env* env)
+    : address_(address), dispatcher_(std::move(dispatcher)), env_(env) {
+  device_ = DeviceFactory::NewDevice("CPU", SessionOptions(),
+                                     "/job:localhost/replica:0/task:0");
+  CHECK(device_ != nullptr) << "Failed to create a CPU device";
+  device_mgr_.reset(new DeviceMgr({device_}));
+  thread_pool_.reset(
+      new thread::ThreadPool(env_, ThreadOptions(), "data_service_worker",
+                             num_threads, false /* low_latency_hint */));
+}
+
+DataWorkerImpl::~DataWorkerImpl() {
+  // The iterators of the jobs run functions on the thread pool.
+  {
+    mutex_lock l(mu_);
+    jobs_.clear();
+  }
+  thread_pool_.reset();
+}
+
+Status DataWorkerImpl::Start() {
+  RegisterWorkerRequest request;
+  request.set_worker_address(address_);
+  RegisterWorkerResponse response;
+  return dispatcher_->RegisterWorker(&request, &response);
+}
+
+Status DataWorkerImpl::GetElement(int64 job_id,
+                                  std::vector<Tensor>* components,
+                                  bool* end_of_sequence) {
+  std::shared_ptr<Job> job;
+  {
+    mutex_lock l(mu_);
+    std::shared_ptr<Job>& entry = jobs_[job_id];
+    if (entry == nullptr) {
+      entry = std::make_shared<Job>();
+    }
+    job = entry;
+  }
+  mutex_lock l(job->mu);
+  if (!job->initialized) {
+    TF_RETURN_IF_ERROR(InitializeJob(job_id, job.get()));
+    job->initialized = true;
+  }
+  while (!job->finished) {
+    if (job->iterator == nullptr) {
+      GetSplitRequest request;
+      request.set_job_id(job_id);
+      request.set_worker_address(address_);
+      request.set_split_position(job->num_splits);
+      GetSplitResponse response;
+      TF_RETURN_IF_ERROR(dispatcher_->GetSplit(&request, &response));
+      if (response.end_of_splits()) {
+        VLOG(1) << "Finished job " << job_id;
+        job->finished = true;
+        // Release the dataset graph and its functions.
+        job->graph.reset();
+        break;
+      }
+      ++job->num_splits;
+      TF_RETURN_IF_ERROR(StartSplit(response.split_index(), job.get()));
+    }
+    bool end_of_split = false;
+    IteratorContext ctx(IteratorParams(job.get()));
+    TF_RETURN_IF_ERROR(
+        job->iterator->GetNext(&ctx, components, &end_of_split));
+    if (!end_of_split) {
+      *end_of_sequence = false;
+      return Status::OK();
+    }
+    job->iterator.reset();
+    job->dataset->Unref();
+    job->dataset = nullptr;
+  }
+  *end_of_sequence = true;
+  return Status::OK();
+}
+
+Status DataWorkerImpl::InitializeJob(int64 job_id, Job* job) {
+  GetJobRequest request;
+  request.set_job_id(job_id);
+  GetJobResponse response;
+  TF_RETURN_IF_ERROR(dispatcher_->GetJob(&request, &response));
+  const GraphDef& graph_def = response.dataset().graph();
+  job->flib_def.reset(
+      new FunctionLibraryDefinition(OpRegistry::Global(), graph_def.library()));
+  job->pflr.reset(new ProcessFunctionLibraryRuntime(
+      device_mgr_.get(), env_, graph_def.versions().producer(),
+      job->flib_def.get(), OptimizerOptions()));
+  job->flr = job->pflr->GetFLR(device_->name());
+  job->graph.reset(new Graph(OpRegistry::Global()));
+  TF_RETURN_IF_ERROR(
+      ImportGraphDef({}, graph_def, job->graph.get(), nullptr));
+  job->dataset_tensor = response.dataset().dataset_tensor();
+  job->split_tensor = response.dataset().split_tensor();
+  VLOG(1) << "Started job " << job_id << " with " << response.num_splits()
+          << " splits";
+  return Status::OK();
+}
+
+Status DataWorkerImpl::StartSplit(int64 split_index, Job* job) {
+  Tensor split(DT_INT64, TensorShape({}));
+  split.scalar<int64>()() = split_index;
+  std::vector<Tensor> outputs;
+  GraphRunner graph_runner(device_);
+  TF_RETURN_IF_ERROR(graph_runner.Run(job->graph.get(), job->flr,
+                                      {{job->split_tensor, split}},
+                                      {job->dataset_tensor}, &outputs));
+  DatasetBase* dataset;
+  TF_RETURN_IF_ERROR(GetDatasetFromVariantTensor(outputs[0], &dataset));
+  IteratorContext ctx(IteratorParams(job));
+  std::unique_ptr<IteratorBase> iterator;
+  TF_RETURN_IF_ERROR(
+      dataset->MakeIterator(&ctx, "DataServiceWorker", &iterator));
+  dataset->Ref();
+  job->dataset = dataset;
+  job->iterator = std::move(iterator);
+  return Status::OK();
+}
+
+IteratorContext::Params DataWorkerImpl::IteratorParams(Job* job) {
+  IteratorContext::Params params;
+  params.env = env_;
+  thread::ThreadPool* pool = thread_pool_.get();
+  params.runner = [pool](std::function<void()> c) {
+    pool->Schedule(std::move(c));
+  };
+  params.lib = job->flr;
+  Device* device = device_;
+  params.allocator_getter = [device](AllocatorAttributes attrs) {
+    return device->GetAllocator(attrs);
+  };
+  return params;
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,113 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_WORKER_IMPL_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_WORKER_IMPL_H_
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/process_function_library_runtime.h"
+#include "tensorflow/core/distributed_runtime/data/data_service.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace data {
+
+// A worker of the tf.data service. For each job a client asks it for, the
+// worker repeatedly obtains a split of the job from the dispatcher, runs the
+// dataset graph of the job for that split on the local CPU, and returns the
+// elements of the split one at a time.
+//
+// The elements of one job are produced in order, so concurrent requests for
+// the same job are serialized; the input pipeline should use parallel
+// transformations and prefetching to keep up with the clients.
+class DataWorkerImpl : public DataWorkerInterface {
+ public:
+  // `address` is the address at which the clients reach the worker, which
+  // the worker registers with `dispatcher` in `Start()`. `num_threads` is the
+  // size of the thread pool that runs the functions of the input pipelines.
+  DataWorkerImpl(const string& address,
+                 std::unique_ptr<DataDispatcherInterface> dispatcher,
+                 int num_threads, Env* env = Env::Default());
+  ~DataWorkerImpl() override;
+
+  // Registers the worker with the dispatcher.
+  Status Start();
+
+  Status GetElement(int64 job_id, std::vector<Tensor>* components,
+                    bool* end_of_sequence) override LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Job {
+    ~Job();
+
+    mutex mu;
+    bool initialized GUARDED_BY(mu) = false;
+    // True once the dispatcher handed out all splits of the job, and the
+    // last split of this worker is exhausted.
+    bool finished GUARDED_BY(mu) = false;
+    // The number of splits the dispatcher handed out to this worker.
+    int64 num_splits GUARDED_BY(mu) = 0;
+
+    // The dataset graph of the job, and the function library it runs with.
+    std::unique_ptr<FunctionLibraryDefinition> flib_def;
+    std::unique_ptr<ProcessFunctionLibraryRuntime> pflr;
+    FunctionLibraryRuntime* flr = nullptr;  // Owned by `pflr`.
+    std::unique_ptr<Graph> graph;
+    string dataset_tensor;
+    string split_tensor;
+
+    // The dataset of the split being processed, if any, and its iterator.
+    DatasetBase* dataset GUARDED_BY(mu) = nullptr;
+    std::unique_ptr<IteratorBase> iterator GUARDED_BY(mu);
+  };
+
+  // Fetches the dataset graph of `job_id` from the dispatcher.
+  Status InitializeJob(int64 job_id, Job* job)
+      EXCLUSIVE_LOCKS_REQUIRED(job->mu);
+
+  // Creates the dataset of split `split_index` of `job`, and its iterator.
+  Status StartSplit(int64 split_index, Job* job)
+      EXCLUSIVE_LOCKS_REQUIRED(job->mu);
+
+  IteratorContext::Params IteratorParams(Job* job);
+
+  const string address_;
+  const std::unique_ptr<DataDispatcherInterface> dispatcher_;
+  Env* const env_;  // Not owned.
+  std::unique_ptr<DeviceMgr> device_mgr_;
+  Device* device_;  // Owned by `device_mgr_`.
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+
+  mutex mu_;
+  std::unordered_map<int64, std::shared_ptr<Job>> jobs_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DataWorkerImpl);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_DATA_WORKER_IMPL_H_
@@ -0,0 +1,260 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/data/worker_impl.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/distributed_runtime/data/dispatcher_impl.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Forwards to a dispatcher shared by several workers.
+class LocalDispatcher : public DataDispatcherInterface {
+ public:
+  explicit LocalDispatcher(DataDispatcherImpl* impl) : impl_(impl) {}
+
+#define DISPATCHER_METHOD(method)                                       \
+  Status method(const method##Request* request,                         \
+                method##Response* response) override {                  \
+    return impl_->method(request, response);                            \
+  }
+
+  DISPATCHER_METHOD(CreateJob);
+  DISPATCHER_METHOD(GetJob);
+  DISPATCHER_METHOD(GetSplit);
+  DISPATCHER_METHOD(RegisterWorker);
+  DISPATCHER_METHOD(GetWorkers);
+
+#undef DISPATCHER_METHOD
+
+ private:
+  DataDispatcherImpl* const impl_;
+};
+
+// A dataset whose split `i` is `range(10 * i, 10 * i + 10)`.
+DatasetDef RangeSplitsDataset() {
+  DatasetDef dataset;
+  CHECK(protobuf::TextFormat::ParseFromString(R"proto(
+    node {
+      name: "split"
+      op: "Placeholder"
+      attr { key: "dtype" value { type: DT_INT64 } }
+      attr { key: "shape" value { shape {} } }
+    }
+    node {
+      name: "ten"
+      op: "Const"
+      attr { key: "dtype" value { type: DT_INT64 } }
+      attr {
+        key: "value"
+        value { tensor { dtype: DT_INT64 tensor_shape {} int64_val: 10 } }
+      }
+    }
+    node {
+      name: "one"
+      op: "Const"
+      attr { key: "dtype" value { type: DT_INT64 } }
+      attr {
+        key: "value"
+        value { tensor { dtype: DT_INT64 tensor_shape {} int64_val: 1 } }
+      }
+    }
+    node {
+      name: "start"
+      op: "Mul"
+      input: "split"
+      input: "ten"
+      attr { key: "T" value { type: DT_INT64 } }
+    }
+    node {
+      name: "stop"
+      op: "Add"
+      input: "start"
+      input: "ten"
+      attr { key: "T" value { type: DT_INT64 } }
+    }
+    node {
+      name: "range"
+      op: "RangeDataset"
+      input: "start"
+      input: "stop"
+      input: "one"
+      attr { key: "output_types" value { list { type: DT_INT64 } } }
+      attr { key: "output_shapes" value { list { shape {} } } }
+    }
+  )proto", dataset.mutable_graph()));
+  dataset.set_dataset_tensor("range:0");
+  dataset.set_split_tensor("split:0");
+  return dataset;
+}
+
+int64 CreateJob(DataDispatcherImpl* dispatcher, int64 num_splits,
+                const string& job_name) {
+  CreateJobRequest request;
+  *request.mutable_dataset() = RangeSplitsDataset();
+  request.set_num_splits(num_splits);
+  request.set_job_name(job_name);
+  CreateJobResponse response;
+  TF_CHECK_OK(dispatcher->CreateJob(&request, &response));
+  return response.job_id();
+}
+
+TEST(DataDispatcherImplTest, HandsOutEachSplitOnce) {
+  DataDispatcherImpl dispatcher;
+  const int64 job_id = CreateJob(&dispatcher, 3, "");
+  GetSplitRequest request;
+  request.set_job_id(job_id);
+  for (int64 i = 0; i < 3; ++i) {
+    request.set_worker_address(i % 2 == 0 ? "a:1" : "b:2");
+    request.set_split_position(i / 2);
+    GetSplitResponse response;
+    TF_ASSERT_OK(dispatcher.GetSplit(&request, &response));
+    EXPECT_FALSE(response.end_of_splits());
+    EXPECT_EQ(response.split_index(), i);
+  }
+  // "a" was handed out splits 0 and 2.
+  request.set_split_position(2);
+  GetSplitResponse response;
+  TF_ASSERT_OK(dispatcher.GetSplit(&request, &response));
+  EXPECT_TRUE(response.end_of_splits());
+
+  request.set_job_id(job_id + 1);
+  EXPECT_TRUE(errors::IsNotFound(dispatcher.GetSplit(&request, &response)));
+}
+
+TEST(DataDispatcherImplTest, ReplaysSplitsHandedOut) {
+  DataDispatcherImpl dispatcher;
+  const int64 job_id = CreateJob(&dispatcher, 4, "");
+  GetSplitRequest request;
+  request.set_job_id(job_id);
+  GetSplitResponse response;
+  request.set_worker_address("a");
+  for (int64 position : {0, 1}) {
+    request.set_split_position(position);
+    TF_ASSERT_OK(dispatcher.GetSplit(&request, &response));
+  }
+  request.set_worker_address("b");
+  request.set_split_position(0);
+  TF_ASSERT_OK(dispatcher.GetSplit(&request, &response));
+  EXPECT_EQ(response.split_index(), 2);
+
+  // "a" restarts from a checkpoint taken after its first split.
+  request.set_worker_address("a");
+  request.set_split_position(1);
+  TF_ASSERT_OK(dispatcher.GetSplit(&request, &response));
+  EXPECT_EQ(response.split_index(), 1);
+  request.set_split_position(2);
+  TF_ASSERT_OK(dispatcher.GetSplit(&request, &response));
+  EXPECT_EQ(response.split_index(), 3);
+
+  request.set_split_position(4);
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(dispatcher.GetSplit(&request, &response)));
+}
+
+TEST(DataDispatcherImplTest, SharesNamedJobs) {
+  DataDispatcherImpl dispatcher;
+  const int64 job_id = CreateJob(&dispatcher, 3, "train");
+  EXPECT_EQ(CreateJob(&dispatcher, 3, "train"), job_id);
+  EXPECT_NE(CreateJob(&dispatcher, 3, "eval"), job_id);
+  EXPECT_NE(CreateJob(&dispatcher, 3, ""), CreateJob(&dispatcher, 3, ""));
+
+  CreateJobRequest request;
+  request.set_num_splits(4);
+  request.set_job_name("train");
+  CreateJobResponse response;
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(dispatcher.CreateJob(&request, &response)));
+}
+
+TEST(DataDispatcherImplTest, RegisterWorkers) {
+  DataDispatcherImpl dispatcher;
+  for (const string& address : {"a:1", "b:2", "a:1"}) {
+    RegisterWorkerRequest request;
+    request.set_worker_address(address);
+    RegisterWorkerResponse response;
+    TF_ASSERT_OK(dispatcher.RegisterWorker(&request, &response));
+  }
+  GetWorkersRequest request;
+  GetWorkersResponse response;
+  TF_ASSERT_OK(dispatcher.GetWorkers(&request, &response));
+  ASSERT_EQ(response.worker_addresses_size(), 2);
+  EXPECT_EQ(response.worker_addresses(0), "a:1");
+  EXPECT_EQ(response.worker_addresses(1), "b:2");
+}
+
+TEST(DataWorkerImplTest, WorkersShareTheSplitsOfAJob) {
+  DataDispatcherImpl dispatcher;
+  std::vector<std::unique_ptr<DataWorkerImpl>> workers;
+  for (const string& address : {"worker0:1", "worker1:1"}) {
+    workers.emplace_back(new DataWorkerImpl(
+        address,
+        std::unique_ptr<DataDispatcherInterface>(
+            new LocalDispatcher(&dispatcher)),
+        2));
+    TF_ASSERT_OK(workers.back()->Start());
+  }
+  const int64 job_id = CreateJob(&dispatcher, 5, "");
+
+  // Alternate between the workers until both are done.
+  std::vector<int64> elements;
+  std::vector<bool> finished(workers.size(), false);
+  for (int i = 0; !finished[0] || !finished[1]; ++i) {
+    const int w = i % workers.size();
+    if (finished[w]) continue;
+    std::vector<Tensor> components;
+    bool end_of_sequence = false;
+    TF_ASSERT_OK(workers[w]->GetElement(job_id, &components, &end_of_sequence));
+    if (end_of_sequence) {
+      finished[w] = true;
+      continue;
+    }
+    ASSERT_EQ(components.size(), 1);
+    elements.push_back(components[0].scalar<int64>()());
+  }
+  std::sort(elements.begin(), elements.end());
+  ASSERT_EQ(elements.size(), 50);
+  for (int64 i = 0; i < 50; ++i) {
+    EXPECT_EQ(elements[i], i);
+  }
+
+  // A finished job stays finished.
+  std::vector<Tensor> components;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(workers[0]->GetElement(job_id, &components, &end_of_sequence));
+  EXPECT_TRUE(end_of_sequence);
+}
+
+TEST(DataWorkerImplTest, UnknownJob) {
+  DataDispatcherImpl dispatcher;
+  DataWorkerImpl worker("worker:1",
+                        std::unique_ptr<DataDispatcherInterface>(
+                            new LocalDispatcher(&dispatcher)),
+                        1);
+  std::vector<Tensor> components;
+  bool end_of_sequence = false;
+  EXPECT_TRUE(errors::IsNotFound(
+      worker.GetElement(17, &components, &end_of_sequence)));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -130,4 +130,19 @@ void DeviceResolverDistributed::ClearTask(const string& task) {
   }
 }
 
+std::vector<string> DeviceResolverDistributed::RemoteTasks() {
+  std::unordered_set<string> tasks;
+  {
+    mutex_lock l(mu_);
+    for (const auto& it : attr_table_) {
+      string task;
+      string device;
+      if (DeviceNameUtils::SplitDeviceName(it.first, &task, &device)) {
+        tasks.insert(task);
+      }
+    }
+  }
+  return std::vector<string>(tasks.begin(), tasks.end());
+}
+
 }  // namespace tensorflow
@@ -44,6 +44,10 @@ class DeviceResolverDistributed : public DeviceResolverInterface {
 
   void ClearTask(const string& task) override;
 
+  // Returns the remote tasks whose device attributes are cached, i.e. the
+  // tasks whose devices take part in collectives with this task.
+  std::vector<string> RemoteTasks() LOCKS_EXCLUDED(mu_);
+
  protected:
   // Loads attr_table_ with device attributes retrieved from remote task.
   void RefreshRemoteAttributes(const string& device, const string& task,
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/graph_mgr.h"
 
+#include <algorithm>
+#include <atomic>
+#include <list>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/build_graph_options.h"
@@ -40,9 +43,14 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/graph_partition.h"
 #include "tensorflow/core/graph/validate.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
@@ -96,6 +104,132 @@ static Status ValidateGraphDefForDevices(const GraphDef& gdef) {
   return Status::OK();
 }
 
+namespace {
+
+// Runs "fn(i)" for each i in [0, n) on "pool" and the calling thread, and
+// returns when all calls are done. The calling thread takes work as well,
+// so that the calls complete even if all threads of "pool" are busy.
+void ParallelFor(thread::ThreadPool* pool, int n,
+                 const std::function<void(int)>& fn) {
+  struct State {
+    State(int n, const std::function<void(int)>& fn) : pending(n), fn(fn) {}
+    std::atomic<int> next{0};
+    BlockingCounter pending;
+    const std::function<void(int)>& fn;
+  };
+  auto state = std::make_shared<State>(n, fn);
+  auto run = [state, n]() {
+    for (int i = state->next++; i < n; i = state->next++) {
+      state->fn(i);
+      state->pending.DecrementCount();
+    }
+  };
+  if (pool != nullptr) {
+    for (int i = 1; i < std::min(n, pool->NumThreads() + 1); ++i) {
+      pool->Schedule(run);
+    }
+  }
+  run();
+  state->pending.Wait();
+}
+
+auto* partition_cache_hits = monitoring::Counter<0>::New(
+    "/tensorflow/core/graph_mgr/partition_cache_hits",
+    "The number of graph registrations that reused cached partitions.");
+
+// Maximum number of registered graphs whose partitions are cached, or 0 to
+// disable the cache.
+int64 PartitionCacheCapacity() {
+  static int64 capacity = []() {
+    int64 value;
+    Status s =
+        ReadInt64FromEnvVar("TF_GRAPH_MGR_PARTITION_CACHE_SIZE", 16, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << s.error_message();
+      value = 16;
+    }
+    return value;
+  }();
+  return capacity;
+}
+
+// Returns the key of the partitions of "gdef" in the partition cache, or 0
+// if they must not be cached. The key covers everything the partitions
+// depend on: the graph, its function library, the graph options and the
+// devices, including their incarnations, which are embedded in the
+// send/recv nodes.
+uint64 PartitionCacheKey(const GraphDef& gdef, uint64 library_fingerprint,
+                         const GraphOptions& graph_options,
+                         const DebugOptions& debug_options,
+                         const DeviceMgr* device_mgr) {
+  // The debugger publishes the graphs as it decorates them, so they are
+  // always rebuilt.
+  if (PartitionCacheCapacity() <= 0 ||
+      !debug_options.debug_tensor_watch_opts().empty()) {
+    return 0;
+  }
+  string serialized;
+  if (!SerializeToStringDeterministic(gdef, &serialized)) return 0;
+  uint64 key = FingerprintCat64(Fingerprint64(serialized), library_fingerprint);
+  if (!SerializeToStringDeterministic(graph_options, &serialized)) return 0;
+  key = FingerprintCat64(key, Fingerprint64(serialized));
+  for (const Device* device : device_mgr->ListDevices()) {
+    key = FingerprintCat64(key, Fingerprint64(device->name()));
+    key = FingerprintCat64(key, device->attributes().incarnation());
+  }
+  return key == 0 ? 1 : key;
+}
+
+}  // namespace
+
+// The optimized device subgraphs of recently registered graphs. The cache
+// holds no session state, so it is shared by the GraphMgrs of all sessions:
+// a session that registers the same graph as an earlier one, on the same
+// devices, skips graph conversion, partitioning and optimization, and only
+// creates its executors.
+class GraphMgr::PartitionCache {
+ public:
+  // Maps device names to subgraphs.
+  typedef std::unordered_map<string, std::unique_ptr<const Graph>>
+      Partitions;
+
+  static PartitionCache* Global() {
+    static PartitionCache* cache = new PartitionCache(PartitionCacheCapacity());
+    return cache;
+  }
+
+  // Returns the partitions cached under "key", or nullptr.
+  std::shared_ptr<const Partitions> Lookup(uint64 key) {
+    mutex_lock l(mu_);
+    auto iter = entries_.find(key);
+    if (iter == entries_.end()) return nullptr;
+    lru_.splice(lru_.begin(), lru_, iter->second.second);
+    return iter->second.first;
+  }
+
+  void Insert(uint64 key, std::shared_ptr<const Partitions> partitions) {
+    mutex_lock l(mu_);
+    if (entries_.count(key) > 0) return;
+    lru_.push_front(key);
+    entries_.emplace(key, std::make_pair(std::move(partitions), lru_.begin()));
+    while (entries_.size() > capacity_) {
+      entries_.erase(lru_.back());
+      lru_.pop_back();
+    }
+  }
+
+ private:
+  explicit PartitionCache(int64 capacity) : capacity_(capacity) {}
+
+  const size_t capacity_;
+  mutex mu_;
+  // Keys, most recently used first.
+  std::list<uint64> lru_ GUARDED_BY(mu_);
+  std::unordered_map<uint64, std::pair<std::shared_ptr<const Partitions>,
+                                       std::list<uint64>::iterator>>
+      entries_ GUARDED_BY(mu_);
+};
+
 Status GraphMgr::DecorateAndPublishGraphForDebug(
     const DebugOptions& debug_options, Graph* graph, Device* device) {
   std::unique_ptr<DebugGraphDecoratorInterface> decorator;
@@ -106,43 +240,23 @@ Status GraphMgr::DecorateAndPublishGraphForDebug(
   return Status::OK();
 }
 
-// Creates executors given a graph definition "gdef" of a "session".
-// If a node in "gdef" is shared by other graphs in "session", the
-// same op kernel is reused. E.g., typically a params node is shared
-// by multiple graphs in a session.
-//
-// If "gdef" is assigned to multiple devices, extra nodes (e.g.,
-// send/recv nodes) maybe added. The extra nodes' name are generated
-// by calling "new_name(old_name)".
-//
-// "executors" are filled with one executor per device if success and
-// the caller takes the ownership of returned executors.
-Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
-                          const GraphOptions& graph_options,
-                          const DebugOptions& debug_options,
-                          int64 collective_graph_key,
-                          DistributedFunctionLibraryRuntime* cluster_flr,
-                          Item* item) {
-  item->session = session;
-  item->collective_graph_key = collective_graph_key;
-  item->lib_def.reset(
-      new FunctionLibraryDefinition(OpRegistry::Global(), gdef.library()));
-
+// Converts "gdef", whose function library is "lib_def", into one graph per
+// device in "partition_graphs". Send/recv nodes are added between the
+// partitions; their names are generated by calling "new_name(old_name)".
+Status GraphMgr::PartitionGraph(
+    const GraphDef& gdef, const GraphOptions& graph_options,
+    FunctionLibraryDefinition* lib_def,
+    std::unordered_map<string, std::unique_ptr<Graph>>* partition_graphs) {
   TF_RETURN_IF_ERROR(ValidateGraphDefForDevices(gdef));
 
   if (gdef.versions().producer() >= 5) {
     // Validate the graph: we assume that merging two valid graphs
     // should maintain graph validity.
-    TF_RETURN_IF_ERROR(graph::ValidateGraphDef(gdef, *item->lib_def));
+    TF_RETURN_IF_ERROR(graph::ValidateGraphDef(gdef, *lib_def));
   }
 
-  item->proc_flr.reset(new ProcessFunctionLibraryRuntime(
-      device_mgr_, worker_env_->env, gdef.versions().producer(),
-      item->lib_def.get(), graph_options.optimizer_options(),
-      worker_env_->compute_pool, cluster_flr));
-
   // Constructs the graph out of "gdef".
-  Graph graph(OpRegistry::Global());
+  Graph graph(*lib_def);
   GraphConstructorOptions opts;
   opts.allow_internal_ops = true;
   opts.expect_device_spec = true;
@@ -173,7 +287,6 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
     TF_RETURN_IF_ERROR(AddControlEdges(popts, &partitions));
   }
 
-  std::unordered_map<string, std::unique_ptr<Graph>> partition_graphs;
   for (const auto& partition : partitions) {
     std::unique_ptr<Graph> device_graph(new Graph(OpRegistry::Global()));
     GraphConstructorOptions device_opts;
@@ -182,21 +295,72 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
     device_opts.expect_device_spec = true;
     TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(device_opts, partition.second,
                                               device_graph.get()));
-    partition_graphs.emplace(partition.first, std::move(device_graph));
+    partition_graphs->emplace(partition.first, std::move(device_graph));
   }
 
   GraphOptimizationPassOptions optimization_options;
-  optimization_options.flib_def = item->lib_def.get();
-  optimization_options.partition_graphs = &partition_graphs;
-  TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
-      OptimizationPassRegistry::POST_PARTITIONING, optimization_options));
+  optimization_options.flib_def = lib_def;
+  optimization_options.partition_graphs = partition_graphs;
+  return OptimizationPassRegistry::Global()->RunGrouping(
+      OptimizationPassRegistry::POST_PARTITIONING, optimization_options);
+}
+
+// Creates executors given a graph definition "gdef" of a "session".
+// If a node in "gdef" is shared by other graphs in "session", the
+// same op kernel is reused. E.g., typically a params node is shared
+// by multiple graphs in a session.
+//
+// If "gdef" is assigned to multiple devices, extra nodes (e.g.,
+// send/recv nodes) maybe added. The extra nodes' name are generated
+// by calling "new_name(old_name)".
+//
+// "executors" are filled with one executor per device if success and
+// the caller takes the ownership of returned executors.
+//
+// If "partition_cache_key" is not 0, the optimized device subgraphs are
+// taken from the partition cache, or added to it once built.
+Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
+                          const FunctionDefLibrary& library,
+                          const GraphOptions& graph_options,
+                          const DebugOptions& debug_options,
+                          int64 collective_graph_key,
+                          uint64 partition_cache_key,
+                          DistributedFunctionLibraryRuntime* cluster_flr,
+                          Item* item) {
+  item->session = session;
+  item->collective_graph_key = collective_graph_key;
+  item->lib_def.reset(
+      new FunctionLibraryDefinition(OpRegistry::Global(), library));
+
+  item->proc_flr.reset(new ProcessFunctionLibraryRuntime(
+      device_mgr_, worker_env_->env, gdef.versions().producer(),
+      item->lib_def.get(), graph_options.optimizer_options(),
+      worker_env_->compute_pool, cluster_flr));
 
-  LocalExecutorParams params;
+  std::shared_ptr<const PartitionCache::Partitions> cached;
+  if (partition_cache_key != 0) {
+    cached = PartitionCache::Global()->Lookup(partition_cache_key);
+  }
+  std::unordered_map<string, std::unique_ptr<Graph>> partition_graphs;
+  if (cached != nullptr) {
+    partition_cache_hits->GetCell()->IncrementBy(1);
+    for (const auto& p : *cached) {
+      std::unique_ptr<Graph> device_graph(new Graph(OpRegistry::Global()));
+      CopyGraph(*p.second, device_graph.get());
+      partition_graphs.emplace(p.first, std::move(device_graph));
+    }
+  } else {
+    TF_RETURN_IF_ERROR(PartitionGraph(gdef, graph_options,
+                                      item->lib_def.get(), &partition_graphs));
+  }
 
-  item->units.reserve(partitions.size());
+  item->units.reserve(partition_graphs.size());
   item->graph_mgr = this;
-  const auto& optimizer_opts = graph_options.optimizer_options();
-  GraphOptimizer optimizer(optimizer_opts);
+  std::vector<LocalExecutorParams> params(partition_graphs.size());
+  std::vector<std::unique_ptr<Graph>*> subgraphs;
+  subgraphs.reserve(partition_graphs.size());
+  std::vector<const string*> subgraph_devices;
+  subgraph_devices.reserve(partition_graphs.size());
   for (auto& p : partition_graphs) {
     const string& device_name = p.first;
     std::unique_ptr<Graph>& subgraph = p.second;
@@ -212,8 +376,11 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
       return s;
     }
 
-    // Give the device an opportunity to rewrite its subgraph.
-    TF_RETURN_IF_ERROR(unit->device->MaybeRewriteGraph(&subgraph));
+    // Give the device an opportunity to rewrite its subgraph. Cached
+    // subgraphs have already been rewritten.
+    if (cached == nullptr) {
+      TF_RETURN_IF_ERROR(unit->device->MaybeRewriteGraph(&subgraph));
+    }
 
     // Top-level nodes in the graph uses the op segment to cache
     // kernels. Therefore, as long as the executor is alive, we need
@@ -229,10 +396,11 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
     }
 
     // Construct the root executor for the subgraph.
-    params.device = unit->device;
-    params.function_library = lib;
-    params.create_kernel = [session, lib, opseg](const NodeDef& ndef,
-                                                 OpKernel** kernel) {
+    LocalExecutorParams& unit_params = params[subgraphs.size()];
+    unit_params.device = unit->device;
+    unit_params.function_library = lib;
+    unit_params.create_kernel = [session, lib, opseg](const NodeDef& ndef,
+                                                      OpKernel** kernel) {
       // NOTE(mrry): We must not share function kernels (implemented
       // using `CallOp`) between subgraphs, because `CallOp::handle_`
       // is tied to a particular subgraph. Even if the function itself
@@ -248,31 +416,68 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
       // on the function library here + global op registry.
       return opseg->FindOrCreate(session, ndef.name(), kernel, create_fn);
     };
-    params.delete_kernel = [lib](OpKernel* kernel) {
+    unit_params.delete_kernel = [lib](OpKernel* kernel) {
       if (kernel && !OpSegment::ShouldOwnKernel(lib, kernel->type_string())) {
         delete kernel;
       }
     };
+    subgraphs.push_back(&subgraph);
+    subgraph_devices.push_back(&device_name);
 
-    optimizer.Optimize(lib, worker_env_->env, params.device, &subgraph,
-                       /*shape_map=*/nullptr);
-
-    // TensorFlow Debugger (tfdbg) inserts debug nodes in the graph.
-    if (!debug_options.debug_tensor_watch_opts().empty()) {
-      TF_RETURN_IF_ERROR(DecorateAndPublishGraphForDebug(
-          debug_options, subgraph.get(), params.device));
-    }
-
-    TF_RETURN_IF_ERROR(
-        EnsureMemoryTypes(DeviceType(unit->device->device_type()),
-                          unit->device->name(), subgraph.get()));
-    unit->graph = subgraph.get();
     unit->build_cost_model = graph_options.build_cost_model();
     if (unit->build_cost_model > 0) {
       skip_cost_models_ = false;
     }
-    TF_RETURN_IF_ERROR(
-        NewLocalExecutor(params, std::move(subgraph), &unit->root));
+  }
+
+  // Optimizing the subgraphs and creating their kernels takes most of the
+  // time of a registration, so the executors of the devices are created in
+  // parallel.
+  const auto& optimizer_opts = graph_options.optimizer_options();
+  const bool add_to_cache = partition_cache_key != 0 && cached == nullptr;
+  std::vector<std::unique_ptr<Graph>> graphs_to_cache(subgraphs.size());
+  std::vector<Status> statuses(subgraphs.size());
+  ParallelFor(
+      worker_env_->compute_pool, subgraphs.size(), [&](int i) {
+        ExecutionUnit* unit = &item->units[i];
+        std::unique_ptr<Graph>& subgraph = *subgraphs[i];
+        if (cached == nullptr) {
+          GraphOptimizer optimizer(optimizer_opts);
+          optimizer.Optimize(params[i].function_library, worker_env_->env,
+                             params[i].device, &subgraph,
+                             /*shape_map=*/nullptr);
+
+          // TensorFlow Debugger (tfdbg) inserts debug nodes in the graph.
+          if (!debug_options.debug_tensor_watch_opts().empty()) {
+            statuses[i] = DecorateAndPublishGraphForDebug(
+                debug_options, subgraph.get(), params[i].device);
+            if (!statuses[i].ok()) return;
+          }
+
+          statuses[i] =
+              EnsureMemoryTypes(DeviceType(unit->device->device_type()),
+                                unit->device->name(), subgraph.get());
+          if (!statuses[i].ok()) return;
+          if (add_to_cache) {
+            graphs_to_cache[i].reset(new Graph(OpRegistry::Global()));
+            CopyGraph(*subgraph, graphs_to_cache[i].get());
+          }
+        }
+        unit->graph = subgraph.get();
+        statuses[i] =
+            NewLocalExecutor(params[i], std::move(subgraph), &unit->root);
+      });
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
+  }
+
+  if (add_to_cache) {
+    auto partitions = std::make_shared<PartitionCache::Partitions>();
+    for (int i = 0; i < subgraphs.size(); ++i) {
+      partitions->emplace(*subgraph_devices[i], std::move(graphs_to_cache[i]));
+    }
+    PartitionCache::Global()->Insert(partition_cache_key,
+                                     std::move(partitions));
   }
   return Status::OK();
 }
@@ -281,11 +486,37 @@ Status GraphMgr::Register(const string& session, const GraphDef& gdef,
                           const GraphOptions& graph_options,
                           const DebugOptions& debug_options,
                           int64 collective_graph_key,
+                          uint64 library_fingerprint,
                           DistributedFunctionLibraryRuntime* cluster_flr,
                           string* handle) {
+  std::shared_ptr<const FunctionDefLibrary> cached_library;
+  if (library_fingerprint != 0) {
+    const FunctionDefLibrary& library = gdef.library();
+    mutex_lock l(mu_);
+    if (library.function_size() > 0 || library.gradient_size() > 0) {
+      auto& entry = libraries_[library_fingerprint];
+      if (entry == nullptr) {
+        entry = std::make_shared<const FunctionDefLibrary>(library);
+      }
+    } else {
+      auto iter = libraries_.find(library_fingerprint);
+      if (iter == libraries_.end()) {
+        return errors::FailedPrecondition(
+            "The function library with fingerprint ", library_fingerprint,
+            " is not registered. Possibly, this worker just restarted.");
+      }
+      cached_library = iter->second;
+    }
+  }
+
   Item* item = new Item;
-  Status s = InitItem(session, gdef, graph_options, debug_options,
-                      collective_graph_key, cluster_flr, item);
+  Status s = InitItem(session, gdef,
+                      cached_library ? *cached_library : gdef.library(),
+                      graph_options, debug_options, collective_graph_key,
+                      PartitionCacheKey(gdef, library_fingerprint,
+                                        graph_options, debug_options,
+                                        device_mgr_),
+                      cluster_flr, item);
   if (!s.ok()) {
     item->Unref();
     return s;
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_GRAPH_MGR_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_GRAPH_MGR_H_
 
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -74,9 +75,18 @@ class GraphMgr {
 
   // Registers a graph. Fills in "handle". The registered graph retains a
   // reference to cluster_flr to do cross process function calls.
+  //
+  // If "library_fingerprint" is not 0, it identifies the function library
+  // of "gdef". The library is cached, and a later graph with the same
+  // fingerprint may be registered with an empty library.
+  //
+  // The optimized device graphs are cached across the GraphMgrs of the
+  // process (see TF_GRAPH_MGR_PARTITION_CACHE_SIZE), so that registering the
+  // same graph again, e.g. from a new session, only creates the executors.
   Status Register(const string& session, const GraphDef& gdef,
                   const GraphOptions& graph_options,
                   const DebugOptions& debug_options, int64 collective_graph_key,
+                  uint64 library_fingerprint,
                   DistributedFunctionLibraryRuntime* cluster_flr,
                   string* handle);
 
@@ -162,6 +172,10 @@ class GraphMgr {
   // mechanism to gc these graphs.
   std::unordered_map<string, Item*> table_;
 
+  // Function libraries of the registered graphs, keyed by fingerprint.
+  std::unordered_map<uint64, std::shared_ptr<const FunctionDefLibrary>>
+      libraries_ GUARDED_BY(mu_);
+
   void StartParallelExecutors(const string& handle, int64 step_id, Item* item,
                               Rendezvous* rendezvous,
                               CollectiveExecutor::Handle* ce_handle,
@@ -177,11 +191,22 @@ class GraphMgr {
   void BuildCostModel(Item* item, StepStatsCollector* collector,
                       CostGraphDef* cost_graph);
 
+  class PartitionCache;
+
+  // Builds "item" out of "gdef", whose function library is "library".
   Status InitItem(const string& session, const GraphDef& gdef,
+                  const FunctionDefLibrary& library,
                   const GraphOptions& graph_options,
                   const DebugOptions& debug_options, int64 collective_graph_key,
+                  uint64 partition_cache_key,
                   DistributedFunctionLibraryRuntime* cluster_flr, Item* item);
 
+  // Splits "gdef" into one graph per device.
+  Status PartitionGraph(
+      const GraphDef& gdef, const GraphOptions& graph_options,
+      FunctionLibraryDefinition* lib_def,
+      std::unordered_map<string, std::unique_ptr<Graph>>* partition_graphs);
+
   Status DecorateAndPublishGraphForDebug(const DebugOptions& debug_options,
                                          Graph* graph, Device* device);
 
@@ -0,0 +1,148 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/graph_mgr.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kCpu0[] = "/job:worker/replica:0/task:0/device:CPU:0";
+constexpr char kCpu1[] = "/job:worker/replica:0/task:0/device:CPU:1";
+
+class GraphMgrTest : public ::testing::Test {
+ protected:
+  GraphMgrTest() : pool_(Env::Default(), "graph_mgr_test", 4) {
+    SessionOptions options;
+    (*options.config.mutable_device_count())["CPU"] = 2;
+    std::vector<Device*> devices;
+    TF_CHECK_OK(DeviceFactory::AddDevices(
+        options, "/job:worker/replica:0/task:0", &devices));
+    device_mgr_.reset(new DeviceMgr(devices));
+    env_.env = Env::Default();
+    env_.device_mgr = device_mgr_.get();
+    env_.compute_pool = &pool_;
+    graph_mgr_.reset(new GraphMgr(&env_, device_mgr_.get()));
+  }
+
+  // Returns a graph that copies a constant from kCpu0 to kCpu1, with the
+  // function library "library".
+  GraphDef MakeGraph(const FunctionDefLibrary& library) {
+    Graph graph(OpRegistry::Global());
+    Node* a = test::graph::Constant(&graph, test::AsScalar<float>(1));
+    a->set_assigned_device_name(kCpu0);
+    Node* b = test::graph::Identity(&graph, a);
+    b->set_assigned_device_name(kCpu1);
+    GraphDef gdef;
+    graph.ToGraphDef(&gdef);
+    *gdef.mutable_library() = library;
+    return gdef;
+  }
+
+  Status Register(const GraphDef& gdef, uint64 library_fingerprint,
+                  string* handle) {
+    return graph_mgr_->Register("session", gdef, GraphOptions(),
+                                DebugOptions(), /*collective_graph_key=*/0,
+                                library_fingerprint, /*cluster_flr=*/nullptr,
+                                handle);
+  }
+
+  // Returns the number of registrations that reused cached partitions.
+  static int64 PartitionCacheHits() {
+    auto metrics = monitoring::CollectionRegistry::Default()->CollectMetrics(
+        monitoring::CollectionRegistry::CollectMetricsOptions());
+    auto iter = metrics->point_set_map.find(
+        "/tensorflow/core/graph_mgr/partition_cache_hits");
+    if (iter == metrics->point_set_map.end()) return 0;
+    return iter->second->points[0]->int64_value;
+  }
+
+  thread::ThreadPool pool_;
+  std::unique_ptr<DeviceMgr> device_mgr_;
+  WorkerEnv env_;
+  std::unique_ptr<GraphMgr> graph_mgr_;
+};
+
+TEST_F(GraphMgrTest, RegistersGraphOnSeveralDevices) {
+  string handle;
+  TF_ASSERT_OK(Register(MakeGraph(FunctionDefLibrary()), 0, &handle));
+  TF_EXPECT_OK(graph_mgr_->Deregister(handle));
+}
+
+TEST_F(GraphMgrTest, RegistersGraphWithCachedLibrary) {
+  FunctionDefLibrary library;
+  *library.add_function() = test::function::XTimesTwo();
+  string first_handle;
+  TF_ASSERT_OK(Register(MakeGraph(library), 17, &first_handle));
+  // The library was cached by the first registration.
+  string second_handle;
+  TF_ASSERT_OK(Register(MakeGraph(FunctionDefLibrary()), 17, &second_handle));
+  EXPECT_NE(first_handle, second_handle);
+  TF_EXPECT_OK(graph_mgr_->Deregister(first_handle));
+  TF_EXPECT_OK(graph_mgr_->Deregister(second_handle));
+}
+
+TEST_F(GraphMgrTest, ReusesPartitionsAcrossGraphMgrs) {
+  GraphDef gdef = MakeGraph(FunctionDefLibrary());
+  (*gdef.mutable_node(0)->mutable_attr())["_test_key"].set_i(1);
+  string first_handle;
+  TF_ASSERT_OK(Register(gdef, 0, &first_handle));
+  const int64 hits = PartitionCacheHits();
+
+  // The graph manager of another session on the same devices.
+  GraphMgr other_graph_mgr(&env_, device_mgr_.get());
+  string second_handle;
+  TF_ASSERT_OK(other_graph_mgr.Register(
+      "other_session", gdef, GraphOptions(), DebugOptions(),
+      /*collective_graph_key=*/0, /*library_fingerprint=*/0,
+      /*cluster_flr=*/nullptr, &second_handle));
+  EXPECT_EQ(hits + 1, PartitionCacheHits());
+
+  // A different graph is built from scratch.
+  (*gdef.mutable_node(0)->mutable_attr())["_test_key"].set_i(2);
+  string third_handle;
+  TF_ASSERT_OK(Register(gdef, 0, &third_handle));
+  EXPECT_EQ(hits + 1, PartitionCacheHits());
+
+  TF_EXPECT_OK(graph_mgr_->Deregister(first_handle));
+  TF_EXPECT_OK(other_graph_mgr.Deregister(second_handle));
+  TF_EXPECT_OK(graph_mgr_->Deregister(third_handle));
+}
+
+TEST_F(GraphMgrTest, FailsWithUnknownLibrary) {
+  string handle;
+  Status s = Register(MakeGraph(FunctionDefLibrary()), 17, &handle);
+  EXPECT_TRUE(errors::IsFailedPrecondition(s)) << s;
+}
+
+}  // namespace
+}  // namespace tensorflow
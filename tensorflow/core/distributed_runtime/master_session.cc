@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/master_session.h"
 
+#include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -44,18 +45,40 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
+// The fingerprints of the function libraries that each worker cached when
+// it registered a graph of the session.
+struct MasterSession::RegisteredLibraries {
+  bool Contains(const string& worker, uint64 fingerprint) {
+    mutex_lock l(mu);
+    auto iter = fingerprints.find(worker);
+    return iter != fingerprints.end() && iter->second.count(fingerprint) > 0;
+  }
+
+  void Add(const string& worker, uint64 fingerprint) {
+    mutex_lock l(mu);
+    fingerprints[worker].insert(fingerprint);
+  }
+
+  mutex mu;
+  std::unordered_map<string, std::unordered_set<uint64>> fingerprints
+      GUARDED_BY(mu);
+};
+
 // MasterSession wraps ClientGraph in a reference counted object.
 // This way, MasterSession can clear up the cache mapping Run requests to
 // compiled graphs while the compiled graph is still being used.
@@ -68,7 +91,10 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
                     const SessionOptions& session_opts,
                     const StatsPublisherFactory& stats_publisher_factory,
                     bool is_partial, WorkerCacheInterface* worker_cache,
-                    bool should_deregister)
+                    bool should_deregister,
+                    const std::unordered_map<string, int64>&
+                        clock_offsets_micros,
+                    std::shared_ptr<RegisteredLibraries> registered_libraries)
       : session_handle_(handle),
         bg_opts_(bopts),
         client_graph_(std::move(cg)),
@@ -76,7 +102,9 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
         is_partial_(is_partial),
         callable_opts_(bopts.callable_options),
         worker_cache_(worker_cache),
-        should_deregister_(should_deregister) {
+        should_deregister_(should_deregister),
+        clock_offsets_micros_(clock_offsets_micros),
+        registered_libraries_(std::move(registered_libraries)) {
     VLOG(1) << "Created ReffedClientGraph for node with "
             << client_graph()->graph.num_node_ids();
 
@@ -102,6 +130,11 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
 
   const CallableOptions& callable_options() { return callable_opts_; }
 
+  // The number of steps each RunGraph call runs on the workers.
+  int64 steps_per_run() const {
+    return std::max<int64>(callable_opts_.steps_per_run(), 1);
+  }
+
   const BuildGraphOptions& build_graph_options() { return bg_opts_; }
 
   std::unique_ptr<ProfileHandler> GetProfileHandler(uint64 step,
@@ -237,6 +270,10 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   WorkerCacheInterface* const worker_cache_;  // Not owned.
   std::unordered_map<StringPiece, Node*, StringPieceHasher> name_to_node_;
   const bool should_deregister_;
+  // The clock offsets of the workers, passed to them to align their traces.
+  const std::unordered_map<string, int64> clock_offsets_micros_;
+  // The function libraries cached by the workers of the session.
+  const std::shared_ptr<RegisteredLibraries> registered_libraries_;
   std::atomic<int64> execution_count_ = {0};
 
   // Graph partitioned into per-location subgraphs.
@@ -409,6 +446,37 @@ Status MasterSession::ReffedClientGraph::DoBuildPartitions(
   return Partition(popts, &client_graph_->graph, out_partitions);
 }
 
+namespace {
+
+// Returns the maximum number of RegisterGraph calls that a MasterSession
+// issues concurrently. Registering all partitions of a large cluster at once
+// floods the network with graphs.
+int64 MaxConcurrentRegisterGraphCalls() {
+  static int64 max_calls = []() {
+    int64 value;
+    Status s = ReadInt64FromEnvVar("TF_REGISTER_GRAPH_MAX_PARALLELISM", 64,
+                                   &value);
+    if (!s.ok()) {
+      LOG(ERROR) << s.error_message();
+      value = 64;
+    }
+    return value > 0 ? value : 64;
+  }();
+  return max_calls;
+}
+
+// Returns the fingerprint of "library", or 0 if it is empty.
+uint64 LibraryFingerprint(const FunctionDefLibrary& library) {
+  if (library.function_size() == 0 && library.gradient_size() == 0) {
+    return 0;
+  }
+  string serialized;
+  if (!SerializeToStringDeterministic(library, &serialized)) return 0;
+  return Fingerprint64(serialized);
+}
+
+}  // namespace
+
 Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
     const PartitionOptions& popts,
     std::unordered_map<string, GraphDef> graph_partitions) {
@@ -438,8 +506,17 @@ Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
     Status status;
   };
   const int num = partitions_.size();
+  // All partitions carry the function library of the client graph. The
+  // workers of a session cache the libraries they are sent (see
+  // GraphMgr::Register()), so a library is only sent to a worker once.
+  // Workers without a session share their graph manager across sessions
+  // and restarts of the master, so they are always sent the library.
+  uint64 library_fingerprint = 0;
+  if (!should_deregister_ && num > 0) {
+    library_fingerprint =
+        LibraryFingerprint(graph_partitions.begin()->second.library());
+  }
   gtl::InlinedVector<Call, 4> calls(num);
-  BlockingCounter done(num);
   for (int i = 0; i < num; ++i) {
     const Part& part = partitions_[i];
     Call* c = &calls[i];
@@ -450,18 +527,47 @@ Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
     *c->req.mutable_debug_options() =
         callable_opts_.run_options().debug_options();
     c->req.set_collective_graph_key(client_graph()->collective_graph_key);
+    if (library_fingerprint != 0) {
+      c->req.set_library_fingerprint(library_fingerprint);
+      if (registered_libraries_->Contains(part.name, library_fingerprint)) {
+        c->req.mutable_graph_def()->clear_library();
+      }
+    }
     VLOG(2) << "Register " << c->req.graph_def().DebugString();
-    auto cb = [c, &done](const Status& s) {
-      c->status = s;
-      done.DecrementCount();
-    };
-    part.worker->RegisterGraphAsync(&c->req, &c->resp, cb);
+  }
+
+  // Issues at most MaxConcurrentRegisterGraphCalls() calls at a time. Each
+  // call issues the next one when it is done.
+  BlockingCounter done(num);
+  mutex mu;
+  int next_call = 0;
+  std::function<void()> issue_next_call = [&]() {
+    int i;
+    {
+      mutex_lock l(mu);
+      if (next_call == num) return;
+      i = next_call++;
+    }
+    Call* c = &calls[i];
+    partitions_[i].worker->RegisterGraphAsync(
+        &c->req, &c->resp, [c, &done, &issue_next_call](const Status& s) {
+          c->status = s;
+          issue_next_call();
+          done.DecrementCount();
+        });
+  };
+  const int64 max_calls = MaxConcurrentRegisterGraphCalls();
+  for (int64 i = 0; i < std::min<int64>(num, max_calls); ++i) {
+    issue_next_call();
   }
   done.Wait();
   for (int i = 0; i < num; ++i) {
     Call* c = &calls[i];
     s.Update(c->status);
     partitions_[i].graph_handle = c->resp.graph_handle();
+    if (c->status.ok() && library_fingerprint != 0) {
+      registered_libraries_->Add(partitions_[i].name, library_fingerprint);
+    }
   }
   return s;
 }
@@ -605,7 +711,14 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
     c->req->set_create_worker_session_called(!should_deregister_);
     c->req->set_graph_handle(part.graph_handle);
     c->req->set_step_id(step_id);
+    if (steps_per_run() > 1) {
+      c->req->set_num_steps(steps_per_run());
+    }
     *c->req->mutable_exec_opts() = exec_opts;
+    auto offset = clock_offsets_micros_.find(part.name);
+    if (offset != clock_offsets_micros_.end()) {
+      c->req->mutable_exec_opts()->set_clock_offset_micros(offset->second);
+    }
     c->req->set_store_errors_in_response_body(true);
     // If any feeds are provided, send the feed values together
     // in the RunGraph request.
@@ -846,6 +959,9 @@ void MasterSession::ReffedClientGraph::CleanupPartitionsAsync(
   // Helper object will be deleted when the final call completes.
   CleanupBroadcastHelper* helper =
       new CleanupBroadcastHelper(step_id, num, std::move(done));
+  if (steps_per_run() > 1) {
+    helper->request()->set_num_steps(steps_per_run());
+  }
   for (int i = 0; i < num; ++i) {
     const Part& part = partitions_[i];
     part.worker->CleanupGraphAsync(
@@ -1151,7 +1267,8 @@ MasterSession::MasterSession(
       stats_publisher_factory_(std::move(stats_publisher_factory)),
       graph_version_(0),
       run_graphs_(5),
-      partial_run_graphs_(5) {
+      partial_run_graphs_(5),
+      registered_libraries_(std::make_shared<RegisteredLibraries>()) {
   UpdateLastAccessTime();
   CHECK(devices_) << "device_set was null!";
 
@@ -1213,6 +1330,11 @@ Status MasterSession::CreateWorkerSessions(
     CreateWorkerSessionRequest request;
     CreateWorkerSessionResponse response;
     Status status = Status::OK();
+
+    // The times on the master's clock when the request was sent and the
+    // response received.
+    int64 send_micros = 0;
+    int64 receive_micros = 0;
   };
   BlockingCounter done(worker_names.size());
   std::vector<WorkerGroup> workers(worker_names.size());
@@ -1264,9 +1386,11 @@ Status MasterSession::CreateWorkerSessions(
 
   for (size_t i = 0; i < worker_names.size(); ++i) {
     auto cb = [i, &workers, &done](const Status& s) {
+      workers[i].receive_micros = Env::Default()->NowMicros();
       workers[i].status = s;
       done.DecrementCount();
     };
+    workers[i].send_micros = Env::Default()->NowMicros();
     workers[i].worker->CreateWorkerSessionAsync(&workers[i].request,
                                                 &workers[i].response, cb);
   }
@@ -1274,6 +1398,13 @@ Status MasterSession::CreateWorkerSessions(
   done.Wait();
   for (size_t i = 0; i < workers.size(); ++i) {
     status.Update(workers[i].status);
+    // Assuming that the request and the response took as long, the worker
+    // read its clock halfway through the round trip.
+    if (workers[i].status.ok() && workers[i].response.worker_time_micros()) {
+      clock_offsets_micros_[worker_names[i]] =
+          workers[i].response.worker_time_micros() -
+          (workers[i].send_micros + workers[i].receive_micros) / 2;
+    }
   }
   return status;
 }
@@ -1417,7 +1548,8 @@ Status MasterSession::StartStep(const BuildGraphOptions& opts, bool is_partial,
       auto entry = new ReffedClientGraph(
           handle_, opts, std::move(client_graph), session_opts_,
           stats_publisher_factory_, is_partial, worker_cache,
-          !should_delete_worker_sessions_);
+          !should_delete_worker_sessions_, clock_offsets_micros_,
+          registered_libraries_);
       iter = m->insert({hash, entry}).first;
       VLOG(1) << "Preparing to execute new graph";
     }
@@ -1876,10 +2008,18 @@ Status MasterSession::MakeCallable(const MakeCallableRequest& req,
     }
     std::unique_ptr<ClientGraph> client_graph;
     TF_RETURN_IF_ERROR(execution_state_->BuildGraph(opts, &client_graph));
+    if (req.options().steps_per_run() > 1 &&
+        client_graph->collective_graph_key !=
+            BuildGraphOptions::kNoCollectiveGraphKey) {
+      return errors::Unimplemented(
+          "steps_per_run is not supported for graphs with collective ops.");
+    }
     callable = new ReffedClientGraph(handle_, opts, std::move(client_graph),
                                      session_opts_, stats_publisher_factory_,
                                      false /* is_partial */, get_worker_cache(),
-                                     !should_delete_worker_sessions_);
+                                     !should_delete_worker_sessions_,
+                                     clock_offsets_micros_,
+                                     registered_libraries_);
   }
 
   Status s = BuildAndRegisterPartitions(callable);
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_MASTER_SESSION_H_
 
 #include <atomic>
+#include <memory>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/debugger_state_interface.h"
@@ -220,6 +221,14 @@ class MasterSession : public core::RefCounted {
   // workers.
   Status CreateWorkerSessions(const WorkerCacheFactoryOptions& server_def);
 
+  // The offsets of the clocks of the workers from the clock of the master, in
+  // microseconds, estimated by `CreateWorkerSessions()`.
+  std::unordered_map<string, int64> clock_offsets_micros_;
+
+  // The function libraries that the workers cached for this session.
+  struct RegisteredLibraries;
+  const std::shared_ptr<RegisteredLibraries> registered_libraries_;
+
   bool should_delete_worker_sessions_ = false;
   Status DeleteWorkerSessions();
 
@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/distributed_runtime/message_wrappers.h"
+
+#include <algorithm>
+
 #include "tensorflow/core/framework/cost_graph.pb.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -373,6 +376,12 @@ void InMemoryRunGraphRequest::set_is_last_partial_run(
   is_last_partial_run_ = is_last_partial_run;
 }
 
+int64 InMemoryRunGraphRequest::num_steps() const { return num_steps_; }
+
+void InMemoryRunGraphRequest::set_num_steps(int64 num_steps) {
+  num_steps_ = num_steps;
+}
+
 bool InMemoryRunGraphRequest::store_errors_in_response_body() const {
   return store_errors_in_response_body_;
 }
@@ -401,6 +410,7 @@ const RunGraphRequest& InMemoryRunGraphRequest::ToProto() const {
     }
     proto_version_->set_is_partial(is_partial());
     proto_version_->set_is_last_partial_run(is_last_partial_run());
+    proto_version_->set_num_steps(num_steps());
   }
   return *proto_version_;
 }
@@ -513,6 +523,14 @@ void MutableProtoRunGraphRequest::set_is_last_partial_run(
   request_.set_is_last_partial_run(is_last_partial_run);
 }
 
+int64 MutableProtoRunGraphRequest::num_steps() const {
+  return std::max<int64>(request_.num_steps(), 1);
+}
+
+void MutableProtoRunGraphRequest::set_num_steps(int64 num_steps) {
+  request_.set_num_steps(num_steps);
+}
+
 bool MutableProtoRunGraphRequest::store_errors_in_response_body() const {
   return request_.store_errors_in_response_body();
 }
@@ -575,6 +593,10 @@ bool ProtoRunGraphRequest::is_last_partial_run() const {
   return request_->is_last_partial_run();
 }
 
+int64 ProtoRunGraphRequest::num_steps() const {
+  return std::max<int64>(request_->num_steps(), 1);
+}
+
 bool ProtoRunGraphRequest::store_errors_in_response_body() const {
   return request_->store_errors_in_response_body();
 }
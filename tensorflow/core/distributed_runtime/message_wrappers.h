@@ -279,6 +279,11 @@ class RunGraphRequestWrapper {
   // True if this is the last partial run request in a sequence of requests.
   virtual bool is_last_partial_run() const = 0;
 
+  // The number of times to run the graph, with consecutive step ids starting
+  // at `step_id`. The feeds are passed to every run and the fetches hold the
+  // values of the last run.
+  virtual int64 num_steps() const = 0;
+
   // If true then some errors, e.g., execution errors that have long
   // error messages, may return an OK RunStepResponse with the actual
   // error saved in the status_code/status_error_message fields of the
@@ -313,6 +318,7 @@ class MutableRunGraphRequestWrapper : public RunGraphRequestWrapper {
   virtual void add_recv_key(const string& recv_key) = 0;
   virtual void set_is_partial(bool is_partial) = 0;
   virtual void set_is_last_partial_run(bool is_last_partial_run) = 0;
+  virtual void set_num_steps(int64 num_steps) = 0;
   virtual void set_store_errors_in_response_body(bool store_errors) = 0;
 };
 
@@ -331,6 +337,7 @@ class InMemoryRunGraphRequest : public MutableRunGraphRequestWrapper {
   const string& recv_key(size_t i) const override;
   bool is_partial() const override;
   bool is_last_partial_run() const override;
+  int64 num_steps() const override;
   const RunGraphRequest& ToProto() const override;
   bool store_errors_in_response_body() const override;
 
@@ -349,6 +356,7 @@ class InMemoryRunGraphRequest : public MutableRunGraphRequestWrapper {
   void add_recv_key(const string& recv_key) override;
   void set_is_partial(bool is_partial) override;
   void set_is_last_partial_run(bool is_last_partial_run) override;
+  void set_num_steps(int64 num_steps) override;
   void set_store_errors_in_response_body(bool store_errors) override;
 
  private:
@@ -361,6 +369,7 @@ class InMemoryRunGraphRequest : public MutableRunGraphRequestWrapper {
   gtl::InlinedVector<string, 4> recvs_;
   bool is_partial_ = false;
   bool is_last_partial_run_ = false;
+  int64 num_steps_ = 1;
   bool store_errors_in_response_body_ = false;
 
   // Holds a cached and owned representation of the proto
@@ -388,6 +397,7 @@ class MutableProtoRunGraphRequest : public MutableRunGraphRequestWrapper {
   const string& recv_key(size_t i) const override;
   bool is_partial() const override;
   bool is_last_partial_run() const override;
+  int64 num_steps() const override;
   bool store_errors_in_response_body() const override;
   const RunGraphRequest& ToProto() const override;
 
@@ -406,6 +416,7 @@ class MutableProtoRunGraphRequest : public MutableRunGraphRequestWrapper {
   void add_recv_key(const string& recv_key) override;
   void set_is_partial(bool is_partial) override;
   void set_is_last_partial_run(bool is_last_partial_run) override;
+  void set_num_steps(int64 num_steps) override;
   void set_store_errors_in_response_body(bool store_errors) override;
 
  private:
@@ -429,6 +440,7 @@ class ProtoRunGraphRequest : public RunGraphRequestWrapper {
   const string& recv_key(size_t i) const override;
   bool is_partial() const override;
   bool is_last_partial_run() const override;
+  int64 num_steps() const override;
   bool store_errors_in_response_body() const override;
   const RunGraphRequest& ToProto() const override;
 
@@ -81,6 +81,7 @@ void BuildRunGraphRequest(const RunStepRequestWrapper& run_step_request,
   run_graph_request->add_recv_key("recv_2");
   run_graph_request->add_recv_key("recv_3");
   run_graph_request->set_is_partial(true);
+  run_graph_request->set_num_steps(5);
 }
 
 void CheckRunGraphRequest(const RunGraphRequestWrapper& request) {
@@ -97,6 +98,7 @@ void CheckRunGraphRequest(const RunGraphRequestWrapper& request) {
   test::ExpectTensorEqual<int32>(TensorB(), val);
   EXPECT_TRUE(request.is_partial());
   EXPECT_FALSE(request.is_last_partial_run());
+  EXPECT_EQ(5, request.num_steps());
 }
 
 void BuildRunGraphResponse(MutableRunGraphResponseWrapper* run_graph_response) {
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
@@ -90,4 +91,10 @@ TEST_F(RemoteDeviceTest, GetStatus) {
   EXPECT_EQ(devices_[1]->attributes().memory_limit(), 256 << 20);
 }
 
+TEST_F(RemoteDeviceTest, GetMetrics) {
+  GetMetricsRequest request;
+  GetMetricsResponse response;
+  TF_EXPECT_OK(wi_->GetMetrics(&request, &response));
+}
+
 }  // namespace tensorflow
@@ -0,0 +1,112 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "grpcpp/grpcpp.h"
+#include "grpcpp/security/credentials.h"
+#include "grpcpp/server_builder.h"
+
+#include "tensorflow/core/distributed_runtime/data/dispatcher_impl.h"
+#include "tensorflow/core/distributed_runtime/data/worker_impl.h"
+#include "tensorflow/core/distributed_runtime/rpc/data/grpc_data_client.h"
+#include "tensorflow/core/distributed_runtime/rpc/data/grpc_data_service_impl.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/host_info.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+// This binary starts a tf.data service dispatcher, or a tf.data service worker
+// that registers with a dispatcher. See
+// "//tensorflow/core/protobuf/data_service.proto".
+
+int main(int argc, char* argv[]) {
+  tensorflow::string role;
+  int port = 0;
+  tensorflow::string dispatcher_address;
+  tensorflow::string worker_address;
+  int num_rpc_threads = 32;
+  int num_threads = tensorflow::port::NumSchedulableCPUs();
+  std::vector<tensorflow::Flag> flag_list = {
+      tensorflow::Flag("role", &role, "\"dispatcher\" or \"worker\""),
+      tensorflow::Flag("port", &port, "port to serve on"),
+      tensorflow::Flag("dispatcher_address", &dispatcher_address,
+                       "host:port of the dispatcher, for workers"),
+      tensorflow::Flag("worker_address", &worker_address,
+                       "host:port at which clients reach this worker; "
+                       "defaults to the hostname and --port"),
+      tensorflow::Flag("num_rpc_threads", &num_rpc_threads,
+                       "number of threads serving requests, which bounds the "
+                       "number of concurrent requests"),
+      tensorflow::Flag("num_threads", &num_threads,
+                       "number of threads running the input pipelines, for "
+                       "workers"),
+  };
+  tensorflow::string usage = tensorflow::Flags::Usage(argv[0], flag_list);
+  const bool parse_result = tensorflow::Flags::Parse(&argc, argv, flag_list);
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  if (!parse_result || argc != 1 || port <= 0 ||
+      (role != "dispatcher" && role != "worker") ||
+      (role == "worker" && dispatcher_address.empty())) {
+    std::cerr << usage << std::endl;
+    return -1;
+  }
+
+  ::grpc::ServerBuilder builder;
+  builder.AddListeningPort(tensorflow::strings::StrCat("0.0.0.0:", port),
+                           ::grpc::InsecureServerCredentials());
+  builder.SetMaxMessageSize(std::numeric_limits<tensorflow::int32>::max());
+  tensorflow::thread::ThreadPool rpc_pool(tensorflow::Env::Default(),
+                                          "data_service_rpc", num_rpc_threads);
+
+  std::unique_ptr<tensorflow::data::DataDispatcherImpl> dispatcher;
+  std::unique_ptr<tensorflow::data::DataWorkerImpl> worker;
+  std::unique_ptr<tensorflow::AsyncServiceInterface> service;
+  if (role == "dispatcher") {
+    dispatcher.reset(new tensorflow::data::DataDispatcherImpl());
+    service.reset(new tensorflow::data::GrpcDataDispatcherService(
+        dispatcher.get(), &rpc_pool, &builder));
+  } else {
+    std::unique_ptr<tensorflow::data::DataDispatcherInterface> client;
+    TF_QCHECK_OK(tensorflow::data::NewGrpcDataDispatcherClient(
+        dispatcher_address, &client));
+    if (worker_address.empty()) {
+      worker_address =
+          tensorflow::strings::StrCat(tensorflow::port::Hostname(), ":", port);
+    }
+    worker.reset(new tensorflow::data::DataWorkerImpl(
+        worker_address, std::move(client), num_threads));
+    service.reset(new tensorflow::data::GrpcDataWorkerService(
+        worker.get(), &rpc_pool, &builder));
+  }
+  std::unique_ptr<::grpc::Server> server = builder.BuildAndStart();
+  if (server == nullptr) {
+    std::cerr << "ERROR: Could not start the server on port " << port
+              << std::endl;
+    return -1;
+  }
+  if (worker != nullptr) {
+    // Clients may use the worker as soon as it is registered.
+    TF_QCHECK_OK(worker->Start());
+  }
+  LOG(INFO) << "Started tf.data service " << role << " on port " << port;
+  service->HandleRPCsLoop();
+}
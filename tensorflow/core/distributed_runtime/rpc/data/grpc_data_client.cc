@@ -0,0 +1,102 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/data/grpc_data_client.h"
+
+#include "grpcpp/client_context.h"
+#include "tensorflow/core/distributed_runtime/rpc/data/grpc_data_service.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+class GrpcDataDispatcherClient : public DataDispatcherInterface {
+ public:
+  explicit GrpcDataDispatcherClient(const SharedGrpcChannelPtr& channel)
+      : stub_(grpc::DataDispatcherService::NewStub(channel)) {}
+
+#define CLIENT_METHOD(method)                                               \
+  Status method(const method##Request* request,                             \
+                method##Response* response) override {                     \
+    ::grpc::ClientContext context;                                          \
+    return FromGrpcStatus(stub_->method(&context, *request, response));     \
+  }
+
+  CLIENT_METHOD(CreateJob);
+  CLIENT_METHOD(GetJob);
+  CLIENT_METHOD(GetSplit);
+  CLIENT_METHOD(RegisterWorker);
+  CLIENT_METHOD(GetWorkers);
+
+#undef CLIENT_METHOD
+
+ private:
+  std::unique_ptr<grpc::DataDispatcherService::Stub> stub_;
+};
+
+class GrpcDataWorkerClient : public DataWorkerInterface {
+ public:
+  explicit GrpcDataWorkerClient(const SharedGrpcChannelPtr& channel)
+      : stub_(grpc::DataWorkerService::NewStub(channel)) {}
+
+  Status GetElement(int64 job_id, std::vector<Tensor>* components,
+                    bool* end_of_sequence) override {
+    GetElementRequest request;
+    request.set_job_id(job_id);
+    GetElementResponse response;
+    ::grpc::ClientContext context;
+    TF_RETURN_IF_ERROR(
+        FromGrpcStatus(stub_->GetElement(&context, request, &response)));
+    components->clear();
+    components->reserve(response.components_size());
+    for (const RecvTensorResponse& component : response.components()) {
+      Tensor tensor;
+      if (!tensor.FromProto(component.tensor())) {
+        return errors::DataLoss("Failed to parse a component of job ", job_id,
+                                " from the tf.data service");
+      }
+      components->push_back(std::move(tensor));
+    }
+    *end_of_sequence = response.end_of_sequence();
+    return Status::OK();
+  }
+
+ private:
+  std::unique_ptr<grpc::DataWorkerService::Stub> stub_;
+};
+
+}  // namespace
+
+Status NewGrpcDataDispatcherClient(
+    const string& address, std::unique_ptr<DataDispatcherInterface>* client) {
+  SharedGrpcChannelPtr channel;
+  TF_RETURN_IF_ERROR(NewHostPortGrpcChannel(address, &channel));
+  client->reset(new GrpcDataDispatcherClient(channel));
+  return Status::OK();
+}
+
+Status NewGrpcDataWorkerClient(const string& address,
+                               std::unique_ptr<DataWorkerInterface>* client) {
+  SharedGrpcChannelPtr channel;
+  TF_RETURN_IF_ERROR(NewHostPortGrpcChannel(address, &channel));
+  client->reset(new GrpcDataWorkerClient(channel));
+  return Status::OK();
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,146 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/data/grpc_data_service.h"
+
+#include "grpcpp/impl/codegen/async_stream.h"
+#include "grpcpp/impl/codegen/async_unary_call.h"
+#include "grpcpp/impl/codegen/channel_interface.h"
+#include "grpcpp/impl/codegen/client_unary_call.h"
+#include "grpcpp/impl/codegen/method_handler_impl.h"
+#include "grpcpp/impl/codegen/rpc_service_method.h"
+#include "grpcpp/impl/codegen/service_type.h"
+#include "grpcpp/impl/codegen/sync_stream.h"
+
+namespace tensorflow {
+namespace data {
+
+namespace grpc {
+
+static const char* grpcDataDispatcherService_method_names[] = {
+    "/tensorflow.data.DataDispatcherService/CreateJob",
+    "/tensorflow.data.DataDispatcherService/GetJob",
+    "/tensorflow.data.DataDispatcherService/GetSplit",
+    "/tensorflow.data.DataDispatcherService/RegisterWorker",
+    "/tensorflow.data.DataDispatcherService/GetWorkers",
+};
+
+std::unique_ptr<DataDispatcherService::Stub> DataDispatcherService::NewStub(
+    const std::shared_ptr< ::grpc::ChannelInterface>& channel,
+    const ::grpc::StubOptions& options) {
+  std::unique_ptr<DataDispatcherService::Stub> stub(
+      new DataDispatcherService::Stub(channel));
+  return stub;
+}
+
+DataDispatcherService::Stub::Stub(
+    const std::shared_ptr< ::grpc::ChannelInterface>& channel)
+    : channel_(channel),
+      rpcmethod_CreateJob_(grpcDataDispatcherService_method_names[0],
+                           ::grpc::internal::RpcMethod::NORMAL_RPC, channel),
+      rpcmethod_GetJob_(grpcDataDispatcherService_method_names[1],
+                        ::grpc::internal::RpcMethod::NORMAL_RPC, channel),
+      rpcmethod_GetSplit_(grpcDataDispatcherService_method_names[2],
+                          ::grpc::internal::RpcMethod::NORMAL_RPC, channel),
+      rpcmethod_RegisterWorker_(grpcDataDispatcherService_method_names[3],
+                                ::grpc::internal::RpcMethod::NORMAL_RPC,
+                                channel),
+      rpcmethod_GetWorkers_(grpcDataDispatcherService_method_names[4],
+                            ::grpc::internal::RpcMethod::NORMAL_RPC, channel) {}
+
+::grpc::Status DataDispatcherService::Stub::CreateJob(
+    ::grpc::ClientContext* context, const CreateJobRequest& request,
+    CreateJobResponse* response) {
+  return ::grpc::internal::BlockingUnaryCall(
+      channel_.get(), rpcmethod_CreateJob_, context, request, response);
+}
+
+::grpc::Status DataDispatcherService::Stub::GetJob(
+    ::grpc::ClientContext* context, const GetJobRequest& request,
+    GetJobResponse* response) {
+  return ::grpc::internal::BlockingUnaryCall(channel_.get(), rpcmethod_GetJob_,
+                                             context, request, response);
+}
+
+::grpc::Status DataDispatcherService::Stub::GetSplit(
+    ::grpc::ClientContext* context, const GetSplitRequest& request,
+    GetSplitResponse* response) {
+  return ::grpc::internal::BlockingUnaryCall(
+      channel_.get(), rpcmethod_GetSplit_, context, request, response);
+}
+
+::grpc::Status DataDispatcherService::Stub::RegisterWorker(
+    ::grpc::ClientContext* context, const RegisterWorkerRequest& request,
+    RegisterWorkerResponse* response) {
+  return ::grpc::internal::BlockingUnaryCall(
+      channel_.get(), rpcmethod_RegisterWorker_, context, request, response);
+}
+
+::grpc::Status DataDispatcherService::Stub::GetWorkers(
+    ::grpc::ClientContext* context, const GetWorkersRequest& request,
+    GetWorkersResponse* response) {
+  return ::grpc::internal::BlockingUnaryCall(
+      channel_.get(), rpcmethod_GetWorkers_, context, request, response);
+}
+
+DataDispatcherService::AsyncService::AsyncService() {
+  for (int i = 0; i < 5; ++i) {
+    AddMethod(new ::grpc::internal::RpcServiceMethod(
+        grpcDataDispatcherService_method_names[i],
+        ::grpc::internal::RpcMethod::NORMAL_RPC, nullptr));
+    ::grpc::Service::MarkMethodAsync(i);
+  }
+}
+
+DataDispatcherService::AsyncService::~AsyncService() {}
+
+static const char* grpcDataWorkerService_method_names[] = {
+    "/tensorflow.data.DataWorkerService/GetElement",
+};
+
+std::unique_ptr<DataWorkerService::Stub> DataWorkerService::NewStub(
+    const std::shared_ptr< ::grpc::ChannelInterface>& channel,
+    const ::grpc::StubOptions& options) {
+  std::unique_ptr<DataWorkerService::Stub> stub(
+      new DataWorkerService::Stub(channel));
+  return stub;
+}
+
+DataWorkerService::Stub::Stub(
+    const std::shared_ptr< ::grpc::ChannelInterface>& channel)
+    : channel_(channel),
+      rpcmethod_GetElement_(grpcDataWorkerService_method_names[0],
+                            ::grpc::internal::RpcMethod::NORMAL_RPC, channel) {}
+
+::grpc::Status DataWorkerService::Stub::GetElement(
+    ::grpc::ClientContext* context, const GetElementRequest& request,
+    GetElementResponse* response) {
+  return ::grpc::internal::BlockingUnaryCall(
+      channel_.get(), rpcmethod_GetElement_, context, request, response);
+}
+
+DataWorkerService::AsyncService::AsyncService() {
+  AddMethod(new ::grpc::internal::RpcServiceMethod(
+      grpcDataWorkerService_method_names[0],
+      ::grpc::internal::RpcMethod::NORMAL_RPC, nullptr));
+  ::grpc::Service::MarkMethodAsync(0);
+}
+
+DataWorkerService::AsyncService::~AsyncService() {}
+
+}  // namespace grpc
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,169 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_GRPC_DATA_SERVICE_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_GRPC_DATA_SERVICE_H_
+
+#include "grpcpp/impl/codegen/async_stream.h"
+#include "grpcpp/impl/codegen/async_unary_call.h"
+#include "grpcpp/impl/codegen/proto_utils.h"
+#include "grpcpp/impl/codegen/rpc_method.h"
+#include "grpcpp/impl/codegen/service_type.h"
+#include "grpcpp/impl/codegen/status.h"
+#include "grpcpp/impl/codegen/stub_options.h"
+#include "grpcpp/impl/codegen/sync_stream.h"
+#include "grpcpp/support/byte_buffer.h"
+
+#include "tensorflow/core/protobuf/data_service.pb.h"
+
+namespace grpc {
+class CompletionQueue;
+class Channel;
+class RpcService;
+class ServerCompletionQueue;
+class ServerContext;
+}  // namespace grpc
+
+namespace tensorflow {
+namespace data {
+
+namespace grpc {
+
+// GRPC stubs of `tensorflow.data.DataDispatcherService` and
+// `tensorflow.data.DataWorkerService`, based on the definitions in
+// "//tensorflow/core/protobuf/data_service.proto", and the gRPC generated
+// stub and service classes. See that file for the definition of methods and
+// messages. Like the other TensorFlow GRPC services, these are not gen'ned
+// via a rule, but included as an implementation directly.
+class DataDispatcherService final {
+ public:
+  class Stub final {
+   public:
+    Stub(const std::shared_ptr< ::grpc::ChannelInterface>& channel);
+    ::grpc::Status CreateJob(::grpc::ClientContext* context,
+                             const CreateJobRequest& request,
+                             CreateJobResponse* response);
+    ::grpc::Status GetJob(::grpc::ClientContext* context,
+                          const GetJobRequest& request,
+                          GetJobResponse* response);
+    ::grpc::Status GetSplit(::grpc::ClientContext* context,
+                            const GetSplitRequest& request,
+                            GetSplitResponse* response);
+    ::grpc::Status RegisterWorker(::grpc::ClientContext* context,
+                                  const RegisterWorkerRequest& request,
+                                  RegisterWorkerResponse* response);
+    ::grpc::Status GetWorkers(::grpc::ClientContext* context,
+                              const GetWorkersRequest& request,
+                              GetWorkersResponse* response);
+
+   private:
+    std::shared_ptr< ::grpc::ChannelInterface> channel_;
+    const ::grpc::internal::RpcMethod rpcmethod_CreateJob_;
+    const ::grpc::internal::RpcMethod rpcmethod_GetJob_;
+    const ::grpc::internal::RpcMethod rpcmethod_GetSplit_;
+    const ::grpc::internal::RpcMethod rpcmethod_RegisterWorker_;
+    const ::grpc::internal::RpcMethod rpcmethod_GetWorkers_;
+  };
+  static std::unique_ptr<Stub> NewStub(
+      const std::shared_ptr< ::grpc::ChannelInterface>& channel,
+      const ::grpc::StubOptions& options = ::grpc::StubOptions());
+
+  class AsyncService : public ::grpc::Service {
+   public:
+    AsyncService();
+    virtual ~AsyncService();
+    void RequestCreateJob(
+        ::grpc::ServerContext* context, CreateJobRequest* request,
+        ::grpc::ServerAsyncResponseWriter<CreateJobResponse>* response,
+        ::grpc::CompletionQueue* new_call_cq,
+        ::grpc::ServerCompletionQueue* notification_cq, void* tag) {
+      ::grpc::Service::RequestAsyncUnary(0, context, request, response,
+                                         new_call_cq, notification_cq, tag);
+    }
+    void RequestGetJob(
+        ::grpc::ServerContext* context, GetJobRequest* request,
+        ::grpc::ServerAsyncResponseWriter<GetJobResponse>* response,
+        ::grpc::CompletionQueue* new_call_cq,
+        ::grpc::ServerCompletionQueue* notification_cq, void* tag) {
+      ::grpc::Service::RequestAsyncUnary(1, context, request, response,
+                                         new_call_cq, notification_cq, tag);
+    }
+    void RequestGetSplit(
+        ::grpc::ServerContext* context, GetSplitRequest* request,
+        ::grpc::ServerAsyncResponseWriter<GetSplitResponse>* response,
+        ::grpc::CompletionQueue* new_call_cq,
+        ::grpc::ServerCompletionQueue* notification_cq, void* tag) {
+      ::grpc::Service::RequestAsyncUnary(2, context, request, response,
+                                         new_call_cq, notification_cq, tag);
+    }
+    void RequestRegisterWorker(
+        ::grpc::ServerContext* context, RegisterWorkerRequest* request,
+        ::grpc::ServerAsyncResponseWriter<RegisterWorkerResponse>* response,
+        ::grpc::CompletionQueue* new_call_cq,
+        ::grpc::ServerCompletionQueue* notification_cq, void* tag) {
+      ::grpc::Service::RequestAsyncUnary(3, context, request, response,
+                                         new_call_cq, notification_cq, tag);
+    }
+    void RequestGetWorkers(
+        ::grpc::ServerContext* context, GetWorkersRequest* request,
+        ::grpc::ServerAsyncResponseWriter<GetWorkersResponse>* response,
+        ::grpc::CompletionQueue* new_call_cq,
+        ::grpc::ServerCompletionQueue* notification_cq, void* tag) {
+      ::grpc::Service::RequestAsyncUnary(4, context, request, response,
+                                         new_call_cq, notification_cq, tag);
+    }
+  };
+};
+
+class DataWorkerService final {
+ public:
+  class Stub final {
+   public:
+    Stub(const std::shared_ptr< ::grpc::ChannelInterface>& channel);
+    ::grpc::Status GetElement(::grpc::ClientContext* context,
+                              const GetElementRequest& request,
+                              GetElementResponse* response);
+
+   private:
+    std::shared_ptr< ::grpc::ChannelInterface> channel_;
+    const ::grpc::internal::RpcMethod rpcmethod_GetElement_;
+  };
+  static std::unique_ptr<Stub> NewStub(
+      const std::shared_ptr< ::grpc::ChannelInterface>& channel,
+      const ::grpc::StubOptions& options = ::grpc::StubOptions());
+
+  class AsyncService : public ::grpc::Service {
+   public:
+    AsyncService();
+    virtual ~AsyncService();
+    // The response is an encoded `GetElementResponse`, so that the tensors
+    // of the element are sent without copying them.
+    void RequestGetElement(
+        ::grpc::ServerContext* context, GetElementRequest* request,
+        ::grpc::ServerAsyncResponseWriter< ::grpc::ByteBuffer>* response,
+        ::grpc::CompletionQueue* new_call_cq,
+        ::grpc::ServerCompletionQueue* notification_cq, void* tag) {
+      ::grpc::Service::RequestAsyncUnary(0, context, request, response,
+                                         new_call_cq, notification_cq, tag);
+    }
+  };
+};
+
+}  // namespace grpc
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_GRPC_DATA_SERVICE_H_
@@ -0,0 +1,168 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/data/grpc_data_service_impl.h"
+
+#include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/slice.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/io/proto_encode_helper.h"
+#include "tensorflow/core/util/ptr_util.h"
+
+namespace tensorflow {
+namespace data {
+
+void EncodeElementToByteBuffer(const std::vector<Tensor>& components,
+                               bool end_of_sequence,
+                               ::grpc::ByteBuffer* result) {
+  // Each component is a length-delimited `RecvTensorResponse`, whose slices
+  // share the tensor buffer where possible.
+  std::vector< ::grpc::Slice> slices;
+  for (const Tensor& component : components) {
+    ::grpc::ByteBuffer encoded;
+    tensorflow::grpc::EncodeTensorToByteBuffer(false /* is_dead */, component,
+                                               &encoded);
+    char header[1 + core::kMaxVarint32Bytes];
+    io::ProtoEncodeHelper e(header, sizeof(header));
+    e.WriteVarlengthBeginning(GetElementResponse::kComponentsFieldNumber,
+                              encoded.Length());
+    slices.emplace_back(e.data(), e.size());
+    std::vector< ::grpc::Slice> component_slices;
+    (void)encoded.Dump(&component_slices);
+    for (::grpc::Slice& slice : component_slices) {
+      slices.push_back(std::move(slice));
+    }
+  }
+  if (end_of_sequence) {
+    char buf[2];
+    io::ProtoEncodeHelper e(buf, sizeof(buf));
+    e.WriteBool(GetElementResponse::kEndOfSequenceFieldNumber, true);
+    slices.emplace_back(e.data(), e.size());
+  }
+  ::grpc::ByteBuffer tmp(slices.data(), slices.size());
+  result->Swap(&tmp);
+}
+
+GrpcDataDispatcherService::GrpcDataDispatcherService(
+    DataDispatcherInterface* impl, thread::ThreadPool* pool,
+    ::grpc::ServerBuilder* server_builder)
+    : impl_(impl), pool_(pool) {
+  server_builder->RegisterService(&service_);
+  cq_ = server_builder->AddCompletionQueue();
+}
+
+void GrpcDataDispatcherService::HandleRPCsLoop() {
+#define ENQUEUE_REQUEST(method)                                        \
+  do {                                                                 \
+    DispatcherCall<method##Request, method##Response>::EnqueueRequest( \
+        &service_, cq_.get(),                                          \
+        &grpc::DataDispatcherService::AsyncService::Request##method,   \
+        &GrpcDataDispatcherService::method##Handler, false);           \
+  } while (0)
+  ENQUEUE_REQUEST(CreateJob);
+  ENQUEUE_REQUEST(GetJob);
+  ENQUEUE_REQUEST(GetSplit);
+  ENQUEUE_REQUEST(RegisterWorker);
+  ENQUEUE_REQUEST(GetWorkers);
+#undef ENQUEUE_REQUEST
+
+  void* tag;  // Matches the operation started against this cq_.
+  bool ok;
+
+  while (true) {
+    if (!cq_->Next(&tag, &ok)) {
+      // The queue is shutting down.
+      break;
+    }
+    UntypedCall<GrpcDataDispatcherService>::Tag* callback_tag =
+        static_cast<UntypedCall<GrpcDataDispatcherService>::Tag*>(tag);
+
+    if (callback_tag) {
+      callback_tag->OnCompleted(this, ok);
+    } else {
+      cq_->Shutdown();
+      break;
+    }
+  }
+}
+
+void GrpcDataDispatcherService::Shutdown() {
+  // This enqueues a special event (with a null tag)
+  // that causes the completion queue to be shut down on the
+  // polling thread.
+  shutdown_alarm_ = MakeUnique< ::grpc::Alarm>(
+      cq_.get(), gpr_now(GPR_CLOCK_MONOTONIC), nullptr);
+}
+
+GrpcDataWorkerService::GrpcDataWorkerService(
+    DataWorkerInterface* impl, thread::ThreadPool* pool,
+    ::grpc::ServerBuilder* server_builder)
+    : impl_(impl), pool_(pool) {
+  server_builder->RegisterService(&service_);
+  cq_ = server_builder->AddCompletionQueue();
+}
+
+void GrpcDataWorkerService::GetElementHandler(
+    WorkerCall<GetElementRequest, ::grpc::ByteBuffer>* call) {
+  pool_->Schedule([this, call]() {
+    std::vector<Tensor> components;
+    bool end_of_sequence = false;
+    Status s = impl_->GetElement(call->request.job_id(), &components,
+                                 &end_of_sequence);
+    if (s.ok()) {
+      EncodeElementToByteBuffer(components, end_of_sequence, &call->response);
+    }
+    call->SendResponse(ToGrpcStatus(s));
+  });
+  WorkerCall<GetElementRequest, ::grpc::ByteBuffer>::EnqueueRequest(
+      &service_, cq_.get(),
+      &grpc::DataWorkerService::AsyncService::RequestGetElement,
+      &GrpcDataWorkerService::GetElementHandler, false);
+}
+
+void GrpcDataWorkerService::HandleRPCsLoop() {
+  WorkerCall<GetElementRequest, ::grpc::ByteBuffer>::EnqueueRequest(
+      &service_, cq_.get(),
+      &grpc::DataWorkerService::AsyncService::RequestGetElement,
+      &GrpcDataWorkerService::GetElementHandler, false);
+
+  void* tag;  // Matches the operation started against this cq_.
+  bool ok;
+
+  while (true) {
+    if (!cq_->Next(&tag, &ok)) {
+      // The queue is shutting down.
+      break;
+    }
+    UntypedCall<GrpcDataWorkerService>::Tag* callback_tag =
+        static_cast<UntypedCall<GrpcDataWorkerService>::Tag*>(tag);
+
+    if (callback_tag) {
+      callback_tag->OnCompleted(this, ok);
+    } else {
+      cq_->Shutdown();
+      break;
+    }
+  }
+}
+
+void GrpcDataWorkerService::Shutdown() {
+  shutdown_alarm_ = MakeUnique< ::grpc::Alarm>(
+      cq_.get(), gpr_now(GPR_CLOCK_MONOTONIC), nullptr);
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,124 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_GRPC_DATA_SERVICE_IMPL_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_GRPC_DATA_SERVICE_IMPL_H_
+
+#include <vector>
+
+#include "grpcpp/alarm.h"
+#include "grpcpp/completion_queue.h"
+#include "grpcpp/server_builder.h"
+#include "tensorflow/core/distributed_runtime/data/data_service.h"
+#include "tensorflow/core/distributed_runtime/rpc/async_service_interface.h"
+#include "tensorflow/core/distributed_runtime/rpc/data/grpc_data_service.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_call.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+
+namespace tensorflow {
+namespace data {
+
+// Encodes an element into a byte buffer in a format that is parseable as a
+// `GetElementResponse` holding the element, without copying the tensor
+// buffers of its components.
+//
+// Discards original contents of *result.
+void EncodeElementToByteBuffer(const std::vector<Tensor>& components,
+                               bool end_of_sequence,
+                               ::grpc::ByteBuffer* result);
+
+// Serves the dispatcher `impl` over gRPC. The calls are run on `pool`.
+class GrpcDataDispatcherService : public AsyncServiceInterface {
+ public:
+  template <class RequestMessage, class ResponseMessage>
+  using DispatcherCall =
+      Call<GrpcDataDispatcherService, grpc::DataDispatcherService::AsyncService,
+           RequestMessage, ResponseMessage>;
+
+  GrpcDataDispatcherService(DataDispatcherInterface* impl,
+                            thread::ThreadPool* pool,
+                            ::grpc::ServerBuilder* server_builder);
+  ~GrpcDataDispatcherService() override {}
+
+  void HandleRPCsLoop() override;
+  void Shutdown() override;
+
+ private:
+#define HANDLER(method)                                                      \
+  void method##Handler(                                                      \
+      DispatcherCall<method##Request, method##Response>* call) {             \
+    pool_->Schedule([this, call]() {                                         \
+      call->SendResponse(                                                    \
+          ToGrpcStatus(impl_->method(&call->request, &call->response)));     \
+    });                                                                      \
+    DispatcherCall<method##Request, method##Response>::EnqueueRequest(       \
+        &service_, cq_.get(),                                                \
+        &grpc::DataDispatcherService::AsyncService::Request##method,         \
+        &GrpcDataDispatcherService::method##Handler, false);                 \
+  }
+  HANDLER(CreateJob);
+  HANDLER(GetJob);
+  HANDLER(GetSplit);
+  HANDLER(RegisterWorker);
+  HANDLER(GetWorkers);
+#undef HANDLER
+
+  DataDispatcherInterface* const impl_;  // Not owned.
+  thread::ThreadPool* const pool_;       // Not owned.
+
+  std::unique_ptr< ::grpc::Alarm> shutdown_alarm_;
+
+  std::unique_ptr< ::grpc::ServerCompletionQueue> cq_;
+  grpc::DataDispatcherService::AsyncService service_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GrpcDataDispatcherService);
+};
+
+// Serves the worker `impl` over gRPC. The calls are run on `pool`, which
+// bounds the number of elements the worker produces concurrently.
+class GrpcDataWorkerService : public AsyncServiceInterface {
+ public:
+  template <class RequestMessage, class ResponseMessage>
+  using WorkerCall = Call<GrpcDataWorkerService,
+                          grpc::DataWorkerService::AsyncService,
+                          RequestMessage, ResponseMessage>;
+
+  GrpcDataWorkerService(DataWorkerInterface* impl, thread::ThreadPool* pool,
+                        ::grpc::ServerBuilder* server_builder);
+  ~GrpcDataWorkerService() override {}
+
+  void HandleRPCsLoop() override;
+  void Shutdown() override;
+
+ private:
+  void GetElementHandler(
+      WorkerCall<GetElementRequest, ::grpc::ByteBuffer>* call);
+
+  DataWorkerInterface* const impl_;  // Not owned.
+  thread::ThreadPool* const pool_;   // Not owned.
+
+  std::unique_ptr< ::grpc::Alarm> shutdown_alarm_;
+
+  std::unique_ptr< ::grpc::ServerCompletionQueue> cq_;
+  grpc::DataWorkerService::AsyncService service_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GrpcDataWorkerService);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_DATA_GRPC_DATA_SERVICE_IMPL_H_
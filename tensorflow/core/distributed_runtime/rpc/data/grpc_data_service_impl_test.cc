@@ -0,0 +1,176 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/data/grpc_data_service_impl.h"
+
+#include "grpcpp/grpcpp.h"
+#include "grpcpp/security/credentials.h"
+#include "grpcpp/server_builder.h"
+#include "tensorflow/core/distributed_runtime/data/dispatcher_impl.h"
+#include "tensorflow/core/distributed_runtime/rpc/data/grpc_data_client.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/net.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+TEST(EncodeElementToByteBufferTest, ParsesAsGetElementResponse) {
+  Tensor small = test::AsTensor<int64>({1, 2, 3});
+  Tensor large(DT_FLOAT, TensorShape({1024}));
+  large.flat<float>().setConstant(2.5);
+  Tensor text = test::AsTensor<string>({"a", "bc"});
+  ::grpc::ByteBuffer buffer;
+  EncodeElementToByteBuffer({small, large, text}, false, &buffer);
+
+  GetElementResponse response;
+  ASSERT_TRUE(GrpcMaybeParseProto(&buffer, &response));
+  EXPECT_FALSE(response.end_of_sequence());
+  ASSERT_EQ(response.components_size(), 3);
+  Tensor parsed;
+  ASSERT_TRUE(parsed.FromProto(response.components(0).tensor()));
+  test::ExpectTensorEqual<int64>(parsed, small);
+  ASSERT_TRUE(parsed.FromProto(response.components(1).tensor()));
+  test::ExpectTensorEqual<float>(parsed, large);
+  ASSERT_TRUE(parsed.FromProto(response.components(2).tensor()));
+  test::ExpectTensorEqual<string>(parsed, text);
+
+  EncodeElementToByteBuffer({}, true, &buffer);
+  ASSERT_TRUE(GrpcMaybeParseProto(&buffer, &response));
+  EXPECT_TRUE(response.end_of_sequence());
+  EXPECT_EQ(response.components_size(), 0);
+}
+
+// A worker whose job 0 produces 0, 1, ..., 4.
+class FakeWorker : public DataWorkerInterface {
+ public:
+  Status GetElement(int64 job_id, std::vector<Tensor>* components,
+                    bool* end_of_sequence) override {
+    if (job_id != 0) {
+      return errors::NotFound("Unknown job ", job_id);
+    }
+    mutex_lock l(mu_);
+    *end_of_sequence = next_ >= 5;
+    if (!*end_of_sequence) {
+      *components = {test::AsScalar<int64>(next_++)};
+    }
+    return Status::OK();
+  }
+
+ private:
+  mutex mu_;
+  int64 next_ GUARDED_BY(mu_) = 0;
+};
+
+// Serves `service` on a new port of localhost until destroyed.
+class TestServer {
+ public:
+  template <class Service, class Impl>
+  static std::unique_ptr<TestServer> Create(Impl* impl) {
+    std::unique_ptr<TestServer> server(new TestServer);
+    server->port_ = internal::PickUnusedPortOrDie();
+    ::grpc::ServerBuilder builder;
+    builder.AddListeningPort(strings::StrCat("localhost:", server->port_),
+                             ::grpc::InsecureServerCredentials());
+    server->service_.reset(new Service(impl, &server->pool_, &builder));
+    server->server_ = builder.BuildAndStart();
+    CHECK(server->server_ != nullptr);
+    AsyncServiceInterface* service = server->service_.get();
+    server->thread_.reset(Env::Default()->StartThread(
+        {}, "test_server", [service]() { service->HandleRPCsLoop(); }));
+    return server;
+  }
+
+  ~TestServer() {
+    server_->Shutdown();
+    service_->Shutdown();
+    thread_.reset();
+  }
+
+  string address() const { return strings::StrCat("localhost:", port_); }
+
+ private:
+  TestServer() : pool_(Env::Default(), "test_server_rpc", 4) {}
+
+  int port_;
+  thread::ThreadPool pool_;
+  std::unique_ptr<AsyncServiceInterface> service_;
+  std::unique_ptr< ::grpc::Server> server_;
+  std::unique_ptr<Thread> thread_;
+};
+
+TEST(GrpcDataServiceTest, Dispatcher) {
+  DataDispatcherImpl impl;
+  std::unique_ptr<TestServer> server =
+      TestServer::Create<GrpcDataDispatcherService>(&impl);
+  std::unique_ptr<DataDispatcherInterface> client;
+  TF_ASSERT_OK(NewGrpcDataDispatcherClient(server->address(), &client));
+
+  RegisterWorkerRequest register_request;
+  register_request.set_worker_address("worker:1");
+  RegisterWorkerResponse register_response;
+  TF_ASSERT_OK(client->RegisterWorker(&register_request, &register_response));
+  GetWorkersRequest workers_request;
+  GetWorkersResponse workers_response;
+  TF_ASSERT_OK(client->GetWorkers(&workers_request, &workers_response));
+  ASSERT_EQ(workers_response.worker_addresses_size(), 1);
+  EXPECT_EQ(workers_response.worker_addresses(0), "worker:1");
+
+  CreateJobRequest create_request;
+  create_request.mutable_dataset()->set_dataset_tensor("dataset:0");
+  create_request.set_num_splits(2);
+  CreateJobResponse create_response;
+  TF_ASSERT_OK(client->CreateJob(&create_request, &create_response));
+  GetJobRequest job_request;
+  job_request.set_job_id(create_response.job_id());
+  GetJobResponse job_response;
+  TF_ASSERT_OK(client->GetJob(&job_request, &job_response));
+  EXPECT_EQ(job_response.dataset().dataset_tensor(), "dataset:0");
+  EXPECT_EQ(job_response.num_splits(), 2);
+
+  job_request.set_job_id(create_response.job_id() + 1);
+  EXPECT_TRUE(
+      errors::IsNotFound(client->GetJob(&job_request, &job_response)));
+}
+
+TEST(GrpcDataServiceTest, Worker) {
+  FakeWorker impl;
+  std::unique_ptr<TestServer> server =
+      TestServer::Create<GrpcDataWorkerService>(&impl);
+  std::unique_ptr<DataWorkerInterface> client;
+  TF_ASSERT_OK(NewGrpcDataWorkerClient(server->address(), &client));
+
+  std::vector<Tensor> components;
+  bool end_of_sequence = false;
+  for (int64 i = 0; i < 5; ++i) {
+    TF_ASSERT_OK(client->GetElement(0, &components, &end_of_sequence));
+    ASSERT_FALSE(end_of_sequence);
+    ASSERT_EQ(components.size(), 1);
+    test::ExpectTensorEqual<int64>(components[0], test::AsScalar<int64>(i));
+  }
+  TF_ASSERT_OK(client->GetElement(0, &components, &end_of_sequence));
+  EXPECT_TRUE(end_of_sequence);
+  EXPECT_TRUE(errors::IsNotFound(
+      client->GetElement(1, &components, &end_of_sequence)));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
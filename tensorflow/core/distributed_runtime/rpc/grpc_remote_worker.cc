@@ -26,17 +26,39 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/trace_exporter.h"
 #include "tensorflow/core/distributed_runtime/worker_cache_logger.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
+namespace {
+
+// Returns true if RegisterGraph requests are compressed.
+bool CompressRegisterGraph() {
+  static bool compress = []() {
+    bool value;
+    Status s =
+        ReadBoolFromEnvVar("TF_GRPC_COMPRESS_REGISTER_GRAPH", true, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << s.error_message();
+      value = true;
+    }
+    return value;
+  }();
+  return compress;
+}
+
+}  // namespace
+
 class GrpcRemoteWorker : public WorkerInterface {
  public:
   explicit GrpcRemoteWorker(SharedGrpcChannelPtr channel,
@@ -60,6 +82,8 @@ class GrpcRemoteWorker : public WorkerInterface {
         completegroup_(Method(GrpcWorkerMethod::kCompleteGroup)),
         instancesource_(Method(GrpcWorkerMethod::kCompleteInstance)),
         getstepsequence_(Method(GrpcWorkerMethod::kGetStepSequence)),
+        batchrecvtensor_(Method(GrpcWorkerMethod::kBatchRecvTensor)),
+        getmetrics_(Method(GrpcWorkerMethod::kGetMetrics)),
         logger_(logger) {}
 
   ~GrpcRemoteWorker() override {}
@@ -87,7 +111,11 @@ class GrpcRemoteWorker : public WorkerInterface {
   void RegisterGraphAsync(const RegisterGraphRequest* request,
                           RegisterGraphResponse* response,
                           StatusCallback done) override {
-    IssueRequest(request, response, registergraph_, std::move(done));
+    // Graphs compress well, and a registration is not latency sensitive.
+    new RPCState<protobuf::Message>(
+        &stub_, cq_, registergraph_, *request, response, std::move(done),
+        /*call_opts=*/nullptr, /*fail_fast=*/false, /*timeout_in_ms=*/0,
+        CompressRegisterGraph() ? GRPC_COMPRESS_GZIP : GRPC_COMPRESS_NONE);
   }
 
   void DeregisterGraphAsync(const DeregisterGraphRequest* request,
@@ -124,6 +152,14 @@ class GrpcRemoteWorker : public WorkerInterface {
     IssueRequest(request, response, recvbuf_, std::move(done), call_opts);
   }
 
+  void BatchRecvTensorAsync(CallOptions* call_opts,
+                            const BatchRecvTensorRequest* request,
+                            BatchRecvTensorResponse* response,
+                            StatusCallback done) override {
+    IssueRequest(request, response, batchrecvtensor_, std::move(done),
+                 call_opts);
+  }
+
   void CompleteGroupAsync(CallOptions* call_opts,
                           const CompleteGroupRequest* request,
                           CompleteGroupResponse* response,
@@ -145,18 +181,41 @@ class GrpcRemoteWorker : public WorkerInterface {
     IssueRequest(request, response, getstepsequence_, std::move(done));
   }
 
+  void GetMetricsAsync(const GetMetricsRequest* request,
+                       GetMetricsResponse* response,
+                       StatusCallback done) override {
+    IssueRequest(request, response, getmetrics_, std::move(done));
+  }
+
   void RecvTensorAsync(CallOptions* call_opts, const RecvTensorRequest* request,
                        TensorResponse* response, StatusCallback done) override {
     VLOG(1) << "RecvTensorAsync req: " << request->DebugString();
     int64 start_usec = Env::Default()->NowMicros();
     // Type-specialized logging for this method.
-    bool logging_active = logger_->LoggingActive() || VLOG_IS_ON(2);
+    TraceExporter* exporter = TraceExporter::Global();
+    bool logging_active =
+        logger_->LoggingActive() || VLOG_IS_ON(2) || exporter != nullptr;
     StatusCallback wrapper_done;
     const StatusCallback* cb_to_use;
     if (!logging_active) {
       cb_to_use = &done;  // No additional work to do, so just use done directly
     } else {
-      wrapper_done = [this, request, response, done, start_usec](Status s) {
+      wrapper_done = [this, request, response, done, start_usec,
+                      exporter](Status s) {
+        if (exporter != nullptr) {
+          // The tensor name is the fourth part of the rendezvous key.
+          std::vector<string> key_parts =
+              str_util::Split(request->rendezvous_key(), ';');
+          exporter->ExportRpc(
+              request->step_id(),
+              strings::StrCat("RecvTensor ", key_parts.size() == 5
+                                                 ? key_parts[3]
+                                                 : request->rendezvous_key()),
+              TraceExporter::RecvTensorFlowId(request->step_id(),
+                                              request->rendezvous_key()),
+              false /* is_flow_start */, start_usec,
+              Env::Default()->NowMicros());
+        }
         if (logger_->LoggingActive()) {
           int64 end_usec = Env::Default()->NowMicros();
           int64 step_id = request->step_id();
@@ -251,6 +310,8 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::string completegroup_;
   const ::grpc::string instancesource_;
   const ::grpc::string getstepsequence_;
+  const ::grpc::string batchrecvtensor_;
+  const ::grpc::string getmetrics_;
 
   // Support for logging.
   WorkerCacheLogger* logger_;
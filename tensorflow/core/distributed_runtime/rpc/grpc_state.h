@@ -25,6 +25,8 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/notification.h"
 
 namespace tensorflow {
@@ -44,12 +46,19 @@ class RPCState : public GrpcClientCQTag {
   RPCState(::grpc::GenericStub* stub, ::grpc::CompletionQueue* cq,
            const ::grpc::string& method, const Request& request,
            Response* response, StatusCallback done, CallOptions* call_opts,
-           bool fail_fast, int64 timeout_in_ms)
-      : call_opts_(call_opts), done_(std::move(done)) {
+           bool fail_fast, int64 timeout_in_ms,
+           grpc_compression_algorithm compression = GRPC_COMPRESS_NONE)
+      : call_opts_(call_opts),
+        done_(std::move(done)),
+        latency_cell_(metrics::GetRpcLatencyCell(method)),
+        start_time_usecs_(Env::Default()->NowMicros()) {
     context_.set_fail_fast(fail_fast);
     if (timeout_in_ms > 0) {
       context_.set_deadline(gpr_time_from_millis(timeout_in_ms, GPR_TIMESPAN));
     }
+    if (compression != GRPC_COMPRESS_NONE) {
+      context_.set_compression_algorithm(compression);
+    }
 
     if (call_opts) {
       call_opts->SetCancelCallback([this]() { context_.TryCancel(); });
@@ -83,6 +92,7 @@ class RPCState : public GrpcClientCQTag {
     if (!s.ok()) {
       VLOG(2) << "Call returned with non-ok status: " << s;
     }
+    latency_cell_->Add(Env::Default()->NowMicros() - start_time_usecs_);
     done_(s);
     delete this;
   }
@@ -96,6 +106,8 @@ class RPCState : public GrpcClientCQTag {
   ::grpc::ByteBuffer response_buf_;
   ::grpc::Status status_;
   StatusCallback done_;
+  monitoring::SamplerCell* const latency_cell_;  // Not owned.
+  const uint64 start_time_usecs_;
 };
 
 }  // namespace tensorflow
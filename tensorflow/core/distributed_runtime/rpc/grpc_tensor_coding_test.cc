@@ -17,15 +17,25 @@ limitations under the License.
 
 #include "grpcpp/support/byte_buffer.h"
 #include "grpcpp/support/slice.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 
 namespace tensorflow {
 
+// Matches the threshold in EncodeTensorToByteBuffer above which tensor
+// contents are aliased rather than copied.
+constexpr size_t kLargeTensorBytes = 1024;
+
 class GrpcTensorCodingTest : public ::testing::Test {
  public:
   void Validate(const Tensor& t, bool is_dead) {
@@ -36,6 +46,16 @@ class GrpcTensorCodingTest : public ::testing::Test {
     // Make a string
     std::vector<::grpc::Slice> slices;
     (void)buf.Dump(&slices);
+
+    // Large tensors of memcpy-able types must be sent without copying:
+    // the last slice aliases the tensor's own buffer.
+    if (DataTypeCanUseMemcpy(t.dtype()) &&
+        t.TotalBytes() > kLargeTensorBytes) {
+      ASSERT_EQ(2, slices.size());
+      EXPECT_EQ(t.tensor_data().data(),
+                reinterpret_cast<const char*>(slices[1].begin()));
+      EXPECT_EQ(t.TotalBytes(), slices[1].size());
+    }
     string tmp;
     for (const auto& s : slices) {
       tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
@@ -100,4 +120,40 @@ TEST_F(GrpcTensorCodingTest, Simple) {
 
 TEST_F(GrpcTensorCodingTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+class CpuDevice : public DeviceBase {
+ public:
+  explicit CpuDevice(Env* env) : DeviceBase(env) {
+    attr_.set_device_type("CPU");
+  }
+
+  const DeviceAttributes& attributes() const override { return attr_; }
+
+  Allocator* GetAllocator(AllocatorAttributes attr) override {
+    return cpu_allocator();
+  }
+
+ private:
+  DeviceAttributes attr_;
+};
+
+// Models one RecvTensor exchange: the sender encodes the tensor into a
+// ByteBuffer and the receiver decodes it into a TensorResponse.
+static void BM_RecvTensorRoundTrip(int iters, int num_floats) {
+  testing::StopTiming();
+  Tensor src(DT_FLOAT, TensorShape({static_cast<int64>(num_floats)}));
+  src.flat<float>().setConstant(1.0f);
+  CpuDevice cpu_device(Env::Default());
+  testing::BytesProcessed(static_cast<int64>(iters) * src.TotalBytes());
+  testing::StartTiming();
+  while (--iters >= 0) {
+    ::grpc::ByteBuffer buf;
+    grpc::EncodeTensorToByteBuffer(false, src, &buf);
+    GrpcByteSource source(&buf);
+    TensorResponse response;
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    TF_CHECK_OK(response.ParseFrom(&source));
+  }
+}
+BENCHMARK(BM_RecvTensorRoundTrip)->Arg(16)->Arg(1 << 10)->Arg(1 << 20);
+
 }  // namespace tensorflow
@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service.h"
 
+#include <algorithm>
+#include <atomic>
 #include <deque>
+#include <memory>
 
 #include "grpcpp/alarm.h"
 #include "grpcpp/server_builder.h"
@@ -34,33 +37,139 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
+#include "tensorflow/core/distributed_runtime/trace_exporter.h"
 #include "tensorflow/core/distributed_runtime/worker.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/protobuf/transport_options.pb.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 namespace {
 
-class GrpcWorkerService : public AsyncServiceInterface {
-  // TODO(ncteisen): consider adding a config var or flag for this
-  static constexpr const size_t kGrpcWorkerServiceThreadCount = 8;
+auto* queueing_delay_sampler = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/grpc_worker_service/queueing_delay_us",
+     "Time the handlers of worker RPCs were queued before running, by "
+     "method.",
+     "method"},
+    // Power of 2 buckets from 1us to ~1000s.
+    monitoring::Buckets::Exponential(1, 2, 30));
+
+int64 ReadServiceOption(const char* env_var_name, int64 default_value) {
+  int64 value;
+  Status s = ReadInt64FromEnvVar(env_var_name, default_value, &value);
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+    return default_value;
+  }
+  return value;
+}
+
+// Number of threads, each polling its own completion queue.
+int64 ServiceThreadCount() {
+  static int64 count = std::max<int64>(
+      1, ReadServiceOption("TF_GRPC_WORKER_SERVICE_THREADS", 8));
+  return count;
+}
+
+// Number of threads running the handlers of control RPCs, or 0 to run them
+// on the compute pool with the other handlers.
+int64 ControlThreadCount() {
+  static int64 count =
+      ReadServiceOption("TF_GRPC_WORKER_SERVICE_CONTROL_THREADS", 4);
+  return count;
+}
+
+// If true, the completion queue threads are spread round-robin over the
+// NUMA nodes of the machine and pinned to them.
+bool PinServiceThreads() {
+  static bool pin = []() {
+    bool value;
+    Status s = ReadBoolFromEnvVar("TF_GRPC_WORKER_SERVICE_NUMA_PINNING",
+                                  false, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return false;
+    }
+    return value;
+  }();
+  return pin;
+}
+
+// Returns true for the RPCs that do little work and whose latency matters,
+// as opposed to tensor transfers, which may encode large tensors, and to
+// graph registration and execution.
+bool IsControlMethod(GrpcWorkerMethod method) {
+  switch (method) {
+    case GrpcWorkerMethod::kRegisterGraph:
+    case GrpcWorkerMethod::kRunGraph:
+    case GrpcWorkerMethod::kRecvTensor:
+    case GrpcWorkerMethod::kRecvBuf:
+    case GrpcWorkerMethod::kBatchRecvTensor:
+      return false;
+    default:
+      return true;
+  }
+}
+
+}  // namespace
+
+thread::ThreadPool* GrpcWorkerHandlerPool(GrpcWorkerMethod method,
+                                          thread::ThreadPool* control_pool,
+                                          thread::ThreadPool* compute_pool) {
+  if (control_pool != nullptr && IsControlMethod(method)) {
+    return control_pool;
+  }
+  return compute_pool;
+}
+
+namespace {
 
+// Returns the queueing delay cell of method.
+monitoring::SamplerCell* QueueingDelayCell(GrpcWorkerMethod method) {
+  static std::vector<monitoring::SamplerCell*>* cells = []() {
+    auto* cells = new std::vector<monitoring::SamplerCell*>;
+    for (int i = 0; i < kGrpcNumWorkerMethods; ++i) {
+      cells->push_back(queueing_delay_sampler->GetCell(
+          GrpcWorkerMethodName(static_cast<GrpcWorkerMethod>(i))));
+    }
+    return cells;
+  }();
+  return (*cells)[static_cast<int>(method)];
+}
+
+class GrpcWorkerService : public AsyncServiceInterface {
  public:
   GrpcWorkerService(GrpcWorker* worker, ::grpc::ServerBuilder* builder)
       : is_shutdown_(false) {
     builder->RegisterService(&worker_service_);
-    for (int i = 0; i < kGrpcWorkerServiceThreadCount; i++) {
-      threads_.emplace_back(
-          new GrpcWorkerServiceThread(worker, builder, &worker_service_));
+    if (ControlThreadCount() > 0) {
+      control_pool_.reset(new thread::ThreadPool(
+          worker->env()->env, "grpc_worker_control", ControlThreadCount()));
+    }
+    const int num_numa_nodes =
+        (PinServiceThreads() && port::NUMAEnabled()) ? port::NUMANumNodes() : 0;
+    for (int i = 0; i < ServiceThreadCount(); i++) {
+      ThreadOptions thread_options;
+      if (num_numa_nodes > 1) {
+        thread_options.numa_node = i % num_numa_nodes;
+      }
+      threads_.emplace_back(new GrpcWorkerServiceThread(
+          worker, builder, &worker_service_, control_pool_.get(),
+          thread_options));
     }
   }
 
@@ -120,18 +229,21 @@ class GrpcWorkerService : public AsyncServiceInterface {
   // CompletionQueue.
   class GrpcWorkerServiceThread {
    public:
-    explicit GrpcWorkerServiceThread(
-        GrpcWorker* worker, ::grpc::ServerBuilder* builder,
-        grpc::WorkerService::AsyncService* worker_service)
+    GrpcWorkerServiceThread(GrpcWorker* worker, ::grpc::ServerBuilder* builder,
+                            grpc::WorkerService::AsyncService* worker_service,
+                            thread::ThreadPool* control_pool,
+                            const ThreadOptions& thread_options)
         : worker_(worker),
           worker_service_(worker_service),
+          control_pool_(control_pool),
+          thread_options_(thread_options),
           is_shutdown_(false) {
       cq_ = builder->AddCompletionQueue();
     }
 
     void Start() {
       thread_.reset(worker_->env()->env->StartThread(
-          ThreadOptions(), "grpc_worker_service",
+          thread_options_, "grpc_worker_service",
           [this]() { HandleRPCsLoop(); }));
     }
 
@@ -165,6 +277,9 @@ class GrpcWorkerService : public AsyncServiceInterface {
       for (int i = 0; i < 500; ++i) {
         ENQUEUE_REQUEST(RecvBuf, true);
       }
+      for (int i = 0; i < 100; ++i) {
+        ENQUEUE_REQUEST(BatchRecvTensor, true);
+      }
       for (int i = 0; i < 100; ++i) {
         ENQUEUE_REQUEST(RunGraph, true);
       }
@@ -174,6 +289,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
 
       ENQUEUE_REQUEST(Logging, false);
       ENQUEUE_REQUEST(Tracing, false);
+      ENQUEUE_REQUEST(GetMetrics, false);
 
       for (int i = 0; i < 10; ++i) {
         ENQUEUE_REQUEST(CompleteGroup, true);
@@ -193,15 +309,26 @@ class GrpcWorkerService : public AsyncServiceInterface {
     }
 
    private:
-    void Schedule(std::function<void()> f) {
-      worker_->env()->compute_pool->Schedule(std::move(f));
+    // Runs `f`, the handler of an RPC of type `method`, on the control pool
+    // if it is a control RPC and there is one, and on the compute pool
+    // otherwise.  Records how long `f` was queued.
+    void Schedule(GrpcWorkerMethod method, std::function<void()> f) {
+      monitoring::SamplerCell* queueing_delay = QueueingDelayCell(method);
+      const uint64 enqueue_time_us = Env::Default()->NowMicros();
+      std::function<void()> run = [queueing_delay, enqueue_time_us, f]() {
+        queueing_delay->Add(Env::Default()->NowMicros() - enqueue_time_us);
+        f();
+      };
+      GrpcWorkerHandlerPool(method, control_pool_,
+                            worker_->env()->compute_pool)
+          ->Schedule(std::move(run));
     }
 
     // The following section contains one request handler method per
     // RPC. The `FooHandler` method is called (indirectly) by
     // `HandleRPCsLoop()` when the next Foo RPC is received. Each
-    // `FooHandler` call schedules a closure on `worker_->env()->compute_pool`,
-    // and is responsible for requesting the next Foo call by calling
+    // `FooHandler` call schedules a closure with `Schedule()`, and is
+    // responsible for requesting the next Foo call by calling
     // `ENQUEUE_REQUEST(Foo)`.
 
     template <class RequestMessage, class ResponseMessage>
@@ -211,7 +338,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
 
     void GetStatusHandler(
         WorkerCall<GetStatusRequest, GetStatusResponse>* call) {
-      Schedule([this, call]() {
+      Schedule(GrpcWorkerMethod::kGetStatus, [this, call]() {
         Status s = worker_->GetStatus(&call->request, &call->response);
         call->SendResponse(ToGrpcStatus(s));
       });
@@ -221,7 +348,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
     void CreateWorkerSessionHandler(
         WorkerCall<CreateWorkerSessionRequest, CreateWorkerSessionResponse>*
             call) {
-      Schedule([this, call]() {
+      Schedule(GrpcWorkerMethod::kCreateWorkerSession, [this, call]() {
         Status s =
             worker_->CreateWorkerSession(&call->request, &call->response);
         call->SendResponse(ToGrpcStatus(s));
@@ -232,7 +359,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
     void DeleteWorkerSessionHandler(
         WorkerCall<DeleteWorkerSessionRequest, DeleteWorkerSessionResponse>*
             call) {
-      Schedule([this, call]() {
+      Schedule(GrpcWorkerMethod::kDeleteWorkerSession, [this, call]() {
         Status s =
             worker_->DeleteWorkerSession(&call->request, &call->response);
         call->SendResponse(ToGrpcStatus(s));
@@ -242,7 +369,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
 
     void CleanupAllHandler(
         WorkerCall<CleanupAllRequest, CleanupAllResponse>* call) {
-      Schedule([this, call]() {
+      Schedule(GrpcWorkerMethod::kCleanupAll, [this, call]() {
         Status s = worker_->CleanupAll(&call->request, &call->response);
         call->SendResponse(ToGrpcStatus(s));
       });
@@ -251,7 +378,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
 
     void RegisterGraphHandler(
         WorkerCall<RegisterGraphRequest, RegisterGraphResponse>* call) {
-      Schedule([this, call]() {
+      Schedule(GrpcWorkerMethod::kRegisterGraph, [this, call]() {
         Status s = worker_->RegisterGraph(&call->request, &call->response);
         call->SendResponse(ToGrpcStatus(s));
       });
@@ -260,7 +387,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
 
     void DeregisterGraphHandler(
         WorkerCall<DeregisterGraphRequest, DeregisterGraphResponse>* call) {
-      Schedule([this, call]() {
+      Schedule(GrpcWorkerMethod::kDeregisterGraph, [this, call]() {
         Status s = worker_->DeregisterGraph(&call->request, &call->response);
         call->SendResponse(ToGrpcStatus(s));
       });
@@ -268,7 +395,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
     }
 
     void RunGraphHandler(WorkerCall<RunGraphRequest, RunGraphResponse>* call) {
-      Schedule([this, call]() {
+      Schedule(GrpcWorkerMethod::kRunGraph, [this, call]() {
         CallOptions* call_opts = new CallOptions;
         ProtoRunGraphRequest* wrapped_request =
             new ProtoRunGraphRequest(&call->request);
@@ -290,7 +417,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
 
     void RecvTensorHandlerRaw(
         WorkerCall<RecvTensorRequest, ::grpc::ByteBuffer>* call) {
-      Schedule([this, call]() {
+      Schedule(GrpcWorkerMethod::kRecvTensor, [this, call]() {
         CallOptions* call_opts = new CallOptions;
         call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
         worker_->GrpcRecvTensorAsync(call_opts, &call->request, &call->response,
@@ -305,7 +432,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
 
     void CleanupGraphHandler(
         WorkerCall<CleanupGraphRequest, CleanupGraphResponse>* call) {
-      Schedule([this, call]() {
+      Schedule(GrpcWorkerMethod::kCleanupGraph, [this, call]() {
         Status s = worker_->CleanupGraph(&call->request, &call->response);
         call->SendResponse(ToGrpcStatus(s));
       });
@@ -313,7 +440,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
     }
 
     void LoggingHandler(WorkerCall<LoggingRequest, LoggingResponse>* call) {
-      Schedule([this, call]() {
+      Schedule(GrpcWorkerMethod::kLogging, [this, call]() {
         Status s = worker_->Logging(&call->request, &call->response);
         call->SendResponse(ToGrpcStatus(s));
       });
@@ -321,7 +448,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
     }
 
     void TracingHandler(WorkerCall<TracingRequest, TracingResponse>* call) {
-      Schedule([this, call]() {
+      Schedule(GrpcWorkerMethod::kTracing, [this, call]() {
         Status s = worker_->Tracing(&call->request, &call->response);
         call->SendResponse(ToGrpcStatus(s));
       });
@@ -329,7 +456,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
     }
 
     void RecvBufHandler(WorkerCall<RecvBufRequest, RecvBufResponse>* call) {
-      Schedule([this, call]() {
+      Schedule(GrpcWorkerMethod::kRecvBuf, [this, call]() {
         CallOptions* call_opts = new CallOptions;
         call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
         worker_->RecvBufAsync(call_opts, &call->request, &call->response,
@@ -342,9 +469,25 @@ class GrpcWorkerService : public AsyncServiceInterface {
       ENQUEUE_REQUEST(RecvBuf, true);
     }
 
+    void BatchRecvTensorHandler(
+        WorkerCall<BatchRecvTensorRequest, BatchRecvTensorResponse>* call) {
+      Schedule(GrpcWorkerMethod::kBatchRecvTensor, [this, call]() {
+        CallOptions* call_opts = new CallOptions;
+        call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+        worker_->BatchRecvTensorAsync(call_opts, &call->request,
+                                      &call->response,
+                                      [call, call_opts](const Status& s) {
+                                        call->ClearCancelCallback();
+                                        delete call_opts;
+                                        call->SendResponse(ToGrpcStatus(s));
+                                      });
+      });
+      ENQUEUE_REQUEST(BatchRecvTensor, true);
+    }
+
     void CompleteGroupHandler(
         WorkerCall<CompleteGroupRequest, CompleteGroupResponse>* call) {
-      Schedule([this, call]() {
+      Schedule(GrpcWorkerMethod::kCompleteGroup, [this, call]() {
         CallOptions* call_opts = new CallOptions;
         call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
         worker_->CompleteGroupAsync(call_opts, &call->request, &call->response,
@@ -359,7 +502,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
 
     void CompleteInstanceHandler(
         WorkerCall<CompleteInstanceRequest, CompleteInstanceResponse>* call) {
-      Schedule([this, call]() {
+      Schedule(GrpcWorkerMethod::kCompleteInstance, [this, call]() {
         CallOptions* call_opts = new CallOptions;
         call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
         worker_->CompleteInstanceAsync(call_opts, &call->request,
@@ -375,13 +518,22 @@ class GrpcWorkerService : public AsyncServiceInterface {
 
     void GetStepSequenceHandler(
         WorkerCall<GetStepSequenceRequest, GetStepSequenceResponse>* call) {
-      Schedule([this, call]() {
+      Schedule(GrpcWorkerMethod::kGetStepSequence, [this, call]() {
         worker_->GetStepSequenceAsync(
             &call->request, &call->response,
             [call](const Status& s) { call->SendResponse(ToGrpcStatus(s)); });
       });
       ENQUEUE_REQUEST(GetStepSequence, true);
     }
+
+    void GetMetricsHandler(
+        WorkerCall<GetMetricsRequest, GetMetricsResponse>* call) {
+      Schedule(GrpcWorkerMethod::kGetMetrics, [this, call]() {
+        Status s = worker_->GetMetrics(&call->request, &call->response);
+        call->SendResponse(ToGrpcStatus(s));
+      });
+      ENQUEUE_REQUEST(GetMetrics, false);
+    }
 #undef ENQUEUE_REQUEST
 
     void EnqueueRecvTensorRequestRaw() {
@@ -398,6 +550,8 @@ class GrpcWorkerService : public AsyncServiceInterface {
     }
 
     GrpcWorker* const worker_ = nullptr;  // Not owned.
+    thread::ThreadPool* const control_pool_;  // Not owned, may be null.
+    const ThreadOptions thread_options_;
     std::unique_ptr<::grpc::ServerCompletionQueue> cq_;
     std::unique_ptr<Thread> thread_;
     grpc::WorkerService::AsyncService* const worker_service_;
@@ -408,6 +562,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
   };  // GrpcWorkerServiceThread
 
   grpc::WorkerService::AsyncService worker_service_;
+  std::unique_ptr<thread::ThreadPool> control_pool_;
   std::vector<std::unique_ptr<GrpcWorkerServiceThread>> threads_;
 
   mutex service_shutdown_mu_;
@@ -419,19 +574,41 @@ class GrpcWorkerService : public AsyncServiceInterface {
 }  // namespace
 
 GrpcWorker::GrpcWorker(WorkerEnv* worker_env)
-    : Worker(worker_env), recent_request_ids_(100000) {}
+    : GrpcWorker(worker_env, ConfigProto()) {}
+
+GrpcWorker::GrpcWorker(WorkerEnv* worker_env, const ConfigProto& config)
+    : Worker(worker_env),
+      recent_request_ids_(100000),
+      tensor_compressor_(config.rpc_options()) {}
+
+bool GrpcWorker::MaybeCompressRecvTensor(const RecvTensorRequest* request,
+                                         StringPiece edge_name, bool is_dead,
+                                         const Tensor& val,
+                                         RecvTensorResponse* proto) {
+  RPCOptions::TensorCompression compression;
+  string content;
+  if (is_dead ||
+      !tensor_compressor_.MaybeCompress(edge_name, val,
+                                        request->accepted_compression(),
+                                        &compression, &content)) {
+    return false;
+  }
+  proto->set_send_start_micros(Env::Default()->NowMicros());
+  proto->set_compression(compression);
+  TensorProto* tensor = proto->mutable_tensor();
+  tensor->set_dtype(val.dtype());
+  val.shape().AsProto(tensor->mutable_tensor_shape());
+  tensor->mutable_tensor_content()->swap(content);
+  return true;
+}
 
-// GrpcRecvTensorAsync: unlike the other Worker methods, which use protocol
-// buffers for a response object, to avoid extra protocol buffer serialization
-// overhead we generate our response directly into a ::grpc::ByteBuffer object
-void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
-                                     const RecvTensorRequest* request,
-                                     ::grpc::ByteBuffer* response,
-                                     StatusCallback done) {
+void GrpcWorker::RecvTensorToHost(CallOptions* opts,
+                                  const RecvTensorRequest* request,
+                                  HostTensorCallback done) {
   Status s = recent_request_ids_.TrackUnique(
       request->request_id(), "RecvTensor (GrpcWorker)", *request);
   if (!s.ok()) {
-    done(s);
+    done(s, StringPiece(), false, Tensor());
     return;
   }
 
@@ -445,7 +622,7 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
     s = PrepareRecvTensor(parsed, &src_dev);
   }
   if (!s.ok()) {
-    done(s);
+    done(s, StringPiece(), false, Tensor());
     return;
   }
 
@@ -453,14 +630,19 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
   // while waiting for the tensor to be produced, up until the start
   // of execution of the callback lambda body below, an RPC
   // cancellation should abort the rendezvous.
-  opts->SetCancelCallback([this, step_id]() { AbortStep(step_id); });
+  if (opts != nullptr) {
+    opts->SetCancelCallback([this, step_id]() { AbortStep(step_id); });
+  }
+  const string edge_name(parsed.edge_name);
   env_->rendezvous_mgr->RecvLocalAsync(
       step_id, parsed,
-      [opts, response, done, src_dev, request](
+      [opts, done, src_dev, request, edge_name](
           const Status& status, const Rendezvous::Args& send_args,
           const Rendezvous::Args& recv_args, const Tensor& val,
           const bool is_dead) {
-        opts->ClearCancelCallback();
+        if (opts != nullptr) {
+          opts->ClearCancelCallback();
+        }
         if (status.ok()) {
           // DMA can only be used for Tensors that do not fall into
           // the following three odd edge cases: 1) a zero-size
@@ -483,28 +665,119 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
                   << " gpu_info: " << src_dev->tensorflow_gpu_device_info();
               // "val" is on an accelerator device. Uses the device_context to
               // fill the copy on host.
-              StatusCallback copy_ready = [response, done, copy,
+              StatusCallback copy_ready = [done, edge_name, copy,
                                            is_dead](const Status& s) {
                 // The value is now ready to be returned on the wire.
-                grpc::EncodeTensorToByteBuffer(is_dead, *copy, response);
-                done(s);
+                done(s, edge_name, is_dead, *copy);
                 delete copy;
               };
 
               send_dev_context->CopyDeviceTensorToCPU(
                   &val, request->rendezvous_key(), src_dev, copy, copy_ready);
             } else {
-              grpc::EncodeTensorToByteBuffer(is_dead, val, response);
-              done(Status::OK());
+              done(Status::OK(), edge_name, is_dead, val);
             }
           }
         } else {
           //  !s.ok()
-          done(status);
+          done(status, edge_name, is_dead, val);
         }
       });
 }
 
+// GrpcRecvTensorAsync: unlike the other Worker methods, which use protocol
+// buffers for a response object, to avoid extra protocol buffer serialization
+// overhead we generate our response directly into a ::grpc::ByteBuffer object
+void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
+                                     const RecvTensorRequest* request,
+                                     ::grpc::ByteBuffer* response,
+                                     StatusCallback done) {
+  TraceExporter* exporter = TraceExporter::Global();
+  const int64 start_micros = exporter ? env_->env->NowMicros() : 0;
+  RecvTensorToHost(
+      opts, request,
+      [this, request, response, exporter, start_micros, done](
+          const Status& s, StringPiece edge_name, bool is_dead,
+          const Tensor& val) {
+        if (exporter != nullptr) {
+          exporter->ExportRpc(
+              request->step_id(),
+              strings::StrCat("Serve RecvTensor ", edge_name),
+              TraceExporter::RecvTensorFlowId(request->step_id(),
+                                              request->rendezvous_key()),
+              true /* is_flow_start */, start_micros, env_->env->NowMicros());
+        }
+        if (s.ok()) {
+          RecvTensorResponse proto;
+          if (MaybeCompressRecvTensor(request, edge_name, is_dead, val,
+                                      &proto)) {
+            grpc::EncodeRecvTensorResponseToByteBuffer(proto, response);
+          } else {
+            grpc::EncodeTensorToByteBuffer(is_dead, val, response);
+          }
+        }
+        done(s);
+      });
+}
+
+void GrpcWorker::BatchRecvTensorAsync(CallOptions* opts,
+                                      const BatchRecvTensorRequest* request,
+                                      BatchRecvTensorResponse* response,
+                                      StatusCallback done) {
+  const int num_requests = request->request_size();
+  if (num_requests == 0) {
+    done(Status::OK());
+    return;
+  }
+  for (int i = 0; i < num_requests; ++i) {
+    response->add_entry();
+  }
+
+  // As for individual RecvTensor calls, cancelling the RPC while tensors
+  // are outstanding aborts the steps producing them.
+  std::vector<int64> step_ids;
+  for (const RecvTensorRequest& r : request->request()) {
+    if (std::find(step_ids.begin(), step_ids.end(), r.step_id()) ==
+        step_ids.end()) {
+      step_ids.push_back(r.step_id());
+    }
+  }
+  opts->SetCancelCallback([this, step_ids]() {
+    for (int64 step_id : step_ids) {
+      AbortStep(step_id);
+    }
+  });
+
+  // Errors are reported per entry, so the RPC itself always succeeds.
+  auto pending = std::make_shared<std::atomic<int>>(num_requests);
+  for (int i = 0; i < num_requests; ++i) {
+    const RecvTensorRequest* sub_request = &request->request(i);
+    BatchRecvTensorResponse::Entry* entry = response->mutable_entry(i);
+    RecvTensorToHost(
+        nullptr, sub_request,
+        [this, opts, sub_request, entry, pending, done](
+            const Status& s, StringPiece edge_name, bool is_dead,
+            const Tensor& val) {
+          if (s.ok()) {
+            RecvTensorResponse* proto = entry->mutable_response();
+            if (!MaybeCompressRecvTensor(sub_request, edge_name, is_dead, val,
+                                         proto)) {
+              proto->set_is_dead(is_dead);
+              proto->set_send_start_micros(Env::Default()->NowMicros());
+              val.AsProtoTensorContent(proto->mutable_tensor());
+            }
+          } else {
+            entry->set_status_code(s.code());
+            entry->set_status_error_message(s.error_message());
+          }
+          if (pending->fetch_sub(1) == 1) {
+            opts->ClearCancelCallback();
+            done(Status::OK());
+          }
+        });
+  }
+}
+
 void GrpcWorker::RecvBufAsync(CallOptions* opts, const RecvBufRequest* request,
                               RecvBufResponse* response, StatusCallback done) {
   // This is a generic, low performance implementation appropriate for grpc.
@@ -612,6 +885,11 @@ std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* env) {
   return std::unique_ptr<GrpcWorker>(new GrpcWorker(env));
 }
 
+std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* env,
+                                          const ConfigProto& config) {
+  return std::unique_ptr<GrpcWorker>(new GrpcWorker(env, config));
+}
+
 std::unique_ptr<AsyncServiceInterface> NewGrpcWorkerService(
     GrpcWorker* worker, ::grpc::ServerBuilder* builder) {
   return std::unique_ptr<AsyncServiceInterface>(
@@ -17,7 +17,9 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_WORKER_SERVICE_H_
 
 #include "tensorflow/core/distributed_runtime/recent_request_ids.h"
+#include "tensorflow/core/distributed_runtime/tensor_compression.h"
 #include "tensorflow/core/distributed_runtime/worker.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace grpc {
 class ByteBuffer;
@@ -27,12 +29,18 @@ class ServerBuilder;
 namespace tensorflow {
 
 class AsyncServiceInterface;
+enum class GrpcWorkerMethod;
 struct WorkerEnv;
 struct WorkerSession;
 
+namespace thread {
+class ThreadPool;
+}  // namespace thread
+
 class GrpcWorker : public Worker {
  public:
   GrpcWorker(WorkerEnv* env);
+  GrpcWorker(WorkerEnv* env, const ConfigProto& config);
 
   // Specialized version of RecvTensor for gRPC, which avoids a copy.
   virtual void GrpcRecvTensorAsync(CallOptions* opts,
@@ -46,18 +54,53 @@ class GrpcWorker : public Worker {
   virtual void RecvBufAsync(CallOptions* opts, const RecvBufRequest* request,
                             RecvBufResponse* response, StatusCallback done);
 
+  virtual void BatchRecvTensorAsync(CallOptions* opts,
+                                    const BatchRecvTensorRequest* request,
+                                    BatchRecvTensorResponse* response,
+                                    StatusCallback done);
+
   WorkerEnv* env();
 
  private:
+  // Called with the value of the edge "edge_name" in host memory, or with a
+  // non-OK status. "val" is only valid for the duration of the call.
+  typedef std::function<void(const Status& s, StringPiece edge_name,
+                             bool is_dead, const Tensor& val)>
+      HostTensorCallback;
+
+  // Waits for the tensor named by "request" and passes it to "done", after
+  // copying it to host memory if it lives on an accelerator. If "opts" is
+  // not null, cancelling it while waiting aborts the step.
+  void RecvTensorToHost(CallOptions* opts, const RecvTensorRequest* request,
+                        HostTensorCallback done);
+
+  // Fills "*proto" with "val", the value of the edge "edge_name", if both
+  // the policy of this worker and the caller allow it to be compressed.
+  // Returns false, leaving "*proto" untouched, otherwise.
+  bool MaybeCompressRecvTensor(const RecvTensorRequest* request,
+                               StringPiece edge_name, bool is_dead,
+                               const Tensor& val, RecvTensorResponse* proto);
+
   RecentRequestIds recent_request_ids_;
+  TensorCompressor tensor_compressor_;
 };
 
 std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* worker_env);
+std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* worker_env,
+                                          const ConfigProto& config);
 
 // Returns an implementation of WorkerService rpc service.
 std::unique_ptr<AsyncServiceInterface> NewGrpcWorkerService(
     GrpcWorker* worker, ::grpc::ServerBuilder* builder);
 
+// Returns the pool that runs the handlers of the RPCs of type `method`:
+// `control_pool` for the control RPCs, unless it is null, and `compute_pool`
+// for graph registration and execution, tensor transfers and every RPC when
+// there is no control pool.
+thread::ThreadPool* GrpcWorkerHandlerPool(GrpcWorkerMethod method,
+                                          thread::ThreadPool* control_pool,
+                                          thread::ThreadPool* compute_pool);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_WORKER_SERVICE_H_
@@ -58,6 +58,10 @@ const char* GrpcWorkerMethodName(GrpcWorkerMethod id) {
       return "/tensorflow.WorkerService/CompleteInstance";
     case GrpcWorkerMethod::kGetStepSequence:
       return "/tensorflow.WorkerService/GetStepSequence";
+    case GrpcWorkerMethod::kBatchRecvTensor:
+      return "/tensorflow.WorkerService/BatchRecvTensor";
+    case GrpcWorkerMethod::kGetMetrics:
+      return "/tensorflow.WorkerService/GetMetrics";
   }
   // Shouldn't be reached.
   LOG(FATAL) << "Invalid id: this line shouldn't be reached.";
@@ -87,9 +87,11 @@ enum class GrpcWorkerMethod {
   kCompleteGroup,
   kCompleteInstance,
   kGetStepSequence,
+  kBatchRecvTensor,
+  kGetMetrics,
 };
 static const int kGrpcNumWorkerMethods =
-    static_cast<int>(GrpcWorkerMethod::kGetStepSequence) + 1;
+    static_cast<int>(GrpcWorkerMethod::kGetMetrics) + 1;
 
 const char* GrpcWorkerMethodName(GrpcWorkerMethod id);
 
@@ -0,0 +1,63 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service.h"
+
+#include <set>
+
+#include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// The RPCs whose handlers may encode large tensors or run graphs.
+const std::set<GrpcWorkerMethod>& ComputeMethods() {
+  static std::set<GrpcWorkerMethod>* methods = new std::set<GrpcWorkerMethod>(
+      {GrpcWorkerMethod::kRegisterGraph, GrpcWorkerMethod::kRunGraph,
+       GrpcWorkerMethod::kRecvTensor, GrpcWorkerMethod::kRecvBuf,
+       GrpcWorkerMethod::kBatchRecvTensor});
+  return *methods;
+}
+
+TEST(GrpcWorkerServiceTest, DispatchesControlRpcsToControlPool) {
+  thread::ThreadPool control_pool(Env::Default(), "control", 1);
+  thread::ThreadPool compute_pool(Env::Default(), "compute", 1);
+  for (int i = 0; i < kGrpcNumWorkerMethods; ++i) {
+    const GrpcWorkerMethod method = static_cast<GrpcWorkerMethod>(i);
+    thread::ThreadPool* expected = ComputeMethods().count(method) > 0
+                                       ? &compute_pool
+                                       : &control_pool;
+    EXPECT_EQ(expected,
+              GrpcWorkerHandlerPool(method, &control_pool, &compute_pool))
+        << GrpcWorkerMethodName(method);
+  }
+}
+
+TEST(GrpcWorkerServiceTest, DispatchesEveryRpcToComputePoolWithoutControl) {
+  thread::ThreadPool compute_pool(Env::Default(), "compute", 1);
+  for (int i = 0; i < kGrpcNumWorkerMethods; ++i) {
+    const GrpcWorkerMethod method = static_cast<GrpcWorkerMethod>(i);
+    EXPECT_EQ(&compute_pool,
+              GrpcWorkerHandlerPool(method, /*control_pool=*/nullptr,
+                                    &compute_pool))
+        << GrpcWorkerMethodName(method);
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
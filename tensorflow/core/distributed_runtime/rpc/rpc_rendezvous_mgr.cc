@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <map>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -23,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/request_id.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/tensor_transport.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
 #include "tensorflow/core/framework/types.h"
@@ -32,15 +36,29 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 namespace {
 
+// Upper bound on the number of RecvTensor requests in one BatchRecvTensor
+// RPC. A full batch is sent without waiting for the rest of the window.
+const size_t kMaxRecvTensorBatchSize = 128;
+
+class RpcRecvTensorCall;
+struct RecvTensorBatch;
+
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
-  RpcRemoteRendezvous(const WorkerEnv* env, int64 step_id)
-      : BaseRemoteRendezvous(env, step_id) {}
+  RpcRemoteRendezvous(
+      const WorkerEnv* env, int64 step_id, int64 batch_window_micros,
+      int64 max_prioritized_recvs,
+      const std::vector<std::unique_ptr<TensorTransport>>* transports)
+      : BaseRemoteRendezvous(env, step_id),
+        batch_window_micros_(batch_window_micros),
+        max_prioritized_recvs_(max_prioritized_recvs),
+        transports_(transports) {}
 
  protected:
   void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
@@ -50,6 +68,61 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  private:
   ~RpcRemoteRendezvous() override {}
 
+  // Receives the tensor "parsed" with a transport or a RecvTensor RPC.
+  void StartRecv(const Rendezvous::ParsedKey& parsed,
+                 const Rendezvous::Args& recv_args, DoneCallback done);
+
+  // Starts the pending prioritized receives that fit in the limit.
+  void StartPrioritizedRecvs();
+
+  // Receives the tensor "parsed" with a RecvTensor RPC.
+  void RecvFromRemoteViaRpc(const Rendezvous::ParsedKey& parsed,
+                            const Rendezvous::Args& recv_args,
+                            DoneCallback done);
+
+  // Receives the tensor "parsed" with "transport", or with a RecvTensor RPC
+  // if "transport" turns out to be unavailable.
+  void RecvFromRemoteViaTransport(TensorTransport* transport,
+                                  const string& src_worker, Device* dst_device,
+                                  const Rendezvous::ParsedKey& parsed,
+                                  const Rendezvous::Args& recv_args,
+                                  DoneCallback done);
+
+  // Queues "call" for the next BatchRecvTensor RPC to its source worker.
+  // "recv_done" runs once the call has completed.
+  void AddToBatch(RpcRecvTensorCall* call, std::function<void()> recv_done);
+
+  // Sends the batch pending for "src_worker" if it is still the one numbered
+  // "batch_id".
+  void FlushBatch(const string& src_worker, int64 batch_id);
+
+  void StartBatch(RecvTensorBatch* batch);
+  void FinishBatch(RecvTensorBatch* batch, const Status& s);
+
+  const int64 batch_window_micros_;
+  const int64 max_prioritized_recvs_;
+  // The transports to try before the RecvTensor RPC. Owned by the
+  // RpcRendezvousMgr.
+  const std::vector<std::unique_ptr<TensorTransport>>* const transports_;
+
+  mutex batch_mu_;
+  // Batch being filled for each source worker.
+  std::unordered_map<string, RecvTensorBatch*> pending_batches_
+      GUARDED_BY(batch_mu_);
+  // Number given to the next batch.  A sent batch may be freed and its
+  // address reused, so FlushBatch() tells batches apart by their number.
+  int64 next_batch_id_ GUARDED_BY(batch_mu_) = 0;
+
+  mutex priority_mu_;
+  // Prioritized receives waiting to start, keyed by priority and then
+  // arrival.
+  std::map<std::pair<int64, int64>, std::function<void()>> pending_recvs_
+      GUARDED_BY(priority_mu_);
+  int64 next_recv_seq_ GUARDED_BY(priority_mu_) = 0;
+  int64 num_prioritized_in_flight_ GUARDED_BY(priority_mu_) = 0;
+  // True while a thread is starting receives from "pending_recvs_".
+  bool starting_recvs_ GUARDED_BY(priority_mu_) = false;
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRemoteRendezvous);
 };
 
@@ -69,6 +142,11 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     req_.set_step_id(step_id);
     req_.set_rendezvous_key(key.data(), key.size());
     req_.set_request_id(GetUniqueRequestId());
+    // TensorResponse decodes every compressed encoding, so advertise them
+    // all and leave the choice to the sender's policy.
+    req_.add_accepted_compression(RPCOptions::SNAPPY);
+    req_.add_accepted_compression(RPCOptions::FLOAT16);
+    req_.add_accepted_compression(RPCOptions::BFLOAT16);
   }
 
   void Reset(WorkerCacheInterface* wc) {
@@ -113,6 +191,22 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     return status_;
   }
 
+  // Records the outcome of this call carried by "entry" of a
+  // BatchRecvTensor response.
+  void FinishFromBatch(BatchRecvTensorResponse::Entry* entry) {
+    Status s;
+    if (entry->status_code() != error::OK) {
+      s = Status(entry->status_code(), entry->status_error_message());
+    } else {
+      resp_.InitAlloc(dst_device_, alloc_attrs_);
+      s = resp_.InitFrom(entry->mutable_response());
+    }
+    if (!s.ok()) {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+  }
+
   const Tensor& tensor() const { return resp_.tensor(); }
 
   bool is_dead() const { return resp_.metadata().is_dead(); }
@@ -159,6 +253,38 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRecvTensorCall);
 };
 
+// A receive through a TensorTransport, tracked so that it can be aborted.
+class TransportRecvCall : public BaseRecvTensorCall {
+ public:
+  TransportRecvCall() {}
+
+  // Transports are started directly by RecvFromRemoteViaTransport().
+  void Start(std::function<void()> recv_done) override {}
+
+  void StartAbort(const Status& s) override {
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    opts_.StartCancel();
+  }
+
+  Status status() const override {
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+  CallOptions* opts() { return &opts_; }
+
+ private:
+  CallOptions opts_;
+
+  mutable mutex mu_;
+  Status status_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(TransportRecvCall);
+};
+
 class RpcRecvTensorFreeList {
  public:
   RpcRecvTensorFreeList() {}
@@ -199,6 +325,23 @@ class RpcRecvTensorFreeList {
   std::vector<RpcRecvTensorCall*> objects_ GUARDED_BY(mu_);
 };
 
+// RecvTensor calls a step made to one worker, sent as a single
+// BatchRecvTensor RPC.
+struct RecvTensorBatch {
+  explicit RecvTensorBatch(int64 id) : id(id) {}
+
+  const int64 id;
+  std::vector<std::function<void()>> recv_dones;
+  CallOptions opts;
+  BatchRecvTensorRequest req;
+  BatchRecvTensorResponse resp;
+
+  mutex mu;
+  std::vector<RpcRecvTensorCall*> calls GUARDED_BY(mu);
+  size_t num_aborted GUARDED_BY(mu) = 0;
+  bool started GUARDED_BY(mu) = false;
+};
+
 static RpcRecvTensorFreeList* get_call_freelist() {
   static RpcRecvTensorFreeList* call_freelist = new RpcRecvTensorFreeList();
   return call_freelist;
@@ -208,6 +351,120 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
     const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
     DoneCallback done) {
   CHECK(is_initialized());
+  if (recv_args.priority < 0 || max_prioritized_recvs_ <= 0) {
+    StartRecv(parsed, recv_args, std::move(done));
+    return;
+  }
+  // Prioritized receives are only made for tensors that can be produced
+  // without any receive (see TransferPriorityOptimizer), so the receives
+  // in flight complete even while others are held back.
+  Ref();
+  DoneCallback prioritized_done = [this, done](
+                                      const Status& s, const Args& send_args,
+                                      const Args& recv_args, const Tensor& val,
+                                      bool is_dead) {
+    done(s, send_args, recv_args, val, is_dead);
+    {
+      mutex_lock l(priority_mu_);
+      --num_prioritized_in_flight_;
+    }
+    StartPrioritizedRecvs();
+    Unref();
+  };
+  {
+    mutex_lock l(priority_mu_);
+    pending_recvs_.emplace(
+        std::make_pair(recv_args.priority, next_recv_seq_++),
+        [this, parsed, recv_args, prioritized_done]() {
+          StartRecv(parsed, recv_args, prioritized_done);
+        });
+  }
+  StartPrioritizedRecvs();
+}
+
+void RpcRemoteRendezvous::StartPrioritizedRecvs() {
+  {
+    mutex_lock l(priority_mu_);
+    // The thread already starting receives picks up the new ones. Starting
+    // them in a loop, rather than from the callbacks of the receives that
+    // complete, also keeps receives that fail at once from recursing.
+    if (starting_recvs_) return;
+    starting_recvs_ = true;
+  }
+  while (true) {
+    std::function<void()> start;
+    {
+      mutex_lock l(priority_mu_);
+      if (pending_recvs_.empty() ||
+          num_prioritized_in_flight_ >= max_prioritized_recvs_) {
+        starting_recvs_ = false;
+        return;
+      }
+      start = std::move(pending_recvs_.begin()->second);
+      pending_recvs_.erase(pending_recvs_.begin());
+      ++num_prioritized_in_flight_;
+    }
+    start();
+  }
+}
+
+void RpcRemoteRendezvous::StartRecv(const Rendezvous::ParsedKey& parsed,
+                                    const Rendezvous::Args& recv_args,
+                                    DoneCallback done) {
+  if (!transports_->empty()) {
+    string src_worker;
+    string src_rel_device;
+    Device* dst_device;
+    if (DeviceNameUtils::SplitDeviceName(parsed.src_device, &src_worker,
+                                         &src_rel_device) &&
+        session()->device_mgr()->LookupDevice(parsed.dst_device,
+                                              &dst_device).ok()) {
+      for (const auto& transport : *transports_) {
+        if (transport->CanRecv(src_worker, parsed, dst_device)) {
+          RecvFromRemoteViaTransport(transport.get(), src_worker, dst_device,
+                                     parsed, recv_args, std::move(done));
+          return;
+        }
+      }
+    }
+  }
+  RecvFromRemoteViaRpc(parsed, recv_args, std::move(done));
+}
+
+void RpcRemoteRendezvous::RecvFromRemoteViaTransport(
+    TensorTransport* transport, const string& src_worker, Device* dst_device,
+    const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
+    DoneCallback done) {
+  TransportRecvCall* call = new TransportRecvCall;
+  // Record "call" in active_ so that it can be aborted cleanly.
+  RegisterCall(call);
+  Ref();
+  transport->RecvAsync(
+      session(), step_id_, src_worker, parsed, dst_device, recv_args,
+      call->opts(),
+      [this, call, parsed, recv_args, done](const Status& s, const Tensor& val,
+                                            bool is_dead) {
+        DeregisterCall(call);
+        // If StartAbort was called prior to DeregisterCall, then the
+        // current status should be bad.
+        Status status = call->status();
+        delete call;
+        if (status.ok() &&
+            (errors::IsUnavailable(s) || errors::IsUnimplemented(s))) {
+          VLOG(1) << "Falling back to RecvTensor for " << parsed.FullKey()
+                  << ": " << s;
+          RecvFromRemoteViaRpc(parsed, recv_args, done);
+        } else {
+          status.Update(s);
+          done(status, Args(), recv_args, val, is_dead);
+        }
+        Unref();
+      });
+}
+
+void RpcRemoteRendezvous::RecvFromRemoteViaRpc(
+    const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
+    DoneCallback done) {
   Status s;
 
   // Prepare a RecvTensor call that can handle being aborted.
@@ -246,7 +503,7 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
 
   // Start "call".
   Ref();
-  call->Start([this, call]() {
+  std::function<void()> recv_done = [this, call]() {
     // Removes "call" from active_. Prevent StartAbort().
     DeregisterCall(call);
     // If StartAbort was called prior to DeregisterCall, then the
@@ -257,17 +514,162 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
     call->wi_ = nullptr;
     get_call_freelist()->Release(call, session()->worker_cache.get());
     Unref();
-  });
+  };
+  if (batch_window_micros_ > 0) {
+    AddToBatch(call, std::move(recv_done));
+  } else {
+    call->Start(std::move(recv_done));
+  }
+}
+
+void RpcRemoteRendezvous::AddToBatch(RpcRecvTensorCall* call,
+                                     std::function<void()> recv_done) {
+  int64 new_batch_id = -1;
+  RecvTensorBatch* full_batch = nullptr;
+  {
+    mutex_lock l(batch_mu_);
+    RecvTensorBatch*& batch = pending_batches_[call->src_worker_];
+    if (batch == nullptr) {
+      batch = new RecvTensorBatch(next_batch_id_++);
+      new_batch_id = batch->id;
+    }
+    bool full;
+    {
+      mutex_lock bl(batch->mu);
+      batch->calls.push_back(call);
+      full = batch->calls.size() >= kMaxRecvTensorBatchSize;
+    }
+    batch->recv_dones.push_back(std::move(recv_done));
+    *batch->req.add_request() = call->req_;
+    // Aborting every call in the batch cancels the RPC, as aborting a
+    // single call cancels its RecvTensor RPC.
+    RecvTensorBatch* b = batch;
+    call->opts_.SetCancelCallback([b]() {
+      bool cancel;
+      {
+        mutex_lock bl(b->mu);
+        ++b->num_aborted;
+        cancel = b->started && b->num_aborted == b->calls.size();
+      }
+      if (cancel) {
+        b->opts.StartCancel();
+      }
+    });
+    if (full) {
+      full_batch = batch;
+      pending_batches_.erase(call->src_worker_);
+    }
+  }
+  if (new_batch_id >= 0 && full_batch == nullptr) {
+    Ref();
+    const string src_worker = call->src_worker_;
+    env_->env->SchedClosureAfter(batch_window_micros_,
+                                 [this, src_worker, new_batch_id]() {
+                                   FlushBatch(src_worker, new_batch_id);
+                                   Unref();
+                                 });
+  }
+  if (full_batch != nullptr) {
+    StartBatch(full_batch);
+  }
+}
+
+void RpcRemoteRendezvous::FlushBatch(const string& src_worker,
+                                     int64 batch_id) {
+  RecvTensorBatch* batch;
+  {
+    mutex_lock l(batch_mu_);
+    auto it = pending_batches_.find(src_worker);
+    // The batch may already have been sent because it filled up, and a newer
+    // batch may be pending in its place.
+    if (it == pending_batches_.end() || it->second->id != batch_id) return;
+    batch = it->second;
+    pending_batches_.erase(it);
+  }
+  StartBatch(batch);
+}
+
+void RpcRemoteRendezvous::StartBatch(RecvTensorBatch* batch) {
+  bool all_aborted;
+  WorkerInterface* wi;
+  {
+    mutex_lock l(batch->mu);
+    batch->started = true;
+    all_aborted = batch->num_aborted == batch->calls.size();
+    // Every call holds a reference to the same worker until it completes.
+    wi = batch->calls[0]->wi_;
+  }
+  if (all_aborted) {
+    FinishBatch(batch, errors::Cancelled("BatchRecvTensor was not sent"));
+    return;
+  }
+  wi->BatchRecvTensorAsync(
+      &batch->opts, &batch->req, &batch->resp,
+      [this, batch](const Status& s) { FinishBatch(batch, s); });
+}
+
+void RpcRemoteRendezvous::FinishBatch(RecvTensorBatch* batch,
+                                      const Status& s) {
+  std::vector<std::function<void()>> recv_dones;
+  recv_dones.swap(batch->recv_dones);
+  std::vector<RpcRecvTensorCall*> calls;
+  {
+    mutex_lock l(batch->mu);
+    calls = batch->calls;
+  }
+  for (RpcRecvTensorCall* call : calls) {
+    call->opts_.ClearCancelCallback();
+  }
+  if (errors::IsUnimplemented(s)) {
+    // The source worker does not support BatchRecvTensor: fall back to one
+    // RecvTensor RPC per call.
+    delete batch;
+    for (size_t i = 0; i < calls.size(); ++i) {
+      calls[i]->Start(std::move(recv_dones[i]));
+    }
+    return;
+  }
+  for (size_t i = 0; i < calls.size(); ++i) {
+    if (!s.ok()) {
+      calls[i]->StartAbort(s);
+    } else if (i < static_cast<size_t>(batch->resp.entry_size())) {
+      calls[i]->FinishFromBatch(batch->resp.mutable_entry(i));
+    } else {
+      calls[i]->StartAbort(
+          errors::Internal("BatchRecvTensor response has ",
+                           batch->resp.entry_size(), " entries for ",
+                           calls.size(), " requests"));
+    }
+  }
+  delete batch;
+  for (auto& recv_done : recv_dones) {
+    recv_done();
+  }
 }
 
 }  // namespace
 
 RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env)
-    : BaseRendezvousMgr(env) {}
+    : BaseRendezvousMgr(env),
+      transports_(TensorTransportRegistry::CreateTransports(env)) {
+  Status status =
+      ReadInt64FromEnvVar("TF_RECV_TENSOR_BATCH_WINDOW_US", 0,
+                          &recv_tensor_batch_window_micros_);
+  if (!status.ok()) {
+    LOG(ERROR) << status.error_message();
+  }
+  status = ReadInt64FromEnvVar("TF_RPC_MAX_PRIORITIZED_RECVS", 8,
+                               &max_prioritized_recvs_);
+  if (!status.ok()) {
+    LOG(ERROR) << status.error_message();
+  }
+}
 
 BaseRemoteRendezvous* RpcRendezvousMgr::Create(int64 step_id,
                                                const WorkerEnv* worker_env) {
-  return new RpcRemoteRendezvous(worker_env, step_id);
+  return new RpcRemoteRendezvous(worker_env, step_id,
+                                 recv_tensor_batch_window_micros_,
+                                 max_prioritized_recvs_, &transports_);
 }
 
 }  // end namespace tensorflow
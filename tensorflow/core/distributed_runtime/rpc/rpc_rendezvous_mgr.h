@@ -16,7 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_RPC_RENDEZVOUS_MGR_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_RPC_RENDEZVOUS_MGR_H_
 
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/distributed_runtime/base_rendezvous_mgr.h"
+#include "tensorflow/core/distributed_runtime/tensor_transport.h"
 #include "tensorflow/core/distributed_runtime/worker_env.h"
 #include "tensorflow/core/platform/macros.h"
 
@@ -50,6 +54,20 @@ class RpcRendezvousMgr : public BaseRendezvousMgr {
   BaseRemoteRendezvous* Create(int64 step_id, const WorkerEnv* worker_env);
 
  private:
+  // If positive, RecvTensor calls a step makes to the same worker within
+  // this many microseconds are sent together as one BatchRecvTensor RPC.
+  // Read from the TF_RECV_TENSOR_BATCH_WINDOW_US environment variable.
+  int64 recv_tensor_batch_window_micros_;
+
+  // If positive, at most this many prioritized receives (see
+  // Rendezvous::Args::priority) of a step are in flight at a time, and the
+  // others start in increasing order of priority. Read from the
+  // TF_RPC_MAX_PRIORITIZED_RECVS environment variable.
+  int64 max_prioritized_recvs_;
+
+  // The registered transports, tried before the RecvTensor RPC.
+  const std::vector<std::unique_ptr<TensorTransport>> transports_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRendezvousMgr);
 };
 
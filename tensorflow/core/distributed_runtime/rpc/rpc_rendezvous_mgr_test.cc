@@ -15,14 +15,26 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <stdlib.h>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/tensor_transport.h"
+#include "tensorflow/core/distributed_runtime/test_utils.h"
 #include "tensorflow/core/framework/control_flow.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
 
 namespace tensorflow {
 
@@ -200,6 +212,193 @@ TEST_F(RpcRendezvousMgrTest, TransferDummyDeviceContext) {
   dc->Unref();
 }
 
+// Remote worker serving RecvTensor and, optionally, BatchRecvTensor from a
+// fixed set of tensors.
+class FakeRemoteWorker : public TestWorkerInterface {
+ public:
+  explicit FakeRemoteWorker(bool supports_batch)
+      : supports_batch_(supports_batch) {}
+
+  void AddTensor(const string& key, const Tensor& val) {
+    tensors_[key] = val;
+  }
+
+  void RecvTensorAsync(CallOptions* opts, const RecvTensorRequest* request,
+                       TensorResponse* response, StatusCallback done) override {
+    ++num_recv_tensor_calls;
+    RecvTensorResponse proto;
+    Status s = Lookup(request->rendezvous_key(), &proto);
+    if (s.ok()) {
+      s = response->InitFrom(&proto);
+    }
+    done(s);
+  }
+
+  void BatchRecvTensorAsync(CallOptions* opts,
+                            const BatchRecvTensorRequest* request,
+                            BatchRecvTensorResponse* response,
+                            StatusCallback done) override {
+    if (!supports_batch_) {
+      done(errors::Unimplemented("BatchRecvTensorAsync"));
+      return;
+    }
+    ++num_batch_calls;
+    for (const RecvTensorRequest& r : request->request()) {
+      BatchRecvTensorResponse::Entry* entry = response->add_entry();
+      Status s = Lookup(r.rendezvous_key(), entry->mutable_response());
+      if (!s.ok()) {
+        entry->set_status_code(s.code());
+        entry->set_status_error_message(s.error_message());
+      }
+    }
+    done(Status::OK());
+  }
+
+  // Only read once all calls have completed.
+  int num_recv_tensor_calls = 0;
+  int num_batch_calls = 0;
+
+ private:
+  Status Lookup(const string& key, RecvTensorResponse* proto) {
+    auto it = tensors_.find(key);
+    if (it == tensors_.end()) {
+      return errors::NotFound("No tensor for ", key);
+    }
+    it->second.AsProtoTensorContent(proto->mutable_tensor());
+    return Status::OK();
+  }
+
+  const bool supports_batch_;
+  std::unordered_map<string, Tensor> tensors_;
+};
+
+// Transport receiving the tensors whose names start with "rdma_". It is
+// unavailable for those whose names also contain "unavailable".
+class FakeTransport : public TensorTransport {
+ public:
+  bool CanRecv(const string& src_worker, const Rendezvous::ParsedKey& parsed,
+               Device* dst_device) override {
+    return str_util::StartsWith(parsed.edge_name, "rdma_");
+  }
+
+  void RecvAsync(WorkerSession* session, int64 step_id,
+                 const string& src_worker, const Rendezvous::ParsedKey& parsed,
+                 Device* dst_device, const Rendezvous::Args& recv_args,
+                 CallOptions* opts, RecvDoneCallback done) override {
+    const string name(parsed.edge_name);
+    if (str_util::StrContains(name, "unavailable")) {
+      done(errors::Unavailable("No RDMA path to ", src_worker), Tensor(),
+           false);
+    } else {
+      done(Status::OK(), V(strings::StrCat("rdma:", name)), false);
+    }
+  }
+};
+
+REGISTER_TENSOR_TRANSPORT("fake", 0, [](const WorkerEnv* env) {
+  return std::unique_ptr<TensorTransport>(new FakeTransport);
+});
+
+class RpcRendezvousMgrBatchTest : public ::testing::Test {
+ protected:
+  // Receives the tensors "names" from "worker" on a rendezvous that batches
+  // RecvTensor calls. The worker has all but the last one, each holding its
+  // own name.
+  void RecvFromWorker(FakeRemoteWorker* worker,
+                      const std::vector<string>& names = {"apple", "banana",
+                                                          "cherry"}) {
+    const string src = "/job:ps/replica:0/task:0/device:CPU:0";
+    const string dst = "/job:mnist/replica:1/task:2/device:CPU:0";
+    std::vector<Rendezvous::ParsedKey> keys;
+    for (const string& name : names) {
+      keys.push_back(MakeKey(
+          Rendezvous::CreateKey(src, 1, dst, name, FrameAndIter(0, 0))));
+    }
+    for (size_t i = 0; i + 1 < keys.size(); ++i) {
+      worker->AddTensor(string(keys[i].FullKey()), V(names[i]));
+    }
+
+    // A long window, so that the three calls land in the same batch.
+    setenv("TF_RECV_TENSOR_BATCH_WINDOW_US", "100000", 1);
+    WorkerEnv env;
+    env.env = Env::Default();
+    RpcRendezvousMgr rmgr(&env);
+    unsetenv("TF_RECV_TENSOR_BATCH_WINDOW_US");
+
+    TestWorkerCache* cache = new TestWorkerCache;
+    cache->AddWorker("/job:ps/replica:0/task:0", worker);
+    std::vector<Device*> devices;
+    TF_ASSERT_OK(DeviceFactory::AddDevices(
+        SessionOptions(), "/job:mnist/replica:1/task:2", &devices));
+    WorkerSession session("rpc_session", "/job:mnist/replica:1/task:2",
+                          std::unique_ptr<WorkerCacheInterface>(cache),
+                          std::unique_ptr<DeviceMgr>(new DeviceMgr(devices)),
+                          std::unique_ptr<GraphMgr>());
+
+    const int64 step_id = 123;
+    RemoteRendezvous* rendez = rmgr.Find(step_id);
+    TF_ASSERT_OK(rendez->Initialize(&session));
+    BlockingCounter counter(keys.size());
+    statuses_.resize(keys.size());
+    values_.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      rendez->RecvAsync(keys[i], Rendezvous::Args(),
+                        [this, i, &counter](const Status& s,
+                                            const Rendezvous::Args& send_args,
+                                            const Rendezvous::Args& recv_args,
+                                            const Tensor& val, bool is_dead) {
+                          statuses_[i] = s;
+                          values_[i] = val;
+                          counter.DecrementCount();
+                        });
+    }
+    counter.Wait();
+    rendez->Unref();
+    rmgr.Cleanup(step_id);
+  }
+
+  std::vector<Status> statuses_;
+  std::vector<Tensor> values_;
+};
+
+TEST_F(RpcRendezvousMgrBatchTest, BatchesCallsToOneWorker) {
+  FakeRemoteWorker worker(/*supports_batch=*/true);
+  RecvFromWorker(&worker);
+  EXPECT_EQ(1, worker.num_batch_calls);
+  EXPECT_EQ(0, worker.num_recv_tensor_calls);
+  TF_EXPECT_OK(statuses_[0]);
+  EXPECT_EQ("apple", V(values_[0]));
+  TF_EXPECT_OK(statuses_[1]);
+  EXPECT_EQ("banana", V(values_[1]));
+  // Errors stay confined to the key they belong to.
+  EXPECT_TRUE(errors::IsNotFound(statuses_[2]));
+}
+
+TEST_F(RpcRendezvousMgrBatchTest, FallsBackWithoutBatchSupport) {
+  FakeRemoteWorker worker(/*supports_batch=*/false);
+  RecvFromWorker(&worker);
+  EXPECT_EQ(0, worker.num_batch_calls);
+  EXPECT_EQ(3, worker.num_recv_tensor_calls);
+  TF_EXPECT_OK(statuses_[0]);
+  EXPECT_EQ("apple", V(values_[0]));
+  TF_EXPECT_OK(statuses_[1]);
+  EXPECT_EQ("banana", V(values_[1]));
+  EXPECT_TRUE(errors::IsNotFound(statuses_[2]));
+}
+
+TEST_F(RpcRendezvousMgrBatchTest, RecvsThroughTransport) {
+  FakeRemoteWorker worker(/*supports_batch=*/true);
+  RecvFromWorker(&worker, {"rdma_apple", "rdma_unavailable_banana", "cherry"});
+  // The unavailable transport falls back to the RPC, batched with the
+  // tensor that the transport does not handle.
+  EXPECT_EQ(1, worker.num_batch_calls);
+  TF_EXPECT_OK(statuses_[0]);
+  EXPECT_EQ("rdma:rdma_apple", V(values_[0]));
+  TF_EXPECT_OK(statuses_[1]);
+  EXPECT_EQ("rdma_unavailable_banana", V(values_[1]));
+  EXPECT_TRUE(errors::IsNotFound(statuses_[2]));
+}
+
 // NOTE: Remote Send/Recv is better tested in worker_test.cc
 
 }  // namespace tensorflow
@@ -21,10 +21,59 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/collective_rma_distributed.h"
 #include "tensorflow/core/distributed_runtime/device_resolver_distributed.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
+namespace {
+// Interval between health checks of collective peers, or 0 to not check.
+int64 HealthCheckIntervalSecs() {
+  static int64 interval_secs = []() {
+    int64 value;
+    Status s = ReadInt64FromEnvVar("TF_COLLECTIVE_HEALTH_CHECK_INTERVAL_SECS",
+                                   0, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return static_cast<int64>(0);
+    }
+    return value;
+  }();
+  return interval_secs;
+}
+
+// Issues a GetStatus RPC to task and waits up to timeout_micros for the
+// response.
+Status PingTask(WorkerCacheInterface* worker_cache, const string& task,
+                int64 timeout_micros) {
+  WorkerInterface* wi = worker_cache->CreateWorker(task);
+  if (wi == nullptr) {
+    return errors::Unavailable("No worker known for ", task);
+  }
+  // Shared with the callback, which may run after a timeout.
+  struct State {
+    GetStatusRequest req;
+    GetStatusResponse resp;
+    Status status;
+    Notification done;
+  };
+  std::shared_ptr<State> state = std::make_shared<State>();
+  wi->GetStatusAsync(&state->req, &state->resp,
+                     [state, worker_cache, task, wi](const Status& s) {
+                       state->status = s;
+                       worker_cache->ReleaseWorker(task, wi);
+                       state->done.Notify();
+                     });
+  if (!WaitForNotificationWithTimeout(&state->done, timeout_micros)) {
+    return errors::DeadlineExceeded("No response from ", task, " within ",
+                                    timeout_micros, "us");
+  }
+  return state->status;
+}
+}  // namespace
+
 RpcCollectiveExecutorMgr::RpcCollectiveExecutorMgr(
     const ConfigProto& config, const DeviceMgr* dev_mgr,
     std::unique_ptr<DeviceResolverDistributed> dev_resolver,
@@ -37,14 +86,62 @@ RpcCollectiveExecutorMgr::RpcCollectiveExecutorMgr(
   group_leader_ = (task_name == config.experimental().collective_group_leader())
                       ? ""
                       : config.experimental().collective_group_leader();
+  const int64 interval_micros = HealthCheckIntervalSecs() * 1000000;
+  if (interval_micros > 0 && worker_cache_ != nullptr) {
+    health_thread_.reset(Env::Default()->StartThread(
+        ThreadOptions(), "TF_collective_health_check",
+        [this, interval_micros]() { HealthCheckLoop(interval_micros); }));
+  }
 }
 
 RpcCollectiveExecutorMgr::~RpcCollectiveExecutorMgr() {
+  {
+    mutex_lock l(health_mu_);
+    shutdown_ = true;
+    health_cv_.notify_all();
+  }
+  health_thread_.reset();  // Joins the thread.
   for (auto it : sequence_table_) {
     delete it.second;
   }
 }
 
+void RpcCollectiveExecutorMgr::CheckPeerHealth(int64 timeout_micros) {
+  // Peers only matter while some step may be waiting for them.
+  const std::vector<int64> step_ids = ActiveStepIds();
+  if (step_ids.empty()) return;
+  DeviceResolverDistributed* dev_resolver =
+      static_cast<DeviceResolverDistributed*>(dev_resolver_.get());
+  for (const string& task : dev_resolver->RemoteTasks()) {
+    Status s = PingTask(worker_cache_, task, timeout_micros);
+    if (s.ok()) continue;
+    LOG(WARNING) << "Collective peer " << task << " failed its health check, "
+                 << "aborting " << step_ids.size() << " steps: " << s;
+    // A replacement of the task may have different devices.
+    dev_resolver->ClearTask(task);
+    const Status abort_status = errors::Unavailable(
+        "Collective peer ", task, " failed its health check: ",
+        s.error_message());
+    for (int64 step_id : step_ids) {
+      StartAbort(step_id, abort_status);
+    }
+    return;
+  }
+}
+
+void RpcCollectiveExecutorMgr::HealthCheckLoop(int64 interval_micros) {
+  while (true) {
+    {
+      mutex_lock l(health_mu_);
+      if (!shutdown_) {
+        WaitForMilliseconds(&l, &health_cv_, interval_micros / 1000);
+      }
+      if (shutdown_) return;
+    }
+    CheckPeerHealth(interval_micros);
+  }
+}
+
 CollectiveExecutor* RpcCollectiveExecutorMgr::Create(int64 step_id) {
   CollectiveRemoteAccessDistributed* rma =
       new CollectiveRemoteAccessDistributed(dev_mgr_, dev_resolver_.get(),
@@ -26,6 +26,7 @@ class DeviceResolverDistributed;
 class WorkerCacheInterface;
 class StepSequenceRequest;
 class StepSequenceResponse;
+class Thread;
 
 // An implementation of CollectiveExecutorMgr for a distributed environment
 // that uses WorkerInterface::RecvBufAsync to route data transfers over RPCs.
@@ -55,6 +56,14 @@ class RpcCollectiveExecutorMgr : public CollectiveExecutorMgr {
 
   void RetireStepId(int64 graph_key, int64 step_id) override;
 
+  // Checks that every remote task collectives of this task exchange data
+  // with answers a GetStatus RPC within timeout_micros.  If one does not,
+  // forgets its device attributes and aborts the collectives of all
+  // pending steps, so that they fail fast instead of waiting for the lost
+  // peer.  Runs periodically when TF_COLLECTIVE_HEALTH_CHECK_INTERVAL_SECS
+  // is positive.
+  void CheckPeerHealth(int64 timeout_micros);
+
  protected:
   CollectiveExecutor* Create(int64 step_id) override;
 
@@ -66,6 +75,9 @@ class RpcCollectiveExecutorMgr : public CollectiveExecutorMgr {
  private:
   Status UpdateStepSequences(const GetStepSequenceResponse& resp);
 
+  // Calls CheckPeerHealth every interval_micros until destruction.
+  void HealthCheckLoop(int64 interval_micros);
+
   // This class maintains the step_id sequencing for a single
   // collective_graph_key.
   struct GraphKeySequence {
@@ -76,6 +88,11 @@ class RpcCollectiveExecutorMgr : public CollectiveExecutorMgr {
     int64 next_step_id_;
   };
 
+  mutex health_mu_;
+  condition_variable health_cv_;
+  bool shutdown_ GUARDED_BY(health_mu_) = false;
+  std::unique_ptr<Thread> health_thread_;
+
   mutex sequence_mu_;
   gtl::FlatMap<int64, GraphKeySequence*> sequence_table_
       GUARDED_BY(sequence_mu_);
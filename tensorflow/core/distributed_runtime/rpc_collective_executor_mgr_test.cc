@@ -16,15 +16,19 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "tensorflow/core/common_runtime/buf_rendezvous.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/distributed_runtime/collective_param_resolver_distributed.h"
 #include "tensorflow/core/distributed_runtime/device_resolver_distributed.h"
 #include "tensorflow/core/distributed_runtime/rpc_collective_executor_mgr.h"
+#include "tensorflow/core/distributed_runtime/test_utils.h"
 #include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 #include "tensorflow/core/public/session_options.h"
@@ -168,4 +172,79 @@ TEST_F(RpcCollectiveExecutorMgrTest, GetStepSequence) {
   }
 }
 
+// Answers GetStatus with the attributes of a single device until it is
+// marked unhealthy.
+class FakeStatusWorker : public TestWorkerInterface {
+ public:
+  explicit FakeStatusWorker(const string& device_name)
+      : device_name_(device_name) {}
+
+  void GetStatusAsync(const GetStatusRequest* request,
+                      GetStatusResponse* response,
+                      StatusCallback done) override {
+    if (!healthy_) {
+      done(errors::Unavailable("Worker is down"));
+      return;
+    }
+    response->add_device_attributes()->set_name(device_name_);
+    done(Status::OK());
+  }
+
+  bool healthy_ = true;
+
+ private:
+  const string device_name_;
+};
+
+TEST(RpcCollectiveExecutorMgrHealthTest, AbortsStepsWhenPeerFails) {
+  const string task_name = "/job:worker/replica:0/task:0";
+  const string peer_task = "/job:worker/replica:0/task:1";
+  const string peer_device = strings::StrCat(peer_task, "/device:CPU:0");
+  SessionOptions options;
+  options.config.mutable_experimental()->set_collective_group_leader(
+      task_name);
+  std::vector<Device*> devices;
+  TF_CHECK_OK(DeviceFactory::AddDevices(options, task_name, &devices));
+  DeviceMgr device_mgr(devices);
+  FakeStatusWorker peer(peer_device);
+  TestWorkerCache worker_cache;
+  worker_cache.AddWorker(peer_task, &peer);
+  std::unique_ptr<DeviceResolverDistributed> dr(
+      new DeviceResolverDistributed(&device_mgr, &worker_cache, task_name));
+  std::unique_ptr<CollectiveParamResolverDistributed> cpr(
+      new CollectiveParamResolverDistributed(options.config, &device_mgr,
+                                             dr.get(), &worker_cache,
+                                             task_name));
+  RpcCollectiveExecutorMgr cme(options.config, &device_mgr, std::move(dr),
+                               std::move(cpr), &worker_cache, task_name);
+
+  // Resolving a device of the peer makes the peer one to check.
+  DeviceLocality locality;
+  Status status;
+  Notification note;
+  cme.GetDeviceResolver()->GetLocalityAsync(peer_device, peer_task, &locality,
+                                            [&status, &note](const Status& s) {
+                                              status = s;
+                                              note.Notify();
+                                            });
+  note.WaitForNotification();
+  TF_ASSERT_OK(status);
+
+  {
+    CollectiveExecutor::Handle ce(cme.FindOrCreate(1), true);
+    cme.CheckPeerHealth(1000000);
+    peer.healthy_ = false;
+    cme.CheckPeerHealth(1000000);
+    // The step is aborted, so consumers no longer wait for their producers.
+    Status consume_status;
+    ce.get()->remote_access()->buf_rendezvous()->ConsumeBuf(
+        "key", [&consume_status](const Status& s, BufRendezvous::Hook* hook) {
+          consume_status = s;
+          delete hook;
+        });
+    EXPECT_TRUE(errors::IsUnavailable(consume_status)) << consume_status;
+    cme.Cleanup(1);
+  }
+}
+
 }  // namespace tensorflow
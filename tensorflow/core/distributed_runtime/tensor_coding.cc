@@ -18,8 +18,10 @@ limitations under the License.
 #include "google/protobuf/any.pb.h"
 
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/distributed_runtime/tensor_compression.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/lib/core/notification.h"
 
 namespace tensorflow {
 
@@ -53,6 +55,8 @@ void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
 Status TensorResponse::InitFrom(RecvTensorResponse* response) {
   Status s;
   meta_.Swap(response);
+  TF_RETURN_IF_ERROR(
+      UncompressTensorProto(meta_.compression(), meta_.mutable_tensor()));
   if (on_host_) {
     if (!tensor_.FromProto(allocator_, meta_.tensor())) {
       s = errors::InvalidArgument("Cannot parse tensor from response");
@@ -80,6 +84,14 @@ void TensorResponse::InitPartial(const RecvTensorResponse& response) {
 
 Status TensorResponse::ParseFrom(Source* source) {
   if (!on_host_) {
+    if (already_used_) {
+      ClearTensor();
+    }
+    already_used_ = true;
+    Status s;
+    if (ParseFastToDevice(source, &s)) return s;
+    meta_.Clear();
+
     protobuf::io::CodedInputStream input(source->contents());
     input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
 
@@ -87,8 +99,10 @@ Status TensorResponse::ParseFrom(Source* source) {
     if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
       return errors::InvalidArgument("Cannot parse tensor from response");
     }
-    Status s =
-        device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
+    s = UncompressTensorProto(meta_.compression(), meta_.mutable_tensor());
+    if (s.ok()) {
+      s = device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
+    }
     // Reduce memory usage for big tensors.
     {
       TensorProto empty;
@@ -101,9 +115,10 @@ Status TensorResponse::ParseFrom(Source* source) {
     ClearTensor();
   }
   already_used_ = true;
-  if (ParseFast(source)) return Status::OK();
+  if (ParseFast(source, allocator_)) return Status::OK();
   meta_.Clear();
-  if (ParseSlow(source)) return Status::OK();
+  Status s;
+  if (ParseSlow(source, &s)) return s;
   return errors::InvalidArgument("Cannot parse tensor from response");
 }
 
@@ -144,7 +159,8 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
 }  // namespace
 
 bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta,
+    Allocator* allocator) {
   bool seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
@@ -155,7 +171,7 @@ bool TensorResponse::ParseTensorSubmessage(
       if (ok && !seen_tensor_content) {
         // No tensor content: could be because it's a zero-length tensor
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        Tensor t(allocator, tensor_meta->dtype(), shape);
         tensor_ = std::move(t);
       }
       return ok;
@@ -195,7 +211,8 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        Tensor t(allocator, tensor_meta->dtype(), shape);
+        if (!t.IsInitialized()) return false;
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
         // TODO(jeff,sanjay): Figure out a way to avoid this copy if
@@ -215,7 +232,7 @@ bool TensorResponse::ParseTensorSubmessage(
   }
 }
 
-bool TensorResponse::ParseFast(Source* source) {
+bool TensorResponse::ParseFast(Source* source, Allocator* allocator) {
   protobuf::io::CodedInputStream input(source->contents());
   input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
   while (true) {
@@ -234,7 +251,8 @@ bool TensorResponse::ParseFast(Source* source) {
         std::pair<protobuf::io::CodedInputStream::Limit, int> p =
             input.IncrementRecursionDepthAndPushLimit(length);
         if (p.second < 0 ||
-            !ParseTensorSubmessage(&input, meta_.mutable_tensor())) {
+            !ParseTensorSubmessage(&input, meta_.mutable_tensor(),
+                                   allocator)) {
           return false;
         }
         if (!input.DecrementRecursionDepthAndPopLimit(p.first)) {
@@ -270,10 +288,52 @@ bool TensorResponse::ParseFast(Source* source) {
   return false;
 }
 
-bool TensorResponse::ParseSlow(Source* source) {
+bool TensorResponse::ParseFastToDevice(Source* source, Status* status) {
+  const DeviceBase::GpuDeviceInfo* gpu_info =
+      device_->tensorflow_gpu_device_info();
+  if (gpu_info == nullptr || gpu_info->default_context == nullptr) {
+    return false;
+  }
+  // Staging through pinned memory lets the host-to-device copy run as a
+  // DMA, and filling it directly from the wire skips the intermediate
+  // TensorProto that MakeTensorFromProto would otherwise parse and copy.
+  AllocatorAttributes host_attrs;
+  host_attrs.set_on_host(true);
+  host_attrs.set_gpu_compatible(true);
+  if (!ParseFast(source, device_->GetAllocator(host_attrs))) {
+    tensor_ = Tensor();
+    return false;
+  }
+  Tensor host_tensor = std::move(tensor_);
+  Tensor device_tensor(allocator_, host_tensor.dtype(), host_tensor.shape());
+  if (!device_tensor.IsInitialized()) {
+    *status = errors::ResourceExhausted(
+        "OOM when allocating tensor of shape ",
+        host_tensor.shape().DebugString(), " and type ",
+        DataTypeString(host_tensor.dtype()));
+    return true;
+  }
+  Notification n;
+  // A GpuDeviceInfo is only ever attached to a Device.
+  gpu_info->default_context->CopyCPUTensorToDevice(
+      &host_tensor, static_cast<Device*>(device_), &device_tensor,
+      [&n, status](const Status& s) {
+        *status = s;
+        n.Notify();
+      });
+  n.WaitForNotification();
+  if (status->ok()) {
+    tensor_ = std::move(device_tensor);
+  }
+  return true;
+}
+
+bool TensorResponse::ParseSlow(Source* source, Status* status) {
   if (!meta_.ParseFromZeroCopyStream(source->contents())) {
     return false;
   }
+  *status = UncompressTensorProto(meta_.compression(), meta_.mutable_tensor());
+  if (!status->ok()) return true;
 
   Tensor parsed(meta_.tensor().dtype());
   if (!parsed.FromProto(allocator_, meta_.tensor())) {
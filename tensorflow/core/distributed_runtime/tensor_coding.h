@@ -92,9 +92,16 @@ class TensorResponse {
 
  private:
   bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
-                             TensorProto* tensor_meta);
-  bool ParseFast(Source* source);
-  bool ParseSlow(Source* source);
+                             TensorProto* tensor_meta, Allocator* allocator);
+  bool ParseFast(Source* source, Allocator* allocator);
+  // Fast path for GPU destinations: decodes the tensor content straight
+  // into pinned host memory and copies it to the device without first
+  // materializing a TensorProto.  Returns false if the fast path does not
+  // apply; otherwise sets *status to the outcome of the device copy.
+  bool ParseFastToDevice(Source* source, Status* status);
+  // Returns false if the response cannot be parsed at all; otherwise sets
+  // *status to the outcome of decoding compressed tensor content.
+  bool ParseSlow(Source* source, Status* status);
 
   bool on_host_ = false;
   DeviceBase* device_ = nullptr;
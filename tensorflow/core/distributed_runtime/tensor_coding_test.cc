@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -156,6 +157,111 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+// Allocator that counts its allocations and forwards them to the CPU
+// allocator.
+class CountingAllocator : public Allocator {
+ public:
+  string Name() override { return "counting"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    ++num_allocations_;
+    return cpu_allocator()->AllocateRaw(alignment, num_bytes);
+  }
+  void DeallocateRaw(void* ptr) override {
+    cpu_allocator()->DeallocateRaw(ptr);
+  }
+  int num_allocations() const { return num_allocations_; }
+
+ private:
+  int num_allocations_ = 0;
+};
+
+// Device context that emulates a host-to-GPU copy with a memcpy.
+class FakeGpuDeviceContext : public DeviceContext {
+ public:
+  void CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device* device,
+                             Tensor* device_tensor,
+                             StatusCallback done) const override {
+    StringPiece src = cpu_tensor->tensor_data();
+    memcpy(const_cast<char*>(device_tensor->tensor_data().data()),
+           src.data(), src.size());
+    ++num_copies_;
+    done(Status::OK());
+  }
+  int num_copies() const { return num_copies_; }
+
+ private:
+  mutable int num_copies_ = 0;
+};
+
+// Non-CPU device that hands out separate pinned-host and device
+// allocators, like a GPU device does.
+class FakeGpuDevice : public Device {
+ public:
+  explicit FakeGpuDevice(Env* env)
+      : Device(env, MakeAttributes()), context_(new FakeGpuDeviceContext) {
+    gpu_info_.default_context = context_;
+    set_tensorflow_gpu_device_info(&gpu_info_);
+  }
+  ~FakeGpuDevice() override { context_->Unref(); }
+
+  Status Sync() override { return Status::OK(); }
+
+  Allocator* GetAllocator(AllocatorAttributes attr) override {
+    if (attr.on_host() && attr.gpu_compatible()) return &pinned_allocator_;
+    return &device_allocator_;
+  }
+
+  const CountingAllocator& pinned_allocator() const {
+    return pinned_allocator_;
+  }
+  const CountingAllocator& device_allocator() const {
+    return device_allocator_;
+  }
+  const FakeGpuDeviceContext& context() const { return *context_; }
+
+ private:
+  static DeviceAttributes MakeAttributes() {
+    DeviceAttributes attr;
+    attr.set_name("/job:a/replica:0/task:0/device:GPU:0");
+    attr.set_device_type("GPU");
+    return attr;
+  }
+
+  CountingAllocator pinned_allocator_;
+  CountingAllocator device_allocator_;
+  FakeGpuDeviceContext* context_;
+  GpuDeviceInfo gpu_info_;
+};
+
+TEST(TensorResponseGpuTest, ParsesIntoPinnedHostMemory) {
+  std::vector<float> v(1000);
+  for (size_t i = 0; i < v.size(); i++) {
+    v[i] = i;
+  }
+  Tensor src(DT_FLOAT, TensorShape({static_cast<int64>(v.size())}));
+  test::FillValues<float>(&src, v);
+
+  RecvTensorResponse proto;
+  proto.set_send_start_micros(123456);
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  FakeGpuDevice gpu_device(Env::Default());
+  StringSource source(&encoded, 1024);
+  TensorResponse response;
+  response.InitAlloc(&gpu_device, AllocatorAttributes());
+  TF_CHECK_OK(response.ParseFrom(&source));
+
+  // The content is staged once in pinned memory and copied once to the
+  // device, with no TensorProto in between.
+  EXPECT_EQ(1, gpu_device.pinned_allocator().num_allocations());
+  EXPECT_EQ(1, gpu_device.device_allocator().num_allocations());
+  EXPECT_EQ(1, gpu_device.context().num_copies());
+  EXPECT_EQ(123456, response.metadata().send_start_micros());
+  test::ExpectTensorEqual<float>(src, response.tensor());
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
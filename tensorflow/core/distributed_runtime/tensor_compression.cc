@@ -0,0 +1,227 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/tensor_compression.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/bfloat16.h"
+#include "tensorflow/core/framework/numeric_types.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/snappy.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Used when RPCOptions.tensor_compression_min_bytes is unset.
+constexpr int64 kDefaultMinBytes = 4096;
+
+// Lossless compression must shrink the content at least this much to be
+// worth the CPU time on both ends.
+constexpr double kMaxCompressedRatio = 0.9;
+
+// Upper bound on the number of tensors an edge sends uncompressed after a
+// compression miss.
+constexpr int64 kMaxBackoff = 1024;
+
+auto* raw_bytes_counter = monitoring::Counter<1>::New(
+    "/tensorflow/core/rpc/tensor_compression/raw_bytes",
+    "Uncompressed size of tensors sent compressed over RecvTensor.",
+    "algorithm");
+
+auto* wire_bytes_counter = monitoring::Counter<1>::New(
+    "/tensorflow/core/rpc/tensor_compression/wire_bytes",
+    "Compressed size of tensors sent compressed over RecvTensor.",
+    "algorithm");
+
+auto* cpu_micros_counter = monitoring::Counter<1>::New(
+    "/tensorflow/core/rpc/tensor_compression/cpu_micros",
+    "Microseconds spent compressing tensors for RecvTensor.", "algorithm");
+
+auto* skipped_counter = monitoring::Counter<1>::New(
+    "/tensorflow/core/rpc/tensor_compression/skipped",
+    "Tensors sent uncompressed because compression did not pay off.",
+    "algorithm");
+
+}  // namespace
+
+bool TensorCompressionSupports(RPCOptions::TensorCompression algorithm,
+                               DataType dtype) {
+  switch (algorithm) {
+    case RPCOptions::SNAPPY:
+      return DataTypeCanUseMemcpy(dtype);
+    case RPCOptions::FLOAT16:
+    case RPCOptions::BFLOAT16:
+      return dtype == DT_FLOAT;
+    default:
+      return false;
+  }
+}
+
+bool CompressTensorContent(RPCOptions::TensorCompression algorithm,
+                           const Tensor& val, string* out) {
+  if (!TensorCompressionSupports(algorithm, val.dtype())) return false;
+  switch (algorithm) {
+    case RPCOptions::SNAPPY: {
+      StringPiece data = val.tensor_data();
+      return port::Snappy_Compress(data.data(), data.size(), out);
+    }
+    case RPCOptions::FLOAT16: {
+      auto src = val.flat<float>();
+      out->resize(src.size() * sizeof(Eigen::half));
+      Eigen::half* dst = reinterpret_cast<Eigen::half*>(&(*out)[0]);
+      for (int64 i = 0; i < src.size(); ++i) {
+        dst[i] = Eigen::half(src(i));
+      }
+      return true;
+    }
+    case RPCOptions::BFLOAT16: {
+      auto src = val.flat<float>();
+      out->resize(src.size() * sizeof(bfloat16));
+      FloatToBFloat16(src.data(), reinterpret_cast<bfloat16*>(&(*out)[0]),
+                      src.size());
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+Status UncompressTensorProto(RPCOptions::TensorCompression algorithm,
+                             TensorProto* proto) {
+  if (algorithm == RPCOptions::NO_COMPRESSION) return Status::OK();
+  if (!TensorCompressionSupports(algorithm, proto->dtype())) {
+    return errors::InvalidArgument(
+        "Tensor compression ", RPCOptions::TensorCompression_Name(algorithm),
+        " does not support dtype ", DataTypeString(proto->dtype()));
+  }
+  if (!TensorShape::IsValid(proto->tensor_shape())) {
+    return errors::InvalidArgument("Invalid shape in compressed tensor");
+  }
+  const int64 num_elements = TensorShape(proto->tensor_shape()).num_elements();
+  const string& content = proto->tensor_content();
+  string raw(num_elements * DataTypeSize(proto->dtype()), '\0');
+  switch (algorithm) {
+    case RPCOptions::SNAPPY: {
+      size_t length;
+      if (!port::Snappy_GetUncompressedLength(content.data(), content.size(),
+                                              &length) ||
+          length != raw.size() ||
+          !port::Snappy_Uncompress(content.data(), content.size(), &raw[0])) {
+        return errors::DataLoss("Corrupt snappy-compressed tensor content");
+      }
+      break;
+    }
+    case RPCOptions::FLOAT16: {
+      if (content.size() != num_elements * sizeof(Eigen::half)) {
+        return errors::DataLoss("Unexpected size of float16 tensor content");
+      }
+      const Eigen::half* src =
+          reinterpret_cast<const Eigen::half*>(content.data());
+      float* dst = reinterpret_cast<float*>(&raw[0]);
+      for (int64 i = 0; i < num_elements; ++i) {
+        dst[i] = static_cast<float>(src[i]);
+      }
+      break;
+    }
+    case RPCOptions::BFLOAT16: {
+      if (content.size() != num_elements * sizeof(bfloat16)) {
+        return errors::DataLoss("Unexpected size of bfloat16 tensor content");
+      }
+      BFloat16ToFloat(reinterpret_cast<const bfloat16*>(content.data()),
+                      reinterpret_cast<float*>(&raw[0]), num_elements);
+      break;
+    }
+    default:
+      return errors::InvalidArgument("Unknown tensor compression ", algorithm);
+  }
+  proto->mutable_tensor_content()->swap(raw);
+  return Status::OK();
+}
+
+TensorCompressor::TensorCompressor(const RPCOptions& options)
+    : options_(options),
+      min_bytes_(options.tensor_compression_min_bytes() > 0
+                     ? options.tensor_compression_min_bytes()
+                     : kDefaultMinBytes) {}
+
+RPCOptions::TensorCompression TensorCompressor::AlgorithmFor(
+    StringPiece edge_name) const {
+  const auto& overrides = options_.edge_tensor_compression();
+  auto it = overrides.find(string(edge_name));
+  if (it != overrides.end()) return it->second;
+  return options_.tensor_compression();
+}
+
+bool TensorCompressor::MaybeCompress(
+    StringPiece edge_name, const Tensor& val,
+    const protobuf::RepeatedField<int>& accepted,
+    RPCOptions::TensorCompression* algorithm, string* content) {
+  const RPCOptions::TensorCompression algo = AlgorithmFor(edge_name);
+  if (algo == RPCOptions::NO_COMPRESSION ||
+      !TensorCompressionSupports(algo, val.dtype()) ||
+      val.TotalBytes() < static_cast<size_t>(min_bytes_) ||
+      std::find(accepted.begin(), accepted.end(), algo) == accepted.end()) {
+    return false;
+  }
+  const string& algo_name = RPCOptions::TensorCompression_Name(algo);
+
+  // The lossy encodings always halve the payload, so only lossless
+  // compression needs to prove itself.
+  const bool lossless = (algo == RPCOptions::SNAPPY);
+  if (lossless) {
+    mutex_lock l(mu_);
+    EdgeState& edge = edges_[string(edge_name)];
+    if (edge.skip > 0) {
+      --edge.skip;
+      skipped_counter->GetCell(algo_name)->IncrementBy(1);
+      return false;
+    }
+  }
+
+  const uint64 start_micros = Env::Default()->NowMicros();
+  string out;
+  if (!CompressTensorContent(algo, val, &out)) return false;
+  cpu_micros_counter->GetCell(algo_name)->IncrementBy(
+      Env::Default()->NowMicros() - start_micros);
+
+  const size_t raw_bytes = val.TotalBytes();
+  if (lossless) {
+    const bool pays_off = out.size() <= raw_bytes * kMaxCompressedRatio;
+    mutex_lock l(mu_);
+    EdgeState& edge = edges_[string(edge_name)];
+    if (pays_off) {
+      edge.backoff = 1;
+    } else {
+      edge.skip = edge.backoff;
+      edge.backoff = std::min(2 * edge.backoff, kMaxBackoff);
+      skipped_counter->GetCell(algo_name)->IncrementBy(1);
+      return false;
+    }
+  }
+  raw_bytes_counter->GetCell(algo_name)->IncrementBy(raw_bytes);
+  wire_bytes_counter->GetCell(algo_name)->IncrementBy(out.size());
+  *algorithm = algo;
+  content->swap(out);
+  return true;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,93 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_COMPRESSION_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_COMPRESSION_H_
+
+#include <unordered_map>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+
+class TensorProto;
+
+// Returns true if "algorithm" can encode the content of tensors of
+// type "dtype".
+bool TensorCompressionSupports(RPCOptions::TensorCompression algorithm,
+                               DataType dtype);
+
+// Encodes the content of "val" with "algorithm" into "*out". Returns false
+// if "algorithm" does not support the dtype of "val" or the encoder is
+// unavailable in this build.
+bool CompressTensorContent(RPCOptions::TensorCompression algorithm,
+                           const Tensor& val, string* out);
+
+// Replaces the encoded "tensor_content" of "*proto" with its decoded,
+// uncompressed form, so that "*proto" can be parsed as an ordinary
+// TensorProto.
+Status UncompressTensorProto(RPCOptions::TensorCompression algorithm,
+                             TensorProto* proto);
+
+// Decides, on the sending side of RecvTensor, whether and how to compress
+// each tensor, according to the RPCOptions of the sending worker.
+//
+// Lossless compression is abandoned on edges where it does not shrink the
+// payload: after a miss the edge sends the next tensors uncompressed,
+// doubling the length of that pause on every further miss. The CPU time
+// spent and the bytes saved are exported through the monitoring counters
+// "/tensorflow/core/rpc/tensor_compression/*".
+//
+// This class is thread-safe.
+class TensorCompressor {
+ public:
+  explicit TensorCompressor(const RPCOptions& options);
+
+  // Compresses "val", sent on the edge named "edge_name" to a receiver that
+  // can decode "accepted". Returns true and sets "*algorithm" and "*content"
+  // if the tensor should be sent compressed.
+  bool MaybeCompress(StringPiece edge_name, const Tensor& val,
+                     const protobuf::RepeatedField<int>& accepted,
+                     RPCOptions::TensorCompression* algorithm,
+                     string* content);
+
+ private:
+  struct EdgeState {
+    // Number of tensors still to send uncompressed before trying again.
+    int64 skip = 0;
+    // Length of the pause imposed by the next miss.
+    int64 backoff = 1;
+  };
+
+  RPCOptions::TensorCompression AlgorithmFor(StringPiece edge_name) const;
+
+  const RPCOptions options_;
+  const int64 min_bytes_;
+  mutex mu_;
+  std::unordered_map<string, EdgeState> edges_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(TensorCompressor);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_COMPRESSION_H_
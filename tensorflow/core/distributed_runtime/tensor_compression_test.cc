@@ -0,0 +1,187 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/tensor_compression.h"
+
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Compresses "val" with "algorithm" and decodes it back through a
+// TensorProto, as the receiving side of RecvTensor does.
+Tensor RoundTrip(RPCOptions::TensorCompression algorithm, const Tensor& val) {
+  TensorProto proto;
+  val.AsProtoTensorContent(&proto);
+  string content;
+  CHECK(CompressTensorContent(algorithm, val, &content));
+  proto.set_tensor_content(content);
+  TF_CHECK_OK(UncompressTensorProto(algorithm, &proto));
+  Tensor result;
+  CHECK(result.FromProto(proto));
+  return result;
+}
+
+bool SnappyAvailable() {
+  Tensor probe(DT_INT32, TensorShape({1}));
+  probe.flat<int32>().setZero();
+  string unused;
+  return CompressTensorContent(RPCOptions::SNAPPY, probe, &unused);
+}
+
+// A tensor whose content snappy cannot shrink.
+Tensor IncompressibleTensor(int64 num_elements) {
+  Tensor t(DT_UINT8, TensorShape({num_elements}));
+  uint32 state = 12345;
+  auto flat = t.flat<uint8>();
+  for (int64 i = 0; i < num_elements; ++i) {
+    state = state * 1664525 + 1013904223;
+    flat(i) = static_cast<uint8>(state >> 24);
+  }
+  return t;
+}
+
+protobuf::RepeatedField<int> AcceptAll() {
+  protobuf::RepeatedField<int> accepted;
+  accepted.Add(RPCOptions::SNAPPY);
+  accepted.Add(RPCOptions::FLOAT16);
+  accepted.Add(RPCOptions::BFLOAT16);
+  return accepted;
+}
+
+TEST(TensorCompressionTest, Supports) {
+  EXPECT_TRUE(TensorCompressionSupports(RPCOptions::SNAPPY, DT_INT64));
+  EXPECT_TRUE(TensorCompressionSupports(RPCOptions::SNAPPY, DT_FLOAT));
+  EXPECT_FALSE(TensorCompressionSupports(RPCOptions::SNAPPY, DT_STRING));
+  EXPECT_TRUE(TensorCompressionSupports(RPCOptions::FLOAT16, DT_FLOAT));
+  EXPECT_FALSE(TensorCompressionSupports(RPCOptions::FLOAT16, DT_INT32));
+  EXPECT_FALSE(TensorCompressionSupports(RPCOptions::BFLOAT16, DT_DOUBLE));
+  EXPECT_FALSE(
+      TensorCompressionSupports(RPCOptions::NO_COMPRESSION, DT_FLOAT));
+}
+
+TEST(TensorCompressionTest, SnappyRoundTrip) {
+  if (!SnappyAvailable()) return;
+  Tensor t(DT_INT32, TensorShape({2, 500}));
+  auto flat = t.flat<int32>();
+  for (int i = 0; i < flat.size(); ++i) {
+    flat(i) = i % 7;
+  }
+  test::ExpectTensorEqual<int32>(t, RoundTrip(RPCOptions::SNAPPY, t));
+}
+
+TEST(TensorCompressionTest, LossyRoundTrip) {
+  Tensor t = test::AsTensor<float>({0.0f, 1.0f, -2.5f, 1024.0f, 0.375f},
+                                   TensorShape({5}));
+  // These values are exactly representable in both half formats.
+  test::ExpectTensorEqual<float>(t, RoundTrip(RPCOptions::FLOAT16, t));
+  test::ExpectTensorEqual<float>(t, RoundTrip(RPCOptions::BFLOAT16, t));
+
+  Tensor pi = test::AsTensor<float>({3.14159265f}, TensorShape({1}));
+  test::ExpectTensorNear<float>(pi, RoundTrip(RPCOptions::FLOAT16, pi), 2e-3);
+  test::ExpectTensorNear<float>(pi, RoundTrip(RPCOptions::BFLOAT16, pi), 2e-2);
+}
+
+TEST(TensorCompressionTest, RejectsCorruptContent) {
+  Tensor t(DT_FLOAT, TensorShape({4}));
+  t.flat<float>().setZero();
+  TensorProto proto;
+  t.AsProtoTensorContent(&proto);
+  proto.set_tensor_content("abc");
+  EXPECT_FALSE(UncompressTensorProto(RPCOptions::FLOAT16, &proto).ok());
+  proto.set_tensor_content("abc");
+  EXPECT_FALSE(UncompressTensorProto(RPCOptions::SNAPPY, &proto).ok());
+  proto.set_dtype(DT_INT32);
+  EXPECT_FALSE(UncompressTensorProto(RPCOptions::BFLOAT16, &proto).ok());
+}
+
+TEST(TensorCompressorTest, RespectsPolicyAndNegotiation) {
+  RPCOptions options;
+  options.set_tensor_compression(RPCOptions::BFLOAT16);
+  (*options.mutable_edge_tensor_compression())["edge_fp16"] =
+      RPCOptions::FLOAT16;
+  (*options.mutable_edge_tensor_compression())["edge_raw"] =
+      RPCOptions::NO_COMPRESSION;
+  options.set_tensor_compression_min_bytes(16);
+  TensorCompressor compressor(options);
+
+  Tensor big(DT_FLOAT, TensorShape({64}));
+  big.flat<float>().setConstant(1.0f);
+  Tensor small(DT_FLOAT, TensorShape({2}));
+  small.flat<float>().setConstant(1.0f);
+  Tensor ints(DT_INT32, TensorShape({64}));
+  ints.flat<int32>().setConstant(1);
+
+  RPCOptions::TensorCompression algorithm;
+  string content;
+  EXPECT_TRUE(compressor.MaybeCompress("edge", big, AcceptAll(), &algorithm,
+                                       &content));
+  EXPECT_EQ(RPCOptions::BFLOAT16, algorithm);
+  EXPECT_EQ(64 * sizeof(bfloat16), content.size());
+
+  EXPECT_TRUE(compressor.MaybeCompress("edge_fp16", big, AcceptAll(),
+                                       &algorithm, &content));
+  EXPECT_EQ(RPCOptions::FLOAT16, algorithm);
+
+  EXPECT_FALSE(compressor.MaybeCompress("edge_raw", big, AcceptAll(),
+                                        &algorithm, &content));
+  EXPECT_FALSE(compressor.MaybeCompress("edge", small, AcceptAll(),
+                                        &algorithm, &content));
+  EXPECT_FALSE(compressor.MaybeCompress("edge", ints, AcceptAll(),
+                                        &algorithm, &content));
+  // A receiver that does not advertise the encoding gets raw content.
+  EXPECT_FALSE(compressor.MaybeCompress("edge", big,
+                                        protobuf::RepeatedField<int>(),
+                                        &algorithm, &content));
+}
+
+TEST(TensorCompressorTest, BacksOffWhenNotPayingOff) {
+  if (!SnappyAvailable()) return;
+  RPCOptions options;
+  options.set_tensor_compression(RPCOptions::SNAPPY);
+  TensorCompressor compressor(options);
+
+  Tensor noise = IncompressibleTensor(1 << 16);
+  Tensor zeros(DT_UINT8, TensorShape({1 << 16}));
+  zeros.flat<uint8>().setZero();
+
+  RPCOptions::TensorCompression algorithm;
+  string content;
+  // The first miss pauses the edge for one tensor, the second for two.
+  EXPECT_FALSE(compressor.MaybeCompress("edge", noise, AcceptAll(),
+                                        &algorithm, &content));
+  EXPECT_FALSE(compressor.MaybeCompress("edge", zeros, AcceptAll(),
+                                        &algorithm, &content));
+  EXPECT_FALSE(compressor.MaybeCompress("edge", noise, AcceptAll(),
+                                        &algorithm, &content));
+  EXPECT_FALSE(compressor.MaybeCompress("edge", zeros, AcceptAll(),
+                                        &algorithm, &content));
+  EXPECT_FALSE(compressor.MaybeCompress("edge", zeros, AcceptAll(),
+                                        &algorithm, &content));
+  EXPECT_TRUE(compressor.MaybeCompress("edge", zeros, AcceptAll(),
+                                       &algorithm, &content));
+  EXPECT_EQ(RPCOptions::SNAPPY, algorithm);
+  EXPECT_LT(content.size(), zeros.TotalBytes());
+
+  // Other edges are unaffected by the misses on "edge".
+  EXPECT_TRUE(compressor.MaybeCompress("other", zeros, AcceptAll(),
+                                       &algorithm, &content));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,80 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/tensor_transport.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+namespace {
+
+struct Registration {
+  string name;
+  int priority;
+  TensorTransportFactory factory;
+};
+
+mutex* get_tensor_transport_lock() {
+  static mutex tensor_transport_lock(LINKER_INITIALIZED);
+  return &tensor_transport_lock;
+}
+
+std::vector<Registration>* tensor_transports() {
+  static std::vector<Registration>* transports =
+      new std::vector<Registration>;
+  return transports;
+}
+
+}  // namespace
+
+/* static */
+void TensorTransportRegistry::Register(const string& name, int priority,
+                                       TensorTransportFactory factory) {
+  mutex_lock l(*get_tensor_transport_lock());
+  std::vector<Registration>* transports = tensor_transports();
+  for (const Registration& registration : *transports) {
+    if (registration.name == name) {
+      LOG(ERROR) << "Two tensor transports are being registered under "
+                 << name;
+      return;
+    }
+  }
+  transports->push_back({name, priority, std::move(factory)});
+  std::stable_sort(transports->begin(), transports->end(),
+                   [](const Registration& a, const Registration& b) {
+                     return a.priority > b.priority;
+                   });
+}
+
+/* static */
+std::vector<std::unique_ptr<TensorTransport>>
+TensorTransportRegistry::CreateTransports(const WorkerEnv* env) {
+  mutex_lock l(*get_tensor_transport_lock());
+  std::vector<std::unique_ptr<TensorTransport>> result;
+  for (const Registration& registration : *tensor_transports()) {
+    std::unique_ptr<TensorTransport> transport = registration.factory(env);
+    if (transport != nullptr) {
+      VLOG(1) << "Created tensor transport " << registration.name;
+      result.push_back(std::move(transport));
+    }
+  }
+  return result;
+}
+
+}  // namespace tensorflow
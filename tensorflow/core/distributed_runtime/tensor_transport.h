@@ -0,0 +1,113 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_TRANSPORT_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_TRANSPORT_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/distributed_runtime/call_options.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/framework/rendezvous.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class Device;
+class WorkerSession;
+
+// A TensorTransport receives tensors from remote workers without the
+// RecvTensor RPC, e.g. with RDMA reads from registered memory. The
+// rendezvous of RpcRendezvousMgr ask the registered transports, in order
+// of priority, whether they can receive a tensor, and fall back to the
+// RecvTensor RPC when none can or when the chosen one is unavailable.
+//
+// A transport that reads from registered host memory should register that
+// memory from an allocator visitor (see ProcessState::AddCPUAllocVisitor()),
+// so that the tensors allocated by BFCAllocator are readable remotely.
+class TensorTransport {
+ public:
+  virtual ~TensorTransport() {}
+
+  // Returns true if the transport can receive the tensor "parsed" from
+  // "src_worker" into "dst_device". Called for every remote Recv, so it
+  // must be cheap.
+  virtual bool CanRecv(const string& src_worker,
+                       const Rendezvous::ParsedKey& parsed,
+                       Device* dst_device) = 0;
+
+  // Receives the tensor "parsed" of step "step_id" from "src_worker" into
+  // "dst_device", and calls "done" with the tensor and whether it is dead.
+  //
+  // If "done" is called with an Unavailable or Unimplemented status, the
+  // tensor is received with the RecvTensor RPC instead. "opts" is cancelled
+  // if the step is aborted.
+  typedef std::function<void(const Status&, const Tensor&, bool is_dead)>
+      RecvDoneCallback;
+  virtual void RecvAsync(WorkerSession* session, int64 step_id,
+                         const string& src_worker,
+                         const Rendezvous::ParsedKey& parsed,
+                         Device* dst_device, const Rendezvous::Args& recv_args,
+                         CallOptions* opts, RecvDoneCallback done) = 0;
+};
+
+// Creates the transport of a worker. May return nullptr if the transport
+// cannot be used by this worker, e.g. if it has no RDMA device.
+typedef std::function<std::unique_ptr<TensorTransport>(const WorkerEnv*)>
+    TensorTransportFactory;
+
+class TensorTransportRegistry {
+ public:
+  // Registers "factory" under the unique name "name". Transports with a
+  // higher "priority" are asked first whether they can receive a tensor.
+  static void Register(const string& name, int priority,
+                       TensorTransportFactory factory);
+
+  // Creates the registered transports for the worker "env", in decreasing
+  // order of priority.
+  static std::vector<std::unique_ptr<TensorTransport>> CreateTransports(
+      const WorkerEnv* env);
+};
+
+namespace tensor_transport_registration {
+
+class TensorTransportRegistration {
+ public:
+  TensorTransportRegistration(const string& name, int priority,
+                              TensorTransportFactory factory) {
+    TensorTransportRegistry::Register(name, priority, std::move(factory));
+  }
+};
+
+}  // namespace tensor_transport_registration
+
+// Registers the transport created by "factory", a TensorTransportFactory.
+#define REGISTER_TENSOR_TRANSPORT(name, priority, factory) \
+  REGISTER_TENSOR_TRANSPORT_UNIQ_HELPER(__COUNTER__, name, priority, factory)
+#define REGISTER_TENSOR_TRANSPORT_UNIQ_HELPER(ctr, name, priority, factory) \
+  REGISTER_TENSOR_TRANSPORT_UNIQ(ctr, name, priority, factory)
+#define REGISTER_TENSOR_TRANSPORT_UNIQ(ctr, name, priority, factory)    \
+  static ::tensorflow::tensor_transport_registration::                  \
+      TensorTransportRegistration register_tensor_transport_##ctr(      \
+          name, priority, factory)
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_TRANSPORT_H_
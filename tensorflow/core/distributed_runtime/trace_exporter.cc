@@ -0,0 +1,224 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/trace_exporter.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/host_info.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The file is flushed when an event is exported at least this long after the
+// last flush.
+const int64 kFlushIntervalMicros = 1000000;
+
+const char kRpcTrackName[] = "RPCs";
+
+// Returns `s` quoted as a JSON string.
+string JsonString(StringPiece s) {
+  string result = "\"";
+  for (char c : s) {
+    switch (c) {
+      case '"':
+        result += "\\\"";
+        break;
+      case '\\':
+        result += "\\\\";
+        break;
+      case '\n':
+        result += "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          strings::Appendf(&result, "\\u%04x", static_cast<int>(c));
+        } else {
+          result += c;
+        }
+    }
+  }
+  result += "\"";
+  return result;
+}
+
+}  // namespace
+
+TraceExporter* TraceExporter::Global() {
+  static TraceExporter* exporter = []() -> TraceExporter* {
+    string dir;
+    Status s = ReadStringFromEnvVar("TF_TRACE_EXPORT_DIR", "", &dir);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return nullptr;
+    }
+    if (dir.empty()) {
+      return nullptr;
+    }
+    int64 step_interval;
+    s = ReadInt64FromEnvVar("TF_TRACE_EXPORT_STEP_INTERVAL", 0,
+                            &step_interval);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      step_interval = 0;
+    }
+    Env* env = Env::Default();
+    const string filename = io::JoinPath(
+        dir, strings::StrCat("trace.", port::Hostname(), ".",
+                             env->NowMicros(), ".json"));
+    std::unique_ptr<WritableFile> file;
+    s = env->RecursivelyCreateDir(dir);
+    if (s.ok()) {
+      s = env->NewWritableFile(filename, &file);
+    }
+    if (!s.ok()) {
+      LOG(ERROR) << "Not exporting traces to " << filename << ": " << s;
+      return nullptr;
+    }
+    LOG(INFO) << "Exporting traces to " << filename;
+    return new TraceExporter(env, std::move(file), step_interval);
+  }();
+  return exporter;
+}
+
+TraceExporter::TraceExporter(Env* env, std::unique_ptr<WritableFile> file,
+                             int64 step_interval)
+    : env_(env), step_interval_(step_interval), file_(std::move(file)) {
+  // The trace viewers accept a JSON array that is not terminated, so that
+  // the file can be read while it is being written.
+  mutex_lock l(mu_);
+  status_ = file_->Append("[\n");
+}
+
+TraceExporter::~TraceExporter() {
+  mutex_lock l(mu_);
+  if (status_.ok()) {
+    status_ = file_->Close();
+  }
+  if (!status_.ok()) {
+    LOG(ERROR) << "Failed to export traces: " << status_;
+  }
+}
+
+void TraceExporter::SetClockOffset(int64 offset_micros) {
+  mutex_lock l(mu_);
+  clock_offset_micros_ = offset_micros;
+}
+
+void TraceExporter::ExportStepStats(int64 step_id,
+                                    const StepStats& step_stats) {
+  mutex_lock l(mu_);
+  for (const DeviceStepStats& dev_stats : step_stats.dev_stats()) {
+    const int64 track_id = GetTrackId(dev_stats.device());
+    for (const NodeExecStats& node_stats : dev_stats.node_stats()) {
+      string event = strings::StrCat(
+          "{\"ph\":\"X\",\"cat\":\"op\",\"name\":",
+          JsonString(node_stats.node_name()), ",\"pid\":", track_id,
+          ",\"tid\":", node_stats.thread_id(),
+          ",\"ts\":", node_stats.all_start_micros() - clock_offset_micros_,
+          ",\"dur\":", std::max<int64>(1, node_stats.all_end_rel_micros()),
+          ",\"args\":{\"step_id\":", step_id);
+      if (!node_stats.timeline_label().empty()) {
+        strings::StrAppend(&event, ",\"label\":",
+                           JsonString(node_stats.timeline_label()));
+      }
+      event += "}}";
+      AppendEvent(event);
+    }
+  }
+}
+
+void TraceExporter::ExportRpc(int64 step_id, const string& name,
+                              uint64 flow_id, bool is_flow_start,
+                              int64 start_micros, int64 end_micros) {
+  mutex_lock l(mu_);
+  const int64 track_id = GetTrackId(kRpcTrackName);
+  start_micros -= clock_offset_micros_;
+  end_micros = std::max(start_micros + 1, end_micros - clock_offset_micros_);
+  size_t lane = 0;
+  while (lane < rpc_lane_end_micros_.size() &&
+         rpc_lane_end_micros_[lane] > start_micros) {
+    ++lane;
+  }
+  if (lane == rpc_lane_end_micros_.size()) {
+    rpc_lane_end_micros_.push_back(end_micros);
+  } else {
+    rpc_lane_end_micros_[lane] = end_micros;
+  }
+  AppendEvent(strings::StrCat(
+      "{\"ph\":\"X\",\"cat\":\"rpc\",\"name\":", JsonString(name),
+      ",\"pid\":", track_id, ",\"tid\":", lane, ",\"ts\":", start_micros,
+      ",\"dur\":", end_micros - start_micros, ",\"args\":{\"step_id\":",
+      step_id, "}}"));
+  // The flow event binds to the slice of the RPC, so it is placed inside it.
+  AppendEvent(strings::StrCat(
+      "{\"ph\":\"", is_flow_start ? "s" : "f",
+      "\",\"bp\":\"e\",\"cat\":\"rpc\",\"name\":\"RecvTensor\",\"id\":",
+      flow_id, ",\"pid\":", track_id, ",\"tid\":", lane,
+      ",\"ts\":", end_micros - 1, "}"));
+}
+
+uint64 TraceExporter::RecvTensorFlowId(int64 step_id,
+                                       const string& rendezvous_key) {
+  // The trace viewers parse the ids as doubles, so keep them exact.
+  return Hash64Combine(step_id, Hash64(rendezvous_key)) & ((1ull << 53) - 1);
+}
+
+Status TraceExporter::Flush() {
+  mutex_lock l(mu_);
+  if (status_.ok()) {
+    status_ = file_->Flush();
+  }
+  last_flush_micros_ = env_->NowMicros();
+  return status_;
+}
+
+int64 TraceExporter::GetTrackId(const string& name) {
+  auto it = track_ids_.find(name);
+  if (it != track_ids_.end()) {
+    return it->second;
+  }
+  const int64 track_id = track_ids_.size() + 1;
+  track_ids_.emplace(name, track_id);
+  AppendEvent(strings::StrCat(
+      "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":", track_id,
+      ",\"args\":{\"name\":",
+      JsonString(strings::StrCat(port::Hostname(), " ", name)), "}}"));
+  return track_id;
+}
+
+void TraceExporter::AppendEvent(const string& event) {
+  if (!status_.ok()) {
+    return;
+  }
+  status_ = file_->Append(strings::StrCat(event, ",\n"));
+  const int64 now_micros = env_->NowMicros();
+  if (status_.ok() && now_micros - last_flush_micros_ >= kFlushIntervalMicros) {
+    status_ = file_->Flush();
+    last_flush_micros_ = now_micros;
+  }
+  if (!status_.ok()) {
+    LOG(ERROR) << "Stopped exporting traces: " << status_;
+  }
+}
+
+}  // namespace tensorflow
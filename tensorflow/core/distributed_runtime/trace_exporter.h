@@ -0,0 +1,112 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TRACE_EXPORTER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TRACE_EXPORTER_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// TraceExporter streams the steps run by the workers of this process to a
+// file in the Chrome trace event format, which chrome://tracing and Perfetto
+// open directly. Each worker writes its own file, as the steps finish, so
+// that a distributed step can be debugged without gathering the StepStats
+// of all the workers to the master.
+//
+// The timestamps are converted to the clock of the master, using the offset
+// the master estimated when it created the worker session, so that the files
+// of the workers can be loaded together. The RecvTensor RPCs are exported on
+// both ends with a flow event from the sender to the receiver.
+//
+// Thread-safe.
+class TraceExporter {
+ public:
+  // Returns the exporter of the process, or nullptr if TF_TRACE_EXPORT_DIR is
+  // not set or the trace file cannot be created in it.
+  //
+  // Besides the steps that record a timeline, the exporter traces one in
+  // TF_TRACE_EXPORT_STEP_INTERVAL steps, none if it is unset or 0.
+  static TraceExporter* Global();
+
+  // Does not take ownership of `file`'s environment. `step_interval` is the
+  // interval of the steps that `ShouldTraceStep()` selects, or 0 for none.
+  TraceExporter(Env* env, std::unique_ptr<WritableFile> file,
+                int64 step_interval);
+  ~TraceExporter();
+
+  // Returns true if the step should be traced even though it does not record
+  // a timeline. All the workers make the same choice for a step.
+  bool ShouldTraceStep(int64 step_id) const {
+    return step_interval_ > 0 && step_id % step_interval_ == 0;
+  }
+
+  // Sets the estimated offset of the local clock from the master's clock, in
+  // microseconds, which is subtracted from the exported timestamps.
+  void SetClockOffset(int64 offset_micros) LOCKS_EXCLUDED(mu_);
+
+  // Exports the execution of the nodes of a step.
+  void ExportStepStats(int64 step_id, const StepStats& step_stats)
+      LOCKS_EXCLUDED(mu_);
+
+  // Exports an RPC that ran from `start_micros` to `end_micros` on the local
+  // clock. The flow event with `flow_id` starts at the end of the RPC if
+  // `is_flow_start`, and ends there otherwise.
+  void ExportRpc(int64 step_id, const string& name, uint64 flow_id,
+                 bool is_flow_start, int64 start_micros, int64 end_micros)
+      LOCKS_EXCLUDED(mu_);
+
+  // Returns the id of the flow event from the sender to the receiver of the
+  // tensor with `rendezvous_key` in a step.
+  static uint64 RecvTensorFlowId(int64 step_id, const string& rendezvous_key);
+
+  // Writes the buffered events to the file.
+  Status Flush() LOCKS_EXCLUDED(mu_);
+
+ private:
+  // Returns the id of the process track of `name`, creating it if needed.
+  int64 GetTrackId(const string& name) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void AppendEvent(const string& event) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Env* const env_;
+  const int64 step_interval_;
+
+  mutex mu_;
+  std::unique_ptr<WritableFile> file_ GUARDED_BY(mu_);
+  Status status_ GUARDED_BY(mu_);
+  int64 clock_offset_micros_ GUARDED_BY(mu_) = 0;
+  std::unordered_map<string, int64> track_ids_ GUARDED_BY(mu_);
+  // The end time of the last RPC of each lane of the RPC track, so that the
+  // concurrent RPCs are exported in separate lanes.
+  std::vector<int64> rpc_lane_end_micros_ GUARDED_BY(mu_);
+  int64 last_flush_micros_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(TraceExporter);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TRACE_EXPORTER_H_
@@ -0,0 +1,102 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/trace_exporter.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class TraceExporterTest : public ::testing::Test {
+ protected:
+  std::unique_ptr<TraceExporter> NewExporter(int64 step_interval) {
+    filename_ = io::JoinPath(testing::TmpDir(),
+                             strings::StrCat("trace_", counter_++, ".json"));
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(Env::Default()->NewWritableFile(filename_, &file));
+    return std::unique_ptr<TraceExporter>(
+        new TraceExporter(Env::Default(), std::move(file), step_interval));
+  }
+
+  string ReadTrace() {
+    string contents;
+    TF_CHECK_OK(ReadFileToString(Env::Default(), filename_, &contents));
+    return contents;
+  }
+
+  string filename_;
+  int counter_ = 0;
+};
+
+TEST_F(TraceExporterTest, ExportsStepStatsOnMasterClock) {
+  std::unique_ptr<TraceExporter> exporter = NewExporter(0);
+  StepStats step_stats;
+  DeviceStepStats* dev_stats = step_stats.add_dev_stats();
+  dev_stats->set_device("/job:worker/replica:0/task:0/device:CPU:0");
+  NodeExecStats* node_stats = dev_stats->add_node_stats();
+  node_stats->set_node_name("a\"b");
+  node_stats->set_all_start_micros(1000);
+  node_stats->set_all_end_rel_micros(20);
+  node_stats->set_thread_id(7);
+  exporter->SetClockOffset(100);
+  exporter->ExportStepStats(42, step_stats);
+  TF_ASSERT_OK(exporter->Flush());
+
+  const string trace = ReadTrace();
+  EXPECT_EQ(0, trace.find("[\n"));
+  EXPECT_NE(string::npos, trace.find("\"name\":\"process_name\",\"pid\":1"));
+  EXPECT_NE(string::npos, trace.find("device:CPU:0\"}}"));
+  EXPECT_NE(string::npos,
+            trace.find("\"name\":\"a\\\"b\",\"pid\":1,\"tid\":7,\"ts\":900,"
+                       "\"dur\":20,\"args\":{\"step_id\":42}}"));
+}
+
+TEST_F(TraceExporterTest, ExportsRpcFlows) {
+  std::unique_ptr<TraceExporter> exporter = NewExporter(0);
+  const uint64 flow_id = TraceExporter::RecvTensorFlowId(1, "key");
+  EXPECT_EQ(flow_id, TraceExporter::RecvTensorFlowId(1, "key"));
+  EXPECT_NE(flow_id, TraceExporter::RecvTensorFlowId(2, "key"));
+  exporter->ExportRpc(1, "RecvTensor x", flow_id, false, 100, 200);
+  // A concurrent RPC goes to another lane.
+  exporter->ExportRpc(1, "RecvTensor y", flow_id + 1, false, 150, 250);
+  TF_ASSERT_OK(exporter->Flush());
+
+  const string trace = ReadTrace();
+  EXPECT_NE(string::npos,
+            trace.find("\"name\":\"RecvTensor x\",\"pid\":1,\"tid\":0,"
+                       "\"ts\":100,\"dur\":100"));
+  EXPECT_NE(string::npos,
+            trace.find(strings::StrCat("{\"ph\":\"f\",\"bp\":\"e\",\"cat\":"
+                                       "\"rpc\",\"name\":\"RecvTensor\","
+                                       "\"id\":",
+                                       flow_id, ",\"pid\":1,\"tid\":0,"
+                                       "\"ts\":199}")));
+  EXPECT_NE(string::npos,
+            trace.find("\"name\":\"RecvTensor y\",\"pid\":1,\"tid\":1,"));
+}
+
+TEST_F(TraceExporterTest, ShouldTraceStep) {
+  EXPECT_FALSE(NewExporter(0)->ShouldTraceStep(0));
+  std::unique_ptr<TraceExporter> exporter = NewExporter(10);
+  EXPECT_TRUE(exporter->ShouldTraceStep(20));
+  EXPECT_FALSE(exporter->ShouldTraceStep(21));
+}
+
+}  // namespace
+}  // namespace tensorflow
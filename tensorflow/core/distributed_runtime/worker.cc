@@ -15,6 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/worker.h"
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+
 #include "tensorflow/core/common_runtime/collective_executor_mgr.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/process_util.h"
@@ -22,7 +27,11 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/trace_exporter.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/lib/monitoring/prometheus_exporter.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/tracing.h"
 
 namespace tensorflow {
@@ -47,6 +56,7 @@ void Worker::CreateWorkerSessionAsync(const CreateWorkerSessionRequest* request,
   Status s = env_->session_mgr->CreateSession(request->session_handle(),
                                               request->server_def(),
                                               request->isolate_session_state());
+  response->set_worker_time_micros(env_->env->NowMicros());
   done(s);
 }
 
@@ -73,8 +83,8 @@ void Worker::RegisterGraphAsync(const RegisterGraphRequest* request,
     s = session->graph_mgr->Register(
         request->session_handle(), request->graph_def(),
         request->graph_options(), request->debug_options(),
-        request->collective_graph_key(), session->cluster_flr.get(),
-        response->mutable_graph_handle());
+        request->collective_graph_key(), request->library_fingerprint(),
+        session->cluster_flr.get(), response->mutable_graph_handle());
   }
   done(s);
 }
@@ -99,12 +109,16 @@ void Worker::DeregisterGraphAsync(const DeregisterGraphRequest* request,
 
 void Worker::AbortStep(int64 step_id) {
   Rendezvous* rendez = env_->rendezvous_mgr->Find(step_id);
-  SchedNonBlockingClosureAfter(1000000, [rendez, step_id]() {
+  CollectiveExecutorMgrInterface* cem = env_->collective_executor_mgr;
+  SchedNonBlockingClosureAfter(1000000, [rendez, cem, step_id]() {
     // Delay a bit before aborting the step. This way, the root
     // cause may return first back to the client instead of this
     // cancellation generated abort error.
     rendez->StartAbort(errors::Aborted("Step ", step_id));
     rendez->Unref();
+    // Collectives wait on their peers rather than on the rendezvous, so
+    // abort them too or they hang when a peer of this step has failed.
+    if (cem) cem->StartAbort(step_id, errors::Aborted("Step ", step_id));
   });
 }
 
@@ -174,17 +188,33 @@ void Worker::DoRunGraph(CallOptions* opts, RunGraphRequestWrapper* request,
     done(s);
     return;
   }
+  TraceExporter* exporter = TraceExporter::Global();
+  if (exporter != nullptr) {
+    exporter->SetClockOffset(request->exec_opts().clock_offset_micros());
+  }
+  // Whether the step stats are only collected to be exported, and should not
+  // be returned to the master.
+  const bool export_only = exporter != nullptr &&
+                           !request->exec_opts().record_timeline() &&
+                           exporter->ShouldTraceStep(step_id);
   StepStatsCollector* collector = nullptr;
   if (request->exec_opts().report_tensor_allocations_upon_oom() ||
       request->exec_opts().record_timeline() ||
-      request->exec_opts().record_costs()) {
+      request->exec_opts().record_costs() || export_only) {
     collector = new StepStatsCollector(response->mutable_step_stats());
     // TODO(mrry,pbar): GPU tracing for distributed steps.
   }
+  const bool export_step_stats =
+      exporter != nullptr &&
+      (request->exec_opts().record_timeline() || export_only);
+  const bool clear_step_stats =
+      export_only && !request->exec_opts().record_costs();
   CancellationManager* cm = new CancellationManager;
-  opts->SetCancelCallback([this, cm, step_id]() {
+  // The step that is running, whose rendezvous a cancellation aborts.
+  auto current_step_id = std::make_shared<std::atomic<int64>>(step_id);
+  opts->SetCancelCallback([this, cm, current_step_id]() {
     cm->StartCancel();
-    AbortStep(step_id);
+    AbortStep(current_step_id->load());
   });
   CancellationToken token;
   token = cancellation_manager_.get_cancellation_token();
@@ -198,30 +228,70 @@ void Worker::DoRunGraph(CallOptions* opts, RunGraphRequestWrapper* request,
     done(errors::Aborted("Call was aborted"));
     return;
   }
-  session->graph_mgr->ExecuteAsync(
-      request->graph_handle(), step_id, session.get(), request->exec_opts(),
-      collector, response, cm, in,
-      [this, step_id, response, session, cm, out, token, collector, opts,
-       done](Status s) {
-        if (s.ok()) {
-          s = session->graph_mgr->RecvOutputs(step_id, out);
-        }
-        opts->ClearCancelCallback();
-        cancellation_manager_.DeregisterCallback(token);
-        delete cm;
+  auto finish = [this, response, cm, out, token, collector, opts, exporter,
+                 export_step_stats, clear_step_stats, done](int64 last_step_id,
+                                                            Status s) {
+    opts->ClearCancelCallback();
+    cancellation_manager_.DeregisterCallback(token);
+    delete cm;
 
-        if (s.ok()) {
-          for (const auto& p : *out) {
-            const string& key = p.first;
-            const Tensor& val = p.second;
-            response->AddRecv(key, val);
+    if (s.ok()) {
+      for (const auto& p : *out) {
+        const string& key = p.first;
+        const Tensor& val = p.second;
+        response->AddRecv(key, val);
+      }
+    }
+    if (collector) collector->Finalize();
+    delete collector;
+    if (export_step_stats) {
+      exporter->ExportStepStats(last_step_id, *response->mutable_step_stats());
+    }
+    if (clear_step_stats) {
+      response->mutable_step_stats()->Clear();
+    }
+    delete out;
+    done(s);
+  };
+  // Runs the steps from `step_id + i` on, without returning to the master
+  // in between, until `num_steps` steps ran or one of them failed. Only the
+  // last step collects stats, fills the response and fetches its outputs.
+  // `run_step` only holds a weak reference to itself; the step that is
+  // running holds it alive.
+  const int64 num_steps = request->num_steps();
+  const string graph_handle = request->graph_handle();
+  const ExecutorOpts exec_opts = request->exec_opts();
+  auto run_step = std::make_shared<std::function<void(int64)>>();
+  std::weak_ptr<std::function<void(int64)>> weak_run_step = run_step;
+  *run_step = [step_id, num_steps, graph_handle, exec_opts, session, collector,
+               response, cm, in, out, current_step_id, finish,
+               weak_run_step](int64 i) {
+    std::shared_ptr<std::function<void(int64)>> self = weak_run_step.lock();
+    const int64 id = step_id + i;
+    const bool last = i == num_steps - 1;
+    current_step_id->store(id);
+    session->graph_mgr->ExecuteAsync(
+        graph_handle, id, session.get(), exec_opts,
+        last ? collector : nullptr, last ? response : nullptr, cm, in,
+        [self, i, id, last, num_steps, session, out, finish](Status s) {
+          if (s.ok() && num_steps > 1) {
+            metrics::RecordRepeatedStep();
           }
-        }
-        if (collector) collector->Finalize();
-        delete collector;
-        delete out;
-        done(s);
-      });
+          if (s.ok() && !last) {
+            (*self)(i + 1);
+            return;
+          }
+          if (s.ok()) {
+            s = session->graph_mgr->RecvOutputs(id, out);
+          } else if (num_steps > 1) {
+            s = Status(s.code(), strings::StrCat("In step ", i + 1, " of ",
+                                                 num_steps, ": ",
+                                                 s.error_message()));
+          }
+          finish(id, s);
+        });
+  };
+  (*run_step)(0);
 }
 
 // TODO(suharshs): Add stats collection support to partial run.
@@ -312,15 +382,18 @@ void Worker::DoPartialRunGraph(CallOptions* opts,
 void Worker::CleanupGraphAsync(const CleanupGraphRequest* request,
                                CleanupGraphResponse* response,
                                StatusCallback done) {
-  const int64 step_id = request->step_id();
-  env_->rendezvous_mgr->Cleanup(step_id);
-  if (env_->collective_executor_mgr) {
-    env_->collective_executor_mgr->Cleanup(step_id);
-  }
-  for (Device* d : env_->local_devices) {
-    ScopedAllocatorMgr* sam = d->GetScopedAllocatorMgr();
-    if (sam) {
-      sam->Cleanup(step_id);
+  const int64 num_steps = std::max<int64>(request->num_steps(), 1);
+  for (int64 i = 0; i < num_steps; ++i) {
+    const int64 step_id = request->step_id() + i;
+    env_->rendezvous_mgr->Cleanup(step_id);
+    if (env_->collective_executor_mgr) {
+      env_->collective_executor_mgr->Cleanup(step_id);
+    }
+    for (Device* d : env_->local_devices) {
+      ScopedAllocatorMgr* sam = d->GetScopedAllocatorMgr();
+      if (sam) {
+        sam->Cleanup(step_id);
+      }
     }
   }
   done(Status::OK());
@@ -392,6 +465,13 @@ void Worker::GetStepSequenceAsync(const GetStepSequenceRequest* request,
   }
 }
 
+void Worker::GetMetricsAsync(const GetMetricsRequest* request,
+                             GetMetricsResponse* response,
+                             StatusCallback done) {
+  response->set_prometheus_text(monitoring::ExportPrometheusText());
+  done(Status::OK());
+}
+
 // Helper for RecvTensor. Validates "key" and returns the source
 // device in "*src_dev".
 Status Worker::PrepareRecvTensor(const Rendezvous::ParsedKey& parsed,
@@ -107,6 +107,10 @@ class Worker : public WorkerInterface {
                             GetStepSequenceResponse* response,
                             StatusCallback done) override;
 
+  void GetMetricsAsync(const GetMetricsRequest* request,
+                       GetMetricsResponse* response,
+                       StatusCallback done) override;
+
  protected:
   WorkerEnv* const env_;  // Not owned.
 
@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/call_options.h"
 #include "tensorflow/core/distributed_runtime/message_wrappers.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/types.h"
@@ -106,6 +107,16 @@ class WorkerInterface {
                                TensorResponse* response,
                                StatusCallback done) = 0;
 
+  // Serves several RecvTensor requests in one call. The default
+  // implementation reports Unimplemented, in which case callers fall back
+  // to one RecvTensorAsync per request.
+  virtual void BatchRecvTensorAsync(CallOptions* opts,
+                                    const BatchRecvTensorRequest* request,
+                                    BatchRecvTensorResponse* response,
+                                    StatusCallback done) {
+    done(errors::Unimplemented("BatchRecvTensorAsync()"));
+  }
+
   virtual void LoggingAsync(const LoggingRequest* request,
                             LoggingResponse* response, StatusCallback done) = 0;
 
@@ -129,6 +140,14 @@ class WorkerInterface {
                                     GetStepSequenceResponse* response,
                                     StatusCallback done) = 0;
 
+  // Returns the metrics of the worker's process. The default implementation
+  // reports Unimplemented.
+  virtual void GetMetricsAsync(const GetMetricsRequest* request,
+                               GetMetricsResponse* response,
+                               StatusCallback done) {
+    done(errors::Unimplemented("GetMetricsAsync()"));
+  }
+
   Status GetStatus(const GetStatusRequest* request,
                    GetStatusResponse* response) {
     return CallAndWait(&ME::GetStatusAsync, request, response);
@@ -178,6 +197,11 @@ class WorkerInterface {
     return CallAndWait(&ME::GetStepSequenceAsync, request, response);
   }
 
+  Status GetMetrics(const GetMetricsRequest* request,
+                    GetMetricsResponse* response) {
+    return CallAndWait(&ME::GetMetricsAsync, request, response);
+  }
+
  protected:
   // Instances of WorkerInterface must be deleted by a call to
   // WorkerCacheInterface::ReleaseWorker().
@@ -32,6 +32,7 @@ void AllocatorStats::Clear() {
   this->max_bytes_in_use = 0;
   this->max_alloc_size = 0;
   this->bytes_limit = 0;
+  this->largest_free_block_bytes = 0;
 }
 
 string AllocatorStats::DebugString() const {
@@ -40,9 +41,10 @@ string AllocatorStats::DebugString() const {
       "InUse:        %20lld\n"
       "MaxInUse:     %20lld\n"
       "NumAllocs:    %20lld\n"
-      "MaxAllocSize: %20lld\n",
+      "MaxAllocSize: %20lld\n"
+      "MaxFreeBlock: %20lld\n",
       this->bytes_limit, this->bytes_in_use, this->max_bytes_in_use,
-      this->num_allocs, this->max_alloc_size);
+      this->num_allocs, this->max_alloc_size, this->largest_free_block_bytes);
 }
 
 constexpr size_t Allocator::kAllocatorAlignment;
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/numeric_types.h"
 #include "tensorflow/core/framework/resource_handle.h"
 #include "tensorflow/core/framework/type_traits.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
@@ -45,6 +46,11 @@ struct AllocationAttributes {
   // which Op is performing the allocation, and sets this flag to
   // true.
   bool allocation_will_be_logged = false;
+  // The name of the op making the allocation, if known, which allocators may
+  // use to tag it. Only valid for the duration of the allocation call.
+  StringPiece op_name;
+  // The id of the step making the allocation, if known, or -1.
+  int64 step_id = -1;
 };
 
 // Runtime statistics collected by an allocator.
@@ -59,6 +65,10 @@ struct AllocatorStats {
   // unknown.
   int64 bytes_limit;
 
+  // The size of the largest contiguous free block the allocator could hand
+  // out without getting more memory, for allocators that track it, or 0.
+  int64 largest_free_block_bytes;
+
   AllocatorStats() { Clear(); }
 
   void Clear();
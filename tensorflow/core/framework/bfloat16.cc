@@ -15,9 +15,21 @@ limitations under the License.
 
 #include "tensorflow/core/framework/bfloat16.h"
 
+#if defined(__SSE2__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define TF_BFLOAT16_USE_SSE2 1
+#include <emmintrin.h>
+#if defined(__AVX2__)
+#define TF_BFLOAT16_USE_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
 namespace tensorflow {
 
-void FloatToBFloat16(const float* src, bfloat16* dst, int64 size) {
+namespace {
+
+// The scalar loops also handle the tails left by the vectorized loops.
+void FloatToBFloat16Scalar(const float* src, bfloat16* dst, int64 size) {
   const uint16_t* p = reinterpret_cast<const uint16_t*>(src);
   uint16_t* q = reinterpret_cast<uint16_t*>(dst);
 #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
@@ -31,7 +43,7 @@ void FloatToBFloat16(const float* src, bfloat16* dst, int64 size) {
 #endif
 }
 
-void BFloat16ToFloat(const bfloat16* src, float* dst, int64 size) {
+void BFloat16ToFloatScalar(const bfloat16* src, float* dst, int64 size) {
   const uint16_t* p = reinterpret_cast<const uint16_t*>(src);
   uint16_t* q = reinterpret_cast<uint16_t*>(dst);
 #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
@@ -47,4 +59,113 @@ void BFloat16ToFloat(const bfloat16* src, float* dst, int64 size) {
 #endif
 }
 
+#ifdef TF_BFLOAT16_USE_SSE2
+// Returns the bfloat16 bits of the 4 floats in "x", sign extended to 32 bits
+// so that _mm_packs_epi32 narrows them without saturating.
+inline __m128i TruncateToBFloat16Bits(__m128i x) {
+  return _mm_srai_epi32(x, 16);
+}
+
+inline __m128i RoundToBFloat16Bits(__m128i x) {
+  const __m128i lsb = _mm_and_si128(_mm_srli_epi32(x, 16), _mm_set1_epi32(1));
+  const __m128i rounded =
+      _mm_add_epi32(_mm_add_epi32(x, _mm_set1_epi32(0x7fff)), lsb);
+  const __m128 f = _mm_castsi128_ps(x);
+  const __m128i nan = _mm_castps_si128(_mm_cmpunord_ps(f, f));
+  return _mm_or_si128(
+      _mm_and_si128(nan, _mm_set1_epi32(0x7fc0)),
+      _mm_andnot_si128(nan, _mm_srai_epi32(rounded, 16)));
+}
+#endif  // TF_BFLOAT16_USE_SSE2
+
+#ifdef TF_BFLOAT16_USE_AVX2
+inline __m256i TruncateToBFloat16Bits(__m256i x) {
+  return _mm256_srai_epi32(x, 16);
+}
+
+inline __m256i RoundToBFloat16Bits(__m256i x) {
+  const __m256i lsb =
+      _mm256_and_si256(_mm256_srli_epi32(x, 16), _mm256_set1_epi32(1));
+  const __m256i rounded =
+      _mm256_add_epi32(_mm256_add_epi32(x, _mm256_set1_epi32(0x7fff)), lsb);
+  const __m256 f = _mm256_castsi256_ps(x);
+  const __m256i nan = _mm256_castps_si256(_mm256_cmp_ps(f, f, _CMP_UNORD_Q));
+  return _mm256_blendv_epi8(_mm256_srai_epi32(rounded, 16),
+                            _mm256_set1_epi32(0x7fc0), nan);
+}
+#endif  // TF_BFLOAT16_USE_AVX2
+
+// Converts a prefix of [src, src + size), rounding to nearest even if kRound
+// and truncating otherwise, and returns the length of the prefix.
+template <bool kRound>
+int64 FloatToBFloat16Vectorized(const float* src, bfloat16* dst, int64 size) {
+  int64 i = 0;
+#ifdef TF_BFLOAT16_USE_AVX2
+  for (; i + 16 <= size; i += 16) {
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    __m256i hi =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 8));
+    lo = kRound ? RoundToBFloat16Bits(lo) : TruncateToBFloat16Bits(lo);
+    hi = kRound ? RoundToBFloat16Bits(hi) : TruncateToBFloat16Bits(hi);
+    // _mm256_packs_epi32 interleaves the 128-bit lanes of its operands.
+    const __m256i packed =
+        _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+  }
+#endif  // TF_BFLOAT16_USE_AVX2
+#ifdef TF_BFLOAT16_USE_SSE2
+  for (; i + 8 <= size; i += 8) {
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4));
+    lo = kRound ? RoundToBFloat16Bits(lo) : TruncateToBFloat16Bits(lo);
+    hi = kRound ? RoundToBFloat16Bits(hi) : TruncateToBFloat16Bits(hi);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packs_epi32(lo, hi));
+  }
+#endif  // TF_BFLOAT16_USE_SSE2
+  return i;
+}
+
+}  // namespace
+
+void FloatToBFloat16(const float* src, bfloat16* dst, int64 size) {
+  const int64 done = FloatToBFloat16Vectorized<false>(src, dst, size);
+  FloatToBFloat16Scalar(src + done, dst + done, size - done);
+}
+
+void RoundFloatToBFloat16(const float* src, bfloat16* dst, int64 size) {
+  const int64 done = FloatToBFloat16Vectorized<true>(src, dst, size);
+  for (int64 i = done; i < size; ++i) {
+    dst[i] = bfloat16::round_to_bfloat16(src[i]);
+  }
+}
+
+void BFloat16ToFloat(const bfloat16* src, float* dst, int64 size) {
+  int64 i = 0;
+#ifdef TF_BFLOAT16_USE_AVX2
+  for (; i + 16 <= size; i += 16) {
+    const __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    const __m256i lo = _mm256_slli_epi32(
+        _mm256_cvtepu16_epi32(_mm256_castsi256_si128(x)), 16);
+    const __m256i hi = _mm256_slli_epi32(
+        _mm256_cvtepu16_epi32(_mm256_extracti128_si256(x, 1)), 16);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), lo);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 8), hi);
+  }
+#endif  // TF_BFLOAT16_USE_AVX2
+#ifdef TF_BFLOAT16_USE_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 8 <= size; i += 8) {
+    const __m128i x =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_unpacklo_epi16(zero, x));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4),
+                     _mm_unpackhi_epi16(zero, x));
+  }
+#endif  // TF_BFLOAT16_USE_SSE2
+  BFloat16ToFloatScalar(src + i, dst + i, size - i);
+}
+
 }  // end namespace tensorflow
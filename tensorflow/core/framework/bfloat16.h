@@ -54,8 +54,11 @@ limitations under the License.
 namespace tensorflow {
 
 // Conversion routines between an array of float and bfloat16 of
-// "size".
+// "size". FloatToBFloat16 truncates the mantissa, and RoundFloatToBFloat16
+// rounds it to nearest even, like bfloat16::round_to_bfloat16. On x86 they
+// convert 8 (SSE2) or 16 (AVX2) values per iteration.
 void FloatToBFloat16(const float* src, bfloat16* dst, int64 size);
+void RoundFloatToBFloat16(const float* src, bfloat16* dst, int64 size);
 void BFloat16ToFloat(const bfloat16* src, float* dst, int64 size);
 
 }  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/framework/bfloat16.h"
 
+#include <vector>
+
 #include "tensorflow/core/framework/numeric_types.h"
 #include "tensorflow/core/lib/core/casts.h"
 #include "tensorflow/core/platform/test.h"
@@ -150,6 +152,32 @@ TEST(Bfloat16Test, Negate) {
   EXPECT_EQ(4.5f, static_cast<float>(-bfloat16(-4.5f)));
 }
 
+TEST(Bfloat16Test, ArrayConversionsMatchScalarConversions) {
+  // Sizes around the vector widths exercise the vectorized loops and their
+  // scalar tails.
+  for (const int size : {1, 7, 8, 9, 15, 16, 17, 100}) {
+    std::vector<float> input(size);
+    for (int i = 0; i < size; ++i) {
+      input[i] = BinaryToFloat(i % 2, 0b10000000 + i % 7, i % 128,
+                               (i * 0x1357) & 0xffff);
+    }
+    input[0] = std::numeric_limits<float>::quiet_NaN();
+
+    std::vector<bfloat16> truncated(size), rounded(size);
+    FloatToBFloat16(input.data(), truncated.data(), size);
+    RoundFloatToBFloat16(input.data(), rounded.data(), size);
+    std::vector<float> output(size);
+    BFloat16ToFloat(rounded.data(), output.data(), size);
+    for (int i = 0; i < size; ++i) {
+      EXPECT_EQ(bfloat16::truncate_to_bfloat16(input[i]).value,
+                truncated[i].value);
+      EXPECT_EQ(bfloat16::round_to_bfloat16(input[i]).value,
+                rounded[i].value);
+      EXPECT_EQ(rounded[i].value, bfloat16(output[i]).value);
+    }
+  }
+}
+
 static void BM_FloatToBFloat16(int iters) {
   testing::StopTiming();
   static const int N = 32 << 20;
@@ -169,6 +197,25 @@ static void BM_FloatToBFloat16(int iters) {
 }
 BENCHMARK(BM_FloatToBFloat16);
 
+static void BM_RoundFloatToBFloat16(int iters) {
+  testing::StopTiming();
+  static const int N = 32 << 20;
+  const int64 tot = static_cast<int64>(iters) * N;
+  testing::ItemsProcessed(tot);
+  testing::BytesProcessed(tot * (sizeof(float) + sizeof(bfloat16)));
+
+  float* inp = new float[N];
+  bfloat16* out = new bfloat16[N];
+
+  testing::StartTiming();
+  while (iters--) {
+    RoundFloatToBFloat16(inp, out, N);
+  }
+  delete[] inp;
+  delete[] out;
+}
+BENCHMARK(BM_RoundFloatToBFloat16);
+
 static void BM_BFloat16ToFloat(int iters) {
   testing::StopTiming();
   static const int N = 32 << 20;
@@ -85,6 +85,9 @@ struct CollInstanceParams {
   std::vector<string> task_names;
   // True if every task has the same number of devices.
   bool same_num_devices_per_task = false;
+  // Format of the values a reduction sends between tasks: empty to send
+  // them as they are, or "fp16" to send float values as halves.
+  string wire_format;
   CollImplDetails impl_details;
   string ToString() const;
   CollInstanceParams& operator=(const struct CollInstanceParams& other);
@@ -209,6 +212,10 @@ class CollectiveExecutorMgrInterface : public StepSequenceInterface {
   // table.
   virtual void Cleanup(int64 step_id) = 0;
 
+  // If there is a CollectiveExecutor for step_id, aborts its pending
+  // collectives with status s.
+  virtual void StartAbort(int64 step_id, const Status& s) = 0;
+
   virtual ParamResolverInterface* GetParamResolver() const = 0;
 
   virtual DeviceResolverInterface* GetDeviceResolver() const = 0;
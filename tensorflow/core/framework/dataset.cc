@@ -15,8 +15,10 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 
 #include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/stats_aggregator.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
 #include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -203,6 +205,27 @@ bool GraphDefBuilderWrapper::HasAttr(const string& name,
   return HasAttr(op_def, attr_name);
 }
 
+int64 GetTotalBytes(const std::vector<Tensor>& element) {
+  int64 total_bytes = 0;
+  for (const Tensor& t : element) {
+    total_bytes += t.TotalBytes();
+  }
+  return total_bytes;
+}
+
+BufferBudget* BufferBudget::Global() {
+  static BufferBudget* global_budget = []() {
+    int64 limit_mb;
+    Status s = ReadInt64FromEnvVar("TF_DATA_BUFFER_BUDGET_MB", 0, &limit_mb);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      limit_mb = 0;
+    }
+    return new BufferBudget(limit_mb * (1LL << 20));
+  }();
+  return global_budget;
+}
+
 Status DatasetBase::Save(SerializationContext* ctx,
                          IteratorStateWriter* writer) const {
   string serialized_graph_def;
@@ -222,6 +245,18 @@ Status DatasetBase::Save(SerializationContext* ctx,
   return Status::OK();
 }
 
+void DatasetBaseIterator::RecordBufferedBytes(IteratorContext* ctx,
+                                              int64 num_bytes) {
+  auto stats_aggregator = ctx->stats_aggregator();
+  if (stats_aggregator) {
+    stats_aggregator->AddScalar(strings::StrCat(prefix(), "::buffered_bytes"),
+                                static_cast<float>(num_bytes));
+    stats_aggregator->AddScalar(
+        "buffer_budget::used_bytes",
+        static_cast<float>(BufferBudget::Global()->used_bytes()));
+  }
+}
+
 Status GetDatasetFromVariantTensor(const Tensor& tensor,
                                    DatasetBase** out_dataset) {
   if (!(tensor.dtype() == DT_VARIANT ||
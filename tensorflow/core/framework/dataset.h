@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_DATASET_H_
 #define TENSORFLOW_CORE_FRAMEWORK_DATASET_H_
 
+#include <atomic>
 #include <deque>
 #include <memory>
 
@@ -367,6 +368,49 @@ class SerializationContext {
   TF_DISALLOW_COPY_AND_ASSIGN(SerializationContext);
 };
 
+// Returns the number of bytes held by the tensors of the given element.
+int64 GetTotalBytes(const std::vector<Tensor>& element);
+
+// Accounts for the memory held by the buffers of tf.data iterators against a
+// process-wide budget.
+//
+// Iterators that hold elements across `GetNext()` calls (e.g. prefetch, shuffle
+// and cache) record the bytes they buffer here. Iterators that can do so
+// consult `Exceeded()` to shrink their buffer or to wait for their consumer
+// before buffering more elements. To guarantee progress, an iterator is always
+// allowed to buffer at least one element.
+//
+// This class is thread-safe.
+class BufferBudget {
+ public:
+  // A `limit_bytes` of 0 means that the budget is unlimited.
+  explicit BufferBudget(int64 limit_bytes) : limit_bytes_(limit_bytes) {}
+
+  // Returns the process-wide budget. Its limit is read from the
+  // TF_DATA_BUFFER_BUDGET_MB environment variable and is unlimited by default.
+  static BufferBudget* Global();
+
+  // Records that `num_bytes` more bytes are buffered.
+  void Add(int64 num_bytes) { used_bytes_ += num_bytes; }
+
+  // Records that `num_bytes` buffered bytes have been released.
+  void Remove(int64 num_bytes) { used_bytes_ -= num_bytes; }
+
+  // Returns whether the buffered bytes exceed the limit.
+  bool Exceeded() const {
+    return limit_bytes_ > 0 && used_bytes_ > limit_bytes_;
+  }
+
+  int64 limit_bytes() const { return limit_bytes_; }
+  int64 used_bytes() const { return used_bytes_; }
+
+ private:
+  const int64 limit_bytes_;
+  std::atomic<int64> used_bytes_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BufferBudget);
+};
+
 // Represents the current position in a range of outputs, where the
 // range of outputs is typically represented by an `DatasetBase`,
 // defined below.
@@ -418,6 +462,11 @@ class IteratorBase {
   // properly propagate errors.
   virtual Status Initialize(IteratorContext* ctx) { return Status::OK(); }
 
+  // Returns the number of bytes of elements buffered by this iterator, not
+  // including the bytes buffered by its input iterators. Iterators that buffer
+  // elements also account for them in `BufferBudget::Global()`.
+  virtual int64 BufferedBytes() { return 0; }
+
   // Saves the state of this iterator.
   virtual Status Save(SerializationContext* ctx, IteratorStateWriter* writer) {
     return SaveInternal(writer);
@@ -603,7 +652,7 @@ class DatasetBaseIterator : public IteratorBase {
     tracing::ScopedActivity activity(params_.prefix);
     RecordStart(ctx, true /* stop_output */);
     Status s = GetNextInternal(ctx, out_tensors, end_of_sequence);
-    if (s.ok() && !*end_of_sequence) RecordElement(ctx);
+    if (s.ok() && !*end_of_sequence) RecordElement(ctx, *out_tensors);
     RecordStop(ctx, true /* start_output */);
     if (TF_PREDICT_FALSE(errors::IsOutOfRange(s) && !*end_of_sequence)) {
       s = errors::Internal(
@@ -656,13 +705,18 @@ class DatasetBaseIterator : public IteratorBase {
   }
 
   // When performance modeling is enabled, this method records the fact that
-  // this iterator has produced an element.
-  void RecordElement(IteratorContext* ctx) {
+  // this iterator has produced the given element.
+  void RecordElement(IteratorContext* ctx, const std::vector<Tensor>& element) {
     if (ctx->model()) {
-      ctx->model()->RecordElement(prefix());
+      ctx->model()->RecordElement(prefix(), GetTotalBytes(element));
     }
   }
 
+  // When statistics collection is enabled, this method records the number of
+  // bytes buffered by this iterator and by all tf.data iterators of the
+  // process.
+  void RecordBufferedBytes(IteratorContext* ctx, int64 num_bytes);
+
   // When performance modeling is enabled, this method records the fact that
   // a thread of this iterator has started work.
   void RecordStart(IteratorContext* ctx, bool stop_output = false) {
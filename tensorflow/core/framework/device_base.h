@@ -177,6 +177,13 @@ class DeviceBase {
     return nullptr;
   }
 
+  // Return the Allocator to use for temporaries allocated by a kernel
+  // through OpKernelContext::allocate_temp(), which rarely outlive the step
+  // that allocates them. Defaults to GetAllocator().
+  virtual Allocator* GetTempAllocator(AllocatorAttributes attr) {
+    return GetAllocator(attr);
+  }
+
   // This method is provided for backwards compatibility, and will be removed
   // in a future release.
   ABSL_DEPRECATED("Use `this->GetAllocator()` or `this->GetScopedAllocator()`.")
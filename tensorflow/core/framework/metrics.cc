@@ -0,0 +1,133 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/metrics.h"
+
+namespace tensorflow {
+namespace metrics {
+
+namespace {
+
+// Buckets from 1us to about 9 minutes.
+std::unique_ptr<monitoring::Buckets> LatencyBuckets() {
+  return monitoring::Buckets::Exponential(1, 2, 30);
+}
+
+auto* graph_run_time_usecs = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/graph_run_time_usecs",
+     "The time an executor took to run a graph."},
+    LatencyBuckets());
+
+auto* executor_queueing_time_usecs = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/executor_queueing_time_usecs",
+     "The time a node ready to run waited for a thread."},
+    LatencyBuckets());
+
+auto* allocator_bytes_in_use = monitoring::Gauge<int64, 1>::New(
+    "/tensorflow/core/allocator_bytes_in_use",
+    "The bytes in use in an allocator.", "allocator");
+
+auto* rendezvous_wait_time_usecs = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/rendezvous_wait_time_usecs",
+     "The time a _Recv op waited for its tensor."},
+    LatencyBuckets());
+
+auto* rpc_latency_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/rpc_client_latency_usecs",
+     "The latency of the client calls to an RPC method.", "method"},
+    LatencyBuckets());
+
+auto* tf_data_element_latency_usecs = monitoring::Sampler<0>::New(
+    {"/tensorflow/data/element_latency_usecs",
+     "The time an IteratorGetNext op waited for an element."},
+    LatencyBuckets());
+
+auto* xla_compilation_time_usecs = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/xla_compilation_time_usecs",
+     "The time an XLA compilation took."},
+    LatencyBuckets());
+
+auto* repeated_steps = monitoring::Counter<0>::New(
+    "/tensorflow/core/repeated_steps",
+    "The steps a worker ran as part of a RunGraph call with several steps.");
+
+auto* shape_inference_cache_lookups = monitoring::Counter<1>::New(
+    "/tensorflow/core/shape_inference_cache_lookups",
+    "The lookups of the shape inference cache, by result.", "result");
+
+auto* shape_inference_cache_saved_usecs = monitoring::Counter<0>::New(
+    "/tensorflow/core/shape_inference_cache_saved_usecs",
+    "The time not spent running shape functions thanks to the shape "
+    "inference cache.");
+
+}  // namespace
+
+void UpdateGraphExecTime(uint64 running_time_usecs) {
+  static monitoring::SamplerCell* cell = graph_run_time_usecs->GetCell();
+  cell->Add(running_time_usecs);
+}
+
+void UpdateExecutorQueueingTime(uint64 queueing_time_usecs) {
+  static monitoring::SamplerCell* cell =
+      executor_queueing_time_usecs->GetCell();
+  cell->Add(queueing_time_usecs);
+}
+
+monitoring::GaugeCell<int64>* GetAllocatorBytesInUseCell(const string& name) {
+  return allocator_bytes_in_use->GetCell(name);
+}
+
+void UpdateRendezvousWaitTime(uint64 wait_time_usecs) {
+  static monitoring::SamplerCell* cell = rendezvous_wait_time_usecs->GetCell();
+  cell->Add(wait_time_usecs);
+}
+
+monitoring::SamplerCell* GetRpcLatencyCell(const string& method) {
+  return rpc_latency_usecs->GetCell(method);
+}
+
+void UpdateTfDataElementLatency(uint64 latency_usecs) {
+  static monitoring::SamplerCell* cell =
+      tf_data_element_latency_usecs->GetCell();
+  cell->Add(latency_usecs);
+}
+
+void UpdateXlaCompilationTime(uint64 compilation_time_usecs) {
+  static monitoring::SamplerCell* cell = xla_compilation_time_usecs->GetCell();
+  cell->Add(compilation_time_usecs);
+}
+
+void RecordRepeatedStep() {
+  static monitoring::CounterCell* cell = repeated_steps->GetCell();
+  cell->IncrementBy(1);
+}
+
+void RecordShapeInferenceCacheLookup(bool hit, uint64 saved_time_usecs) {
+  static monitoring::CounterCell* hits =
+      shape_inference_cache_lookups->GetCell("hit");
+  static monitoring::CounterCell* misses =
+      shape_inference_cache_lookups->GetCell("miss");
+  static monitoring::CounterCell* saved =
+      shape_inference_cache_saved_usecs->GetCell();
+  if (hit) {
+    hits->IncrementBy(1);
+    saved->IncrementBy(saved_time_usecs);
+  } else {
+    misses->IncrementBy(1);
+  }
+}
+
+}  // namespace metrics
+}  // namespace tensorflow
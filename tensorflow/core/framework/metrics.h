@@ -0,0 +1,67 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_FRAMEWORK_METRICS_H_
+#define TENSORFLOW_CORE_FRAMEWORK_METRICS_H_
+
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/types.h"
+
+// Metrics of the runtime, exported through the monitoring CollectionRegistry.
+// All the times are in microseconds.
+//
+// The functions returning a cell are meant for hot paths, which look the
+// cell up once and keep it.
+namespace tensorflow {
+namespace metrics {
+
+// Records the time an executor took to run a graph, i.e. a partition of a
+// step or a function.
+void UpdateGraphExecTime(uint64 running_time_usecs);
+
+// Records the time a node ready to run waited for a thread.
+void UpdateExecutorQueueingTime(uint64 queueing_time_usecs);
+
+// Returns the cell holding the bytes in use in the allocator named `name`.
+monitoring::GaugeCell<int64>* GetAllocatorBytesInUseCell(const string& name);
+
+// Records the time a _Recv op waited for its tensor.
+void UpdateRendezvousWaitTime(uint64 wait_time_usecs);
+
+// Returns the cell of the latency of the client calls to the RPC `method`.
+monitoring::SamplerCell* GetRpcLatencyCell(const string& method);
+
+// Records the time an IteratorGetNext op waited for an element of its
+// tf.data input pipeline.
+void UpdateTfDataElementLatency(uint64 latency_usecs);
+
+// Records the time an XLA compilation took.
+void UpdateXlaCompilationTime(uint64 compilation_time_usecs);
+
+// Counts a step that a worker ran as part of a RunGraph call with several
+// steps. Scraping this counter shows the progress of such calls before they
+// return to the master.
+void RecordRepeatedStep();
+
+// Counts a lookup of the shape inference cache of ShapeRefiner. On a hit,
+// also records the time the shape function took when its result was cached.
+void RecordShapeInferenceCacheLookup(bool hit, uint64 saved_time_usecs);
+
+}  // namespace metrics
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_FRAMEWORK_METRICS_H_
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/model.h"
 
+#include <algorithm>
 #include <memory>
 
 namespace tensorflow {
@@ -30,7 +31,6 @@ void Model::Node::CollectTunables(
   }
   switch (type_) {
     case Type::MAP_AND_BATCH:
-    case Type::PARALLEL_INTERLEAVE_V2:
     case Type::PARALLEL_MAP: {
       if (auto* tunable_param =
               gtl::FindOrNull(tunable_params_, "parallelism")) {
@@ -38,11 +38,63 @@ void Model::Node::CollectTunables(
       }
       return;
     }
+    case Type::PARALLEL_INTERLEAVE_V2: {
+      if (auto* tunable_param =
+              gtl::FindOrNull(tunable_params_, "parallelism")) {
+        tunables->push_back(*tunable_param);
+      }
+      if (auto* tunable_param =
+              gtl::FindOrNull(tunable_params_, "buffered_blocks")) {
+        tunables->push_back(*tunable_param);
+      }
+      return;
+    }
+    case Type::PREFETCH: {
+      if (auto* tunable_param =
+              gtl::FindOrNull(tunable_params_, "buffer_size")) {
+        tunables->push_back(*tunable_param);
+      }
+      return;
+    }
     default:
       return;
   }
 }
 
+int64 Model::Node::BufferedBytes() {
+  tf_shared_lock l(mu_);
+  int64 result = 0;
+  for (auto input : inputs_) {
+    result += input->BufferedBytes();
+  }
+  switch (type_) {
+    case Type::MAP_AND_BATCH: {
+      int64 batch_size = GetParameterValue("batch_size");
+      int64 parallelism = GetParameterValue("parallelism");
+      if (batch_size > 0) {
+        result += (parallelism + batch_size - 1) / batch_size *
+                  BytesPerElementLocked();
+      }
+      return result;
+    }
+    case Type::PARALLEL_INTERLEAVE_V2: {
+      return result + GetParameterValue("buffered_blocks") *
+                          GetParameterValue("block_length") *
+                          BytesPerElementLocked();
+    }
+    case Type::PARALLEL_MAP: {
+      return result +
+             GetParameterValue("parallelism") * BytesPerElementLocked();
+    }
+    case Type::PREFETCH: {
+      return result +
+             GetParameterValue("buffer_size") * BytesPerElementLocked();
+    }
+    default:
+      return result;
+  }
+}
+
 int64 Model::Node::GetParameterValue(const string& name) {
   if (auto* tunable_param = gtl::FindOrNull(tunable_params_, name)) {
     return (*tunable_param)->value;
@@ -210,6 +262,13 @@ int64 Model::Node::OutputTimeLocked(std::vector<int64>* input_times) {
       double parallelism =
           std::min(static_cast<int>(GetParameterValue("cycle_length")),
                    static_cast<int>(GetParameterValue("parallelism")));
+      // Each in-flight fetch fills a block of the result buffer, so a buffer
+      // of fewer blocks than `parallelism` limits the parallelism.
+      int64 buffered_blocks = GetParameterValue("buffered_blocks");
+      if (buffered_blocks > 0) {
+        parallelism =
+            std::min(parallelism, static_cast<double>(buffered_blocks));
+      }
       int64 output_time =
           NanosPerElementLocked() + ((static_cast<double>(inputs_output_time) /
                                       static_cast<double>(inputs_.size() - 1)) /
@@ -237,9 +296,19 @@ int64 Model::Node::OutputTimeLocked(std::vector<int64>* input_times) {
       input_times->push_back(delta);
       auto cleanup =
           gtl::MakeCleanup([input_times]() { input_times->pop_back(); });
-      return std::max(0LL, NanosPerElementLocked() +
-                               OutputTimeForInputs(input_times) -
-                               input_times->at(input_times->size() - 2));
+      int64 producer_time =
+          NanosPerElementLocked() + OutputTimeForInputs(input_times);
+      int64 consumer_time = input_times->at(input_times->size() - 2);
+      // A buffer of `buffer_size` elements absorbs fluctuations of the time it
+      // takes to produce an element; the time the consumer still spends waiting
+      // is modeled to decrease inversely with the buffer size.
+      int64 wait_time =
+          consumer_time > 0 ? std::min(producer_time, consumer_time)
+                            : producer_time;
+      double buffer_size = std::max(0LL, GetParameterValue("buffer_size"));
+      return std::max(0LL, producer_time - consumer_time) +
+             static_cast<int64>(static_cast<double>(wait_time) /
+                                (buffer_size + 1));
     }
     case Type::CACHE:
     case Type::CONCATENATE:
@@ -268,6 +337,7 @@ std::shared_ptr<Model::Node> Model::Node::Snapshot(
       std::make_shared<Node>(id_, name_, std::move(output));
   result->processing_time_ = processing_time_;
   result->num_elements_ = num_elements_;
+  result->bytes_produced_ = bytes_produced_;
   result->constant_params_ = constant_params_;
   result->tunable_params_ = tunable_params_;
   for (auto& input : inputs_) {
@@ -276,6 +346,21 @@ std::shared_ptr<Model::Node> Model::Node::Snapshot(
   return result;
 }
 
+Model::NodeStats Model::Node::Stats(const string& name) {
+  tf_shared_lock l(mu_);
+  NodeStats stats;
+  stats.name = name;
+  stats.num_elements = num_elements_;
+  stats.bytes_produced = bytes_produced_;
+  stats.processing_time_nanos = processing_time_;
+  if (auto* tunable_param = gtl::FindOrNull(tunable_params_, "parallelism")) {
+    stats.parallelism = (*tunable_param)->value;
+  } else if (auto* value = gtl::FindOrNull(constant_params_, "parallelism")) {
+    stats.parallelism = *value;
+  }
+  return stats;
+}
+
 void Model::AddConstantParameter(const string& node_name,
                                  const string& parameter_name, int64 value) {
   tf_shared_lock l(mu_);
@@ -336,8 +421,10 @@ void Model::AddTunableParameter(const string& node_name,
 // in parallelism decreases the output time the most. This process is repeated
 // until all parameters reach their maximum values or the projected output time
 // is less than or equal to the processing time needed to produce an element
-// divided by CPU budget.
-void Model::Optimize(int64 cpu_budget) {
+// divided by CPU budget. Increases that would make the estimated amount of
+// memory buffered by the input pipeline exceed the RAM budget are not
+// considered.
+void Model::Optimize(int64 cpu_budget, int64 ram_budget) {
   std::shared_ptr<Model::Node> snapshot;
   {
     tf_shared_lock lock(mu_);
@@ -362,18 +449,27 @@ void Model::Optimize(int64 cpu_budget) {
     }
     int64 best_delta = -1;
     Model::Node::Tunable* best_tunable = nullptr;
+    bool within_ram_budget = false;
     for (auto& tunable : tunables) {
       if (tunable->value == tunable->max) {
         continue;
       }
       tunable->value++;
-      int64 delta = output_time - OutputTime(snapshot);
-      if (delta > best_delta) {
-        best_delta = delta;
-        best_tunable = tunable.get();
+      if (BufferedBytes(snapshot) <= ram_budget) {
+        within_ram_budget = true;
+        int64 delta = output_time - OutputTime(snapshot);
+        if (delta > best_delta) {
+          best_delta = delta;
+          best_tunable = tunable.get();
+        }
       }
       tunable->value--;
     }
+    if (!within_ram_budget) {
+      // Every remaining increase would exceed the RAM budget.
+      VLOG(2) << "Reached the RAM budget of " << ram_budget << " bytes.";
+      break;
+    }
     if (!best_tunable) {
       // This should never happen because we are using a model snapshot and
       // the output time is monotonically decreasing w.r.t. parallelism.
@@ -393,11 +489,11 @@ void Model::Optimize(int64 cpu_budget) {
   }
 }
 
-void Model::RecordElement(const string& name) {
+void Model::RecordElement(const string& name, int64 num_bytes) {
   tf_shared_lock l(mu_);
   auto node = gtl::FindOrNull(lookup_table_, name);
   if (node) {
-    (*node)->record_element();
+    (*node)->record_element(num_bytes);
   }
 }
 
@@ -432,6 +528,16 @@ void Model::RemoveNode(const string& name) {
   lookup_table_.erase(name);
 }
 
+std::vector<Model::NodeStats> Model::GetNodeStats() {
+  tf_shared_lock l(mu_);
+  std::vector<NodeStats> stats;
+  stats.reserve(lookup_table_.size());
+  for (const auto& node : lookup_table_) {
+    stats.push_back(node.second->Stats(node.first));
+  }
+  return stats;
+}
+
 std::vector<std::shared_ptr<Model::Node::Tunable>> Model::CollectTunables(
     std::shared_ptr<Model::Node> node) {
   std::vector<std::shared_ptr<Model::Node::Tunable>> tunables;
@@ -439,6 +545,10 @@ std::vector<std::shared_ptr<Model::Node::Tunable>> Model::CollectTunables(
   return tunables;
 }
 
+int64 Model::BufferedBytes(std::shared_ptr<Model::Node> node) {
+  return node->BufferedBytes();
+}
+
 int64 Model::OutputTime(std::shared_ptr<Model::Node> node) {
   std::vector<int64> input_times(1, 0);
   return node->OutputTime(&input_times);
@@ -448,6 +558,21 @@ int64 Model::ProcessingTime(std::shared_ptr<Model::Node> node) {
   return node->ProcessingTime();
 }
 
+int64 AdjustCpuBudget(int64 cpu_budget, double stall_fraction,
+                      int64 num_cpus) {
+  // The consumer stalls more than this when the input pipeline is the
+  // bottleneck, and less than the lower threshold when it keeps up easily.
+  constexpr double kHighStallFraction = 0.05;
+  constexpr double kLowStallFraction = 0.01;
+  if (stall_fraction > kHighStallFraction) {
+    cpu_budget += std::max<int64>(1, cpu_budget / 2);
+  } else if (stall_fraction < kLowStallFraction) {
+    cpu_budget -= std::max<int64>(1, cpu_budget / 8);
+  }
+  cpu_budget = std::min(cpu_budget, num_cpus);
+  return std::max<int64>(cpu_budget, 1);
+}
+
 }  // namespace model
 }  // namespace data
 }  // namespace tensorflow
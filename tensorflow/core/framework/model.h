@@ -58,6 +58,19 @@ struct SharedState {
 // implementation of `DatasetBase` and `DatasetBaseIterator` respectively.
 class Model {
  public:
+  // Statistics of an iterator of the model.
+  struct NodeStats {
+    // The sequence of iterators leading up to the iterator, joined by `::`.
+    string name;
+    int64 num_elements = 0;
+    int64 bytes_produced = 0;
+    // The time spent producing the elements, excluding the time spent in the
+    // inputs, summed over all the threads of the iterator.
+    int64 processing_time_nanos = 0;
+    // The number of elements the iterator produces in parallel.
+    int64 parallelism = 1;
+  };
+
   Model() = default;
 
   // Adds a constant parameter for the given node.
@@ -78,11 +91,13 @@ class Model {
                            std::shared_ptr<SharedState> value, int64 min,
                            int64 max) LOCKS_EXCLUDED(mu_);
 
-  // Runs optimization.
-  void Optimize(int64 cpu_budget) LOCKS_EXCLUDED(mu_);
+  // Runs optimization. Tunable parameters are only increased as long as the
+  // estimated amount of memory buffered by the input pipeline stays within
+  // `ram_budget` bytes.
+  void Optimize(int64 cpu_budget, int64 ram_budget) LOCKS_EXCLUDED(mu_);
 
-  // Records that a node has produced an element.
-  void RecordElement(const string& name) LOCKS_EXCLUDED(mu_);
+  // Records that a node has produced an element of `num_bytes` bytes.
+  void RecordElement(const string& name, int64 num_bytes) LOCKS_EXCLUDED(mu_);
 
   // Records that the given node has started work. If `stop_output` is set, it
   // also records that the output of the given node has stopped work.
@@ -95,6 +110,9 @@ class Model {
   // Removes the given node.
   void RemoveNode(const string& name) LOCKS_EXCLUDED(mu_);
 
+  // Returns the statistics of all the iterators of the model, sorted by name.
+  std::vector<NodeStats> GetNodeStats() LOCKS_EXCLUDED(mu_);
+
  private:
   // Abstract representation of a TensorFlow input pipeline node. It collects
   // information about inputs to this node, processing time spent executing the
@@ -173,6 +191,10 @@ class Model {
     // Returns the unique node ID.
     int64 id() LOCKS_EXCLUDED(mu_) { return id_; }
 
+    // Returns the estimated number of bytes buffered in the subtree rooted in
+    // this node.
+    int64 BufferedBytes() LOCKS_EXCLUDED(mu_);
+
     // Returns the node inputs.
     std::list<std::shared_ptr<Node>> inputs() LOCKS_EXCLUDED(mu_) {
       tf_shared_lock l(mu_);
@@ -197,10 +219,11 @@ class Model {
       return output_;
     }
 
-    // Records that the node produced an element.
-    void record_element() LOCKS_EXCLUDED(mu_) {
+    // Records that the node produced an element of `num_bytes` bytes.
+    void record_element(int64 num_bytes) LOCKS_EXCLUDED(mu_) {
       mutex_lock l(mu_);
       num_elements_++;
+      bytes_produced_ += num_bytes;
     }
 
     // Records that a node thread has started executing.
@@ -259,6 +282,9 @@ class Model {
     std::shared_ptr<Node> Snapshot(std::shared_ptr<Node> output)
         LOCKS_EXCLUDED(mu_);
 
+    // Returns the statistics of the node, which is looked up by `name`.
+    NodeStats Stats(const string& name) LOCKS_EXCLUDED(mu_);
+
    private:
     enum class Type {
       BATCH = 0,
@@ -291,6 +317,14 @@ class Model {
       return NanosPerElementLocked();
     }
 
+    // Returns the average size of the elements produced by this node.
+    int64 BytesPerElementLocked() SHARED_LOCKS_REQUIRED(mu_) {
+      if (num_elements_ == 0) {
+        return 0;
+      }
+      return (int64)((double)bytes_produced_ / (double)num_elements_);
+    }
+
     int64 NanosPerElementLocked() SHARED_LOCKS_REQUIRED(mu_) {
       if (num_elements_ == 0) {
         return 0;
@@ -385,6 +419,7 @@ class Model {
     const Type type_;
     int64 processing_time_ GUARDED_BY(mu_) = 0;
     int64 num_elements_ GUARDED_BY(mu_) = 0;
+    int64 bytes_produced_ GUARDED_BY(mu_) = 0;
     std::map<std::thread::id, int64> work_start_ GUARDED_BY(mu_);
     std::map<string, int64> constant_params_ GUARDED_BY(mu_);
     // Tunables are shared with the model during optimization.
@@ -397,6 +432,9 @@ class Model {
   std::vector<std::shared_ptr<Node::Tunable>> CollectTunables(
       std::shared_ptr<Node> node);
 
+  // Collects the buffered bytes for the given node.
+  int64 BufferedBytes(std::shared_ptr<Node> node);
+
   // Collects the output time for the given node.
   int64 OutputTime(std::shared_ptr<Node> node);
 
@@ -412,6 +450,13 @@ class Model {
   std::map<string, std::shared_ptr<Node>> lookup_table_ GUARDED_BY(mu_);
 };
 
+// Returns the number of CPUs, out of `num_cpus`, to give an input pipeline
+// for the next optimization period, given its `cpu_budget` for the last one
+// and the fraction of that period that the consumer of the pipeline spent
+// waiting for elements. The budget grows while the consumer stalls, and
+// otherwise shrinks to leave the CPUs to the computation.
+int64 AdjustCpuBudget(int64 cpu_budget, double stall_fraction, int64 num_cpus);
+
 }  // namespace model
 }  // namespace data
 }  // namespace tensorflow
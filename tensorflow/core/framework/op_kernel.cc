@@ -296,6 +296,17 @@ Allocator* OpKernelContext::get_allocator(AllocatorAttributes attr) {
   } else {
     allocator = params_->device->GetAllocator(attr);
   }
+  return MaybeWrapAllocator(allocator);
+}
+
+Allocator* OpKernelContext::get_temp_allocator(AllocatorAttributes attr) {
+  if (TF_PREDICT_FALSE(attr.scope_id > 0)) {
+    return get_allocator(attr);
+  }
+  return MaybeWrapAllocator(params_->device->GetTempAllocator(attr));
+}
+
+Allocator* OpKernelContext::MaybeWrapAllocator(Allocator* allocator) {
   if (TF_PREDICT_FALSE(track_allocations())) {
     mutex_lock lock(mu_);
     for (const auto& wrapped : wrapped_allocators_) {
@@ -676,9 +687,17 @@ Status OpKernelContext::allocate_output(StringPiece name,
 Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
     AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+  return allocate_tensor(get_allocator(attr), type, shape, out_tensor,
+                         allocation_attr);
+}
+
+Status OpKernelContext::allocate_tensor(
+    Allocator* a, DataType type, const TensorShape& shape, Tensor* out_tensor,
+    const AllocationAttributes& allocation_attr) {
   AllocationAttributes logged_attr(allocation_attr);
   logged_attr.allocation_will_be_logged = true;
+  logged_attr.op_name = params_->op_kernel->name();
+  logged_attr.step_id = params_->step_id;
   Tensor new_tensor(a, type, shape, logged_attr);
 
   if (!new_tensor.IsInitialized()) {
@@ -717,10 +736,9 @@ Status OpKernelContext::allocate_temp(
     DataType type, const TensorShape& shape, Tensor* out_temp,
     AllocatorAttributes allocator_attr,
     const AllocationAttributes& allocation_attr) {
-  Status s =
-      allocate_tensor(type, shape, out_temp, allocator_attr, allocation_attr);
+  Allocator* a = get_temp_allocator(allocator_attr);
+  Status s = allocate_tensor(a, type, shape, out_temp, allocation_attr);
   if (track_allocations() && s.ok() && out_temp->TotalBytes() > 0) {
-    Allocator* a = get_allocator(allocator_attr);
     if (a->TracksAllocationSizes()) {
       int64 alloc_size = a->AllocatedSize(out_temp->tensor_data().data());
       record_temp_memory_allocation(alloc_size, *out_temp);
@@ -15,7 +15,6 @@ limitations under the License.
 
 #include "tensorflow/core/framework/rendezvous.h"
 
-#include <deque>
 #include <functional>
 #include <utility>
 #include <vector>
@@ -155,15 +154,16 @@ class LocalRendezvousImpl : public Rendezvous {
     uint64 key_hash = KeyHash(key.FullKey());
     VLOG(2) << "Send " << this << " " << key_hash << " " << key.FullKey();
 
-    mu_.lock();
-    if (!status_.ok()) {
+    Shard* shard = GetShard(key_hash);
+    shard->mu.lock();
+    if (!shard->status.ok()) {
       // Rendezvous has been aborted.
-      Status s = status_;
-      mu_.unlock();
+      Status s = shard->status;
+      shard->mu.unlock();
       return s;
     }
 
-    ItemQueue* queue = &table_[key_hash];
+    ItemQueue* queue = &shard->table[key_hash];
     if (queue->empty() || queue->front()->IsSendValue()) {
       // There is no waiter for this message. Append the message
       // into the queue. The waiter will pick it up when arrives.
@@ -176,14 +176,13 @@ class LocalRendezvousImpl : public Rendezvous {
         item->send_args.device_context->Ref();
       }
       queue->push_back(item);
-      mu_.unlock();
+      shard->mu.unlock();
       return Status::OK();
     }
 
     // There is an earliest waiter to consume this message.
-    Item* item = queue->front();
-    queue->pop_front();
-    mu_.unlock();
+    Item* item = queue->pop_front();
+    shard->mu.unlock();
 
     // Notify the waiter by invoking its done closure, outside the
     // lock.
@@ -198,16 +197,17 @@ class LocalRendezvousImpl : public Rendezvous {
     uint64 key_hash = KeyHash(key.FullKey());
     VLOG(2) << "Recv " << this << " " << key_hash << " " << key.FullKey();
 
-    mu_.lock();
-    if (!status_.ok()) {
+    Shard* shard = GetShard(key_hash);
+    shard->mu.lock();
+    if (!shard->status.ok()) {
       // Rendezvous has been aborted.
-      Status s = status_;
-      mu_.unlock();
+      Status s = shard->status;
+      shard->mu.unlock();
       done(s, Args(), recv_args, Tensor(), false);
       return;
     }
 
-    ItemQueue* queue = &table_[key_hash];
+    ItemQueue* queue = &shard->table[key_hash];
     if (queue->empty() || !queue->front()->IsSendValue()) {
       // There is no message to pick up.
       // Only recv-related fields need to be filled.
@@ -218,15 +218,14 @@ class LocalRendezvousImpl : public Rendezvous {
         item->recv_args.device_context->Ref();
       }
       queue->push_back(item);
-      mu_.unlock();
+      shard->mu.unlock();
       return;
     }
 
     // A message has already arrived and is queued in the table under
     // this key.  Consumes the message and invokes the done closure.
-    Item* item = queue->front();
-    queue->pop_front();
-    mu_.unlock();
+    Item* item = queue->pop_front();
+    shard->mu.unlock();
 
     // Invokes the done() by invoking its done closure, outside scope
     // of the table lock.
@@ -237,18 +236,24 @@ class LocalRendezvousImpl : public Rendezvous {
 
   void StartAbort(const Status& status) override {
     CHECK(!status.ok());
-    Table table;
-    {
-      mutex_lock l(mu_);
-      status_.Update(status);
-      table_.swap(table);
-    }
-    for (auto& p : table) {
-      for (Item* item : p.second) {
-        if (!item->IsSendValue()) {
-          item->waiter(status, Args(), Args(), Tensor(), false);
+    // Serializes the aborts so that every shard keeps the same status.
+    mutex_lock abort_lock(abort_mu_);
+    for (Shard& shard : shards_) {
+      Table table;
+      {
+        mutex_lock l(shard.mu);
+        shard.status.Update(status);
+        shard.table.swap(table);
+      }
+      for (auto& p : table) {
+        ItemQueue* queue = &p.second;
+        while (!queue->empty()) {
+          Item* item = queue->pop_front();
+          if (!item->IsSendValue()) {
+            item->waiter(status, Args(), Args(), Tensor(), false);
+          }
+          delete item;
         }
-        delete item;
       }
     }
   }
@@ -262,6 +267,8 @@ class LocalRendezvousImpl : public Rendezvous {
     bool is_dead = false;
     Args send_args;
     Args recv_args;
+    // The next item in the same ItemQueue.
+    Item* next = nullptr;
 
     ~Item() {
       if (send_args.device_context) {
@@ -286,17 +293,68 @@ class LocalRendezvousImpl : public Rendezvous {
   // or
   //   [!item.IsSendValue()]* meaning each item is a waiter.
   //
-  // TODO(zhifengc): consider a better queue impl than std::deque.
-  typedef std::deque<Item*> ItemQueue;
+  // The queue is a list linked through the items themselves, so that
+  // queueing an item allocates nothing beyond the item. Most keys only
+  // ever hold a single item, for which a std::deque would allocate a
+  // whole block.
+  class ItemQueue {
+   public:
+    bool empty() const { return head_ == nullptr; }
+    Item* front() const { return head_; }
+
+    void push_back(Item* item) {
+      DCHECK(item->next == nullptr);
+      if (tail_ == nullptr) {
+        head_ = item;
+      } else {
+        tail_->next = item;
+      }
+      tail_ = item;
+    }
+
+    Item* pop_front() {
+      DCHECK(!empty());
+      Item* item = head_;
+      head_ = item->next;
+      if (head_ == nullptr) tail_ = nullptr;
+      item->next = nullptr;
+      return item;
+    }
+
+   private:
+    Item* head_ = nullptr;
+    Item* tail_ = nullptr;
+  };
   typedef gtl::FlatMap<uint64, ItemQueue> Table;
 
-  // TODO(zhifengc): shard table_.
-  mutex mu_;
-  Table table_ GUARDED_BY(mu_);
-  Status status_ GUARDED_BY(mu_);
+  // The table is sharded by key hash, so that Sends and Recvs of
+  // different keys (e.g. of different devices) mostly take different
+  // locks. Every shard also records the abort status, so that an
+  // operation only takes the lock of its own shard.
+  static constexpr int kNumShardBits = 4;
+  static constexpr int kNumShards = 1 << kNumShardBits;
+  struct Shard {
+    mutex mu;
+    Table table GUARDED_BY(mu);
+    Status status GUARDED_BY(mu);
+  };
+
+  Shard* GetShard(uint64 key_hash) {
+    // The low bits of the hash also pick the bucket of the FlatMap, so
+    // the shard is picked with the high bits.
+    return &shards_[key_hash >> (64 - kNumShardBits)];
+  }
+
+  mutex abort_mu_;
+  Shard shards_[kNumShards];
 
   ~LocalRendezvousImpl() override {
-    if (!table_.empty()) {
+    bool empty = true;
+    for (Shard& shard : shards_) {
+      mutex_lock l(shard.mu);
+      empty &= shard.table.empty();
+    }
+    if (!empty) {
       StartAbort(errors::Cancelled("LocalRendezvousImpl deleted"));
     }
   }
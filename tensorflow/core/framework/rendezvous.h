@@ -48,6 +48,9 @@ class Rendezvous : public core::RefCounted {
   struct Args {
     DeviceContext* device_context = nullptr;
     AllocatorAttributes alloc_attrs;
+    // If not negative, remote rendezvous may hold receives back to start
+    // them in increasing order of priority.
+    int64 priority = -1;
   };
 
   // Constructs a rendezvous key for the tensor of "name" sent from
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -282,6 +283,33 @@ class DummyDeviceContext : public DeviceContext {
   const int stream_id_;
 };
 
+TEST_F(LocalRendezvousTest, AbortWaitersOfManyKeys) {
+  // The keys are spread over all the shards of the table.
+  const int kNumKeys = 100;
+  for (int i = 0; i < kNumKeys; ++i) {
+    TF_ASSERT_OK(rendez_->Send(MakeKey(strings::StrCat("send", i)),
+                               Rendezvous::Args(), V("hello"), false));
+  }
+  mutex mu;
+  int num_aborted = 0;
+  for (int i = 0; i < kNumKeys; ++i) {
+    rendez_->RecvAsync(
+        MakeKey(strings::StrCat("recv", i)), Rendezvous::Args(),
+        [&mu, &num_aborted](const Status& s, const Rendezvous::Args&,
+                            const Rendezvous::Args&, const Tensor&, bool) {
+          EXPECT_TRUE(errors::IsAborted(s));
+          mutex_lock l(mu);
+          ++num_aborted;
+        });
+  }
+  rendez_->StartAbort(errors::Aborted(""));
+  EXPECT_EQ(kNumKeys, num_aborted);
+  Tensor val(DT_STRING);
+  bool is_dead = false;
+  EXPECT_TRUE(errors::IsAborted(rendez_->Recv(
+      MakeKey("send0"), Rendezvous::Args(), &val, &is_dead)));
+}
+
 TEST_F(LocalRendezvousTest, TransferDummyDeviceContext) {
   Rendezvous::Args args;
   args.device_context = new DummyDeviceContext(123);
@@ -358,5 +386,44 @@ void BM_PingPong(int iters) {
 }
 BENCHMARK(BM_PingPong);
 
+// Measures the contention on the table of a rendezvous that many threads
+// send to and receive from, each with its own keys, like the executors of
+// different devices do.
+void BM_SendRecvContention(int iters, int num_threads) {
+  testing::StopTiming();
+  const int kKeysPerThread = 16;
+  std::vector<std::vector<Rendezvous::ParsedKey>> keys(num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    for (int j = 0; j < kKeysPerThread; ++j) {
+      keys[i].push_back(MakeKey(strings::StrCat("edge_", i, "_", j)));
+    }
+  }
+  Rendezvous* rendez = NewLocalRendezvous();
+  BlockingCounter counter(num_threads);
+  thread::ThreadPool* pool =
+      new thread::ThreadPool(Env::Default(), "test", num_threads);
+  testing::StartTiming();
+  for (int i = 0; i < num_threads; ++i) {
+    pool->Schedule([rendez, iters, &keys, &counter, i]() {
+      Tensor orig = V("val");
+      Tensor val;
+      bool is_dead = false;
+      Rendezvous::Args args;
+      for (int n = 0; n < iters; ++n) {
+        const Rendezvous::ParsedKey& key = keys[i][n % kKeysPerThread];
+        TF_CHECK_OK(rendez->Send(key, args, orig, is_dead));
+        TF_CHECK_OK(rendez->Recv(key, args, &val, &is_dead));
+      }
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  testing::StopTiming();
+  delete pool;
+  rendez->Unref();
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_threads);
+}
+BENCHMARK(BM_SendRecvContention)->Arg(1)->Arg(4)->Arg(16);
+
 }  // namespace
 }  // namespace tensorflow
@@ -17,19 +17,38 @@ limitations under the License.
 
 #include "tensorflow/core/framework/run_handler.h"
 
+#include <deque>
+#include <functional>
+#include <map>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/run_handler_util.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
 
+namespace {
+
+auto* queueing_delay_sampler = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/run_handler/queueing_delay_us",
+     "Time inter-op closures scheduled through a RunHandler were queued "
+     "before running, by the priority of their Session::Run().",
+     "priority"},
+    // Power of 2 buckets from 1us to ~1000s.
+    monitoring::Buckets::Exponential(1, 2, 30));
+
+}  // namespace
+
 // Contains the concrete implementation of the RunHandler.
 // Externally visible RunHandler class simply forwards the work to this one.
 class RunHandler::Impl {
  public:
   explicit Impl(RunHandlerPool::Impl* pool_impl) : pool_impl_(pool_impl) {
-    Reset();
+    Reset(/*priority=*/0);
   }
 
   ~Impl() {}
@@ -48,9 +67,11 @@ class RunHandler::Impl {
   // requested via RunHandlerPool::Get().
   uint64 start_time_us() const { return start_time_us_; }
 
+  int64 priority() const { return priority_; }
+
   void ScheduleInterOpClosure(std::function<void()> fn);
 
-  void Reset();
+  void Reset(int64 priority);
 
   RunHandlerPool::Impl* pool_impl() { return pool_impl_; }
 
@@ -75,6 +96,7 @@ class RunHandler::Impl {
   std::atomic_uint_fast32_t inter_op_scheduling_range_;
   RunHandlerPool::Impl* pool_impl_;  // NOT OWNED.
   uint64 start_time_us_;
+  int64 priority_;
 };
 
 // Contains shared state across all run handlers present in the pool. Also
@@ -82,11 +104,20 @@ class RunHandler::Impl {
 // This class is thread safe.
 class RunHandlerPool::Impl {
  public:
+  static constexpr int64 kDefaultMaxQueueingDelayUs = 10000;
+
   explicit Impl(int num_inter_op_threads)
       : max_handlers_(128),
         inter_op_thread_pool_(new thread::ThreadPool(
             Env::Default(), ThreadOptions(), "inter_op", num_inter_op_threads)),
         iterations_(0) {
+    Status s = ReadInt64FromEnvVar("TF_RUN_HANDLER_MAX_QUEUEING_DELAY_US",
+                                   kDefaultMaxQueueingDelayUs,
+                                   &max_queueing_delay_us_);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      max_queueing_delay_us_ = kDefaultMaxQueueingDelayUs;
+    }
     VLOG(1) << "Creating a RunHandlerPool with max handlers: " << max_handlers_;
     for (int i = 0; i < max_handlers_; ++i) {
       handlers_.emplace_back(new RunHandler::Impl(this));
@@ -106,7 +137,7 @@ class RunHandlerPool::Impl {
     return inter_op_thread_pool_.get();
   }
 
-  std::unique_ptr<RunHandler> Get() LOCKS_EXCLUDED(mu_) {
+  std::unique_ptr<RunHandler> Get(int64 priority) LOCKS_EXCLUDED(mu_) {
     mutex_lock l(mu_);
     while (free_handlers_.empty()) {
       one_handler_free_.wait(l);
@@ -114,7 +145,7 @@ class RunHandlerPool::Impl {
     // Remove the last entry from free_handlers_ and add to the end of
     // sorted_active_handlers_.
     auto* handler_impl = free_handlers_.back();
-    handler_impl->Reset();
+    handler_impl->Reset(priority);
     // Sortedness isn't violated if we simply add at the end of the list, since
     // handlers are expected to be obtained in increasing order of time.
     sorted_active_handlers_.push_back(handler_impl);
@@ -153,15 +184,42 @@ class RunHandlerPool::Impl {
     one_handler_free_.notify_one();
   }
 
+  // Queues `fn` with `priority` and schedules a task on the inter-op thread
+  // pool that runs the next closure to run.
+  void ScheduleClosure(int64 priority, std::function<void()> fn)
+      LOCKS_EXCLUDED(queue_mu_);
+
  private:
   void RecomputePoolStatsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Dequeues and runs the closure with the highest priority, or the one that
+  // was queued first if it has waited for more than max_queueing_delay_us_.
+  void RunNextClosure() LOCKS_EXCLUDED(queue_mu_);
+
+  struct QueuedClosure {
+    std::function<void()> fn;
+    uint64 enqueue_time_us;
+  };
+
+  struct ClosureQueue {
+    std::deque<QueuedClosure> closures;
+    monitoring::SamplerCell* queueing_delay = nullptr;
+  };
+
   // Maximum number of handlers pre-created during pool construction time. The
   // number has been chosen expecting each handler might at least want 1
   // inter-op thread for execution (during compute intensive workloads like
   // inference).
   const int max_handlers_;
 
+  int64 max_queueing_delay_us_;
+
+  // Queued closures by decreasing priority. Declared before
+  // inter_op_thread_pool_ so that they outlive the tasks that run them.
+  mutex queue_mu_;
+  std::map<int64, ClosureQueue, std::greater<int64>> queues_
+      GUARDED_BY(queue_mu_);
+
   // Thread safe part.
   const std::unique_ptr<thread::ThreadPool> inter_op_thread_pool_;
 
@@ -220,16 +278,67 @@ void RunHandlerPool::Impl::RecomputePoolStatsLocked() {
   }
 }
 
+void RunHandlerPool::Impl::ScheduleClosure(int64 priority,
+                                           std::function<void()> fn) {
+  {
+    mutex_lock l(queue_mu_);
+    ClosureQueue& queue = queues_[priority];
+    if (queue.queueing_delay == nullptr) {
+      queue.queueing_delay =
+          queueing_delay_sampler->GetCell(strings::StrCat(priority));
+    }
+    queue.closures.push_back(
+        {std::move(fn), tensorflow::Env::Default()->NowMicros()});
+  }
+  // Each task runs one closure, but not necessarily the one queued here.
+  inter_op_thread_pool_->Schedule([this]() { RunNextClosure(); });
+}
+
+void RunHandlerPool::Impl::RunNextClosure() {
+  QueuedClosure closure;
+  {
+    mutex_lock l(queue_mu_);
+    auto next = queues_.end();
+    auto oldest = queues_.end();
+    for (auto it = queues_.begin(); it != queues_.end(); ++it) {
+      if (it->second.closures.empty()) continue;
+      if (next == queues_.end()) next = it;
+      if (oldest == queues_.end() ||
+          it->second.closures.front().enqueue_time_us <
+              oldest->second.closures.front().enqueue_time_us) {
+        oldest = it;
+      }
+    }
+    // There is one task per queued closure.
+    DCHECK(next != queues_.end());
+    const uint64 now = tensorflow::Env::Default()->NowMicros();
+    const uint64 oldest_time_us =
+        oldest->second.closures.front().enqueue_time_us;
+    if (now > oldest_time_us &&
+        static_cast<int64>(now - oldest_time_us) > max_queueing_delay_us_) {
+      next = oldest;
+    }
+    closure = std::move(next->second.closures.front());
+    next->second.closures.pop_front();
+    const uint64 queued_us = now > closure.enqueue_time_us
+                                 ? now - closure.enqueue_time_us
+                                 : 0;
+    next->second.queueing_delay->Add(queued_us);
+  }
+  closure.fn();
+}
+
 void RunHandler::Impl::ScheduleInterOpClosure(std::function<void()> fn) {
   std::uint_fast32_t start = 0, limit = 0;
   DecodePartition(inter_op_scheduling_range(), &start, &limit);
-  pool_impl_->inter_op_thread_pool()->Schedule(std::move(fn));
+  pool_impl_->ScheduleClosure(priority_, std::move(fn));
 }
 
-void RunHandler::Impl::Reset() {
+void RunHandler::Impl::Reset(int64 priority) {
   set_inter_op_scheduling_range(
       0, pool_impl_->inter_op_thread_pool()->NumThreads());
   start_time_us_ = tensorflow::Env::Default()->NowMicros();
+  priority_ = priority;
 }
 
 RunHandlerPool::RunHandlerPool(int num_inter_op_threads)
@@ -237,7 +346,11 @@ RunHandlerPool::RunHandlerPool(int num_inter_op_threads)
 
 RunHandlerPool::~RunHandlerPool() {}
 
-std::unique_ptr<RunHandler> RunHandlerPool::Get() { return impl_->Get(); }
+std::unique_ptr<RunHandler> RunHandlerPool::Get() { return impl_->Get(0); }
+
+std::unique_ptr<RunHandler> RunHandlerPool::Get(int64 priority) {
+  return impl_->Get(priority);
+}
 
 RunHandler::RunHandler(Impl* impl) : impl_(impl) {}
 
@@ -42,6 +42,15 @@ class RunHandler;
 // * Use handler for scheduling all inter-op work by:
 // handler->ScheduleInterOpClosure(closure);
 //
+// Inter-op closures of all active handlers are queued in the pool and run in
+// order of the priority their handler was obtained with, then in FIFO order,
+// so that a low priority Session::Run() does not delay the closures of higher
+// priority ones. A closure that has been queued for longer than
+// TF_RUN_HANDLER_MAX_QUEUEING_DELAY_US microseconds (10000 by default) runs
+// next regardless of its priority, which bounds starvation. The queueing delay
+// of closures is exported per priority to
+// /tensorflow/core/run_handler/queueing_delay_us.
+//
 // This class is thread safe.
 class RunHandlerPool {
  public:
@@ -58,6 +67,10 @@ class RunHandlerPool {
   // Will block unless there is an inactive handler.
   std::unique_ptr<RunHandler> Get();
 
+  // As above, but closures scheduled on the returned handler run before those
+  // of handlers with a lower `priority`.
+  std::unique_ptr<RunHandler> Get(int64 priority);
+
  private:
   class Impl;
   friend class RunHandler;
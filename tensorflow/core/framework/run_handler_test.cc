@@ -0,0 +1,141 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/run_handler.h"
+
+#include <stdlib.h>
+#include <vector>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Blocks the only inter-op thread of `handler`'s pool until `unblock` is
+// notified, so that closures scheduled meanwhile are all queued.
+void BlockInterOpThread(RunHandler* handler, Notification* blocked,
+                        Notification* unblock) {
+  handler->ScheduleInterOpClosure([blocked, unblock]() {
+    blocked->Notify();
+    unblock->WaitForNotification();
+  });
+  blocked->WaitForNotification();
+}
+
+TEST(RunHandlerTest, RunsHigherPriorityClosuresFirst) {
+  RunHandlerPool pool(/*num_inter_op_threads=*/1);
+  std::unique_ptr<RunHandler> low = pool.Get(/*priority=*/0);
+  std::unique_ptr<RunHandler> high = pool.Get(/*priority=*/10);
+
+  Notification blocked, unblock;
+  BlockInterOpThread(low.get(), &blocked, &unblock);
+
+  mutex mu;
+  std::vector<int> order;
+  BlockingCounter done(4);
+  auto record = [&mu, &order, &done](int id) {
+    return [&mu, &order, &done, id]() {
+      {
+        mutex_lock l(mu);
+        order.push_back(id);
+      }
+      done.DecrementCount();
+    };
+  };
+  low->ScheduleInterOpClosure(record(0));
+  low->ScheduleInterOpClosure(record(1));
+  high->ScheduleInterOpClosure(record(2));
+  high->ScheduleInterOpClosure(record(3));
+  unblock.Notify();
+  done.Wait();
+
+  EXPECT_EQ(order, std::vector<int>({2, 3, 0, 1}));
+}
+
+TEST(RunHandlerTest, RunsStarvedClosuresFirst) {
+  setenv("TF_RUN_HANDLER_MAX_QUEUEING_DELAY_US", "1000", 1);
+  RunHandlerPool pool(/*num_inter_op_threads=*/1);
+  unsetenv("TF_RUN_HANDLER_MAX_QUEUEING_DELAY_US");
+  std::unique_ptr<RunHandler> low = pool.Get(/*priority=*/0);
+  std::unique_ptr<RunHandler> high = pool.Get(/*priority=*/10);
+
+  Notification blocked, unblock;
+  BlockInterOpThread(low.get(), &blocked, &unblock);
+
+  mutex mu;
+  std::vector<int> order;
+  BlockingCounter done(2);
+  low->ScheduleInterOpClosure([&mu, &order, &done]() {
+    {
+      mutex_lock l(mu);
+      order.push_back(0);
+    }
+    done.DecrementCount();
+  });
+  Env::Default()->SleepForMicroseconds(5000);
+  high->ScheduleInterOpClosure([&mu, &order, &done]() {
+    {
+      mutex_lock l(mu);
+      order.push_back(1);
+    }
+    done.DecrementCount();
+  });
+  unblock.Notify();
+  done.Wait();
+
+  EXPECT_EQ(order, std::vector<int>({0, 1}));
+}
+
+TEST(RunHandlerTest, FallsBackToDefaultMaxQueueingDelay) {
+  setenv("TF_RUN_HANDLER_MAX_QUEUEING_DELAY_US", "not_a_number", 1);
+  RunHandlerPool pool(/*num_inter_op_threads=*/1);
+  unsetenv("TF_RUN_HANDLER_MAX_QUEUEING_DELAY_US");
+  std::unique_ptr<RunHandler> low = pool.Get(/*priority=*/0);
+  std::unique_ptr<RunHandler> high = pool.Get(/*priority=*/10);
+
+  Notification blocked, unblock;
+  BlockInterOpThread(low.get(), &blocked, &unblock);
+
+  // The low priority closure has not waited for the default 10ms, so the
+  // high priority one still runs first.
+  mutex mu;
+  std::vector<int> order;
+  BlockingCounter done(2);
+  low->ScheduleInterOpClosure([&mu, &order, &done]() {
+    {
+      mutex_lock l(mu);
+      order.push_back(0);
+    }
+    done.DecrementCount();
+  });
+  high->ScheduleInterOpClosure([&mu, &order, &done]() {
+    {
+      mutex_lock l(mu);
+      order.push_back(1);
+    }
+    done.DecrementCount();
+  });
+  unblock.Notify();
+  done.Wait();
+
+  EXPECT_EQ(order, std::vector<int>({1, 0}));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,124 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/graph/compact_graph.h"
+
+#include <algorithm>
+#include <tuple>
+
+
+namespace tensorflow {
+
+namespace {
+
+// Groups `all` into `edges` by key(e), the compact index of the node an edge
+// belongs to, and orders the edges of each node with `less`. On entry
+// (*offsets)[i + 1] is the number of edges of node i; on exit it is the end of
+// the edges of node i.
+template <typename Key, typename Less>
+void FillEdges(const std::vector<CompactEdge>& all, Key key, Less less,
+               std::vector<int64>* offsets, std::vector<CompactEdge>* edges) {
+  // offsets holds the number of edges of each node, shifted by one.
+  for (size_t i = 1; i < offsets->size(); ++i) {
+    (*offsets)[i] += (*offsets)[i - 1];
+  }
+  edges->resize(all.size());
+  std::vector<int64> next(offsets->begin(), offsets->end() - 1);
+  for (const CompactEdge& e : all) {
+    (*edges)[next[key(e)]++] = e;
+  }
+  for (size_t i = 0; i + 1 < offsets->size(); ++i) {
+    std::sort(edges->begin() + (*offsets)[i],
+              edges->begin() + (*offsets)[i + 1], less);
+  }
+}
+
+}  // namespace
+
+CompactGraph::CompactGraph(const Graph& graph)
+    : index_(graph.num_node_ids(), -1) {
+  nodes_.reserve(graph.num_nodes());
+  ops_.reserve(graph.num_nodes());
+  for (Node* n : graph.nodes()) {
+    index_[n->id()] = nodes_.size();
+    nodes_.push_back(n);
+    auto inserted = op_ids_.emplace(n->type_string(), num_ops());
+    if (inserted.second) op_names_.push_back(inserted.first->first);
+    ops_.push_back(inserted.first->second);
+  }
+
+  std::vector<CompactEdge> all;
+  all.reserve(graph.num_edges());
+  in_offsets_.assign(nodes_.size() + 1, 0);
+  out_offsets_.assign(nodes_.size() + 1, 0);
+  for (const Edge* e : graph.edges()) {
+    const CompactEdge edge = {index_[e->src()->id()], e->src_output(),
+                              index_[e->dst()->id()], e->dst_input()};
+    ++in_offsets_[edge.dst + 1];
+    ++out_offsets_[edge.src + 1];
+    all.push_back(edge);
+  }
+
+  FillEdges(
+      all, [](const CompactEdge& e) { return e.dst; },
+      [](const CompactEdge& a, const CompactEdge& b) {
+        return std::make_tuple(a.IsControlEdge(), a.dst_input, a.src,
+                               a.src_output) <
+               std::make_tuple(b.IsControlEdge(), b.dst_input, b.src,
+                               b.src_output);
+      },
+      &in_offsets_, &in_edges_);
+  FillEdges(
+      all, [](const CompactEdge& e) { return e.src; },
+      [](const CompactEdge& a, const CompactEdge& b) {
+        return std::make_tuple(a.IsControlEdge(), a.src_output, a.dst,
+                               a.dst_input) <
+               std::make_tuple(b.IsControlEdge(), b.src_output, b.dst,
+                               b.dst_input);
+      },
+      &out_offsets_, &out_edges_);
+}
+
+int32 CompactGraph::FindOp(StringPiece op_name) const {
+  auto it = op_ids_.find(op_name);
+  return it == op_ids_.end() ? -1 : it->second;
+}
+
+std::vector<int32> CompactGraph::ReversePostOrder() const {
+  std::vector<int32> order;
+  order.reserve(nodes_.size());
+  std::vector<bool> visited(nodes_.size(), false);
+  // Stack of work to do. A negative entry -i - 1 leaves node i.
+  std::vector<int32> stack;
+  stack.push_back(index_[Graph::kSourceId]);
+  while (!stack.empty()) {
+    const int32 i = stack.back();
+    stack.pop_back();
+    if (i < 0) {
+      order.push_back(-i - 1);
+      continue;
+    }
+    if (visited[i]) continue;
+    visited[i] = true;
+    stack.push_back(-i - 1);
+    for (const CompactEdge& e : out_edges(i)) {
+      if (!visited[e.dst]) stack.push_back(e.dst);
+    }
+  }
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+}  // namespace tensorflow
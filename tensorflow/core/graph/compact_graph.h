@@ -0,0 +1,111 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPH_COMPACT_GRAPH_H_
+#define TENSORFLOW_CORE_GRAPH_COMPACT_GRAPH_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An edge of a CompactGraph, between the compact indices of two nodes.
+struct CompactEdge {
+  int32 src;
+  int32 src_output;
+  int32 dst;
+  int32 dst_input;
+
+  bool IsControlEdge() const { return src_output == Graph::kControlSlot; }
+};
+
+// An immutable, index-based snapshot of the structure of a Graph, for
+// analyses that traverse a large graph many times. Nodes are numbered densely
+// in [0, num_nodes()) in the order of their ids, the edges of each node are
+// stored contiguously in one array (compressed sparse row), and op types are
+// interned into small integers, so a traversal touches a few flat arrays
+// instead of chasing Node and Edge pointers.
+//
+// In-edges are ordered by dst_input and out-edges by src_output, each with
+// the control edges last. The view does not see later changes to the Graph,
+// which must outlive it.
+class CompactGraph {
+ public:
+  explicit CompactGraph(const Graph& graph);
+
+  int32 num_nodes() const { return static_cast<int32>(nodes_.size()); }
+  int64 num_edges() const { return in_edges_.size(); }
+
+  // Returns the node with compact index `i`.
+  Node* node(int32 i) const { return nodes_[i]; }
+
+  // Returns the compact index of `n`, or -1 if `n` was not in the graph when
+  // the view was built.
+  int32 index(const Node* n) const {
+    return n->id() < static_cast<int>(index_.size()) ? index_[n->id()] : -1;
+  }
+
+  // Returns the edges into and out of the node with compact index `i`.
+  gtl::ArraySlice<CompactEdge> in_edges(int32 i) const {
+    return gtl::ArraySlice<CompactEdge>(in_edges_.data() + in_offsets_[i],
+                                        in_offsets_[i + 1] - in_offsets_[i]);
+  }
+  gtl::ArraySlice<CompactEdge> out_edges(int32 i) const {
+    return gtl::ArraySlice<CompactEdge>(out_edges_.data() + out_offsets_[i],
+                                        out_offsets_[i + 1] - out_offsets_[i]);
+  }
+
+  // Returns the interned op type of the node with compact index `i`, in
+  // [0, num_ops()).
+  int32 op(int32 i) const { return ops_[i]; }
+  int32 num_ops() const { return static_cast<int32>(op_names_.size()); }
+  StringPiece op_name(int32 op) const { return op_names_[op]; }
+
+  // Returns the interned op type named `op_name`, or -1 if no node has it.
+  int32 FindOp(StringPiece op_name) const;
+
+  // Returns the compact indices of the nodes reachable from the source node
+  // in reverse post order of a depth first search, like GetReversePostOrder()
+  // in algorithm.h. This is a topological order if the graph is acyclic.
+  std::vector<int32> ReversePostOrder() const;
+
+ private:
+  std::vector<Node*> nodes_;
+  // The compact index of each node id, or -1 for removed ids.
+  std::vector<int32> index_;
+
+  // The edges of node i are [offsets[i], offsets[i + 1]) in the edge arrays.
+  std::vector<int64> in_offsets_;
+  std::vector<CompactEdge> in_edges_;
+  std::vector<int64> out_offsets_;
+  std::vector<CompactEdge> out_edges_;
+
+  std::vector<int32> ops_;
+  // Points into the type strings of the Graph.
+  std::vector<StringPiece> op_names_;
+  std::unordered_map<StringPiece, int32, StringPieceHasher> op_ids_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CompactGraph);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPH_COMPACT_GRAPH_H_
@@ -0,0 +1,138 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/graph/compact_graph.h"
+
+#include <vector>
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/graph/graph_def_builder_util.h"
+#include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+REGISTER_OP("TestParams").Output("o: float");
+REGISTER_OP("TestInput").Output("a: float").Output("b: float");
+REGISTER_OP("TestMul").Input("a: float").Input("b: float").Output("o: float");
+
+class CompactGraphTest : public ::testing::Test {
+ protected:
+  CompactGraphTest() : graph_(OpRegistry::Global()) {
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    Node* w = SourceOp("TestParams", b.opts().WithName("W"));
+    Node* input =
+        SourceOp("TestInput", b.opts().WithName("input").WithControlInput(w));
+    Node* t1 = BinaryOp("TestMul", w, {input, 1}, b.opts().WithName("t1"));
+    BinaryOp("TestMul", t1, {input, 0},
+             b.opts().WithName("t2").WithControlInput(w));
+    TF_CHECK_OK(GraphDefBuilderToGraph(b, &graph_));
+  }
+
+  Node* FindNode(const string& name) {
+    for (Node* n : graph_.nodes()) {
+      if (n->name() == name) return n;
+    }
+    LOG(FATAL) << "No node named " << name;
+    return nullptr;
+  }
+
+  Graph graph_;
+};
+
+TEST_F(CompactGraphTest, Edges) {
+  const CompactGraph compact(graph_);
+  EXPECT_EQ(graph_.num_nodes(), compact.num_nodes());
+  EXPECT_EQ(graph_.num_edges(), compact.num_edges());
+  for (int32 i = 0; i < compact.num_nodes(); ++i) {
+    EXPECT_EQ(i, compact.index(compact.node(i)));
+  }
+
+  const int32 w = compact.index(FindNode("W"));
+  const int32 input = compact.index(FindNode("input"));
+  const int32 t1 = compact.index(FindNode("t1"));
+  const int32 t2 = compact.index(FindNode("t2"));
+
+  // Data inputs come in order, followed by control inputs.
+  gtl::ArraySlice<CompactEdge> in = compact.in_edges(t2);
+  ASSERT_EQ(3, in.size());
+  EXPECT_EQ(t1, in[0].src);
+  EXPECT_EQ(0, in[0].src_output);
+  EXPECT_EQ(0, in[0].dst_input);
+  EXPECT_EQ(input, in[1].src);
+  EXPECT_EQ(0, in[1].src_output);
+  EXPECT_EQ(1, in[1].dst_input);
+  EXPECT_EQ(w, in[2].src);
+  EXPECT_TRUE(in[2].IsControlEdge());
+  for (const CompactEdge& e : in) EXPECT_EQ(t2, e.dst);
+
+  gtl::ArraySlice<CompactEdge> out = compact.out_edges(input);
+  ASSERT_EQ(2, out.size());
+  EXPECT_EQ(t2, out[0].dst);
+  EXPECT_EQ(0, out[0].src_output);
+  EXPECT_EQ(t1, out[1].dst);
+  EXPECT_EQ(1, out[1].src_output);
+
+  // W has data edges to t1, and control edges to input and t2.
+  out = compact.out_edges(w);
+  ASSERT_EQ(3, out.size());
+  EXPECT_FALSE(out[0].IsControlEdge());
+  EXPECT_EQ(t1, out[0].dst);
+  EXPECT_TRUE(out[1].IsControlEdge());
+  EXPECT_TRUE(out[2].IsControlEdge());
+}
+
+TEST_F(CompactGraphTest, InternsOps) {
+  const CompactGraph compact(graph_);
+  // _SOURCE, _SINK, TestParams, TestInput and TestMul.
+  EXPECT_EQ(5, compact.num_ops());
+  const int32 t1 = compact.index(FindNode("t1"));
+  const int32 t2 = compact.index(FindNode("t2"));
+  EXPECT_EQ(compact.op(t1), compact.op(t2));
+  EXPECT_EQ(compact.op(t1), compact.FindOp("TestMul"));
+  EXPECT_EQ("TestMul", compact.op_name(compact.op(t1)));
+  EXPECT_EQ(-1, compact.FindOp("TestUnknown"));
+}
+
+TEST_F(CompactGraphTest, IgnoresLaterChanges) {
+  Node* t2 = FindNode("t2");
+  graph_.RemoveNode(t2);
+  const CompactGraph compact(graph_);
+  EXPECT_EQ(graph_.num_nodes(), compact.num_nodes());
+  EXPECT_EQ(graph_.num_edges(), compact.num_edges());
+
+  Node* t3 = graph_.CopyNode(FindNode("t1"));
+  EXPECT_EQ(-1, compact.index(t3));
+}
+
+TEST_F(CompactGraphTest, ReversePostOrder) {
+  const CompactGraph compact(graph_);
+  const std::vector<int32> order = compact.ReversePostOrder();
+  EXPECT_EQ(compact.num_nodes(), order.size());
+  std::vector<int> position(compact.num_nodes(), -1);
+  for (int i = 0; i < order.size(); ++i) position[order[i]] = i;
+  for (int32 n = 0; n < compact.num_nodes(); ++n) {
+    for (const CompactEdge& e : compact.out_edges(n)) {
+      EXPECT_LT(position[e.src], position[e.dst]);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
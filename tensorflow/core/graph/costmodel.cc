@@ -15,12 +15,16 @@ limitations under the License.
 
 #include "tensorflow/core/graph/costmodel.h"
 
+#include <algorithm>
 #include <vector>
+
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/cost_graph.pb.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
@@ -130,6 +134,7 @@ void CostModel::Ensure(int id, int num_outputs) {
     max_mem_usage_.resize(id + 1);
     max_exec_time_.resize(id + 1);
     output_port_alloc_ids_.resize(id + 1);
+    shape_times_.resize(id + 1);
   }
   if (num_outputs > 0) {
     auto perslot = &slot_bytes_[id];
@@ -346,6 +351,138 @@ Microseconds CostModel::MaxExecutionTime(const Node* node) const {
   return max_exec_time_[id];
 }
 
+constexpr int CostModel::kMaxShapeSignatures;
+constexpr int CostModel::kMaxShapeTimeSamples;
+
+void CostModel::RecordShapeTime(
+    const Node* node, const std::vector<TensorShapeProto>& input_shapes,
+    Microseconds time) {
+  ShapeTimes* times = FindOrCreateShapeTimes(node, input_shapes);
+  if (times != nullptr) {
+    AddShapeTimeSamples(1, {time}, times);
+  }
+}
+
+Microseconds CostModel::ShapeTimePercentile(
+    const Node* node, const std::vector<TensorShapeProto>& input_shapes,
+    double percentile) const {
+  const int id = Id(node);
+  if (id < 0 || static_cast<size_t>(id) >= shape_times_.size()) {
+    return Microseconds(-1);
+  }
+  auto it = shape_times_[id].find(ShapeSignature(input_shapes));
+  if (it == shape_times_[id].end()) {
+    return Microseconds(-1);
+  }
+  return Percentile(it->second, percentile);
+}
+
+std::vector<Microseconds> CostModel::ShapeTimePercentiles(
+    const Node* node, double percentile) const {
+  std::vector<Microseconds> result;
+  const int id = Id(node);
+  if (id < 0 || static_cast<size_t>(id) >= shape_times_.size()) {
+    return result;
+  }
+  for (const auto& it : shape_times_[id]) {
+    result.push_back(Percentile(it.second, percentile));
+  }
+  return result;
+}
+
+void CostModel::MergeShapeTimesFromCostGraphDef(
+    const Graph& graph, const CostGraphDef& cost_graph) {
+  std::unordered_map<StringPiece, const CostGraphDef::Node*, StringPieceHasher>
+      cost_nodes;
+  for (const CostGraphDef::Node& cost_node : cost_graph.node()) {
+    cost_nodes.emplace(cost_node.name(), &cost_node);
+  }
+  for (const Node* n : graph.nodes()) {
+    auto it = cost_nodes.find(n->name());
+    if (it == cost_nodes.end()) continue;
+    for (const auto& shape_cost : it->second->shape_cost()) {
+      std::vector<TensorShapeProto> input_shapes(
+          shape_cost.input_shape().begin(), shape_cost.input_shape().end());
+      ShapeTimes* times = FindOrCreateShapeTimes(n, input_shapes);
+      if (times == nullptr) break;
+      std::vector<Microseconds> samples;
+      for (int64 sample : shape_cost.compute_time_sample()) {
+        samples.push_back(Microseconds(sample));
+      }
+      AddShapeTimeSamples(shape_cost.count(), samples, times);
+    }
+  }
+}
+
+// static
+string CostModel::ShapeSignature(const std::vector<TensorShapeProto>& shapes) {
+  string signature;
+  for (const TensorShapeProto& shape : shapes) {
+    if (shape.unknown_rank()) {
+      signature += "?;";
+      continue;
+    }
+    for (const auto& dim : shape.dim()) {
+      strings::StrAppend(&signature, dim.size(), ",");
+    }
+    signature += ";";
+  }
+  return signature;
+}
+
+// static
+void CostModel::AddShapeTimeSamples(int64 count,
+                                    const std::vector<Microseconds>& samples,
+                                    ShapeTimes* times) {
+  // Reservoir sampling: once the reservoir is full, the n-th execution
+  // replaces a random sample with probability kMaxShapeTimeSamples / n.
+  for (Microseconds sample : samples) {
+    if (times->samples.size() < kMaxShapeTimeSamples) {
+      times->samples.push_back(sample);
+    } else {
+      const int64 index =
+          random::New64() % std::max<int64>(times->count + count, 1);
+      if (index < kMaxShapeTimeSamples) {
+        times->samples[index] = sample;
+      }
+    }
+  }
+  times->count += std::max<int64>(count, samples.size());
+}
+
+// static
+Microseconds CostModel::Percentile(const ShapeTimes& times,
+                                   double percentile) {
+  if (times.samples.empty()) {
+    return Microseconds(-1);
+  }
+  std::vector<Microseconds> samples = times.samples;
+  const size_t index = std::min<size_t>(
+      samples.size() - 1,
+      static_cast<size_t>(std::max(0.0, percentile) / 100 * samples.size()));
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  return samples[index];
+}
+
+CostModel::ShapeTimes* CostModel::FindOrCreateShapeTimes(
+    const Node* node, const std::vector<TensorShapeProto>& input_shapes) {
+  const int id = Id(node);
+  if (id < 0) return nullptr;
+  Ensure(id, node->num_outputs());
+  std::map<string, ShapeTimes>* node_times = &shape_times_[id];
+  const string signature = ShapeSignature(input_shapes);
+  auto it = node_times->find(signature);
+  if (it != node_times->end()) {
+    return &it->second;
+  }
+  if (node_times->size() >= kMaxShapeSignatures) {
+    return nullptr;
+  }
+  ShapeTimes* times = &(*node_times)[signature];
+  times->input_shapes = input_shapes;
+  return times;
+}
+
 void CostModel::RecordAllocationId(const Node* node, int output_slot,
                                    int64 alloc_id) {
   const int id = Id(node);
@@ -536,6 +673,21 @@ void CostModel::AddToCostGraphDef(const Graph* graph,
 
     cnode->set_compute_cost(MaxExecutionTime(n).value());
 
+    const int id = Id(n);
+    if (id >= 0 && static_cast<size_t>(id) < shape_times_.size()) {
+      for (const auto& it : shape_times_[id]) {
+        const ShapeTimes& times = it.second;
+        CostGraphDef::Node::ShapeCost* shape_cost = cnode->add_shape_cost();
+        for (const TensorShapeProto& shape : times.input_shapes) {
+          *shape_cost->add_input_shape() = shape;
+        }
+        shape_cost->set_count(times.count);
+        for (Microseconds sample : times.samples) {
+          shape_cost->add_compute_time_sample(sample.value());
+        }
+      }
+    }
+
     // For now we treat all send nodes as final.
     // TODO(yuanbyu): Send nodes for fetches shouldn't be treated as final.
     cnode->set_is_final(n->IsSend());
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPH_COSTMODEL_H_
 #define TENSORFLOW_CORE_GRAPH_COSTMODEL_H_
 
+#include <map>
 #include <unordered_map>
 #include <vector>
 
@@ -145,6 +146,37 @@ class CostModel {
   // Returns the maximum execution time (in microseconds) of "node".
   Microseconds MaxExecutionTime(const Node* node) const;
 
+  // At most this many lists of input shapes are kept per node, the lists seen
+  // after them are ignored, and at most this many execution times are kept
+  // per list of input shapes.
+  static constexpr int kMaxShapeSignatures = 8;
+  static constexpr int kMaxShapeTimeSamples = 16;
+
+  // Records that an execution of "node" whose inputs had the shapes
+  // "input_shapes" took "time" microseconds. A uniform sample of the times is
+  // kept for each list of input shapes.
+  void RecordShapeTime(const Node* node,
+                       const std::vector<TensorShapeProto>& input_shapes,
+                       Microseconds time);
+
+  // Returns the "percentile", in [0, 100], of the execution times of "node"
+  // recorded for the input shapes "input_shapes", or -1 if none were
+  // recorded.
+  Microseconds ShapeTimePercentile(
+      const Node* node, const std::vector<TensorShapeProto>& input_shapes,
+      double percentile) const;
+
+  // Returns the "percentile" of the execution times of "node" for each list
+  // of input shapes recorded for it.
+  std::vector<Microseconds> ShapeTimePercentiles(const Node* node,
+                                                 double percentile) const;
+
+  // Merges the per-shape execution times of the nodes of "cost_graph", e.g.
+  // saved by AddToCostGraphDef() in an earlier run, into the nodes of "graph"
+  // with the same names.
+  void MergeShapeTimesFromCostGraphDef(const Graph& graph,
+                                       const CostGraphDef& cost_graph);
+
   // Record the unique id of the tensor generated by "output_slot" of "node".
   // Any other tensor sharing the same id will be an alias, i.e. it will share
   // the same underlying memory storage area.
@@ -219,6 +251,29 @@ class CostModel {
 
   std::vector<gtl::InlinedVector<int64, 2>> output_port_alloc_ids_;
 
+  // Execution times of a node for one list of input shapes.
+  struct ShapeTimes {
+    std::vector<TensorShapeProto> input_shapes;
+    // The number of executions, of which at most kMaxShapeTimeSamples are
+    // kept in "samples".
+    int64 count = 0;
+    std::vector<Microseconds> samples;
+  };
+  static string ShapeSignature(const std::vector<TensorShapeProto>& shapes);
+  // Adds "samples" that stand for "count" executions to "times".
+  static void AddShapeTimeSamples(int64 count,
+                                  const std::vector<Microseconds>& samples,
+                                  ShapeTimes* times);
+  static Microseconds Percentile(const ShapeTimes& times, double percentile);
+  // Returns the times of "node" for "input_shapes", creating them unless
+  // the node already has kMaxShapeSignatures of them. Returns nullptr if the
+  // times can't be kept.
+  ShapeTimes* FindOrCreateShapeTimes(
+      const Node* node, const std::vector<TensorShapeProto>& input_shapes);
+
+  // Per node, the execution times by signature of the input shapes.
+  std::vector<std::map<string, ShapeTimes>> shape_times_;
+
   std::set<int64> persistent_alloc_ids_;
   std::map<string, std::set<int64>> persistent_alloc_ids_by_devices_;
 
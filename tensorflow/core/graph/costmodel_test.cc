@@ -0,0 +1,91 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/graph/costmodel.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+std::vector<TensorShapeProto> Shapes(int64 size) {
+  std::vector<TensorShapeProto> shapes(1);
+  shapes[0].add_dim()->set_size(size);
+  return shapes;
+}
+
+TEST(CostModelTest, ShapeTimePercentiles) {
+  Graph graph(OpRegistry::Global());
+  const Node* node = graph.source_node();
+  CostModel cm(false);
+  for (int i = 1; i <= 10; ++i) {
+    cm.RecordShapeTime(node, Shapes(2), Microseconds(i));
+    cm.RecordShapeTime(node, Shapes(3), Microseconds(100 * i));
+  }
+  EXPECT_EQ(Microseconds(1), cm.ShapeTimePercentile(node, Shapes(2), 0));
+  EXPECT_EQ(Microseconds(6), cm.ShapeTimePercentile(node, Shapes(2), 50));
+  EXPECT_EQ(Microseconds(10), cm.ShapeTimePercentile(node, Shapes(2), 100));
+  EXPECT_EQ(Microseconds(600), cm.ShapeTimePercentile(node, Shapes(3), 50));
+  EXPECT_EQ(Microseconds(-1), cm.ShapeTimePercentile(node, Shapes(4), 50));
+  EXPECT_EQ(2, cm.ShapeTimePercentiles(node, 50).size());
+  EXPECT_TRUE(cm.ShapeTimePercentiles(graph.sink_node(), 50).empty());
+}
+
+TEST(CostModelTest, ShapeTimesAreBounded) {
+  Graph graph(OpRegistry::Global());
+  const Node* node = graph.source_node();
+  CostModel cm(false);
+  for (int i = 0; i < 2 * CostModel::kMaxShapeSignatures; ++i) {
+    for (int j = 0; j < 2 * CostModel::kMaxShapeTimeSamples; ++j) {
+      cm.RecordShapeTime(node, Shapes(i), Microseconds(7));
+    }
+  }
+  EXPECT_EQ(CostModel::kMaxShapeSignatures,
+            cm.ShapeTimePercentiles(node, 50).size());
+  EXPECT_EQ(Microseconds(-1), cm.ShapeTimePercentile(
+                                  node, Shapes(CostModel::kMaxShapeSignatures),
+                                  50));
+
+  CostGraphDef cost_graph;
+  cm.AddToCostGraphDef(&graph, &cost_graph);
+  const CostGraphDef::Node& cost_node = cost_graph.node(node->id());
+  ASSERT_EQ(CostModel::kMaxShapeSignatures, cost_node.shape_cost_size());
+  EXPECT_EQ(2 * CostModel::kMaxShapeTimeSamples,
+            cost_node.shape_cost(0).count());
+  EXPECT_EQ(CostModel::kMaxShapeTimeSamples,
+            cost_node.shape_cost(0).compute_time_sample_size());
+}
+
+TEST(CostModelTest, MergeShapeTimesFromCostGraphDef) {
+  Graph graph(OpRegistry::Global());
+  const Node* node = graph.source_node();
+  CostModel saved(false);
+  saved.RecordShapeTime(node, Shapes(2), Microseconds(5));
+  CostGraphDef cost_graph;
+  saved.AddToCostGraphDef(&graph, &cost_graph);
+
+  CostModel cm(false);
+  cm.MergeShapeTimesFromCostGraphDef(graph, cost_graph);
+  EXPECT_EQ(Microseconds(5), cm.ShapeTimePercentile(node, Shapes(2), 50));
+  EXPECT_EQ(Microseconds(-1),
+            cm.ShapeTimePercentile(graph.sink_node(), Shapes(2), 50));
+}
+
+}  // namespace
+}  // namespace tensorflow
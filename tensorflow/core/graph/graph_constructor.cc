@@ -118,21 +118,27 @@ class GraphConstructor {
 
   typedef gtl::ArraySlice<const NodeDef*> NodeDefSlice;
 
-  // versions and library may be nullptr
+  // versions and library may be nullptr. If movable_node_defs is not empty,
+  // it holds mutable pointers to the same NodeDefs as node_defs, and each
+  // NodeDef is moved into its Node instead of being copied. Only the op of a
+  // moved NodeDef is left in place.
   static Status Construct(
       const Options& opts, NodeDefSlice node_defs, const VersionDef* versions,
       const FunctionDefLibrary* library, Graph* g, ShapeRefiner* refiner,
       std::vector<std::pair<Node*, int>>* return_tensors,
       std::vector<Node*>* return_nodes,
-      std::vector<SafeTensorId>* missing_unused_input_map_keys) {
+      std::vector<SafeTensorId>* missing_unused_input_map_keys,
+      gtl::ArraySlice<NodeDef*> movable_node_defs = {}) {
     if (versions) {
       TF_RETURN_IF_ERROR(CheckVersions(*versions, TF_GRAPH_DEF_VERSION,
                                        TF_GRAPH_DEF_VERSION_MIN_PRODUCER,
                                        "GraphDef", "graph"));
     }
+    DCHECK(movable_node_defs.empty() ||
+           movable_node_defs.size() == node_defs.size());
     GraphConstructor c(opts, node_defs, versions, library, g, refiner,
                        return_tensors, return_nodes,
-                       missing_unused_input_map_keys);
+                       missing_unused_input_map_keys, movable_node_defs);
     const Status s = c.TryImport();
     if (!s.ok()) c.Undo();
     return s;
@@ -145,9 +151,11 @@ class GraphConstructor {
                    ShapeRefiner* refiner,
                    std::vector<std::pair<Node*, int>>* return_tensors,
                    std::vector<Node*>* return_nodes,
-                   std::vector<SafeTensorId>* missing_unused_input_map_keys)
+                   std::vector<SafeTensorId>* missing_unused_input_map_keys,
+                   gtl::ArraySlice<NodeDef*> movable_node_defs)
       : opts_(opts),
         node_defs_(node_defs),
+        movable_node_defs_(movable_node_defs),
         versions_(versions),
         library_(library),
         g_(g),
@@ -189,7 +197,7 @@ class GraphConstructor {
 
   Status IsNodeFullyMapped(const NodeDef& node_def, bool* is_node_mapped);
   Status ValidateColocationConstraints(const NodeDef& node_def);
-  Status MakeNode(const NodeDef& node_def, Node** node);
+  Status MakeNode(NodeDef node_def, Node** node);
   Status MakeEdge(Node* src, int output_index, Node* dst, int input_index);
   Status ValidateShape(Node* node);
   Status ModifyNodeDefForImport(NodeDef* node_def);
@@ -237,6 +245,7 @@ class GraphConstructor {
   // From constructor
   const Options opts_;
   const NodeDefSlice node_defs_;
+  const gtl::ArraySlice<NodeDef*> movable_node_defs_;
   const VersionDef* versions_;
   const FunctionDefLibrary* library_;
   Graph* g_;
@@ -437,6 +446,7 @@ Status GraphConstructor::ValidateInputMapAndControlDependencies() {
 }
 
 Status GraphConstructor::BuildNodeIndex() {
+  gdef_nodes_.reserve(node_defs_.size());
   // Validate the node names and add them to gdef_nodes_ and gdef_prefixes_.
   for (int n = 0; n < node_defs_.size(); ++n) {
     const NodeDef& node_def = *node_defs_[n];
@@ -478,9 +488,9 @@ Status GraphConstructor::BuildNodeIndex() {
   return Status::OK();
 }
 
-std::unordered_set<string> GetNextIterationNodes(
+std::unordered_set<StringPiece, StringPieceHasher> GetNextIterationNodes(
     const GraphConstructor::NodeDefSlice& node_defs) {
-  std::unordered_set<string> next_iteration_nodes;
+  std::unordered_set<StringPiece, StringPieceHasher> next_iteration_nodes;
 
   for (int n = 0; n < node_defs.size(); ++n) {
     const NodeDef& node_def = *node_defs[n];
@@ -496,8 +506,8 @@ Status GraphConstructor::InitFromEdges() {
   const int num_nodes = node_defs_.size();
   pending_count_.reserve(num_nodes);
   outputs_.resize(num_nodes);
-  std::unordered_set<string> next_iteration_nodes_ =
-      GetNextIterationNodes(node_defs_);
+  const std::unordered_set<StringPiece, StringPieceHasher>
+      next_iteration_nodes = GetNextIterationNodes(node_defs_);
 
   // Parse the inputs for each node.
   for (int n = 0; n < num_nodes; ++n) {
@@ -516,8 +526,8 @@ Status GraphConstructor::InitFromEdges() {
           num_control_edges++;
         } else {
           TensorId id(ParseTensorName(input_name));
-          if (next_iteration_nodes_.find(string(id.first)) !=
-              next_iteration_nodes_.end()) {
+          if (next_iteration_nodes.find(id.first) !=
+              next_iteration_nodes.end()) {
             has_loop_back_edge = true;
           }
         }
@@ -572,13 +582,13 @@ Status GraphConstructor::ValidateColocationConstraints(
   return Status::OK();
 }
 
-Status GraphConstructor::MakeNode(const NodeDef& node_def, Node** node) {
+Status GraphConstructor::MakeNode(NodeDef node_def, Node** node) {
   // Add the node to the graph.
   Status status;
-  *node = g_->AddNode(node_def, &status);
+  *node = g_->AddNode(std::move(node_def), &status);
   if (!status.ok()) return status;
   if (opts_.expect_device_spec) {
-    (*node)->set_assigned_device_name(node_def.device());
+    (*node)->set_assigned_device_name((*node)->def().device());
   }
   return Status::OK();
 }
@@ -1025,9 +1035,21 @@ Status GraphConstructor::Convert() {
       }
       TF_RETURN_IF_ERROR(ModifyNodeDefForImport(&imported_node_def));
     }
-    TF_RETURN_IF_ERROR(MakeNode(*node_def, &node));
-    // Use original_node_def so name StringPiece remains valid
-    gdef_nodes_[original_node_def.name()].node = node;
+    // Look up the NodeInfo before original_node_def may be moved from. The
+    // key stays valid: moving a NodeDef swaps out the string it points into,
+    // which is then owned by the new node.
+    NodeInfo* node_info = &gdef_nodes_[original_node_def.name()];
+    if (opts_.importing) {
+      TF_RETURN_IF_ERROR(MakeNode(std::move(imported_node_def), &node));
+    } else if (!movable_node_defs_.empty()) {
+      NodeDef* movable_node_def = movable_node_defs_[o];
+      TF_RETURN_IF_ERROR(MakeNode(std::move(*movable_node_def), &node));
+      // UpdatePendingCountAndReady() still needs the op of processed nodes.
+      movable_node_def->set_op(node->type_string());
+    } else {
+      TF_RETURN_IF_ERROR(MakeNode(*node_def, &node));
+    }
+    node_info->node = node;
 
     // Add edges from inputs to *node to the graph.
     for (size_t i = 0; i < inputs.size(); ++i) {
@@ -1213,6 +1235,19 @@ Status ConvertGraphDefToGraph(const GraphConstructorOptions& opts,
       /*missing_unused_input_map_keys=*/nullptr);
 }
 
+Status ConvertGraphDefToGraph(const GraphConstructorOptions& opts,
+                              GraphDef&& gdef, Graph* g) {
+  ShapeRefiner refiner(gdef.versions().producer(), g->op_registry());
+  GraphConstructor::NodeDefSlice node_defs(gdef.node().data(),
+                                           gdef.node_size());
+  gtl::ArraySlice<NodeDef*> movable_node_defs(
+      gdef.mutable_node()->mutable_data(), gdef.node_size());
+  return GraphConstructor::Construct(
+      opts, node_defs, &gdef.versions(), &gdef.library(), g, &refiner,
+      /*return_tensors=*/nullptr, /*return_nodes=*/nullptr,
+      /*missing_unused_input_map_keys=*/nullptr, movable_node_defs);
+}
+
 Status ConvertNodeDefsToGraph(const GraphConstructorOptions& opts,
                               gtl::ArraySlice<NodeDef> nodes, Graph* g) {
   ShapeRefiner refiner(TF_GRAPH_DEF_VERSION, g->op_registry());
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/version.h"
 
@@ -805,6 +806,29 @@ versions {
   ASSERT_EQ(Status::OK(), s) << s;
 }
 
+TEST_F(GraphConstructorTest, MovedGraphDefWithOKCycle) {
+  GraphDef gdef;
+  CHECK(protobuf::TextFormat::ParseFromString(
+      "node { name: 'input' op: 'TestInput' }"
+      "node { name: 'merge' op: 'Merge' input: [ 'input:0', 'next' ] "
+      "       attr { key: 'T' value { type: DT_FLOAT } } "
+      "       attr { key: 'N' value { i: 2 } } }"
+      "node { name: 'next' op: 'NextIteration' input: [ 'merge' ] "
+      "       attr { key: 'T' value { type: DT_FLOAT } } }"
+      "node { name: 't1' op: 'TestMul' input: [ 'merge', 'input:1' ] }",
+      &gdef));
+  GraphConstructorOptions opts;
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, gdef, &graph_));
+  GraphDef copied;
+  graph_.ToGraphDef(&copied);
+
+  Graph moved_graph(OpRegistry::Global());
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, std::move(gdef), &moved_graph));
+  GraphDef moved;
+  moved_graph.ToGraphDef(&moved);
+  EXPECT_EQ(copied.DebugString(), moved.DebugString());
+}
+
 TEST_F(GraphConstructorTest, TypeMismatch) {
   ExpectError(
       "node { name: 'input' op: 'TestInput' }"
@@ -3254,5 +3278,59 @@ TEST_F(GraphConstructorTest, ImportGraphDef_UnknownOps) {
        "when the module is first accessed."});
 }
 
+// A chain of num_nodes TestMul nodes, each with a string attr of
+// payload_bytes that stands in for the constants of a large model.
+GraphDef CreateLargeGraphDef(int num_nodes, int payload_bytes) {
+  GraphDef gdef;
+  NodeDef* input = gdef.add_node();
+  input->set_name("input");
+  input->set_op("TestInput");
+  string prev = "input";
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = gdef.add_node();
+    node->set_name(strings::StrCat("mul", i));
+    node->set_op("TestMul");
+    node->add_input(prev);
+    node->add_input("input:1");
+    (*node->mutable_attr())["_payload"].set_s(string(payload_bytes, 'x'));
+    prev = node->name();
+  }
+  return gdef;
+}
+
+void BM_ConvertGraphDefToGraph(int iters, int num_nodes, int payload_bytes) {
+  testing::StopTiming();
+  const GraphDef gdef = CreateLargeGraphDef(num_nodes, payload_bytes);
+  GraphConstructorOptions opts;
+  for (int i = 0; i < iters; ++i) {
+    Graph graph(OpRegistry::Global());
+    testing::StartTiming();
+    TF_CHECK_OK(ConvertGraphDefToGraph(opts, gdef, &graph));
+    testing::StopTiming();
+  }
+}
+BENCHMARK(BM_ConvertGraphDefToGraph)->ArgPair(1 << 10, 0);
+BENCHMARK(BM_ConvertGraphDefToGraph)->ArgPair(1 << 16, 0);
+BENCHMARK(BM_ConvertGraphDefToGraph)->ArgPair(1 << 10, 1 << 12);
+BENCHMARK(BM_ConvertGraphDefToGraph)->ArgPair(1 << 14, 1 << 12);
+
+void BM_ConvertMovedGraphDefToGraph(int iters, int num_nodes,
+                                    int payload_bytes) {
+  testing::StopTiming();
+  const GraphDef gdef = CreateLargeGraphDef(num_nodes, payload_bytes);
+  GraphConstructorOptions opts;
+  for (int i = 0; i < iters; ++i) {
+    Graph graph(OpRegistry::Global());
+    GraphDef copy = gdef;
+    testing::StartTiming();
+    TF_CHECK_OK(ConvertGraphDefToGraph(opts, std::move(copy), &graph));
+    testing::StopTiming();
+  }
+}
+BENCHMARK(BM_ConvertMovedGraphDefToGraph)->ArgPair(1 << 10, 0);
+BENCHMARK(BM_ConvertMovedGraphDefToGraph)->ArgPair(1 << 16, 0);
+BENCHMARK(BM_ConvertMovedGraphDefToGraph)->ArgPair(1 << 10, 1 << 12);
+BENCHMARK(BM_ConvertMovedGraphDefToGraph)->ArgPair(1 << 14, 1 << 12);
+
 }  // namespace
 }  // namespace tensorflow
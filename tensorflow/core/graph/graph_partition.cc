@@ -185,6 +185,12 @@ void SetSendRecvAttrs(const PartitionOptions& opts, const Edge* edge,
                     opts.get_incarnation(edge->src()->assigned_device_name())));
   builder->Attr("recv_device", edge->dst()->assigned_device_name());
   builder->Attr("client_terminated", false);
+  // The order in which the transfers of a step should start, if the source
+  // was ranked (see TransferPriorityOptimizer).
+  const AttrValue* priority = edge->src()->attrs().Find("_transfer_priority");
+  if (priority != nullptr) {
+    builder->Attr("_transfer_priority", *priority);
+  }
 }
 
 NodeDef* AddSend(const PartitionOptions& opts, const GraphInfo& g_info,
@@ -270,6 +270,35 @@ TEST_F(GraphPartitionTest, CrossDeviceData) {
   ExpectMatchB();
 }
 
+TEST_F(GraphPartitionTest, CrossDeviceDataWithPriority) {
+  auto a1 = FloatInput(in_.WithOpName("A1"));
+  auto b1 = FloatInput(in_.WithOpName("B1"));
+  Combine(in_.WithOpName("B2"), a1, b1);
+  GraphDef graph_def = ToGraphDef();
+  for (NodeDef& ndef : *graph_def.mutable_node()) {
+    if (ndef.name() == "A1") {
+      (*ndef.mutable_attr())["_transfer_priority"].set_i(3);
+    }
+  }
+
+  Partition(graph_def, &partitions_);
+  EXPECT_EQ(2, partitions_.size());
+
+  // The send and the recv of the edge inherit the priority of its source.
+  int num_prioritized = 0;
+  for (const auto& kv : partitions_) {
+    for (const NodeDef& ndef : kv.second.node()) {
+      if (ndef.op() == "_Send" || ndef.op() == "_Recv") {
+        int64 priority;
+        TF_ASSERT_OK(GetNodeAttr(ndef, "_transfer_priority", &priority));
+        EXPECT_EQ(3, priority);
+        ++num_prioritized;
+      }
+    }
+  }
+  EXPECT_EQ(2, num_prioritized);
+}
+
 TEST_F(GraphPartitionTest, CrossDeviceControl) {
   auto a1 = FloatInput(in_.WithOpName("A1"));
   auto b1 = FloatInput(in_.WithOpName("B1"));
@@ -20,6 +20,7 @@ limitations under the License.
 #include <vector>
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/graph/compact_graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/kernels/ops_util.h"
@@ -760,6 +761,49 @@ BENCHMARK(BM_InEdgeIteration)->ArgPair(1 << 9, 16);
 BENCHMARK(BM_InEdgeIteration)->ArgPair(1 << 12, 16);
 BENCHMARK(BM_InEdgeIteration)->ArgPair(1 << 15, 16);
 
+static void BM_CompactInEdgeIteration(int iters, int num_nodes,
+                                      int num_edges_per_node) {
+  testing::StopTiming();
+  const GraphDef graph_def = CreateGraphDef(num_nodes, num_edges_per_node);
+  Graph graph(OpRegistry::Global());
+  GraphConstructorOptions opts;
+  TF_CHECK_OK(ConvertGraphDefToGraph(opts, graph_def, &graph));
+  CompactGraph compact(graph);
+
+  int64 sum = 0;
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    for (int32 n = 0; n < compact.num_nodes(); ++n) {
+      for (const CompactEdge& e : compact.in_edges(n)) {
+        sum += e.src;
+      }
+    }
+  }
+  VLOG(1) << sum;
+  testing::StopTiming();
+}
+BENCHMARK(BM_CompactInEdgeIteration)->ArgPair(1 << 12, 4);
+BENCHMARK(BM_CompactInEdgeIteration)->ArgPair(1 << 15, 4);
+BENCHMARK(BM_CompactInEdgeIteration)->ArgPair(1 << 12, 16);
+BENCHMARK(BM_CompactInEdgeIteration)->ArgPair(1 << 15, 16);
+
+static void BM_CompactGraphCreation(int iters, int num_nodes,
+                                    int num_edges_per_node) {
+  testing::StopTiming();
+  const GraphDef graph_def = CreateGraphDef(num_nodes, num_edges_per_node);
+  Graph graph(OpRegistry::Global());
+  GraphConstructorOptions opts;
+  TF_CHECK_OK(ConvertGraphDefToGraph(opts, graph_def, &graph));
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    CompactGraph compact(graph);
+    testing::DoNotOptimize(compact.num_edges());
+  }
+  testing::StopTiming();
+}
+BENCHMARK(BM_CompactGraphCreation)->ArgPair(1 << 12, 16);
+BENCHMARK(BM_CompactGraphCreation)->ArgPair(1 << 15, 16);
+
 static void BM_GraphCreation(int iters, int num_nodes, int num_edges_per_node) {
   testing::StopTiming();
   const GraphDef graph_def = CreateGraphDef(num_nodes, num_edges_per_node);
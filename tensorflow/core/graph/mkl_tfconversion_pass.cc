@@ -15,6 +15,7 @@ limitations under the License.
 
 #ifdef INTEL_MKL
 
+#include <map>
 #include <memory>
 #include <queue>
 #include <set>
@@ -106,15 +107,23 @@ class MklToTfConversionPass : public GraphOptimizationPass {
     return mkl_op_registry::IsMklElementWiseOp(op_name, T);
   }
 
+  // Conversion nodes inserted so far, keyed by the Mkl output they convert.
+  typedef std::map<std::pair<const Node*, int>, Node*> ConversionNodeMap;
+
   // Insert layout conversion node on the edge pointed by 'e' from graph 'g'.
   //
+  // All the edges leaving the same Mkl output share one conversion node,
+  // which is looked up in and added to 'conversion_nodes', so that every
+  // tensor is converted at most once.
+  //
   // Edge will be deleted once a call to this function is successful.
   // Any attempt to use the edge after this call
   // will lead to undefined behaviors.
   //
   // @return Success:OK() if insertion is successful, otherwise returns
   //         appropriate error status code.
-  Status InsertConversionNodeOnEdge(std::unique_ptr<Graph>* g, Edge*);
+  Status InsertConversionNodeOnEdge(std::unique_ptr<Graph>* g, Edge*,
+                                    ConversionNodeMap* conversion_nodes);
 
   // For element-wise ops, we need to sanitize the inputs. For this, we add a
   // new node at the input of the replacement element-wise node that checks
@@ -139,7 +148,7 @@ REGISTER_OPTIMIZATION(kMklTfConvPassGroup, 2, MklToTfConversionPass);
 #endif  // ENABLE_MKL
 
 Status MklToTfConversionPass::InsertConversionNodeOnEdge(
-    std::unique_ptr<Graph>* g, Edge* e) {
+    std::unique_ptr<Graph>* g, Edge* e, ConversionNodeMap* conversion_nodes) {
   CHECK_NOTNULL(e);
 
   Node* src = e->src();
@@ -163,6 +172,15 @@ Status MklToTfConversionPass::InsertConversionNodeOnEdge(
     return Status(error::Code::INVALID_ARGUMENT, err_msg.c_str());
   }
 
+  Node*& shared_node = (*conversion_nodes)[{src, e->src_output()}];
+  if (shared_node != nullptr) {
+    CHECK_NOTNULL((*g)->AddEdge(shared_node, 0, dst, e->dst_input()));
+    VLOG(1) << "MklToTfConversionPass: Reusing conversion node "
+            << shared_node->name() << " for " << dst->name();
+    (*g)->RemoveEdge(e);
+    return Status::OK();
+  }
+
   TF_CHECK_OK(
       NodeBuilder((*g)->NewName("Mkl2Tf"), "_MklToTf")
           .Input(src, e->src_output())
@@ -176,6 +194,7 @@ Status MklToTfConversionPass::InsertConversionNodeOnEdge(
           .Finalize(&**g, &conversion_node));
 
   CHECK_NOTNULL(conversion_node);
+  shared_node = conversion_node;
   // TODO(Intel-tf) MklToTf accepts only NHWC or NCHW, but doesn't seem to be
   // using data_format. This code might be redundant.
   if (GetNodeAttr(src->def(), "data_format", &data_format) == Status::OK() &&
@@ -349,12 +368,13 @@ bool MklToTfConversionPass::RunPass(std::unique_ptr<Graph>* g) {
   }
 
   // Process all candidate edges and insert conversion nodes on them.
+  ConversionNodeMap conversion_nodes;
   for (Edge* e : candidate_edges) {
     // Even if we insert conversion node on a single edge, we
     // need to return true.
     string src_name = e->src()->name();
     string dst_name = e->dst()->name();
-    if (InsertConversionNodeOnEdge(g, e) == Status::OK()) {
+    if (InsertConversionNodeOnEdge(g, e, &conversion_nodes) == Status::OK()) {
       VLOG(1) << "MklToTfConversionPass: Inserted conversion "
               << "node on edge between " << src_name << " and " << dst_name;
       result = true;
@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/grappler/clusters/utils.h"
 #include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_database.h"
 #include "tensorflow/core/grappler/costs/virtual_scheduler.h"
 
 namespace tensorflow {
@@ -27,7 +28,7 @@ namespace grappler {
 VirtualCluster::VirtualCluster(
     const std::unordered_map<string, DeviceProperties>& devices)
     : Cluster(0),
-      node_estimator_(new OpLevelCostEstimator()),
+      node_estimator_(CreateDefaultOpLevelCostEstimator()),
       node_manager_(new FirstReadyManager()) {
   devices_ = devices;
 }
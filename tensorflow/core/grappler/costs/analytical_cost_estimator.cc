@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/graph/types.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/grappler/costs/op_performance_database.h"
 #include "tensorflow/core/grappler/costs/utils.h"
 #include "tensorflow/core/grappler/costs/virtual_placer.h"
 #include "tensorflow/core/grappler/costs/virtual_scheduler.h"
@@ -103,7 +104,7 @@ void AddCostNode(ReadyNodeManager* node_manager, const OpContext& op_context,
 AnalyticalCostEstimator::AnalyticalCostEstimator(Cluster* cluster,
                                                  bool use_static_shapes)
     : AnalyticalCostEstimator(
-          cluster, absl::make_unique<OpLevelCostEstimator>(),
+          cluster, CreateDefaultOpLevelCostEstimator(),
           ReadyNodeManagerFactory("FirstReady"), use_static_shapes, nullptr) {}
 
 AnalyticalCostEstimator::AnalyticalCostEstimator(
@@ -0,0 +1,226 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_performance_database.h"
+
+#include <map>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+bool IsTextFormat(const string& path) {
+  return str_util::EndsWith(path, ".pbtxt");
+}
+
+// Returns the average of `num_samples` values `mean` updated with `value`.
+int64 UpdateMean(int64 mean, int64 value, int64 num_samples) {
+  return mean + (value - mean) / (num_samples + 1);
+}
+
+}  // namespace
+
+string OpPerformanceDatabase::Key(const OpInfo& op_info) {
+  string key = strings::StrCat(op_info.op(), ";", op_info.device().type());
+  // Sort the attributes for a deterministic key, and skip the internal ones
+  // such as _class that don't change the computation.
+  std::map<string, const AttrValue*> attrs;
+  for (const auto& attr : op_info.attr()) {
+    if (!str_util::StartsWith(attr.first, "_")) {
+      attrs[attr.first] = &attr.second;
+    }
+  }
+  for (const auto& attr : attrs) {
+    strings::StrAppend(&key, ";", attr.first, "=",
+                       SummarizeAttrValue(*attr.second));
+  }
+  for (const auto& input : op_info.inputs()) {
+    strings::StrAppend(&key, ";", DataTypeString(input.dtype()),
+                       PartialTensorShape::DebugString(input.shape()));
+  }
+  return key;
+}
+
+void OpPerformanceDatabase::AddOpPerformance(
+    const OpPerformanceList& perf_list) {
+  for (const OpPerformance& perf : perf_list.op_performance()) {
+    Entry& entry = entries_[Key(perf.op())];
+    if (entry.num_samples == 0) {
+      entry.mean.Clear();
+      *entry.mean.mutable_op() = perf.op();
+      entry.mean.set_compute_cost(perf.compute_cost());
+      entry.mean.set_compute_time(perf.compute_time());
+      entry.mean.set_memory_time(perf.memory_time());
+    } else {
+      entry.mean.set_compute_cost(UpdateMean(
+          entry.mean.compute_cost(), perf.compute_cost(), entry.num_samples));
+      entry.mean.set_compute_time(UpdateMean(
+          entry.mean.compute_time(), perf.compute_time(), entry.num_samples));
+      entry.mean.set_memory_time(UpdateMean(
+          entry.mean.memory_time(), perf.memory_time(), entry.num_samples));
+    }
+    ++entry.num_samples;
+  }
+}
+
+Status OpPerformanceDatabase::AddStepStats(const GrapplerItem& item,
+                                           const StepStats& step_stats) {
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(false));
+
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  for (const NodeDef& node : item.graph.node()) {
+    name_to_node[node.name()] = &node;
+  }
+
+  OpPerformanceList perf_list;
+  for (const auto& dev_stats : step_stats.dev_stats()) {
+    const DeviceProperties device = GetDeviceInfo(dev_stats.device());
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      auto it = name_to_node.find(node_stats.node_name());
+      if (it == name_to_node.end()) {
+        continue;
+      }
+      const NodeDef& node = *it->second;
+      OpPerformance* perf = perf_list.add_op_performance();
+      perf->set_node(node.name());
+      *perf->mutable_op() = BuildOpInfoWithoutDevice(
+          node, name_to_node, properties.GetInputProperties(node.name()));
+      *perf->mutable_op()->mutable_device() = device;
+      // Step stats are in microseconds, while OpPerformance is in
+      // nanoseconds. We can't tell the compute and memory times apart, so
+      // the whole op time is accounted as compute.
+      const int64 op_time_ns =
+          (node_stats.op_end_rel_micros() - node_stats.op_start_rel_micros()) *
+          1000;
+      perf->set_compute_cost(op_time_ns);
+      perf->set_compute_time(op_time_ns);
+    }
+  }
+  AddOpPerformance(perf_list);
+  return Status::OK();
+}
+
+const OpPerformance* OpPerformanceDatabase::Find(const OpInfo& op_info) const {
+  auto it = entries_.find(Key(op_info));
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  return &it->second.mean;
+}
+
+Status OpPerformanceDatabase::Load(const string& path) {
+  OpPerformanceList perf_list;
+  if (IsTextFormat(path)) {
+    TF_RETURN_IF_ERROR(ReadTextProto(Env::Default(), path, &perf_list));
+  } else {
+    TF_RETURN_IF_ERROR(ReadBinaryProto(Env::Default(), path, &perf_list));
+  }
+  AddOpPerformance(perf_list);
+  return Status::OK();
+}
+
+Status OpPerformanceDatabase::Save(const string& path) const {
+  // Sort the entries so that saving the same database twice gives the same
+  // file.
+  std::map<string, const Entry*> sorted_entries;
+  for (const auto& entry : entries_) {
+    sorted_entries[entry.first] = &entry.second;
+  }
+  OpPerformanceList perf_list;
+  for (const auto& entry : sorted_entries) {
+    *perf_list.add_op_performance() = entry.second->mean;
+  }
+  if (IsTextFormat(path)) {
+    return WriteTextProto(Env::Default(), path, perf_list);
+  }
+  return WriteBinaryProto(Env::Default(), path, perf_list);
+}
+
+MeasuredOpLevelCostEstimator::MeasuredOpLevelCostEstimator(
+    std::shared_ptr<const OpPerformanceDatabase> database)
+    : database_(std::move(database)) {}
+
+Costs MeasuredOpLevelCostEstimator::PredictCosts(
+    const OpContext& op_context) const {
+  const OpPerformance* perf = database_->Find(op_context.op_info);
+  if (perf == nullptr) {
+    return OpLevelCostEstimator::PredictCosts(op_context);
+  }
+  // Keep the memory estimates of the analytical model, which the
+  // measurements don't cover.
+  Costs costs = OpLevelCostEstimator::PredictCosts(op_context);
+  costs.execution_time = Costs::NanoSeconds(perf->compute_cost());
+  costs.compute_time = Costs::NanoSeconds(perf->compute_time());
+  costs.memory_time = Costs::NanoSeconds(perf->memory_time());
+  costs.intermediate_memory_time = 0;
+  costs.inaccurate = false;
+  costs.num_ops_with_unknown_shapes = 0;
+  VLOG(1) << "Operation " << op_context.op_info.op() << " was measured to take "
+          << costs.execution_time.count() << " ns.";
+  return costs;
+}
+
+std::unique_ptr<OpLevelCostEstimator> CreateDefaultOpLevelCostEstimator() {
+  static mutex mu(LINKER_INITIALIZED);
+  static std::shared_ptr<const OpPerformanceDatabase>* database = nullptr;
+  {
+    mutex_lock l(mu);
+    if (database == nullptr) {
+      database = new std::shared_ptr<const OpPerformanceDatabase>();
+      string path;
+      Status s = ReadStringFromEnvVar("TF_GRAPPLER_OP_PERFORMANCE_DB", "",
+                                      &path);
+      if (s.ok() && !path.empty()) {
+        std::shared_ptr<OpPerformanceDatabase> loaded =
+            std::make_shared<OpPerformanceDatabase>();
+        s = loaded->Load(path);
+        if (s.ok()) {
+          VLOG(1) << "Loaded " << loaded->size()
+                  << " measured op costs from " << path;
+          *database = std::move(loaded);
+        }
+      }
+      if (!s.ok()) {
+        LOG(WARNING) << "Failed to load the op performance database: "
+                     << s.error_message();
+      }
+    }
+  }
+  if (*database == nullptr) {
+    return std::unique_ptr<OpLevelCostEstimator>(new OpLevelCostEstimator());
+  }
+  return std::unique_ptr<OpLevelCostEstimator>(
+      new MeasuredOpLevelCostEstimator(*database));
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,105 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_OP_PERFORMANCE_DATABASE_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_OP_PERFORMANCE_DATABASE_H_
+
+#include <memory>
+#include <unordered_map>
+
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+class StepStats;
+}  // namespace tensorflow
+
+namespace tensorflow {
+namespace grappler {
+
+struct GrapplerItem;
+
+// Measured performance of ops, keyed by op type, attributes, input types and
+// shapes, and device type. It is built from the step stats of real runs and
+// saved as an OpPerformanceList, so that the cost estimators can use the
+// measured costs for the hardware at hand instead of analytical estimates.
+// Several measurements of the same key are averaged.
+class OpPerformanceDatabase {
+ public:
+  OpPerformanceDatabase() {}
+
+  // Adds the measurements in `perf_list`, e.g. as returned by
+  // CostGraphToOpPerformanceData.
+  void AddOpPerformance(const OpPerformanceList& perf_list);
+
+  // Adds the op execution times recorded in `step_stats` for a run of
+  // `item`. Nodes of the step stats that aren't in the graph of `item`, such
+  // as the _Send and _Recv nodes added by graph partitioning, are ignored.
+  Status AddStepStats(const GrapplerItem& item, const StepStats& step_stats);
+
+  // Returns the average measured performance of the ops matching `op_info`,
+  // or nullptr if none was measured.
+  const OpPerformance* Find(const OpInfo& op_info) const;
+
+  // Number of distinct keys in the database.
+  int64 size() const { return entries_.size(); }
+
+  // Adds the measurements saved in the file at `path`, in text format if its
+  // name ends with ".pbtxt" and in binary format otherwise.
+  Status Load(const string& path);
+
+  // Saves the database to the file at `path`, in the same formats as Load.
+  Status Save(const string& path) const;
+
+ private:
+  struct Entry {
+    OpPerformance mean;
+    int64 num_samples = 0;
+  };
+
+  static string Key(const OpInfo& op_info);
+
+  std::unordered_map<string, Entry> entries_;
+};
+
+// Estimates the cost of the ops found in an OpPerformanceDatabase from their
+// measurements, and of the other ones analytically.
+class MeasuredOpLevelCostEstimator : public OpLevelCostEstimator {
+ public:
+  explicit MeasuredOpLevelCostEstimator(
+      std::shared_ptr<const OpPerformanceDatabase> database);
+  ~MeasuredOpLevelCostEstimator() override {}
+
+  Costs PredictCosts(const OpContext& op_context) const override;
+
+ private:
+  std::shared_ptr<const OpPerformanceDatabase> database_;
+};
+
+// Returns the op level cost estimator used by default by the virtual cluster
+// and the analytical cost estimator. If the TF_GRAPPLER_OP_PERFORMANCE_DB
+// environment variable names an OpPerformanceDatabase file, it's a
+// MeasuredOpLevelCostEstimator using that database, which is loaded once per
+// process. Otherwise it's a plain OpLevelCostEstimator.
+std::unique_ptr<OpLevelCostEstimator> CreateDefaultOpLevelCostEstimator();
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_OP_PERFORMANCE_DATABASE_H_
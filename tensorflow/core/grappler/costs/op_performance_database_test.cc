@@ -0,0 +1,181 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_performance_database.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Returns an OpInfo for a MatMul of two matrices of the given sizes on CPU.
+OpInfo DescribeMatMul(int m, int n, int k) {
+  OpInfo op_info;
+  op_info.set_op("MatMul");
+  op_info.mutable_device()->set_type("CPU");
+  (*op_info.mutable_attr())["transpose_a"].set_b(false);
+  for (const auto& dims : {std::make_pair(m, k), std::make_pair(k, n)}) {
+    auto* input = op_info.add_inputs();
+    input->set_dtype(DT_FLOAT);
+    input->mutable_shape()->add_dim()->set_size(dims.first);
+    input->mutable_shape()->add_dim()->set_size(dims.second);
+  }
+  return op_info;
+}
+
+OpPerformanceList MeasureMatMul(int m, int n, int k,
+                                const std::vector<int64>& costs) {
+  OpPerformanceList perf_list;
+  for (int64 cost : costs) {
+    OpPerformance* perf = perf_list.add_op_performance();
+    *perf->mutable_op() = DescribeMatMul(m, n, k);
+    perf->set_compute_cost(cost);
+    perf->set_compute_time(cost);
+  }
+  return perf_list;
+}
+
+}  // namespace
+
+TEST(OpPerformanceDatabaseTest, AveragesMeasurements) {
+  OpPerformanceDatabase database;
+  database.AddOpPerformance(MeasureMatMul(10, 20, 30, {1000, 3000, 5000}));
+  database.AddOpPerformance(MeasureMatMul(20, 20, 30, {7000}));
+  EXPECT_EQ(2, database.size());
+
+  const OpPerformance* perf = database.Find(DescribeMatMul(10, 20, 30));
+  ASSERT_NE(nullptr, perf);
+  EXPECT_EQ(3000, perf->compute_cost());
+  EXPECT_EQ(3000, perf->compute_time());
+
+  perf = database.Find(DescribeMatMul(20, 20, 30));
+  ASSERT_NE(nullptr, perf);
+  EXPECT_EQ(7000, perf->compute_cost());
+
+  // Different shapes, attributes or devices don't match.
+  EXPECT_EQ(nullptr, database.Find(DescribeMatMul(30, 20, 30)));
+  OpInfo transposed = DescribeMatMul(10, 20, 30);
+  (*transposed.mutable_attr())["transpose_a"].set_b(true);
+  EXPECT_EQ(nullptr, database.Find(transposed));
+  OpInfo on_gpu = DescribeMatMul(10, 20, 30);
+  on_gpu.mutable_device()->set_type("GPU");
+  EXPECT_EQ(nullptr, database.Find(on_gpu));
+
+  // Internal attributes and device details are ignored.
+  OpInfo with_details = DescribeMatMul(10, 20, 30);
+  (*with_details.mutable_attr())["_class"].mutable_list()->add_s("loc:@a");
+  with_details.mutable_device()->set_frequency(1000);
+  EXPECT_NE(nullptr, database.Find(with_details));
+}
+
+TEST(OpPerformanceDatabaseTest, SaveAndLoad) {
+  OpPerformanceDatabase database;
+  database.AddOpPerformance(MeasureMatMul(10, 20, 30, {1000, 3000}));
+  database.AddOpPerformance(MeasureMatMul(20, 20, 30, {7000}));
+
+  for (const string& name : {"op_perf.pb", "op_perf.pbtxt"}) {
+    const string path = io::JoinPath(testing::TmpDir(), name);
+    TF_ASSERT_OK(database.Save(path));
+
+    OpPerformanceDatabase loaded;
+    TF_ASSERT_OK(loaded.Load(path));
+    EXPECT_EQ(2, loaded.size());
+    const OpPerformance* perf = loaded.Find(DescribeMatMul(10, 20, 30));
+    ASSERT_NE(nullptr, perf);
+    EXPECT_EQ(2000, perf->compute_cost());
+  }
+
+  OpPerformanceDatabase missing;
+  EXPECT_FALSE(
+      missing.Load(io::JoinPath(testing::TmpDir(), "missing.pb")).ok());
+}
+
+TEST(OpPerformanceDatabaseTest, AddStepStats) {
+  GrapplerItem item;
+  NodeDef* x = item.graph.add_node();
+  x->set_name("x");
+  x->set_op("Placeholder");
+  (*x->mutable_attr())["dtype"].set_type(DT_FLOAT);
+  TensorShapeProto* shape = (*x->mutable_attr())["shape"].mutable_shape();
+  shape->add_dim()->set_size(10);
+  shape->add_dim()->set_size(10);
+  NodeDef* y = item.graph.add_node();
+  y->set_name("y");
+  y->set_op("Square");
+  y->add_input("x");
+  (*y->mutable_attr())["T"].set_type(DT_FLOAT);
+
+  StepStats step_stats;
+  DeviceStepStats* dev_stats = step_stats.add_dev_stats();
+  dev_stats->set_device("/job:localhost/replica:0/task:0/device:CPU:0");
+  NodeExecStats* node_stats = dev_stats->add_node_stats();
+  node_stats->set_node_name("y");
+  node_stats->set_op_start_rel_micros(2);
+  node_stats->set_op_end_rel_micros(7);
+  // Nodes added by the runtime are skipped.
+  node_stats = dev_stats->add_node_stats();
+  node_stats->set_node_name("_SOURCE");
+
+  OpPerformanceDatabase database;
+  TF_ASSERT_OK(database.AddStepStats(item, step_stats));
+  EXPECT_EQ(1, database.size());
+
+  OpInfo op_info;
+  op_info.set_op("Square");
+  op_info.mutable_device()->set_type("CPU");
+  (*op_info.mutable_attr())["T"].set_type(DT_FLOAT);
+  OpInfo::TensorProperties* input = op_info.add_inputs();
+  input->set_dtype(DT_FLOAT);
+  *input->mutable_shape() = *shape;
+  const OpPerformance* perf = database.Find(op_info);
+  ASSERT_NE(nullptr, perf);
+  EXPECT_EQ(5000, perf->compute_cost());
+}
+
+TEST(MeasuredOpLevelCostEstimatorTest, UsesMeasuredCosts) {
+  auto database = std::make_shared<OpPerformanceDatabase>();
+  database->AddOpPerformance(MeasureMatMul(10, 20, 30, {123456}));
+  MeasuredOpLevelCostEstimator estimator(database);
+
+  OpContext measured;
+  measured.op_info = DescribeMatMul(10, 20, 30);
+  Costs costs = estimator.PredictCosts(measured);
+  EXPECT_EQ(Costs::Duration(123456), costs.execution_time);
+  EXPECT_FALSE(costs.inaccurate);
+
+  // Ops that weren't measured get the analytical estimate.
+  OpContext unmeasured;
+  unmeasured.op_info = DescribeMatMul(100, 20, 30);
+  OpLevelCostEstimator analytical;
+  EXPECT_EQ(analytical.PredictCosts(unmeasured).execution_time,
+            estimator.PredictCosts(unmeasured).execution_time);
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/costs/utils.h"
 
 #include <stddef.h>
+#include <algorithm>
 #include <utility>
 
 #include "third_party/eigen3/Eigen/Core"
@@ -314,7 +315,8 @@ OpPerformanceList CostGraphToOpPerformanceData(const CostGraphDef& cost_graph,
     }
     const CostGraphDef::Node* cost_node = it->second;
 
-    OpPerformance* perf = ret.add_op_performance();
+    OpPerformance op_perf;
+    OpPerformance* perf = &op_perf;
     perf->set_node(node.name());
 
     std::vector<OpInfo::TensorProperties> inputs =
@@ -337,6 +339,31 @@ OpPerformanceList CostGraphToOpPerformanceData(const CostGraphDef& cost_graph,
         cost_node->temporary_memory_size());
     perf->mutable_op_memory()->set_persistent_memory(
         cost_node->persistent_memory_size());
+
+    if (cost_node->shape_cost_size() == 0) {
+      *ret.add_op_performance() = std::move(op_perf);
+      continue;
+    }
+    // The node ran with several input shapes: report the median time of
+    // each shape separately rather than the time of the slowest one.
+    for (const auto& shape_cost : cost_node->shape_cost()) {
+      if (shape_cost.compute_time_sample_size() == 0 ||
+          shape_cost.input_shape_size() != perf->op().inputs_size()) {
+        continue;
+      }
+      OpPerformance* shape_perf = ret.add_op_performance();
+      *shape_perf = op_perf;
+      for (int i = 0; i < shape_cost.input_shape_size(); ++i) {
+        *shape_perf->mutable_op()->mutable_inputs(i)->mutable_shape() =
+            shape_cost.input_shape(i);
+      }
+      std::vector<int64> samples(shape_cost.compute_time_sample().begin(),
+                                 shape_cost.compute_time_sample().end());
+      auto median = samples.begin() + samples.size() / 2;
+      std::nth_element(samples.begin(), median, samples.end());
+      shape_perf->set_compute_cost(*median * 1000);
+      shape_perf->set_compute_time(*median * 1000);
+    }
   }
   return ret;
 }
@@ -178,6 +178,45 @@ TEST(UtilsTest, TestSkipControlInput) {
   EXPECT_TRUE(node_found);
 }
 
+TEST(UtilsTest, CostGraphToOpPerformanceDataPerShape) {
+  GraphDef graph;
+  TF_CHECK_OK(NodeDefBuilder("x", "Placeholder")
+                  .Attr("dtype", DT_FLOAT)
+                  .Finalize(graph.add_node()));
+  TF_CHECK_OK(NodeDefBuilder("y", "Identity")
+                  .Input("x", 0, DT_FLOAT)
+                  .Finalize(graph.add_node()));
+
+  CostGraphDef cost_graph;
+  CostGraphDef::Node* x = cost_graph.add_node();
+  x->set_name("x");
+  x->add_output_info()->set_dtype(DT_FLOAT);
+  CostGraphDef::Node* y = cost_graph.add_node();
+  y->set_name("y");
+  y->set_compute_cost(100);
+  for (int size : {2, 200}) {
+    CostGraphDef::Node::ShapeCost* shape_cost = y->add_shape_cost();
+    shape_cost->add_input_shape()->add_dim()->set_size(size);
+    shape_cost->set_count(3);
+    for (int i = 1; i <= 3; ++i) {
+      shape_cost->add_compute_time_sample(size * i);
+    }
+  }
+
+  OpPerformanceList perfs = CostGraphToOpPerformanceData(cost_graph, graph);
+  ASSERT_EQ(3, perfs.op_performance_size());
+  EXPECT_EQ("x", perfs.op_performance(0).node());
+  for (int i = 1; i < 3; ++i) {
+    const OpPerformance& perf = perfs.op_performance(i);
+    EXPECT_EQ("y", perf.node());
+    ASSERT_EQ(1, perf.op().inputs_size());
+    EXPECT_EQ(DT_FLOAT, perf.op().inputs(0).dtype());
+    const int64 size = perf.op().inputs(0).shape().dim(0).size();
+    EXPECT_EQ(i == 1 ? 2 : 200, size);
+    EXPECT_EQ(size * 2 * 1000, perf.compute_cost());
+  }
+}
+
 TEST(UtilsTest, CalculateTensorSize) {
   // Test normal usage.
   EXPECT_EQ(DataTypeSize(DT_FLOAT) * 1,
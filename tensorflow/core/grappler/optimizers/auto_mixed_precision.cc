@@ -0,0 +1,346 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+constexpr char kCastPrefix[] = "AutoMixedPrecision";
+
+enum class OpList { kWhite, kGray, kClear, kBlack };
+
+std::vector<string> SplitOpNames(const string& ops) {
+  return str_util::Split(ops, ',', str_util::SkipEmpty());
+}
+
+// The list of each op, with the changes of the environment applied.
+class OpLists {
+ public:
+  OpLists() {
+    Add(OpList::kWhite,
+        {"BatchMatMul", "BlockLSTM", "BlockLSTMGrad", "Conv2D",
+         "Conv2DBackpropFilter", "Conv2DBackpropInput", "Conv3D",
+         "Conv3DBackpropFilterV2", "Conv3DBackpropInputV2", "CudnnRNN",
+         "CudnnRNNBackprop", "MatMul", "_FusedConv2D", "_FusedMatMul"});
+    Add(OpList::kGray,
+        {"Add", "AddN", "AddV2", "AvgPool", "AvgPool3D", "AvgPool3DGrad",
+         "AvgPoolGrad", "BiasAdd", "BiasAddGrad", "BiasAddV1", "Elu", "EluGrad",
+         "FusedBatchNormGradV2", "FusedBatchNormV2", "Mul", "RealDiv",
+         "Reciprocal", "Sigmoid", "SigmoidGrad", "Softplus", "SoftplusGrad",
+         "Sqrt", "SquaredDifference", "Sub", "Tanh", "TanhGrad"});
+    Add(OpList::kClear,
+        {"Abs", "ArgMax", "ArgMin", "BatchToSpace", "BatchToSpaceND", "Concat",
+         "ConcatV2", "DepthToSpace", "DynamicPartition", "DynamicStitch",
+         "Fill", "Gather", "GatherNd", "GatherV2", "Identity", "IdentityN",
+         "Max", "MaxPool", "MaxPool3D", "MaxPool3DGrad", "MaxPoolGrad",
+         "MaxPoolV2", "Maximum", "Min", "Minimum", "Neg", "OnesLike", "Pack",
+         "Pad", "PadV2", "PreventGradient", "Relu", "Relu6", "Relu6Grad",
+         "ReluGrad", "Reshape", "ReverseV2", "Select", "Shape", "ShapeN",
+         "Sign", "Size", "Slice", "Snapshot", "SpaceToBatch", "SpaceToBatchND",
+         "SpaceToDepth", "Split", "SplitV", "Square", "Squeeze", "StopGradient",
+         "StridedSlice", "StridedSliceGrad", "Tile", "TopKV2", "Transpose",
+         "Unpack", "ZerosLike"});
+    Add(OpList::kBlack,
+        {"Cumprod", "Cumsum", "Exp", "Expm1", "L2Loss", "Log", "Log1p",
+         "LogSoftmax", "Mean", "Pow", "Prod", "SaveV2", "Softmax",
+         "SoftmaxCrossEntropyWithLogits",
+         "SparseSoftmaxCrossEntropyWithLogits", "Sum"});
+
+    const std::pair<OpList, const char*> kEnvNames[] = {
+        {OpList::kWhite, "WHITELIST"},
+        {OpList::kGray, "GRAYLIST"},
+        {OpList::kClear, "CLEARLIST"},
+        {OpList::kBlack, "BLACKLIST"}};
+    for (const auto& list : kEnvNames) {
+      const string prefix =
+          strings::StrCat("TF_AUTO_MIXED_PRECISION_", list.second);
+      string ops;
+      TF_CHECK_OK(ReadStringFromEnvVar(prefix + "_ADD", "", &ops));
+      for (const string& op : SplitOpNames(ops)) {
+        lists_[op] = list.first;
+      }
+      TF_CHECK_OK(ReadStringFromEnvVar(prefix + "_REMOVE", "", &ops));
+      for (const string& op : SplitOpNames(ops)) {
+        const auto it = lists_.find(op);
+        if (it != lists_.end() && it->second == list.first) lists_.erase(it);
+      }
+    }
+  }
+
+  // Returns false if `op` is in no list.
+  bool Find(const string& op, OpList* list) const {
+    const auto it = lists_.find(op);
+    if (it == lists_.end()) return false;
+    *list = it->second;
+    return true;
+  }
+
+ private:
+  void Add(OpList list, const std::vector<string>& ops) {
+    for (const string& op : ops) lists_[op] = list;
+  }
+
+  std::unordered_map<string, OpList> lists_;
+};
+
+// What the pass knows about a node of one of the lists.
+struct NodeInfo {
+  OpList list;
+  // The type the node would be converted to, or DT_INVALID if it cannot be.
+  DataType type = DT_INVALID;
+  // Whether the type of each input and output is the "T" attribute.
+  std::vector<bool> t_inputs;
+  std::vector<bool> t_outputs;
+  bool converted = false;
+};
+
+// Appends to `is_t` whether the type of each tensor of `args` is the "T"
+// attribute. Returns false if a tensor of type "T" is a reference.
+bool ArgsOfTypeT(const NodeDef& node,
+                 const protobuf::RepeatedPtrField<OpDef::ArgDef>& args,
+                 std::vector<bool>* is_t) {
+  for (const OpDef::ArgDef& arg : args) {
+    int count = 1;
+    if (!arg.number_attr().empty()) {
+      if (!GetNodeAttr(node, arg.number_attr(), &count).ok()) return false;
+    } else if (!arg.type_list_attr().empty()) {
+      DataTypeVector types;
+      if (!GetNodeAttr(node, arg.type_list_attr(), &types).ok()) return false;
+      count = types.size();
+    }
+    const bool of_type_t = arg.type_attr() == "T";
+    if (of_type_t && arg.is_ref()) return false;
+    is_t->insert(is_t->end(), count, of_type_t);
+  }
+  return true;
+}
+
+// Returns the reduced precision type of the float ops of `node`, or
+// DT_INVALID if it has no kernel of that type.
+DataType ReducedPrecisionType(const NodeDef& node,
+                              const string& default_device_type) {
+  string device_type = default_device_type;
+  DeviceNameUtils::ParsedName parsed_name;
+  if (!node.device().empty()) {
+    if (!DeviceNameUtils::ParseFullName(node.device(), &parsed_name) ||
+        !parsed_name.has_type) {
+      return DT_INVALID;
+    }
+    device_type = parsed_name.type;
+  }
+  DataType type;
+  if (device_type == DEVICE_GPU) {
+    type = DT_HALF;
+  } else if (device_type == DEVICE_CPU) {
+    type = DT_BFLOAT16;
+  } else {
+    return DT_INVALID;
+  }
+  NodeDef converted = node;
+  SetAttrValue(type, &(*converted.mutable_attr())["T"]);
+  if (!FindKernelDef(DeviceType(device_type), converted, nullptr, nullptr)
+           .ok()) {
+    return DT_INVALID;
+  }
+  return type;
+}
+
+}  // namespace
+
+Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                    GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  if (opt_level_ == RewriterConfig::OFF) {
+    return Status::OK();
+  }
+
+  // Nodes without a device will likely be placed on a GPU if there is one.
+  string default_device_type = DEVICE_CPU;
+  if (cluster != nullptr) {
+    for (const auto& device : cluster->GetDevices()) {
+      if (device.second.type() == DEVICE_GPU) {
+        default_device_type = DEVICE_GPU;
+      }
+    }
+  }
+
+  static const OpLists* lists = new OpLists;
+  const std::unordered_set<string> nodes_to_preserve = item.NodesToPreserve();
+  std::unordered_map<const NodeDef*, NodeInfo> infos;
+  for (const NodeDef& node : optimized_graph->node()) {
+    OpList list;
+    if (!lists->Find(node.op(), &list)) continue;
+    NodeInfo& info = infos[&node];
+    info.list = list;
+    // Blacklist nodes are recorded to block the conversion of their fanouts.
+    if (list == OpList::kBlack) continue;
+    DataType t;
+    if (nodes_to_preserve.count(node.name()) > 0 ||
+        !GetNodeAttr(node, "T", &t).ok() || t != DT_FLOAT) {
+      continue;
+    }
+    const OpDef* op_def = nullptr;
+    if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+        !ArgsOfTypeT(node, op_def->input_arg(), &info.t_inputs) ||
+        !ArgsOfTypeT(node, op_def->output_arg(), &info.t_outputs)) {
+      continue;
+    }
+    info.type = ReducedPrecisionType(node, default_device_type);
+  }
+
+  NodeMap node_map(optimized_graph);
+  auto find_info = [&infos](const NodeDef* node) -> NodeInfo* {
+    const auto it = infos.find(node);
+    return it == infos.end() ? nullptr : &it->second;
+  };
+  // Returns the info of the producer of the i-th input of `node` if the
+  // input is a converted output of type "T", and nullptr otherwise.
+  auto converted_producer = [&](const NodeDef& node, int i) -> NodeInfo* {
+    int port;
+    const string producer = ParseNodeName(node.input(i), &port);
+    NodeInfo* info = find_info(node_map.GetNode(producer));
+    if (info == nullptr || !info->converted || port < 0 ||
+        port >= static_cast<int>(info->t_outputs.size()) ||
+        !info->t_outputs[port]) {
+      return nullptr;
+    }
+    return info;
+  };
+
+  // Convert the whitelist nodes, then let the graylist and clearlist nodes
+  // follow their inputs.
+  std::deque<const NodeDef*> queue;
+  for (auto& node_info : infos) {
+    NodeInfo& info = node_info.second;
+    if (info.list == OpList::kWhite && info.type != DT_INVALID) {
+      info.converted = true;
+      queue.push_back(node_info.first);
+    }
+  }
+  while (!queue.empty()) {
+    const NodeDef* converted = queue.front();
+    queue.pop_front();
+    for (const NodeDef* fanout : node_map.GetOutputs(converted->name())) {
+      NodeInfo* info = find_info(fanout);
+      if (info == nullptr || info->converted || info->type == DT_INVALID ||
+          (info->list != OpList::kGray && info->list != OpList::kClear)) {
+        continue;
+      }
+      bool has_converted_input = false;
+      bool has_blacklist_input = false;
+      const int num_inputs =
+          std::min<int>(fanout->input_size(), info->t_inputs.size());
+      for (int i = 0; i < num_inputs; ++i) {
+        if (!info->t_inputs[i] || IsControlInput(fanout->input(i))) continue;
+        const NodeInfo* producer = converted_producer(*fanout, i);
+        if (producer != nullptr && producer->type == info->type) {
+          has_converted_input = true;
+        }
+        const NodeInfo* input_info =
+            find_info(node_map.GetNode(NodeName(fanout->input(i))));
+        if (input_info != nullptr && input_info->list == OpList::kBlack) {
+          has_blacklist_input = true;
+        }
+      }
+      if (has_converted_input && !has_blacklist_input) {
+        info->converted = true;
+        queue.push_back(fanout);
+      }
+    }
+  }
+
+  // Insert the casts on the edges whose two ends now have different types,
+  // sharing them between the consumers of a tensor.
+  std::map<std::pair<string, DataType>, string> casts;
+  std::vector<NodeDef> cast_nodes;
+  int num_converted = 0;
+  for (NodeDef& node : *optimized_graph->mutable_node()) {
+    NodeInfo* info = find_info(&node);
+    const bool converted = info != nullptr && info->converted;
+    for (int i = 0; i < node.input_size(); ++i) {
+      if (IsControlInput(node.input(i))) break;
+      const NodeInfo* producer = converted_producer(node, i);
+      const DataType src_type =
+          producer != nullptr ? producer->type : DT_FLOAT;
+      const DataType dst_type =
+          converted && i < static_cast<int>(info->t_inputs.size()) &&
+                  info->t_inputs[i]
+              ? info->type
+              : DT_FLOAT;
+      if (src_type == dst_type) continue;
+
+      string& cast_name = casts[std::make_pair(node.input(i), dst_type)];
+      if (cast_name.empty()) {
+        int port;
+        const string producer_name = ParseNodeName(node.input(i), &port);
+        cast_name = AddPrefixToNodeName(
+            strings::StrCat(producer_name, "-", port, "-CastTo",
+                            DataTypeString(dst_type)),
+            kCastPrefix);
+        cast_nodes.emplace_back();
+        NodeDef& cast = cast_nodes.back();
+        cast.set_name(cast_name);
+        cast.set_op("Cast");
+        // Casts run on the device of the converted op.
+        cast.set_device(producer != nullptr
+                            ? node_map.GetNode(producer_name)->device()
+                            : node.device());
+        cast.add_input(node.input(i));
+        SetAttrValue(src_type, &(*cast.mutable_attr())["SrcT"]);
+        SetAttrValue(dst_type, &(*cast.mutable_attr())["DstT"]);
+        SetAttrValue(false, &(*cast.mutable_attr())["Truncate"]);
+      }
+      node.set_input(i, cast_name);
+    }
+    if (converted) {
+      SetAttrValue(info->type, &(*node.mutable_attr())["T"]);
+      ++num_converted;
+    }
+  }
+  for (NodeDef& cast : cast_nodes) {
+    optimized_graph->add_node()->Swap(&cast);
+  }
+  VLOG(1) << "Converted " << num_converted
+          << " nodes to reduced precision with " << casts.size() << " casts";
+  return Status::OK();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
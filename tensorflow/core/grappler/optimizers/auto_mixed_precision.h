@@ -0,0 +1,67 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_AUTO_MIXED_PRECISION_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_AUTO_MIXED_PRECISION_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Converts float ops to half on GPUs and to bfloat16 on CPUs where it is
+// fast and numerically safe, and inserts casts on the edges between the
+// converted and the remaining float ops.
+//
+// Ops fall into four lists. Whitelist ops (matrix multiplications and
+// convolutions) are always converted, graylist ops (e.g. Add, BiasAdd) are
+// converted when one of their inputs is converted and none comes from a
+// blacklist op, clearlist ops (e.g. Relu, Reshape) follow their inputs in the
+// same way, and blacklist ops (e.g. Softmax, Sum) stay in float. The lists can
+// be changed with the TF_AUTO_MIXED_PRECISION_<LIST>_ADD and
+// TF_AUTO_MIXED_PRECISION_<LIST>_REMOVE environment variables, where <LIST>
+// is WHITELIST, GRAYLIST, CLEARLIST or BLACKLIST and the value is a comma
+// separated list of ops. Ops are only converted if their device has a kernel
+// for the reduced precision type.
+//
+// Variables are not converted, so the weights and their updates stay in
+// float. Losses computed in reduced precision should be scaled, e.g. with
+// tf.contrib.mixed_precision.LossScaleOptimizer, to keep small gradients from
+// flushing to zero.
+class AutoMixedPrecision : public GraphOptimizer {
+ public:
+  AutoMixedPrecision() : opt_level_(RewriterConfig::ON) {}
+  explicit AutoMixedPrecision(RewriterConfig::Toggle opt_level)
+      : opt_level_(opt_level) {}
+
+  ~AutoMixedPrecision() override {}
+
+  string name() const override { return "auto_mixed_precision"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override {}
+
+ private:
+  RewriterConfig::Toggle opt_level_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_AUTO_MIXED_PRECISION_H_
@@ -0,0 +1,157 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
+
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+
+constexpr char kDevice[] = "/job:localhost/replica:0/task:0/device:CPU:0";
+
+NodeDef Placeholder(const string& name) {
+  return NDef(name, "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice);
+}
+
+NodeDef Op(const string& name, const string& op,
+           const std::vector<string>& inputs) {
+  return NDef(name, op, inputs, {{"T", DT_FLOAT}}, kDevice);
+}
+
+DataType TypeOf(const NodeDef& node, const string& attr = "T") {
+  return node.attr().at(attr).type();
+}
+
+TEST(AutoMixedPrecisionTest, ConvertsRegionsBetweenCasts) {
+  GrapplerItem item;
+  item.graph = test::function::GDef({
+      Placeholder("x"),
+      Placeholder("w"),
+      Placeholder("b"),
+      NDef("matmul", "MatMul", {"x", "w"},
+           {{"T", DT_FLOAT}, {"transpose_a", false}, {"transpose_b", false}},
+           kDevice),
+      Op("bias", "BiasAdd", {"matmul", "b"}),
+      Op("relu", "Relu", {"bias"}),
+      Op("softmax", "Softmax", {"relu"}),
+      Op("other", "Relu", {"relu"}),
+      Op("out", "Identity", {"softmax"}),
+  });
+  item.fetch = {"out", "other"};
+
+  AutoMixedPrecision optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  for (const string& name : {"matmul", "bias", "relu"}) {
+    const NodeDef* node = node_map.GetNode(name);
+    ASSERT_NE(nullptr, node);
+    EXPECT_EQ(DT_BFLOAT16, TypeOf(*node)) << name;
+  }
+  // The fetched nodes keep their types.
+  for (const string& name : {"softmax", "other", "out"}) {
+    EXPECT_EQ(DT_FLOAT, TypeOf(*node_map.GetNode(name))) << name;
+  }
+
+  const NodeDef* matmul = node_map.GetNode("matmul");
+  const NodeDef* cast_x = node_map.GetNode(matmul->input(0));
+  ASSERT_NE(nullptr, cast_x);
+  EXPECT_EQ("Cast", cast_x->op());
+  EXPECT_EQ("x", cast_x->input(0));
+  EXPECT_EQ(DT_FLOAT, TypeOf(*cast_x, "SrcT"));
+  EXPECT_EQ(DT_BFLOAT16, TypeOf(*cast_x, "DstT"));
+  EXPECT_EQ(kDevice, cast_x->device());
+  EXPECT_EQ("Cast", node_map.GetNode(matmul->input(1))->op());
+  EXPECT_EQ("Cast", node_map.GetNode(node_map.GetNode("bias")->input(1))->op());
+  EXPECT_EQ("matmul", node_map.GetNode("bias")->input(0));
+  EXPECT_EQ("bias", node_map.GetNode("relu")->input(0));
+
+  // The two float consumers of relu share a cast.
+  const string& cast_relu = node_map.GetNode("softmax")->input(0);
+  EXPECT_EQ(cast_relu, node_map.GetNode("other")->input(0));
+  const NodeDef* cast = node_map.GetNode(cast_relu);
+  ASSERT_NE(nullptr, cast);
+  EXPECT_EQ("relu", cast->input(0));
+  EXPECT_EQ(DT_BFLOAT16, TypeOf(*cast, "SrcT"));
+  EXPECT_EQ(DT_FLOAT, TypeOf(*cast, "DstT"));
+
+  int num_casts = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.op() == "Cast") ++num_casts;
+  }
+  EXPECT_EQ(4, num_casts);
+}
+
+TEST(AutoMixedPrecisionTest, BlacklistInputsKeepGraylistNodesInFloat) {
+  GrapplerItem item;
+  item.graph = test::function::GDef({
+      Placeholder("x"),
+      NDef("matmul", "MatMul", {"x", "x"},
+           {{"T", DT_FLOAT}, {"transpose_a", false}, {"transpose_b", false}},
+           kDevice),
+      Op("log", "Log", {"x"}),
+      Op("add", "Add", {"matmul", "log"}),
+      Op("out", "Identity", {"add"}),
+  });
+  item.fetch = {"out"};
+
+  AutoMixedPrecision optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(DT_BFLOAT16, TypeOf(*node_map.GetNode("matmul")));
+  EXPECT_EQ(DT_FLOAT, TypeOf(*node_map.GetNode("log")));
+  const NodeDef* add = node_map.GetNode("add");
+  EXPECT_EQ(DT_FLOAT, TypeOf(*add));
+  EXPECT_EQ("log", add->input(1));
+  const NodeDef* cast = node_map.GetNode(add->input(0));
+  ASSERT_NE(nullptr, cast);
+  EXPECT_EQ("Cast", cast->op());
+  EXPECT_EQ("matmul", cast->input(0));
+  // Both inputs of matmul read the same cast of x.
+  EXPECT_EQ(node_map.GetNode("matmul")->input(0),
+            node_map.GetNode("matmul")->input(1));
+}
+
+TEST(AutoMixedPrecisionTest, Disabled) {
+  GrapplerItem item;
+  item.graph = test::function::GDef({
+      Placeholder("x"),
+      NDef("matmul", "MatMul", {"x", "x"},
+           {{"T", DT_FLOAT}, {"transpose_a", false}, {"transpose_b", false}},
+           kDevice),
+  });
+
+  AutoMixedPrecision optimizer(RewriterConfig::OFF);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  ASSERT_EQ(2, output.node_size());
+  EXPECT_EQ(DT_FLOAT, TypeOf(output.node(1)));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -37,7 +37,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/denormal.h"
@@ -53,6 +55,30 @@ namespace grappler {
 using TensorVector = gtl::InlinedVector<TensorValue, 4>;
 
 namespace {
+// Nodes whose outputs would be larger than this (before encoding, which may
+// compress repeated values) are not evaluated.
+const int64 kMaxOutputSizeToEvaluate = 256LL * 1024 * 1024;  // bytes
+
+// Maximum total size of the outputs kept in the cache of folded results.
+const int64 kMaxFoldCacheSize = 64LL * 1024 * 1024;  // bytes
+
+// Returns the size in bytes of the largest output of `node`, or -1 if its
+// output shapes or types are not known statically.
+int64 EstimateLargestOutputSize(const NodeDef& node,
+                                const GraphProperties& properties) {
+  const auto& output_props = properties.GetOutputProperties(node.name());
+  if (output_props.empty()) return -1;
+  int64 largest = 0;
+  for (const auto& output : output_props) {
+    const int64 num_elements =
+        PartialTensorShape(output.shape()).num_elements();
+    const int64 element_size = DataTypeSize(output.dtype());
+    if (num_elements < 0 || element_size == 0) return -1;
+    largest = std::max(largest, num_elements * element_size);
+  }
+  return largest;
+}
+
 class EigenThreadPoolWrapper : public Eigen::ThreadPoolInterface {
  public:
   explicit EigenThreadPoolWrapper(thread::ThreadPool* pool) : pool_(pool) {}
@@ -986,6 +1012,15 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
     }
   });
 
+  // The fingerprint covers the op, its attributes and the values of its
+  // inputs, but not its name.
+  NodeDef signature;
+  signature.set_op(node.op());
+  *signature.mutable_attr() = node.attr();
+  string serialized;
+  SerializeToStringDeterministic(signature, &serialized);
+  uint64 fingerprint = Hash64(serialized);
+  std::vector<const TensorProto*> input_values;
   for (const auto& input : node.input()) {
     int port = 0;
     ParseNodeNameAsStringPiece(input, &port);
@@ -1001,14 +1036,41 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
     }
     TF_RETURN_IF_ERROR(CheckAttrExists(*input_node, "value"));
     const TensorProto& raw_val = input_node->attr().at("value").tensor();
-    Tensor* value = new Tensor(raw_val.dtype(), raw_val.tensor_shape());
-    CHECK(value->FromProto(raw_val));
-    inputs.emplace_back(value);
+    SerializeToStringDeterministic(raw_val, &serialized);
+    fingerprint = Hash64Combine(fingerprint, Hash64(serialized));
+    input_values.push_back(&raw_val);
+  }
+
+  bool cached = false;
+  {
+    mutex_lock l(fold_cache_mu_);
+    auto it = fold_cache_.find(fingerprint);
+    if (it != fold_cache_.end()) {
+      const FoldedResult& result = it->second;
+      TF_RETURN_IF_ERROR(result.status);
+      for (size_t i = 0; i < result.outputs.size(); ++i) {
+        output_tensors.emplace_back(
+            result.dead_outputs[i] ? nullptr : new Tensor(result.outputs[i]));
+      }
+      cached = true;
+    }
   }
 
-  TF_RETURN_IF_ERROR(EvaluateNode(node, inputs, &output_tensors));
-  if (output_tensors.empty()) {
-    return Status(error::INVALID_ARGUMENT, "Expected at least one output.");
+  if (!cached) {
+    for (const TensorProto* raw_val : input_values) {
+      Tensor* value = new Tensor(raw_val->dtype(), raw_val->tensor_shape());
+      CHECK(value->FromProto(*raw_val));
+      inputs.emplace_back(value);
+    }
+    Status s = EvaluateNode(node, inputs, &output_tensors);
+    if (s.ok() && output_tensors.empty()) {
+      s = Status(error::INVALID_ARGUMENT, "Expected at least one output.");
+    }
+    if (!s.ok()) {
+      mutex_lock l(fold_cache_mu_);
+      fold_cache_[fingerprint].status = s;
+      return s;
+    }
   }
 
   outputs->resize(output_tensors.size());
@@ -1018,18 +1080,39 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
       node_name = strings::StrCat(node_name, "-", i);
     }
     if (output_tensors[i].tensor) {
-      TF_RETURN_IF_ERROR(
-          CreateNodeDef(node_name, output_tensors[i], &outputs->at(i)));
+      Status s = CreateNodeDef(node_name, output_tensors[i], &outputs->at(i));
+      if (!s.ok()) {
+        mutex_lock l(fold_cache_mu_);
+        fold_cache_[fingerprint].status = s;
+        return s;
+      }
     } else {
       // Create an empty NodeDef to identify dead outputs (e.g. the output of a
       // switch that's not selected by the switch predicate).
       outputs->at(i) = NodeDef();
     }
   }
+
+  if (!cached) {
+    FoldedResult result;
+    int64 total_bytes = 0;
+    for (const auto& output : output_tensors) {
+      result.dead_outputs.push_back(output.tensor == nullptr);
+      result.outputs.push_back(output.tensor ? *output.tensor : Tensor());
+      total_bytes += output.tensor ? output.tensor->TotalBytes() : 0;
+    }
+    mutex_lock l(fold_cache_mu_);
+    if (fold_cache_bytes_ + total_bytes <= kMaxFoldCacheSize) {
+      fold_cache_bytes_ += total_bytes;
+      fold_cache_[fingerprint] = std::move(result);
+    }
+  }
   return Status::OK();
 }
 
-Status ConstantFolding::FoldNode(NodeDef* node, GraphDef* output_graph) {
+Status ConstantFolding::FoldNode(NodeDef* node,
+                                 std::vector<NodeDef>* const_nodes_ptr,
+                                 GraphDef* output_graph) {
   if (IsMerge(*node)) {
     // Merge nodes are special, in the sense that they execute as soon as one of
     // their input is ready. We can therefore fold a merge node iff it has at
@@ -1121,8 +1204,7 @@ Status ConstantFolding::FoldNode(NodeDef* node, GraphDef* output_graph) {
     return Status::OK();
   }
 
-  std::vector<NodeDef> const_nodes;
-  TF_RETURN_IF_ERROR(EvaluateOneFoldable(*node, &const_nodes));
+  std::vector<NodeDef>& const_nodes = *const_nodes_ptr;
   NodeDef* constant_output = nullptr;
   for (int i = 0; i < const_nodes.size(); i++) {
     NodeDef* const_node = &const_nodes[i];
@@ -1227,7 +1309,8 @@ Status ConstantFolding::FoldNode(NodeDef* node, GraphDef* output_graph) {
   return Status::OK();
 }
 
-Status ConstantFolding::FoldGraph(GraphDef* output) {
+Status ConstantFolding::FoldGraph(const GraphProperties* properties,
+                                  GraphDef* output) {
   std::unordered_set<string> processed_nodes;
   std::deque<NodeDef*> queue;
   for (int i = 0; i < graph_->node_size(); i++) {
@@ -1236,29 +1319,82 @@ Status ConstantFolding::FoldGraph(GraphDef* output) {
     }
   }
   while (!queue.empty()) {
-    NodeDef* node = queue.front();
-    queue.pop_front();
-    if (processed_nodes.count(node->name())) {
-      continue;
+    // All the inputs of the queued nodes are constant, so they can be
+    // evaluated independently of each other: evaluate them in parallel, then
+    // fold them in queue order.
+    std::vector<NodeDef*> nodes;
+    while (!queue.empty()) {
+      NodeDef* node = queue.front();
+      queue.pop_front();
+      if (processed_nodes.insert(node->name()).second) {
+        nodes.push_back(node);
+      }
+    }
+    std::vector<std::vector<NodeDef>> const_nodes(nodes.size());
+    std::vector<Status> statuses(nodes.size());
+    std::vector<int> to_evaluate;
+    for (int i = 0; i < nodes.size(); ++i) {
+      if (IsMerge(*nodes[i])) {
+        continue;
+      }
+      if (properties != nullptr &&
+          EstimateLargestOutputSize(*nodes[i], *properties) >
+              kMaxOutputSizeToEvaluate) {
+        statuses[i] = errors::InvalidArgument(
+            "Can't fold ", nodes[i]->name(),
+            ", its output would be too large to evaluate");
+        continue;
+      }
+      to_evaluate.push_back(i);
     }
-    // We need to record a copy of output nodes before FoldNode() modifies it.
-    // We also need to ensure that the fanout is sorted deterministically.
-    const std::set<NodeDef*>& outputs = node_map_->GetOutputs(node->name());
-    std::vector<NodeDef*> fanout(outputs.begin(), outputs.end());
-    std::sort(fanout.begin(), fanout.end(),
-              [](const NodeDef* n1, const NodeDef* n2) {
-                return n1->name() < n2->name();
-              });
-
-    Status s = FoldNode(node, output);
-    processed_nodes.insert(node->name());
-    if (!s.ok()) {
-      VLOG(1) << "Failed to fold node " << node->DebugString()
-              << "\nError message: " << s;
+    auto evaluate = [this, &nodes, &const_nodes, &statuses, &to_evaluate](
+                        int64 begin, int64 end) {
+      // TensorFlow flushes denormals to zero and rounds to nearest, so we do
+      // the same here.
+      port::ScopedFlushDenormal flush;
+      port::ScopedSetRound round(FE_TONEAREST);
+      for (int64 j = begin; j < end; ++j) {
+        const int i = to_evaluate[j];
+        statuses[i] = EvaluateOneFoldable(*nodes[i], &const_nodes[i]);
+      }
+    };
+    if (to_evaluate.size() > 1) {
+      if (thread_pool_ == nullptr) {
+        thread_pool_.reset(new thread::ThreadPool(
+            Env::Default(), "constant_folding",
+            std::max(port::NumSchedulableCPUs(), 1)));
+      }
+      // Evaluating a node costs far more than scheduling it.
+      const int64 kCostPerNode = 1000000;
+      thread_pool_->ParallelFor(to_evaluate.size(), kCostPerNode, evaluate);
     } else {
-      for (auto& output : fanout) {
-        if (IsFoldable(*output)) {
-          queue.push_back(output);
+      evaluate(0, to_evaluate.size());
+    }
+
+    for (int i = 0; i < nodes.size(); ++i) {
+      NodeDef* node = nodes[i];
+      // We need to record a copy of output nodes before FoldNode() modifies
+      // it. We also need to ensure that the fanout is sorted
+      // deterministically.
+      const std::set<NodeDef*>& outputs = node_map_->GetOutputs(node->name());
+      std::vector<NodeDef*> fanout(outputs.begin(), outputs.end());
+      std::sort(fanout.begin(), fanout.end(),
+                [](const NodeDef* n1, const NodeDef* n2) {
+                  return n1->name() < n2->name();
+                });
+
+      Status s = statuses[i];
+      if (s.ok()) {
+        s = FoldNode(node, &const_nodes[i], output);
+      }
+      if (!s.ok()) {
+        VLOG(1) << "Failed to fold node " << node->DebugString()
+                << "\nError message: " << s;
+      } else {
+        for (auto& output : fanout) {
+          if (IsFoldable(*output)) {
+            queue.push_back(output);
+          }
         }
       }
     }
@@ -3023,7 +3159,8 @@ Status ConstantFolding::RunOptimizationPass(Cluster* cluster,
     TF_RETURN_IF_ERROR(MaterializeShapes(properties));
     TF_RETURN_IF_ERROR(MaterializeConstants(properties));
   }
-  TF_RETURN_IF_ERROR(FoldGraph(optimized_graph));
+  TF_RETURN_IF_ERROR(FoldGraph(can_use_shape_info ? &properties : nullptr,
+                               optimized_graph));
   node_map_.reset(new NodeMap(optimized_graph));
   TF_RETURN_IF_ERROR(
       SimplifyGraph(can_use_shape_info, optimized_graph, &properties));
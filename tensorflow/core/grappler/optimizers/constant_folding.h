@@ -16,12 +16,18 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_CONSTANT_FOLDING_H_
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_CONSTANT_FOLDING_H_
 
+#include <unordered_map>
+#include <vector>
+
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 
 namespace tensorflow {
@@ -71,10 +77,17 @@ class ConstantFolding : public GraphOptimizer {
                       const gtl::InlinedVector<TensorValue, 4>& inputs,
                       gtl::InlinedVector<TensorValue, 4>* output) const;
 
+  // Evaluates the foldable node `node` into constant nodes, one per output.
+  // Results are cached by the fingerprint of the node and its inputs.
+  // Thread-safe as long as the graph is not modified concurrently.
   Status EvaluateOneFoldable(const NodeDef& node,
                              std::vector<NodeDef>* outputs);
 
-  Status FoldNode(NodeDef* node, GraphDef* output_graph);
+  // Folds `node` into the constant nodes `const_nodes` evaluated by
+  // EvaluateOneFoldable(), unless it is a merge node, which are folded
+  // without evaluation.
+  Status FoldNode(NodeDef* node, std::vector<NodeDef>* const_nodes,
+                  GraphDef* output_graph);
 
   bool IsOnes(const NodeDef& node) const;
   bool IsZeros(const NodeDef& node) const;
@@ -91,7 +104,9 @@ class ConstantFolding : public GraphOptimizer {
                                       NodeDef* node, GraphDef* graph,
                                       bool* success);
   void ReplaceDivisionOfOnesByReciprocal(NodeDef* node, GraphDef* graph);
-  Status FoldGraph(GraphDef* output);
+  // Folds all the foldable nodes of the graph. `properties` may be null if
+  // shapes could not be inferred.
+  Status FoldGraph(const GraphProperties* properties, GraphDef* output);
 
   bool IsSimplifiableReduction(const NodeDef& node,
                                const GraphProperties& properties) const;
@@ -227,6 +242,24 @@ class ConstantFolding : public GraphOptimizer {
   bool has_fetch_;
   bool graph_modified_;
   bool graph_contains_assign_or_inplace_op_;
+
+  // Evaluates independent foldable nodes in parallel. Created on first use.
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+
+  // The result of evaluating a node, either an error or its outputs.
+  struct FoldedResult {
+    Status status;
+    std::vector<Tensor> outputs;
+    std::vector<bool> dead_outputs;
+  };
+  // Results of EvaluateOneFoldable() by fingerprint of the node and its
+  // inputs, kept across optimization passes and calls to Optimize() so that
+  // nodes that fail to fold, e.g. because their output is too large, are not
+  // evaluated again.
+  mutex fold_cache_mu_;
+  std::unordered_map<uint64, FoldedResult> fold_cache_
+      GUARDED_BY(fold_cache_mu_);
+  int64 fold_cache_bytes_ GUARDED_BY(fold_cache_mu_) = 0;
 };
 
 }  // end namespace grappler
@@ -2731,6 +2731,70 @@ TEST_F(ConstantFoldingTest, LargeConstant) {
   test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
 }
 
+TEST_F(ConstantFoldingTest, HugeOutputIsNotEvaluated) {
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  // The fill would produce a 16GB tensor.
+  Output dims = ops::Const(scope.WithOpName("dims"), {1 << 16, 1 << 16}, {2});
+  Output value = ops::Const(scope.WithOpName("value"), 1.0f, {});
+  Output fill = ops::Fill(scope.WithOpName("fill"), dims, value);
+  Output out = ops::Identity(scope.WithOpName("out"), fill);
+
+  GrapplerItem item;
+  TF_CHECK_OK(scope.ToGraphDef(&item.graph));
+  item.fetch.push_back("out");
+
+  ConstantFolding optimizer(nullptr /* cpu_device */);
+  GraphDef output;
+  Status status = optimizer.Optimize(nullptr, item, &output);
+  TF_EXPECT_OK(status);
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "fill") {
+      EXPECT_EQ("Fill", node.op());
+      ++found;
+    } else if (node.name() == "out") {
+      EXPECT_EQ("Identity", node.op());
+      EXPECT_EQ("fill", node.input(0));
+      ++found;
+    }
+  }
+  EXPECT_EQ(2, found);
+}
+
+TEST_F(ConstantFoldingTest, RepeatedOptimizationReusesFoldedResults) {
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(scope.WithOpName("x"), {1.0f, 2.0f}, {2});
+  Output y = ops::Const(scope.WithOpName("y"), {3.0f, 4.0f}, {2});
+  // Independent nodes, evaluated in parallel.
+  Output add = ops::Add(scope.WithOpName("add"), x, y);
+  Output mul = ops::Mul(scope.WithOpName("mul"), x, y);
+  Output sub = ops::Sub(scope.WithOpName("sub"), x, y);
+  Output out = ops::AddN(scope.WithOpName("out"), {add, mul, sub});
+
+  GrapplerItem item;
+  TF_CHECK_OK(scope.ToGraphDef(&item.graph));
+  item.fetch.push_back("out");
+
+  ConstantFolding optimizer(nullptr /* cpu_device */);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  GraphDef second_output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &second_output));
+  CompareGraphs(output, second_output);
+
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "add" || node.name() == "mul" || node.name() == "sub") {
+      EXPECT_EQ("Const", node.op());
+    }
+  }
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  EXPECT_EQ(1, tensors_expected.size());
+  auto tensors = EvaluateNodes(second_output, item.fetch);
+  EXPECT_EQ(1, tensors.size());
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
 TEST_F(ConstantFoldingTest, SwitchIdenticalInputs) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   Output x = ops::Placeholder(s.WithOpName("x"), DT_BOOL,
@@ -0,0 +1,311 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/decode_and_resize_fusion.h"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/optimizers/data/function_utils.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kFusedOp[] = "_DecodeAndCropResizeJpeg";
+
+// Attributes of DecodeAndCropJpeg that `kFusedOp` shares.
+constexpr const char* kDecodeAttrs[] = {
+    "channels", "fancy_upscaling", "try_recover_truncated",
+    "acceptable_fraction", "dct_method"};
+
+bool IsMapLike(const NodeDef& node) {
+  return node.op() == "MapDataset" || node.op() == "ParallelMapDataset" ||
+         node.op() == "MapAndBatchDatasetV2" ||
+         node.op() == "ExperimentalNumaMapAndBatchDataset";
+}
+
+string NodeName(const string& tensor) {
+  return function_utils::FunctionDefTensorDesc(tensor).node_name;
+}
+
+bool HasControlInputs(const NodeDef& node) {
+  for (const string& input : node.input()) {
+    if (str_util::StartsWith(input, "^")) return true;
+  }
+  return false;
+}
+
+// Returns whether any node or output of `function` refers to the node `name`.
+bool IsReferenced(const string& name, const FunctionDef& function) {
+  const string control_input = strings::StrCat("^", name);
+  for (const NodeDef& node : function.node_def()) {
+    for (const string& input : node.input()) {
+      if (input == control_input || NodeName(input) == name) return true;
+    }
+  }
+  for (const auto& ret : function.ret()) {
+    if (NodeName(ret.second) == name) return true;
+  }
+  return false;
+}
+
+// Returns the only node consuming `tensor`, which must be the only output of
+// `node` that is used. Returns nullptr if `node` has other consumers, control
+// outputs, or an output returned from the function.
+NodeDef* GetSoleConsumer(const NodeDef& node, const string& tensor,
+                         FunctionDef* function) {
+  const string control_input = strings::StrCat("^", node.name());
+  NodeDef* consumer = nullptr;
+  for (NodeDef& n : *function->mutable_node_def()) {
+    for (const string& input : n.input()) {
+      if (input == control_input) return nullptr;
+      if (NodeName(input) != node.name()) continue;
+      if (input != tensor || consumer != nullptr) return nullptr;
+      consumer = &n;
+    }
+  }
+  for (const auto& ret : function->ret()) {
+    if (NodeName(ret.second) == node.name()) return nullptr;
+  }
+  if (consumer == nullptr || HasControlInputs(*consumer)) return nullptr;
+  return consumer;
+}
+
+// Returns the value of `tensor` if it is produced by a Const node.
+bool GetConstValue(const string& tensor, const FunctionDef& function,
+                   Tensor* value) {
+  const int index =
+      function_utils::FindFunctionNodeWithName(NodeName(tensor), function);
+  if (index == -1) return false;
+  const NodeDef& node = function.node_def(index);
+  auto it = node.attr().find("value");
+  if (node.op() != "Const" || it == node.attr().end()) return false;
+  return value->FromProto(it->second.tensor());
+}
+
+// Returns whether `tensor` is a constant scalar or vector of floats, which
+// broadcasts over the channels of an image like `kFusedOp` expects.
+bool IsPerChannelConst(const string& tensor, const FunctionDef& function) {
+  Tensor value;
+  return GetConstValue(tensor, function, &value) &&
+         value.dtype() == DT_FLOAT && value.dims() <= 1;
+}
+
+bool IsConstZero(const string& tensor, const FunctionDef& function) {
+  Tensor value;
+  if (!GetConstValue(tensor, function, &value) || value.NumElements() != 1) {
+    return false;
+  }
+  if (value.dtype() == DT_INT32) return value.flat<int32>()(0) == 0;
+  if (value.dtype() == DT_INT64) return value.flat<int64>()(0) == 0;
+  return false;
+}
+
+string AddFloatConst(StringPiece prefix, float value, FunctionDef* function) {
+  AttrValue dtype_attr;
+  dtype_attr.set_type(DT_FLOAT);
+  AttrValue value_attr;
+  TensorProto* proto = value_attr.mutable_tensor();
+  proto->set_dtype(DT_FLOAT);
+  proto->mutable_tensor_shape();
+  proto->add_float_val(value);
+  NodeDef* node = function_utils::AddNode(
+      "", "Const", {}, {{"dtype", dtype_attr}, {"value", value_attr}},
+      function);
+  function_utils::SetUniqueFunctionNodeName(prefix, function, node);
+  return strings::StrCat(node->name(), ":output:0");
+}
+
+// Replaces the decode, resize and normalization chain starting at the node
+// `decode_name` with a single `kFusedOp` node. Returns whether the chain
+// matched.
+bool FuseDecodeAndResize(const string& decode_name, FunctionDef* function) {
+  const int decode_index =
+      function_utils::FindFunctionNodeWithName(decode_name, *function);
+  const NodeDef& decode = function->node_def(decode_index);
+  auto ratio = decode.attr().find("ratio");
+  if (HasControlInputs(decode) ||
+      (ratio != decode.attr().end() && ratio->second.i() != 1)) {
+    return false;
+  }
+  std::set<string> fused_nodes = {decode.name()};
+
+  string tensor = strings::StrCat(decode.name(), ":image:0");
+  NodeDef* consumer = GetSoleConsumer(decode, tensor, function);
+  if (consumer != nullptr && consumer->op() == "Cast") {
+    if (consumer->attr().at("DstT").type() != DT_FLOAT) return false;
+    fused_nodes.insert(consumer->name());
+    tensor = strings::StrCat(consumer->name(), ":y:0");
+    consumer = GetSoleConsumer(*consumer, tensor, function);
+  }
+
+  // The image is made a batch of one for the resize.
+  if (consumer == nullptr || consumer->op() != "ExpandDims" ||
+      consumer->input(0) != tensor ||
+      !IsConstZero(consumer->input(1), *function)) {
+    return false;
+  }
+  const string axis_node = NodeName(consumer->input(1));
+  fused_nodes.insert(consumer->name());
+  tensor = strings::StrCat(consumer->name(), ":output:0");
+  consumer = GetSoleConsumer(*consumer, tensor, function);
+
+  if (consumer == nullptr || consumer->op() != "ResizeBilinear" ||
+      consumer->input(0) != tensor) {
+    return false;
+  }
+  const NodeDef& resize = *consumer;
+  fused_nodes.insert(resize.name());
+  tensor = strings::StrCat(resize.name(), ":resized_images:0");
+  consumer = GetSoleConsumer(resize, tensor, function);
+
+  if (consumer == nullptr || consumer->op() != "Squeeze" ||
+      consumer->input(0) != tensor) {
+    return false;
+  }
+  auto squeeze_dims = consumer->attr().find("squeeze_dims");
+  if (squeeze_dims == consumer->attr().end() ||
+      squeeze_dims->second.list().i_size() != 1 ||
+      squeeze_dims->second.list().i(0) != 0) {
+    return false;
+  }
+  fused_nodes.insert(consumer->name());
+  tensor = strings::StrCat(consumer->name(), ":output:0");
+
+  // The normalization is optional, and has to be applied to the whole image.
+  string offset;
+  consumer = GetSoleConsumer(*consumer, tensor, function);
+  if (consumer != nullptr && consumer->op() == "Sub" &&
+      consumer->input(0) == tensor &&
+      IsPerChannelConst(consumer->input(1), *function)) {
+    offset = consumer->input(1);
+    fused_nodes.insert(consumer->name());
+    tensor = strings::StrCat(consumer->name(), ":z:0");
+    consumer = GetSoleConsumer(*consumer, tensor, function);
+  }
+  string scale;
+  if (consumer != nullptr && consumer->op() == "Mul") {
+    const string& other = consumer->input(0) == tensor ? consumer->input(1)
+                                                       : consumer->input(0);
+    if (IsPerChannelConst(other, *function)) {
+      scale = other;
+      fused_nodes.insert(consumer->name());
+      tensor = strings::StrCat(consumer->name(), ":z:0");
+    }
+  }
+
+  if (offset.empty()) offset = AddFloatConst("fused_offset", 0.0f, function);
+  if (scale.empty()) scale = AddFloatConst("fused_scale", 1.0f, function);
+  NodeDef* fused = function_utils::AddNode(
+      "", kFusedOp, {decode.input(0), decode.input(1), resize.input(1), offset,
+                     scale},
+      {}, function);
+  function_utils::SetUniqueFunctionNodeName("decode_and_crop_resize_jpeg",
+                                            function, fused);
+  fused->set_device(decode.device());
+  for (const char* attr : kDecodeAttrs) {
+    auto it = decode.attr().find(attr);
+    if (it != decode.attr().end()) (*fused->mutable_attr())[attr] = it->second;
+  }
+  auto align_corners = resize.attr().find("align_corners");
+  if (align_corners != resize.attr().end()) {
+    (*fused->mutable_attr())["align_corners"] = align_corners->second;
+  }
+  function_utils::ReplaceReferences(
+      tensor, strings::StrCat(fused->name(), ":image:0"), function);
+
+  // The axis of the ExpandDims is usually not needed anymore either.
+  auto* nodes = function->mutable_node_def();
+  nodes->erase(std::remove_if(nodes->begin(), nodes->end(),
+                              [&fused_nodes](const NodeDef& node) {
+                                return fused_nodes.count(node.name()) > 0;
+                              }),
+               nodes->end());
+  if (!IsReferenced(axis_node, *function)) {
+    const int index =
+        function_utils::FindFunctionNodeWithName(axis_node, *function);
+    if (index != -1) nodes->erase(nodes->begin() + index);
+  }
+  return true;
+}
+
+// Fuses all the matching chains in `function`. Returns whether any matched.
+bool FuseInFunction(FunctionDef* function) {
+  std::vector<string> decode_nodes;
+  for (const NodeDef& node : function->node_def()) {
+    if (node.op() == "DecodeAndCropJpeg") decode_nodes.push_back(node.name());
+  }
+  bool changed = false;
+  for (const string& name : decode_nodes) {
+    if (FuseDecodeAndResize(name, function)) changed = true;
+  }
+  return changed;
+}
+
+}  // namespace
+
+Status DecodeAndResizeFusion::Optimize(Cluster* cluster,
+                                       const GrapplerItem& item,
+                                       GraphDef* output) {
+  *output = item.graph;
+  FunctionLibraryDefinition function_library(OpRegistry::Global(),
+                                             item.graph.library());
+
+  for (NodeDef& node : *output->mutable_node()) {
+    if (!IsMapLike(node)) continue;
+    const FunctionDef* func =
+        function_library.Find(node.attr().at("f").func().name());
+    if (func == nullptr) continue;
+
+    // The function may be used by other nodes, so the rewrite is done on a
+    // copy.
+    FunctionDef fused_func = *func;
+    if (!FuseInFunction(&fused_func)) continue;
+    FunctionDef* new_func = output->mutable_library()->add_function();
+    *new_func = std::move(fused_func);
+    graph_utils::SetUniqueGraphFunctionName("decode_and_resize_fusion",
+                                            output->mutable_library(),
+                                            new_func);
+    (*node.mutable_attr())["f"].mutable_func()->set_name(
+        new_func->signature().name());
+  }
+  return Status::OK();
+}
+
+void DecodeAndResizeFusion::Feedback(Cluster* cluster,
+                                     const GrapplerItem& item,
+                                     const GraphDef& optimize_output,
+                                     double result) {
+  // no-op
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(DecodeAndResizeFusion, "decode_and_resize_fusion");
+
+}  // end namespace grappler
+}  // end namespace tensorflow
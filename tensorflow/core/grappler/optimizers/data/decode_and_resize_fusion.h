@@ -0,0 +1,58 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_DECODE_AND_RESIZE_FUSION_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_DECODE_AND_RESIZE_FUSION_H_
+
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// This optimization rewrites the common image preprocessing pattern
+//
+//   image = tf.image.decode_and_crop_jpeg(contents, crop_window)
+//   image = tf.cast(image, tf.float32)  # optional
+//   image = tf.image.resize_bilinear(tf.expand_dims(image, 0), size)
+//   image = tf.squeeze(image, [0])
+//   image = (image - offset) * scale  # both optional
+//
+// in the functions of map-like datasets into a single
+// `_DecodeAndCropResizeJpeg` op, which doesn't materialize the intermediate
+// images and lets libjpeg decode large crops at a reduced scale. Functions
+// shared with other nodes are copied before being rewritten.
+class DecodeAndResizeFusion : public CustomGraphOptimizer {
+ public:
+  DecodeAndResizeFusion() = default;
+  ~DecodeAndResizeFusion() override = default;
+
+  string name() const override { return "decode_and_resize_fusion"; };
+
+  Status Init(
+      const tensorflow::RewriterConfig_CustomGraphOptimizer* config) override {
+    return Status::OK();
+  }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* output) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimize_output, double result) override;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_DECODE_AND_RESIZE_FUSION_H_
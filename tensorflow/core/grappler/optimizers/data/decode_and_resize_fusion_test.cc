@@ -0,0 +1,195 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/decode_and_resize_fusion.h"
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/data/function_utils.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_test_utils.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::GDef;
+using test::function::NDef;
+
+// Returns a function decoding, cropping and resizing an image to 32x32, which
+// then computes `image - 127.0` and multiplies the result with `scale`.
+FunctionDef PreprocessImage(const string& scale) {
+  return FunctionDefHelper::Create(
+      "PreprocessImage", {"contents: string", "scale: float"},
+      {"image: float"}, {},
+      {{{"crop_window"},
+        "Const",
+        {},
+        {{"value", test::AsTensor<int32>({0, 0, 64, 64})},
+         {"dtype", DT_INT32}}},
+       {{"decode"},
+        "DecodeAndCropJpeg",
+        {"contents", "crop_window:output:0"},
+        {{"channels", 3}}},
+       {{"cast"},
+        "Cast",
+        {"decode:image:0"},
+        {{"SrcT", DT_UINT8}, {"DstT", DT_FLOAT}}},
+       {{"axis"}, "Const", {}, {{"value", 0}, {"dtype", DT_INT32}}},
+       {{"expand"},
+        "ExpandDims",
+        {"cast:y:0", "axis:output:0"},
+        {{"T", DT_FLOAT}, {"Tdim", DT_INT32}}},
+       {{"size"},
+        "Const",
+        {},
+        {{"value", test::AsTensor<int32>({32, 32})}, {"dtype", DT_INT32}}},
+       {{"resize"},
+        "ResizeBilinear",
+        {"expand:output:0", "size:output:0"},
+        {{"T", DT_FLOAT}, {"align_corners", true}}},
+       {{"squeeze"},
+        "Squeeze",
+        {"resize:resized_images:0"},
+        {{"T", DT_FLOAT}, {"squeeze_dims", gtl::ArraySlice<int>{0}}}},
+       {{"offset"}, "Const", {}, {{"value", 127.0f}, {"dtype", DT_FLOAT}}},
+       {{"sub"},
+        "Sub",
+        {"squeeze:output:0", "offset:output:0"},
+        {{"T", DT_FLOAT}}},
+       {{"half"}, "Const", {}, {{"value", 0.5f}, {"dtype", DT_FLOAT}}},
+       {{"mul"}, "Mul", {scale, "sub:z:0"}, {{"T", DT_FLOAT}}}},
+      {{"image", "mul:z:0"}});
+}
+
+GrapplerItem MakeItem(const FunctionDef& function) {
+  GrapplerItem item;
+  item.graph = GDef(
+      {NDef("start", "Const", {}, {{"value", 0}, {"dtype", DT_INT32}}),
+       NDef("stop", "Const", {}, {{"value", 10}, {"dtype", DT_INT32}}),
+       NDef("step", "Const", {}, {{"value", 1}, {"dtype", DT_INT32}}),
+       NDef("range", "RangeDataset", {"start", "stop", "step"},
+            {{"output_shapes", gtl::ArraySlice<TensorShape>{}},
+             {"output_types", gtl::ArraySlice<DataType>{}}}),
+       graph_tests_utils::MakeMapNode("map", "range", "PreprocessImage")},
+      {function});
+  return item;
+}
+
+TEST(DecodeAndResizeFusionTest, FusesWholeChain) {
+  GrapplerItem item = MakeItem(PreprocessImage("half:output:0"));
+  DecodeAndResizeFusion optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // The map uses a rewritten copy of the function.
+  ASSERT_EQ(2, output.library().function_size());
+  const NodeDef& map_node =
+      output.node(graph_utils::FindGraphNodeWithName("map", output));
+  const string& fused_name = map_node.attr().at("f").func().name();
+  EXPECT_NE("PreprocessImage", fused_name);
+  const FunctionDef& function = output.library().function(
+      graph_utils::FindGraphFunctionWithName(fused_name, output.library()));
+
+  for (const char* op :
+       {"DecodeAndCropJpeg", "Cast", "ExpandDims", "ResizeBilinear", "Squeeze",
+        "Sub", "Mul"}) {
+    EXPECT_FALSE(function_utils::ContainsFunctionNodeWithOp(op, function))
+        << op;
+  }
+  EXPECT_FALSE(function_utils::ContainsFunctionNodeWithName("axis", function));
+  const int fused_index =
+      function_utils::FindFunctionNodeWithOp("_DecodeAndCropResizeJpeg",
+                                             function);
+  ASSERT_NE(-1, fused_index);
+  const NodeDef& fused = function.node_def(fused_index);
+  ASSERT_EQ(5, fused.input_size());
+  EXPECT_EQ("contents", fused.input(0));
+  EXPECT_EQ("crop_window:output:0", fused.input(1));
+  EXPECT_EQ("size:output:0", fused.input(2));
+  EXPECT_EQ("offset:output:0", fused.input(3));
+  EXPECT_EQ("half:output:0", fused.input(4));
+  EXPECT_EQ(3, fused.attr().at("channels").i());
+  EXPECT_TRUE(fused.attr().at("align_corners").b());
+  EXPECT_EQ(strings::StrCat(fused.name(), ":image:0"),
+            function.ret().at("image"));
+}
+
+TEST(DecodeAndResizeFusionTest, LeavesNonConstantScale) {
+  // The scale is a function argument, so only the steps up to and including
+  // the offset are fused.
+  GrapplerItem item = MakeItem(PreprocessImage("scale"));
+  DecodeAndResizeFusion optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  ASSERT_EQ(2, output.library().function_size());
+  const FunctionDef& function = output.library().function(1);
+  EXPECT_TRUE(function_utils::ContainsFunctionNodeWithOp("Mul", function));
+  EXPECT_FALSE(function_utils::ContainsFunctionNodeWithOp("Sub", function));
+  const NodeDef& fused =
+      function.node_def(function_utils::FindFunctionNodeWithOp(
+          "_DecodeAndCropResizeJpeg", function));
+  const NodeDef& mul = function.node_def(
+      function_utils::FindFunctionNodeWithOp("Mul", function));
+  EXPECT_EQ(strings::StrCat(fused.name(), ":image:0"), mul.input(1));
+  EXPECT_EQ("offset:output:0", fused.input(3));
+  EXPECT_EQ("fused_scale:output:0", fused.input(4));
+}
+
+TEST(DecodeAndResizeFusionTest, KeepsIntermediateWithOtherConsumers) {
+  FunctionDef function = PreprocessImage("half:output:0");
+  // The resized image is also returned, so it can't be fused away.
+  function.mutable_signature()->add_output_arg()->set_name("resized");
+  function.mutable_signature()->mutable_output_arg(1)->set_type(DT_FLOAT);
+  (*function.mutable_ret())["resized"] = "squeeze:output:0";
+  GrapplerItem item = MakeItem(function);
+
+  DecodeAndResizeFusion optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  ASSERT_EQ(2, output.library().function_size());
+  const FunctionDef& fused_function = output.library().function(1);
+  EXPECT_TRUE(
+      function_utils::ContainsFunctionNodeWithOp("Sub", fused_function));
+  EXPECT_TRUE(function_utils::ContainsFunctionNodeWithOp(
+      "_DecodeAndCropResizeJpeg", fused_function));
+}
+
+TEST(DecodeAndResizeFusionTest, SkipsReducedRatio) {
+  FunctionDef function = PreprocessImage("half:output:0");
+  NodeDef* decode = function.mutable_node_def(
+      function_utils::FindFunctionNodeWithName("decode", function));
+  SetAttrValue(2, &(*decode->mutable_attr())["ratio"]);
+  GrapplerItem item = MakeItem(function);
+
+  DecodeAndResizeFusion optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(1, output.library().function_size());
+  const NodeDef& map_node =
+      output.node(graph_utils::FindGraphNodeWithName("map", output));
+  EXPECT_EQ("PreprocessImage", map_node.attr().at("f").func().name());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
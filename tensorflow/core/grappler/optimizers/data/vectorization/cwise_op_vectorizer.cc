@@ -208,6 +208,18 @@ REGISTER_VECTORIZER("Square", CwiseOpVectorizer);
 REGISTER_VECTORIZER("Tanh", CwiseOpVectorizer);
 REGISTER_VECTORIZER("Tan", CwiseOpVectorizer);
 
+// String unary
+REGISTER_VECTORIZER("AsString", CwiseOpVectorizer);
+REGISTER_VECTORIZER("DecodeBase64", CwiseOpVectorizer);
+REGISTER_VECTORIZER("EncodeBase64", CwiseOpVectorizer);
+REGISTER_VECTORIZER("StaticRegexReplace", CwiseOpVectorizer);
+REGISTER_VECTORIZER("StringLength", CwiseOpVectorizer);
+REGISTER_VECTORIZER("StringStrip", CwiseOpVectorizer);
+REGISTER_VECTORIZER("StringToHashBucket", CwiseOpVectorizer);
+REGISTER_VECTORIZER("StringToHashBucketFast", CwiseOpVectorizer);
+REGISTER_VECTORIZER("StringToHashBucketStrong", CwiseOpVectorizer);
+REGISTER_VECTORIZER("StringToNumber", CwiseOpVectorizer);
+
 // Bitwise binary
 REGISTER_VECTORIZER("BitwiseAnd", CwiseOpVectorizer);
 REGISTER_VECTORIZER("BitwiseOr", CwiseOpVectorizer);
@@ -0,0 +1,77 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/framework/scope_internal.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+const char* const kExpandDimsPrefix = "vectorized/expand_dims";
+
+class ExpandDimsVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   std::vector<WrappedTensor>&& inputs,
+                   std::vector<WrappedTensor>* outputs) override {
+    if (!inputs[0].stacked || inputs[1].stacked) {
+      return errors::InvalidArgument(
+          "Expecting input 0 (`input`) to be stacked and input 1 (`axis`) to "
+          "be unstacked.");
+    }
+    DataType axis_type;
+    TF_RETURN_IF_ERROR(GetNodeAttr(node.attrs(), "Tdim", &axis_type));
+
+    Status status;
+    Scope parent = NewInternalScope(outer_scope, &status, nullptr);
+    Scope s = parent.NewSubScope(kExpandDimsPrefix);
+
+    // Since the vectorized input has an extra leading dimension, non-negative
+    // axis values need to be incremented by 1. Negative values wrap around.
+    Output axis = {inputs[1].node, inputs[1].output_index};
+    Output zero = ops::Cast(s, ops::Const(s, 0), axis_type);
+    Output one = ops::Cast(s, ops::Const(s, 1), axis_type);
+    Output vectorized_axis = ops::Where3(s, ops::GreaterEqual(s, axis, zero),
+                                         ops::Add(s, axis, one), axis);
+    TF_RETURN_IF_ERROR(status);
+
+    Node* new_node;
+    TF_RETURN_IF_ERROR(
+        NodeBuilder(strings::StrCat("vectorized/", node.name()), "ExpandDims")
+            .Input(inputs[0].node, inputs[0].output_index)
+            .Input(vectorized_axis.node(), vectorized_axis.index())
+            .Attr("T", node.def().attr().at("T"))
+            .Attr("Tdim", axis_type)
+            .Finalize(outer_scope, &new_node));
+
+    // Add output mappings
+    outputs->push_back({new_node, 0, true});
+    return Status::OK();
+  }
+};
+
+REGISTER_VECTORIZER("ExpandDims", ExpandDimsVectorizer);
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,153 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/framework/scope_internal.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+const char* const kResizePrefix = "vectorized/resize";
+
+// Returns an error unless the first input is the only stacked one.
+Status CheckOnlyImagesStacked(const std::vector<WrappedTensor>& inputs) {
+  if (!inputs[0].stacked) {
+    return errors::InvalidArgument(
+        "Expecting input 0 (`images`) to be stacked.");
+  }
+  for (size_t i = 1; i < inputs.size(); ++i) {
+    if (inputs[i].stacked) {
+      return errors::InvalidArgument("Expecting input ", i,
+                                     " to be unstacked.");
+    }
+  }
+  return Status::OK();
+}
+
+// Adds a node with the same op type and attrs as `node` to `outer_scope`,
+// reading the given inputs.
+Status AddNodeLike(const Node& node, Graph* outer_scope, const string& name,
+                   const std::vector<Output>& inputs, Node** new_node) {
+  auto node_builder = NodeBuilder(name, node.type_string());
+  for (const auto& input : inputs) {
+    node_builder = node_builder.Input(input.node(), input.index());
+  }
+  for (const auto& attr_slice : node.attrs()) {
+    node_builder = node_builder.Attr(attr_slice.first, attr_slice.second);
+  }
+  return node_builder.Finalize(outer_scope, new_node);
+}
+
+// Vectorizer for the image ops that adjust each pixel, or each image, in a
+// tensor of any rank: the leading dimension of the stacked images is just one
+// more batch dimension to them.
+class ImageAdjustmentVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   std::vector<WrappedTensor>&& inputs,
+                   std::vector<WrappedTensor>* outputs) override {
+    TF_RETURN_IF_ERROR(CheckOnlyImagesStacked(inputs));
+    std::vector<Output> new_inputs;
+    for (const auto& input : inputs) {
+      new_inputs.emplace_back(input.node, input.output_index);
+    }
+    Node* new_node;
+    TF_RETURN_IF_ERROR(AddNodeLike(node, outer_scope,
+                                   strings::StrCat("vectorized/", node.name()),
+                                   new_inputs, &new_node));
+
+    // Add output mappings
+    outputs->push_back({new_node, 0, true});
+    return Status::OK();
+  }
+};
+
+// Vectorizer for the resize ops, which take a 4-D batch of images. The
+// stacked batches of shape [n, batch, height, width, channels] are merged into
+// a single batch of n * batch images, which is resized at once and split back
+// into n batches.
+class ImageResizeVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   std::vector<WrappedTensor>&& inputs,
+                   std::vector<WrappedTensor>* outputs) override {
+    if (inputs.size() != 2) {
+      return errors::Internal("Resize op should have two inputs.");
+    }
+    TF_RETURN_IF_ERROR(CheckOnlyImagesStacked(inputs));
+
+    Status status;
+    Scope parent = NewInternalScope(outer_scope, &status, nullptr);
+    Scope s = parent.NewSubScope(kResizePrefix);
+
+    Output images = {inputs[0].node, inputs[0].output_index};
+    Output size = {inputs[1].node, inputs[1].output_index};
+    Output const_vec_0 = ops::Const(s, {0});
+    Output const_vec_1 = ops::Const(s, {1});
+    Output const_vec_2 = ops::Const(s, {2});
+    Output shape = ops::Shape(s, images);
+
+    // tf.reshape(images, tf.concat([[-1], shape[2:]], 0))
+    Output image_shape =
+        ops::StridedSlice(s, shape, const_vec_2, const_vec_0, const_vec_1,
+                          ops::StridedSlice::Attrs().EndMask(1));
+    Output merged = ops::Reshape(
+        s, images,
+        ops::Concat(s, {ops::Const(s, {-1}), image_shape}, ops::Const(s, 0)));
+    TF_RETURN_IF_ERROR(status);
+
+    Node* resize_node;
+    TF_RETURN_IF_ERROR(AddNodeLike(node, outer_scope,
+                                   strings::StrCat("vectorized/", node.name()),
+                                   {merged, size}, &resize_node));
+    Output resized(resize_node, 0);
+
+    // tf.reshape(resized, tf.concat([shape[:2], tf.shape(resized)[1:]], 0))
+    Output batch_shape =
+        ops::StridedSlice(s, shape, const_vec_0, const_vec_2, const_vec_1);
+    Output resized_image_shape =
+        ops::StridedSlice(s, ops::Shape(s, resized), const_vec_1, const_vec_0,
+                          const_vec_1, ops::StridedSlice::Attrs().EndMask(1));
+    Output split = ops::Reshape(
+        s, resized,
+        ops::Concat(s, {batch_shape, resized_image_shape}, ops::Const(s, 0)));
+    TF_RETURN_IF_ERROR(status);
+
+    // Add output mappings
+    outputs->push_back({split.node(), 0, true});
+    return Status::OK();
+  }
+};
+
+REGISTER_VECTORIZER("AdjustContrastv2", ImageAdjustmentVectorizer);
+REGISTER_VECTORIZER("AdjustHue", ImageAdjustmentVectorizer);
+REGISTER_VECTORIZER("AdjustSaturation", ImageAdjustmentVectorizer);
+REGISTER_VECTORIZER("HSVToRGB", ImageAdjustmentVectorizer);
+REGISTER_VECTORIZER("RGBToHSV", ImageAdjustmentVectorizer);
+
+REGISTER_VECTORIZER("ResizeArea", ImageResizeVectorizer);
+REGISTER_VECTORIZER("ResizeBicubic", ImageResizeVectorizer);
+REGISTER_VECTORIZER("ResizeBilinear", ImageResizeVectorizer);
+REGISTER_VECTORIZER("ResizeNearestNeighbor", ImageResizeVectorizer);
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,70 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class SqueezeVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   std::vector<WrappedTensor>&& inputs,
+                   std::vector<WrappedTensor>* outputs) override {
+    Status s;
+    if (node.num_inputs() != 1 || inputs.size() != 1) {
+      return errors::Internal("Squeeze op should only have one input.");
+    }
+
+    std::vector<int32> squeeze_dims;
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(node.attrs(), "squeeze_dims", &squeeze_dims));
+    if (squeeze_dims.empty()) {
+      // Squeezing all the dimensions of size 1 would also squeeze the
+      // leading dimension of a batch of size 1.
+      return errors::InvalidArgument(
+          "Squeeze op can only be vectorized with explicit `squeeze_dims`.");
+    }
+    for (int32& dim : squeeze_dims) {
+      // Since the vectorized input has an extra leading dimension, we need
+      // to increment non-negative dimensions by 1. Negative values wrap
+      // around.
+      if (dim >= 0) {
+        dim += 1;
+      }
+    }
+
+    // Add new Squeeze node with the same op and attrs as the original node
+    auto new_squeeze_node = outer_scope->AddNode(node.def(), &s);
+    TF_RETURN_IF_ERROR(s);
+    new_squeeze_node->AddAttr("squeeze_dims", squeeze_dims);
+
+    outer_scope->AddEdge(inputs[0].node, inputs[0].output_index,
+                         new_squeeze_node, 0);
+
+    // Add output mappings
+    outputs->push_back({new_squeeze_node, 0, true});
+    return Status::OK();
+  }
+};
+
+REGISTER_VECTORIZER("Squeeze", SqueezeVectorizer);
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
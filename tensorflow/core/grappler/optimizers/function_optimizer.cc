@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/function_optimizer.h"
 
+#include <deque>
 #include <unordered_map>
 
 #include "absl/strings/str_replace.h"
@@ -430,6 +431,68 @@ bool HasUnusedOutputs(const NodeDef& func_node, const FunctionDef& func,
   return active_outputs.size() != num_outputs;
 }
 
+// Maps the name of each function in `flib` whose definition is identical,
+// except for its name, to an earlier function with the same gradient, to the
+// name of that function. Such duplicates are common when the same Python
+// function is traced several times.
+gtl::FlatMap<string, string> FindDuplicateFunctions(
+    const FunctionLibraryDefinition& flib, const FunctionDefLibrary& library) {
+  gtl::FlatMap<string, string> duplicates;
+
+  // Definitions with their names cleared, bucketed by hash, of the functions
+  // that are not duplicates themselves.
+  std::deque<std::pair<string, FunctionDef>> unique_functions;
+  std::unordered_map<uint64, std::vector<const std::pair<string, FunctionDef>*>>
+      buckets;
+
+  for (const FunctionDef& func : library.function()) {
+    const string& name = func.signature().name();
+    FunctionDef anonymous = func;
+    anonymous.mutable_signature()->clear_name();
+    const uint64 hash = FunctionDefHash(anonymous);
+
+    bool is_duplicate = false;
+    for (const auto* unique_function : buckets[hash]) {
+      if (flib.FindGradient(unique_function->first) ==
+              flib.FindGradient(name) &&
+          FunctionDefsEqual(unique_function->second, anonymous)) {
+        duplicates[name] = unique_function->first;
+        is_duplicate = true;
+        break;
+      }
+    }
+    if (!is_duplicate) {
+      unique_functions.emplace_back(name, std::move(anonymous));
+      buckets[hash].push_back(&unique_functions.back());
+    }
+  }
+  return duplicates;
+}
+
+// Redirects the function calls and function attributes of the nodes of
+// `graph` that refer to a function in `duplicates` to their identical
+// function. Returns true if any node was updated.
+bool RedirectDuplicateFunctionCalls(
+    const gtl::FlatMap<string, string>& duplicates, GraphDef* graph) {
+  bool updated = false;
+  for (NodeDef& node : *graph->mutable_node()) {
+    auto it = duplicates.find(node.op());
+    if (it != duplicates.end()) {
+      node.set_op(it->second);
+      updated = true;
+    }
+    for (auto& attr : *node.mutable_attr()) {
+      if (!attr.second.has_func()) continue;
+      it = duplicates.find(attr.second.func().name());
+      if (it != duplicates.end()) {
+        attr.second.mutable_func()->set_name(it->second);
+        updated = true;
+      }
+    }
+  }
+  return updated;
+}
+
 // Return pruned FunctionDefLibrary with functions that are reachable from
 // the optimized graph.
 FunctionDefLibrary PruneFunctionLibrary(const FunctionLibraryDefinition& flib,
@@ -1006,6 +1069,29 @@ Status FunctionOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     return Status::OK();
   }
 
+  // Call functions that only differ by their names through a single one of
+  // them, so that they share specializations and the other ones get pruned.
+  std::unique_ptr<GrapplerItem> deduplicated_item;
+  if (options_.enable_function_deduplication) {
+    const FunctionLibraryDefinition flib(OpRegistry::Global(),
+                                         item.graph.library());
+    const gtl::FlatMap<string, string> duplicates =
+        FindDuplicateFunctions(flib, item.graph.library());
+    GraphDef deduplicated_graph = item.graph;
+    if (!duplicates.empty() &&
+        RedirectDuplicateFunctionCalls(duplicates, &deduplicated_graph)) {
+      VLOG(2) << "Redirect calls to " << duplicates.size()
+              << " duplicate functions";
+      deduplicated_item.reset(
+          new GrapplerItem(item, std::move(deduplicated_graph)));
+    }
+  }
+  return OptimizeFunctionCalls(deduplicated_item ? *deduplicated_item : item,
+                               optimized_graph);
+}
+
+Status FunctionOptimizer::OptimizeFunctionCalls(const GrapplerItem& item,
+                                                GraphDef* optimized_graph) {
   FunctionOptimizerContext ctx(opt_level_, item);
 
   bool inline_gradients = options_.enable_symbolic_gradient_inlining;
@@ -44,10 +44,15 @@ class FunctionOptimizer : public GraphOptimizer {
   struct FunctionOptimizerOptions {
     bool enable_function_inlining = true;
     bool enable_function_specialization = true;
+    bool enable_function_deduplication = true;
     bool enable_symbolic_gradient_inlining = true;
     bool enable_trim_function_library = true;
   };
 
+  // Inlines and specializes the function calls of `item`.
+  Status OptimizeFunctionCalls(const GrapplerItem& item,
+                               GraphDef* optimized_graph);
+
   RewriterConfig::Toggle opt_level_;
   FunctionOptimizerOptions options_;
 };
@@ -1076,6 +1076,60 @@ TEST_F(FunctionOptimizerTest, SpecializeFunction_OncePerUniqueContext) {
   test::ExpectTensorEqual<float>(tensors_expected[5], tensors[5]);
 }
 
+TEST_F(FunctionOptimizerTest, SpecializeFunction_MergesDuplicateFunctions) {
+  using test::function::NDef;
+
+  FunctionOptimizer optimizer(RewriterConfig::DEFAULT);
+
+  // Two noinline functions that only differ by their names.
+  FunctionDef mul_func = FunctionDefHelper::Create(
+      "MyMul", {"x:T", "y:T"}, {"z:T"}, {"T: {float, int32}"},
+      {{{"output"}, "Mul", {"x", "y"}, {{"T", "$T"}}}},
+      /* Mapping between function returns and function node outputs. */
+      {{"z", "output:z:0"}});
+  (*mul_func.mutable_attr())["_noinline"].set_b(true);
+  FunctionDef mul_copy_func = mul_func;
+  mul_copy_func.mutable_signature()->set_name("MyMulCopy");
+  std::vector<FunctionDef> function_library = {mul_func, mul_copy_func};
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+       NDef("y", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+       NDef("mul_1", "MyMul", {"x", "y"}, {{"T", DT_FLOAT}}, kDevice),
+       NDef("mul_2", "MyMulCopy", {"y", "x"}, {{"T", DT_FLOAT}}, kDevice)},
+      function_library);
+  item.fetch = {"mul_1", "mul_2"};
+
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // Both calls share a single specialization of MyMul.
+  ASSERT_EQ(1, output.library().function_size());
+  EXPECT_EQ("MyMul_specialized_for_mul_1_at_tf_graph",
+            output.library().function(0).signature().name());
+
+  int count = 0;
+  for (const NodeDef& node : output.node()) {
+    if ((node.name() == "mul_1" || node.name() == "mul_2") && ++count) {
+      EXPECT_EQ("MyMul_specialized_for_mul_1_at_tf_graph", node.op());
+    }
+  }
+  EXPECT_EQ(2, count);
+
+  Tensor pi = test::AsScalar<float>(3.14f);
+  Tensor two = test::AsScalar<float>(2.0f);
+  item.feed = {{"x", pi}, {"y", two}};
+
+  auto tensors_expected = EvaluateFetchNodes(item);
+  GrapplerItem optimized(item, std::move(output));
+  auto tensors = EvaluateFetchNodes(optimized);
+
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+  test::ExpectTensorEqual<float>(tensors_expected[1], tensors[1]);
+}
+
 TEST_F(FunctionOptimizerTest, SpecializeFunctionForUsedOutputTensors) {
   using test::function::NDef;
 
@@ -14,6 +14,12 @@ limitations under the License.
 ==============================================================================*/
 
 // Op kernels used to swap data in and out of GPU memory.
+//
+// The copies go through the device context of the op, which issues them on
+// the device_to_host and host_to_device streams of the GPU rather than on its
+// compute stream, so that they overlap with the computation. Swapped out
+// tensors are allocated in pinned host memory from the GPU-compatible host
+// allocator, which the asynchronous copies require.
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -23,9 +23,11 @@ limitations under the License.
 
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/tensor.pb.h"  // NOLINT
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/grappler/costs/graph_memory.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
@@ -919,6 +921,56 @@ static bool IsSwappable(GraphView::InputPort input) {
   return !IsRefType(dtype);
 }
 
+// Simulates the execution of `item` on a virtual copy of `cluster` and records
+// the completion time of each node, and if `op_compute_costs` is not null the
+// estimated time it takes to run.
+static bool SimulateExecution(
+    Cluster* cluster, const GrapplerItem& item,
+    std::unordered_map<string, Costs::NanoSeconds>* op_completion_times,
+    std::unordered_map<string, Costs::NanoSeconds>* op_compute_costs) {
+  VirtualCluster vcluster(cluster->GetDevices());
+  if (!vcluster.Provision().ok()) {
+    return false;
+  }
+  if (!vcluster.Initialize(item).ok()) {
+    return false;
+  }
+  RunMetadata metadata;
+  Status s = vcluster.Run(item.graph, item.feed, item.fetch, &metadata);
+  if (!s.ok() && s.code() != error::RESOURCE_EXHAUSTED) {
+    return false;
+  }
+
+  for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      Costs::NanoSeconds exec_time =
+          Costs::NanoSeconds(1) +
+          Costs::MicroSeconds(node_stats.all_start_micros() +
+                              node_stats.op_end_rel_micros());
+      op_completion_times->emplace(node_stats.node_name(), exec_time);
+      if (op_compute_costs != nullptr) {
+        op_compute_costs->emplace(
+            node_stats.node_name(),
+            Costs::MicroSeconds(node_stats.op_end_rel_micros() -
+                                node_stats.op_start_rel_micros()));
+      }
+    }
+  }
+  return true;
+}
+
+// Returns the time at which the peak memory usage `mem_usage` is reached, that
+// is the time of the last allocation among the tensors live at the peak.
+static Costs::Duration PeakTime(const GraphMemory::MemoryUsage& mem_usage) {
+  Costs::Duration peak_time = -1;
+  for (const auto& live_tensor : mem_usage.live_tensors) {
+    if (live_tensor.allocation_time > peak_time) {
+      peak_time = live_tensor.allocation_time;
+    }
+  }
+  return peak_time;
+}
+
 struct MemInfo {
   GraphView::OutputPort port;
   int64 memory_used;
@@ -959,37 +1011,11 @@ static bool IdentifySwappingCandidates(
     int64 required_savings = mem_usage.used_memory - prop.memory_size();
 
     std::unordered_map<string, Costs::NanoSeconds> op_completion_times;
-    {
-      VirtualCluster vcluster(cluster->GetDevices());
-      if (!vcluster.Provision().ok()) {
-        return false;
-      }
-      if (!vcluster.Initialize(*item).ok()) {
-        return false;
-      }
-      RunMetadata metadata;
-      Status s = vcluster.Run(item->graph, item->feed, item->fetch, &metadata);
-      if (!s.ok() && s.code() != error::RESOURCE_EXHAUSTED) {
-        return false;
-      }
-
-      for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
-        for (const auto& node_stats : dev_stats.node_stats()) {
-          Costs::NanoSeconds exec_time =
-              Costs::NanoSeconds(1) +
-              Costs::MicroSeconds(node_stats.all_start_micros() +
-                                  node_stats.op_end_rel_micros());
-          op_completion_times.emplace(node_stats.node_name(), exec_time);
-        }
-      }
+    if (!SimulateExecution(cluster, *item, &op_completion_times, nullptr)) {
+      return false;
     }
 
-    Costs::Duration peak_time = -1;
-    for (const auto& live_tensor : mem_usage.live_tensors) {
-      if (live_tensor.allocation_time > peak_time) {
-        peak_time = live_tensor.allocation_time;
-      }
-    }
+    const Costs::Duration peak_time = PeakTime(mem_usage);
 
     std::vector<MemInfo> mem_state;
 
@@ -1092,6 +1118,40 @@ static bool IdentifySwappingCandidates(
   return updated_graph;
 }
 
+// All the swap-ins of a GPU are issued on its host_to_device stream, so they
+// run one after the other rather than concurrently. Walks the swap-ins of each
+// device from the last one needed to the first, and extends the time budgeted
+// for each so that it completes before the next one starts: the earlier
+// swap-ins are then triggered sooner, and the transfers stay hidden behind
+// the compute instead of queuing up right before their consumers.
+static void ScheduleSwapInsOnCopyStreams(
+    const std::unordered_map<const NodeDef*, Costs::NanoSeconds>&
+        execution_times,
+    std::unordered_map<NodeDef*, SwapInfo>* nodes_to_swap) {
+  typedef std::pair<Costs::NanoSeconds, SwapInfo*> SwapIn;
+  std::unordered_map<string, std::vector<SwapIn>> swap_ins;
+  for (auto& swap : *nodes_to_swap) {
+    auto it = execution_times.find(swap.first);
+    if (it != execution_times.end()) {
+      swap_ins[swap.first->device()].emplace_back(it->second, &swap.second);
+    }
+  }
+  for (auto& device : swap_ins) {
+    std::vector<SwapIn>& swaps = device.second;
+    std::sort(
+        swaps.begin(), swaps.end(),
+        [](const SwapIn& a, const SwapIn& b) { return a.first > b.first; });
+    Costs::NanoSeconds stream_available = Costs::NanoSeconds::infinity();
+    for (SwapIn& swap : swaps) {
+      const Costs::NanoSeconds deadline =
+          std::min(swap.first, stream_available);
+      const Costs::NanoSeconds start = deadline - swap.second->time_to_swap;
+      swap.second->time_to_swap = swap.first - start;
+      stream_available = start;
+    }
+  }
+}
+
 bool SwappingPass(RewriterConfig::MemOptType optimization_level,
                   Cluster* cluster, GrapplerItem* item,
                   std::unordered_set<string>* skip_list) {
@@ -1145,6 +1205,7 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
   if (!EstimateEarliestExecutionTimes(*item, cluster, &execution_times).ok()) {
     return false;
   }
+  ScheduleSwapInsOnCopyStreams(execution_times, &nodes_to_swap);
 
   std::unordered_map<string, const NodeDef*> name_map;
   for (const auto& node : item->graph.node()) {
@@ -1206,7 +1267,322 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
       // Make sure we won't try to swap the swap nodes in subsequent passes.
       skip_list->insert(swap_nodes.first->name());
       skip_list->insert(swap_nodes.second->name());
+      updated_graph = true;
+    }
+  }
+  return updated_graph;
+}
+
+// A node whose outputs, live at the peak memory usage of its device, are
+// recomputed for their uses after the peak instead of being kept.
+struct RecomputeCandidate {
+  NodeDef* node = nullptr;
+  // Bytes no longer live at the peak.
+  int64 memory_saved = 0;
+  // Estimated time to run the node again.
+  Costs::NanoSeconds recompute_cost = 0;
+  // Inputs of the nodes executing after the peak that read the outputs.
+  std::vector<GraphView::InputPort> late_uses;
+
+  // Orders candidates by increasing recompute cost per byte saved, the
+  // largest first among equally cheap ones.
+  bool operator<(const RecomputeCandidate& other) const {
+    const double cost = static_cast<double>(recompute_cost.count()) *
+                        static_cast<double>(other.memory_saved);
+    const double other_cost =
+        static_cast<double>(other.recompute_cost.count()) *
+        static_cast<double>(memory_saved);
+    if (cost != other_cost) {
+      return cost < other_cost;
+    }
+    return memory_saved > other.memory_saved;
+  }
+};
+
+// Returns true if running `node` a second time yields the same outputs and
+// frees memory.
+static bool IsRecomputable(const NodeDef& node,
+                           const std::unordered_set<string>& feeds) {
+  if (feeds.count(node.name()) > 0 || IsPersistent(node) ||
+      ModifiesFrameInfo(node) || IsSwitch(node) || IsMerge(node) ||
+      IsControlFlow(node) || IsSend(node) || IsRecv(node)) {
+    return false;
+  }
+  // Identity and Reshape forward their input buffer, so recomputing them
+  // saves nothing.
+  if (node.op() == "Identity" || node.op() == "Reshape") {
+    return false;
+  }
+  // Don't recompute the copies made by a previous pass.
+  if (str_util::StartsWith(node.name(),
+                           strings::StrCat(kRecomputedNodePrefix, "/"))) {
+    return false;
+  }
+  const OpDef* op_def;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+      op_def->is_stateful()) {
+    return false;
+  }
+  DataTypeVector inputs, outputs;
+  if (!InOutTypesForNode(node, *op_def, &inputs, &outputs).ok()) {
+    return false;
+  }
+  for (DataType dtype : inputs) {
+    if (IsRefType(dtype)) return false;
+  }
+  for (DataType dtype : outputs) {
+    if (IsRefType(dtype)) return false;
+  }
+  return true;
+}
+
+// Returns true if all the data inputs of `node` are kept in memory past
+// `peak_time` anyway, so that recomputing the node after the peak doesn't
+// extend their lifetime across it.
+static bool InputsLiveAfterPeak(
+    const GraphView& graph, const NodeDef& node, Costs::Duration peak_time,
+    const std::unordered_map<string, Costs::NanoSeconds>& op_completion_times) {
+  for (int i = 0; i < node.input_size(); ++i) {
+    if (IsControlInput(node.input(i))) {
+      break;
+    }
+    GraphView::OutputPort fanin =
+        graph.GetRegularFanin(GraphView::InputPort(&node, i));
+    if (fanin.node == nullptr) {
+      return false;
+    }
+    if (IsPersistent(*fanin.node) || IsConstant(*fanin.node)) {
+      continue;
+    }
+    bool live_after_peak = false;
+    for (const GraphView::InputPort& use : graph.GetFanout(fanin)) {
+      auto it = op_completion_times.find(use.node->name());
+      if (use.node != &node && it != op_completion_times.end() &&
+          it->second > peak_time) {
+        live_after_peak = true;
+        break;
+      }
+    }
+    if (!live_after_peak) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Uses the cost model to find the nodes to recompute to bring the peak memory
+// usage of each device under its memory size. This is a greedy approximation
+// of the checkpointing problem: a node is only recomputed from inputs that
+// are kept in memory across the peak anyway, and the cheapest nodes per byte
+// saved are picked first. Successive passes recompute chains of nodes as the
+// peak moves.
+static bool IdentifyRecomputeCandidates(
+    Cluster* cluster, GrapplerItem* item,
+    std::vector<RecomputeCandidate>* candidates) {
+  GraphMemory memory(*item);
+  const std::unordered_map<string, DeviceProperties>& devices =
+      cluster->GetDevices();
+  Status s = memory.InferStatically(devices);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer memory usage: " << s.error_message();
+    return false;
+  }
+
+  std::unordered_set<string> feeds;
+  for (const auto& feed : item->feed) {
+    feeds.insert(NodeName(feed.first));
+  }
+
+  std::unordered_map<string, Costs::NanoSeconds> op_completion_times;
+  std::unordered_map<string, Costs::NanoSeconds> op_compute_costs;
+  bool simulated = false;
+
+  GraphView graph(&item->graph);
+  for (const auto& device : devices) {
+    const string& name = device.first;
+    const DeviceProperties& prop = device.second;
+    if (prop.memory_size() <= 0) {
+      VLOG(1) << "Memory size unknown for device " << name;
+      continue;
+    }
+    const GraphMemory::MemoryUsage& mem_usage = memory.GetPeakMemoryUsage(name);
+    if (mem_usage.used_memory <= prop.memory_size()) {
+      continue;
+    }
+    int64 required_savings = mem_usage.used_memory - prop.memory_size();
+
+    if (!simulated) {
+      if (!SimulateExecution(cluster, *item, &op_completion_times,
+                             &op_compute_costs)) {
+        return false;
+      }
+      simulated = true;
+    }
+    const Costs::Duration peak_time = PeakTime(mem_usage);
+
+    std::unordered_map<NodeDef*, RecomputeCandidate> device_candidates;
+    for (const auto& live_tensor : mem_usage.live_tensors) {
+      if (live_tensor.memory_used <= 1024) {
+        // Don't bother with small tensors.
+        continue;
+      }
+      if (live_tensor.allocation_time >= peak_time) {
+        // Allocated at the peak: it can't be freed before it.
+        continue;
+      }
+      GraphView::OutputPort port =
+          graph.GetOutputPort(live_tensor.node, live_tensor.output_id);
+      if (port.node == nullptr || !IsRecomputable(*port.node, feeds)) {
+        continue;
+      }
+      auto cost = op_compute_costs.find(port.node->name());
+      if (cost == op_compute_costs.end()) {
+        continue;
+      }
+      bool valid = true;
+      bool has_early_use = false;
+      std::vector<GraphView::InputPort> late_uses;
+      for (const GraphView::InputPort& use : graph.GetFanout(port)) {
+        auto it = op_completion_times.find(use.node->name());
+        if (it == op_completion_times.end()) {
+          valid = false;
+          break;
+        }
+        if (it->second <= peak_time) {
+          has_early_use = true;
+        } else {
+          late_uses.push_back(use);
+        }
+      }
+      // Without an early use, the node itself should run later instead.
+      if (!valid || !has_early_use || late_uses.empty()) {
+        continue;
+      }
+      if (!InputsLiveAfterPeak(graph, *port.node, peak_time,
+                               op_completion_times)) {
+        continue;
+      }
+      RecomputeCandidate& candidate = device_candidates[port.node];
+      candidate.node = port.node;
+      candidate.memory_saved += live_tensor.memory_used;
+      candidate.recompute_cost = cost->second;
+      candidate.late_uses.insert(candidate.late_uses.end(), late_uses.begin(),
+                                 late_uses.end());
+    }
+
+    std::vector<RecomputeCandidate> sorted_candidates;
+    for (auto& candidate : device_candidates) {
+      sorted_candidates.push_back(std::move(candidate.second));
+    }
+    std::sort(sorted_candidates.begin(), sorted_candidates.end());
+
+    // A node recomputed from the original outputs of another recomputed node
+    // would keep them alive, so skip the neighbors of the selected nodes.
+    std::unordered_set<const NodeDef*> selected;
+    for (RecomputeCandidate& candidate : sorted_candidates) {
+      bool has_selected_neighbor = false;
+      for (const auto& fanin : graph.GetFanins(*candidate.node, false)) {
+        has_selected_neighbor |= selected.count(fanin.node) > 0;
+      }
+      for (const auto& fanout : graph.GetFanouts(*candidate.node, false)) {
+        has_selected_neighbor |= selected.count(fanout.node) > 0;
+      }
+      if (has_selected_neighbor) {
+        continue;
+      }
+      VLOG(1) << "Will recompute " << candidate.node->name() << " for "
+              << candidate.late_uses.size() << " uses to save "
+              << candidate.memory_saved << " bytes on " << name;
+      selected.insert(candidate.node);
+      required_savings -= candidate.memory_saved;
+      candidates->push_back(std::move(candidate));
+      if (required_savings < 0) {
+        break;
+      }
+    }
+  }
+  return !candidates->empty();
+}
+
+bool CostModelRecomputationPass(Cluster* cluster, GrapplerItem* item) {
+  std::vector<RecomputeCandidate> candidates;
+  if (!IdentifyRecomputeCandidates(cluster, item, &candidates)) {
+    return false;
+  }
+
+  std::unordered_map<const NodeDef*, Costs::NanoSeconds> execution_times;
+  if (!EstimateEarliestExecutionTimes(*item, cluster, &execution_times).ok()) {
+    return false;
+  }
+  std::unordered_map<string, const NodeDef*> name_map;
+  for (const auto& node : item->graph.node()) {
+    name_map[node.name()] = &node;
+  }
+
+  bool updated_graph = false;
+  for (const RecomputeCandidate& candidate : candidates) {
+    const NodeDef* node = candidate.node;
+    const string recomputed_name =
+        AddPrefixToNodeName(node->name(), kRecomputedNodePrefix);
+    if (name_map.find(recomputed_name) != name_map.end()) {
+      continue;
+    }
+
+    // The copy must run late enough not to recreate the peak, yet finish in
+    // time for its earliest use: reuse the swap-in logic to find a node that
+    // executes just before that use, and make the copy wait for it.
+    NodeDef* earliest_use = nullptr;
+    for (const GraphView::InputPort& use : candidate.late_uses) {
+      auto it = execution_times.find(use.node);
+      if (it == execution_times.end()) {
+        earliest_use = nullptr;
+        break;
+      }
+      if (earliest_use == nullptr ||
+          it->second < execution_times.find(earliest_use)->second) {
+        earliest_use = use.node;
+      }
+    }
+    if (earliest_use == nullptr) {
+      continue;
+    }
+    SwapInfo trigger_info;
+    for (const GraphView::InputPort& use : candidate.late_uses) {
+      if (use.node == earliest_use) {
+        trigger_info.inputs_to_swap.push_back(use.port_id);
+      }
+    }
+    trigger_info.time_to_swap = candidate.recompute_cost;
+    const NodeDef* trigger = FindSwapInTrigger(earliest_use, trigger_info,
+                                               name_map, execution_times);
+    if (trigger == nullptr) {
+      continue;
+    }
+    // Uses executing after the trigger can't be upstream of it, so reading
+    // the copy cannot create a cycle.
+    const Costs::NanoSeconds trigger_time = execution_times.at(trigger);
+    bool trigger_precedes_uses = true;
+    for (const GraphView::InputPort& use : candidate.late_uses) {
+      trigger_precedes_uses &= execution_times.at(use.node) > trigger_time;
+    }
+    if (!trigger_precedes_uses) {
+      continue;
+    }
+
+    NodeDef* recomputed = item->graph.add_node();
+    *recomputed = *node;
+    recomputed->set_name(recomputed_name);
+    *recomputed->add_input() = strings::StrCat("^", trigger->name());
+    name_map[recomputed_name] = recomputed;
+    for (const GraphView::InputPort& use : candidate.late_uses) {
+      const TensorId tensor = ParseTensorName(use.node->input(use.port_id));
+      *use.node->mutable_input(use.port_id) =
+          tensor.second == 0
+              ? recomputed_name
+              : strings::StrCat(recomputed_name, ":", tensor.second);
     }
+    VLOG(1) << "Recomputing " << node->name() << " after " << trigger->name();
+    updated_graph = true;
   }
   return updated_graph;
 }
@@ -1335,6 +1711,12 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
       updated_graph |= SwappingPass(optimization_level_, cluster,
                                     &optimized_item, &skip_list);
     }
+
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    if (optimization_level_ == RewriterConfig::RECOMPUTATION_COST_MODEL &&
+        cluster != nullptr) {
+      updated_graph |= CostModelRecomputationPass(cluster, &optimized_item);
+    }
   }
 
   TF_RETURN_IF_ERROR(RelaxAllocatorConstraints(&optimized_item.graph));
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 
+#include <map>
 #include <memory>
 #include <unordered_map>
 #include <utility>
@@ -27,9 +28,11 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/static_schedule.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/device_properties.pb.h"
 
@@ -203,7 +206,9 @@ TEST_F(RecomputeSubgraphTest, MultiNode) {
 
 class MemoryOptimizerTest : public GrapplerTest {
  public:
-  static std::unique_ptr<VirtualCluster> CreateVirtualCluster() {
+  // gpu_bandwidth is the memory bandwidth of the GPU in KB/s.
+  static std::unique_ptr<VirtualCluster> CreateVirtualCluster(
+      int64 gpu_bandwidth = 128) {
     DeviceProperties cpu_device;
     cpu_device.set_type("CPU");
     cpu_device.set_frequency(1000);
@@ -214,7 +219,7 @@ class MemoryOptimizerTest : public GrapplerTest {
     gpu_device.set_type("GPU");
     gpu_device.set_frequency(1000);
     gpu_device.set_num_cores(24);
-    gpu_device.set_bandwidth(128);
+    gpu_device.set_bandwidth(gpu_bandwidth);
     gpu_device.set_memory_size(1024 * 1024);
     gpu_device.mutable_environment()->insert({"architecture", "6"});
     std::unordered_map<string, DeviceProperties> devices;
@@ -293,6 +298,89 @@ TEST_F(MemoryOptimizerTest, SimpleSwapping) {
 #endif
 }
 
+TEST_F(MemoryOptimizerTest, SwapInsShareCopyStream) {
+  // Two tensors are swapped back in for consumers that run one right after the
+  // other. Both transfers go through the same host_to_device stream, and each
+  // of them takes longer than the computation separating the consumers.
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output v = ops::Variable(s.WithOpName("v").WithDevice("/gpu:0"),
+                           {128, 128, 8}, DT_FLOAT);
+  Output a = ops::Square(s.WithOpName("a").WithDevice("/gpu:0"), v);
+  Output b = ops::Exp(s.WithOpName("b").WithDevice("/gpu:0"), v);
+  std::vector<Output> chain;
+  chain.push_back(ops::AddN(s.WithOpName("c0").WithDevice("/gpu:0"), {a, b}));
+  for (int i = 1; i <= 21; ++i) {
+    chain.push_back(ops::Sqrt(
+        s.WithOpName(strings::StrCat("c", i)).WithDevice("/gpu:0"),
+        chain.back()));
+  }
+  Output e1 = ops::Add(s.WithOpName("e1").WithDevice("/gpu:0"), a, chain[20]);
+  Output e2 = ops::Add(s.WithOpName("e2").WithDevice("/gpu:0"), b, chain[21]);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"e1", "e2"};
+  for (auto& node : *item.graph.mutable_node()) {
+    if (node.name() == "e1" || node.name() == "e2") {
+      (*node.mutable_attr())["_swap_to_host"].mutable_list()->add_i(0);
+    }
+  }
+
+  // Give the GPU a realistic 128 GB/s of memory bandwidth, so that the copies
+  // over PCIe are slow next to the elementwise ops.
+  std::unique_ptr<VirtualCluster> cluster(
+      CreateVirtualCluster(128 * 1000 * 1000));
+  std::unordered_map<const NodeDef*, Costs::NanoSeconds> execution_times;
+  TF_ASSERT_OK(
+      EstimateEarliestExecutionTimes(item, cluster.get(), &execution_times));
+  std::unordered_map<string, Costs::NanoSeconds> times;
+  for (const auto& time : execution_times) {
+    times[time.first->name()] = time.second;
+  }
+
+  MemoryOptimizer optimizer(RewriterConfig::MANUAL);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  NodeMap node_map(&output);
+  const std::vector<string> consumers = {"e1", "e2"};
+  std::map<Costs::NanoSeconds, string> swap_ins_by_trigger;
+  for (const string& consumer : consumers) {
+    const NodeDef* node = node_map.GetNode(consumer);
+    ASSERT_NE(nullptr, node);
+    const string swap_in_name = strings::StrCat("swap_in_", consumer, "_0");
+    EXPECT_EQ(swap_in_name, node->input(0));
+
+    // The swap-in runs on the device of its consumer, whose context issues it
+    // on the host_to_device stream.
+    const NodeDef* swap_in = node_map.GetNode(swap_in_name);
+    ASSERT_NE(nullptr, swap_in);
+    EXPECT_EQ("_CopyFromHostToGpu", swap_in->op());
+    EXPECT_EQ(node->device(), swap_in->device());
+    EXPECT_EQ(strings::StrCat("swap_out_", consumer, "_0"), swap_in->input(0));
+
+    // It is triggered by a control dependency on a node of the chain.
+    ASSERT_EQ(2, swap_in->input_size());
+    ASSERT_TRUE(IsControlInput(swap_in->input(1)));
+    const string trigger = NodeName(swap_in->input(1));
+    EXPECT_TRUE(str_util::StartsWith(trigger, "c")) << trigger;
+    ASSERT_EQ(1, times.count(trigger));
+    swap_ins_by_trigger[times[trigger]] = consumer;
+  }
+  ASSERT_EQ(2, swap_ins_by_trigger.size());
+
+  // Replay the swap-ins one after the other on the shared stream: each must
+  // still complete by the time its consumer is scheduled.
+  const Costs::NanoSeconds time_to_swap(128 * 128 * 8 * sizeof(float) / 16);
+  Costs::NanoSeconds stream_available(0);
+  for (const auto& swap_in : swap_ins_by_trigger) {
+    const Costs::NanoSeconds done =
+        std::max(swap_in.first, stream_available) + time_to_swap;
+    EXPECT_LE(done, times[swap_in.second]) << swap_in.second;
+    stream_available = done;
+  }
+}
+
 TEST_F(MemoryOptimizerTest, SwappingHeuristics) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   Output v = ops::Variable(s.WithOpName("v").WithDevice("/gpu:0"),
@@ -447,6 +535,67 @@ TEST_F(MemoryOptimizerTest, AccumulationRewrites) {
   }
 }
 
+TEST_F(MemoryOptimizerTest, CostModelRecomputation) {
+  // A forward chain whose activations are all used again by a backward chain
+  // in reverse order, so that they are all live at the end of the forward
+  // chain and the peak memory usage exceeds the memory of the device.
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output v = ops::Variable(s.WithOpName("v").WithDevice("/cpu:0"),
+                           {128, 128, 8}, DT_FLOAT);
+  Output a = ops::Sqrt(s.WithOpName("a").WithDevice("/cpu:0"), v);
+  Output b = ops::Square(s.WithOpName("b").WithDevice("/cpu:0"), a);
+  Output c = ops::Square(s.WithOpName("c").WithDevice("/cpu:0"), b);
+  Output d = ops::Square(s.WithOpName("d").WithDevice("/cpu:0"), c);
+  Output e = ops::Square(s.WithOpName("e").WithDevice("/cpu:0"), d);
+  Output f = ops::AddN(s.WithOpName("f").WithDevice("/cpu:0"), {e, d});
+  Output g = ops::AddN(s.WithOpName("g").WithDevice("/cpu:0"), {f, c});
+  Output h = ops::AddN(s.WithOpName("h").WithDevice("/cpu:0"), {g, b});
+  Output i = ops::AddN(s.WithOpName("i").WithDevice("/cpu:0"), {h, a});
+
+  Output constant = ops::Const(s.WithOpName("constant"), 1.0f, {128, 128, 8});
+  Output init = ops::Assign(s.WithOpName("init"), v, constant);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"i"};
+  item.init_ops = {init.name()};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_COST_MODEL);
+  GraphDef output;
+  Status status = optimizer.Optimize(cluster.get(), item, &output);
+  TF_EXPECT_OK(status);
+
+  // The early activations are recomputed for the backward chain, after a
+  // trigger node, instead of being kept alive.
+  std::unordered_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : output.node()) {
+    nodes[node.name()] = &node;
+  }
+  int num_recomputed = 0;
+  for (const NodeDef& node : output.node()) {
+    if (!str_util::StartsWith(node.name(), "Recomputed/")) {
+      continue;
+    }
+    ++num_recomputed;
+    const NodeDef* original = nodes[node.name().substr(11)];
+    ASSERT_NE(nullptr, original);
+    EXPECT_EQ(original->op(), node.op());
+    ASSERT_EQ(original->input_size() + 1, node.input_size());
+    EXPECT_TRUE(IsControlInput(node.input(node.input_size() - 1)));
+  }
+  EXPECT_LT(0, num_recomputed);
+  const NodeDef* new_i = nodes["i"];
+  ASSERT_NE(nullptr, new_i);
+  EXPECT_EQ("Recomputed/a", new_i->input(1));
+
+  auto tensors_expected = EvaluateFetchNodes(item);
+  GrapplerItem optimized(item, std::move(output));
+  auto tensors = EvaluateFetchNodes(optimized);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
 class RelaxAllocatorConstraintsTest : public GrapplerTest {};
 
 TEST_F(RelaxAllocatorConstraintsTest, SameDevice) {
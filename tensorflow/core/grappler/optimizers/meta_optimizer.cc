@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
 #include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
@@ -28,16 +29,20 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/layout_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/model_parallel_placer.h"
+#include "tensorflow/core/grappler/optimizers/multi_apply_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
 #include "tensorflow/core/grappler/optimizers/pin_to_host_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 #include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/shape_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/transfer_priority_optimizer.h"
 #include "tensorflow/core/grappler/utils/colocation.h"
 #include "tensorflow/core/grappler/utils/functions.h"
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
@@ -48,6 +53,11 @@ namespace {
 constexpr int kDefaultNumberOfIterations = 2;
 constexpr int kDefaultMinGraphNodes = 4;
 
+auto* optimizer_time_usecs = monitoring::Counter<1>::New(
+    "/tensorflow/core/grappler_optimizer_time_usecs",
+    "The time spent running each grappler optimizer, in microseconds.",
+    "optimizer");
+
 int64 NumEdges(const GraphDef& graph) {
   int64 num_edges = 0;
   for (const auto& node : graph.node()) {
@@ -108,7 +118,8 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
   MK_OPT("function", new FunctionOptimizer(cfg_.function_optimization()));
   MK_OPT("constfold", new ConstantFolding(cpu_device_));
   MK_OPT("shape", new ShapeOptimizer());
-  MK_OPT("remap", new Remapper(cfg_.remapping()));
+  MK_OPT("remap",
+         new Remapper(cfg_.remapping(), cfg_.int8_inference()));
   MK_OPT("layout", new LayoutOptimizer());
   MK_OPT("memory", new MemoryOptimizer(RewriterConfig::MANUAL));
   MK_OPT("arithmetic", new ArithmeticOptimizer(cfg_.arithmetic_optimization()));
@@ -120,6 +131,14 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
          new ScopedAllocatorOptimizer(cfg_.scoped_allocator_optimization(),
                                       cfg_.scoped_allocator_opts()));
   MK_OPT("small_op", new PinToHostOptimizer(cfg_.pin_to_host_optimization()));
+  MK_OPT("model_parallel",
+         new ModelParallelPlacer(cfg_.model_parallel_placement()));
+  MK_OPT("auto_mixed_precision",
+         new AutoMixedPrecision(cfg_.auto_mixed_precision()));
+  MK_OPT("multi_apply",
+         new MultiApplyOptimizer(cfg_.multi_apply_optimization()));
+  MK_OPT("transfer_priority",
+         new TransferPriorityOptimizer(cfg_.transfer_priority_optimization()));
 
   return std::unique_ptr<GraphOptimizer>();
 }
@@ -144,6 +163,9 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(
         MakeUnique<FunctionOptimizer>(cfg_.function_optimization()));
   }
+  if (cfg_.auto_mixed_precision() == RewriterConfig::ON) {
+    optimizers->push_back(MakeUnique<AutoMixedPrecision>());
+  }
   if (cfg_.debug_stripper() == RewriterConfig::ON) {
     optimizers->push_back(MakeUnique<DebugStripper>());
   }
@@ -155,7 +177,8 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(MakeUnique<ShapeOptimizer>());
   }
   if (cfg_.remapping() != RewriterConfig::OFF) {
-    optimizers->push_back(MakeUnique<Remapper>(cfg_.remapping()));
+    optimizers->push_back(
+        MakeUnique<Remapper>(cfg_.remapping(), cfg_.int8_inference()));
   }
   if (cfg_.pin_to_host_optimization() == RewriterConfig::ON) {
     optimizers->push_back(MakeUnique<PinToHostOptimizer>());
@@ -175,6 +198,12 @@ Status MetaOptimizer::InitializeOptimizers(
   if (cfg_.layout_optimizer() != RewriterConfig::OFF) {
     optimizers->push_back(MakeUnique<LayoutOptimizer>());
   }
+  if (cfg_.multi_apply_optimization() == RewriterConfig::ON) {
+    optimizers->push_back(MakeUnique<MultiApplyOptimizer>());
+  }
+  if (cfg_.model_parallel_placement() == RewriterConfig::ON) {
+    optimizers->push_back(MakeUnique<ModelParallelPlacer>());
+  }
   if (cfg_.memory_optimization() != RewriterConfig::NO_MEM_OPT) {
     if (cfg_.memory_optimizer_target_node_name_scope().empty()) {
       optimizers->push_back(
@@ -190,6 +219,9 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(
         MakeUnique<AutoParallel>(cfg_.auto_parallel().num_replicas()));
   }
+  if (cfg_.transfer_priority_optimization() == RewriterConfig::ON) {
+    optimizers->push_back(MakeUnique<TransferPriorityOptimizer>());
+  }
   if (cfg_.scoped_allocator_optimization()) {
     optimizers->push_back(MakeUnique<ScopedAllocatorOptimizer>(
         cfg_.scoped_allocator_optimization(), cfg_.scoped_allocator_opts()));
@@ -390,6 +422,8 @@ Status MetaOptimizer::RunOptimizer(
   Status status =
       optimizer->Optimize(cluster, *optimized_item, optimized_graph);
   uint64 end_us = Env::Default()->NowMicros();
+  optimizer_time_usecs->GetCell(optimizer->name())
+      ->IncrementBy(end_us - start_us);
 
   string result;
   if (!status.ok()) {
@@ -556,6 +590,10 @@ bool MetaOptimizerEnabled(const RewriterConfig& cfg) {
          cfg.debug_stripper() == RewriterConfig::ON ||
          cfg.scoped_allocator_optimization() == RewriterConfig::ON ||
          cfg.pin_to_host_optimization() == RewriterConfig::ON ||
+         cfg.model_parallel_placement() == RewriterConfig::ON ||
+         cfg.multi_apply_optimization() == RewriterConfig::ON ||
+         cfg.auto_mixed_precision() == RewriterConfig::ON ||
+         cfg.transfer_priority_optimization() == RewriterConfig::ON ||
          !cfg.optimizers().empty() || !cfg.custom_optimizers().empty();
 }
 
@@ -0,0 +1,355 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/model_parallel_placer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/graph_memory.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+constexpr char kDefaultTask[] = "/job:localhost/replica:0/task:0";
+constexpr char kColocationGroupPrefix[] = "loc:@";
+
+// Share of the total node weight by which a stage boundary may be moved to
+// reduce the data crossing devices.
+constexpr double kBoundarySlack = 0.05;
+
+string CanonicalDeviceName(const string& device) {
+  string canonical;
+  if (!DeviceNameUtils::CanonicalizeDeviceName(device, kDefaultTask,
+                                               &canonical)
+           .ok()) {
+    return device;
+  }
+  return canonical;
+}
+
+// Disjoint sets of the nodes that must be placed on the same device.
+class NodeGroups {
+ public:
+  explicit NodeGroups(int num_nodes) : parents_(num_nodes) {
+    std::iota(parents_.begin(), parents_.end(), 0);
+  }
+
+  int Find(int node) {
+    while (parents_[node] != node) {
+      parents_[node] = parents_[parents_[node]];
+      node = parents_[node];
+    }
+    return node;
+  }
+
+  void Merge(int a, int b) { parents_[Find(a)] = Find(b); }
+
+ private:
+  std::vector<int> parents_;
+};
+
+// Returns the output types of `node`, or an empty vector if they are unknown.
+DataTypeVector OutputTypes(const NodeDef& node) {
+  DataTypeVector inputs, outputs;
+  const OpDef* op_def;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+      !InOutTypesForNode(node, *op_def, &inputs, &outputs).ok()) {
+    return {};
+  }
+  return outputs;
+}
+
+struct GpuDevice {
+  string name;
+  int64 capacity;
+};
+
+}  // namespace
+
+Status ModelParallelPlacer::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                     GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  if (cluster == nullptr || opt_level_ == RewriterConfig::OFF) {
+    return Status::OK();
+  }
+
+  // Don't bother splitting loops across devices.
+  for (const NodeDef& node : item.graph.node()) {
+    if (ModifiesFrameInfo(node)) {
+      return Status::OK();
+    }
+  }
+
+  const std::unordered_map<string, DeviceProperties>& devices =
+      cluster->GetDevices();
+  std::vector<string> gpus;
+  for (const auto& device : devices) {
+    if (device.second.type() == "GPU" && device.second.memory_size() > 0) {
+      gpus.push_back(device.first);
+    }
+  }
+  if (gpus.size() < 2) {
+    return Status::OK();
+  }
+  std::sort(gpus.begin(), gpus.end());
+
+  GraphMemory memory(item);
+  Status s = memory.InferStatically(devices);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer memory usage: " << s.error_message();
+    return Status::OK();
+  }
+
+  // Find the GPU that overflows the most.
+  string source;
+  int64 max_overflow = 0;
+  for (const string& gpu : gpus) {
+    const int64 overflow = memory.GetPeakMemoryUsage(gpu).used_memory -
+                           devices.at(gpu).memory_size();
+    if (overflow > max_overflow) {
+      source = gpu;
+      max_overflow = overflow;
+    }
+  }
+  if (source.empty()) {
+    return Status::OK();
+  }
+
+  // Use as few GPUs of the same task as possible, since every additional one
+  // adds transfers.
+  const int64 source_usage = memory.GetPeakMemoryUsage(source).used_memory;
+  std::vector<GpuDevice> targets = {{source, devices.at(source).memory_size()}};
+  int64 total_capacity = targets[0].capacity;
+  for (const string& gpu : gpus) {
+    if (total_capacity >= source_usage) break;
+    if (gpu == source || !DeviceNameUtils::IsSameAddressSpace(gpu, source)) {
+      continue;
+    }
+    // Devices without any node have an unknown (negative) usage.
+    const int64 used = std::max<int64>(
+        0, memory.GetPeakMemoryUsage(gpu).used_memory);
+    const int64 free_memory = devices.at(gpu).memory_size() - used;
+    if (free_memory > 0) {
+      targets.push_back({gpu, free_memory});
+      total_capacity += free_memory;
+    }
+  }
+  if (targets.size() < 2) {
+    VLOG(1) << "No GPU has memory to spare for the nodes of " << source;
+    return Status::OK();
+  }
+
+  GraphProperties properties(item);
+  s = properties.InferStatically(false);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer shapes: " << s.error_message();
+    return Status::OK();
+  }
+
+  const int num_nodes = item.graph.node_size();
+  std::unordered_map<string, int> node_index;
+  for (int i = 0; i < num_nodes; ++i) {
+    node_index[item.graph.node(i).name()] = i;
+  }
+  const string canonical_source = CanonicalDeviceName(source);
+  std::vector<bool> on_source(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    on_source[i] =
+        CanonicalDeviceName(item.graph.node(i).device()) == canonical_source;
+  }
+
+  // Group the nodes that must stay together.
+  NodeGroups groups(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    const NodeDef& node = item.graph.node(i);
+    auto class_attr = node.attr().find("_class");
+    if (class_attr != node.attr().end()) {
+      for (const string& entry : class_attr->second.list().s()) {
+        if (!str_util::StartsWith(entry, kColocationGroupPrefix)) continue;
+        auto it = node_index.find(
+            entry.substr(strlen(kColocationGroupPrefix)));
+        if (it != node_index.end()) {
+          groups.Merge(i, it->second);
+        }
+      }
+    }
+    for (const string& input : node.input()) {
+      if (IsControlInput(input)) continue;
+      const TensorId tensor = ParseTensorName(input);
+      auto it = node_index.find(string(tensor.first));
+      if (it == node_index.end()) continue;
+      const DataTypeVector types = OutputTypes(item.graph.node(it->second));
+      if (tensor.second < 0 || tensor.second >= types.size()) continue;
+      const DataType dtype = types[tensor.second];
+      if (IsRefType(dtype) || dtype == DT_RESOURCE) {
+        groups.Merge(i, it->second);
+      }
+    }
+  }
+
+  // A group can only be moved if all its nodes are on the source GPU.
+  std::vector<bool> movable_group(num_nodes, true);
+  for (int i = 0; i < num_nodes; ++i) {
+    if (!on_source[i]) {
+      movable_group[groups.Find(i)] = false;
+    }
+  }
+
+  std::unordered_map<const NodeDef*, int> topo_order;
+  s = ComputeTopologicalOrder(item.graph, &topo_order, nullptr);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to sort the graph: " << s.error_message();
+    return Status::OK();
+  }
+
+  // Order the movable groups by the earliest of their nodes, and weigh them
+  // by the size of the tensors they produce.
+  std::unordered_map<int, int> group_position;
+  std::unordered_map<int, int64> group_weight;
+  for (int i = 0; i < num_nodes; ++i) {
+    const int group = groups.Find(i);
+    if (!movable_group[group]) continue;
+    const NodeDef* node = &item.graph.node(i);
+    const int position = topo_order.at(node);
+    auto it = group_position.find(group);
+    if (it == group_position.end() || position < it->second) {
+      group_position[group] = position;
+    }
+    int64& weight = group_weight[group];
+    for (const auto& output : properties.GetOutputProperties(node->name())) {
+      weight += CalculateTensorSize(output);
+    }
+  }
+  std::vector<int> ordered_groups;
+  for (const auto& group : group_position) {
+    ordered_groups.push_back(group.first);
+  }
+  if (ordered_groups.size() < 2) {
+    return Status::OK();
+  }
+  std::sort(ordered_groups.begin(), ordered_groups.end(), [&](int a, int b) {
+    return group_position[a] < group_position[b];
+  });
+  std::unordered_map<int, int> group_rank;
+  for (int rank = 0; rank < ordered_groups.size(); ++rank) {
+    group_rank[ordered_groups[rank]] = rank;
+  }
+
+  // crossing_bytes[r] is the size of the tensors that would be transferred
+  // between devices by a cut right after the group of rank r.
+  const int num_groups = ordered_groups.size();
+  std::vector<int64> crossing_bytes(num_groups + 1, 0);
+  for (int i = 0; i < num_nodes; ++i) {
+    const NodeDef& node = item.graph.node(i);
+    auto consumer_rank = group_rank.find(groups.Find(i));
+    if (consumer_rank == group_rank.end()) continue;
+    for (const string& input : node.input()) {
+      if (IsControlInput(input)) continue;
+      const TensorId tensor = ParseTensorName(input);
+      auto it = node_index.find(string(tensor.first));
+      if (it == node_index.end()) continue;
+      auto producer_rank = group_rank.find(groups.Find(it->second));
+      if (producer_rank == group_rank.end() ||
+          producer_rank->second >= consumer_rank->second) {
+        continue;
+      }
+      const auto& outputs =
+          properties.GetOutputProperties(item.graph.node(it->second).name());
+      if (tensor.second < 0 || tensor.second >= outputs.size()) continue;
+      const int64 size = CalculateTensorSize(outputs[tensor.second]);
+      crossing_bytes[producer_rank->second] += size;
+      crossing_bytes[consumer_rank->second] -= size;
+    }
+  }
+  for (int rank = 1; rank < num_groups; ++rank) {
+    crossing_bytes[rank] += crossing_bytes[rank - 1];
+  }
+
+  std::vector<int64> cumulative_weight(num_groups);
+  int64 total_weight = 0;
+  for (int rank = 0; rank < num_groups; ++rank) {
+    total_weight += group_weight[ordered_groups[rank]];
+    cumulative_weight[rank] = total_weight;
+  }
+
+  // Choose the last group of each stage but the last one: close to the
+  // boundary given by the memory share of its device, where the fewest bytes
+  // cross devices.
+  const int64 slack = static_cast<int64>(kBoundarySlack * total_weight);
+  std::vector<int> stage_ends;
+  int64 capacity_so_far = 0;
+  int first_rank = 0;
+  for (int stage = 0; stage + 1 < targets.size(); ++stage) {
+    capacity_so_far += targets[stage].capacity;
+    const int64 boundary = static_cast<int64>(
+        static_cast<double>(total_weight) * capacity_so_far / total_capacity);
+    int best = -1;
+    for (int rank = first_rank; rank + 1 < num_groups; ++rank) {
+      if (cumulative_weight[rank] < boundary - slack) continue;
+      if (cumulative_weight[rank] > boundary + slack) {
+        if (best < 0) best = rank;
+        break;
+      }
+      if (best < 0 || crossing_bytes[rank] < crossing_bytes[best]) {
+        best = rank;
+      }
+    }
+    if (best < 0) break;
+    stage_ends.push_back(best);
+    first_rank = best + 1;
+  }
+  stage_ends.push_back(num_groups - 1);
+
+  std::vector<int> group_stage(num_groups);
+  int stage = 0;
+  for (int rank = 0; rank < num_groups; ++rank) {
+    while (rank > stage_ends[stage]) ++stage;
+    group_stage[rank] = stage;
+  }
+
+  int num_moved = 0;
+  for (int i = 0; i < num_nodes; ++i) {
+    auto rank = group_rank.find(groups.Find(i));
+    if (rank == group_rank.end()) continue;
+    const int node_stage = group_stage[rank->second];
+    if (node_stage == 0) continue;
+    optimized_graph->mutable_node(i)->set_device(targets[node_stage].name);
+    ++num_moved;
+  }
+  VLOG(1) << "Moved " << num_moved << " nodes from " << source << " to "
+          << targets.size() - 1 << " other GPUs";
+  return Status::OK();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
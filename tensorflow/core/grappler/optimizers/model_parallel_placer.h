@@ -0,0 +1,55 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_MODEL_PARALLEL_PLACER_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_MODEL_PARALLEL_PLACER_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Spreads the nodes of a GPU whose estimated peak memory usage exceeds its
+// memory over additional GPUs of the same task. The nodes are split into
+// stages that are contiguous in topological order, sized in proportion to the
+// free memory of each GPU, and the stage boundaries are moved to the nearby
+// cut points where the fewest bytes cross devices. Nodes that must stay
+// together (colocation constraints, reference and resource edges) are moved
+// as a unit. Graphs that fit on their devices are left untouched.
+class ModelParallelPlacer : public GraphOptimizer {
+ public:
+  ModelParallelPlacer() : opt_level_(RewriterConfig::ON) {}
+  explicit ModelParallelPlacer(RewriterConfig::Toggle opt_level)
+      : opt_level_(opt_level) {}
+
+  ~ModelParallelPlacer() override {}
+
+  string name() const override { return "model_parallel_placer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override {}
+
+ private:
+  RewriterConfig::Toggle opt_level_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_MODEL_PARALLEL_PLACER_H_
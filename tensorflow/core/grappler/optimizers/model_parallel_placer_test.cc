@@ -0,0 +1,116 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/model_parallel_placer.h"
+
+#include <memory>
+#include <unordered_map>
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kGpu0[] = "/job:localhost/replica:0/task:0/gpu:0";
+constexpr char kGpu1[] = "/job:localhost/replica:0/task:0/gpu:1";
+
+class ModelParallelPlacerTest : public ::testing::Test {
+ protected:
+  // Creates a cluster with a CPU and two GPUs of 2MB each.
+  static std::unique_ptr<VirtualCluster> CreateVirtualCluster() {
+    DeviceProperties cpu_device;
+    cpu_device.set_type("CPU");
+    cpu_device.set_frequency(1000);
+    cpu_device.set_num_cores(4);
+    cpu_device.set_bandwidth(32);
+    cpu_device.set_memory_size(1024 * 1024 * 1024);
+    DeviceProperties gpu_device;
+    gpu_device.set_type("GPU");
+    gpu_device.set_frequency(1000);
+    gpu_device.set_num_cores(24);
+    gpu_device.set_bandwidth(128);
+    gpu_device.set_memory_size(2 * 1024 * 1024);
+    gpu_device.mutable_environment()->insert({"architecture", "6"});
+    std::unordered_map<string, DeviceProperties> devices;
+    devices["/job:localhost/replica:0/task:0/cpu:0"] = cpu_device;
+    devices[kGpu0] = gpu_device;
+    devices[kGpu1] = gpu_device;
+    return std::unique_ptr<VirtualCluster>(new VirtualCluster(devices));
+  }
+};
+
+TEST_F(ModelParallelPlacerTest, SplitsOversizedGraph) {
+  // Each tensor takes 512KB, and all of a, b, c, d and e are live at the
+  // same time: that's more than the 2MB of a GPU.
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output v = ops::Variable(s.WithOpName("v").WithDevice("/cpu:0"),
+                           {128, 128, 8}, DT_FLOAT);
+  Output a = ops::Sqrt(s.WithOpName("a").WithDevice("/gpu:0"), v);
+  Output b = ops::Sqrt(s.WithOpName("b").WithDevice("/gpu:0"), a);
+  Output c = ops::Sqrt(s.WithOpName("c").WithDevice("/gpu:0"), b);
+  Output d = ops::Sqrt(s.WithOpName("d").WithDevice("/gpu:0"), c);
+  Output e = ops::AddN(s.WithOpName("e").WithDevice("/gpu:0"), {a, b, c, d});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"e"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  ModelParallelPlacer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  std::unordered_map<string, string> devices;
+  for (const NodeDef& node : output.node()) {
+    devices[node.name()] = node.device();
+  }
+  EXPECT_EQ("/cpu:0", devices["v"]);
+  EXPECT_EQ("/gpu:0", devices["a"]);
+  EXPECT_EQ("/gpu:0", devices["b"]);
+  EXPECT_EQ(kGpu1, devices["e"]);
+}
+
+TEST_F(ModelParallelPlacerTest, LeavesFittingGraphAlone) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output v = ops::Variable(s.WithOpName("v").WithDevice("/cpu:0"),
+                           {128, 128, 8}, DT_FLOAT);
+  Output a = ops::Sqrt(s.WithOpName("a").WithDevice("/gpu:0"), v);
+  Output b = ops::Sqrt(s.WithOpName("b").WithDevice("/gpu:0"), a);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"b"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  ModelParallelPlacer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  ASSERT_EQ(item.graph.node_size(), output.node_size());
+  for (int i = 0; i < output.node_size(); ++i) {
+    EXPECT_EQ(item.graph.node(i).device(), output.node(i).device());
+  }
+}
+
+}  // namespace
+}  // end namespace grappler
+}  // end namespace tensorflow
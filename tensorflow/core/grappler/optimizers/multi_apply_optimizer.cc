@@ -0,0 +1,232 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/multi_apply_optimizer.h"
+
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/frame.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// The apply ops with a multi-tensor variant, and the layout of their inputs.
+struct MultiApplyOp {
+  const char* op;
+  const char* multi_op;
+  // The number of variable inputs (the variable and its slots), which are
+  // followed by the scalar and gradient inputs.
+  int num_variables;
+  int grad_index;
+  int num_inputs;
+};
+
+const MultiApplyOp kMultiApplyOps[] = {
+    {"ResourceApplyAdam", "ResourceMultiApplyAdam", 3, 9, 10},
+    {"ResourceApplyMomentum", "ResourceMultiApplyMomentum", 2, 3, 5},
+};
+
+const MultiApplyOp* FindMultiApplyOp(const NodeDef& node) {
+  for (const MultiApplyOp& op : kMultiApplyOps) {
+    if (node.op() == op.op) return &op;
+  }
+  return nullptr;
+}
+
+// Returns the key shared by the nodes that can be updated by the same
+// multi-tensor apply node, or an empty string if `node` cannot be fused.
+string GroupKey(const NodeDef& node, const MultiApplyOp& op) {
+  if (node.device().empty()) return "";
+  int num_data_inputs = 0;
+  while (num_data_inputs < node.input_size() &&
+         !IsControlInput(node.input(num_data_inputs))) {
+    ++num_data_inputs;
+  }
+  if (num_data_inputs != op.num_inputs) return "";
+  const auto& attr = node.attr();
+  if (attr.count("T") == 0) return "";
+  string key = strings::StrCat(op.op, ";", node.device(), ";",
+                               attr.at("T").type());
+  for (const char* name : {"use_locking", "use_nesterov"}) {
+    const auto it = attr.find(name);
+    strings::StrAppend(&key, ";", it != attr.end() && it->second.b());
+  }
+  // The scalar inputs.
+  for (int i = op.num_variables; i < op.num_inputs; ++i) {
+    if (i != op.grad_index) strings::StrAppend(&key, ";", node.input(i));
+  }
+  return key;
+}
+
+// Returns the nodes reachable from the fanouts of `sources`.
+std::unordered_set<const NodeDef*> Downstream(
+    const NodeMap& node_map, const std::vector<const NodeDef*>& sources) {
+  std::unordered_set<const NodeDef*> reached;
+  std::deque<const NodeDef*> queue(sources.begin(), sources.end());
+  while (!queue.empty()) {
+    const NodeDef* node = queue.front();
+    queue.pop_front();
+    for (const NodeDef* fanout : node_map.GetOutputs(node->name())) {
+      if (reached.insert(fanout).second) queue.push_back(fanout);
+    }
+  }
+  return reached;
+}
+
+// Makes the node that updates the variables of `group` at once.
+NodeDef MakeMultiApplyNode(const string& name, const MultiApplyOp& op,
+                           const std::vector<const NodeDef*>& group) {
+  const NodeDef& first = *group.front();
+  NodeDef fused;
+  fused.set_name(name);
+  fused.set_op(op.multi_op);
+  fused.set_device(first.device());
+  for (int k = 0; k < op.num_variables; ++k) {
+    for (const NodeDef* node : group) fused.add_input(node->input(k));
+  }
+  for (int i = op.num_variables; i < op.num_inputs; ++i) {
+    if (i != op.grad_index) fused.add_input(first.input(i));
+  }
+  for (const NodeDef* node : group) fused.add_input(node->input(op.grad_index));
+  std::unordered_set<string> control_inputs;
+  for (const NodeDef* node : group) {
+    for (int i = op.num_inputs; i < node->input_size(); ++i) {
+      if (control_inputs.insert(node->input(i)).second) {
+        fused.add_input(node->input(i));
+      }
+    }
+  }
+  auto* attr = fused.mutable_attr();
+  (*attr)["N"].set_i(group.size());
+  for (const char* name : {"T", "use_locking", "use_nesterov"}) {
+    const auto it = first.attr().find(name);
+    if (it != first.attr().end()) (*attr)[name] = it->second;
+  }
+  return fused;
+}
+
+}  // namespace
+
+Status MultiApplyOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                     GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  if (opt_level_ == RewriterConfig::OFF) {
+    return Status::OK();
+  }
+
+  NodeMap node_map(const_cast<GraphDef*>(&item.graph));
+  FrameMap frame_map;
+  int num_frames;
+  TF_RETURN_IF_ERROR(IdentifyFramesWithNodeMap(item.graph, node_map,
+                                               &frame_map, &num_frames));
+  const std::unordered_set<string> nodes_to_preserve = item.NodesToPreserve();
+
+  std::vector<const NodeDef*> candidates;
+  for (const NodeDef& node : item.graph.node()) {
+    if (FindMultiApplyOp(node) != nullptr &&
+        nodes_to_preserve.count(node.name()) == 0 &&
+        frame_map[&node].empty()) {
+      candidates.push_back(&node);
+    }
+  }
+  if (candidates.size() < 2) {
+    return Status::OK();
+  }
+
+  // A node that depends on another candidate cannot join its group without
+  // creating a cycle. Leaving out every such node also keeps the nodes of a
+  // group independent of each other.
+  const std::unordered_set<const NodeDef*> downstream =
+      Downstream(node_map, candidates);
+
+  // Ordered by key, so that the rewritten graph does not depend on hashing.
+  std::map<string, std::vector<const NodeDef*>> groups;
+  std::map<string, std::unordered_set<string>> group_variables;
+  for (const NodeDef* node : candidates) {
+    if (downstream.count(node) > 0) continue;
+    const MultiApplyOp& op = *FindMultiApplyOp(*node);
+    const string key = GroupKey(*node, op);
+    if (key.empty()) continue;
+    // A variable may only be updated once by a multi-tensor apply node.
+    if (!group_variables[key].insert(NodeName(node->input(0))).second) {
+      continue;
+    }
+    groups[key].push_back(node);
+  }
+
+  std::unordered_map<string, string> fused_names;
+  GraphDef fused_nodes;
+  for (const auto& group : groups) {
+    if (group.second.size() < 2) continue;
+    const NodeDef& first = *group.second.front();
+    string name = strings::StrCat(first.name(), "/MultiApply");
+    while (node_map.GetNode(name) != nullptr) {
+      name = strings::StrCat(name, "_1");
+    }
+    *fused_nodes.add_node() =
+        MakeMultiApplyNode(name, *FindMultiApplyOp(first), group.second);
+    for (const NodeDef* node : group.second) {
+      fused_names[node->name()] = name;
+    }
+    VLOG(1) << "Updating " << group.second.size() << " variables with "
+            << name;
+  }
+  if (fused_names.empty()) {
+    return Status::OK();
+  }
+
+  // Drop the fused nodes and make the nodes that waited for them wait for
+  // the multi-tensor apply nodes instead.
+  optimized_graph->clear_node();
+  for (const NodeDef& node : item.graph.node()) {
+    if (fused_names.count(node.name()) > 0) continue;
+    NodeDef* new_node = optimized_graph->add_node();
+    *new_node = node;
+    new_node->clear_input();
+    std::unordered_set<string> control_inputs;
+    for (const string& input : node.input()) {
+      if (!IsControlInput(input)) {
+        new_node->add_input(input);
+        continue;
+      }
+      const auto it = fused_names.find(NodeName(input));
+      const string control_input =
+          it == fused_names.end() ? input : AsControlDependency(it->second);
+      if (control_inputs.insert(control_input).second) {
+        new_node->add_input(control_input);
+      }
+    }
+  }
+  for (NodeDef& node : *fused_nodes.mutable_node()) {
+    optimized_graph->add_node()->Swap(&node);
+  }
+  *optimized_graph->mutable_library() = item.graph.library();
+  *optimized_graph->mutable_versions() = item.graph.versions();
+  return Status::OK();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,193 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/multi_apply_optimizer.h"
+
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+
+constexpr char kDevice[] = "/job:localhost/replica:0/task:0/device:GPU:0";
+
+NodeDef Variable(const string& name) {
+  return NDef(name, "VarHandleOp", {},
+              {{"dtype", DT_FLOAT}, {"shape", TensorShape({})}}, kDevice);
+}
+
+NodeDef Scalar(const string& name) {
+  return NDef(name, "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice);
+}
+
+// Adds an Adam update of the variable `var` with the scalars s0..s5.
+void AddAdam(const string& name, const string& var,
+             const std::vector<string>& control_inputs, GraphDef* graph) {
+  for (const string& slot : {var, var + "_m", var + "_v", var + "_grad"}) {
+    *graph->add_node() =
+        slot == var + "_grad" ? Scalar(slot) : Variable(slot);
+  }
+  std::vector<string> inputs = {var,  var + "_m", var + "_v", "s0", "s1",
+                                "s2", "s3",       "s4",       "s5",
+                                var + "_grad"};
+  for (const string& input : control_inputs) {
+    inputs.push_back(AsControlDependency(input));
+  }
+  *graph->add_node() =
+      NDef(name, "ResourceApplyAdam", inputs,
+           {{"T", DT_FLOAT}, {"use_locking", false}, {"use_nesterov", false}},
+           kDevice);
+}
+
+class MultiApplyOptimizerTest : public ::testing::Test {
+ protected:
+  static GraphDef ScalarsGraph() {
+    GraphDef graph;
+    for (int i = 0; i < 6; ++i) {
+      *graph.add_node() = Scalar(strings::StrCat("s", i));
+    }
+    *graph.add_node() = Scalar("other_lr");
+    return graph;
+  }
+};
+
+TEST_F(MultiApplyOptimizerTest, GroupsUpdates) {
+  GrapplerItem item;
+  item.graph = ScalarsGraph();
+  AddAdam("adam_a", "a", {}, &item.graph);
+  AddAdam("adam_b", "b", {"s0"}, &item.graph);
+  AddAdam("adam_c", "c", {}, &item.graph);
+  for (const string& var : {"d", "e"}) {
+    *item.graph.add_node() = Variable(var);
+    *item.graph.add_node() = Variable(var + "_accum");
+    *item.graph.add_node() = Scalar(var + "_grad");
+    *item.graph.add_node() = NDef(
+        "momentum_" + var, "ResourceApplyMomentum",
+        {var, var + "_accum", "s2", var + "_grad", "s3"},
+        {{"T", DT_FLOAT}, {"use_locking", false}, {"use_nesterov", true}},
+        kDevice);
+  }
+  *item.graph.add_node() =
+      NDef("train", "NoOp",
+           {"^adam_a", "^adam_b", "^adam_c", "^momentum_d", "^momentum_e"},
+           {}, kDevice);
+  item.fetch = {"train"};
+
+  MultiApplyOptimizer optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE("ResourceApplyAdam", node.op());
+    EXPECT_NE("ResourceApplyMomentum", node.op());
+    if (node.name() == "adam_a/MultiApply") {
+      ++found;
+      EXPECT_EQ("ResourceMultiApplyAdam", node.op());
+      EXPECT_EQ(kDevice, node.device());
+      EXPECT_EQ(3, node.attr().at("N").i());
+      ASSERT_EQ(19, node.input_size());
+      EXPECT_EQ("a", node.input(0));
+      EXPECT_EQ("c_m", node.input(5));
+      EXPECT_EQ("a_v", node.input(6));
+      EXPECT_EQ("s0", node.input(9));
+      EXPECT_EQ("s5", node.input(14));
+      EXPECT_EQ("a_grad", node.input(15));
+      EXPECT_EQ("c_grad", node.input(17));
+      EXPECT_EQ("^s0", node.input(18));
+    } else if (node.name() == "momentum_d/MultiApply") {
+      ++found;
+      EXPECT_EQ("ResourceMultiApplyMomentum", node.op());
+      EXPECT_EQ(2, node.attr().at("N").i());
+      EXPECT_TRUE(node.attr().at("use_nesterov").b());
+      ASSERT_EQ(8, node.input_size());
+      EXPECT_EQ("e_accum", node.input(3));
+      EXPECT_EQ("s2", node.input(4));
+      EXPECT_EQ("s3", node.input(5));
+      EXPECT_EQ("d_grad", node.input(6));
+    } else if (node.name() == "train") {
+      ++found;
+      ASSERT_EQ(2, node.input_size());
+      EXPECT_EQ("^adam_a/MultiApply", node.input(0));
+      EXPECT_EQ("^momentum_d/MultiApply", node.input(1));
+    }
+  }
+  EXPECT_EQ(3, found);
+}
+
+TEST_F(MultiApplyOptimizerTest, LeavesIncompatibleUpdates) {
+  GrapplerItem item;
+  item.graph = ScalarsGraph();
+  AddAdam("adam_a", "a", {}, &item.graph);
+  AddAdam("adam_b", "b", {}, &item.graph);
+  // Depends on another update, so fusing it would create a cycle.
+  AddAdam("adam_c", "c", {"adam_a"}, &item.graph);
+  // Uses a different learning rate.
+  AddAdam("adam_d", "d", {}, &item.graph);
+  item.graph.mutable_node(item.graph.node_size() - 1)->set_input(5,
+                                                                  "other_lr");
+  // Updates the same variable as adam_a.
+  *item.graph.add_node() =
+      NDef("adam_e", "ResourceApplyAdam",
+           {"a", "a_m", "a_v", "s0", "s1", "s2", "s3", "s4", "s5", "b_grad"},
+           {{"T", DT_FLOAT}, {"use_locking", false}, {"use_nesterov", false}},
+           kDevice);
+
+  MultiApplyOptimizer optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* fused = node_map.GetNode("adam_a/MultiApply");
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ(2, fused->attr().at("N").i());
+  EXPECT_EQ("a", fused->input(0));
+  EXPECT_EQ("b", fused->input(1));
+  EXPECT_EQ(nullptr, node_map.GetNode("adam_a"));
+  EXPECT_EQ(nullptr, node_map.GetNode("adam_b"));
+  for (const string& name : {"adam_c", "adam_d", "adam_e"}) {
+    const NodeDef* node = node_map.GetNode(name);
+    ASSERT_NE(nullptr, node);
+    EXPECT_EQ("ResourceApplyAdam", node->op());
+  }
+  EXPECT_EQ("^adam_a/MultiApply", node_map.GetNode("adam_c")->input(10));
+}
+
+TEST_F(MultiApplyOptimizerTest, KeepsPreservedNodes) {
+  GrapplerItem item;
+  item.graph = ScalarsGraph();
+  AddAdam("adam_a", "a", {}, &item.graph);
+  AddAdam("adam_b", "b", {}, &item.graph);
+  item.fetch = {"adam_a"};
+
+  MultiApplyOptimizer optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  NodeMap node_map(&output);
+  EXPECT_NE(nullptr, node_map.GetNode("adam_a"));
+  EXPECT_NE(nullptr, node_map.GetNode("adam_b"));
+  EXPECT_EQ(nullptr, node_map.GetNode("adam_a/MultiApply"));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/graph_view.h"
@@ -22,11 +26,596 @@ limitations under the License.
 #include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
 #include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/device_name_utils.h"
 
 namespace tensorflow {
 namespace grappler {
 
+namespace {
+
+constexpr char kFusedConv2D[] = "_FusedConv2D";
+constexpr char kFusedLayerNorm[] = "_FusedLayerNorm";
+constexpr char kFusedMultiHeadAttention[] = "FusedMultiHeadAttention";
+constexpr char kFusedMatMul[] = "_FusedMatMul";
+constexpr char kQuantizedFusedConv2D[] = "_QuantizedFusedConv2D";
+constexpr char kQuantizedFusedMatMul[] = "_QuantizedFusedMatMul";
+// The attribute of a float Conv2D/MatMul with the calibrated magnitude of its
+// input values.
+constexpr char kInputRangeAttr[] = "_input_range";
+
+// A Conv2D or MatMul followed by a BiasAdd and an optional Relu or Relu6,
+// which can be replaced by a single _FusedConv2D or _FusedMatMul node.
+struct FusedContraction {
+  const NodeDef* contraction = nullptr;
+  const NodeDef* bias_add = nullptr;
+  const NodeDef* activation = nullptr;  // Null if there is no activation.
+};
+
+// The fused kernels are only implemented for the CPU.
+bool NodeIsOnCpu(const NodeDef& node) {
+  string task, device;
+  return DeviceNameUtils::SplitDeviceName(node.device(), &task, &device) &&
+         str_util::StartsWith(device, DEVICE_CPU);
+}
+
+bool HasDataFormatNHWC(const NodeDef& node) {
+  return node.attr().count("data_format") == 0 ||
+         node.attr().at("data_format").s() == "NHWC";
+}
+
+// Returns true if the output of `node` feeds nothing but its single consumer,
+// so that it can be folded into it.
+bool HasSingleFanoutAndIsNotPreserved(
+    const GraphView& graph, const std::unordered_set<string>& nodes_to_preserve,
+    const NodeDef& node) {
+  return nodes_to_preserve.count(node.name()) == 0 &&
+         graph.GetFanouts(node, true).size() == 1;
+}
+
+bool IsFusableContraction(const NodeDef& node) {
+  if (node.op() != "Conv2D" && node.op() != "MatMul") return false;
+  if (!NodeIsOnCpu(node)) return false;
+  const DataType dtype = GetDataTypeFromAttr(node, "T");
+  if (dtype != DT_FLOAT && dtype != DT_DOUBLE) return false;
+  return node.op() == "MatMul" || HasDataFormatNHWC(node);
+}
+
+// Matches Conv2D/MatMul -> BiasAdd rooted at `node`.
+bool FindContractionWithBias(
+    const GraphView& graph, const std::unordered_set<string>& nodes_to_preserve,
+    const NodeDef& node, FusedContraction* matched) {
+  if (!IsBiasAdd(node) || !HasDataFormatNHWC(node)) return false;
+  const NodeDef* contraction =
+      graph.GetRegularFanin(GraphView::InputPort(&node, 0)).node;
+  if (contraction == nullptr || !IsFusableContraction(*contraction) ||
+      contraction->device() != node.device() ||
+      !HasSingleFanoutAndIsNotPreserved(graph, nodes_to_preserve,
+                                        *contraction)) {
+    return false;
+  }
+  matched->contraction = contraction;
+  matched->bias_add = &node;
+  matched->activation = nullptr;
+  return true;
+}
+
+// Matches Conv2D/MatMul -> BiasAdd -> Relu/Relu6 rooted at `node`.
+bool FindContractionWithBiasAndActivation(
+    const GraphView& graph, const std::unordered_set<string>& nodes_to_preserve,
+    const NodeDef& node, FusedContraction* matched) {
+  if (node.op() != "Relu" && node.op() != "Relu6") return false;
+  const NodeDef* bias_add =
+      graph.GetRegularFanin(GraphView::InputPort(&node, 0)).node;
+  if (bias_add == nullptr || bias_add->device() != node.device() ||
+      !HasSingleFanoutAndIsNotPreserved(graph, nodes_to_preserve,
+                                        *bias_add) ||
+      !FindContractionWithBias(graph, nodes_to_preserve, *bias_add,
+                               matched)) {
+    return false;
+  }
+  matched->activation = &node;
+  return true;
+}
+
+void AddFusedContractionNode(const FusedContraction& matched,
+                             GraphDef* optimized_graph) {
+  const NodeDef& contraction = *matched.contraction;
+  const NodeDef& root =
+      matched.activation != nullptr ? *matched.activation : *matched.bias_add;
+  const bool is_conv2d = IsConv2D(contraction);
+
+  NodeDef* fused = optimized_graph->add_node();
+  fused->set_name(root.name());
+  fused->set_op(is_conv2d ? kFusedConv2D : kFusedMatMul);
+  fused->set_device(contraction.device());
+  *fused->add_input() = contraction.input(0);
+  *fused->add_input() = contraction.input(1);
+  *fused->add_input() = matched.bias_add->input(1);
+  // Keep the control dependencies of all the fused nodes.
+  for (const NodeDef* node :
+       {matched.contraction, matched.bias_add, matched.activation}) {
+    if (node == nullptr) continue;
+    for (const string& input : node->input()) {
+      if (IsControlInput(input)) *fused->add_input() = input;
+    }
+  }
+
+  auto* attr = fused->mutable_attr();
+  const auto& src_attr = contraction.attr();
+  const std::vector<string> copied_attrs =
+      is_conv2d ? std::vector<string>(
+                      {"T", "strides", "padding", "data_format", "dilations"})
+                : std::vector<string>({"T", "transpose_a", "transpose_b"});
+  for (const string& name : copied_attrs) {
+    if (src_attr.count(name)) (*attr)[name] = src_attr.at(name);
+  }
+  (*attr)["num_args"].set_i(1);
+  auto* fused_ops = (*attr)["fused_ops"].mutable_list();
+  fused_ops->add_s("BiasAdd");
+  if (matched.activation != nullptr) {
+    fused_ops->add_s(matched.activation->op());
+  }
+}
+
+// Returns the constant float weights of `contraction`, or null if they are
+// not a constant that the int8 kernels can take.
+const NodeDef* FindInt8FilterConstant(const GraphView& graph,
+                                      const NodeDef& contraction) {
+  if (GetDataTypeFromAttr(contraction, "T") != DT_FLOAT) return nullptr;
+  if (!IsConv2D(contraction) && contraction.attr().count("transpose_a") &&
+      contraction.attr().at("transpose_a").b()) {
+    return nullptr;
+  }
+  const GraphView::OutputPort filter =
+      graph.GetRegularFanin(GraphView::InputPort(&contraction, 1));
+  if (filter.node == nullptr || !IsConstant(*filter.node) ||
+      filter.port_id != 0 ||
+      GetDataTypeFromAttr(*filter.node, "dtype") != DT_FLOAT) {
+    return nullptr;
+  }
+  return filter.node;
+}
+
+// Adds the int8 counterpart of the fused node of `matched`, with the float
+// weights of `filter_node` quantized symmetrically per output channel.
+// Returns false, without changing the graph, if the weights can't be read.
+bool AddQuantizedFusedContractionNode(const FusedContraction& matched,
+                                      const NodeDef& filter_node,
+                                      GraphDef* optimized_graph) {
+  const NodeDef& contraction = *matched.contraction;
+  const NodeDef& root =
+      matched.activation != nullptr ? *matched.activation : *matched.bias_add;
+  const bool is_conv2d = IsConv2D(contraction);
+
+  Tensor weights;
+  if (!weights.FromProto(filter_node.attr().at("value").tensor()) ||
+      weights.dims() != (is_conv2d ? 4 : 2)) {
+    return false;
+  }
+  // The kernels take the weights as a [depth, channels] matrix.
+  const bool transpose_b = !is_conv2d &&
+                           contraction.attr().count("transpose_b") &&
+                           contraction.attr().at("transpose_b").b();
+  const int64 channels = weights.dim_size(transpose_b ? 0 : weights.dims() - 1);
+  const int64 depth = weights.NumElements() / channels;
+  auto weight = [&weights, transpose_b, depth, channels](int64 k, int64 j) {
+    return transpose_b ? weights.flat<float>()(j * depth + k)
+                       : weights.flat<float>()(k * channels + j);
+  };
+  Tensor scales(DT_FLOAT, TensorShape({channels}));
+  for (int64 j = 0; j < channels; ++j) {
+    float max_abs = 0;
+    for (int64 k = 0; k < depth; ++k) {
+      max_abs = std::max(max_abs, std::abs(weight(k, j)));
+    }
+    scales.flat<float>()(j) = max_abs > 0 ? max_abs / 127 : 1;
+  }
+  TensorShape quantized_shape = weights.shape();
+  if (transpose_b) quantized_shape = TensorShape({depth, channels});
+  Tensor quantized(DT_QINT8, quantized_shape);
+  for (int64 k = 0; k < depth; ++k) {
+    for (int64 j = 0; j < channels; ++j) {
+      const float value =
+          std::round(weight(k, j) / scales.flat<float>()(j));
+      quantized.flat<qint8>()(k * channels + j) =
+          static_cast<int8>(std::min(127.0f, std::max(-127.0f, value)));
+    }
+  }
+
+  auto add_constant = [&](const string& suffix, const Tensor& value) {
+    NodeDef* node = optimized_graph->add_node();
+    node->set_name(strings::StrCat(root.name(), "/", suffix));
+    node->set_op("Const");
+    node->set_device(contraction.device());
+    for (const string& input : filter_node.input()) {
+      if (IsControlInput(input)) *node->add_input() = input;
+    }
+    (*node->mutable_attr())["dtype"].set_type(value.dtype());
+    value.AsProtoTensorContent(
+        (*node->mutable_attr())["value"].mutable_tensor());
+    return node->name();
+  };
+  const string filter_name = add_constant("int8_filter", quantized);
+  const string scales_name = add_constant("filter_scales", scales);
+
+  NodeDef* fused = optimized_graph->add_node();
+  fused->set_name(root.name());
+  fused->set_op(is_conv2d ? kQuantizedFusedConv2D : kQuantizedFusedMatMul);
+  fused->set_device(contraction.device());
+  *fused->add_input() = contraction.input(0);
+  *fused->add_input() = filter_name;
+  *fused->add_input() = scales_name;
+  *fused->add_input() = matched.bias_add->input(1);
+  for (const NodeDef* node :
+       {matched.contraction, matched.bias_add, matched.activation}) {
+    if (node == nullptr) continue;
+    for (const string& input : node->input()) {
+      if (IsControlInput(input)) *fused->add_input() = input;
+    }
+  }
+
+  auto* attr = fused->mutable_attr();
+  const auto& src_attr = contraction.attr();
+  if (is_conv2d) {
+    for (const string& name :
+         {"strides", "padding", "data_format", "dilations"}) {
+      if (src_attr.count(name)) (*attr)[name] = src_attr.at(name);
+    }
+  }
+  // A calibration tool can record the range of the input to quantize it
+  // with, rather than the range of each batch.
+  if (src_attr.count(kInputRangeAttr)) {
+    (*attr)["input_range"] = src_attr.at(kInputRangeAttr);
+  }
+  (*attr)["num_args"].set_i(1);
+  auto* fused_ops = (*attr)["fused_ops"].mutable_list();
+  fused_ops->add_s("BiasAdd");
+  if (matched.activation != nullptr) {
+    fused_ops->add_s(matched.activation->op());
+  }
+  return true;
+}
+
+// The layer normalization built by tf.contrib.layers.layer_norm, i.e.
+// tf.nn.moments followed by tf.nn.batch_normalization, over the last
+// dimension of `x`:
+//
+//   mean = Mean(x, axis, keep_dims=true)
+//   variance = Mean(SquaredDifference(x, StopGradient(mean)), axis,
+//                   keep_dims=true)
+//   inv = Mul(Rsqrt(Add(variance, epsilon)), scale)
+//   root = Add(Mul(x, inv), Sub(offset, Mul(mean, inv)))
+//
+// which can be replaced by a single _FusedLayerNorm node.
+struct LayerNorm {
+  const NodeDef* root = nullptr;
+  const NodeDef* mean = nullptr;
+  const NodeDef* inv = nullptr;
+  const NodeDef* sub = nullptr;
+  int64 axis = 0;
+  float epsilon = 0;
+  // The nodes that the fused node replaces, other than `root`.
+  std::vector<const NodeDef*> fused;
+};
+
+// Returns the value of the scalar (or single element) constant `node`.
+bool GetSingleConstantValue(const NodeDef& node, double* value) {
+  if (!IsConstant(node)) return false;
+  Tensor t;
+  if (!t.FromProto(node.attr().at("value").tensor()) ||
+      t.NumElements() != 1) {
+    return false;
+  }
+  switch (t.dtype()) {
+    case DT_FLOAT:
+      *value = t.flat<float>()(0);
+      return true;
+    case DT_INT32:
+      *value = t.flat<int32>()(0);
+      return true;
+    case DT_INT64:
+      *value = t.flat<int64>()(0);
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Matches the layer normalization rooted at `node`. The shapes of the inputs
+// are checked separately by LayerNormShapesMatch().
+bool FindLayerNorm(const GraphView& graph,
+                   const std::unordered_set<string>& nodes_to_preserve,
+                   const NodeDef& node, LayerNorm* matched) {
+  if (!IsAdd(node) || GetDataTypeFromAttr(node, "T") != DT_FLOAT) {
+    return false;
+  }
+  auto fanin = [&graph](const NodeDef* n, int i) {
+    return graph.GetRegularFanin(GraphView::InputPort(n, i));
+  };
+  // Returns the `i`th input of `n` if it is an `is_op` node on the device of
+  // the root that feeds nothing but `num_fanouts` consumers in the pattern.
+  auto fused_fanin = [&](const NodeDef* n, int i, bool (*is_op)(const NodeDef&),
+                         size_t num_fanouts) -> const NodeDef* {
+    const NodeDef* input = fanin(n, i).node;
+    if (input == nullptr || !is_op(*input) ||
+        input->device() != node.device() ||
+        nodes_to_preserve.count(input->name()) ||
+        graph.GetFanouts(*input, true).size() != num_fanouts) {
+      return nullptr;
+    }
+    return input;
+  };
+  const NodeDef* mul_x = fused_fanin(&node, 0, IsMul, 1);
+  const NodeDef* sub = fused_fanin(&node, 1, IsSub, 1);
+  if (mul_x == nullptr || sub == nullptr) return false;
+  const NodeDef* mul_mean = fused_fanin(sub, 1, IsMul, 1);
+  const NodeDef* inv = fused_fanin(mul_x, 1, IsMul, 2);
+  if (mul_mean == nullptr || inv == nullptr || fanin(mul_mean, 1).node != inv) {
+    return false;
+  }
+  const NodeDef* mean = fused_fanin(mul_mean, 0, IsMean, 2);
+  const NodeDef* rsqrt = fused_fanin(inv, 0, IsRsqrt, 1);
+  if (mean == nullptr || rsqrt == nullptr) return false;
+  const NodeDef* add_epsilon = fused_fanin(rsqrt, 0, IsAdd, 1);
+  if (add_epsilon == nullptr) return false;
+  const NodeDef* variance = fused_fanin(add_epsilon, 0, IsMean, 1);
+  if (variance == nullptr) return false;
+  const NodeDef* squared_difference =
+      fused_fanin(variance, 0, IsSquaredDifference, 1);
+  if (squared_difference == nullptr) return false;
+  const NodeDef* stop_gradient =
+      fused_fanin(squared_difference, 1, IsStopGradient, 1);
+  if (stop_gradient == nullptr || fanin(stop_gradient, 0).node != mean) {
+    return false;
+  }
+
+  // `x` is the input of the Mul, of the mean, and of the squared difference.
+  const GraphView::OutputPort x = fanin(mul_x, 0);
+  for (const NodeDef* n : {mean, squared_difference}) {
+    const GraphView::OutputPort other = fanin(n, 0);
+    if (other.node != x.node || other.port_id != x.port_id) return false;
+  }
+  // Both moments reduce the same single axis and keep it.
+  double axis, other_axis, epsilon;
+  const NodeDef* epsilon_node = fanin(add_epsilon, 1).node;
+  const NodeDef* axis_node = fanin(mean, 1).node;
+  const NodeDef* other_axis_node = fanin(variance, 1).node;
+  if (epsilon_node == nullptr || axis_node == nullptr ||
+      other_axis_node == nullptr ||
+      !GetSingleConstantValue(*epsilon_node, &epsilon) ||
+      !GetSingleConstantValue(*axis_node, &axis) ||
+      !GetSingleConstantValue(*other_axis_node, &other_axis) ||
+      axis != other_axis) {
+    return false;
+  }
+  for (const NodeDef* n : {mean, variance}) {
+    if (n->attr().count("keep_dims") == 0 || !n->attr().at("keep_dims").b()) {
+      return false;
+    }
+  }
+
+  matched->root = &node;
+  matched->mean = mean;
+  matched->inv = inv;
+  matched->sub = sub;
+  matched->axis = static_cast<int64>(axis);
+  matched->epsilon = static_cast<float>(epsilon);
+  matched->fused = {mul_x,       sub,      mul_mean,
+                    inv,         mean,     rsqrt,
+                    add_epsilon, variance, squared_difference,
+                    stop_gradient};
+  return true;
+}
+
+// Returns true if `matched` normalizes the last dimension of `x`, and its
+// scale and offset are vectors of that dimension, as _FusedLayerNorm
+// requires; the graph would broadcast other shapes.
+bool LayerNormShapesMatch(const GraphProperties& properties,
+                          const LayerNorm& matched) {
+  const auto& mean_inputs = properties.GetInputProperties(matched.mean->name());
+  const auto& inv_inputs = properties.GetInputProperties(matched.inv->name());
+  const auto& sub_inputs = properties.GetInputProperties(matched.sub->name());
+  if (mean_inputs.empty() || inv_inputs.size() != 2 || sub_inputs.empty()) {
+    return false;
+  }
+  const TensorShapeProto& x = mean_inputs[0].shape();
+  if (x.unknown_rank() || x.dim_size() < 1 ||
+      (matched.axis != -1 && matched.axis != x.dim_size() - 1)) {
+    return false;
+  }
+  const int64 depth = x.dim(x.dim_size() - 1).size();
+  for (const TensorShapeProto* vec :
+       {&inv_inputs[1].shape(), &sub_inputs[0].shape()}) {
+    if (depth < 0 || vec->unknown_rank() || vec->dim_size() != 1 ||
+        vec->dim(0).size() != depth) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void AddFusedLayerNormNode(const LayerNorm& matched,
+                           GraphDef* optimized_graph) {
+  NodeDef* fused = optimized_graph->add_node();
+  fused->set_name(matched.root->name());
+  fused->set_op(kFusedLayerNorm);
+  fused->set_device(matched.root->device());
+  *fused->add_input() = matched.mean->input(0);
+  *fused->add_input() = matched.inv->input(1);
+  *fused->add_input() = matched.sub->input(0);
+  // Keep the control dependencies of all the fused nodes.
+  std::vector<const NodeDef*> nodes = matched.fused;
+  nodes.push_back(matched.root);
+  for (const NodeDef* node : nodes) {
+    for (const string& input : node->input()) {
+      if (IsControlInput(input)) *fused->add_input() = input;
+    }
+  }
+  auto* attr = fused->mutable_attr();
+  (*attr)["T"].set_type(DT_FLOAT);
+  (*attr)["epsilon"].set_f(matched.epsilon);
+}
+
+// The scaled dot-product attention of queries, keys and values
+// [batch, heads, length, depth]:
+//
+//   scores = BatchMatMul(query, key, adj_y=true)
+//   root = BatchMatMul(Softmax(Add(Mul(scores, scale), mask)), value)
+//
+// where the Mul by a scalar constant and the Add of the mask are optional,
+// which can be replaced by a single FusedMultiHeadAttention node, without
+// the [batch, heads, query_length, key_length] intermediate tensors.
+struct Attention {
+  const NodeDef* root = nullptr;
+  const NodeDef* scores = nullptr;
+  const NodeDef* mask_add = nullptr;  // Null if there is no mask.
+  int mask_input = 0;
+  float scale = 1;
+  // The nodes that the fused node replaces, other than `root`.
+  std::vector<const NodeDef*> fused;
+};
+
+bool IsBatchMatMul(const NodeDef& node, bool adj_y) {
+  if (node.op() != "BatchMatMul" ||
+      GetDataTypeFromAttr(node, "T") != DT_FLOAT) {
+    return false;
+  }
+  auto flag = [&node](const string& name) {
+    return node.attr().count(name) > 0 && node.attr().at(name).b();
+  };
+  return !flag("adj_x") && flag("adj_y") == adj_y;
+}
+
+// Matches the attention rooted at `node`. The shapes of the inputs are
+// checked separately by AttentionShapesMatch().
+bool FindAttention(const GraphView& graph,
+                   const std::unordered_set<string>& nodes_to_preserve,
+                   const NodeDef& node, Attention* matched) {
+  if (!IsBatchMatMul(node, false)) return false;
+  // Returns the `i`th input of `n` if it is on the device of the root and
+  // feeds nothing but `n`.
+  auto fused_fanin = [&](const NodeDef* n, int i) -> const NodeDef* {
+    const NodeDef* input =
+        graph.GetRegularFanin(GraphView::InputPort(n, i)).node;
+    if (input == nullptr || input->device() != node.device() ||
+        nodes_to_preserve.count(input->name()) ||
+        graph.GetFanouts(*input, true).size() != 1) {
+      return nullptr;
+    }
+    return input;
+  };
+  const NodeDef* softmax = fused_fanin(&node, 0);
+  if (softmax == nullptr || softmax->op() != "Softmax") return false;
+  matched->fused = {softmax};
+  const NodeDef* logits = fused_fanin(softmax, 0);
+  if (logits == nullptr) return false;
+
+  matched->mask_add = nullptr;
+  if (IsAdd(*logits)) {
+    // The mask is the input of the Add that isn't the scores.
+    for (int i = 0; i < 2 && matched->mask_add == nullptr; ++i) {
+      const NodeDef* input = fused_fanin(logits, i);
+      if (input != nullptr && (IsMul(*input) || IsBatchMatMul(*input, true))) {
+        matched->mask_add = logits;
+        matched->mask_input = 1 - i;
+        logits = input;
+      }
+    }
+    if (matched->mask_add == nullptr) return false;
+    matched->fused.push_back(matched->mask_add);
+  }
+
+  matched->scale = 1;
+  if (IsMul(*logits)) {
+    // The scale is the scalar constant input of the Mul.
+    const NodeDef* scores = nullptr;
+    for (int i = 0; i < 2 && scores == nullptr; ++i) {
+      const NodeDef* input = fused_fanin(logits, i);
+      const NodeDef* other =
+          graph.GetRegularFanin(GraphView::InputPort(logits, 1 - i)).node;
+      double scale;
+      if (input != nullptr && IsBatchMatMul(*input, true) &&
+          other != nullptr && GetSingleConstantValue(*other, &scale)) {
+        matched->scale = static_cast<float>(scale);
+        scores = input;
+      }
+    }
+    if (scores == nullptr) return false;
+    matched->fused.push_back(logits);
+    logits = scores;
+  }
+  if (!IsBatchMatMul(*logits, true)) return false;
+  matched->scores = logits;
+  matched->fused.push_back(logits);
+  matched->root = &node;
+  return true;
+}
+
+// Returns true if the inputs of `matched` are 4-D, and its mask can be
+// broadcast to the [batch, heads, query_length, key_length] scores along its
+// first three dimensions, as FusedMultiHeadAttention requires.
+bool AttentionShapesMatch(const GraphProperties& properties,
+                          const Attention& matched) {
+  const auto& scores_inputs =
+      properties.GetInputProperties(matched.scores->name());
+  const auto& root_inputs = properties.GetInputProperties(matched.root->name());
+  if (scores_inputs.size() != 2 || root_inputs.size() != 2) return false;
+  const TensorShapeProto& query = scores_inputs[0].shape();
+  const TensorShapeProto& key = scores_inputs[1].shape();
+  const TensorShapeProto& value = root_inputs[1].shape();
+  for (const TensorShapeProto* shape : {&query, &key, &value}) {
+    if (shape->unknown_rank() || shape->dim_size() != 4) return false;
+  }
+  if (matched.mask_add == nullptr) return true;
+
+  const auto& add_inputs =
+      properties.GetInputProperties(matched.mask_add->name());
+  if (add_inputs.size() != 2) return false;
+  const TensorShapeProto& mask = add_inputs[matched.mask_input].shape();
+  if (mask.unknown_rank() || mask.dim_size() != 4 ||
+      mask.dim(3).size() < 0 || mask.dim(3).size() != key.dim(2).size()) {
+    return false;
+  }
+  for (int i = 0; i < 3; ++i) {
+    const int64 size = mask.dim(i).size();
+    if (size != 1 && (size < 0 || size != query.dim(i).size())) return false;
+  }
+  return true;
+}
+
+void AddFusedAttentionNode(const Attention& matched,
+                           GraphDef* optimized_graph) {
+  NodeDef* fused = optimized_graph->add_node();
+  fused->set_name(matched.root->name());
+  fused->set_op(kFusedMultiHeadAttention);
+  fused->set_device(matched.root->device());
+  *fused->add_input() = matched.scores->input(0);
+  *fused->add_input() = matched.scores->input(1);
+  *fused->add_input() = matched.root->input(1);
+  if (matched.mask_add != nullptr) {
+    *fused->add_input() = matched.mask_add->input(matched.mask_input);
+  }
+  // Keep the control dependencies of all the fused nodes.
+  std::vector<const NodeDef*> nodes = matched.fused;
+  nodes.push_back(matched.root);
+  for (const NodeDef* node : nodes) {
+    for (const string& input : node->input()) {
+      if (IsControlInput(input)) *fused->add_input() = input;
+    }
+  }
+  auto* attr = fused->mutable_attr();
+  (*attr)["T"].set_type(DT_FLOAT);
+  (*attr)["num_cache"].set_i(0);
+  (*attr)["num_mask"].set_i(matched.mask_add != nullptr ? 1 : 0);
+  (*attr)["scale"].set_f(matched.scale);
+  (*attr)["causal"].set_b(false);
+}
+
+}  // namespace
+
 void AddBatchNormNodes(GraphDef* optimized_graph, const NodeDef& fused_node) {
   const string& x = fused_node.input(0);
   string scale = fused_node.input(1);
@@ -171,10 +760,102 @@ Status Remapper::Optimize(Cluster* /*cluster*/, const GrapplerItem& item,
   bool inferred_properties = false;
   GraphView graph(const_cast<GraphDef*>(&item.graph));
 
+  // Find the Conv2D/MatMul + BiasAdd (+ activation) chains to fuse, keyed by
+  // the name of their last node, which the fused node replaces. Chains ending
+  // in an activation are matched first so that their BiasAdd is not fused on
+  // its own.
+  std::unordered_map<string, FusedContraction> fused_contractions;
+  std::unordered_set<string> fused_nodes;
+  const std::unordered_set<string> nodes_to_preserve = item.NodesToPreserve();
+#ifndef INTEL_MKL
+  // MKL builds rewrite Conv2D and MatMul into their own kernels instead.
+  for (int pass = 0; pass < 2; ++pass) {
+    for (const NodeDef& node : item.graph.node()) {
+      if (fused_nodes.count(node.name())) continue;
+      FusedContraction matched;
+      const bool found =
+          pass == 0 ? FindContractionWithBiasAndActivation(
+                          graph, nodes_to_preserve, node, &matched)
+                    : FindContractionWithBias(graph, nodes_to_preserve, node,
+                                              &matched);
+      if (!found || fused_nodes.count(matched.contraction->name()) ||
+          fused_nodes.count(matched.bias_add->name())) {
+        continue;
+      }
+      fused_nodes.insert(matched.contraction->name());
+      fused_nodes.insert(matched.bias_add->name());
+      if (matched.activation != nullptr) {
+        fused_nodes.insert(matched.activation->name());
+      }
+      fused_contractions[node.name()] = matched;
+    }
+  }
+#endif  // !INTEL_MKL
+
+  // Find the layer normalizations to fuse, keyed by the name of their root.
+  std::unordered_map<string, LayerNorm> layer_norms;
+  for (const NodeDef& node : item.graph.node()) {
+    LayerNorm matched;
+    if (!FindLayerNorm(graph, nodes_to_preserve, node, &matched)) continue;
+    if (!inferred_properties) {
+      TF_RETURN_IF_ERROR(properties.InferStatically(false));
+      inferred_properties = true;
+    }
+    if (!LayerNormShapesMatch(properties, matched)) continue;
+    for (const NodeDef* fused : matched.fused) {
+      fused_nodes.insert(fused->name());
+    }
+    layer_norms[node.name()] = matched;
+  }
+
+  // Find the attentions to fuse, keyed by the name of their root.
+  std::unordered_map<string, Attention> attentions;
+  for (const NodeDef& node : item.graph.node()) {
+    Attention matched;
+    if (!FindAttention(graph, nodes_to_preserve, node, &matched)) continue;
+    if (!inferred_properties) {
+      TF_RETURN_IF_ERROR(properties.InferStatically(false));
+      inferred_properties = true;
+    }
+    if (!AttentionShapesMatch(properties, matched)) continue;
+    for (const NodeDef* fused : matched.fused) {
+      fused_nodes.insert(fused->name());
+    }
+    attentions[node.name()] = matched;
+  }
+
   // During inference, most of the inputs to FusedBatchNorm are constant, and we
   // can therefore replace the op with a much cheaper set of primitives.
   optimized_graph->mutable_node()->Reserve(item.graph.node_size());
   for (const NodeDef& node : item.graph.node()) {
+    auto it = fused_contractions.find(node.name());
+    if (it != fused_contractions.end()) {
+      VLOG(1) << "Fusing " << it->second.contraction->op() << " into "
+              << node.name();
+      const NodeDef* int8_filter =
+          int8_inference_ == RewriterConfig::ON
+              ? FindInt8FilterConstant(graph, *it->second.contraction)
+              : nullptr;
+      if (int8_filter == nullptr ||
+          !AddQuantizedFusedContractionNode(it->second, *int8_filter,
+                                            optimized_graph)) {
+        AddFusedContractionNode(it->second, optimized_graph);
+      }
+      continue;
+    }
+    auto layer_norm = layer_norms.find(node.name());
+    if (layer_norm != layer_norms.end()) {
+      VLOG(1) << "Fusing layer normalization into " << node.name();
+      AddFusedLayerNormNode(layer_norm->second, optimized_graph);
+      continue;
+    }
+    auto attention = attentions.find(node.name());
+    if (attention != attentions.end()) {
+      VLOG(1) << "Fusing attention into " << node.name();
+      AddFusedAttentionNode(attention->second, optimized_graph);
+      continue;
+    }
+    if (fused_nodes.count(node.name())) continue;
     if (node.op() == "FusedBatchNorm" || node.op() == "FusedBatchNormV2") {
       bool optimizable = (node.attr().count("T") == 0 ||
                           node.attr().at("T").type() == DT_FLOAT);
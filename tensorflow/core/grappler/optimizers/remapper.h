@@ -26,7 +26,11 @@ namespace grappler {
 // nodes to decrease the amount of operations needed to perform a computation.
 class Remapper : public GraphOptimizer {
  public:
-  explicit Remapper(RewriterConfig::Toggle opt_level) : opt_level_(opt_level) {}
+  // If "int8_inference" is ON, the fused Conv2D/MatMul chains with constant
+  // float weights use int8 kernels instead.
+  explicit Remapper(RewriterConfig::Toggle opt_level,
+                    RewriterConfig::Toggle int8_inference = RewriterConfig::OFF)
+      : opt_level_(opt_level), int8_inference_(int8_inference) {}
 
   ~Remapper() override {}
 
@@ -40,6 +44,7 @@ class Remapper : public GraphOptimizer {
 
  private:
   RewriterConfig::Toggle opt_level_;
+  RewriterConfig::Toggle int8_inference_;
 };
 
 }  // end namespace grappler
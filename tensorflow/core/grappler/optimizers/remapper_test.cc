@@ -24,7 +24,39 @@ limitations under the License.
 namespace tensorflow {
 namespace grappler {
 
-class RemapperTest : public GrapplerTest {};
+class RemapperTest : public GrapplerTest {
+ protected:
+  // Returns a float tensor with values in [-0.5, 0.5).
+  Tensor RandomTensor(const TensorShape& shape) const {
+    Tensor tensor(DT_FLOAT, shape);
+    tensor.flat<float>().setRandom();
+    tensor.flat<float>() -= tensor.flat<float>().constant(0.5f);
+    return tensor;
+  }
+
+  // Places all the nodes of `graph` on the CPU, where the fused contraction
+  // kernels are implemented.
+  void PlaceOnCpu(GraphDef* graph) const {
+    for (int i = 0; i < graph->node_size(); ++i) {
+      graph->mutable_node(i)->set_device("/device:CPU:0");
+    }
+  }
+
+  // Checks that `node` is a fused contraction of op `op` applying
+  // `fused_ops` to the product of `a` and `b`.
+  void ExpectFusedContraction(const NodeDef& node, const string& op,
+                              const string& a, const string& b,
+                              const std::vector<string>& fused_ops) const {
+    EXPECT_EQ(op, node.op());
+    ASSERT_EQ(3, node.input_size());
+    EXPECT_EQ(a, node.input(0));
+    EXPECT_EQ(b, node.input(1));
+    EXPECT_EQ("bias", node.input(2));
+    EXPECT_EQ(1, node.attr().at("num_args").i());
+    const auto& ops = node.attr().at("fused_ops").list().s();
+    EXPECT_EQ(fused_ops, std::vector<string>(ops.begin(), ops.end()));
+  }
+};
 
 TEST_F(RemapperTest, FusedBatchNorm) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
@@ -91,5 +123,324 @@ TEST_F(RemapperTest, FusedBatchNormNCHW) {
   }
 }
 
+TEST_F(RemapperTest, FuseConv2DWithBiasAndActivation) {
+  for (const string& activation : {"Relu", "Relu6"}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    auto input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT);
+    auto filter = ops::Placeholder(s.WithOpName("filter"), DT_FLOAT);
+    auto bias = ops::Placeholder(s.WithOpName("bias"), DT_FLOAT);
+    auto conv = ops::Conv2D(s.WithOpName("conv"), input, filter, {1, 1, 1, 1},
+                            "SAME");
+    auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), conv, bias);
+    Output activate =
+        activation == "Relu"
+            ? ops::Relu(s.WithOpName("activation"), bias_add).activations
+            : ops::Relu6(s.WithOpName("activation"), bias_add).activations;
+    ops::Identity(s.WithOpName("fetch"), activate);
+
+    GrapplerItem item;
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    PlaceOnCpu(&item.graph);
+    item.fetch = {"fetch"};
+    item.feed = {{"input", RandomTensor({2, 8, 8, 3})},
+                 {"filter", RandomTensor({3, 3, 3, 16})},
+                 {"bias", RandomTensor({16})}};
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE("conv", node.name());
+      EXPECT_NE("bias_add", node.name());
+      if (node.name() == "activation") {
+        ExpectFusedContraction(node, "_FusedConv2D", "input", "filter",
+                               {"BiasAdd", activation});
+        EXPECT_EQ("SAME", node.attr().at("padding").s());
+        ++found;
+      }
+    }
+    EXPECT_EQ(1, found);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(1, tensors_expected.size());
+    ASSERT_EQ(1, tensors.size());
+    test::ExpectTensorNear<float>(tensors_expected[0], tensors[0], 1e-5);
+  }
+}
+
+TEST_F(RemapperTest, FuseMatMulWithBiasAndActivation) {
+  for (const string& activation : {"", "Relu", "Relu6"}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    auto a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+    auto b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT);
+    auto bias = ops::Placeholder(s.WithOpName("bias"), DT_FLOAT);
+    auto matmul = ops::MatMul(s.WithOpName("matmul"), a, b,
+                              ops::MatMul::TransposeB(true));
+    Output last = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+    if (activation == "Relu") {
+      last = ops::Relu(s.WithOpName("activation"), last);
+    } else if (activation == "Relu6") {
+      last = ops::Relu6(s.WithOpName("activation"), last);
+    }
+    ops::Identity(s.WithOpName("fetch"), last);
+
+    GrapplerItem item;
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    PlaceOnCpu(&item.graph);
+    item.fetch = {"fetch"};
+    item.feed = {{"a", RandomTensor({8, 32})},
+                 {"b", RandomTensor({64, 32})},
+                 {"bias", RandomTensor({64})}};
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+
+    const string fused_name = activation.empty() ? "bias_add" : "activation";
+    std::vector<string> fused_ops = {"BiasAdd"};
+    if (!activation.empty()) fused_ops.push_back(activation);
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE("matmul", node.name());
+      if (node.name() == fused_name) {
+        ExpectFusedContraction(node, "_FusedMatMul", "a", "b", fused_ops);
+        EXPECT_TRUE(node.attr().at("transpose_b").b());
+        ++found;
+      }
+    }
+    EXPECT_EQ(1, found);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(1, tensors_expected.size());
+    ASSERT_EQ(1, tensors.size());
+    test::ExpectTensorNear<float>(tensors_expected[0], tensors[0], 1e-5);
+  }
+}
+
+TEST_F(RemapperTest, QuantizeContractionsWithConstantFilters) {
+  for (const string& op : {"Conv2D", "MatMul"}) {
+    const bool is_conv2d = op == "Conv2D";
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    auto input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT);
+    auto filter = ops::Const(
+        s.WithOpName("filter"),
+        Input::Initializer(is_conv2d ? RandomTensor({3, 3, 3, 16})
+                                     : RandomTensor({16, 32})));
+    auto bias = ops::Placeholder(s.WithOpName("bias"), DT_FLOAT);
+    Output contraction =
+        is_conv2d ? ops::Conv2D(s.WithOpName("contraction"), input, filter,
+                                {1, 2, 2, 1}, "SAME")
+                        .output
+                  : ops::MatMul(s.WithOpName("contraction"), input, filter,
+                                ops::MatMul::TransposeB(true))
+                        .product;
+    auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), contraction, bias);
+    auto relu = ops::Relu(s.WithOpName("activation"), bias_add);
+    ops::Identity(s.WithOpName("fetch"), relu);
+
+    GrapplerItem item;
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    PlaceOnCpu(&item.graph);
+    item.fetch = {"fetch"};
+    item.feed = {{"input", is_conv2d ? RandomTensor({2, 8, 8, 3})
+                                     : RandomTensor({8, 32})},
+                 {"bias", RandomTensor({16})}};
+
+    Remapper optimizer(RewriterConfig::ON, RewriterConfig::ON);
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE("contraction", node.name());
+      if (node.name() == "activation") {
+        EXPECT_EQ(is_conv2d ? "_QuantizedFusedConv2D" : "_QuantizedFusedMatMul",
+                  node.op());
+        ASSERT_EQ(4, node.input_size());
+        EXPECT_EQ("input", node.input(0));
+        EXPECT_EQ("activation/int8_filter", node.input(1));
+        EXPECT_EQ("activation/filter_scales", node.input(2));
+        EXPECT_EQ("bias", node.input(3));
+        ++found;
+      }
+    }
+    EXPECT_EQ(1, found);
+
+    // The results differ by the rounding of the input and the filter to
+    // 8 bits.
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(1, tensors_expected.size());
+    ASSERT_EQ(1, tensors.size());
+    test::ExpectTensorNear<float>(tensors_expected[0], tensors[0], 2e-2);
+  }
+}
+
+TEST_F(RemapperTest, FuseLayerNorm) {
+  // The graph of tf.contrib.layers.layer_norm over the last dimension, or the
+  // same graph over the first one, which _FusedLayerNorm doesn't implement.
+  for (int axis : {-1, 0}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape({8, 64}));
+    const int depth = 64;
+    auto scale = ops::Placeholder(s.WithOpName("scale"), DT_FLOAT,
+                                  ops::Placeholder::Shape({depth}));
+    auto offset = ops::Placeholder(s.WithOpName("offset"), DT_FLOAT,
+                                   ops::Placeholder::Shape({depth}));
+    auto axes = ops::Const(s.WithOpName("axes"), {axis});
+    auto mean = ops::Mean(s.WithOpName("mean"), x, axes,
+                          ops::Mean::KeepDims(true));
+    auto stop_gradient = ops::StopGradient(s.WithOpName("stop"), mean);
+    auto squared_difference =
+        ops::SquaredDifference(s.WithOpName("diff"), x, stop_gradient);
+    auto variance = ops::Mean(s.WithOpName("variance"), squared_difference,
+                              axes, ops::Mean::KeepDims(true));
+    auto epsilon = ops::Const(s.WithOpName("epsilon"), 1e-3f);
+    auto rsqrt = ops::Rsqrt(s.WithOpName("rsqrt"),
+                            ops::Add(s.WithOpName("add"), variance, epsilon));
+    auto inv = ops::Mul(s.WithOpName("inv"), rsqrt, scale);
+    auto mul_x = ops::Mul(s.WithOpName("mul_x"), x, inv);
+    auto mul_mean = ops::Mul(s.WithOpName("mul_mean"), mean, inv);
+    auto sub = ops::Sub(s.WithOpName("sub"), offset, mul_mean);
+    auto layer_norm = ops::Add(s.WithOpName("layer_norm"), mul_x, sub);
+    ops::Identity(s.WithOpName("fetch"), layer_norm);
+
+    GrapplerItem item;
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    PlaceOnCpu(&item.graph);
+    item.fetch = {"fetch"};
+    item.feed = {{"x", RandomTensor({8, 64})},
+                 {"scale", RandomTensor({depth})},
+                 {"offset", RandomTensor({depth})}};
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+
+    if (axis != -1) {
+      EXPECT_EQ(0, CountOpNodes(output, "_FusedLayerNorm"));
+      continue;
+    }
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE("mean", node.name());
+      EXPECT_NE("inv", node.name());
+      if (node.name() == "layer_norm") {
+        EXPECT_EQ("_FusedLayerNorm", node.op());
+        ASSERT_EQ(3, node.input_size());
+        EXPECT_EQ("x", node.input(0));
+        EXPECT_EQ("scale", node.input(1));
+        EXPECT_EQ("offset", node.input(2));
+        EXPECT_FLOAT_EQ(1e-3f, node.attr().at("epsilon").f());
+        ++found;
+      }
+    }
+    EXPECT_EQ(1, found);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(1, tensors_expected.size());
+    ASSERT_EQ(1, tensors.size());
+    test::ExpectTensorNear<float>(tensors_expected[0], tensors[0], 1e-5);
+  }
+}
+
+TEST_F(RemapperTest, FuseAttention) {
+  for (bool with_mask : {false, true}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    auto shape = ops::Placeholder::Shape({2, 4, 10, 16});
+    auto query = ops::Placeholder(s.WithOpName("query"), DT_FLOAT, shape);
+    auto key = ops::Placeholder(s.WithOpName("key"), DT_FLOAT, shape);
+    auto value = ops::Placeholder(s.WithOpName("value"), DT_FLOAT, shape);
+    auto mask = ops::Placeholder(s.WithOpName("mask"), DT_FLOAT,
+                                 ops::Placeholder::Shape({2, 1, 1, 10}));
+    auto scores = ops::BatchMatMul(s.WithOpName("scores"), query, key,
+                                   ops::BatchMatMul::AdjY(true));
+    Output logits = ops::Mul(s.WithOpName("scaled"), scores,
+                             ops::Const(s.WithOpName("scale"), 0.25f));
+    if (with_mask) logits = ops::Add(s.WithOpName("masked"), logits, mask);
+    auto softmax = ops::Softmax(s.WithOpName("softmax"), logits);
+    auto attention =
+        ops::BatchMatMul(s.WithOpName("attention"), softmax, value);
+    ops::Identity(s.WithOpName("fetch"), attention);
+
+    GrapplerItem item;
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    PlaceOnCpu(&item.graph);
+    item.fetch = {"fetch"};
+    item.feed = {{"query", RandomTensor({2, 4, 10, 16})},
+                 {"key", RandomTensor({2, 4, 10, 16})},
+                 {"value", RandomTensor({2, 4, 10, 16})},
+                 {"mask", RandomTensor({2, 1, 1, 10})}};
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE("scores", node.name());
+      EXPECT_NE("softmax", node.name());
+      if (node.name() == "attention") {
+        EXPECT_EQ("FusedMultiHeadAttention", node.op());
+        ASSERT_EQ(with_mask ? 4 : 3, node.input_size());
+        EXPECT_EQ("query", node.input(0));
+        EXPECT_EQ("key", node.input(1));
+        EXPECT_EQ("value", node.input(2));
+        if (with_mask) EXPECT_EQ("mask", node.input(3));
+        EXPECT_EQ(with_mask ? 1 : 0, node.attr().at("num_mask").i());
+        EXPECT_FLOAT_EQ(0.25f, node.attr().at("scale").f());
+        ++found;
+      }
+    }
+    EXPECT_EQ(1, found);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(1, tensors_expected.size());
+    ASSERT_EQ(1, tensors.size());
+    test::ExpectTensorNear<float>(tensors_expected[0], tensors[0], 1e-5);
+  }
+}
+
+TEST_F(RemapperTest, DoesNotFuseFetchedOrUnplacedNodes) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT);
+  auto filter = ops::Placeholder(s.WithOpName("filter"), DT_FLOAT);
+  auto bias = ops::Placeholder(s.WithOpName("bias"), DT_FLOAT);
+  auto conv = ops::Conv2D(s.WithOpName("conv"), input, filter, {1, 1, 1, 1},
+                          "VALID");
+  auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), conv, bias);
+  auto relu = ops::Relu(s.WithOpName("relu"), bias_add);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  // Fetching bias_add keeps it from being fused into relu, but the Conv2D
+  // can still be fused into it.
+  item.fetch = {"bias_add", "relu"};
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(0, CountOpNodes(output, "_FusedConv2D"));
+
+  PlaceOnCpu(&item.graph);
+  GraphDef placed_output;
+  TF_CHECK_OK(optimizer.Optimize(nullptr, item, &placed_output));
+  EXPECT_EQ(1, CountOpNodes(placed_output, "_FusedConv2D"));
+  EXPECT_EQ(1, CountOpNodes(placed_output, "Relu"));
+  for (const NodeDef& node : placed_output.node()) {
+    if (node.name() == "bias_add") {
+      ExpectFusedContraction(node, "_FusedConv2D", "input", "filter",
+                             {"BiasAdd"});
+    }
+  }
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
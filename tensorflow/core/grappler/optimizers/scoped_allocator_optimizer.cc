@@ -651,7 +651,7 @@ class UnaryElementwiseRewriter : public ScopedAllocatorOptimizer::Rewriter {
 
 ScopedAllocatorOptimizer::ScopedAllocatorOptimizer(
     RewriterConfig::Toggle opt_level, const ScopedAllocatorOptions& opts)
-    : opt_level_(opt_level) {
+    : opt_level_(opt_level), max_bucket_bytes_(opts.max_bucket_bytes()) {
   VLOG(1) << "ScopedAllocatorOptimizer::ScopedAllocatorOptimizer";
   Rewriter* r = new UnaryElementwiseRewriter();
   to_delete_.push_back(r);
@@ -812,6 +812,35 @@ void PartitionByLoopStructure(const FrameMap& frame_map,
   }
 }
 
+// Splits nodes, already in their final order, into consecutive groups
+// whose outputs total at most max_bytes, so that each group can be
+// coalesced separately.  A node whose output alone exceeds max_bytes ends
+// up in a group of its own.  Nodes without a fully known output shape are
+// counted as empty; coalescing them is rejected later anyway.
+void PartitionBySize(const GraphProperties& graph_properties, int64 max_bytes,
+                     const std::vector<NodeDef*>& nodes,
+                     std::vector<std::vector<NodeDef*>>* size_groups) {
+  int64 group_bytes = 0;
+  for (NodeDef* nd : nodes) {
+    int64 node_bytes = 0;
+    if (graph_properties.HasOutputProperties(nd->name())) {
+      const std::vector<OpInfo::TensorProperties>& prop_list =
+          graph_properties.GetOutputProperties(nd->name());
+      if (prop_list.size() == 1 &&
+          TensorShape::IsValid(prop_list[0].shape())) {
+        node_bytes = TensorShape(prop_list[0].shape()).num_elements() *
+                     DataTypeSize(prop_list[0].dtype());
+      }
+    }
+    if (size_groups->empty() || group_bytes + node_bytes > max_bytes) {
+      size_groups->emplace_back();
+      group_bytes = 0;
+    }
+    size_groups->back().push_back(nd);
+    group_bytes += node_bytes;
+  }
+}
+
 }  // namespace
 
 Status ScopedAllocatorOptimizer::ProcessGraphDef(
@@ -841,26 +870,42 @@ Status ScopedAllocatorOptimizer::ProcessGraphDef(
         // Nodes with a common depth and root path are now grouped
         // in the same Tree struct.  Split those groups into subgroups that
         // share identical loop nesting.
-        status = ApplyToAll(
-            root.get(), [this, rewriter, graph, &frame_map, &op_name](Tree* t) {
-              VLOG(2) << "applied to tree node " << t->edge_ << " at depth "
-                      << t->depth_ << " of size " << t->nodes_.size();
-              if (t->nodes_.size() > 1) {
-                std::vector<std::vector<NodeDef*>> loop_groups;
-                PartitionByLoopStructure(frame_map, t->nodes_, &loop_groups);
-                for (auto& lg : loop_groups) {
-                  if (lg.size() > 1) {
+        status = ApplyToAll(root.get(), [this, rewriter, graph,
+                                         &graph_properties, &frame_map,
+                                         &op_name](Tree* t) {
+          VLOG(2) << "applied to tree node " << t->edge_ << " at depth "
+                  << t->depth_ << " of size " << t->nodes_.size();
+          if (t->nodes_.size() > 1) {
+            std::vector<std::vector<NodeDef*>> loop_groups;
+            PartitionByLoopStructure(frame_map, t->nodes_, &loop_groups);
+            for (auto& lg : loop_groups) {
+              if (lg.size() > 1) {
+                Status s = OrderNodeSet(&lg);
+                TF_RETURN_IF_ERROR(s);
+                // Bounding the size of each coalesced group lets the
+                // earlier groups run while the inputs of later ones are
+                // still being computed.
+                std::vector<std::vector<NodeDef*>> size_groups;
+                if (max_bucket_bytes_ > 0) {
+                  PartitionBySize(graph_properties, max_bucket_bytes_, lg,
+                                  &size_groups);
+                } else {
+                  size_groups.push_back(lg);
+                }
+                for (auto& sg : size_groups) {
+                  if (sg.size() > 1) {
                     bool applied = false;
-                    Status s = OrderNodeSet(&lg);
-                    TF_RETURN_IF_ERROR(s);
-                    VLOG(1) << "Applying Rewriter for " << op_name;
-                    s = rewriter->Rewrite(this, graph, op_name, lg, &applied);
+                    VLOG(1) << "Applying Rewriter for " << op_name << " to "
+                            << sg.size() << " nodes";
+                    s = rewriter->Rewrite(this, graph, op_name, sg, &applied);
                     LOG_WARNING_AND_RETURN_IF_ERROR(s);
                   }
                 }
               }
-              return Status::OK();
-            });
+            }
+          }
+          return Status::OK();
+        });
         if (!status.ok()) {
           break;
         }
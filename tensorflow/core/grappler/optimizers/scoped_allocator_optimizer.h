@@ -95,6 +95,9 @@ class ScopedAllocatorOptimizer : public GraphOptimizer {
   Status OrderNodeSet(std::vector<NodeDef*>* nodes) const;
 
   RewriterConfig::Toggle opt_level_;
+  // Upper bound on the combined output size of a coalesced group, or 0 for
+  // no bound.  See ScopedAllocatorOptions.max_bucket_bytes.
+  const int64 max_bucket_bytes_;
   std::unordered_set<string> nodes_to_preserve_;
   OpNameSet op_name_set_;
   std::unordered_map<string, Rewriter*> rewriters_;
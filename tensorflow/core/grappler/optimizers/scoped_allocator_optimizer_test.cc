@@ -217,6 +217,41 @@ TEST_F(ScopedAllocatorOptimizerTest, UnaryExecute) {
   }
 }
 
+TEST_F(ScopedAllocatorOptimizerTest, BucketedRewrite) {
+  // Three parallel Abs ops on 16-byte inputs with room for two per group:
+  // a1 and a2 are coalesced and a3 is left as it was.
+  GrapplerItem item;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  s = s.WithDevice("/job:localhost/replica:0/task:0/device:CPU:0");
+  Output a =
+      ops::Const<float>(s.WithOpName("a"), {1.0, 0.0, 0.0, -1.0}, {2, 2});
+  Output b =
+      ops::Const<float>(s.WithOpName("b"), {1.0, -2.0, 3.0, 4.0}, {2, 2});
+  Output s1 = ops::Add(s.WithOpName("s1"), a, b);
+  Output s2 = ops::Add(s.WithOpName("s2"), b, a);
+  Output s3 = ops::Add(s.WithOpName("s3"), a, a);
+  Output a1 = ops::Abs(s.WithOpName("a1"), s1);
+  Output a2 = ops::Abs(s.WithOpName("a2"), s2);
+  Output a3 = ops::Abs(s.WithOpName("a3"), s3);
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  SetShapes(&item.graph);
+
+  ScopedAllocatorOptions opts;
+  opts.add_enable_op("Abs");
+  opts.set_max_bucket_bytes(2 * 4 * sizeof(float));
+  ScopedAllocatorOptimizer sao(RewriterConfig::ON, opts);
+
+  GraphDef optimized_graph;
+  TF_ASSERT_OK(sao.Optimize(nullptr /*cluster*/, item, &optimized_graph));
+
+  NodeMap node_map(&optimized_graph);
+  EXPECT_NE(nullptr, node_map.GetNode("scoped_allocator_1_Abs"));
+  EXPECT_EQ(nullptr, node_map.GetNode("a1"));
+  EXPECT_EQ(nullptr, node_map.GetNode("a2"));
+  EXPECT_NE(nullptr, node_map.GetNode("a3"));
+  EXPECT_EQ(nullptr, node_map.GetNode("scoped_allocator_4"));
+}
+
 // Tests static ScopedAllocatorOptimizer::ExtendNodeAttr.
 // Maybe this should be moved elsewhere?
 TEST_F(ScopedAllocatorOptimizerTest, Extend) {
@@ -0,0 +1,119 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/transfer_priority_optimizer.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Returns the task of "device", e.g. "/job:ps/replica:0/task:1", or an empty
+// string if "device" is not a full device name.
+string TaskOf(const string& device) {
+  string task;
+  string unused;
+  if (!DeviceNameUtils::SplitDeviceName(device, &task, &unused)) return "";
+  return task;
+}
+
+}  // namespace
+
+Status TransferPriorityOptimizer::Optimize(Cluster* cluster,
+                                           const GrapplerItem& item,
+                                           GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  if (opt_level_ == RewriterConfig::OFF) {
+    return Status::OK();
+  }
+
+  std::unordered_map<const NodeDef*, int> topo_order;
+  TF_RETURN_IF_ERROR(
+      ComputeTopologicalOrder(item.graph, &topo_order, nullptr));
+  const int num_nodes = item.graph.node_size();
+  std::vector<const NodeDef*> sorted(num_nodes);
+  for (const auto& entry : topo_order) {
+    sorted[entry.second] = entry.first;
+  }
+
+  std::unordered_map<string, int> node_index;
+  std::vector<string> tasks(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    node_index[sorted[i]->name()] = i;
+    tasks[i] = TaskOf(sorted[i]->device());
+  }
+
+  // Whether each node depends on another task, and the position of the
+  // first consumer on another task of each node.
+  std::vector<bool> depends_on_remote(num_nodes, false);
+  std::vector<int> first_remote_use(num_nodes,
+                                    std::numeric_limits<int>::max());
+  bool has_remote_uses = false;
+  for (int i = 0; i < num_nodes; ++i) {
+    for (const string& input : sorted[i]->input()) {
+      auto iter = node_index.find(NodeName(input));
+      if (iter == node_index.end()) continue;
+      const int src = iter->second;
+      if (tasks[src] != tasks[i] || depends_on_remote[src]) {
+        depends_on_remote[i] = true;
+      }
+      if (!IsControlInput(input) && !tasks[src].empty() &&
+          !tasks[i].empty() && tasks[src] != tasks[i]) {
+        first_remote_use[src] = std::min(first_remote_use[src], i);
+        has_remote_uses = true;
+      }
+    }
+  }
+  if (!has_remote_uses) {
+    return Status::OK();
+  }
+
+  std::vector<std::pair<int, int>> transfers;  // (first remote use, node)
+  for (int i = 0; i < num_nodes; ++i) {
+    if (first_remote_use[i] != std::numeric_limits<int>::max() &&
+        !depends_on_remote[i]) {
+      transfers.emplace_back(first_remote_use[i], i);
+    }
+  }
+  std::sort(transfers.begin(), transfers.end());
+
+  std::unordered_map<string, int> priorities;
+  for (int rank = 0; rank < transfers.size(); ++rank) {
+    priorities[sorted[transfers[rank].second]->name()] = rank;
+  }
+  for (NodeDef& node : *optimized_graph->mutable_node()) {
+    auto iter = priorities.find(node.name());
+    if (iter != priorities.end()) {
+      (*node.mutable_attr())["_transfer_priority"].set_i(iter->second);
+    }
+  }
+  return Status::OK();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,61 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_TRANSFER_PRIORITY_OPTIMIZER_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_TRANSFER_PRIORITY_OPTIMIZER_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Ranks the tensors sent between tasks by how early the step needs them.
+// Every node with an output consumed on another task, and that depends on
+// no other task itself (typically a parameter read on a parameter server),
+// gets a "_transfer_priority" attribute: the rank of its first remote
+// consumer in the topological order of the graph, 0 being needed first.
+// Graph partitioning copies the attribute to the _Send and _Recv nodes of
+// the transfer, and the RPC rendezvous starts prioritized receives in
+// increasing order of priority, so that the forward pass can start on the
+// first layers while the parameters of the last ones are still in flight.
+//
+// Because the ranked tensors depend on no other task, they can all be
+// produced without any receive, and holding some receives back to order
+// the others cannot deadlock the step.
+class TransferPriorityOptimizer : public GraphOptimizer {
+ public:
+  TransferPriorityOptimizer() : opt_level_(RewriterConfig::ON) {}
+  explicit TransferPriorityOptimizer(RewriterConfig::Toggle opt_level)
+      : opt_level_(opt_level) {}
+
+  ~TransferPriorityOptimizer() override {}
+
+  string name() const override { return "transfer_priority_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override {}
+
+ private:
+  RewriterConfig::Toggle opt_level_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_TRANSFER_PRIORITY_OPTIMIZER_H_
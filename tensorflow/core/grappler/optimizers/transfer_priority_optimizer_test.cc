@@ -0,0 +1,95 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/transfer_priority_optimizer.h"
+
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+
+constexpr char kPs[] = "/job:ps/replica:0/task:0/device:CPU:0";
+constexpr char kWorker[] = "/job:worker/replica:0/task:0/device:CPU:0";
+
+NodeDef Parameter(const string& name, const string& device) {
+  return NDef(name, "Placeholder", {}, {{"dtype", DT_FLOAT}}, device);
+}
+
+NodeDef Mul(const string& name, const string& a, const string& b,
+            const string& device) {
+  return NDef(name, "Mul", {a, b}, {{"T", DT_FLOAT}}, device);
+}
+
+// Returns the _transfer_priority of "name" in "graph", or -1.
+int64 PriorityOf(const GraphDef& graph, const string& name) {
+  for (const NodeDef& node : graph.node()) {
+    if (node.name() == name) {
+      auto iter = node.attr().find("_transfer_priority");
+      return iter == node.attr().end() ? -1 : iter->second.i();
+    }
+  }
+  return -1;
+}
+
+TEST(TransferPriorityOptimizerTest, RanksParametersByFirstUse) {
+  GrapplerItem item;
+  // The worker multiplies its input by w1, then by w0, and sends the result
+  // back to the parameter server.
+  *item.graph.add_node() = Parameter("w0", kPs);
+  *item.graph.add_node() = Parameter("w1", kPs);
+  *item.graph.add_node() = Parameter("unused", kPs);
+  *item.graph.add_node() = Parameter("x", kWorker);
+  *item.graph.add_node() = Mul("layer1", "x", "w1", kWorker);
+  *item.graph.add_node() = Mul("layer2", "layer1", "w0", kWorker);
+  *item.graph.add_node() =
+      NDef("update", "Identity", {"layer2"}, {{"T", DT_FLOAT}}, kPs);
+
+  TransferPriorityOptimizer optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(0, PriorityOf(output, "w1"));
+  EXPECT_EQ(1, PriorityOf(output, "w0"));
+  EXPECT_EQ(-1, PriorityOf(output, "unused"));
+  // x is only used locally, and layer2 depends on the parameter server.
+  EXPECT_EQ(-1, PriorityOf(output, "x"));
+  EXPECT_EQ(-1, PriorityOf(output, "layer2"));
+}
+
+TEST(TransferPriorityOptimizerTest, LeavesLocalGraphsAlone) {
+  GrapplerItem item;
+  *item.graph.add_node() = Parameter("a", kWorker);
+  *item.graph.add_node() = Parameter("b", kWorker);
+  *item.graph.add_node() = Mul("c", "a", "b", kWorker);
+
+  TransferPriorityOptimizer optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  for (const NodeDef& node : output.node()) {
+    EXPECT_EQ(0, node.attr().count("_transfer_priority")) << node.name();
+  }
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -27,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/split_lib.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/macros.h"
 
 namespace tensorflow {
@@ -134,6 +137,19 @@ Status SplitEasyCases(OpKernelContext* context, const Tensor& input,
     return Status::OK();
   }
 
+  // Special case 2: the splits happen to start at aligned addresses.
+  std::vector<Tensor> slices;
+  slices.reserve(sizes.size());
+  int64 position = 0;
+  for (const int64 size : sizes) {
+    slices.push_back(input.Slice(position, position + size));
+    if (!slices.back().IsAligned()) {
+      return Status::OK();
+    }
+    position += size;
+  }
+  outputs->insert(outputs->end(), slices.begin(), slices.end());
+  *done = true;
   return Status::OK();
 }
 
@@ -186,6 +202,8 @@ Status SplitGPU(OpKernelContext* context, const Tensor& input,
 #endif  // GOOGLE_CUDA
 
 // The outer function that dispatches to the various Split*() functions above.
+// Where possible the splits are views of 'input' that share its buffer,
+// which stays alive until all of them are released.
 template <typename T>
 Status Split(OpKernelContext* context, const Tensor& input,
              const gtl::ArraySlice<int64>& sizes,
@@ -204,12 +222,81 @@ Status Split(OpKernelContext* context, const Tensor& input,
   return SplitCPU<T>(context, input, sizes, outputs);
 }
 
+// Dispatches Split() on the type of 'input'.
+Status SplitAnyType(OpKernelContext* context, const Tensor& input,
+                    const gtl::ArraySlice<int64>& sizes,
+                    std::vector<Tensor>* outputs) {
+  switch (input.dtype()) {
+#define CASE(type)                   \
+  case DataTypeToEnum<type>::value:  \
+    return Split<type>(context, input, sizes, outputs);
+    TF_CALL_ALL_TYPES(CASE);
+#undef CASE
+    default:
+      return errors::InvalidArgument("Unsupported data type: ", input.dtype());
+  }
+}
+
+template <typename T>
+void ResizeDimension(const Tensor& input, int dim, int64 size,
+                     Tensor* output) {
+  int64 outer_size = 1;
+  for (int i = 0; i < dim; ++i) {
+    outer_size *= input.dim_size(i);
+  }
+  int64 inner_size = 1;
+  for (int i = dim + 1; i < input.dims(); ++i) {
+    inner_size *= input.dim_size(i);
+  }
+  const int64 input_size = input.dim_size(dim);
+  TensorShape output_shape(input.shape());
+  output_shape.set_dim(dim, size);
+  *output = Tensor(input.dtype(), output_shape);
+
+  auto input_shaped = input.shaped<T, 3>({outer_size, input_size, inner_size});
+  auto output_shaped = output->shaped<T, 3>({outer_size, size, inner_size});
+  const int64 copied_size = std::min(size, input_size);
+  if (copied_size < size) {
+    output_shaped.setConstant(T());
+  }
+  const Eigen::DSizes<Eigen::DenseIndex, 3> offsets(0, 0, 0);
+  const Eigen::DSizes<Eigen::DenseIndex, 3> extents(outer_size, copied_size,
+                                                    inner_size);
+  output_shaped.slice(offsets, extents) = input_shaped.slice(offsets, extents);
+}
+
+// Copies 'input' into '*output', padding it with zeros or cutting it along
+// dimension 'dim' to have size 'size' there.
+Status ResizeDimension(const Tensor& input, int dim, int64 size,
+                       Tensor* output) {
+  switch (input.dtype()) {
+#define CASE(type)                               \
+  case DataTypeToEnum<type>::value:                \
+    ResizeDimension<type>(input, dim, size, output); \
+    return Status::OK();
+    TF_CALL_ALL_TYPES(CASE);
+#undef CASE
+    default:
+      return errors::InvalidArgument("Unsupported data type: ", input.dtype());
+  }
+}
+
 // A class encapsulating the state and logic for batching tensors.
 class BatchResource : public ResourceBase {
  public:
+  // If 'bucket_boundaries' is non-empty, tasks are batched separately by
+  // their size along dimension 'bucket_dimension', and padded to the
+  // largest size of their batch there. If 'enable_large_batch_splitting' is
+  // true, tasks larger than 'max_batch_size' are split across batches. If
+  // 'copy_split_outputs' is true, every task gets its own copy of its part
+  // of the function outputs instead of a view of them.
   static Status Create(int32 num_batch_threads, int32 max_batch_size,
                        int32 batch_timeout_micros, int32 max_enqueued_batches,
                        const std::vector<int32>& allowed_batch_sizes,
+                       bool enable_large_batch_splitting,
+                       int32 bucket_dimension,
+                       const std::vector<int32>& bucket_boundaries,
+                       bool copy_split_outputs,
                        FunctionLibraryRuntime::Handle fhandle,
                        std::unique_ptr<BatchResource>* resource) {
     std::unique_ptr<BatchResource> new_resource(new BatchResource);
@@ -226,6 +313,10 @@ class BatchResource : public ResourceBase {
         batch_timeout_micros;
 
     new_resource->allowed_batch_sizes_ = allowed_batch_sizes;
+    new_resource->enable_large_batch_splitting_ = enable_large_batch_splitting;
+    new_resource->bucket_dimension_ = bucket_dimension;
+    new_resource->bucket_boundaries_ = bucket_boundaries;
+    new_resource->copy_split_outputs_ = copy_split_outputs;
 
     new_resource->fhandle_ = fhandle;
 
@@ -269,16 +360,32 @@ class BatchResource : public ResourceBase {
     batch_components->context = context;
     batch_components->done_callback = std::move(done_callback);
 
+    string queue_name = batcher_queue_name;
+    if (!bucket_boundaries_.empty()) {
+      int bucket;
+      TF_RETURN_IF_ERROR(AssignBucket(batch_components.get(), &bucket));
+      // Each bucket gets its own queue, so tasks of different buckets are
+      // never batched together.
+      queue_name = strings::StrCat(batcher_queue_name, "/length_bucket_",
+                                   bucket);
+    }
+
     BatcherQueue* batcher_queue;
-    TF_RETURN_IF_ERROR(
-        LookupOrCreateBatcherQueue(batcher_queue_name, &batcher_queue));
+    TF_RETURN_IF_ERROR(LookupOrCreateBatcherQueue(queue_name, &batcher_queue));
+    if (enable_large_batch_splitting_ &&
+        batch_components->size() > batcher_queue->max_task_size()) {
+      return ScheduleSplit(std::move(batch_components), batcher_queue);
+    }
     return batcher_queue->Schedule(&batch_components);
   }
 
  private:
   BatchResource() = default;
 
-  // One input to be batched. Corresponds to one invocation of the batch op.
+  struct SplitTaskState;
+
+  // One input to be batched. Corresponds to one invocation of the batch op,
+  // or to a piece of one that was split across batches.
   struct BatchTask : public serving::BatchTask {
     // A unique ID to identify this invocation of Batch.
     int64 guid;
@@ -288,13 +395,185 @@ class BatchResource : public ResourceBase {
     OpKernelContext* context;
     AsyncOpKernel::DoneCallback done_callback;
 
+    // With bucketing, the size of the inputs along the bucket dimension
+    // before padding.
+    int64 length = 0;
+
+    // For the pieces of a split invocation, the state shared by all pieces,
+    // the index of this piece and its outputs. Null otherwise.
+    std::shared_ptr<SplitTaskState> split_state;
+    int split_index = 0;
+    std::vector<Tensor> split_outputs;
+
     size_t size() const override { return inputs[0].shape().dim_size(0); }
   };
 
+  // Collects the outputs of the pieces of an invocation split across
+  // batches, and completes the invocation once all pieces are done.
+  struct SplitTaskState {
+    OpKernelContext* context;
+    AsyncOpKernel::DoneCallback done_callback;
+
+    mutex mu;
+    int num_pending GUARDED_BY(mu);
+    Status status GUARDED_BY(mu);
+    // The outputs of each piece, in order.
+    std::vector<std::vector<Tensor>> outputs GUARDED_BY(mu);
+  };
+
   using Batcher = serving::SharedBatchScheduler<BatchTask>;
   using BatcherQueue = serving::BatchScheduler<BatchTask>;
   using Batch = serving::Batch<BatchTask>;
 
+  // Validates the inputs of 'task' along the bucket dimension and returns
+  // the index of the bucket it belongs to: the first boundary that is at
+  // least the task's length, or one past the last boundary.
+  Status AssignBucket(BatchTask* task, int* bucket) const {
+    const Tensor& first_input = task->inputs[0];
+    if (first_input.dims() <= bucket_dimension_) {
+      return errors::InvalidArgument(
+          "Batching input tensors must have a dimension ", bucket_dimension_,
+          " to be bucketed along; got shape ",
+          first_input.shape().DebugString());
+    }
+    task->length = first_input.dim_size(bucket_dimension_);
+    for (const Tensor& input : task->inputs) {
+      if (input.dims() > bucket_dimension_ &&
+          input.dim_size(bucket_dimension_) != task->length) {
+        return errors::InvalidArgument(
+            "Batching input tensors supplied in a given op invocation must "
+            "have equal sizes along the bucket dimension ",
+            bucket_dimension_);
+      }
+    }
+    *bucket = std::lower_bound(bucket_boundaries_.begin(),
+                               bucket_boundaries_.end(), task->length) -
+              bucket_boundaries_.begin();
+    return Status::OK();
+  }
+
+  // Splits 'task' into pieces of at most the maximum task size of 'queue'
+  // along the zeroth dimension and schedules them.
+  Status ScheduleSplit(std::unique_ptr<BatchTask> task, BatcherQueue* queue) {
+    const int64 task_size = task->size();
+    const int64 max_size = queue->max_task_size();
+    std::vector<int64> piece_sizes;
+    for (int64 offset = 0; offset < task_size; offset += max_size) {
+      piece_sizes.push_back(std::min(max_size, task_size - offset));
+    }
+    std::vector<std::vector<Tensor>> split_inputs(task->inputs.size());
+    for (int i = 0; i < task->inputs.size(); ++i) {
+      TF_RETURN_IF_ERROR(
+          tensor::Split(task->inputs[i], piece_sizes, &split_inputs[i]));
+    }
+
+    std::shared_ptr<SplitTaskState> state(new SplitTaskState);
+    state->context = task->context;
+    state->done_callback = std::move(task->done_callback);
+    {
+      mutex_lock l(state->mu);
+      state->num_pending = piece_sizes.size();
+      state->outputs.resize(piece_sizes.size());
+    }
+    for (int j = 0; j < piece_sizes.size(); ++j) {
+      std::unique_ptr<BatchTask> piece(new BatchTask);
+      piece->guid = task->guid;
+      for (const std::vector<Tensor>& split_input : split_inputs) {
+        piece->inputs.push_back(split_input[j]);
+      }
+      piece->captured_inputs = task->captured_inputs;
+      piece->context = task->context;
+      piece->length = task->length;
+      piece->split_state = state;
+      piece->split_index = j;
+      const Status status = queue->Schedule(&piece);
+      if (!status.ok()) {
+        // Nothing has been scheduled yet, so the caller completes the
+        // invocation. Otherwise the scheduled pieces complete it, with the
+        // error of the remaining ones.
+        if (j == 0) return status;
+        for (int k = j; k < piece_sizes.size(); ++k) {
+          FinishSplitPiece(state.get(), k, status, {});
+        }
+        break;
+      }
+    }
+    return Status::OK();
+  }
+
+  // Records the outcome of piece 'index' of a split invocation and, if it
+  // was the last one pending, concatenates the outputs of all pieces and
+  // completes the invocation.
+  static void FinishSplitPiece(SplitTaskState* state, int index,
+                               const Status& piece_status,
+                               std::vector<Tensor> piece_outputs) {
+    Status status;
+    std::vector<std::vector<Tensor>> outputs;
+    {
+      mutex_lock l(state->mu);
+      state->status.Update(piece_status);
+      state->outputs[index] = std::move(piece_outputs);
+      if (--state->num_pending > 0) {
+        return;
+      }
+      status = state->status;
+      outputs.swap(state->outputs);
+    }
+    OpKernelContext* context = state->context;
+    for (int i = 0; status.ok() && i < context->num_outputs(); ++i) {
+      std::vector<Tensor> to_concatenate;
+      for (const std::vector<Tensor>& outputs_of_piece : outputs) {
+        to_concatenate.push_back(outputs_of_piece.at(i));
+      }
+      Tensor output;
+      status = tensor::Concat(to_concatenate, &output);
+      if (status.ok()) {
+        context->set_output(i, output);
+      }
+    }
+    context->SetStatus(status);
+    state->done_callback();
+  }
+
+  // Completes 'task' with 'status'.
+  static void FinishTask(BatchTask* task, const Status& status) {
+    if (task->split_state != nullptr) {
+      FinishSplitPiece(task->split_state.get(), task->split_index, status,
+                       std::move(task->split_outputs));
+      return;
+    }
+    task->context->SetStatus(status);
+    task->done_callback();
+  }
+
+  // Returns the size of the inputs of 'batch' along the bucket dimension
+  // after padding, i.e. the largest length of its tasks.
+  static int64 PaddedLength(const Batch& batch) {
+    int64 padded_length = 0;
+    for (int i = 0; i < batch.num_tasks(); ++i) {
+      padded_length = std::max(padded_length, batch.task(i).length);
+    }
+    return padded_length;
+  }
+
+  // Pads the inputs of the tasks in 'batch' with zeros along the bucket
+  // dimension to the padded length of the batch.
+  Status PadInputsToLength(Batch* batch) const {
+    const int64 padded_length = PaddedLength(*batch);
+    for (int task_idx = 0; task_idx < batch->num_tasks(); ++task_idx) {
+      BatchTask* task = batch->mutable_task(task_idx);
+      if (task->length == padded_length) continue;
+      for (Tensor& input : task->inputs) {
+        if (input.dims() <= bucket_dimension_) continue;
+        Tensor padded;
+        TF_RETURN_IF_ERROR(
+            ResizeDimension(input, bucket_dimension_, padded_length, &padded));
+        input = padded;
+      }
+    }
+    return Status::OK();
+  }
+
   // Validates that it's legal to combine the tasks in 'batch' into a batch.
   // Assumes the batch is non-empty.
   static Status ValidateBatch(const Batch& batch) {
@@ -404,8 +683,11 @@ class BatchResource : public ResourceBase {
     return Status::OK();
   }
 
+  // Unless 'copy_split_outputs_' is set, the per-task outputs are views of
+  // 'combined_outputs' wherever alignment allows, so that each batched
+  // output is shared by its tasks instead of being copied for each of them.
   Status SplitOutputTensors(const std::vector<Tensor>& combined_outputs,
-                            Batch* batch) const {
+                            OpKernelContext* context, Batch* batch) const {
     DCHECK_GE(batch->num_tasks(), 1);
     if (batch->num_tasks() < 1) {
       return errors::Internal("Batch size expected to be positive; was ",
@@ -426,6 +708,9 @@ class BatchResource : public ResourceBase {
     // For each output tensor name, a divided-up tensor with one entry per task.
     std::map<string, std::vector<Tensor>> split_tensors;
 
+    const int64 padded_length =
+        bucket_boundaries_.empty() ? 0 : PaddedLength(*batch);
+
     DCHECK_EQ(batch->task(0).context->num_outputs(), combined_outputs.size());
     if (combined_outputs.size() != batch->task(0).context->num_outputs()) {
       return errors::Internal("Wrong number of batched output tensors");
@@ -445,8 +730,12 @@ class BatchResource : public ResourceBase {
       }
 
       std::vector<Tensor> split_tensor;
-      const Status split_status = tensor::Split(
-          output_tensor, task_sizes_plus_optional_padding, &split_tensor);
+      const Status split_status =
+          copy_split_outputs_
+              ? tensor::Split(output_tensor, task_sizes_plus_optional_padding,
+                              &split_tensor)
+              : SplitAnyType(context, output_tensor,
+                             task_sizes_plus_optional_padding, &split_tensor);
       DCHECK(split_status.ok()) << split_status.ToString();
       if (!split_status.ok()) {
         return errors::Internal("Tensor split operation failed: ",
@@ -462,7 +751,22 @@ class BatchResource : public ResourceBase {
 
       for (int j = 0; j < batch->num_tasks(); ++j) {
         BatchTask& task = *(batch->mutable_task(j));
-        task.context->set_output(i, split_tensor.at(j));
+        Tensor task_output = split_tensor.at(j);
+        // Cut outputs that kept the padded length along the bucket dimension
+        // back to the length of the task.
+        if (!bucket_boundaries_.empty() && task.length < padded_length &&
+            task_output.dims() > bucket_dimension_ &&
+            task_output.dim_size(bucket_dimension_) == padded_length) {
+          Tensor cut_output;
+          TF_RETURN_IF_ERROR(ResizeDimension(task_output, bucket_dimension_,
+                                             task.length, &cut_output));
+          task_output = cut_output;
+        }
+        if (task.split_state != nullptr) {
+          task.split_outputs.push_back(task_output);
+        } else {
+          task.context->set_output(i, task_output);
+        }
       }  // (Ignore a possible final split_tensors entry containing the
          // padding.)
     }
@@ -488,8 +792,7 @@ class BatchResource : public ResourceBase {
         return;
       }
       for (int i = 0; i < batch->num_tasks(); ++i) {
-        batch->mutable_task(i)->context->SetStatus(status);
-        batch->mutable_task(i)->done_callback();
+        FinishTask(batch->mutable_task(i), status);
       }
       cleanup_done = true;
     };
@@ -500,6 +803,12 @@ class BatchResource : public ResourceBase {
     if (!status.ok()) {
       return;
     }
+    if (!bucket_boundaries_.empty()) {
+      status = PadInputsToLength(batch.get());
+      if (!status.ok()) {
+        return;
+      }
+    }
 
     std::vector<Tensor> concatenated_tensors;
     status =
@@ -543,7 +852,8 @@ class BatchResource : public ResourceBase {
           if (!final_status.ok()) {
             return;
           }
-          final_status = SplitOutputTensors(combined_outputs, batch.get());
+          final_status = SplitOutputTensors(combined_outputs,
+                                            last_task_context, batch.get());
         });
     // By waiting for the notification we are ensuring that this thread isn't
     // used for processing other batches, which gives the batches time to
@@ -685,6 +995,10 @@ class BatchResource : public ResourceBase {
       GUARDED_BY(batcher_queues_mu_);
 
   std::vector<int32> allowed_batch_sizes_;
+  bool enable_large_batch_splitting_ = false;
+  int32 bucket_dimension_ = 1;
+  std::vector<int32> bucket_boundaries_;
+  bool copy_split_outputs_ = false;
   FunctionLibraryRuntime::Handle fhandle_;
 };
 
@@ -707,6 +1021,12 @@ class BatchFunctionKernel : public AsyncOpKernel {
                    c->GetAttr("max_enqueued_batches", &max_enqueued_batches_));
     OP_REQUIRES_OK(c, c->GetAttr("allowed_batch_sizes", &allowed_batch_sizes_));
     OP_REQUIRES_OK(c, ValidateAllowedBatchSizes());
+    OP_REQUIRES_OK(c, c->GetAttr("enable_large_batch_splitting",
+                                 &enable_large_batch_splitting_));
+    OP_REQUIRES_OK(c, c->GetAttr("bucket_dimension", &bucket_dimension_));
+    OP_REQUIRES_OK(c, c->GetAttr("bucket_boundaries", &bucket_boundaries_));
+    OP_REQUIRES_OK(c, ValidateBuckets());
+    OP_REQUIRES_OK(c, c->GetAttr("copy_split_outputs", &copy_split_outputs_));
 
     auto lib = c->function_library();
     OP_REQUIRES(c, lib != nullptr, errors::Internal("No function library"));
@@ -723,10 +1043,11 @@ class BatchFunctionKernel : public AsyncOpKernel {
     std::function<Status(BatchResource * *r)> creator = [this,
                                                          c](BatchResource** r) {
       std::unique_ptr<BatchResource> new_resource;
-      TF_RETURN_IF_ERROR(
-          BatchResource::Create(num_batch_threads_, max_batch_size_,
-                                batch_timeout_micros_, max_enqueued_batches_,
-                                allowed_batch_sizes_, fhandle_, &new_resource));
+      TF_RETURN_IF_ERROR(BatchResource::Create(
+          num_batch_threads_, max_batch_size_, batch_timeout_micros_,
+          max_enqueued_batches_, allowed_batch_sizes_,
+          enable_large_batch_splitting_, bucket_dimension_, bucket_boundaries_,
+          copy_split_outputs_, fhandle_, &new_resource));
       *r = new_resource.release();
       return Status::OK();
     };
@@ -763,6 +1084,27 @@ class BatchFunctionKernel : public AsyncOpKernel {
     return Status::OK();
   }
 
+  // Validates 'bucket_dimension_' and 'bucket_boundaries_'. The dimension
+  // must not be the batch dimension, and the boundaries must be positive and
+  // increase monotonically.
+  Status ValidateBuckets() const {
+    if (bucket_boundaries_.empty()) {
+      return Status::OK();
+    }
+    if (bucket_dimension_ < 1) {
+      return errors::InvalidArgument("bucket_dimension must be positive; was ",
+                                     bucket_dimension_);
+    }
+    for (size_t i = 0; i < bucket_boundaries_.size(); ++i) {
+      if (bucket_boundaries_[i] <= (i > 0 ? bucket_boundaries_[i - 1] : 0)) {
+        return errors::InvalidArgument(
+            "bucket_boundaries entries must be positive and monotonically "
+            "increasing");
+      }
+    }
+    return Status::OK();
+  }
+
  private:
   string container_;
   string shared_name_;
@@ -772,6 +1114,10 @@ class BatchFunctionKernel : public AsyncOpKernel {
   int32 batch_timeout_micros_;
   int32 max_enqueued_batches_;
   std::vector<int32> allowed_batch_sizes_;
+  bool enable_large_batch_splitting_;
+  int32 bucket_dimension_;
+  std::vector<int32> bucket_boundaries_;
+  bool copy_split_outputs_;
   FunctionLibraryRuntime::Handle fhandle_;
 };
 
@@ -806,8 +1152,10 @@ class BatchKernel : public AsyncOpKernel {
           std::unique_ptr<BatchResource> new_resource;
           TF_RETURN_IF_ERROR(BatchResource::Create(
               num_batch_threads_, max_batch_size_, batch_timeout_micros_,
-              max_enqueued_batches_, allowed_batch_sizes_, kInvalidHandle,
-              &new_resource));
+              max_enqueued_batches_, allowed_batch_sizes_,
+              /*enable_large_batch_splitting=*/false, /*bucket_dimension=*/1,
+              /*bucket_boundaries=*/{}, /*copy_split_outputs=*/false,
+              kInvalidHandle, &new_resource));
           *r = new_resource.release();
           return Status::OK();
         };
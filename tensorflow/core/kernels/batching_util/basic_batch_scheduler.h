@@ -162,6 +162,11 @@ class BasicBatchScheduler : public BatchScheduler<TaskType> {
     // avoid latency spikes.
     int64 batch_timeout_micros = 0;
 
+    // If true, underfull batches may be closed before 'batch_timeout_micros'
+    // based on the observed arrival rate of tasks. See
+    // SharedBatchScheduler::QueueOptions::adaptive_batch_timeout.
+    bool adaptive_batch_timeout = false;
+
     // The name to use for the pool of batch threads.
     string thread_pool_name = {"batch_threads"};
 
@@ -229,6 +234,8 @@ Status BasicBatchScheduler<TaskType>::Create(
   shared_scheduler_queue_options.max_batch_size = options.max_batch_size;
   shared_scheduler_queue_options.batch_timeout_micros =
       options.batch_timeout_micros;
+  shared_scheduler_queue_options.adaptive_batch_timeout =
+      options.adaptive_batch_timeout;
   shared_scheduler_queue_options.max_enqueued_batches =
       options.max_enqueued_batches;
   std::unique_ptr<BatchScheduler<TaskType>> shared_scheduler_queue;
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_SHARED_BATCH_SCHEDULER_H_
 
 #include <stddef.h>
+#include <algorithm>
 #include <deque>
 #include <functional>
 #include <list>
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/batching_util/periodic_function.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/cpu_info.h"
@@ -152,6 +154,19 @@ class SharedBatchScheduler
     // avoid latency spikes.
     int64 batch_timeout_micros = 0;
 
+    // If true, the queue also closes an underfull batch before
+    // 'batch_timeout_micros' when waiting for more tasks isn't worth it: it
+    // estimates the arrival rate of tasks and the fixed per-batch processing
+    // cost, and closes the batch as soon as the expected wait for the next
+    // task, summed over the tasks already in the batch, exceeds the time
+    // that adding the task to this batch instead of a later one saves.
+    // 'batch_timeout_micros' remains the bound on the wait, i.e. the latency
+    // SLO of the queue.
+    //
+    // At low request rates this removes most of the timeout from the
+    // latency; at high rates batches still fill up to 'max_batch_size'.
+    bool adaptive_batch_timeout = false;
+
     // The maximum allowable number of enqueued (accepted by Schedule() but
     // not yet being processed on a batch thread) tasks in terms of batches.
     // If this limit is reached, Schedule() will return an UNAVAILABLE error.
@@ -206,6 +221,107 @@ class SharedBatchScheduler
 
 namespace internal {
 
+// Decides whether to close an open batch early for queues with
+// 'adaptive_batch_timeout'. Tracks exponentially decayed estimates of the
+// gap between task arrivals and of a linear model of the batch processing
+// time, duration = overhead + per_unit * batch size, fit by least squares.
+//
+// Not thread-safe.
+class BatchCloseEstimator {
+ public:
+  // Records a task arriving at 'now_micros'.
+  void RecordArrival(uint64 now_micros) {
+    if (has_arrival_ && now_micros >= last_arrival_micros_) {
+      const double gap = now_micros - last_arrival_micros_;
+      if (num_gaps_ == 0) {
+        mean_arrival_gap_micros_ = gap;
+      } else {
+        mean_arrival_gap_micros_ +=
+            (1 - kDecay) * (gap - mean_arrival_gap_micros_);
+      }
+      ++num_gaps_;
+    }
+    has_arrival_ = true;
+    last_arrival_micros_ = now_micros;
+  }
+
+  // Records that processing a batch of size 'batch_size' took
+  // 'duration_micros'.
+  void RecordBatch(size_t batch_size, uint64 duration_micros) {
+    const double size = batch_size;
+    const double duration = duration_micros;
+    weight_ = kDecay * weight_ + 1;
+    sum_size_ = kDecay * sum_size_ + size;
+    sum_duration_ = kDecay * sum_duration_ + duration;
+    sum_size_squared_ = kDecay * sum_size_squared_ + size * size;
+    sum_size_duration_ = kDecay * sum_size_duration_ + size * duration;
+  }
+
+  // Returns the estimated fixed cost of processing a batch, i.e. the time
+  // saved by processing a task as part of another batch instead of on its
+  // own.
+  double BatchOverheadMicros() const {
+    if (weight_ == 0) return 0;
+    const double mean_size = sum_size_ / weight_;
+    const double mean_duration = sum_duration_ / weight_;
+    const double variance = sum_size_squared_ / weight_ - mean_size * mean_size;
+    const double covariance =
+        sum_size_duration_ / weight_ - mean_size * mean_duration;
+    double per_unit = 0;
+    if (variance > 1e-6 * (1 + mean_size * mean_size)) {
+      per_unit = std::max(0.0, covariance / variance);
+    }
+    return std::max(0.0, mean_duration - per_unit * mean_size);
+  }
+
+  // Returns the estimated time until the next task arrives.
+  double ExpectedArrivalGapMicros() const { return mean_arrival_gap_micros_; }
+
+  // Returns true if the open batch, holding 'num_tasks' tasks, should be
+  // closed now: the extra latency of waiting for the next task exceeds the
+  // processing time saved by batching it with them. Returns false until both
+  // an arrival gap and a batch have been recorded.
+  bool ShouldClose(size_t num_tasks) const {
+    if (num_gaps_ == 0 || weight_ == 0) return false;
+    return num_tasks * mean_arrival_gap_micros_ > BatchOverheadMicros();
+  }
+
+ private:
+  // Factor by which the weight of older samples decays on each new one.
+  static constexpr double kDecay = 0.9;
+
+  bool has_arrival_ = false;
+  uint64 last_arrival_micros_ = 0;
+  int64 num_gaps_ = 0;
+  double mean_arrival_gap_micros_ = 0;
+
+  double weight_ = 0;
+  double sum_size_ = 0;
+  double sum_duration_ = 0;
+  double sum_size_squared_ = 0;
+  double sum_size_duration_ = 0;
+};
+
+// Histograms of the batches closed by all queues: how long each batch was
+// open, i.e. the queueing latency of its first task, and how full it was.
+inline monitoring::Sampler<0>* BatchLatencySampler() {
+  static monitoring::Sampler<0>* sampler = monitoring::Sampler<0>::New(
+      {"/tensorflow/serving/batching/batch_latency_us",
+       "Time from the first task of a batch being enqueued until the batch "
+       "is closed."},
+      monitoring::Buckets::Exponential(1, 2, 30));
+  return sampler;
+}
+
+inline monitoring::Sampler<0>* BatchFillSampler() {
+  static monitoring::Sampler<0>* sampler = monitoring::Sampler<0>::New(
+      {"/tensorflow/serving/batching/batch_fill_percent",
+       "Size of a closed batch as a percentage of the maximum batch size."},
+      monitoring::Buckets::Explicit(
+          {10.0, 20.0, 30.0, 40.0, 50.0, 60.0, 70.0, 80.0, 90.0, 100.0}));
+  return sampler;
+}
+
 // A task queue for SharedBatchScheduler. Accepts tasks and accumulates them
 // into batches, and dispenses those batches to be processed via a "pull"
 // interface. The queue's behavior is governed by maximum batch size, timeout
@@ -320,6 +436,9 @@ class Queue {
   // Incremented in ScheduleBatch() and decremented in ProcessBatch().
   int num_batches_being_processed_ GUARDED_BY(mu_) = 0;
 
+  // Only fed if 'options_.adaptive_batch_timeout' is set.
+  BatchCloseEstimator close_estimator_ GUARDED_BY(mu_);
+
   // Used by CloseAndWaitUntilEmpty() to wait until the queue is empty, for the
   // case in which the queue is not empty when CloseAndWaitUntilEmpty() starts.
   // When ProcessBatch() dequeues the last batch and makes the queue empty, if
@@ -546,8 +665,12 @@ Status Queue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
       }
       StartNewBatch();
     }
+    const uint64 now_micros = env_->NowMicros();
     if (batches_.back()->empty()) {
-      open_batch_start_time_micros_ = env_->NowMicros();
+      open_batch_start_time_micros_ = now_micros;
+    }
+    if (options_.adaptive_batch_timeout) {
+      close_estimator_.RecordArrival(now_micros);
     }
     batches_.back()->AddTask(std::move(*task));
 
@@ -616,10 +739,20 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
 
 template <typename TaskType>
 void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
+  const size_t batch_size = batch->size();
+  const uint64 start_time_micros =
+      options_.adaptive_batch_timeout ? env_->NowMicros() : 0;
   process_batch_callback_(std::move(batch));
 
   {
     mutex_lock l(mu_);
+    if (options_.adaptive_batch_timeout) {
+      const uint64 end_time_micros = env_->NowMicros();
+      close_estimator_.RecordBatch(
+          batch_size, end_time_micros > start_time_micros
+                          ? end_time_micros - start_time_micros
+                          : 0);
+    }
     --num_batches_being_processed_;
     if (empty_notification_ != nullptr && IsEmptyInternal()) {
       empty_notification_->Notify();
@@ -657,7 +790,17 @@ bool Queue<TaskType>::IsEmptyInternal() const {
 
 template <typename TaskType>
 void Queue<TaskType>::StartNewBatch() {
-  batches_.back()->Close();
+  Batch<TaskType>* open_batch = batches_.back().get();
+  if (!open_batch->empty()) {
+    const uint64 now_micros = env_->NowMicros();
+    BatchLatencySampler()->GetCell()->Add(
+        now_micros > open_batch_start_time_micros_
+            ? now_micros - open_batch_start_time_micros_
+            : 0);
+    BatchFillSampler()->GetCell()->Add(100.0 * open_batch->size() /
+                                       options_.max_batch_size);
+  }
+  open_batch->Close();
   batches_.emplace_back(new Batch<TaskType>);
 }
 
@@ -667,9 +810,13 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
   if (open_batch->empty()) {
     return false;
   }
-  return closed_ || open_batch->size() >= options_.max_batch_size ||
-         env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+  if (closed_ || open_batch->size() >= options_.max_batch_size ||
+      env_->NowMicros() >=
+          open_batch_start_time_micros_ + options_.batch_timeout_micros) {
+    return true;
+  }
+  return options_.adaptive_batch_timeout &&
+         close_estimator_.ShouldClose(open_batch->num_tasks());
 }
 
 template <typename TaskType>
@@ -289,6 +289,85 @@ TEST(SharedBatchSchedulerTest, ObeysTimeoutWithRealClock) {
   second_batch_processed.WaitForNotification();
 }
 
+TEST(SharedBatchSchedulerTest, BatchCloseEstimator) {
+  internal::BatchCloseEstimator estimator;
+  EXPECT_FALSE(estimator.ShouldClose(1));
+
+  // Batches take 100us plus 10us per unit.
+  for (int i = 0; i < 20; ++i) {
+    const size_t batch_size = 1 + i % 4;
+    estimator.RecordBatch(batch_size, 100 + 10 * batch_size);
+  }
+  EXPECT_NEAR(100, estimator.BatchOverheadMicros(), 1e-3);
+  EXPECT_FALSE(estimator.ShouldClose(1));
+
+  // Tasks arrive every 40us: waiting for one more task is worth it for
+  // batches of up to two tasks.
+  for (int i = 0; i < 10; ++i) {
+    estimator.RecordArrival(40 * i);
+  }
+  EXPECT_NEAR(40, estimator.ExpectedArrivalGapMicros(), 1e-3);
+  EXPECT_FALSE(estimator.ShouldClose(1));
+  EXPECT_FALSE(estimator.ShouldClose(2));
+  EXPECT_TRUE(estimator.ShouldClose(3));
+}
+
+TEST(SharedBatchSchedulerTest, AdaptiveTimeoutClosesBatchesEarly) {
+  // Set up a fake clock, which only advances when we explicitly tell it to.
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    Notification first_batch_processed, second_batch_processed;
+    int num_batches = 0;
+    auto callback = [&first_batch_processed, &second_batch_processed,
+                     &num_batches](std::unique_ptr<Batch<FakeTask>> batch) {
+      ASSERT_TRUE(batch->IsClosed());
+      EXPECT_EQ(1, batch->size());
+      ++num_batches;
+      if (num_batches == 1) {
+        first_batch_processed.Notify();
+      } else if (num_batches == 2) {
+        second_batch_processed.Notify();
+      } else {
+        EXPECT_TRUE(false) << "Unexpected batch";
+      }
+    };
+
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 4;
+    queue_options.batch_timeout_micros = 1000;
+    queue_options.adaptive_batch_timeout = true;
+    queue_options.max_enqueued_batches = 2;
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    // Without any estimates the first batch waits for the full timeout.
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    env.AdvanceByMicroseconds(999);
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+    EXPECT_FALSE(first_batch_processed.HasBeenNotified());
+    env.AdvanceByMicroseconds(1);
+    first_batch_processed.WaitForNotification();
+
+    // Tasks now arrive far apart compared to the cost of a batch, so the next
+    // one is processed without waiting for the timeout.
+    env.AdvanceByMicroseconds(100 * 1000);
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    second_batch_processed.WaitForNotification();
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
 TEST(SharedBatchSchedulerTest,
      WithZeroTimeoutBatchesScheduledAsSoonAsThreadIsAvailable) {
   // Set up a fake clock, and never advance the time.
@@ -0,0 +1,55 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BFLOAT16_CONVERSION_H_
+#define TENSORFLOW_CORE_KERNELS_BFLOAT16_CONVERSION_H_
+
+#include "tensorflow/core/framework/bfloat16.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+// Helpers for the CPU kernels that compute bfloat16 in float. They run the
+// vectorized conversions of framework/bfloat16.h over the CPU worker threads
+// of "ctx".
+
+inline void ShardedBFloat16ToFloat(OpKernelContext* ctx, const bfloat16* src,
+                                   float* dst, int64 size) {
+  auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers, size,
+        /*cost_per_unit=*/1, [src, dst](int64 start, int64 limit) {
+          BFloat16ToFloat(src + start, dst + start, limit - start);
+        });
+}
+
+// Rounds to nearest even, or truncates if "truncate" is true.
+inline void ShardedFloatToBFloat16(OpKernelContext* ctx, const float* src,
+                                   bfloat16* dst, int64 size,
+                                   bool truncate = false) {
+  auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers, size,
+        /*cost_per_unit=*/2, [src, dst, truncate](int64 start, int64 limit) {
+          if (truncate) {
+            FloatToBFloat16(src + start, dst + start, limit - start);
+          } else {
+            RoundFloatToBFloat16(src + start, dst + start, limit - start);
+          }
+        });
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BFLOAT16_CONVERSION_H_
@@ -204,12 +204,12 @@ class BoostedTreesPredictOp : public OpKernel {
     OpInputList bucketized_features_list;
     OP_REQUIRES_OK(context, context->input_list("bucketized_features",
                                                 &bucketized_features_list));
-    std::vector<tensorflow::TTypes<int32>::ConstVec> batch_bucketized_features;
+    std::vector<const int32*> batch_bucketized_features;
     batch_bucketized_features.reserve(bucketized_features_list.size());
     for (const Tensor& tensor : bucketized_features_list) {
-      batch_bucketized_features.emplace_back(tensor.vec<int32>());
+      batch_bucketized_features.push_back(tensor.vec<int32>().data());
     }
-    const int batch_size = batch_bucketized_features[0].size();
+    const int batch_size = bucketized_features_list[0].NumElements();
 
     // Allocate outputs.
     Tensor* output_logits_t = nullptr;
@@ -217,45 +217,27 @@ class BoostedTreesPredictOp : public OpKernel {
                                 "logits", {batch_size, logits_dimension_},
                                 &output_logits_t));
     auto output_logits = output_logits_t->matrix<float>();
-
-    // Return zero logits if it's an empty ensemble.
-    if (resource->num_trees() <= 0) {
-      output_logits.setZero();
-      return;
+    output_logits.setZero();
+
+    // The flat copy of the ensemble stays valid after the lock is released,
+    // even if the ensemble is updated in the meantime.
+    std::shared_ptr<const FlatTreeEnsemble> ensemble;
+    {
+      tf_shared_lock l(*resource->get_mutex());
+      // Return zero logits if it's an empty ensemble.
+      if (resource->num_trees() <= 0) return;
+      ensemble = resource->GetFlatTreeEnsemble();
     }
 
-    const int32 last_tree = resource->num_trees() - 1;
-
-    auto do_work = [&resource, &batch_bucketized_features, &output_logits,
-                    batch_size, last_tree](int32 start, int32 end) {
-      for (int32 i = start; i < end; ++i) {
-        float tree_logit = 0.0;
-        int32 tree_id = 0;
-        int32 node_id = 0;
-        while (true) {
-          if (resource->is_leaf(tree_id, node_id)) {
-            tree_logit += resource->GetTreeWeight(tree_id) *
-                          resource->node_value(tree_id, node_id);
-
-            // Stop if it was the last tree.
-            if (tree_id == last_tree) {
-              break;
-            }
-            // Move onto other trees.
-            ++tree_id;
-            node_id = 0;
-          } else {
-            node_id = resource->next_node(tree_id, node_id, i,
-                                          batch_bucketized_features);
-          }
-        }
-        output_logits(i, 0) = tree_logit;
-      }
+    float* const logits = output_logits.data();
+    auto do_work = [&ensemble, &batch_bucketized_features, logits](
+                       int32 start, int32 end) {
+      ensemble->AddLogits(batch_bucketized_features, start, end, logits);
     };
     // 10 is the magic number. The actual number might depend on (the number of
     // layers in the trees) and (cpu cycles spent on each layer), but this
     // value would work for many cases. May be tuned later.
-    const int64 cost = (last_tree + 1) * 10;
+    const int64 cost = ensemble->num_trees() * 10;
     thread::ThreadPool* const worker_threads =
         context->device()->tensorflow_cpu_worker_threads()->workers;
     Shard(worker_threads->NumThreads(), worker_threads, batch_size,
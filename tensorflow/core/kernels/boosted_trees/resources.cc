@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/boosted_trees/resources.h"
+
+#include <algorithm>
+
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/kernels/boosted_trees/boosted_trees.pb.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -23,8 +26,106 @@ namespace tensorflow {
 
 namespace {
 constexpr float kLayerByLayerTreeWeight = 1.0;
+
+// The number of examples that AddLogits() runs through each tree before
+// moving on to the next tree, so that the nodes of a tree stay in cache.
+constexpr int32 kExampleBlockSize = 64;
 }  // namespace
 
+FlatTreeEnsemble::FlatTreeEnsemble(
+    const boosted_trees::TreeEnsemble& ensemble) {
+  int64 num_nodes = 0;
+  for (const auto& tree : ensemble.trees()) {
+    num_nodes += std::max(tree.nodes_size(), 1);
+  }
+  roots_.reserve(ensemble.trees_size());
+  kinds_.reserve(num_nodes);
+  feature_ids_.reserve(num_nodes);
+  thresholds_.reserve(num_nodes);
+  left_ids_.reserve(num_nodes);
+  right_ids_.reserve(num_nodes);
+  weighted_values_.reserve(num_nodes);
+
+  for (int32 tree_id = 0; tree_id < ensemble.trees_size(); ++tree_id) {
+    const auto& tree = ensemble.trees(tree_id);
+    const float weight = ensemble.tree_weights(tree_id);
+    const int32 root = kinds_.size();
+    roots_.push_back(root);
+    if (tree.nodes_size() == 0) {
+      // An empty tree adds nothing.
+      kinds_.push_back(kLeaf);
+      feature_ids_.push_back(0);
+      thresholds_.push_back(0);
+      left_ids_.push_back(0);
+      right_ids_.push_back(0);
+      weighted_values_.push_back(0);
+      continue;
+    }
+    for (const auto& node : tree.nodes()) {
+      int32 feature_id = 0;
+      int32 threshold = 0;
+      int32 left_id = 0;
+      int32 right_id = 0;
+      float value = 0;
+      switch (node.node_case()) {
+        case boosted_trees::Node::kBucketizedSplit: {
+          const auto& split = node.bucketized_split();
+          kinds_.push_back(kBucketizedSplit);
+          feature_id = split.feature_id();
+          threshold = split.threshold();
+          left_id = root + split.left_id();
+          right_id = root + split.right_id();
+          break;
+        }
+        case boosted_trees::Node::kCategoricalSplit: {
+          const auto& split = node.categorical_split();
+          kinds_.push_back(kCategoricalSplit);
+          feature_id = split.feature_id();
+          threshold = split.value();
+          left_id = root + split.left_id();
+          right_id = root + split.right_id();
+          break;
+        }
+        default:
+          kinds_.push_back(kLeaf);
+          value = weight * node.leaf().scalar();
+      }
+      feature_ids_.push_back(feature_id);
+      thresholds_.push_back(threshold);
+      left_ids_.push_back(left_id);
+      right_ids_.push_back(right_id);
+      weighted_values_.push_back(value);
+    }
+  }
+}
+
+void FlatTreeEnsemble::AddLogits(
+    const std::vector<const int32*>& bucketized_features, int32 begin,
+    int32 end, float* logits) const {
+  const uint8* const kinds = kinds_.data();
+  const int32* const feature_ids = feature_ids_.data();
+  const int32* const thresholds = thresholds_.data();
+  const int32* const left_ids = left_ids_.data();
+  const int32* const right_ids = right_ids_.data();
+  const float* const weighted_values = weighted_values_.data();
+  for (int32 block = begin; block < end; block += kExampleBlockSize) {
+    const int32 block_end = std::min(end, block + kExampleBlockSize);
+    for (const int32 root : roots_) {
+      for (int32 i = block; i < block_end; ++i) {
+        int32 node = root;
+        while (kinds[node] != kLeaf) {
+          const int32 bucket = bucketized_features[feature_ids[node]][i];
+          const bool go_left = kinds[node] == kBucketizedSplit
+                                   ? bucket <= thresholds[node]
+                                   : bucket == thresholds[node];
+          node = go_left ? left_ids[node] : right_ids[node];
+        }
+        logits[i] += weighted_values[node];
+      }
+    }
+  }
+}
+
 // Constructor.
 BoostedTreesEnsembleResource::BoostedTreesEnsembleResource()
     : tree_ensemble_(
@@ -272,9 +373,23 @@ void BoostedTreesEnsembleResource::AddBucketizedSplitNode(
   right_node->mutable_leaf()->set_scalar(prev_node_value + right_contrib);
 }
 
+std::shared_ptr<const FlatTreeEnsemble>
+BoostedTreesEnsembleResource::GetFlatTreeEnsemble() {
+  mutex_lock l(flat_mu_);
+  if (flat_tree_ensemble_ == nullptr || flat_tree_ensemble_stamp_ != stamp()) {
+    flat_tree_ensemble_ = std::make_shared<FlatTreeEnsemble>(*tree_ensemble_);
+    flat_tree_ensemble_stamp_ = stamp();
+  }
+  return flat_tree_ensemble_;
+}
+
 void BoostedTreesEnsembleResource::Reset() {
   // Reset stamp.
   set_stamp(-1);
+  {
+    mutex_lock l(flat_mu_);
+    flat_tree_ensemble_.reset();
+  }
 
   // Clear tree ensemle.
   arena_.Reset();
@@ -16,9 +16,13 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_RESOURCES_H_
 #define TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_RESOURCES_H_
 
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
@@ -43,6 +47,37 @@ class StampedResource : public ResourceBase {
   int64 stamp_;
 };
 
+// A read-only copy of a tree ensemble in flat arrays, one entry per node of
+// all trees, for inference without walking the protos. The nodes of each
+// tree are contiguous, children are indices into the same arrays, and the
+// leaf values are premultiplied by their tree weights.
+class FlatTreeEnsemble {
+ public:
+  explicit FlatTreeEnsemble(const boosted_trees::TreeEnsemble& ensemble);
+
+  int32 num_trees() const { return roots_.size(); }
+
+  // Adds the logits of all trees for the examples [begin, end) to
+  // logits[begin, end). bucketized_features[f][i] is the bucket of feature f
+  // for example i.
+  void AddLogits(const std::vector<const int32*>& bucketized_features,
+                 int32 begin, int32 end, float* logits) const;
+
+ private:
+  enum NodeKind : uint8 { kLeaf, kBucketizedSplit, kCategoricalSplit };
+
+  std::vector<int32> roots_;
+  std::vector<uint8> kinds_;
+  std::vector<int32> feature_ids_;
+  // The threshold of a bucketized split, or the value of a categorical split.
+  std::vector<int32> thresholds_;
+  std::vector<int32> left_ids_;
+  std::vector<int32> right_ids_;
+  std::vector<float> weighted_values_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FlatTreeEnsemble);
+};
+
 // Keep a tree ensemble in memory for efficient evaluation and mutation.
 class BoostedTreesEnsembleResource : public StampedResource {
  public:
@@ -143,6 +178,12 @@ class BoostedTreesEnsembleResource : public StampedResource {
                               float* logit_update) const;
   mutex* get_mutex() { return &mu_; }
 
+  // Returns the ensemble as a FlatTreeEnsemble, which is only rebuilt when
+  // the stamp changed or the resource was reset since the last call. Every
+  // change to the ensemble must do one of these. Caller needs to hold at
+  // least a shared lock on the mutex.
+  std::shared_ptr<const FlatTreeEnsemble> GetFlatTreeEnsemble();
+
  private:
   // Helper method to check whether a node is a terminal node in that it
   // only has leaf nodes as children.
@@ -166,6 +207,13 @@ class BoostedTreesEnsembleResource : public StampedResource {
   protobuf::Arena arena_;
   mutex mu_;
   boosted_trees::TreeEnsemble* tree_ensemble_;
+
+ private:
+  mutex flat_mu_;
+  std::shared_ptr<const FlatTreeEnsemble> flat_tree_ensemble_
+      GUARDED_BY(flat_mu_);
+  // The stamp of the ensemble that flat_tree_ensemble_ was built from.
+  int64 flat_tree_ensemble_stamp_ GUARDED_BY(flat_mu_) = -1;
 };
 
 }  // namespace tensorflow
@@ -13,14 +13,30 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/boosted_trees/tree_helper.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
+namespace {
+
+// The best split of each node that has one, for a single feature.
+struct FeatureSplits {
+  std::vector<int32> node_ids;
+  std::vector<float> gains;
+  std::vector<int32> thresholds;
+  std::vector<float> left_node_contribs;
+  std::vector<float> right_node_contribs;
+};
+
+}  // namespace
+
 class BoostedTreesCalculateBestGainsPerFeatureOp : public OpKernel {
  public:
   explicit BoostedTreesCalculateBestGainsPerFeatureOp(
@@ -81,75 +97,32 @@ class BoostedTreesCalculateBestGainsPerFeatureOp : public OpKernel {
                    context->output_list("right_node_contribs_list",
                                         &output_right_node_contribs_list));
 
-    // Get the best split info per node for each feature.
-    for (int feature_idx = 0; feature_idx < num_features_; ++feature_idx) {
-      std::vector<float> cum_grad;
-      std::vector<float> cum_hess;
-      cum_grad.reserve(num_buckets);
-      cum_hess.reserve(num_buckets);
-
-      std::vector<int32> output_node_ids;
-      std::vector<float> output_gains;
-      std::vector<int32> output_thresholds;
-      std::vector<float> output_left_node_contribs;
-      std::vector<float> output_right_node_contribs;
-      for (int node_id = node_id_first; node_id < node_id_last; ++node_id) {
-        // Calculate gains.
-        cum_grad.clear();
-        cum_hess.clear();
-        float total_grad = 0.0;
-        float total_hess = 0.0;
-        for (int bucket = 0; bucket < num_buckets; ++bucket) {
-          // TODO(nponomareva): Consider multi-dimensional gradients/hessians.
-          total_grad += stats_summary[feature_idx](node_id, bucket, 0);
-          total_hess += stats_summary[feature_idx](node_id, bucket, 1);
-          cum_grad.push_back(total_grad);
-          cum_hess.push_back(total_hess);
-        }
-        // Check if node has enough of average hessian.
-        if (total_hess < min_node_weight) {
-          // Do not split the node because not enough avg hessian.
-          continue;
-        }
-        float best_gain = std::numeric_limits<float>::lowest();
-        float best_bucket = 0;
-        float best_contrib_for_left = 0.0;
-        float best_contrib_for_right = 0.0;
-        // Parent gain.
-        float parent_gain;
-        float unused;
-        CalculateWeightsAndGains(total_grad, total_hess, l1, l2, &unused,
-                                 &parent_gain);
-
-        for (int bucket = 0; bucket < num_buckets; ++bucket) {
-          const float cum_grad_bucket = cum_grad[bucket];
-          const float cum_hess_bucket = cum_hess[bucket];
-          // Left child.
-          float contrib_for_left;
-          float gain_for_left;
-          CalculateWeightsAndGains(cum_grad_bucket, cum_hess_bucket, l1, l2,
-                                   &contrib_for_left, &gain_for_left);
-          // Right child.
-          float contrib_for_right;
-          float gain_for_right;
-          CalculateWeightsAndGains(total_grad - cum_grad_bucket,
-                                   total_hess - cum_hess_bucket, l1, l2,
-                                   &contrib_for_right, &gain_for_right);
+    // Get the best split info per node for each feature. The features are
+    // independent, so they are split across the worker threads.
+    std::vector<FeatureSplits> splits(num_features_);
+    auto do_work = [&](int64 begin, int64 end) {
+      for (int64 feature_idx = begin; feature_idx < end; ++feature_idx) {
+        FindBestSplits(stats_summary[feature_idx], node_id_first,
+                       node_id_last, num_buckets, l1, l2, min_node_weight,
+                       &splits[feature_idx]);
+      }
+    };
+    const int64 cost =
+        std::max<int64>(node_id_last - node_id_first, 1) * num_buckets * 50;
+    thread::ThreadPool* const worker_threads =
+        context->device()->tensorflow_cpu_worker_threads()->workers;
+    Shard(worker_threads->NumThreads(), worker_threads, num_features_,
+          /*cost_per_unit=*/cost, do_work);
 
-          if (GainIsLarger(gain_for_left + gain_for_right, best_gain)) {
-            best_gain = gain_for_left + gain_for_right;
-            best_bucket = bucket;
-            best_contrib_for_left = contrib_for_left;
-            best_contrib_for_right = contrib_for_right;
-          }
-        }  // for bucket
-        output_node_ids.push_back(node_id);
-        // Remove the parent gain for the parent node.
-        output_gains.push_back(best_gain - parent_gain);
-        output_thresholds.push_back(best_bucket);
-        output_left_node_contribs.push_back(best_contrib_for_left);
-        output_right_node_contribs.push_back(best_contrib_for_right);
-      }  // for node_id
+    for (int feature_idx = 0; feature_idx < num_features_; ++feature_idx) {
+      const FeatureSplits& feature_splits = splits[feature_idx];
+      const std::vector<int32>& output_node_ids = feature_splits.node_ids;
+      const std::vector<float>& output_gains = feature_splits.gains;
+      const std::vector<int32>& output_thresholds = feature_splits.thresholds;
+      const std::vector<float>& output_left_node_contribs =
+          feature_splits.left_node_contribs;
+      const std::vector<float>& output_right_node_contribs =
+          feature_splits.right_node_contribs;
       const int num_nodes = output_node_ids.size();
       // output_node_ids
       Tensor* output_node_ids_t;
@@ -197,6 +170,75 @@ class BoostedTreesCalculateBestGainsPerFeatureOp : public OpKernel {
   }
 
  private:
+  // Finds the best split of each node in [node_id_first, node_id_last) from
+  // the stats of one feature.
+  static void FindBestSplits(
+      const TTypes<float, 3>::ConstTensor& stats_summary, int32 node_id_first,
+      int32 node_id_last, int64 num_buckets, float l1, float l2,
+      float min_node_weight, FeatureSplits* splits) {
+    std::vector<float> cum_grad;
+    std::vector<float> cum_hess;
+    cum_grad.reserve(num_buckets);
+    cum_hess.reserve(num_buckets);
+    for (int node_id = node_id_first; node_id < node_id_last; ++node_id) {
+      // Calculate gains.
+      cum_grad.clear();
+      cum_hess.clear();
+      float total_grad = 0.0;
+      float total_hess = 0.0;
+      for (int bucket = 0; bucket < num_buckets; ++bucket) {
+        // TODO(nponomareva): Consider multi-dimensional gradients/hessians.
+        total_grad += stats_summary(node_id, bucket, 0);
+        total_hess += stats_summary(node_id, bucket, 1);
+        cum_grad.push_back(total_grad);
+        cum_hess.push_back(total_hess);
+      }
+      // Check if node has enough of average hessian.
+      if (total_hess < min_node_weight) {
+        // Do not split the node because not enough avg hessian.
+        continue;
+      }
+      float best_gain = std::numeric_limits<float>::lowest();
+      float best_bucket = 0;
+      float best_contrib_for_left = 0.0;
+      float best_contrib_for_right = 0.0;
+      // Parent gain.
+      float parent_gain;
+      float unused;
+      CalculateWeightsAndGains(total_grad, total_hess, l1, l2, &unused,
+                               &parent_gain);
+
+      for (int bucket = 0; bucket < num_buckets; ++bucket) {
+        const float cum_grad_bucket = cum_grad[bucket];
+        const float cum_hess_bucket = cum_hess[bucket];
+        // Left child.
+        float contrib_for_left;
+        float gain_for_left;
+        CalculateWeightsAndGains(cum_grad_bucket, cum_hess_bucket, l1, l2,
+                                 &contrib_for_left, &gain_for_left);
+        // Right child.
+        float contrib_for_right;
+        float gain_for_right;
+        CalculateWeightsAndGains(total_grad - cum_grad_bucket,
+                                 total_hess - cum_hess_bucket, l1, l2,
+                                 &contrib_for_right, &gain_for_right);
+
+        if (GainIsLarger(gain_for_left + gain_for_right, best_gain)) {
+          best_gain = gain_for_left + gain_for_right;
+          best_bucket = bucket;
+          best_contrib_for_left = contrib_for_left;
+          best_contrib_for_right = contrib_for_right;
+        }
+      }  // for bucket
+      splits->node_ids.push_back(node_id);
+      // Remove the parent gain for the parent node.
+      splits->gains.push_back(best_gain - parent_gain);
+      splits->thresholds.push_back(best_bucket);
+      splits->left_node_contribs.push_back(best_contrib_for_left);
+      splits->right_node_contribs.push_back(best_contrib_for_right);
+    }  // for node_id
+  }
+
   int max_splits_;
   int num_features_;
 };
@@ -243,16 +285,31 @@ class BoostedTreesMakeStatsSummaryOp : public OpKernel {
     auto temp_stats_double = temp_stats_double_t.tensor<double, 4>();
     temp_stats_double.setZero();
 
-    // Partition by node, and then bucketize.
-    for (int feature_idx = 0; feature_idx < num_features_; ++feature_idx) {
-      const auto& features = bucketized_features_list[feature_idx].vec<int32>();
-      for (int i = 0; i < batch_size; ++i) {
-        const int32 node = node_ids(i);
-        const int32 bucket = features(i);
-        temp_stats_double(feature_idx, node, bucket, 0) += gradients(i, 0);
-        temp_stats_double(feature_idx, node, bucket, 1) += hessians(i, 0);
+    // Partition by node, and then bucketize. Each feature accumulates into
+    // its own slice of the stats, so the features are split across the
+    // worker threads, and the sums do not depend on the number of threads.
+    const int64 feature_stats_size = max_splits_ * num_buckets_ * 2;
+    auto do_work = [&](int64 begin, int64 end) {
+      for (int64 feature_idx = begin; feature_idx < end; ++feature_idx) {
+        const auto features =
+            bucketized_features_list[feature_idx].vec<int32>();
+        double* const feature_stats =
+            temp_stats_double.data() + feature_idx * feature_stats_size;
+        for (int i = 0; i < batch_size; ++i) {
+          const int32 node = node_ids(i);
+          const int32 bucket = features(i);
+          double* const stats =
+              feature_stats + (static_cast<int64>(node) * num_buckets_ +
+                               bucket) * 2;
+          stats[0] += gradients(i, 0);
+          stats[1] += hessians(i, 0);
+        }
       }
-    }
+    };
+    thread::ThreadPool* const worker_threads =
+        context->device()->tensorflow_cpu_worker_threads()->workers;
+    Shard(worker_threads->NumThreads(), worker_threads, num_features_,
+          /*cost_per_unit=*/std::max<int64>(batch_size, 1) * 10, do_work);
 
     // Copy temp tensor over to output tensor.
     Tensor* output_stats_summary_t = nullptr;
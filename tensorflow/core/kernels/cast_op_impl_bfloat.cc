@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/cast_op_impl.h"
 
+#include "tensorflow/core/kernels/bfloat16_conversion.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -23,6 +24,14 @@ typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
 CastFunctorType GetCpuCastFromBfloat(DataType dst_dtype) {
+  if (dst_dtype == DT_FLOAT) {
+    // Widening is exact, so "truncate" does not matter.
+    return [](OpKernelContext* ctx, const Tensor& inp, Tensor* out,
+              bool truncate) {
+      ShardedBFloat16ToFloat(ctx, inp.flat<bfloat16>().data(),
+                             out->flat<float>().data(), inp.NumElements());
+    };
+  }
   CURRY_TYPES3(CAST_CASE, CPUDevice, bfloat16);
   return nullptr;
 }
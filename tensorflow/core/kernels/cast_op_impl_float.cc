@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/cast_op_impl.h"
 
+#include "tensorflow/core/kernels/bfloat16_conversion.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -23,6 +24,14 @@ typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
 CastFunctorType GetCpuCastFromFloat(DataType dst_dtype) {
+  if (dst_dtype == DT_BFLOAT16) {
+    return [](OpKernelContext* ctx, const Tensor& inp, Tensor* out,
+              bool truncate) {
+      ShardedFloatToBFloat16(ctx, inp.flat<float>().data(),
+                             out->flat<bfloat16>().data(), inp.NumElements(),
+                             truncate);
+    };
+  }
   CURRY_TYPES3(CAST_CASE, CPUDevice, float);
   return nullptr;
 }
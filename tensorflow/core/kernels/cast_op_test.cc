@@ -116,6 +116,30 @@ TEST_ALL_CASTS_FROM(quint16)
 #undef TEST_ALL_CASTS_FROM
 #undef TEST_CAST
 
+// 1 + 2^-8 + 2^-9 lies between the bfloat16 values 1 and 1 + 2^-7, and is
+// closer to the latter. 17 elements cover the vectorized loops and a tail.
+TEST_F(CastOpTest, FloatToBFloat16Rounds) {
+  MakeOp(DT_FLOAT, DT_BFLOAT16);
+  AddInputFromArray<float>(TensorShape({17}),
+                           std::vector<float>(17, 1.0f + 3.0f / 512));
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(allocator(), DT_BFLOAT16, TensorShape({17}));
+  test::FillFn<bfloat16>(&expected, [](int) {
+    return bfloat16::round_to_bfloat16(1.0f + 1.0f / 128);
+  });
+  test::ExpectTensorEqual<bfloat16>(expected, *GetOutput(0));
+}
+
+TEST_F(CastOpTest, FloatToBFloat16Truncates) {
+  MakeOp(DT_FLOAT, DT_BFLOAT16, /*trunc=*/true);
+  AddInputFromArray<float>(TensorShape({17}),
+                           std::vector<float>(17, 1.0f + 3.0f / 512));
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(allocator(), DT_BFLOAT16, TensorShape({17}));
+  test::FillFn<bfloat16>(&expected, [](int) { return bfloat16(1.0f); });
+  test::ExpectTensorEqual<bfloat16>(expected, *GetOutput(0));
+}
+
 // TODO(wicke): check conversions from/to bool, and bfloat16
 
 static void BM_cpu_float_int64(int iters, int num) {
@@ -74,6 +74,17 @@ class CollectiveReduceOpKernel : public CollectiveOpKernel {
     OP_REQUIRES_OK(
         c, c->GetAttr("subdiv_offsets",
                       &col_params_.instance.impl_details.subdiv_offsets));
+    OP_REQUIRES_OK(
+        c, c->GetAttr("implementation",
+                      &col_params_.instance.impl_details.collective_name));
+    OP_REQUIRES_OK(
+        c, c->GetAttr("wire_format", &col_params_.instance.wire_format));
+    OP_REQUIRES(c,
+                col_params_.instance.wire_format.empty() ||
+                    col_params_.instance.wire_format == "fp16",
+                errors::InvalidArgument(
+                    "wire_format must be one of {\"\", \"fp16\"} but got ",
+                    col_params_.instance.wire_format));
     string merge_op_name;
     OP_REQUIRES_OK(c, c->GetAttr("merge_op", &merge_op_name));
     OP_REQUIRES(c, merge_op_name == "Add" || merge_op_name == "Mul",
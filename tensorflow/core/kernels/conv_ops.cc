@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/kernels/bfloat16_conversion.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/conv_2d.h"
 #include "tensorflow/core/kernels/deep_conv2d.h"
@@ -140,6 +141,39 @@ struct LaunchConv2DOp<CPUDevice, T> {
   }
 };
 
+// Computes bfloat16 convolutions in float, as there are no bfloat16
+// contraction kernels on CPU.
+template <>
+struct LaunchConv2DOp<CPUDevice, bfloat16> {
+  void operator()(OpKernelContext* ctx, bool use_cudnn, bool cudnn_use_autotune,
+                  const Tensor& input, const Tensor& filter, int row_dilation,
+                  int col_dilation, int row_stride, int col_stride,
+                  const Padding& padding, Tensor* output,
+                  TensorFormat data_format) {
+    Tensor input_float, filter_float, output_float;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_temp(DT_FLOAT, input.shape(), &input_float));
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_temp(DT_FLOAT, filter.shape(), &filter_float));
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_temp(DT_FLOAT, output->shape(), &output_float));
+    ShardedBFloat16ToFloat(ctx, input.flat<bfloat16>().data(),
+                           input_float.flat<float>().data(),
+                           input.NumElements());
+    ShardedBFloat16ToFloat(ctx, filter.flat<bfloat16>().data(),
+                           filter_float.flat<float>().data(),
+                           filter.NumElements());
+    LaunchConv2DOp<CPUDevice, float>()(
+        ctx, use_cudnn, cudnn_use_autotune, input_float, filter_float,
+        row_dilation, col_dilation, row_stride, col_stride, padding,
+        &output_float, data_format);
+    if (!ctx->status().ok()) return;
+    ShardedFloatToBFloat16(ctx, output_float.flat<float>().data(),
+                           output->flat<bfloat16>().data(),
+                           output->NumElements());
+  }
+};
+
 template <typename Device, typename T>
 class LaunchDeepConvOp {
  public:
@@ -150,12 +184,14 @@ class LaunchDeepConvOp {
                   int /*out_cols*/, int /*out_depth*/, int /*dilation_rows*/,
                   int /*dilation_cols*/, int /*stride_rows*/,
                   int /*stride_cols*/, Tensor* /*output*/,
-                  TensorFormat /*data_format*/) {
+                  TensorFormat /*data_format*/,
+                  DeepConv2DFilterCache* /*filter_cache*/) {
     return false;
   }
 };
 
 // Conditionally launches DeepConv operation based on convolution parameters.
+// 'filter_cache' holds the transformed filters across calls of the kernel.
 template <>
 class LaunchDeepConvOp<CPUDevice, float> {
  public:
@@ -165,7 +201,8 @@ class LaunchDeepConvOp<CPUDevice, float> {
                   int filter_cols, int pad_rows, int pad_cols, int out_rows,
                   int out_cols, int out_depth, int dilation_rows,
                   int dilation_cols, int stride_rows, int stride_cols,
-                  Tensor* output, TensorFormat data_format) {
+                  Tensor* output, TensorFormat data_format,
+                  DeepConv2DFilterCache* filter_cache) {
     if (data_format != FORMAT_NHWC || dilation_rows != 1 ||
         dilation_cols != 1 ||
         !CanUseDeepConv2D(stride_rows, stride_cols, filter_rows, filter_cols,
@@ -191,7 +228,7 @@ class LaunchDeepConvOp<CPUDevice, float> {
     auto output_ptr = output->template flat<float>().data();
 
     functor::DeepConv2D<CPUDevice, float>()(ctx, args, input_ptr, filter_ptr,
-                                            output_ptr);
+                                            output_ptr, filter_cache);
     return true;
   }
 };
@@ -482,7 +519,7 @@ class Conv2DOp : public BinaryOp<T> {
             dimensions.out_rows, dimensions.out_cols, dimensions.out_depth,
             dimensions.dilation_rows, dimensions.dilation_cols,
             dimensions.stride_rows, dimensions.stride_cols, output,
-            params_.data_format)) {
+            params_.data_format, &deep_conv_filter_cache_)) {
       return;
     }
 
@@ -498,6 +535,7 @@ class Conv2DOp : public BinaryOp<T> {
   bool cudnn_use_autotune_;
 
   LaunchConv2DOp<Device, T> launcher_;
+  DeepConv2DFilterCache deep_conv_filter_cache_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(Conv2DOp);
 };
@@ -511,12 +549,14 @@ class Conv2DOp : public BinaryOp<T> {
 // CPU implementation, don't register this EigenTensor-based version.
 #if !defined(USE_GEMM_FOR_CONV)
 TF_CALL_half(REGISTER_CPU);
+TF_CALL_bfloat16(REGISTER_CPU);
 TF_CALL_float(REGISTER_CPU);
 TF_CALL_double(REGISTER_CPU);
 #endif  // USE_GEMM_FOR_CONV
 
 // To be used inside depthwise_conv_op.cc.
 template struct LaunchConv2DOp<CPUDevice, Eigen::half>;
+template struct LaunchConv2DOp<CPUDevice, bfloat16>;
 template struct LaunchConv2DOp<CPUDevice, float>;
 template struct LaunchConv2DOp<CPUDevice, double>;
 
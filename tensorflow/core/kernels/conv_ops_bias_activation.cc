@@ -0,0 +1,176 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Implements the _FusedConv2D op: a Conv2D followed by a BiasAdd and an
+// optional activation, with the bias add and the activation applied by an
+// Eigen output kernel inside the convolution's tensor contraction.
+
+#define EIGEN_USE_THREADS
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/conv_2d.h"
+#include "tensorflow/core/kernels/conv_ops.h"
+#include "tensorflow/core/kernels/fused_eigen_output_kernels.h"
+#include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/padding.h"
+#include "tensorflow/core/util/tensor_format.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Runs the convolution with `output_kernel` fused into it. Mirrors the
+// choice of contraction made by the generic Conv2D CPU implementation.
+template <typename T, typename OutputKernel>
+void LaunchConv2DWithOutputKernel(OpKernelContext* context,
+                                  const Tensor& input, const Tensor& filter,
+                                  const Conv2DDimensions& dimensions,
+                                  const Padding& padding,
+                                  const OutputKernel& output_kernel,
+                                  Tensor* output) {
+  const CPUDevice& d = context->eigen_device<CPUDevice>();
+
+  Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> dim_pair;
+  dim_pair[0] = Eigen::IndexPair<Eigen::DenseIndex>(1, 0);
+
+  if (filter.dim_size(0) == 1 && filter.dim_size(1) == 1 &&
+      dimensions.stride_rows == 1 && dimensions.stride_cols == 1) {
+    // For 1x1 kernel, the 2D convolution is reduced to matrix multiplication.
+    const int64 conv_width =
+        output->dim_size(0) * output->dim_size(1) * output->dim_size(2);
+    auto out = output->shaped<T, 2>({conv_width, filter.dim_size(3)});
+    out.device(d) =
+        input.shaped<T, 2>({conv_width, filter.dim_size(2)})
+            .contract(
+                filter.shaped<T, 2>({filter.dim_size(2), filter.dim_size(3)}),
+                dim_pair, output_kernel);
+  } else if (filter.dim_size(0) == input.dim_size(1) &&
+             filter.dim_size(1) == input.dim_size(2) &&
+             dimensions.dilation_rows == 1 && dimensions.dilation_cols == 1 &&
+             padding == VALID) {
+    // If the input data and filter have the same height/width, the 2D
+    // convolution is reduced to matrix multiplication.
+    const int64 k =
+        filter.dim_size(0) * filter.dim_size(1) * filter.dim_size(2);
+    auto out = output->shaped<T, 2>({input.dim_size(0), filter.dim_size(3)});
+    out.device(d) =
+        input.shaped<T, 2>({input.dim_size(0), k})
+            .contract(filter.shaped<T, 2>({k, filter.dim_size(3)}), dim_pair,
+                      output_kernel);
+  } else {
+    // Need to swap row/col when calling Eigen.
+    output->tensor<T, 4>().device(d) = Eigen::SpatialConvolution(
+        input.tensor<T, 4>(), filter.tensor<T, 4>(), dimensions.stride_cols,
+        dimensions.stride_rows, BrainPadding2EigenPadding(padding),
+        dimensions.dilation_cols, dimensions.dilation_rows, output_kernel);
+  }
+}
+
+}  // namespace
+
+template <typename Device, typename T>
+class FusedConv2DOp : public OpKernel {
+ public:
+  explicit FusedConv2DOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, InitConv2DParameters(context, &params_));
+    OP_REQUIRES(context, params_.data_format == FORMAT_NHWC,
+                errors::Unimplemented(
+                    "_FusedConv2D only supports NHWC tensor format for now."));
+    OP_REQUIRES_OK(context, InitializeFusedComputation(
+                                context, "_FusedConv2D", &fused_computation_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    // Input tensor is of the following dimensions:
+    // [ batch, in_rows, in_cols, in_depth ]
+    const Tensor& input = context->input(0);
+
+    // Input filter is of the following dimensions:
+    // [ filter_rows, filter_cols, in_depth, out_depth]
+    const Tensor& filter = context->input(1);
+
+    const Tensor& bias = context->input(2);
+
+    Conv2DDimensions dimensions;
+    OP_REQUIRES_OK(context,
+                   ComputeConv2DDimension(params_, input, filter, &dimensions));
+    OP_REQUIRES(context, dimensions.in_depth == filter.dim_size(2),
+                errors::Unimplemented(
+                    "_FusedConv2D does not support grouped convolutions."));
+    OP_REQUIRES_OK(context, ValidateBias(bias, dimensions.out_depth));
+
+    TensorShape out_shape = ShapeFromFormat(
+        params_.data_format, dimensions.batch, dimensions.out_rows,
+        dimensions.out_cols, dimensions.out_depth);
+
+    // Output tensor is of the following dimensions:
+    // [ in_batch, out_rows, out_cols, out_depth ]
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, out_shape, &output));
+
+    // If there is nothing to compute, return.
+    if (out_shape.num_elements() == 0) {
+      return;
+    }
+
+    const T* bias_data = bias.flat<T>().data();
+    switch (fused_computation_) {
+      case FusedComputationType::kBiasAdd:
+        LaunchConv2DWithOutputKernel<T>(
+            context, input, filter, dimensions, params_.padding,
+            BiasAddOutputKernel<T, IdentityActivation>(bias_data), output);
+        break;
+      case FusedComputationType::kBiasAddWithRelu:
+        LaunchConv2DWithOutputKernel<T>(
+            context, input, filter, dimensions, params_.padding,
+            BiasAddOutputKernel<T, ReluActivation>(bias_data), output);
+        break;
+      case FusedComputationType::kBiasAddWithRelu6:
+        LaunchConv2DWithOutputKernel<T>(
+            context, input, filter, dimensions, params_.padding,
+            BiasAddOutputKernel<T, Relu6Activation>(bias_data), output);
+        break;
+      case FusedComputationType::kUndefined:
+        context->SetStatus(
+            errors::Internal("Fused computation must be defined"));
+        break;
+    }
+  }
+
+ private:
+  Conv2DParameters params_;
+  FusedComputationType fused_computation_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FusedConv2DOp);
+};
+
+#define REGISTER_CPU(T)                                                 \
+  REGISTER_KERNEL_BUILDER(                                              \
+      Name("_FusedConv2D").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedConv2DOp<CPUDevice, T>);
+
+TF_CALL_float(REGISTER_CPU);
+TF_CALL_double(REGISTER_CPU);
+
+#undef REGISTER_CPU
+
+}  // namespace tensorflow
@@ -122,6 +122,11 @@ class ConvParameters {
   uint64 hash() const { return hash_code_; }
 
   string ToString() const {
+    return strings::StrCat(ToStringWithoutDevice(), ", ", device_id_);
+  }
+
+  // Describes the convolution independently of the GPU it runs on.
+  string ToStringWithoutDevice() const {
     // clang-format off
     return strings::StrCat(
         batch_, ", ", in_depths_, ", ",
@@ -132,11 +137,12 @@ class ConvParameters {
         "(", str_util::Join(dilation_, ", "), "), ",
         "(", str_util::Join(stride_, ", "), "), ",
         "(", str_util::Join(padding_, ", "), "), ",
-        dtype_, ", ",
-        device_id_);
+        dtype_);
     // clang-format on
   }
 
+  int device_id() const { return device_id_; }
+
   // The purpose of this function is to disable winograd nonfused conv algorithm
   // for certain input parameters so as to avoid a bug in cuDNNv5 and cuDNNv6.
   template <typename T>
@@ -196,6 +202,16 @@ class ConvParameters {
   int device_id_;
 };
 
+// Lets the convolution autotuners share their results through the
+// AutotuneCache. Subclasses with more parameters don't match this overload,
+// so their results are not shared.
+inline bool GetAutotuneCacheKey(const ConvParameters& params, string* device,
+                                string* key) {
+  *device = GpuAutotuneDeviceKey(params.device_id());
+  *key = params.ToStringWithoutDevice();
+  return !device->empty();
+}
+
 typedef Eigen::GpuDevice GPUDevice;
 
 }  // namespace tensorflow
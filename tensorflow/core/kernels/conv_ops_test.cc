@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <stdlib.h>
+
 #include "tensorflow/cc/ops/const_op.h"
 #include "tensorflow/cc/ops/image_ops.h"
 #include "tensorflow/cc/ops/nn_ops.h"
@@ -522,4 +524,118 @@ TEST_F(ConvOpTest, HandwrittenConv) { HandwrittenConv(); }
 
 TEST_F(ConvOpTest, AnisotropicStride) { AnisotropicStrides(); }
 
+// Tests the Winograd DeepConv2D implementation of Conv2D (deep_conv2d.cc)
+// against a direct convolution.
+class DeepConv2DTest : public OpsTestBase {
+ protected:
+  DeepConv2DTest() { setenv("TF_USE_DEEP_CONV2D", "1", 1); }
+
+  ~DeepConv2DTest() override {
+    unsetenv("TF_USE_DEEP_CONV2D");
+    unsetenv("TF_DEEP_CONV2D_OUTPUT_TILE");
+  }
+
+  void MakeConv2D(const string& padding, const string& out_tile_size) {
+    setenv("TF_DEEP_CONV2D_OUTPUT_TILE", out_tile_size.c_str(), 1);
+    TF_ASSERT_OK(NodeDefBuilder("conv_op", "Conv2D")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("T", DT_FLOAT)
+                     .Attr("strides", {1, 1, 1, 1})
+                     .Attr("padding", padding)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Returns the direct 3x3 convolution of 'input' with 'filter'.
+  static Tensor ReferenceConv2D(const Tensor& input, const Tensor& filter,
+                                int pad) {
+    const int batch = input.dim_size(0);
+    const int in_rows = input.dim_size(1);
+    const int in_cols = input.dim_size(2);
+    const int in_depth = input.dim_size(3);
+    const int out_depth = filter.dim_size(3);
+    const int out_rows = in_rows + 2 * pad - 2;
+    const int out_cols = in_cols + 2 * pad - 2;
+    auto in = input.tensor<float, 4>();
+    auto f = filter.tensor<float, 4>();
+    Tensor output(DT_FLOAT,
+                  TensorShape({batch, out_rows, out_cols, out_depth}));
+    auto out = output.tensor<float, 4>();
+    for (int b = 0; b < batch; ++b) {
+      for (int r = 0; r < out_rows; ++r) {
+        for (int c = 0; c < out_cols; ++c) {
+          for (int od = 0; od < out_depth; ++od) {
+            double sum = 0;
+            for (int fr = 0; fr < 3; ++fr) {
+              for (int fc = 0; fc < 3; ++fc) {
+                const int in_r = r + fr - pad;
+                const int in_c = c + fc - pad;
+                if (in_r < 0 || in_r >= in_rows || in_c < 0 ||
+                    in_c >= in_cols) {
+                  continue;
+                }
+                for (int id = 0; id < in_depth; ++id) {
+                  sum += in(b, in_r, in_c, id) * f(fr, fc, id, od);
+                }
+              }
+            }
+            out(b, r, c, od) = sum;
+          }
+        }
+      }
+    }
+    return output;
+  }
+
+  void TestConv2D(const string& padding, const string& out_tile_size,
+                  float tolerance) {
+    MakeConv2D(padding, out_tile_size);
+    Tensor input(DT_FLOAT, TensorShape({2, 10, 9, 32}));
+    input.flat<float>().setRandom();
+    Tensor filter(DT_FLOAT, TensorShape({3, 3, 32, 32}));
+    filter.flat<float>().setRandom();
+    filter.flat<float>() -= filter.flat<float>().constant(0.5f);
+    AddInputFromArray<float>(input.shape(), input.flat<float>());
+    AddInputFromArray<float>(filter.shape(), filter.flat<float>());
+    TF_ASSERT_OK(RunOpKernel());
+    test::ExpectTensorNear<float>(
+        ReferenceConv2D(input, filter, padding == "SAME" ? 1 : 0),
+        *GetOutput(0), tolerance);
+  }
+};
+
+TEST_F(DeepConv2DTest, Winograd2x2Same) { TestConv2D("SAME", "2", 1e-4); }
+
+TEST_F(DeepConv2DTest, Winograd2x2Valid) { TestConv2D("VALID", "2", 1e-4); }
+
+TEST_F(DeepConv2DTest, Winograd4x4Same) { TestConv2D("SAME", "4", 5e-4); }
+
+TEST_F(DeepConv2DTest, Winograd4x4Valid) { TestConv2D("VALID", "4", 5e-4); }
+
+TEST_F(DeepConv2DTest, FilterCacheSeesInPlaceUpdate) {
+  MakeConv2D("SAME", "4");
+  Tensor input(DT_FLOAT, TensorShape({1, 8, 8, 32}));
+  input.flat<float>().setRandom();
+  Tensor filter(DT_FLOAT, TensorShape({3, 3, 32, 32}));
+  filter.flat<float>().setRandom();
+  filter.flat<float>() -= filter.flat<float>().constant(0.5f);
+  AddInputFromArray<float>(input.shape(), input.flat<float>());
+  AddInputFromArray<float>(filter.shape(), filter.flat<float>());
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorNear<float>(ReferenceConv2D(input, filter, 1),
+                                *GetOutput(0), 5e-4);
+
+  // Running again with the same filter reuses its transform, and updating
+  // the filter in place (like an optimizer does) invalidates it.
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorNear<float>(ReferenceConv2D(input, filter, 1),
+                                *GetOutput(0), 5e-4);
+  filter.flat<float>() = filter.flat<float>() * -2.0f;
+  inputs_[1].tensor->flat<float>() = filter.flat<float>();
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorNear<float>(ReferenceConv2D(input, filter, 1),
+                                *GetOutput(0), 5e-4);
+}
+
 }  // namespace tensorflow
@@ -19,8 +19,10 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/crop_and_resize_op.h"
 
+#include <algorithm>
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/register_types.h"
@@ -196,6 +198,55 @@ class CropAndResizeOp : public AsyncOpKernel {
   string method_;
 };
 
+namespace {
+
+// The input columns that an output column of a crop is interpolated from,
+// premultiplied by the depth, and the weight of the right one. A negative
+// left column means that the output column is outside of the image.
+struct CropInterpolation {
+  int64 left;
+  int64 right;
+  float lerp;
+};
+
+// Interpolates one row of a crop from the image rows above and below it.
+// When kDepth is not 0, it is the depth, known at compile time so that the
+// loop over channels is unrolled and vectorized.
+template <int kDepth, typename T>
+inline void CropAndResizeBilinearRow(const T* top_row, const T* bottom_row,
+                                     const float y_lerp,
+                                     const CropInterpolation* xs,
+                                     const int crop_width, const int depth,
+                                     const float extrapolation_value,
+                                     float* crop_row) {
+  const int num_channels = kDepth > 0 ? kDepth : depth;
+  for (int x = 0; x < crop_width; ++x) {
+    float* crop_x = crop_row + x * num_channels;
+    if (xs[x].left < 0) {
+      for (int d = 0; d < num_channels; ++d) {
+        crop_x[d] = extrapolation_value;
+      }
+      continue;
+    }
+    const T* top_left_ptr = top_row + xs[x].left;
+    const T* top_right_ptr = top_row + xs[x].right;
+    const T* bottom_left_ptr = bottom_row + xs[x].left;
+    const T* bottom_right_ptr = bottom_row + xs[x].right;
+    const float x_lerp = xs[x].lerp;
+    for (int d = 0; d < num_channels; ++d) {
+      const float top_left(static_cast<float>(top_left_ptr[d]));
+      const float top_right(static_cast<float>(top_right_ptr[d]));
+      const float bottom_left(static_cast<float>(bottom_left_ptr[d]));
+      const float bottom_right(static_cast<float>(bottom_right_ptr[d]));
+      const float top = top_left + (top_right - top_left) * x_lerp;
+      const float bottom = bottom_left + (bottom_right - bottom_left) * x_lerp;
+      crop_x[d] = top + (bottom - top) * y_lerp;
+    }
+  }
+}
+
+}  // namespace
+
 // Partial specialization of CropAndResize functor for a CPUDevice.
 namespace functor {
 template <typename T>
@@ -215,90 +266,100 @@ struct CropAndResize<CPUDevice, T> {
     const int crop_width = crops.dimension(2);
     const int depth = crops.dimension(3);
 
-    // Sharding across boxes.
-    auto CropAndResizePerBox = [&](int start_box, int limit_box) {
-      for (int b = start_box; b < limit_box; ++b) {
-        const float y1 = boxes(b, 0);
-        const float x1 = boxes(b, 1);
-        const float y2 = boxes(b, 2);
-        const float x2 = boxes(b, 3);
+    // Precompute the input columns and weights of every output column, which
+    // are the same for all the rows of a crop.
+    std::vector<CropInterpolation> xs(num_boxes * crop_width);
+    for (int b = 0; b < num_boxes; ++b) {
+      const float x1 = boxes(b, 1);
+      const float x2 = boxes(b, 3);
+      const float width_scale =
+          (crop_width > 1) ? (x2 - x1) * (image_width - 1) / (crop_width - 1)
+                           : 0;
+      for (int x = 0; x < crop_width; ++x) {
+        const float in_x = (crop_width > 1)
+                               ? x1 * (image_width - 1) + x * width_scale
+                               : 0.5 * (x1 + x2) * (image_width - 1);
+        CropInterpolation& interpolation = xs[b * crop_width + x];
+        if (in_x < 0 || in_x > image_width - 1) {
+          interpolation.left = -1;
+          continue;
+        }
+        if (method_name == "bilinear") {
+          const int left_x_index = floorf(in_x);
+          const int right_x_index = ceilf(in_x);
+          interpolation.left = left_x_index * depth;
+          interpolation.right = right_x_index * depth;
+          interpolation.lerp = in_x - left_x_index;
+        } else {  // method == "nearest"
+          interpolation.left = roundf(in_x) * depth;
+          interpolation.right = interpolation.left;
+          interpolation.lerp = 0;
+        }
+      }
+    }
+
+    const int64 image_row_size = static_cast<int64>(image_width) * depth;
+    const int64 crop_row_size = static_cast<int64>(crop_width) * depth;
 
+    // Sharding across the rows of all boxes, so that a single large crop
+    // also uses all the threads.
+    auto CropAndResizePerRow = [&](int64 start_row, int64 limit_row) {
+      for (int64 row = start_row; row < limit_row; ++row) {
+        const int b = row / crop_height;
+        const int y = row % crop_height;
         const int32 b_in = box_index(b);
         if (!FastBoundsCheck(b_in, batch_size)) {
           continue;
         }
 
+        const float y1 = boxes(b, 0);
+        const float y2 = boxes(b, 2);
         const float height_scale =
             (crop_height > 1)
                 ? (y2 - y1) * (image_height - 1) / (crop_height - 1)
                 : 0;
-        const float width_scale =
-            (crop_width > 1) ? (x2 - x1) * (image_width - 1) / (crop_width - 1)
-                             : 0;
-
-        for (int y = 0; y < crop_height; ++y) {
-          const float in_y = (crop_height > 1)
-                                 ? y1 * (image_height - 1) + y * height_scale
-                                 : 0.5 * (y1 + y2) * (image_height - 1);
-          if (in_y < 0 || in_y > image_height - 1) {
-            for (int x = 0; x < crop_width; ++x) {
-              for (int d = 0; d < depth; ++d) {
-                crops(b, y, x, d) = extrapolation_value;
-              }
-            }
-            continue;
+        const float in_y = (crop_height > 1)
+                               ? y1 * (image_height - 1) + y * height_scale
+                               : 0.5 * (y1 + y2) * (image_height - 1);
+        float* crop_row = crops.data() + row * crop_row_size;
+        if (in_y < 0 || in_y > image_height - 1) {
+          std::fill(crop_row, crop_row + crop_row_size, extrapolation_value);
+          continue;
+        }
+
+        const T* image_b = image.data() + b_in * image_height * image_row_size;
+        const CropInterpolation* row_xs = xs.data() + b * crop_width;
+        if (method_name == "bilinear") {
+          const int top_y_index = floorf(in_y);
+          const int bottom_y_index = ceilf(in_y);
+          const float y_lerp = in_y - top_y_index;
+          const T* top_row = image_b + top_y_index * image_row_size;
+          const T* bottom_row = image_b + bottom_y_index * image_row_size;
+          if (depth == 3) {
+            CropAndResizeBilinearRow<3>(top_row, bottom_row, y_lerp, row_xs,
+                                        crop_width, depth,
+                                        extrapolation_value, crop_row);
+          } else if (depth == 4) {
+            CropAndResizeBilinearRow<4>(top_row, bottom_row, y_lerp, row_xs,
+                                        crop_width, depth,
+                                        extrapolation_value, crop_row);
+          } else {
+            CropAndResizeBilinearRow<0>(top_row, bottom_row, y_lerp, row_xs,
+                                        crop_width, depth,
+                                        extrapolation_value, crop_row);
           }
-          if (method_name == "bilinear") {
-            const int top_y_index = floorf(in_y);
-            const int bottom_y_index = ceilf(in_y);
-            const float y_lerp = in_y - top_y_index;
-
-            for (int x = 0; x < crop_width; ++x) {
-              const float in_x = (crop_width > 1)
-                                     ? x1 * (image_width - 1) + x * width_scale
-                                     : 0.5 * (x1 + x2) * (image_width - 1);
-              if (in_x < 0 || in_x > image_width - 1) {
-                for (int d = 0; d < depth; ++d) {
-                  crops(b, y, x, d) = extrapolation_value;
-                }
-                continue;
-              }
-              const int left_x_index = floorf(in_x);
-              const int right_x_index = ceilf(in_x);
-              const float x_lerp = in_x - left_x_index;
-
-              for (int d = 0; d < depth; ++d) {
-                const float top_left(static_cast<float>(
-                    image(b_in, top_y_index, left_x_index, d)));
-                const float top_right(static_cast<float>(
-                    image(b_in, top_y_index, right_x_index, d)));
-                const float bottom_left(static_cast<float>(
-                    image(b_in, bottom_y_index, left_x_index, d)));
-                const float bottom_right(static_cast<float>(
-                    image(b_in, bottom_y_index, right_x_index, d)));
-                const float top = top_left + (top_right - top_left) * x_lerp;
-                const float bottom =
-                    bottom_left + (bottom_right - bottom_left) * x_lerp;
-                crops(b, y, x, d) = top + (bottom - top) * y_lerp;
-              }
+        } else {  // method == "nearest"
+          const int closest_y_index = roundf(in_y);
+          const T* image_row = image_b + closest_y_index * image_row_size;
+          for (int x = 0; x < crop_width; ++x) {
+            float* crop_x = crop_row + x * depth;
+            if (row_xs[x].left < 0) {
+              std::fill(crop_x, crop_x + depth, extrapolation_value);
+              continue;
             }
-          } else {  // method == "nearest"
-            for (int x = 0; x < crop_width; ++x) {
-              const float in_x = (crop_width > 1)
-                                     ? x1 * (image_width - 1) + x * width_scale
-                                     : 0.5 * (x1 + x2) * (image_width - 1);
-              if (in_x < 0 || in_x > image_width - 1) {
-                for (int d = 0; d < depth; ++d) {
-                  crops(b, y, x, d) = extrapolation_value;
-                }
-                continue;
-              }
-              const int closest_x_index = roundf(in_x);
-              const int closest_y_index = roundf(in_y);
-              for (int d = 0; d < depth; ++d) {
-                crops(b, y, x, d) = static_cast<float>(
-                    image(b_in, closest_y_index, closest_x_index, d));
-              }
+            const T* image_x = image_row + row_xs[x].left;
+            for (int d = 0; d < depth; ++d) {
+              crop_x[d] = static_cast<float>(image_x[d]);
             }
           }
         }
@@ -317,12 +378,13 @@ struct CropAndResize<CPUDevice, T> {
                        Eigen::TensorOpCost::AddCost<float>() * 4 +
                        Eigen::TensorOpCost::MulCost<float>() * 4;
     }
-    const double cost_per_box = crop_height * crop_width * cost_per_pixel;
+    const double cost_per_row = crop_width * cost_per_pixel;
 
     const DeviceBase::CpuWorkerThreads& worker_threads =
         *(context->device()->tensorflow_cpu_worker_threads());
-    Shard(worker_threads.num_threads, worker_threads.workers, num_boxes,
-          cost_per_box, CropAndResizePerBox);
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          static_cast<int64>(num_boxes) * crop_height, cost_per_row,
+          CropAndResizePerRow);
 
     return true;
   }
@@ -69,4 +69,11 @@ BM_CropAndResizeDev(cpu, 1, 640, 640, 3, 512, 512);
 BM_CropAndResizeDev(cpu, 1, 640, 640, 1, 512, 512);
 BM_CropAndResizeDev(cpu, 1, 80, 80, 512, 7, 7);
 
+// Crops of camera frames and of ImageNet-sized images to the input sizes of
+// common classification models.
+BM_CropAndResizeDev(cpu, 1, 1920, 1080, 3, 224, 224);
+BM_CropAndResizeDev(cpu, 1, 1920, 1080, 4, 224, 224);
+BM_CropAndResizeDev(cpu, 1, 1920, 1080, 3, 1024, 1024);
+BM_CropAndResizeDev(cpu, 8, 500, 375, 3, 299, 299);
+
 }  // namespace tensorflow
@@ -0,0 +1,214 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_CSR_SPARSE_MATRIX_H_
+#define TENSORFLOW_CORE_KERNELS_CSR_SPARSE_MATRIX_H_
+
+#define EIGEN_USE_THREADS
+
+#include <memory>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// A matrix in compressed sparse row format: the entries of row r are
+// col_indices[j] and values[j] for j in [row_ptr[r], row_ptr[r + 1]).
+template <typename T>
+struct CSRMatrix {
+  int64 rows = 0;
+  int64 cols = 0;
+  std::vector<int64> row_ptr;
+  std::vector<int64> col_indices;
+  std::vector<T> values;
+};
+
+// Builds the CSR form of the COO matrix with nnz entries
+// (indices(i, row_index), indices(i, col_index), values(i)), conjugating the
+// values if `conj`. The entries of every row keep their order in `indices`,
+// so products accumulate in the same order as they would over the COO
+// entries. Returns InvalidArgument for out of range indices.
+template <typename T, typename Tindices>
+Status COOToCSR(typename TTypes<Tindices>::ConstMatrix indices,
+                typename TTypes<T>::ConstVec values, int row_index,
+                int col_index, int64 rows, int64 cols, bool conj,
+                CSRMatrix<T>* csr) {
+  const int64 nnz = values.size();
+  csr->rows = rows;
+  csr->cols = cols;
+  csr->row_ptr.assign(rows + 1, 0);
+  csr->col_indices.resize(nnz);
+  csr->values.resize(nnz);
+  for (int64 i = 0; i < nnz; ++i) {
+    const Tindices m = internal::SubtleMustCopy(indices(i, row_index));
+    const Tindices k = internal::SubtleMustCopy(indices(i, col_index));
+    if (!FastBoundsCheck(k, cols)) {
+      return errors::InvalidArgument("k (", k, ") from index[", i, ",",
+                                     col_index, "] out of bounds (>=", cols,
+                                     ")");
+    }
+    if (!FastBoundsCheck(m, rows)) {
+      return errors::InvalidArgument("m (", m, ") from index[", i, ",",
+                                     row_index, "] out of bounds (>=", rows,
+                                     ")");
+    }
+    ++csr->row_ptr[m + 1];
+  }
+  for (int64 r = 0; r < rows; ++r) {
+    csr->row_ptr[r + 1] += csr->row_ptr[r];
+  }
+  // Counting sort by row; row_next[r] is the next free slot of row r.
+  std::vector<int64> row_next(csr->row_ptr.begin(), csr->row_ptr.end() - 1);
+  for (int64 i = 0; i < nnz; ++i) {
+    const int64 j = row_next[indices(i, row_index)]++;
+    csr->col_indices[j] = indices(i, col_index);
+    csr->values[j] = conj ? Eigen::numext::conj(values(i)) : values(i);
+  }
+  return Status::OK();
+}
+
+// Returns the conjugate transpose of `a`.
+template <typename T>
+std::unique_ptr<CSRMatrix<T>> CSRAdjoint(const CSRMatrix<T>& a) {
+  std::unique_ptr<CSRMatrix<T>> adjoint(new CSRMatrix<T>);
+  adjoint->rows = a.cols;
+  adjoint->cols = a.rows;
+  adjoint->row_ptr.assign(a.cols + 1, 0);
+  adjoint->col_indices.resize(a.values.size());
+  adjoint->values.resize(a.values.size());
+  for (const int64 col : a.col_indices) {
+    ++adjoint->row_ptr[col + 1];
+  }
+  for (int64 r = 0; r < adjoint->rows; ++r) {
+    adjoint->row_ptr[r + 1] += adjoint->row_ptr[r];
+  }
+  std::vector<int64> row_next(adjoint->row_ptr.begin(),
+                              adjoint->row_ptr.end() - 1);
+  for (int64 r = 0; r < a.rows; ++r) {
+    for (int64 j = a.row_ptr[r]; j < a.row_ptr[r + 1]; ++j) {
+      const int64 k = row_next[a.col_indices[j]]++;
+      adjoint->col_indices[k] = r;
+      adjoint->values[k] = Eigen::numext::conj(a.values[j]);
+    }
+  }
+  return adjoint;
+}
+
+// Computes out = a * b, where b is row major with `b.dimension(1)` columns,
+// sharding the rows of out over the intra-op pool. Every row of out is a
+// sum of scaled rows of b, which the inner loop computes with contiguous
+// (vectorizable) accesses.
+template <typename T>
+void CSRDenseMatMul(const Eigen::ThreadPoolDevice& d, const CSRMatrix<T>& a,
+                    typename TTypes<T>::ConstMatrix b,
+                    typename TTypes<T>::Matrix out) {
+  const int64 n = b.dimension(1);
+  const T* b_data = b.data();
+  T* out_data = out.data();
+  const int64 nnz = a.values.size();
+  const double nnz_per_row =
+      a.rows > 0 ? static_cast<double>(nnz) / a.rows : 0;
+  const Eigen::TensorOpCost cost(
+      (nnz_per_row + 1) * n * sizeof(T), n * sizeof(T),
+      nnz_per_row * n * (Eigen::TensorOpCost::AddCost<T>() +
+                         Eigen::TensorOpCost::MulCost<T>()));
+  d.parallelFor(a.rows, cost, [&](Eigen::Index begin, Eigen::Index end) {
+    for (Eigen::Index r = begin; r < end; ++r) {
+      T* out_row = out_data + r * n;
+      std::fill(out_row, out_row + n, T(0));
+      for (int64 j = a.row_ptr[r]; j < a.row_ptr[r + 1]; ++j) {
+        const T value = a.values[j];
+        const T* b_row = b_data + a.col_indices[j] * n;
+        for (int64 c = 0; c < n; ++c) {
+          out_row[c] += value * b_row[c];
+        }
+      }
+    }
+  });
+}
+
+// A CSR matrix resource, built once by AssignCSRSparseMatrix and reused by
+// every CSRSparseMatrixDenseMatMul until it is reassigned. Readers take a
+// reference to the current matrix, so they never block a reassignment.
+template <typename T>
+class CSRSparseMatrix : public ResourceBase {
+ public:
+  string DebugString() override {
+    tf_shared_lock l(mu_);
+    if (matrix_ == nullptr) return "CSRSparseMatrix (unassigned)";
+    return strings::StrCat("CSRSparseMatrix [", matrix_->rows, ", ",
+                           matrix_->cols, "] with ", matrix_->values.size(),
+                           " entries");
+  }
+
+  int64 MemoryUsed() const override {
+    tf_shared_lock l(mu_);
+    int64 bytes = 0;
+    for (const auto* m : {matrix_.get(), adjoint_.get()}) {
+      if (m != nullptr) {
+        bytes += m->row_ptr.size() * sizeof(int64) +
+                 m->col_indices.size() * sizeof(int64) +
+                 m->values.size() * sizeof(T);
+      }
+    }
+    return bytes;
+  }
+
+  void Assign(std::unique_ptr<CSRMatrix<T>> matrix) {
+    mutex_lock l(mu_);
+    matrix_ = std::move(matrix);
+    adjoint_.reset();
+  }
+
+  // Returns the matrix, or its conjugate transpose if `adjoint`, which is
+  // computed on first use and then cached with the matrix. Returns null if
+  // the matrix has not been assigned.
+  std::shared_ptr<const CSRMatrix<T>> Get(bool adjoint) {
+    std::shared_ptr<const CSRMatrix<T>> matrix;
+    {
+      tf_shared_lock l(mu_);
+      if (!adjoint || adjoint_ != nullptr) {
+        return adjoint ? adjoint_ : matrix_;
+      }
+      matrix = matrix_;
+    }
+    if (matrix == nullptr) return nullptr;
+    std::shared_ptr<const CSRMatrix<T>> result = CSRAdjoint(*matrix);
+    mutex_lock l(mu_);
+    // Only cache the adjoint if the matrix was not reassigned meanwhile.
+    if (matrix_ == matrix && adjoint_ == nullptr) {
+      adjoint_ = result;
+    }
+    return result;
+  }
+
+ private:
+  mutable mutex mu_;
+  std::shared_ptr<const CSRMatrix<T>> matrix_ GUARDED_BY(mu_);
+  std::shared_ptr<const CSRMatrix<T>> adjoint_ GUARDED_BY(mu_);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_CSR_SPARSE_MATRIX_H_
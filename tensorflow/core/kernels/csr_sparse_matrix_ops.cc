@@ -0,0 +1,165 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/sparse_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/csr_sparse_matrix.h"
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+template <typename T, typename Tindices>
+class AssignCSRSparseMatrixOp : public OpKernel {
+ public:
+  explicit AssignCSRSparseMatrixOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& indices = ctx->input(1);
+    const Tensor& values = ctx->input(2);
+    const Tensor& dense_shape = ctx->input(3);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(indices.shape()),
+                errors::InvalidArgument("Tensor 'indices' is not a matrix"));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(values.shape()),
+                errors::InvalidArgument("Tensor 'values' is not a vector"));
+    OP_REQUIRES(
+        ctx, dense_shape.shape() == TensorShape({2}),
+        errors::InvalidArgument("Tensor 'dense_shape' must have 2 elements"));
+    OP_REQUIRES(ctx, indices.dim_size(1) == 2,
+                errors::InvalidArgument("Tensor 'indices' must have 2 columns,",
+                                        " got: ", indices.dim_size(1)));
+    OP_REQUIRES(ctx, indices.dim_size(0) == values.dim_size(0),
+                errors::InvalidArgument(
+                    "Number of rows of 'indices' does not match number of ",
+                    "entries in 'values': ", indices.dim_size(0), " vs. ",
+                    values.dim_size(0)));
+    auto shape = dense_shape.vec<int64>();
+    OP_REQUIRES(ctx, shape(0) >= 0 && shape(1) >= 0,
+                errors::InvalidArgument("Tensor 'dense_shape' must be ",
+                                        "non-negative, got: [", shape(0), ", ",
+                                        shape(1), "]"));
+
+    std::unique_ptr<CSRMatrix<T>> csr(new CSRMatrix<T>);
+    OP_REQUIRES_OK(ctx, (COOToCSR<T, Tindices>(
+                            indices.matrix<Tindices>(), values.vec<T>(), 0, 1,
+                            shape(0), shape(1), false, csr.get())));
+
+    CSRSparseMatrix<T>* matrix = nullptr;
+    OP_REQUIRES_OK(ctx, LookupOrCreateResource<CSRSparseMatrix<T>>(
+                            ctx, HandleFromInput(ctx, 0), &matrix,
+                            [](CSRSparseMatrix<T>** ptr) {
+                              *ptr = new CSRSparseMatrix<T>;
+                              return Status::OK();
+                            }));
+    core::ScopedUnref unref(matrix);
+    matrix->Assign(std::move(csr));
+  }
+};
+
+template <typename T>
+class CSRSparseMatrixDenseMatMulOp : public OpKernel {
+ public:
+  explicit CSRSparseMatrixDenseMatMulOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("adjoint_a", &adjoint_a_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("adjoint_b", &adjoint_b_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    CSRSparseMatrix<T>* matrix = nullptr;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &matrix));
+    core::ScopedUnref unref(matrix);
+    std::shared_ptr<const CSRMatrix<T>> a = matrix->Get(adjoint_a_);
+    OP_REQUIRES(ctx, a != nullptr,
+                errors::FailedPrecondition(
+                    "Attempting to use an unassigned CSR sparse matrix"));
+
+    const Tensor& b = ctx->input(1);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(b.shape()),
+                errors::InvalidArgument("Tensor 'b' is not a matrix"));
+    const int64 inner_b = b.dim_size(adjoint_b_ ? 1 : 0);
+    const int64 outer_b = b.dim_size(adjoint_b_ ? 0 : 1);
+    OP_REQUIRES(
+        ctx, a->cols == inner_b,
+        errors::InvalidArgument(
+            "Cannot multiply A and B because inner dimension does not match: ",
+            a->cols, " vs. ", inner_b,
+            ".  Did you forget a transpose?  Dimensions of A: [", a->rows,
+            ", ", a->cols, "].  Dimensions of B: ", b.shape().DebugString()));
+
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_output(0, TensorShape({a->rows, outer_b}), &out));
+    if (out->NumElements() == 0) {
+      return;
+    }
+
+    const CPUDevice& d = ctx->eigen_device<CPUDevice>();
+    if (adjoint_b_) {
+      // Rows of b are scaled and summed, so make them contiguous once.
+      Eigen::array<int, 2> shuffle(1, 0);
+      Eigen::Tensor<T, 2, Eigen::RowMajor> conj_b =
+          b.matrix<T>().shuffle(shuffle).conjugate();
+      CSRDenseMatMul<T>(
+          d, *a,
+          typename TTypes<T>::ConstMatrix(conj_b.data(), inner_b, outer_b),
+          out->matrix<T>());
+    } else {
+      CSRDenseMatMul<T>(d, *a, b.matrix<T>(), out->matrix<T>());
+    }
+  }
+
+ private:
+  bool adjoint_a_;
+  bool adjoint_b_;
+};
+
+#define REGISTER_CPU(T)                                                 \
+  REGISTER_KERNEL_BUILDER(Name("CSRSparseMatrixHandle")                 \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("dtype"),              \
+                          ResourceHandleOp<CSRSparseMatrix<T>>);        \
+  REGISTER_KERNEL_BUILDER(Name("AssignCSRSparseMatrix")                 \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("dtype")               \
+                              .TypeConstraint<int32>("Tindices"),       \
+                          AssignCSRSparseMatrixOp<T, int32>);           \
+  REGISTER_KERNEL_BUILDER(Name("AssignCSRSparseMatrix")                 \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("dtype")               \
+                              .TypeConstraint<int64>("Tindices"),       \
+                          AssignCSRSparseMatrixOp<T, int64>);           \
+  REGISTER_KERNEL_BUILDER(Name("CSRSparseMatrixDenseMatMul")            \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T"),                  \
+                          CSRSparseMatrixDenseMatMulOp<T>);
+
+REGISTER_CPU(float);
+REGISTER_CPU(double);
+REGISTER_CPU(int32);
+REGISTER_CPU(complex64);
+REGISTER_CPU(complex128);
+#undef REGISTER_CPU
+
+}  // namespace tensorflow
@@ -1103,9 +1103,30 @@ template <typename T>
 class CudnnRNNCanonicalToParams<GPUDevice, T> : public CudnnRNNKernelCommon {
  public:
   explicit CudnnRNNCanonicalToParams(OpKernelConstruction* context)
-      : CudnnRNNKernelCommon(context) {}
+      : CudnnRNNKernelCommon(context),
+        cache_frozen_params_(CudnnRnnCacheFrozenParams()) {}
 
   void Compute(OpKernelContext* context) override {
+    // With frozen weights, the conversion only runs for the first call, and
+    // again if the inputs are ever different buffers.
+    std::vector<const void*> cache_key;
+    if (cache_frozen_params_) {
+      for (int i = 0; i < context->num_inputs(); ++i) {
+        cache_key.push_back(context->input(i).tensor_data().data());
+      }
+      // num_layers, num_units and input_size live in host memory.
+      for (int i = 0; i < 3; ++i) {
+        const Tensor& t = context->input(i);
+        const intptr_t value = t.NumElements() == 1 ? t.flat<int>()(0) : -1;
+        cache_key.push_back(reinterpret_cast<const void*>(value));
+      }
+      mutex_lock l(mu_);
+      if (cached_params_.IsInitialized() && cache_key == cache_key_) {
+        context->set_output(0, cached_params_);
+        return;
+      }
+    }
+
     std::unique_ptr<RnnDescriptor> rnn_desc;
     OP_REQUIRES_OK(context, ExtractCudnnRNNParamsInfo<T>(context, &rnn_desc));
     int64 params_size_in_bytes = rnn_desc->ParamsSizeInBytes();
@@ -1127,7 +1148,20 @@ class CudnnRNNCanonicalToParams<GPUDevice, T> : public CudnnRNNKernelCommon {
     OP_REQUIRES_OK(context, context->input_list("biases", &biases));
     RestoreParams<T>(biases, rnn_desc->ParamsBiasRegions(), &output_ptr,
                      stream);
+
+    if (cache_frozen_params_) {
+      mutex_lock l(mu_);
+      cached_params_ = *output;
+      cache_key_ = std::move(cache_key);
+    }
   }
+
+ private:
+  const bool cache_frozen_params_;
+  mutex mu_;
+  // The output of the last call and the inputs it was converted from.
+  Tensor cached_params_ GUARDED_BY(mu_);
+  std::vector<const void*> cache_key_ GUARDED_BY(mu_);
 };
 
 #define REGISTER_GPU(T)                                     \
@@ -1229,113 +1263,12 @@ class CudnnRNNForwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
                                const Tensor* input_c, const Tensor* params,
                                Tensor* output, Tensor* output_h,
                                Tensor* output_c,
-                               AlgorithmConfig* best_algo_config) {
-    CHECK_NE(best_algo_config, nullptr);
-    *best_algo_config = AlgorithmConfig();
-    return Status::OK();
-  }
-
-  bool is_training() const { return is_training_; }
-  bool is_debug_mode_;
-  bool debug_use_tensor_ops_;
-  int64 debug_cudnn_rnn_algo_;
-
- private:
-  Status AllocateOutputs(OpKernelContext* context,
-                         const CudnnRnnModelShapes& model_shapes,
-                         Tensor** output, Tensor** output_h,
-                         Tensor** output_c) {
-    const TensorShape& hidden_state_shape = model_shapes.hidden_state_shape;
-    const TensorShape& output_shape = model_shapes.output_shape;
-
-    TF_RETURN_IF_ERROR(context->allocate_output(0, output_shape, output));
-    TF_RETURN_IF_ERROR(
-        context->allocate_output(1, hidden_state_shape, output_h));
-    if (HasInputC()) {
-      TF_RETURN_IF_ERROR(
-          context->allocate_output(2, hidden_state_shape, output_c));
-    } else {
-      // Only LSTM uses input_c and output_c. So for all other models, we only
-      // need to create dummy outputs.
-      TF_RETURN_IF_ERROR(context->allocate_output(2, {}, output_c));
-    }
-    if (!is_training_) {
-      Tensor* dummy_reserve_space = nullptr;
-      TF_RETURN_IF_ERROR(context->allocate_output(3, {}, &dummy_reserve_space));
-    }
-    return Status::OK();
-  }
-
-  mutex mu_;
-  bool is_training_;
-  RnnStateCache rnn_state_cache_ GUARDED_BY(mu_);
-};
-
-#define REGISTER_GPU(T)                                           \
-  REGISTER_KERNEL_BUILDER(                                        \
-      Name("CudnnRNN").Device(DEVICE_GPU).TypeConstraint<T>("T"), \
-      CudnnRNNForwardOp<GPUDevice, T>);
-
-TF_CALL_half(REGISTER_GPU);
-TF_CALL_float(REGISTER_GPU);
-TF_CALL_double(REGISTER_GPU);
-#undef REGISTER_GPU
-
-template <typename T>
-class CudnnRNNForwardOpV2<GPUDevice, T>
-    : public CudnnRNNForwardOp<GPUDevice, T> {
- private:
-  using CudnnRNNForwardOp<GPUDevice, T>::is_training;
-  using CudnnRNNKernelCommon::CreateRnnDescriptor;
-  using CudnnRNNKernelCommon::dropout;
-  using CudnnRNNKernelCommon::HasInputC;
-  using CudnnRNNKernelCommon::model_types;
-
- public:
-  explicit CudnnRNNForwardOpV2(OpKernelConstruction* context)
-      : CudnnRNNForwardOp<GPUDevice, T>(context) {}
-
-  void Compute(OpKernelContext* context) override {
-    AlgorithmConfig best_algo_config;
-    CudnnRNNForwardOp<GPUDevice, T>::ComputeAndReturnAlgorithm(
-        context, &best_algo_config);
-    if (!context->status().ok()) {
-      return;
-    }
-
-    Tensor* output_host_reserved = nullptr;
-    // output_host_reserved stores opaque info used for backprop when running
-    // in training mode. At present, it includes a serialization of the best
-    // AlgorithmDesc picked during rnn forward pass autotune.
-    // int8 algorithm_id
-    // int8 use_tensor_op
-    // If autotune is not enabled, the algorithm_id is
-    // stream_executor::dnn::kDefaultAlgorithm and use_tensor_op is false. If
-    // running in inference mode, the output_host_reserved is currently not
-    // populated.
-    if (is_training()) {
-      OP_REQUIRES_OK(context, context->allocate_output(4, TensorShape({2}),
-                                                       &output_host_reserved));
-      auto output_host_reserved_int8 = output_host_reserved->vec<int8>();
-      output_host_reserved_int8(0) = best_algo_config.algorithm().algo_id();
-      output_host_reserved_int8(1) =
-          best_algo_config.algorithm().tensor_ops_enabled();
-    } else {
-      OP_REQUIRES_OK(context,
-                     context->allocate_output(4, {}, &output_host_reserved));
-    }
-  }
-
- protected:
-  Status MaybeAutoTune(OpKernelContext* context,
-                       const CudnnRnnModelShapes& model_shapes,
-                       const RnnInputMode& input_mode, const Tensor* input,
-                       const Tensor* input_h, const Tensor* input_c,
-                       const Tensor* params, Tensor* output, Tensor* output_h,
-                       Tensor* output_c,
-                       AlgorithmConfig* algo_config) override {
+                               AlgorithmConfig* algo_config) {
     CHECK_NE(algo_config, nullptr);
-    if (!CudnnRnnUseAutotune() || this->is_debug_mode_) {
+    // CudnnRNNBackprop always uses the default algorithm, so only the forward
+    // ops that pass their algorithm on can pick another one when training.
+    if (!CudnnRnnUseAutotune() || is_debug_mode_ ||
+        (is_training() && !CanAutoTuneTraining())) {
       *algo_config = AlgorithmConfig();
       return Status::OK();
     }
@@ -1463,6 +1396,101 @@ class CudnnRNNForwardOpV2<GPUDevice, T>
     AutoTuneRnnConfigMap::GetInstance()->Insert(rnn_params, *algo_config);
     return Status::OK();
   }
+
+  // Whether the algorithm can be autotuned when training, which requires the
+  // backward pass to use the same algorithm.
+  virtual bool CanAutoTuneTraining() const { return false; }
+
+  bool is_training() const { return is_training_; }
+  bool is_debug_mode_;
+  bool debug_use_tensor_ops_;
+  int64 debug_cudnn_rnn_algo_;
+
+ private:
+  Status AllocateOutputs(OpKernelContext* context,
+                         const CudnnRnnModelShapes& model_shapes,
+                         Tensor** output, Tensor** output_h,
+                         Tensor** output_c) {
+    const TensorShape& hidden_state_shape = model_shapes.hidden_state_shape;
+    const TensorShape& output_shape = model_shapes.output_shape;
+
+    TF_RETURN_IF_ERROR(context->allocate_output(0, output_shape, output));
+    TF_RETURN_IF_ERROR(
+        context->allocate_output(1, hidden_state_shape, output_h));
+    if (HasInputC()) {
+      TF_RETURN_IF_ERROR(
+          context->allocate_output(2, hidden_state_shape, output_c));
+    } else {
+      // Only LSTM uses input_c and output_c. So for all other models, we only
+      // need to create dummy outputs.
+      TF_RETURN_IF_ERROR(context->allocate_output(2, {}, output_c));
+    }
+    if (!is_training_) {
+      Tensor* dummy_reserve_space = nullptr;
+      TF_RETURN_IF_ERROR(context->allocate_output(3, {}, &dummy_reserve_space));
+    }
+    return Status::OK();
+  }
+
+  mutex mu_;
+  bool is_training_;
+  RnnStateCache rnn_state_cache_ GUARDED_BY(mu_);
+};
+
+#define REGISTER_GPU(T)                                           \
+  REGISTER_KERNEL_BUILDER(                                        \
+      Name("CudnnRNN").Device(DEVICE_GPU).TypeConstraint<T>("T"), \
+      CudnnRNNForwardOp<GPUDevice, T>);
+
+TF_CALL_half(REGISTER_GPU);
+TF_CALL_float(REGISTER_GPU);
+TF_CALL_double(REGISTER_GPU);
+#undef REGISTER_GPU
+
+template <typename T>
+class CudnnRNNForwardOpV2<GPUDevice, T>
+    : public CudnnRNNForwardOp<GPUDevice, T> {
+ private:
+  using CudnnRNNForwardOp<GPUDevice, T>::is_training;
+
+ public:
+  explicit CudnnRNNForwardOpV2(OpKernelConstruction* context)
+      : CudnnRNNForwardOp<GPUDevice, T>(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    AlgorithmConfig best_algo_config;
+    CudnnRNNForwardOp<GPUDevice, T>::ComputeAndReturnAlgorithm(
+        context, &best_algo_config);
+    if (!context->status().ok()) {
+      return;
+    }
+
+    Tensor* output_host_reserved = nullptr;
+    // output_host_reserved stores opaque info used for backprop when running
+    // in training mode. At present, it includes a serialization of the best
+    // AlgorithmDesc picked during rnn forward pass autotune.
+    // int8 algorithm_id
+    // int8 use_tensor_op
+    // If autotune is not enabled, the algorithm_id is
+    // stream_executor::dnn::kDefaultAlgorithm and use_tensor_op is false. If
+    // running in inference mode, the output_host_reserved is currently not
+    // populated.
+    if (is_training()) {
+      OP_REQUIRES_OK(context, context->allocate_output(4, TensorShape({2}),
+                                                       &output_host_reserved));
+      auto output_host_reserved_int8 = output_host_reserved->vec<int8>();
+      output_host_reserved_int8(0) = best_algo_config.algorithm().algo_id();
+      output_host_reserved_int8(1) =
+          best_algo_config.algorithm().tensor_ops_enabled();
+    } else {
+      OP_REQUIRES_OK(context,
+                     context->allocate_output(4, {}, &output_host_reserved));
+    }
+  }
+
+ protected:
+  // The algorithm is passed to the backward pass in output_host_reserved.
+  bool CanAutoTuneTraining() const override { return true; }
 };
 
 #define REGISTER_GPU(T)                                    \
@@ -21,6 +21,12 @@ namespace tensorflow {
 namespace data {
 namespace {
 
+// Batches of up to this many elements are allocated before the elements are
+// produced. Larger batch sizes are often used to gather all elements of a
+// dataset of unknown size, so their elements are collected before the batch is
+// allocated with the number of elements actually produced.
+constexpr int64 kMaxPreallocatedBatchSize = 1 << 14;
+
 // See documentation in ../../ops/dataset_ops.cc for a high-level
 // description of the following op.
 
@@ -124,76 +130,71 @@ class BatchDatasetOp : public UnaryDatasetOpKernel {
       Status GetNextInternal(IteratorContext* ctx,
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
-        // Each row of `batch_elements` is a tuple of tensors from the
-        // input iterator.
+        // If the batch is preallocated, each element is copied into its row
+        // of the output as soon as the input produces it, which releases the
+        // element while it is still in the cache. Otherwise the elements are
+        // collected in `batch_elements`, and copied once the size of the
+        // batch is known.
+        const bool preallocate =
+            dataset()->batch_size_ <= kMaxPreallocatedBatchSize;
         std::vector<std::vector<Tensor>> batch_elements;
+        std::vector<Tensor> batch_components;
+        int64 num_batch_elements = 0;
         {
           mutex_lock l(mu_);
           if (!input_impl_) {
             *end_of_sequence = true;
             return Status::OK();
           }
-          batch_elements.reserve(dataset()->batch_size_);
+          if (!preallocate) {
+            batch_elements.reserve(dataset()->batch_size_);
+          }
           *end_of_sequence = false;
           for (int i = 0; i < dataset()->batch_size_ && !*end_of_sequence;
                ++i) {
             std::vector<Tensor> batch_element_tuple;
             TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &batch_element_tuple,
                                                     end_of_sequence));
-            if (!*end_of_sequence) {
-              batch_elements.emplace_back(std::move(batch_element_tuple));
-            } else {
+            if (*end_of_sequence) {
               input_impl_.reset();
+            } else if (preallocate) {
+              TF_RETURN_IF_ERROR(CopyToBatch(
+                  ctx, dataset()->batch_size_, num_batch_elements++,
+                  std::move(batch_element_tuple), &batch_components));
+            } else {
+              batch_elements.emplace_back(std::move(batch_element_tuple));
+              ++num_batch_elements;
             }
           }
         }
 
-        if (batch_elements.empty()) {
+        if (num_batch_elements == 0) {
           DCHECK(*end_of_sequence);
           return Status::OK();
         }
 
         if (dataset()->drop_remainder_ &&
-            batch_elements.size() < dataset()->batch_size_) {
+            num_batch_elements < dataset()->batch_size_) {
           *end_of_sequence = true;
           return Status::OK();
         }
 
-        // Copy the retrieved batch elements into one output tensor
-        // per tuple component.
-        // NOTE(mrry): If the input or output sizes are statically
-        // known, we could potentially read the input values in-place
-        // into their respective slice locations. This would require a
-        // different GetNext() overload that supports zero-copy, and might
-        // make sense in an optimization pass.
-        const size_t num_tuple_components = batch_elements[0].size();
-        const int64 num_batch_elements = batch_elements.size();
-        for (size_t component_index = 0; component_index < num_tuple_components;
-             ++component_index) {
-          const Tensor& first_element = batch_elements[0][component_index];
-          TensorShape batch_component_shape({num_batch_elements});
-          batch_component_shape.AppendShape(first_element.shape());
-          Tensor batch_component(ctx->allocator({}), first_element.dtype(),
-                                 batch_component_shape);
-          // Build the output tuple component by copying one slice
-          // from each input element in the batch.
-          for (size_t i = 0; i < num_batch_elements; ++i) {
-            if (batch_elements[i][component_index].shape() !=
-                first_element.shape()) {
-              return errors::InvalidArgument(
-                  "Cannot batch tensors with different shapes in component ",
-                  component_index, ". First element had shape ",
-                  first_element.shape().DebugString(), " and element ", i,
-                  " had shape ",
-                  batch_elements[i][component_index].shape().DebugString(),
-                  ".");
+        if (preallocate) {
+          if (num_batch_elements < dataset()->batch_size_) {
+            // The last batch of the input is smaller. Its rows are a prefix
+            // of the preallocated output.
+            for (Tensor& batch_component : batch_components) {
+              batch_component = batch_component.Slice(0, num_batch_elements);
             }
-            TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
-                std::move(batch_elements[i][component_index]), &batch_component,
-                i));
           }
-          out_tensors->emplace_back(std::move(batch_component));
+        } else {
+          for (int64 i = 0; i < num_batch_elements; ++i) {
+            TF_RETURN_IF_ERROR(CopyToBatch(ctx, num_batch_elements, i,
+                                           std::move(batch_elements[i]),
+                                           &batch_components));
+          }
         }
+        *out_tensors = std::move(batch_components);
         *end_of_sequence = false;
         return Status::OK();
       }
@@ -222,6 +223,54 @@ class BatchDatasetOp : public UnaryDatasetOpKernel {
       }
 
      private:
+      // Copies the components of `element` into row `index` of
+      // `batch_components`, allocating them with `batch_size` rows for the
+      // first element of the batch.
+      static Status CopyToBatch(IteratorContext* ctx, int64 batch_size,
+                                int64 index, std::vector<Tensor>&& element,
+                                std::vector<Tensor>* batch_components) {
+        if (index == 0) {
+          batch_components->reserve(element.size());
+          for (const Tensor& component : element) {
+            TensorShape batch_component_shape({batch_size});
+            batch_component_shape.AppendShape(component.shape());
+            batch_components->emplace_back(ctx->allocator({}),
+                                           component.dtype(),
+                                           batch_component_shape);
+          }
+        }
+        for (size_t component_index = 0; component_index < element.size();
+             ++component_index) {
+          Tensor* batch_component = &(*batch_components)[component_index];
+          Tensor& component = element[component_index];
+          if (!SameElementShape(*batch_component, component)) {
+            TensorShape first_shape = batch_component->shape();
+            first_shape.RemoveDim(0);
+            return errors::InvalidArgument(
+                "Cannot batch tensors with different shapes in component ",
+                component_index, ". First element had shape ",
+                first_shape.DebugString(), " and element ", index,
+                " had shape ", component.shape().DebugString(), ".");
+          }
+          TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
+              std::move(component), batch_component, index));
+        }
+        return Status::OK();
+      }
+
+      // Returns whether `element` has the shape of the rows of `batch`.
+      static bool SameElementShape(const Tensor& batch, const Tensor& element) {
+        if (batch.dims() != element.dims() + 1) {
+          return false;
+        }
+        for (int d = 0; d < element.dims(); ++d) {
+          if (batch.dim_size(d + 1) != element.dim_size(d)) {
+            return false;
+          }
+        }
+        return true;
+      }
+
       mutex mu_;
       std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
     };
@@ -15,6 +15,10 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
@@ -29,7 +33,9 @@ namespace {
 class CacheDatasetOp : public UnaryDatasetOpKernel {
  public:
   explicit CacheDatasetOp(OpKernelConstruction* ctx)
-      : UnaryDatasetOpKernel(ctx) {}
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("shuffle_reads", &shuffle_reads_));
+  }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                    DatasetBase** output) override {
@@ -41,7 +47,8 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
     if (filename.empty()) {
       *output = new MemoryDataset(ctx, input);
     } else {
-      *output = new FileDataset(ctx, input, filename, ctx->env());
+      *output = new FileDataset(ctx, input, filename, shuffle_reads_,
+                                ctx->env());
     }
   }
 
@@ -49,10 +56,11 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
   class FileDataset : public DatasetBase {
    public:
     explicit FileDataset(OpKernelContext* ctx, const DatasetBase* input,
-                         string filename, Env* env)
+                         string filename, bool shuffle_reads, Env* env)
         : DatasetBase(DatasetContext(ctx)),
           input_(input),
           filename_(std::move(filename)),
+          shuffle_reads_(shuffle_reads),
           env_(env),
           num_tensors_(input->output_dtypes().size()),
           tensor_index_padding_size_(StringPaddingSize(num_tensors_)),
@@ -92,7 +100,11 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
       TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph));
       Node* filename = nullptr;
       TF_RETURN_IF_ERROR(b->AddScalar(filename_, &filename));
-      TF_RETURN_IF_ERROR(b->AddDataset(this, {input_graph, filename}, output));
+      AttrValue shuffle_reads;
+      b->BuildAttrValue(shuffle_reads_, &shuffle_reads);
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this, {input_graph, filename},
+          {std::make_pair("shuffle_reads", shuffle_reads)}, output));
       return Status::OK();
     }
 
@@ -183,6 +195,12 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
       // partial cache gets flushed to disk in files with prefix
       // <filename>_<shard_id> where shard_id is unique for each checkpoint.
       // When all elements have been produced, these shards get coalesced.
+      //
+      // Each lockfile records a random token, which is saved in the
+      // checkpoint together with the shard it belongs to. When restoring from
+      // a checkpoint finds the lockfile of the current shard with the saved
+      // token, the lockfile was left behind by this iterator before the
+      // process was preempted, and writing the shard resumes.
       class FileWriterIterator : public DatasetIterator<FileDataset> {
        public:
         explicit FileWriterIterator(const Params& params)
@@ -193,6 +211,7 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
                   strings::StrCat(params.dataset->filename_, "_", shard_id_)),
               lockfile_(strings::StrCat(filename_, ".lockfile")),
               lockfile_created_(false),
+              lockfile_token_(random::New64()),
               iteration_completed_(false) {}
 
         Status Initialize(IteratorContext* ctx) override {
@@ -269,12 +288,16 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
             filename_ = strings::StrCat(dataset()->filename_, "_", shard_id_);
             lockfile_ = strings::StrCat(filename_, ".lockfile");
             lockfile_created_ = false;
+            lockfile_token_ = random::New64();
           }
           TF_RETURN_IF_ERROR(SaveInput(writer, input_impl_));
           TF_RETURN_IF_ERROR(
               writer->WriteScalar(full_name("cur_index"), cur_index_));
           TF_RETURN_IF_ERROR(
               writer->WriteScalar(full_name("shard_id"), shard_id_));
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name("lockfile_token"),
+                                  static_cast<int64>(lockfile_token_)));
           return Status::OK();
         }
 
@@ -308,6 +331,15 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
               return errors::Internal("Invalid value for shard_id ", temp);
             }
           }
+          // Checkpoints written before lockfile tokens were introduced do not
+          // have one; a lockfile left behind by them is never taken over.
+          restored_lockfile_token_ = 0;
+          if (reader->Contains(full_name("lockfile_token"))) {
+            TF_RETURN_IF_ERROR(
+                reader->ReadScalar(full_name("lockfile_token"), &temp));
+            lockfile_token_ = static_cast<uint64>(temp);
+            restored_lockfile_token_ = lockfile_token_;
+          }
           filename_ = strings::StrCat(dataset()->filename_, "_", shard_id_);
           lockfile_ = strings::StrCat(filename_, ".lockfile");
           writer_.reset(new BundleWriter(dataset()->env_, filename_));
@@ -344,6 +376,16 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
             if (dataset()->env_->NewRandomAccessFile(lockfile_, &file).ok()) {
               file->Read(0, 150, &contents, contents_scratch).IgnoreError();
             }
+            if (restored_lockfile_token_ != 0 &&
+                str_util::EndsWith(contents,
+                                   LockfileTokenString(lockfile_token_))) {
+              LOG(WARNING) << "Resuming to write the cache file " << filename_
+                           << ", whose lockfile (" << lockfile_
+                           << ") was left behind by this iterator before it "
+                           << "was restored from a checkpoint.";
+              restored_lockfile_token_ = 0;
+              return CreateLockFile();
+            }
             return errors::AlreadyExists(
                 "There appears to be a concurrent caching iterator running - "
                 "cache lockfile already exists ('",
@@ -354,28 +396,40 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
                 "iterator. Lockfile contents: ",
                 contents);
           } else {
-            // Create the file, and write some basic contents.
-            std::unique_ptr<WritableFile> lockfile;
-            TF_RETURN_IF_ERROR(
-                dataset()->env_->NewWritableFile(lockfile_, &lockfile));
-            TF_RETURN_IF_ERROR(lockfile->Append(strings::StrCat(
-                "Created at: ", dataset()->env_->NowSeconds())));
-
-            // At this point we know that
-            // 1. There is no conflicting checkpoint with prefix `filename_`.
-            // 2. There is no concurrent session that is trying to write a ckpt
-            //    to filename.
-            // So it is safe to create a BundleWriter here. Note that it is
-            // unsafe to initialize the BundleWriter anywhere the above
-            // conditions are not met since BundleWriter's constructor creates
-            // new temp files which can delete the temp files created by a
-            // BundleWriter in another Session.
-            writer_.reset(new BundleWriter(dataset()->env_, filename_));
-            lockfile_created_ = true;
-            return Status::OK();
+            return CreateLockFile();
           }
         }
 
+        // Returns the suffix of the lockfile contents that identifies "token".
+        static string LockfileTokenString(uint64 token) {
+          return strings::StrCat("\nToken: ", token);
+        }
+
+        // Creates the lockfile of the current shard and its BundleWriter.
+        Status CreateLockFile() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+          // Create the file, and write some basic contents.
+          std::unique_ptr<WritableFile> lockfile;
+          TF_RETURN_IF_ERROR(
+              dataset()->env_->NewWritableFile(lockfile_, &lockfile));
+          TF_RETURN_IF_ERROR(lockfile->Append(
+              strings::StrCat("Created at: ", dataset()->env_->NowSeconds(),
+                              LockfileTokenString(lockfile_token_))));
+          TF_RETURN_IF_ERROR(lockfile->Close());
+
+          // At this point we know that
+          // 1. There is no conflicting checkpoint with prefix `filename_`.
+          // 2. There is no concurrent session that is trying to write a ckpt
+          //    to filename.
+          // So it is safe to create a BundleWriter here. Note that it is
+          // unsafe to initialize the BundleWriter anywhere the above
+          // conditions are not met since BundleWriter's constructor creates
+          // new temp files which can delete the temp files created by a
+          // BundleWriter in another Session.
+          writer_.reset(new BundleWriter(dataset()->env_, filename_));
+          lockfile_created_ = true;
+          return Status::OK();
+        }
+
         Status Finish() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
           iteration_completed_ = true;
           // Flush the current bundle.
@@ -417,52 +471,58 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
         std::unique_ptr<BundleWriter> writer_ GUARDED_BY(mu_);
         string lockfile_ GUARDED_BY(mu_);
         bool lockfile_created_ GUARDED_BY(mu_);
+        // The token written to the lockfile of the current shard.
+        uint64 lockfile_token_ GUARDED_BY(mu_);
+        // The token restored from a checkpoint, until the lockfile of the
+        // current shard is created or taken over; 0 otherwise.
+        uint64 restored_lockfile_token_ GUARDED_BY(mu_) = 0;
         bool iteration_completed_ GUARDED_BY(mu_);
       };  // FileWriterIterator
 
+      // FileReaderIterator produces the elements of a completely written
+      // cache.
+      //
+      // The metadata table of the bundle maps the key of each tensor to its
+      // offset in the data files, so it serves as an index of the cached
+      // elements: every element is looked up by its index instead of by
+      // scanning the bundle. This lets any number of reader iterators run
+      // concurrently, each at its own position, and with `shuffle_reads` lets
+      // each of them read the elements in its own random order.
       class FileReaderIterator : public DatasetIterator<FileDataset> {
        public:
         explicit FileReaderIterator(const Params& params)
             : DatasetIterator<FileDataset>(params),
               cur_index_(0),
-              reader_(dataset()->env_, dataset()->filename_),
-              iterator_restored_(false) {}
+              num_elements_(0),
+              seed_(random::New64()),
+              reader_(dataset()->env_, dataset()->filename_) {}
+
+        Status Initialize(IteratorContext* ctx) override {
+          mutex_lock l(mu_);
+          TF_RETURN_IF_ERROR(reader_.status());
+          num_elements_ = CountElements();
+          InitializeOrder();
+          return Status::OK();
+        }
 
         Status GetNextInternal(IteratorContext* ctx,
                                std::vector<Tensor>* out_tensors,
                                bool* end_of_sequence) override {
           mutex_lock l(mu_);
-          *end_of_sequence = false;
           TF_RETURN_IF_ERROR(reader_.status());
-          if (!reader_.Valid()) {
-            return errors::Internal(
-                "Cache iterator is in an invalid state. (Perhaps GetNext "
-                "called "
-                "after end_of_sequence?)");
+          if (cur_index_ >= num_elements_) {
+            *end_of_sequence = true;
+            return Status::OK();
           }
+          const size_t item_index =
+              order_.empty() ? cur_index_ : order_[cur_index_];
           out_tensors->clear();
           out_tensors->resize(dataset()->num_tensors_);
-
           for (size_t i = 0; i < dataset()->num_tensors_; ++i) {
-            // When the iterator is restored from the checkpoint, `reader_` is
-            // already pointing at `key` so we do not need to skip the header
-            // entry.
-            if (!iterator_restored_) {
-              reader_
-                  .Next();  // The first entry in the table is a header entry.
-            } else {
-              iterator_restored_ = false;
-            }
-            if (!reader_.Valid()) {
-              out_tensors->clear();
-              *end_of_sequence = true;
-              return Status::OK();
-            }
-            StringPiece key = reader_.key();
-            DCHECK_EQ(key, dataset()->FormatName(cur_index_, i));
-            TF_RETURN_IF_ERROR(reader_.ReadCurrent(&(*out_tensors)[i]));
-            TF_RETURN_IF_ERROR(reader_.status());
+            TF_RETURN_IF_ERROR(reader_.Lookup(
+                dataset()->FormatName(item_index, i), &(*out_tensors)[i]));
           }
+          *end_of_sequence = false;
           cur_index_++;
           return Status::OK();
         }
@@ -472,6 +532,8 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
           mutex_lock l(mu_);
           TF_RETURN_IF_ERROR(
               writer->WriteScalar(full_name("cur_index"), cur_index_));
+          TF_RETURN_IF_ERROR(writer->WriteScalar(full_name("seed"),
+                                                 static_cast<int64>(seed_)));
           return Status::OK();
         }
 
@@ -490,19 +552,71 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
               return errors::Internal("Invalid value for cur_index ", temp);
             }
           }
-          if (!reader_.Valid()) {
-            return errors::Internal("Error initializing BundleReader.");
+          // The seed is absent from checkpoints of writer iterators that are
+          // restored as readers, and from checkpoints written before shuffled
+          // reads were introduced. Both of them read in order.
+          if (iterator_state_reader->Contains(full_name("seed"))) {
+            int64 temp;
+            TF_RETURN_IF_ERROR(
+                iterator_state_reader->ReadScalar(full_name("seed"), &temp));
+            seed_ = static_cast<uint64>(temp);
+            InitializeOrder();
+          } else {
+            order_.clear();
+          }
+          if (cur_index_ > num_elements_) {
+            return errors::Internal("Invalid value for cur_index ", cur_index_,
+                                    ", the cache has ", num_elements_,
+                                    " elements.");
           }
-          reader_.Seek(dataset()->FormatName(cur_index_, 0));
-          iterator_restored_ = true;
           return Status::OK();
         }
 
        private:
+        // Returns the number of cached elements. The writer adds the tensors
+        // of the elements `0, 1, ..., n - 1`, so `n` is found by a binary
+        // search for the first element whose first tensor is missing from the
+        // metadata table.
+        size_t CountElements() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+          size_t lo = 0;
+          size_t hi = kMaxItems + 1;
+          while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (reader_.Contains(dataset()->FormatName(mid, 0))) {
+              lo = mid + 1;
+            } else {
+              hi = mid;
+            }
+          }
+          return lo;
+        }
+
+        // Builds the order in which the elements are read from `seed_`, or
+        // clears it to read the elements in the order they were cached.
+        void InitializeOrder() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+          order_.clear();
+          if (!dataset()->shuffle_reads_) return;
+          order_.resize(num_elements_);
+          for (size_t i = 0; i < num_elements_; ++i) {
+            order_[i] = i;
+          }
+          random::PhiloxRandom parent_generator(seed_);
+          random::SimplePhilox generator(&parent_generator);
+          for (size_t i = num_elements_; i > 1; --i) {
+            std::swap(order_[i - 1], order_[generator.Uniform64(i)]);
+          }
+        }
+
         mutex mu_;
+        // The number of elements produced so far.
         size_t cur_index_ GUARDED_BY(mu_);
+        size_t num_elements_ GUARDED_BY(mu_);
+        // The seed of the order in which the elements are read.
+        uint64 seed_ GUARDED_BY(mu_);
+        // The index of the `i`-th element to produce when reads are shuffled;
+        // empty otherwise.
+        std::vector<size_t> order_ GUARDED_BY(mu_);
         BundleReader reader_ GUARDED_BY(mu_);
-        bool iterator_restored_ GUARDED_BY(mu_);
       };  // FileReaderIterator
 
       void InitializeIterator() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -533,6 +647,7 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
 
     const DatasetBase* const input_;
     const string filename_;
+    const bool shuffle_reads_;
     Env* const env_;
     const size_t num_tensors_;
     const size_t tensor_index_padding_size_;
@@ -589,10 +704,22 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
     // The expected use is that a single `MemoryWriterIterator` populates the
     // cache with dataset elements. Once all elements are cached, the cache can
     // be used by one or more `MemoryReaderIterator`s.
+    //
+    // The cached bytes are accounted for in `BufferBudget::Global()`. As the
+    // cache must hold all elements of the dataset, it does not shrink when the
+    // budget is exceeded.
     class MemoryCache {
      public:
       MemoryCache() = default;
 
+      ~MemoryCache() { BufferBudget::Global()->Remove(bytes_); }
+
+      // Returns the number of bytes held by the cached elements.
+      int64 bytes() {
+        tf_shared_lock l(mu_);
+        return bytes_;
+      }
+
       // Marks the cache as completed.
       void Complete() {
         mutex_lock l(mu_);
@@ -627,6 +754,8 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
         claimed_ = false;
         completed_ = false;
         cache_.clear();
+        BufferBudget::Global()->Remove(bytes_);
+        bytes_ = 0;
       }
 
       // Returns the element at the given index.
@@ -638,7 +767,10 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
 
       // Adds the element to the cache.
       void emplace_back(std::vector<Tensor> element) {
+        int64 num_bytes = GetTotalBytes(element);
+        BufferBudget::Global()->Add(num_bytes);
         mutex_lock l(mu_);
+        bytes_ += num_bytes;
         cache_.emplace_back(std::move(element));
       }
 
@@ -655,6 +787,8 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
       // Determines whether all elements of the dataset have been cached.
       bool completed_ GUARDED_BY(mu_) = false;
       std::vector<std::vector<Tensor>> cache_ GUARDED_BY(mu_);
+      // The number of bytes held by the elements of `cache_`.
+      int64 bytes_ GUARDED_BY(mu_) = 0;
     };
 
     class MemoryIterator : public DatasetIterator<MemoryDataset> {
@@ -675,6 +809,8 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
         return iterator_->Initialize(ctx);
       }
 
+      int64 BufferedBytes() override { return cache_->bytes(); }
+
       Status GetNextInternal(IteratorContext* ctx,
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
@@ -795,6 +931,7 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
             return Status::OK();
           }
           cache_->emplace_back(*out_tensors);
+          RecordBufferedBytes(ctx, cache_->bytes());
           return Status::OK();
         }
 
@@ -887,6 +1024,8 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
     const DatasetBase* const input_;
     const std::shared_ptr<MemoryCache> cache_;
   };  // MemoryDataset
+
+  bool shuffle_reads_;
 };    // CacheDatasetOp
 
 REGISTER_KERNEL_BUILDER(Name("CacheDataset").Device(DEVICE_CPU),
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/util/csv_fast_parsing.h"
 
 namespace tensorflow {
 namespace data {
@@ -438,7 +439,7 @@ class CSVDatasetOp : public DatasetOpKernel {
         pos_++;  // Starting quotation mark
 
         Status parse_result;
-        while (true) {  // Each iter reads 1 char, filling buffer if necessary
+        while (true) {  // Each iter skips a run of chars, filling buffer
           if (pos_ >= buffer_.size()) {
             Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
             if (errors::IsOutOfRange(s)) {
@@ -492,7 +493,13 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
 
           } else {
-            pos_++;
+            // Skip to the next quote, which is the only character that can
+            // end the field.
+            const void* quote =
+                memchr(&buffer_[pos_], '"', buffer_.size() - pos_);
+            pos_ = quote == nullptr
+                       ? buffer_.size()
+                       : static_cast<const char*>(quote) - buffer_.data();
           }
         }
       }
@@ -570,7 +577,7 @@ class CSVDatasetOp : public DatasetOpKernel {
         size_t start = pos_;
         Status parse_result;
 
-        while (true) {  // Each iter reads 1 char, filling buffer if necessary
+        while (true) {  // Each iter skips a run of chars, filling buffer
           if (pos_ >= buffer_.size()) {
             Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
             // Handle errors
@@ -586,6 +593,14 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
           }
 
+          // Skip the characters that cannot end the field.
+          const char* buffer_end = buffer_.data() + buffer_.size();
+          pos_ = csv::FindFieldEnd(&buffer_[pos_], buffer_end,
+                                   dataset()->delim_,
+                                   dataset()->use_quote_delim_) -
+                 buffer_.data();
+          if (pos_ >= buffer_.size()) continue;
+
           char ch = buffer_[pos_];
 
           if (ch == dataset()->delim_) {
@@ -688,7 +703,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                   dataset()->record_defaults_[output_idx].flat<float>()(0);
             } else {
               float value;
-              if (!strings::safe_strtof(field, &value)) {
+              if (!csv::ParseFloat(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid float: ", field);
@@ -703,7 +718,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                   dataset()->record_defaults_[output_idx].flat<double>()(0);
             } else {
               double value;
-              if (!strings::safe_strtod(field, &value)) {
+              if (!csv::ParseDouble(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid double: ", field);
@@ -0,0 +1,321 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <deque>
+
+#include "tensorflow/core/distributed_runtime/data/data_service.h"
+#include "tensorflow/core/distributed_runtime/rpc/data/grpc_data_client.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// See documentation in ../../ops/experimental_dataset_ops.cc for a high-level
+// description of the following op.
+
+class DataServiceDatasetOp : public DatasetOpKernel {
+ public:
+  explicit DataServiceDatasetOp(OpKernelConstruction* ctx)
+      : DatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("max_outstanding_requests",
+                                     &max_outstanding_requests_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
+    string dispatcher_address;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "dispatcher_address",
+                                                    &dispatcher_address));
+    string job_name;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<string>(ctx, "job_name", &job_name));
+    string graph_def;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<string>(ctx, "graph_def", &graph_def));
+    DatasetDef dataset_def;
+    OP_REQUIRES(ctx, dataset_def.mutable_graph()->ParseFromString(graph_def),
+                errors::InvalidArgument("Could not parse the dataset graph"));
+    string dataset_tensor;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "dataset_tensor",
+                                                    &dataset_tensor));
+    dataset_def.set_dataset_tensor(dataset_tensor);
+    string split_tensor;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "split_tensor",
+                                                    &split_tensor));
+    dataset_def.set_split_tensor(split_tensor);
+    int64 num_splits;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<int64>(ctx, "num_splits", &num_splits));
+    OP_REQUIRES(ctx, num_splits >= 1,
+                errors::InvalidArgument("num_splits must be at least 1, got ",
+                                        num_splits));
+    *output = new Dataset(ctx, dispatcher_address, job_name, graph_def,
+                          dataset_def, num_splits, max_outstanding_requests_,
+                          output_types_, output_shapes_);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, const string& dispatcher_address,
+            const string& job_name, const string& graph_def,
+            const DatasetDef& dataset_def, int64 num_splits,
+            int64 max_outstanding_requests, const DataTypeVector& output_types,
+            const std::vector<PartialTensorShape>& output_shapes)
+        : DatasetBase(DatasetContext(ctx)),
+          dispatcher_address_(dispatcher_address),
+          job_name_(job_name),
+          graph_def_(graph_def),
+          dataset_def_(dataset_def),
+          num_splits_(num_splits),
+          max_outstanding_requests_(max_outstanding_requests),
+          output_types_(output_types),
+          output_shapes_(output_shapes) {}
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return std::unique_ptr<IteratorBase>(
+          new Iterator({this, strings::StrCat(prefix, "::DataService")}));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() const override {
+      return "DataServiceDatasetOp::Dataset";
+    }
+
+   protected:
+    Status AsGraphDefInternal(SerializationContext* ctx,
+                              DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* dispatcher_address = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(dispatcher_address_,
+                                      &dispatcher_address));
+      Node* job_name = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(job_name_, &job_name));
+      Node* graph_def = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(graph_def_, &graph_def));
+      Node* dataset_tensor = nullptr;
+      TF_RETURN_IF_ERROR(
+          b->AddScalar(dataset_def_.dataset_tensor(), &dataset_tensor));
+      Node* split_tensor = nullptr;
+      TF_RETURN_IF_ERROR(
+          b->AddScalar(dataset_def_.split_tensor(), &split_tensor));
+      Node* num_splits = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(num_splits_, &num_splits));
+      AttrValue max_outstanding_requests;
+      b->BuildAttrValue(max_outstanding_requests_, &max_outstanding_requests);
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this,
+          {dispatcher_address, job_name, graph_def, dataset_tensor,
+           split_tensor, num_splits},
+          {{"max_outstanding_requests", max_outstanding_requests}}, output));
+      return Status::OK();
+    }
+
+   private:
+    // Creates the job of the dataset on the dispatcher, and fetches its
+    // elements from all workers registered with the dispatcher. Background
+    // threads keep up to `max_outstanding_requests` elements requested or
+    // buffered, requesting them from the workers round robin. The elements
+    // are returned in the order they arrive.
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {}
+
+      ~Iterator() override {
+        {
+          mutex_lock l(mu_);
+          cancelled_ = true;
+          cond_var_.notify_all();
+        }
+        // Joins the fetch threads, each after its outstanding request.
+        fetch_threads_.clear();
+      }
+
+      Status Initialize(IteratorContext* ctx) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(NewGrpcDataDispatcherClient(
+            dataset()->dispatcher_address_, &dispatcher_));
+        CreateJobRequest job_request;
+        *job_request.mutable_dataset() = dataset()->dataset_def_;
+        job_request.set_num_splits(dataset()->num_splits_);
+        job_request.set_job_name(dataset()->job_name_);
+        CreateJobResponse job_response;
+        TF_RETURN_IF_ERROR(dispatcher_->CreateJob(&job_request, &job_response));
+        job_id_ = job_response.job_id();
+
+        GetWorkersRequest workers_request;
+        GetWorkersResponse workers_response;
+        TF_RETURN_IF_ERROR(
+            dispatcher_->GetWorkers(&workers_request, &workers_response));
+        if (workers_response.worker_addresses_size() == 0) {
+          return errors::Unavailable(
+              "No tf.data service workers are registered with the dispatcher "
+              "at ",
+              dataset()->dispatcher_address_);
+        }
+        for (const string& address : workers_response.worker_addresses()) {
+          std::unique_ptr<DataWorkerInterface> worker;
+          TF_RETURN_IF_ERROR(NewGrpcDataWorkerClient(address, &worker));
+          workers_.push_back(std::move(worker));
+        }
+        worker_finished_.resize(workers_.size(), false);
+        return Status::OK();
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        EnsureFetchThreadsStarted(ctx);
+        while (results_.empty() && status_.ok() &&
+               num_finished_workers_ < workers_.size()) {
+          cond_var_.wait(l);
+        }
+        if (!results_.empty()) {
+          *out_tensors = std::move(results_.front());
+          results_.pop_front();
+          *end_of_sequence = false;
+          cond_var_.notify_all();
+          return Status::OK();
+        }
+        TF_RETURN_IF_ERROR(status_);
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+
+     protected:
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        return errors::Unimplemented(
+            "Checkpointing a tf.data service dataset is not supported.");
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        return errors::Unimplemented(
+            "Checkpointing a tf.data service dataset is not supported.");
+      }
+
+     private:
+      void EnsureFetchThreadsStarted(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!fetch_threads_.empty()) {
+          return;
+        }
+        for (int64 i = 0; i < dataset()->max_outstanding_requests_; ++i) {
+          fetch_threads_.emplace_back(ctx->env()->StartThread(
+              {}, "data_service_fetch_thread", [this]() { FetchThread(); }));
+        }
+      }
+
+      void FetchThread() {
+        while (true) {
+          size_t worker;
+          {
+            mutex_lock l(mu_);
+            while (!cancelled_ && status_.ok() &&
+                   num_finished_workers_ < workers_.size() &&
+                   results_.size() + outstanding_requests_ >=
+                       dataset()->max_outstanding_requests_) {
+              cond_var_.wait(l);
+            }
+            if (cancelled_ || !status_.ok() ||
+                num_finished_workers_ == workers_.size()) {
+              return;
+            }
+            do {
+              worker = next_worker_;
+              next_worker_ = (next_worker_ + 1) % workers_.size();
+            } while (worker_finished_[worker]);
+            ++outstanding_requests_;
+          }
+          std::vector<Tensor> element;
+          bool end_of_sequence = false;
+          Status s = workers_[worker]->GetElement(job_id_, &element,
+                                                  &end_of_sequence);
+          if (s.ok() && !end_of_sequence &&
+              element.size() != dataset()->output_types_.size()) {
+            s = errors::InvalidArgument(
+                "Expected elements of ", dataset()->output_types_.size(),
+                " components from the tf.data service, got ", element.size());
+          }
+          mutex_lock l(mu_);
+          --outstanding_requests_;
+          if (!s.ok()) {
+            status_.Update(s);
+          } else if (end_of_sequence) {
+            if (!worker_finished_[worker]) {
+              worker_finished_[worker] = true;
+              ++num_finished_workers_;
+            }
+          } else {
+            results_.push_back(std::move(element));
+          }
+          cond_var_.notify_all();
+        }
+      }
+
+      mutex mu_;
+      condition_variable cond_var_;
+      // Set in `Initialize()`, and only read afterwards.
+      std::unique_ptr<DataDispatcherInterface> dispatcher_;
+      int64 job_id_ = -1;
+      std::vector<std::unique_ptr<DataWorkerInterface>> workers_;
+
+      std::vector<bool> worker_finished_ GUARDED_BY(mu_);
+      size_t num_finished_workers_ GUARDED_BY(mu_) = 0;
+      size_t next_worker_ GUARDED_BY(mu_) = 0;
+      int64 outstanding_requests_ GUARDED_BY(mu_) = 0;
+      std::deque<std::vector<Tensor>> results_ GUARDED_BY(mu_);
+      Status status_ GUARDED_BY(mu_);
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      std::vector<std::unique_ptr<Thread>> fetch_threads_ GUARDED_BY(mu_);
+    };
+
+    const string dispatcher_address_;
+    const string job_name_;
+    // The serialized GraphDef in `dataset_def_`, for `AsGraphDefInternal()`.
+    const string graph_def_;
+    const DatasetDef dataset_def_;
+    const int64 num_splits_;
+    const int64 max_outstanding_requests_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+  int64 max_outstanding_requests_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("ExperimentalDataServiceDataset").Device(DEVICE_CPU),
+    DataServiceDatasetOp);
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,201 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/data/data_service.h"
+#include "tensorflow/core/distributed_runtime/rpc/data/grpc_data_client.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// See documentation in ../../../ops/experimental_dataset_ops.cc for a
+// high-level description of the following op.
+
+class DynamicShardDatasetOp : public DatasetOpKernel {
+ public:
+  using DatasetOpKernel::DatasetOpKernel;
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
+    string dispatcher_address;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "dispatcher_address",
+                                                    &dispatcher_address));
+    string job_name;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<string>(ctx, "job_name", &job_name));
+    OP_REQUIRES(ctx, !job_name.empty(),
+                errors::InvalidArgument("job_name must not be empty"));
+    int64 num_splits;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<int64>(ctx, "num_splits", &num_splits));
+    OP_REQUIRES(ctx, num_splits >= 1,
+                errors::InvalidArgument("num_splits must be at least 1, got ",
+                                        num_splits));
+    string worker_name;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<string>(ctx, "worker_name", &worker_name));
+    OP_REQUIRES(ctx, !worker_name.empty(),
+                errors::InvalidArgument("worker_name must not be empty"));
+    *output = new Dataset(ctx, dispatcher_address, job_name, num_splits,
+                          worker_name);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, const string& dispatcher_address,
+            const string& job_name, int64 num_splits,
+            const string& worker_name)
+        : DatasetBase(DatasetContext(ctx)),
+          dispatcher_address_(dispatcher_address),
+          job_name_(job_name),
+          num_splits_(num_splits),
+          worker_name_(worker_name) {}
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return std::unique_ptr<IteratorBase>(
+          new Iterator({this, strings::StrCat(prefix, "::DynamicShard")}));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      static DataTypeVector* dtypes = new DataTypeVector({DT_INT64});
+      return *dtypes;
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      static std::vector<PartialTensorShape>* shapes =
+          new std::vector<PartialTensorShape>({{}});
+      return *shapes;
+    }
+
+    string DebugString() const override {
+      return "DynamicShardDatasetOp::Dataset";
+    }
+
+   protected:
+    Status AsGraphDefInternal(SerializationContext* ctx,
+                              DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* dispatcher_address = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(dispatcher_address_,
+                                      &dispatcher_address));
+      Node* job_name = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(job_name_, &job_name));
+      Node* num_splits = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(num_splits_, &num_splits));
+      Node* worker_name = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(worker_name_, &worker_name));
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this, {dispatcher_address, job_name, num_splits, worker_name},
+          output));
+      return Status::OK();
+    }
+
+   private:
+    // Asks the dispatcher for a split of the job whenever the consumer asks
+    // for an element. The checkpointed state is the number of splits handed
+    // out, so that a restored iterator replays the splits handed out after
+    // the checkpoint instead of asking for new ones.
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {}
+
+      Status Initialize(IteratorContext* ctx) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(NewGrpcDataDispatcherClient(
+            dataset()->dispatcher_address_, &dispatcher_));
+        CreateJobRequest request;
+        request.set_num_splits(dataset()->num_splits_);
+        request.set_job_name(dataset()->job_name_);
+        CreateJobResponse response;
+        TF_RETURN_IF_ERROR(dispatcher_->CreateJob(&request, &response));
+        job_id_ = response.job_id();
+        return Status::OK();
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        if (end_of_splits_) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        GetSplitRequest request;
+        request.set_job_id(job_id_);
+        request.set_worker_address(dataset()->worker_name_);
+        request.set_split_position(num_splits_);
+        GetSplitResponse response;
+        TF_RETURN_IF_ERROR(dispatcher_->GetSplit(&request, &response));
+        if (response.end_of_splits()) {
+          end_of_splits_ = true;
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        ++num_splits_;
+        Tensor split(ctx->allocator({}), DT_INT64, {});
+        split.scalar<int64>()() = response.split_index();
+        out_tensors->push_back(std::move(split));
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+     protected:
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(full_name("num_splits"), num_splits_));
+        if (end_of_splits_) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name("end_of_splits"), ""));
+        }
+        return Status::OK();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(full_name("num_splits"), &num_splits_));
+        end_of_splits_ = reader->Contains(full_name("end_of_splits"));
+        return Status::OK();
+      }
+
+     private:
+      mutex mu_;
+      std::unique_ptr<DataDispatcherInterface> dispatcher_ GUARDED_BY(mu_);
+      int64 job_id_ GUARDED_BY(mu_) = -1;
+      // The number of splits handed out to this iterator.
+      int64 num_splits_ GUARDED_BY(mu_) = 0;
+      bool end_of_splits_ GUARDED_BY(mu_) = false;
+    };
+
+    const string dispatcher_address_;
+    const string job_name_;
+    const int64 num_splits_;
+    const string worker_name_;
+  };
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("ExperimentalDynamicShardDataset").Device(DEVICE_CPU),
+    DynamicShardDatasetOp);
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
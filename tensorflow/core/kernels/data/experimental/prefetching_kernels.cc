@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include <deque>
 
+#include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/function.h"
@@ -32,6 +33,9 @@ struct BufferElement {
   Status status;
   // The buffered data element.
   std::vector<Tensor> value;
+  // False while the element is being copied to the device, in which case
+  // it cannot be handed out yet.
+  bool ready = true;
 };
 
 using FunctionBufferCallback = std::function<void(const BufferElement&)>;
@@ -53,6 +57,9 @@ class FunctionBufferingResource : public ResourceBase {
         target_device_(target_device),
         func_args_(func_args),
         output_types_(output_types),
+        copy_to_device_(source_device != target_device &&
+                        lib->device()->tensorflow_gpu_device_info() !=
+                            nullptr),
         handle_(kInvalidHandle),
         is_buffering_(false),
         end_of_sequence_(false),
@@ -93,7 +100,7 @@ class FunctionBufferingResource : public ResourceBase {
   void Cancel() LOCKS_EXCLUDED(mu_) {
     mutex_lock l(mu_);
     cancelled_ = true;
-    while (is_buffering_) {
+    while (is_buffering_ || num_copies_in_flight_ > 0) {
       cond_var_.wait(l);
     }
   }
@@ -121,7 +128,7 @@ class FunctionBufferingResource : public ResourceBase {
       if (!is_buffering_ && !end_of_sequence_) {
         start_buffering = true;
       }
-      if (!buffer_.empty()) {
+      if (!buffer_.empty() && buffer_.front().ready) {
         produced_output = true;
         std::swap(buffer_element, buffer_.front());
         buffer_.pop_front();
@@ -139,6 +146,104 @@ class FunctionBufferingResource : public ResourceBase {
   }
 
  private:
+  // Returns true if output i of the function is returned in host memory and
+  // then copied to the device by CopyToDevice().
+  bool CopiesOutput(int i) const {
+    return copy_to_device_ && !DataTypeAlwaysOnHost(output_types_[i]);
+  }
+
+  // Copies the outputs of `element` selected by CopiesOutput() to the
+  // device on its host to device stream, and marks the element ready once
+  // the copies have completed. Consumers of the device tensors do not need
+  // to synchronize with the copies then.
+  //
+  // The function is called again as soon as the copies are enqueued, so the
+  // copy of one element overlaps with producing the next one. `element`
+  // must not be ready, so that nothing else accesses it until the copies
+  // are done.
+  void CopyToDevice(BufferElement* element) LOCKS_EXCLUDED(mu_) {
+    Device* device = lib_->device();
+    DeviceContext* device_context =
+        device->tensorflow_gpu_device_info()->default_context;
+    struct CopyState {
+      std::vector<Tensor> host_values;
+      mutex mu;
+      Status status GUARDED_BY(mu);
+      int pending GUARDED_BY(mu) = 1;
+    };
+    auto* state = new CopyState;
+    state->host_values.swap(element->value);
+    element->value.resize(state->host_values.size());
+    auto done = [this, element, state](const Status& status) {
+      {
+        mutex_lock l(state->mu);
+        state->status.Update(status);
+        if (--state->pending > 0) return;
+      }
+      OnCopyDone(element, state->status);
+      delete state;
+    };
+    for (size_t i = 0; i < state->host_values.size(); ++i) {
+      const Tensor& host_value = state->host_values[i];
+      if (!CopiesOutput(i)) {
+        element->value[i] = host_value;
+        continue;
+      }
+      if (!DMAHelper::CanUseDMA(&host_value)) {
+        done(errors::Internal("Cannot copy a tensor of type ",
+                              DataTypeString(host_value.dtype()),
+                              " to the device"));
+        return;
+      }
+      element->value[i] = Tensor(device->GetAllocator(AllocatorAttributes()),
+                                 host_value.dtype(), host_value.shape());
+      if (!element->value[i].IsInitialized()) {
+        done(errors::ResourceExhausted("OOM when allocating tensor of shape ",
+                                       host_value.shape().DebugString(),
+                                       " on ", device->name()));
+        return;
+      }
+      {
+        mutex_lock l(state->mu);
+        ++state->pending;
+      }
+      device_context->CopyCPUTensorToDevice(&host_value, device,
+                                            &element->value[i], done);
+    }
+    done(Status::OK());
+  }
+
+  // Marks `element` ready and hands out the ready elements at the front of
+  // the buffer to the pending requests.
+  void OnCopyDone(BufferElement* element, const Status& status)
+      LOCKS_EXCLUDED(mu_) {
+    std::vector<FunctionBufferCallback> callbacks;
+    std::vector<BufferElement> buffer_elements;
+    {
+      mutex_lock l(mu_);
+      if (!status.ok()) {
+        element->status = status;
+        element->value.clear();
+        end_of_sequence_ = true;
+      }
+      element->ready = true;
+      --num_copies_in_flight_;
+      while (!requests_.empty() && !buffer_.empty() &&
+             buffer_.front().ready) {
+        buffer_elements.push_back(std::move(buffer_.front()));
+        buffer_.pop_front();
+        callbacks.push_back(std::move(requests_.front()));
+        requests_.pop_front();
+      }
+      // Notify under the lock, since Cancel() may return and the resource
+      // be deleted as soon as the lock is released.
+      cond_var_.notify_all();
+    }
+    for (size_t i = 0; i < callbacks.size(); ++i) {
+      callbacks[i](buffer_elements[i]);
+    }
+  }
+
   void FillBuffer() LOCKS_EXCLUDED(mu_) {
     FunctionLibraryRuntime::Handle handle;
     std::vector<FunctionBufferCallback> cancellation_callbacks;
@@ -151,7 +256,11 @@ class FunctionBufferingResource : public ResourceBase {
         cancelled = true;
         // Run through and fulfill all pending requests, if possible.
         while (!requests_.empty()) {
-          if (!buffer_.empty()) {
+          if (!buffer_.empty() && !buffer_.front().ready) {
+            // The element is still being copied, and OnCopyDone() hands it
+            // out once it is ready.
+            break;
+          } else if (!buffer_.empty()) {
             cancellation_buffer_elements.push_back(std::move(buffer_.front()));
             buffer_.pop_front();
             cancellation_callbacks.push_back(std::move(requests_.front()));
@@ -185,6 +294,12 @@ class FunctionBufferingResource : public ResourceBase {
       AllocatorAttributes ret_alloc_attrs;
       if (DataTypeAlwaysOnHost(dtype)) {
         ret_alloc_attrs.set_on_host(true);
+      } else if (copy_to_device_) {
+        // Returned in host memory, and copied by CopyToDevice(). The copy is
+        // asynchronous when the producer allocated the tensor in pinned
+        // memory, e.g. with force_gpu_compatible.
+        ret_alloc_attrs.set_on_host(true);
+        ret_alloc_attrs.set_gpu_compatible(true);
       }
       opts.rets_alloc_attrs.push_back(ret_alloc_attrs);
     }
@@ -197,6 +312,7 @@ class FunctionBufferingResource : public ResourceBase {
               [this, rets](const Status& status) {
                 FunctionBufferCallback callback = nullptr;
                 BufferElement buffer_front;
+                BufferElement* to_copy = nullptr;
                 bool restart_buffering = false;
                 {
                   mutex_lock l(mu_);
@@ -209,7 +325,12 @@ class FunctionBufferingResource : public ResourceBase {
                     is_buffering_ = false;
                   }
                   buffer_.push_back(std::move(buffer_element));
-                  if (!requests_.empty()) {
+                  if (status.ok() && copy_to_device_) {
+                    to_copy = &buffer_.back();
+                    to_copy->ready = false;
+                    ++num_copies_in_flight_;
+                  }
+                  if (!requests_.empty() && buffer_.front().ready) {
                     buffer_front = std::move(buffer_.front());
                     buffer_.pop_front();
                     callback = std::move(requests_.front());
@@ -228,12 +349,16 @@ class FunctionBufferingResource : public ResourceBase {
                     is_buffering_ = false;
                   }
                 }
+                if (to_copy != nullptr) {
+                  CopyToDevice(to_copy);
+                }
                 if (callback != nullptr) {
                   callback(buffer_front);
                 }
                 if (restart_buffering) {
                   FillBuffer();
                 }
+                delete rets;
               });
   }
 
@@ -246,12 +371,16 @@ class FunctionBufferingResource : public ResourceBase {
   const string target_device_;
   const std::vector<Tensor> func_args_;
   const DataTypeVector output_types_;
+  // True if the function runs on another device than this GPU, in which
+  // case its outputs are copied here by CopyToDevice().
+  const bool copy_to_device_;
   FunctionLibraryRuntime::Handle handle_ GUARDED_BY(mu_);
   std::deque<BufferElement> buffer_ GUARDED_BY(mu_);
   std::deque<FunctionBufferCallback> requests_ GUARDED_BY(mu_);
   bool is_buffering_ GUARDED_BY(mu_);
   bool end_of_sequence_ GUARDED_BY(mu_);
   bool cancelled_ GUARDED_BY(mu_);
+  int64 num_copies_in_flight_ GUARDED_BY(mu_) = 0;
   condition_variable cond_var_;
 };
 
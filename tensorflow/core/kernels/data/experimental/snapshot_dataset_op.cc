@@ -0,0 +1,555 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <deque>
+
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/lib/io/compression.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// See documentation in ../../ops/experimental_dataset_ops.cc for a high-level
+// description of the following op.
+
+constexpr char kMetadataFilename[] = "snapshot.metadata";
+constexpr char kShardSuffix[] = ".snapshot";
+// The number of elements the writer thread may fall behind the consumer.
+constexpr size_t kMaxPendingElements = 64;
+// The buffer of the reader of each shard, whose next buffer is read ahead.
+constexpr int64 kReadBufferSize = 256 * 1024;
+
+class SnapshotDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit SnapshotDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("compression", &compression_));
+    OP_REQUIRES(ctx,
+                compression_ == io::compression::kNone ||
+                    compression_ == "ZLIB" ||
+                    compression_ == io::compression::kGzip,
+                errors::InvalidArgument("Unsupported compression type: ",
+                                        compression_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("num_shards", &num_shards_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("shuffle_shards", &shuffle_shards_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    string path;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "path", &path));
+    int64 seed;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "seed", &seed));
+    int64 seed2;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "seed2", &seed2));
+    // If both seeds are unspecified, use completely random seeds.
+    if (seed == 0 && seed2 == 0) {
+      seed = random::New64();
+      seed2 = random::New64();
+    }
+    uint64 fingerprint;
+    OP_REQUIRES_OK(ctx, Dataset::Fingerprint(ctx, input, &fingerprint));
+    *output = new Dataset(ctx, input, path, fingerprint, seed, seed2,
+                          compression_, num_shards_, shuffle_shards_);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, const DatasetBase* input, const string& path,
+            uint64 fingerprint, int64 seed, int64 seed2,
+            const string& compression, int64 num_shards, bool shuffle_shards)
+        : DatasetBase(DatasetContext(ctx)),
+          input_(input),
+          path_(path),
+          directory_(io::JoinPath(
+              path, strings::Printf("%016llx",
+                                    static_cast<unsigned long long>(
+                                        fingerprint)))),
+          seed_(seed),
+          seed2_(seed2),
+          compression_(compression),
+          num_shards_(num_shards),
+          shuffle_shards_(shuffle_shards),
+          env_(ctx->env()) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    // Returns the fingerprint of the graph that produces `dataset`, which
+    // names the snapshot directory of the dataset.
+    static Status Fingerprint(OpKernelContext* ctx, const DatasetBase* dataset,
+                              uint64* fingerprint) {
+      GraphDefBuilder b;
+      DatasetGraphDefBuilder db(&b);
+      Node* node = nullptr;
+      SerializationContext::Params params;
+      params.flib_def =
+          ctx->function_library()->GetFunctionLibraryDefinition();
+      SerializationContext serialization_ctx(params);
+      Status s = db.AddInputDataset(&serialization_ctx, dataset, &node);
+      if (!s.ok()) {
+        return errors::InvalidArgument(
+            "Snapshots require an input dataset that can be serialized: ", s);
+      }
+      GraphDef graph_def;
+      TF_RETURN_IF_ERROR(b.ToGraphDef(&graph_def));
+      string serialized;
+      if (!SerializeToStringDeterministic(graph_def, &serialized)) {
+        return errors::Internal(
+            "Failed to serialize the input dataset graph.");
+      }
+      *fingerprint = Fingerprint64(serialized);
+      return Status::OK();
+    }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      if (env_->FileExists(io::JoinPath(directory_, kMetadataFilename))
+              .ok()) {
+        return std::unique_ptr<IteratorBase>(new ReaderIterator(
+            {this, strings::StrCat(prefix, "::SnapshotReader")}));
+      }
+      return std::unique_ptr<IteratorBase>(new WriterIterator(
+          {this, strings::StrCat(prefix, "::SnapshotWriter")}));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() const override {
+      return "SnapshotDatasetOp::Dataset";
+    }
+
+   protected:
+    Status AsGraphDefInternal(SerializationContext* ctx,
+                              DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* input_graph_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+      Node* path = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(path_, &path));
+      Node* seed = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(seed_, &seed));
+      Node* seed2 = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(seed2_, &seed2));
+      AttrValue compression;
+      b->BuildAttrValue(compression_, &compression);
+      AttrValue num_shards;
+      b->BuildAttrValue(num_shards_, &num_shards);
+      AttrValue shuffle_shards;
+      b->BuildAttrValue(shuffle_shards_, &shuffle_shards);
+      TF_RETURN_IF_ERROR(b->AddDataset(this,
+                                       {input_graph_node, path, seed, seed2},
+                                       {{"compression", compression},
+                                        {"num_shards", num_shards},
+                                        {"shuffle_shards", shuffle_shards}},
+                                       output));
+      return Status::OK();
+    }
+
+   private:
+    // Passes through the elements of the input dataset, while a background
+    // thread writes them to a new set of shards. Element `i` goes to shard
+    // `i % num_shards`. Once the input is exhausted, the metadata file that
+    // lists the shards is written, which makes it visible to later readers.
+    //
+    // Several jobs may write the same snapshot at once, each into its own
+    // shards. The first to finish publishes its shards, and the others delete
+    // theirs.
+    class WriterIterator : public DatasetIterator<Dataset> {
+     public:
+      explicit WriterIterator(const Params& params)
+          : DatasetIterator<Dataset>(params),
+            run_id_(strings::Printf("%016llx", static_cast<unsigned long long>(
+                                                   random::New64()))) {}
+
+      ~WriterIterator() override {
+        {
+          mutex_lock l(writer_mu_);
+          cancelled_ = true;
+          writer_cond_var_.notify_all();
+        }
+        // Joins the writer thread.
+        writer_thread_.reset();
+        if (!published_) {
+          DeleteShards();
+        }
+      }
+
+      Status Initialize(IteratorContext* ctx) override {
+        return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(EnsureWriterStarted(ctx));
+        TF_RETURN_IF_ERROR(
+            input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
+        mutex_lock writer_lock(writer_mu_);
+        if (*end_of_sequence) {
+          input_done_ = true;
+          writer_cond_var_.notify_all();
+          while (!writer_done_) {
+            writer_cond_var_.wait(writer_lock);
+          }
+          return status_;
+        }
+        while (status_.ok() && pending_.size() >= kMaxPendingElements) {
+          writer_cond_var_.wait(writer_lock);
+        }
+        TF_RETURN_IF_ERROR(status_);
+        pending_.push_back(*out_tensors);
+        writer_cond_var_.notify_all();
+        return Status::OK();
+      }
+
+     protected:
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        return errors::Unimplemented(
+            "Checkpointing a snapshot dataset while its snapshot is being "
+            "written is not supported.");
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        return errors::Unimplemented(
+            "Checkpointing a snapshot dataset while its snapshot is being "
+            "written is not supported.");
+      }
+
+     private:
+      // Opens the shards and starts the writer thread on the first call.
+      Status EnsureWriterStarted(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (writer_thread_) {
+          return Status::OK();
+        }
+        Env* env = dataset()->env_;
+        Status s = env->RecursivelyCreateDir(dataset()->directory_);
+        if (!s.ok() && !errors::IsAlreadyExists(s)) {
+          return s;
+        }
+        const io::RecordWriterOptions options =
+            io::RecordWriterOptions::CreateRecordWriterOptions(
+                dataset()->compression_);
+        for (int64 i = 0; i < dataset()->num_shards_; ++i) {
+          shard_names_.push_back(strings::StrCat(
+              run_id_, "_",
+              strings::Printf("%05lld", static_cast<long long>(i)),
+              kShardSuffix));
+          std::unique_ptr<WritableFile> file;
+          TF_RETURN_IF_ERROR(env->NewWritableFile(
+              io::JoinPath(dataset()->directory_, shard_names_.back()),
+              &file));
+          writers_.emplace_back(new io::RecordWriter(file.get(), options));
+          files_.push_back(std::move(file));
+        }
+        writer_thread_.reset(env->StartThread(
+            {}, "snapshot_writer_thread", [this]() { WriterThread(); }));
+        return Status::OK();
+      }
+
+      void WriterThread() {
+        int64 num_elements = 0;
+        Status s;
+        while (s.ok()) {
+          std::vector<Tensor> element;
+          {
+            mutex_lock l(writer_mu_);
+            while (pending_.empty() && !input_done_ && !cancelled_) {
+              writer_cond_var_.wait(l);
+            }
+            if (cancelled_) {
+              return;
+            }
+            if (pending_.empty()) {
+              break;
+            }
+            element = std::move(pending_.front());
+            pending_.pop_front();
+            writer_cond_var_.notify_all();
+          }
+          s = WriteElement(num_elements++ % dataset()->num_shards_, element);
+        }
+        if (s.ok()) {
+          s = Publish();
+        }
+        mutex_lock l(writer_mu_);
+        status_.Update(s);
+        writer_done_ = true;
+        writer_cond_var_.notify_all();
+      }
+
+      Status WriteElement(int64 shard, const std::vector<Tensor>& element) {
+        for (const Tensor& t : element) {
+          TensorProto proto;
+          t.AsProtoTensorContent(&proto);
+          TF_RETURN_IF_ERROR(
+              writers_[shard]->WriteRecord(proto.SerializeAsString()));
+        }
+        return Status::OK();
+      }
+
+      // Closes the shards, and lists them in the metadata file unless another
+      // job published the snapshot first.
+      Status Publish() {
+        for (size_t i = 0; i < writers_.size(); ++i) {
+          TF_RETURN_IF_ERROR(writers_[i]->Close());
+          TF_RETURN_IF_ERROR(files_[i]->Close());
+        }
+        Env* env = dataset()->env_;
+        const string metadata =
+            io::JoinPath(dataset()->directory_, kMetadataFilename);
+        if (env->FileExists(metadata).ok()) {
+          return Status::OK();
+        }
+        // The first line is the compression type, and each of the others
+        // names a shard.
+        const string contents =
+            strings::StrCat(dataset()->compression_, "\n",
+                            str_util::Join(shard_names_, "\n"));
+        const string tmp_metadata =
+            strings::StrCat(metadata, ".", run_id_, ".tmp");
+        TF_RETURN_IF_ERROR(WriteStringToFile(env, tmp_metadata, contents));
+        TF_RETURN_IF_ERROR(env->RenameFile(tmp_metadata, metadata));
+        published_ = true;
+        return Status::OK();
+      }
+
+      void DeleteShards() {
+        writers_.clear();
+        files_.clear();
+        for (const string& shard : shard_names_) {
+          dataset()
+              ->env_->DeleteFile(io::JoinPath(dataset()->directory_, shard))
+              .IgnoreError();
+        }
+      }
+
+      const string run_id_;
+
+      mutex mu_;
+      std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      std::unique_ptr<Thread> writer_thread_ GUARDED_BY(mu_);
+
+      // Owned by the writer thread once it has started.
+      std::vector<string> shard_names_;
+      // `writers_` borrow the files in `files_`, and are destroyed first.
+      std::vector<std::unique_ptr<WritableFile>> files_;
+      std::vector<std::unique_ptr<io::RecordWriter>> writers_;
+      bool published_ = false;
+
+      mutex writer_mu_;
+      condition_variable writer_cond_var_;
+      std::deque<std::vector<Tensor>> pending_ GUARDED_BY(writer_mu_);
+      bool input_done_ GUARDED_BY(writer_mu_) = false;
+      bool cancelled_ GUARDED_BY(writer_mu_) = false;
+      bool writer_done_ GUARDED_BY(writer_mu_) = false;
+      Status status_ GUARDED_BY(writer_mu_);
+    };
+
+    // Reads the elements of a published snapshot, in the order they were
+    // written unless the shards are shuffled. The shards are read round robin,
+    // each with a buffered reader that reads its next buffer ahead.
+    class ReaderIterator : public DatasetIterator<Dataset> {
+     public:
+      explicit ReaderIterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {}
+
+      Status Initialize(IteratorContext* ctx) override {
+        mutex_lock l(mu_);
+        Env* env = dataset()->env_;
+        string contents;
+        TF_RETURN_IF_ERROR(ReadFileToString(
+            env, io::JoinPath(dataset()->directory_, kMetadataFilename),
+            &contents));
+        std::vector<string> lines = str_util::Split(contents, '\n');
+        if (lines.empty()) {
+          return errors::DataLoss("Empty snapshot metadata in ",
+                                  dataset()->directory_);
+        }
+        io::RecordReaderOptions options =
+            io::RecordReaderOptions::CreateRecordReaderOptions(lines[0]);
+        options.buffer_size = kReadBufferSize;
+        std::vector<string> shards(lines.begin() + 1, lines.end());
+        if (dataset()->shuffle_shards_) {
+          random::PhiloxRandom parent_generator(dataset()->seed_,
+                                                dataset()->seed2_);
+          random::SingleSampleAdapter<random::PhiloxRandom> generator(
+              &parent_generator);
+          for (size_t i = shards.size(); i > 1; --i) {
+            std::swap(shards[i - 1], shards[generator() % i]);
+          }
+        }
+        for (const string& shard : shards) {
+          std::unique_ptr<RandomAccessFile> file;
+          TF_RETURN_IF_ERROR(env->NewRandomAccessFile(
+              io::JoinPath(dataset()->directory_, shard), &file));
+          readers_.emplace_back(
+              new io::SequentialRecordReader(file.get(), options));
+          files_.push_back(std::move(file));
+        }
+        exhausted_.assign(readers_.size(), false);
+        return Status::OK();
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        for (size_t i = 0; i < readers_.size(); ++i) {
+          const size_t shard = next_shard_;
+          next_shard_ = (next_shard_ + 1) % readers_.size();
+          if (exhausted_[shard]) {
+            continue;
+          }
+          Status s = ReadElement(ctx, shard, out_tensors);
+          if (errors::IsOutOfRange(s)) {
+            exhausted_[shard] = true;
+            continue;
+          }
+          TF_RETURN_IF_ERROR(s);
+          *end_of_sequence = false;
+          return Status::OK();
+        }
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+
+     protected:
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            full_name("next_shard"), static_cast<int64>(next_shard_)));
+        for (size_t i = 0; i < readers_.size(); ++i) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              full_name(strings::StrCat("offset_", i)),
+              static_cast<int64>(readers_[i]->TellOffset())));
+          if (exhausted_[i]) {
+            TF_RETURN_IF_ERROR(writer->WriteScalar(
+                full_name(strings::StrCat("exhausted_", i)), ""));
+          }
+        }
+        return Status::OK();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        int64 next_shard;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(full_name("next_shard"), &next_shard));
+        if (next_shard < 0 ||
+            (next_shard > 0 && static_cast<size_t>(next_shard) >=
+                                   readers_.size())) {
+          return errors::Internal("Invalid value for next_shard ",
+                                  next_shard);
+        }
+        next_shard_ = next_shard;
+        for (size_t i = 0; i < readers_.size(); ++i) {
+          int64 offset;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              full_name(strings::StrCat("offset_", i)), &offset));
+          TF_RETURN_IF_ERROR(readers_[i]->SeekOffset(offset));
+          exhausted_[i] =
+              reader->Contains(full_name(strings::StrCat("exhausted_", i)));
+        }
+        return Status::OK();
+      }
+
+     private:
+      Status ReadElement(IteratorContext* ctx, size_t shard,
+                         std::vector<Tensor>* out_tensors)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const DataTypeVector& dtypes = dataset()->output_dtypes();
+        out_tensors->clear();
+        out_tensors->reserve(dtypes.size());
+        string record;
+        for (size_t i = 0; i < dtypes.size(); ++i) {
+          Status s = readers_[shard]->ReadRecord(&record);
+          if (i > 0 && errors::IsOutOfRange(s)) {
+            return errors::DataLoss("Truncated element in snapshot shard ",
+                                    shard, " of ", dataset()->directory_);
+          }
+          TF_RETURN_IF_ERROR(s);
+          TensorProto proto;
+          Tensor t;
+          if (!proto.ParseFromString(record) ||
+              !t.FromProto(ctx->allocator({}), proto) ||
+              t.dtype() != dtypes[i]) {
+            return errors::DataLoss("Corrupt element in snapshot shard ",
+                                    shard, " of ", dataset()->directory_);
+          }
+          out_tensors->push_back(std::move(t));
+        }
+        return Status::OK();
+      }
+
+      mutex mu_;
+      // `readers_` borrow the files in `files_`, and are destroyed first.
+      std::vector<std::unique_ptr<RandomAccessFile>> files_ GUARDED_BY(mu_);
+      std::vector<std::unique_ptr<io::SequentialRecordReader>> readers_
+          GUARDED_BY(mu_);
+      std::vector<bool> exhausted_ GUARDED_BY(mu_);
+      size_t next_shard_ GUARDED_BY(mu_) = 0;
+    };
+
+    const DatasetBase* const input_;
+    const string path_;
+    // The directory of the snapshot of `input_`, named after its fingerprint.
+    const string directory_;
+    const int64 seed_;
+    const int64 seed2_;
+    const string compression_;
+    const int64 num_shards_;
+    const bool shuffle_shards_;
+    Env* const env_;
+  };
+
+  string compression_;
+  int64 num_shards_;
+  bool shuffle_shards_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("ExperimentalSnapshotDataset").Device(DEVICE_CPU),
+                        SnapshotDatasetOp);
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
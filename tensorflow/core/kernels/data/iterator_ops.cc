@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/common_runtime/threadpool_device.h"
 #include "tensorflow/core/framework/iterator.pb.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_op_kernel.h"
 #include "tensorflow/core/framework/stats_aggregator.h"
@@ -989,7 +990,10 @@ void IteratorGetNextOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
         };
         IteratorContext iter_ctx(std::move(params));
 
+        const uint64 start_time_usecs = ctx->env()->NowMicros();
         Status s = iterator->GetNext(&iter_ctx, &components, &end_of_sequence);
+        metrics::UpdateTfDataElementLatency(ctx->env()->NowMicros() -
+                                            start_time_usecs);
         // NOTE(mrry): We must unref the iterator before calling `done()`, to
         // avoid destruction races.
         iterator->Unref();
@@ -1027,8 +1031,11 @@ void IteratorGetNextSyncOp::Compute(OpKernelContext* ctx) {
   };
   IteratorContext iter_ctx(std::move(params));
 
-  OP_REQUIRES_OK(ctx,
-                 iterator->GetNext(&iter_ctx, &components, &end_of_sequence));
+  const uint64 start_time_usecs = ctx->env()->NowMicros();
+  Status s = iterator->GetNext(&iter_ctx, &components, &end_of_sequence);
+  metrics::UpdateTfDataElementLatency(ctx->env()->NowMicros() -
+                                      start_time_usecs);
+  OP_REQUIRES_OK(ctx, s);
   OP_REQUIRES(ctx, !end_of_sequence, errors::OutOfRange("End of sequence"));
 
   for (int i = 0; i < components.size(); ++i) {
@@ -16,8 +16,10 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/mem.h"
 
 namespace tensorflow {
 namespace data {
@@ -86,6 +88,12 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
       }
 
       Status Initialize(IteratorContext* ctx) override {
+        // The input pipeline runs its functions on a pool of its own, rather
+        // than on the inter-op pool of the computation that consumes it. How
+        // many CPUs it uses is bounded by the CPU budget of the model.
+        thread_pool_.reset(new thread::ThreadPool(
+            ctx->env(), ThreadOptions(), "data_model",
+            port::NumSchedulableCPUs(), /*low_latency_hint=*/false));
         IteratorContext ctx_with_model(CreateParams(ctx));
         return dataset()->input_->MakeIterator(&ctx_with_model, prefix(),
                                                &input_impl_);
@@ -97,8 +105,11 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
         mutex_lock l(mu_);
         TF_RETURN_IF_ERROR(EnsureOptimizeThreadStarted(ctx));
         IteratorContext ctx_with_model(CreateParams(ctx));
-        return input_impl_->GetNext(&ctx_with_model, out_tensors,
-                                    end_of_sequence);
+        const uint64 start_us = ctx->env()->NowMicros();
+        Status s = input_impl_->GetNext(&ctx_with_model, out_tensors,
+                                        end_of_sequence);
+        stall_time_us_ += ctx->env()->NowMicros() - start_us;
+        return s;
       }
 
      protected:
@@ -118,6 +129,10 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
       IteratorContext::Params CreateParams(IteratorContext* ctx) {
         IteratorContext::Params params = ctx->params();
         params.model = model_;
+        thread::ThreadPool* pool = thread_pool_.get();
+        params.runner = [pool](std::function<void()> c) {
+          pool->Schedule(std::move(c));
+        };
         return params;
       }
 
@@ -134,6 +149,15 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
       }
 
       void OptimizeThread(const std::shared_ptr<IteratorContext>& ctx) {
+        // The buffers of the input pipeline may use up to half of the memory
+        // that is available when the input pipeline starts producing elements.
+        const int64 ram_budget = port::AvailableRam() / 2;
+        // The CPUs are split between the input pipeline and the computation
+        // by how long the computation waits for elements.
+        const int64 num_cpus = port::NumSchedulableCPUs();
+        int64 cpu_budget = num_cpus;
+        uint64 last_time_us = ctx->env()->NowMicros();
+        uint64 last_stall_time_us = 0;
         int64 last_optimization_ms = 0;
         int64 optimization_period_ms = 10;
         while (true) {
@@ -149,7 +173,20 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
             }
             if (cancelled_) return;
           }
-          model_->Optimize(port::NumSchedulableCPUs());
+          const uint64 now_us = ctx->env()->NowMicros();
+          const uint64 stall_time_us = stall_time_us_;
+          if (now_us > last_time_us) {
+            const double stall_fraction =
+                static_cast<double>(stall_time_us - last_stall_time_us) /
+                (now_us - last_time_us);
+            cpu_budget =
+                model::AdjustCpuBudget(cpu_budget, stall_fraction, num_cpus);
+            VLOG(2) << "Input pipeline stalled " << stall_fraction
+                    << " of the time, using a CPU budget of " << cpu_budget;
+          }
+          last_time_us = now_us;
+          last_stall_time_us = stall_time_us;
+          model_->Optimize(cpu_budget, ram_budget);
           // Exponentially increase the period of running the optimization
           // until a threshold is reached.
           if (optimization_period_ms < kOptimizationPeriodThresholdMs) {
@@ -169,6 +206,10 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
       std::shared_ptr<model::Model> model_;
       std::unique_ptr<Thread> optimize_thread_ GUARDED_BY(mu_);
       bool cancelled_ GUARDED_BY(mu_) = false;
+      // The total time spent in GetNext() of the input. Declared before
+      // input_impl_ like thread_pool_, which must outlive it.
+      std::atomic<uint64> stall_time_us_{0};
+      std::unique_ptr<thread::ThreadPool> thread_pool_;
       std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
     };
 
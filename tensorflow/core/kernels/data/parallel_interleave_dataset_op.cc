@@ -1233,6 +1233,8 @@ class ParallelInterleaveDatasetV2Op : public UnaryDatasetOpKernel {
             cond_var_(std::make_shared<condition_variable>()),
             num_parallel_calls_(std::make_shared<model::SharedState>(
                 params.dataset->num_parallel_calls_, mu_, cond_var_)),
+            buffered_blocks_(std::make_shared<model::SharedState>(
+                params.dataset->cycle_length_, mu_, cond_var_)),
             args_list_(params.dataset->cycle_length_),
             current_elements_(params.dataset->cycle_length_),
             element_in_use_(params.dataset->cycle_length_, false),
@@ -1258,10 +1260,19 @@ class ParallelInterleaveDatasetV2Op : public UnaryDatasetOpKernel {
           num_parallel_calls_->value = 1;
           AddTunableParameter(ctx, "parallelism", num_parallel_calls_, 1,
                               dataset()->cycle_length_);
+          // When autotuning, the number of blocks of results that can be
+          // buffered is tuned alongside the parallelism, trading memory for
+          // throughput.
+          buffered_blocks_->value = 1;
+          AddTunableParameter(ctx, "buffered_blocks", buffered_blocks_, 1,
+                              dataset()->cycle_length_);
         } else {
           AddConstantParameter(ctx, "parallelism", num_parallel_calls_->value);
+          AddConstantParameter(ctx, "buffered_blocks",
+                               buffered_blocks_->value);
         }
         AddConstantParameter(ctx, "cycle_length", dataset()->cycle_length_);
+        AddConstantParameter(ctx, "block_length", dataset()->block_length_);
         TF_RETURN_IF_ERROR(
             dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_));
         return dataset()->captured_func_->Instantiate(ctx);
@@ -1464,7 +1475,7 @@ class ParallelInterleaveDatasetV2Op : public UnaryDatasetOpKernel {
           return element_in_use_[cycle_index_] ||
                  num_calls_ >= num_parallel_calls_->value ||
                  invocation_results_.size() >=
-                     dataset()->cycle_length_ * dataset()->block_length_;
+                     buffered_blocks_->value * dataset()->block_length_;
         };
         while (true) {
           mutex_lock l(*mu_);
@@ -1631,6 +1642,10 @@ class ParallelInterleaveDatasetV2Op : public UnaryDatasetOpKernel {
       // Identifies the maximum number of parallel calls.
       const std::shared_ptr<model::SharedState> num_parallel_calls_;
 
+      // Identifies the maximum number of blocks of `block_length` invocation
+      // results that can be buffered.
+      const std::shared_ptr<model::SharedState> buffered_blocks_;
+
       // Iterator for input elements.
       std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(*mu_);
 
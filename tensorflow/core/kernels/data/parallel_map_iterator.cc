@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/parallel_map_iterator.h"
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
 #include <functional>
@@ -29,6 +30,12 @@ namespace tensorflow {
 namespace data {
 namespace {
 
+// Once the runner thread waits because the buffer of results is full, it is
+// only woken when a `1 / kRunnerWakeupDivisor` fraction of the buffer is free,
+// so that it schedules a batch of calls per wakeup instead of one call for each
+// result consumed.
+constexpr int64 kRunnerWakeupDivisor = 8;
+
 class ParallelMapIteratorBase : public DatasetBaseIterator {
  public:
   ParallelMapIteratorBase(
@@ -52,7 +59,7 @@ class ParallelMapIteratorBase : public DatasetBaseIterator {
     cond_var_->notify_all();
     // Wait for all in-flight calls to complete.
     while (num_calls_ > 0) {
-      cond_var_->wait(l);
+      WaitForResult(&l);
     }
   }
 
@@ -83,7 +90,7 @@ class ParallelMapIteratorBase : public DatasetBaseIterator {
       EnsureRunnerThreadStarted(ctx);
       while (ShouldWait(&result)) {
         RecordStop(ctx);
-        cond_var_->wait(l);
+        WaitForResult(&l);
         RecordStart(ctx);
       }
     }
@@ -105,11 +112,35 @@ class ParallelMapIteratorBase : public DatasetBaseIterator {
   // false, `result` will point to a result to consume.
   virtual bool ShouldWait(std::shared_ptr<InvocationResult>* result) = 0;
 
+  // Waits for a new or completed invocation result.
+  void WaitForResult(mutex_lock* l) EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+    ++num_waiting_consumers_;
+    consumer_cond_var_.wait(*l);
+    --num_waiting_consumers_;
+  }
+
+  // Called after an invocation result has been consumed, or a call has
+  // completed. Wakes the runner thread if it waits for space in a full buffer
+  // and there is room for a batch of calls.
+  void MaybeWakeRunner() EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+    if (!runner_waiting_) {
+      return;
+    }
+    const int64 num_parallel_calls = num_parallel_calls_->value;
+    const int64 batch =
+        std::max<int64>(1, num_parallel_calls / kRunnerWakeupDivisor);
+    if (num_calls_ + batch <= num_parallel_calls &&
+        static_cast<int64>(invocation_results_.size()) + batch <=
+            num_parallel_calls) {
+      cond_var_->notify_all();
+    }
+  }
+
   Status SaveInternal(IteratorStateWriter* writer) override {
     mutex_lock l(*mu_);
     // Wait for all in-flight calls to complete.
     while (num_calls_ > 0) {
-      cond_var_->wait(l);
+      WaitForResult(&l);
     }
     CHECK_EQ(num_calls_, 0);
     TF_RETURN_IF_ERROR(SaveInput(writer, input_impl_));
@@ -191,7 +222,10 @@ class ParallelMapIteratorBase : public DatasetBaseIterator {
     mutex_lock l(*mu_);
     num_calls_--;
     result->notification.Notify();
-    cond_var_->notify_all();
+    if (num_waiting_consumers_ > 0) {
+      consumer_cond_var_.notify_all();
+    }
+    MaybeWakeRunner();
   }
 
   void CallFunction(const std::shared_ptr<IteratorContext>& ctx,
@@ -250,7 +284,9 @@ class ParallelMapIteratorBase : public DatasetBaseIterator {
         mutex_lock l(*mu_);
         while (!cancelled_ && busy()) {
           RecordStop(ctx.get());
+          runner_waiting_ = true;
           cond_var_->wait(l);
+          runner_waiting_ = false;
           RecordStart(ctx.get());
         }
         if (cancelled_) {
@@ -261,7 +297,9 @@ class ParallelMapIteratorBase : public DatasetBaseIterator {
           new_calls.push_back(invocation_results_.back());
           num_calls_++;
         }
-        cond_var_->notify_all();
+        if (num_waiting_consumers_ > 0) {
+          consumer_cond_var_.notify_all();
+        }
       }
       for (const auto& call : new_calls) {
         CallFunction(ctx, call);
@@ -320,6 +358,11 @@ class ParallelMapIteratorBase : public DatasetBaseIterator {
   // parallelism and there are slots available in the `invocation_results_`
   // buffer.
   const std::shared_ptr<condition_variable> cond_var_;
+  // Wakes the consumers waiting for a new or completed invocation result, and
+  // threads waiting for the in-flight calls to complete.
+  condition_variable consumer_cond_var_;
+  int64 num_waiting_consumers_ GUARDED_BY(*mu_) = 0;
+  bool runner_waiting_ GUARDED_BY(*mu_) = false;
   // Identifies the maximum number of parallel calls.
   const std::shared_ptr<model::SharedState> num_parallel_calls_;
   // Counts the number of outstanding calls.
@@ -348,7 +391,7 @@ class DeterministicParallelMapIterator : public ParallelMapIteratorBase {
     if (!invocation_results_.empty()) {
       std::swap(*result, invocation_results_.front());
       invocation_results_.pop_front();
-      cond_var_->notify_all();
+      MaybeWakeRunner();
       return false;
     }
     return true;
@@ -374,7 +417,7 @@ class SloppyParallelMapIterator : public ParallelMapIteratorBase {
           (it == invocation_results_.begin() || !(*it)->end_of_input)) {
         std::swap(*result, *it);
         invocation_results_.erase(it);
-        cond_var_->notify_all();
+        MaybeWakeRunner();
         return false;
       }
     }
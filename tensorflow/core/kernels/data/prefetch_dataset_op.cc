@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/prefetch_dataset_op.h"
 
+#include <algorithm>
 #include <deque>
 
 #include "tensorflow/core/framework/partial_tensor_shape.h"
@@ -25,6 +26,18 @@ limitations under the License.
 
 namespace tensorflow {
 namespace data {
+namespace {
+
+// The largest buffer size the performance model may choose when autotuning.
+constexpr int64 kMaxAutotuneBufferSize = 256;
+
+// Once the prefetch thread waits for space in a full buffer, it is only woken
+// when a `1 / kProducerWakeupDivisor` fraction of the buffer is free, so that
+// it produces a batch of elements per wakeup instead of one element for each
+// element consumed.
+constexpr int64 kProducerWakeupDivisor = 8;
+
+}  // namespace
 
 // See documentation in ../../ops/dataset_ops.cc for a high-level
 // description of the following op.
@@ -74,6 +87,8 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
    public:
     explicit Iterator(const Params& params)
         : DatasetIterator<Dataset>(params),
+          mu_(std::make_shared<mutex>()),
+          cond_var_(std::make_shared<condition_variable>()),
           auto_tuner_(params.dataset->buffer_size_) {
       std::vector<string> components =
           str_util::Split(params.prefix, "::", str_util::SkipEmpty());
@@ -90,13 +105,35 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       // through the IteratorContext to upstream,
       // potentially-blocking iterators, when we add these.
       {
-        mutex_lock l(mu_);
+        mutex_lock l(*mu_);
         cancelled_ = true;
-        cond_var_.notify_all();
+        cond_var_->notify_all();
+        consumer_cond_var_.notify_all();
       }
+      // Join the prefetch thread before releasing the buffered bytes, as it
+      // may still add an element to the buffer.
+      prefetch_thread_.reset();
+      BufferBudget::Global()->Remove(buffered_bytes_);
+    }
+
+    int64 BufferedBytes() override {
+      mutex_lock l(*mu_);
+      return buffered_bytes_;
     }
 
     Status Initialize(IteratorContext* ctx) override {
+      if (dataset()->buffer_size_ == PrefetchAutotuner::kAutoTune) {
+        if (ctx->model()) {
+          // Let the performance model choose the buffer size, so that it can
+          // account for the memory used by the buffer.
+          buffer_limit_ =
+              std::make_shared<model::SharedState>(1, mu_, cond_var_);
+          AddTunableParameter(ctx, "buffer_size", buffer_limit_, 1,
+                              kMaxAutotuneBufferSize);
+        }
+      } else {
+        AddConstantParameter(ctx, "buffer_size", dataset()->buffer_size_);
+      }
       return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
     }
 
@@ -105,15 +142,17 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
                            bool* end_of_sequence) override {
       auto stats_aggregator = ctx->stats_aggregator();
       {
-        mutex_lock l(mu_);
+        mutex_lock l(*mu_);
         TF_RETURN_IF_ERROR(EnsurePrefetchThreadStarted(ctx));
         // Wait until the next element in the buffer has been
         // produced, or we are shutting down.
         while (!cancelled_ && buffer_.empty() && !prefetch_thread_finished_ &&
-               auto_tuner_.buffer_limit() != 0) {
+               buffer_limit() != 0) {
           auto_tuner_.RecordEmpty();
           RecordStop(ctx);
-          cond_var_.wait(l);
+          ++num_waiting_consumers_;
+          consumer_cond_var_.wait(l);
+          --num_waiting_consumers_;
           RecordStart(ctx);
         }
 
@@ -123,7 +162,7 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
         }
 
         if (!buffer_.empty()) {
-          return Consume(out_tensors, end_of_sequence, stats_aggregator);
+          return Consume(ctx, out_tensors, end_of_sequence);
         }
 
         if (prefetch_thread_finished_) {
@@ -131,18 +170,18 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
           return Status::OK();
         }
 
-        DCHECK_EQ(auto_tuner_.buffer_limit(), 0);
+        DCHECK_EQ(buffer_limit(), 0);
       }
 
       mutex_lock parent_l(parent_mu_);
-      mutex_lock l(mu_);
+      mutex_lock l(*mu_);
       if (stats_aggregator) {
         stats_aggregator->AddScalar(
             strings::StrCat(prefix_end_, "::buffer_size"),
             static_cast<float>(buffer_.size()));
         stats_aggregator->AddScalar(
             strings::StrCat(prefix_end_, "::buffer_capacity"),
-            static_cast<float>(auto_tuner_.buffer_limit()));
+            static_cast<float>(buffer_limit()));
       }
       return input_impl_->GetNext(ctx, out_tensors, end_of_sequence);
     }
@@ -152,7 +191,7 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       // Acquire both locks to ensure that the prefetch thread and
       // all GetNext threads are blocked.
       mutex_lock parent_l(parent_mu_);
-      mutex_lock l(mu_);
+      mutex_lock l(*mu_);
       TF_RETURN_IF_ERROR(SaveInput(writer, input_impl_));
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(full_name("buffer_size"), buffer_.size()));
@@ -176,8 +215,10 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     Status RestoreInternal(IteratorContext* ctx,
                            IteratorStateReader* reader) override {
       mutex_lock parent_l(parent_mu_);
-      mutex_lock l(mu_);
+      mutex_lock l(*mu_);
       buffer_.clear();
+      BufferBudget::Global()->Remove(buffered_bytes_);
+      buffered_bytes_ = 0;
       TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
       size_t buffer_size;
       {
@@ -204,6 +245,9 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
                 full_name(strings::StrCat("buffer[", i, "][", j, "]")),
                 &buffer_element.value.back()));
           }
+          int64 num_bytes = GetTotalBytes(buffer_element.value);
+          buffered_bytes_ += num_bytes;
+          BufferBudget::Global()->Add(num_bytes);
         }
       }
       return Status::OK();
@@ -219,42 +263,51 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       std::vector<Tensor> value;
     };
 
-    Status Consume(std::vector<Tensor>* out_tensors, bool* end_of_sequence,
-                   const std::shared_ptr<StatsAggregator>& stats_aggregator)
-        EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    Status Consume(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                   bool* end_of_sequence) EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      auto stats_aggregator = ctx->stats_aggregator();
       if (stats_aggregator) {
         stats_aggregator->AddToHistogram(
             strings::StrCat(prefix_end_, "::buffer_utilization"),
             {static_cast<float>(buffer_.size()) /
-             static_cast<float>(auto_tuner_.buffer_limit())});
+             static_cast<float>(buffer_limit())});
         stats_aggregator->AddScalar(
             strings::StrCat(prefix_end_, "::buffer_size"),
             static_cast<float>(buffer_.size()));
         stats_aggregator->AddScalar(
             strings::StrCat(prefix_end_, "::buffer_capacity"),
-            static_cast<float>(auto_tuner_.buffer_limit()));
+            static_cast<float>(buffer_limit()));
       }
       // A new element is available. Forward the status from computing it, and
       // (if we successfully got an element) the output values.
       Status s = buffer_.front().status;
       if (s.ok()) {
+        int64 num_bytes = GetTotalBytes(buffer_.front().value);
+        buffered_bytes_ -= num_bytes;
+        BufferBudget::Global()->Remove(num_bytes);
         *out_tensors = std::move(buffer_.front().value);
       }
       auto_tuner_.RecordConsumption(buffer_.size());
       buffer_.pop_front();
       *end_of_sequence = false;
-
-      // Wake the prefetch thread, in case it has been waiting for space
-      // in the buffer. Also wake up threads from other calls to GetNext.
-      //
-      // TODO(mrry): Consider using different condition variables for
-      // GetNext and Prefetch.
-      cond_var_.notify_all();
+      RecordBufferedBytes(ctx, buffered_bytes_);
+
+      // Wake the prefetch thread if it has been waiting for space in the
+      // buffer, and enough space is now free for a batch of elements, or the
+      // buffer is drained while the buffers of the process exceed their budget.
+      if (producer_waiting_) {
+        const int64 limit = buffer_limit();
+        const int64 batch = std::max<int64>(1, limit / kProducerWakeupDivisor);
+        if (buffer_.empty() ||
+            static_cast<int64>(buffer_.size()) + batch <= limit) {
+          cond_var_->notify_all();
+        }
+      }
       return s;
     }
 
     Status EnsurePrefetchThreadStarted(IteratorContext* ctx)
-        EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
       if (!prefetch_thread_) {
         std::shared_ptr<IteratorContext> new_ctx(new IteratorContext(*ctx));
         prefetch_thread_.reset(ctx->env()->StartThread(
@@ -274,12 +327,17 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       while (true) {
         std::vector<Tensor> value;
 
-        // 1. Wait for a slot in the buffer.
+        // 1. Wait for a slot in the buffer. While the buffers of the process
+        // exceed their budget, also wait for the consumer to drain this buffer.
         {
-          mutex_lock l(mu_);
-          while (!cancelled_ && buffer_.size() >= auto_tuner_.buffer_limit()) {
+          mutex_lock l(*mu_);
+          while (!cancelled_ &&
+                 (buffer_.size() >= buffer_limit() ||
+                  (!buffer_.empty() && BufferBudget::Global()->Exceeded()))) {
             RecordStop(ctx.get());
-            cond_var_.wait(l);
+            producer_waiting_ = true;
+            cond_var_->wait(l);
+            producer_waiting_ = false;
             RecordStart(ctx.get());
           }
 
@@ -300,23 +358,30 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
         buffer_element.status = input_impl_->GetNext(
             ctx.get(), &buffer_element.value, &end_of_sequence);
         if (buffer_element.status.ok() && end_of_sequence) {
-          mutex_lock l(mu_);
+          mutex_lock l(*mu_);
           prefetch_thread_finished_ = true;
-          cond_var_.notify_all();
+          consumer_cond_var_.notify_all();
           return;
         }
 
         // 3. Signal that the element has been produced.
         {
-          mutex_lock l(mu_);
+          mutex_lock l(*mu_);
+          if (buffer_element.status.ok()) {
+            int64 num_bytes = GetTotalBytes(buffer_element.value);
+            buffered_bytes_ += num_bytes;
+            BufferBudget::Global()->Add(num_bytes);
+          }
           buffer_.push_back(std::move(buffer_element));
-          cond_var_.notify_all();
+          if (num_waiting_consumers_ > 0) {
+            consumer_cond_var_.notify_all();
+          }
         }
       }
     }
 
     Status WriteStatus(IteratorStateWriter* writer, size_t index,
-                       const Status& status) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+                       const Status& status) EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
       TF_RETURN_IF_ERROR(writer->WriteScalar(
           CodeKey(index), static_cast<int64>(status.code())));
       if (!status.ok()) {
@@ -327,7 +392,7 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     }
 
     Status ReadStatus(IteratorStateReader* reader, size_t index, Status* status)
-        EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
       int64 code_int;
       TF_RETURN_IF_ERROR(reader->ReadScalar(CodeKey(index), &code_int));
       error::Code code = static_cast<error::Code>(code_int);
@@ -343,6 +408,15 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       return Status::OK();
     }
 
+    // Returns the maximum number of buffered elements, which is chosen by the
+    // performance model if it tunes the buffer size.
+    int64 buffer_limit() EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      if (buffer_limit_) {
+        return buffer_limit_->value;
+      }
+      return auto_tuner_.buffer_limit();
+    }
+
     string CodeKey(size_t index) {
       return full_name(strings::StrCat("status[", index, "].code"));
     }
@@ -353,19 +427,29 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
 
     // This mutex is used to ensure exclusivity between multiple threads
     // reading/writing this iterator's local state.
-    mutex mu_;
+    const std::shared_ptr<mutex> mu_;
     // This mutex is used to ensure exclusivity between multiple threads
     // accessing the parent iterator. We keep this separate from `mu_` to
     // allow prefetching to run in parallel with GetNext calls.
-    mutex parent_mu_ ACQUIRED_BEFORE(mu_);
+    mutex parent_mu_ ACQUIRED_BEFORE(*mu_);
     std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(parent_mu_);
-    condition_variable cond_var_;
+    // Wakes the prefetch thread. It is shared with the performance model, which
+    // notifies it when it changes the buffer size.
+    const std::shared_ptr<condition_variable> cond_var_;
+    // Wakes the calls to GetNext waiting for an element.
+    condition_variable consumer_cond_var_;
+    int64 num_waiting_consumers_ GUARDED_BY(*mu_) = 0;
+    bool producer_waiting_ GUARDED_BY(*mu_) = false;
     string prefix_end_;
-    PrefetchAutotuner auto_tuner_ GUARDED_BY(mu_);
-    std::deque<BufferElement> buffer_ GUARDED_BY(mu_);
-    std::unique_ptr<Thread> prefetch_thread_ GUARDED_BY(mu_);
-    bool cancelled_ GUARDED_BY(mu_) = false;
-    bool prefetch_thread_finished_ GUARDED_BY(mu_) = false;
+    PrefetchAutotuner auto_tuner_ GUARDED_BY(*mu_);
+    // Set if the buffer size is tuned by the performance model.
+    std::shared_ptr<model::SharedState> buffer_limit_;
+    std::deque<BufferElement> buffer_ GUARDED_BY(*mu_);
+    // The number of bytes held by the elements of `buffer_`.
+    int64 buffered_bytes_ GUARDED_BY(*mu_) = 0;
+    std::unique_ptr<Thread> prefetch_thread_ GUARDED_BY(*mu_);
+    bool cancelled_ GUARDED_BY(*mu_) = false;
+    bool prefetch_thread_finished_ GUARDED_BY(*mu_) = false;
   };
   const DatasetBase* const input_;
   const int64 buffer_size_;
@@ -19,9 +19,15 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
@@ -30,6 +36,135 @@ namespace {
 
 const int64 kLogIntervalMicros = 10 * 1000000;  // 10 seconds.
 
+// Returns the local directory that shuffle buffers spill elements to, which is
+// read from the TF_DATA_SHUFFLE_SPILL_DIR environment variable. Spilling is
+// disabled if it is empty, the default.
+const string& ShuffleSpillDirectory() {
+  static const string* directory = []() {
+    string* directory = new string;
+    Status s =
+        ReadStringFromEnvVar("TF_DATA_SHUFFLE_SPILL_DIR", "", directory);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      directory->clear();
+    }
+    return directory;
+  }();
+  return *directory;
+}
+
+// Returns the number of bytes a shuffle buffer keeps in memory before it
+// spills elements, which is read from the TF_DATA_SHUFFLE_MEMORY_LIMIT_MB
+// environment variable. It is unlimited by default, in which case elements are
+// only spilled while the buffers of the process exceed their budget.
+int64 ShuffleMemoryLimitBytes() {
+  static const int64 limit_bytes = []() {
+    int64 limit_mb;
+    Status s =
+        ReadInt64FromEnvVar("TF_DATA_SHUFFLE_MEMORY_LIMIT_MB", 0, &limit_mb);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      limit_mb = 0;
+    }
+    return limit_mb * (1LL << 20);
+  }();
+  return limit_bytes;
+}
+
+// The location of a spilled element in its `SpillFile`.
+struct SpilledElement {
+  int64 offset = -1;  // -1 if the element is held in memory.
+  int64 length = 0;
+};
+
+// A file holding the elements spilled from a shuffle buffer. Each element is a
+// sequence of serialized `TensorProto`s, each prefixed by its length.
+class SpillFile {
+ public:
+  SpillFile(Env* env, const string& directory)
+      : env_(env), directory_(directory) {}
+
+  ~SpillFile() { Reset(); }
+
+  Status Write(const std::vector<Tensor>& element, SpilledElement* spilled) {
+    if (!writer_) {
+      filename_ = io::JoinPath(
+          directory_,
+          strings::StrCat("shuffle_spill_",
+                          strings::Hex(random::New64(), strings::kZeroPad16),
+                          ".tmp"));
+      TF_RETURN_IF_ERROR(env_->NewWritableFile(filename_, &writer_));
+    }
+    string record;
+    for (const Tensor& t : element) {
+      TensorProto proto;
+      t.AsProtoTensorContent(&proto);
+      string serialized;
+      proto.SerializeToString(&serialized);
+      core::PutVarint64(&record, serialized.size());
+      record.append(serialized);
+    }
+    TF_RETURN_IF_ERROR(writer_->Append(record));
+    spilled->offset = size_;
+    spilled->length = record.size();
+    size_ += record.size();
+    needs_flush_ = true;
+    return Status::OK();
+  }
+
+  Status Read(const SpilledElement& spilled, std::vector<Tensor>* element) {
+    if (needs_flush_) {
+      TF_RETURN_IF_ERROR(writer_->Flush());
+      needs_flush_ = false;
+    }
+    if (!reader_) {
+      TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(filename_, &reader_));
+    }
+    string scratch;
+    scratch.resize(spilled.length);
+    StringPiece data;
+    TF_RETURN_IF_ERROR(
+        reader_->Read(spilled.offset, spilled.length, &data, &scratch[0]));
+    if (data.size() != spilled.length) {
+      return errors::DataLoss("Truncated shuffle spill file ", filename_);
+    }
+    element->clear();
+    while (!data.empty()) {
+      uint64 length;
+      TensorProto proto;
+      element->emplace_back();
+      if (!core::GetVarint64(&data, &length) || length > data.size() ||
+          !proto.ParseFromArray(data.data(), length) ||
+          !element->back().FromProto(proto)) {
+        return errors::DataLoss("Corrupted shuffle spill file ", filename_);
+      }
+      data.remove_prefix(length);
+    }
+    return Status::OK();
+  }
+
+  // Deletes the file. Must only be called once it holds no live elements.
+  void Reset() {
+    reader_.reset();
+    writer_.reset();
+    if (!filename_.empty()) {
+      env_->DeleteFile(filename_).IgnoreError();
+      filename_.clear();
+    }
+    size_ = 0;
+    needs_flush_ = false;
+  }
+
+ private:
+  Env* const env_;
+  const string directory_;
+  string filename_;
+  std::unique_ptr<WritableFile> writer_;
+  std::unique_ptr<RandomAccessFile> reader_;
+  int64 size_ = 0;
+  bool needs_flush_ = false;
+};
+
 // See documentation in ../../ops/dataset_ops.cc for a high-level
 // description of the following op.
 
@@ -76,9 +211,19 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
             parent_generator_(seed, seed2),
             generator_(&parent_generator_) {
         buffer_.reset(new std::vector<Tensor>[params.dataset->buffer_size_]);
+        if (!ShuffleSpillDirectory().empty()) {
+          spilled_.reset(new SpilledElement[params.dataset->buffer_size_]);
+        }
         slices_.push_back(MakeUnique<Slice>(0, 0));
       }
 
+      ~Iterator() override { BufferBudget::Global()->Remove(buffered_bytes_); }
+
+      int64 BufferedBytes() override {
+        mutex_lock l(mu_);
+        return buffered_bytes_;
+      }
+
       Status GetNextInternal(IteratorContext* ctx,
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
@@ -91,7 +236,12 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
           TF_RETURN_IF_ERROR(this->dataset()->input_->MakeIterator(
               ctx, this->prefix(), &input_impl_));
         }
-        while (input_impl_ && num_elements_ < this->dataset()->buffer_size_) {
+        // While the buffers of the process exceed their budget, the shuffle
+        // buffer shrinks to the elements it already holds, unless it spills
+        // the new elements to disk.
+        while (input_impl_ && num_elements_ < this->dataset()->buffer_size_ &&
+               (num_elements_ == 0 || spilled_ ||
+                !BufferBudget::Global()->Exceeded())) {
           if (ctx->env()->NowMicros() >
               ((num_log_entries + 1) * kLogIntervalMicros) + start_micros) {
             num_log_entries++;
@@ -124,8 +274,22 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
                 ctx, this->prefix(), &input_impl_));
           }
           if (!end_of_input_sequence) {
-            buffer_[slices_.back()->end % this->dataset()->buffer_size_] =
-                std::move(input_element);
+            int64 index = slices_.back()->end % this->dataset()->buffer_size_;
+            int64 num_bytes = GetTotalBytes(input_element);
+            if (ShouldSpill(num_bytes)) {
+              if (!spill_file_) {
+                spill_file_.reset(
+                    new SpillFile(ctx->env(), ShuffleSpillDirectory()));
+              }
+              TF_RETURN_IF_ERROR(
+                  spill_file_->Write(input_element, &spilled_[index]));
+              buffer_[index].clear();
+              num_spilled_++;
+            } else {
+              buffered_bytes_ += num_bytes;
+              BufferBudget::Global()->Add(num_bytes);
+              buffer_[index] = std::move(input_element);
+            }
             num_elements_++;
             slices_.back()->end++;
           } else {
@@ -150,16 +314,32 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
               Random() % (slices_.front()->end - slices_.front()->start);
           int64 index =
               (slices_.front()->start + offset) % this->dataset()->buffer_size_;
-          *out_tensors = std::move(buffer_[index]);
-          std::swap(
-              buffer_[index],
-              buffer_[slices_.front()->start % this->dataset()->buffer_size_]);
+          int64 start_index =
+              slices_.front()->start % this->dataset()->buffer_size_;
+          if (IsSpilled(index)) {
+            TF_RETURN_IF_ERROR(spill_file_->Read(spilled_[index], out_tensors));
+            spilled_[index] = SpilledElement();
+            if (--num_spilled_ == 0) {
+              // Reclaim the disk space of the elements read back.
+              spill_file_->Reset();
+            }
+          } else {
+            int64 num_bytes = GetTotalBytes(buffer_[index]);
+            buffered_bytes_ -= num_bytes;
+            BufferBudget::Global()->Remove(num_bytes);
+            *out_tensors = std::move(buffer_[index]);
+          }
+          std::swap(buffer_[index], buffer_[start_index]);
+          if (spilled_) {
+            std::swap(spilled_[index], spilled_[start_index]);
+          }
           slices_.front()->start++;
           num_elements_--;
         } else {
           DCHECK(input_impl_ == nullptr);
           *end_of_sequence = true;
         }
+        this->RecordBufferedBytes(ctx, buffered_bytes_);
         return Status::OK();
       }
 
@@ -198,13 +378,21 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
               slices_[i]->end));
           for (size_t j = slices_[i]->start; j < slices_[i]->end; ++j) {
             size_t index = j % this->dataset()->buffer_size_;
+            // Spilled elements are checkpointed like the ones in memory.
+            const std::vector<Tensor>* element = &buffer_[index];
+            std::vector<Tensor> spilled_element;
+            if (IsSpilled(index)) {
+              TF_RETURN_IF_ERROR(
+                  spill_file_->Read(spilled_[index], &spilled_element));
+              element = &spilled_element;
+            }
             TF_RETURN_IF_ERROR(writer->WriteScalar(
                 this->full_name(strings::StrCat("buffer_", index, "_size")),
-                buffer_[index].size()));
-            for (size_t k = 0; k < buffer_[index].size(); ++k) {
+                element->size()));
+            for (size_t k = 0; k < element->size(); ++k) {
               TF_RETURN_IF_ERROR(writer->WriteTensor(
                   this->full_name(strings::StrCat("buffer_", index, "_", k)),
-                  buffer_[index][k]));
+                  (*element)[k]));
             }
           }
         }
@@ -245,6 +433,14 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
           slices_size = static_cast<size_t>(temp);
         }
         buffer_.reset(new std::vector<Tensor>[this->dataset()->buffer_size_]);
+        BufferBudget::Global()->Remove(buffered_bytes_);
+        buffered_bytes_ = 0;
+        // The restored elements are all held in memory.
+        if (spilled_) {
+          spilled_.reset(new SpilledElement[this->dataset()->buffer_size_]);
+        }
+        spill_file_.reset();
+        num_spilled_ = 0;
         for (size_t i = 0; i < slices_size; ++i) {
           int64 start;
           TF_RETURN_IF_ERROR(reader->ReadScalar(
@@ -265,6 +461,9 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
                   this->full_name(strings::StrCat("buffer_", index, "_", k)),
                   &buffer_[index][k]));
             }
+            int64 num_bytes = GetTotalBytes(buffer_[index]);
+            buffered_bytes_ += num_bytes;
+            BufferBudget::Global()->Add(num_bytes);
           }
         }
 
@@ -284,6 +483,21 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
         int64 end;
       };
 
+      // Returns whether a new element of `num_bytes` bytes should be spilled
+      // to disk rather than held in memory.
+      bool ShouldSpill(int64 num_bytes) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!spilled_ || num_elements_ == 0) {
+          return false;
+        }
+        const int64 limit_bytes = ShuffleMemoryLimitBytes();
+        return BufferBudget::Global()->Exceeded() ||
+               (limit_bytes > 0 && buffered_bytes_ + num_bytes > limit_bytes);
+      }
+
+      bool IsSpilled(int64 index) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return spilled_ && spilled_[index].offset >= 0;
+      }
+
       random::SingleSampleAdapter<random::PhiloxRandom>::ResultType Random()
           EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         num_random_samples_++;
@@ -301,11 +515,18 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
 
       mutex mu_;
       std::unique_ptr<std::vector<Tensor>[]> buffer_ GUARDED_BY(mu_);
+      // If spilling is enabled, the location of each element of `buffer_` that
+      // is spilled to `spill_file_` instead of held in memory.
+      std::unique_ptr<SpilledElement[]> spilled_ GUARDED_BY(mu_);
+      std::unique_ptr<SpillFile> spill_file_ GUARDED_BY(mu_);
+      int64 num_spilled_ GUARDED_BY(mu_) = 0;
       std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
       int64 seed_ GUARDED_BY(mu_);
       int64 seed2_ GUARDED_BY(mu_);
       int64 epoch_ GUARDED_BY(mu_);
       int64 num_elements_ GUARDED_BY(mu_);
+      // The number of bytes held by the elements of `buffer_`.
+      int64 buffered_bytes_ GUARDED_BY(mu_) = 0;
       std::deque<std::unique_ptr<Slice>> slices_ GUARDED_BY(mu_);
       random::PhiloxRandom parent_generator_ GUARDED_BY(mu_);
       random::SingleSampleAdapter<random::PhiloxRandom> generator_
@@ -51,7 +51,9 @@ namespace data {
 //    are not currently supported.
 //
 // The single-threaded executor is primarily suitable for executing simple
-// TensorFlow functions, such as one might find in a `tf.data` pipeline.
+// TensorFlow functions, such as one might find in a `tf.data` pipeline. When it
+// is linked in, `FunctionLibraryRuntime` also uses it for small CPU function
+// bodies that do not request a particular executor.
 Status NewSingleThreadedExecutor(const LocalExecutorParams& params,
                                  std::unique_ptr<const Graph> graph,
                                  Executor** executor);
@@ -19,14 +19,20 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 #include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/rendezvous.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -35,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
 
 namespace tensorflow {
 namespace data {
@@ -244,6 +251,55 @@ TEST_F(ExecutorTest, OpError) {
   EXPECT_TRUE(errors::IsInvalidArgument(Run(&call_frame)));
 }
 
+// Runs XTimesTwo on a CPU function library runtime with the given executor
+// type and returns how many closures the executor handed to the runner.
+int RunXTimesTwo(const string& executor_type) {
+  SessionOptions options;
+  std::vector<Device*> devices;
+  TF_CHECK_OK(DeviceFactory::AddDevices(
+      options, "/job:localhost/replica:0/task:0", &devices));
+  DeviceMgr device_mgr(devices);
+  FunctionDefLibrary proto;
+  *proto.add_function() = test::function::XTimesTwo();
+  FunctionLibraryDefinition lib_def(OpRegistry::Global(), proto);
+  ProcessFunctionLibraryRuntime pflr(&device_mgr, Env::Default(),
+                                     TF_GRAPH_DEF_VERSION, &lib_def,
+                                     OptimizerOptions(), nullptr, nullptr);
+  FunctionLibraryRuntime* flr =
+      pflr.GetFLR("/job:localhost/replica:0/task:0/cpu:0");
+
+  FunctionLibraryRuntime::InstantiateOptions instantiate_opts;
+  instantiate_opts.executor_type = executor_type;
+  FunctionLibraryRuntime::Handle handle;
+  TF_CHECK_OK(flr->Instantiate("XTimesTwo",
+                               test::function::Attrs({{"T", DT_FLOAT}}),
+                               instantiate_opts, &handle));
+
+  int num_scheduled = 0;
+  std::function<void(std::function<void()>)> runner =
+      [&num_scheduled](std::function<void()> fn) {
+        ++num_scheduled;
+        fn();
+      };
+  FunctionLibraryRuntime::Options opts;
+  opts.runner = &runner;
+  std::vector<Tensor> rets;
+  Notification done;
+  flr->Run(opts, handle, {test::AsTensor<float>({1, 2, 3})}, &rets,
+           [&done](const Status& s) {
+             TF_CHECK_OK(s);
+             done.Notify();
+           });
+  done.WaitForNotification();
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({2, 4, 6}), rets[0]);
+  return num_scheduled;
+}
+
+TEST(SingleThreadedExecutorTest, RunsSmallFunctionsByDefault) {
+  EXPECT_EQ(0, RunXTimesTwo(""));
+  EXPECT_LT(0, RunXTimesTwo("DEFAULT"));
+}
+
 static void BM_executor(int iters, int width, int depth) {
 #ifdef PLATFORM_GOOGLE
   BenchmarkUseRealTime();
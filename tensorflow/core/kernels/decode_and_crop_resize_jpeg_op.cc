@@ -0,0 +1,249 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/image_resizer_state.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace {
+
+// The largest denominator of the scaling factors supported by libjpeg.
+constexpr int kMaxDecodeRatio = 8;
+
+struct Interpolation {
+  int64 lower;
+  int64 upper;
+  float lerp;
+};
+
+// Same interpolation weights as the ResizeBilinear kernel.
+std::vector<Interpolation> InterpolationWeights(int64 out_size, int64 in_size,
+                                                bool align_corners) {
+  const float scale = CalculateResizeScale(in_size, out_size, align_corners);
+  std::vector<Interpolation> weights(out_size);
+  for (int64 i = 0; i < out_size; ++i) {
+    const float in = i * scale;
+    weights[i].lower = static_cast<int64>(in);
+    weights[i].upper = std::min(weights[i].lower + 1, in_size - 1);
+    weights[i].lerp = in - weights[i].lower;
+  }
+  return weights;
+}
+
+// Decodes, crops, resizes and normalizes a JPEG image in a single kernel. The
+// image is decoded straight to the smallest scale libjpeg supports that is
+// still at least as large as the output, and resized bilinearly into the
+// normalized float output, so that no full-resolution intermediate is needed.
+class DecodeAndCropResizeJpegOp : public OpKernel {
+ public:
+  explicit DecodeAndCropResizeJpegOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &channels_));
+    OP_REQUIRES(context, channels_ == 0 || channels_ == 1 || channels_ == 3,
+                errors::InvalidArgument(
+                    "channels must be 0, 1, or 3 for JPEG, got ", channels_));
+    flags_.components = channels_;
+    flags_.crop = true;
+    OP_REQUIRES_OK(context, context->GetAttr("fancy_upscaling",
+                                             &flags_.fancy_upscaling));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("try_recover_truncated",
+                                    &flags_.try_recover_truncated_jpeg));
+    OP_REQUIRES_OK(context, context->GetAttr("acceptable_fraction",
+                                             &flags_.min_acceptable_fraction));
+    OP_REQUIRES_OK(context, context->GetAttr("align_corners", &align_corners_));
+
+    // Same default as DecodeAndCropJpeg.
+    flags_.dct_method = JDCT_IFAST;
+    string dct_method;
+    OP_REQUIRES_OK(context, context->GetAttr("dct_method", &dct_method));
+    OP_REQUIRES(
+        context,
+        (dct_method.empty() || dct_method == "INTEGER_FAST" ||
+         dct_method == "INTEGER_ACCURATE"),
+        errors::InvalidArgument("dct_method must be one of "
+                                "{'', 'INTEGER_FAST', 'INTEGER_ACCURATE'}"));
+    if (dct_method == "INTEGER_ACCURATE") {
+      flags_.dct_method = JDCT_ISLOW;
+    }
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& contents = context->input(0);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(contents.shape()),
+                errors::InvalidArgument("contents must be scalar, got shape ",
+                                        contents.shape().DebugString()));
+    const StringPiece input = contents.scalar<string>()();
+    OP_REQUIRES(context, input.size() <= std::numeric_limits<int>::max(),
+                errors::InvalidArgument("JPEG contents are too large for int: ",
+                                        input.size()));
+
+    const Tensor& crop_window = context->input(1);
+    OP_REQUIRES(context,
+                crop_window.dims() == 1 && crop_window.dim_size(0) == 4,
+                errors::InvalidArgument(
+                    "crop_window must be 1-D with four elements, got shape ",
+                    crop_window.shape().DebugString()));
+    const Tensor& size = context->input(2);
+    OP_REQUIRES(context, size.dims() == 1 && size.dim_size(0) == 2,
+                errors::InvalidArgument(
+                    "size must be 1-D with two elements, got shape ",
+                    size.shape().DebugString()));
+    const int64 out_height = size.vec<int32>()(0);
+    const int64 out_width = size.vec<int32>()(1);
+    OP_REQUIRES(context, out_height > 0 && out_width > 0,
+                errors::InvalidArgument("output dimensions must be positive"));
+    const Tensor& offset = context->input(3);
+    const Tensor& scale = context->input(4);
+    OP_REQUIRES(context, offset.dims() <= 1 && scale.dims() <= 1,
+                errors::InvalidArgument(
+                    "offset and scale must be scalars or vectors, got shapes ",
+                    offset.shape().DebugString(), " and ",
+                    scale.shape().DebugString()));
+
+    int image_width, image_height;
+    OP_REQUIRES(context,
+                jpeg::GetImageInfo(input.data(), input.size(), &image_width,
+                                   &image_height, nullptr),
+                errors::InvalidArgument("Invalid JPEG data, data size ",
+                                        input.size()));
+
+    auto crop_window_vec = crop_window.vec<int32>();
+    const int crop_y = crop_window_vec(0);
+    const int crop_x = crop_window_vec(1);
+    const int crop_height = crop_window_vec(2);
+    const int crop_width = crop_window_vec(3);
+    OP_REQUIRES(context,
+                crop_height > 0 && crop_width > 0 && crop_y >= 0 &&
+                    crop_x >= 0 && crop_y + crop_height <= image_height &&
+                    crop_x + crop_width <= image_width,
+                errors::InvalidArgument(
+                    "Invalid crop window: y=", crop_y, ", x=", crop_x,
+                    ", h=", crop_height, ", w=", crop_width,
+                    " for image_height: ", image_height,
+                    " and image_width: ", image_width));
+
+    // Decode at the smallest scale at which the crop is still at least as
+    // large as the output. The crop window is given in the coordinates of the
+    // scaled image, which libjpeg rounds up.
+    jpeg::UncompressFlags flags = flags_;
+    while (flags.ratio < kMaxDecodeRatio &&
+           crop_height / (2 * flags.ratio) >= out_height &&
+           crop_width / (2 * flags.ratio) >= out_width) {
+      flags.ratio *= 2;
+    }
+    flags.crop_y = crop_y / flags.ratio;
+    flags.crop_x = crop_x / flags.ratio;
+    flags.crop_height = crop_height / flags.ratio;
+    flags.crop_width = crop_width / flags.ratio;
+
+    Tensor decoded;
+    OP_REQUIRES(
+        context,
+        jpeg::Uncompress(
+            input.data(), input.size(), flags, nullptr /* nwarn */,
+            [=, &decoded](int width, int height, int channels) -> uint8* {
+              Status status = context->allocate_temp(
+                  DT_UINT8, TensorShape({height, width, channels}), &decoded);
+              if (!status.ok()) {
+                VLOG(1) << status;
+                context->SetStatus(status);
+                return nullptr;
+              }
+              return decoded.flat<uint8>().data();
+            }),
+        errors::InvalidArgument("Invalid JPEG data or crop window, data size ",
+                                input.size()));
+
+    const int64 in_height = decoded.dim_size(0);
+    const int64 in_width = decoded.dim_size(1);
+    const int64 channels = decoded.dim_size(2);
+    OP_REQUIRES(context,
+                (offset.NumElements() == 1 ||
+                 offset.NumElements() == channels) &&
+                    (scale.NumElements() == 1 ||
+                     scale.NumElements() == channels),
+                errors::InvalidArgument(
+                    "offset and scale must have 1 or ", channels,
+                    " elements, got ", offset.NumElements(), " and ",
+                    scale.NumElements()));
+
+    // One offset and scale per channel.
+    std::vector<float> offsets(channels), scales(channels);
+    for (int64 c = 0; c < channels; ++c) {
+      offsets[c] = offset.flat<float>()(offset.NumElements() == 1 ? 0 : c);
+      scales[c] = scale.flat<float>()(scale.NumElements() == 1 ? 0 : c);
+    }
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0, TensorShape({out_height, out_width, channels}),
+                       &output));
+
+    const std::vector<Interpolation> ys =
+        InterpolationWeights(out_height, in_height, align_corners_);
+    const std::vector<Interpolation> xs =
+        InterpolationWeights(out_width, in_width, align_corners_);
+    const uint8* image = decoded.flat<uint8>().data();
+    const int64 row_size = in_width * channels;
+    float* out = output->flat<float>().data();
+    for (int64 y = 0; y < out_height; ++y) {
+      const uint8* top_row = image + ys[y].lower * row_size;
+      const uint8* bottom_row = image + ys[y].upper * row_size;
+      const float y_lerp = ys[y].lerp;
+      for (int64 x = 0; x < out_width; ++x) {
+        const int64 left = xs[x].lower * channels;
+        const int64 right = xs[x].upper * channels;
+        const float x_lerp = xs[x].lerp;
+        for (int64 c = 0; c < channels; ++c) {
+          const float top_left = top_row[left + c];
+          const float top_right = top_row[right + c];
+          const float bottom_left = bottom_row[left + c];
+          const float bottom_right = bottom_row[right + c];
+          const float top = top_left + (top_right - top_left) * x_lerp;
+          const float bottom =
+              bottom_left + (bottom_right - bottom_left) * x_lerp;
+          const float value = top + (bottom - top) * y_lerp;
+          *out++ = (value - offsets[c]) * scales[c];
+        }
+      }
+    }
+  }
+
+ private:
+  int channels_;
+  bool align_corners_;
+  jpeg::UncompressFlags flags_;
+};
+
+}  // namespace
+
+REGISTER_KERNEL_BUILDER(Name("_DecodeAndCropResizeJpeg").Device(DEVICE_CPU),
+                        DecodeAndCropResizeJpegOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,120 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// A 128x256 (width x height) RGB image.
+constexpr char kTestImage[] =
+    "tensorflow/core/lib/jpeg/testdata/jpeg_merge_test1.jpg";
+
+class DecodeAndCropResizeJpegOpTest : public OpsTestBase {
+ protected:
+  void SetUp() override {
+    TF_ASSERT_OK(ReadFileToString(Env::Default(), kTestImage, &jpeg_));
+    TF_ASSERT_OK(NodeDefBuilder("decode", "_DecodeAndCropResizeJpeg")
+                     .Input(FakeInput(DT_STRING))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("channels", 3)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Returns the normalized image decoded by libjpeg at the given ratio.
+  Tensor Decode(int ratio, int crop_y, int crop_x, int crop_height,
+                int crop_width, float offset, float scale) {
+    jpeg::UncompressFlags flags;
+    flags.components = 3;
+    flags.dct_method = JDCT_IFAST;
+    flags.ratio = ratio;
+    flags.crop = true;
+    flags.crop_y = crop_y;
+    flags.crop_x = crop_x;
+    flags.crop_height = crop_height;
+    flags.crop_width = crop_width;
+    int width, height, channels;
+    std::unique_ptr<uint8[]> decoded(
+        jpeg::Uncompress(jpeg_.data(), jpeg_.size(), flags, &width, &height,
+                         &channels, nullptr));
+    CHECK(decoded != nullptr);
+    Tensor expected(DT_FLOAT, TensorShape({height, width, channels}));
+    auto expected_flat = expected.flat<float>();
+    for (int i = 0; i < expected_flat.size(); ++i) {
+      expected_flat(i) = (decoded[i] - offset) * scale;
+    }
+    return expected;
+  }
+
+  string jpeg_;
+};
+
+TEST_F(DecodeAndCropResizeJpegOpTest, SameSizeAsCrop) {
+  AddInputFromArray<string>(TensorShape({}), {jpeg_});
+  AddInputFromArray<int32>(TensorShape({4}), {16, 8, 64, 32});
+  AddInputFromArray<int32>(TensorShape({2}), {64, 32});
+  AddInputFromArray<float>(TensorShape({}), {10.0f});
+  AddInputFromArray<float>(TensorShape({}), {0.5f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<float>(Decode(1, 16, 8, 64, 32, 10.0f, 0.5f),
+                                 *GetOutput(0));
+}
+
+TEST_F(DecodeAndCropResizeJpegOpTest, DecodesAtReducedScale) {
+  AddInputFromArray<string>(TensorShape({}), {jpeg_});
+  AddInputFromArray<int32>(TensorShape({4}), {0, 0, 256, 128});
+  AddInputFromArray<int32>(TensorShape({2}), {32, 16});
+  AddInputFromArray<float>(TensorShape({3}), {1.0f, 2.0f, 3.0f});
+  AddInputFromArray<float>(TensorShape({}), {2.0f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // The output is an eighth of the image, which libjpeg decodes directly.
+  Tensor expected = Decode(8, 0, 0, 32, 16, 0.0f, 2.0f);
+  auto expected_flat = expected.flat<float>();
+  for (int i = 0; i < expected_flat.size(); ++i) {
+    expected_flat(i) -= 2.0f * (1 + i % 3);
+  }
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(DecodeAndCropResizeJpegOpTest, InvalidCropWindow) {
+  AddInputFromArray<string>(TensorShape({}), {jpeg_});
+  AddInputFromArray<int32>(TensorShape({4}), {200, 0, 100, 128});
+  AddInputFromArray<int32>(TensorShape({2}), {32, 16});
+  AddInputFromArray<float>(TensorShape({}), {0.0f});
+  AddInputFromArray<float>(TensorShape({}), {1.0f});
+  EXPECT_FALSE(RunOpKernel().ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -21,6 +21,9 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/csv_fast_parsing.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -76,137 +79,155 @@ class DecodeCSVOp : public OpKernel {
     OpOutputList output;
     OP_REQUIRES_OK(ctx, ctx->output_list("output", &output));
 
+    std::vector<Tensor*> outputs(out_type_.size());
     for (int i = 0; i < static_cast<int>(out_type_.size()); ++i) {
-      Tensor* out = nullptr;
-      OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &out));
+      OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &outputs[i]));
     }
 
-    for (int64 i = 0; i < records_size; ++i) {
-      const StringPiece record(records_t(i));
-      std::vector<string> fields;
-      ExtractFields(ctx, record, &fields);
-      OP_REQUIRES(ctx, fields.size() == out_type_.size(),
-                  errors::InvalidArgument("Expect ", out_type_.size(),
-                                          " fields but have ", fields.size(),
-                                          " in record ", i));
+    // Records are independent, so shards of them are parsed in parallel.
+    // Reports the error of the first invalid record, as a sequential parse
+    // would.
+    mutex mu;
+    int64 first_error_record = records_size;
+    Status first_error;
+    auto parse_records = [&](int64 start, int64 limit) {
+      // Reused across records, so that parsing a record does not allocate.
+      std::vector<StringPiece> fields;
+      string unescaped;
+      for (int64 i = start; i < limit; ++i) {
+        Status s = ParseRecord(i, records_t(i), record_defaults, outputs,
+                               &fields, &unescaped);
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          if (i < first_error_record) {
+            first_error_record = i;
+            first_error = s;
+          }
+          return;
+        }
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    const int64 cost_per_record = kCostPerField * out_type_.size();
+    Shard(worker_threads.num_threads, worker_threads.workers, records_size,
+          cost_per_record, parse_records);
+    OP_REQUIRES_OK(ctx, first_error);
+  }
 
-      // Check each field in the record
-      for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
-        const DataType& dtype = out_type_[f];
-        switch (dtype) {
-          case DT_INT32: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
+ private:
+  // A rough count of the cycles to parse a field, for sharding records.
+  static constexpr int64 kCostPerField = 200;
 
-              output[f]->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
-            } else {
-              int32 value;
-              OP_REQUIRES(ctx, strings::safe_strto32(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid int32: ", fields[f]));
-              output[f]->flat<int32>()(i) = value;
-            }
-            break;
-          }
-          case DT_INT64: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
+  std::vector<DataType> out_type_;
+  std::vector<int64> select_cols_;
+  char delim_;
+  bool use_quote_delim_;
+  bool select_all_cols_;
+  string na_value_;
 
-              output[f]->flat<int64>()(i) = record_defaults[f].flat<int64>()(0);
-            } else {
-              int64 value;
-              OP_REQUIRES(ctx, strings::safe_strto64(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid int64: ", fields[f]));
-              output[f]->flat<int64>()(i) = value;
+  // Parses `record`, the record at index `i` of the input, into element `i`
+  // of `outputs`. `fields` and `unescaped` are scratch space.
+  Status ParseRecord(int64 i, StringPiece record,
+                     const OpInputList& record_defaults,
+                     const std::vector<Tensor*>& outputs,
+                     std::vector<StringPiece>* fields, string* unescaped) {
+    fields->clear();
+    TF_RETURN_IF_ERROR(ExtractFields(record, fields, unescaped));
+    if (fields->size() != out_type_.size()) {
+      return errors::InvalidArgument("Expect ", out_type_.size(),
+                                     " fields but have ", fields->size(),
+                                     " in record ", i);
+    }
+
+    // Check each field in the record
+    for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
+      const StringPiece field = (*fields)[f];
+      const DataType& dtype = out_type_[f];
+      // If this field is empty or NA value, check if default is given:
+      // If yes, use default value; Otherwise report error.
+      const bool missing = field.empty() || field == na_value_;
+      if (missing && record_defaults[f].NumElements() != 1) {
+        return errors::InvalidArgument(
+            "Field ", f, " is required but missing in record ", i, "!");
+      }
+      switch (dtype) {
+        case DT_INT32: {
+          if (missing) {
+            outputs[f]->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
+          } else {
+            int32 value;
+            if (!strings::safe_strto32(field, &value)) {
+              return errors::InvalidArgument("Field ", f, " in record ", i,
+                                             " is not a valid int32: ", field);
             }
-            break;
+            outputs[f]->flat<int32>()(i) = value;
           }
-          case DT_FLOAT: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<float>()(i) = record_defaults[f].flat<float>()(0);
-            } else {
-              float value;
-              OP_REQUIRES(ctx, strings::safe_strtof(fields[f].c_str(), &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid float: ", fields[f]));
-              output[f]->flat<float>()(i) = value;
+          break;
+        }
+        case DT_INT64: {
+          if (missing) {
+            outputs[f]->flat<int64>()(i) = record_defaults[f].flat<int64>()(0);
+          } else {
+            int64 value;
+            if (!strings::safe_strto64(field, &value)) {
+              return errors::InvalidArgument("Field ", f, " in record ", i,
+                                             " is not a valid int64: ", field);
             }
-            break;
+            outputs[f]->flat<int64>()(i) = value;
           }
-          case DT_DOUBLE: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<double>()(i) =
-                  record_defaults[f].flat<double>()(0);
-            } else {
-              double value;
-              OP_REQUIRES(ctx, strings::safe_strtod(fields[f].c_str(), &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid double: ", fields[f]));
-              output[f]->flat<double>()(i) = value;
+          break;
+        }
+        case DT_FLOAT: {
+          if (missing) {
+            outputs[f]->flat<float>()(i) = record_defaults[f].flat<float>()(0);
+          } else {
+            float value;
+            if (!csv::ParseFloat(field, &value)) {
+              return errors::InvalidArgument("Field ", f, " in record ", i,
+                                             " is not a valid float: ", field);
             }
-            break;
+            outputs[f]->flat<float>()(i) = value;
           }
-          case DT_STRING: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<string>()(i) =
-                  record_defaults[f].flat<string>()(0);
-            } else {
-              output[f]->flat<string>()(i) = fields[f];
+          break;
+        }
+        case DT_DOUBLE: {
+          if (missing) {
+            outputs[f]->flat<double>()(i) =
+                record_defaults[f].flat<double>()(0);
+          } else {
+            double value;
+            if (!csv::ParseDouble(field, &value)) {
+              return errors::InvalidArgument("Field ", f, " in record ", i,
+                                             " is not a valid double: ", field);
             }
-            break;
+            outputs[f]->flat<double>()(i) = value;
+          }
+          break;
+        }
+        case DT_STRING: {
+          if (missing) {
+            outputs[f]->flat<string>()(i) =
+                record_defaults[f].flat<string>()(0);
+          } else {
+            outputs[f]->flat<string>()(i).assign(field.data(), field.size());
           }
-          default:
-            OP_REQUIRES(ctx, false,
-                        errors::InvalidArgument("csv: data type ", dtype,
-                                                " not supported in field ", f));
+          break;
         }
+        default:
+          return errors::InvalidArgument("csv: data type ", dtype,
+                                         " not supported in field ", f);
       }
     }
+    return Status::OK();
   }
 
- private:
-  std::vector<DataType> out_type_;
-  std::vector<int64> select_cols_;
-  char delim_;
-  bool use_quote_delim_;
-  bool select_all_cols_;
-  string na_value_;
-
-  void ExtractFields(OpKernelContext* ctx, StringPiece input,
-                     std::vector<string>* result) {
+  // Appends the selected fields of `input` to `result`. The fields point
+  // into `input`, except for quoted fields with escaped quotes, which are
+  // unescaped into `unescaped`.
+  Status ExtractFields(StringPiece input, std::vector<StringPiece>* result,
+                       string* unescaped) {
+    unescaped->clear();
     int64 current_idx = 0;
     int64 num_fields_parsed = 0;
     int64 selector_idx = 0;  // Keep track of index into select_cols
@@ -229,48 +250,64 @@ class DecodeCSVOp : public OpKernel {
         }
 
         // This is the body of the field;
-        string field;
+        StringPiece field;
+        const int64 field_start = current_idx;
         if (!quoted) {
-          while (static_cast<size_t>(current_idx) < input.size() &&
-                 input[current_idx] != delim_) {
-            OP_REQUIRES(ctx,
-                        (!use_quote_delim_ || input[current_idx] != '"') &&
-                            input[current_idx] != '\n' &&
-                            input[current_idx] != '\r',
-                        errors::InvalidArgument(
-                            "Unquoted fields cannot have quotes/CRLFs inside"));
-            if (include) field += input[current_idx];
-            current_idx++;
+          const char* field_end =
+              csv::FindFieldEnd(input.data() + current_idx,
+                                input.data() + input.size(), delim_,
+                                use_quote_delim_);
+          current_idx = field_end - input.data();
+          if (static_cast<size_t>(current_idx) < input.size() &&
+              input[current_idx] != delim_) {
+            return errors::InvalidArgument(
+                "Unquoted fields cannot have quotes/CRLFs inside");
           }
+          field = input.substr(field_start, current_idx - field_start);
 
           // Go to next field or the end
           current_idx++;
         } else if (use_quote_delim_) {
           // Quoted field needs to be ended with '"' and delim or end
-          while (
-              (static_cast<size_t>(current_idx) < input.size() - 1) &&
-              (input[current_idx] != '"' || input[current_idx + 1] != delim_)) {
-            if (input[current_idx] != '"') {
-              if (include) field += input[current_idx];
-              current_idx++;
-            } else {
-              OP_REQUIRES(
-                  ctx, input[current_idx + 1] == '"',
-                  errors::InvalidArgument("Quote inside a string has to be "
-                                          "escaped by another quote"));
-              if (include) field += '"';
-              current_idx += 2;
+          bool has_escaped_quotes = false;
+          while (static_cast<size_t>(current_idx) < input.size() - 1) {
+            // Skip to the next quote.
+            const void* quote = memchr(input.data() + current_idx, '"',
+                                       input.size() - 1 - current_idx);
+            if (quote == nullptr) {
+              current_idx = input.size() - 1;
+              break;
             }
+            current_idx = static_cast<const char*>(quote) - input.data();
+            if (input[current_idx + 1] == delim_) break;
+            if (input[current_idx + 1] != '"') {
+              return errors::InvalidArgument(
+                  "Quote inside a string has to be escaped by another quote");
+            }
+            has_escaped_quotes = true;
+            current_idx += 2;
+          }
+          field = input.substr(field_start, current_idx - field_start);
+          if (include && has_escaped_quotes) {
+            // Unescaped fields are shorter than the input, so once the whole
+            // input fits, appending never moves the fields unescaped before.
+            if (unescaped->empty()) unescaped->reserve(input.size());
+            const size_t offset = unescaped->size();
+            for (size_t j = 0; j < field.size(); ++j) {
+              unescaped->push_back(field[j]);
+              if (field[j] == '"') ++j;
+            }
+            field = StringPiece(unescaped->data() + offset,
+                                unescaped->size() - offset);
           }
 
-          OP_REQUIRES(
-              ctx,
-              (static_cast<size_t>(current_idx) < input.size() &&
-               input[current_idx] == '"' &&
-               (static_cast<size_t>(current_idx) == input.size() - 1 ||
-                input[current_idx + 1] == delim_)),
-              errors::InvalidArgument("Quoted field has to end with quote "
-                                      "followed by delim or end"));
+          if (!(static_cast<size_t>(current_idx) < input.size() &&
+                input[current_idx] == '"' &&
+                (static_cast<size_t>(current_idx) == input.size() - 1 ||
+                 input[current_idx + 1] == delim_))) {
+            return errors::InvalidArgument(
+                "Quoted field has to end with quote followed by delim or end");
+          }
 
           current_idx += 2;
         }
@@ -279,7 +316,7 @@ class DecodeCSVOp : public OpKernel {
         if (include) {
           result->push_back(field);
           selector_idx++;
-          if (selector_idx == select_cols_.size()) return;
+          if (selector_idx == select_cols_.size()) return Status::OK();
         }
       }
 
@@ -288,8 +325,9 @@ class DecodeCSVOp : public OpKernel {
                                    static_cast<size_t>(num_fields_parsed));
       // Check if the last field is missing
       if (include && input[input.size() - 1] == delim_)
-        result->push_back(string());
+        result->push_back(StringPiece());
     }
+    return Status::OK();
   }
 };
 
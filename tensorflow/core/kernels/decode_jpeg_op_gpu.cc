@@ -0,0 +1,330 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc
+
+#if GOOGLE_CUDA
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/kernels/decode_jpeg_op_gpu.h"
+
+#include <limits>
+
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace functor {
+template <>
+bool JpegInverseDct<GPUDevice>::operator()(const GPUDevice& d,
+                                          const JpegImage& image,
+                                          const int16* coefficients,
+                                          uint8* samples);
+template <>
+bool JpegColorConvert<GPUDevice>::operator()(
+    const GPUDevice& d, const JpegImage& image, const uint8* samples,
+    int crop_y, int crop_x, bool fancy_upsampling,
+    typename TTypes<uint8, 3>::Tensor output);
+}  // namespace functor
+
+namespace {
+
+// Images smaller than this many bytes are decoded entirely on the host:
+// the inverse DCT of small images is cheaper than the extra copy and
+// kernel launches.
+constexpr int64 kDefaultMinGpuJpegBytes = 32 * 1024;
+
+// Copies `host` to `device` on `stream`, keeping `host` alive until the copy
+// is done.
+void CopyToDevice(OpKernelContext* context, const Tensor& host,
+                  Tensor* device) {
+  auto* stream = context->op_device_context()->stream();
+  se::DeviceMemoryBase device_memory(DMAHelper::base(device),
+                                     host.TotalBytes());
+  stream->ThenMemcpy(&device_memory, DMAHelper::base(&host),
+                     host.TotalBytes());
+  TensorReference host_ref(host);
+  context->device()->tensorflow_gpu_device_info()->event_mgr->ThenExecute(
+      stream, [host_ref]() { host_ref.Unref(); });
+}
+
+}  // namespace
+
+// Decodes JPEG images for consumers on the GPU. The entropy decoding, which
+// is inherently sequential, runs on the host with libjpeg. The inverse DCT,
+// the upsampling of the chroma components and the color conversion run on
+// the GPU, which removes the bulk of the decoding work from the host. Small
+// images, and images or options the GPU path doesn't support (CMYK images,
+// reduced ratios, recovery of truncated images), are decoded on the host and
+// copied to the GPU.
+//
+// The inverse DCT is computed in floating point, so the output may differ
+// from the one of the CPU kernel by a few intensity levels.
+class DecodeJpegGpuOp : public OpKernel {
+ public:
+  explicit DecodeJpegGpuOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    crop_ = type_string() == "DecodeAndCropJpeg";
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &channels_));
+    OP_REQUIRES(context, channels_ == 0 || channels_ == 1 || channels_ == 3,
+                errors::InvalidArgument(
+                    "channels must be 0, 1, or 3 for JPEG, got ", channels_));
+    flags_.components = channels_;
+    OP_REQUIRES_OK(context, context->GetAttr("ratio", &flags_.ratio));
+    OP_REQUIRES(context,
+                flags_.ratio == 1 || flags_.ratio == 2 || flags_.ratio == 4 ||
+                    flags_.ratio == 8,
+                errors::InvalidArgument("ratio must be 1, 2, 4, or 8, got ",
+                                        flags_.ratio));
+    OP_REQUIRES_OK(context, context->GetAttr("fancy_upscaling",
+                                             &flags_.fancy_upscaling));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("try_recover_truncated",
+                                    &flags_.try_recover_truncated_jpeg));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("acceptable_fraction",
+                                    &flags_.min_acceptable_fraction));
+
+    string dct_method;
+    OP_REQUIRES_OK(context, context->GetAttr("dct_method", &dct_method));
+    OP_REQUIRES(
+        context,
+        (dct_method.empty() || dct_method == "INTEGER_FAST" ||
+         dct_method == "INTEGER_ACCURATE"),
+        errors::InvalidArgument("dct_method must be one of "
+                                "{'', 'INTEGER_FAST', 'INTEGER_ACCURATE'}"));
+    flags_.dct_method = dct_method == "INTEGER_ACCURATE" ? JDCT_ISLOW
+                                                         : JDCT_IFAST;
+
+    OP_REQUIRES_OK(context, ReadInt64FromEnvVar("TF_GPU_JPEG_DECODE_MIN_BYTES",
+                                                kDefaultMinGpuJpegBytes,
+                                                &min_gpu_bytes_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& contents = context->input(0);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(contents.shape()),
+                errors::InvalidArgument("contents must be scalar, got shape ",
+                                        contents.shape().DebugString()));
+    const StringPiece input = contents.scalar<string>()();
+    OP_REQUIRES(context, input.size() <= std::numeric_limits<int>::max(),
+                errors::InvalidArgument("JPEG contents are too large for int: ",
+                                        input.size()));
+
+    // Use local copy of flags to avoid race condition as the class member is
+    // shared among different invocations.
+    jpeg::UncompressFlags flags = flags_;
+    if (crop_) {
+      const Tensor& crop_window = context->input(1);
+      OP_REQUIRES(context, crop_window.dims() == 1,
+                  errors::InvalidArgument("crop_window must be 1-D, got shape ",
+                                          crop_window.shape().DebugString()));
+      OP_REQUIRES(context, crop_window.dim_size(0) == 4,
+                  errors::InvalidArgument("crop_size must have four elements ",
+                                          crop_window.shape().DebugString()));
+      auto crop_window_vec = crop_window.vec<int32>();
+      flags.crop = true;
+      flags.crop_y = crop_window_vec(0);
+      flags.crop_x = crop_window_vec(1);
+      flags.crop_height = crop_window_vec(2);
+      flags.crop_width = crop_window_vec(3);
+    }
+
+    if (flags.ratio == 1 && !flags.try_recover_truncated_jpeg &&
+        static_cast<int64>(input.size()) >= min_gpu_bytes_) {
+      bool decoded = false;
+      DecodeOnGpu(context, input, flags, &decoded);
+      if (!context->status().ok() || decoded) return;
+    }
+    DecodeOnHost(context, input, flags);
+  }
+
+ private:
+  // Entropy decodes the image on the host and finishes the decoding on the
+  // GPU. Leaves `decoded` false if the image has to be decoded on the host.
+  void DecodeOnGpu(OpKernelContext* context, StringPiece input,
+                   const jpeg::UncompressFlags& flags, bool* decoded) {
+    AllocatorAttributes host_attr;
+    host_attr.set_on_host(true);
+    host_attr.set_gpu_compatible(true);
+    Tensor host_coefficients;
+    jpeg::CoefficientImage image;
+    // Let the host decoder report invalid or truncated data.
+    if (!jpeg::DecodeCoefficients(
+            input.data(), input.size(), flags, &image,
+            [=, &host_coefficients](int64 size) -> JCOEF* {
+              Status status(context->allocate_temp(
+                  DT_INT16, TensorShape({size}), &host_coefficients,
+                  host_attr));
+              if (!status.ok()) {
+                VLOG(1) << status;
+                context->SetStatus(status);
+                return nullptr;
+              }
+              return reinterpret_cast<JCOEF*>(
+                  host_coefficients.flat<int16>().data());
+            })) {
+      return;
+    }
+
+    functor::JpegImage gpu_image;
+    gpu_image.num_components = image.components.size();
+    gpu_image.max_h_samp_factor = image.max_h_samp_factor;
+    gpu_image.max_v_samp_factor = image.max_v_samp_factor;
+    gpu_image.ycbcr = image.color_space == JCS_YCbCr;
+    const bool supported =
+        (image.color_space == JCS_GRAYSCALE &&
+         gpu_image.num_components == 1) ||
+        ((image.color_space == JCS_YCbCr || image.color_space == JCS_RGB) &&
+         gpu_image.num_components == 3);
+    if (!supported) {
+      VLOG(1) << "Decoding a JPEG image with color space " << image.color_space
+              << " on the host";
+      return;
+    }
+
+    int crop_y = 0;
+    int crop_x = 0;
+    int height = image.height;
+    int width = image.width;
+    if (flags.crop) {
+      OP_REQUIRES(
+          context,
+          flags.crop_width > 0 && flags.crop_height > 0 &&
+              flags.crop_x >= 0 && flags.crop_y >= 0 &&
+              flags.crop_y + flags.crop_height <= image.height &&
+              flags.crop_x + flags.crop_width <= image.width,
+          errors::InvalidArgument("Invalid JPEG data or crop window, data "
+                                  "size ",
+                                  input.size()));
+      crop_y = flags.crop_y;
+      crop_x = flags.crop_x;
+      height = flags.crop_height;
+      width = flags.crop_width;
+    }
+
+    int64 num_samples = 0;
+    for (int c = 0; c < gpu_image.num_components; ++c) {
+      const jpeg::ComponentCoefficients& from = image.components[c];
+      functor::JpegComponent& to = gpu_image.components[c];
+      to.h_samp_factor = from.h_samp_factor;
+      to.v_samp_factor = from.v_samp_factor;
+      to.width = from.width;
+      to.height = from.height;
+      to.width_in_blocks = from.width_in_blocks;
+      to.height_in_blocks = from.height_in_blocks;
+      to.coefficient_offset = from.offset;
+      to.sample_offset = num_samples;
+      std::copy(from.quant_table, from.quant_table + DCTSIZE2,
+                to.quant_table);
+      num_samples += static_cast<int64>(from.width_in_blocks) *
+                     from.height_in_blocks * DCTSIZE2;
+    }
+
+    const int channels =
+        channels_ == 0 ? gpu_image.num_components : channels_;
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0, TensorShape({height, width, channels}), &output));
+    Tensor coefficients;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DT_INT16, host_coefficients.shape(),
+                                          &coefficients));
+    Tensor samples;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DT_UINT8, TensorShape({num_samples}),
+                                          &samples));
+    CopyToDevice(context, host_coefficients, &coefficients);
+
+    const GPUDevice& d = context->eigen_device<GPUDevice>();
+    OP_REQUIRES(context,
+                functor::JpegInverseDct<GPUDevice>()(
+                    d, gpu_image, coefficients.flat<int16>().data(),
+                    samples.flat<uint8>().data()),
+                errors::Internal("Failed to launch JpegInverseDct."));
+    OP_REQUIRES(context,
+                functor::JpegColorConvert<GPUDevice>()(
+                    d, gpu_image, samples.flat<uint8>().data(), crop_y, crop_x,
+                    flags.fancy_upscaling, output->tensor<uint8, 3>()),
+                errors::Internal("Failed to launch JpegColorConvert."));
+    *decoded = true;
+  }
+
+  // Decodes the image on the host and copies it to the GPU.
+  void DecodeOnHost(OpKernelContext* context, StringPiece input,
+                    const jpeg::UncompressFlags& flags) {
+    AllocatorAttributes host_attr;
+    host_attr.set_on_host(true);
+    host_attr.set_gpu_compatible(true);
+    Tensor host_image;
+    OP_REQUIRES(
+        context,
+        jpeg::Uncompress(
+            input.data(), input.size(), flags, nullptr /* nwarn */,
+            [=, &host_image](int width, int height, int channels) -> uint8* {
+              Status status(context->allocate_temp(
+                  DT_UINT8, TensorShape({height, width, channels}),
+                  &host_image, host_attr));
+              if (!status.ok()) {
+                VLOG(1) << status;
+                context->SetStatus(status);
+                return nullptr;
+              }
+              return host_image.flat<uint8>().data();
+            }),
+        errors::InvalidArgument("Invalid JPEG data or crop window, data size ",
+                                input.size()));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, host_image.shape(), &output));
+    CopyToDevice(context, host_image, output);
+  }
+
+  bool crop_;
+  int channels_;
+  jpeg::UncompressFlags flags_;
+  int64 min_gpu_bytes_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("DecodeJpeg").Device(DEVICE_GPU).HostMemory("contents"),
+    DecodeJpegGpuOp);
+REGISTER_KERNEL_BUILDER(Name("DecodeAndCropJpeg")
+                            .Device(DEVICE_GPU)
+                            .HostMemory("contents")
+                            .HostMemory("crop_window"),
+                        DecodeJpegGpuOp);
+
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
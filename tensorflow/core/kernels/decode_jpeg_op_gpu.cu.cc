@@ -0,0 +1,203 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/kernels/decode_jpeg_op_gpu.h"
+
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/cuda_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+using functor::JpegComponent;
+using functor::JpegImage;
+using functor::kMaxJpegComponents;
+
+constexpr int kBlockSize = 8;
+
+__device__ uint8 ClampToUint8(float value) {
+  return static_cast<uint8>(fminf(fmaxf(roundf(value), 0.f), 255.f));
+}
+
+// Computes one sample of `component` from the 64 coefficients of its block,
+// with a direct evaluation of the 8x8 inverse DCT.
+__global__ void JpegInverseDctKernel(const int32 nthreads,
+                                     const JpegComponent component,
+                                     const int16* coefficients,
+                                     uint8* samples) {
+  const int pitch = component.width_in_blocks * kBlockSize;
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    const int x = index % pitch;
+    const int y = index / pitch;
+    const int16* block =
+        coefficients + component.coefficient_offset +
+        ((y / kBlockSize) * component.width_in_blocks + x / kBlockSize) *
+            kBlockSize * kBlockSize;
+
+    float cos_x[kBlockSize];
+    float cos_y[kBlockSize];
+    for (int u = 0; u < kBlockSize; ++u) {
+      const float scale = u == 0 ? 0.5f * M_SQRT1_2 : 0.5f;
+      cos_x[u] = scale * cospif((2 * (x % kBlockSize) + 1) * u / 16.f);
+      cos_y[u] = scale * cospif((2 * (y % kBlockSize) + 1) * u / 16.f);
+    }
+    float value = 128.f;
+    for (int v = 0; v < kBlockSize; ++v) {
+      float row = 0.f;
+      for (int u = 0; u < kBlockSize; ++u) {
+        const int i = v * kBlockSize + u;
+        row += cos_x[u] * block[i] * component.quant_table[i];
+      }
+      value += cos_y[v] * row;
+    }
+    samples[component.sample_offset + index] = ClampToUint8(value);
+  }
+}
+
+// Returns the value of `component` at pixel (y, x) of the image. With fancy
+// upsampling the subsampled components are interpolated linearly between
+// the centers of their samples, like libjpeg does for 2x subsampling,
+// otherwise the samples are replicated.
+__device__ float SampleComponent(const JpegImage& image,
+                                 const JpegComponent& component,
+                                 const uint8* samples, int y, int x,
+                                 bool fancy_upsampling) {
+  const int pitch = component.width_in_blocks * kBlockSize;
+  const uint8* plane = samples + component.sample_offset;
+  if (component.h_samp_factor == image.max_h_samp_factor &&
+      component.v_samp_factor == image.max_v_samp_factor) {
+    return plane[y * pitch + x];
+  }
+  if (!fancy_upsampling) {
+    return plane[(y * component.v_samp_factor / image.max_v_samp_factor) *
+                     pitch +
+                 x * component.h_samp_factor / image.max_h_samp_factor];
+  }
+  const float in_x = fmaxf(
+      (x + 0.5f) * component.h_samp_factor / image.max_h_samp_factor - 0.5f,
+      0.f);
+  const float in_y = fmaxf(
+      (y + 0.5f) * component.v_samp_factor / image.max_v_samp_factor - 0.5f,
+      0.f);
+  const int left = static_cast<int>(in_x);
+  const int top = static_cast<int>(in_y);
+  const int right = min(left + 1, component.width - 1);
+  const int bottom = min(top + 1, component.height - 1);
+  const float x_lerp = in_x - left;
+  const float y_lerp = in_y - top;
+  const float top_value =
+      plane[top * pitch + left] +
+      (plane[top * pitch + right] - plane[top * pitch + left]) * x_lerp;
+  const float bottom_value =
+      plane[bottom * pitch + left] +
+      (plane[bottom * pitch + right] - plane[bottom * pitch + left]) * x_lerp;
+  return top_value + (bottom_value - top_value) * y_lerp;
+}
+
+__global__ void JpegColorConvertKernel(const int32 nthreads,
+                                       const JpegImage image,
+                                       const uint8* samples, int crop_y,
+                                       int crop_x, int crop_width,
+                                       int channels, bool fancy_upsampling,
+                                       uint8* output) {
+  CUDA_1D_KERNEL_LOOP(index, nthreads) {
+    const int y = crop_y + index / crop_width;
+    const int x = crop_x + index % crop_width;
+    uint8* pixel = output + index * channels;
+
+    float values[kMaxJpegComponents];
+    // A grayscale output of a YCbCr image is the luma component.
+    const int num_components =
+        image.ycbcr && channels == 1 ? 1 : image.num_components;
+    for (int c = 0; c < num_components; ++c) {
+      values[c] = SampleComponent(image, image.components[c], samples, y, x,
+                                  fancy_upsampling);
+    }
+    if (num_components == 1) {
+      for (int c = 0; c < channels; ++c) pixel[c] = ClampToUint8(values[0]);
+      continue;
+    }
+
+    float red = values[0];
+    float green = values[1];
+    float blue = values[2];
+    if (image.ycbcr) {
+      const float cb = values[1] - 128.f;
+      const float cr = values[2] - 128.f;
+      red = values[0] + 1.402f * cr;
+      green = values[0] - 0.344136f * cb - 0.714136f * cr;
+      blue = values[0] + 1.772f * cb;
+    }
+    if (channels == 1) {
+      pixel[0] = ClampToUint8(0.299f * red + 0.587f * green + 0.114f * blue);
+    } else {
+      pixel[0] = ClampToUint8(red);
+      pixel[1] = ClampToUint8(green);
+      pixel[2] = ClampToUint8(blue);
+    }
+  }
+}
+
+}  // namespace
+
+namespace functor {
+
+template <>
+bool JpegInverseDct<GPUDevice>::operator()(const GPUDevice& d,
+                                          const JpegImage& image,
+                                          const int16* coefficients,
+                                          uint8* samples) {
+  for (int c = 0; c < image.num_components; ++c) {
+    const JpegComponent& component = image.components[c];
+    const int total_count = component.width_in_blocks *
+                            component.height_in_blocks * kBlockSize *
+                            kBlockSize;
+    if (total_count == 0) continue;
+    CudaLaunchConfig config = GetCudaLaunchConfig(total_count, d);
+    JpegInverseDctKernel<<<config.block_count, config.thread_per_block, 0,
+                           d.stream()>>>(config.virtual_thread_count,
+                                         component, coefficients, samples);
+  }
+  return d.ok();
+}
+
+template <>
+bool JpegColorConvert<GPUDevice>::operator()(
+    const GPUDevice& d, const JpegImage& image, const uint8* samples,
+    int crop_y, int crop_x, bool fancy_upsampling,
+    typename TTypes<uint8, 3>::Tensor output) {
+  const int total_count = output.dimension(0) * output.dimension(1);
+  if (total_count == 0) return true;
+  CudaLaunchConfig config = GetCudaLaunchConfig(total_count, d);
+  JpegColorConvertKernel<<<config.block_count, config.thread_per_block, 0,
+                           d.stream()>>>(
+      config.virtual_thread_count, image, samples, crop_y, crop_x,
+      output.dimension(1), output.dimension(2), fancy_upsampling,
+      output.data());
+  return d.ok();
+}
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
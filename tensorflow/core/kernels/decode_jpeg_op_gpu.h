@@ -0,0 +1,77 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_DECODE_JPEG_OP_GPU_H_
+#define TENSORFLOW_CORE_KERNELS_DECODE_JPEG_OP_GPU_H_
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace functor {
+
+// The maximum number of components of the JPEG images decoded on the GPU.
+constexpr int kMaxJpegComponents = 3;
+
+// One component of a JPEG image whose entropy decoding was done on the host.
+struct JpegComponent {
+  int h_samp_factor;
+  int v_samp_factor;
+  // Size of the component in samples and in 8x8 blocks.
+  int width;
+  int height;
+  int width_in_blocks;
+  int height_in_blocks;
+  // Index of the first coefficient of the component in the coefficients.
+  int64 coefficient_offset;
+  // Index of the first sample of the component in the samples, which are
+  // stored with a row pitch of 8 * width_in_blocks.
+  int64 sample_offset;
+  // Quantization table, in natural order.
+  uint16 quant_table[64];
+};
+
+struct JpegImage {
+  int num_components;
+  int max_h_samp_factor;
+  int max_v_samp_factor;
+  // Whether the components are YCbCr rather than grayscale or RGB.
+  bool ycbcr;
+  JpegComponent components[kMaxJpegComponents];
+};
+
+// Dequantizes the DCT coefficients of all the components of `image`, and
+// inverse transforms them into 8-bit samples.
+template <typename Device>
+struct JpegInverseDct {
+  bool operator()(const Device& d, const JpegImage& image,
+                  const int16* coefficients, uint8* samples);
+};
+
+// Upsamples the components of the window of `image` starting at
+// (`crop_y`, `crop_x`), and converts them to a grayscale or RGB `output`.
+template <typename Device>
+struct JpegColorConvert {
+  bool operator()(const Device& d, const JpegImage& image,
+                  const uint8* samples, int crop_y, int crop_x,
+                  bool fancy_upsampling,
+                  typename TTypes<uint8, 3>::Tensor output);
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DECODE_JPEG_OP_GPU_H_
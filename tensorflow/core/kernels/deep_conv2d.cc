@@ -22,6 +22,8 @@ limitations under the License.
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/winograd_transform.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -90,6 +92,47 @@ static bool ReadBoolFromEnvVar(const char* env_var_name, bool default_val) {
   return default_val;
 }
 
+// Reads environment variable 'env_var_name' as an integer.
+// Returns 'default_val' if it is not set or not an integer.
+static int64 ReadIntFromEnvVar(const char* env_var_name, int64 default_val) {
+  const char* tf_env_var_val = getenv(env_var_name);
+  int64 value;
+  if (tf_env_var_val != nullptr &&
+      strings::safe_strto64(tf_env_var_val, &value)) {
+    return value;
+  }
+  return default_val;
+}
+
+// Returns the cost of a deep convolution using a Winograd transform with
+// 'out_tile_size' x 'out_tile_size' output tiles of a 3x3 filter.
+static int64 GetWinogradConvCost(int64 out_tile_size, int in_depth,
+                                 int out_depth, int out_rows, int out_cols) {
+  const int input_tile_size = out_tile_size + 2;
+  return GetDeepConvCost(input_tile_size, input_tile_size, out_tile_size,
+                         out_tile_size, in_depth, out_depth, out_rows,
+                         out_cols);
+}
+
+// Returns the output tile size of the Winograd transform used by DeepConv2D:
+// 2 for F(2x2, 3x3) or 4 for F(4x4, 3x3). The environment variable
+// TF_DEEP_CONV2D_OUTPUT_TILE selects one of them; otherwise (or for other
+// values) the transform with the lower cost is used. F(4x4, 3x3) needs fewer
+// products per output, but has larger input and output transforms, so its
+// cost is lower for deeper convolutions.
+static int64 GetWinogradOutputTileSize(int in_depth, int out_depth,
+                                       int out_rows, int out_cols) {
+  const int64 tile_size = ReadIntFromEnvVar("TF_DEEP_CONV2D_OUTPUT_TILE", 0);
+  if (tile_size == 2 || tile_size == 4) {
+    return tile_size;
+  }
+  return GetWinogradConvCost(4, in_depth, out_depth, out_rows, out_cols) <
+                 GetWinogradConvCost(2, in_depth, out_depth, out_rows,
+                                     out_cols)
+             ? 4
+             : 2;
+}
+
 // Returns true if convolution can be computed efficiently by DeepConv2D,
 // returns false otherwise.
 // TODO(andydavis) Add support for other filter sizes and strides.
@@ -111,14 +154,15 @@ bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
   }
 
   // Check if flop cost of deep convolution is less than direct convolution.
-  WinogradTransform<float> t;
-  const int64 deep_conv_cost = GetDeepConvCost(
-      t.input_shape().rows, t.input_shape().cols, t.output_shape().rows,
-      t.output_shape().cols, in_depth, out_depth, out_rows, out_cols);
+  const int64 out_tile_size =
+      GetWinogradOutputTileSize(in_depth, out_depth, out_rows, out_cols);
+  const int64 deep_conv_cost = GetWinogradConvCost(
+      out_tile_size, in_depth, out_depth, out_rows, out_cols);
   const int64 direct_conv_cost = GetDirectConvCost(
       filter_rows, filter_cols, in_depth, out_depth, out_rows, out_cols);
 
   VLOG(2) << "CanUseDeepConv2D"
+          << " out_tile_size: " << out_tile_size
           << " deep_conv_cost: " << deep_conv_cost
           << " direct_conv_cost: " << direct_conv_cost << " deep_direct_ratio: "
           << (static_cast<float>(deep_conv_cost) /
@@ -127,6 +171,32 @@ bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
   return deep_conv_cost < direct_conv_cost;
 }
 
+bool DeepConv2DFilterCache::Key::operator==(const Key& other) const {
+  return data == other.data && fingerprint == other.fingerprint &&
+         out_tile_size == other.out_tile_size &&
+         filter_rows == other.filter_rows &&
+         filter_cols == other.filter_cols && in_depth == other.in_depth &&
+         out_depth == other.out_depth;
+}
+
+bool DeepConv2DFilterCache::Lookup(const Key& key,
+                                   std::vector<Tensor>* packed_filters) const {
+  mutex_lock l(mu_);
+  if (!valid_ || !(key_ == key)) {
+    return false;
+  }
+  *packed_filters = packed_filters_;
+  return true;
+}
+
+void DeepConv2DFilterCache::Insert(const Key& key,
+                                   const std::vector<Tensor>& packed_filters) {
+  mutex_lock l(mu_);
+  valid_ = true;
+  key_ = key;
+  packed_filters_ = packed_filters;
+}
+
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
 // Copies data from 'filter_in' to 'filter_buf' along 'in_depth' dimension.
@@ -922,7 +992,9 @@ namespace functor {
 // Conv2D operation specialized for deep convolutions (i.e. large
 // in_depth * out_depth).
 // Details:
-// *) Transforms and packs filters from 'filter' in parallel.
+// *) Selects the F(2x2, 3x3) or F(4x4, 3x3) Winograd transform.
+// *) Transforms and packs filters from 'filter' in parallel, unless
+//    'filter_cache' holds them from a previous call.
 // *) Computes Conv2D parallelized across 'batch' dimension.
 //   *) Each thread loops over images in its batch shard, copying 'num_tiles'
 //      input tiles into a local buffer, and computing the Conv2D output of
@@ -936,9 +1008,16 @@ namespace functor {
 template <typename T>
 struct DeepConv2D<CPUDevice, T> {
   void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
-                  const T* filter, T* output) {
-    // TODO(andydavis) Add function to select transform based on conv params.
-    std::unique_ptr<DeepConv2DTransform<T>> transform(new WinogradTransform<T>);
+                  const T* filter, T* output,
+                  DeepConv2DFilterCache* filter_cache) {
+    const int64 transform_out_tile_size = GetWinogradOutputTileSize(
+        args.in_depth, args.out_depth, args.out_rows, args.out_cols);
+    std::unique_ptr<DeepConv2DTransform<T>> transform;
+    if (transform_out_tile_size == 4) {
+      transform.reset(new Winograd4x4Transform<T>);
+    } else {
+      transform.reset(new WinogradTransform<T>);
+    }
 
     const int64 in_depth = args.in_depth;
     const int64 out_depth = args.out_depth;
@@ -961,24 +1040,46 @@ struct DeepConv2D<CPUDevice, T> {
         std::max(int64{0}, args.filter_cols - base_filter_rows);
     const int64 filter_shards_col = 1 + (filter_residual_col + 2 - 1) / 2;
 
-    // Allocate buffer for transformed filters.
-    Tensor filter_transform;
-    OP_REQUIRES_OK(
-        ctx, ctx->allocate_temp(
-                 DataTypeToEnum<T>::value,
-                 TensorShape({tile_rows, tile_cols, out_depth,
-                              filter_shards_row, filter_shards_col, in_depth}),
-                 &filter_transform));
-    T* filter_transform_data = filter_transform.template flat<T>().data();
-
-    // Transform filters.
-    TransformFilters<T>()(ctx, args, transform.get(), filter_shards_row,
-                          filter_shards_col, filter, filter_transform_data);
-
-    // Pack filters.
-    std::vector<Tensor> packed_filters(tile_spatial_size);
-    PackFilters<T>()(ctx, args, tile_spatial_size, filter_shards_row,
-                     filter_shards_col, filter_transform_data, &packed_filters);
+    std::vector<Tensor> packed_filters;
+    DeepConv2DFilterCache::Key filter_key;
+    if (filter_cache != nullptr) {
+      const int64 filter_size =
+          args.filter_rows * args.filter_cols * in_depth * out_depth;
+      filter_key.data = filter;
+      filter_key.fingerprint = Hash64(reinterpret_cast<const char*>(filter),
+                                      filter_size * sizeof(T));
+      filter_key.out_tile_size = out_tile_rows;
+      filter_key.filter_rows = args.filter_rows;
+      filter_key.filter_cols = args.filter_cols;
+      filter_key.in_depth = args.in_depth;
+      filter_key.out_depth = args.out_depth;
+    }
+    if (filter_cache == nullptr ||
+        !filter_cache->Lookup(filter_key, &packed_filters)) {
+      // Allocate buffer for transformed filters.
+      Tensor filter_transform;
+      OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                              DataTypeToEnum<T>::value,
+                              TensorShape({tile_rows, tile_cols, out_depth,
+                                           filter_shards_row,
+                                           filter_shards_col, in_depth}),
+                              &filter_transform));
+      T* filter_transform_data = filter_transform.template flat<T>().data();
+
+      // Transform filters.
+      TransformFilters<T>()(ctx, args, transform.get(), filter_shards_row,
+                            filter_shards_col, filter, filter_transform_data);
+
+      // Pack filters.
+      packed_filters.resize(tile_spatial_size);
+      PackFilters<T>()(ctx, args, tile_spatial_size, filter_shards_row,
+                       filter_shards_col, filter_transform_data,
+                       &packed_filters);
+      if (!ctx->status().ok()) return;
+      if (filter_cache != nullptr) {
+        filter_cache->Insert(filter_key, packed_filters);
+      }
+    }
 
     // Allocate buffer for tile transform matrix.
     Tensor tile_transform_matrix_tensor;
@@ -16,7 +16,12 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_DEEP_CONV2D_H_
 #define TENSORFLOW_CORE_KERNELS_DEEP_CONV2D_H_
 
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
@@ -101,13 +106,49 @@ bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
                       int filter_cols, int in_depth, int out_depth,
                       int out_rows, int out_cols);
 
+// Holds the filters of a Conv2D kernel transformed and packed by DeepConv2D,
+// so that a kernel whose filter does not change between steps (e.g. the
+// constant weights of an inference graph) transforms it only once. The filter
+// is identified by its address, shape and a fingerprint of its contents, so
+// in-place updates of a variable filter are detected. Thread-safe.
+class DeepConv2DFilterCache {
+ public:
+  struct Key {
+    const void* data = nullptr;
+    uint64 fingerprint = 0;
+    int64 out_tile_size = 0;
+    int filter_rows = 0;
+    int filter_cols = 0;
+    int in_depth = 0;
+    int out_depth = 0;
+
+    bool operator==(const Key& other) const;
+  };
+
+  // Returns true and sets '*packed_filters' if the cache holds the packed
+  // filters for 'key'.
+  bool Lookup(const Key& key, std::vector<Tensor>* packed_filters) const;
+
+  // Replaces the cached filters with 'packed_filters' for 'key'.
+  void Insert(const Key& key, const std::vector<Tensor>& packed_filters);
+
+ private:
+  mutable mutex mu_;
+  bool valid_ GUARDED_BY(mu_) = false;
+  Key key_ GUARDED_BY(mu_);
+  std::vector<Tensor> packed_filters_ GUARDED_BY(mu_);
+};
+
 namespace functor {
 
 // Calls DeepConv2D implementation (see deep_conv2d.cc for details).
+// If 'filter_cache' is not null, it is used to reuse the transformed filters
+// of a previous call with the same filter.
 template <typename Device, typename T>
 struct DeepConv2D {
   void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
-                  const T* filter, T* output);
+                  const T* filter, T* output,
+                  DeepConv2DFilterCache* filter_cache = nullptr);
 };
 
 }  // namespace functor
@@ -155,5 +155,109 @@ TEST(DeepConv2DTransformTest, WingradOutputTransformMatrix) {
   }
 }
 
+TEST(DeepConv2DTransformTest, Winograd4x4FilterTransformMatrix) {
+  // Test that the filter transform matrix returned is the kronecker product of
+  // the following matrix with itself:
+  //
+  //   [ 1/4     0     0   ]
+  //   [ -1/6  -1/6  -1/6  ]
+  //   [ -1/6   1/6  -1/6  ]
+  //   [ 1/24   1/12  1/6  ]
+  //   [ 1/24  -1/12  1/6  ]
+  //   [ 0      0     1    ]
+  //
+  const int rows = 6;
+  const int cols = 3;
+
+  float transform_matrix[] = {1.0f / 4,  0,          0,        -1.0f / 6,
+                              -1.0f / 6, -1.0f / 6,  -1.0f / 6, 1.0f / 6,
+                              -1.0f / 6, 1.0f / 24,  1.0f / 12, 1.0f / 6,
+                              1.0f / 24, -1.0f / 12, 1.0f / 6,  0,
+                              0,         1};
+
+  const int kron_rows = rows * rows;
+  const int kron_cols = cols * cols;
+
+  float transform_matrix_kron[kron_rows * kron_cols];
+
+  ComputeKroneckerProduct(rows, cols, &transform_matrix[0],
+                          &transform_matrix_kron[0]);
+
+  float transform_matrix_test[kron_rows * kron_cols];
+  Winograd4x4Transform<float> t;
+  t.GetFilterTransformMatrix(kron_rows, kron_cols, &transform_matrix_test[0]);
+
+  for (int i = 0; i < kron_rows * kron_cols; ++i) {
+    EXPECT_FLOAT_EQ(transform_matrix_kron[i], transform_matrix_test[i]);
+  }
+}
+
+TEST(DeepConv2DTransformTest, Winograd4x4InputTransformMatrix) {
+  // Test that the input transform matrix returned is the kronecker product of
+  // the following matrix:
+  //
+  //   [4   0  -5   0   1   0]
+  //   [0  -4  -4   1   1   0]
+  //   [0   4  -4  -1   1   0]
+  //   [0  -2  -1   2   1   0]
+  //   [0   2  -1  -2   1   0]
+  //   [0   4   0  -5   0   1]
+  //
+  const int rows = 6;
+  const int cols = 6;
+
+  float transform_matrix[] = {4, 0,  -5, 0,  1, 0, 0, -4, -4, 1,  1, 0,
+                              0, 4,  -4, -1, 1, 0, 0, -2, -1, 2,  1, 0,
+                              0, 2,  -1, -2, 1, 0, 0, 4,  0,  -5, 0, 1};
+
+  const int kron_rows = rows * rows;
+  const int kron_cols = cols * cols;
+
+  float transform_matrix_kron[kron_rows * kron_cols];
+
+  ComputeKroneckerProduct(rows, cols, &transform_matrix[0],
+                          &transform_matrix_kron[0]);
+
+  float transform_matrix_test[kron_rows * kron_cols];
+  Winograd4x4Transform<float> t;
+  t.GetInputTransformMatrix(kron_rows, kron_cols, &transform_matrix_test[0]);
+
+  for (int i = 0; i < kron_rows * kron_cols; ++i) {
+    EXPECT_FLOAT_EQ(transform_matrix_kron[i], transform_matrix_test[i]);
+  }
+}
+
+TEST(DeepConv2DTransformTest, Winograd4x4OutputTransformMatrix) {
+  // Test that the output transform matrix returned is the kronecker product
+  // of the following matrix:
+  //
+  //   [1  1  1  1  1  0]
+  //   [0  1 -1  2 -2  0]
+  //   [0  1  1  4  4  0]
+  //   [0  1 -1  8 -8  1]
+  //
+  const int rows = 4;
+  const int cols = 6;
+
+  float transform_matrix[] = {1, 1, 1, 1, 1, 0, 0, 1, -1, 2, -2, 0,
+                              0, 1, 1, 4, 4, 0, 0, 1, -1, 8, -8, 1};
+
+  const int kron_rows = rows * rows;
+  const int kron_cols = cols * cols;
+
+  float transform_matrix_kron[kron_rows * kron_cols];
+
+  ComputeKroneckerProduct(rows, cols, &transform_matrix[0],
+                          &transform_matrix_kron[0]);
+
+  float transform_matrix_test[kron_rows * kron_cols];
+  Winograd4x4Transform<float> t;
+  t.GetOutputTransformMatrix(kron_rows, kron_cols, &transform_matrix_test[0]);
+
+  for (int i = 0; i < kron_rows * kron_cols; ++i) {
+    EXPECT_FLOAT_EQ(transform_matrix_kron[i], transform_matrix_test[i]);
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
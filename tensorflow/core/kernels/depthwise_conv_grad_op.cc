@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/conv_grad_ops.h"
 #include "tensorflow/core/kernels/depthwise_conv_op.h"
+#include "tensorflow/core/kernels/depthwise_conv_specialized.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
@@ -381,6 +382,33 @@ struct LaunchDepthwiseConvBackpropInputOp<CPUDevice, T> {
 
     static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
 
+    if (depthwise_specialized::IsSupported(args)) {
+      // Computes one shard of 'in_backprop' rows with the kernel specialized
+      // for the filter size and stride, which needs no padded copies.
+      auto specialized_shard = [&args, out_backprop, depthwise_filter,
+                                in_backprop](int64 start, int64 limit) {
+        const int64 input_image_size =
+            args.in_rows * args.in_cols * args.in_depth;
+        const int64 output_image_size =
+            args.out_rows * args.out_cols * args.out_depth;
+        for (int64 i = start; i < limit; ++i) {
+          const int64 b = i / args.in_rows;
+          depthwise_specialized::Dispatch<
+              depthwise_specialized::DepthwiseConv2DBackpropInputKernel, T>(
+              args, out_backprop + b * output_image_size, depthwise_filter,
+              static_cast<int>(i % args.in_rows),
+              in_backprop + b * input_image_size);
+        }
+      };
+      const int64 shard_cost = args.in_cols * args.out_depth *
+                               args.filter_rows * args.filter_cols /
+                               (args.stride * args.stride);
+      auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+      Shard(worker_threads.num_threads, worker_threads.workers,
+            args.batch * args.in_rows, shard_cost, specialized_shard);
+      return;
+    }
+
     // Pad 'depthwise_filter' to vector register width (if needed).
     const bool pad_filter = (args.out_depth % kPacketSize) == 0 ? false : true;
     Tensor padded_filter;
@@ -849,21 +877,26 @@ struct LaunchDepthwiseConvBackpropFilterOp<CPUDevice, T> {
     T* output_buffer_data = output_buffer.template flat<T>().data();
 
     // Computes one shard of depthwise conv2d backprop filter.
-    auto shard = [&ctx, &args, &out_backprop, &input, &output_buffer_data](
-                     int64 start, int64 limit) {
+    const bool specialized = depthwise_specialized::IsSupported(args);
+    auto shard = [&ctx, &args, &out_backprop, &input, &output_buffer_data,
+                  specialized](int64 start, int64 limit) {
       static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
       const int64 filter_spatial_size = args.filter_rows * args.filter_cols;
       const int64 padded_out_depth_size =
           ((args.out_depth + kPacketSize - 1) / kPacketSize) * kPacketSize;
 
-      // Allocate buffer for local input regions.
+      // Allocate buffer for local input regions, which the specialized
+      // kernels do not need.
       Tensor input_buffer;
-      OP_REQUIRES_OK(
-          ctx, ctx->allocate_temp(
-                   DataTypeToEnum<T>::value,
-                   TensorShape({filter_spatial_size, padded_out_depth_size}),
-                   &input_buffer));
-      T* input_buffer_data = input_buffer.template flat<T>().data();
+      T* input_buffer_data = nullptr;
+      if (!specialized) {
+        OP_REQUIRES_OK(
+            ctx, ctx->allocate_temp(
+                     DataTypeToEnum<T>::value,
+                     TensorShape({filter_spatial_size, padded_out_depth_size}),
+                     &input_buffer));
+        input_buffer_data = input_buffer.template flat<T>().data();
+      }
 
       const int64 input_image_size =
           args.in_rows * args.in_cols * args.in_depth;
@@ -877,6 +910,15 @@ struct LaunchDepthwiseConvBackpropFilterOp<CPUDevice, T> {
         auto* output_buffer = output_buffer_data + b * padded_filter_size;
         memset(output_buffer, 0, padded_filter_size * sizeof(T));
 
+        if (specialized) {
+          depthwise_specialized::Dispatch<
+              depthwise_specialized::DepthwiseConv2DBackpropFilterKernel, T>(
+              args, out_backprop + b * output_image_size,
+              input + b * input_image_size, padded_out_depth_size,
+              output_buffer);
+          continue;
+        }
+
         for (int out_r = 0; out_r < args.out_rows; ++out_r) {
           for (int out_c = 0; out_c < args.out_cols; ++out_c) {
             // Populate 'input_buffer_data' with data from local input region.
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/conv_ops.h"
 #include "tensorflow/core/kernels/depthwise_conv_op.h"
+#include "tensorflow/core/kernels/depthwise_conv_specialized.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
@@ -163,6 +164,41 @@ struct LaunchDepthwiseConvOp<CPUDevice, T> {
             "Depthwise convolution on CPU is only supported for NHWC format"));
     static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
 
+    const int64 total_shards = args.batch * args.out_rows;
+
+    // Empirically tested to give reasonable performance boosts at batch size 1
+    // without reducing throughput at batch size 32.
+    const float kCostMultiplier = 2.5f;
+
+    // TODO(andydavis): Estimate shard cost (in cycles) based on the number of
+    // flops/loads/stores required to compute one shard.
+    const int64 shard_cost = kCostMultiplier * args.out_cols * args.out_depth;
+
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+
+    if (depthwise_specialized::IsSupported(args)) {
+      // Computes one shard of output rows with the kernel specialized for
+      // the filter size and stride, which needs no padded copies.
+      auto specialized_shard = [&args, input, depthwise_filter, output](
+                                   int64 start, int64 limit) {
+        const int64 input_image_size =
+            args.in_rows * args.in_cols * args.in_depth;
+        const int64 output_image_size =
+            args.out_rows * args.out_cols * args.out_depth;
+        for (int64 i = start; i < limit; ++i) {
+          const int64 b = i / args.out_rows;
+          depthwise_specialized::Dispatch<
+              depthwise_specialized::DepthwiseConv2DKernel, T>(
+              args, input + b * input_image_size, depthwise_filter,
+              static_cast<int>(i % args.out_rows),
+              output + b * output_image_size);
+        }
+      };
+      Shard(worker_threads.num_threads, worker_threads.workers, total_shards,
+            shard_cost, specialized_shard);
+      return;
+    }
+
     // Pad 'depthwise_filter' to vector register width (if needed).
     const bool pad_filter = (args.out_depth % kPacketSize) == 0 ? false : true;
     Tensor padded_filter;
@@ -225,17 +261,6 @@ struct LaunchDepthwiseConvOp<CPUDevice, T> {
       }
     };
 
-    const int64 total_shards = args.batch * args.out_rows;
-
-    // Empirically tested to give reasonable performance boosts at batch size 1
-    // without reducing throughput at batch size 32.
-    const float kCostMultiplier = 2.5f;
-
-    // TODO(andydavis): Estimate shard cost (in cycles) based on the number of
-    // flops/loads/stores required to compute one shard.
-    const int64 shard_cost = kCostMultiplier * args.out_cols * args.out_depth;
-
-    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
     Shard(worker_threads.num_threads, worker_threads.workers, total_shards,
           shard_cost, shard);
   }
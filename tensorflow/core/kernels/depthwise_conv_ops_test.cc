@@ -13,6 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/cc/ops/const_op.h"
 #include "tensorflow/cc/ops/image_ops.h"
 #include "tensorflow/cc/ops/nn_ops.h"
@@ -110,5 +113,139 @@ TEST_F(DepthwiseConvOpTest, DepthwiseConvHalfGpu) {
 }
 #endif
 
+// Checks the CPU kernels specialized for a depth multiplier of 1, a 3x3 or
+// 5x5 filter and a stride of 1 or 2 against a naive implementation.
+class DepthwiseConvSpecializedTest : public OpsTestBase {
+ protected:
+  enum class Op { kForward, kBackpropInput, kBackpropFilter };
+
+  void Run(Op op, int filter_size, int stride, const string& padding) {
+    const int batch = 2, in_rows = 7, in_cols = 9, depth = 11;
+    const bool same = padding == "SAME";
+    const int out_rows =
+        same ? (in_rows + stride - 1) / stride
+             : (in_rows - filter_size) / stride + 1;
+    const int out_cols =
+        same ? (in_cols + stride - 1) / stride
+             : (in_cols - filter_size) / stride + 1;
+    const int pad_rows =
+        same ? std::max(0, (out_rows - 1) * stride + filter_size - in_rows) / 2
+             : 0;
+    const int pad_cols =
+        same ? std::max(0, (out_cols - 1) * stride + filter_size - in_cols) / 2
+             : 0;
+
+    Tensor input(DT_FLOAT, {batch, in_rows, in_cols, depth});
+    Tensor filter(DT_FLOAT, {filter_size, filter_size, depth, 1});
+    Tensor out_backprop(DT_FLOAT, {batch, out_rows, out_cols, depth});
+    // Small integers keep the sums exact.
+    for (Tensor* t : {&input, &filter, &out_backprop}) {
+      auto flat = t->flat<float>();
+      for (int i = 0; i < flat.size(); ++i) flat(i) = (i * 7 + 3) % 5 - 2;
+    }
+
+    // Accumulates the forward pass and both backprops at once.
+    Tensor output(DT_FLOAT, out_backprop.shape());
+    Tensor in_backprop(DT_FLOAT, input.shape());
+    Tensor filter_backprop(DT_FLOAT, filter.shape());
+    output.flat<float>().setZero();
+    in_backprop.flat<float>().setZero();
+    filter_backprop.flat<float>().setZero();
+    auto in = input.tensor<float, 4>();
+    auto f = filter.tensor<float, 4>();
+    auto out_bp = out_backprop.tensor<float, 4>();
+    for (int b = 0; b < batch; ++b) {
+      for (int r = 0; r < out_rows; ++r) {
+        for (int c = 0; c < out_cols; ++c) {
+          for (int fr = 0; fr < filter_size; ++fr) {
+            for (int fc = 0; fc < filter_size; ++fc) {
+              const int in_r = r * stride - pad_rows + fr;
+              const int in_c = c * stride - pad_cols + fc;
+              if (in_r < 0 || in_r >= in_rows || in_c < 0 || in_c >= in_cols) {
+                continue;
+              }
+              for (int d = 0; d < depth; ++d) {
+                output.tensor<float, 4>()(b, r, c, d) +=
+                    in(b, in_r, in_c, d) * f(fr, fc, d, 0);
+                in_backprop.tensor<float, 4>()(b, in_r, in_c, d) +=
+                    out_bp(b, r, c, d) * f(fr, fc, d, 0);
+                filter_backprop.tensor<float, 4>()(fr, fc, d, 0) +=
+                    out_bp(b, r, c, d) * in(b, in_r, in_c, d);
+              }
+            }
+          }
+        }
+      }
+    }
+
+    const char* op_names[] = {"DepthwiseConv2dNative",
+                              "DepthwiseConv2dNativeBackpropInput",
+                              "DepthwiseConv2dNativeBackpropFilter"};
+    NodeDefBuilder builder("depthwise", op_names[static_cast<int>(op)]);
+    builder.Input(FakeInput(op == Op::kBackpropInput ? DT_INT32 : DT_FLOAT))
+        .Input(FakeInput(op == Op::kBackpropFilter ? DT_INT32 : DT_FLOAT));
+    if (op != Op::kForward) builder.Input(FakeInput(DT_FLOAT));
+    TF_ASSERT_OK(builder.Attr("T", DT_FLOAT)
+                     .Attr("strides", {1, stride, stride, 1})
+                     .Attr("padding", padding)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    auto add_sizes = [this](const Tensor& t) {
+      std::vector<int32> sizes(t.shape().dim_sizes().begin(),
+                               t.shape().dim_sizes().end());
+      AddInputFromArray<int32>(TensorShape({4}), sizes);
+    };
+    const Tensor* expected = nullptr;
+    switch (op) {
+      case Op::kForward:
+        AddInputFromArray<float>(input.shape(), input.flat<float>());
+        AddInputFromArray<float>(filter.shape(), filter.flat<float>());
+        expected = &output;
+        break;
+      case Op::kBackpropInput:
+        add_sizes(input);
+        AddInputFromArray<float>(filter.shape(), filter.flat<float>());
+        AddInputFromArray<float>(out_backprop.shape(),
+                                 out_backprop.flat<float>());
+        expected = &in_backprop;
+        break;
+      case Op::kBackpropFilter:
+        AddInputFromArray<float>(input.shape(), input.flat<float>());
+        add_sizes(filter);
+        AddInputFromArray<float>(out_backprop.shape(),
+                                 out_backprop.flat<float>());
+        expected = &filter_backprop;
+        break;
+    }
+    TF_ASSERT_OK(RunOpKernel());
+    test::ExpectTensorNear<float>(*expected, *GetOutput(0), 1e-4);
+  }
+};
+
+TEST_F(DepthwiseConvSpecializedTest, Forward3x3Stride1) {
+  Run(Op::kForward, 3, 1, "SAME");
+}
+TEST_F(DepthwiseConvSpecializedTest, Forward3x3Stride2) {
+  Run(Op::kForward, 3, 2, "SAME");
+}
+TEST_F(DepthwiseConvSpecializedTest, Forward5x5Stride2Valid) {
+  Run(Op::kForward, 5, 2, "VALID");
+}
+TEST_F(DepthwiseConvSpecializedTest, BackpropInput3x3Stride2) {
+  Run(Op::kBackpropInput, 3, 2, "SAME");
+}
+TEST_F(DepthwiseConvSpecializedTest, BackpropInput5x5Stride1) {
+  Run(Op::kBackpropInput, 5, 1, "SAME");
+}
+TEST_F(DepthwiseConvSpecializedTest, BackpropInput5x5Stride2Valid) {
+  Run(Op::kBackpropInput, 5, 2, "VALID");
+}
+TEST_F(DepthwiseConvSpecializedTest, BackpropFilter3x3Stride1) {
+  Run(Op::kBackpropFilter, 3, 1, "SAME");
+}
+TEST_F(DepthwiseConvSpecializedTest, BackpropFilter5x5Stride2) {
+  Run(Op::kBackpropFilter, 5, 2, "SAME");
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,281 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// CPU kernels for the depthwise convolutions of MobileNet-style models: a
+// depth multiplier of 1, a square 3x3 or 5x5 filter and a stride of 1 or 2.
+// The filter size and stride are template parameters, so the loops over the
+// filter taps are unrolled, and the kernels read the input in place instead
+// of first copying each patch to a padded buffer, as the generic kernels do.
+
+#ifndef TENSORFLOW_CORE_KERNELS_DEPTHWISE_CONV_SPECIALIZED_H_
+#define TENSORFLOW_CORE_KERNELS_DEPTHWISE_CONV_SPECIALIZED_H_
+
+#include <algorithm>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/kernels/depthwise_conv_op.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace depthwise_specialized {
+
+// Returns true if there are specialized kernels for the convolution `args`,
+// which must be in the NHWC format.
+inline bool IsSupported(const DepthwiseArgs& args) {
+  return args.depth_multiplier == 1 &&
+         args.filter_rows == args.filter_cols &&
+         (args.filter_rows == 3 || args.filter_rows == 5) &&
+         (args.stride == 1 || args.stride == 2);
+}
+
+// Calls Kernel<T, filter size, stride>::Run(args, kernel_args...).
+//
+// REQUIRES: IsSupported(args)
+template <template <typename, int, int> class Kernel, typename T,
+          typename... KernelArgs>
+void Dispatch(const DepthwiseArgs& args, KernelArgs... kernel_args) {
+  if (args.filter_rows == 3) {
+    if (args.stride == 1) {
+      Kernel<T, 3, 1>::Run(args, kernel_args...);
+    } else {
+      Kernel<T, 3, 2>::Run(args, kernel_args...);
+    }
+  } else {
+    if (args.stride == 1) {
+      Kernel<T, 5, 1>::Run(args, kernel_args...);
+    } else {
+      Kernel<T, 5, 2>::Run(args, kernel_args...);
+    }
+  }
+}
+
+// Sets [*begin, *end) to the taps of a filter of size kFilterSize, whose
+// first tap is at `start` in a dimension of size `size`, that fall inside
+// the dimension.
+template <int kFilterSize>
+inline void ValidTaps(int start, int size, int* begin, int* end) {
+  *begin = std::max(0, -start);
+  *end = std::min(kFilterSize, size - start);
+}
+
+// Computes one output pixel from the filter taps [r_begin, r_end) x
+// [c_begin, c_end) of the [rows, cols, depth] image `input`, where the first
+// tap is at (in_r, in_c), and stores it to output[0, depth). When kAllTaps
+// is true, all the taps are inside the image and the tap loops have
+// constant bounds.
+template <typename T, int kFilterSize, bool kAllTaps>
+inline void FilterPixel(const T* input, int64 cols, int64 depth, int in_r,
+                        int in_c, const T* filter, int r_begin, int r_end,
+                        int c_begin, int c_end, T* output) {
+  typedef typename Eigen::internal::packet_traits<T>::type Packet;
+  static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
+  if (kAllTaps) {
+    r_begin = c_begin = 0;
+    r_end = c_end = kFilterSize;
+  }
+  const int64 vectorized_size = (depth / kPacketSize) * kPacketSize;
+  for (int64 d = 0; d < vectorized_size; d += kPacketSize) {
+    auto vaccum = Eigen::internal::pset1<Packet>(static_cast<T>(0));
+    for (int r = r_begin; r < r_end; ++r) {
+      const T* input_row = input + ((in_r + r) * cols + in_c) * depth + d;
+      const T* filter_row = filter + r * kFilterSize * depth + d;
+      for (int c = c_begin; c < c_end; ++c) {
+        const auto data_block =
+            Eigen::internal::ploadu<Packet>(input_row + c * depth);
+        const auto filter_block =
+            Eigen::internal::ploadu<Packet>(filter_row + c * depth);
+        vaccum =
+            Eigen::internal::pmadd<Packet>(filter_block, data_block, vaccum);
+      }
+    }
+    Eigen::internal::pstoreu<T>(output + d, vaccum);
+  }
+  for (int64 d = vectorized_size; d < depth; ++d) {
+    T accum = static_cast<T>(0);
+    for (int r = r_begin; r < r_end; ++r) {
+      for (int c = c_begin; c < c_end; ++c) {
+        accum += input[((in_r + r) * cols + in_c + c) * depth + d] *
+                 filter[(r * kFilterSize + c) * depth + d];
+      }
+    }
+    output[d] = accum;
+  }
+}
+
+// Computes the row `out_r` of the depthwise convolution of the [in_rows,
+// in_cols, depth] image `input` by the [filter_rows, filter_cols, depth]
+// `filter` into the [out_rows, out_cols, depth] image `output`.
+template <typename T, int kFilterSize, int kStride>
+struct DepthwiseConv2DKernel {
+  static void Run(const DepthwiseArgs& args, const T* input, const T* filter,
+                  int out_r, T* output) {
+    const int64 depth = args.in_depth;
+    const int in_r = out_r * kStride - args.pad_rows;
+    int r_begin, r_end;
+    ValidTaps<kFilterSize>(in_r, args.in_rows, &r_begin, &r_end);
+    const bool all_rows = r_begin == 0 && r_end == kFilterSize;
+    T* out = output + static_cast<int64>(out_r) * args.out_cols * depth;
+    for (int out_c = 0; out_c < args.out_cols; ++out_c, out += depth) {
+      const int in_c = out_c * kStride - args.pad_cols;
+      int c_begin, c_end;
+      ValidTaps<kFilterSize>(in_c, args.in_cols, &c_begin, &c_end);
+      if (all_rows && c_begin == 0 && c_end == kFilterSize) {
+        FilterPixel<T, kFilterSize, true>(input, args.in_cols, depth, in_r,
+                                          in_c, filter, 0, 0, 0, 0, out);
+      } else {
+        FilterPixel<T, kFilterSize, false>(input, args.in_cols, depth, in_r,
+                                           in_c, filter, r_begin, r_end,
+                                           c_begin, c_end, out);
+      }
+    }
+  }
+};
+
+// The filter taps along one dimension that map the input position `in` to an
+// output position: tap[i] reaches out[i], for i in [0, size).
+template <int kFilterSize>
+struct BackpropTaps {
+  int size = 0;
+  int tap[kFilterSize];
+  int out[kFilterSize];
+};
+
+// Returns the taps that map the input position `in` to one of the `out_size`
+// output positions, for a convolution of stride kStride and padding `pad`.
+template <int kFilterSize, int kStride>
+inline BackpropTaps<kFilterSize> FindBackpropTaps(int in, int pad,
+                                                  int out_size) {
+  BackpropTaps<kFilterSize> taps;
+  for (int t = 0; t < kFilterSize; ++t) {
+    const int pos = in + pad - t;
+    if (pos < 0 || pos % kStride != 0 || pos / kStride >= out_size) continue;
+    taps.tap[taps.size] = t;
+    taps.out[taps.size] = pos / kStride;
+    ++taps.size;
+  }
+  return taps;
+}
+
+// Computes the row `in_r` of the backprop of the depthwise convolution with
+// respect to its input, from the [out_rows, out_cols, depth] `out_backprop`
+// and the [filter_rows, filter_cols, depth] `filter`, into the [in_rows,
+// in_cols, depth] image `in_backprop`.
+template <typename T, int kFilterSize, int kStride>
+struct DepthwiseConv2DBackpropInputKernel {
+  static void Run(const DepthwiseArgs& args, const T* out_backprop,
+                  const T* filter, int in_r, T* in_backprop) {
+    typedef typename Eigen::internal::packet_traits<T>::type Packet;
+    static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
+    const int64 depth = args.in_depth;
+    const int64 vectorized_size = (depth / kPacketSize) * kPacketSize;
+    const BackpropTaps<kFilterSize> rows =
+        FindBackpropTaps<kFilterSize, kStride>(in_r, args.pad_rows,
+                                               args.out_rows);
+    T* out = in_backprop + static_cast<int64>(in_r) * args.in_cols * depth;
+    for (int in_c = 0; in_c < args.in_cols; ++in_c, out += depth) {
+      const BackpropTaps<kFilterSize> cols =
+          FindBackpropTaps<kFilterSize, kStride>(in_c, args.pad_cols,
+                                                 args.out_cols);
+      for (int64 d = 0; d < vectorized_size; d += kPacketSize) {
+        auto vaccum = Eigen::internal::pset1<Packet>(static_cast<T>(0));
+        for (int i = 0; i < rows.size; ++i) {
+          const T* out_bprop_row =
+              out_backprop +
+              static_cast<int64>(rows.out[i]) * args.out_cols * depth + d;
+          const T* filter_row = filter + rows.tap[i] * kFilterSize * depth + d;
+          for (int j = 0; j < cols.size; ++j) {
+            const auto data_block = Eigen::internal::ploadu<Packet>(
+                out_bprop_row + cols.out[j] * depth);
+            const auto filter_block = Eigen::internal::ploadu<Packet>(
+                filter_row + cols.tap[j] * depth);
+            vaccum = Eigen::internal::pmadd<Packet>(filter_block, data_block,
+                                                    vaccum);
+          }
+        }
+        Eigen::internal::pstoreu<T>(out + d, vaccum);
+      }
+      for (int64 d = vectorized_size; d < depth; ++d) {
+        T accum = static_cast<T>(0);
+        for (int i = 0; i < rows.size; ++i) {
+          for (int j = 0; j < cols.size; ++j) {
+            accum += out_backprop[(static_cast<int64>(rows.out[i]) *
+                                       args.out_cols +
+                                   cols.out[j]) *
+                                      depth +
+                                  d] *
+                     filter[(rows.tap[i] * kFilterSize + cols.tap[j]) * depth +
+                            d];
+          }
+        }
+        out[d] = accum;
+      }
+    }
+  }
+};
+
+// Adds the backprop of the depthwise convolution of the [in_rows, in_cols,
+// depth] image `input` with respect to its filter, from the [out_rows,
+// out_cols, depth] `out_backprop`, to `filter_backprop`, which holds a
+// [filter_rows, filter_cols] grid of vectors `filter_stride` apart.
+template <typename T, int kFilterSize, int kStride>
+struct DepthwiseConv2DBackpropFilterKernel {
+  static void Run(const DepthwiseArgs& args, const T* out_backprop,
+                  const T* input, int64 filter_stride, T* filter_backprop) {
+    typedef typename Eigen::internal::packet_traits<T>::type Packet;
+    static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
+    const int64 depth = args.in_depth;
+    const int64 vectorized_size = (depth / kPacketSize) * kPacketSize;
+    for (int out_r = 0; out_r < args.out_rows; ++out_r) {
+      const int in_r = out_r * kStride - args.pad_rows;
+      int r_begin, r_end;
+      ValidTaps<kFilterSize>(in_r, args.in_rows, &r_begin, &r_end);
+      for (int out_c = 0; out_c < args.out_cols; ++out_c) {
+        const int in_c = out_c * kStride - args.pad_cols;
+        int c_begin, c_end;
+        ValidTaps<kFilterSize>(in_c, args.in_cols, &c_begin, &c_end);
+        const T* out_bprop =
+            out_backprop +
+            (static_cast<int64>(out_r) * args.out_cols + out_c) * depth;
+        for (int r = r_begin; r < r_end; ++r) {
+          for (int c = c_begin; c < c_end; ++c) {
+            const T* in =
+                input +
+                ((static_cast<int64>(in_r) + r) * args.in_cols + in_c + c) *
+                    depth;
+            T* filter_bprop =
+                filter_backprop + (r * kFilterSize + c) * filter_stride;
+            for (int64 d = 0; d < vectorized_size; d += kPacketSize) {
+              const auto data_block = Eigen::internal::ploadu<Packet>(in + d);
+              const auto out_block =
+                  Eigen::internal::ploadu<Packet>(out_bprop + d);
+              auto vaccum = Eigen::internal::ploadu<Packet>(filter_bprop + d);
+              vaccum =
+                  Eigen::internal::pmadd<Packet>(data_block, out_block, vaccum);
+              Eigen::internal::pstoreu<T>(filter_bprop + d, vaccum);
+            }
+            for (int64 d = vectorized_size; d < depth; ++d) {
+              filter_bprop[d] += in[d] * out_bprop[d];
+            }
+          }
+        }
+      }
+    }
+  }
+};
+
+}  // namespace depthwise_specialized
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DEPTHWISE_CONV_SPECIALIZED_H_
@@ -315,4 +315,142 @@ BM_AllParseSingleExample(SparseFloat);
 BM_AllParseSingleExample(DenseFloat);
 BM_AllParseSingleExample(VarLenDenseFloat);
 
+// Benchmarks over feature schemas modeled after production input pipelines,
+// in which most features are dense numeric features of a fixed length.
+struct FeatureSpec {
+  string name;
+  DataType dtype;
+  int length;
+  bool sparse;
+  // Whether int64 values are small enough to be encoded as single-byte
+  // varints.
+  bool small_values;
+};
+
+enum SchemaType { kRanking, kEmbedding };
+
+static std::vector<FeatureSpec> GetSchema(SchemaType schema_type) {
+  std::vector<FeatureSpec> schema;
+  switch (schema_type) {
+    case kRanking:
+      // Scalar float features, dense embeddings, 64-bit ids, int64 histories
+      // of small values and sparse query terms.
+      for (int i = 0; i < 32; ++i) {
+        schema.push_back({strings::Printf("float_%d", i), DT_FLOAT, 1, false,
+                          false});
+      }
+      for (int i = 0; i < 4; ++i) {
+        schema.push_back({strings::Printf("embedding_%d", i), DT_FLOAT, 64,
+                          false, false});
+      }
+      for (int i = 0; i < 8; ++i) {
+        schema.push_back(
+            {strings::Printf("id_%d", i), DT_INT64, 1, false, false});
+      }
+      for (int i = 0; i < 2; ++i) {
+        schema.push_back({strings::Printf("history_%d", i), DT_INT64, 50,
+                          false, true});
+      }
+      for (int i = 0; i < 2; ++i) {
+        schema.push_back({strings::Printf("query_terms_%d", i), DT_STRING, 3,
+                          true, false});
+      }
+      break;
+    case kEmbedding:
+      // A few long dense features, e.g. precomputed embeddings.
+      schema.push_back({"user_embedding", DT_FLOAT, 1024, false, false});
+      schema.push_back({"item_embedding", DT_FLOAT, 1024, false, false});
+      schema.push_back({"item_ids", DT_INT64, 256, false, true});
+      break;
+  }
+  return schema;
+}
+
+static Tensor MakeSerializedExamples(const std::vector<FeatureSpec>& schema,
+                                     int batch_size) {
+  Tensor serialized(DT_STRING, TensorShape({batch_size}));
+  auto serialized_t = serialized.vec<string>();
+  for (int b = 0; b < batch_size; ++b) {
+    Example example;
+    auto* features = example.mutable_features()->mutable_feature();
+    for (const FeatureSpec& spec : schema) {
+      Feature& f = (*features)[spec.name];
+      for (int i = 0; i < spec.length; ++i) {
+        switch (spec.dtype) {
+          case DT_FLOAT:
+            f.mutable_float_list()->add_value(0.37f * (b + i));
+            break;
+          case DT_INT64:
+            f.mutable_int64_list()->add_value(
+                spec.small_values ? (b + i) % 100
+                                  : (b * 7919LL + i) * 1000003LL);
+            break;
+          default:
+            f.mutable_bytes_list()->add_value(strings::Printf("term_%d", i));
+            break;
+        }
+      }
+    }
+    CHECK(example.SerializeToString(&serialized_t(b)));
+  }
+  return serialized;
+}
+
+static Graph* ParseExampleWithSchema(SchemaType schema_type, int batch_size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const std::vector<FeatureSpec> schema = GetSchema(schema_type);
+  Tensor serialized = MakeSerializedExamples(schema, batch_size);
+  Tensor names(DT_STRING, TensorShape({batch_size}));
+
+  std::vector<NodeBuilder::NodeOut> sparse_keys;
+  std::vector<NodeBuilder::NodeOut> dense_keys;
+  std::vector<NodeBuilder::NodeOut> dense_defaults;
+  std::vector<DataType> sparse_types;
+  std::vector<PartialTensorShape> dense_shapes;
+  for (const FeatureSpec& spec : schema) {
+    Tensor key(DT_STRING, TensorShape());
+    key.scalar<string>()() = spec.name;
+    if (spec.sparse) {
+      sparse_keys.emplace_back(test::graph::Constant(g, key));
+      sparse_types.push_back(spec.dtype);
+    } else {
+      dense_keys.emplace_back(test::graph::Constant(g, key));
+      dense_defaults.emplace_back(test::graph::Constant(
+          g, Tensor(spec.dtype, TensorShape({spec.length}))));
+      dense_shapes.push_back(PartialTensorShape({spec.length}));
+    }
+  }
+
+  Node* ret;
+  TF_EXPECT_OK(NodeBuilder(g->NewName("n"), "ParseExample")
+                   .Input(test::graph::Constant(g, serialized))
+                   .Input(test::graph::Constant(g, names))
+                   .Input(sparse_keys)
+                   .Input(dense_keys)
+                   .Input(dense_defaults)
+                   .Attr("sparse_types", sparse_types)
+                   .Attr("dense_shapes", dense_shapes)
+                   .Finalize(g, &ret));
+
+  return g;
+}
+
+// B == batch_size. Reports the number of parsed examples.
+#define BM_ParseExampleWithSchema(SCHEMA, B)                                  \
+  static void BM_ParseExampleWithSchema##_##SCHEMA##_##B(int iters) {         \
+    testing::StopTiming();                                                    \
+    testing::UseRealTime();                                                   \
+    testing::ItemsProcessed(static_cast<int64>(iters) * B);                   \
+    test::Benchmark("cpu", ParseExampleWithSchema(SCHEMA, B)).Run(iters);     \
+  }                                                                           \
+  BENCHMARK(BM_ParseExampleWithSchema##_##SCHEMA##_##B);
+
+#define BM_AllParseExampleWithSchema(SCHEMA) \
+  BM_ParseExampleWithSchema(SCHEMA, 1);      \
+  BM_ParseExampleWithSchema(SCHEMA, 128);    \
+  BM_ParseExampleWithSchema(SCHEMA, 512);
+
+BM_AllParseExampleWithSchema(kRanking);
+BM_AllParseExampleWithSchema(kEmbedding);
+
 }  // end namespace tensorflow
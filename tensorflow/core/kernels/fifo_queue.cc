@@ -47,9 +47,56 @@ void FIFOQueue::DequeueLocked(OpKernelContext* ctx, Tuple* tuple) {
   }
 }
 
+Status FIFOQueue::DequeueManyLocked(OpKernelContext* ctx, int64 num_elements,
+                                    Tuple* tuple) {
+  DCHECK_GE(queues_[0].size(), static_cast<size_t>(num_elements));
+  Tuple batch;
+  batch.reserve(num_components());
+  for (int i = 0; i < num_components(); ++i) {
+    Tensor component;
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        component_dtypes_[i], ManyOutShape(i, num_elements), &component));
+    batch.emplace_back(std::move(component));
+  }
+  for (int i = 0; i < num_components(); ++i) {
+    std::vector<Tensor> elements;
+    elements.reserve(num_elements);
+    for (int64 j = 0; j < num_elements; ++j) {
+      elements.push_back(*queues_[i].front().AccessTensor(ctx));
+      queues_[i].pop_front();
+    }
+    TF_RETURN_IF_ERROR(batch_util::CopyElementsToSlices(std::move(elements),
+                                                        &batch[i], 0));
+  }
+  *tuple = std::move(batch);
+  return Status::OK();
+}
+
 void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
                            DoneCallback callback) {
   CancellationManager* cm = ctx->cancellation_manager();
+  // When no other enqueue is blocked and there is room, the element is
+  // enqueued right away, without an attempt or a cancellation callback.
+  bool enqueued = false;
+  bool flush = false;
+  {
+    mutex_lock l(mu_);
+    if (!closed_ && enqueue_attempts_.empty() &&
+        queues_[0].size() < static_cast<size_t>(capacity_) &&
+        !cm->IsCancelled()) {
+      for (int i = 0; i < num_components(); ++i) {
+        queues_[i].push_back(PersistentTensor(tuple[i]));
+      }
+      enqueued = true;
+      flush = !dequeue_attempts_.empty();
+    }
+  }
+  if (enqueued) {
+    if (flush) FlushUnlocked();
+    callback();
+    return;
+  }
+
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
   {
@@ -154,6 +201,26 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
 
 void FIFOQueue::TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) {
   CancellationManager* cm = ctx->cancellation_manager();
+  // When no other dequeue is blocked and the queue is not empty, the element
+  // is dequeued right away, without an attempt or a cancellation callback.
+  Tuple tuple;
+  bool dequeued = false;
+  bool flush = false;
+  {
+    mutex_lock l(mu_);
+    if (dequeue_attempts_.empty() && !queues_[0].empty() &&
+        !cm->IsCancelled()) {
+      DequeueLocked(ctx, &tuple);
+      dequeued = true;
+      flush = !enqueue_attempts_.empty();
+    }
+  }
+  if (dequeued) {
+    if (flush) FlushUnlocked();
+    callback(tuple);
+    return;
+  }
+
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
   {
@@ -245,6 +312,34 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
   }
 
   CancellationManager* cm = ctx->cancellation_manager();
+  // When no other dequeue is blocked and the queue holds a whole batch, the
+  // batch is dequeued right away with one copy per component.
+  {
+    Tuple tuple;
+    Status s;
+    bool dequeued = false;
+    bool flush = false;
+    {
+      mutex_lock l(mu_);
+      if (dequeue_attempts_.empty() &&
+          queues_[0].size() >= static_cast<size_t>(num_elements) &&
+          !cm->IsCancelled()) {
+        s = DequeueManyLocked(ctx, num_elements, &tuple);
+        dequeued = true;
+        flush = !enqueue_attempts_.empty();
+      }
+    }
+    if (dequeued) {
+      if (flush) FlushUnlocked();
+      if (!s.ok()) {
+        ctx->SetStatus(s);
+        tuple.clear();
+      }
+      callback(tuple);
+      return;
+    }
+  }
+
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
   {
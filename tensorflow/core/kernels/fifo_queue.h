@@ -61,6 +61,12 @@ class FIFOQueue : public TypedQueue<std::deque<PersistentTensor> > {
   void DequeueLocked(OpKernelContext* ctx, Tuple* tuple)
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Helper for dequeuing num_elements elements from queues_ into a batch,
+  // copying each component with a single batch_util call. On error, the
+  // elements are left in the queue.
+  Status DequeueManyLocked(OpKernelContext* ctx, int64 num_elements,
+                           Tuple* tuple) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   static Status GetElementComponentFromBatch(const Tuple& tuple, int64 index,
                                              int component,
                                              OpKernelContext* ctx,
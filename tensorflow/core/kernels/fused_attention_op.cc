@@ -0,0 +1,495 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/fused_attention_op.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+#if GOOGLE_CUDA
+#include "tensorflow/core/kernels/batch_matmul_op_impl.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#endif  // GOOGLE_CUDA
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
+template <typename Device, typename T>
+struct LaunchFusedAttention;
+
+// Computes the attention of a block of queries at a time, over a block of
+// keys at a time. The scores of a block of keys are turned into exponentials
+// relative to the running maximum of each query, and their products with the
+// values are added to the output, which is rescaled whenever the maximum
+// grows. Only the scores of a pair of blocks are in memory at once.
+template <typename T>
+struct LaunchFusedAttention<CPUDevice, T> {
+  typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      Matrix;
+  typedef Eigen::Map<const Matrix> ConstMatrixMap;
+  typedef Eigen::Map<Matrix> MatrixMap;
+  typedef Eigen::Map<const Eigen::Matrix<T, 1, Eigen::Dynamic>> ConstRowMap;
+
+  static constexpr int64 kQueryBlock = 64;
+  static constexpr int64 kKeyBlock = 128;
+
+  static void Launch(OpKernelContext* context, const AttentionDims& dims,
+                     const T* query, const T* key, const T* value,
+                     const AttentionMask<T>& mask, T* output) {
+    const int64 num_query_blocks =
+        (dims.query_length + kQueryBlock - 1) / kQueryBlock;
+    auto compute_blocks = [&](int64 begin, int64 end) {
+      Matrix scores(kQueryBlock, kKeyBlock);
+      Matrix accumulator;
+      Eigen::Array<T, Eigen::Dynamic, 1> row_max;
+      Eigen::Array<T, Eigen::Dynamic, 1> row_sum;
+      for (int64 unit = begin; unit < end; ++unit) {
+        const int64 bh = unit / num_query_blocks;
+        const int64 query_begin = (unit % num_query_blocks) * kQueryBlock;
+        ComputeBlock(dims, mask, bh, query_begin,
+                     std::min(kQueryBlock, dims.query_length - query_begin),
+                     query, key, value, &scores, &accumulator, &row_max,
+                     &row_sum, output);
+      }
+    };
+    const int64 cost_per_unit = kQueryBlock * dims.key_length *
+                                (dims.depth + dims.value_depth) * 2;
+    auto worker_threads = *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          dims.batch * dims.heads * num_query_blocks, cost_per_unit,
+          compute_blocks);
+  }
+
+ private:
+  // Computes the rows [query_begin, query_begin + num_rows) of the attention
+  // of the head 'bh', in the order batch * heads.
+  static void ComputeBlock(const AttentionDims& dims,
+                           const AttentionMask<T>& mask, int64 bh,
+                           int64 query_begin, int64 num_rows, const T* query,
+                           const T* key, const T* value, Matrix* scores,
+                           Matrix* accumulator,
+                           Eigen::Array<T, Eigen::Dynamic, 1>* row_max,
+                           Eigen::Array<T, Eigen::Dynamic, 1>* row_sum,
+                           T* output) {
+    const T kMinusInf = -std::numeric_limits<T>::infinity();
+    const int64 batch = bh / dims.heads;
+    const int64 head = bh % dims.heads;
+    const int64 depth = dims.depth;
+    const int64 value_depth = dims.value_depth;
+    ConstMatrixMap queries(
+        query + (bh * dims.query_length + query_begin) * depth, num_rows,
+        depth);
+    const T* head_keys = key + bh * dims.key_length * depth;
+    const T* head_values = value + bh * dims.key_length * value_depth;
+    // The query i attends to the keys before key_limit + i.
+    const int64 key_limit =
+        dims.causal ? dims.key_length - dims.query_length + query_begin + 1
+                    : dims.key_length;
+    const int64 key_end =
+        std::min(dims.key_length, key_limit + (dims.causal ? num_rows - 1 : 0));
+
+    accumulator->setZero(num_rows, value_depth);
+    row_max->setConstant(num_rows, kMinusInf);
+    row_sum->setZero(num_rows);
+    for (int64 key_begin = 0; key_begin < key_end; key_begin += kKeyBlock) {
+      const int64 num_keys = std::min(kKeyBlock, key_end - key_begin);
+      auto s = scores->topLeftCorner(num_rows, num_keys);
+      s.noalias() =
+          queries *
+          ConstMatrixMap(head_keys + key_begin * depth, num_keys, depth)
+              .transpose();
+      s *= static_cast<T>(dims.scale);
+      for (int64 i = 0; i < num_rows; ++i) {
+        auto row = s.row(i);
+        if (mask.data != nullptr) {
+          row += ConstRowMap(mask.data + batch * mask.batch_stride +
+                                 head * mask.head_stride +
+                                 (query_begin + i) * mask.query_stride +
+                                 key_begin,
+                             num_keys);
+        }
+        if (dims.causal) {
+          const int64 limit = key_limit + i - key_begin;
+          if (limit < num_keys) {
+            row.tail(num_keys - std::max<int64>(limit, 0))
+                .setConstant(kMinusInf);
+          }
+        }
+        const T new_max = std::max((*row_max)(i), row.maxCoeff());
+        if (new_max == kMinusInf) {
+          // Nothing to attend to yet.
+          row.setZero();
+          continue;
+        }
+        const T correction = std::exp((*row_max)(i) - new_max);
+        row = (row.array() - new_max).exp().matrix();
+        (*row_sum)(i) = (*row_sum)(i) * correction + row.sum();
+        accumulator->row(i) *= correction;
+        (*row_max)(i) = new_max;
+      }
+      accumulator->noalias() +=
+          s * ConstMatrixMap(head_values + key_begin * value_depth, num_keys,
+                             value_depth);
+    }
+    MatrixMap(output + (bh * dims.query_length + query_begin) * value_depth,
+              num_rows, value_depth) =
+        row_sum->inverse().matrix().asDiagonal() * (*accumulator);
+  }
+};
+
+template <typename T>
+constexpr int64 LaunchFusedAttention<CPUDevice, T>::kQueryBlock;
+template <typename T>
+constexpr int64 LaunchFusedAttention<CPUDevice, T>::kKeyBlock;
+
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                                   \
+  template <>                                                                 \
+  void AttentionCacheConcat<GPUDevice, T>::operator()(                        \
+      const GPUDevice& d, typename TTypes<T, 4>::ConstTensor cache,           \
+      typename TTypes<T, 4>::ConstTensor values,                              \
+      typename TTypes<T, 4>::Tensor output);                                  \
+  extern template struct AttentionCacheConcat<GPUDevice, T>;                  \
+  template <>                                                                 \
+  void AttentionSoftmaxChunk<GPUDevice, T>::operator()(                       \
+      const GPUDevice& d, const AttentionDims& dims,                          \
+      const AttentionMask<T>& mask, int64 key_begin, int64 chunk_length,      \
+      int64 chunk_stride, bool first_chunk, T* scores, T* row_max,            \
+      T* row_sum, T* output);                                                 \
+  extern template struct AttentionSoftmaxChunk<GPUDevice, T>;                 \
+  template <>                                                                 \
+  void AttentionNormalize<GPUDevice, T>::operator()(                          \
+      const GPUDevice& d, const AttentionDims& dims, const T* row_sum,        \
+      T* output);                                                             \
+  extern template struct AttentionNormalize<GPUDevice, T>;
+
+DECLARE_GPU_SPEC(float);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+// The device memory of the matrices of each head, for the batched GEMMs.
+template <typename T>
+class HeadMatrices {
+ public:
+  HeadMatrices(const T* base, int64 num_heads, int64 head_stride) {
+    memory_.reserve(num_heads);
+    ptrs_.reserve(num_heads);
+    for (int64 i = 0; i < num_heads; ++i) {
+      memory_.push_back(AsDeviceMemory(base + i * head_stride));
+      ptrs_.push_back(&memory_.back());
+    }
+  }
+
+  const std::vector<se::DeviceMemory<T>*>& ptrs() const { return ptrs_; }
+
+ private:
+  std::vector<se::DeviceMemory<T>> memory_;
+  std::vector<se::DeviceMemory<T>*> ptrs_;
+};
+
+// Computes the attention a chunk of keys at a time, with cuBLAS batched GEMMs
+// over the heads. The scores of a chunk are turned into exponentials relative
+// to the running maximum of each query, and their products with the values
+// are added to the output, which is rescaled whenever the maximum grows.
+// Chunks are sized so that their scores take at most kMaxChunkScores values.
+template <typename T>
+struct LaunchFusedAttention<GPUDevice, T> {
+  static constexpr int64 kMaxChunkScores = 16 << 20;
+  static constexpr int64 kMinChunkLength = 64;
+
+  static void Launch(OpKernelContext* context, const AttentionDims& dims,
+                     const T* query, const T* key, const T* value,
+                     const AttentionMask<T>& mask, T* output) {
+    auto* stream = context->op_device_context()->stream();
+    OP_REQUIRES(context, stream, errors::Internal("No GPU stream available."));
+    const GPUDevice& d = context->eigen_device<GPUDevice>();
+    const int64 num_heads = dims.batch * dims.heads;
+    const int64 num_rows = num_heads * dims.query_length;
+    const int64 chunk_stride = std::min(
+        dims.key_length,
+        std::max(kMinChunkLength, kMaxChunkScores / num_rows /
+                                      kMinChunkLength * kMinChunkLength));
+
+    Tensor scores, row_max, row_sum;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DataTypeToEnum<T>::value,
+                                          TensorShape({num_rows, chunk_stride}),
+                                          &scores));
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DataTypeToEnum<T>::value,
+                                          TensorShape({num_rows}), &row_max));
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DataTypeToEnum<T>::value,
+                                          TensorShape({num_rows}), &row_sum));
+    T* scores_data = scores.flat<T>().data();
+    HeadMatrices<T> queries(query, num_heads, dims.query_length * dims.depth);
+    HeadMatrices<T> head_scores(scores_data, num_heads,
+                                dims.query_length * chunk_stride);
+    HeadMatrices<T> outputs(output, num_heads,
+                            dims.query_length * dims.value_depth);
+    CublasScratchAllocator scratch_allocator(context);
+
+    // cuBLAS is column-major: the row-major scores [query_length, chunk] of
+    // a head are the column-major product keys * queries^T, and the output
+    // [query_length, value_depth] is values^T * scores^T.
+    for (int64 key_begin = 0; key_begin < dims.key_length;
+         key_begin += chunk_stride) {
+      const int64 chunk_length =
+          std::min(chunk_stride, dims.key_length - key_begin);
+      HeadMatrices<T> keys(key + key_begin * dims.depth, num_heads,
+                           dims.key_length * dims.depth);
+      HeadMatrices<T> values(value + key_begin * dims.value_depth, num_heads,
+                             dims.key_length * dims.value_depth);
+      bool blas_launch_status =
+          stream
+              ->ThenBlasGemmBatchedWithScratch(
+                  se::blas::Transpose::kTranspose,
+                  se::blas::Transpose::kNoTranspose, chunk_length,
+                  dims.query_length, dims.depth, static_cast<T>(dims.scale),
+                  keys.ptrs(), dims.depth, queries.ptrs(), dims.depth,
+                  static_cast<T>(0), head_scores.ptrs(), chunk_stride,
+                  num_heads, &scratch_allocator)
+              .ok();
+      OP_REQUIRES(context, blas_launch_status,
+                  errors::Internal("Blas xGEMMBatched launch failed for the "
+                                   "attention scores: num_heads=",
+                                   num_heads, ", chunk_length=", chunk_length,
+                                   ", query_length=", dims.query_length,
+                                   ", depth=", dims.depth));
+      functor::AttentionSoftmaxChunk<GPUDevice, T>()(
+          d, dims, mask, key_begin, chunk_length, chunk_stride,
+          key_begin == 0, scores_data, row_max.flat<T>().data(),
+          row_sum.flat<T>().data(), output);
+      blas_launch_status =
+          stream
+              ->ThenBlasGemmBatchedWithScratch(
+                  se::blas::Transpose::kNoTranspose,
+                  se::blas::Transpose::kNoTranspose, dims.value_depth,
+                  dims.query_length, chunk_length, static_cast<T>(1),
+                  values.ptrs(), dims.value_depth, head_scores.ptrs(),
+                  chunk_stride, static_cast<T>(1), outputs.ptrs(),
+                  dims.value_depth, num_heads, &scratch_allocator)
+              .ok();
+      OP_REQUIRES(context, blas_launch_status,
+                  errors::Internal("Blas xGEMMBatched launch failed for the "
+                                   "attention output: num_heads=",
+                                   num_heads, ", chunk_length=", chunk_length,
+                                   ", query_length=", dims.query_length,
+                                   ", value_depth=", dims.value_depth));
+    }
+    functor::AttentionNormalize<GPUDevice, T>()(
+        d, dims, row_sum.flat<T>().data(), output);
+  }
+};
+
+template <typename T>
+constexpr int64 LaunchFusedAttention<GPUDevice, T>::kMaxChunkScores;
+template <typename T>
+constexpr int64 LaunchFusedAttention<GPUDevice, T>::kMinChunkLength;
+#endif  // GOOGLE_CUDA
+
+template <typename Device, typename T>
+class FusedMultiHeadAttentionOp : public OpKernel {
+ public:
+  explicit FusedMultiHeadAttentionOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_cache", &num_cache_));
+    OP_REQUIRES_OK(context, context->GetAttr("num_mask", &num_mask_));
+    OP_REQUIRES_OK(context, context->GetAttr("scale", &scale_));
+    OP_REQUIRES_OK(context, context->GetAttr("causal", &causal_));
+    OP_REQUIRES(context, num_cache_ <= 1,
+                errors::InvalidArgument("num_cache must be 0 or 1, got ",
+                                        num_cache_));
+    OP_REQUIRES(context, num_mask_ <= 1,
+                errors::InvalidArgument("num_mask must be 0 or 1, got ",
+                                        num_mask_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& query = context->input(0);
+    Tensor key = context->input(1);
+    Tensor value = context->input(2);
+    OP_REQUIRES(context,
+                query.dims() == 4 && key.dims() == 4 && value.dims() == 4,
+                errors::InvalidArgument("query, key and value must be 4-D "
+                                        "[batch, heads, length, depth], got ",
+                                        query.shape().DebugString(), ", ",
+                                        key.shape().DebugString(), " and ",
+                                        value.shape().DebugString()));
+    OP_REQUIRES(
+        context,
+        key.dim_size(0) == query.dim_size(0) &&
+            value.dim_size(0) == query.dim_size(0) &&
+            key.dim_size(1) == query.dim_size(1) &&
+            value.dim_size(1) == query.dim_size(1) &&
+            key.dim_size(2) == value.dim_size(2) &&
+            key.dim_size(3) == query.dim_size(3),
+        errors::InvalidArgument("Incompatible shapes of query ",
+                                query.shape().DebugString(), ", key ",
+                                key.shape().DebugString(), " and value ",
+                                value.shape().DebugString()));
+
+    if (num_cache_ > 0) {
+      // Attend over the cached keys and values followed by those of this
+      // step, and output them as the cache of the next step.
+      const Tensor& key_cache = context->input(3);
+      const Tensor& value_cache = context->input(4);
+      OP_REQUIRES(context,
+                  key_cache.dims() == 4 && value_cache.dims() == 4 &&
+                      key_cache.dim_size(2) == value_cache.dim_size(2),
+                  errors::InvalidArgument(
+                      "key_cache and value_cache must be 4-D with the same "
+                      "length, got ",
+                      key_cache.shape().DebugString(), " and ",
+                      value_cache.shape().DebugString()));
+      Tensor* new_key_cache = nullptr;
+      Tensor* new_value_cache = nullptr;
+      OP_REQUIRES_OK(context, ConcatCache(context, key_cache, key, 1,
+                                          &new_key_cache));
+      OP_REQUIRES_OK(context, ConcatCache(context, value_cache, value, 2,
+                                          &new_value_cache));
+      key = *new_key_cache;
+      value = *new_value_cache;
+    }
+
+    AttentionDims dims;
+    dims.batch = query.dim_size(0);
+    dims.heads = query.dim_size(1);
+    dims.query_length = query.dim_size(2);
+    dims.key_length = key.dim_size(2);
+    dims.depth = query.dim_size(3);
+    dims.value_depth = value.dim_size(3);
+    dims.scale = scale_;
+    dims.causal = causal_;
+    OP_REQUIRES(context, !causal_ || dims.query_length <= dims.key_length,
+                errors::InvalidArgument(
+                    "A causal attention needs at least as many keys as "
+                    "queries, got ",
+                    dims.key_length, " keys and ", dims.query_length,
+                    " queries"));
+
+    AttentionMask<T> mask;
+    if (num_mask_ > 0) {
+      const Tensor& mask_tensor = context->input(3 + 2 * num_cache_);
+      OP_REQUIRES_OK(context, GetMask(mask_tensor, dims, &mask));
+    }
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0,
+                                TensorShape({dims.batch, dims.heads,
+                                             dims.query_length,
+                                             dims.value_depth}),
+                                &output));
+    if (output->NumElements() == 0) return;
+    OP_REQUIRES(context, dims.key_length > 0,
+                errors::InvalidArgument("An attention needs at least one key"));
+    LaunchFusedAttention<Device, T>::Launch(
+        context, dims, query.flat<T>().data(), key.flat<T>().data(),
+        value.flat<T>().data(), mask, output->flat<T>().data());
+  }
+
+ private:
+  // Allocates the output 'output_index' to the concatenation of 'cache' and
+  // 'values' along the sequence dimension.
+  Status ConcatCache(OpKernelContext* context, const Tensor& cache,
+                     const Tensor& values, int output_index,
+                     Tensor** output) {
+    if (cache.dims() != 4 || cache.dim_size(0) != values.dim_size(0) ||
+        cache.dim_size(1) != values.dim_size(1) ||
+        cache.dim_size(3) != values.dim_size(3)) {
+      return errors::InvalidArgument(
+          "A cache of shape ", cache.shape().DebugString(),
+          " can't be extended with values of shape ",
+          values.shape().DebugString());
+    }
+    TensorShape shape = values.shape();
+    shape.set_dim(2, cache.dim_size(2) + values.dim_size(2));
+    TF_RETURN_IF_ERROR(context->allocate_output(output_index, shape, output));
+    if ((*output)->NumElements() > 0) {
+      functor::AttentionCacheConcat<Device, T>()(
+          context->eigen_device<Device>(), cache.tensor<T, 4>(),
+          values.tensor<T, 4>(), (*output)->tensor<T, 4>());
+    }
+    return Status::OK();
+  }
+
+  // Fills 'mask' with the broadcast of 'mask_tensor' to
+  // [batch, heads, query_length, key_length].
+  Status GetMask(const Tensor& mask_tensor, const AttentionDims& dims,
+                 AttentionMask<T>* mask) {
+    const int64 full_dims[] = {dims.batch, dims.heads, dims.query_length};
+    bool broadcastable =
+        mask_tensor.dims() == 4 && mask_tensor.dim_size(3) == dims.key_length;
+    for (int i = 0; broadcastable && i < 3; ++i) {
+      broadcastable = mask_tensor.dim_size(i) == full_dims[i] ||
+                      mask_tensor.dim_size(i) == 1;
+    }
+    if (!broadcastable) {
+      return errors::InvalidArgument(
+          "mask of shape ", mask_tensor.shape().DebugString(),
+          " can't be broadcast to [", dims.batch, ", ", dims.heads, ", ",
+          dims.query_length, ", ", dims.key_length, "]");
+    }
+    auto stride = [&mask_tensor](int i, int64 stride) -> int64 {
+      return mask_tensor.dim_size(i) == 1 ? 0 : stride;
+    };
+    const int64 query_stride = dims.key_length;
+    const int64 head_stride = mask_tensor.dim_size(2) * query_stride;
+    const int64 batch_stride = mask_tensor.dim_size(1) * head_stride;
+    mask->data = mask_tensor.flat<T>().data();
+    mask->query_stride = stride(2, query_stride);
+    mask->head_stride = stride(1, head_stride);
+    mask->batch_stride = stride(0, batch_stride);
+    return Status::OK();
+  }
+
+  int num_cache_;
+  int num_mask_;
+  float scale_;
+  bool causal_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("FusedMultiHeadAttention")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<float>("T"),
+                        FusedMultiHeadAttentionOp<CPUDevice, float>);
+
+#if GOOGLE_CUDA
+REGISTER_KERNEL_BUILDER(Name("FusedMultiHeadAttention")
+                            .Device(DEVICE_GPU)
+                            .TypeConstraint<float>("T"),
+                        FusedMultiHeadAttentionOp<GPUDevice, float>);
+#endif  // GOOGLE_CUDA
+
+}  // namespace tensorflow
@@ -0,0 +1,93 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_FUSED_ATTENTION_OP_H_
+#define TENSORFLOW_CORE_KERNELS_FUSED_ATTENTION_OP_H_
+// Functor definitions for FusedMultiHeadAttentionOp, must be compilable by
+// nvcc.
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The shape of an attention of queries [batch, heads, query_length, depth]
+// over keys [batch, heads, key_length, depth] and values
+// [batch, heads, key_length, value_depth].
+struct AttentionDims {
+  int64 batch = 0;
+  int64 heads = 0;
+  int64 query_length = 0;
+  int64 key_length = 0;
+  int64 depth = 0;
+  int64 value_depth = 0;
+  // The factor of the scores, usually 1 / sqrt(depth).
+  float scale = 1;
+  // If true, the query i only attends to the keys j with
+  // j <= key_length - query_length + i, i.e. the queries are the last
+  // query_length positions of the keys.
+  bool causal = false;
+};
+
+// The mask added to the scaled scores, broadcast to
+// [batch, heads, query_length, key_length]. The strides of the broadcast
+// dimensions are 0; the keys are contiguous.
+template <typename T>
+struct AttentionMask {
+  const T* data = nullptr;  // Null if there is no mask.
+  int64 batch_stride = 0;
+  int64 head_stride = 0;
+  int64 query_stride = 0;
+};
+
+namespace functor {
+
+// Concatenates the cached keys or values of the previous steps with those of
+// the current step, along the sequence dimension.
+template <typename Device, typename T>
+struct AttentionCacheConcat {
+  void operator()(const Device& d, typename TTypes<T, 4>::ConstTensor cache,
+                  typename TTypes<T, 4>::ConstTensor values,
+                  typename TTypes<T, 4>::Tensor output) {
+    output.device(d) = cache.concatenate(values, 2);
+  }
+};
+
+// Applies a chunk of keys [key_begin, key_begin + chunk_length) to the online
+// softmax of each of the batch * heads * query_length rows of the attention.
+// 'scores' holds the scaled scores of the chunk, 'chunk_stride' apart per row,
+// and is replaced by their exponentials relative to the updated maximum of the
+// row in 'row_max'. The sums of the exponentials in 'row_sum' and the rows of
+// 'output' are rescaled to that maximum, or initialized if 'first_chunk'.
+template <typename Device, typename T>
+struct AttentionSoftmaxChunk {
+  void operator()(const Device& d, const AttentionDims& dims,
+                  const AttentionMask<T>& mask, int64 key_begin,
+                  int64 chunk_length, int64 chunk_stride, bool first_chunk,
+                  T* scores, T* row_max, T* row_sum, T* output);
+};
+
+// Divides the rows of 'output' by the sums of their exponentials.
+template <typename Device, typename T>
+struct AttentionNormalize {
+  void operator()(const Device& d, const AttentionDims& dims,
+                  const T* row_sum, T* output);
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_FUSED_ATTENTION_OP_H_
@@ -0,0 +1,164 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/kernels/fused_attention_op.h"
+
+#include "tensorflow/core/util/cuda_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+constexpr int kThreads = 128;
+constexpr int kWarpSize = 32;
+
+struct MaxOp {
+  __device__ EIGEN_STRONG_INLINE float operator()(float a, float b) const {
+    return fmaxf(a, b);
+  }
+};
+
+struct SumOp {
+  __device__ EIGEN_STRONG_INLINE float operator()(float a, float b) const {
+    return a + b;
+  }
+};
+
+// Reduces 'value' over the threads of the block, with warp shuffles and then
+// across the warps in 'shared'. Every thread gets the result.
+template <typename Op>
+__device__ float BlockReduce(float value, Op op, float* shared) {
+  for (int lane_mask = kWarpSize / 2; lane_mask > 0; lane_mask /= 2) {
+    value = op(value, CudaShuffleXorSync(kCudaWarpAll, value, lane_mask));
+  }
+  const int warp = threadIdx.x / kWarpSize;
+  if (threadIdx.x % kWarpSize == 0) shared[warp] = value;
+  __syncthreads();
+  value = shared[0];
+  for (int i = 1; i < kThreads / kWarpSize; ++i) value = op(value, shared[i]);
+  // Keep 'shared' from being overwritten by a following reduction before
+  // every thread has read it.
+  __syncthreads();
+  return value;
+}
+
+// Applies a chunk of keys to a row of the attention per block.
+__global__ void AttentionSoftmaxChunkKernel(
+    AttentionDims dims, AttentionMask<float> mask, int64 key_begin,
+    int chunk_length, int64 chunk_stride, bool first_chunk, float* scores,
+    float* row_max, float* row_sum, float* output) {
+  __shared__ float shared[kThreads / kWarpSize];
+  const float kMinusInf = -Eigen::NumTraits<float>::infinity();
+  const int64 row = blockIdx.x;
+  const int64 query = row % dims.query_length;
+  const int64 bh = row / dims.query_length;
+  float* row_scores = scores + row * chunk_stride;
+  const float* row_mask =
+      mask.data == nullptr
+          ? nullptr
+          : mask.data + (bh / dims.heads) * mask.batch_stride +
+                (bh % dims.heads) * mask.head_stride +
+                query * mask.query_stride + key_begin;
+  // The number of keys of the chunk that the query attends to.
+  const int64 num_keys =
+      dims.causal
+          ? min(static_cast<int64>(chunk_length),
+                dims.key_length - dims.query_length + query + 1 - key_begin)
+          : chunk_length;
+  const float old_max = first_chunk ? kMinusInf : row_max[row];
+  const float old_sum = first_chunk ? 0.0f : row_sum[row];
+
+  float max = kMinusInf;
+  for (int i = threadIdx.x; i < chunk_length; i += kThreads) {
+    float score = kMinusInf;
+    if (i < num_keys) {
+      score = row_scores[i];
+      if (row_mask != nullptr) score += ldg(row_mask + i);
+    }
+    row_scores[i] = score;
+    max = fmaxf(max, score);
+  }
+  const float new_max = fmaxf(old_max, BlockReduce(max, MaxOp(), shared));
+
+  float sum = 0;
+  for (int i = threadIdx.x; i < chunk_length; i += kThreads) {
+    const float p =
+        new_max == kMinusInf ? 0.0f : expf(row_scores[i] - new_max);
+    row_scores[i] = p;
+    sum += p;
+  }
+  sum = BlockReduce(sum, SumOp(), shared);
+
+  // The output accumulated so far is relative to the old maximum.
+  const float correction =
+      first_chunk || new_max == kMinusInf ? 0.0f : expf(old_max - new_max);
+  float* row_output = output + row * dims.value_depth;
+  for (int i = threadIdx.x; i < dims.value_depth; i += kThreads) {
+    row_output[i] = first_chunk ? 0.0f : row_output[i] * correction;
+  }
+  if (threadIdx.x == 0) {
+    row_max[row] = new_max;
+    row_sum[row] = old_sum * correction + sum;
+  }
+}
+
+__global__ void AttentionNormalizeKernel(int64 count, int64 value_depth,
+                                         const float* row_sum, float* output) {
+  CUDA_1D_KERNEL_LOOP(i, count) { output[i] /= ldg(row_sum + i / value_depth); }
+}
+
+}  // namespace
+
+namespace functor {
+
+template <>
+void AttentionSoftmaxChunk<GPUDevice, float>::operator()(
+    const GPUDevice& d, const AttentionDims& dims,
+    const AttentionMask<float>& mask, int64 key_begin, int64 chunk_length,
+    int64 chunk_stride, bool first_chunk, float* scores, float* row_max,
+    float* row_sum, float* output) {
+  const int64 num_rows = dims.batch * dims.heads * dims.query_length;
+  AttentionSoftmaxChunkKernel<<<num_rows, kThreads, 0, d.stream()>>>(
+      dims, mask, key_begin, chunk_length, chunk_stride, first_chunk, scores,
+      row_max, row_sum, output);
+}
+
+template <>
+void AttentionNormalize<GPUDevice, float>::operator()(const GPUDevice& d,
+                                                      const AttentionDims& dims,
+                                                      const float* row_sum,
+                                                      float* output) {
+  const int64 count =
+      dims.batch * dims.heads * dims.query_length * dims.value_depth;
+  CudaLaunchConfig config = GetCudaLaunchConfig(count, d);
+  AttentionNormalizeKernel<<<config.block_count, config.thread_per_block, 0,
+                             d.stream()>>>(count, dims.value_depth, row_sum,
+                                           output);
+}
+
+template struct AttentionCacheConcat<GPUDevice, float>;
+template struct AttentionSoftmaxChunk<GPUDevice, float>;
+template struct AttentionNormalize<GPUDevice, float>;
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
@@ -0,0 +1,190 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class FusedMultiHeadAttentionOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(int num_cache, int num_mask, float scale, bool causal) {
+    TF_ASSERT_OK(NodeDefBuilder("attention", "FusedMultiHeadAttention")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(num_cache, DT_FLOAT))
+                     .Input(FakeInput(num_cache, DT_FLOAT))
+                     .Input(FakeInput(num_mask, DT_FLOAT))
+                     .Attr("scale", scale)
+                     .Attr("causal", causal)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Returns a float tensor with values in [-1, 1).
+  static Tensor RandomTensor(const TensorShape& shape) {
+    Tensor tensor(DT_FLOAT, shape);
+    tensor.flat<float>().setRandom();
+    tensor.flat<float>() =
+        tensor.flat<float>() * 2.0f - tensor.flat<float>().constant(1.0f);
+    return tensor;
+  }
+
+  // Computes softmax(scale * query * key^T + mask) * value, where 'mask' is
+  // null or has the shape [1, heads, 1, key_length].
+  static Tensor ReferenceAttention(const Tensor& query, const Tensor& key,
+                                   const Tensor& value, const Tensor* mask,
+                                   float scale, bool causal) {
+    const int64 batch = query.dim_size(0), heads = query.dim_size(1);
+    const int64 query_length = query.dim_size(2), depth = query.dim_size(3);
+    const int64 key_length = key.dim_size(2);
+    const int64 value_depth = value.dim_size(3);
+    auto q = query.tensor<float, 4>();
+    auto k = key.tensor<float, 4>();
+    auto v = value.tensor<float, 4>();
+    Tensor output(DT_FLOAT,
+                  TensorShape({batch, heads, query_length, value_depth}));
+    auto out = output.tensor<float, 4>();
+    for (int64 b = 0; b < batch; ++b) {
+      for (int64 h = 0; h < heads; ++h) {
+        for (int64 i = 0; i < query_length; ++i) {
+          std::vector<double> p(key_length);
+          double max = -std::numeric_limits<double>::infinity();
+          for (int64 j = 0; j < key_length; ++j) {
+            double score = 0;
+            for (int64 c = 0; c < depth; ++c) {
+              score += q(b, h, i, c) * k(b, h, j, c);
+            }
+            score *= scale;
+            if (mask != nullptr) score += mask->tensor<float, 4>()(0, h, 0, j);
+            if (causal && j > key_length - query_length + i) {
+              score = -std::numeric_limits<double>::infinity();
+            }
+            p[j] = score;
+            max = std::max(max, score);
+          }
+          double sum = 0;
+          for (double& x : p) {
+            x = std::exp(x - max);
+            sum += x;
+          }
+          for (int64 c = 0; c < value_depth; ++c) {
+            double result = 0;
+            for (int64 j = 0; j < key_length; ++j) {
+              result += p[j] * v(b, h, j, c);
+            }
+            out(b, h, i, c) = result / sum;
+          }
+        }
+      }
+    }
+    return output;
+  }
+};
+
+TEST_F(FusedMultiHeadAttentionOpTest, WithMask) {
+  // Several blocks of queries and keys, with masked keys.
+  const int batch = 2, heads = 3, query_length = 70, key_length = 300;
+  MakeOp(0, 1, 0.25f, false);
+  Tensor query = RandomTensor({batch, heads, query_length, 16});
+  Tensor key = RandomTensor({batch, heads, key_length, 16});
+  Tensor value = RandomTensor({batch, heads, key_length, 8});
+  Tensor mask = RandomTensor({1, heads, 1, key_length});
+  for (int j = 0; j < heads * key_length; j += 7) {
+    mask.flat<float>()(j) = -std::numeric_limits<float>::infinity();
+  }
+  AddInputFromArray<float>(query.shape(), query.flat<float>());
+  AddInputFromArray<float>(key.shape(), key.flat<float>());
+  AddInputFromArray<float>(value.shape(), value.flat<float>());
+  AddInputFromArray<float>(mask.shape(), mask.flat<float>());
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorNear<float>(
+      ReferenceAttention(query, key, value, &mask, 0.25f, false),
+      *GetOutput(0), 1e-5);
+}
+
+TEST_F(FusedMultiHeadAttentionOpTest, Causal) {
+  const int query_length = 100, key_length = 200;
+  MakeOp(0, 0, 0.5f, true);
+  Tensor query = RandomTensor({1, 2, query_length, 8});
+  Tensor key = RandomTensor({1, 2, key_length, 8});
+  Tensor value = RandomTensor({1, 2, key_length, 8});
+  AddInputFromArray<float>(query.shape(), query.flat<float>());
+  AddInputFromArray<float>(key.shape(), key.flat<float>());
+  AddInputFromArray<float>(value.shape(), value.flat<float>());
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorNear<float>(
+      ReferenceAttention(query, key, value, nullptr, 0.5f, true),
+      *GetOutput(0), 1e-5);
+}
+
+TEST_F(FusedMultiHeadAttentionOpTest, KeyValueCache) {
+  // A step of incremental decoding: the query of the new position attends
+  // over the cached keys and its own.
+  const int cache_length = 150;
+  MakeOp(1, 0, 0.25f, true);
+  Tensor query = RandomTensor({2, 2, 1, 16});
+  Tensor key = RandomTensor({2, 2, 1, 16});
+  Tensor value = RandomTensor({2, 2, 1, 4});
+  Tensor key_cache = RandomTensor({2, 2, cache_length, 16});
+  Tensor value_cache = RandomTensor({2, 2, cache_length, 4});
+  AddInputFromArray<float>(query.shape(), query.flat<float>());
+  AddInputFromArray<float>(key.shape(), key.flat<float>());
+  AddInputFromArray<float>(value.shape(), value.flat<float>());
+  AddInputFromArray<float>(key_cache.shape(), key_cache.flat<float>());
+  AddInputFromArray<float>(value_cache.shape(), value_cache.flat<float>());
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor all_keys(DT_FLOAT, TensorShape({2, 2, cache_length + 1, 16}));
+  all_keys.tensor<float, 4>() =
+      key_cache.tensor<float, 4>().concatenate(key.tensor<float, 4>(), 2);
+  Tensor all_values(DT_FLOAT, TensorShape({2, 2, cache_length + 1, 4}));
+  all_values.tensor<float, 4>() =
+      value_cache.tensor<float, 4>().concatenate(value.tensor<float, 4>(), 2);
+  test::ExpectTensorNear<float>(
+      ReferenceAttention(query, all_keys, all_values, nullptr, 0.25f, true),
+      *GetOutput(0), 1e-5);
+  test::ExpectTensorEqual<float>(all_keys, *GetOutput(1));
+  test::ExpectTensorEqual<float>(all_values, *GetOutput(2));
+}
+
+TEST_F(FusedMultiHeadAttentionOpTest, MaskOfWrongShape) {
+  MakeOp(0, 1, 1.0f, false);
+  AddInputFromArray<float>(TensorShape({1, 2, 3, 4}),
+                           std::vector<float>(24, 0));
+  AddInputFromArray<float>(TensorShape({1, 2, 5, 4}),
+                           std::vector<float>(40, 0));
+  AddInputFromArray<float>(TensorShape({1, 2, 5, 4}),
+                           std::vector<float>(40, 0));
+  AddInputFromArray<float>(TensorShape({1, 2, 3, 4}),
+                           std::vector<float>(24, 0));
+  Status s = RunOpKernel();
+  EXPECT_TRUE(str_util::StrContains(
+      s.ToString(), "mask of shape [1,2,3,4] can't be broadcast to"))
+      << s;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,149 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Output kernels for fusing computations into Eigen tensor contractions.
+// They are used by the _FusedConv2D and _FusedMatMul CPU kernels, which the
+// grappler remapper creates from Conv2D/MatMul + BiasAdd (+ activation)
+// chains. An output kernel is run on each block of the contraction result
+// right after it is computed, so the bias add and the activation do not make
+// separate passes over the output tensor.
+
+#ifndef TENSORFLOW_CORE_KERNELS_FUSED_EIGEN_OUTPUT_KERNELS_H_
+#define TENSORFLOW_CORE_KERNELS_FUSED_EIGEN_OUTPUT_KERNELS_H_
+
+#include <utility>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+
+namespace tensorflow {
+
+// The computations a fused kernel applies to the contraction output, as
+// given by its `fused_ops` attribute.
+enum class FusedComputationType {
+  kUndefined,
+  kBiasAdd,           // fused_ops = ["BiasAdd"]
+  kBiasAddWithRelu,   // fused_ops = ["BiasAdd", "Relu"]
+  kBiasAddWithRelu6,  // fused_ops = ["BiasAdd", "Relu6"]
+};
+
+// Parses the `fused_ops` and `num_args` attributes of `context` into
+// `*fused_computation`. Returns an error for unsupported combinations.
+inline Status InitializeFusedComputation(
+    OpKernelConstruction* context, const string& kernel_name,
+    FusedComputationType* fused_computation) {
+  std::vector<string> fused_ops;
+  TF_RETURN_IF_ERROR(context->GetAttr("fused_ops", &fused_ops));
+  int num_args;
+  TF_RETURN_IF_ERROR(context->GetAttr("num_args", &num_args));
+
+  *fused_computation = FusedComputationType::kUndefined;
+  if (fused_ops == std::vector<string>({"BiasAdd"})) {
+    *fused_computation = FusedComputationType::kBiasAdd;
+  } else if (fused_ops == std::vector<string>({"BiasAdd", "Relu"})) {
+    *fused_computation = FusedComputationType::kBiasAddWithRelu;
+  } else if (fused_ops == std::vector<string>({"BiasAdd", "Relu6"})) {
+    *fused_computation = FusedComputationType::kBiasAddWithRelu6;
+  } else {
+    return errors::Unimplemented("Fusion is not implemented for ",
+                                 kernel_name, ": [",
+                                 str_util::Join(fused_ops, ","), "]");
+  }
+  if (num_args != 1) {
+    return errors::InvalidArgument(
+        kernel_name, " with BiasAdd must have exactly one extra argument");
+  }
+  return Status::OK();
+}
+
+// Checks that `bias` can be added to an output with `channels` channels in
+// its innermost dimension.
+inline Status ValidateBias(const Tensor& bias, int64 channels) {
+  if (bias.dims() != 1) {
+    return errors::InvalidArgument("bias must be 1-dimensional: ",
+                                   bias.shape().DebugString());
+  }
+  if (bias.dim_size(0) != channels) {
+    return errors::InvalidArgument(
+        "bias must have the same size as the last dimension of the output: ",
+        bias.dim_size(0), " vs. ", channels);
+  }
+  return Status::OK();
+}
+
+// Activation functions applied to a tensor expression.
+struct IdentityActivation {
+  template <typename XprType>
+  static auto apply(XprType expr) -> XprType {
+    return expr;
+  }
+};
+
+struct ReluActivation {
+  template <typename XprType>
+  static auto apply(XprType expr)
+      -> decltype(expr.cwiseMax(std::declval<typename XprType::Scalar>())) {
+    return expr.cwiseMax(static_cast<typename XprType::Scalar>(0));
+  }
+};
+
+struct Relu6Activation {
+  template <typename XprType>
+  static auto apply(XprType expr)
+      -> decltype(expr.cwiseMax(std::declval<typename XprType::Scalar>())
+                      .cwiseMin(std::declval<typename XprType::Scalar>())) {
+    return expr.cwiseMax(static_cast<typename XprType::Scalar>(0))
+        .cwiseMin(static_cast<typename XprType::Scalar>(6));
+  }
+};
+
+// Adds a bias vector to the innermost dimension of the contraction output,
+// then applies Activation.
+//
+// TensorFlow tensors are row major, so the Eigen contraction evaluator swaps
+// its arguments and works on a column major output matrix whose rows are the
+// output channels: the block at (i, j) covers channels [i, i + num_rows).
+template <typename T, typename Activation = IdentityActivation>
+struct BiasAddOutputKernel {
+  explicit BiasAddOutputKernel(const T* bias_data) : bias_data(bias_data) {}
+
+  template <typename Index, typename Scalar>
+  EIGEN_ALWAYS_INLINE void operator()(
+      const Eigen::internal::blas_data_mapper<Scalar, Index, Eigen::ColMajor>&
+          output_mapper,
+      const Eigen::TensorContractionParams& params, Index i, Index j,
+      Index num_rows, Index num_cols) const {
+    DCHECK(params.swapped_arguments);
+
+    typename TTypes<T>::UnalignedConstTensor bias(bias_data + i, num_rows);
+    for (Index col = 0; col < num_cols; ++col) {
+      typename TTypes<T>::UnalignedTensor output(&output_mapper(0, col),
+                                                 num_rows);
+      output = Activation::apply(output + bias);
+    }
+  }
+
+  const T* bias_data;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_FUSED_EIGEN_OUTPUT_KERNELS_H_
@@ -0,0 +1,389 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#define EIGEN_USE_THREADS
+#if GOOGLE_CUDA
+#define EIGEN_USE_GPU
+#endif  // GOOGLE_CUDA
+
+#include "tensorflow/core/kernels/fused_embedding_ops.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace functor {
+
+namespace {
+
+// Returns the factor the weighted sum of each of the `num_rows` output rows is
+// multiplied with.
+template <typename T>
+std::vector<T> ComputeRowScales(EmbeddingCombiner combiner, int64 num_rows,
+                                const std::vector<int64>& rows,
+                                typename TTypes<T>::ConstFlat weights) {
+  std::vector<T> scales(num_rows, T(1));
+  if (combiner == EmbeddingCombiner::kSum) {
+    return scales;
+  }
+  std::vector<T> sums(num_rows, T(0));
+  for (int64 e = 0; e < rows.size(); ++e) {
+    const T weight = weights(e);
+    sums[rows[e]] +=
+        combiner == EmbeddingCombiner::kSqrtN ? weight * weight : weight;
+  }
+  for (int64 r = 0; r < num_rows; ++r) {
+    scales[r] = combiner == EmbeddingCombiner::kSqrtN
+                    ? T(1) / Eigen::numext::sqrt(sums[r])
+                    : T(1) / sums[r];
+  }
+  return scales;
+}
+
+// Groups the entries 0..keys.size()-1 by key with a counting sort: the
+// entries with key k are entries[starts[k]] to entries[starts[k + 1] - 1], in
+// their original order.
+void GroupByKey(const std::vector<int64>& keys, int64 num_keys,
+                std::vector<int64>* starts, std::vector<int64>* entries) {
+  starts->assign(num_keys + 1, 0);
+  for (int64 key : keys) {
+    ++(*starts)[key + 1];
+  }
+  for (int64 k = 0; k < num_keys; ++k) {
+    (*starts)[k + 1] += (*starts)[k];
+  }
+  std::vector<int64> next(starts->begin(), starts->end() - 1);
+  entries->resize(keys.size());
+  for (int64 e = 0; e < keys.size(); ++e) {
+    (*entries)[next[keys[e]]++] = e;
+  }
+}
+
+// Copies `indices` to a vector, failing if any of them is out of
+// [0, limit).
+template <typename Index>
+Status CopyIndices(typename TTypes<Index>::ConstFlat indices, int64 limit,
+                   const char* name, std::vector<int64>* out) {
+  out->resize(indices.size());
+  for (int64 e = 0; e < indices.size(); ++e) {
+    const Index index = internal::SubtleMustCopy(indices(e));
+    if (!FastBoundsCheck(index, limit)) {
+      return errors::InvalidArgument(name, "[", e, "] = ", index,
+                                     " is not in [0, ", limit, ")");
+    }
+    (*out)[e] = index;
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+// The entries are grouped by output row, so that every row is accumulated by
+// one thread directly from the rows of params, without materializing the
+// gathered embeddings.
+template <typename T, typename Tidx>
+struct FusedEmbeddingLookupSparseFunctor<CPUDevice, T, Tidx> {
+  void operator()(OpKernelContext* ctx, const CPUDevice& d,
+                  EmbeddingCombiner combiner,
+                  typename TTypes<T, 2>::ConstTensor params,
+                  typename TTypes<Tidx>::ConstFlat ids,
+                  typename TTypes<int64>::ConstFlat segment_ids,
+                  typename TTypes<T>::ConstFlat weights,
+                  typename TTypes<T, 2>::Tensor output) {
+    const int64 num_rows = output.dimension(0);
+    std::vector<int64> rows;
+    OP_REQUIRES_OK(ctx, CopyIndices<int64>(segment_ids, num_rows,
+                                           "segment_ids", &rows));
+    std::vector<int64> id_values;
+    OP_REQUIRES_OK(ctx, CopyIndices<Tidx>(ids, params.dimension(0), "ids",
+                                          &id_values));
+    const std::vector<T> scales =
+        ComputeRowScales<T>(combiner, num_rows, rows, weights);
+    std::vector<int64> starts;
+    std::vector<int64> entries;
+    GroupByKey(rows, num_rows, &starts, &entries);
+
+    auto work = [&](int64 begin, int64 end) {
+      for (int64 r = begin; r < end; ++r) {
+        auto out = output.template chip<0>(r);
+        out.setZero();
+        for (int64 j = starts[r]; j < starts[r + 1]; ++j) {
+          const int64 e = entries[j];
+          out += params.template chip<0>(id_values[e]) *
+                 out.constant(weights(e) * scales[r]);
+        }
+      }
+    };
+    const int64 embedding_size = output.dimension(1);
+    const int64 cost_per_row =
+        (1 + ids.size() / std::max<int64>(num_rows, 1)) * embedding_size * 2;
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_rows,
+          cost_per_row, work);
+  }
+};
+
+// The entries are grouped by unique id, so that the gradient of every looked
+// up row of params is accumulated by one thread.
+template <typename T>
+struct FusedEmbeddingLookupSparseGradFunctor<CPUDevice, T> {
+  void operator()(OpKernelContext* ctx, const CPUDevice& d,
+                  EmbeddingCombiner combiner,
+                  typename TTypes<T, 2>::ConstTensor grad,
+                  typename TTypes<int32>::ConstFlat unique_idx,
+                  typename TTypes<int64>::ConstFlat segment_ids,
+                  typename TTypes<T>::ConstFlat weights,
+                  typename TTypes<T, 2>::Tensor output) {
+    const int64 num_rows = grad.dimension(0);
+    const int64 num_unique = output.dimension(0);
+    std::vector<int64> rows;
+    OP_REQUIRES_OK(ctx, CopyIndices<int64>(segment_ids, num_rows,
+                                           "segment_ids", &rows));
+    std::vector<int64> unique_rows;
+    OP_REQUIRES_OK(ctx, CopyIndices<int32>(unique_idx, num_unique,
+                                           "unique_idx", &unique_rows));
+    const std::vector<T> scales =
+        ComputeRowScales<T>(combiner, num_rows, rows, weights);
+    std::vector<int64> starts;
+    std::vector<int64> entries;
+    GroupByKey(unique_rows, num_unique, &starts, &entries);
+
+    auto work = [&](int64 begin, int64 end) {
+      for (int64 u = begin; u < end; ++u) {
+        auto out = output.template chip<0>(u);
+        out.setZero();
+        for (int64 j = starts[u]; j < starts[u + 1]; ++j) {
+          const int64 e = entries[j];
+          const int64 r = rows[e];
+          out += grad.template chip<0>(r) *
+                 out.constant(weights(e) * scales[r]);
+        }
+      }
+    };
+    const int64 embedding_size = output.dimension(1);
+    const int64 cost_per_row =
+        (1 + unique_idx.size() / std::max<int64>(num_unique, 1)) *
+        embedding_size * 2;
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_unique,
+          cost_per_row, work);
+  }
+};
+
+}  // namespace functor
+
+namespace {
+
+Status ParseCombiner(OpKernelConstruction* ctx,
+                     functor::EmbeddingCombiner* combiner) {
+  string name;
+  TF_RETURN_IF_ERROR(ctx->GetAttr("combiner", &name));
+  if (name == "sum") {
+    *combiner = functor::EmbeddingCombiner::kSum;
+  } else if (name == "mean") {
+    *combiner = functor::EmbeddingCombiner::kMean;
+  } else if (name == "sqrtn") {
+    *combiner = functor::EmbeddingCombiner::kSqrtN;
+  } else {
+    return errors::InvalidArgument("Unknown combiner: ", name);
+  }
+  return Status::OK();
+}
+
+// Checks that 'ids' or 'unique_idx', 'segment_ids' and 'weights' are vectors
+// of the same size.
+Status ValidateEntries(const Tensor& ids, const Tensor& segment_ids,
+                       const Tensor& weights) {
+  if (!TensorShapeUtils::IsVector(ids.shape())) {
+    return errors::InvalidArgument("ids must be a vector, got shape ",
+                                   ids.shape().DebugString());
+  }
+  if (segment_ids.shape() != ids.shape()) {
+    return errors::InvalidArgument(
+        "segment_ids must have the same shape as ids: ",
+        segment_ids.shape().DebugString(), " vs. ", ids.shape().DebugString());
+  }
+  if (weights.shape() != ids.shape()) {
+    return errors::InvalidArgument(
+        "weights must have the same shape as ids: ",
+        weights.shape().DebugString(), " vs. ", ids.shape().DebugString());
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+template <typename Device, typename T, typename Tidx>
+class FusedEmbeddingLookupSparseOp : public OpKernel {
+ public:
+  explicit FusedEmbeddingLookupSparseOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ParseCombiner(ctx, &combiner_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& params = ctx->input(0);
+    const Tensor& ids = ctx->input(1);
+    const Tensor& segment_ids = ctx->input(2);
+    const Tensor& weights = ctx->input(3);
+    const Tensor& num_rows = ctx->input(4);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVectorOrHigher(params.shape()),
+                errors::InvalidArgument("params must be at least 1-D, got ",
+                                        params.shape().DebugString()));
+    OP_REQUIRES_OK(ctx, ValidateEntries(ids, segment_ids, weights));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(num_rows.shape()),
+                errors::InvalidArgument("num_rows must be a scalar, got ",
+                                        num_rows.shape().DebugString()));
+    const int64 output_rows = num_rows.scalar<int64>()();
+    OP_REQUIRES(ctx, output_rows >= 0,
+                errors::InvalidArgument("num_rows must be non-negative, got ",
+                                        output_rows));
+
+    TensorShape output_shape = params.shape();
+    output_shape.set_dim(0, output_rows);
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) {
+      return;
+    }
+    functor::FusedEmbeddingLookupSparseFunctor<Device, T, Tidx>()(
+        ctx, ctx->eigen_device<Device>(), combiner_,
+        params.flat_outer_dims<T>(), ids.flat<Tidx>(),
+        segment_ids.flat<int64>(), weights.flat<T>(),
+        output->flat_outer_dims<T>());
+  }
+
+ private:
+  functor::EmbeddingCombiner combiner_;
+};
+
+template <typename Device, typename T>
+class FusedEmbeddingLookupSparseGradOp : public OpKernel {
+ public:
+  explicit FusedEmbeddingLookupSparseGradOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ParseCombiner(ctx, &combiner_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& grad = ctx->input(0);
+    const Tensor& unique_idx = ctx->input(1);
+    const Tensor& segment_ids = ctx->input(2);
+    const Tensor& weights = ctx->input(3);
+    const Tensor& num_unique = ctx->input(4);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVectorOrHigher(grad.shape()),
+                errors::InvalidArgument("grad must be at least 1-D, got ",
+                                        grad.shape().DebugString()));
+    OP_REQUIRES_OK(ctx, ValidateEntries(unique_idx, segment_ids, weights));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(num_unique.shape()),
+                errors::InvalidArgument("num_unique must be a scalar, got ",
+                                        num_unique.shape().DebugString()));
+    const int32 output_rows = num_unique.scalar<int32>()();
+    OP_REQUIRES(ctx, output_rows >= 0,
+                errors::InvalidArgument(
+                    "num_unique must be non-negative, got ", output_rows));
+
+    TensorShape output_shape = grad.shape();
+    output_shape.set_dim(0, output_rows);
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) {
+      return;
+    }
+    functor::FusedEmbeddingLookupSparseGradFunctor<Device, T>()(
+        ctx, ctx->eigen_device<Device>(), combiner_, grad.flat_outer_dims<T>(),
+        unique_idx.flat<int32>(), segment_ids.flat<int64>(), weights.flat<T>(),
+        output->flat_outer_dims<T>());
+  }
+
+ private:
+  functor::EmbeddingCombiner combiner_;
+};
+
+#define REGISTER_KERNELS(D, type, index_type)                               \
+  REGISTER_KERNEL_BUILDER(Name("FusedEmbeddingLookupSparse")                \
+                              .Device(DEVICE_##D)                           \
+                              .HostMemory("num_rows")                       \
+                              .TypeConstraint<type>("T")                    \
+                              .TypeConstraint<index_type>("Tidx"),          \
+                          FusedEmbeddingLookupSparseOp<D##Device, type,     \
+                                                       index_type>);
+
+#define REGISTER_GRAD_KERNELS(D, type)                                      \
+  REGISTER_KERNEL_BUILDER(Name("FusedEmbeddingLookupSparseGrad")            \
+                              .Device(DEVICE_##D)                           \
+                              .HostMemory("num_unique")                     \
+                              .TypeConstraint<type>("T"),                   \
+                          FusedEmbeddingLookupSparseGradOp<D##Device, type>);
+
+#define REGISTER_CPU_KERNELS(type)   \
+  REGISTER_KERNELS(CPU, type, int32) \
+  REGISTER_KERNELS(CPU, type, int64) \
+  REGISTER_GRAD_KERNELS(CPU, type)
+
+REGISTER_CPU_KERNELS(float);
+REGISTER_CPU_KERNELS(double);
+
+#undef REGISTER_CPU_KERNELS
+
+#if GOOGLE_CUDA
+
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                                 \
+  extern template struct FusedEmbeddingLookupSparseFunctor<GPUDevice, T,    \
+                                                           int32>;          \
+  extern template struct FusedEmbeddingLookupSparseFunctor<GPUDevice, T,    \
+                                                           int64>;          \
+  extern template struct FusedEmbeddingLookupSparseGradFunctor<GPUDevice, T>;
+
+DECLARE_GPU_SPEC(float);
+DECLARE_GPU_SPEC(double);
+
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+#define REGISTER_GPU_KERNELS(type)   \
+  REGISTER_KERNELS(GPU, type, int32) \
+  REGISTER_KERNELS(GPU, type, int64) \
+  REGISTER_GRAD_KERNELS(GPU, type)
+
+REGISTER_GPU_KERNELS(float);
+REGISTER_GPU_KERNELS(double);
+
+#undef REGISTER_GPU_KERNELS
+
+#endif  // GOOGLE_CUDA
+
+#undef REGISTER_GRAD_KERNELS
+#undef REGISTER_KERNELS
+
+}  // namespace tensorflow
@@ -0,0 +1,75 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_FUSED_EMBEDDING_OPS_H_
+#define TENSORFLOW_CORE_KERNELS_FUSED_EMBEDDING_OPS_H_
+
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class OpKernelContext;
+
+namespace functor {
+
+// How the weighted embeddings of the ids of one output row are combined.
+enum class EmbeddingCombiner { kSum, kMean, kSqrtN };
+
+// Functor for FusedEmbeddingLookupSparseOp. Computes
+//
+//   output[r] = sum_{e : segment_ids(e) == r} weights(e) * params[ids(e)]
+//
+// scaled by 1, 1 / sum(weights) or 1 / sqrt(sum(weights^2)) over the entries
+// of row r, depending on `combiner`. Rows without entries are zero. The
+// entries don't need to be sorted by segment id.
+//
+// params: the embeddings reshaped to {vocab_size, embedding_size}.
+// output: the result reshaped to {num_rows, embedding_size}.
+template <typename Device, typename T, typename Tidx>
+struct FusedEmbeddingLookupSparseFunctor {
+  void operator()(OpKernelContext* ctx, const Device& d,
+                  EmbeddingCombiner combiner,
+                  typename TTypes<T, 2>::ConstTensor params,
+                  typename TTypes<Tidx>::ConstFlat ids,
+                  typename TTypes<int64>::ConstFlat segment_ids,
+                  typename TTypes<T>::ConstFlat weights,
+                  typename TTypes<T, 2>::Tensor output);
+};
+
+// Functor for FusedEmbeddingLookupSparseGradOp. Computes the gradient with
+// respect to the rows of params that were looked up:
+//
+//   output[u] = sum_{e : unique_idx(e) == u} weights(e) * scale(r) * grad[r]
+//
+// where r = segment_ids(e) and scale(r) is the combiner scale of row r.
+//
+// grad: the gradient of the output, reshaped to {num_rows, embedding_size}.
+// output: the result reshaped to {num_unique, embedding_size}.
+template <typename Device, typename T>
+struct FusedEmbeddingLookupSparseGradFunctor {
+  void operator()(OpKernelContext* ctx, const Device& d,
+                  EmbeddingCombiner combiner,
+                  typename TTypes<T, 2>::ConstTensor grad,
+                  typename TTypes<int32>::ConstFlat unique_idx,
+                  typename TTypes<int64>::ConstFlat segment_ids,
+                  typename TTypes<T>::ConstFlat weights,
+                  typename TTypes<T, 2>::Tensor output);
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_FUSED_EMBEDDING_OPS_H_
@@ -0,0 +1,208 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/kernels/fused_embedding_ops.h"
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/util/cuda_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+// Accumulates the weights (or their squares for sqrtn) of the entries of
+// every row into sums.
+template <typename T>
+__global__ void RowWeightSumsKernel(int32 num_entries, bool squared,
+                                    int64 num_rows, const int64* segment_ids,
+                                    const T* weights, T* sums) {
+  CUDA_1D_KERNEL_LOOP(e, num_entries) {
+    const int64 row = ldg(segment_ids + e);
+    if (!FastBoundsCheck(row, num_rows)) {
+      continue;
+    }
+    const T weight = ldg(weights + e);
+    CudaAtomicAdd(sums + row, squared ? weight * weight : weight);
+  }
+}
+
+// Turns the row sums computed by RowWeightSumsKernel into combiner scales.
+template <typename T>
+__global__ void RowScalesKernel(int32 num_rows, bool sqrtn, T* scales) {
+  CUDA_1D_KERNEL_LOOP(r, num_rows) {
+    scales[r] = T(1) / (sqrtn ? Eigen::numext::sqrt(scales[r]) : scales[r]);
+  }
+}
+
+// Adds weights(e) * scale(segment_ids(e)) * input[input_rows(e)] to
+// output[output_rows(e)] for every entry e, with one thread per element of
+// the embedding. Entries with out of range indices are skipped, like in the
+// GPU kernels of Gather and UnsortedSegmentSum.
+template <typename T, typename InputIndex, typename OutputIndex>
+__global__ void ScatterWeightedRowsKernel(
+    int32 size, int64 embedding_size, const InputIndex* input_rows,
+    int64 num_input_rows, const OutputIndex* output_rows,
+    int64 num_output_rows, const int64* segment_ids, const T* weights,
+    const T* scales, const T* input, T* output) {
+  CUDA_1D_KERNEL_LOOP(i, size) {
+    const int64 e = i / embedding_size;
+    const int64 j = i - e * embedding_size;
+    const int64 input_row = ldg(input_rows + e);
+    const int64 output_row = ldg(output_rows + e);
+    if (!FastBoundsCheck(input_row, num_input_rows) ||
+        !FastBoundsCheck(output_row, num_output_rows)) {
+      continue;
+    }
+    const int64 segment = ldg(segment_ids + e);
+    T scale = ldg(weights + e);
+    if (scales != nullptr) {
+      scale *= ldg(scales + segment);
+    }
+    CudaAtomicAdd(output + output_row * embedding_size + j,
+                  ldg(input + input_row * embedding_size + j) * scale);
+  }
+}
+
+// Returns the combiner scales of the `num_rows` rows in `scales`, or sets it
+// to nullptr if they are all 1.
+template <typename T>
+Status ComputeRowScales(OpKernelContext* ctx, const GPUDevice& d,
+                        functor::EmbeddingCombiner combiner, int64 num_rows,
+                        typename TTypes<int64>::ConstFlat segment_ids,
+                        typename TTypes<T>::ConstFlat weights,
+                        Tensor* scales_tensor, const T** scales) {
+  if (combiner == functor::EmbeddingCombiner::kSum) {
+    *scales = nullptr;
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(DataTypeToEnum<T>::value,
+                                        TensorShape({num_rows}),
+                                        scales_tensor));
+  T* data = scales_tensor->flat<T>().data();
+  const bool sqrtn = combiner == functor::EmbeddingCombiner::kSqrtN;
+  CudaLaunchConfig config = GetCudaLaunchConfig(num_rows, d);
+  SetZero<<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+      num_rows, data);
+  const int32 num_entries = segment_ids.size();
+  if (num_entries > 0) {
+    config = GetCudaLaunchConfig(num_entries, d);
+    RowWeightSumsKernel<T>
+        <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+            num_entries, sqrtn, num_rows, segment_ids.data(), weights.data(),
+            data);
+  }
+  config = GetCudaLaunchConfig(num_rows, d);
+  RowScalesKernel<T>
+      <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+          num_rows, sqrtn, data);
+  *scales = data;
+  return Status::OK();
+}
+
+}  // namespace
+
+namespace functor {
+
+// Every element of every looked up embedding is added to the output with an
+// atomic add, so the gathered embeddings are never materialized.
+template <typename T, typename Tidx>
+struct FusedEmbeddingLookupSparseFunctor<GPUDevice, T, Tidx> {
+  void operator()(OpKernelContext* ctx, const GPUDevice& d,
+                  EmbeddingCombiner combiner,
+                  typename TTypes<T, 2>::ConstTensor params,
+                  typename TTypes<Tidx>::ConstFlat ids,
+                  typename TTypes<int64>::ConstFlat segment_ids,
+                  typename TTypes<T>::ConstFlat weights,
+                  typename TTypes<T, 2>::Tensor output) {
+    const int64 num_rows = output.dimension(0);
+    const int64 embedding_size = output.dimension(1);
+    Tensor scales_tensor;
+    const T* scales;
+    OP_REQUIRES_OK(ctx, ComputeRowScales<T>(ctx, d, combiner, num_rows,
+                                            segment_ids, weights,
+                                            &scales_tensor, &scales));
+
+    CudaLaunchConfig config = GetCudaLaunchConfig(output.size(), d);
+    SetZero<<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+        output.size(), output.data());
+    const int64 size = ids.size() * embedding_size;
+    if (size == 0) {
+      return;
+    }
+    config = GetCudaLaunchConfig(size, d);
+    ScatterWeightedRowsKernel<T, Tidx, int64>
+        <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+            size, embedding_size, ids.data(), params.dimension(0),
+            segment_ids.data(), num_rows, segment_ids.data(), weights.data(),
+            scales, params.data(), output.data());
+  }
+};
+
+template <typename T>
+struct FusedEmbeddingLookupSparseGradFunctor<GPUDevice, T> {
+  void operator()(OpKernelContext* ctx, const GPUDevice& d,
+                  EmbeddingCombiner combiner,
+                  typename TTypes<T, 2>::ConstTensor grad,
+                  typename TTypes<int32>::ConstFlat unique_idx,
+                  typename TTypes<int64>::ConstFlat segment_ids,
+                  typename TTypes<T>::ConstFlat weights,
+                  typename TTypes<T, 2>::Tensor output) {
+    const int64 num_rows = grad.dimension(0);
+    const int64 embedding_size = output.dimension(1);
+    Tensor scales_tensor;
+    const T* scales;
+    OP_REQUIRES_OK(ctx, ComputeRowScales<T>(ctx, d, combiner, num_rows,
+                                            segment_ids, weights,
+                                            &scales_tensor, &scales));
+
+    CudaLaunchConfig config = GetCudaLaunchConfig(output.size(), d);
+    SetZero<<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+        output.size(), output.data());
+    const int64 size = unique_idx.size() * embedding_size;
+    if (size == 0) {
+      return;
+    }
+    config = GetCudaLaunchConfig(size, d);
+    ScatterWeightedRowsKernel<T, int64, int32>
+        <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+            size, embedding_size, segment_ids.data(), num_rows,
+            unique_idx.data(), output.dimension(0), segment_ids.data(),
+            weights.data(), scales, grad.data(), output.data());
+  }
+};
+
+#define DEFINE_GPU_SPECS(T)                                                 \
+  template struct FusedEmbeddingLookupSparseFunctor<GPUDevice, T, int32>; \
+  template struct FusedEmbeddingLookupSparseFunctor<GPUDevice, T, int64>; \
+  template struct FusedEmbeddingLookupSparseGradFunctor<GPUDevice, T>;
+
+DEFINE_GPU_SPECS(float);
+DEFINE_GPU_SPECS(double);
+
+#undef DEFINE_GPU_SPECS
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
@@ -0,0 +1,137 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/fused_layer_norm_op.h"
+
+#include <cmath>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace functor {
+
+// Normalizes a row while it is in the cache: the mean, the variance and the
+// output each take a pass over the row, which is read from memory once.
+template <typename T>
+struct FusedLayerNorm<CPUDevice, T> {
+  void operator()(OpKernelContext* context,
+                  typename TTypes<T>::ConstMatrix x,
+                  typename TTypes<T>::ConstVec scale,
+                  typename TTypes<T>::ConstVec offset, float epsilon,
+                  typename TTypes<T>::Matrix y) {
+    typedef Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>> ConstRow;
+    typedef Eigen::Map<Eigen::Array<T, 1, Eigen::Dynamic>> Row;
+    const int64 depth = x.dimension(1);
+    const T* x_data = x.data();
+    const T* scale_data = scale.data();
+    const T* offset_data = offset.data();
+    T* y_data = y.data();
+    auto normalize_rows = [=](int64 begin, int64 end) {
+      ConstRow scale_row(scale_data, depth);
+      ConstRow offset_row(offset_data, depth);
+      for (int64 i = begin; i < end; ++i) {
+        ConstRow x_row(x_data + i * depth, depth);
+        Row y_row(y_data + i * depth, depth);
+        const T mean = x_row.mean();
+        const T variance = (x_row - mean).square().mean();
+        const T inverse_stddev = T(1) / std::sqrt(variance + T(epsilon));
+        y_row = (x_row - mean) * inverse_stddev * scale_row + offset_row;
+      }
+    };
+    const Eigen::TensorOpCost row_cost(depth * sizeof(T), depth * sizeof(T),
+                                       depth * 8);
+    context->eigen_device<CPUDevice>().parallelFor(x.dimension(0), row_cost,
+                                                    normalize_rows);
+  }
+};
+
+}  // namespace functor
+
+template <typename Device, typename T>
+class FusedLayerNormOp : public OpKernel {
+ public:
+  explicit FusedLayerNormOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &epsilon_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    const Tensor& scale = context->input(1);
+    const Tensor& offset = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(x.shape()),
+                errors::InvalidArgument("x must have >= 1 dimension, got ",
+                                        x.shape().DebugString()));
+    const int64 depth = x.dim_size(x.dims() - 1);
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(scale.shape()) &&
+                    scale.NumElements() == depth,
+                errors::InvalidArgument("scale must be a vector of ", depth,
+                                        " values, got ",
+                                        scale.shape().DebugString()));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(offset.shape()) &&
+                    offset.NumElements() == depth,
+                errors::InvalidArgument("offset must be a vector of ", depth,
+                                        " values, got ",
+                                        offset.shape().DebugString()));
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, x.shape(), &y));
+    if (x.NumElements() == 0) return;
+    functor::FusedLayerNorm<Device, T>()(
+        context, x.flat_inner_dims<T>(), scale.vec<T>(), offset.vec<T>(),
+        epsilon_, y->flat_inner_dims<T>());
+  }
+
+ private:
+  float epsilon_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedLayerNorm").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    FusedLayerNormOp<CPUDevice, float>);
+
+#if GOOGLE_CUDA
+// Forward declaration of the functor specialization for GPU.
+namespace functor {
+template <>
+void FusedLayerNorm<GPUDevice, float>::operator()(
+    OpKernelContext* context, typename TTypes<float>::ConstMatrix x,
+    typename TTypes<float>::ConstVec scale,
+    typename TTypes<float>::ConstVec offset, float epsilon,
+    typename TTypes<float>::Matrix y);
+extern template struct FusedLayerNorm<GPUDevice, float>;
+}  // namespace functor
+
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedLayerNorm").Device(DEVICE_GPU).TypeConstraint<float>("T"),
+    FusedLayerNormOp<GPUDevice, float>);
+#endif  // GOOGLE_CUDA
+
+}  // namespace tensorflow
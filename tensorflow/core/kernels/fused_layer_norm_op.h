@@ -0,0 +1,39 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_FUSED_LAYER_NORM_OP_H_
+#define TENSORFLOW_CORE_KERNELS_FUSED_LAYER_NORM_OP_H_
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_types.h"
+
+namespace tensorflow {
+namespace functor {
+
+// Normalizes each row of 'x' to a mean of 0 and a variance of 1, then scales
+// it by 'scale' and adds 'offset', a row at a time.
+template <typename Device, typename T>
+struct FusedLayerNorm {
+  void operator()(OpKernelContext* context,
+                  typename TTypes<T>::ConstMatrix x,
+                  typename TTypes<T>::ConstVec scale,
+                  typename TTypes<T>::ConstVec offset, float epsilon,
+                  typename TTypes<T>::Matrix y);
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_FUSED_LAYER_NORM_OP_H_
@@ -0,0 +1,143 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/kernels/fused_layer_norm_op.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/util/cuda_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+constexpr int kMaxThreads = 256;
+constexpr int kWarpSize = 32;
+
+// Merges the count, mean and sum of squared deviations of a part of a row
+// into those of another part (Chan et al.'s parallel Welford update).
+__device__ EIGEN_STRONG_INLINE void MergeMoments(float other_count,
+                                                 float other_mean,
+                                                 float other_m2, float* count,
+                                                 float* mean, float* m2) {
+  const float total = *count + other_count;
+  if (total == 0) return;
+  const float delta = other_mean - *mean;
+  const float other_fraction = other_count / total;
+  *mean += delta * other_fraction;
+  *m2 += other_m2 + delta * delta * *count * other_fraction;
+  *count = total;
+}
+
+__device__ EIGEN_STRONG_INLINE void WarpMergeMoments(float* count, float* mean,
+                                                     float* m2) {
+  for (int lane_mask = kWarpSize / 2; lane_mask > 0; lane_mask /= 2) {
+    const float other_count = CudaShuffleXorSync(kCudaWarpAll, *count,
+                                                 lane_mask);
+    const float other_mean = CudaShuffleXorSync(kCudaWarpAll, *mean,
+                                                lane_mask);
+    const float other_m2 = CudaShuffleXorSync(kCudaWarpAll, *m2, lane_mask);
+    MergeMoments(other_count, other_mean, other_m2, count, mean, m2);
+  }
+}
+
+// Normalizes a row per block. The threads of the block compute the moments
+// of their columns with Welford's update, in a single read of the row, and
+// merge them with warp shuffles. The row is then read again, from the cache,
+// to write the output.
+__global__ void FusedLayerNormKernel(const float* x, const float* scale,
+                                     const float* offset, float epsilon,
+                                     int depth, float* y) {
+  __shared__ float shared_count[kMaxThreads / kWarpSize];
+  __shared__ float shared_mean[kMaxThreads / kWarpSize];
+  __shared__ float shared_m2[kMaxThreads / kWarpSize];
+  const float* row_x = x + static_cast<int64>(blockIdx.x) * depth;
+  float* row_y = y + static_cast<int64>(blockIdx.x) * depth;
+
+  float count = 0;
+  float mean = 0;
+  float m2 = 0;
+  for (int i = threadIdx.x; i < depth; i += blockDim.x) {
+    const float value = ldg(row_x + i);
+    count += 1;
+    const float delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+  }
+  WarpMergeMoments(&count, &mean, &m2);
+  const int warp = threadIdx.x / kWarpSize;
+  const int lane = threadIdx.x % kWarpSize;
+  const int num_warps = blockDim.x / kWarpSize;
+  if (num_warps > 1) {
+    if (lane == 0) {
+      shared_count[warp] = count;
+      shared_mean[warp] = mean;
+      shared_m2[warp] = m2;
+    }
+    __syncthreads();
+    if (warp == 0) {
+      count = lane < num_warps ? shared_count[lane] : 0;
+      mean = lane < num_warps ? shared_mean[lane] : 0;
+      m2 = lane < num_warps ? shared_m2[lane] : 0;
+      WarpMergeMoments(&count, &mean, &m2);
+      if (lane == 0) {
+        shared_mean[0] = mean;
+        shared_m2[0] = m2;
+      }
+    }
+    __syncthreads();
+    mean = shared_mean[0];
+    m2 = shared_m2[0];
+  }
+
+  const float inverse_stddev = rsqrtf(m2 / depth + epsilon);
+  for (int i = threadIdx.x; i < depth; i += blockDim.x) {
+    row_y[i] = (ldg(row_x + i) - mean) * inverse_stddev * ldg(scale + i) +
+               ldg(offset + i);
+  }
+}
+
+}  // namespace
+
+namespace functor {
+
+template <>
+void FusedLayerNorm<GPUDevice, float>::operator()(
+    OpKernelContext* context, typename TTypes<float>::ConstMatrix x,
+    typename TTypes<float>::ConstVec scale,
+    typename TTypes<float>::ConstVec offset, float epsilon,
+    typename TTypes<float>::Matrix y) {
+  const int rows = x.dimension(0);
+  const int depth = x.dimension(1);
+  const int num_threads =
+      std::min(kMaxThreads,
+               static_cast<int>(Eigen::divup(depth, kWarpSize)) * kWarpSize);
+  const GPUDevice& d = context->eigen_device<GPUDevice>();
+  FusedLayerNormKernel<<<rows, num_threads, 0, d.stream()>>>(
+      x.data(), scale.data(), offset.data(), epsilon, depth, y.data());
+}
+
+template struct FusedLayerNorm<GPUDevice, float>;
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
@@ -0,0 +1,105 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class FusedLayerNormOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(float epsilon) {
+    TF_ASSERT_OK(NodeDefBuilder("layer_norm", "_FusedLayerNorm")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("epsilon", epsilon)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(FusedLayerNormOpTest, Simple) {
+  MakeOp(0);
+  AddInputFromArray<float>(TensorShape({2, 4}), {1, 2, 3, 4, 5, 5, 5, 9});
+  AddInputFromArray<float>(TensorShape({4}), {1, 2, 1, 1});
+  AddInputFromArray<float>(TensorShape({4}), {0, 0, 0, 1});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // The rows have means of 2.5 and 6, and variances of 1.25 and 3.
+  const float a = 1 / std::sqrt(1.25f), b = 1 / std::sqrt(3.0f);
+  Tensor expected(DT_FLOAT, TensorShape({2, 4}));
+  test::FillValues<float>(&expected, {-1.5f * a, -1.0f * a, 0.5f * a,
+                                      1.5f * a + 1, -b, -2 * b, -b, 3 * b + 1});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(FusedLayerNormOpTest, LongRows) {
+  const int rows = 5, depth = 1000;
+  const float epsilon = 1e-3;
+  MakeOp(epsilon);
+  Tensor x(DT_FLOAT, TensorShape({rows, 2, depth}));
+  x.flat<float>().setRandom();
+  x.flat<float>() = x.flat<float>() * 4.0f + 100.0f;
+  Tensor scale(DT_FLOAT, TensorShape({depth}));
+  scale.flat<float>().setRandom();
+  Tensor offset(DT_FLOAT, TensorShape({depth}));
+  offset.flat<float>().setRandom();
+  AddInputFromArray<float>(x.shape(), x.flat<float>());
+  AddInputFromArray<float>(scale.shape(), scale.flat<float>());
+  AddInputFromArray<float>(offset.shape(), offset.flat<float>());
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_FLOAT, x.shape());
+  for (int i = 0; i < rows * 2; ++i) {
+    const float* row = x.flat<float>().data() + i * depth;
+    double mean = 0, variance = 0;
+    for (int j = 0; j < depth; ++j) mean += row[j];
+    mean /= depth;
+    for (int j = 0; j < depth; ++j) {
+      variance += (row[j] - mean) * (row[j] - mean);
+    }
+    variance /= depth;
+    for (int j = 0; j < depth; ++j) {
+      expected.flat<float>()(i * depth + j) =
+          (row[j] - mean) / std::sqrt(variance + epsilon) *
+              scale.flat<float>()(j) +
+          offset.flat<float>()(j);
+    }
+  }
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-4);
+}
+
+TEST_F(FusedLayerNormOpTest, ScaleOfWrongSize) {
+  MakeOp(0);
+  AddInputFromArray<float>(TensorShape({1, 3}), {1, 2, 3});
+  AddInputFromArray<float>(TensorShape({2}), {1, 1});
+  AddInputFromArray<float>(TensorShape({3}), {0, 0, 0});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(str_util::StrContains(s.ToString(),
+                                    "scale must be a vector of 3 values"))
+      << s;
+}
+
+}  // namespace tensorflow
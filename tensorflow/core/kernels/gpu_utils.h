@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/util/autotune_cache.h"
 
 namespace tensorflow {
 
@@ -35,6 +36,77 @@ inline se::DeviceMemory<T> AsDeviceMemory(const T* cuda_memory, uint64 size) {
   return typed;
 }
 
+// Returns the AutotuneCache device key of the CUDA GPU `device_ordinal`, or
+// an empty string if there is no such GPU.
+inline string GpuAutotuneDeviceKey(int device_ordinal) {
+  auto platform = se::MultiPlatformManager::PlatformWithName("CUDA");
+  if (!platform.ok()) {
+    return "";
+  }
+  auto stream_exec = platform.ValueOrDie()->ExecutorForDevice(device_ordinal);
+  if (!stream_exec.ok()) {
+    return "";
+  }
+  const se::DeviceDescription& description =
+      stream_exec.ValueOrDie()->GetDeviceDescription();
+  int cc_major = 0;
+  int cc_minor = 0;
+  description.cuda_compute_capability(&cc_major, &cc_minor);
+  string dnn_version = "unknown";
+  if (auto* dnn = stream_exec.ValueOrDie()->AsDnn()) {
+    auto version_or = dnn->GetVersion();
+    if (version_or.ok()) {
+      se::dnn::VersionInfo version = version_or.ValueOrDie();
+      dnn_version = strings::StrCat(version.major_version(), ".",
+                                    version.minor_version(), ".",
+                                    version.patch());
+    }
+  }
+  return AutotuneDeviceKey(description.name(), cc_major, cc_minor,
+                           dnn_version);
+}
+
+// Hooks that let an AutoTuneMap share its results through the process-wide
+// AutotuneCache, when that is persistent. By default results are not shared:
+// parameters opt in by overloading GetAutotuneCacheKey() in their namespace,
+// and configs by overloading the two conversions below.
+template <typename Parameters>
+bool GetAutotuneCacheKey(const Parameters& params, string* device,
+                         string* key) {
+  return false;
+}
+
+template <typename Config>
+bool ConfigToAutotuneCacheEntry(const Config& config,
+                                AutotuneCacheEntry* entry) {
+  return false;
+}
+
+template <typename Config>
+bool ConfigFromAutotuneCacheEntry(const AutotuneCacheEntry& entry,
+                                  Config* config) {
+  return false;
+}
+
+inline bool ConfigToAutotuneCacheEntry(const se::dnn::AlgorithmConfig& config,
+                                       AutotuneCacheEntry* entry) {
+  entry->set_algorithm(config.algorithm().algo_id());
+  entry->set_tensor_ops_enabled(config.algorithm().tensor_ops_enabled());
+  entry->set_algorithm_no_scratch(config.algorithm_no_scratch().algo_id());
+  entry->set_no_scratch_tensor_ops_enabled(
+      config.algorithm_no_scratch().tensor_ops_enabled());
+  return true;
+}
+
+inline bool ConfigFromAutotuneCacheEntry(const AutotuneCacheEntry& entry,
+                                         se::dnn::AlgorithmConfig* config) {
+  config->set_algorithm(
+      se::dnn::AlgorithmDesc(entry.algorithm(), entry.tensor_ops_enabled()));
+  config->set_algorithm_no_scratch(se::dnn::AlgorithmDesc(
+      entry.algorithm_no_scratch(), entry.no_scratch_tensor_ops_enabled()));
+  return true;
+}
+
 // A helper class that looks up the best autotuned config from parameters.
 // Due to the noisy nature of autotune, especially with multiple devices, it
 // only accepts a config if its margin exceeds a threshold.
@@ -45,15 +117,21 @@ inline se::DeviceMemory<T> AsDeviceMemory(const T* cuda_memory, uint64 size) {
 // back and forth randomly, the expected number of experiments before autotune
 // settles is O(threshold ^ 2). So we recommend that number of warmup runs
 // for any benchmarks.
+//
+// When the AutotuneCache is persistent and the parameters and configs support
+// it, accepted configs are also written to the cache, and configs found in the
+// cache are accepted without autotuning.
 template <typename Parameters, typename Config>
 class AutoTuneMap {
  public:
   bool Find(const Parameters& params, Config* config) const {
     mutex_lock lock(mu_);
     auto iter = params_config_map_.find(params);
-    if (iter == params_config_map_.end() ||
-        (iter->second.score < min_score_threshold_ &&
-         iter->second.count <= max_autotune_count_)) {
+    if (iter == params_config_map_.end()) {
+      return FindInCache(params, config);
+    }
+    if (iter->second.score < min_score_threshold_ &&
+        iter->second.count <= max_autotune_count_) {
       return false;
     }
     *config = iter->second.config;
@@ -90,6 +168,7 @@ class AutoTuneMap {
     }
     if (new_score >= min_score_threshold_) {
       VLOG(1) << GetActionSummary("accepts", params, config);
+      InsertInCache(params, config);
     }
   }
 
@@ -120,8 +199,39 @@ class AutoTuneMap {
     }
   };
 
+  // Looks up `params` in the AutotuneCache, and accepts the config found.
+  bool FindInCache(const Parameters& params, Config* config) const
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    AutotuneCache* cache = AutotuneCache::Global();
+    string device, key;
+    AutotuneCacheEntry entry;
+    if (!cache->persistent() || !GetAutotuneCacheKey(params, &device, &key) ||
+        !cache->Find(device, strings::StrCat(name_, ": ", key), &entry) ||
+        !ConfigFromAutotuneCacheEntry(entry, config)) {
+      return false;
+    }
+    VLOG(1) << GetActionSummary("loads", params, *config);
+    params_config_map_.insert(std::make_pair(
+        params, ValueType{*config, min_score_threshold_, 1}));
+    return true;
+  }
+
+  void InsertInCache(const Parameters& params, const Config& config) const
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    AutotuneCache* cache = AutotuneCache::Global();
+    string device, key;
+    AutotuneCacheEntry entry;
+    if (!cache->persistent() || !GetAutotuneCacheKey(params, &device, &key) ||
+        !ConfigToAutotuneCacheEntry(config, &entry)) {
+      return;
+    }
+    entry.set_device(device);
+    entry.set_key(strings::StrCat(name_, ": ", key));
+    cache->Insert(entry);
+  }
+
   string GetActionSummary(StringPiece action, const Parameters& params,
-                          const Config& config) {
+                          const Config& config) const {
     return strings::Printf("autotune_map %s %s: %s -> (%s)", name_.c_str(),
                            string(action).c_str(), params.ToString().c_str(),
                            config.ToString().c_str());
@@ -133,7 +243,8 @@ class AutoTuneMap {
     int32 score;
     int32 count;
   };
-  std::unordered_map<Parameters, ValueType, Hasher> params_config_map_
+  // Mutable so that Find() can add the configs found in the AutotuneCache.
+  mutable std::unordered_map<Parameters, ValueType, Hasher> params_config_map_
       GUARDED_BY(mu_);
   string name_;
   int32 min_score_threshold_;
@@ -50,7 +50,13 @@ Status InitializableLookupTable::Initialize(InitTableIterator& iter) {
     return errors::FailedPrecondition("Table already initialized.");
   }
 
-  TF_RETURN_IF_ERROR(DoLazyPrepare([&iter]() { return iter.total_size(); }));
+  const int64 size_hint = iter.size_hint();
+  if (size_hint >= 0) {
+    TF_RETURN_IF_ERROR(DoPrepare(size_hint));
+  } else {
+    TF_RETURN_IF_ERROR(
+        DoLazyPrepare([&iter]() { return iter.total_size(); }));
+  }
   while (iter.Valid()) {
     TF_RETURN_IF_ERROR(DoInsert(iter.keys(), iter.values()));
     iter.Next();
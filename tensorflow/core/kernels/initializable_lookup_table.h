@@ -121,6 +121,10 @@ class InitializableLookupTable : public LookupInterface {
     // It might return -1 in case of error.
     virtual int64 total_size() const = 0;
 
+    // Returns an estimate of total_size() that is cheap to compute, used to
+    // size the table before populating it, or -1 if there is none.
+    virtual int64 size_hint() const { return -1; }
+
    private:
     TF_DISALLOW_COPY_AND_ASSIGN(InitTableIterator);
   };
@@ -199,6 +203,8 @@ class KeyValueTensorIterator
     return keys_ == nullptr ? -1 : keys_->NumElements();
   }
 
+  int64 size_hint() const override { return total_size(); }
+
  private:
   TF_DISALLOW_COPY_AND_ASSIGN(KeyValueTensorIterator);
 
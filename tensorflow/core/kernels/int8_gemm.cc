@@ -0,0 +1,303 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/int8_gemm.h"
+
+#include <string.h>
+#include <algorithm>
+
+#if defined(__AVX512F__) && defined(__AVX512VNNI__)
+#define TF_INT8_GEMM_USE_VNNI 1
+#include <immintrin.h>
+#elif defined(__AVX2__)
+#define TF_INT8_GEMM_USE_AVX2 1
+#include <immintrin.h>
+#endif
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace int8_gemm {
+
+#ifdef TF_INT8_GEMM_USE_VNNI
+
+namespace {
+
+// vpdpbusd multiplies groups of this many bytes into each 32-bit lane.
+constexpr int64 kDepthGroup = 4;
+
+// Accumulates the products of kRows rows of A, each given as k4 words of
+// four offset bytes, and a block of kColumnBlock columns of B into `acc`.
+template <int kRows>
+inline void VnniBlock(const uint32* a_words, int64 k4, const int8* b_block,
+                      __m512i* acc) {
+  for (int r = 0; r < kRows; ++r) {
+    acc[r] = _mm512_setzero_si512();
+  }
+  for (int64 kb = 0; kb < k4; ++kb) {
+    const __m512i b = _mm512_loadu_si512(b_block + kb * 64);
+    for (int r = 0; r < kRows; ++r) {
+      const __m512i a =
+          _mm512_set1_epi32(static_cast<int32>(a_words[r * k4 + kb]));
+      acc[r] = _mm512_dpbusd_epi32(acc[r], a, b);
+    }
+  }
+}
+
+template <int kRows>
+void VnniRows(const uint32* a_words, int64 k4, const int8* b_data,
+              const int32* column_sums, int64 col_begin, int64 col_end,
+              int64 ldc, int32* c) {
+  __m512i acc[kRows];
+  for (int64 j = col_begin; j < col_end; j += kColumnBlock) {
+    const int8* b_block = b_data + (j / kColumnBlock) * k4 * 64;
+    VnniBlock<kRows>(a_words, k4, b_block, acc);
+    // The bytes of A were offset by 128 to make them unsigned.
+    const __m512i correction = _mm512_slli_epi32(
+        _mm512_loadu_si512(column_sums + j), 7);
+    const int64 width = std::min(kColumnBlock, col_end - j);
+    const __mmask16 mask = static_cast<__mmask16>((1u << width) - 1);
+    for (int r = 0; r < kRows; ++r) {
+      _mm512_mask_storeu_epi32(c + r * ldc + j, mask,
+                               _mm512_sub_epi32(acc[r], correction));
+    }
+  }
+}
+
+}  // namespace
+
+PackedMatrix::PackedMatrix(const int8* data, int64 rows, int64 cols)
+    : rows_(rows), cols_(cols) {
+  const int64 k4 = (rows + kDepthGroup - 1) / kDepthGroup;
+  const int64 num_blocks = (cols + kColumnBlock - 1) / kColumnBlock;
+  // Each block of kColumnBlock columns stores, for each group of four rows,
+  // the four bytes of each column next to each other.
+  data_.assign(num_blocks * k4 * kColumnBlock * kDepthGroup, 0);
+  column_sums_.assign(num_blocks * kColumnBlock, 0);
+  for (int64 k = 0; k < rows; ++k) {
+    for (int64 j = 0; j < cols; ++j) {
+      const int8 value = data[k * cols + j];
+      const int64 block = j / kColumnBlock;
+      data_[((block * k4 + k / kDepthGroup) * kColumnBlock +
+             j % kColumnBlock) *
+                kDepthGroup +
+            k % kDepthGroup] = value;
+      column_sums_[j] += value;
+    }
+  }
+}
+
+void Gemm(const int8* a, int64 num_rows, const PackedMatrix& b,
+          int64 col_begin, int64 col_end, int32* c) {
+  DCHECK_EQ(col_begin % kColumnBlock, 0);
+  DCHECK_LE(col_end, b.cols());
+  const int64 depth = b.rows();
+  const int64 k4 = (depth + kDepthGroup - 1) / kDepthGroup;
+  // Up to four rows of A, offset by 128 and padded with zeros.
+  std::vector<uint32> a_words(4 * k4);
+  for (int64 i = 0; i < num_rows; i += 4) {
+    const int rows = static_cast<int>(std::min<int64>(4, num_rows - i));
+    std::fill(a_words.begin(), a_words.end(), 0x80808080u);
+    for (int r = 0; r < rows; ++r) {
+      uint8* bytes = reinterpret_cast<uint8*>(&a_words[r * k4]);
+      const int8* row = a + (i + r) * depth;
+      for (int64 k = 0; k < depth; ++k) {
+        bytes[k] = static_cast<uint8>(row[k]) ^ 0x80;
+      }
+    }
+    // The padding bytes are 0x80, i.e. zero before the offset, so they only
+    // add 128 * 0 to the products.
+    int32* c_rows = c + i * b.cols();
+    switch (rows) {
+      case 4:
+        VnniRows<4>(a_words.data(), k4, b.data_.data(),
+                    b.column_sums_.data(), col_begin, col_end, b.cols(),
+                    c_rows);
+        break;
+      case 3:
+        VnniRows<3>(a_words.data(), k4, b.data_.data(),
+                    b.column_sums_.data(), col_begin, col_end, b.cols(),
+                    c_rows);
+        break;
+      case 2:
+        VnniRows<2>(a_words.data(), k4, b.data_.data(),
+                    b.column_sums_.data(), col_begin, col_end, b.cols(),
+                    c_rows);
+        break;
+      default:
+        VnniRows<1>(a_words.data(), k4, b.data_.data(),
+                    b.column_sums_.data(), col_begin, col_end, b.cols(),
+                    c_rows);
+        break;
+    }
+  }
+}
+
+bool UsesVnni() { return true; }
+
+#elif defined(TF_INT8_GEMM_USE_AVX2)
+
+namespace {
+
+// vpmaddwd multiplies pairs of 16-bit values into each 32-bit lane.
+constexpr int64 kDepthGroup = 2;
+
+// Accumulates the products of kRows rows of A, each given as k2 words of two
+// 16-bit values, and a block of kColumnBlock columns of B into `acc`, two
+// registers per row.
+template <int kRows>
+inline void Avx2Block(const uint32* a_words, int64 k2, const int16* b_block,
+                      __m256i* acc) {
+  for (int r = 0; r < 2 * kRows; ++r) {
+    acc[r] = _mm256_setzero_si256();
+  }
+  for (int64 kb = 0; kb < k2; ++kb) {
+    const __m256i b_low = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(b_block + kb * 32));
+    const __m256i b_high = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(b_block + kb * 32 + 16));
+    for (int r = 0; r < kRows; ++r) {
+      const __m256i a =
+          _mm256_set1_epi32(static_cast<int32>(a_words[r * k2 + kb]));
+      acc[2 * r] =
+          _mm256_add_epi32(acc[2 * r], _mm256_madd_epi16(a, b_low));
+      acc[2 * r + 1] =
+          _mm256_add_epi32(acc[2 * r + 1], _mm256_madd_epi16(a, b_high));
+    }
+  }
+}
+
+template <int kRows>
+void Avx2Rows(const uint32* a_words, int64 k2, const int16* b_data,
+              int64 col_begin, int64 col_end, int64 ldc, int32* c) {
+  __m256i acc[2 * kRows];
+  int32 block[kColumnBlock];
+  for (int64 j = col_begin; j < col_end; j += kColumnBlock) {
+    const int16* b_block = b_data + (j / kColumnBlock) * k2 * 32;
+    Avx2Block<kRows>(a_words, k2, b_block, acc);
+    const int64 width = std::min(kColumnBlock, col_end - j);
+    for (int r = 0; r < kRows; ++r) {
+      int32* out = c + r * ldc + j;
+      if (width == kColumnBlock) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), acc[2 * r]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 8),
+                            acc[2 * r + 1]);
+      } else {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(block), acc[2 * r]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(block + 8),
+                            acc[2 * r + 1]);
+        memcpy(out, block, width * sizeof(int32));
+      }
+    }
+  }
+}
+
+}  // namespace
+
+PackedMatrix::PackedMatrix(const int8* data, int64 rows, int64 cols)
+    : rows_(rows), cols_(cols) {
+  const int64 k2 = (rows + kDepthGroup - 1) / kDepthGroup;
+  const int64 num_blocks = (cols + kColumnBlock - 1) / kColumnBlock;
+  // Each block of kColumnBlock columns stores, for each pair of rows, the two
+  // values of each column next to each other, widened to 16 bits. The first
+  // register of a block holds the pairs of its first 8 columns.
+  wide_data_.assign(num_blocks * k2 * kColumnBlock * kDepthGroup, 0);
+  for (int64 k = 0; k < rows; ++k) {
+    for (int64 j = 0; j < cols; ++j) {
+      const int64 block = j / kColumnBlock;
+      wide_data_[((block * k2 + k / kDepthGroup) * kColumnBlock +
+                  j % kColumnBlock) *
+                     kDepthGroup +
+                 k % kDepthGroup] = data[k * cols + j];
+    }
+  }
+}
+
+void Gemm(const int8* a, int64 num_rows, const PackedMatrix& b,
+          int64 col_begin, int64 col_end, int32* c) {
+  DCHECK_EQ(col_begin % kColumnBlock, 0);
+  DCHECK_LE(col_end, b.cols());
+  const int64 depth = b.rows();
+  const int64 k2 = (depth + kDepthGroup - 1) / kDepthGroup;
+  // Up to four rows of A, widened to 16 bits and padded with zeros.
+  std::vector<uint32> a_words(4 * k2);
+  for (int64 i = 0; i < num_rows; i += 4) {
+    const int rows = static_cast<int>(std::min<int64>(4, num_rows - i));
+    std::fill(a_words.begin(), a_words.end(), 0);
+    for (int r = 0; r < rows; ++r) {
+      int16* values = reinterpret_cast<int16*>(&a_words[r * k2]);
+      const int8* row = a + (i + r) * depth;
+      for (int64 k = 0; k < depth; ++k) {
+        values[k] = row[k];
+      }
+    }
+    const int16* b_data = b.wide_data_.data();
+    int32* c_rows = c + i * b.cols();
+    switch (rows) {
+      case 4:
+        Avx2Rows<4>(a_words.data(), k2, b_data, col_begin, col_end,
+                    b.cols(), c_rows);
+        break;
+      case 3:
+        Avx2Rows<3>(a_words.data(), k2, b_data, col_begin, col_end,
+                    b.cols(), c_rows);
+        break;
+      case 2:
+        Avx2Rows<2>(a_words.data(), k2, b_data, col_begin, col_end,
+                    b.cols(), c_rows);
+        break;
+      default:
+        Avx2Rows<1>(a_words.data(), k2, b_data, col_begin, col_end,
+                    b.cols(), c_rows);
+        break;
+    }
+  }
+}
+
+bool UsesVnni() { return false; }
+
+#else  // !TF_INT8_GEMM_USE_VNNI && !TF_INT8_GEMM_USE_AVX2
+
+PackedMatrix::PackedMatrix(const int8* data, int64 rows, int64 cols)
+    : rows_(rows), cols_(cols), data_(data, data + rows * cols) {}
+
+void Gemm(const int8* a, int64 num_rows, const PackedMatrix& b,
+          int64 col_begin, int64 col_end, int32* c) {
+  DCHECK_EQ(col_begin % kColumnBlock, 0);
+  DCHECK_LE(col_end, b.cols());
+  const int64 depth = b.rows();
+  const int64 n = b.cols();
+  const int64 width = col_end - col_begin;
+  for (int64 i = 0; i < num_rows; ++i) {
+    int32* c_row = c + i * n + col_begin;
+    memset(c_row, 0, width * sizeof(int32));
+    const int8* a_row = a + i * depth;
+    for (int64 k = 0; k < depth; ++k) {
+      const int32 a_value = a_row[k];
+      if (a_value == 0) continue;
+      const int8* b_row = b.data_.data() + k * n + col_begin;
+      for (int64 j = 0; j < width; ++j) {
+        c_row[j] += a_value * b_row[j];
+      }
+    }
+  }
+}
+
+bool UsesVnni() { return false; }
+
+#endif  // TF_INT8_GEMM_USE_VNNI
+
+}  // namespace int8_gemm
+}  // namespace tensorflow
@@ -0,0 +1,79 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A signed 8-bit GEMM with 32-bit accumulators, used by the int8 inference
+// kernels. When the build targets AVX-512 VNNI (e.g. with
+// --copt=-march=cascadelake), it uses the vpdpbusd instruction, which
+// multiplies and accumulates four pairs of bytes per 32-bit lane. When it
+// targets AVX2, it uses vpmaddwd on values widened to 16 bits. Otherwise it
+// uses a scalar loop.
+
+#ifndef TENSORFLOW_CORE_KERNELS_INT8_GEMM_H_
+#define TENSORFLOW_CORE_KERNELS_INT8_GEMM_H_
+
+#include <vector>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace int8_gemm {
+
+// Ranges of columns passed to Gemm() must start at a multiple of this.
+constexpr int64 kColumnBlock = 16;
+
+// The right-hand side of a GEMM, a row-major [k, n] matrix, in the layout of
+// the GEMM kernel of this build. Packing costs about as much as a GEMM with a
+// single row, so constant matrices should be packed once.
+class PackedMatrix {
+ public:
+  PackedMatrix(const int8* data, int64 rows, int64 cols);
+
+  int64 rows() const { return rows_; }
+  int64 cols() const { return cols_; }
+
+ private:
+  friend void Gemm(const int8* a, int64 num_rows, const PackedMatrix& b,
+                   int64 col_begin, int64 col_end, int32* c);
+
+  const int64 rows_;
+  const int64 cols_;
+  std::vector<int8> data_;
+  // The sum of each column, to undo the offset of the left-hand side in the
+  // VNNI kernel, which multiplies unsigned by signed bytes.
+  std::vector<int32> column_sums_;
+  // The values widened to 16 bits for the AVX2 kernel, which multiplies
+  // pairs of 16-bit values.
+  std::vector<int16> wide_data_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PackedMatrix);
+};
+
+// Computes the columns [col_begin, col_end) of C = A * B, where A is a
+// row-major [num_rows, b.rows()] matrix and C a row-major
+// [num_rows, b.cols()] matrix.
+//
+// REQUIRES: col_begin % kColumnBlock == 0
+// REQUIRES: 0 <= col_begin <= col_end <= b.cols()
+void Gemm(const int8* a, int64 num_rows, const PackedMatrix& b,
+          int64 col_begin, int64 col_end, int32* c);
+
+// Returns true if Gemm() uses the AVX-512 VNNI kernel.
+bool UsesVnni();
+
+}  // namespace int8_gemm
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_INT8_GEMM_H_
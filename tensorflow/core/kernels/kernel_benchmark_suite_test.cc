@@ -0,0 +1,267 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A suite of benchmarks of the kernels of the main op families over the
+// shapes of common models, to compare a build of TensorFlow against a
+// baseline. The benchmarks are named BM_Suite_<family>_<shape>, report the
+// number of flops as items for the compute bound kernels and the bytes
+// processed for the memory bound ones, and are logged as TestResults by the
+// //tensorflow/tools/test:kernel_benchmark_suite target.
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+Node* RandomFloat(Graph* g, const TensorShape& shape) {
+  Tensor t(DT_FLOAT, shape);
+  t.flat<float>().setRandom();
+  return test::graph::Constant(g, t);
+}
+
+// Returns `num_indices` random indices in [0, limit), sorted if `sorted`.
+Node* RandomIndices(Graph* g, int64 num_indices, int64 limit, bool sorted,
+                    const TensorShape& shape) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<int32> indices(num_indices);
+  for (int32& index : indices) {
+    index = rnd.Uniform(limit);
+  }
+  if (sorted) {
+    std::sort(indices.begin(), indices.end());
+  }
+  Tensor t(DT_INT32, shape);
+  std::copy(indices.begin(), indices.end(), t.flat<int32>().data());
+  return test::graph::Constant(g, t);
+}
+
+Node* Int32Constant(Graph* g, gtl::ArraySlice<int32> values) {
+  Tensor t(DT_INT32, TensorShape({static_cast<int64>(values.size())}));
+  std::copy(values.begin(), values.end(), t.flat<int32>().data());
+  return test::graph::Constant(g, t);
+}
+
+// MatMul of [m, k] by [k, n].
+Graph* MatMul(int m, int k, int n) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Matmul(g, RandomFloat(g, TensorShape({m, k})),
+                      RandomFloat(g, TensorShape({k, n})), false, false);
+  return g;
+}
+
+#define BM_SUITE_MATMUL(M, K, N)                                             \
+  static void BM_Suite_MatMul_##M##x##K##x##N(int iters) {                   \
+    testing::UseRealTime();                                                  \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2);      \
+    test::Benchmark("cpu", MatMul(M, K, N)).Run(iters);                      \
+  }                                                                          \
+  BENCHMARK(BM_Suite_MatMul_##M##x##K##x##N);
+
+// Inference and training batches of dense layers, and attention projections.
+BM_SUITE_MATMUL(1, 1024, 1024);
+BM_SUITE_MATMUL(128, 1024, 1024);
+BM_SUITE_MATMUL(512, 4096, 1024);
+BM_SUITE_MATMUL(4096, 512, 512);
+
+// SAME Conv2D with stride 1 of an NHWC [batch, size, size, in_depth] input
+// by a square [filter, filter, in_depth, out_depth] filter.
+Graph* Conv2D(int batch, int size, int in_depth, int filter, int out_depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Conv2D(
+      g, RandomFloat(g, TensorShape({batch, size, size, in_depth})),
+      RandomFloat(g, TensorShape({filter, filter, in_depth, out_depth})));
+  return g;
+}
+
+#define BM_SUITE_CONV2D(B, S, I, F, O)                                       \
+  static void BM_Suite_Conv2D_##B##_##S##x##S##_##I##_##F##x##F##_##O(       \
+      int iters) {                                                           \
+    testing::UseRealTime();                                                  \
+    testing::ItemsProcessed(static_cast<int64>(iters) * B * S * S * I * F *  \
+                            F * O * 2);                                      \
+    test::Benchmark("cpu", Conv2D(B, S, I, F, O)).Run(iters);                \
+  }                                                                          \
+  BENCHMARK(BM_Suite_Conv2D_##B##_##S##x##S##_##I##_##F##x##F##_##O);
+
+// The 3x3 convolutions of the four stages of ResNet-50, and a 1x1 one.
+BM_SUITE_CONV2D(32, 56, 64, 3, 64);
+BM_SUITE_CONV2D(32, 28, 128, 3, 128);
+BM_SUITE_CONV2D(32, 14, 256, 3, 256);
+BM_SUITE_CONV2D(32, 7, 512, 3, 512);
+BM_SUITE_CONV2D(32, 56, 256, 1, 64);
+
+// Sum of a [rows, cols] matrix over `axis`.
+Graph* Reduction(int rows, int cols, int axis) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Reduce(g, "Sum", RandomFloat(g, TensorShape({rows, cols})),
+                      Int32Constant(g, {axis}));
+  return g;
+}
+
+#define BM_SUITE_REDUCTION(R, C, AXIS)                                       \
+  static void BM_Suite_Sum_##R##x##C##_Axis##AXIS(int iters) {               \
+    testing::UseRealTime();                                                  \
+    testing::BytesProcessed(static_cast<int64>(iters) * R * C *              \
+                            sizeof(float));                                  \
+    test::Benchmark("cpu", Reduction(R, C, AXIS)).Run(iters);                \
+  }                                                                          \
+  BENCHMARK(BM_Suite_Sum_##R##x##C##_Axis##AXIS);
+
+BM_SUITE_REDUCTION(4096, 4096, 0);
+BM_SUITE_REDUCTION(4096, 4096, 1);
+BM_SUITE_REDUCTION(65536, 128, 0);
+BM_SUITE_REDUCTION(65536, 128, 1);
+
+// Gathers `num_indices` rows of a [vocab, dim] embedding table.
+Graph* Gather(int vocab, int dim, int num_indices) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Gather(
+      g, RandomFloat(g, TensorShape({vocab, dim})),
+      RandomIndices(g, num_indices, vocab, false, TensorShape({num_indices})),
+      Int32Constant(g, {0}));
+  return g;
+}
+
+// Scatters `num_indices` rows into a zero [vocab, dim] tensor.
+Graph* ScatterNd(int vocab, int dim, int num_indices) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* ret;
+  TF_CHECK_OK(
+      NodeBuilder(g->NewName("n"), "ScatterNd")
+          .Input(RandomIndices(g, num_indices, vocab, false,
+                               TensorShape({num_indices, 1})))
+          .Input(RandomFloat(g, TensorShape({num_indices, dim})))
+          .Input(Int32Constant(g, {vocab, dim}))
+          .Finalize(g, &ret));
+  return g;
+}
+
+#define BM_SUITE_EMBEDDING(OP, V, D, N)                                      \
+  static void BM_Suite_##OP##_##V##x##D##_##N(int iters) {                   \
+    testing::UseRealTime();                                                  \
+    testing::BytesProcessed(static_cast<int64>(iters) * N * D *              \
+                            sizeof(float));                                  \
+    test::Benchmark("cpu", OP(V, D, N)).Run(iters);                          \
+  }                                                                          \
+  BENCHMARK(BM_Suite_##OP##_##V##x##D##_##N);
+
+BM_SUITE_EMBEDDING(Gather, 100000, 64, 4096);
+BM_SUITE_EMBEDDING(Gather, 200000, 128, 16384);
+BM_SUITE_EMBEDDING(ScatterNd, 100000, 64, 4096);
+BM_SUITE_EMBEDDING(ScatterNd, 10000, 256, 16384);
+
+// Reduces a [rows, dim] tensor into `num_segments` segments, with sorted
+// segment ids for SegmentSum and random ones for UnsortedSegmentSum.
+Graph* Segment(const string& op, int rows, int dim, int num_segments) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const bool sorted = op == "SegmentSum";
+  NodeBuilder builder(g->NewName("n"), op);
+  builder.Input(RandomFloat(g, TensorShape({rows, dim})))
+      .Input(RandomIndices(g, rows, num_segments, sorted,
+                           TensorShape({rows})));
+  if (!sorted) {
+    Tensor t(DT_INT32, TensorShape({}));
+    t.scalar<int32>()() = num_segments;
+    builder.Input(test::graph::Constant(g, t));
+  }
+  Node* ret;
+  TF_CHECK_OK(builder.Finalize(g, &ret));
+  return g;
+}
+
+#define BM_SUITE_SEGMENT(OP, R, D, S)                                        \
+  static void BM_Suite_##OP##_##R##x##D##_##S(int iters) {                   \
+    testing::UseRealTime();                                                  \
+    testing::BytesProcessed(static_cast<int64>(iters) * R * D *              \
+                            sizeof(float));                                  \
+    test::Benchmark("cpu", Segment(#OP, R, D, S)).Run(iters);                \
+  }                                                                          \
+  BENCHMARK(BM_Suite_##OP##_##R##x##D##_##S);
+
+BM_SUITE_SEGMENT(SegmentSum, 16384, 64, 512);
+BM_SUITE_SEGMENT(SegmentSum, 65536, 128, 4096);
+BM_SUITE_SEGMENT(UnsortedSegmentSum, 16384, 64, 512);
+BM_SUITE_SEGMENT(UnsortedSegmentSum, 65536, 128, 4096);
+
+// Parses `batch` serialized Examples with `num_features` dense float
+// features of `feature_size` values.
+Graph* ParseExample(int batch, int num_features, int feature_size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Example example;
+  auto& features = *example.mutable_features()->mutable_feature();
+  for (int i = 0; i < num_features; ++i) {
+    auto* values = features[strings::StrCat("feature_", i)]
+                       .mutable_float_list()
+                       ->mutable_value();
+    for (int j = 0; j < feature_size; ++j) {
+      values->Add(j);
+    }
+  }
+  Tensor serialized(DT_STRING, TensorShape({batch}));
+  serialized.flat<string>().setConstant(example.SerializeAsString());
+  Tensor names(DT_STRING, TensorShape({batch}));
+
+  std::vector<NodeBuilder::NodeOut> dense_keys;
+  std::vector<NodeBuilder::NodeOut> dense_defaults;
+  std::vector<PartialTensorShape> dense_shapes;
+  for (int i = 0; i < num_features; ++i) {
+    Tensor key(DT_STRING, TensorShape());
+    key.scalar<string>()() = strings::StrCat("feature_", i);
+    dense_keys.emplace_back(test::graph::Constant(g, key));
+    Tensor dense_default(DT_FLOAT, TensorShape({feature_size}));
+    dense_default.flat<float>().setZero();
+    dense_defaults.emplace_back(test::graph::Constant(g, dense_default));
+    dense_shapes.push_back(PartialTensorShape({feature_size}));
+  }
+
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "ParseExample")
+                  .Input(test::graph::Constant(g, serialized))
+                  .Input(test::graph::Constant(g, names))
+                  .Input(std::vector<NodeBuilder::NodeOut>())
+                  .Input(dense_keys)
+                  .Input(dense_defaults)
+                  .Attr("sparse_types", DataTypeVector())
+                  .Attr("dense_shapes", dense_shapes)
+                  .Finalize(g, &ret));
+  return g;
+}
+
+#define BM_SUITE_PARSE_EXAMPLE(B, K, F)                                      \
+  static void BM_Suite_ParseExample_##B##_##K##x##F(int iters) {             \
+    testing::UseRealTime();                                                  \
+    testing::ItemsProcessed(static_cast<int64>(iters) * B * K * F);          \
+    test::Benchmark("cpu", ParseExample(B, K, F)).Run(iters);                \
+  }                                                                          \
+  BENCHMARK(BM_Suite_ParseExample_##B##_##K##x##F);
+
+BM_SUITE_PARSE_EXAMPLE(128, 10, 1);
+BM_SUITE_PARSE_EXAMPLE(512, 50, 16);
+BM_SUITE_PARSE_EXAMPLE(512, 10, 256);
+
+}  // namespace
+}  // namespace tensorflow
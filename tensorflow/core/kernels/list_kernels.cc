@@ -118,6 +118,35 @@ bool TensorList::Decode(const VariantTensorData& data) {
   return true;
 }
 
+Status ForwardInputOrCreateNewList(OpKernelContext* c, int32 input_index,
+                                   int32 output_index,
+                                   const TensorList& input_list,
+                                   TensorList** output_list) {
+  std::unique_ptr<Tensor> maybe_output = c->forward_input(
+      input_index, output_index, DT_VARIANT, TensorShape{},
+      c->input_memory_type(input_index), AllocatorAttributes());
+  if (maybe_output != nullptr) {
+    TensorList* forwarded_list =
+        maybe_output->scalar<Variant>()().get<TensorList>();
+    if (forwarded_list == nullptr) {
+      return errors::InvalidArgument(
+          "Expected the forwarded input to contain a TensorList, but saw: '",
+          maybe_output->scalar<Variant>()().DebugString(), "'");
+    }
+    c->set_output(output_index, *maybe_output);
+    *output_list = forwarded_list;
+    return Status::OK();
+  }
+  Tensor* result;
+  AllocatorAttributes attr;
+  attr.set_on_host(true);
+  TF_RETURN_IF_ERROR(
+      c->allocate_output(output_index, TensorShape{}, &result, attr));
+  result->scalar<Variant>()() = input_list;
+  *output_list = result->scalar<Variant>()().get<TensorList>();
+  return Status::OK();
+}
+
 Status TensorShapeFromTensor(const Tensor& t, PartialTensorShape* out) {
   if (t.shape() == TensorShape({})) {
     if ((t.dtype() == DT_INT32 && t.scalar<int32>()() == -1) ||
@@ -209,14 +238,9 @@ class TensorListPushBack : public OpKernel {
                                         " but list elements ",
                                         DataTypeString(l->element_dtype)));
 
-    TensorList output;
-    output = *l;
-    output.tensors.push_back(input);
-    Tensor* result;
-    AllocatorAttributes attr;
-    attr.set_on_host(true);
-    OP_REQUIRES_OK(c, c->allocate_output(0, TensorShape{}, &result, attr));
-    result->scalar<Variant>()() = std::move(output);
+    TensorList* output = nullptr;
+    OP_REQUIRES_OK(c, ForwardInputOrCreateNewList(c, 0, 0, *l, &output));
+    output->tensors.push_back(input);
   }
 
  private:
@@ -334,14 +358,9 @@ class TensorListPopBack : public OpKernel {
                 errors::InvalidArgument("Trying to pop from an empty list."));
 
     c->set_output(1, l->tensors.back());
-    TensorList output;
-    output = *l;
-    output.tensors.pop_back();
-    Tensor* result;
-    AllocatorAttributes attr;
-    attr.set_on_host(true);
-    OP_REQUIRES_OK(c, c->allocate_output(0, TensorShape{}, &result, attr));
-    result->scalar<Variant>()() = std::move(output);
+    TensorList* output = nullptr;
+    OP_REQUIRES_OK(c, ForwardInputOrCreateNewList(c, 0, 0, *l, &output));
+    output->tensors.pop_back();
   }
 
  private:
@@ -468,14 +487,9 @@ class TensorListSetItem : public OpKernel {
                     "list index. Item element shape: ",
                     value.shape().DebugString(),
                     " list shape: ", l->element_shape.DebugString()));
-    TensorList output;
-    output = *l;
-    output.tensors[index] = value;
-    Tensor* result;
-    AllocatorAttributes attr;
-    attr.set_on_host(true);
-    OP_REQUIRES_OK(c, c->allocate_output(0, TensorShape{}, &result, attr));
-    result->scalar<Variant>()() = std::move(output);
+    TensorList* output = nullptr;
+    OP_REQUIRES_OK(c, ForwardInputOrCreateNewList(c, 0, 0, *l, &output));
+    output->tensors[index] = value;
   }
 
  private:
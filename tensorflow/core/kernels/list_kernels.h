@@ -20,6 +20,9 @@ limitations under the License.
 #define EIGEN_USE_GPU
 #endif  // GOOGLE_CUDA
 
+#include <cstring>
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -31,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -60,6 +64,49 @@ struct TensorList {
 
 Status TensorShapeFromTensor(const Tensor& t, PartialTensorShape* out);
 
+// Makes the list in output `output_index` a modifiable copy of `input_list`,
+// the list in input `input_index`, and sets `*output_list` to it. If no other
+// tensor shares the buffer of the input, the input is forwarded to the output
+// and the list is modified in place; otherwise the list is copied. This keeps
+// loops that push to or set items of a list linear in the list length.
+Status ForwardInputOrCreateNewList(OpKernelContext* c, int32 input_index,
+                                   int32 output_index,
+                                   const TensorList& input_list,
+                                   TensorList** output_list);
+
+// Copies `elements`, which must all have the number of elements of a row of
+// `output`, into consecutive rows of `output`, in parallel on the CPU worker
+// threads. Only for types that can be copied with memcpy.
+template <typename T>
+Status CopyElementsToRowsCPU(OpKernelContext* c,
+                             const std::vector<const Tensor*>& elements,
+                             Tensor* output) {
+  const int64 row_size = output->NumElements() / elements.size();
+  for (const Tensor* element : elements) {
+    if (element->dtype() != DataTypeToEnum<T>::value ||
+        element->NumElements() != row_size) {
+      return errors::InvalidArgument(
+          "Tried to stack or gather an element with ", element->NumElements(),
+          " values of type ", DataTypeString(element->dtype()),
+          " into rows of ", row_size, " values of type ",
+          DataTypeString(output->dtype()));
+    }
+  }
+  const int64 row_bytes = row_size * sizeof(T);
+  char* output_data = const_cast<char*>(output->tensor_data().data());
+  auto copy_rows = [&elements, output_data, row_bytes](int64 begin,
+                                                       int64 end) {
+    for (int64 i = begin; i < end; ++i) {
+      std::memcpy(output_data + i * row_bytes,
+                  elements[i]->tensor_data().data(), row_bytes);
+    }
+  };
+  auto* worker_threads = c->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers, elements.size(),
+        row_bytes, copy_rows);
+  return Status::OK();
+}
+
 template <typename Device, typename T>
 class TensorListStack : public OpKernel {
  public:
@@ -120,6 +167,17 @@ class TensorListStack : public OpKernel {
       return;
     }
 
+    if (std::is_same<Device, CPUDevice>::value &&
+        DataTypeCanUseMemcpy(DataTypeToEnum<T>::value)) {
+      std::vector<const Tensor*> elements;
+      elements.reserve(l->tensors.size());
+      for (const Tensor& t : l->tensors) {
+        elements.push_back(&t);
+      }
+      OP_REQUIRES_OK(c, CopyElementsToRowsCPU<T>(c, elements, output));
+      return;
+    }
+
     ConstMatrixVector inputs_flat;
     inputs_flat.reserve(l->tensors.size());
     for (const auto& t : l->tensors) {
@@ -200,17 +258,28 @@ class TensorListGather : public OpKernel {
       return;
     }
 
-    ConstMatrixVector inputs_flat;
-    inputs_flat.reserve(l->tensors.size());
+    std::vector<const Tensor*> elements;
+    elements.reserve(indices.NumElements());
     for (int index = 0; index < indices.NumElements(); ++index) {
       const int i = indices.flat<int32>()(index);
       OP_REQUIRES(
           c, i < l->tensors.size(),
           errors::InvalidArgument("Index ", i, " out o range; list only has ",
                                   l->tensors.size(), " elements."));
-      const Tensor& t = l->tensors[i];
+      elements.push_back(&l->tensors[i]);
+    }
+
+    if (std::is_same<Device, CPUDevice>::value &&
+        DataTypeCanUseMemcpy(DataTypeToEnum<T>::value)) {
+      OP_REQUIRES_OK(c, CopyElementsToRowsCPU<T>(c, elements, output));
+      return;
+    }
+
+    ConstMatrixVector inputs_flat;
+    inputs_flat.reserve(elements.size());
+    for (const Tensor* t : elements) {
       inputs_flat.emplace_back(new typename TTypes<T, 2>::ConstMatrix(
-          t.shaped<T, 2>({1, t.NumElements()})));
+          t->shaped<T, 2>({1, t->NumElements()})));
     }
     auto output_flat = output->shaped<T, 2>({1, output->NumElements()});
 
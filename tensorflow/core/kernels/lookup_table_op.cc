@@ -16,9 +16,12 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
@@ -26,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/prefetch.h"
 
 namespace tensorflow {
 namespace lookup {
@@ -776,6 +780,772 @@ class MutableDenseHashTable final : public LookupInterface {
   uint64 deleted_key_hash_;
 };
 
+// Lookup table for scalar keys and values that is optimized for many
+// concurrent Find and Insert calls. The table is split into shards by key
+// hash, and each shard is an open-addressing hash table with linear probing
+// and its own reader-writer lock, so that operations on different shards
+// never contend and lookups in the same shard run concurrently.
+//
+// Batches of keys are grouped by shard, so that each shard is locked once per
+// batch, and the buckets of upcoming keys are prefetched while probing.
+//
+// A shard that exceeds max_load_factor is grown incrementally: writes move a
+// bounded number of buckets from the old to the new table, and reads check
+// both until the old one is drained. No operation ever rehashes more than one
+// shard, so readers of other shards are never blocked by a resize.
+template <class K, class V>
+class MutableStripedHashTable final : public LookupInterface {
+ public:
+  MutableStripedHashTable(OpKernelContext* ctx, OpKernel* kernel) {
+    OP_REQUIRES_OK(
+        ctx, GetNodeAttr(kernel->def(), "max_load_factor", &max_load_factor_));
+    OP_REQUIRES(ctx, max_load_factor_ > 0 && max_load_factor_ < 1,
+                errors::InvalidArgument(
+                    "max_load_factor must be between 0 and 1, got: ",
+                    max_load_factor_));
+    int64 num_shards;
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "num_shards", &num_shards));
+    OP_REQUIRES(ctx, num_shards > 0 && (num_shards & (num_shards - 1)) == 0,
+                errors::InvalidArgument(
+                    "num_shards must be a power of 2, got: ", num_shards));
+    int64 initial_num_buckets;
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "initial_num_buckets",
+                                    &initial_num_buckets));
+    OP_REQUIRES(
+        ctx,
+        initial_num_buckets > 0 &&
+            (initial_num_buckets & (initial_num_buckets - 1)) == 0,
+        errors::InvalidArgument("initial_num_buckets must be a power of 2, ",
+                                "got: ", initial_num_buckets));
+    num_shards_ = num_shards;
+    initial_buckets_per_shard_ =
+        std::max<int64>(2, initial_num_buckets / num_shards);
+    shards_.reset(new Shard[num_shards_]);
+    for (int64 i = 0; i < num_shards_; ++i) {
+      mutex_lock l(shards_[i].mu);
+      shards_[i].current.Reset(initial_buckets_per_shard_);
+    }
+  }
+
+  size_t size() const override {
+    size_t size = 0;
+    for (int64 i = 0; i < num_shards_; ++i) {
+      tf_shared_lock l(shards_[i].mu);
+      size += shards_[i].current.num_entries + shards_[i].draining.num_entries;
+    }
+    return size;
+  }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const V default_val = default_value.flat<V>()(0);
+    const auto key_values = key.flat<K>();
+    auto value_values = value->flat<V>();
+    std::vector<K> keys(key_values.size());
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      keys[i] = SubtleMustCopyIfIntegral(key_values(i));
+    }
+    ShardedBatch batch(*this, keys);
+    for (int64 s = 0; s < num_shards_; ++s) {
+      if (batch.begin(s) == batch.end(s)) {
+        continue;
+      }
+      const Shard& shard = shards_[s];
+      tf_shared_lock l(shard.mu);
+      for (int64 j = batch.begin(s); j < batch.end(s); ++j) {
+        if (j + kPrefetchDistance < batch.end(s)) {
+          shard.current.Prefetch(batch.hash(j + kPrefetchDistance));
+        }
+        const int64 i = batch.index(j);
+        const uint64 hash = batch.hash(j);
+        const Buckets* buckets = &shard.current;
+        int64 slot = buckets->FindSlot(keys[i], hash);
+        if (slot < 0) {
+          buckets = &shard.draining;
+          slot = buckets->FindSlot(keys[i], hash);
+        }
+        value_values(i) = slot < 0 ? default_val : buckets->values[slot];
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    return DoInsert(false, keys, values);
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    const auto key_values = keys.flat<K>();
+    std::vector<K> key_vector(key_values.size());
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      key_vector[i] = SubtleMustCopyIfIntegral(key_values(i));
+    }
+    ShardedBatch batch(*this, key_vector);
+    for (int64 s = 0; s < num_shards_; ++s) {
+      if (batch.begin(s) == batch.end(s)) {
+        continue;
+      }
+      Shard* shard = &shards_[s];
+      mutex_lock l(shard->mu);
+      for (int64 j = batch.begin(s); j < batch.end(s); ++j) {
+        MigrateSome(shard);
+        const K key = key_vector[batch.index(j)];
+        if (!shard->current.Erase(key, batch.hash(j))) {
+          shard->draining.Erase(key, batch.hash(j));
+        }
+      }
+    }
+    return Status::OK();
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    return DoInsert(true, keys, values);
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    std::vector<K> keys;
+    std::vector<V> values;
+    for (int64 s = 0; s < num_shards_; ++s) {
+      const Shard& shard = shards_[s];
+      tf_shared_lock l(shard.mu);
+      shard.current.AppendEntries(&keys, &values);
+      shard.draining.AppendEntries(&keys, &values);
+    }
+    const int64 size = keys.size();
+    Tensor* keys_tensor;
+    Tensor* values_tensor;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), &keys_tensor));
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("values", TensorShape({size}), &values_tensor));
+    std::copy(keys.begin(), keys.end(), keys_tensor->flat<K>().data());
+    std::copy(values.begin(), values.end(), values_tensor->flat<V>().data());
+    return Status::OK();
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const override { return TensorShape(); }
+
+  TensorShape value_shape() const override { return TensorShape(); }
+
+  int64 MemoryUsed() const override {
+    int64 ret = sizeof(MutableStripedHashTable) + num_shards_ * sizeof(Shard);
+    for (int64 s = 0; s < num_shards_; ++s) {
+      tf_shared_lock l(shards_[s].mu);
+      ret += shards_[s].current.MemoryUsed() + shards_[s].draining.MemoryUsed();
+    }
+    return ret;
+  }
+
+ private:
+  // Number of keys ahead of the current one whose buckets are prefetched.
+  static constexpr int64 kPrefetchDistance = 8;
+  // Number of buckets of a shard being resized that each write moves to the
+  // new table.
+  static constexpr int64 kBucketsMovedPerWrite = 16;
+
+  enum BucketState : uint8 { kEmpty = 0, kFull, kDeleted };
+
+  // An open-addressing hash table with linear probing. Removed entries leave
+  // tombstones that are reused by later insertions.
+  struct Buckets {
+    std::vector<K> keys;
+    std::vector<V> values;
+    std::vector<uint8> states;
+    int64 num_entries = 0;
+    // Number of buckets that are not empty, including tombstones.
+    int64 num_used = 0;
+
+    int64 num_buckets() const { return states.size(); }
+
+    void Reset(int64 num_buckets) {
+      keys.assign(num_buckets, K());
+      values.assign(num_buckets, V());
+      states.assign(num_buckets, kEmpty);
+      num_entries = 0;
+      num_used = 0;
+    }
+
+    void Prefetch(uint64 hash) const {
+      const int64 slot = hash & (num_buckets() - 1);
+      port::prefetch<port::PREFETCH_HINT_T0>(&states[slot]);
+      port::prefetch<port::PREFETCH_HINT_T0>(&keys[slot]);
+    }
+
+    // Returns the bucket holding key, or -1 if there is none.
+    int64 FindSlot(K key, uint64 hash) const {
+      if (num_entries == 0) {
+        return -1;
+      }
+      const int64 mask = num_buckets() - 1;
+      for (int64 slot = hash & mask, probes = 0; probes < num_buckets();
+           slot = (slot + 1) & mask, ++probes) {
+        if (states[slot] == kEmpty) {
+          return -1;
+        }
+        if (states[slot] == kFull && keys[slot] == key) {
+          return slot;
+        }
+      }
+      return -1;
+    }
+
+    // Inserts or updates the entry for key. There must be an empty bucket.
+    void InsertOrUpdate(K key, V value, uint64 hash) {
+      const int64 mask = num_buckets() - 1;
+      int64 tombstone = -1;
+      for (int64 slot = hash & mask;; slot = (slot + 1) & mask) {
+        if (states[slot] == kFull) {
+          if (keys[slot] == key) {
+            values[slot] = value;
+            return;
+          }
+        } else if (states[slot] == kDeleted) {
+          if (tombstone < 0) {
+            tombstone = slot;
+          }
+        } else {
+          if (tombstone >= 0) {
+            slot = tombstone;
+          } else {
+            ++num_used;
+          }
+          states[slot] = kFull;
+          keys[slot] = key;
+          values[slot] = value;
+          ++num_entries;
+          return;
+        }
+      }
+    }
+
+    // Removes the entry for key, and returns whether there was one.
+    bool Erase(K key, uint64 hash) {
+      const int64 slot = FindSlot(key, hash);
+      if (slot < 0) {
+        return false;
+      }
+      states[slot] = kDeleted;
+      --num_entries;
+      return true;
+    }
+
+    void AppendEntries(std::vector<K>* entry_keys,
+                       std::vector<V>* entry_values) const {
+      for (int64 slot = 0; slot < num_buckets(); ++slot) {
+        if (states[slot] == kFull) {
+          entry_keys->push_back(keys[slot]);
+          entry_values->push_back(values[slot]);
+        }
+      }
+    }
+
+    int64 MemoryUsed() const {
+      return num_buckets() * (sizeof(K) + sizeof(V) + sizeof(uint8));
+    }
+  };
+
+  struct Shard {
+    mutable mutex mu;
+    Buckets current GUARDED_BY(mu);
+    // The table before the last resize, whose buckets before drain_position
+    // have been moved to `current`. Empty if no resize is in progress. A key
+    // is in at most one of the tables.
+    Buckets draining GUARDED_BY(mu);
+    int64 drain_position GUARDED_BY(mu) = 0;
+  };
+
+  // The keys of a batch grouped by shard, with their hashes.
+  class ShardedBatch {
+   public:
+    ShardedBatch(const MutableStripedHashTable& table,
+                 const std::vector<K>& keys)
+        : starts_(table.num_shards_ + 1, 0),
+          indices_(keys.size()),
+          hashes_(keys.size()) {
+      std::vector<uint64> key_hashes(keys.size());
+      for (int64 i = 0; i < keys.size(); ++i) {
+        key_hashes[i] = HashKey(keys[i]);
+        ++starts_[table.ShardIndex(key_hashes[i]) + 1];
+      }
+      for (int64 s = 0; s < table.num_shards_; ++s) {
+        starts_[s + 1] += starts_[s];
+      }
+      std::vector<int64> positions(starts_.begin(), starts_.end() - 1);
+      for (int64 i = 0; i < keys.size(); ++i) {
+        const int64 j = positions[table.ShardIndex(key_hashes[i])]++;
+        indices_[j] = i;
+        hashes_[j] = key_hashes[i];
+      }
+    }
+
+    // Positions of the keys of shard s in the batch are [begin(s), end(s)).
+    int64 begin(int64 s) const { return starts_[s]; }
+    int64 end(int64 s) const { return starts_[s + 1]; }
+    // The index in the input and the hash of the key at position j.
+    int64 index(int64 j) const { return indices_[j]; }
+    uint64 hash(int64 j) const { return hashes_[j]; }
+
+   private:
+    std::vector<int64> starts_;
+    std::vector<int64> indices_;
+    std::vector<uint64> hashes_;
+  };
+
+  // Keys are mixed so that consecutive ids spread over shards and buckets.
+  static uint64 HashKey(K key) {
+    uint64 h = static_cast<uint64>(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  // Buckets are selected by the low bits of the hash, shards by the high bits.
+  int64 ShardIndex(uint64 hash) const {
+    return (hash >> 40) & (num_shards_ - 1);
+  }
+
+  bool NeedsGrow(const Buckets& buckets) const {
+    return buckets.num_used + 1 > max_load_factor_ * buckets.num_buckets();
+  }
+
+  // Makes room for at least one more entry in the current table of shard.
+  void Grow(Shard* shard) EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    Buckets& current = shard->current;
+    // Tables that are mostly tombstones are rehashed at the same size.
+    const int64 num_buckets =
+        current.num_entries * 2 < max_load_factor_ * current.num_buckets()
+            ? current.num_buckets()
+            : current.num_buckets() * 2;
+    if (shard->draining.num_buckets() == 0) {
+      shard->draining = std::move(current);
+      shard->drain_position = 0;
+      current.Reset(num_buckets);
+      return;
+    }
+    // The previous resize hasn't finished, so everything is moved right away.
+    Buckets grown;
+    grown.Reset(num_buckets);
+    for (const Buckets* buckets : {&shard->current, &shard->draining}) {
+      for (int64 slot = 0; slot < buckets->num_buckets(); ++slot) {
+        if (buckets->states[slot] == kFull) {
+          grown.InsertOrUpdate(buckets->keys[slot], buckets->values[slot],
+                               HashKey(buckets->keys[slot]));
+        }
+      }
+    }
+    current = std::move(grown);
+    shard->draining = Buckets();
+    shard->drain_position = 0;
+  }
+
+  // Moves some buckets of a shard being resized to its current table.
+  void MigrateSome(Shard* shard) EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    Buckets& draining = shard->draining;
+    if (draining.num_buckets() == 0) {
+      return;
+    }
+    const int64 end = std::min(draining.num_buckets(),
+                               shard->drain_position + kBucketsMovedPerWrite);
+    for (; shard->drain_position < end; ++shard->drain_position) {
+      const int64 slot = shard->drain_position;
+      if (draining.states[slot] != kFull) {
+        continue;
+      }
+      if (NeedsGrow(shard->current)) {
+        // Moves the remaining buckets too.
+        Grow(shard);
+        return;
+      }
+      shard->current.InsertOrUpdate(draining.keys[slot], draining.values[slot],
+                                    HashKey(draining.keys[slot]));
+      draining.states[slot] = kDeleted;
+      --draining.num_entries;
+    }
+    if (shard->drain_position == draining.num_buckets()) {
+      draining = Buckets();
+      shard->drain_position = 0;
+    }
+  }
+
+  Status DoInsert(bool clear, const Tensor& keys, const Tensor& values) {
+    const auto key_values = keys.flat<K>();
+    const auto value_values = values.flat<V>();
+    std::vector<K> key_vector(key_values.size());
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      key_vector[i] = SubtleMustCopyIfIntegral(key_values(i));
+    }
+    ShardedBatch batch(*this, key_vector);
+    for (int64 s = 0; s < num_shards_; ++s) {
+      if (!clear && batch.begin(s) == batch.end(s)) {
+        continue;
+      }
+      Shard* shard = &shards_[s];
+      // Imports replace the contents of each shard atomically, but readers
+      // may see some shards before and others after the import.
+      mutex_lock l(shard->mu);
+      if (clear) {
+        shard->current.Reset(initial_buckets_per_shard_);
+        shard->draining = Buckets();
+        shard->drain_position = 0;
+      }
+      for (int64 j = batch.begin(s); j < batch.end(s); ++j) {
+        if (j + kPrefetchDistance < batch.end(s)) {
+          shard->current.Prefetch(batch.hash(j + kPrefetchDistance));
+        }
+        MigrateSome(shard);
+        const int64 i = batch.index(j);
+        const K key = key_vector[i];
+        const uint64 hash = batch.hash(j);
+        shard->draining.Erase(key, hash);
+        if (shard->current.FindSlot(key, hash) < 0 &&
+            NeedsGrow(shard->current)) {
+          Grow(shard);
+        }
+        shard->current.InsertOrUpdate(
+            key, SubtleMustCopyIfIntegral(value_values(i)), hash);
+      }
+    }
+    return Status::OK();
+  }
+
+  float max_load_factor_;
+  int64 num_shards_;
+  int64 initial_buckets_per_shard_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
+// Lookup table that maps int64 ids to dense embedding rows, for id spaces
+// that are too large or too sparse to pre-size a Variable for.
+//
+// Rows are only allocated for ids that have been gathered at least
+// admit_threshold times, and once the table holds more than max_rows rows
+// the least recently (lru) or least frequently (lfu) gathered ones are
+// evicted. Memory use thus follows the number of active ids instead of the
+// size of the id space.
+//
+// Besides the embedding, every row holds num_slots vectors of optimizer state
+// that the fused DynamicEmbeddingApply* kernels update in place. Find and
+// Insert only read and write the embedding, while ExportValues and
+// ImportValues use values of shape [size, 1 + num_slots, dim] so that the
+// optimizer state is checkpointed along with it. Lookup counts are not
+// exported; restored rows start out as if they had just been admitted.
+template <class V>
+class DynamicEmbeddingTable final : public LookupInterface {
+ public:
+  DynamicEmbeddingTable(OpKernelContext* ctx, OpKernel* kernel) {
+    OP_REQUIRES_OK(ctx,
+                   GetNodeAttr(kernel->def(), "value_shape", &value_shape_));
+    OP_REQUIRES(ctx,
+                TensorShapeUtils::IsVector(value_shape_) &&
+                    value_shape_.num_elements() > 0,
+                errors::InvalidArgument(
+                    "Default value must be a non-empty vector, got shape ",
+                    value_shape_.DebugString()));
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "admit_threshold",
+                                    &admit_threshold_));
+    OP_REQUIRES(ctx, admit_threshold_ >= 1,
+                errors::InvalidArgument(
+                    "admit_threshold must be at least 1, got: ",
+                    admit_threshold_));
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "max_rows", &max_rows_));
+    OP_REQUIRES(ctx, max_rows_ >= 0,
+                errors::InvalidArgument("max_rows must be non-negative, got: ",
+                                        max_rows_));
+    string eviction_policy;
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "eviction_policy",
+                                    &eviction_policy));
+    OP_REQUIRES(ctx, eviction_policy == "lru" || eviction_policy == "lfu",
+                errors::InvalidArgument(
+                    "eviction_policy must be 'lru' or 'lfu', got: ",
+                    eviction_policy));
+    evict_least_frequent_ = eviction_policy == "lfu";
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "num_slots", &num_slots_));
+    OP_REQUIRES(ctx, num_slots_ >= 0,
+                errors::InvalidArgument(
+                    "num_slots must be non-negative, got: ", num_slots_));
+    float slot_initial_value;
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "slot_initial_value",
+                                    &slot_initial_value));
+    slot_initial_value_ = static_cast<V>(slot_initial_value);
+    dim_ = value_shape_.dim_size(0);
+    row_size_ = (1 + num_slots_) * dim_;
+    if (max_rows_ > 0) {
+      max_candidates_ = max_rows_;
+    } else {
+      max_candidates_ = kDefaultMaxCandidates;
+    }
+  }
+
+  size_t size() const override {
+    tf_shared_lock l(mu_);
+    return rows_.size();
+  }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const auto default_flat = default_value.flat<V>();
+    const auto key_values = key.flat<int64>();
+    auto value_values = value->flat_inner_dims<V, 2>();
+
+    tf_shared_lock l(mu_);
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      const Row* row =
+          gtl::FindOrNull(rows_, SubtleMustCopyIfIntegral(key_values(i)));
+      for (int64 j = 0; j < dim_; ++j) {
+        value_values(i, j) = row != nullptr ? row->data[j] : default_flat(j);
+      }
+    }
+    return Status::OK();
+  }
+
+  // Like Find, but counts the lookups towards admission and eviction. Ids that
+  // reach admit_threshold get a row whose embedding is initialized to
+  // `default_value`.
+  Status Gather(const Tensor& keys, const Tensor& default_value,
+                Tensor* values) {
+    const auto default_flat = default_value.flat<V>();
+    const auto key_values = keys.flat<int64>();
+    auto value_values = values->flat_inner_dims<V, 2>();
+
+    mutex_lock l(mu_);
+    ++clock_;
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      const int64 key = SubtleMustCopyIfIntegral(key_values(i));
+      Row* row = gtl::FindOrNull(rows_, key);
+      if (row != nullptr) {
+        ++row->frequency;
+      } else {
+        auto candidate = candidates_.emplace(key, 0).first;
+        if (++candidate->second >= admit_threshold_) {
+          row = &rows_[key];
+          row->frequency = candidate->second;
+          InitializeRow(default_flat.data(), row);
+          candidates_.erase(candidate);
+        }
+      }
+      if (row != nullptr) {
+        row->last_access = clock_;
+      }
+      for (int64 j = 0; j < dim_; ++j) {
+        value_values(i, j) = row != nullptr ? row->data[j] : default_flat(j);
+      }
+    }
+    MaybeEvict();
+    MaybeDecayCandidates();
+    return Status::OK();
+  }
+
+  // Calls `update(i, row)` for the i-th element of `keys` if it has a row,
+  // with `row` pointing at the embedding followed by the slots. The table is
+  // locked exclusively for the whole batch.
+  template <typename Update>
+  void UpdateRows(const Tensor& keys, const Update& update) {
+    const auto key_values = keys.flat<int64>();
+    mutex_lock l(mu_);
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      Row* row =
+          gtl::FindOrNull(rows_, SubtleMustCopyIfIntegral(key_values(i)));
+      if (row != nullptr) {
+        update(i, row->data.data());
+      }
+    }
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    const auto key_values = keys.flat<int64>();
+    const auto value_values = values.flat_inner_dims<V, 2>();
+
+    mutex_lock l(mu_);
+    ++clock_;
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      const int64 key = SubtleMustCopyIfIntegral(key_values(i));
+      Row* row = &rows_[key];
+      if (row->data.empty()) {
+        row->frequency = admit_threshold_;
+        InitializeRow(&value_values(i, 0), row);
+        candidates_.erase(key);
+      } else {
+        std::copy_n(&value_values(i, 0), dim_, row->data.begin());
+      }
+      row->last_access = clock_;
+    }
+    MaybeEvict();
+    return Status::OK();
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    const auto key_values = keys.flat<int64>();
+
+    mutex_lock l(mu_);
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      const int64 key = SubtleMustCopyIfIntegral(key_values(i));
+      rows_.erase(key);
+      candidates_.erase(key);
+    }
+    return Status::OK();
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    const auto key_values = keys.flat<int64>();
+    const auto value_values = values.flat_inner_dims<V, 2>();
+
+    mutex_lock l(mu_);
+    rows_.clear();
+    candidates_.clear();
+    ++clock_;
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      Row* row = &rows_[SubtleMustCopyIfIntegral(key_values(i))];
+      row->frequency = admit_threshold_;
+      row->last_access = clock_;
+      row->data.assign(&value_values(i, 0), &value_values(i, 0) + row_size_);
+    }
+    MaybeEvict();
+    return Status::OK();
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    tf_shared_lock l(mu_);
+    const int64 size = rows_.size();
+
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), &keys));
+    TF_RETURN_IF_ERROR(ctx->allocate_output(
+        "values", TensorShape({size, 1 + num_slots_, dim_}), &values));
+
+    auto keys_data = keys->flat<int64>();
+    auto values_data = values->flat_inner_dims<V, 2>();
+    int64 i = 0;
+    for (const auto& it : rows_) {
+      keys_data(i) = it.first;
+      std::copy_n(it.second.data.begin(), row_size_, &values_data(i, 0));
+      ++i;
+    }
+    return Status::OK();
+  }
+
+  Status CheckKeyAndValueTensorsForImport(const Tensor& keys,
+                                          const Tensor& values) override {
+    TF_RETURN_IF_ERROR(CheckKeyAndValueTypes(keys, values));
+    TF_RETURN_IF_ERROR(CheckKeyShape(keys.shape()));
+    TensorShape expected_value_shape = keys.shape();
+    expected_value_shape.AddDim(1 + num_slots_);
+    expected_value_shape.AddDim(dim_);
+    if (values.shape() != expected_value_shape) {
+      return errors::InvalidArgument(
+          "Expected shape ", expected_value_shape.DebugString(),
+          " for value, got ", values.shape().DebugString());
+    }
+    return Status::OK();
+  }
+
+  DataType key_dtype() const override { return DT_INT64; }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const override { return TensorShape(); }
+
+  TensorShape value_shape() const override { return value_shape_; }
+
+  int64 num_slots() const { return num_slots_; }
+
+  int64 MemoryUsed() const override {
+    tf_shared_lock l(mu_);
+    return sizeof(DynamicEmbeddingTable) +
+           rows_.size() * (sizeof(int64) + sizeof(Row) +
+                           row_size_ * sizeof(V)) +
+           candidates_.size() * 2 * sizeof(int64);
+  }
+
+ private:
+  // Limit on the number of ids waiting for admission when max_rows is unset.
+  static constexpr int64 kDefaultMaxCandidates = 1 << 20;
+
+  // Once the table is full, rows are evicted in batches of max_rows divided
+  // by this, so that the scan over all rows is amortized over many
+  // admissions.
+  static constexpr int64 kEvictionBatchDivisor = 16;
+
+  struct Row {
+    int64 frequency = 0;
+    int64 last_access = 0;
+    std::vector<V> data;
+  };
+
+  void InitializeRow(const V* embedding, Row* row) const {
+    row->data.resize(row_size_, slot_initial_value_);
+    std::copy_n(embedding, dim_, row->data.begin());
+  }
+
+  void MaybeEvict() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (max_rows_ == 0 || rows_.size() <= max_rows_) {
+      return;
+    }
+    const int64 target = max_rows_ - max_rows_ / kEvictionBatchDivisor;
+    std::vector<std::pair<int64, int64>> scores;
+    scores.reserve(rows_.size());
+    for (const auto& it : rows_) {
+      scores.emplace_back(evict_least_frequent_ ? it.second.frequency
+                                                : it.second.last_access,
+                          it.first);
+    }
+    const int64 num_evicted = rows_.size() - target;
+    std::nth_element(scores.begin(), scores.begin() + num_evicted,
+                     scores.end());
+    for (int64 i = 0; i < num_evicted; ++i) {
+      rows_.erase(scores[i].second);
+    }
+    VLOG(2) << "Evicted " << num_evicted << " rows from embedding table";
+  }
+
+  // Ids that are looked up fewer than admit_threshold times would otherwise
+  // accumulate forever. When there are too many of them, their counts are
+  // halved and the ids whose count drops to zero are forgotten.
+  void MaybeDecayCandidates() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (candidates_.size() <= max_candidates_) {
+      return;
+    }
+    for (auto it = candidates_.begin(); it != candidates_.end();) {
+      it->second /= 2;
+      if (it->second == 0) {
+        it = candidates_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  TensorShape value_shape_;
+  int64 dim_;
+  int64 row_size_;
+  int64 admit_threshold_;
+  int64 max_rows_;
+  int64 max_candidates_;
+  bool evict_least_frequent_;
+  int64 num_slots_;
+  V slot_initial_value_;
+
+  mutable mutex mu_;
+  std::unordered_map<int64, Row> rows_ GUARDED_BY(mu_);
+  // Lookup counts of the ids that don't have a row yet.
+  std::unordered_map<int64, int64> candidates_ GUARDED_BY(mu_);
+  // Incremented on every Gather, Insert and ImportValues call, and used as
+  // the access time of the rows they touch.
+  int64 clock_ GUARDED_BY(mu_) = 0;
+};
+
 }  // namespace lookup
 
 // Table lookup op. Perform the lookup operation on the given table.
@@ -962,6 +1732,165 @@ REGISTER_KERNEL_BUILDER(Name("LookupTableImport").Device(DEVICE_CPU),
 REGISTER_KERNEL_BUILDER(Name("LookupTableImportV2").Device(DEVICE_CPU),
                         LookupTableImportOp);
 
+namespace {
+
+// Returns the DynamicEmbeddingTable<T> behind the "table_handle" input.
+template <typename T>
+Status GetDynamicEmbeddingTable(OpKernelContext* ctx,
+                                lookup::DynamicEmbeddingTable<T>** table) {
+  lookup::LookupInterface* base;
+  TF_RETURN_IF_ERROR(GetLookupTable("table_handle", ctx, &base));
+  *table = dynamic_cast<lookup::DynamicEmbeddingTable<T>*>(base);
+  if (*table == nullptr) {
+    base->Unref();
+    return errors::InvalidArgument(
+        "Table is not a DynamicEmbeddingTable with ",
+        DataTypeString(DataTypeToEnum<T>::v()), " values");
+  }
+  return Status::OK();
+}
+
+// Checks that `grad` holds one embedding gradient per element of `keys`.
+template <typename T>
+Status CheckEmbeddingGradient(const lookup::DynamicEmbeddingTable<T>& table,
+                              const Tensor& keys, const Tensor& grad) {
+  TensorShape expected_grad_shape = keys.shape();
+  expected_grad_shape.AppendShape(table.value_shape());
+  if (grad.shape() != expected_grad_shape) {
+    return errors::InvalidArgument(
+        "Expected shape ", expected_grad_shape.DebugString(), " for grad, got ",
+        grad.shape().DebugString());
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+// Looks up embeddings and counts the lookups towards admission and eviction.
+template <typename T>
+class DynamicEmbeddingLookupOp : public OpKernel {
+ public:
+  explicit DynamicEmbeddingLookupOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    lookup::DynamicEmbeddingTable<T>* table;
+    OP_REQUIRES_OK(ctx, GetDynamicEmbeddingTable(ctx, &table));
+    core::ScopedUnref unref_me(table);
+
+    const Tensor& keys = ctx->input(1);
+    const Tensor& default_value = ctx->input(2);
+    OP_REQUIRES_OK(ctx, table->CheckFindArguments(keys, default_value));
+
+    TensorShape output_shape = keys.shape();
+    output_shape.AppendShape(table->value_shape());
+    Tensor* values;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output("values", output_shape, &values));
+
+    int64 memory_used_before = 0;
+    if (ctx->track_allocations()) {
+      memory_used_before = table->MemoryUsed();
+    }
+    OP_REQUIRES_OK(ctx, table->Gather(keys, default_value, values));
+    if (ctx->track_allocations()) {
+      ctx->record_persistent_memory_allocation(table->MemoryUsed() -
+                                               memory_used_before);
+    }
+  }
+};
+
+// Applies a gradient descent step to the embeddings of `keys` in place.
+template <typename T>
+class DynamicEmbeddingApplyGradientDescentOp : public OpKernel {
+ public:
+  explicit DynamicEmbeddingApplyGradientDescentOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    lookup::DynamicEmbeddingTable<T>* table;
+    OP_REQUIRES_OK(ctx, GetDynamicEmbeddingTable(ctx, &table));
+    core::ScopedUnref unref_me(table);
+
+    const Tensor& lr = ctx->input(1);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(lr.shape()),
+                errors::InvalidArgument("lr is not a scalar: ",
+                                        lr.shape().DebugString()));
+    const Tensor& grad = ctx->input(2);
+    const Tensor& keys = ctx->input(3);
+    OP_REQUIRES_OK(ctx, CheckEmbeddingGradient(*table, keys, grad));
+
+    const int64 dim = table->value_shape().dim_size(0);
+    const auto grad_flat = grad.flat_inner_dims<T, 2>();
+    const T lr_scalar = lr.scalar<T>()();
+    table->UpdateRows(keys, [&](int64 i, T* row) {
+      typename TTypes<T>::UnalignedVec v(row, dim);
+      auto g = grad_flat.template chip<0>(i);
+      v -= g * g.constant(lr_scalar);
+    });
+  }
+};
+
+// Applies an Adagrad step to the embeddings of `keys` in place, keeping the
+// accumulator in the first slot of each row.
+template <typename T>
+class DynamicEmbeddingApplyAdagradOp : public OpKernel {
+ public:
+  explicit DynamicEmbeddingApplyAdagradOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    lookup::DynamicEmbeddingTable<T>* table;
+    OP_REQUIRES_OK(ctx, GetDynamicEmbeddingTable(ctx, &table));
+    core::ScopedUnref unref_me(table);
+    OP_REQUIRES(ctx, table->num_slots() >= 1,
+                errors::InvalidArgument(
+                    "Adagrad needs a table with at least one slot"));
+
+    const Tensor& lr = ctx->input(1);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(lr.shape()),
+                errors::InvalidArgument("lr is not a scalar: ",
+                                        lr.shape().DebugString()));
+    const Tensor& grad = ctx->input(2);
+    const Tensor& keys = ctx->input(3);
+    OP_REQUIRES_OK(ctx, CheckEmbeddingGradient(*table, keys, grad));
+
+    const int64 dim = table->value_shape().dim_size(0);
+    const auto grad_flat = grad.flat_inner_dims<T, 2>();
+    const T lr_scalar = lr.scalar<T>()();
+    table->UpdateRows(keys, [&](int64 i, T* row) {
+      typename TTypes<T>::UnalignedVec v(row, dim);
+      typename TTypes<T>::UnalignedVec a(row + dim, dim);
+      auto g = grad_flat.template chip<0>(i);
+      a += g.square();
+      v -= g.constant(lr_scalar) * g * a.rsqrt();
+    });
+  }
+};
+
+#define REGISTER_KERNEL(T)                                                    \
+  REGISTER_KERNEL_BUILDER(                                                    \
+      Name("DynamicEmbeddingTable")                                           \
+          .Device(DEVICE_CPU)                                                 \
+          .TypeConstraint<T>("value_dtype"),                                  \
+      LookupTableOp<lookup::DynamicEmbeddingTable<T>, int64, T>);             \
+  REGISTER_KERNEL_BUILDER(Name("DynamicEmbeddingLookup")                      \
+                              .Device(DEVICE_CPU)                             \
+                              .TypeConstraint<T>("value_dtype"),              \
+                          DynamicEmbeddingLookupOp<T>);                       \
+  REGISTER_KERNEL_BUILDER(Name("DynamicEmbeddingApplyGradientDescent")        \
+                              .Device(DEVICE_CPU)                             \
+                              .TypeConstraint<T>("T"),                        \
+                          DynamicEmbeddingApplyGradientDescentOp<T>);         \
+  REGISTER_KERNEL_BUILDER(Name("DynamicEmbeddingApplyAdagrad")                \
+                              .Device(DEVICE_CPU)                             \
+                              .TypeConstraint<T>("T"),                        \
+                          DynamicEmbeddingApplyAdagradOp<T>);
+
+REGISTER_KERNEL(float);
+REGISTER_KERNEL(double);
+
+#undef REGISTER_KERNEL
+
 // Register the HashTable op with the currently supported key and value types.
 #define REGISTER_KERNEL(key_dtype, value_dtype)                           \
   REGISTER_KERNEL_BUILDER(                                                \
@@ -1098,4 +2027,25 @@ REGISTER_KERNEL(string, int64);
 
 #undef REGISTER_KERNEL
 
+// Register the MutableStripedHashTable op.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                              \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("MutableStripedHashTable")                                        \
+          .Device(DEVICE_CPU)                                                \
+          .TypeConstraint<key_dtype>("key_dtype")                            \
+          .TypeConstraint<value_dtype>("value_dtype"),                       \
+      LookupTableOp<lookup::MutableStripedHashTable<key_dtype, value_dtype>, \
+                    key_dtype, value_dtype>)
+
+REGISTER_KERNEL(int32, double);
+REGISTER_KERNEL(int32, float);
+REGISTER_KERNEL(int32, int32);
+REGISTER_KERNEL(int32, int64);
+REGISTER_KERNEL(int64, double);
+REGISTER_KERNEL(int64, float);
+REGISTER_KERNEL(int64, int32);
+REGISTER_KERNEL(int64, int64);
+
+#undef REGISTER_KERNEL
+
 }  // namespace tensorflow
@@ -209,7 +209,7 @@ class HashTable : public InitializableLookupTable {
   DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
 
  protected:
-  Status DoPrepare(size_t unused) override {
+  Status DoPrepare(size_t expected_num_elements) override {
     if (is_initialized_) {
       return errors::Aborted("HashTable already initialized.");
     }
@@ -217,6 +217,7 @@ class HashTable : public InitializableLookupTable {
       table_ = std::unique_ptr<std::unordered_map<K, V>>(
           new std::unordered_map<K, V>());
     }
+    table_->reserve(expected_num_elements);
     return Status::OK();
   };
 
@@ -15,10 +15,18 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/lookup_util.h"
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/inputbuffer.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 namespace lookup {
@@ -48,9 +56,11 @@ Status GetNumLinesInTextFile(Env* env, const string& vocab_file,
   return Status::OK();
 }
 
-// Iterator that reads a text file. Each iteration process one line, it parses
-// the line and populates the keys and values tensors used for initialization
-// with a single key and corresponding value.
+// Iterator that reads a text file in blocks of lines. Each iteration parses
+// the lines of one block, in parallel on `thread_pool` when one is given,
+// and populates the keys and values tensors used for initialization with
+// the keys and values of all of them, so that the table inserts them in a
+// single batch.
 //
 // What information of the line to populate the key or values is specified by
 // providing key_index and value_index.
@@ -74,22 +84,27 @@ class TextFileLineIterator
   //   delimiter.
   Status Init(const string& filename, int64 vocab_size, char delimiter,
               DataType key_dtype, int64 key_index, DataType value_dtype,
-              int64 value_index, Env* env) {
+              int64 value_index, Env* env, thread::ThreadPool* thread_pool) {
     filename_ = filename;
     vocab_size_ = vocab_size;
     delimiter_ = delimiter;
-    key_ = Tensor(key_dtype, TensorShape({}));
-    value_ = Tensor(value_dtype, TensorShape({}));
+    key_dtype_ = key_dtype;
+    value_dtype_ = value_dtype;
     key_index_ = key_index;
     value_index_ = value_index;
     env_ = env;
+    thread_pool_ = thread_pool;
 
     status_ = env->NewRandomAccessFile(filename_, &file_);
     if (!status_.ok()) return status_;
 
-    input_buffer_.reset(new io::InputBuffer(file_.get(), kInputBufferSize));
     valid_ = true;
     next_id_ = 0;
+    file_offset_ = 0;
+    buffer_offset_ = 0;
+    consumed_ = 0;
+    eof_ = false;
+    truncated_ = false;
     ignore_split_ = std::max(key_index_, value_index_) < 0;
     Next();
     return status_;
@@ -98,8 +113,9 @@ class TextFileLineIterator
   void Next() override {
     if (!valid_) return;
 
-    string line;
-    status_ = input_buffer_->ReadLine(&line);
+    if (!truncated_) {
+      status_ = ReadLines();
+    }
     if (!status_.ok()) {
       if (errors::IsOutOfRange(status_) && vocab_size_ != -1 &&
           next_id_ != vocab_size_) {
@@ -119,38 +135,47 @@ class TextFileLineIterator
       valid_ = false;
       return;
     }
-    if (line.empty()) {
-      status_ = errors::InvalidArgument("Invalid content in ", filename_,
-                                        ": empty line found at position ",
-                                        input_buffer_->Tell(), ".");
-      valid_ = false;
-      return;
-    }
 
-    std::vector<string> tokens;
-    if (!ignore_split_) {
-      tokens = str_util::Split(line, delimiter_);
-      if (std::max(key_index_, value_index_) >= tokens.size()) {
-        status_ = errors::InvalidArgument(
-            "Invalid number of columns in ", filename_, " line ", next_id_,
-            " (", line, ") : expected ", std::max(key_index_, value_index_),
-            " got ", tokens.size());
-        valid_ = false;
-        return;
-      }
+    int64 num_lines = lines_.size();
+    if (vocab_size_ != -1 && next_id_ + num_lines > vocab_size_) {
+      num_lines = vocab_size_ - next_id_;
+      truncated_ = true;
     }
-    status_ = SetValue(line, tokens, key_index_, &key_);
-    if (!status_.ok()) {
-      valid_ = false;
-      return;
+    key_ = Tensor(key_dtype_, TensorShape({num_lines}));
+    value_ = Tensor(value_dtype_, TensorShape({num_lines}));
+
+    // The first error in the file wins, whichever shard finds it first.
+    mutex error_mu;
+    int64 error_line = num_lines;
+    Status error;
+    auto parse_lines = [this, &error_mu, &error_line, &error](int64 begin,
+                                                               int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        Status s = ParseLine(i);
+        if (!s.ok()) {
+          mutex_lock l(error_mu);
+          if (i < error_line) {
+            error_line = i;
+            error = s;
+          }
+          return;
+        }
+      }
+    };
+    if (thread_pool_ != nullptr && num_lines > 1) {
+      const int64 cost_per_line =
+          kCyclesPerByte * (consumed_ / lines_.size() + 1);
+      thread_pool_->ParallelFor(num_lines, cost_per_line, parse_lines);
+    } else {
+      parse_lines(0, num_lines);
     }
-    status_ = SetValue(line, tokens, value_index_, &value_);
-    if (!status_.ok()) {
+    if (!error.ok()) {
+      status_ = error;
       valid_ = false;
       return;
     }
 
-    next_id_++;
+    next_id_ += num_lines;
   }
 
   bool Valid() const override { return valid_; }
@@ -174,74 +199,181 @@ class TextFileLineIterator
     return vocab_size_;
   }
 
+  // Returns vocab_size if it is known, or else extrapolates the number of
+  // lines of the first block of the file to the size of the file.
+  int64 size_hint() const override {
+    if (vocab_size_ != -1) return vocab_size_;
+    if (eof_) return next_id_;
+    uint64 file_size;
+    if (next_id_ == 0 || !env_->GetFileSize(filename_, &file_size).ok()) {
+      return -1;
+    }
+    return file_size / std::max<uint64>(1, consumed_ / next_id_);
+  }
+
  private:
+  // Roughly the cost of parsing a byte of a line, used to shard the lines.
+  static const int64 kCyclesPerByte = 20;
+
   Tensor key_;
   Tensor value_;
   bool valid_;  // true if the iterator points to an existing range.
+  DataType key_dtype_;
+  DataType value_dtype_;
   int64 key_index_;
   int64 value_index_;
   Env* env_;
+  thread::ThreadPool* thread_pool_;  // Not owned; may be null.
   int64 next_id_;
   int64 vocab_size_;
   string filename_;
   char delimiter_;
   Status status_;
   bool ignore_split_;
-  std::unique_ptr<RandomAccessFile> file_;  // must outlive input_buffer_
-  std::unique_ptr<io::InputBuffer> input_buffer_;
+  std::unique_ptr<RandomAccessFile> file_;
+  uint64 file_offset_;    // Offset in the file of the next byte to read.
+  string buffer_;         // Bytes read from the file but not consumed yet.
+  uint64 buffer_offset_;  // Offset in the file of buffer_[0].
+  size_t consumed_;       // Number of bytes of buffer_ covered by lines_.
+  bool eof_;              // true once the last byte of the file was read.
+  bool truncated_;        // true once vocab_size lines have been returned.
+  std::vector<StringPiece> lines_;  // Lines of the current block.
+
+  // Reads the next block of whole lines of the file into lines_. Returns
+  // OutOfRange at the end of the file.
+  Status ReadLines() {
+    lines_.clear();
+    buffer_.erase(0, consumed_);
+    buffer_offset_ += consumed_;
+    consumed_ = 0;
+    size_t searched = 0;
+    while (!eof_ && buffer_.find('\n', searched) == string::npos) {
+      searched = buffer_.size();
+      buffer_.resize(searched + kInputBufferSize);
+      StringPiece data;
+      Status s = file_->Read(file_offset_, kInputBufferSize, &data,
+                             &buffer_[searched]);
+      if (!s.ok() && !errors::IsOutOfRange(s)) return s;
+      if (data.data() != &buffer_[searched]) {
+        memmove(&buffer_[searched], data.data(), data.size());
+      }
+      buffer_.resize(searched + data.size());
+      file_offset_ += data.size();
+      eof_ = !s.ok() || data.empty();
+    }
 
-  // Set the corresponding value from line or tokens based on 'index' into the
-  // tensor 't'. The value is transformed to the given data type 'dtype'.
-  Status SetValue(const string& line, const std::vector<string>& tokens,
-                  int64 index, Tensor* tensor) {
+    size_t begin = 0;
+    while (begin < buffer_.size()) {
+      size_t end = buffer_.find('\n', begin);
+      if (end == string::npos) {
+        if (!eof_) break;
+        end = buffer_.size();
+      }
+      StringPiece line(buffer_.data() + begin, end - begin);
+      if (str_util::EndsWith(line, "\r")) line.remove_suffix(1);
+      lines_.push_back(line);
+      begin = end + 1;
+    }
+    consumed_ = std::min(begin, buffer_.size());
+    if (lines_.empty()) {
+      return errors::OutOfRange("End of file ", filename_);
+    }
+    return Status::OK();
+  }
+
+  // Parses lines_[i] into element i of key_ and value_.
+  Status ParseLine(int64 i) {
+    const StringPiece line = lines_[i];
+    const int64 line_number = next_id_ + i;
+    if (line.empty()) {
+      const uint64 position =
+          buffer_offset_ + (line.data() - buffer_.data()) + 1;
+      return errors::InvalidArgument("Invalid content in ", filename_,
+                                     ": empty line found at position ",
+                                     position, ".");
+    }
+    StringPiece key_token = line;
+    StringPiece value_token = line;
+    if (!ignore_split_) {
+      if (!GetColumn(line, key_index_, &key_token) ||
+          !GetColumn(line, value_index_, &value_token)) {
+        const int64 num_columns =
+            std::count(line.begin(), line.end(), delimiter_) + 1;
+        return errors::InvalidArgument(
+            "Invalid number of columns in ", filename_, " line ", line_number,
+            " (", line, ") : expected ", std::max(key_index_, value_index_),
+            " got ", num_columns);
+      }
+    }
+    TF_RETURN_IF_ERROR(
+        SetValue(key_token, line_number, key_index_, i, &key_));
+    return SetValue(value_token, line_number, value_index_, i, &value_);
+  }
+
+  // Sets *column to the column 'index' of 'line', if 'index' >= 0. Returns
+  // false if the line has fewer columns.
+  bool GetColumn(StringPiece line, int64 index, StringPiece* column) const {
+    if (index < 0) return true;
+    size_t begin = 0;
+    for (int64 i = 0; i < index; ++i) {
+      begin = line.find(delimiter_, begin);
+      if (begin == StringPiece::npos) return false;
+      ++begin;
+    }
+    size_t end = line.find(delimiter_, begin);
+    if (end == StringPiece::npos) end = line.size();
+    *column = line.substr(begin, end - begin);
+    return true;
+  }
+
+  // Set the corresponding value from line or its column token based on
+  // 'index' into element 'i' of the tensor 't'. The value is transformed to
+  // the given data type 'dtype'.
+  Status SetValue(StringPiece token, int64 line_number, int64 index, int64 i,
+                  Tensor* tensor) {
     if (index == kLineNumber) {
-      tensor->flat<int64>()(0) = next_id_;
+      tensor->flat<int64>()(i) = line_number;
       return Status::OK();
     }
-    const string& token = (index == kWholeLine) ? line : tokens[index];
     const DataType& dtype = tensor->dtype();
     switch (dtype) {
       case DT_INT32: {
         int32 value;
-        if (!strings::safe_strto32(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
-                                         " is not a valid int32.");
+        if (!strings::safe_strto32(token, &value)) {
+          return errors::InvalidArgument("Field ", token, " in line ",
+                                         line_number, " is not a valid int32.");
         }
-        tensor->flat<int32>()(0) = value;
+        tensor->flat<int32>()(i) = value;
       } break;
       case DT_INT64: {
         int64 value;
-        if (!strings::safe_strto64(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
-                                         " is not a valid int64.");
+        if (!strings::safe_strto64(token, &value)) {
+          return errors::InvalidArgument("Field ", token, " in line ",
+                                         line_number, " is not a valid int64.");
         }
-        tensor->flat<int64>()(0) = value;
+        tensor->flat<int64>()(i) = value;
       } break;
       case DT_FLOAT: {
         float value;
-        if (!strings::safe_strtof(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
-                                         " is not a valid float.");
+        if (!strings::safe_strtof(token, &value)) {
+          return errors::InvalidArgument("Field ", token, " in line ",
+                                         line_number, " is not a valid float.");
         }
-        tensor->flat<float>()(0) = value;
+        tensor->flat<float>()(i) = value;
       } break;
       case DT_DOUBLE: {
         double value;
-        if (!strings::safe_strtod(token.c_str(), &value)) {
-          valid_ = false;
-          return errors::InvalidArgument("Field ", token, " in line ", next_id_,
-                                         " is not a valid double.");
+        if (!strings::safe_strtod(token, &value)) {
+          return errors::InvalidArgument(
+              "Field ", token, " in line ", line_number,
+              " is not a valid double.");
         }
-        tensor->flat<double>()(0) = value;
+        tensor->flat<double>()(i) = value;
       } break;
       case DT_STRING:
-        tensor->flat<string>()(0) = token;
+        tensor->flat<string>()(i) = string(token);
         break;
       default:
-        valid_ = false;
         return errors::InvalidArgument("Data type ", DataTypeString(dtype),
                                        " not supported.");
     }
@@ -340,6 +472,16 @@ Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
                                    char delimiter, int32 key_index,
                                    int32 value_index, Env* env,
                                    InitializableLookupTable* table) {
+  return InitializeTableFromTextFile(filename, vocab_size, delimiter,
+                                     key_index, value_index, env,
+                                     /*thread_pool=*/nullptr, table);
+}
+
+Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
+                                   char delimiter, int32 key_index,
+                                   int32 value_index, Env* env,
+                                   thread::ThreadPool* thread_pool,
+                                   InitializableLookupTable* table) {
   if (key_index == kLineNumber && table->key_dtype() != DT_INT64) {
     return errors::InvalidArgument(
         "Key index for line number requires table key dtype of int64, got ",
@@ -366,7 +508,8 @@ Status InitializeTableFromTextFile(const string& filename, int64 vocab_size,
 
   TextFileLineIterator iter;
   TF_RETURN_IF_ERROR(iter.Init(filename, vocab_size, delimiter, key_dtype,
-                               key_index, value_dtype, value_index, env));
+                               key_index, value_dtype, value_index, env,
+                               thread_pool));
   // For initialization from files, ignore if the table is already
   // initialized. The table shared name should contain the filename to
   // avoid trying to initialize the same table from the same file at the same
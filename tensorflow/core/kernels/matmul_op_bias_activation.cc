@@ -0,0 +1,159 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Implements the _FusedMatMul op: a MatMul followed by a BiasAdd and an
+// optional activation, with the bias add and the activation applied by an
+// Eigen output kernel inside the tensor contraction.
+
+#define EIGEN_USE_THREADS
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/fused_eigen_output_kernels.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Computes `out` = `a` * `b` with `output_kernel` fused into the
+// contraction.
+template <typename T, typename OutputKernel>
+void LaunchMatMulWithOutputKernel(
+    OpKernelContext* context, const Tensor& a, const Tensor& b,
+    const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair,
+    const OutputKernel& output_kernel, Tensor* out) {
+  const CPUDevice& d = context->eigen_device<CPUDevice>();
+  auto out_matrix = out->matrix<T>();
+
+  if (a.NumElements() == 0 || b.NumElements() == 0) {
+    // The product is all zeros, but the bias and the activation must still
+    // be applied, so run the output kernel over the whole output directly.
+    out_matrix.setZero();
+    typedef Eigen::internal::blas_data_mapper<T, Eigen::DenseIndex,
+                                              Eigen::ColMajor>
+        OutputMapper;
+    Eigen::TensorContractionParams params;
+    params.swapped_arguments = true;
+    output_kernel(OutputMapper(out_matrix.data(), out->dim_size(1)), params,
+                  Eigen::DenseIndex(0), Eigen::DenseIndex(0),
+                  static_cast<Eigen::DenseIndex>(out->dim_size(1)),
+                  static_cast<Eigen::DenseIndex>(out->dim_size(0)));
+    return;
+  }
+
+  out_matrix.device(d) =
+      a.matrix<T>().contract(b.matrix<T>(), dim_pair, output_kernel);
+}
+
+}  // namespace
+
+template <typename Device, typename T>
+class FusedMatMulOp : public OpKernel {
+ public:
+  explicit FusedMatMulOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_a", &transpose_a_));
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_b", &transpose_b_));
+    OP_REQUIRES_OK(context, InitializeFusedComputation(
+                                context, "_FusedMatMul", &fused_computation_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& a = context->input(0);
+    const Tensor& b = context->input(1);
+    const Tensor& bias = context->input(2);
+
+    // Check that the dimensions of the two matrices are valid.
+    OP_REQUIRES(
+        context, TensorShapeUtils::IsMatrix(a.shape()),
+        errors::InvalidArgument("In[0] is not a matrix. Instead it has shape ",
+                                a.shape().DebugString()));
+    OP_REQUIRES(
+        context, TensorShapeUtils::IsMatrix(b.shape()),
+        errors::InvalidArgument("In[1] is not a matrix. Instead it has shape ",
+                                b.shape().DebugString()));
+    Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> dim_pair;
+    dim_pair[0].first = transpose_a_ ? 0 : 1;
+    dim_pair[0].second = transpose_b_ ? 1 : 0;
+
+    OP_REQUIRES(
+        context,
+        a.dim_size(dim_pair[0].first) == b.dim_size(dim_pair[0].second),
+        errors::InvalidArgument(
+            "Matrix size-incompatible: In[0]: ", a.shape().DebugString(),
+            ", In[1]: ", b.shape().DebugString()));
+    const int a_dim_remaining = 1 - dim_pair[0].first;
+    const int b_dim_remaining = 1 - dim_pair[0].second;
+    TensorShape out_shape(
+        {a.dim_size(a_dim_remaining), b.dim_size(b_dim_remaining)});
+    OP_REQUIRES_OK(context, ValidateBias(bias, out_shape.dim_size(1)));
+
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, out_shape, &out));
+
+    if (out->NumElements() == 0) {
+      // If a has shape [0, x] or b has shape [x, 0], the output shape
+      // is a 0-element matrix, so there is nothing to do.
+      return;
+    }
+
+    const T* bias_data = bias.flat<T>().data();
+    switch (fused_computation_) {
+      case FusedComputationType::kBiasAdd:
+        LaunchMatMulWithOutputKernel<T>(
+            context, a, b, dim_pair,
+            BiasAddOutputKernel<T, IdentityActivation>(bias_data), out);
+        break;
+      case FusedComputationType::kBiasAddWithRelu:
+        LaunchMatMulWithOutputKernel<T>(
+            context, a, b, dim_pair,
+            BiasAddOutputKernel<T, ReluActivation>(bias_data), out);
+        break;
+      case FusedComputationType::kBiasAddWithRelu6:
+        LaunchMatMulWithOutputKernel<T>(
+            context, a, b, dim_pair,
+            BiasAddOutputKernel<T, Relu6Activation>(bias_data), out);
+        break;
+      case FusedComputationType::kUndefined:
+        context->SetStatus(
+            errors::Internal("Fused computation must be defined"));
+        break;
+    }
+  }
+
+ private:
+  bool transpose_a_;
+  bool transpose_b_;
+  FusedComputationType fused_computation_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FusedMatMulOp);
+};
+
+#define REGISTER_CPU(T)                                                 \
+  REGISTER_KERNEL_BUILDER(                                              \
+      Name("_FusedMatMul").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedMatMulOp<CPUDevice, T>);
+
+TF_CALL_float(REGISTER_CPU);
+TF_CALL_double(REGISTER_CPU);
+
+#undef REGISTER_CPU
+
+}  // namespace tensorflow
@@ -0,0 +1,351 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Implements the _QuantizedFusedMatMul and _QuantizedFusedConv2D ops, the
+// int8 counterparts of _FusedMatMul and _FusedConv2D. Their inputs and
+// outputs are float: the input is quantized symmetrically to int8 on the
+// fly, multiplied by weights quantized per output channel with int8_gemm, and
+// the 32-bit products are scaled back to float by the fused bias add and
+// activation.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/conv_ops.h"
+#include "tensorflow/core/kernels/fused_eigen_output_kernels.h"
+#include "tensorflow/core/kernels/int8_gemm.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Products are accumulated for at most this many rows at a time per shard.
+constexpr int64 kRowChunk = 64;
+
+// Returns the scale that maps [-range, range] to [-127, 127], where `range`
+// is `input_range` if it is positive and the largest magnitude in `input`
+// otherwise.
+float InputScale(OpKernelContext* context, const Tensor& input,
+                 float input_range) {
+  float range = input_range;
+  if (range <= 0) {
+    Eigen::Tensor<float, 0, Eigen::RowMajor> max_abs;
+    max_abs.device(context->eigen_device<CPUDevice>()) =
+        input.flat<float>().abs().maximum();
+    range = max_abs();
+  }
+  // An all-zero input quantizes to zeros with any scale.
+  return range > 0 ? range / 127.0f : 1.0f;
+}
+
+// Quantizes `input` to `*output` with `scale`, saturating values outside the
+// range of the scale.
+void QuantizeInput(OpKernelContext* context, const Tensor& input, float scale,
+                   Tensor* output) {
+  output->flat<int8>().device(context->eigen_device<CPUDevice>()) =
+      (input.flat<float>() * (1.0f / scale))
+          .round()
+          .cwiseMax(-127.0f)
+          .cwiseMin(127.0f)
+          .cast<int8>();
+}
+
+// Scales the int32 products of `num_rows` rows to float and applies the
+// bias and the activation of `fused_computation`.
+void OutputStage(const int32* products, int64 num_rows, int64 num_cols,
+                 int64 col_begin, int64 col_end, float input_scale,
+                 const float* filter_scales, const float* bias,
+                 FusedComputationType fused_computation, float* output) {
+  for (int64 i = 0; i < num_rows; ++i) {
+    const int32* row = products + i * num_cols;
+    float* out = output + i * num_cols;
+    for (int64 j = col_begin; j < col_end; ++j) {
+      float value = row[j] * (input_scale * filter_scales[j]) + bias[j];
+      switch (fused_computation) {
+        case FusedComputationType::kBiasAddWithRelu:
+          value = std::max(value, 0.0f);
+          break;
+        case FusedComputationType::kBiasAddWithRelu6:
+          value = std::min(std::max(value, 0.0f), 6.0f);
+          break;
+        default:
+          break;
+      }
+      out[j] = value;
+    }
+  }
+}
+
+}  // namespace
+
+// The attributes and the packed weights shared by the int8 kernels.
+class QuantizedFusedOpBase : public OpKernel {
+ public:
+  QuantizedFusedOpBase(OpKernelConstruction* context, const string& name)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("input_range", &input_range_));
+    OP_REQUIRES_OK(context, InitializeFusedComputation(context, name,
+                                                       &fused_computation_));
+  }
+
+ protected:
+  // Returns `filter` as a [rows, cols] GEMM operand. The weights are
+  // constants, so the packed matrix of the last filter is kept and reused
+  // as long as the filter has the same buffer.
+  std::shared_ptr<const int8_gemm::PackedMatrix> GetPackedFilter(
+      const Tensor& filter, int64 rows, int64 cols) {
+    mutex_lock l(mu_);
+    if (packed_filter_ == nullptr ||
+        !packed_filter_source_.SharesBufferWith(filter) ||
+        packed_filter_->rows() != rows || packed_filter_->cols() != cols) {
+      packed_filter_ = std::make_shared<int8_gemm::PackedMatrix>(
+          reinterpret_cast<const int8*>(filter.flat<qint8>().data()), rows,
+          cols);
+      // Holding a reference keeps the buffer from being reused by another
+      // tensor.
+      packed_filter_source_ = filter;
+    }
+    return packed_filter_;
+  }
+
+  Status ValidateScales(const Tensor& scales, int64 channels) {
+    if (scales.dims() != 1 || scales.dim_size(0) != channels) {
+      return errors::InvalidArgument("The filter scales must have shape [",
+                                     channels, "], got ",
+                                     scales.shape().DebugString());
+    }
+    return Status::OK();
+  }
+
+  float input_range_;
+  FusedComputationType fused_computation_;
+
+ private:
+  mutex mu_;
+  Tensor packed_filter_source_ GUARDED_BY(mu_);
+  std::shared_ptr<const int8_gemm::PackedMatrix> packed_filter_
+      GUARDED_BY(mu_);
+};
+
+class QuantizedFusedMatMulOp : public QuantizedFusedOpBase {
+ public:
+  explicit QuantizedFusedMatMulOp(OpKernelConstruction* context)
+      : QuantizedFusedOpBase(context, "_QuantizedFusedMatMul") {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& a = context->input(0);
+    const Tensor& b = context->input(1);
+    const Tensor& b_scales = context->input(2);
+    const Tensor& bias = context->input(3);
+    OP_REQUIRES(
+        context, TensorShapeUtils::IsMatrix(a.shape()),
+        errors::InvalidArgument("In[0] is not a matrix. Instead it has shape ",
+                                a.shape().DebugString()));
+    OP_REQUIRES(
+        context, TensorShapeUtils::IsMatrix(b.shape()),
+        errors::InvalidArgument("In[1] is not a matrix. Instead it has shape ",
+                                b.shape().DebugString()));
+    OP_REQUIRES(context, a.dim_size(1) == b.dim_size(0),
+                errors::InvalidArgument("Matrix size-incompatible: In[0]: ",
+                                        a.shape().DebugString(), ", In[1]: ",
+                                        b.shape().DebugString()));
+    const int64 m = a.dim_size(0);
+    const int64 k = a.dim_size(1);
+    const int64 n = b.dim_size(1);
+    OP_REQUIRES_OK(context, ValidateScales(b_scales, n));
+    OP_REQUIRES_OK(context, ValidateBias(bias, n));
+
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, {m, n}, &out));
+    if (out->NumElements() == 0) return;
+
+    const float input_scale = InputScale(context, a, input_range_);
+    Tensor quantized_a;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DT_INT8, a.shape(), &quantized_a));
+    QuantizeInput(context, a, input_scale, &quantized_a);
+    Tensor products;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DT_INT32, {m, n}, &products));
+
+    std::shared_ptr<const int8_gemm::PackedMatrix> packed_b =
+        GetPackedFilter(b, k, n);
+    const int8* a_data = quantized_a.flat<int8>().data();
+    int32* products_data = products.flat<int32>().data();
+    const float* scales_data = b_scales.flat<float>().data();
+    const float* bias_data = bias.flat<float>().data();
+    float* out_data = out->flat<float>().data();
+    const FusedComputationType fused_computation = fused_computation_;
+    auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    const int64 num_col_blocks =
+        (n + int8_gemm::kColumnBlock - 1) / int8_gemm::kColumnBlock;
+    if (m >= 4 * worker_threads->num_threads) {
+      // Enough rows for every thread: split them.
+      Shard(worker_threads->num_threads, worker_threads->workers, m, k * n,
+            [&](int64 begin, int64 end) {
+              int8_gemm::Gemm(a_data + begin * k, end - begin, *packed_b, 0,
+                              n, products_data + begin * n);
+              OutputStage(products_data + begin * n, end - begin, n, 0, n,
+                          input_scale, scales_data, bias_data,
+                          fused_computation, out_data + begin * n);
+            });
+    } else {
+      // Few rows, as when serving single examples: split the columns.
+      Shard(worker_threads->num_threads, worker_threads->workers,
+            num_col_blocks, m * k * int8_gemm::kColumnBlock,
+            [&](int64 begin, int64 end) {
+              const int64 col_begin = begin * int8_gemm::kColumnBlock;
+              const int64 col_end =
+                  std::min(n, end * int8_gemm::kColumnBlock);
+              int8_gemm::Gemm(a_data, m, *packed_b, col_begin, col_end,
+                              products_data);
+              OutputStage(products_data, m, n, col_begin, col_end,
+                          input_scale, scales_data, bias_data,
+                          fused_computation, out_data);
+            });
+    }
+  }
+};
+
+class QuantizedFusedConv2DOp : public QuantizedFusedOpBase {
+ public:
+  explicit QuantizedFusedConv2DOp(OpKernelConstruction* context)
+      : QuantizedFusedOpBase(context, "_QuantizedFusedConv2D") {
+    OP_REQUIRES_OK(context, InitConv2DParameters(context, &params_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    const Tensor& filter = context->input(1);
+    const Tensor& filter_scales = context->input(2);
+    const Tensor& bias = context->input(3);
+
+    Conv2DDimensions dims;
+    OP_REQUIRES_OK(context,
+                   ComputeConv2DDimension(params_, input, filter, &dims));
+    OP_REQUIRES(
+        context, dims.in_depth == filter.dim_size(2),
+        errors::Unimplemented(
+            "_QuantizedFusedConv2D does not support grouped convolutions."));
+    OP_REQUIRES_OK(context, ValidateScales(filter_scales, dims.out_depth));
+    OP_REQUIRES_OK(context, ValidateBias(bias, dims.out_depth));
+
+    TensorShape out_shape = ShapeFromFormat(
+        FORMAT_NHWC, dims.batch, dims.out_rows, dims.out_cols, dims.out_depth);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, out_shape, &output));
+    if (out_shape.num_elements() == 0) return;
+
+    const float input_scale = InputScale(context, input, input_range_);
+    Tensor quantized_input;
+    OP_REQUIRES_OK(context, context->allocate_temp(DT_INT8, input.shape(),
+                                                   &quantized_input));
+    QuantizeInput(context, input, input_scale, &quantized_input);
+
+    // The convolution is a GEMM of the [num_rows, depth] patches of the
+    // input, one row per output pixel, and the [depth, out_depth] filter.
+    const int64 depth = dims.filter_rows * dims.filter_cols * dims.in_depth;
+    const int64 n = dims.out_depth;
+    const int64 num_rows = dims.batch * dims.out_rows * dims.out_cols;
+    std::shared_ptr<const int8_gemm::PackedMatrix> packed_filter =
+        GetPackedFilter(filter, depth, n);
+    const bool is_pointwise = dims.filter_rows == 1 && dims.filter_cols == 1 &&
+                              dims.stride_rows == 1 && dims.stride_cols == 1;
+
+    const int8* input_data = quantized_input.flat<int8>().data();
+    const float* scales_data = filter_scales.flat<float>().data();
+    const float* bias_data = bias.flat<float>().data();
+    float* out_data = output->flat<float>().data();
+    const FusedComputationType fused_computation = fused_computation_;
+    auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_rows,
+          depth * n, [&](int64 begin, int64 end) {
+            std::vector<int8> patches;
+            std::vector<int32> products(std::min(kRowChunk, end - begin) * n);
+            for (int64 row = begin; row < end; row += kRowChunk) {
+              const int64 rows = std::min(kRowChunk, end - row);
+              const int8* a = input_data + row * dims.in_depth;
+              if (!is_pointwise) {
+                patches.resize(rows * depth);
+                ExtractPatches(dims, input_data, row, rows, patches.data());
+                a = patches.data();
+              }
+              int8_gemm::Gemm(a, rows, *packed_filter, 0, n, products.data());
+              OutputStage(products.data(), rows, n, 0, n, input_scale,
+                          scales_data, bias_data, fused_computation,
+                          out_data + row * n);
+            }
+          });
+  }
+
+ private:
+  // Writes the patches of the output pixels [first_row, first_row +
+  // num_rows), in NHWC order, to `patches`. The padding is zero.
+  static void ExtractPatches(const Conv2DDimensions& dims, const int8* input,
+                             int64 first_row, int64 num_rows, int8* patches) {
+    const int64 patch_row_bytes = dims.filter_cols * dims.in_depth;
+    for (int64 row = first_row; row < first_row + num_rows; ++row) {
+      const int64 out_col = row % dims.out_cols;
+      const int64 out_row = (row / dims.out_cols) % dims.out_rows;
+      const int64 batch = row / (dims.out_cols * dims.out_rows);
+      const int8* image =
+          input + batch * dims.input_rows * dims.input_cols * dims.in_depth;
+      for (int64 fy = 0; fy < dims.filter_rows; ++fy) {
+        const int64 in_row = out_row * dims.stride_rows - dims.pad_rows +
+                             fy * dims.dilation_rows;
+        int8* out = patches + fy * patch_row_bytes;
+        if (in_row < 0 || in_row >= dims.input_rows) {
+          memset(out, 0, patch_row_bytes);
+          continue;
+        }
+        for (int64 fx = 0; fx < dims.filter_cols; ++fx) {
+          const int64 in_col = out_col * dims.stride_cols - dims.pad_cols +
+                               fx * dims.dilation_cols;
+          int8* pixel = out + fx * dims.in_depth;
+          if (in_col < 0 || in_col >= dims.input_cols) {
+            memset(pixel, 0, dims.in_depth);
+          } else {
+            memcpy(pixel,
+                   image + (in_row * dims.input_cols + in_col) * dims.in_depth,
+                   dims.in_depth);
+          }
+        }
+      }
+      patches += dims.filter_rows * patch_row_bytes;
+    }
+  }
+
+  Conv2DParameters params_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("_QuantizedFusedMatMul").Device(DEVICE_CPU),
+                        QuantizedFusedMatMulOp);
+REGISTER_KERNEL_BUILDER(Name("_QuantizedFusedConv2D").Device(DEVICE_CPU),
+                        QuantizedFusedConv2DOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,124 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class QuantizedFusedOpsTest : public OpsTestBase {
+ protected:
+  void MakeMatMul(const std::vector<string>& fused_ops, float input_range) {
+    TF_ASSERT_OK(NodeDefBuilder("matmul", "_QuantizedFusedMatMul")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_QINT8))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(1, DT_FLOAT))
+                     .Attr("fused_ops", fused_ops)
+                     .Attr("input_range", input_range)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(QuantizedFusedOpsTest, MatMulWithBiasAndRelu) {
+  MakeMatMul({"BiasAdd", "Relu"}, 127);
+  // With a range of 127, the input is quantized to itself.
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<qint8>(TensorShape({3, 2}), {1, -1, 2, -2, 3, 30});
+  AddInputFromArray<float>(TensorShape({2}), {1, 0.5});
+  AddInputFromArray<float>(TensorShape({2}), {1, -40});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // [1 2 3] * [1 2 3] = 14, [1 2 3] * [-1 -2 30] = 85
+  // [4 5 6] * [1 2 3] = 32, [4 5 6] * [-1 -2 30] = 166
+  Tensor expected(DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&expected,
+                          {15, std::max(0.0f, 85 * 0.5f - 40), 33, 43});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(QuantizedFusedOpsTest, MatMulQuantizesWithInputRange) {
+  const int m = 3, k = 70, n = 33;
+  MakeMatMul({"BiasAdd"}, 0);
+  Tensor a(DT_FLOAT, TensorShape({m, k}));
+  a.flat<float>().setRandom();
+  a.flat<float>() -= a.flat<float>().constant(0.5f);
+  Tensor b(DT_QINT8, TensorShape({k, n}));
+  for (int i = 0; i < k * n; ++i) {
+    b.flat<qint8>()(i) = static_cast<int8>(i % 255 - 127);
+  }
+  AddInputFromArray<float>(a.shape(), a.flat<float>());
+  AddInputFromArray<qint8>(b.shape(), b.flat<qint8>());
+  AddInputFromArray<float>(TensorShape({n}), std::vector<float>(n, 0.01f));
+  AddInputFromArray<float>(TensorShape({n}), std::vector<float>(n, 2));
+  TF_ASSERT_OK(RunOpKernel());
+
+  // The input is quantized with the range of its values.
+  float max_abs = 0;
+  for (int i = 0; i < m * k; ++i) {
+    max_abs = std::max(max_abs, std::abs(a.flat<float>()(i)));
+  }
+  const float scale = max_abs / 127.0f;
+  Tensor expected(DT_FLOAT, TensorShape({m, n}));
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      int32 sum = 0;
+      for (int l = 0; l < k; ++l) {
+        const float value = a.matrix<float>()(i, l) * (1.0f / scale);
+        sum += static_cast<int32>(std::round(value)) *
+               static_cast<int8>(b.matrix<qint8>()(l, j));
+      }
+      expected.matrix<float>()(i, j) = sum * scale * 0.01f + 2;
+    }
+  }
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-4);
+}
+
+TEST_F(QuantizedFusedOpsTest, Conv2DWithBias) {
+  TF_ASSERT_OK(NodeDefBuilder("conv", "_QuantizedFusedConv2D")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_QINT8))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(1, DT_FLOAT))
+                   .Attr("strides", {1, 1, 1, 1})
+                   .Attr("padding", "SAME")
+                   .Attr("fused_ops", {"BiasAdd"})
+                   .Attr("input_range", 127.0f)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<float>(TensorShape({1, 3, 3, 1}),
+                           {1, 2, 3, 4, 5, 6, 7, 8, 9});
+  AddInputFromArray<qint8>(TensorShape({2, 2, 1, 1}), {1, 1, 1, 1});
+  AddInputFromArray<float>(TensorShape({1}), {2});
+  AddInputFromArray<float>(TensorShape({1}), {-1});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // SAME padding of a 2x2 filter pads the bottom and the right with zeros.
+  Tensor expected(DT_FLOAT, TensorShape({1, 3, 3, 1}));
+  test::FillValues<float>(&expected,
+                          {23, 31, 17, 47, 55, 29, 29, 33, 17});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+}  // namespace tensorflow
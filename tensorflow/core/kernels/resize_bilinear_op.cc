@@ -99,16 +99,43 @@ inline float compute_lerp(const float top_left, const float top_right,
   return top + (bottom - top) * y_lerp;
 }
 
+// Interpolates one output row from the input rows above and below it. When
+// kChannels is not 0, it is the number of channels, known at compile time so
+// that the loop over channels is unrolled and vectorized.
+template <int kChannels, typename T>
+inline void resize_row(const T* ys_input_lower_ptr, const T* ys_input_upper_ptr,
+                       const float ys_lerp, const CachedInterpolation* xs,
+                       const int64 out_width, const int channels,
+                       float* output_y_ptr) {
+  const int num_channels = kChannels > 0 ? kChannels : channels;
+  for (int64 x = 0; x < out_width; ++x) {
+    const int64 xs_lower = xs[x].lower;
+    const int64 xs_upper = xs[x].upper;
+    const float xs_lerp = xs[x].lerp;
+    for (int c = 0; c < num_channels; ++c) {
+      const float top_left(ys_input_lower_ptr[xs_lower + c]);
+      const float top_right(ys_input_lower_ptr[xs_upper + c]);
+      const float bottom_left(ys_input_upper_ptr[xs_lower + c]);
+      const float bottom_right(ys_input_upper_ptr[xs_upper + c]);
+      output_y_ptr[x * num_channels + c] = compute_lerp(
+          top_left, top_right, bottom_left, bottom_right, xs_lerp, ys_lerp);
+    }
+  }
+}
+
 template <typename T>
-void resize_image(
-    typename TTypes<T, 4>::ConstTensor images, const int batch_size,
-    const int64 in_height, const int64 in_width, const int64 out_height,
-    const int64 out_width, const int channels,
-    const std::vector<CachedInterpolation>& xs,
-    const std::vector<CachedInterpolation>& ys,
-    typename TTypes<float, 4>::Tensor output) TF_ATTRIBUTE_NOINLINE;
+void resize_image(const CPUDevice& d,
+                  typename TTypes<T, 4>::ConstTensor images,
+                  const int batch_size, const int64 in_height,
+                  const int64 in_width, const int64 out_height,
+                  const int64 out_width, const int channels,
+                  const std::vector<CachedInterpolation>& xs,
+                  const std::vector<CachedInterpolation>& ys,
+                  typename TTypes<float, 4>::Tensor output)
+    TF_ATTRIBUTE_NOINLINE;
 template <typename T>
-void resize_image(typename TTypes<T, 4>::ConstTensor images,
+void resize_image(const CPUDevice& d,
+                  typename TTypes<T, 4>::ConstTensor images,
                   const int batch_size, const int64 in_height,
                   const int64 in_width, const int64 out_height,
                   const int64 out_width, const int channels,
@@ -119,80 +146,38 @@ void resize_image(typename TTypes<T, 4>::ConstTensor images,
   const int64 in_batch_num_values = in_height * in_row_size;
   const int64 out_row_size = out_width * channels;
 
-  const T* input_b_ptr = images.data();
+  const T* input_ptr = images.data();
+  float* output_ptr = output.data();
   const CachedInterpolation* xs = xs_vec.data();
 
-  if (channels == 3) {
-    float* output_y_ptr = output.data();
-    for (int b = 0; b < batch_size; ++b) {
-      for (int64 y = 0; y < out_height; ++y) {
-        const T* ys_input_lower_ptr = input_b_ptr + ys[y].lower * in_row_size;
-        const T* ys_input_upper_ptr = input_b_ptr + ys[y].upper * in_row_size;
-        const float ys_lerp = ys[y].lerp;
-        for (int64 x = 0; x < out_width; ++x) {
-          const int64 xs_lower = xs[x].lower;
-          const int64 xs_upper = xs[x].upper;
-          const float xs_lerp = xs[x].lerp;
-
-          // Read channel 0.
-          const float top_left0(ys_input_lower_ptr[xs_lower + 0]);
-          const float top_right0(ys_input_lower_ptr[xs_upper + 0]);
-          const float bottom_left0(ys_input_upper_ptr[xs_lower + 0]);
-          const float bottom_right0(ys_input_upper_ptr[xs_upper + 0]);
-
-          // Read channel 1.
-          const float top_left1(ys_input_lower_ptr[xs_lower + 1]);
-          const float top_right1(ys_input_lower_ptr[xs_upper + 1]);
-          const float bottom_left1(ys_input_upper_ptr[xs_lower + 1]);
-          const float bottom_right1(ys_input_upper_ptr[xs_upper + 1]);
-
-          // Read channel 2.
-          const float top_left2(ys_input_lower_ptr[xs_lower + 2]);
-          const float top_right2(ys_input_lower_ptr[xs_upper + 2]);
-          const float bottom_left2(ys_input_upper_ptr[xs_lower + 2]);
-          const float bottom_right2(ys_input_upper_ptr[xs_upper + 2]);
-
-          // Compute output.
-          output_y_ptr[x * channels + 0] =
-              compute_lerp(top_left0, top_right0, bottom_left0, bottom_right0,
-                           xs_lerp, ys_lerp);
-          output_y_ptr[x * channels + 1] =
-              compute_lerp(top_left1, top_right1, bottom_left1, bottom_right1,
-                           xs_lerp, ys_lerp);
-          output_y_ptr[x * channels + 2] =
-              compute_lerp(top_left2, top_right2, bottom_left2, bottom_right2,
-                           xs_lerp, ys_lerp);
-        }
-        output_y_ptr += out_row_size;
+  // The output rows of all images are independent, so they are sharded
+  // across the threads of the device.
+  auto resize_rows = [&](int64 begin, int64 end) {
+    for (int64 row = begin; row < end; ++row) {
+      const int64 b = row / out_height;
+      const int64 y = row % out_height;
+      const T* input_b_ptr = input_ptr + b * in_batch_num_values;
+      const T* ys_input_lower_ptr = input_b_ptr + ys[y].lower * in_row_size;
+      const T* ys_input_upper_ptr = input_b_ptr + ys[y].upper * in_row_size;
+      float* output_y_ptr = output_ptr + row * out_row_size;
+      if (channels == 3) {
+        resize_row<3>(ys_input_lower_ptr, ys_input_upper_ptr, ys[y].lerp, xs,
+                      out_width, channels, output_y_ptr);
+      } else if (channels == 4) {
+        resize_row<4>(ys_input_lower_ptr, ys_input_upper_ptr, ys[y].lerp, xs,
+                      out_width, channels, output_y_ptr);
+      } else {
+        resize_row<0>(ys_input_lower_ptr, ys_input_upper_ptr, ys[y].lerp, xs,
+                      out_width, channels, output_y_ptr);
       }
-      input_b_ptr += in_batch_num_values;
     }
-  } else {
-    float* output_y_ptr = output.data();
-    for (int b = 0; b < batch_size; ++b) {
-      for (int64 y = 0; y < out_height; ++y) {
-        const T* ys_input_lower_ptr = input_b_ptr + ys[y].lower * in_row_size;
-        const T* ys_input_upper_ptr = input_b_ptr + ys[y].upper * in_row_size;
-        const float ys_lerp = ys[y].lerp;
-        for (int64 x = 0; x < out_width; ++x) {
-          auto xs_lower = xs[x].lower;
-          auto xs_upper = xs[x].upper;
-          auto xs_lerp = xs[x].lerp;
-          for (int c = 0; c < channels; ++c) {
-            const float top_left(ys_input_lower_ptr[xs_lower + c]);
-            const float top_right(ys_input_lower_ptr[xs_upper + c]);
-            const float bottom_left(ys_input_upper_ptr[xs_lower + c]);
-            const float bottom_right(ys_input_upper_ptr[xs_upper + c]);
-            output_y_ptr[x * channels + c] =
-                compute_lerp(top_left, top_right, bottom_left, bottom_right,
-                             xs_lerp, ys_lerp);
-          }
-        }
-        output_y_ptr += out_row_size;
-      }
-      input_b_ptr += in_batch_num_values;
-    }
-  }
+  };
+  const Eigen::TensorOpCost row_cost(
+      4 * out_row_size * sizeof(T), out_row_size * sizeof(float),
+      out_row_size * (Eigen::TensorOpCost::AddCost<float>() * 6 +
+                      Eigen::TensorOpCost::MulCost<float>() * 3 +
+                      Eigen::TensorOpCost::CastCost<T, float>() * 4));
+  d.parallelFor(batch_size * out_height, row_cost, resize_rows);
 }
 
 }  // namespace
@@ -232,7 +217,7 @@ struct ResizeBilinear<CPUDevice, T> {
       xs[i].upper *= channels;
     }
 
-    resize_image<T>(images, batch_size, in_height, in_width, out_height,
+    resize_image<T>(d, images, batch_size, in_height, in_width, out_height,
                     out_width, channels, xs, ys, output);
   }
 };
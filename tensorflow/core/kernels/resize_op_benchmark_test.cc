@@ -52,6 +52,7 @@ BM_ResizeDev(cpu, ResizeNearestNeighbor, 10, 499, 499);
 BM_ResizeDev(gpu, ResizeNearestNeighbor, 10, 499, 499);
 
 BM_ResizeDev(cpu, ResizeBilinear, 10, 499, 499);
+BM_ResizeDev(cpu, ResizeBilinear, 1, 960, 540);
 BM_ResizeDev(gpu, ResizeBilinear, 10, 499, 499);
 
 }  // namespace tensorflow
@@ -641,7 +641,7 @@ class ResourceScatterUpdateOp : public OpKernel {
     core::ScopedUnref unref_v(v);
     mutex_lock ml(*v->mu());
     Tensor* params = v->tensor();
-    OP_REQUIRES_OK(c, PrepareToUpdateVariable<Device, T>(c, params));
+    OP_REQUIRES_OK(c, PrepareToUpdateVariableSparse<Device, T>(c, params));
     const Tensor& indices = c->input(1);
     const Tensor& updates = c->input(2);
 
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <complex>
 #include <functional>
 #include <memory>
@@ -26,11 +27,15 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -353,5 +358,60 @@ TEST_F(RestoreV2OpTest, RestoreAfterSaveV2) { RunTest("SaveV2"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveSlicesV1) { RunTest("SaveSlices"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveV1) { RunTest("Save"); }
 
+TEST_F(RestoreV2OpTest, RestoreFromMultipleDataFiles) {
+  const string dir = io::JoinPath(testing::TmpDir(), "multiple_data_files");
+  const string prefix = io::JoinPath(dir, "merged");
+  const int kNumShards = 3;
+  std::vector<string> shard_prefixes;
+  std::vector<string> tensor_names;
+  for (int shard = 0; shard < kNumShards; ++shard) {
+    shard_prefixes.push_back(
+        io::JoinPath(dir, strings::StrCat("shard", shard)));
+    BundleWriter writer(Env::Default(), shard_prefixes.back());
+    for (int i = 0; i < 4; ++i) {
+      // Interleaves the tensor names of the shards.
+      tensor_names.push_back(strings::StrCat("tensor", i, "_", shard));
+      TF_ASSERT_OK(writer.Add(
+          tensor_names.back(),
+          MakeInput<float>(TensorShape({2, 3}), [shard, i](int x) -> float {
+            return shard * 100 + i * 10 + x;
+          })));
+    }
+    TF_ASSERT_OK(writer.Finish());
+  }
+  TF_ASSERT_OK(MergeBundles(Env::Default(), shard_prefixes, prefix));
+
+  // Restores the tensors in reverse order, to check that the outputs follow
+  // the order of the requested names.
+  std::reverse(tensor_names.begin(), tensor_names.end());
+  const int num_tensors = tensor_names.size();
+  TF_ASSERT_OK(
+      NodeDefBuilder("myop", "RestoreV2")
+          .Input(FakeInput())  // prefix
+          .Input(FakeInput())  // tensor_names
+          .Input(FakeInput())  // shape_and_slices
+          .Attr("dtypes", DataTypeVector(num_tensors, DT_FLOAT))
+          .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInput<string>(TensorShape({}),
+                   [&prefix](int x) -> string { return prefix; });
+  AddInput<string>(
+      TensorShape({num_tensors}),
+      [&tensor_names](int x) -> string { return tensor_names[x]; });
+  AddInput<string>(TensorShape({num_tensors}),
+                   [](int x) -> string { return ""; });
+  TF_ASSERT_OK(RunOpKernel());
+
+  for (int i = 0; i < num_tensors; ++i) {
+    const int shard = (num_tensors - 1 - i) / 4;
+    const int index = (num_tensors - 1 - i) % 4;
+    test::ExpectTensorEqual<float>(
+        *GetOutput(i),
+        MakeInput<float>(TensorShape({2, 3}), [shard, index](int x) -> float {
+          return shard * 100 + index * 10 + x;
+        }));
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
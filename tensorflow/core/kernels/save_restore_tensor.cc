@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/save_restore_tensor.h"
+#include <algorithm>
+#include <map>
 #include <numeric>
 #include <unordered_map>
 #include <utility>
@@ -28,8 +30,10 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -236,6 +240,54 @@ namespace {
 // Tensors larger than this threshold will be restored from a thread-pool.
 const int64 kLargeShapeThreshold = 16 << 20;  // 16M
 
+// Returns the number of threads RestoreV2 uses to restore large tensors and,
+// for bundles with several data files, to restore the tensors of different
+// data files in parallel.  Can be overridden with the TF_RESTORE_NUM_THREADS
+// environment variable; a value of 1 restores all the tensors of a bundle from
+// the op thread, except for large tensors.
+int64 RestoreNumThreads() {
+  static const int64 num_threads = []() {
+    int64 num_threads;
+    TF_CHECK_OK(
+        ReadInt64FromEnvVar("TF_RESTORE_NUM_THREADS", 8, &num_threads));
+    return std::max<int64>(num_threads, 1);
+  }();
+  return num_threads;
+}
+
+// Returns the BundleReader options used by RestoreV2.  Setting the
+// TF_RESTORE_USE_MMAP environment variable to true restores full tensors
+// as read-only views of the memory-mapped checkpoint data files; this is
+// only safe for graphs that never modify the restored variables in place,
+// e.g. serving graphs.
+const BundleReader::Options& RestoreReaderOptions() {
+  static const BundleReader::Options* options = []() {
+    BundleReader::Options* options = new BundleReader::Options;
+    TF_CHECK_OK(ReadBoolFromEnvVar("TF_RESTORE_USE_MMAP", false,
+                                   &options->use_mmap));
+    return options;
+  }();
+  return *options;
+}
+
+// Returns whether RestoreV2 shares the buffers of the restored tensors that
+// are equal to tensors restored earlier in the process, through
+// RestoredTensorPool.  Set with the TF_RESTORE_SHARE_TENSORS environment
+// variable, e.g. to load two versions of a model side by side without
+// duplicating their unchanged variables.  Only tensors of at least
+// kMinSharedTensorBytes are shared.
+bool RestoreSharesTensors() {
+  static const bool share_tensors = []() {
+    bool share_tensors;
+    TF_CHECK_OK(ReadBoolFromEnvVar("TF_RESTORE_SHARE_TENSORS", false,
+                                   &share_tensors));
+    return share_tensors;
+  }();
+  return share_tensors;
+}
+
+const int64 kMinSharedTensorBytes = 64 << 10;  // 64K
+
 // A restore operation for a single tensor.  Small tensors may be restored
 // directly from the op thread to improve read locality.  Large tensors can be
 // restored from a thread pool: this requires creating a separate BundleReader
@@ -256,7 +308,7 @@ struct RestoreOp {
 
   // Run this restore operation using a new BundleReader.
   void run_with_new_reader() {
-    BundleReader reader(Env::Default(), reader_prefix);
+    BundleReader reader(Env::Default(), reader_prefix, RestoreReaderOptions());
     if (!reader.status().ok()) {
       status = reader.status();
       return;
@@ -273,11 +325,27 @@ struct RestoreOp {
     VLOG(1) << "Restoring tensor " << idx << " : " << tensor_name << " : "
             << restored_full_shape.num_elements();
     Tensor* restored_tensor;
-    if (shape_and_slice.empty()) {
+    std::vector<TensorSlice> stored_slices;
+    if (shape_and_slice.empty() && RestoreReaderOptions().use_mmap &&
+        reader->LookupTensorSlices(tensor_name, &stored_slices).ok() &&
+        stored_slices.empty()) {
+      // Lets the reader create the output, so that it can be backed by the
+      // mapped data file instead of a freshly allocated buffer.
+      Tensor restored;
+      TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, &restored));
+      context->set_output(idx, restored);
+    } else if (shape_and_slice.empty()) {
       // Lookup the full tensor.
       TF_RETURN_IF_ERROR(
           context->allocate_output(idx, restored_full_shape, &restored_tensor));
       TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, restored_tensor));
+      uint32 crc32c;
+      if (RestoreSharesTensors() &&
+          restored_tensor->TotalBytes() >= kMinSharedTensorBytes &&
+          reader->LookupChecksum(tensor_name, &crc32c).ok()) {
+        context->set_output(idx, RestoredTensorPool::Global()->Share(
+                                     *restored_tensor, crc32c));
+      }
     } else {
       // Lookup the slice.
       TensorShape parsed_full_shape;
@@ -312,6 +380,28 @@ struct RestoreOp {
   ::tensorflow::Status status;
 };
 
+// The restore operations for the tensors stored in one data file of a
+// bundle; see RestoreTensorsV2.  The operations run in order, using a
+// BundleReader owned by the thread that runs them.
+struct ShardRestoreOps {
+  void run(const string& reader_prefix) {
+    const uint64 start_micros = Env::Default()->NowMicros();
+    BundleReader reader(Env::Default(), reader_prefix, RestoreReaderOptions());
+    status = reader.status();
+    for (size_t i = 0; status.ok() && i < ops.size(); ++i) {
+      status = ops[i]->run(&reader);
+    }
+    VLOG(1) << "Restored " << ops.size() << " tensors from data file "
+            << shard_id << " of " << reader_prefix << " in "
+            << (Env::Default()->NowMicros() - start_micros) / 1000 << " ms";
+  }
+
+  int32 shard_id;
+  std::vector<RestoreOp*> ops;  // Not owned.
+
+  ::tensorflow::Status status;
+};
+
 }  // namespace
 
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
@@ -334,7 +424,8 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   std::vector<std::unique_ptr<RestoreOp> > pool_restore_ops;
   std::vector<std::unique_ptr<RestoreOp> > direct_restore_ops;
 
-  BundleReader default_reader(Env::Default(), prefix_string);
+  BundleReader default_reader(Env::Default(), prefix_string,
+                              RestoreReaderOptions());
   TF_RETURN_IF_ERROR(default_reader.status());
 
   std::vector<string> mismatched_errors;
@@ -369,25 +460,59 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     }
   }
 
+  // When the bundle has several data files, the small tensors are grouped by
+  // data file and each group is restored from the thread pool, so that reads
+  // of different files are issued in parallel.  The groups are ordered by data
+  // file, and each keeps the tensors sorted by name.
+  const int64 num_threads = RestoreNumThreads();
+  std::vector<ShardRestoreOps> shard_restore_ops;
+  if (num_threads > 1 && default_reader.num_shards() > 1 &&
+      direct_restore_ops.size() > 1) {
+    std::map<int32, std::vector<RestoreOp*> > ops_by_shard;
+    for (auto& op : direct_restore_ops) {
+      int32 shard_id;
+      TF_RETURN_IF_ERROR(
+          default_reader.LookupShardId(op->tensor_name, &shard_id));
+      ops_by_shard[shard_id].push_back(op.get());
+    }
+    if (ops_by_shard.size() > 1) {
+      shard_restore_ops.reserve(ops_by_shard.size());
+      for (auto& shard_and_ops : ops_by_shard) {
+        shard_restore_ops.push_back(
+            {shard_and_ops.first, std::move(shard_and_ops.second)});
+      }
+    }
+  }
+
   {
     // Schedule any threaded operations first, skipping thread pool creation if
     // we don't have any expensive operations.
     std::unique_ptr<thread::ThreadPool> reader_pool;
-    if (!pool_restore_ops.empty()) {
-      reader_pool.reset(
-          new thread::ThreadPool(Env::Default(), "restore_tensors", 8));
+    if (!pool_restore_ops.empty() || !shard_restore_ops.empty()) {
+      reader_pool.reset(new thread::ThreadPool(Env::Default(),
+                                               "restore_tensors", num_threads));
       for (auto& op : pool_restore_ops) {
         reader_pool->Schedule([&op]() { op->run_with_new_reader(); });
       }
+      for (auto& shard_ops : shard_restore_ops) {
+        reader_pool->Schedule(
+            [&shard_ops, &prefix_string]() { shard_ops.run(prefix_string); });
+      }
     }
 
-    // Read small tensors from the op thread
-    for (auto& op : direct_restore_ops) {
-      TF_RETURN_IF_ERROR(op->run(&default_reader));
+    // Read small tensors from the op thread, unless they are restored per data
+    // file from the thread pool.
+    if (shard_restore_ops.empty()) {
+      for (auto& op : direct_restore_ops) {
+        TF_RETURN_IF_ERROR(op->run(&default_reader));
+      }
     }
   }
 
   // Check status of pool ops; this must come after the pool shuts down.
+  for (auto& shard_ops : shard_restore_ops) {
+    TF_RETURN_IF_ERROR(shard_ops.status);
+  }
   for (auto& op : pool_restore_ops) {
     TF_RETURN_IF_ERROR(op->status);
   }
@@ -405,4 +530,110 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   return Status::OK();
 }
 
+BackgroundCheckpointWriter::BackgroundCheckpointWriter(Env* env,
+                                                       int64 max_pending_bytes)
+    : env_(env), max_pending_bytes_(max_pending_bytes) {
+  thread_.reset(env_->StartThread(ThreadOptions(), "checkpoint_writer",
+                                  [this]() { WriterLoop(); }));
+}
+
+BackgroundCheckpointWriter::~BackgroundCheckpointWriter() {
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+  }
+  cond_var_.notify_all();
+  // Joins the writer thread, which drains the queue first.
+  thread_.reset();
+}
+
+BackgroundCheckpointWriter* BackgroundCheckpointWriter::Global() {
+  static BackgroundCheckpointWriter* writer =
+      []() -> BackgroundCheckpointWriter* {
+    int64 buffer_mb;
+    TF_CHECK_OK(
+        ReadInt64FromEnvVar("TF_ASYNC_CHECKPOINT_BUFFER_MB", 0, &buffer_mb));
+    if (buffer_mb <= 0) return nullptr;
+    return new BackgroundCheckpointWriter(Env::Default(), buffer_mb << 20);
+  }();
+  return writer;
+}
+
+Status BackgroundCheckpointWriter::Schedule(const string& prefix,
+                                            int64 num_bytes,
+                                            std::function<Status()> write) {
+  {
+    mutex_lock l(mu_);
+    while (pending_bytes_ > 0 &&
+           pending_bytes_ + num_bytes > max_pending_bytes_) {
+      cond_var_.wait(l);
+    }
+    if (!unreported_error_.ok()) {
+      Status s = unreported_error_;
+      unreported_error_ = Status::OK();
+      return errors::Aborted("A previous background checkpoint write failed: ",
+                             s.ToString());
+    }
+    pending_bytes_ += num_bytes;
+    ++num_pending_writes_[prefix];
+    queue_.push_back({prefix, num_bytes, std::move(write)});
+  }
+  cond_var_.notify_all();
+  return Status::OK();
+}
+
+Status BackgroundCheckpointWriter::WaitFor(const string& prefix) {
+  mutex_lock l(mu_);
+  while (num_pending_writes_.count(prefix) > 0) {
+    cond_var_.wait(l);
+  }
+  auto it = prefix_errors_.find(prefix);
+  if (it == prefix_errors_.end()) return Status::OK();
+  Status s = it->second;
+  prefix_errors_.erase(it);
+  return s;
+}
+
+Status BackgroundCheckpointWriter::WaitForAll() {
+  mutex_lock l(mu_);
+  while (!num_pending_writes_.empty()) {
+    cond_var_.wait(l);
+  }
+  Status s = unreported_error_;
+  unreported_error_ = Status::OK();
+  return s;
+}
+
+void BackgroundCheckpointWriter::WriterLoop() {
+  while (true) {
+    PendingWrite pending;
+    {
+      mutex_lock l(mu_);
+      while (queue_.empty() && !cancelled_) {
+        cond_var_.wait(l);
+      }
+      if (queue_.empty()) return;
+      pending = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    const uint64 start_micros = env_->NowMicros();
+    const Status s = pending.write();
+    VLOG(1) << "Background write of checkpoint " << pending.prefix << " took "
+            << (env_->NowMicros() - start_micros) / 1000 << " ms";
+    {
+      mutex_lock l(mu_);
+      pending_bytes_ -= pending.num_bytes;
+      auto it = num_pending_writes_.find(pending.prefix);
+      if (--it->second == 0) num_pending_writes_.erase(it);
+      if (!s.ok()) {
+        LOG(ERROR) << "Background write of checkpoint " << pending.prefix
+                   << " failed: " << s;
+        prefix_errors_.emplace(pending.prefix, s);
+        unreported_error_.Update(s);
+      }
+    }
+    cond_var_.notify_all();
+  }
+}
+
 }  // namespace tensorflow
@@ -16,6 +16,15 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_SAVE_RESTORE_TENSOR_H_
 #define TENSORFLOW_CORE_KERNELS_SAVE_RESTORE_TENSOR_H_
 
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_writer.h"
 
@@ -68,6 +77,81 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& shape_and_slices,
                         gtl::ArraySlice<DataType> dtypes);
 
+// Runs the file writes of the SaveV2 and MergeV2Checkpoints ops on a
+// background thread, one at a time and in the order they were scheduled, so
+// that a checkpoint save only blocks the step for the time it takes to
+// snapshot the saved tensors into host memory.
+//
+// A checkpoint is durable once the writes scheduled for its prefix have
+// completed.  BundleWriter only renames its files into place when it
+// finishes, so readers never see a partially written bundle; RestoreV2 waits
+// for the pending writes of the prefix it reads.
+class BackgroundCheckpointWriter {
+ public:
+  // "max_pending_bytes" bounds the host memory held by the snapshots of the
+  // writes that have not completed yet: Schedule() blocks until there is
+  // room.  A write larger than the bound is admitted once nothing else is
+  // pending.
+  BackgroundCheckpointWriter(Env* env, int64 max_pending_bytes);
+
+  // Waits for all the scheduled writes to complete.
+  ~BackgroundCheckpointWriter();
+
+  // Returns the writer used by the checkpoint ops, or nullptr if checkpoint
+  // files are written synchronously (the default).  Setting the
+  // TF_ASYNC_CHECKPOINT_BUFFER_MB environment variable to a positive value
+  // enables background writes, with that many megabytes of snapshot memory.
+  //
+  // Checkpoints that have been saved but not written yet are lost if the
+  // process exits; use WaitForAll() before shutting down.
+  static BackgroundCheckpointWriter* Global();
+
+  // Schedules "write", which writes the files of the checkpoint "prefix" and
+  // holds "num_bytes" of host memory until it returns.
+  //
+  // Returns, and does not schedule "write", if a previously scheduled write
+  // has failed since the last call: the error is reported only once.
+  Status Schedule(const string& prefix, int64 num_bytes,
+                  std::function<Status()> write) TF_MUST_USE_RESULT;
+
+  // Blocks until the writes scheduled for "prefix" have completed, and
+  // returns the first error among the ones that have not been returned by
+  // an earlier call.  May be called from a scheduled write, e.g. to depend on
+  // the writes of an earlier prefix.
+  Status WaitFor(const string& prefix) TF_MUST_USE_RESULT;
+
+  // Blocks until all the scheduled writes have completed, and returns the
+  // first error that has not been returned by Schedule() yet.
+  Status WaitForAll() TF_MUST_USE_RESULT;
+
+ private:
+  struct PendingWrite {
+    string prefix;
+    int64 num_bytes;
+    std::function<Status()> write;
+  };
+
+  void WriterLoop();
+
+  Env* const env_;
+  const int64 max_pending_bytes_;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  std::deque<PendingWrite> queue_ GUARDED_BY(mu_);
+  // Counts the write in progress.
+  int64 pending_bytes_ GUARDED_BY(mu_) = 0;
+  std::unordered_map<string, int> num_pending_writes_ GUARDED_BY(mu_);
+  // The first error of each prefix that has not been returned by WaitFor().
+  std::unordered_map<string, Status> prefix_errors_ GUARDED_BY(mu_);
+  // The first error that has not been returned by Schedule().
+  Status unreported_error_ GUARDED_BY(mu_);
+  bool cancelled_ GUARDED_BY(mu_) = false;
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BackgroundCheckpointWriter);
+};
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_KERNELS_SAVE_RESTORE_TENSOR_H_
@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/bounds_check.h"
@@ -87,7 +88,36 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
 
 }  // namespace
 
+// Writes the named tensors, with their validated "shape_and_slices" specs, to
+// the bundle "prefix".
+Status WriteTensorBundle(const string& prefix,
+                         const std::vector<string>& tensor_names,
+                         const std::vector<string>& shape_and_slices,
+                         const std::vector<Tensor>& tensors) {
+  BundleWriter writer(Env::Default(), prefix);
+  TF_RETURN_IF_ERROR(writer.status());
+  VLOG(1) << "BundleWriter, prefix_string: " << prefix;
+
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    if (!shape_and_slices[i].empty()) {
+      TensorShape shape;
+      TensorSlice slice(tensors[i].dims());
+      TensorShape slice_shape;
+      TF_RETURN_IF_ERROR(checkpoint::ParseShapeAndSlice(
+          shape_and_slices[i], &shape, &slice, &slice_shape));
+      TF_RETURN_IF_ERROR(
+          writer.AddSlice(tensor_names[i], shape, slice, tensors[i]));
+    } else {
+      TF_RETURN_IF_ERROR(writer.Add(tensor_names[i], tensors[i]));
+    }
+  }
+  return writer.Finish();
+}
+
 // Saves a list of named tensors using the tensor bundle library.
+//
+// If BackgroundCheckpointWriter::Global() is enabled, the op only snapshots
+// the tensors and the bundle is written in the background.
 class SaveV2 : public OpKernel {
  public:
   explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {}
@@ -105,12 +135,7 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<string>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
-    OP_REQUIRES_OK(context, writer.status());
-    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
-
     for (int i = 0; i < num_tensors; ++i) {
-      const string& tensor_name = tensor_names_flat(i);
       const Tensor& tensor = context->input(i + kFixedInputs);
 
       if (!shape_and_slices_flat(i).empty()) {
@@ -127,14 +152,40 @@ class SaveV2 : public OpKernel {
                                             "shape of the tensor to  save: ",
                                             shape_spec, ", tensor: ",
                                             tensor.shape().DebugString()));
-
-        OP_REQUIRES_OK(context,
-                       writer.AddSlice(tensor_name, shape, slice, tensor));
-      } else {
-        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
       }
     }
-    OP_REQUIRES_OK(context, writer.Finish());
+
+    std::vector<string> names(num_tensors);
+    std::vector<string> specs(num_tensors);
+    std::vector<Tensor> tensors(num_tensors);
+    for (int i = 0; i < num_tensors; ++i) {
+      names[i] = tensor_names_flat(i);
+      specs[i] = shape_and_slices_flat(i);
+      tensors[i] = context->input(i + kFixedInputs);
+    }
+
+    BackgroundCheckpointWriter* background_writer =
+        BackgroundCheckpointWriter::Global();
+    if (background_writer == nullptr) {
+      OP_REQUIRES_OK(context,
+                     WriteTensorBundle(prefix_string, names, specs, tensors));
+      return;
+    }
+
+    // The inputs may be variables that the following steps update in place,
+    // so the background write uses a private copy of them.
+    int64 num_bytes = 0;
+    for (Tensor& tensor : tensors) {
+      tensor = tensor::DeepCopy(tensor);
+      num_bytes += tensor.TotalBytes();
+    }
+    OP_REQUIRES_OK(
+        context,
+        background_writer->Schedule(
+            prefix_string, num_bytes,
+            [prefix_string, names, specs, tensors]() {
+              return WriteTensorBundle(prefix_string, names, specs, tensors);
+            }));
   }
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
@@ -159,6 +210,12 @@ class RestoreV2 : public OpKernel {
 
     const string& prefix_string = prefix.scalar<string>()();
 
+    BackgroundCheckpointWriter* background_writer =
+        BackgroundCheckpointWriter::Global();
+    if (background_writer != nullptr) {
+      OP_REQUIRES_OK(context, background_writer->WaitFor(prefix_string));
+    }
+
     // Intention: we plan to use the RestoreV2 op as a backward-compatible
     // reader as we upgrade to the V2 format.  This allows transparent upgrade.
     // We here attempt to read a V1 checkpoint, if "prefix_string" does not
@@ -191,6 +248,9 @@ class RestoreV2 : public OpKernel {
 REGISTER_KERNEL_BUILDER(Name("RestoreV2").Device(DEVICE_CPU), RestoreV2);
 
 // The final step in saving sharded V2 checkpoints: merges metadata files.
+//
+// If BackgroundCheckpointWriter::Global() is enabled, the merge runs in the
+// background, after the writes of the input bundles.
 class MergeV2Checkpoints : public OpKernel {
  public:
   explicit MergeV2Checkpoints(OpKernelConstruction* context)
@@ -212,14 +272,43 @@ class MergeV2Checkpoints : public OpKernel {
                     "Input destination_prefix should be a scalar tensor, got ",
                     destination_prefix.shape().DebugString(), " instead."));
 
-    const gtl::ArraySlice<string> input_prefixes =
-        gtl::ArraySlice<string>(checkpoint_prefixes.flat<string>());
-    Env* env = Env::Default();
+    const auto& input_prefixes_flat = checkpoint_prefixes.flat<string>();
+    const std::vector<string> input_prefixes(
+        input_prefixes_flat.data(),
+        input_prefixes_flat.data() + input_prefixes_flat.size());
     const string& merged_prefix = destination_prefix.scalar<string>()();
+
+    BackgroundCheckpointWriter* background_writer =
+        BackgroundCheckpointWriter::Global();
+    if (background_writer == nullptr) {
+      OP_REQUIRES_OK(context, Merge(input_prefixes, merged_prefix,
+                                    delete_old_dirs_));
+      return;
+    }
+    // Merges once the input bundles have been written, which are scheduled
+    // before the merge.
+    const bool delete_old_dirs = delete_old_dirs_;
     OP_REQUIRES_OK(
-        context, tensorflow::MergeBundles(env, input_prefixes, merged_prefix));
+        context,
+        background_writer->Schedule(
+            merged_prefix, 0,
+            [background_writer, input_prefixes, merged_prefix,
+             delete_old_dirs]() {
+              for (const string& input_prefix : input_prefixes) {
+                TF_RETURN_IF_ERROR(background_writer->WaitFor(input_prefix));
+              }
+              return Merge(input_prefixes, merged_prefix, delete_old_dirs);
+            }));
+  }
+
+ private:
+  static Status Merge(const std::vector<string>& input_prefixes,
+                      const string& merged_prefix, bool delete_old_dirs) {
+    Env* env = Env::Default();
+    TF_RETURN_IF_ERROR(
+        tensorflow::MergeBundles(env, input_prefixes, merged_prefix));
 
-    if (delete_old_dirs_) {
+    if (delete_old_dirs) {
       const string merged_dir(io::Dirname(merged_prefix));
       for (const string& input_prefix : input_prefixes) {
         const string dirname(io::Dirname(input_prefix));
@@ -230,9 +319,9 @@ class MergeV2Checkpoints : public OpKernel {
         if (!status.ok()) VLOG(1) << status;
       }
     }
+    return Status::OK();
   }
 
- private:
   // On merge, whether or not to delete the input (temporary) directories.
   bool delete_old_dirs_;
 };
@@ -15,14 +15,17 @@ limitations under the License.
 
 #include <complex>
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/framework/fake_input.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/save_restore_tensor.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/env.h"
@@ -339,5 +342,51 @@ TEST_F(SaveV2OpTest, Simple) {
   }
 }
 
+TEST(BackgroundCheckpointWriterTest, WritesInOrder) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "background_writes");
+  std::vector<int> completed;
+  {
+    // Each write is larger than the budget, so they are admitted one by one.
+    BackgroundCheckpointWriter writer(Env::Default(), 1);
+    for (int i = 0; i < 4; ++i) {
+      TF_ASSERT_OK(writer.Schedule(prefix, 16, [&completed, i, prefix]() {
+        BundleWriter bundle_writer(Env::Default(), prefix);
+        TF_RETURN_IF_ERROR(
+            bundle_writer.Add("step", test::AsScalar<int32>(i)));
+        completed.push_back(i);
+        return bundle_writer.Finish();
+      }));
+    }
+    TF_ASSERT_OK(writer.WaitFor(prefix));
+    EXPECT_EQ(4, completed.size());
+    TF_ASSERT_OK(writer.WaitForAll());
+  }
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), completed);
+
+  // The bundle holds the last write.
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  TF_ASSERT_OK(reader.Lookup("step", &val));
+  test::ExpectTensorEqual<int32>(test::AsScalar<int32>(3), val);
+}
+
+TEST(BackgroundCheckpointWriterTest, ReportsErrors) {
+  BackgroundCheckpointWriter writer(Env::Default(), 1 << 20);
+  TF_ASSERT_OK(
+      writer.Schedule("bad", 0, []() { return errors::Internal("bad"); }));
+  TF_ASSERT_OK(writer.Schedule("good", 0, []() { return Status::OK(); }));
+  EXPECT_EQ(error::INTERNAL, writer.WaitFor("bad").code());
+  // Reported once per prefix.
+  TF_EXPECT_OK(writer.WaitFor("bad"));
+  TF_EXPECT_OK(writer.WaitFor("good"));
+
+  // The next write is rejected with the unreported error, once.
+  EXPECT_EQ(error::ABORTED,
+            writer.Schedule("next", 0, []() { return Status::OK(); }).code());
+  TF_EXPECT_OK(writer.Schedule("next", 0, []() { return Status::OK(); }));
+  TF_EXPECT_OK(writer.WaitForAll());
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_KERNELS_SCATTER_FUNCTOR_H_
 
 #include <type_traits>
+#include <vector>
 
 #include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -25,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/framework/variant_op_registry.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/dense_update_functor.h"
+#include "tensorflow/core/kernels/sparse_update_sharding.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -318,6 +320,45 @@ struct ScatterFunctorBase<CPUDevice, T, Index, scatter_op::UpdateOp::ASSIGN> {
   }
 };
 
+template <typename T, typename Index, scatter_op::UpdateOp op>
+struct ScatterFunctorBase<CPUDevice, T, Index, op> {
+  Index operator()(OpKernelContext* c, const CPUDevice& d,
+                   typename TTypes<T>::Matrix params,
+                   typename TTypes<T>::ConstMatrix updates,
+                   typename TTypes<Index>::ConstFlat indices) {
+    // indices and params sizes were validated in DoCompute().
+    const Index N = static_cast<Index>(indices.size());
+    const Index limit = static_cast<Index>(params.dimension(0));
+    auto update = [&params, &updates](Index i, Index index) {
+      // Copy last Ndim-1 dimensions of updates[i] to params[index]
+      scatter_op::internal::Assign<op>::Run(params.template chip<0>(index),
+                                            updates.template chip<0>(i));
+    };
+    // Large updates are applied to shards of rows in parallel.
+    const int64 cost_per_update = updates.dimension(1) * 5;
+    const int num_shards =
+        sparse_update_sharding::NumRowShards(c, N, cost_per_update);
+    if (num_shards > 1) {
+      std::vector<Index> rows;
+      const Index bad_i = sparse_update_sharding::CopyRows(indices, limit,
+                                                           &rows);
+      if (bad_i >= 0) return bad_i;
+      sparse_update_sharding::ForEachUpdate<Index>(c, num_shards, rows,
+                                                   cost_per_update, update);
+      return -1;
+    }
+    for (Index i = 0; i < N; i++) {
+      // Grab the index and check its validity.  Do this carefully,
+      // to avoid checking the value and grabbing it again from
+      // memory a second time (a security risk since it may change in between).
+      const Index index = ::tensorflow::internal::SubtleMustCopy(indices(i));
+      if (!FastBoundsCheck(index, limit)) return i;
+      update(i, index);
+    }
+    return -1;
+  }
+};
+
 template <typename T, typename Index, scatter_op::UpdateOp op>
 struct ScatterFunctor<CPUDevice, T, Index, op>
     : ScatterFunctorBase<CPUDevice, T, Index, op> {};
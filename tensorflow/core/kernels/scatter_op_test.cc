@@ -38,8 +38,9 @@ namespace {
 
 class ScatterUpdateOpTest : public OpsTestBase {
  protected:
-  void MakeOp(DataType variable_ref_type, DataType index_type) {
-    TF_ASSERT_OK(NodeDefBuilder("myop", "ScatterUpdate")
+  void MakeOp(DataType variable_ref_type, DataType index_type,
+              const string& op = "ScatterUpdate") {
+    TF_ASSERT_OK(NodeDefBuilder("myop", op)
                      .Input(FakeInput(variable_ref_type))
                      .Input(FakeInput(index_type))
                      .Input(FakeInput(RemoveRefType(variable_ref_type)))
@@ -160,6 +161,50 @@ TEST_F(ScatterUpdateOpTest, HigherRank) {
   test::ExpectTensorEqual<float>(expected, params_tensor);
 }
 
+TEST_F(ScatterUpdateOpTest, LargeAddWithDuplicateIndices) {
+  MakeOp(DT_INT32_REF, DT_INT32, "ScatterAdd");
+  // Enough updates to be applied on several threads.
+  const int rows = 100, cols = 64, n = 4000;
+  std::vector<int32> indices(n);
+  std::vector<int32> updates(n * cols);
+  std::vector<int32> expected_values(rows * cols, 1);
+  for (int i = 0; i < n; ++i) {
+    indices[i] = (i * 7) % rows;
+    for (int j = 0; j < cols; ++j) {
+      updates[i * cols + j] = i + j;
+      expected_values[indices[i] * cols + j] += i + j;
+    }
+  }
+  AddInputFromArray<int32>(TensorShape({rows, cols}),
+                           std::vector<int32>(rows * cols, 1));
+  AddInputFromArray<int32>(TensorShape({n}), indices);
+  AddInputFromArray<int32>(TensorShape({n, cols}), updates);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_INT32, TensorShape({rows, cols}));
+  test::FillValues<int32>(&expected, expected_values);
+  test::ExpectTensorEqual<int32>(expected, *mutable_input(0).tensor);
+}
+
+TEST_F(ScatterUpdateOpTest, LargeAddWithIndexOutOfRange) {
+  MakeOp(DT_INT32_REF, DT_INT32, "ScatterAdd");
+  const int rows = 100, cols = 64, n = 4000;
+  std::vector<int32> indices(n);
+  for (int i = 0; i < n; ++i) {
+    indices[i] = i % rows;
+  }
+  indices[1234] = rows;
+  AddInputFromArray<int32>(TensorShape({rows, cols}),
+                           std::vector<int32>(rows * cols, 0));
+  AddInputFromArray<int32>(TensorShape({n}), indices);
+  AddInputFromArray<int32>(TensorShape({n, cols}),
+                           std::vector<int32>(n * cols, 1));
+  Status s = RunOpKernel();
+  EXPECT_TRUE(str_util::StrContains(s.ToString(),
+                                    "indices[1234] = 100 is not in [0, 100)"))
+      << s;
+}
+
 TEST_F(ScatterUpdateOpTest, Error_IndexOutOfRange) {
   MakeOp(DT_FLOAT_REF, DT_INT32);
 
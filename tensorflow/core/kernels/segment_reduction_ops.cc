@@ -33,7 +33,9 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #if GOOGLE_CUDA
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
@@ -48,6 +50,16 @@ namespace tensorflow {
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
+bool DeterministicSegmentReductions() {
+  static bool deterministic = [] {
+    bool deterministic;
+    TF_CHECK_OK(ReadBoolFromEnvVar("TF_DETERMINISTIC_SEGMENT_REDUCTIONS",
+                                   /*default_val=*/false, &deterministic));
+    return deterministic;
+  }();
+  return deterministic;
+}
+
 // Static routines not in the templated class to reduce code size
 static void SegmentReductionValidationHelper(OpKernelContext* context,
                                              const Tensor& input,
@@ -68,6 +80,12 @@ static bool SegmentReductionDoValidation(OpKernelContext* c,
   return c->status().ok();
 }
 
+static Status SegmentIdOutOfRangeError(int64 segment_id, int64 output_rows) {
+  return errors::InvalidArgument(
+      "Segment id ", segment_id, " out of range [0, ", output_rows,
+      "), possibly because 'segment_ids' input is not sorted.");
+}
+
 // This operator handles reducing segments along the first dimension.
 // See core/ops/math_ops.cc for more details.
 template <typename Device, class T, class Index, typename Reducer,
@@ -111,86 +129,93 @@ class SegmentReductionOp : public OpKernel {
                 errors::InvalidArgument("segment ids must be >= 0"));
     auto output_flat = output->flat_outer_dims<T>();
 
+    // Find where every segment starts, checking that the segment ids are
+    // increasing, then reduce the segments in parallel.
+    std::vector<int64> segment_starts = {0};
+    std::vector<Index> segment_out_indices;
+    Index out_index = internal::SubtleMustCopy(segment_vec(0));
+    for (int64 end = 1; end < num_indices; ++end) {
+      const Index next_index = internal::SubtleMustCopy(segment_vec(end));
+      if (next_index == out_index) continue;
+      OP_REQUIRES(context, out_index < next_index,
+                  errors::InvalidArgument("segment ids are not increasing"));
+      OP_REQUIRES(context, FastBoundsCheck(out_index, output_rows),
+                  SegmentIdOutOfRangeError(out_index, output_rows));
+      segment_starts.push_back(end);
+      segment_out_indices.push_back(out_index);
+      out_index = next_index;
+    }
+    OP_REQUIRES(context, FastBoundsCheck(out_index, output_rows),
+                SegmentIdOutOfRangeError(out_index, output_rows));
+    segment_out_indices.push_back(out_index);
+    const int64 num_segments = segment_starts.size();
+    segment_starts.push_back(num_indices);
+
 #if !defined(EIGEN_HAS_INDEX_LIST)
     Eigen::DSizes<Eigen::DenseIndex, 1> dims_to_reduce;
     dims_to_reduce[0] = 0;
 #else
     Eigen::IndexList<Eigen::type2index<0> > dims_to_reduce;
 #endif
-    Index start = 0, end = 1;
-
-    Index uninitialized_index = 0;  // Index from which the output is not set.
-    Index out_index = internal::SubtleMustCopy(segment_vec(start));
-
-    // TODO(agarwal): if this loop becomes a bottleneck, consider sharding it
-    // across threads.
     Eigen::DSizes<Eigen::DenseIndex, 1> out_slice_shape(num_col);
-    while (end <= num_indices) {
-      // We initialize next_index to 0 to avoid "warning: 'next_index' may be
-      // used uninitialized in this function" in the Mac build (since the
-      // compiler isn't smart enough to realize the code is safe).
-      Index next_index = 0;
-      if (end < num_indices) {
-        next_index = internal::SubtleMustCopy(segment_vec(end));
-        if (out_index == next_index) {
-          ++end;
-          continue;
+    // Every segment owns its output row and the gap before it, so segments
+    // are reduced independently, always in the same order.
+    auto reduce_segments = [&](int64 begin_segment, int64 end_segment) {
+      for (int64 k = begin_segment; k < end_segment; ++k) {
+        const int64 start = segment_starts[k];
+        const int64 end = segment_starts[k + 1];
+        const Index out_index = segment_out_indices[k];
+        // Index from which the output is not set.
+        const Index uninitialized_index =
+            k == 0 ? 0 : segment_out_indices[k - 1] + 1;
+
+        // If there is a gap between two indices, we need to set that gap to
+        // the default value.
+        if (out_index > uninitialized_index) {
+          Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
+              out_index - uninitialized_index, num_col);
+          Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>,
+                           Eigen::Unaligned>
+              gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
+          gap_slice.setConstant(T(default_value));
         }
-        // We have a new segment here.  Verify that the segment ids are growing.
-        OP_REQUIRES(context, out_index < next_index,
-                    errors::InvalidArgument("segment ids are not increasing"));
-      }
-
-      // Process segment [start, end)
-      const T* in_slice_ptr = &input_flat(start, 0);
-      typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
-                               Eigen::Unaligned>
-          OutT;
 
-      OP_REQUIRES(
-          context, FastBoundsCheck(out_index, output_rows),
-          errors::InvalidArgument(
-              "Segment id ", out_index, " out of range [0, ", output_rows,
-              "), possibly because 'segment_ids' input is not sorted."));
-
-      // If there is a gap between two indices, we need to set that gap to the
-      // default value.
-      if (out_index > uninitialized_index) {
-        Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
-            out_index - uninitialized_index, num_col);
-        Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>, Eigen::Unaligned>
-            gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
-        gap_slice.setConstant(T(default_value));
-      }
-
-      T* out_slice_ptr = &output_flat(out_index, 0);
-      OutT out_slice(out_slice_ptr, out_slice_shape);
-      // We don't use out_slice.device(context->eigen_device<Device>)
-      // because these pieces of work are likely to be very small and
-      // the context switching overhead dwarfs any benefit we get from
-      // using another thread to do this work.
-      if (start == end - 1) {
-        typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
-                                 Eigen::Unaligned>
-            InT;
-        InT in_slice(in_slice_ptr, out_slice_shape);
-        out_slice = in_slice;
-      } else {
-        Eigen::DSizes<Eigen::DenseIndex, 2> in_slice_shape(end - start,
-                                                           num_col);
-        typedef Eigen::TensorMap<Eigen::Tensor<const T, 2, Eigen::RowMajor>,
+        // Process segment [start, end)
+        const T* in_slice_ptr = &input_flat(start, 0);
+        typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
                                  Eigen::Unaligned>
-            InT;
-        InT in_slice(in_slice_ptr, in_slice_shape);
-
-        out_slice = in_slice.reduce(dims_to_reduce, Reducer());
+            OutT;
+        T* out_slice_ptr = &output_flat(out_index, 0);
+        OutT out_slice(out_slice_ptr, out_slice_shape);
+        // We don't use out_slice.device(context->eigen_device<Device>)
+        // because these pieces of work are likely to be very small and
+        // the context switching overhead dwarfs any benefit we get from
+        // using another thread to do this work.
+        if (start == end - 1) {
+          typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
+                                   Eigen::Unaligned>
+              InT;
+          InT in_slice(in_slice_ptr, out_slice_shape);
+          out_slice = in_slice;
+        } else {
+          Eigen::DSizes<Eigen::DenseIndex, 2> in_slice_shape(end - start,
+                                                             num_col);
+          typedef Eigen::TensorMap<Eigen::Tensor<const T, 2, Eigen::RowMajor>,
+                                   Eigen::Unaligned>
+              InT;
+          InT in_slice(in_slice_ptr, in_slice_shape);
+
+          out_slice = in_slice.reduce(dims_to_reduce, Reducer());
+        }
       }
-      if (end >= num_indices) break;
-      start = end;
-      ++end;
-      uninitialized_index = out_index + 1;
-      out_index = next_index;
-    }
+    };
+    // Segments (and gaps) are on average output_rows / num_segments rows of
+    // output and num_indices / num_segments rows of input.
+    const int64 cost_per_segment =
+        (num_indices + output_rows) / num_segments * num_col * sizeof(T);
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_segments,
+          cost_per_segment, reduce_segments);
   }
 };
 
@@ -377,19 +402,76 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
       return;
     }
     const int64 N = segment_ids.dimension(0);
+    const int64 row_size = data_size / N;
     ReductionF reduction;
-    auto data_flat = typename TTypes<T, 2>::ConstTensor(data, N, data_size / N);
+    auto data_flat = typename TTypes<T, 2>::ConstTensor(data, N, row_size);
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    if (worker_threads->num_threads <= 1 || N * row_size < kMinParallelSize) {
+      for (int64 i = 0; i < N; ++i) {
+        Index j = internal::SubtleMustCopy(segment_ids(i));
+        if (j < 0) {
+          continue;
+        }
+        OP_REQUIRES(ctx, FastBoundsCheck(j, num_segments),
+                    OutOfRangeError(segment_ids_shape, i, j, num_segments));
+        reduction(data_flat.template chip<0>(i), output.template chip<0>(j));
+      }
+      return;
+    }
+
+    // Group the rows by segment with a counting sort, then shard the output
+    // segments. Rows are still reduced in input order, so results match the
+    // serial loop above.
+    std::vector<Index> ids(N);
+    std::vector<int64> segment_starts(num_segments + 1, 0);
     for (int64 i = 0; i < N; ++i) {
-      Index j = internal::SubtleMustCopy(segment_ids(i));
+      const Index j = internal::SubtleMustCopy(segment_ids(i));
+      ids[i] = j;
       if (j < 0) {
         continue;
       }
       OP_REQUIRES(ctx, FastBoundsCheck(j, num_segments),
-                  errors::InvalidArgument(
-                      "segment_ids", SliceDebugString(segment_ids_shape, i),
-                      " = ", j, " is out of range [0, ", num_segments, ")"));
-      reduction(data_flat.template chip<0>(i), output.template chip<0>(j));
+                  OutOfRangeError(segment_ids_shape, i, j, num_segments));
+      ++segment_starts[j + 1];
+    }
+    for (Index j = 0; j < num_segments; ++j) {
+      segment_starts[j + 1] += segment_starts[j];
+    }
+    std::vector<int64> rows(segment_starts[num_segments]);
+    if (rows.empty()) {
+      return;
+    }
+    {
+      std::vector<int64> next(segment_starts.begin(), segment_starts.end() - 1);
+      for (int64 i = 0; i < N; ++i) {
+        if (ids[i] >= 0) {
+          rows[next[ids[i]]++] = i;
+        }
+      }
     }
+    auto reduce_segments = [&](int64 begin, int64 end) {
+      for (int64 j = begin; j < end; ++j) {
+        for (int64 k = segment_starts[j]; k < segment_starts[j + 1]; ++k) {
+          reduction(data_flat.template chip<0>(rows[k]),
+                    output.template chip<0>(j));
+        }
+      }
+    };
+    const int64 cost_per_segment =
+        (rows.size() / num_segments + 1) * row_size * sizeof(T);
+    Shard(worker_threads->num_threads, worker_threads->workers, num_segments,
+          cost_per_segment, reduce_segments);
+  }
+
+ private:
+  // Below this many elements of data the rows are not grouped by segment.
+  static const int64 kMinParallelSize = 1 << 15;
+
+  static Status OutOfRangeError(const TensorShape& segment_ids_shape, int64 i,
+                                Index j, Index num_segments) {
+    return errors::InvalidArgument(
+        "segment_ids", SliceDebugString(segment_ids_shape, i), " = ", j,
+        " is out of range [0, ", num_segments, ")");
   }
 };
 
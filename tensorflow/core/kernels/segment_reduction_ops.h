@@ -46,6 +46,13 @@ namespace tensorflow {
 
 class OpKernelContext;
 
+// Returns whether TF_DETERMINISTIC_SEGMENT_REDUCTIONS is set. The GPU kernels
+// of SegmentSum and UnsortedSegmentSum then sum every output element in a
+// fixed order instead of with atomic adds, which makes their results
+// reproducible and avoids contention on large segments. The CPU kernels are
+// always deterministic.
+bool DeterministicSegmentReductions();
+
 namespace functor {
 
 #ifdef GOOGLE_CUDA
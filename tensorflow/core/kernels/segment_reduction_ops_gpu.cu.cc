@@ -22,6 +22,9 @@ limitations under the License.
 #include "tensorflow/core/util/cuda_kernel_helper.h"
 
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
+#include <type_traits>
+#include "third_party/cub/device/device_radix_sort.cuh"
+#include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/util/cuda_device_functions.h"
 
@@ -125,6 +128,133 @@ __global__ void UnsortedSegmentCustomKernel(const Index input_outer_dim_size,
   }
 }
 
+namespace {
+
+// Sets offsets[s], for every s in [0, num_segments], to the number of
+// entries of the sorted_ids that are less than s, so the entries of segment
+// s are [offsets[s], offsets[s + 1]).
+template <typename Index>
+__global__ void SegmentOffsetsKernel(const int32 num_offsets,
+                                     const Index num_ids,
+                                     const Index* sorted_ids, Index* offsets) {
+  CUDA_1D_KERNEL_LOOP(s, num_offsets) {
+    Index lo = 0;
+    Index hi = num_ids;
+    while (lo < hi) {
+      const Index mid = lo + (hi - lo) / 2;
+      if (ldg(sorted_ids + mid) < s) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    offsets[s] = lo;
+  }
+}
+
+// Sums the rows of segment s into row s of output with one thread per
+// output element, always in the order of the entries. The entries of s are
+// [offsets[s], offsets[s + 1]) and entry j is row rows[j] of input, or row j
+// if rows is null.
+template <typename T, typename Index>
+__global__ void DeterministicSegmentSumKernel(const int32 output_size,
+                                              const Index inner_dim_size,
+                                              const Index* offsets,
+                                              const Index* rows,
+                                              const T* input, T* output) {
+  CUDA_1D_KERNEL_LOOP(i, output_size) {
+    const Index segment = i / inner_dim_size;
+    const Index segment_offset = i - segment * inner_dim_size;
+    const Index end = ldg(offsets + segment + 1);
+    T sum = T(0);
+    for (Index j = ldg(offsets + segment); j < end; ++j) {
+      const Index row = rows == nullptr ? j : ldg(rows + j);
+      sum += ldg(input + row * inner_dim_size + segment_offset);
+    }
+    output[i] = sum;
+  }
+}
+
+template <typename Index>
+__global__ void RangeInitKernel(const int32 size, Index* out) {
+  CUDA_1D_KERNEL_LOOP(i, size) { out[i] = i; }
+}
+
+// Computes the segment sum of the `num_ids` rows of `data` into `output`,
+// where row i belongs to segment sorted_ids[i], or to segment
+// sorted_ids[j] if rows[j] == i when rows is not null. sorted_ids must be
+// sorted; entries outside [0, output.dimension(0)) are dropped.
+template <typename T, typename Index>
+Status DeterministicSegmentSum(OpKernelContext* ctx, const GPUDevice& d,
+                               const Index num_ids, const Index* sorted_ids,
+                               const Index* rows, const T* data,
+                               typename TTypes<T, 2>::Tensor output) {
+  const Index num_segments = output.dimension(0);
+  Tensor offsets;
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(
+      DataTypeToEnum<Index>::value,
+      TensorShape({static_cast<int64>(num_segments) + 1}), &offsets));
+  Index* offsets_ptr = offsets.flat<Index>().data();
+  CudaLaunchConfig config = GetCudaLaunchConfig(num_segments + 1, d);
+  SegmentOffsetsKernel<Index>
+      <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+          num_segments + 1, num_ids, sorted_ids, offsets_ptr);
+  config = GetCudaLaunchConfig(output.size(), d);
+  DeterministicSegmentSumKernel<T, Index>
+      <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+          output.size(), output.dimension(1), offsets_ptr, rows, data,
+          output.data());
+  return Status::OK();
+}
+
+// Sorts the segment ids, together with their row numbers, so that
+// DeterministicSegmentSum can sum unsorted segments.
+template <typename T, typename Index>
+Status DeterministicUnsortedSegmentSum(
+    OpKernelContext* ctx, const GPUDevice& d,
+    typename TTypes<Index>::ConstFlat segment_ids, const T* data,
+    typename TTypes<T, 2>::Tensor output) {
+  const Index num_ids = segment_ids.dimension(0);
+  Tensor temps[3];
+  for (Tensor& temp : temps) {
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(DataTypeToEnum<Index>::value,
+                                          TensorShape({num_ids}), &temp));
+  }
+  Index* sorted_ids = temps[0].flat<Index>().data();
+  Index* rows = temps[1].flat<Index>().data();
+  Index* sorted_rows = temps[2].flat<Index>().data();
+  CudaLaunchConfig config = GetCudaLaunchConfig(num_ids, d);
+  RangeInitKernel<Index>
+      <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+          num_ids, rows);
+
+  // Radix sort is stable, so the rows of every segment stay in order.
+  size_t temp_storage_bytes = 0;
+  cudaError_t err = cub::DeviceRadixSort::SortPairs(
+      nullptr, temp_storage_bytes, segment_ids.data(), sorted_ids, rows,
+      sorted_rows, num_ids, 0, sizeof(Index) * 8, d.stream());
+  if (err == cudaSuccess) {
+    Tensor temp_storage;
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DT_INT8, TensorShape({static_cast<int64>(temp_storage_bytes)}),
+        &temp_storage));
+    err = cub::DeviceRadixSort::SortPairs(
+        temp_storage.flat<int8>().data(), temp_storage_bytes,
+        segment_ids.data(), sorted_ids, rows, sorted_rows, num_ids, 0,
+        sizeof(Index) * 8, d.stream());
+  }
+  if (err != cudaSuccess) {
+    return errors::Internal(
+        "UnsortedSegmentSum: could not launch cub::DeviceRadixSort::SortPairs, "
+        "status: ",
+        cudaGetErrorString(err));
+  }
+  return DeterministicSegmentSum<T, Index>(ctx, d, num_ids, sorted_ids,
+                                           sorted_rows, data, output);
+}
+
+}  // namespace
+
 namespace functor {
 
 template <typename T, typename Index>
@@ -153,6 +283,13 @@ void SegmentSumFunctor<T, Index>::operator()(
   const Index input_outer_dim_size = segment_ids.dimension(0);
   const Index input_inner_dim_size = input_total_size / input_outer_dim_size;
 
+  if (DeterministicSegmentReductions()) {
+    OP_REQUIRES_OK(ctx, (DeterministicSegmentSum<T, Index>(
+                            ctx, d, input_outer_dim_size, segment_ids.data(),
+                            /*rows=*/nullptr, data, output)));
+    return;
+  }
+
   const int OuterDimTileSize = 8;
 
   const Index input_outer_dim_num_stripe =
@@ -187,6 +324,14 @@ struct UnsortedSegmentFunctor<GPUDevice, T, Index, InitialValueF, ReductionF> {
     if (data_size == 0 || segment_ids_shape.num_elements() == 0) {
       return;
     }
+    // Only sums have an atomics-free kernel so far. Max and min don't depend
+    // on the order of the atomic updates anyway.
+    if (std::is_same<ReductionF, SumOpGpu<T>>::value &&
+        DeterministicSegmentReductions()) {
+      OP_REQUIRES_OK(ctx, (DeterministicUnsortedSegmentSum<T, Index>(
+                              ctx, d, segment_ids, data, output)));
+      return;
+    }
     // Launch kernel to compute unsorted segment reduction.
     // Notes:
     // *) 'data_size' is the total number of elements to process.
@@ -15,10 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sendrecv_ops.h"
 
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
@@ -140,18 +142,25 @@ RecvOp::RecvOp(OpKernelConstruction* ctx) : AsyncOpKernel(ctx) {
   if (!ctx->GetAttr("_hostmem_sendrecv", &hostmem_sendrecv_).ok()) {
     hostmem_sendrecv_ = false;
   }
+  if (!ctx->GetAttr("_transfer_priority", &priority_).ok()) {
+    priority_ = -1;
+  }
 }
 
 namespace {
 Rendezvous::DoneCallback make_recv_callback(OpKernelContext* ctx,
                                             AsyncOpKernel::DoneCallback done) {
   using namespace std::placeholders;
+  const uint64 start_time_usecs = Env::Default()->NowMicros();
   return std::bind(
-      [ctx](AsyncOpKernel::DoneCallback done,
-            // Begin unbound arguments.
-            const Status& s, const Rendezvous::Args& send_args,
-            const Rendezvous::Args& recv_args, const Tensor& val,
-            bool is_dead) {
+      [ctx, start_time_usecs](AsyncOpKernel::DoneCallback done,
+                              // Begin unbound arguments.
+                              const Status& s,
+                              const Rendezvous::Args& send_args,
+                              const Rendezvous::Args& recv_args,
+                              const Tensor& val, bool is_dead) {
+        metrics::UpdateRendezvousWaitTime(Env::Default()->NowMicros() -
+                                          start_time_usecs);
         ctx->SetStatus(s);
         if (s.ok()) {
           // 'ctx' allocates the output tensor of the expected type.
@@ -176,6 +185,7 @@ void RecvOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
   Rendezvous::Args args;
   args.device_context = ctx->op_device_context();
   args.alloc_attrs = ctx->output_alloc_attr(0);
+  args.priority = priority_;
 
   FrameAndIter frame_iter = GetFrameAndIter(ctx, hostmem_sendrecv_);
   if (frame_iter == FrameAndIter(0, 0)) {
@@ -0,0 +1,254 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/array_ops.cc and ../ops/resource_variable_ops.cc.
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/resource_var.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/type_traits.h"
+#include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+// Gathers rows of a table that is split along dimension 0 into shards, the
+// way embedding_lookup partitions ids, without partitioning the ids and
+// stitching the results: every row is copied straight from its shard to its
+// position in the output.
+template <typename T, typename Index>
+class ShardedGatherOpBase : public OpKernel {
+ public:
+  explicit ShardedGatherOpBase(OpKernelConstruction* c) : OpKernel(c) {
+    string partition_strategy;
+    OP_REQUIRES_OK(c, c->GetAttr("partition_strategy", &partition_strategy));
+    div_ = partition_strategy == "div";
+  }
+
+ protected:
+  // Gathers the rows of `shards` listed in the last input into output 0.
+  void Gather(OpKernelContext* c, const std::vector<const Tensor*>& shards) {
+    const int num_shards = shards.size();
+    const Tensor& indices = c->input(num_shards);
+    const Tensor& first = *shards[0];
+    OP_REQUIRES(
+        c, TensorShapeUtils::IsVectorOrHigher(first.shape()),
+        errors::InvalidArgument("params[0] must be at least 1 dimensional"));
+    TensorShape slice_shape = first.shape();
+    slice_shape.RemoveDim(0);
+
+    std::vector<const T*> shard_data(num_shards);
+    std::vector<int64> shard_rows(num_shards);
+    int64 total_rows = 0;
+    for (int i = 0; i < num_shards; ++i) {
+      const Tensor& shard = *shards[i];
+      bool same_slice_shape = shard.dims() == first.dims();
+      for (int d = 1; same_slice_shape && d < first.dims(); ++d) {
+        same_slice_shape = shard.dim_size(d) == first.dim_size(d);
+      }
+      OP_REQUIRES(c, same_slice_shape,
+                  errors::InvalidArgument(
+                      "params[", i, "] has shape ", shard.shape().DebugString(),
+                      ", which does not match the shape ",
+                      first.shape().DebugString(), " of params[0] past ",
+                      "dimension 0"));
+      shard_data[i] = shard.flat<T>().data();
+      shard_rows[i] = shard.dim_size(0);
+      total_rows += shard_rows[i];
+    }
+    OP_REQUIRES(
+        c, total_rows <= std::numeric_limits<Index>::max(),
+        errors::InvalidArgument("params have too many rows for ",
+                                DataTypeString(DataTypeToEnum<Index>::v()),
+                                " indexing: ", total_rows, " > ",
+                                std::numeric_limits<Index>::max()));
+
+    // The result shape is indices.shape + params.shape[1:].
+    TensorShape result_shape = indices.shape();
+    result_shape.AppendShape(slice_shape);
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(c, c->allocate_output(0, result_shape, &out));
+    const int64 N = indices.NumElements();
+    if (N == 0) {
+      return;
+    }
+
+    const int64 slice_elems = slice_shape.num_elements();
+    const int64 rows_per_shard = total_rows / num_shards;
+    const int64 extras = total_rows % num_shards;
+    // With "div" the first `extras` shards hold one more row than the rest.
+    const int64 extras_boundary = extras * (rows_per_shard + 1);
+    const bool div = div_;
+    auto indices_flat = indices.flat<Index>();
+    T* out_base = out->flat<T>().data();
+
+    mutex mu;
+    int64 bad_i = -1;
+    auto work = [&](int64 start, int64 end) {
+      for (int64 i = start; i < end; ++i) {
+        const int64 id = internal::SubtleMustCopy(indices_flat(i));
+        if (!FastBoundsCheck(id, total_rows)) {
+          mutex_lock l(mu);
+          bad_i = i;
+          return;
+        }
+        int64 shard;
+        int64 row;
+        if (!div) {
+          shard = id % num_shards;
+          row = id / num_shards;
+        } else if (id < extras_boundary) {
+          shard = id / (rows_per_shard + 1);
+          row = id % (rows_per_shard + 1);
+        } else {
+          shard = extras + (id - extras_boundary) / rows_per_shard;
+          row = (id - extras_boundary) % rows_per_shard;
+        }
+        // Shards that are not sized like the strategy expects can leave
+        // the row outside its shard.
+        if (!FastBoundsCheck(row, shard_rows[shard])) {
+          mutex_lock l(mu);
+          bad_i = i;
+          return;
+        }
+        const T* src = shard_data[shard] + row * slice_elems;
+        T* dst = out_base + i * slice_elems;
+        if (is_simple_type<T>::value) {
+          memcpy(dst, src, slice_elems * sizeof(T));
+        } else {
+          std::copy(src, src + slice_elems, dst);
+        }
+      }
+    };
+    auto* worker_threads = c->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, N,
+          slice_elems * sizeof(T), work);
+
+    OP_REQUIRES(c, bad_i < 0,
+                errors::InvalidArgument(
+                    "indices", SliceDebugString(indices.shape(), bad_i), " = ",
+                    indices_flat(bad_i), " is not a row of the ", num_shards,
+                    " params with ", total_rows, " rows partitioned by '",
+                    div ? "div" : "mod", "'"));
+  }
+
+ private:
+  bool div_;
+};
+
+template <typename T, typename Index>
+class ShardedGatherOp : public ShardedGatherOpBase<T, Index> {
+ public:
+  explicit ShardedGatherOp(OpKernelConstruction* c)
+      : ShardedGatherOpBase<T, Index>(c) {}
+
+  void Compute(OpKernelContext* c) override {
+    OpInputList params;
+    OP_REQUIRES_OK(c, c->input_list("params", &params));
+    std::vector<const Tensor*> shards;
+    shards.reserve(params.size());
+    for (const Tensor& shard : params) {
+      shards.push_back(&shard);
+    }
+    this->Gather(c, shards);
+  }
+};
+
+template <typename T, typename Index>
+class ResourceShardedGatherOp : public ShardedGatherOpBase<T, Index> {
+ public:
+  explicit ResourceShardedGatherOp(OpKernelConstruction* c)
+      : ShardedGatherOpBase<T, Index>(c) {}
+
+  void Compute(OpKernelContext* c) override {
+    const int num_shards = c->num_inputs() - 1;
+    std::vector<Var*> vars;
+    vars.reserve(num_shards);
+    auto unref_vars = gtl::MakeCleanup([&vars] {
+      for (Var* v : vars) {
+        v->Unref();
+      }
+    });
+    for (int i = 0; i < num_shards; ++i) {
+      Var* v = nullptr;
+      OP_REQUIRES_OK(c, LookupResource(c, HandleFromInput(c, i), &v));
+      vars.push_back(v);
+      OP_REQUIRES(
+          c, v->tensor()->dtype() == DataTypeToEnum<T>::value,
+          errors::InvalidArgument(
+              "Trying to gather from variable ", i, " with wrong dtype. ",
+              "Expected ", DataTypeString(DataTypeToEnum<T>::value), " got ",
+              DataTypeString(v->tensor()->dtype())));
+    }
+
+    // As in ResourceGather, hold the locks for the whole gather instead of
+    // referencing the tensors, so concurrent writes don't copy the shards.
+    // The locks are taken in address order, like
+    // MaybeLockVariableInputMutexesInOrder, to avoid deadlocks.
+    std::vector<mutex*> mutexes;
+    mutexes.reserve(num_shards);
+    for (Var* v : vars) {
+      mutexes.push_back(v->mu());
+    }
+    std::sort(mutexes.begin(), mutexes.end());
+    mutexes.erase(std::unique(mutexes.begin(), mutexes.end()), mutexes.end());
+    std::vector<tf_shared_lock> locks;
+    locks.reserve(mutexes.size());
+    for (mutex* mu : mutexes) {
+      locks.emplace_back(*mu);
+    }
+
+    std::vector<const Tensor*> shards;
+    shards.reserve(num_shards);
+    for (Var* v : vars) {
+      shards.push_back(v->tensor());
+    }
+    this->Gather(c, shards);
+  }
+};
+
+#define REGISTER_SHARDED_GATHER_FULL(type, index_type)                 \
+  REGISTER_KERNEL_BUILDER(Name("ShardedGather")                        \
+                              .Device(DEVICE_CPU)                      \
+                              .TypeConstraint<type>("Tparams")         \
+                              .TypeConstraint<index_type>("Tindices"), \
+                          ShardedGatherOp<type, index_type>);          \
+  REGISTER_KERNEL_BUILDER(Name("ResourceShardedGather")                \
+                              .Device(DEVICE_CPU)                      \
+                              .TypeConstraint<type>("dtype")           \
+                              .TypeConstraint<index_type>("Tindices"), \
+                          ResourceShardedGatherOp<type, index_type>)
+
+#define REGISTER_SHARDED_GATHER(type)          \
+  REGISTER_SHARDED_GATHER_FULL(type, int32); \
+  REGISTER_SHARDED_GATHER_FULL(type, int64)
+
+TF_CALL_ALL_TYPES(REGISTER_SHARDED_GATHER);
+TF_CALL_QUANTIZED_TYPES(REGISTER_SHARDED_GATHER);
+
+#undef REGISTER_SHARDED_GATHER
+#undef REGISTER_SHARDED_GATHER_FULL
+
+}  // namespace tensorflow
@@ -0,0 +1,121 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class ShardedGatherOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(int num_shards, const string& partition_strategy) {
+    TF_ASSERT_OK(NodeDefBuilder("myop", "ShardedGather")
+                     .Input(FakeInput(num_shards, DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("partition_strategy", partition_strategy)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(ShardedGatherOpTest, Mod) {
+  MakeOp(3, "mod");
+
+  // Rows 0, 3, 6 | 1, 4 | 2, 5 of a [7, 2] table.
+  AddInputFromArray<float>(TensorShape({3, 2}), {0, 0, 3, 3, 6, 6});
+  AddInputFromArray<float>(TensorShape({2, 2}), {1, 1, 4, 4});
+  AddInputFromArray<float>(TensorShape({2, 2}), {2, 2, 5, 5});
+  AddInputFromArray<int32>(TensorShape({2, 2}), {6, 1, 5, 1});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 2, 2}));
+  test::FillValues<float>(&expected, {6, 6, 1, 1, 5, 5, 1, 1});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(ShardedGatherOpTest, Div) {
+  MakeOp(3, "div");
+
+  // Rows 0, 1, 2 | 3, 4 | 5, 6 of a [7] table.
+  AddInputFromArray<float>(TensorShape({3}), {0, 1, 2});
+  AddInputFromArray<float>(TensorShape({2}), {3, 4});
+  AddInputFromArray<float>(TensorShape({2}), {5, 6});
+  AddInputFromArray<int32>(TensorShape({7}), {6, 2, 3, 0, 5, 4, 1});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({7}));
+  test::FillValues<float>(&expected, {6, 2, 3, 0, 5, 4, 1});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(ShardedGatherOpTest, EmptyIndices) {
+  MakeOp(2, "mod");
+
+  AddInputFromArray<float>(TensorShape({1, 3}), {0, 0, 0});
+  AddInputFromArray<float>(TensorShape({1, 3}), {1, 1, 1});
+  AddInputFromArray<int32>(TensorShape({0}), {});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({0, 3}));
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(ShardedGatherOpTest, OutOfRange) {
+  MakeOp(2, "mod");
+
+  AddInputFromArray<float>(TensorShape({2}), {0, 2});
+  AddInputFromArray<float>(TensorShape({1}), {1});
+  AddInputFromArray<int32>(TensorShape({2}), {0, 3});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(str_util::StrContains(s.ToString(), "indices[1] = 3 is not"))
+      << s;
+}
+
+TEST_F(ShardedGatherOpTest, NotInShard) {
+  // With "mod", id 4 belongs to row 2 of the first shard, which only has 2.
+  MakeOp(2, "mod");
+
+  AddInputFromArray<float>(TensorShape({2}), {0, 2});
+  AddInputFromArray<float>(TensorShape({3}), {1, 3, 5});
+  AddInputFromArray<int32>(TensorShape({1}), {4});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(str_util::StrContains(s.ToString(), "indices[0] = 4 is not"))
+      << s;
+}
+
+TEST_F(ShardedGatherOpTest, MismatchedShardShapes) {
+  MakeOp(2, "mod");
+
+  AddInputFromArray<float>(TensorShape({1, 2}), {0, 0});
+  AddInputFromArray<float>(TensorShape({1, 3}), {1, 1, 1});
+  AddInputFromArray<int32>(TensorShape({1}), {0});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(
+      str_util::StrContains(s.ToString(), "params[1] has shape [1,3]"))
+      << s;
+}
+
+}  // namespace
+}  // namespace tensorflow
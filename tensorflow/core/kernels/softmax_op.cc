@@ -18,6 +18,12 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -46,6 +52,125 @@ struct SoftmaxFunctorBase {
 template <typename T>
 struct SoftmaxFunctor<CPUDevice, T> : SoftmaxFunctorBase<CPUDevice, T> {};
 
+// Computes Softmax or LogSoftmax a row at a time, for the types whose
+// exponential Eigen vectorizes. The maximum of a row and the sum of the
+// exponentials are computed in a single read of the row by the online
+// normalizer: each block of 'kBlockSize' values gets its own maximum and sum,
+// and the sums are rescaled to the larger maximum as the blocks are merged.
+// Softmax writes the exponentials of each block as it goes, and then scales
+// them, while the row is still in the cache. The Eigen expressions instead
+// make four passes over all of the logits.
+template <typename T>
+struct SoftmaxOnlineImpl {
+  typedef Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>> ConstRow;
+  typedef Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>> Row;
+
+  static constexpr int64 kBlockSize = 128;
+
+  // Merges the maximum 'block_max' and the sum 'block_sum' of the
+  // exponentials of a block into '*max' and '*sum'. Equal maxima (including
+  // -inf) are not rescaled, which would compute exp(inf - inf).
+  static void Merge(T block_max, T block_sum, T* max, T* sum) {
+    const T new_max = std::max(*max, block_max);
+    if (*max != new_max) *sum *= std::exp(*max - new_max);
+    if (block_max != new_max) block_sum *= std::exp(block_max - new_max);
+    *sum += block_sum;
+    *max = new_max;
+  }
+
+  static int64 NumBlocks(int64 num_classes) {
+    return (num_classes + kBlockSize - 1) / kBlockSize;
+  }
+
+  // Computes a row of 'num_classes' values. 'block_maxima' is a buffer of
+  // NumBlocks(num_classes) values. 'softmax' may be 'logits'.
+  static void ComputeRow(const T* logits, int64 num_classes, bool log,
+                         T* block_maxima, T* softmax) {
+    const T kMinusInf = -std::numeric_limits<T>::infinity();
+    T max = kMinusInf;
+    T sum = 0;
+    for (int64 b = 0; b < NumBlocks(num_classes); ++b) {
+      const int64 begin = b * kBlockSize;
+      const int64 size = std::min(kBlockSize, num_classes - begin);
+      ConstRow block(logits + begin, size);
+      const T block_max = block.maxCoeff();
+      T block_sum = 0;
+      if (log) {
+        // A block of -inf has no exponential to add.
+        if (block_max != kMinusInf) {
+          block_sum = (block - block_max).exp().sum();
+        }
+      } else {
+        Row exp_block(softmax + begin, size);
+        if (block_max != kMinusInf) {
+          exp_block = (block - block_max).exp();
+          block_sum = exp_block.sum();
+        } else {
+          exp_block.setZero();
+        }
+      }
+      block_maxima[b] = block_max;
+      Merge(block_max, block_sum, &max, &sum);
+    }
+    if (log) {
+      ConstRow x(logits, num_classes);
+      Row y(softmax, num_classes);
+      y = x - (max + std::log(sum));
+      return;
+    }
+    const T inverse_sum = T(1) / sum;
+    for (int64 b = 0; b < NumBlocks(num_classes); ++b) {
+      const int64 begin = b * kBlockSize;
+      Row exp_block(softmax + begin, std::min(kBlockSize, num_classes - begin));
+      exp_block *= block_maxima[b] == max
+                       ? inverse_sum
+                       : std::exp(block_maxima[b] - max) * inverse_sum;
+    }
+  }
+
+  static void Compute(const CPUDevice& d,
+                      typename TTypes<T>::ConstMatrix logits,
+                      typename TTypes<T>::Matrix softmax, const bool log) {
+    const int64 batch_size = logits.dimension(0);
+    const int64 num_classes = logits.dimension(1);
+    const T* logits_data = logits.data();
+    T* softmax_data = softmax.data();
+    auto compute_rows = [=](int64 begin, int64 end) {
+      std::vector<T> block_maxima(NumBlocks(num_classes));
+      for (int64 row = begin; row < end; ++row) {
+        ComputeRow(logits_data + row * num_classes, num_classes, log,
+                   block_maxima.data(), softmax_data + row * num_classes);
+      }
+    };
+    const double exp_cost =
+        Eigen::internal::functor_traits<
+            Eigen::internal::scalar_exp_op<T>>::Cost;
+    const Eigen::TensorOpCost row_cost(num_classes * sizeof(T),
+                                       num_classes * sizeof(T),
+                                       num_classes * (exp_cost + 4));
+    d.parallelFor(batch_size, row_cost, compute_rows);
+  }
+};
+
+template <typename T>
+constexpr int64 SoftmaxOnlineImpl<T>::kBlockSize;
+
+template <>
+struct SoftmaxFunctor<CPUDevice, float> {
+  void operator()(const CPUDevice& d, TTypes<float>::ConstMatrix logits,
+                  TTypes<float>::Matrix softmax, const bool log) {
+    SoftmaxOnlineImpl<float>::Compute(d, logits, softmax, log);
+  }
+};
+
+template <>
+struct SoftmaxFunctor<CPUDevice, double> {
+  void operator()(const CPUDevice& d, TTypes<double>::ConstMatrix logits,
+                  TTypes<double>::Matrix softmax, const bool log) {
+    SoftmaxOnlineImpl<double>::Compute(d, logits, softmax, log);
+  }
+};
+
 #ifdef TENSORFLOW_USE_SYCL
 template <typename T>
 struct SoftmaxFunctor<SYCLDevice, T> : SoftmaxFunctorBase<SYCLDevice, T> {};
@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+
 #include "tensorflow/core/lib/strings/str_util.h"
 #if GOOGLE_CUDA
 
@@ -123,6 +125,94 @@ void DoRowReduction(OpKernelContext* context, T* output, InputIter input,
   functor::ReduceImpl<T, Op, T*, InputIter, ReductionAxes>(
       context, output, input, 2, rows, cols, 1, 1, constants.kOne, op);
 }
+
+// Rows of at most this many columns are computed by OnlineSoftmaxKernel.
+// Longer rows are reduced by cub, which splits a row across blocks.
+constexpr int kMaxOnlineSoftmaxCols = 8192;
+constexpr int kMaxOnlineSoftmaxThreads = 256;
+constexpr int kWarpSize = 32;
+
+// Merges the maximum 'other_max' and the sum of exponentials 'other_sum'
+// relative to it into '*max' and '*sum', rescaling the sum of the smaller
+// maximum. A sum relative to a maximum of -inf is rescaled to 0.
+template <typename U>
+__device__ EIGEN_STRONG_INLINE void MergeMaxAndSum(U other_max, U other_sum,
+                                                   U* max, U* sum) {
+  if (other_max > *max) {
+    *sum = *sum * exp(*max - other_max) + other_sum;
+    *max = other_max;
+  } else if (other_max < *max) {
+    *sum += other_sum * exp(other_max - *max);
+  } else {
+    *sum += other_sum;
+  }
+}
+
+// Computes a row of Softmax or LogSoftmax per block. The threads of the block
+// compute the maximum of the row and the sum of the exponentials in a single
+// read of the row, with the online normalizer, and reduce them with warp
+// shuffles. The row is then read again, from the cache, to write the output.
+template <typename T, typename U>
+__global__ void OnlineSoftmaxKernel(const T* logits, T* output,
+                                    const int num_cols,
+                                    const bool in_log_space) {
+  __shared__ U shared_max[kMaxOnlineSoftmaxThreads / kWarpSize];
+  __shared__ U shared_sum[kMaxOnlineSoftmaxThreads / kWarpSize];
+  const T* row_logits = logits + static_cast<int64>(blockIdx.x) * num_cols;
+  T* row_output = output + static_cast<int64>(blockIdx.x) * num_cols;
+
+  U max = -Eigen::NumTraits<U>::infinity();
+  U sum = 0;
+  for (int col = threadIdx.x; col < num_cols; col += blockDim.x) {
+    MergeMaxAndSum(strict_cast<U>(row_logits[col]), U(1), &max, &sum);
+  }
+  for (int lane_mask = kWarpSize / 2; lane_mask > 0; lane_mask /= 2) {
+    const U other_max = CudaShuffleXorSync(kCudaWarpAll, max, lane_mask);
+    const U other_sum = CudaShuffleXorSync(kCudaWarpAll, sum, lane_mask);
+    MergeMaxAndSum(other_max, other_sum, &max, &sum);
+  }
+  const int warp = threadIdx.x / kWarpSize;
+  const int lane = threadIdx.x % kWarpSize;
+  const int num_warps = blockDim.x / kWarpSize;
+  if (num_warps > 1) {
+    if (lane == 0) {
+      shared_max[warp] = max;
+      shared_sum[warp] = sum;
+    }
+    __syncthreads();
+    if (warp == 0) {
+      max = lane < num_warps ? shared_max[lane]
+                             : -Eigen::NumTraits<U>::infinity();
+      sum = lane < num_warps ? shared_sum[lane] : U(0);
+      for (int lane_mask = kWarpSize / 2; lane_mask > 0; lane_mask /= 2) {
+        const U other_max = CudaShuffleXorSync(kCudaWarpAll, max, lane_mask);
+        const U other_sum = CudaShuffleXorSync(kCudaWarpAll, sum, lane_mask);
+        MergeMaxAndSum(other_max, other_sum, &max, &sum);
+      }
+      if (lane == 0) {
+        shared_max[0] = max;
+        shared_sum[0] = sum;
+      }
+    }
+    __syncthreads();
+    max = shared_max[0];
+    sum = shared_sum[0];
+  }
+
+  if (in_log_space) {
+    const U offset = max + log(sum);
+    for (int col = threadIdx.x; col < num_cols; col += blockDim.x) {
+      row_output[col] =
+          strict_cast<T>(strict_cast<U>(row_logits[col]) - offset);
+    }
+  } else {
+    const U inverse_sum = U(1) / sum;
+    for (int col = threadIdx.x; col < num_cols; col += blockDim.x) {
+      row_output[col] = strict_cast<T>(
+          exp(strict_cast<U>(row_logits[col]) - max) * inverse_sum);
+    }
+  }
+}
 }  // namespace
 
 template <typename T>
@@ -145,14 +235,21 @@ class SoftmaxOpGPU : public OpKernel {
                                 {0}, 0, logits_in_.shape(), &softmax_out));
 
     const cudaStream_t& cu_stream = GetCudaStream(context);
-    if (logits_in_.NumElements() > 0) {
+    typedef typename softmax_traits<T>::accumulator_type acc_type;
+    if (logits_in_.NumElements() > 0 && cols <= kMaxOnlineSoftmaxCols) {
+      const int num_threads = std::min(
+          kMaxOnlineSoftmaxThreads,
+          static_cast<int>(Eigen::divup(cols, kWarpSize)) * kWarpSize);
+      OnlineSoftmaxKernel<T, acc_type><<<rows, num_threads, 0, cu_stream>>>(
+          reinterpret_cast<const T*>(logits_in_.flat<T>().data()),
+          const_cast<T*>(softmax_out->flat<T>().data()), cols, log_);
+    } else if (logits_in_.NumElements() > 0) {
       Tensor max_logits;
       Tensor sum_probs;
       OP_REQUIRES_OK(context,
                      context->allocate_temp(DataTypeToEnum<T>::value,
                                             softmax_out->shape(), &max_logits));
 
-      typedef typename softmax_traits<T>::accumulator_type acc_type;
       OP_REQUIRES_OK(context,
                      context->allocate_temp(DataTypeToEnum<acc_type>::value,
                                             softmax_out->shape(), &sum_probs));
@@ -15,6 +15,7 @@ limitations under the License.
 
 // Contains OP to generate sparse crosses.
 #include <assert.h>
+#include <string.h>
 #include <limits>
 #include <string>
 #include <vector>
@@ -27,7 +28,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
-#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/util/work_sharder.h"
 
@@ -142,25 +143,24 @@ class OutputUpdater {
   OutputUpdater(const std::vector<int64>& output_start_indices,
                 Tensor* indices_out, Tensor* values_out)
       : output_start_indices_(output_start_indices),
-        indices_out_(indices_out),
-        values_out_(values_out) {}
+        indices_matrix_(indices_out->matrix<int64>()),
+        values_vec_(values_out->vec<OutType>()) {}
 
-  void Update(const int64 batch_index, const int64 cross_count,
-              const OutType& cross) const {
+  // Sets the indices of a cross and returns where to write its value, so
+  // that crossers build values in place.
+  OutType* Update(const int64 batch_index, const int64 cross_count) const {
     const int64 output_index = output_start_indices_[batch_index] + cross_count;
 
-    auto indices_matrix = indices_out_->matrix<int64>();
-    indices_matrix(output_index, 0) = batch_index;
-    indices_matrix(output_index, 1) = cross_count;
+    indices_matrix_(output_index, 0) = batch_index;
+    indices_matrix_(output_index, 1) = cross_count;
 
-    auto value_vec = values_out_->vec<OutType>();
-    value_vec(output_index) = cross;
+    return &values_vec_(output_index);
   }
 
  private:
   const std::vector<int64>& output_start_indices_;
-  Tensor* indices_out_;
-  Tensor* values_out_;
+  typename TTypes<int64>::Matrix indices_matrix_;
+  typename TTypes<OutType>::Vec values_vec_;
 };
 
 // Generates the sparse crosses as concatenation of strings.
@@ -172,17 +172,28 @@ class StringCrosser {
                 const int64 num_buckets_unused, const uint64 hash_key_unused)
       : columns_(columns) {}
 
-  string Generate(const int64 batch_index,
-                  const std::vector<int>& permutation) const {
-    static const auto k_feature_separator = "_X_";
+  void Generate(const int64 batch_index, const std::vector<int>& permutation,
+                string* cross) const {
+    static const char k_feature_separator[] = "_X_";
+    static const size_t k_separator_size = sizeof(k_feature_separator) - 1;
 
     gtl::InlinedVector<InternalType, 6> cross_vec(columns_.size());
+    size_t cross_size = 0;
     for (int i = 0; i < permutation.size(); i++) {
       cross_vec[i] = columns_[i]->Feature(batch_index, permutation[i]);
+      cross_size += cross_vec[i].size() + (i > 0 ? k_separator_size : 0);
+    }
+    // Joins the features directly into the output value.
+    cross->resize(cross_size);
+    char* out = &(*cross)[0];
+    for (int i = 0; i < cross_vec.size(); i++) {
+      if (i > 0) {
+        memcpy(out, k_feature_separator, k_separator_size);
+        out += k_separator_size;
+      }
+      memcpy(out, cross_vec[i].data(), cross_vec[i].size());
+      out += cross_vec[i].size();
     }
-    // TODO(zakaria): this will copy the string twice, might effect
-    // performance.
-    return str_util::Join(cross_vec, k_feature_separator);
   }
 
  private:
@@ -197,8 +208,8 @@ class HashCrosser {
       const int64 num_buckets, const uint64 hash_key)
       : columns_(columns), num_buckets_(num_buckets), hash_key_(hash_key) {}
 
-  int64 Generate(const int64 batch_index,
-                 const std::vector<int>& permutation) const {
+  void Generate(const int64 batch_index, const std::vector<int>& permutation,
+                int64* cross) const {
     // Do the fingerprint concatenation on uint64.
     uint64 hashed_output = hash_key_;
     for (size_t i = 0; i < permutation.size(); ++i) {
@@ -207,10 +218,10 @@ class HashCrosser {
     }
     // The return value is int64 based on the number of buckets.
     if (num_buckets_ > 0) {
-      return hashed_output % num_buckets_;
+      *cross = hashed_output % num_buckets_;
     } else {
       // To prevent negative output we take modulo to max int64.
-      return hashed_output % std::numeric_limits<int64>::max();
+      *cross = hashed_output % std::numeric_limits<int64>::max();
     }
   }
 
@@ -240,8 +251,9 @@ class ProductIterator {
     }
   }
 
-  std::vector<int> Next() {
-    std::vector<int> permutation(next_permutation_);
+  // Copies the next permutation into `permutation`, reusing its storage.
+  void Next(std::vector<int>* permutation) {
+    *permutation = next_permutation_;
 
     // Generates next permutation, if available.
     bool carry = true;
@@ -257,7 +269,6 @@ class ProductIterator {
       }
     }
     has_next_ = !carry;
-    return permutation;
   }
 
   bool HasNext() { return has_next_; }
@@ -311,29 +322,49 @@ class SparseCrossOp : public OpKernel {
     ValidateInput(context, indices_list_in, values_list_in, shapes_list_in,
                   dense_list_in);
 
+    // Hashed crosses use the fingerprint of a string feature once per cross
+    // it takes part in, so each string is fingerprinted once, up front.
+    std::vector<Tensor> values_in(values_list_in.begin(),
+                                  values_list_in.end());
+    std::vector<Tensor> dense_in(dense_list_in.begin(), dense_list_in.end());
+    if (HASHED_OUTPUT) {
+      for (std::vector<Tensor>* inputs : {&values_in, &dense_in}) {
+        for (Tensor& input : *inputs) {
+          if (input.dtype() != DT_STRING) continue;
+          Tensor fingerprints;
+          OP_REQUIRES_OK(context, context->allocate_temp(
+                                      DT_INT64, input.shape(), &fingerprints));
+          FingerprintStrings(context, input, &fingerprints);
+          input = fingerprints;
+        }
+      }
+    }
+
+    const int64 batch_size = CalculateBatchSize(shapes_list_in, dense_list_in);
     std::vector<std::unique_ptr<ColumnInterface<InternalType>>> columns =
-        GenerateColumnsFromInput(indices_list_in, values_list_in,
-                                 shapes_list_in, dense_list_in);
+        GenerateColumnsFromInput(indices_list_in, values_in, shapes_list_in,
+                                 dense_in, batch_size);
 
     typename CrossTraits<HASHED_OUTPUT, InternalType>::Crosser crosser(
         columns, num_buckets_, hash_key_);
     Tensor* indices_out;
     Tensor* values_out;
     Tensor* shape_out;
-    const int64 batch_size = CalculateBatchSize(shapes_list_in, dense_list_in);
     std::vector<int64> output_start_indices(batch_size);
     CreateOutputTensors(columns, batch_size, context, &indices_out, &values_out,
                         &shape_out, &output_start_indices);
+    if (!context->status().ok()) return;
 
     typename CrossTraits<HASHED_OUTPUT, InternalType>::Updater updater(
         output_start_indices, indices_out, values_out);
     auto do_work = [&columns, crosser, updater](int64 begin, int64 end) {
+      std::vector<int> permutation;
       for (int b = begin; b < end; b++) {
         ProductIterator<InternalType> product_iterator(columns, b);
         int64 cross_count = 0;
         while (product_iterator.HasNext()) {
-          const auto permutation = product_iterator.Next();
-          updater.Update(b, cross_count, crosser.Generate(b, permutation));
+          product_iterator.Next(&permutation);
+          crosser.Generate(b, permutation, updater.Update(b, cross_count));
           cross_count++;
         }
       }
@@ -347,6 +378,23 @@ class SparseCrossOp : public OpKernel {
   }
 
  private:
+  // Sets each element of the int64 tensor `fingerprints` to the Fingerprint64
+  // of the corresponding string of `strings`, in parallel.
+  void FingerprintStrings(OpKernelContext* context, const Tensor& strings,
+                          Tensor* fingerprints) {
+    const string* input = strings.flat<string>().data();
+    int64* output = fingerprints->flat<int64>().data();
+    auto fingerprint = [input, output](int64 begin, int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        output[i] = Fingerprint64(input[i]);
+      }
+    };
+    auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    const int kCostPerString = 100;
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          strings.NumElements(), kCostPerString, fingerprint);
+  }
+
   // Validates input tensors.
   void ValidateInput(OpKernelContext* context,
                      const OpInputList& indices_list_in,
@@ -444,11 +492,11 @@ class SparseCrossOp : public OpKernel {
   // Generate the columns given the sparse and dense inputs.
   std::vector<std::unique_ptr<ColumnInterface<InternalType>>>
   GenerateColumnsFromInput(const OpInputList& indices_list_in,
-                           const OpInputList& values_list_in,
+                           const std::vector<Tensor>& values_list_in,
                            const OpInputList& shapes_list_in,
-                           const OpInputList& dense_list_in) {
+                           const std::vector<Tensor>& dense_list_in,
+                           int64 batch_size) {
     std::vector<std::unique_ptr<ColumnInterface<InternalType>>> columns;
-    const int64 batch_size = CalculateBatchSize(shapes_list_in, dense_list_in);
     const int64 number_of_columns = shapes_list_in.size();
 
     std::vector<std::vector<int64>> feature_counts(number_of_columns,
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/kernels/csr_sparse_matrix.h"
 #include "tensorflow/core/kernels/fill_functor.h"
 
 namespace tensorflow {
@@ -243,6 +244,9 @@ template <typename T, typename Tindices, bool ADJ_A, bool ADJ_B>
 struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
   // Vectorize certain operations above this size.
   static const std::size_t kNumVectorize = 32;
+  // Shard products with at least this many multiply-adds over the rows of
+  // the output.
+  static const int64 kMinParallelCost = 1 << 16;
 
   static Status Compute(const CPUDevice& d, typename TTypes<T>::Matrix out,
                         typename TTypes<Tindices>::ConstMatrix a_indices,
@@ -254,11 +258,30 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
     const int lhs_index_a = ADJ_A ? 1 : 0;
     const int rhs_index_a = ADJ_A ? 0 : 1;
 
-    out.setZero();
+    if (d.numThreads() > 1 &&
+        static_cast<int64>(nnz * rhs_right) >= kMinParallelCost) {
+      // Sorting the entries by output row lets every thread own a block of
+      // rows of the output, without any synchronization. The entries of a
+      // row keep their order, so the sums are the same as below.
+      CSRMatrix<T> csr;
+      TF_RETURN_IF_ERROR((COOToCSR<T, Tindices>(
+          a_indices, a_values, lhs_index_a, rhs_index_a, out.dimension(0),
+          lhs_right, ADJ_A, &csr)));
+      if (ADJ_B) {
+        Eigen::array<int, 2> shuffle(1, 0);
+        Eigen::Tensor<T, 2, Eigen::RowMajor> conj_b =
+            b.shuffle(shuffle).conjugate();
+        CSRDenseMatMul<T>(
+            d, csr, typename TTypes<T>::ConstMatrix(conj_b.data(), lhs_right,
+                                                    rhs_right),
+            out);
+      } else {
+        CSRDenseMatMul<T>(d, csr, b, out);
+      }
+      return Status::OK();
+    }
 
-    // TODO(ebrevdo): After many failed experiments, can't find a multi-threaded
-    // approach that achieves the performance of the single threaded
-    // one.  Perhaps Eigen threadpool implementation is just too slow?
+    out.setZero();
 
     if (rhs_right < kNumVectorize) {
       // Disable vectorization if the RHS of output is too small
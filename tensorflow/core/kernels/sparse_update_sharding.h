@@ -0,0 +1,96 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_SPARSE_UPDATE_SHARDING_H_
+#define TENSORFLOW_CORE_KERNELS_SPARSE_UPDATE_SHARDING_H_
+
+// Helpers for kernels that update rows of a variable at given indices, such
+// as ScatterAdd and SparseApplyAdagrad, to apply large updates on several
+// threads. The rows are partitioned into shards, and each shard is updated
+// by one thread in the order of the indices. The result is then the same as
+// the one of a sequential loop, even with duplicate indices, and a hot row
+// only delays the updates of its own shard.
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace sparse_update_sharding {
+
+// The minimum cost of the updates of a shard, in cycles, below which the
+// scheduling overhead dominates.
+constexpr int64 kMinCostPerShard = 100000;
+
+// Returns the number of shards to apply "num_updates" updates of
+// "cost_per_update" cycles each into. Returns 1 for a sequential loop.
+inline int NumRowShards(OpKernelContext* ctx, int64 num_updates,
+                        int64 cost_per_update) {
+  const int num_threads =
+      ctx->device()->tensorflow_cpu_worker_threads()->num_threads;
+  const int64 max_shards = num_updates * cost_per_update / kMinCostPerShard;
+  return static_cast<int>(std::max<int64>(
+      1, std::min<int64>(num_threads, max_shards)));
+}
+
+// Copies "indices" to "rows". Returns the position of the first index that
+// is not in [0, limit), or -1 if they all are. Reads each index once, so
+// that the indices checked are the ones that are used.
+template <typename Index, typename Indices>
+Index CopyRows(const Indices& indices, Index limit, std::vector<Index>* rows) {
+  const Index n = static_cast<Index>(indices.size());
+  rows->resize(n);
+  for (Index i = 0; i < n; ++i) {
+    const Index row = ::tensorflow::internal::SubtleMustCopy(indices(i));
+    if (!FastBoundsCheck(row, limit)) return i;
+    (*rows)[i] = row;
+  }
+  return -1;
+}
+
+// Calls "fn(i, rows[i])" for each position i of "rows", with "num_shards"
+// threads of "ctx" that each own the rows r with r % num_shards equal to
+// their shard. "cost_per_update" is the cost of one call, in cycles.
+template <typename Index>
+void ForEachUpdate(OpKernelContext* ctx, int num_shards,
+                   const std::vector<Index>& rows, int64 cost_per_update,
+                   const std::function<void(Index i, Index row)>& fn) {
+  std::vector<std::vector<Index>> positions(num_shards);
+  for (Index i = 0; i < static_cast<Index>(rows.size()); ++i) {
+    positions[rows[i] % num_shards].push_back(i);
+  }
+  const int64 cost_per_shard =
+      std::max<int64>(kMinCostPerShard, rows.size() / num_shards *
+                                            cost_per_update);
+  auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(num_shards, worker_threads->workers, num_shards, cost_per_shard,
+        [&](int64 begin, int64 end) {
+          for (int64 shard = begin; shard < end; ++shard) {
+            for (Index i : positions[shard]) {
+              fn(i, rows[i]);
+            }
+          }
+        });
+}
+
+}  // namespace sparse_update_sharding
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_SPARSE_UPDATE_SHARDING_H_
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -44,18 +45,28 @@ class StringToHashBucketOp : public OpKernel {
                                             &output_tensor));
     auto output_flat = output_tensor->flat<int64>();
 
-    typedef decltype(input_flat.size()) Index;
-    for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output_flat(i) = static_cast<int64>(bucket_id);
-    }
+    const string* input = input_flat.data();
+    int64* output = output_flat.data();
+    auto hash_strings = [this, input, output](int64 begin, int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        const uint64 input_hash = hash(input[i]);
+        const uint64 bucket_id = input_hash % num_buckets_;
+        // The number of buckets is always in the positive range of int64 so
+        // is the resulting bucket_id. Casting the bucket_id from uint64 to
+        // int64 is safe.
+        output[i] = static_cast<int64>(bucket_id);
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          input_flat.size(), kCostPerString, hash_strings);
   }
 
  private:
+  // A rough count of the cycles to hash a short string into a bucket.
+  static constexpr int64 kCostPerString = 100;
+
   int64 num_buckets_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(StringToHashBucketOp);
@@ -86,18 +97,28 @@ class StringToKeyedHashBucketOp : public OpKernel {
                                             &output_tensor));
     auto output_flat = output_tensor->flat<int64>();
 
-    typedef decltype(input_flat.size()) Index;
-    for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(key_, input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output_flat(i) = static_cast<int64>(bucket_id);
-    }
+    const string* input = input_flat.data();
+    int64* output = output_flat.data();
+    auto hash_strings = [this, input, output](int64 begin, int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        const uint64 input_hash = hash(key_, input[i]);
+        const uint64 bucket_id = input_hash % num_buckets_;
+        // The number of buckets is always in the positive range of int64 so
+        // is the resulting bucket_id. Casting the bucket_id from uint64 to
+        // int64 is safe.
+        output[i] = static_cast<int64>(bucket_id);
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          input_flat.size(), kCostPerString, hash_strings);
   }
 
  private:
+  // A rough count of the cycles to hash a short string into a bucket.
+  static constexpr int64 kCostPerString = 200;
+
   int64 num_buckets_;
   uint64 key_[2];
 
@@ -97,10 +97,53 @@ class TopK : public OpKernel {
   bool sorted_;
 };
 
+namespace {
+
+// Orders positions of `input_data` by decreasing value, breaking ties by
+// increasing position.
+template <typename T>
+struct StableGreater {
+  bool operator()(const int32 a, const int32 b) const {
+    if (input_data[b] < input_data[a]) {
+      return true;
+    } else if (input_data[b] > input_data[a]) {
+      return false;
+    } else {
+      return a < b;
+    }
+  }
+
+  const T* input_data;
+};
+
+// Moves the k greatest of the positions in [begin, end) to the front, in
+// decreasing order if `sorted`. Since StableGreater is a total order, the
+// result is the same as that of gtl::TopN with it.
+template <typename T>
+void SelectTopK(const T* input_data, int64 k, bool sorted, int32* begin,
+                int32* end) {
+  const StableGreater<T> comp{input_data};
+  if (k < end - begin) {
+    std::nth_element(begin, begin + k, end, comp);
+  }
+  if (sorted) {
+    std::sort(begin, begin + k, comp);
+  }
+}
+
+}  // namespace
+
 namespace functor {
 
 template <typename T>
 struct TopKFunctor<CPUDevice, T> {
+  // From this k on, rows are partitioned with std::nth_element rather than
+  // pushed through a heap of size k.
+  static const int kMinSelectK = 64;
+  // Rows with at least this many columns are split over several threads
+  // when there are fewer rows than threads.
+  static const int64 kMinColsToSplitRows = 1 << 17;
+
   static EIGEN_ALWAYS_INLINE Status
   Compute(OpKernelContext* context, bool sorted, int k,
           const typename TTypes<T, 2>::ConstTensor& input, const int64 num_rows,
@@ -134,26 +177,34 @@ struct TopKFunctor<CPUDevice, T> {
       return Status::OK();
     }
 
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    const double cmp_cost = 3 * Eigen::TensorOpCost::AddCost<int32>() +
+                            Eigen::TensorOpCost::AddCost<T>();
+    if (k < num_cols && num_rows < worker_threads.num_threads &&
+        num_cols >= kMinColsToSplitRows) {
+      // Every chunk should hold several times k columns, so that selecting
+      // the top k of each of them is worth the merge.
+      const int64 num_chunks =
+          std::min<int64>(worker_threads.num_threads, num_cols / (4 * k));
+      if (num_chunks > 1) {
+        SplitRowsTopK(worker_threads, cmp_cost, sorted, k, input, num_rows,
+                      num_cols, num_chunks, values, indices);
+        return Status::OK();
+      }
+    }
+
     auto SortIndices = [&, context](int start_batch, int limit_batch) {
+      // Positions of a row, for rows partitioned with std::nth_element.
+      std::vector<int32> positions;
       for (int32 b = start_batch; b < limit_batch; ++b) {
         const T* input_data = &input(b, 0);
-        const auto stable_comp = [input_data](const int32 a, const int32 b) {
-          if (input_data[b] < input_data[a]) {
-            return true;
-          } else if (input_data[b] > input_data[a]) {
-            return false;
-          } else {
-            return a < b;
-          }
-        };
+        const StableGreater<T> stable_comp{input_data};
         const auto comp = [input_data](const int32 a, const int32 b) {
           return input_data[b] < input_data[a];
         };
-        // TODO(ebrevdo): For large k < num_cols, instead of using
-        // TopN, it may be faster to create a temporary vector of
-        // values 0..num_cols - 1 and then use std::partial_sort_copy
-        // of this into indices. Choosing the appropriate minimum k or
-        // ratio of k/num_cols will require some experimentation.
+        // For large k < num_cols, a heap of size k costs more than
+        // partitioning a temporary vector of 0..num_cols - 1 with
+        // std::nth_element and sorting its first k elements.
         if (k == num_cols) {
           auto* begin = &indices(b, 0);
           auto* end = &indices(b, k);
@@ -176,9 +227,15 @@ struct TopKFunctor<CPUDevice, T> {
             }
             run_begin = run_end;
           }
+        } else if (k >= kMinSelectK) {
+          positions.resize(num_cols);
+          std::iota(positions.begin(), positions.end(), 0);
+          SelectTopK(input_data, k, sorted, positions.data(),
+                     positions.data() + num_cols);
+          std::copy(positions.begin(), positions.begin() + k, &indices(b, 0));
         } else {
           // Use the TopN heap object to sort.
-          gtl::TopN<int32, decltype(stable_comp)> filter(k, stable_comp);
+          gtl::TopN<int32, StableGreater<T>> filter(k, stable_comp);
           filter.reserve(num_cols);
           for (int32 c = 0; c < num_cols; ++c) {
             filter.push(c);
@@ -206,25 +263,70 @@ struct TopKFunctor<CPUDevice, T> {
     };
 
     // Guesstimate of cost; 4*N*log(K) where N == num_cols.
-    // If K == N, assume the cost is N*log(K + 1).
-    const double cmp_cost = 3 * Eigen::TensorOpCost::AddCost<int32>() +
-                            Eigen::TensorOpCost::AddCost<T>();
-    const double base_cost =
-        cmp_cost *
-        static_cast<double>(num_cols *
-                            Eigen::numext::log2(static_cast<float>(k + 1)));
-    const double sort_cost = (k == num_cols) ? base_cost : 4 * base_cost;
+    // If K == N, assume the cost is N*log(K + 1). If the row is partitioned,
+    // assume 2*N for std::nth_element, plus K*log(K + 1) to sort.
+    const double log_k = Eigen::numext::log2(static_cast<float>(k + 1));
+    const double base_cost = cmp_cost * static_cast<double>(num_cols * log_k);
+    double sort_cost = (k == num_cols) ? base_cost : 4 * base_cost;
+    if (k >= kMinSelectK && k < num_cols) {
+      sort_cost = cmp_cost * (2 * num_cols + (sorted ? k * log_k : 0));
+    }
     const double copy_cost = 2 * k * Eigen::TensorOpCost::AddCost<T>();
     const double total_cost = sort_cost + copy_cost;
     const int64 final_cost = (total_cost >= static_cast<double>(kint64max))
                                  ? kint64max
                                  : static_cast<int64>(total_cost);
-    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           final_cost, SortIndices);
 
     return Status::OK();
   }
+
+ private:
+  // Splits every row into num_chunks chunks, selects the top k of every
+  // chunk in parallel, and then the top k of those candidates. The top k of
+  // a row are among the top k of its chunks, so the result is the same as
+  // when the row is handled by a single thread.
+  static void SplitRowsTopK(
+      const DeviceBase::CpuWorkerThreads& worker_threads, double cmp_cost,
+      bool sorted, int k, const typename TTypes<T, 2>::ConstTensor& input,
+      const int64 num_rows, const int64 num_cols, const int64 num_chunks,
+      typename TTypes<T, 2>::Tensor values,
+      typename TTypes<int, 2>::Tensor indices) {
+    const int64 chunk_size = Eigen::divup(num_cols, num_chunks);
+    std::vector<int32> positions(num_cols);
+    std::vector<int32> candidates;
+    for (int64 b = 0; b < num_rows; ++b) {
+      const T* input_data = &input(b, 0);
+      std::iota(positions.begin(), positions.end(), 0);
+      auto select_chunks = [&](int64 start, int64 limit) {
+        for (int64 i = start; i < limit; ++i) {
+          const int64 begin = std::min(num_cols, i * chunk_size);
+          const int64 end = std::min(num_cols, begin + chunk_size);
+          SelectTopK(input_data, std::min<int64>(k, end - begin),
+                     /*sorted=*/false, positions.data() + begin,
+                     positions.data() + end);
+        }
+      };
+      Shard(worker_threads.num_threads, worker_threads.workers, num_chunks,
+            static_cast<int64>(2 * chunk_size * cmp_cost), select_chunks);
+
+      candidates.clear();
+      for (int64 i = 0; i < num_chunks; ++i) {
+        const int64 begin = std::min(num_cols, i * chunk_size);
+        const int64 end = std::min(num_cols, begin + chunk_size);
+        const int64 num_candidates = std::min<int64>(k, end - begin);
+        candidates.insert(candidates.end(), positions.begin() + begin,
+                          positions.begin() + begin + num_candidates);
+      }
+      SelectTopK(input_data, k, sorted, candidates.data(),
+                 candidates.data() + candidates.size());
+      for (int i = 0; i < k; ++i) {
+        indices(b, i) = candidates[i];
+        values(b, i) = input_data[candidates[i]];
+      }
+    }
+  }
 };
 
 }  // namespace functor
@@ -20,9 +20,11 @@ limitations under the License.
 #include <cmath>
 #include <vector>
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "third_party/cub/block/block_scan.cuh"
 #include "third_party/cub/device/device_segmented_radix_sort.cuh"
 #include "third_party/cub/iterator/counting_input_iterator.cuh"
 #include "third_party/cub/iterator/transform_input_iterator.cuh"
+#include "third_party/cub/util_type.cuh"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -426,55 +428,29 @@ struct ColumnIndexCreator {
   int num_cols_;
 };
 
+// Sorts every row of the row major [num_rows, num_cols] `keys_in` in
+// decreasing order into `keys_out`, permuting `values_in` along into
+// `values_out`. The sort is stable, so equal keys keep their order.
 template <typename T>
-Status LaunchSortKernel(OpKernelContext* ctx, const T* input, int num_rows,
-                        int num_cols, int k,
-                        typename TTypes<T, 2>::Tensor values,
-                        TTypes<int, 2>::Tensor indices) {
-  const GPUDevice& d = ctx->eigen_device<GPUDevice>();
+Status SegmentedSortPairsDescending(OpKernelContext* ctx, const T* keys_in,
+                                    T* keys_out, const int* values_in,
+                                    int* values_out, int num_rows,
+                                    int num_cols) {
   const cudaStream_t& cu_stream = GetCudaStream(ctx);
   size_t temp_storage_bytes = -1;
 
-  // TODO(ebrevdo): Once cub supports iterators for ValueT replace that tensor
-  // with an iterator that directly returns the correct value.
-  Tensor input_indices;
-  TF_RETURN_IF_ERROR(ctx->allocate_temp(
-      DT_INT32, TensorShape({num_rows, num_cols}), &input_indices));
-  auto input_indices_t = To32Bit(input_indices.flat<int32>());
-  input_indices_t.device(d) =
-      input_indices_t.generate(ColumnIndexCreator(num_cols));
-
   cub::CountingInputIterator<int> counting_iter(0);
   cub::TransformInputIterator<int, SegmentOffsetCreator,
                               cub::CountingInputIterator<int>>
       segment_offsets_t(counting_iter, SegmentOffsetCreator(num_cols));
 
-  Tensor temp_values;
-  Tensor temp_indices;
-  T* sorted_values_ptr;
-  int* sorted_indices_ptr;
-  if (k == num_cols) {
-    // Doing a full sort, no intermediate values needed.
-    sorted_values_ptr = values.data();
-    sorted_indices_ptr = indices.data();
-  } else {
-    // Need to create intermediate values for sorting.
-    TF_RETURN_IF_ERROR(ctx->allocate_temp(
-        DT_INT32, TensorShape({num_rows, num_cols}), &temp_indices));
-    TF_RETURN_IF_ERROR(ctx->allocate_temp(DataTypeToEnum<T>::value,
-                                          TensorShape({num_rows, num_cols}),
-                                          &temp_values));
-    sorted_indices_ptr = temp_indices.flat<int32>().data();
-    sorted_values_ptr = temp_values.flat<T>().data();
-  }
-
   auto err = cub::DeviceSegmentedRadixSort::SortPairsDescending(
       /* d_temp_storage */ nullptr,
       /* temp_storage_bytes */ temp_storage_bytes,
-      /* d_keys_in */ input,
-      /* d_keys_out */ sorted_values_ptr,
-      /* d_values_in */ input_indices_t.data(),
-      /* d_values_out */ sorted_indices_ptr,
+      /* d_keys_in */ keys_in,
+      /* d_keys_out */ keys_out,
+      /* d_values_in */ values_in,
+      /* d_values_out */ values_out,
       /* num_items */ num_cols * num_rows,
       /* num_segments */ num_rows,
       /* d_begin_offsets */ segment_offsets_t,
@@ -496,10 +472,10 @@ Status LaunchSortKernel(OpKernelContext* ctx, const T* input, int num_rows,
   err = cub::DeviceSegmentedRadixSort::SortPairsDescending(
       /* d_temp_storage */ temp_storage.flat<int8>().data(),
       /* temp_storage_bytes */ temp_storage_bytes,
-      /* d_keys_in */ input,
-      /* d_keys_out */ sorted_values_ptr,
-      /* d_values_in */ input_indices_t.data(),
-      /* d_values_out */ sorted_indices_ptr,
+      /* d_keys_in */ keys_in,
+      /* d_keys_out */ keys_out,
+      /* d_values_in */ values_in,
+      /* d_values_out */ values_out,
       /* num_items */ num_cols * num_rows,
       /* num_segments */ num_rows,
       /* d_begin_offsets */ segment_offsets_t,
@@ -514,6 +490,47 @@ Status LaunchSortKernel(OpKernelContext* ctx, const T* input, int num_rows,
         "temp_storage_bytes: ",
         temp_storage_bytes, ", status: ", cudaGetErrorString(err));
   }
+  return Status::OK();
+}
+
+template <typename T>
+Status LaunchSortKernel(OpKernelContext* ctx, const T* input, int num_rows,
+                        int num_cols, int k,
+                        typename TTypes<T, 2>::Tensor values,
+                        TTypes<int, 2>::Tensor indices) {
+  const GPUDevice& d = ctx->eigen_device<GPUDevice>();
+
+  // TODO(ebrevdo): Once cub supports iterators for ValueT replace that tensor
+  // with an iterator that directly returns the correct value.
+  Tensor input_indices;
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(
+      DT_INT32, TensorShape({num_rows, num_cols}), &input_indices));
+  auto input_indices_t = To32Bit(input_indices.flat<int32>());
+  input_indices_t.device(d) =
+      input_indices_t.generate(ColumnIndexCreator(num_cols));
+
+  Tensor temp_values;
+  Tensor temp_indices;
+  T* sorted_values_ptr;
+  int* sorted_indices_ptr;
+  if (k == num_cols) {
+    // Doing a full sort, no intermediate values needed.
+    sorted_values_ptr = values.data();
+    sorted_indices_ptr = indices.data();
+  } else {
+    // Need to create intermediate values for sorting.
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DT_INT32, TensorShape({num_rows, num_cols}), &temp_indices));
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(DataTypeToEnum<T>::value,
+                                          TensorShape({num_rows, num_cols}),
+                                          &temp_values));
+    sorted_indices_ptr = temp_indices.flat<int32>().data();
+    sorted_values_ptr = temp_values.flat<T>().data();
+  }
+
+  TF_RETURN_IF_ERROR(SegmentedSortPairsDescending(
+      ctx, input, sorted_values_ptr, input_indices_t.data(),
+      sorted_indices_ptr, num_rows, num_cols));
   if (k < num_cols) {
     // Need to copy subsets of sorted_indices and sorted_outputs to
     // indices and outputs.
@@ -527,6 +544,152 @@ Status LaunchSortKernel(OpKernelContext* ctx, const T* input, int num_rows,
   return Status::OK();
 }
 
+constexpr int kRadixSelectBlockSize = 1024;
+constexpr int kRadixBits = 8;
+constexpr int kRadixSize = 1 << kRadixBits;
+
+// Selects the k largest elements of every row of `input` with one block per
+// row. The bits of the elements, twiddled so that they order like the
+// elements do (as in cub's radix sort), are scanned a digit at a time from
+// the most significant one, narrowing down the bits of the k-th largest
+// element: a histogram of the digit over the elements that match the digits
+// found so far tells which digit the k-th largest element has. This reads
+// the row once per digit, instead of sorting it.
+//
+// The elements greater than the k-th largest one, and as many elements equal
+// to it as needed, lowest indices first, are then written in index order.
+template <typename T>
+__global__ void __launch_bounds__(kRadixSelectBlockSize)
+    RadixSelectKernel(const T* input, int num_cols, int k, T* output,
+                      int* indices) {
+  typedef typename cub::Traits<T>::UnsignedBits UnsignedBits;
+  typedef cub::BlockScan<int, kRadixSelectBlockSize> BlockScan;
+  __shared__ int histogram[kRadixSize];
+  __shared__ UnsignedBits shared_prefix;
+  __shared__ int shared_remaining;
+  __shared__ typename BlockScan::TempStorage greater_storage;
+  __shared__ typename BlockScan::TempStorage equal_storage;
+
+  const UnsignedBits* row = reinterpret_cast<const UnsignedBits*>(input) +
+                            static_cast<int64>(blockIdx.x) * num_cols;
+  const int thread_index = threadIdx.x;
+  if (thread_index == 0) {
+    shared_prefix = 0;
+    shared_remaining = k;
+  }
+
+  // The digits of the k-th largest element found so far are prefix & mask,
+  // and it is the shared_remaining-th largest of the elements that match
+  // them.
+  UnsignedBits mask = 0;
+  for (int shift = sizeof(UnsignedBits) * 8 - kRadixBits; shift >= 0;
+       shift -= kRadixBits) {
+    for (int i = thread_index; i < kRadixSize; i += kRadixSelectBlockSize) {
+      histogram[i] = 0;
+    }
+    __syncthreads();
+    const UnsignedBits prefix = shared_prefix;
+    for (int c = thread_index; c < num_cols; c += kRadixSelectBlockSize) {
+      const UnsignedBits key = cub::Traits<T>::TwiddleIn(row[c]);
+      if ((key & mask) == prefix) {
+        atomicAdd(&histogram[(key >> shift) & (kRadixSize - 1)], 1);
+      }
+    }
+    __syncthreads();
+    if (thread_index == 0) {
+      int digit = kRadixSize - 1;
+      int remaining = shared_remaining;
+      while (histogram[digit] < remaining) {
+        remaining -= histogram[digit];
+        --digit;
+      }
+      shared_prefix = prefix | (static_cast<UnsignedBits>(digit) << shift);
+      shared_remaining = remaining;
+    }
+    mask |= static_cast<UnsignedBits>(kRadixSize - 1) << shift;
+    __syncthreads();
+  }
+
+  const UnsignedBits kth_key = shared_prefix;
+  const int num_equal = shared_remaining;
+  const int num_greater = k - num_equal;
+  T* row_output = output + static_cast<int64>(blockIdx.x) * k;
+  int* row_indices = indices + static_cast<int64>(blockIdx.x) * k;
+  int greater_base = 0;
+  int equal_base = 0;
+  for (int tile = 0; tile < num_cols; tile += kRadixSelectBlockSize) {
+    const int c = tile + thread_index;
+    int is_greater = 0;
+    int is_equal = 0;
+    UnsignedBits bits = 0;
+    if (c < num_cols) {
+      bits = row[c];
+      const UnsignedBits key = cub::Traits<T>::TwiddleIn(bits);
+      is_greater = key > kth_key;
+      is_equal = key == kth_key;
+    }
+    int greater_offset;
+    int equal_offset;
+    int tile_greater;
+    int tile_equal;
+    BlockScan(greater_storage)
+        .ExclusiveSum(is_greater, greater_offset, tile_greater);
+    BlockScan(equal_storage).ExclusiveSum(is_equal, equal_offset, tile_equal);
+    int position = -1;
+    if (is_greater) {
+      position = greater_base + greater_offset;
+    } else if (is_equal && equal_base + equal_offset < num_equal) {
+      position = num_greater + equal_base + equal_offset;
+    }
+    if (position >= 0) {
+      row_output[position] = reinterpret_cast<const T&>(bits);
+      row_indices[position] = c;
+    }
+    greater_base += tile_greater;
+    equal_base += tile_equal;
+    // All threads agree on the bases, so they all leave together.
+    if (greater_base == num_greater && equal_base >= num_equal) break;
+    // The temp storage is reused by the next tile.
+    __syncthreads();
+  }
+}
+
+template <typename T>
+Status LaunchRadixSelectKernel(OpKernelContext* ctx, const T* input,
+                               int num_rows, int num_cols, int k, bool sorted,
+                               typename TTypes<T, 2>::Tensor values,
+                               TTypes<int, 2>::Tensor indices) {
+  const cudaStream_t& cu_stream = GetCudaStream(ctx);
+  // The selected elements are in index order, so sort them if needed.
+  Tensor temp_values;
+  Tensor temp_indices;
+  T* selected_values_ptr = values.data();
+  int* selected_indices_ptr = indices.data();
+  if (sorted) {
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DT_INT32, TensorShape({num_rows, k}), &temp_indices));
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DataTypeToEnum<T>::value, TensorShape({num_rows, k}), &temp_values));
+    selected_indices_ptr = temp_indices.flat<int32>().data();
+    selected_values_ptr = temp_values.flat<T>().data();
+  }
+
+  RadixSelectKernel<T><<<num_rows, kRadixSelectBlockSize, 0, cu_stream>>>(
+      input, num_cols, k, selected_values_ptr, selected_indices_ptr);
+  auto err = cudaGetLastError();
+  if (err != cudaSuccess) {
+    return errors::Internal("Could not launch RadixSelectKernel: ",
+                            cudaGetErrorString(err), ".");
+  }
+  if (sorted) {
+    // The sort is stable, so equal elements stay in index order.
+    return SegmentedSortPairsDescending(ctx, selected_values_ptr,
+                                        values.data(), selected_indices_ptr,
+                                        indices.data(), num_rows, k);
+  }
+  return Status::OK();
+}
+
 }  // end namespace impl
 
 namespace functor {
@@ -538,13 +701,17 @@ struct TopKFunctor<GPUDevice, T> {
           const typename TTypes<T, 2>::ConstTensor& input, const int64 num_rows,
           const int64 num_cols, typename TTypes<T, 2>::Tensor values,
           typename TTypes<int, 2>::Tensor indices) {
-    // For small k, use the heap implementation.  For larger k, use
-    // the in-place cub sort.  For k == num_cols, always use the
-    // in-place cub sort.  The thresholds for n and k were determined
-    // empirically.
-    if (num_cols <= 1000 || k == num_cols || k >= 100) {
+    // For small k, use the heap implementation.  For larger k, or for
+    // very long rows, select the top k with a radix select, and only sort
+    // those.  For short rows and for k == num_cols, use the in-place cub
+    // sort.  The thresholds for n and k were determined empirically.
+    if (num_cols <= 1000 || k == num_cols) {
       return impl::LaunchSortKernel(context, input.data(), num_rows, num_cols,
                                     k, values, indices);
+    } else if (k >= 100 || num_cols >= (1 << 20)) {
+      return impl::LaunchRadixSelectKernel(context, input.data(), num_rows,
+                                           num_cols, k, sorted, values,
+                                           indices);
     } else {
       const cudaStream_t& cu_stream = GetCudaStream(context);
       auto err = impl::LaunchTopKKernel(cu_stream, /* num_shards */ 0,
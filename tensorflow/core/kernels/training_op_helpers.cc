@@ -15,10 +15,25 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/training_op_helpers.h"
 
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
 
+bool SparseVariableUpdatesInPlace() {
+  static const bool in_place = [] {
+    bool value;
+    Status status = ReadBoolFromEnvVar(
+        "TF_RESOURCE_VARIABLE_SPARSE_UPDATE_IN_PLACE", false, &value);
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      return false;
+    }
+    return value;
+  }();
+  return in_place;
+}
+
 mutex* GetTrainingVariableMutex(OpKernelContext* ctx, int input,
                                 Var** maybe_resource) {
   *maybe_resource = nullptr;
@@ -55,31 +70,24 @@ VariableInputLockHolder MaybeLockVariableInputMutexesInOrder(
   }
   std::vector<Var*> vars;
   std::vector<mutex*> mutexes;
-  std::vector<int> acquire_order;
   for (auto input : input_ids) {
     Var* var;
     mutex* mutex = GetTrainingVariableMutex(ctx, input, &var);
     if (var) vars.push_back(var);
-    // Only lock each mutex once if duplicates exist (n^2 but n is 2 or 3).
-    if (std::find(mutexes.begin(), mutexes.end(), mutex) == mutexes.end()) {
-      acquire_order.push_back(mutexes.size());
-      mutexes.push_back(mutex);
-    }
+    if (mutex != nullptr) mutexes.push_back(mutex);
   }
-  std::sort(acquire_order.begin(), acquire_order.end(),
-            [&mutexes](int a, int b) { return mutexes[a] < mutexes[b]; });
+  // Only lock each mutex once if duplicates exist. Sorting rather than
+  // searching keeps this cheap for the multi-tensor apply ops, which may lock
+  // thousands of variables.
+  std::sort(mutexes.begin(), mutexes.end());
+  mutexes.erase(std::unique(mutexes.begin(), mutexes.end()), mutexes.end());
 
   std::unique_ptr<std::vector<mutex_lock>> locks =
       MakeUnique<std::vector<mutex_lock>>();
-  locks->reserve(acquire_order.size());
+  locks->reserve(mutexes.size());
 
-  for (auto input : acquire_order) {
-    Var* var;
-    mutex* mu = GetTrainingVariableMutex(ctx, input, &var);
-    core::ScopedUnref scoped_unref(var);
-    if (mu != nullptr) {
-      locks->emplace_back(*mu);
-    }
+  for (mutex* mu : mutexes) {
+    locks->emplace_back(*mu);
   }
   return VariableInputLockHolder(std::move(vars), std::move(locks));
 }
@@ -100,12 +100,32 @@ Status PrepareToUpdateVariable(OpKernelContext* ctx, Tensor* tensor) {
   return Status::OK();
 }
 
+// Returns true if sparse updates of ResourceVariables write into the
+// variable's buffer even when a read still holds a reference to it, so
+// that such readers observe the update (Hogwild-style relaxed
+// consistency) instead of the update copying the whole variable.
+// Gathers are not affected: they read under the variable's shared lock
+// and never see a partially applied update.  Enabled by setting the
+// environment variable TF_RESOURCE_VARIABLE_SPARSE_UPDATE_IN_PLACE=1.
+bool SparseVariableUpdatesInPlace();
+
+// Like PrepareToUpdateVariable(), for updates that only write some rows of
+// the variable: never copies when SparseVariableUpdatesInPlace().
+// REQUIRES: If you pass in variable->tensor(), *variable->mu() must be held.
+template <typename Device, typename T>
+Status PrepareToUpdateVariableSparse(OpKernelContext* ctx, Tensor* tensor) {
+  if (SparseVariableUpdatesInPlace()) {
+    return Status::OK();
+  }
+  return PrepareToUpdateVariable<Device, T>(ctx, tensor);
+}
+
 // This gives you `*out`, a tensor you can update, corresponding to a
 // variable passed as input index `input`.  This handles the
 // differences between reference and resource variables.  For resource
 // variables, we ensure `*out` has a reference count of 1 (using
-// PrepareToUpdateVariable() to copy if necessary) unless
-// sparse && !lock_held, in which case it never copies.
+// PrepareToUpdateVariable() to copy if necessary) unless sparse and
+// SparseVariableUpdatesInPlace(), in which case it never copies.
 template <typename Device, typename T>
 Status GetInputTensorFromVariable(OpKernelContext* ctx, int input,
                                   bool lock_held, bool sparse, Tensor* out) {
@@ -113,7 +133,13 @@ Status GetInputTensorFromVariable(OpKernelContext* ctx, int input,
     Var* var;
     TF_RETURN_IF_ERROR(LookupResource(ctx, HandleFromInput(ctx, input), &var));
     core::ScopedUnref unref_var(var);
-    TF_RETURN_IF_ERROR(PrepareToUpdateVariable<Device, T>(ctx, var->tensor()));
+    if (sparse) {
+      TF_RETURN_IF_ERROR(
+          PrepareToUpdateVariableSparse<Device, T>(ctx, var->tensor()));
+    } else {
+      TF_RETURN_IF_ERROR(
+          PrepareToUpdateVariable<Device, T>(ctx, var->tensor()));
+    }
     *out = *var->tensor();
     return Status::OK();
   }
@@ -17,10 +17,13 @@ limitations under the License.
 #include "tensorflow/core/lib/bfloat16/bfloat16.h"
 
 #include <algorithm>
+#include <numeric>
+#include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/kernels/sparse_update_sharding.h"
 #include "tensorflow/core/kernels/training_op_helpers.h"
 #include "tensorflow/core/kernels/training_ops.h"
 #include "tensorflow/core/kernels/variable_ops.h"
@@ -331,6 +334,102 @@ struct ApplyAdamSYCL {
 template <typename T>
 struct ApplyAdam<CPUDevice, T> : ApplyAdamNonCuda<CPUDevice, T> {};
 
+// Runs fn(i, begin, end) on the elements [begin, end) of the i-th of tensors
+// with `sizes` elements, in chunks spread over the threads of `d`. Chunks
+// rather than whole tensors are the unit of work, so that a few large
+// variables do not leave the other threads idle.
+template <typename Fn>
+void ForEachMultiApplyChunk(const CPUDevice& d,
+                            const std::vector<int64>& sizes,
+                            const Eigen::TensorOpCost& cost_per_element,
+                            const Fn& fn) {
+  constexpr int64 kChunkSize = 16384;
+  // The first chunk of each tensor, plus the total number of chunks.
+  std::vector<int64> chunk_begin(1, 0);
+  for (int64 size : sizes) {
+    chunk_begin.push_back(chunk_begin.back() +
+                          (size + kChunkSize - 1) / kChunkSize);
+  }
+  const int64 num_chunks = chunk_begin.back();
+  auto work = [&](int64 first, int64 last) {
+    int i = std::upper_bound(chunk_begin.begin(), chunk_begin.end(), first) -
+            chunk_begin.begin() - 1;
+    for (int64 chunk = first; chunk < last; ++chunk) {
+      while (chunk >= chunk_begin[i + 1]) ++i;
+      const int64 begin = (chunk - chunk_begin[i]) * kChunkSize;
+      fn(i, begin, std::min(sizes[i], begin + kChunkSize));
+    }
+  };
+  d.parallelFor(num_chunks, cost_per_element * kChunkSize, work);
+}
+
+template <typename T>
+struct MultiApplyMomentum<CPUDevice, T> {
+  void operator()(const CPUDevice& d, const std::vector<T*>& var,
+                  const std::vector<T*>& accum,
+                  const std::vector<const T*>& grad,
+                  const std::vector<int64>& sizes,
+                  typename TTypes<T>::ConstScalar lr,
+                  typename TTypes<T>::ConstScalar momentum,
+                  bool use_nesterov) {
+    const T lr_value = lr();
+    const T momentum_value = momentum();
+    auto update = [&](int i, int64 begin, int64 end) {
+      typename TTypes<T>::Flat var_chunk(var[i] + begin, end - begin);
+      typename TTypes<T>::Flat accum_chunk(accum[i] + begin, end - begin);
+      typename TTypes<T>::ConstFlat grad_chunk(grad[i] + begin, end - begin);
+      accum_chunk = accum_chunk * momentum_value + grad_chunk;
+      if (use_nesterov) {
+        var_chunk -= grad_chunk * lr_value +
+                     accum_chunk * momentum_value * lr_value;
+      } else {
+        var_chunk -= accum_chunk * lr_value;
+      }
+    };
+    const Eigen::TensorOpCost cost(3 * sizeof(T), 2 * sizeof(T), 5);
+    ForEachMultiApplyChunk(d, sizes, cost, update);
+  }
+};
+
+template <typename T>
+struct MultiApplyAdam<CPUDevice, T> {
+  void operator()(const CPUDevice& d, const std::vector<T*>& var,
+                  const std::vector<T*>& m, const std::vector<T*>& v,
+                  const std::vector<const T*>& grad,
+                  const std::vector<int64>& sizes,
+                  typename TTypes<T>::ConstScalar beta1_power,
+                  typename TTypes<T>::ConstScalar beta2_power,
+                  typename TTypes<T>::ConstScalar lr,
+                  typename TTypes<T>::ConstScalar beta1,
+                  typename TTypes<T>::ConstScalar beta2,
+                  typename TTypes<T>::ConstScalar epsilon,
+                  bool use_nesterov) {
+    const T alpha = lr() * Eigen::numext::sqrt(T(1) - beta2_power()) /
+                    (T(1) - beta1_power());
+    const T beta1_value = beta1();
+    const T beta2_value = beta2();
+    const T epsilon_value = epsilon();
+    auto update = [&](int i, int64 begin, int64 end) {
+      typename TTypes<T>::Flat var_chunk(var[i] + begin, end - begin);
+      typename TTypes<T>::Flat m_chunk(m[i] + begin, end - begin);
+      typename TTypes<T>::Flat v_chunk(v[i] + begin, end - begin);
+      typename TTypes<T>::ConstFlat grad_chunk(grad[i] + begin, end - begin);
+      m_chunk += (grad_chunk - m_chunk) * (T(1) - beta1_value);
+      v_chunk += (grad_chunk.square() - v_chunk) * (T(1) - beta2_value);
+      if (use_nesterov) {
+        var_chunk -= ((grad_chunk * (T(1) - beta1_value) +
+                       m_chunk * beta1_value) *
+                      alpha) /
+                     (v_chunk.sqrt() + epsilon_value);
+      } else {
+        var_chunk -= (m_chunk * alpha) / (v_chunk.sqrt() + epsilon_value);
+      }
+    };
+    const Eigen::TensorOpCost cost(4 * sizeof(T), 3 * sizeof(T), 15);
+    ForEachMultiApplyChunk(d, sizes, cost, update);
+  }
+};
+
 template <typename Device, typename T>
 struct ApplyAdaMaxNonCuda {
   void operator()(const Device& d, typename TTypes<T>::Flat var,
@@ -1337,14 +1436,7 @@ class SparseApplyAdagradOp : public OpKernel {
         auto grad_flat = grad.flat_outer_dims<T>();
         T lr_scalar = lr.scalar<T>()();
 
-        // Note(yonghui): It might be worth multi-threading square() and
-        // rsqrt().
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto update = [&](Tindex i, Tindex index) {
           auto a = accum_flat.template chip<0>(index);
           auto g = grad_flat.template chip<0>(i);
           auto v = var_flat.template chip<0>(index);
@@ -1352,6 +1444,31 @@ class SparseApplyAdagradOp : public OpKernel {
             a += g.square();
           }
           v -= g.constant(lr_scalar) * g * a.rsqrt();
+        };
+        // Large updates, e.g. of hot embeddings, are applied to shards of
+        // rows in parallel, which shortens the time the variable is locked.
+        const int64 cost_per_update = inner_dim * 20;
+        const int num_shards =
+            sparse_update_sharding::NumRowShards(ctx, N, cost_per_update);
+        if (num_shards > 1) {
+          std::vector<Tindex> rows;
+          const Tindex bad_i = sparse_update_sharding::CopyRows(
+              indices_vec, first_dim_size, &rows);
+          OP_REQUIRES(ctx, bad_i < 0,
+                      errors::InvalidArgument(strings::StrCat(
+                          "Index ", indices_vec(bad_i), " at offset ", bad_i,
+                          " in indices is out of range")));
+          sparse_update_sharding::ForEachUpdate<Tindex>(
+              ctx, num_shards, rows, cost_per_update, update);
+        } else {
+          for (Tindex i = 0; i < N; i++) {
+            const Tindex index = internal::SubtleMustCopy(indices_vec(i));
+            OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
+                        errors::InvalidArgument(
+                            strings::StrCat("Index ", index, " at offset ", i,
+                                            " in indices is out of range")));
+            update(i, index);
+          }
         }
       } else {
         auto indices_vec = indices.vec<Tindex>();
@@ -2406,6 +2523,142 @@ REGISTER_KERNELS(GPU, double);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+// Gets the variables of the first `num_lists` input lists of a multi-tensor
+// apply op with N variables per list, and checks them against the N gradients
+// starting at input `grad_begin`. The variables must already be locked. Sets
+// (*slots)[k][i] to the data of the i-th variable of list k.
+template <typename Device, typename T>
+Status GetMultiApplyInputs(OpKernelContext* ctx, bool use_exclusive_lock,
+                           int num_lists, int grad_begin,
+                           std::vector<std::vector<T*>>* slots,
+                           std::vector<const T*>* grads,
+                           std::vector<int64>* sizes) {
+  const int n = ctx->num_inputs() - grad_begin;
+  slots->assign(num_lists, std::vector<T*>(n));
+  grads->resize(n);
+  sizes->resize(n);
+  for (int i = 0; i < n; ++i) {
+    const Tensor& grad = ctx->input(grad_begin + i);
+    for (int k = 0; k < num_lists; ++k) {
+      const int input = k * n + i;
+      Tensor var;
+      TF_RETURN_IF_ERROR(GetInputTensorFromVariable<Device, T>(
+          ctx, input, use_exclusive_lock, false, &var));
+      if (!var.IsInitialized()) {
+        return errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ",
+            ctx->op_kernel().requested_input(input));
+      }
+      if (!var.shape().IsSameSize(grad.shape())) {
+        return errors::InvalidArgument(
+            "Variable ", ctx->op_kernel().requested_input(input),
+            " and grad ", i, " do not have the same shape",
+            var.shape().DebugString(), " ", grad.shape().DebugString());
+      }
+      (*slots)[k][i] = var.flat<T>().data();
+    }
+    (*grads)[i] = grad.flat<T>().data();
+    (*sizes)[i] = grad.NumElements();
+  }
+  // The variables are updated in parallel, so each may appear only once.
+  std::vector<T*> vars = slots->front();
+  std::sort(vars.begin(), vars.end());
+  for (int i = 1; i < n; ++i) {
+    if (vars[i] == vars[i - 1] && vars[i] != nullptr) {
+      return errors::InvalidArgument(
+          "A variable cannot be updated twice by ", ctx->op_kernel().name());
+    }
+  }
+  return Status::OK();
+}
+
+// Returns the input ids of the first `num_lists` lists of a multi-tensor
+// apply op, which are the variables to lock.
+static std::vector<int> MultiApplyVariableInputs(int num_lists, int n) {
+  std::vector<int> inputs(num_lists * n);
+  std::iota(inputs.begin(), inputs.end(), 0);
+  return inputs;
+}
+
+template <typename Device, typename T>
+class MultiApplyMomentumOp : public OpKernel {
+ public:
+  explicit MultiApplyMomentumOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &n_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    auto locks = MaybeLockVariableInputMutexesInOrder(
+        ctx, use_exclusive_lock_, MultiApplyVariableInputs(2, n_));
+
+    const Tensor& lr = ctx->input(2 * n_);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(lr.shape()),
+                errors::InvalidArgument("lr is not a scalar: ",
+                                        lr.shape().DebugString()));
+    const Tensor& momentum = ctx->input(2 * n_ + 1);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(momentum.shape()),
+                errors::InvalidArgument("momentum is not a scalar: ",
+                                        momentum.shape().DebugString()));
+
+    std::vector<std::vector<T*>> slots;
+    std::vector<const T*> grads;
+    std::vector<int64> sizes;
+    OP_REQUIRES_OK(ctx, GetMultiApplyInputs<Device, T>(
+                            ctx, use_exclusive_lock_, 2, 2 * n_ + 2, &slots,
+                            &grads, &sizes));
+
+    const Device& device = ctx->template eigen_device<Device>();
+    functor::MultiApplyMomentum<Device, T>()(
+        device, slots[0], slots[1], grads, sizes, lr.scalar<T>(),
+        momentum.scalar<T>(), use_nesterov_);
+  }
+
+ private:
+  int n_;
+  bool use_exclusive_lock_;
+  bool use_nesterov_;
+};
+
+#define REGISTER_KERNELS(D, T)                                  \
+  REGISTER_KERNEL_BUILDER(Name("ResourceMultiApplyMomentum")    \
+                              .Device(DEVICE_##D)               \
+                              .HostMemory("var")                \
+                              .HostMemory("accum")              \
+                              .TypeConstraint<T>("T"),          \
+                          MultiApplyMomentumOp<D##Device, T>);
+#define REGISTER_CPU_KERNELS(T) REGISTER_KERNELS(CPU, T);
+
+TF_CALL_half(REGISTER_CPU_KERNELS);
+TF_CALL_bfloat16(REGISTER_CPU_KERNELS);
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_double(REGISTER_CPU_KERNELS);
+
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                               \
+  template <>                                                             \
+  void MultiApplyMomentum<GPUDevice, T>::operator()(                      \
+      const GPUDevice& d, const std::vector<T*>& var,                     \
+      const std::vector<T*>& accum, const std::vector<const T*>& grad,    \
+      const std::vector<int64>& sizes, typename TTypes<T>::ConstScalar lr, \
+      typename TTypes<T>::ConstScalar momentum, bool use_nesterov);       \
+  extern template struct MultiApplyMomentum<GPUDevice, T>;
+DECLARE_GPU_SPEC(Eigen::half);
+DECLARE_GPU_SPEC(float);
+DECLARE_GPU_SPEC(double);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+REGISTER_KERNELS(GPU, Eigen::half);
+REGISTER_KERNELS(GPU, float);
+REGISTER_KERNELS(GPU, double);
+#endif
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_KERNELS
+
 // Note, this op works on cpu only.
 template <typename T, typename Tindex>
 class SparseApplyMomentumOp : public OpKernel {
@@ -2786,6 +3039,95 @@ REGISTER_KERNELS(GPU, double);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+template <typename Device, typename T>
+class MultiApplyAdamOp : public OpKernel {
+ public:
+  explicit MultiApplyAdamOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &n_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    auto locks = MaybeLockVariableInputMutexesInOrder(
+        ctx, use_exclusive_lock_, MultiApplyVariableInputs(3, n_));
+
+    static const char* const kScalarNames[] = {
+        "beta1_power", "beta2_power", "lr", "beta1", "beta2", "epsilon"};
+    for (int i = 0; i < 6; ++i) {
+      const Tensor& scalar = ctx->input(3 * n_ + i);
+      OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(scalar.shape()),
+                  errors::InvalidArgument(kScalarNames[i],
+                                          " is not a scalar: ",
+                                          scalar.shape().DebugString()));
+    }
+
+    std::vector<std::vector<T*>> slots;
+    std::vector<const T*> grads;
+    std::vector<int64> sizes;
+    OP_REQUIRES_OK(ctx, GetMultiApplyInputs<Device, T>(
+                            ctx, use_exclusive_lock_, 3, 3 * n_ + 6, &slots,
+                            &grads, &sizes));
+
+    const Device& device = ctx->template eigen_device<Device>();
+    functor::MultiApplyAdam<Device, T>()(
+        device, slots[0], slots[1], slots[2], grads, sizes,
+        ctx->input(3 * n_).scalar<T>(), ctx->input(3 * n_ + 1).scalar<T>(),
+        ctx->input(3 * n_ + 2).scalar<T>(), ctx->input(3 * n_ + 3).scalar<T>(),
+        ctx->input(3 * n_ + 4).scalar<T>(), ctx->input(3 * n_ + 5).scalar<T>(),
+        use_nesterov_);
+  }
+
+ private:
+  int n_;
+  bool use_exclusive_lock_;
+  bool use_nesterov_;
+};
+
+#define REGISTER_KERNELS(D, T)                               \
+  REGISTER_KERNEL_BUILDER(Name("ResourceMultiApplyAdam")     \
+                              .Device(DEVICE_##D)            \
+                              .HostMemory("var")             \
+                              .HostMemory("m")               \
+                              .HostMemory("v")               \
+                              .TypeConstraint<T>("T"),       \
+                          MultiApplyAdamOp<D##Device, T>);
+#define REGISTER_CPU_KERNELS(T) REGISTER_KERNELS(CPU, T);
+
+TF_CALL_half(REGISTER_CPU_KERNELS);
+TF_CALL_bfloat16(REGISTER_CPU_KERNELS);
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_double(REGISTER_CPU_KERNELS);
+
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                               \
+  template <>                                                             \
+  void MultiApplyAdam<GPUDevice, T>::operator()(                          \
+      const GPUDevice& d, const std::vector<T*>& var,                     \
+      const std::vector<T*>& m, const std::vector<T*>& v,                 \
+      const std::vector<const T*>& grad, const std::vector<int64>& sizes, \
+      typename TTypes<T>::ConstScalar beta1_power,                        \
+      typename TTypes<T>::ConstScalar beta2_power,                        \
+      typename TTypes<T>::ConstScalar lr,                                 \
+      typename TTypes<T>::ConstScalar beta1,                              \
+      typename TTypes<T>::ConstScalar beta2,                              \
+      typename TTypes<T>::ConstScalar epsilon, bool use_nesterov);        \
+  extern template struct MultiApplyAdam<GPUDevice, T>;
+DECLARE_GPU_SPEC(Eigen::half);
+DECLARE_GPU_SPEC(float);
+DECLARE_GPU_SPEC(double);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+REGISTER_KERNELS(GPU, Eigen::half);
+REGISTER_KERNELS(GPU, float);
+REGISTER_KERNELS(GPU, double);
+#endif
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_KERNELS
+
 template <typename Device, typename T>
 class ApplyAdaMaxOp : public OpKernel {
  public:
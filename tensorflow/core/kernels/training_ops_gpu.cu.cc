@@ -17,8 +17,12 @@ limitations under the License.
 
 #define EIGEN_USE_GPU
 
+#include <array>
+#include <type_traits>
+
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/training_ops.h"
+#include "tensorflow/core/util/cuda_kernel_helper.h"
 
 namespace tensorflow {
 
@@ -286,6 +290,194 @@ struct ApplyPowerSign<GPUDevice, T> {
 
 }  // namespace functor
 
+namespace {
+
+// Each block of a multi-tensor apply kernel updates one chunk of one tensor.
+// The tensors of a launch are passed by value in a MultiApplyPack, and kernel
+// arguments are limited to 4KB, so large updates take several launches of
+// up to kMaxMultiApplyTensors tensors and kMaxMultiApplyBlocks chunks.
+constexpr int kMultiApplyChunkSize = 16384;
+constexpr int kMultiApplyThreads = 512;
+constexpr int kMaxMultiApplyTensors = 36;
+constexpr int kMaxMultiApplyBlocks = 320;
+
+template <typename T, int kNumSlots>
+struct MultiApplyPack {
+  // The variables, then their optimizer slots.
+  T* slots[kNumSlots][kMaxMultiApplyTensors];
+  const T* grad[kMaxMultiApplyTensors];
+  int64 size[kMaxMultiApplyTensors];
+  uint8 block_tensor[kMaxMultiApplyBlocks];
+  int32 block_chunk[kMaxMultiApplyBlocks];
+};
+
+// half is updated in float.
+template <typename T>
+using MultiApplyComputeType =
+    typename std::conditional<std::is_same<T, Eigen::half>::value, float,
+                              T>::type;
+
+// Splits the tensors into chunks and calls launch(pack, num_blocks) for each
+// pack of chunks.
+template <typename T, int kNumSlots, typename Launch>
+void LaunchMultiApply(
+    const std::array<const std::vector<T*>*, kNumSlots>& slots,
+    const std::vector<const T*>& grad, const std::vector<int64>& sizes,
+    const Launch& launch) {
+  MultiApplyPack<T, kNumSlots> pack;
+  auto set_tensor = [&](int index, int i) {
+    for (int k = 0; k < kNumSlots; ++k) {
+      pack.slots[k][index] = (*slots[k])[i];
+    }
+    pack.grad[index] = grad[i];
+    pack.size[index] = sizes[i];
+  };
+  int num_tensors = 0;
+  int num_blocks = 0;
+  const int n = sizes.size();
+  for (int i = 0; i < n; ++i) {
+    if (sizes[i] == 0) continue;
+    set_tensor(num_tensors, i);
+    bool pack_reset = false;
+    const int64 num_chunks =
+        (sizes[i] + kMultiApplyChunkSize - 1) / kMultiApplyChunkSize;
+    for (int64 chunk = 0; chunk < num_chunks; ++chunk) {
+      pack.block_tensor[num_blocks] = num_tensors;
+      pack.block_chunk[num_blocks] = chunk;
+      ++num_blocks;
+      const bool last_chunk = chunk + 1 == num_chunks;
+      if (num_blocks == kMaxMultiApplyBlocks ||
+          (last_chunk && num_tensors + 1 == kMaxMultiApplyTensors)) {
+        launch(pack, num_blocks);
+        num_blocks = 0;
+        pack_reset = true;
+        // The remaining chunks of this tensor start the next pack.
+        if (!last_chunk) {
+          set_tensor(0, i);
+          num_tensors = 0;
+          pack_reset = false;
+        }
+      }
+    }
+    num_tensors = pack_reset ? 0 : num_tensors + 1;
+  }
+  if (num_blocks > 0) {
+    launch(pack, num_blocks);
+  }
+}
+
+template <typename T, int kNumSlots>
+__device__ void MultiApplyChunk(const MultiApplyPack<T, kNumSlots>& pack,
+                                int* tensor, int64* begin, int64* end) {
+  *tensor = pack.block_tensor[blockIdx.x];
+  *begin = static_cast<int64>(pack.block_chunk[blockIdx.x]) *
+           kMultiApplyChunkSize;
+  *end = min(pack.size[*tensor], *begin + kMultiApplyChunkSize);
+}
+
+template <typename T>
+__global__ void MultiApplyMomentumKernel(MultiApplyPack<T, 2> pack,
+                                         const T* __restrict__ lr_ptr,
+                                         const T* __restrict__ momentum_ptr,
+                                         bool use_nesterov) {
+  typedef MultiApplyComputeType<T> U;
+  int tensor;
+  int64 begin, end;
+  MultiApplyChunk(pack, &tensor, &begin, &end);
+  T* var = pack.slots[0][tensor];
+  T* accum = pack.slots[1][tensor];
+  const T* grad = pack.grad[tensor];
+  const U lr = static_cast<U>(ldg(lr_ptr));
+  const U momentum = static_cast<U>(ldg(momentum_ptr));
+  for (int64 i = begin + threadIdx.x; i < end; i += blockDim.x) {
+    const U g = static_cast<U>(ldg(grad + i));
+    const U a = static_cast<U>(accum[i]) * momentum + g;
+    const U update = use_nesterov ? g * lr + a * momentum * lr : a * lr;
+    accum[i] = static_cast<T>(a);
+    var[i] = static_cast<T>(static_cast<U>(var[i]) - update);
+  }
+}
+
+template <typename T>
+__global__ void MultiApplyAdamKernel(
+    MultiApplyPack<T, 3> pack, const T* __restrict__ beta1_power_ptr,
+    const T* __restrict__ beta2_power_ptr, const T* __restrict__ lr_ptr,
+    const T* __restrict__ beta1_ptr, const T* __restrict__ beta2_ptr,
+    const T* __restrict__ epsilon_ptr, bool use_nesterov) {
+  typedef MultiApplyComputeType<T> U;
+  int tensor;
+  int64 begin, end;
+  MultiApplyChunk(pack, &tensor, &begin, &end);
+  T* var = pack.slots[0][tensor];
+  T* m = pack.slots[1][tensor];
+  T* v = pack.slots[2][tensor];
+  const T* grad = pack.grad[tensor];
+  const U one = static_cast<U>(1);
+  const U beta1 = static_cast<U>(ldg(beta1_ptr));
+  const U beta2 = static_cast<U>(ldg(beta2_ptr));
+  const U epsilon = static_cast<U>(ldg(epsilon_ptr));
+  const U alpha = static_cast<U>(ldg(lr_ptr)) *
+                  sqrt(one - static_cast<U>(ldg(beta2_power_ptr))) /
+                  (one - static_cast<U>(ldg(beta1_power_ptr)));
+  for (int64 i = begin + threadIdx.x; i < end; i += blockDim.x) {
+    const U g = static_cast<U>(ldg(grad + i));
+    U m_i = static_cast<U>(m[i]);
+    U v_i = static_cast<U>(v[i]);
+    m_i += (g - m_i) * (one - beta1);
+    v_i += (g * g - v_i) * (one - beta2);
+    const U step = use_nesterov ? g * (one - beta1) + beta1 * m_i : m_i;
+    m[i] = static_cast<T>(m_i);
+    v[i] = static_cast<T>(v_i);
+    var[i] = static_cast<T>(static_cast<U>(var[i]) -
+                            step * alpha / (sqrt(v_i) + epsilon));
+  }
+}
+
+}  // namespace
+
+namespace functor {
+template <typename T>
+struct MultiApplyMomentum<GPUDevice, T> {
+  void operator()(const GPUDevice& d, const std::vector<T*>& var,
+                  const std::vector<T*>& accum,
+                  const std::vector<const T*>& grad,
+                  const std::vector<int64>& sizes,
+                  typename TTypes<T>::ConstScalar lr,
+                  typename TTypes<T>::ConstScalar momentum,
+                  bool use_nesterov) {
+    auto launch = [&](const MultiApplyPack<T, 2>& pack, int num_blocks) {
+      MultiApplyMomentumKernel<T>
+          <<<num_blocks, kMultiApplyThreads, 0, d.stream()>>>(
+              pack, lr.data(), momentum.data(), use_nesterov);
+    };
+    LaunchMultiApply<T, 2>({{&var, &accum}}, grad, sizes, launch);
+  }
+};
+
+template <typename T>
+struct MultiApplyAdam<GPUDevice, T> {
+  void operator()(const GPUDevice& d, const std::vector<T*>& var,
+                  const std::vector<T*>& m, const std::vector<T*>& v,
+                  const std::vector<const T*>& grad,
+                  const std::vector<int64>& sizes,
+                  typename TTypes<T>::ConstScalar beta1_power,
+                  typename TTypes<T>::ConstScalar beta2_power,
+                  typename TTypes<T>::ConstScalar lr,
+                  typename TTypes<T>::ConstScalar beta1,
+                  typename TTypes<T>::ConstScalar beta2,
+                  typename TTypes<T>::ConstScalar epsilon,
+                  bool use_nesterov) {
+    auto launch = [&](const MultiApplyPack<T, 3>& pack, int num_blocks) {
+      MultiApplyAdamKernel<T>
+          <<<num_blocks, kMultiApplyThreads, 0, d.stream()>>>(
+              pack, beta1_power.data(), beta2_power.data(), lr.data(),
+              beta1.data(), beta2.data(), epsilon.data(), use_nesterov);
+    };
+    LaunchMultiApply<T, 3>({{&var, &m, &v}}, grad, sizes, launch);
+  }
+};
+}  // namespace functor
+
 template struct functor::ApplyGradientDescent<GPUDevice, Eigen::half>;
 template struct functor::ApplyGradientDescent<GPUDevice, float>;
 template struct functor::ApplyGradientDescent<GPUDevice, double>;
@@ -306,6 +498,14 @@ template struct functor::ApplyAdam<GPUDevice, Eigen::half>;
 template struct functor::ApplyAdam<GPUDevice, float>;
 template struct functor::ApplyAdam<GPUDevice, double>;
 
+template struct functor::MultiApplyMomentum<GPUDevice, Eigen::half>;
+template struct functor::MultiApplyMomentum<GPUDevice, float>;
+template struct functor::MultiApplyMomentum<GPUDevice, double>;
+
+template struct functor::MultiApplyAdam<GPUDevice, Eigen::half>;
+template struct functor::MultiApplyAdam<GPUDevice, float>;
+template struct functor::MultiApplyAdam<GPUDevice, double>;
+
 template struct functor::ApplyAdaMax<GPUDevice, Eigen::half>;
 template struct functor::ApplyAdaMax<GPUDevice, float>;
 template struct functor::ApplyAdaMax<GPUDevice, double>;
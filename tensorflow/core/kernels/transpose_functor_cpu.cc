@@ -15,7 +15,14 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <string.h>
+#include <algorithm>
 #include <complex>
+#include <type_traits>
+
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#endif
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/attr_value.pb.h"
@@ -65,12 +72,271 @@ void TransposeSimple(const CPUDevice& device, const Tensor& in,
   device.parallelFor(in.NumElements(), cost, std::move(transpose_fn));
 }
 
+// Writes the transpose of the 8x8 block at 'src' (with rows 'src_stride'
+// elements apart) to 'dst' (with rows 'dst_stride' elements apart).
+template <typename T>
+inline void Transpose8x8(const T* src, int64 src_stride, T* dst,
+                         int64 dst_stride) {
+  for (int r = 0; r < 8; ++r) {
+    for (int c = 0; c < 8; ++c) {
+      dst[c * dst_stride + r] = src[r * src_stride + c];
+    }
+  }
+}
+
+#if defined(__AVX__)
+// 4-byte elements are moved as floats, which copies their bits unchanged.
+template <>
+inline void Transpose8x8<uint32>(const uint32* src, int64 src_stride,
+                                 uint32* dst, int64 dst_stride) {
+  const float* s = reinterpret_cast<const float*>(src);
+  float* d = reinterpret_cast<float*>(dst);
+  __m256 r0 = _mm256_loadu_ps(s + 0 * src_stride);
+  __m256 r1 = _mm256_loadu_ps(s + 1 * src_stride);
+  __m256 r2 = _mm256_loadu_ps(s + 2 * src_stride);
+  __m256 r3 = _mm256_loadu_ps(s + 3 * src_stride);
+  __m256 r4 = _mm256_loadu_ps(s + 4 * src_stride);
+  __m256 r5 = _mm256_loadu_ps(s + 5 * src_stride);
+  __m256 r6 = _mm256_loadu_ps(s + 6 * src_stride);
+  __m256 r7 = _mm256_loadu_ps(s + 7 * src_stride);
+  // Interleave pairs of rows, then pairs of pairs, within each 128-bit lane.
+  const __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+  const __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+  const __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+  const __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+  const __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+  const __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+  const __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+  const __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+  const __m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  const __m256 u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  const __m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  const __m256 u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  const __m256 u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  const __m256 u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  const __m256 u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  const __m256 u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+  // Swap the 128-bit lanes between the two halves of the block.
+  _mm256_storeu_ps(d + 0 * dst_stride, _mm256_permute2f128_ps(u0, u4, 0x20));
+  _mm256_storeu_ps(d + 1 * dst_stride, _mm256_permute2f128_ps(u1, u5, 0x20));
+  _mm256_storeu_ps(d + 2 * dst_stride, _mm256_permute2f128_ps(u2, u6, 0x20));
+  _mm256_storeu_ps(d + 3 * dst_stride, _mm256_permute2f128_ps(u3, u7, 0x20));
+  _mm256_storeu_ps(d + 4 * dst_stride, _mm256_permute2f128_ps(u0, u4, 0x31));
+  _mm256_storeu_ps(d + 5 * dst_stride, _mm256_permute2f128_ps(u1, u5, 0x31));
+  _mm256_storeu_ps(d + 6 * dst_stride, _mm256_permute2f128_ps(u2, u6, 0x31));
+  _mm256_storeu_ps(d + 7 * dst_stride, _mm256_permute2f128_ps(u3, u7, 0x31));
+}
+#elif defined(__SSE__)
+// 4-byte elements are moved as floats, which copies their bits unchanged.
+template <>
+inline void Transpose8x8<uint32>(const uint32* src, int64 src_stride,
+                                 uint32* dst, int64 dst_stride) {
+  const float* s = reinterpret_cast<const float*>(src);
+  float* d = reinterpret_cast<float*>(dst);
+  for (int r = 0; r < 8; r += 4) {
+    for (int c = 0; c < 8; c += 4) {
+      __m128 r0 = _mm_loadu_ps(s + (r + 0) * src_stride + c);
+      __m128 r1 = _mm_loadu_ps(s + (r + 1) * src_stride + c);
+      __m128 r2 = _mm_loadu_ps(s + (r + 2) * src_stride + c);
+      __m128 r3 = _mm_loadu_ps(s + (r + 3) * src_stride + c);
+      _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+      _mm_storeu_ps(d + (c + 0) * dst_stride + r, r0);
+      _mm_storeu_ps(d + (c + 1) * dst_stride + r, r1);
+      _mm_storeu_ps(d + (c + 2) * dst_stride + r, r2);
+      _mm_storeu_ps(d + (c + 3) * dst_stride + r, r3);
+    }
+  }
+}
+#endif
+
+// Transposes the [rows, cols] matrix at 'src' (with rows 'src_stride'
+// elements apart) into the [cols, rows] matrix at 'dst' (with rows
+// 'dst_stride' elements apart), in 8x8 blocks.
+template <typename T>
+void TransposeBlock(const T* src, int64 src_stride, int64 rows, int64 cols,
+                    T* dst, int64 dst_stride) {
+  const int64 rows8 = rows & ~int64{7};
+  const int64 cols8 = cols & ~int64{7};
+  for (int64 r = 0; r < rows8; r += 8) {
+    for (int64 c = 0; c < cols8; c += 8) {
+      Transpose8x8<T>(src + r * src_stride + c, src_stride,
+                      dst + c * dst_stride + r, dst_stride);
+    }
+    for (int64 c = cols8; c < cols; ++c) {
+      for (int64 i = r; i < r + 8; ++i) {
+        dst[c * dst_stride + i] = src[i * src_stride + c];
+      }
+    }
+  }
+  for (int64 r = rows8; r < rows; ++r) {
+    for (int64 c = 0; c < cols; ++c) {
+      dst[c * dst_stride + r] = src[r * src_stride + c];
+    }
+  }
+}
+
+// Transposes 'in' into 'out' by moving cache-sized tiles, for the element
+// types that are copied bit by bit. Returns false, without writing to 'out',
+// for permutations it does not handle well; the Eigen shuffle is used then.
+//
+// The singleton dimensions of 'in' are dropped, and dimensions that stay
+// adjacent in 'out' are merged (see ReduceTransposeDimensions). If the
+// innermost dimension stays innermost, the output is copied in contiguous
+// rows. Otherwise, the input dimension that becomes innermost and the
+// innermost input dimension form a matrix, which is transposed in tiles of
+// 'kTile' x 'kTile' elements that fit in the L1 cache, with 8x8 SIMD
+// kernels. Rows or tiles are split across the threads of 'device'.
+template <typename T>
+bool TransposeTiled(const CPUDevice& device, const Tensor& in,
+                    const gtl::ArraySlice<int32> perm, Tensor* out) {
+  const int ndims = in.dims();
+  // Drop the singleton dimensions.
+  gtl::InlinedVector<int32, 8> new_index(ndims, -1);
+  TensorShape shape;
+  for (int i = 0; i < ndims; ++i) {
+    if (in.dim_size(i) != 1) {
+      new_index[i] = shape.dims();
+      shape.AddDim(in.dim_size(i));
+    }
+  }
+  internal::TransposePermsVec shape_perm;
+  for (int i = 0; i < ndims; ++i) {
+    if (new_index[perm[i]] >= 0) shape_perm.push_back(new_index[perm[i]]);
+  }
+
+  const T* src = reinterpret_cast<const T*>(in.tensor_data().data());
+  T* dst = reinterpret_cast<T*>(const_cast<char*>(out->tensor_data().data()));
+  const int64 num_elements = in.NumElements();
+
+  internal::TransposePermsVec positions;
+  internal::TransposeDimsVec dims;
+  if (shape.dims() > 1) {
+    internal::ReduceTransposeDimensions(shape, shape_perm, &positions, &dims);
+  }
+  const int n = dims.size();
+  // ReduceTransposeDimensions returns the output position of each input
+  // dimension; 'p' is the input dimension of each output dimension.
+  internal::TransposePermsVec p(n);
+  for (int i = 0; i < n; ++i) p[positions[i]] = i;
+  if (n <= 1) {
+    // The permutation only moves singleton dimensions: copy the data.
+    device.parallelFor(num_elements,
+                       Eigen::TensorOpCost(sizeof(T), sizeof(T), 0),
+                       [src, dst](int64 begin, int64 end) {
+                         memcpy(dst + begin, src + begin,
+                                (end - begin) * sizeof(T));
+                       });
+    return true;
+  }
+
+  gtl::InlinedVector<int64, 8> in_strides(n, 1);
+  gtl::InlinedVector<int64, 8> out_dims(n);
+  gtl::InlinedVector<int64, 8> out_strides(n, 1);
+  for (int i = n - 2; i >= 0; --i) {
+    in_strides[i] = in_strides[i + 1] * dims[i + 1];
+  }
+  for (int i = 0; i < n; ++i) out_dims[i] = dims[p[i]];
+  for (int i = n - 2; i >= 0; --i) {
+    out_strides[i] = out_strides[i + 1] * out_dims[i + 1];
+  }
+
+  if (p[n - 1] == n - 1) {
+    // The output is made of contiguous rows of the input.
+    const int64 row_size = dims[n - 1];
+    if (row_size * sizeof(T) < 64) return false;
+    auto copy_rows = [=, &in_strides, &out_dims, &p](int64 begin, int64 end) {
+      for (int64 row = begin; row < end; ++row) {
+        int64 src_offset = 0;
+        int64 t = row;
+        for (int i = n - 2; i >= 0; --i) {
+          src_offset += (t % out_dims[i]) * in_strides[p[i]];
+          t /= out_dims[i];
+        }
+        memcpy(dst + row * row_size, src + src_offset, row_size * sizeof(T));
+      }
+    };
+    device.parallelFor(
+        num_elements / row_size,
+        Eigen::TensorOpCost(row_size * sizeof(T), row_size * sizeof(T),
+                            n * Eigen::TensorOpCost::DivCost<int64>()),
+        std::move(copy_rows));
+    return true;
+  }
+
+  // Transpose the matrix of input dimensions 'p[n - 1]' (rows) and 'n - 1'
+  // (columns), for each index of the other dimensions.
+  const int row_dim = p[n - 1];
+  const int col_out_dim =
+      std::find(p.begin(), p.end(), n - 1) - p.begin();
+  const int64 rows = dims[row_dim];
+  const int64 cols = dims[n - 1];
+  if (rows < 8 || cols < 8) return false;
+  const int64 src_stride = in_strides[row_dim];
+  const int64 dst_stride = out_strides[col_out_dim];
+
+  // A tile of the input and its transpose fill about half of a 32KB L1 cache.
+  const int64 kTile = sizeof(T) <= 4 ? 64 : 32;
+  const int64 row_tiles = (rows + kTile - 1) / kTile;
+  const int64 col_tiles = (cols + kTile - 1) / kTile;
+  const int64 tiles_per_matrix = row_tiles * col_tiles;
+  const int64 num_matrices = num_elements / (rows * cols);
+
+  auto transpose_tiles = [=, &in_strides, &out_dims, &out_strides, &p](
+                             int64 begin, int64 end) {
+    for (int64 tile = begin; tile < end; ++tile) {
+      int64 t = tile / tiles_per_matrix;
+      const int64 tile_in_matrix = tile % tiles_per_matrix;
+      const int64 r0 = (tile_in_matrix / col_tiles) * kTile;
+      const int64 c0 = (tile_in_matrix % col_tiles) * kTile;
+      // Offsets of the matrix: the output dimensions other than the two of
+      // the matrix, innermost first.
+      int64 src_offset = r0 * src_stride + c0;
+      int64 dst_offset = c0 * dst_stride + r0;
+      for (int i = n - 2; i >= 0; --i) {
+        if (i == col_out_dim) continue;
+        const int64 index = t % out_dims[i];
+        t /= out_dims[i];
+        src_offset += index * in_strides[p[i]];
+        dst_offset += index * out_strides[i];
+      }
+      TransposeBlock<T>(src + src_offset, src_stride,
+                        std::min(kTile, rows - r0), std::min(kTile, cols - c0),
+                        dst + dst_offset, dst_stride);
+    }
+  };
+  device.parallelFor(num_matrices * tiles_per_matrix,
+                     Eigen::TensorOpCost(kTile * kTile * sizeof(T),
+                                         kTile * kTile * sizeof(T),
+                                         kTile * kTile),
+                     std::move(transpose_tiles));
+  return true;
+}
+
+// The unsigned integer types stand for all the types that are copied bit by
+// bit (see DoTransposeImpl), which are the ones TransposeTiled handles.
+template <typename T>
+typename std::enable_if<std::is_unsigned<T>::value, bool>::type
+MaybeTransposeTiled(const CPUDevice& device, const Tensor& in,
+                    const gtl::ArraySlice<int32> perm, Tensor* out) {
+  return TransposeTiled<T>(device, in, perm, out);
+}
+
+template <typename T>
+typename std::enable_if<!std::is_unsigned<T>::value, bool>::type
+MaybeTransposeTiled(const CPUDevice& device, const Tensor& in,
+                    const gtl::ArraySlice<int32> perm, Tensor* out) {
+  return false;
+}
+
 }  // namespace
 
 template <typename T, bool conjugate>
 struct Transpose<CPUDevice, T, conjugate> {
   static void run(const CPUDevice& d, const Tensor& in,
                   const gtl::ArraySlice<int32> perm, Tensor* out) {
+    if (!conjugate && MaybeTransposeTiled<T>(d, in, perm, out)) {
+      return;
+    }
     switch (in.dims()) {
       case 2:
         internal::TransposeUsingEigen<CPUDevice, T, 2>(d, in, perm, conjugate,
@@ -13,9 +13,17 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#define EIGEN_USE_THREADS
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/common_runtime/eigen_thread_pool.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/kernels/transpose_functor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -130,4 +138,68 @@ TEST_F(TransposeUtilTest, NonSingletonDimensionAlignment) {
                                                      {0, 1, 2, 5, 4, 3}));
 }
 
+template <typename T>
+class TransposeCpuTest : public ::testing::Test {
+ protected:
+  // Checks DoTranspose of a tensor of 'shape' against an element by element
+  // transpose.
+  void TestTranspose(const TensorShape& shape,
+                     const std::vector<int32>& perm) {
+    Tensor in(DataTypeToEnum<T>::value, shape);
+    auto in_flat = in.flat<T>();
+    for (int64 i = 0; i < in.NumElements(); ++i) {
+      in_flat(i) = static_cast<T>(i % 97);
+    }
+    TensorShape out_shape;
+    for (int32 d : perm) out_shape.AddDim(shape.dim_size(d));
+    Tensor out(DataTypeToEnum<T>::value, out_shape);
+
+    thread::ThreadPool pool(Env::Default(), "test", 4);
+    EigenThreadPoolWrapper wrapper(&pool);
+    Eigen::ThreadPoolDevice device(&wrapper, 4);
+    TF_ASSERT_OK(DoTranspose(device, in, perm, &out));
+
+    Tensor expected(DataTypeToEnum<T>::value, out_shape);
+    const auto in_strides = ComputeStride<int64>(shape);
+    const auto out_strides = ComputeStride<int64>(out_shape);
+    for (int64 o = 0; o < expected.NumElements(); ++o) {
+      int64 i = 0;
+      int64 t = o;
+      for (int d = 0; d < perm.size(); ++d) {
+        i += (t / out_strides[d]) * in_strides[perm[d]];
+        t %= out_strides[d];
+      }
+      expected.flat<T>()(o) = in_flat(i);
+    }
+    test::ExpectTensorEqual<T>(expected, out);
+  }
+};
+
+typedef ::testing::Types<int8, int16, float, double> TransposeTypes;
+TYPED_TEST_CASE(TransposeCpuTest, TransposeTypes);
+
+TYPED_TEST(TransposeCpuTest, Matrix) {
+  this->TestTranspose({37, 91}, {1, 0});
+  this->TestTranspose({200, 300}, {1, 0});
+}
+
+TYPED_TEST(TransposeCpuTest, NHWCToNCHW) {
+  this->TestTranspose({2, 17, 19, 40}, {0, 3, 1, 2});
+  this->TestTranspose({2, 40, 17, 19}, {0, 2, 3, 1});
+  this->TestTranspose({2, 5, 7, 3}, {0, 3, 1, 2});
+}
+
+TYPED_TEST(TransposeCpuTest, HigherRank) {
+  this->TestTranspose({9, 10, 11, 12, 13}, {4, 2, 0, 3, 1});
+  this->TestTranspose({2, 3, 4, 5, 16}, {3, 4, 1, 2, 0});
+  // The innermost dimension stays innermost.
+  this->TestTranspose({4, 5, 6, 7, 32}, {1, 0, 3, 2, 4});
+}
+
+TYPED_TEST(TransposeCpuTest, SingletonDimensions) {
+  this->TestTranspose({1, 64, 1, 65}, {3, 2, 1, 0});
+  this->TestTranspose({3, 1, 4}, {1, 0, 2});
+  this->TestTranspose({1, 30, 1}, {2, 1, 0});
+}
+
 }  // namespace tensorflow
@@ -13,9 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -24,11 +26,171 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
+namespace {
+
+// Vectors with at least this many elements are deduplicated in parallel.
+constexpr int64 kMinParallelUniqueSize = 1 << 15;
+
+// Mixes the bits of a hash before it picks a shard, as std::hash is the
+// identity for integers.
+inline uint64 MixHash(uint64 h) { return (h * 0x9E3779B97F4A7C15ULL) >> 32; }
+
+// Computes unique(input) for a large vector, with the same outputs as the
+// serial implementation: the unique values are numbered in order of first
+// occurrence. The elements are sharded by hash so that every shard owns a
+// disjoint set of values and can be deduplicated by one thread:
+//
+// 1. Every chunk of the input computes the shard of its elements and
+//    counts them per shard.
+// 2. The element indices are bucketed by shard with a counting sort,
+//    keeping them in input order within every shard.
+// 3. Every shard assigns local ids with its own hash map and marks the
+//    first occurrence of every value.
+// 4. A prefix sum over the marks numbers the first occurrences globally,
+//    which yields the final id of every local id.
+//
+// Allocates output 0 (and output 2 with the counts, if the op has it) and
+// fills idx_vec.
+template <typename T, typename TIndex>
+Status ParallelUnique(OpKernelContext* context, const Tensor& input,
+                      typename TTypes<TIndex>::Vec idx_vec, int64* uniq_size) {
+  auto Tin = input.flat<T>();
+  const int32 N = static_cast<int32>(Tin.size());
+  const DeviceBase::CpuWorkerThreads* worker_threads =
+      context->device()->tensorflow_cpu_worker_threads();
+  const int num_shards = std::min(64, worker_threads->num_threads);
+  // Every unit of work below is a chunk or a shard, so give Shard() a cost
+  // that lets it run each of them on its own thread.
+  const int64 cost_per_unit = N;
+  auto parallel_for = [&](const std::function<void(int)>& fn) {
+    Shard(num_shards, worker_threads->workers, num_shards, cost_per_unit,
+          [&fn](int64 start, int64 limit) {
+            for (int64 i = start; i < limit; ++i) {
+              fn(static_cast<int>(i));
+            }
+          });
+  };
+  auto chunk_start = [N, num_shards](int chunk) {
+    return static_cast<int32>(static_cast<int64>(N) * chunk / num_shards);
+  };
+
+  // Step 1. `marks` holds the shard of every element until step 3.
+  std::vector<int32> marks(N);
+  std::vector<int32> offsets(num_shards * num_shards, 0);
+  parallel_for([&](int chunk) {
+    int32* counts = &offsets[chunk * num_shards];
+    for (int32 i = chunk_start(chunk); i < chunk_start(chunk + 1); ++i) {
+      const int32 shard = MixHash(std::hash<T>{}(Tin(i))) % num_shards;
+      marks[i] = shard;
+      ++counts[shard];
+    }
+  });
+
+  // Step 2. After the exclusive scan offsets[chunk * num_shards + shard] is
+  // where the chunk's first element of the shard goes, the shards being laid
+  // out one after the other.
+  std::vector<int32> shard_start(num_shards + 1, 0);
+  {
+    int32 total = 0;
+    for (int shard = 0; shard < num_shards; ++shard) {
+      shard_start[shard] = total;
+      for (int chunk = 0; chunk < num_shards; ++chunk) {
+        const int32 count = offsets[chunk * num_shards + shard];
+        offsets[chunk * num_shards + shard] = total;
+        total += count;
+      }
+    }
+    shard_start[num_shards] = total;
+  }
+  std::vector<int32> order(N);
+  parallel_for([&](int chunk) {
+    int32* next = &offsets[chunk * num_shards];
+    for (int32 i = chunk_start(chunk); i < chunk_start(chunk + 1); ++i) {
+      order[next[marks[i]]++] = i;
+    }
+  });
+
+  // Step 3. local_ids[k] is the local id of element order[k]. The first
+  // occurrences are marked with -1.
+  std::vector<int32> local_ids(N);
+  std::vector<std::vector<int32>> first_occurrences(num_shards);
+  std::vector<std::vector<TIndex>> shard_counts(num_shards);
+  parallel_for([&](int shard) {
+    std::unordered_map<T, int32> uniq;
+    uniq.reserve(2 * (shard_start[shard + 1] - shard_start[shard]));
+    std::vector<int32>& firsts = first_occurrences[shard];
+    std::vector<TIndex>& counts = shard_counts[shard];
+    for (int32 k = shard_start[shard]; k < shard_start[shard + 1]; ++k) {
+      const int32 i = order[k];
+      auto it = uniq.insert(std::make_pair(Tin(i), firsts.size()));
+      if (it.second) {
+        firsts.push_back(i);
+        counts.push_back(0);
+        marks[i] = -1;
+      }
+      local_ids[k] = it.first->second;
+      ++counts[it.first->second];
+    }
+  });
+
+  // Step 4. Overwrites the marks of the first occurrences with their ids.
+  std::vector<int32> chunk_uniques(num_shards + 1, 0);
+  parallel_for([&](int chunk) {
+    int32 count = 0;
+    for (int32 i = chunk_start(chunk); i < chunk_start(chunk + 1); ++i) {
+      count += marks[i] < 0;
+    }
+    chunk_uniques[chunk + 1] = count;
+  });
+  for (int chunk = 0; chunk < num_shards; ++chunk) {
+    chunk_uniques[chunk + 1] += chunk_uniques[chunk];
+  }
+  parallel_for([&](int chunk) {
+    int32 id = chunk_uniques[chunk];
+    for (int32 i = chunk_start(chunk); i < chunk_start(chunk + 1); ++i) {
+      if (marks[i] < 0) {
+        marks[i] = id++;
+      }
+    }
+  });
+
+  *uniq_size = chunk_uniques[num_shards];
+  TensorShape output_shape(input.shape());
+  output_shape.set_dim(0, *uniq_size);
+  Tensor* output = nullptr;
+  TF_RETURN_IF_ERROR(context->allocate_output(0, output_shape, &output));
+  auto Tout = output->flat<T>();
+  Tensor* count_output = nullptr;
+  if (context->num_outputs() > 2) {
+    TF_RETURN_IF_ERROR(context->allocate_output(
+        2, TensorShape({*uniq_size}), &count_output));
+  }
+  parallel_for([&](int shard) {
+    // Turns the first occurrences into the final ids of the local ids.
+    std::vector<int32>& ids = first_occurrences[shard];
+    for (size_t u = 0; u < ids.size(); ++u) {
+      const int32 i = ids[u];
+      ids[u] = marks[i];
+      Tout(ids[u]) = Tin(i);
+      if (count_output != nullptr) {
+        count_output->vec<TIndex>()(ids[u]) = shard_counts[shard][u];
+      }
+    }
+    for (int32 k = shard_start[shard]; k < shard_start[shard + 1]; ++k) {
+      idx_vec(order[k]) = ids[local_ids[k]];
+    }
+  });
+  return Status::OK();
+}
+
+}  // namespace
+
 template <typename T, typename TIndex>
 class UniqueOp : public OpKernel {
  public:
@@ -99,7 +261,14 @@ class UniqueOp : public OpKernel {
     auto idx_vec = idx->template vec<TIndex>();
 
     int64 uniq_size;
-    if (new_sizes[0] == 1 && new_sizes[2] == 1) {
+    if (new_sizes[0] == 1 && new_sizes[2] == 1 &&
+        new_sizes[1] >= kMinParallelUniqueSize &&
+        context->device()->tensorflow_cpu_worker_threads()->num_threads > 1) {
+      OP_REQUIRES_OK(context, ParallelUnique<T, TIndex>(context, input, idx_vec,
+                                                        &uniq_size));
+      // ParallelUnique computes the counts along with the ids.
+      return;
+    } else if (new_sizes[0] == 1 && new_sizes[2] == 1) {
       // Specialized and faster implementation when unique is run over single
       // elements. Here we put T directly into the map rather than ints pointing
       // to them as in the general case.
@@ -239,10 +408,12 @@ TF_CALL_REAL_NUMBER_TYPES(REGISTER_UNIQUE);
 REGISTER_UNIQUE(string)
 #undef REGISTER_UNIQUE
 
+#if !GOOGLE_CUDA
 // Fake integer GPU kernels so that the use of Unique in optimizers (to
 // de-duplicate sparse gradient indices) does not conflict with gradients being
 // located on a GPU. These kernels run on the CPU, their inputs and outputs
-// residing in host (not GPU) memory.
+// residing in host (not GPU) memory. CUDA builds have real GPU kernels, in
+// unique_op_gpu.cu.cc.
 REGISTER_KERNEL_BUILDER(Name("Unique")
                             .Device(DEVICE_GPU)
                             .TypeConstraint<int32>("T")
@@ -275,6 +446,7 @@ REGISTER_KERNEL_BUILDER(Name("Unique")
                             .HostMemory("y")
                             .HostMemory("idx"),
                         UniqueOp<int64, int64>);
+#endif  // !GOOGLE_CUDA
 
 #ifdef TENSORFLOW_USE_SYCL
 REGISTER_KERNEL_BUILDER(Name("Unique")
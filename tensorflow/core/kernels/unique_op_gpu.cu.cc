@@ -0,0 +1,331 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// The algorithm for Unique and UniqueWithCounts on GPU is as follows:
+//
+// 1. Radix-sort the input x together with the indices 0, ..., N - 1. Radix
+//    sort is stable, so the first element of every run of equal keys is the
+//    first occurrence of the value in x.
+// 2. Mark the run heads, both in sorted order (heads) and at the positions
+//    of the first occurrences in x (first_mask).
+// 3. An inclusive sum of heads numbers the runs in sorted order, and an
+//    exclusive sum of first_mask numbers the first occurrences in x order.
+//    The latter are the output ids: like on CPU, the unique values are
+//    numbered in order of first occurrence.
+// 4. Scatter the output id of every run back to the positions in x to
+//    produce idx.
+// 5. Once the number of runs has been copied to the host, allocate y and
+//    count and write the value and length of every run.
+
+#if GOOGLE_CUDA
+
+#define EIGEN_USE_GPU
+
+#include "third_party/cub/device/device_radix_sort.cuh"
+#include "third_party/cub/device/device_scan.cuh"
+#include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/cuda.h"
+#include "tensorflow/core/util/cuda_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+using stream_executor::cuda::ScopedActivateExecutorContext;
+
+namespace {
+
+__global__ void RangeInitKernel(const int32 size, int32* out) {
+  CUDA_1D_KERNEL_LOOP(i, size) { out[i] = i; }
+}
+
+template <typename T>
+__global__ void MarkFirstOccurrencesKernel(const int32 size,
+                                           const T* sorted_keys,
+                                           const int32* sorted_indices,
+                                           int32* heads, int32* first_mask) {
+  CUDA_1D_KERNEL_LOOP(i, size) {
+    const int32 head = i == 0 || sorted_keys[i] != sorted_keys[i - 1];
+    heads[i] = head;
+    first_mask[ldg(sorted_indices + i)] = head;
+  }
+}
+
+// Records the output id and the sorted position of the head of every run.
+__global__ void RunHeadsKernel(const int32 size, const int32* heads,
+                               const int32* run_ids,
+                               const int32* sorted_indices, const int32* ranks,
+                               int32* run_output_ids, int32* run_starts) {
+  CUDA_1D_KERNEL_LOOP(i, size) {
+    if (ldg(heads + i)) {
+      const int32 run = ldg(run_ids + i) - 1;
+      run_output_ids[run] = ldg(ranks + ldg(sorted_indices + i));
+      run_starts[run] = i;
+    }
+  }
+}
+
+template <typename TIndex>
+__global__ void ScatterIdxKernel(const int32 size, const int32* sorted_indices,
+                                 const int32* run_ids,
+                                 const int32* run_output_ids, TIndex* idx) {
+  CUDA_1D_KERNEL_LOOP(i, size) {
+    idx[ldg(sorted_indices + i)] =
+        ldg(run_output_ids + ldg(run_ids + i) - 1);
+  }
+}
+
+// Writes the value of every run to y and, if count is not null, its length
+// to count.
+template <typename T, typename TIndex>
+__global__ void RunOutputsKernel(const int32 size, const int32 num_runs,
+                                 const T* sorted_keys, const int32* heads,
+                                 const int32* run_ids,
+                                 const int32* run_output_ids,
+                                 const int32* run_starts, T* y,
+                                 TIndex* count) {
+  CUDA_1D_KERNEL_LOOP(i, size) {
+    if (ldg(heads + i)) {
+      const int32 run = ldg(run_ids + i) - 1;
+      const int32 out = ldg(run_output_ids + run);
+      y[out] = sorted_keys[i];
+      if (count != nullptr) {
+        const int32 end = run + 1 < num_runs ? ldg(run_starts + run + 1) : size;
+        count[out] = end - i;
+      }
+    }
+  }
+}
+
+// Runs a cub device-wide algorithm: `fn(temp_storage, temp_storage_bytes)`
+// is called once to size the temporary storage and once to launch it.
+template <typename CubFn>
+Status RunCub(OpKernelContext* c, const char* name, CubFn fn) {
+  size_t temp_storage_bytes = 0;
+  cudaError_t err = fn(nullptr, temp_storage_bytes);
+  if (err != cudaSuccess) {
+    return errors::Internal("UniqueOp: could not launch ", name,
+                            " to calculate temp_storage_bytes, status: ",
+                            cudaGetErrorString(err));
+  }
+  Tensor temp_storage;
+  TF_RETURN_IF_ERROR(c->allocate_temp(
+      DT_INT8, TensorShape({static_cast<int64>(temp_storage_bytes)}),
+      &temp_storage));
+  err = fn(temp_storage.flat<int8>().data(), temp_storage_bytes);
+  if (err != cudaSuccess) {
+    return errors::Internal("UniqueOp: could not launch ", name,
+                            ", temp_storage_bytes: ", temp_storage_bytes,
+                            ", status: ", cudaGetErrorString(err));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+// The memory cost on GPU is the input plus about 9N 32-bit words for the
+// temporaries, including the radix sort storage, plus the outputs.
+template <typename T, typename TIndex>
+class UniqueOpGPU : public AsyncOpKernel {
+ public:
+  explicit UniqueOpGPU(OpKernelConstruction* c) : AsyncOpKernel(c) {}
+
+  void ComputeAsync(OpKernelContext* c, DoneCallback done) override {
+    const Tensor& input = c->input(0);
+    OP_REQUIRES_ASYNC(c, TensorShapeUtils::IsVector(input.shape()),
+                      errors::InvalidArgument("unique expects a 1D vector."),
+                      done);
+    OP_REQUIRES_ASYNC(
+        c, input.NumElements() <= std::numeric_limits<int32>::max(),
+        errors::InvalidArgument(
+            "unique does not support input tensors larger than ",
+            std::numeric_limits<int32>::max(), " elements"),
+        done);
+    const int32 N = input.NumElements();
+    const bool with_counts = num_outputs() > 2;
+
+    Tensor* idx = nullptr;
+    OP_REQUIRES_OK_ASYNC(c, c->allocate_output(1, TensorShape({N}), &idx),
+                         done);
+    if (N == 0) {
+      Tensor* unused = nullptr;
+      OP_REQUIRES_OK_ASYNC(c, c->allocate_output(0, TensorShape({0}), &unused),
+                           done);
+      if (with_counts) {
+        OP_REQUIRES_OK_ASYNC(
+            c, c->allocate_output(2, TensorShape({0}), &unused), done);
+      }
+      done();
+      return;
+    }
+
+    const GPUDevice& d = c->eigen_device<GPUDevice>();
+    const cudaStream_t& cu_stream = GetCudaStream(c);
+
+    Tensor sorted_keys;
+    OP_REQUIRES_OK_ASYNC(c,
+                         c->allocate_temp(DataTypeToEnum<T>::value,
+                                          TensorShape({N}), &sorted_keys),
+                         done);
+    Tensor int32_temps[7];
+    for (Tensor& temp : int32_temps) {
+      OP_REQUIRES_OK_ASYNC(
+          c, c->allocate_temp(DT_INT32, TensorShape({N}), &temp), done);
+    }
+    int32* indices = int32_temps[0].flat<int32>().data();
+    int32* sorted_indices = int32_temps[1].flat<int32>().data();
+    int32* heads = int32_temps[2].flat<int32>().data();
+    int32* first_mask = int32_temps[3].flat<int32>().data();
+    int32* run_ids = int32_temps[4].flat<int32>().data();
+    // The ranks are only needed until the run heads are recorded, so the
+    // buffer of the unsorted indices is reused for them.
+    int32* ranks = indices;
+    int32* run_output_ids = int32_temps[5].flat<int32>().data();
+    int32* run_starts = int32_temps[6].flat<int32>().data();
+    const T* keys = input.flat<T>().data();
+    T* sorted_keys_ptr = sorted_keys.flat<T>().data();
+
+    CudaLaunchConfig config = GetCudaLaunchConfig(N, d);
+    RangeInitKernel<<<config.block_count, config.thread_per_block, 0,
+                      d.stream()>>>(N, indices);
+
+    OP_REQUIRES_OK_ASYNC(
+        c,
+        RunCub(c, "cub::DeviceRadixSort::SortPairs",
+               [&](void* temp_storage, size_t& temp_storage_bytes) {
+                 return cub::DeviceRadixSort::SortPairs(
+                     temp_storage, temp_storage_bytes, keys, sorted_keys_ptr,
+                     indices, sorted_indices, N, 0, sizeof(T) * 8, cu_stream);
+               }),
+        done);
+    MarkFirstOccurrencesKernel<T>
+        <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+            N, sorted_keys_ptr, sorted_indices, heads, first_mask);
+    OP_REQUIRES_OK_ASYNC(
+        c,
+        RunCub(c, "cub::DeviceScan::InclusiveSum",
+               [&](void* temp_storage, size_t& temp_storage_bytes) {
+                 return cub::DeviceScan::InclusiveSum(temp_storage,
+                                                      temp_storage_bytes, heads,
+                                                      run_ids, N, cu_stream);
+               }),
+        done);
+    OP_REQUIRES_OK_ASYNC(
+        c,
+        RunCub(c, "cub::DeviceScan::ExclusiveSum",
+               [&](void* temp_storage, size_t& temp_storage_bytes) {
+                 return cub::DeviceScan::ExclusiveSum(
+                     temp_storage, temp_storage_bytes, first_mask, ranks, N,
+                     cu_stream);
+               }),
+        done);
+    RunHeadsKernel<<<config.block_count, config.thread_per_block, 0,
+                     d.stream()>>>(N, heads, run_ids, sorted_indices, ranks,
+                                   run_output_ids, run_starts);
+    ScatterIdxKernel<TIndex>
+        <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+            N, sorted_indices, run_ids, run_output_ids,
+            idx->flat<TIndex>().data());
+
+    // The last run id is the number of unique values, which is needed on the
+    // host to allocate y and count.
+    auto* stream = c->op_device_context()->stream();
+    OP_REQUIRES_ASYNC(c, stream, errors::Internal("No GPU stream available."),
+                      done);
+    Tensor num_runs_host;
+    AllocatorAttributes alloc_attr;
+    alloc_attr.set_on_host(true);
+    alloc_attr.set_gpu_compatible(true);
+    OP_REQUIRES_OK_ASYNC(c,
+                         c->allocate_temp(DT_INT32, TensorShape({}),
+                                          &num_runs_host, alloc_attr),
+                         done);
+    se::DeviceMemoryBase num_runs_ptr(run_ids + N - 1, sizeof(int32));
+    OP_REQUIRES_ASYNC(
+        c,
+        stream
+            ->ThenMemcpy(num_runs_host.scalar<int32>().data(), num_runs_ptr,
+                         sizeof(int32))
+            .ok(),
+        errors::Internal("UniqueOp: failed to copy the number of unique "
+                         "values from device"),
+        done);
+
+    // The captured tensors keep the temporaries alive until the callback.
+    Tensor heads_t = int32_temps[2];
+    Tensor run_ids_t = int32_temps[4];
+    Tensor run_output_ids_t = int32_temps[5];
+    Tensor run_starts_t = int32_temps[6];
+    auto create_outputs = [c, N, with_counts, num_runs_host, sorted_keys,
+                           heads_t, run_ids_t, run_output_ids_t, run_starts_t,
+                           done]() {
+      auto stream = c->op_device_context()->stream();
+      ScopedActivateExecutorContext scoped_activation{stream->parent()};
+
+      const int32 num_runs = num_runs_host.scalar<int32>()();
+      Tensor* y = nullptr;
+      OP_REQUIRES_OK_ASYNC(
+          c, c->allocate_output(0, TensorShape({num_runs}), &y), done);
+      TIndex* count_ptr = nullptr;
+      if (with_counts) {
+        Tensor* count = nullptr;
+        OP_REQUIRES_OK_ASYNC(
+            c, c->allocate_output(2, TensorShape({num_runs}), &count), done);
+        count_ptr = count->flat<TIndex>().data();
+      }
+      const GPUDevice& d = c->eigen_device<GPUDevice>();
+      CudaLaunchConfig config = GetCudaLaunchConfig(N, d);
+      RunOutputsKernel<T, TIndex>
+          <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+              N, num_runs, sorted_keys.flat<T>().data(),
+              heads_t.flat<int32>().data(), run_ids_t.flat<int32>().data(),
+              run_output_ids_t.flat<int32>().data(),
+              run_starts_t.flat<int32>().data(), y->flat<T>().data(),
+              count_ptr);
+      done();
+    };
+    c->device()->tensorflow_gpu_device_info()->event_mgr->ThenExecute(
+        stream, create_outputs);
+  }
+};
+
+#define REGISTER_UNIQUE_GPU_FULL(type, index_type)                    \
+  REGISTER_KERNEL_BUILDER(Name("Unique")                              \
+                              .Device(DEVICE_GPU)                     \
+                              .TypeConstraint<type>("T")              \
+                              .TypeConstraint<index_type>("out_idx"), \
+                          UniqueOpGPU<type, index_type>);             \
+  REGISTER_KERNEL_BUILDER(Name("UniqueWithCounts")                    \
+                              .Device(DEVICE_GPU)                     \
+                              .TypeConstraint<type>("T")              \
+                              .TypeConstraint<index_type>("out_idx"), \
+                          UniqueOpGPU<type, index_type>)
+
+#define REGISTER_UNIQUE_GPU(type)            \
+  REGISTER_UNIQUE_GPU_FULL(type, int32); \
+  REGISTER_UNIQUE_GPU_FULL(type, int64)
+
+TF_CALL_int32(REGISTER_UNIQUE_GPU);
+TF_CALL_int64(REGISTER_UNIQUE_GPU);
+#undef REGISTER_UNIQUE_GPU
+#undef REGISTER_UNIQUE_GPU_FULL
+
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/threadpool.h"
 
+#include <atomic>
+#include <deque>
+
 #define EIGEN_USE_THREADS
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/lib/core/blocking_counter.h"
@@ -29,6 +32,95 @@ limitations under the License.
 namespace tensorflow {
 namespace thread {
 
+constexpr int64 ThreadPool::kMaxLowPriorityDelayMicros;
+
+// The closures scheduled with Priority::kLow. Each of them is queued here
+// along with a task in the pool, which runs the oldest queued closure if it
+// may run, and parks it otherwise. Parked closures are run by the tasks that
+// finish later, once they may run.
+struct LowPriorityQueue {
+  explicit LowPriorityQueue(Env* env) : env(env) {}
+
+  void Push(std::function<void()> fn) LOCKS_EXCLUDED(mu) {
+    mutex_lock l(mu);
+    closures.push_back({std::move(fn), env->NowMicros()});
+  }
+
+  // Runs or parks the oldest queued closure.
+  void RunOrPark() LOCKS_EXCLUDED(mu) {
+    QueuedClosure closure;
+    {
+      mutex_lock l(mu);
+      if (!MayRunLocked()) {
+        ++num_parked;
+        closure.fn = nullptr;
+      } else {
+        closure = std::move(closures.front());
+        closures.pop_front();
+      }
+    }
+    if (closure.fn == nullptr) {
+      // The tasks that were waiting may have finished before seeing the
+      // parked closure.
+      MaybeRunParked();
+      return;
+    }
+    closure.fn();
+  }
+
+  // Runs the parked closures while they may run.
+  void MaybeRunParked() LOCKS_EXCLUDED(mu) {
+    while (num_parked > 0) {
+      QueuedClosure closure;
+      {
+        mutex_lock l(mu);
+        if (num_parked == 0 || !MayRunLocked()) return;
+        --num_parked;
+        closure = std::move(closures.front());
+        closures.pop_front();
+      }
+      closure.fn();
+    }
+  }
+
+  // Lets the parked closures run regardless of other tasks, and returns how
+  // many of them there are.
+  int64 Flush() LOCKS_EXCLUDED(mu) {
+    mutex_lock l(mu);
+    flushing = true;
+    return num_parked.exchange(0);
+  }
+
+  bool MayRunLocked() EXCLUSIVE_LOCKS_REQUIRED(mu) {
+    DCHECK(!closures.empty());
+    // A closure parked while another task has yet to start is not left
+    // behind: either that task sees the parked closure once it is done, or
+    // the task that parked it sees that it started when checking again.
+    if (flushing || num_tasks - num_low_tasks <= 0) return true;
+    const uint64 now = env->NowMicros();
+    const uint64 enqueue_time = closures.front().enqueue_time_us;
+    return now > enqueue_time &&
+           now - enqueue_time >= ThreadPool::kMaxLowPriorityDelayMicros;
+  }
+
+  struct QueuedClosure {
+    std::function<void()> fn;
+    uint64 enqueue_time_us;
+  };
+
+  Env* const env;
+  // The number of tasks of the pool that were created but did not start,
+  // and how many of them run low priority closures.
+  std::atomic<int64> num_tasks{0};
+  std::atomic<int64> num_low_tasks{0};
+  // The number of queued closures whose task has run.
+  std::atomic<int64> num_parked{0};
+
+  mutex mu;
+  std::deque<QueuedClosure> closures GUARDED_BY(mu);
+  bool flushing GUARDED_BY(mu) = false;
+};
+
 struct EigenEnvironment {
   typedef Thread EnvThread;
   struct TaskImpl {
@@ -43,10 +135,14 @@ struct EigenEnvironment {
   Env* const env_;
   const ThreadOptions thread_options_;
   const string name_;
+  LowPriorityQueue* const low_priority_queue_;
 
   EigenEnvironment(Env* env, const ThreadOptions& thread_options,
-                   const string& name)
-      : env_(env), thread_options_(thread_options), name_(name) {}
+                   const string& name, LowPriorityQueue* low_priority_queue)
+      : env_(env),
+        thread_options_(thread_options),
+        name_(name),
+        low_priority_queue_(low_priority_queue) {}
 
   EnvThread* CreateThread(std::function<void()> f) {
     return env_->StartThread(thread_options_, name_, [=]() {
@@ -64,6 +160,7 @@ struct EigenEnvironment {
       id = tracing::GetUniqueArg();
       tracing::RecordEvent(tracing::EventCategory::kScheduleClosure, id);
     }
+    ++low_priority_queue_->num_tasks;
     return Task{
         std::unique_ptr<TaskImpl>(new TaskImpl{
             std::move(f),
@@ -74,19 +171,34 @@ struct EigenEnvironment {
   }
 
   void ExecuteTask(const Task& t) {
-    WithContext wc(t.f->context);
-    tracing::ScopedRegion region(tracing::EventCategory::kRunClosure,
-                                 t.f->trace_id);
-    t.f->f();
+    --low_priority_queue_->num_tasks;
+    {
+      WithContext wc(t.f->context);
+      tracing::ScopedRegion region(tracing::EventCategory::kRunClosure,
+                                   t.f->trace_id);
+      t.f->f();
+    }
+    low_priority_queue_->MaybeRunParked();
   }
 };
 
-struct ThreadPool::Impl : Eigen::ThreadPoolTempl<EigenEnvironment> {
+// LowPriorityQueue is a base so that it outlives the threads of the pool.
+struct ThreadPool::Impl : LowPriorityQueue,
+                          Eigen::ThreadPoolTempl<EigenEnvironment> {
   Impl(Env* env, const ThreadOptions& thread_options, const string& name,
        int num_threads, bool low_latency_hint)
-      : Eigen::ThreadPoolTempl<EigenEnvironment>(
+      : LowPriorityQueue(env),
+        Eigen::ThreadPoolTempl<EigenEnvironment>(
             num_threads, low_latency_hint,
-            EigenEnvironment(env, thread_options, name)) {}
+            EigenEnvironment(env, thread_options, name, this)) {}
+
+  void ScheduleLowPriorityTask() {
+    ++num_low_tasks;
+    Schedule([this]() {
+      --num_low_tasks;
+      RunOrPark();
+    });
+  }
 
   void ParallelFor(int64 total, int64 cost_per_unit,
                    std::function<void(int64, int64)> fn) {
@@ -114,13 +226,29 @@ ThreadPool::ThreadPool(Env* env, const ThreadOptions& thread_options,
                                    num_threads, low_latency_hint));
 }
 
-ThreadPool::~ThreadPool() {}
+ThreadPool::~ThreadPool() {
+  // The pool runs all the scheduled tasks before its threads exit, so
+  // parked closures need a task to run them.
+  for (int64 i = impl_->Flush(); i > 0; --i) {
+    impl_->ScheduleLowPriorityTask();
+  }
+}
 
 void ThreadPool::Schedule(std::function<void()> fn) {
   CHECK(fn != nullptr);
   impl_->Schedule(std::move(fn));
 }
 
+void ThreadPool::Schedule(std::function<void()> fn, Priority priority) {
+  CHECK(fn != nullptr);
+  if (priority == Priority::kNormal) {
+    impl_->Schedule(std::move(fn));
+    return;
+  }
+  impl_->Push(std::move(fn));
+  impl_->ScheduleLowPriorityTask();
+}
+
 int ThreadPool::NumShardsUsedByTransformRangeConcurrently(
     const int64 block_size, const int64 total) {
   if (block_size <= 0 || total <= 1 || total <= block_size ||
@@ -27,13 +27,26 @@ namespace thread {
 
 class ThreadPool {
  public:
+  // The priority class of a scheduled closure.
+  enum class Priority {
+    // Runs as soon as a thread of the pool is free.
+    kNormal,
+    // For background work, e.g. checkpointing or summary writing. Runs once
+    // no kNormal closure is waiting for a thread, or once it has waited for
+    // kMaxLowPriorityDelayMicros, which bounds starvation.
+    kLow,
+  };
+
+  static constexpr int64 kMaxLowPriorityDelayMicros = 10000;
+
   // Constructs a pool that contains "num_threads" threads with specified
   // "name". env->StartThread() is used to create individual threads with the
-  // given ThreadOptions. If "low_latency_hint" is true the thread pool
-  // implementation may use it as a hint that lower latency is preferred at the
-  // cost of higher CPU usage, e.g. by letting one or more idle threads spin
-  // wait. Conversely, if the threadpool is used to schedule high-latency
-  // operations like I/O the hint should be set to false.
+  // given ThreadOptions, which may e.g. restrict them to a set of CPUs. If
+  // "low_latency_hint" is true the thread pool implementation may use it as a
+  // hint that lower latency is preferred at the cost of higher CPU usage,
+  // e.g. by letting one or more idle threads spin wait. Conversely, if the
+  // threadpool is used to schedule high-latency operations like I/O the hint
+  // should be set to false.
   //
   // REQUIRES: num_threads > 0
   ThreadPool(Env* env, const ThreadOptions& thread_options, const string& name,
@@ -59,6 +72,9 @@ class ThreadPool {
   // Schedules fn() for execution in the pool of threads.
   void Schedule(std::function<void()> fn);
 
+  // Schedules fn() for execution in the pool of threads with "priority".
+  void Schedule(std::function<void()> fn, Priority priority);
+
   // Requires 0 < block_size <= total.
   // Spawns k threads and calls fn(i*block_size, (i+1)*block_size) from the
   // ith thread (i>=0). When (i+1)*block_size > total, fn(i*block_size, total)
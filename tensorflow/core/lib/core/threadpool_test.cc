@@ -16,7 +16,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 
 #include <atomic>
+#include <vector>
 
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -61,6 +63,52 @@ TEST(ThreadPool, DoWork) {
   }
 }
 
+TEST(ThreadPool, LowPriorityRunsAfterNormal) {
+  mutex mu;
+  std::vector<string> order;
+  Notification blocked, low_done;
+  {
+    ThreadPool pool(Env::Default(), "test", 1);
+    pool.Schedule([&blocked]() { blocked.WaitForNotification(); });
+    pool.Schedule(
+        [&]() {
+          mutex_lock l(mu);
+          order.push_back("low");
+          low_done.Notify();
+        },
+        ThreadPool::Priority::kLow);
+    pool.Schedule([&]() {
+      mutex_lock l(mu);
+      order.push_back("normal");
+    });
+    blocked.Notify();
+    low_done.WaitForNotification();
+  }
+  EXPECT_EQ(order, std::vector<string>({"normal", "low"}));
+}
+
+TEST(ThreadPool, LowPriorityRunsWhenIdle) {
+  ThreadPool pool(Env::Default(), "test", 2);
+  Notification done;
+  pool.Schedule([&done]() { done.Notify(); }, ThreadPool::Priority::kLow);
+  done.WaitForNotification();
+}
+
+TEST(ThreadPool, LowPriorityRunsBeforeDestruction) {
+  for (int num_threads = 1; num_threads < 4; num_threads++) {
+    std::atomic<int> num_done(0);
+    {
+      ThreadPool pool(Env::Default(), "test", num_threads);
+      for (int i = 0; i < 100; i++) {
+        pool.Schedule([&num_done]() { ++num_done; },
+                      i % 2 == 0 ? ThreadPool::Priority::kLow
+                                 : ThreadPool::Priority::kNormal);
+      }
+    }
+    EXPECT_EQ(100, num_done);
+  }
+}
+
 void RunSharding(int64 block_size, int64 total, ThreadPool* threads) {
   mutex mu;
   int64 num_shards = 0;
@@ -19,8 +19,10 @@ limitations under the License.
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include "tensorflow/core/lib/gtl/swissmap.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -702,6 +704,106 @@ TEST(FlatMap, UniqueMapIter) {
   EXPECT_EQ(val_sum, key_sum + (kCount * kValueDelta));
 }
 
+// Benchmarks of FlatMap against SwissMap and std::unordered_map.  Keys are
+// spread out so that the maps cannot rely on the hash of consecutive
+// integers being consecutive.
+static int64 BenchmarkKey(int64 i) { return i * 0x9E3779B97F4A7C15LL; }
+
+template <typename Map>
+static void BM_MapInsert(int iters, int n) {
+  for (int i = 0; i < iters; i++) {
+    Map map;
+    for (int64 k = 0; k < n; k++) {
+      map[BenchmarkKey(k)] = k;
+    }
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * n);
+}
+
+// Looks up keys of which half are in the map.
+template <typename Map>
+static void BM_MapFind(int iters, int n) {
+  testing::StopTiming();
+  Map map;
+  for (int64 k = 0; k < n; k += 2) {
+    map[BenchmarkKey(k)] = k;
+  }
+  int64 found = 0;
+  testing::StartTiming();
+  for (int i = 0; i < iters; i++) {
+    for (int64 k = 0; k < n; k++) {
+      found += map.count(BenchmarkKey(k));
+    }
+  }
+  testing::StopTiming();
+  CHECK_EQ(found, static_cast<int64>(iters) * ((n + 1) / 2));
+  testing::ItemsProcessed(static_cast<int64>(iters) * n);
+}
+
+// Inserts and erases keys in a map of a constant size.
+template <typename Map>
+static void BM_MapInsertErase(int iters, int n) {
+  testing::StopTiming();
+  Map map;
+  for (int64 k = 0; k < n; k++) {
+    map[BenchmarkKey(k)] = k;
+  }
+  testing::StartTiming();
+  for (int i = 0; i < iters; i++) {
+    for (int64 k = 0; k < n; k++) {
+      map.erase(BenchmarkKey(k));
+      map[BenchmarkKey(k + n)] = k;
+    }
+    for (int64 k = 0; k < n; k++) {
+      map.erase(BenchmarkKey(k + n));
+      map[BenchmarkKey(k)] = k;
+    }
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * n * 2);
+}
+
+typedef FlatMap<int64, int64> BenchmarkFlatMap;
+typedef SwissMap<int64, int64> BenchmarkSwissMap;
+typedef std::unordered_map<int64, int64, hash<int64>> BenchmarkUnorderedMap;
+
+static void BM_FlatMapInsert(int iters, int n) {
+  BM_MapInsert<BenchmarkFlatMap>(iters, n);
+}
+static void BM_SwissMapInsert(int iters, int n) {
+  BM_MapInsert<BenchmarkSwissMap>(iters, n);
+}
+static void BM_UnorderedMapInsert(int iters, int n) {
+  BM_MapInsert<BenchmarkUnorderedMap>(iters, n);
+}
+static void BM_FlatMapFind(int iters, int n) {
+  BM_MapFind<BenchmarkFlatMap>(iters, n);
+}
+static void BM_SwissMapFind(int iters, int n) {
+  BM_MapFind<BenchmarkSwissMap>(iters, n);
+}
+static void BM_UnorderedMapFind(int iters, int n) {
+  BM_MapFind<BenchmarkUnorderedMap>(iters, n);
+}
+static void BM_FlatMapInsertErase(int iters, int n) {
+  BM_MapInsertErase<BenchmarkFlatMap>(iters, n);
+}
+static void BM_SwissMapInsertErase(int iters, int n) {
+  BM_MapInsertErase<BenchmarkSwissMap>(iters, n);
+}
+static void BM_UnorderedMapInsertErase(int iters, int n) {
+  BM_MapInsertErase<BenchmarkUnorderedMap>(iters, n);
+}
+
+BENCHMARK(BM_FlatMapInsert)->Range(16, 1 << 20);
+BENCHMARK(BM_SwissMapInsert)->Range(16, 1 << 20);
+BENCHMARK(BM_UnorderedMapInsert)->Range(16, 1 << 20);
+BENCHMARK(BM_FlatMapFind)->Range(16, 1 << 20);
+BENCHMARK(BM_SwissMapFind)->Range(16, 1 << 20);
+BENCHMARK(BM_UnorderedMapFind)->Range(16, 1 << 20);
+BENCHMARK(BM_FlatMapInsertErase)->Range(16, 1 << 20);
+BENCHMARK(BM_SwissMapInsertErase)->Range(16, 1 << 20);
+BENCHMARK(BM_UnorderedMapInsertErase)->Range(16, 1 << 20);
+
 }  // namespace
 }  // namespace gtl
 }  // namespace tensorflow
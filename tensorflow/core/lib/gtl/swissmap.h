@@ -0,0 +1,649 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_GTL_SWISSMAP_H_
+#define TENSORFLOW_CORE_LIB_GTL_SWISSMAP_H_
+
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <utility>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/prefetch.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace gtl {
+
+// SwissMap<K,V,...> provides a map from K to V, with the same interface as
+// FlatMap.
+//
+// The map is an open-addressed hash table that probes groups of kGroupWidth
+// slots at a time.  Every slot has a control byte that is kEmpty, kDeleted,
+// or holds 7 bits of the hash of the slot's key.  A lookup compares the
+// control bytes of a whole group against the hash bits of the key with a
+// single SSE2 instruction when available, so it usually compares a single
+// key, and stops at the first group that has an empty slot.
+template <typename Key, typename Val, class Hash = hash<Key>,
+          class Eq = std::equal_to<Key>>
+class SwissMap {
+ private:
+  // Forward declare some internal types needed in public section.
+  struct Slot;
+
+  // Holds references to the key and value of a slot, like FlatMap.
+  struct ValueType {
+    typedef Key first_type;
+    typedef Val second_type;
+
+    const Key& first;
+    Val& second;
+    ValueType(const Key& k, Val& v) : first(k), second(v) {}
+  };
+
+ public:
+  typedef Key key_type;
+  typedef Val mapped_type;
+  typedef Hash hasher;
+  typedef Eq key_equal;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef ValueType value_type;
+  typedef value_type* pointer;
+  typedef const value_type* const_pointer;
+  typedef value_type& reference;
+  typedef const value_type& const_reference;
+
+  // The number of slots probed together.
+  static const size_t kGroupWidth = 16;
+
+  SwissMap() : SwissMap(1) {}
+
+  explicit SwissMap(size_t N, const Hash& hf = Hash(), const Eq& eq = Eq())
+      : hash_(hf), equal_(eq) {
+    Init(N);
+  }
+
+  SwissMap(const SwissMap& src) : hash_(src.hash_), equal_(src.equal_) {
+    Init(src.size());
+    CopyEntries(src);
+  }
+
+  // Move constructor leaves src in a valid but unspecified state (same as
+  // std::unordered_map).
+  SwissMap(SwissMap&& src) : hash_(src.hash_), equal_(src.equal_) {
+    Init(1);
+    swap(src);
+  }
+
+  template <typename InputIter>
+  SwissMap(InputIter first, InputIter last, size_t N = 1,
+           const Hash& hf = Hash(), const Eq& eq = Eq())
+      : SwissMap(N, hf, eq) {
+    insert(first, last);
+  }
+
+  SwissMap(std::initializer_list<std::pair<const Key, Val>> init, size_t N = 1,
+           const Hash& hf = Hash(), const Eq& eq = Eq())
+      : SwissMap(init.begin(), init.end(), N, hf, eq) {}
+
+  SwissMap& operator=(const SwissMap& src) {
+    if (this != &src) {
+      Destroy();
+      Init(src.size());
+      CopyEntries(src);
+    }
+    return *this;
+  }
+
+  // Move-assignment operator leaves src in a valid but unspecified state (same
+  // as std::unordered_map).
+  SwissMap& operator=(SwissMap&& src) {
+    if (this != &src) {
+      swap(src);
+    }
+    return *this;
+  }
+
+  ~SwissMap() { Destroy(); }
+
+  void swap(SwissMap& x) {
+    using std::swap;
+    swap(hash_, x.hash_);
+    swap(equal_, x.equal_);
+    swap(ctrl_, x.ctrl_);
+    swap(slots_, x.slots_);
+    swap(capacity_, x.capacity_);
+    swap(size_, x.size_);
+    swap(growth_left_, x.growth_left_);
+  }
+  void clear_no_resize() {
+    DestroyEntries();
+    ResetControl();
+  }
+  void clear() {
+    Destroy();
+    Init(1);
+  }
+  void reserve(size_t N) { Resize(std::max(N, size())); }
+  void rehash(size_t N) { Resize(std::max(N, size())); }
+  void resize(size_t N) { Resize(std::max(N, size())); }
+  size_t size() const { return size_; }
+  bool empty() const { return size() == 0; }
+  size_t bucket_count() const { return capacity_; }
+  hasher hash_function() const { return hash_; }
+  key_equal key_eq() const { return equal_; }
+
+  class iterator {
+   public:
+    typedef typename SwissMap::difference_type difference_type;
+    typedef typename SwissMap::value_type value_type;
+    typedef typename SwissMap::pointer pointer;
+    typedef typename SwissMap::reference reference;
+    typedef ::std::forward_iterator_tag iterator_category;
+
+    iterator() : ctrl_(nullptr), slot_(nullptr), end_(nullptr) {}
+
+    // Make iterator pointing at first element at or after slot.
+    iterator(const int8* ctrl, Slot* slot, Slot* end)
+        : ctrl_(ctrl), slot_(slot), end_(end) {
+      SkipUnused();
+    }
+
+    // Make iterator pointing exactly at slot, which must be full.
+    iterator(const int8* ctrl, Slot* slot, Slot* end, bool /*full*/)
+        : ctrl_(ctrl), slot_(slot), end_(end) {
+      FillValue();
+    }
+
+    reference operator*() { return *val(); }
+    pointer operator->() { return val(); }
+    bool operator==(const iterator& x) const { return slot_ == x.slot_; }
+    bool operator!=(const iterator& x) const { return !(*this == x); }
+    iterator& operator++() {
+      DCHECK(slot_ != end_);
+      ++ctrl_;
+      ++slot_;
+      SkipUnused();
+      return *this;
+    }
+    iterator operator++(int /*indicates postfix*/) {
+      iterator tmp(*this);
+      ++*this;
+      return tmp;
+    }
+
+   private:
+    friend class SwissMap;
+    const int8* ctrl_;
+    Slot* slot_;
+    Slot* end_;
+    char space_ alignas(value_type)[sizeof(value_type)];
+
+    pointer val() { return reinterpret_cast<pointer>(space_); }
+    void FillValue() { new (space_) value_type(slot_->key, slot_->val); }
+    void SkipUnused() {
+      while (slot_ < end_) {
+        if (IsFull(*ctrl_)) {
+          FillValue();
+          break;
+        }
+        ++ctrl_;
+        ++slot_;
+      }
+    }
+  };
+
+  class const_iterator {
+   private:
+    mutable iterator rep_;  // Share state and logic with non-const iterator.
+   public:
+    typedef typename SwissMap::difference_type difference_type;
+    typedef typename SwissMap::value_type value_type;
+    typedef typename SwissMap::const_pointer pointer;
+    typedef typename SwissMap::const_reference reference;
+    typedef ::std::forward_iterator_tag iterator_category;
+
+    const_iterator() : rep_() {}
+    const_iterator(const int8* ctrl, Slot* slot, Slot* end)
+        : rep_(ctrl, slot, end) {}
+    const_iterator(const int8* ctrl, Slot* slot, Slot* end, bool full)
+        : rep_(ctrl, slot, end, full) {}
+
+    reference operator*() const { return *rep_.val(); }
+    pointer operator->() const { return rep_.val(); }
+    bool operator==(const const_iterator& x) const { return rep_ == x.rep_; }
+    bool operator!=(const const_iterator& x) const { return rep_ != x.rep_; }
+    const_iterator& operator++() {
+      ++rep_;
+      return *this;
+    }
+    const_iterator operator++(int /*indicates postfix*/) {
+      const_iterator tmp(*this);
+      ++*this;
+      return tmp;
+    }
+  };
+
+  iterator begin() { return iterator(ctrl_, slots_, limit()); }
+  iterator end() { return iterator(nullptr, limit(), limit()); }
+  const_iterator begin() const {
+    return const_iterator(ctrl_, slots_, limit());
+  }
+  const_iterator end() const {
+    return const_iterator(nullptr, limit(), limit());
+  }
+
+  size_t count(const Key& k) const { return Find(k) >= 0 ? 1 : 0; }
+  iterator find(const Key& k) {
+    const int64 i = Find(k);
+    return i >= 0 ? MakeIterator(i) : end();
+  }
+  const_iterator find(const Key& k) const {
+    const int64 i = Find(k);
+    return i >= 0 ? const_iterator(ctrl_ + i, slots_ + i, limit(), true)
+                  : end();
+  }
+
+  Val& at(const Key& k) {
+    const int64 i = Find(k);
+    DCHECK_GE(i, 0);
+    return slots_[i].val;
+  }
+  const Val& at(const Key& k) const {
+    const int64 i = Find(k);
+    DCHECK_GE(i, 0);
+    return slots_[i].val;
+  }
+
+  template <typename P>
+  std::pair<iterator, bool> insert(const P& p) {
+    return Insert(p.first, p.second);
+  }
+  std::pair<iterator, bool> insert(const std::pair<const Key, Val>& p) {
+    return Insert(p.first, p.second);
+  }
+  template <typename InputIter>
+  void insert(InputIter first, InputIter last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  Val& operator[](const Key& k) { return IndexOp(k); }
+  Val& operator[](Key&& k) { return IndexOp(std::forward<Key>(k)); }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    return InsertPair(std::make_pair(std::forward<Args>(args)...));
+  }
+
+  size_t erase(const Key& k) {
+    const int64 i = Find(k);
+    if (i < 0) return 0;
+    Erase(i);
+    return 1;
+  }
+  iterator erase(iterator pos) {
+    Erase(pos.slot_ - slots_);
+    ++pos;
+    return pos;
+  }
+  iterator erase(iterator pos, iterator last) {
+    for (; pos != last; ++pos) {
+      Erase(pos.slot_ - slots_);
+    }
+    return pos;
+  }
+
+  std::pair<iterator, iterator> equal_range(const Key& k) {
+    auto pos = find(k);
+    if (pos == end()) {
+      return std::make_pair(pos, pos);
+    } else {
+      auto next = pos;
+      ++next;
+      return std::make_pair(pos, next);
+    }
+  }
+  std::pair<const_iterator, const_iterator> equal_range(const Key& k) const {
+    auto pos = find(k);
+    if (pos == end()) {
+      return std::make_pair(pos, pos);
+    } else {
+      auto next = pos;
+      ++next;
+      return std::make_pair(pos, next);
+    }
+  }
+
+  bool operator==(const SwissMap& x) const {
+    if (size() != x.size()) return false;
+    for (auto& p : x) {
+      auto i = find(p.first);
+      if (i == end()) return false;
+      if (i->second != p.second) return false;
+    }
+    return true;
+  }
+  bool operator!=(const SwissMap& x) const { return !(*this == x); }
+
+  // If key exists in the table, prefetch the associated value.  This
+  // is a hint, and may have no effect.
+  void prefetch_value(const Key& key) const {
+    const size_t group = H1(Mix(hash_(key))) & group_mask();
+    port::prefetch<port::PREFETCH_HINT_T0>(ctrl_ + group * kGroupWidth);
+    port::prefetch<port::PREFETCH_HINT_T0>(slots_ + group * kGroupWidth);
+  }
+
+ private:
+  // Special control bytes.  Full slots hold 7 bits of hash, so they are
+  // non-negative.
+  enum : int8 { kEmpty = -128, kDeleted = -2 };
+
+  struct Slot {
+    Key key;
+    Val val;
+  };
+
+  // A bitmask of the slots of a group, one bit per slot.
+  class BitMask {
+   public:
+    explicit BitMask(uint32 mask) : mask_(mask) {}
+    explicit operator bool() const { return mask_ != 0; }
+    // Returns the index of the lowest set bit.
+    uint32 Lowest() const {
+#if defined(__GNUC__)
+      return __builtin_ctz(mask_);
+#else
+      uint32 i = 0;
+      while (((mask_ >> i) & 1) == 0) ++i;
+      return i;
+#endif
+    }
+    void ClearLowest() { mask_ &= mask_ - 1; }
+
+   private:
+    uint32 mask_;
+  };
+
+  // The control bytes of one group.
+  class Group {
+   public:
+    explicit Group(const int8* ctrl) : ctrl_(ctrl) {}
+
+    // Returns the slots whose control byte is `h2`.
+    BitMask Match(int8 h2) const { return MatchByte(h2); }
+    BitMask MatchEmpty() const { return MatchByte(kEmpty); }
+    // Returns the slots that are empty or deleted.
+    BitMask MatchEmptyOrDeleted() const {
+#ifdef __SSE2__
+      const __m128i ctrl =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl_));
+      return BitMask(_mm_movemask_epi8(ctrl));
+#else
+      uint32 mask = 0;
+      for (uint32 i = 0; i < kGroupWidth; ++i) {
+        mask |= static_cast<uint32>(ctrl_[i] < 0) << i;
+      }
+      return BitMask(mask);
+#endif
+    }
+
+   private:
+    BitMask MatchByte(int8 byte) const {
+#ifdef __SSE2__
+      const __m128i ctrl =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl_));
+      return BitMask(
+          _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(byte), ctrl)));
+#else
+      uint32 mask = 0;
+      for (uint32 i = 0; i < kGroupWidth; ++i) {
+        mask |= static_cast<uint32>(ctrl_[i] == byte) << i;
+      }
+      return BitMask(mask);
+#endif
+    }
+
+    const int8* ctrl_;
+  };
+
+  Hash hash_;            // User-supplied hasher
+  Eq equal_;             // User-supplied comparator
+  int8* ctrl_;           // Control bytes of the capacity_ slots
+  Slot* slots_;          // Array of capacity_ slots
+  size_t capacity_;      // Number of slots, a power of two >= kGroupWidth
+  size_t size_;          // Number of full slots
+  size_t growth_left_;   // Number of empty slots we may fill before growing
+
+  static bool IsFull(int8 ctrl) { return ctrl >= 0; }
+
+  // Spreads the bits of user-supplied hashes, which are often the identity
+  // for integers.
+  static size_t Mix(size_t h) {
+    const uint64 m = static_cast<uint64>(h) * 0x9ddfea08eb382d69ULL;
+    return static_cast<size_t>(m ^ (m >> 32));
+  }
+  static size_t H1(size_t h) { return h >> 7; }
+  static int8 H2(size_t h) { return static_cast<int8>(h & 0x7f); }
+
+  size_t group_mask() const { return capacity_ / kGroupWidth - 1; }
+  Slot* limit() const { return slots_ + capacity_; }
+  iterator MakeIterator(size_t i) {
+    return iterator(ctrl_ + i, slots_ + i, limit(), true);
+  }
+
+  // Allocates empty room for N elements at a maximum load of 7/8.
+  void Init(size_t N) {
+    size_t capacity = kGroupWidth;
+    while (N > capacity - capacity / 8) {
+      capacity *= 2;
+    }
+    capacity_ = capacity;
+    ctrl_ = new int8[capacity];
+    slots_ = static_cast<Slot*>(::operator new(capacity * sizeof(Slot)));
+    ResetControl();
+  }
+
+  void ResetControl() {
+    memset(ctrl_, kEmpty, capacity_);
+    size_ = 0;
+    growth_left_ = capacity_ - capacity_ / 8;
+  }
+
+  void DestroyEntries() {
+    for (size_t i = 0; i < capacity_; ++i) {
+      if (IsFull(ctrl_[i])) {
+        slots_[i].key.Key::~Key();
+        slots_[i].val.Val::~Val();
+      }
+    }
+  }
+
+  void Destroy() {
+    DestroyEntries();
+    delete[] ctrl_;
+    ::operator delete(slots_);
+  }
+
+  // Returns the index of the slot holding k, or -1.
+  int64 Find(const Key& k) const {
+    const size_t h = Mix(hash_(k));
+    const int8 h2 = H2(h);
+    size_t group = H1(h) & group_mask();
+    size_t num_probes = 1;  // Needed for quadratic probing
+    while (true) {
+      const size_t base = group * kGroupWidth;
+      Group g(ctrl_ + base);
+      for (BitMask m = g.Match(h2); m; m.ClearLowest()) {
+        const size_t i = base + m.Lowest();
+        if (equal_(slots_[i].key, k)) return i;
+      }
+      if (g.MatchEmpty()) return -1;
+      group = (group + num_probes) & group_mask();
+      num_probes++;
+    }
+  }
+
+  // Returns the index of the first empty or deleted slot in the probe
+  // sequence of hash h.
+  size_t FindFreeSlot(size_t h) const {
+    size_t group = H1(h) & group_mask();
+    size_t num_probes = 1;
+    while (true) {
+      const size_t base = group * kGroupWidth;
+      BitMask m = Group(ctrl_ + base).MatchEmptyOrDeleted();
+      if (m) return base + m.Lowest();
+      group = (group + num_probes) & group_mask();
+      num_probes++;
+    }
+  }
+
+  // Finds the slot of k, creating one if necessary, and returns its index
+  // and whether it was there already.
+  //
+  // KeyType is a template parameter so that k's type is deduced and it
+  // becomes a universal reference which allows the key initialization
+  // below to use an rvalue constructor if available.
+  template <typename KeyType>
+  std::pair<size_t, bool> FindOrInsert(KeyType&& k) {
+    const size_t h = Mix(hash_(k));
+    const int8 h2 = H2(h);
+    size_t group = H1(h) & group_mask();
+    size_t num_probes = 1;  // Needed for quadratic probing
+    size_t i = capacity_;   // First empty or deleted slot when not found
+    while (true) {
+      const size_t base = group * kGroupWidth;
+      Group g(ctrl_ + base);
+      for (BitMask m = g.Match(h2); m; m.ClearLowest()) {
+        const size_t j = base + m.Lowest();
+        if (equal_(slots_[j].key, k)) return {j, true};
+      }
+      if (i == capacity_) {
+        BitMask free = g.MatchEmptyOrDeleted();
+        if (free) i = base + free.Lowest();
+      }
+      if (g.MatchEmpty()) break;
+      group = (group + num_probes) & group_mask();
+      num_probes++;
+    }
+    if (growth_left_ == 0 && ctrl_[i] == kEmpty) {
+      // Rehash, in place if deleted slots make up for the growth.
+      Resize(size_ * 2 >= capacity_ - capacity_ / 8 ? size_ * 2 : size_);
+      i = FindFreeSlot(h);
+    }
+    if (ctrl_[i] == kEmpty) growth_left_--;
+    ctrl_[i] = H2(h);
+    size_++;
+    new (&slots_[i].key) Key(std::forward<KeyType>(k));
+    return {i, false};
+  }
+
+  void Erase(size_t i) {
+    slots_[i].key.Key::~Key();
+    slots_[i].val.Val::~Val();
+    size_--;
+    // Probing stops at groups with an empty slot, so such a group was never
+    // full and no probe sequence goes past it: the slot can be empty again.
+    const size_t base = i & ~(kGroupWidth - 1);
+    if (Group(ctrl_ + base).MatchEmpty()) {
+      ctrl_[i] = kEmpty;
+      growth_left_++;
+    } else {
+      ctrl_[i] = kDeleted;
+    }
+  }
+
+  void Resize(size_t N) {
+    int8* old_ctrl = ctrl_;
+    Slot* old_slots = slots_;
+    const size_t old_capacity = capacity_;
+    Init(N);
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (IsFull(old_ctrl[i])) {
+        Slot* src = &old_slots[i];
+        Slot* dst = FreshInsert(src->key);
+        new (&dst->key) Key(std::move(src->key));
+        new (&dst->val) Val(std::move(src->val));
+        src->key.Key::~Key();
+        src->val.Val::~Val();
+      }
+    }
+    delete[] old_ctrl;
+    ::operator delete(old_slots);
+  }
+
+  void CopyEntries(const SwissMap& src) {
+    for (size_t i = 0; i < src.capacity_; ++i) {
+      if (IsFull(src.ctrl_[i])) {
+        const Slot& s = src.slots_[i];
+        Slot* dst = FreshInsert(s.key);
+        new (&dst->key) Key(s.key);
+        new (&dst->val) Val(s.val);
+      }
+    }
+  }
+
+  // Claims a slot for k in a table without deleted slots that does not
+  // contain k, and returns it for the caller to construct.
+  Slot* FreshInsert(const Key& k) {
+    const size_t h = Mix(hash_(k));
+    const size_t i = FindFreeSlot(h);
+    ctrl_[i] = H2(h);
+    size_++;
+    growth_left_--;
+    return &slots_[i];
+  }
+
+  template <typename Pair>
+  std::pair<iterator, bool> InsertPair(Pair&& p) {
+    return Insert(std::forward<decltype(p.first)>(p.first),
+                  std::forward<decltype(p.second)>(p.second));
+  }
+
+  template <typename K, typename V>
+  std::pair<iterator, bool> Insert(K&& k, V&& v) {
+    auto r = FindOrInsert(std::forward<K>(k));
+    const bool inserted = !r.second;
+    if (inserted) {
+      new (&slots_[r.first].val) Val(std::forward<V>(v));
+    }
+    return {MakeIterator(r.first), inserted};
+  }
+
+  template <typename K>
+  Val& IndexOp(K&& k) {
+    auto r = FindOrInsert(std::forward<K>(k));
+    Val* vptr = &slots_[r.first].val;
+    if (!r.second) {
+      new (vptr) Val();  // Initialize value in new slot.
+    }
+    return *vptr;
+  }
+};
+
+}  // namespace gtl
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_GTL_SWISSMAP_H_
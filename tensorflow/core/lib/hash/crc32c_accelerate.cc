@@ -16,7 +16,8 @@ limitations under the License.
 #include <stddef.h>
 #include <stdint.h>
 
-// SSE4.2 accelerated CRC32c.
+// Hardware accelerated CRC32c, using the SSE4.2 crc32 instructions on x86-64
+// and the ARMv8 CRC32 extension on aarch64.
 
 // See if the SSE4.2 crc32c instruction is available.
 #undef USE_SSE_CRC32C
@@ -37,14 +38,24 @@ limitations under the License.
 #undef USE_SSE_CRC32C
 #endif
 
+// See if the ARMv8 crc32c instructions are available.  They are optional in
+// ARMv8.0, so this requires compiling with e.g. -march=armv8-a+crc.
+#undef USE_ARM_CRC32C
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define USE_ARM_CRC32C 1
+#endif
+
 #ifdef USE_SSE_CRC32C
 #include <nmmintrin.h>
 #endif
+#ifdef USE_ARM_CRC32C
+#include <arm_acle.h>
+#endif
 
 namespace tensorflow {
 namespace crc32c {
 
-#ifndef USE_SSE_CRC32C
+#if !defined(USE_SSE_CRC32C) && !defined(USE_ARM_CRC32C)
 
 bool CanAccelerate() { return false; }
 uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
@@ -54,10 +65,134 @@ uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
 
 #else
 
-// SSE4.2 optimized crc32c computation.
+namespace {
+
+#ifdef USE_SSE_CRC32C
+
+inline uint32_t Crc32Byte(uint32_t crc, uint8_t v) {
+  return _mm_crc32_u8(crc, v);
+}
+inline uint32_t Crc32Word(uint32_t crc, const uint8_t *p) {
+  return static_cast<uint32_t>(
+      _mm_crc32_u64(crc, *reinterpret_cast<const uint64_t *>(p)));
+}
+
+#else  // USE_ARM_CRC32C
+
+inline uint32_t Crc32Byte(uint32_t crc, uint8_t v) { return __crc32cb(crc, v); }
+inline uint32_t Crc32Word(uint32_t crc, const uint8_t *p) {
+  return __crc32cd(crc, *reinterpret_cast<const uint64_t *>(p));
+}
+
+#endif
+
+// The crc32 instructions have a latency of three cycles but a throughput of
+// one per cycle, so large buffers are processed as three interleaved streams
+// of kLongBlock (then kShortBlock) bytes.  The crcs of the streams are
+// combined by applying the operator that appends that many zero bytes.
+constexpr size_t kLongBlock = 8192;
+constexpr size_t kShortBlock = 256;
+
+// The CRC32c polynomial, bit-reflected.
+constexpr uint32_t kPoly = 0x82f63b78;
+
+// Multiplies the 32x32 GF(2) matrix "mat" by "vec".
+uint32_t Gf2MatrixTimes(const uint32_t *mat, uint32_t vec) {
+  uint32_t sum = 0;
+  while (vec) {
+    if (vec & 1) sum ^= *mat;
+    vec >>= 1;
+    mat++;
+  }
+  return sum;
+}
+
+void Gf2MatrixSquare(uint32_t *square, const uint32_t *mat) {
+  for (int n = 0; n < 32; n++) {
+    square[n] = Gf2MatrixTimes(mat, mat[n]);
+  }
+}
+
+// Tables applying the operator that appends "len" zero bytes to a crc, one
+// byte of the crc at a time.
+class ZerosOperator {
+ public:
+  // REQUIRES: "len" is a power of two.
+  explicit ZerosOperator(size_t len) {
+    // The operator for one zero bit, then for two and four zero bits.
+    uint32_t odd[32];
+    uint32_t even[32];
+    odd[0] = kPoly;
+    uint32_t row = 1;
+    for (int n = 1; n < 32; n++) {
+      odd[n] = row;
+      row <<= 1;
+    }
+    Gf2MatrixSquare(even, odd);
+    Gf2MatrixSquare(odd, even);
+    // Each square doubles the number of zero bytes, starting from one.
+    const uint32_t *op = odd;
+    for (; len > 0; len >>= 1) {
+      if (op == odd) {
+        Gf2MatrixSquare(even, odd);
+        op = even;
+      } else {
+        Gf2MatrixSquare(odd, even);
+        op = odd;
+      }
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+      table_[0][n] = Gf2MatrixTimes(op, n);
+      table_[1][n] = Gf2MatrixTimes(op, n << 8);
+      table_[2][n] = Gf2MatrixTimes(op, n << 16);
+      table_[3][n] = Gf2MatrixTimes(op, n << 24);
+    }
+  }
+
+  uint32_t Apply(uint32_t crc) const {
+    return table_[0][crc & 0xff] ^ table_[1][(crc >> 8) & 0xff] ^
+           table_[2][(crc >> 16) & 0xff] ^ table_[3][crc >> 24];
+  }
+
+ private:
+  uint32_t table_[4][256];
+};
+
+// Processes as many blocks of 3 * "block" bytes as "*p" holds.
+// REQUIRES: "*p" is 8-byte aligned, and "block" a multiple of 8.
+inline uint32_t ExtendInterleaved(uint32_t crc0, size_t block,
+                                  const ZerosOperator &shift,
+                                  const uint8_t **p, const uint8_t *e) {
+  while (static_cast<size_t>(e - *p) >= 3 * block) {
+    uint32_t crc1 = 0;
+    uint32_t crc2 = 0;
+    const uint8_t *q = *p;
+    const uint8_t *end = q + block;
+    do {
+      crc0 = Crc32Word(crc0, q);
+      crc1 = Crc32Word(crc1, q + block);
+      crc2 = Crc32Word(crc2, q + 2 * block);
+      q += 8;
+    } while (q < end);
+    crc0 = shift.Apply(crc0) ^ crc1;
+    crc0 = shift.Apply(crc0) ^ crc2;
+    *p += 3 * block;
+  }
+  return crc0;
+}
+
+}  // namespace
+
+#ifdef USE_SSE_CRC32C
 bool CanAccelerate() { return __builtin_cpu_supports("sse4.2"); }
+#else
+bool CanAccelerate() { return true; }
+#endif
 
 uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
+  static const ZerosOperator *long_shift = new ZerosOperator(kLongBlock);
+  static const ZerosOperator *short_shift = new ZerosOperator(kShortBlock);
+
   const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
   const uint8_t *e = p + size;
   uint32_t l = crc ^ 0xffffffffu;
@@ -70,23 +205,25 @@ uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
   if (x <= e) {
     // Process bytes until finished or p is 8-byte aligned
     while (p != x) {
-      l = _mm_crc32_u8(l, *p);
+      l = Crc32Byte(l, *p);
       p++;
     }
   }
 
+  // Process large buffers as three interleaved streams.
+  l = ExtendInterleaved(l, kLongBlock, *long_shift, &p, e);
+  l = ExtendInterleaved(l, kShortBlock, *short_shift, &p, e);
+
   // Process bytes 16 at a time
-  uint64_t l64 = l;
   while ((e - p) >= 16) {
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p));
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p + 8));
+    l = Crc32Word(l, p);
+    l = Crc32Word(l, p + 8);
     p += 16;
   }
 
   // Process remaining bytes one at a time.
-  l = l64;
   while (p < e) {
-    l = _mm_crc32_u8(l, *p);
+    l = Crc32Byte(l, *p);
     p++;
   }
 
@@ -14,6 +14,10 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/lib/hash/crc32c.h"
+
+#include <algorithm>
+#include <string>
+
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -62,6 +66,26 @@ TEST(CRC, Extend) {
   ASSERT_EQ(Value("hello world", 11), Extend(Value("hello ", 6), "world", 5));
 }
 
+TEST(CRC, LargeBuffers) {
+  // Large buffers are processed in interleaved blocks; extending the crc in
+  // small pieces does not.
+  std::string input;
+  for (int i = 0; i < 100000; i++) {
+    input.push_back(static_cast<char>(i * 7 + (i >> 8)));
+  }
+  for (size_t offset : {0, 1, 5}) {
+    for (size_t len : {767, 768, 24576, 24577, 99990}) {
+      uint32 expected = 0;
+      for (size_t i = 0; i < len; i += 100) {
+        expected = Extend(expected, input.data() + offset + i,
+                          std::min<size_t>(100, len - i));
+      }
+      ASSERT_EQ(expected, Value(input.data() + offset, len))
+          << offset << " " << len;
+    }
+  }
+}
+
 TEST(CRC, Mask) {
   uint32 crc = Value("foo", 3);
   ASSERT_NE(crc, Mask(crc));
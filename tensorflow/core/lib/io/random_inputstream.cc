@@ -24,27 +24,94 @@ RandomAccessInputStream::RandomAccessInputStream(RandomAccessFile* file,
     : file_(file), owns_file_(owns_file) {}
 
 RandomAccessInputStream::~RandomAccessInputStream() {
+  // The read ahead writes to its buffer until it completes.
+  WaitForReadahead();
   if (owns_file_) {
     delete file_;
   }
 }
 
+void RandomAccessInputStream::EnableReadahead() {
+  if (readahead_ == nullptr) {
+    readahead_.reset(new Readahead);
+  }
+}
+
+void RandomAccessInputStream::WaitForReadahead() {
+  if (readahead_ == nullptr) {
+    return;
+  }
+  mutex_lock l(readahead_->mu);
+  while (readahead_->pending) {
+    readahead_->cv.wait(l);
+  }
+}
+
+void RandomAccessInputStream::StartReadahead(int64 bytes_to_read) {
+  Readahead* readahead = readahead_.get();
+  char* scratch;
+  {
+    mutex_lock l(readahead->mu);
+    readahead->pending = true;
+    readahead->offset = pos_;
+    readahead->size = bytes_to_read;
+    readahead->buffer.resize(bytes_to_read);
+    scratch = &readahead->buffer[0];
+  }
+  file_->ReadAsync(pos_, bytes_to_read, scratch,
+                   [readahead, scratch](const Status& s, StringPiece data) {
+                     mutex_lock l(readahead->mu);
+                     if (data.data() != scratch) {
+                       memmove(scratch, data.data(), data.size());
+                     }
+                     readahead->buffer.resize(data.size());
+                     readahead->status = s;
+                     readahead->pending = false;
+                     readahead->cv.notify_all();
+                   });
+}
+
+bool RandomAccessInputStream::TakeReadahead(int64 bytes_to_read,
+                                            string* result, Status* status) {
+  mutex_lock l(readahead_->mu);
+  while (readahead_->pending) {
+    readahead_->cv.wait(l);
+  }
+  if (readahead_->offset != pos_ || readahead_->size != bytes_to_read) {
+    return false;
+  }
+  readahead_->offset = -1;
+  // Errors other than EOF may be transient, so the read is tried again.
+  if (!readahead_->status.ok() && !errors::IsOutOfRange(readahead_->status)) {
+    return false;
+  }
+  result->swap(readahead_->buffer);
+  *status = readahead_->status;
+  return true;
+}
+
 Status RandomAccessInputStream::ReadNBytes(int64 bytes_to_read,
                                            string* result) {
   if (bytes_to_read < 0) {
     return errors::InvalidArgument("Cannot read negative number of bytes");
   }
-  result->clear();
-  result->resize(bytes_to_read);
-  char* result_buffer = &(*result)[0];
-  StringPiece data;
-  Status s = file_->Read(pos_, bytes_to_read, &data, result_buffer);
-  if (data.data() != result_buffer) {
-    memmove(result_buffer, data.data(), data.size());
+  Status s;
+  if (readahead_ == nullptr || !TakeReadahead(bytes_to_read, result, &s)) {
+    result->clear();
+    result->resize(bytes_to_read);
+    char* result_buffer = &(*result)[0];
+    StringPiece data;
+    s = file_->Read(pos_, bytes_to_read, &data, result_buffer);
+    if (data.data() != result_buffer) {
+      memmove(result_buffer, data.data(), data.size());
+    }
+    result->resize(data.size());
   }
-  result->resize(data.size());
   if (s.ok() || errors::IsOutOfRange(s)) {
-    pos_ += data.size();
+    pos_ += result->size();
+  }
+  if (readahead_ != nullptr && s.ok() && bytes_to_read > 0) {
+    StartReadahead(bytes_to_read);
   }
   return s;
 }
@@ -16,8 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_LIB_IO_RANDOM_INPUTSTREAM_H_
 #define TENSORFLOW_CORE_LIB_IO_RANDOM_INPUTSTREAM_H_
 
+#include <memory>
 #include "tensorflow/core/lib/io/inputstream_interface.h"
 #include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 namespace io {
@@ -45,10 +48,38 @@ class RandomAccessInputStream : public InputStreamInterface {
 
   Status Reset() override { return Seek(0); }
 
+  // Makes every ReadNBytes(n) start reading the n bytes that follow with
+  // RandomAccessFile::ReadAsync(), so that a sequential reader of a file with
+  // slow reads waits for the next chunk while it processes the current one.
+  // Reads at other positions, or of other sizes, bypass the read ahead.
+  void EnableReadahead();
+
  private:
+  // A read ahead of the current position, shared with its callback.
+  struct Readahead {
+    mutex mu;
+    condition_variable cv;
+    bool pending GUARDED_BY(mu) = false;
+    int64 offset GUARDED_BY(mu) = -1;
+    int64 size GUARDED_BY(mu) = 0;
+    string buffer GUARDED_BY(mu);
+    Status status GUARDED_BY(mu);
+  };
+
+  // Starts reading `bytes_to_read` bytes at the current position.
+  void StartReadahead(int64 bytes_to_read);
+
+  // Returns the data of the read ahead in `result` and its status in
+  // `status` if it read `bytes_to_read` bytes at the current position.
+  bool TakeReadahead(int64 bytes_to_read, string* result, Status* status);
+
+  // Waits until the read ahead, if any, completes.
+  void WaitForReadahead();
+
   RandomAccessFile* file_;  // Not owned.
   int64 pos_ = 0;           // Tracks where we are in the file.
   bool owns_file_ = false;
+  std::unique_ptr<Readahead> readahead_;  // Null if disabled.
 };
 
 }  // namespace io
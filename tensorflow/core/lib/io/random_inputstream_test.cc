@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/lib/io/random_inputstream.h"
 
+#include <atomic>
+
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
@@ -109,6 +111,74 @@ TEST(RandomInputStream, Seek) {
   EXPECT_EQ(5, in.Tell());
 }
 
+// Counts the reads of a file, and runs its ReadAsync() calls on another
+// thread.
+class AsyncCountingFile : public RandomAccessFile {
+ public:
+  explicit AsyncCountingFile(std::unique_ptr<RandomAccessFile> file)
+      : file_(std::move(file)) {}
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    ++num_reads_;
+    return file_->Read(offset, n, result, scratch);
+  }
+
+  void ReadAsync(uint64 offset, size_t n, char* scratch,
+                 ReadDoneCallback done) const override {
+    Env::Default()->SchedClosure([this, offset, n, scratch, done]() {
+      StringPiece result;
+      Status s = Read(offset, n, &result, scratch);
+      done(s, result);
+    });
+  }
+
+  int num_reads() const { return num_reads_; }
+
+ private:
+  std::unique_ptr<RandomAccessFile> file_;
+  mutable std::atomic<int> num_reads_{0};
+};
+
+TEST(RandomInputStream, Readahead) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/random_inputbuffer_readahead_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+
+  std::unique_ptr<RandomAccessFile> base_file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &base_file));
+  AsyncCountingFile file(std::move(base_file));
+  string read;
+  {
+    RandomAccessInputStream in(&file);
+    in.EnableReadahead();
+    TF_ASSERT_OK(in.ReadNBytes(3, &read));
+    EXPECT_EQ(read, "012");
+    TF_ASSERT_OK(in.ReadNBytes(3, &read));
+    EXPECT_EQ(read, "345");
+    TF_ASSERT_OK(in.ReadNBytes(3, &read));
+    EXPECT_EQ(read, "678");
+    EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(3, &read)));
+    EXPECT_EQ(read, "9");
+    EXPECT_EQ(10, in.Tell());
+    // Every read after the first one was read ahead.
+    EXPECT_EQ(4, file.num_reads());
+
+    // Reads elsewhere and of other sizes bypass the read ahead.
+    TF_ASSERT_OK(in.Seek(1));
+    TF_ASSERT_OK(in.ReadNBytes(4, &read));
+    EXPECT_EQ(read, "1234");
+    TF_ASSERT_OK(in.ReadNBytes(2, &read));
+    EXPECT_EQ(read, "56");
+    TF_ASSERT_OK(in.ReadNBytes(2, &read));
+    EXPECT_EQ(read, "78");
+    EXPECT_EQ(9, in.Tell());
+  }
+  // The reads at 1 and 5, the read ahead of 4 bytes at 5 and the read aheads
+  // at 7 and 9.
+  EXPECT_EQ(9, file.num_reads());
+}
+
 }  // anonymous namespace
 }  // namespace io
 }  // namespace tensorflow
@@ -60,6 +60,9 @@ RecordReader::RecordReader(RandomAccessFile* file,
       input_stream_(new RandomAccessInputStream(file)),
       last_read_failed_(false) {
   if (options.buffer_size > 0) {
+    // Buffered reads are sequential, so the next buffer is read ahead.
+    static_cast<RandomAccessInputStream*>(input_stream_.get())
+        ->EnableReadahead();
     input_stream_.reset(new BufferedInputStream(input_stream_.release(),
                                                 options.buffer_size, true));
   }
@@ -80,11 +83,13 @@ RecordReader::RecordReader(RandomAccessFile* file,
 }
 
 // Read n+4 bytes from file, verify that checksum of first n bytes is
-// stored in the last 4 bytes and store the first n bytes in *result.
+// stored in the last 4 bytes if verify_checksum is true, and store the first
+// n bytes in *result.
 //
 // offset corresponds to the user-provided value to ReadRecord()
 // and is used only in error messages.
-Status RecordReader::ReadChecksummed(uint64 offset, size_t n, string* result) {
+Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
+                                     bool verify_checksum, string* result) {
   if (n >= SIZE_MAX - sizeof(uint32)) {
     return errors::DataLoss("record size too large");
   }
@@ -100,9 +105,11 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n, string* result) {
     }
   }
 
-  const uint32 masked_crc = core::DecodeFixed32(result->data() + n);
-  if (crc32c::Unmask(masked_crc) != crc32c::Value(result->data(), n)) {
-    return errors::DataLoss("corrupted record at ", offset);
+  if (verify_checksum) {
+    const uint32 masked_crc = core::DecodeFixed32(result->data() + n);
+    if (crc32c::Unmask(masked_crc) != crc32c::Value(result->data(), n)) {
+      return errors::DataLoss("corrupted record at ", offset);
+    }
   }
   result->resize(n);
   return Status::OK();
@@ -128,7 +135,7 @@ Status RecordReader::GetMetadata(Metadata* md) {
     string record;
     while (true) {
       // Read header, containing size of data.
-      Status s = ReadChecksummed(offset, sizeof(uint64), &record);
+      Status s = ReadChecksummed(offset, sizeof(uint64), true, &record);
       if (!s.ok()) {
         if (errors::IsOutOfRange(s)) {
           // We should reach out of range when the record file is complete.
@@ -176,7 +183,7 @@ Status RecordReader::ReadRecord(uint64* offset, string* record) {
   DCHECK_EQ(desired_pos, input_stream_->Tell());
 
   // Read header data.
-  Status s = ReadChecksummed(*offset, sizeof(uint64), record);
+  Status s = ReadChecksummed(*offset, sizeof(uint64), true, record);
   if (!s.ok()) {
     last_read_failed_ = true;
     return s;
@@ -184,7 +191,10 @@ Status RecordReader::ReadRecord(uint64* offset, string* record) {
   const uint64 length = core::DecodeFixed64(record->data());
 
   // Read data
-  s = ReadChecksummed(*offset + kHeaderSize, length, record);
+  const int64 period = options_.data_checksum_period;
+  const bool verify_data =
+      period == 1 || (period > 0 && num_records_read_ % period == 0);
+  s = ReadChecksummed(*offset + kHeaderSize, length, verify_data, record);
   if (!s.ok()) {
     last_read_failed_ = true;
     if (errors::IsOutOfRange(s)) {
@@ -194,6 +204,7 @@ Status RecordReader::ReadRecord(uint64* offset, string* record) {
   }
 
   *offset += kHeaderSize + length + kFooterSize;
+  ++num_records_read_;
   DCHECK_EQ(*offset, input_stream_->Tell());
   return Status::OK();
 }
@@ -202,5 +213,130 @@ SequentialRecordReader::SequentialRecordReader(
     RandomAccessFile* file, const RecordReaderOptions& options)
     : underlying_(file, options), offset_(0) {}
 
+namespace {
+
+// "TFRIDX01", stored as a fixed64.
+const uint64 kRecordIndexMagic = 0x3130584449524654ull;
+
+// Verifies the masked crc that follows "n" bytes of "data".
+bool VerifyMaskedCrc(const char* data, size_t n) {
+  const uint32 masked_crc = core::DecodeFixed32(data + n);
+  return crc32c::Unmask(masked_crc) == crc32c::Value(data, n);
+}
+
+}  // namespace
+
+Status RecordIndex::Build(RandomAccessFile* file, uint64 file_size,
+                          RecordIndex* index) {
+  index->offsets_.clear();
+  const uint64 kOverhead =
+      RecordReader::kHeaderSize + RecordReader::kFooterSize;
+  uint64 offset = 0;
+  char scratch[RecordReader::kHeaderSize];
+  while (offset < file_size) {
+    if (file_size - offset < kOverhead) {
+      return errors::DataLoss("truncated record at ", offset);
+    }
+    StringPiece header;
+    Status s = file->Read(offset, sizeof(scratch), &header, scratch);
+    if (!s.ok() && !errors::IsOutOfRange(s)) return s;
+    if (header.size() != sizeof(scratch)) {
+      return errors::DataLoss("truncated record at ", offset);
+    }
+    if (!VerifyMaskedCrc(header.data(), sizeof(uint64))) {
+      return errors::DataLoss("corrupted record at ", offset);
+    }
+    // Compared this way round so that a huge length cannot overflow.
+    const uint64 length = core::DecodeFixed64(header.data());
+    if (length > file_size - offset - kOverhead) {
+      return errors::DataLoss("truncated record at ", offset);
+    }
+    index->Add(offset);
+    offset += kOverhead + length;
+  }
+  return Status::OK();
+}
+
+Status RecordIndex::ReadFromFile(Env* env, const string& fname,
+                                 RecordIndex* index) {
+  string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, fname, &contents));
+  const size_t kPrefixSize = 2 * sizeof(uint64);
+  if (contents.size() < kPrefixSize + sizeof(uint32) ||
+      core::DecodeFixed64(contents.data()) != kRecordIndexMagic) {
+    return errors::DataLoss("not a TFRecord index: ", fname);
+  }
+  const uint64 num_records = core::DecodeFixed64(contents.data() + 8);
+  if (num_records > (contents.size() - kPrefixSize) / sizeof(uint64) ||
+      contents.size() !=
+          kPrefixSize + num_records * sizeof(uint64) + sizeof(uint32)) {
+    return errors::DataLoss("truncated TFRecord index: ", fname);
+  }
+  if (!VerifyMaskedCrc(contents.data(), contents.size() - sizeof(uint32))) {
+    return errors::DataLoss("corrupted TFRecord index: ", fname);
+  }
+  index->offsets_.resize(num_records);
+  for (uint64 i = 0; i < num_records; ++i) {
+    index->offsets_[i] =
+        core::DecodeFixed64(contents.data() + kPrefixSize + i * sizeof(uint64));
+  }
+  return Status::OK();
+}
+
+Status RecordIndex::WriteToFile(Env* env, const string& fname) const {
+  string contents;
+  core::PutFixed64(&contents, kRecordIndexMagic);
+  core::PutFixed64(&contents, offsets_.size());
+  for (uint64 offset : offsets_) {
+    core::PutFixed64(&contents, offset);
+  }
+  const uint32 crc = crc32c::Value(contents.data(), contents.size());
+  core::PutFixed32(&contents, crc32c::Mask(crc));
+  return WriteStringToFile(env, fname, contents);
+}
+
+Status MemmappedRecordReader::Create(
+    Env* env, const string& fname,
+    std::unique_ptr<MemmappedRecordReader>* reader) {
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  TF_RETURN_IF_ERROR(env->NewReadOnlyMemoryRegionFromFile(fname, &region));
+  reader->reset(new MemmappedRecordReader(std::move(region)));
+  return Status::OK();
+}
+
+MemmappedRecordReader::MemmappedRecordReader(
+    std::unique_ptr<ReadOnlyMemoryRegion> region)
+    : region_(std::move(region)) {}
+
+MemmappedRecordReader::~MemmappedRecordReader() {}
+
+Status MemmappedRecordReader::ReadRecord(uint64* offset,
+                                         StringPiece* record) const {
+  const char* data = static_cast<const char*>(region_->data());
+  const uint64 size = region_->length();
+  if (*offset >= size) {
+    return errors::OutOfRange("eof");
+  }
+  if (size - *offset < RecordReader::kHeaderSize) {
+    return errors::DataLoss("truncated record at ", *offset);
+  }
+  const char* header = data + *offset;
+  if (!VerifyMaskedCrc(header, sizeof(uint64))) {
+    return errors::DataLoss("corrupted record at ", *offset);
+  }
+  const uint64 length = core::DecodeFixed64(header);
+  const uint64 available = size - *offset - RecordReader::kHeaderSize;
+  if (length > available || available - length < RecordReader::kFooterSize) {
+    return errors::DataLoss("truncated record at ", *offset);
+  }
+  const char* contents = header + RecordReader::kHeaderSize;
+  if (!VerifyMaskedCrc(contents, length)) {
+    return errors::DataLoss("corrupted record at ", *offset);
+  }
+  *record = StringPiece(contents, length);
+  *offset += RecordReader::kHeaderSize + length + RecordReader::kFooterSize;
+  return Status::OK();
+}
+
 }  // namespace io
 }  // namespace tensorflow
@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_LIB_IO_RECORD_READER_H_
 #define TENSORFLOW_CORE_LIB_IO_RECORD_READER_H_
 
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/io/inputstream_interface.h"
@@ -28,7 +31,9 @@ limitations under the License.
 
 namespace tensorflow {
 
+class Env;
 class RandomAccessFile;
+class ReadOnlyMemoryRegion;
 
 namespace io {
 
@@ -39,9 +44,17 @@ class RecordReaderOptions {
 
   // If buffer_size is non-zero, then all reads must be sequential, and no
   // skipping around is permitted. (Note: this is the same behavior as reading
-  // compressed files.) Consider using SequentialRecordReader.
+  // compressed files.) Consider using SequentialRecordReader. The next buffer
+  // is then read ahead with RandomAccessFile::ReadAsync().
   int64 buffer_size = 0;
 
+  // The data checksum of one record out of every data_checksum_period records
+  // is verified, and 0 skips data checksums entirely.  The header checksum of
+  // every record is always verified, since the length it protects is needed
+  // to parse the file.  Values other than 1 are only meant for trusted inputs
+  // whose checksums dominate the cost of reading them, e.g. local caches.
+  int64 data_checksum_period = 1;
+
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
@@ -103,11 +116,14 @@ class RecordReader {
   Status GetMetadata(Metadata* md);
 
  private:
-  Status ReadChecksummed(uint64 offset, size_t n, string* result);
+  Status ReadChecksummed(uint64 offset, size_t n, bool verify_checksum,
+                         string* result);
 
   RecordReaderOptions options_;
   std::unique_ptr<InputStreamInterface> input_stream_;
   bool last_read_failed_;
+  // Counts the records read, to sample data checksums.
+  int64 num_records_read_ = 0;
 
   std::unique_ptr<Metadata> cached_metadata_;
 
@@ -152,6 +168,79 @@ class SequentialRecordReader {
   uint64 offset_ = 0;
 };
 
+// The offsets of the records of an uncompressed TFRecord file, which give
+// O(1) access to record i, e.g. for global shuffling or sharding by record.
+//
+// An index is either built while writing the file (see
+// RecordWriter::set_record_index()) or by scanning an existing file, and is
+// stored next to it, conventionally as "<file>.index", in the format:
+//  uint64    magic number
+//  uint64    number of records N
+//  uint64    offset[N]
+//  uint32    masked crc of the above
+class RecordIndex {
+ public:
+  // Builds the index of "*file", which is "file_size" bytes long, by reading
+  // the header of every record.  Returns DATA_LOSS if the last record is
+  // truncated or a length runs past the end of the file.
+  static Status Build(RandomAccessFile* file, uint64 file_size,
+                      RecordIndex* index);
+
+  // Reads an index written by WriteToFile().
+  static Status ReadFromFile(Env* env, const string& fname,
+                             RecordIndex* index);
+
+  Status WriteToFile(Env* env, const string& fname) const;
+
+  // Appends the offset of the next record.
+  void Add(uint64 offset) { offsets_.push_back(offset); }
+
+  // Returns the number of records in the file.
+  size_t size() const { return offsets_.size(); }
+
+  // Returns the offset of record "i", to pass to ReadRecord().
+  // REQUIRES: i < size()
+  uint64 offset(size_t i) const { return offsets_[i]; }
+
+ private:
+  std::vector<uint64> offsets_;
+};
+
+// Reads the records of an uncompressed TFRecord file that is memory-mapped,
+// which is generally only supported for local files.  Records are returned as
+// views into the mapping instead of copies, and stay valid for the lifetime
+// of the reader.
+//
+// Unlike RecordReader, this class is thread safe: the reader has no current
+// position, and the records may be read in any order.
+class MemmappedRecordReader {
+ public:
+  // Maps "fname".  Returns an error, e.g. UNIMPLEMENTED, if the file system
+  // cannot map the file; callers can fall back to RecordReader.
+  static Status Create(Env* env, const string& fname,
+                       std::unique_ptr<MemmappedRecordReader>* reader);
+
+  explicit MemmappedRecordReader(std::unique_ptr<ReadOnlyMemoryRegion> region);
+  ~MemmappedRecordReader();
+
+  // Same as RecordReader::ReadRecord(), except that "*record" points into the
+  // mapped file.
+  Status ReadRecord(uint64* offset, StringPiece* record) const;
+
+  // Reads record "i" of "index".
+  // REQUIRES: i < index.size()
+  Status ReadRecord(const RecordIndex& index, size_t i,
+                    StringPiece* record) const {
+    uint64 offset = index.offset(i);
+    return ReadRecord(&offset, record);
+  }
+
+ private:
+  std::unique_ptr<ReadOnlyMemoryRegion> region_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemmappedRecordReader);
+};
+
 }  // namespace io
 }  // namespace tensorflow
 
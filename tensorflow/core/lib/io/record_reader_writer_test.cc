@@ -20,12 +20,15 @@ limitations under the License.
 #include <vector>
 #include "tensorflow/core/platform/env.h"
 
+#include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
@@ -196,6 +199,130 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestRecordIndex) {
+  Env* env = Env::Default();
+  const string fname = testing::TmpDir() + "/record_reader_writer_index_test";
+  const string index_fname = fname + ".index";
+
+  std::vector<string> records;
+  io::RecordIndex written_index;
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    writer.set_record_index(&written_index);
+    for (int i = 0; i < 100; ++i) {
+      records.push_back(string(i % 7, 'a' + i % 26));
+      TF_EXPECT_OK(writer.WriteRecord(records.back()));
+    }
+    TF_CHECK_OK(writer.Close());
+    TF_CHECK_OK(file->Close());
+  }
+  ASSERT_EQ(records.size(), written_index.size());
+  TF_ASSERT_OK(written_index.WriteToFile(env, index_fname));
+
+  // Scanning the file gives the same index.
+  io::RecordIndex built_index;
+  {
+    std::unique_ptr<RandomAccessFile> file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+    uint64 file_size;
+    TF_CHECK_OK(env->GetFileSize(fname, &file_size));
+    TF_ASSERT_OK(io::RecordIndex::Build(file.get(), file_size, &built_index));
+  }
+  io::RecordIndex index;
+  TF_ASSERT_OK(io::RecordIndex::ReadFromFile(env, index_fname, &index));
+  ASSERT_EQ(records.size(), built_index.size());
+  ASSERT_EQ(records.size(), index.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    EXPECT_EQ(written_index.offset(i), built_index.offset(i));
+    EXPECT_EQ(written_index.offset(i), index.offset(i));
+  }
+
+  // Reads the records out of order.
+  std::vector<size_t> order;
+  for (size_t i = 0; i < records.size(); ++i) {
+    order.push_back(i * 37 % records.size());
+  }
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+  io::RecordReader reader(file.get());
+  std::unique_ptr<io::MemmappedRecordReader> mapped_reader;
+  TF_ASSERT_OK(io::MemmappedRecordReader::Create(env, fname, &mapped_reader));
+  for (size_t i : order) {
+    uint64 offset = index.offset(i);
+    string record;
+    TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+    EXPECT_EQ(records[i], record);
+
+    StringPiece mapped_record;
+    TF_ASSERT_OK(mapped_reader->ReadRecord(index, i, &mapped_record));
+    EXPECT_EQ(records[i], mapped_record);
+  }
+  uint64 offset = index.offset(records.size() - 1);
+  StringPiece mapped_record;
+  TF_ASSERT_OK(mapped_reader->ReadRecord(&offset, &mapped_record));
+  EXPECT_EQ(error::OUT_OF_RANGE,
+            mapped_reader->ReadRecord(&offset, &mapped_record).code());
+
+  // A corrupted index is detected.
+  string contents;
+  TF_CHECK_OK(ReadFileToString(env, index_fname, &contents));
+  contents[20] ^= 1;
+  TF_CHECK_OK(WriteStringToFile(env, index_fname, contents));
+  EXPECT_EQ(error::DATA_LOSS,
+            io::RecordIndex::ReadFromFile(env, index_fname, &index).code());
+}
+
+TEST(RecordReaderWriterTest, TestRecordIndexOfTruncatedFile) {
+  Env* env = Env::Default();
+  const string fname =
+      testing::TmpDir() + "/record_reader_writer_truncated_index_test";
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_EXPECT_OK(writer.WriteRecord("defghijk"));
+    TF_CHECK_OK(writer.Close());
+    TF_CHECK_OK(file->Close());
+  }
+  string contents;
+  TF_CHECK_OK(ReadFileToString(env, fname, &contents));
+  const size_t first_record_size =
+      io::RecordReader::kHeaderSize + 3 + io::RecordReader::kFooterSize;
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+  io::RecordIndex index;
+  TF_ASSERT_OK(io::RecordIndex::Build(file.get(), contents.size(), &index));
+  ASSERT_EQ(2, index.size());
+
+  // Cutting the file anywhere inside the second record, including in its
+  // header, its data or its footer, is detected.
+  for (size_t size = first_record_size + 1; size < contents.size(); ++size) {
+    EXPECT_EQ(error::DATA_LOSS,
+              io::RecordIndex::Build(file.get(), size, &index).code())
+        << size;
+  }
+  TF_ASSERT_OK(io::RecordIndex::Build(file.get(), first_record_size, &index));
+  EXPECT_EQ(1, index.size());
+
+  // So is a corrupted length that runs past the end of the file, even one that
+  // would overflow the offset of the next record.
+  contents = contents.substr(0, first_record_size);
+  string header;
+  core::PutFixed64(&header, ~0ull);
+  core::PutFixed32(&header,
+                   crc32c::Mask(crc32c::Value(header.data(), header.size())));
+  contents += header + "lmn";
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+  EXPECT_EQ(error::DATA_LOSS,
+            io::RecordIndex::Build(file.get(), contents.size(), &index).code());
+}
+
 TEST(RecordReaderWriterTest, TestUseAfterClose) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_flush_close_test";
@@ -219,4 +346,52 @@ TEST(RecordReaderWriterTest, TestUseAfterClose) {
   }
 }
 
+// Reads a file of kBenchmarkFileBytes of records of "record_size" bytes,
+// verifying the data checksums of one record out of "data_checksum_period".
+static void BM_ReadRecords(int iters, int record_size,
+                           int data_checksum_period) {
+  testing::StopTiming();
+  const int64 kBenchmarkFileBytes = 2LL << 30;
+  Env* env = Env::Default();
+  const string fname = strings::StrCat(
+      testing::TmpDir(), "/record_reader_benchmark_", record_size);
+  const int64 num_records =
+      kBenchmarkFileBytes /
+      (io::RecordWriter::kHeaderSize + record_size +
+       io::RecordWriter::kFooterSize);
+  if (!env->FileExists(fname).ok()) {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    const string record(record_size, 'x');
+    for (int64 i = 0; i < num_records; ++i) {
+      TF_CHECK_OK(writer.WriteRecord(record));
+    }
+    TF_CHECK_OK(writer.Close());
+    TF_CHECK_OK(file->Close());
+  }
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+  io::RecordReaderOptions options;
+  options.buffer_size = 256 << 10;
+  options.data_checksum_period = data_checksum_period;
+  testing::BytesProcessed(static_cast<int64>(iters) * num_records *
+                          record_size);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    io::SequentialRecordReader reader(file.get(), options);
+    string record;
+    int64 n = 0;
+    while (reader.ReadRecord(&record).ok()) ++n;
+    CHECK_EQ(num_records, n);
+  }
+}
+BENCHMARK(BM_ReadRecords)
+    ->ArgPair(256, 1)
+    ->ArgPair(256, 0)
+    ->ArgPair(64 << 10, 1)
+    ->ArgPair(64 << 10, 16)
+    ->ArgPair(64 << 10, 0);
+
 }  // namespace tensorflow
@@ -33,6 +33,8 @@ class WritableFile;
 
 namespace io {
 
+class RecordIndex;
+
 class RecordWriterOptions {
  public:
   enum CompressionType { NONE = 0, ZLIB_COMPRESSION = 1 };
@@ -82,6 +84,12 @@ class RecordWriter {
   // are invalid.
   Status Close();
 
+  // If "index" is not null, adds the offset of every record written from now
+  // on to "*index", e.g. to write it with RecordIndex::WriteToFile() once the
+  // file is complete.  "*index" must remain live while this Writer is in use.
+  // REQUIRES: the records are not compressed.
+  void set_record_index(RecordIndex* index) { index_ = index; }
+
   // Utility method to populate TFRecord headers.  Populates record-header in
   // "header[0,kHeaderSize-1]".  The record-header is based on data[0, n-1].
   inline static void PopulateHeader(char* header, const char* data, size_t n);
@@ -93,6 +101,9 @@ class RecordWriter {
  private:
   WritableFile* dest_;
   RecordWriterOptions options_;
+  // Bytes of records written to "dest_", before compression.
+  uint64 offset_ = 0;
+  RecordIndex* index_ = nullptr;  // Not owned.
 
   inline static uint32 MaskedCrc(const char* data, size_t n) {
     return crc32c::Mask(crc32c::Value(data, n));
@@ -336,6 +336,52 @@ TEST_F(RecordioTest, CorruptDataCrc) {
   AssertHasSubstr(Read(), "Data loss");
 }
 
+TEST_F(RecordioTest, DataChecksumPeriod) {
+  string contents;
+  StringDest dst(&contents);
+  RecordWriter writer(&dst);
+  for (int i = 0; i < 4; ++i) {
+    TF_ASSERT_OK(writer.WriteRecord("foo"));
+  }
+  // Corrupts the data of the second record.
+  const size_t record_size =
+      RecordReader::kHeaderSize + 3 + RecordReader::kFooterSize;
+  contents[record_size + RecordReader::kHeaderSize] = 'g';
+
+  StringSource file(&contents);
+  for (int64 period : {0, 1, 2, 3}) {
+    RecordReaderOptions options;
+    options.data_checksum_period = period;
+    RecordReader reader(&file, options);
+    uint64 offset = 0;
+    string record;
+    TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+    EXPECT_EQ("foo", record);
+    Status s = reader.ReadRecord(&offset, &record);
+    if (period == 1) {
+      // The other periods skip the checksum of the second record.
+      AssertHasSubstr(s.ToString(), "Data loss");
+      continue;
+    }
+    TF_ASSERT_OK(s);
+    EXPECT_EQ("goo", record);
+    for (int i = 2; i < 4; ++i) {
+      TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ("foo", record);
+    }
+  }
+
+  // Header checksums are always verified.
+  contents[0] += 1;
+  RecordReaderOptions options;
+  options.data_checksum_period = 0;
+  RecordReader reader(&file, options);
+  uint64 offset = 0;
+  string record;
+  AssertHasSubstr(reader.ReadRecord(&offset, &record).ToString(),
+                  "Data loss");
+}
+
 TEST_F(RecordioTest, ReadEnd) { CheckOffsetPastEndReturnsNoRecords(0); }
 
 TEST_F(RecordioTest, ReadPastEnd) { CheckOffsetPastEndReturnsNoRecords(5); }
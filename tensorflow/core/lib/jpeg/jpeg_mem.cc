@@ -575,6 +575,96 @@ bool GetImageInfo(const void* srcdata, int datasize, int* width, int* height,
   return true;
 }
 
+// -----------------------------------------------------------------------------
+// Entropy decoding only.
+bool DecodeCoefficients(const void* srcdata, int datasize,
+                        const UncompressFlags& flags, CoefficientImage* image,
+                        std::function<JCOEF*(int64)> allocate_coefficients) {
+  // If empty image, return
+  if (datasize == 0 || srcdata == nullptr) return false;
+
+  // Initialize libjpeg structures to have a memory source
+  // Modify the usual jpeg error manager to catch fatal errors.
+  struct jpeg_decompress_struct cinfo;
+  struct jpeg_error_mgr jerr;
+  jmp_buf jpeg_jmpbuf;
+  cinfo.err = jpeg_std_error(&jerr);
+  cinfo.client_data = &jpeg_jmpbuf;
+  jerr.error_exit = CatchError;
+  if (setjmp(jpeg_jmpbuf)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+
+  jpeg_create_decompress(&cinfo);
+  SetSrc(&cinfo, srcdata, datasize, flags.try_recover_truncated_jpeg);
+  jpeg_read_header(&cinfo, TRUE);
+
+  const int64 total_size = static_cast<int64>(cinfo.image_height) *
+                           static_cast<int64>(cinfo.image_width);
+  if (cinfo.image_width <= 0 || cinfo.image_height <= 0) {
+    LOG(ERROR) << "Invalid image size: " << cinfo.image_width << " x "
+               << cinfo.image_height;
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  if (total_size >= (1LL << 29)) {
+    LOG(ERROR) << "Image too large: " << total_size;
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+
+  jvirt_barray_ptr* coefficients = jpeg_read_coefficients(&cinfo);
+
+  image->width = cinfo.image_width;
+  image->height = cinfo.image_height;
+  image->color_space = cinfo.jpeg_color_space;
+  image->max_h_samp_factor = cinfo.max_h_samp_factor;
+  image->max_v_samp_factor = cinfo.max_v_samp_factor;
+  image->components.resize(cinfo.num_components);
+  int64 num_coefficients = 0;
+  for (int c = 0; c < cinfo.num_components; ++c) {
+    const jpeg_component_info& info = cinfo.comp_info[c];
+    if (info.quant_table == nullptr) {
+      jpeg_destroy_decompress(&cinfo);
+      return false;
+    }
+    ComponentCoefficients& component = image->components[c];
+    component.h_samp_factor = info.h_samp_factor;
+    component.v_samp_factor = info.v_samp_factor;
+    component.width = info.downsampled_width;
+    component.height = info.downsampled_height;
+    component.width_in_blocks = info.width_in_blocks;
+    component.height_in_blocks = info.height_in_blocks;
+    std::copy(info.quant_table->quantval,
+              info.quant_table->quantval + DCTSIZE2, component.quant_table);
+    component.offset = num_coefficients;
+    num_coefficients += static_cast<int64>(info.width_in_blocks) *
+                        info.height_in_blocks * DCTSIZE2;
+  }
+
+  JCOEF* output = allocate_coefficients(num_coefficients);
+  if (output == nullptr) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  for (int c = 0; c < cinfo.num_components; ++c) {
+    const ComponentCoefficients& component = image->components[c];
+    const int64 row_size =
+        static_cast<int64>(component.width_in_blocks) * DCTSIZE2;
+    for (int row = 0; row < component.height_in_blocks; ++row) {
+      JBLOCKARRAY blocks = (*cinfo.mem->access_virt_barray)(
+          reinterpret_cast<j_common_ptr>(&cinfo), coefficients[c], row, 1,
+          FALSE);
+      memcpy(output + component.offset + row * row_size, blocks[0],
+             row_size * sizeof(JCOEF));
+    }
+  }
+
+  jpeg_destroy_decompress(&cinfo);
+  return true;
+}
+
 // -----------------------------------------------------------------------------
 // Compression
 
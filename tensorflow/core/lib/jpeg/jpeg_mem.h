@@ -23,6 +23,7 @@ limitations under the License.
 
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/platform/jpeg.h"
@@ -105,6 +106,46 @@ uint8* Uncompress(const void* srcdata, int datasize,
 bool GetImageInfo(const void* srcdata, int datasize, int* width, int* height,
                   int* components);
 
+// The quantized DCT coefficients of one component of a JPEG image.
+struct ComponentCoefficients {
+  // Sampling factors of the component.
+  int h_samp_factor = 1;
+  int v_samp_factor = 1;
+  // Size of the component in samples and in 8x8 blocks.
+  int width = 0;
+  int height = 0;
+  int width_in_blocks = 0;
+  int height_in_blocks = 0;
+  // Quantization table, in natural (row-major) order.
+  uint16 quant_table[DCTSIZE2];
+  // Index of the first coefficient of the component in the coefficient
+  // buffer. The blocks are stored row by row, with the DCTSIZE2 coefficients
+  // of each block in natural order.
+  int64 offset = 0;
+};
+
+// The output of the entropy decoding stage of a JPEG image: what is left to
+// do is the dequantization, the inverse DCT, the upsampling of the
+// subsampled components and the color conversion.
+struct CoefficientImage {
+  int width = 0;
+  int height = 0;
+  J_COLOR_SPACE color_space = JCS_UNKNOWN;
+  int max_h_samp_factor = 1;
+  int max_v_samp_factor = 1;
+  std::vector<ComponentCoefficients> components;
+};
+
+// Entropy decodes the raw JPEG data given by the pointer srcdata and the
+// length datasize, without running the inverse DCT. The callback is called
+// with the total number of coefficients of all the components, and returns
+// the buffer where they are stored. The caller is responsible for freeing
+// that buffer *even along error paths*. Of the flags only
+// try_recover_truncated_jpeg is used. Returns true on success.
+bool DecodeCoefficients(const void* srcdata, int datasize,
+                        const UncompressFlags& flags, CoefficientImage* image,
+                        std::function<JCOEF*(int64)> allocate_coefficients);
+
 // Note: (format & 0xff) = number of components (<=> bytes per pixels)
 enum Format {
   FORMAT_GRAYSCALE = 0x001,  // 1 byte/pixel
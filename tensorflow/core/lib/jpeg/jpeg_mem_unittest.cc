@@ -20,7 +20,9 @@ limitations under the License.
 #include <stdlib.h>
 #include <string.h>
 
+#include <cmath>
 #include <memory>
+#include <vector>
 
 #include "tensorflow/core/lib/jpeg/jpeg_handle.h"
 #include "tensorflow/core/platform/env.h"
@@ -519,6 +521,69 @@ TEST(JpegMemTest, BadJpeg) {
   TestBadJPEG(env, data_path + "corrupt34_4.jpg", 2544, 3300, "", true);
 }
 
+TEST(JpegMemTest, DecodeCoefficients) {
+  Env* env = Env::Default();
+  const string data_path = kTestData;
+  string jpeg;
+  ReadFileToStringOrDie(env, data_path + "jpeg_merge_test1.jpg", &jpeg);
+  UncompressFlags flags;
+  CoefficientImage image;
+  std::vector<JCOEF> coefficients;
+  ASSERT_TRUE(DecodeCoefficients(jpeg.data(), jpeg.size(), flags, &image,
+                                 [&coefficients](int64 size) {
+                                   coefficients.resize(size);
+                                   return coefficients.data();
+                                 }));
+
+  int width, height, components;
+  ASSERT_TRUE(
+      GetImageInfo(jpeg.data(), jpeg.size(), &width, &height, &components));
+  EXPECT_EQ(width, image.width);
+  EXPECT_EQ(height, image.height);
+  EXPECT_EQ(JCS_YCbCr, image.color_space);
+  ASSERT_EQ(3, image.components.size());
+  const ComponentCoefficients& luma = image.components[0];
+  EXPECT_EQ(width, luma.width);
+  EXPECT_EQ(height, luma.height);
+  EXPECT_EQ((width + DCTSIZE - 1) / DCTSIZE, luma.width_in_blocks);
+  EXPECT_EQ(0, luma.offset);
+  EXPECT_EQ(static_cast<int64>(luma.width_in_blocks) * luma.height_in_blocks *
+                DCTSIZE2,
+            image.components[1].offset);
+
+  // The inverse DCT of the first luma block gives the top-left corner of the
+  // grayscale image, up to the rounding of the integer DCT.
+  flags.components = 1;
+  std::unique_ptr<uint8[]> gray(
+      Uncompress(jpeg.data(), jpeg.size(), flags, nullptr, nullptr, nullptr,
+                 nullptr));
+  ASSERT_NE(nullptr, gray.get());
+  const float kPi = 3.14159265358979f;
+  for (int y = 0; y < DCTSIZE; ++y) {
+    for (int x = 0; x < DCTSIZE; ++x) {
+      float value = 128.f;
+      for (int v = 0; v < DCTSIZE; ++v) {
+        for (int u = 0; u < DCTSIZE; ++u) {
+          const float cu = u == 0 ? std::sqrt(0.5f) : 1.f;
+          const float cv = v == 0 ? std::sqrt(0.5f) : 1.f;
+          value += cu * cv / 4 * coefficients[v * DCTSIZE + u] *
+                   luma.quant_table[v * DCTSIZE + u] *
+                   std::cos((2 * x + 1) * u * kPi / 16) *
+                   std::cos((2 * y + 1) * v * kPi / 16);
+        }
+      }
+      value = std::min(255.f, std::max(0.f, std::round(value)));
+      EXPECT_NEAR(value, gray[y * width + x], 2) << x << "," << y;
+    }
+  }
+
+  EXPECT_FALSE(DecodeCoefficients(jpeg.data(), 10, flags, &image,
+                                  [&coefficients](int64 size) {
+                                    coefficients.resize(size);
+                                    return coefficients.data();
+                                  }));
+}
+
 }  // namespace
 }  // namespace jpeg
 }  // namespace tensorflow
@@ -0,0 +1,159 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/monitoring/prometheus_exporter.h"
+
+#include <float.h>
+
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace monitoring {
+
+namespace {
+
+string PrometheusName(const string& name) {
+  string result;
+  for (char c : name) {
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+        (c >= '0' && c <= '9') || c == '_' || c == ':') {
+      result += c;
+    } else if (!result.empty()) {
+      result += '_';
+    }
+  }
+  if (result.empty() || (result[0] >= '0' && result[0] <= '9')) {
+    result.insert(0, "_");
+  }
+  return result;
+}
+
+// Escapes `s` for a HELP line or, if `quote` is true, for a label value.
+string Escape(const string& s, bool quote) {
+  string result;
+  for (char c : s) {
+    if (c == '\\') {
+      result += "\\\\";
+    } else if (c == '\n') {
+      result += "\\n";
+    } else if (c == '"' && quote) {
+      result += "\\\"";
+    } else {
+      result += c;
+    }
+  }
+  return result;
+}
+
+// Returns the labels of `point`, followed by `extra_label` if it is not
+// empty, in braces, or an empty string if there are none.
+string Labels(const Point& point, const string& extra_label = "") {
+  string result;
+  for (const Point::Label& label : point.labels) {
+    strings::StrAppend(&result, result.empty() ? "{" : ",",
+                       PrometheusName(label.name), "=\"",
+                       Escape(label.value, true), "\"");
+  }
+  if (!extra_label.empty()) {
+    strings::StrAppend(&result, result.empty() ? "{" : ",", extra_label);
+  }
+  if (!result.empty()) {
+    result += "}";
+  }
+  return result;
+}
+
+void AppendHistogram(const string& name, const Point& point, string* output) {
+  const HistogramProto& histogram = point.histogram_value;
+  double count = 0;
+  for (int i = 0; i < histogram.bucket_size(); ++i) {
+    count += histogram.bucket(i);
+    const double limit = i < histogram.bucket_limit_size()
+                             ? histogram.bucket_limit(i)
+                             : DBL_MAX;
+    const string le = limit == DBL_MAX ? string("+Inf")
+                                       : strings::StrCat(limit);
+    strings::StrAppend(output, name, "_bucket",
+                       Labels(point, strings::StrCat("le=\"", le, "\"")), " ",
+                       count, "\n");
+  }
+  strings::StrAppend(output, name, "_sum", Labels(point), " ", histogram.sum(),
+                     "\n");
+  strings::StrAppend(output, name, "_count", Labels(point), " ",
+                     histogram.num(), "\n");
+}
+
+}  // namespace
+
+string FormatPrometheusText(const CollectedMetrics& metrics) {
+  string output;
+  for (const auto& entry : metrics.point_set_map) {
+    const auto descriptor = metrics.metric_descriptor_map.find(entry.first);
+    const string name = PrometheusName(entry.first);
+    const PointSet& point_set = *entry.second;
+    if (point_set.points.empty()) {
+      continue;
+    }
+    const ValueType value_type = point_set.points[0]->value_type;
+    const char* type;
+    if (value_type == ValueType::kHistogram) {
+      type = "histogram";
+    } else if (descriptor != metrics.metric_descriptor_map.end() &&
+               descriptor->second->metric_kind == MetricKind::kCumulative) {
+      type = "counter";
+    } else {
+      type = "gauge";
+    }
+    if (descriptor != metrics.metric_descriptor_map.end()) {
+      strings::StrAppend(&output, "# HELP ", name, " ",
+                         Escape(descriptor->second->description, false),
+                         "\n");
+    }
+    strings::StrAppend(&output, "# TYPE ", name, " ", type, "\n");
+    for (const auto& point : point_set.points) {
+      switch (point->value_type) {
+        case ValueType::kInt64:
+          strings::StrAppend(&output, name, Labels(*point), " ",
+                             point->int64_value, "\n");
+          break;
+        case ValueType::kBool:
+          strings::StrAppend(&output, name, Labels(*point), " ",
+                             point->bool_value ? 1 : 0, "\n");
+          break;
+        case ValueType::kString:
+          strings::StrAppend(
+              &output, name,
+              Labels(*point, strings::StrCat(
+                                 "value=\"",
+                                 Escape(point->string_value, true), "\"")),
+              " 1\n");
+          break;
+        case ValueType::kHistogram:
+          AppendHistogram(name, *point, &output);
+          break;
+      }
+    }
+  }
+  return output;
+}
+
+string ExportPrometheusText() {
+  return FormatPrometheusText(*CollectionRegistry::Default()->CollectMetrics(
+      CollectionRegistry::CollectMetricsOptions()));
+}
+
+}  // namespace monitoring
+}  // namespace tensorflow
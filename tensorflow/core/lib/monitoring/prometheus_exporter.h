@@ -0,0 +1,43 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_MONITORING_PROMETHEUS_EXPORTER_H_
+#define TENSORFLOW_CORE_LIB_MONITORING_PROMETHEUS_EXPORTER_H_
+
+#include "tensorflow/core/lib/monitoring/collected_metrics.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace monitoring {
+
+// Formats `metrics` in the Prometheus text exposition format.
+//
+// The metric names are turned into Prometheus names by dropping the leading
+// '/' and replacing the other invalid characters with '_', e.g.
+// "/tensorflow/core/graph_runs" becomes "tensorflow_core_graph_runs".
+// Cumulative int64 metrics are exported as counters, int64 and bool gauges as
+// gauges, and samplers as histograms. Prometheus has no string values, so a
+// string gauge is exported as a gauge of 1 with the string in a "value"
+// label.
+string FormatPrometheusText(const CollectedMetrics& metrics);
+
+// Collects all the metrics of the default CollectionRegistry and formats them
+// in the Prometheus text exposition format.
+string ExportPrometheusText();
+
+}  // namespace monitoring
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_MONITORING_PROMETHEUS_EXPORTER_H_
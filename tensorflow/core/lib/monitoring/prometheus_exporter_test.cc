@@ -0,0 +1,75 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/monitoring/prometheus_exporter.h"
+
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace monitoring {
+namespace {
+
+auto* counter = Counter<1>::New("/tensorflow/test/prometheus/counter",
+                                "A \\ counter.", "my-label");
+
+auto* gauge = Gauge<string, 0>::New("/tensorflow/test/prometheus/gauge",
+                                    "A string gauge.");
+
+auto* sampler = Sampler<0>::New(
+    {"/tensorflow/test/prometheus/sampler", "A sampler."},
+    Buckets::Explicit({10.0, 20.0}));
+
+TEST(PrometheusExporterTest, ExportsCounters) {
+  counter->GetCell("a\"b")->IncrementBy(3);
+  const string text = ExportPrometheusText();
+  EXPECT_NE(string::npos,
+            text.find("# HELP tensorflow_test_prometheus_counter "
+                      "A \\\\ counter.\n"
+                      "# TYPE tensorflow_test_prometheus_counter counter\n"
+                      "tensorflow_test_prometheus_counter"
+                      "{my_label=\"a\\\"b\"} 3\n"));
+}
+
+TEST(PrometheusExporterTest, ExportsStringGauges) {
+  gauge->GetCell()->Set("v1");
+  const string text = ExportPrometheusText();
+  EXPECT_NE(string::npos,
+            text.find("# TYPE tensorflow_test_prometheus_gauge gauge\n"
+                      "tensorflow_test_prometheus_gauge{value=\"v1\"} 1\n"));
+}
+
+TEST(PrometheusExporterTest, ExportsHistograms) {
+  sampler->GetCell()->Add(5);
+  sampler->GetCell()->Add(15);
+  sampler->GetCell()->Add(25);
+  const string text = ExportPrometheusText();
+  EXPECT_NE(string::npos,
+            text.find("# TYPE tensorflow_test_prometheus_sampler histogram\n"
+                      "tensorflow_test_prometheus_sampler_bucket"
+                      "{le=\"10\"} 1\n"
+                      "tensorflow_test_prometheus_sampler_bucket"
+                      "{le=\"20\"} 2\n"
+                      "tensorflow_test_prometheus_sampler_bucket"
+                      "{le=\"+Inf\"} 3\n"
+                      "tensorflow_test_prometheus_sampler_sum 45\n"
+                      "tensorflow_test_prometheus_sampler_count 3\n"));
+}
+
+}  // namespace
+}  // namespace monitoring
+}  // namespace tensorflow
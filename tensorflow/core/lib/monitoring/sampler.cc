@@ -22,6 +22,9 @@ limitations under the License.
 // Do nothing.
 #else
 
+#include <algorithm>
+#include <atomic>
+
 namespace tensorflow {
 namespace monitoring {
 namespace {
@@ -92,6 +95,41 @@ class ExponentialBuckets : public Buckets {
 
 }  // namespace
 
+SamplerCell::SamplerCell(const std::vector<double>& bucket_limits) {
+  for (auto& shard : shards_) {
+    shard.reset(new histogram::ThreadSafeHistogram(bucket_limits));
+  }
+}
+
+// static
+int SamplerCell::ThreadShard() {
+  static std::atomic<int> next_shard(0);
+  static thread_local int shard = next_shard++ % kNumShards;
+  return shard;
+}
+
+HistogramProto SamplerCell::value() const {
+  HistogramProto pb;
+  shards_[0]->EncodeToProto(&pb, true /* preserve_zero_buckets */);
+  for (int i = 1; i < kNumShards; ++i) {
+    HistogramProto shard;
+    shards_[i]->EncodeToProto(&shard, true /* preserve_zero_buckets */);
+    if (shard.num() == 0) {
+      continue;
+    }
+    // All the shards have the same buckets.
+    pb.set_min(std::min(pb.min(), shard.min()));
+    pb.set_max(std::max(pb.max(), shard.max()));
+    pb.set_num(pb.num() + shard.num());
+    pb.set_sum(pb.sum() + shard.sum());
+    pb.set_sum_squares(pb.sum_squares() + shard.sum_squares());
+    for (int j = 0; j < shard.bucket_size(); ++j) {
+      pb.set_bucket(j, pb.bucket(j) + shard.bucket(j));
+    }
+  }
+  return pb;
+}
+
 // static
 std::unique_ptr<Buckets> Buckets::Explicit(
     std::initializer_list<double> bucket_limits) {
@@ -25,6 +25,7 @@ limitations under the License.
 
 #include <float.h>
 #include <map>
+#include <memory>
 
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/lib/histogram/histogram.h"
@@ -45,11 +46,14 @@ namespace monitoring {
 // to which both cells belong) and performance (since map indexing and
 // associated locking are both avoided).
 //
+// The samples are added to one of several histograms, picked by the calling
+// thread, so that threads adding samples concurrently rarely contend for the
+// same lock.
+//
 // This class is thread-safe.
 class SamplerCell {
  public:
-  SamplerCell(const std::vector<double>& bucket_limits)
-      : histogram_(bucket_limits) {}
+  SamplerCell(const std::vector<double>& bucket_limits);
 
   ~SamplerCell() {}
 
@@ -60,7 +64,12 @@ class SamplerCell {
   HistogramProto value() const;
 
  private:
-  histogram::ThreadSafeHistogram histogram_;
+  static constexpr int kNumShards = 8;
+
+  // Returns the shard the calling thread adds its samples to.
+  static int ThreadShard();
+
+  std::unique_ptr<histogram::ThreadSafeHistogram> shards_[kNumShards];
 
   TF_DISALLOW_COPY_AND_ASSIGN(SamplerCell);
 };
@@ -172,12 +181,8 @@ class Sampler {
 //  Implementation details follow. API readers may skip.
 ////
 
-inline void SamplerCell::Add(const double sample) { histogram_.Add(sample); }
-
-inline HistogramProto SamplerCell::value() const {
-  HistogramProto pb;
-  histogram_.EncodeToProto(&pb, true /* preserve_zero_buckets */);
-  return pb;
+inline void SamplerCell::Add(const double sample) {
+  shards_[ThreadShard()]->Add(sample);
 }
 
 template <int NumLabels>
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/lib/monitoring/sampler.h"
 
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -58,6 +59,26 @@ TEST(LabeledSamplerTest, ExplicitBucketBoundaries) {
   EqHistograms(expected, cell->value());
 }
 
+TEST(LabeledSamplerTest, MergesSamplesFromAllThreads) {
+  Histogram expected({10.0, 20.0, DBL_MAX});
+  auto* cell = sampler_with_labels->GetCell("AllThreads");
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int i = 0; i < 16; ++i) {
+    for (int j = 0; j < 10; ++j) {
+      expected.Add(i * j);
+    }
+    threads.emplace_back(Env::Default()->StartThread(
+        ThreadOptions(), "sampler_test", [cell, i]() {
+          for (int j = 0; j < 10; ++j) {
+            cell->Add(i * j);
+          }
+        }));
+  }
+  threads.clear();
+
+  EqHistograms(expected, cell->value());
+}
+
 auto* init_sampler_without_labels =
     Sampler<0>::New({"/tensorflow/test/init_sampler_without_labels",
                      "Sampler without labels initialized as empty."},
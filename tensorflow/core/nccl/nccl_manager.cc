@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/cuda.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -47,8 +48,9 @@ struct NcclManager::NcclStream {
   std::unique_ptr<Thread> thread;
   mutex mu;
   condition_variable cv;
-  // Has collective,rank pairs.
-  std::deque<std::pair<Collective*, int>> pending_launches_ GUARDED_BY(mu);
+  // Has pairs of a group of collectives, launched together, and a rank.
+  std::deque<std::pair<std::vector<Collective*>, int>> pending_launches_
+      GUARDED_BY(mu);
   bool shutdown_requested GUARDED_BY(mu) = false;
 };
 
@@ -74,6 +76,20 @@ struct NcclManager::Communicator {
 };
 
 namespace {
+// Launching more collectives at once than this does not reduce the
+// overhead per collective any further.
+constexpr size_t kMaxGroupSize = 128;
+
+int64 GroupWindowMicrosFromEnv() {
+  int64 group_window_micros = 0;
+  Status status = ReadInt64FromEnvVar("TF_NCCL_GROUP_WINDOW_MICROS", 0,
+                                      &group_window_micros);
+  if (!status.ok()) {
+    LOG(ERROR) << status.error_message();
+  }
+  return group_window_micros;
+}
+
 ncclDataType_t ToNcclType(DataType t) {
   switch (t) {
     case DT_HALF:
@@ -170,7 +186,9 @@ struct NcclManager::Collective {
   mutable std::atomic_int_fast32_t remaining_participants;
 };
 
-NcclManager::NcclManager() {}
+NcclManager::NcclManager() : NcclManager(GroupWindowMicrosFromEnv()) {}
+NcclManager::NcclManager(int64 group_window_micros)
+    : group_window_micros_(group_window_micros) {}
 NcclManager::~NcclManager() {}
 NcclManager* NcclManager::instance() {
   static NcclManager* instance = new NcclManager();
@@ -398,8 +416,6 @@ void NcclManager::AddParticipant(int num_devices, const string& key,
 }
 
 void NcclManager::RunCollective(const string& key, Collective* collective) {
-  static mutex collective_mu(LINKER_INITIALIZED);
-
   auto* communicator = GetCommunicator(collective);
   collective->communicator = communicator;
   const int size = communicator->num_devices;
@@ -425,20 +441,60 @@ void NcclManager::RunCollective(const string& key, Collective* collective) {
     CHECK_NE(collective->root_rank, -1);
   }
 
+  if (group_window_micros_ <= 0) {
+    LaunchGroup({collective});
+    return;
+  }
+
+  // Holds the collective until the grouping window of the first collective
+  // held for the communicator expires, or the group is full.
+  bool start_window = false;
+  std::vector<Collective*> full_group;
   {
-    // Allow only one collective at a time to queue kernels for launching. This
-    // is to prevent collectives from deadlocking each other.
-    // Note that it would be possible to run multiple collectives at once, if
-    // they have non-intersecting sets of devices.
-    mutex_lock l(collective_mu);
-    for (int rank = 0; rank < size; ++rank) {
-      NcclStream* nccl_stream = communicator->members[rank].nccl_stream;
-      mutex_lock l(nccl_stream->mu);
-      nccl_stream->pending_launches_.push_front(
-          std::make_pair(collective, rank));
-      nccl_stream->cv.notify_all();
+    mutex_lock l(group_mu_);
+    std::vector<Collective*>& group = pending_groups_[communicator];
+    start_window = group.empty();
+    group.push_back(collective);
+    if (group.size() >= kMaxGroupSize) {
+      full_group.swap(group);
     }
   }
+  if (!full_group.empty()) {
+    LaunchGroup(std::move(full_group));
+  } else if (start_window) {
+    Env::Default()->SchedClosureAfter(
+        group_window_micros_,
+        [this, communicator]() { FlushGroup(communicator); });
+  }
+}
+
+void NcclManager::FlushGroup(Communicator* communicator) {
+  std::vector<Collective*> group;
+  {
+    mutex_lock l(group_mu_);
+    group.swap(pending_groups_[communicator]);
+  }
+  if (!group.empty()) {
+    LaunchGroup(std::move(group));
+  }
+}
+
+void NcclManager::LaunchGroup(std::vector<Collective*> group) {
+  static mutex collective_mu(LINKER_INITIALIZED);
+
+  Communicator* communicator = group.front()->communicator;
+  const int size = communicator->num_devices;
+  // Allow only one group at a time to queue kernels for launching. This
+  // is to prevent collectives from deadlocking each other.
+  // Note that it would be possible to run multiple collectives at once, if
+  // they have non-intersecting sets of devices.
+  mutex_lock l(collective_mu);
+  for (int rank = 0; rank < size; ++rank) {
+    NcclStream* nccl_stream = communicator->members[rank].nccl_stream;
+    mutex_lock l(nccl_stream->mu);
+    nccl_stream->pending_launches_.push_front(std::make_pair(group, rank));
+    nccl_stream->cv.notify_all();
+  }
 }
 
 void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
@@ -448,8 +504,8 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
       comm_stream->implementation()->GpuStreamMemberHack());
 
   while (true) {
-    // Find collective to run.
-    std::pair<Collective*, int> next_launch;
+    // Find the group of collectives to run.
+    std::pair<std::vector<Collective*>, int> next_launch;
     {
       mutex_lock l(nccl_stream->mu);
       while (nccl_stream->pending_launches_.empty()) {
@@ -459,68 +515,91 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
         }
         nccl_stream->cv.wait(l);
       }
-      next_launch = nccl_stream->pending_launches_.back();
+      next_launch = std::move(nccl_stream->pending_launches_.back());
       nccl_stream->pending_launches_.pop_back();
     }
-    Collective* collective = next_launch.first;
+    const std::vector<Collective*>& group = next_launch.first;
     int rank = next_launch.second;
 
-    // Launch the nccl kernel.
-    ncclDataType_t data_type = ToNcclType(collective->data_type);
-    Participant* p = collective->participants[rank].get();
-
-    auto nccl_comm = collective->communicator->members[rank].nccl_comm;
-    ncclResult_t nccl_result = ncclSuccess;
-    switch (collective->type) {
-      case kAllReduce: {
-        const void* sendbuff = p->in_t->tensor_data().data();
-        void* recvbuff = const_cast<char*>(p->out_t->tensor_data().data());
-
-        nccl_result =
-            ncclAllReduce(sendbuff, recvbuff, p->in_t->NumElements(), data_type,
-                          collective->reduction_op, nccl_comm, *cu_stream);
-        break;
-      }
-      case kBroadcast: {
-        const Tensor* buf_t = p->in_t ? p->in_t : p->out_t;
-        void* buf = const_cast<char*>(buf_t->tensor_data().data());
-        nccl_result = ncclBcast(buf, buf_t->NumElements(), data_type,
-                                collective->root_rank, nccl_comm, *cu_stream);
-        break;
+    // Launch the nccl kernels. Within a group, NCCL launches the kernels of
+    // all the collectives at once.
+    std::vector<ncclResult_t> nccl_results(group.size(), ncclSuccess);
+#if NCCL_MAJOR >= 2
+    if (group.size() > 1) CHECK_EQ(ncclGroupStart(), ncclSuccess);
+#endif
+    for (size_t i = 0; i < group.size(); ++i) {
+      Collective* collective = group[i];
+      ncclDataType_t data_type = ToNcclType(collective->data_type);
+      Participant* p = collective->participants[rank].get();
+
+      auto nccl_comm = collective->communicator->members[rank].nccl_comm;
+      ncclResult_t& nccl_result = nccl_results[i];
+      switch (collective->type) {
+        case kAllReduce: {
+          const void* sendbuff = p->in_t->tensor_data().data();
+          void* recvbuff = const_cast<char*>(p->out_t->tensor_data().data());
+
+          nccl_result = ncclAllReduce(sendbuff, recvbuff,
+                                      p->in_t->NumElements(), data_type,
+                                      collective->reduction_op, nccl_comm,
+                                      *cu_stream);
+          break;
+        }
+        case kBroadcast: {
+          const Tensor* buf_t = p->in_t ? p->in_t : p->out_t;
+          void* buf = const_cast<char*>(buf_t->tensor_data().data());
+          nccl_result = ncclBcast(buf, buf_t->NumElements(), data_type,
+                                  collective->root_rank, nccl_comm, *cu_stream);
+          break;
+        }
+        case kReduce: {
+          const void* sendbuff = p->in_t->tensor_data().data();
+          void* recvbuff =
+              p->out_t ? const_cast<char*>(p->out_t->tensor_data().data())
+                       : nullptr;
+          nccl_result = ncclReduce(sendbuff, recvbuff, p->in_t->NumElements(),
+                                   data_type, collective->reduction_op,
+                                   collective->root_rank, nccl_comm,
+                                   *cu_stream);
+          break;
+        }
       }
-      case kReduce: {
-        const void* sendbuff = p->in_t->tensor_data().data();
-        void* recvbuff = p->out_t
-                             ? const_cast<char*>(p->out_t->tensor_data().data())
-                             : nullptr;
-        nccl_result = ncclReduce(sendbuff, recvbuff, p->in_t->NumElements(),
-                                 data_type, collective->reduction_op,
-                                 collective->root_rank, nccl_comm, *cu_stream);
-        break;
+    }
+#if NCCL_MAJOR >= 2
+    if (group.size() > 1) {
+      ncclResult_t group_result = ncclGroupEnd();
+      for (ncclResult_t& nccl_result : nccl_results) {
+        if (nccl_result == ncclSuccess) nccl_result = group_result;
       }
     }
+#endif
 
-    // Run the done_callback when the nccl kernel finishes running.
-    auto done_callback = [collective, rank, nccl_result]() {
-      if (nccl_result == ncclSuccess) {
-        collective->participants[rank]->done_callback(Status::OK());
-      } else {
-        // Propagate the error, but note that if other members of the collective
-        // did launch their kernels, then they are hanging.
-        collective->participants[rank]->done_callback(errors::Unknown(
-            "Error invoking NCCL: ", ncclGetErrorString(nccl_result)));
-      }
+    for (size_t i = 0; i < group.size(); ++i) {
+      Collective* collective = group[i];
+      ncclResult_t nccl_result = nccl_results[i];
+      // Run the done_callback when the nccl kernel finishes running.
+      auto done_callback = [collective, rank, nccl_result]() {
+        if (nccl_result == ncclSuccess) {
+          collective->participants[rank]->done_callback(Status::OK());
+        } else {
+          // Propagate the error, but note that if other members of the
+          // collective did launch their kernels, then they are hanging.
+          collective->participants[rank]->done_callback(errors::Unknown(
+              "Error invoking NCCL: ", ncclGetErrorString(nccl_result)));
+        }
 
-      // TODO(cwhipkey): use RefCounted after figuring out how to use in a
-      // custom op library.
-      // See tensorflow/core/lib/core/refcount.h for details on this locking.
-      if (collective->remaining_participants.load(std::memory_order_acquire) ==
-              1 ||
-          collective->remaining_participants.fetch_sub(1) == 1) {
-        delete collective;
-      }
-    };
-    p->event_mgr->ThenExecute(comm_stream, done_callback);
+        // TODO(cwhipkey): use RefCounted after figuring out how to use in a
+        // custom op library.
+        // See tensorflow/core/lib/core/refcount.h for details on this locking.
+        if (collective->remaining_participants.load(
+                std::memory_order_acquire) == 1 ||
+            collective->remaining_participants.fetch_sub(1) == 1) {
+          delete collective;
+        }
+      };
+      collective->participants[rank]->event_mgr->ThenExecute(comm_stream,
+                                                             done_callback);
+    }
   }
 }
 
@@ -43,7 +43,16 @@ namespace tensorflow {
 class NcclManager {
  public:
   typedef std::function<void(Status)> DoneCallback;
+  // Reads the grouping window from the environment variable
+  // TF_NCCL_GROUP_WINDOW_MICROS, which defaults to 0.
   NcclManager();
+  // Collectives that become ready within <group_window_micros> of each other
+  // on the same set of devices are launched as one group, between
+  // ncclGroupStart and ncclGroupEnd. Each collective still completes, and
+  // calls the done callbacks of its participants, on its own. If
+  // <group_window_micros> is 0, every collective is launched as soon as all
+  // its participants have been added.
+  explicit NcclManager(int64 group_window_micros);
   ~NcclManager();
 
   static NcclManager* instance();
@@ -112,8 +121,15 @@ class NcclManager {
 
   // Run <collective>.  This calls takes ownership of <collective>.
   void RunCollective(const string& key, Collective* collective);
+  // Queues the kernels of <group>, whose collectives share a communicator, for
+  // launching as one group.
+  void LaunchGroup(std::vector<Collective*> group);
+  // Launches the collectives held for <communicator>, if any.
+  void FlushGroup(Communicator* communicator);
   void LoopKernelLaunches(NcclStream* stream);
 
+  const int64 group_window_micros_;
+
   mutex mu_;
 
   // Maps key to collectives currently being assembled or run.
@@ -128,6 +144,12 @@ class NcclManager {
 
   std::vector<std::unique_ptr<Communicator>> communicators_;
 
+  mutex group_mu_;
+  // The collectives that are ready to run, but held to be launched with the
+  // collectives that follow them within the grouping window.
+  std::unordered_map<Communicator*, std::vector<Collective*>> pending_groups_
+      GUARDED_BY(group_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(NcclManager);
 };
 
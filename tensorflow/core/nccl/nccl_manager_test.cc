@@ -222,6 +222,36 @@ TYPED_TEST(NcclManagerTest, BasicSumReduction) {
   }
 }
 
+// Test that reductions that are ready within the grouping window are launched
+// together, and each produce their own result.
+TYPED_TEST(NcclManagerTest, GroupedSumReductions) {
+  const int num_ranks = 2;
+  const int num_collectives = 10;
+  NcclManager manager(/*group_window_micros=*/10 * 1000);
+
+  std::vector<std::unique_ptr<typename TestFixture::TestCase>> test_cases;
+  for (int i = 0; i < num_collectives; ++i) {
+    test_cases.emplace_back(this->MakeTestCase(
+        num_ranks, ncclSum, TensorShape({i + 1, 3}), 1.1f * i));
+  }
+  for (int i = 0; i < num_collectives; ++i) {
+    for (int rank = 0; rank < num_ranks; ++rank) {
+      auto* device = this->GetDevice(rank);
+      auto* event_mgr = device->tensorflow_gpu_device_info()->event_mgr;
+      auto* stream = device->tensorflow_gpu_device_info()->stream;
+      manager.AddToAllReduce(
+          num_ranks, strings::StrCat("allreduce", i), ncclSum,
+          device->executor(), device->gpu_id(), event_mgr, stream,
+          &test_cases[i]->ins[rank], &test_cases[i]->outs[rank],
+          this->CreateDoneCallback(test_cases[i].get()));
+    }
+  }
+
+  for (int i = 0; i < num_collectives; ++i) {
+    this->VerifyResults(strings::StrCat("collective", i), test_cases[i].get());
+  }
+}
+
 // Same as the Basic test, but with multiple threads launching parts of many
 // reductions.
 //
@@ -1165,6 +1165,33 @@ REGISTER_OP("GatherV2")
       return Status::OK();
     });
 
+// --------------------------------------------------------------------------
+REGISTER_OP("ShardedGather")
+    .Input("params: N * Tparams")
+    .Input("indices: Tindices")
+    .Output("output: Tparams")
+    .Attr("N: int >= 1")
+    .Attr("Tparams: type")
+    .Attr("Tindices: {int32,int64}")
+    .Attr("partition_strategy: {'mod', 'div'} = 'mod'")
+    .SetShapeFn([](InferenceContext* c) {
+      const int num_shards = c->num_inputs() - 1;
+      ShapeHandle params_subshape = c->UnknownShape();
+      for (int i = 0; i < num_shards; ++i) {
+        ShapeHandle unused;
+        TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(i), 1, &unused));
+        ShapeHandle shard_subshape;
+        TF_RETURN_IF_ERROR(c->Subshape(c->input(i), 1, &shard_subshape));
+        TF_RETURN_IF_ERROR(
+            c->Merge(params_subshape, shard_subshape, &params_subshape));
+      }
+      ShapeHandle indices_shape = c->input(num_shards);
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->Concatenate(indices_shape, params_subshape, &out));
+      c->set_output(0, out);
+      return Status::OK();
+    });
+
 // --------------------------------------------------------------------------
 REGISTER_OP("GatherNd")
     .Input("params: Tparams")
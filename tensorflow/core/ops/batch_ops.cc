@@ -32,6 +32,10 @@ REGISTER_OP("BatchFunction")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
     .Attr("batching_queue: string = ''")
+    .Attr("enable_large_batch_splitting: bool = false")
+    .Attr("bucket_dimension: int = 1")
+    .Attr("bucket_boundaries: list(int) = []")
+    .Attr("copy_split_outputs: bool = false")
     .Attr("Tin: list(type)")
     .Attr("Tcaptured: list(type) >= 0")
     .Attr("Tout: list(type)")
@@ -28,6 +28,8 @@ REGISTER_OP("CollectiveReduce")
     .Attr("merge_op: {'Min', 'Max', 'Mul', 'Add'}")
     .Attr("final_op: {'Id', 'Div'}")
     .Attr("subdiv_offsets: list(int)")
+    .Attr("implementation: string = ''")
+    .Attr("wire_format: string = ''")
     .SetIsStateful()
     .SetShapeFn(shape_inference::UnchangedShape);
 
@@ -334,6 +334,75 @@ REGISTER_OP("DecodeAndCropJpeg")
       return Status::OK();
     });
 
+// --------------------------------------------------------------------------
+REGISTER_OP("_DecodeAndCropResizeJpeg")
+    .Input("contents: string")
+    .Input("crop_window: int32")
+    .Input("size: int32")
+    .Input("offset: float")
+    .Input("scale: float")
+    .Attr("channels: int = 0")
+    .Attr("fancy_upscaling: bool = true")
+    .Attr("try_recover_truncated: bool = false")
+    .Attr("acceptable_fraction: float = 1.0")
+    .Attr("dct_method: string = ''")
+    .Attr("align_corners: bool = false")
+    .Output("image: float")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(unused, 0), 4, &unused_dim));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(3), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(4), 1, &unused));
+
+      int32 channels;
+      TF_RETURN_IF_ERROR(c->GetAttr("channels", &channels));
+      if (channels < 0) {
+        return errors::InvalidArgument("channels must be non-negative, got ",
+                                       channels);
+      }
+      DimensionHandle channels_dim =
+          channels == 0 ? c->UnknownDim() : c->MakeDim(channels);
+
+      ShapeHandle size;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &size));
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(size, 0), 2, &unused_dim));
+      DimensionHandle h = c->UnknownDim();
+      DimensionHandle w = c->UnknownDim();
+      const Tensor* size_tensor = c->input_tensor(2);
+      if (size_tensor != nullptr) {
+        auto size_vec = size_tensor->vec<int32>();
+        h = c->MakeDim(size_vec(0));
+        w = c->MakeDim(size_vec(1));
+      }
+      c->set_output(0, c->MakeShape({h, w, channels_dim}));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Decodes, crops, resizes and normalizes a JPEG-encoded image.
+
+Computes `(ResizeBilinear(DecodeAndCropJpeg(contents, crop_window), size) -
+offset) * scale` for a single image, without allocating the intermediate
+images. When the crop window is at least twice as large as `size`, the image is
+decoded at a reduced scale by libjpeg, so the result may differ slightly from
+the one of the separate ops.
+
+NOTE: Do not invoke this operator directly in Python. The tf.data
+decode_and_resize_fusion optimization is expected to create it.
+
+contents: 0-D. The JPEG-encoded image.
+crop_window: 1-D. The crop window: [crop_y, crop_x, crop_height, crop_width].
+size: 1-D of 2 elements: `new_height, new_width`.
+offset: Scalar, or 1-D with one value per channel, subtracted from the resized
+  image.
+scale: Scalar, or 1-D with one value per channel, by which the image is
+  multiplied after subtracting `offset`.
+channels: Number of color channels for the decoded image.
+image: 3-D with shape `[new_height, new_width, channels]`.
+)doc");
+
 // --------------------------------------------------------------------------
 REGISTER_OP("EncodeJpeg")
     .Input("image: uint8")
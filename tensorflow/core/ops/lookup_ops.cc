@@ -439,6 +439,90 @@ REGISTER_OP("MutableDenseHashTableV2")
       return MutableHashTableShape(c, /*key=*/c->input(0), /*value=*/value_s);
     });
 
+REGISTER_OP("MutableStripedHashTable")
+    .Output("table_handle: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("key_dtype: {int32, int64}")
+    .Attr("value_dtype: {int32, int64, float, double}")
+    .Attr("num_shards: int = 64")
+    .Attr("initial_num_buckets: int = 131072")  // 2^17
+    .Attr("max_load_factor: float = 0.8")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      return MutableHashTableShape(c, /*key=*/c->Scalar(),
+                                   /*value=*/c->Scalar());
+    });
+
+REGISTER_OP("DynamicEmbeddingTable")
+    .Output("table_handle: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("value_dtype: {float, double}")
+    .Attr("value_shape: shape")
+    .Attr("admit_threshold: int = 1")
+    .Attr("max_rows: int = 0")
+    .Attr("eviction_policy: {'lru', 'lfu'} = 'lru'")
+    .Attr("num_slots: int = 0")
+    .Attr("slot_initial_value: float = 0")
+    .SetIsStateful()
+    .SetShapeFn(ScalarOutput);
+
+REGISTER_OP("DynamicEmbeddingLookup")
+    .Input("table_handle: resource")
+    .Input("keys: int64")
+    .Input("default_value: value_dtype")
+    .Output("values: value_dtype")
+    .Attr("value_dtype: {float, double}")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle handle;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &handle));
+      ShapeHandle value;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &value));
+      ShapeHandle output;
+      TF_RETURN_IF_ERROR(c->Concatenate(c->input(1), value, &output));
+      c->set_output(0, output);
+      return Status::OK();
+    });
+
+namespace {
+
+Status DynamicEmbeddingApplyShape(InferenceContext* c) {
+  ShapeHandle unused;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));  // table_handle
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));  // lr
+  ShapeHandle grad;
+  TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(2), 1, &grad));
+  ShapeHandle keys = c->input(3);
+  if (c->RankKnown(keys) && c->RankKnown(grad)) {
+    ShapeHandle grad_prefix;
+    TF_RETURN_IF_ERROR(c->Subshape(grad, 0, c->Rank(keys), &grad_prefix));
+    TF_RETURN_IF_ERROR(c->Merge(grad_prefix, keys, &unused));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+REGISTER_OP("DynamicEmbeddingApplyGradientDescent")
+    .Input("table_handle: resource")
+    .Input("lr: T")
+    .Input("grad: T")
+    .Input("keys: int64")
+    .Attr("T: {float, double}")
+    .SetShapeFn(DynamicEmbeddingApplyShape);
+
+REGISTER_OP("DynamicEmbeddingApplyAdagrad")
+    .Input("table_handle: resource")
+    .Input("lr: T")
+    .Input("grad: T")
+    .Input("keys: int64")
+    .Attr("T: {float, double}")
+    .SetShapeFn(DynamicEmbeddingApplyShape);
+
 REGISTER_OP("InitializeTable")
     .Input("table_handle: Ref(string)")
     .Input("keys: Tkey")
@@ -771,6 +771,55 @@ REGISTER_OP("MatMul")
         "complex128}")
     .SetShapeFn(shape_inference::MatMulShape);
 
+REGISTER_OP("_FusedMatMul")
+    .Input("a: T")
+    .Input("b: T")
+    .Input("args: num_args * T")
+    .Output("product: T")
+    .Attr("transpose_a: bool = false")
+    .Attr("transpose_b: bool = false")
+    .Attr("T: {float, double}")
+    .Attr("num_args: int >= 0")
+    .Attr("fused_ops: list(string) = []")
+    .SetShapeFn(shape_inference::MatMulShape)
+    .Doc(R"doc(
+Performs a MatMul followed by the operations listed in `fused_ops`, e.g.
+["BiasAdd", "Relu"], whose extra inputs are passed in `args`.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_QuantizedFusedMatMul")
+    .Input("a: float")
+    .Input("b: qint8")
+    .Input("b_scales: float")
+    .Input("args: num_args * float")
+    .Output("product: float")
+    .Attr("num_args: int >= 0")
+    .Attr("fused_ops: list(string) = []")
+    .Attr("input_range: float = 0")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle a;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &a));
+      ShapeHandle b;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &b));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(a, 1), c->Dim(b, 0), &unused));
+      c->set_output(0, c->Matrix(c->Dim(a, 0), c->Dim(b, 1)));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Performs an int8 MatMul of `a` and `b` followed by the operations listed in
+`fused_ops`, e.g. ["BiasAdd", "Relu"], whose extra inputs are passed in
+`args`. Column `j` of `b` times `b_scales[j]` approximates the float weights.
+`a` is quantized to int8 with the range [-input_range, input_range], or with
+the range of its values if `input_range` is 0.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
 REGISTER_OP("SparseMatMul")
     .Input("a: Ta")
     .Input("b: Tb")
@@ -1220,6 +1269,54 @@ REGISTER_OP("SparseSegmentSqrtNGrad")
     .Attr("Tidx: {int32, int64} = DT_INT32")
     .SetShapeFn(SparseSegmentReductionGradShapeFn);
 
+namespace {
+
+Status FusedEmbeddingLookupSparseShapeFn(InferenceContext* c) {
+  ShapeHandle data_shape;
+  TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &data_shape));
+
+  // ids (or unique_idx), segment_ids and weights should merge cleanly.
+  ShapeHandle entries_shape;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &entries_shape));
+  TF_RETURN_IF_ERROR(c->Merge(c->input(2), entries_shape, &entries_shape));
+  TF_RETURN_IF_ERROR(c->Merge(c->input(3), entries_shape, &entries_shape));
+
+  ShapeHandle unused;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
+  DimensionHandle dim0;
+  TF_RETURN_IF_ERROR(c->MakeDimForScalarInput(4, &dim0));
+
+  ShapeHandle out;
+  TF_RETURN_IF_ERROR(c->ReplaceDim(data_shape, 0, dim0, &out));
+  c->set_output(0, out);
+  return Status::OK();
+}
+
+}  // namespace
+
+REGISTER_OP("FusedEmbeddingLookupSparse")
+    .Input("params: T")
+    .Input("ids: Tidx")
+    .Input("segment_ids: int64")
+    .Input("weights: T")
+    .Input("num_rows: int64")
+    .Output("output: T")
+    .Attr("T: {float, double}")
+    .Attr("Tidx: {int32, int64} = DT_INT32")
+    .Attr("combiner: {'sum', 'mean', 'sqrtn'} = 'mean'")
+    .SetShapeFn(FusedEmbeddingLookupSparseShapeFn);
+
+REGISTER_OP("FusedEmbeddingLookupSparseGrad")
+    .Input("grad: T")
+    .Input("unique_idx: int32")
+    .Input("segment_ids: int64")
+    .Input("weights: T")
+    .Input("num_unique: int32")
+    .Output("output: T")
+    .Attr("T: {float, double}")
+    .Attr("combiner: {'sum', 'mean', 'sqrtn'} = 'mean'")
+    .SetShapeFn(FusedEmbeddingLookupSparseShapeFn);
+
 REGISTER_OP("All")
     .Input("input: bool")
     .Input("reduction_indices: Tidx")
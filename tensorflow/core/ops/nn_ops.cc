@@ -274,6 +274,53 @@ REGISTER_OP("Conv2D")
     .Attr("dilations: list(int) = [1, 1, 1, 1]")
     .SetShapeFn(shape_inference::Conv2DShape);
 
+REGISTER_OP("_FusedConv2D")
+    .Input("input: T")
+    .Input("filter: T")
+    .Input("args: num_args * T")
+    .Output("output: T")
+    .Attr("T: {float, double}")
+    .Attr("num_args: int >= 0")
+    .Attr("strides: list(int)")
+    .Attr(GetPaddingAttrString())
+    .Attr(GetConvnetDataFormatAttrString())
+    .Attr("dilations: list(int) = [1, 1, 1, 1]")
+    .Attr("fused_ops: list(string) = []")
+    .SetShapeFn(shape_inference::Conv2DShape)
+    .Doc(R"doc(
+Performs a Conv2D followed by the operations listed in `fused_ops`, e.g.
+["BiasAdd", "Relu"], whose extra inputs are passed in `args`.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_QuantizedFusedConv2D")
+    .Input("input: float")
+    .Input("filter: qint8")
+    .Input("filter_scales: float")
+    .Input("args: num_args * float")
+    .Output("output: float")
+    .Attr("num_args: int >= 0")
+    .Attr("strides: list(int)")
+    .Attr(GetPaddingAttrString())
+    .Attr("data_format: {'NHWC'} = 'NHWC'")
+    .Attr("dilations: list(int) = [1, 1, 1, 1]")
+    .Attr("fused_ops: list(string) = []")
+    .Attr("input_range: float = 0")
+    .SetShapeFn(shape_inference::Conv2DShape)
+    .Doc(R"doc(
+Performs an int8 Conv2D of `input` and `filter` followed by the operations
+listed in `fused_ops`, e.g. ["BiasAdd", "Relu"], whose extra inputs are passed
+in `args`. Output channel `j` of `filter` times `filter_scales[j]`
+approximates the float filter. `input` is quantized to int8 with the range
+[-input_range, input_range], or with the range of its values if `input_range`
+is 0.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
 REGISTER_OP("Conv2DBackpropInput")
     .Input("input_sizes: int32")
     .Input("filter: T")
@@ -1070,6 +1117,95 @@ REGISTER_OP("LogSoftmax")
       return shape_inference::UnchangedShapeWithRankAtLeast(c, 1);
     });
 
+REGISTER_OP("_FusedLayerNorm")
+    .Input("x: T")
+    .Input("scale: T")
+    .Input("offset: T")
+    .Output("y: T")
+    .Attr("T: {float}")
+    .Attr("epsilon: float = 0.001")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &x));
+      DimensionHandle depth = c->Dim(x, -1);
+      for (int i = 1; i < 3; ++i) {
+        ShapeHandle vec;
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &vec));
+        TF_RETURN_IF_ERROR(c->Merge(depth, c->Dim(vec, 0), &depth));
+      }
+      ShapeHandle y;
+      TF_RETURN_IF_ERROR(c->ReplaceDim(x, -1, depth, &y));
+      c->set_output(0, y);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Normalizes `x` over its last dimension to a mean of 0 and a variance of 1,
+then scales it by `scale` and adds `offset`:
+y = (x - mean) * rsqrt(variance + epsilon) * scale + offset.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("FusedMultiHeadAttention")
+    .Input("query: T")
+    .Input("key: T")
+    .Input("value: T")
+    .Input("key_cache: num_cache * T")
+    .Input("value_cache: num_cache * T")
+    .Input("mask: num_mask * T")
+    .Output("output: T")
+    .Output("new_key_cache: num_cache * T")
+    .Output("new_value_cache: num_cache * T")
+    .Attr("T: {float}")
+    .Attr("num_cache: int >= 0 = 0")
+    .Attr("num_mask: int >= 0 = 0")
+    .Attr("scale: float = 1.0")
+    .Attr("causal: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle query, key, value;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &query));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 4, &key));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 4, &value));
+      int num_cache;
+      TF_RETURN_IF_ERROR(c->GetAttr("num_cache", &num_cache));
+      if (num_cache > 1) {
+        return errors::InvalidArgument("num_cache must be 0 or 1, got ",
+                                       num_cache);
+      }
+      // The batch and head dimensions of all the inputs, and the depth of the
+      // queries and the keys, must match.
+      DimensionHandle batch = c->Dim(query, 0);
+      DimensionHandle heads = c->Dim(query, 1);
+      DimensionHandle depth = c->Dim(query, 3);
+      for (ShapeHandle s : {key, value}) {
+        TF_RETURN_IF_ERROR(c->Merge(batch, c->Dim(s, 0), &batch));
+        TF_RETURN_IF_ERROR(c->Merge(heads, c->Dim(s, 1), &heads));
+      }
+      TF_RETURN_IF_ERROR(c->Merge(depth, c->Dim(key, 3), &depth));
+      DimensionHandle length;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(key, 2), c->Dim(value, 2), &length));
+      c->set_output(0,
+                    c->MakeShape({batch, heads, c->Dim(query, 2),
+                                  c->Dim(value, 3)}));
+      if (num_cache == 1) {
+        // The caches are extended with the keys and values of this step.
+        ShapeHandle key_cache, value_cache;
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 4, &key_cache));
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 4, &value_cache));
+        DimensionHandle cache_length;
+        TF_RETURN_IF_ERROR(c->Merge(c->Dim(key_cache, 2),
+                                    c->Dim(value_cache, 2), &cache_length));
+        TF_RETURN_IF_ERROR(c->Add(cache_length, length, &length));
+        ShapeHandle new_key_cache, new_value_cache;
+        TF_RETURN_IF_ERROR(c->ReplaceDim(key, 2, length, &new_key_cache));
+        TF_RETURN_IF_ERROR(c->ReplaceDim(value, 2, length, &new_value_cache));
+        c->set_output(1, new_key_cache);
+        c->set_output(2, new_value_cache);
+      }
+      return Status::OK();
+    });
+
 // --------------------------------------------------------------------------
 
 REGISTER_OP("SoftmaxCrossEntropyWithLogits")
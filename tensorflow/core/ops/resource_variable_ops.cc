@@ -257,6 +257,38 @@ REGISTER_OP("ResourceGather")
       return Status::OK();
     });
 
+REGISTER_OP("ResourceShardedGather")
+    .Input("resources: N * resource")
+    .Input("indices: Tindices")
+    .Output("output: dtype")
+    .Attr("N: int >= 1")
+    .Attr("dtype: type")
+    .Attr("Tindices: {int32,int64}")
+    .Attr("partition_strategy: {'mod', 'div'} = 'mod'")
+    .SetShapeFn([](InferenceContext* c) {
+      const int num_shards = c->num_inputs() - 1;
+      ShapeHandle params_subshape = c->UnknownShape();
+      for (int i = 0; i < num_shards; ++i) {
+        auto* handle_data = c->input_handle_shapes_and_types(i);
+        if (handle_data == nullptr || handle_data->empty()) {
+          continue;
+        }
+        ShapeHandle unused;
+        TF_RETURN_IF_ERROR(
+            c->WithRankAtLeast((*handle_data)[0].shape, 1, &unused));
+        ShapeHandle shard_subshape;
+        TF_RETURN_IF_ERROR(
+            c->Subshape((*handle_data)[0].shape, 1, &shard_subshape));
+        TF_RETURN_IF_ERROR(
+            c->Merge(params_subshape, shard_subshape, &params_subshape));
+      }
+      ShapeHandle indices_shape = c->input(num_shards);
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->Concatenate(indices_shape, params_subshape, &out));
+      c->set_output(0, out);
+      return Status::OK();
+    });
+
 namespace {
 
 Status ResourceScatterUpdateShape(InferenceContext* c) {
@@ -118,6 +118,50 @@ REGISTER_OP("SparseTensorDenseMatMul")
       return Status::OK();
     });
 
+REGISTER_OP("CSRSparseMatrixHandle")
+    .Output("resource: resource")
+    .Attr("dtype: {float, double, int32, complex64, complex128}")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ScalarShape);
+
+REGISTER_OP("AssignCSRSparseMatrix")
+    .Input("resource: resource")
+    .Input("indices: Tindices")
+    .Input("values: dtype")
+    .Input("dense_shape: int64")
+    .Attr("dtype: {float, double, int32, complex64, complex128}")
+    .Attr("Tindices: {int32,int64} = DT_INT64")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 1, &unused));
+      return Status::OK();
+    });
+
+REGISTER_OP("CSRSparseMatrixDenseMatMul")
+    .Input("a: resource")
+    .Input("b: T")
+    .Output("product: T")
+    .Attr("T: {float, double, int32, complex64, complex128}")
+    .Attr("adjoint_a: bool = false")
+    .Attr("adjoint_b: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      ShapeHandle b;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &b));
+      bool adjoint_b;
+      TF_RETURN_IF_ERROR(c->GetAttr("adjoint_b", &adjoint_b));
+      // The shape of `a` is only known when the kernel runs.
+      c->set_output(0, c->Matrix(InferenceContext::kUnknownDim,
+                                 c->Dim(b, adjoint_b ? 0 : 1)));
+      return Status::OK();
+    });
+
 REGISTER_OP("SerializeSparse")
     .Input("sparse_indices: int64")
     .Input("sparse_values: T")
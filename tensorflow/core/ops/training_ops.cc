@@ -685,6 +685,42 @@ REGISTER_OP("ResourceSparseApplyMomentum")
       return ApplyMomentumShapeFn(c, true /* sparse */);
     });
 
+// Shape function of the multi-tensor apply ops, whose inputs are `num_lists`
+// lists of N variables, then `num_scalars` scalars, then N gradients.
+static Status MultiApplyShapeFn(InferenceContext* c, int num_lists,
+                                int num_scalars) {
+  int n;
+  TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+  ShapeHandle unused;
+  for (int i = 0; i < num_scalars; ++i) {
+    TF_RETURN_IF_ERROR(c->WithRank(c->input(num_lists * n + i), 0, &unused));
+  }
+  const int grad_begin = num_lists * n + num_scalars;
+  for (int i = 0; i < n; ++i) {
+    ShapeHandle s = ShapeOrHandleShape(c, i);
+    for (int list = 1; list < num_lists; ++list) {
+      TF_RETURN_IF_ERROR(c->Merge(s, ShapeOrHandleShape(c, list * n + i), &s));
+    }
+    TF_RETURN_IF_ERROR(
+        HandleGradAndIndicesInputs(c, false /* sparse */, grad_begin + i, &s));
+  }
+  return Status::OK();
+}
+
+REGISTER_OP("ResourceMultiApplyMomentum")
+    .Input("var: N * resource")
+    .Input("accum: N * resource")
+    .Input("lr: T")
+    .Input("momentum: T")
+    .Input("grad: N * T")
+    .Attr("N: int >= 1")
+    .Attr("T: numbertype")
+    .Attr("use_locking: bool = false")
+    .Attr("use_nesterov: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      return MultiApplyShapeFn(c, 2 /* num_lists */, 2 /* num_scalars */);
+    });
+
 static Status ApplyAdamShapeFn(InferenceContext* c, bool sparse) {
   ShapeHandle unused;
   ShapeHandle s = ShapeOrHandleShape(c, 0);                       // var
@@ -741,6 +777,25 @@ REGISTER_OP("ResourceApplyAdam")
       return ApplyAdamShapeFn(c, false /* sparse */);
     });
 
+REGISTER_OP("ResourceMultiApplyAdam")
+    .Input("var: N * resource")
+    .Input("m: N * resource")
+    .Input("v: N * resource")
+    .Input("beta1_power: T")
+    .Input("beta2_power: T")
+    .Input("lr: T")
+    .Input("beta1: T")
+    .Input("beta2: T")
+    .Input("epsilon: T")
+    .Input("grad: N * T")
+    .Attr("N: int >= 1")
+    .Attr("T: numbertype")
+    .Attr("use_locking: bool = false")
+    .Attr("use_nesterov: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      return MultiApplyShapeFn(c, 3 /* num_lists */, 6 /* num_scalars */);
+    });
+
 static Status ApplyAdaMaxShapeFn(InferenceContext* c, bool sparse) {
   ShapeHandle unused;
   ShapeHandle s = ShapeOrHandleShape(c, 0);                       // var
@@ -0,0 +1,300 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/disk_file_block_cache.h"
+#include <algorithm>
+#include <cstring>
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kBlockSuffix[] = ".blk";
+
+// Trimming removes blocks until the cache is at most this fraction of its
+// budget, so that it does not list the directory on every write.
+constexpr double kTrimTarget = 0.9;
+
+// The checksum of a block covers the remote file name, so that blocks of
+// files whose names share a hash are not mistaken for each other.
+uint32 BlockChecksum(const string& filename, const char* data, size_t n) {
+  return crc32c::Mask(
+      crc32c::Extend(crc32c::Value(filename.data(), filename.size()), data, n));
+}
+
+// The prefix of the names of all the block files of `filename`.
+string FilePrefix(const string& filename) {
+  return strings::StrCat(Hash64(filename), "_");
+}
+
+}  // namespace
+
+DiskFileBlockCache::DiskFileBlockCache(size_t block_size, size_t max_bytes,
+                                       uint64 max_staleness,
+                                       const string& cache_dir,
+                                       BlockFetcher block_fetcher, Env* env)
+    : block_size_(block_size),
+      max_bytes_(max_bytes),
+      max_staleness_(max_staleness),
+      cache_dir_(cache_dir),
+      block_fetcher_(std::move(block_fetcher)),
+      env_(env) {
+  if (IsCacheEnabled()) {
+    Status s = env_->RecursivelyCreateDir(cache_dir_);
+    if (!s.ok() && !errors::IsAlreadyExists(s)) {
+      LOG(WARNING) << "Failed to create the block cache directory "
+                   << cache_dir_ << ": " << s;
+    }
+    std::vector<BlockFile> blocks;
+    const uint64 size = ListBlocks("", &blocks);
+    mutex_lock l(mu_);
+    cache_size_ = size;
+  }
+  VLOG(1) << "Disk file block cache in " << cache_dir_ << " is "
+          << (IsCacheEnabled() ? "enabled" : "disabled");
+}
+
+string DiskFileBlockCache::BlockPath(const string& filename, size_t offset) {
+  int64 signature = 0;
+  {
+    mutex_lock l(mu_);
+    auto it = file_signature_map_.find(filename);
+    if (it != file_signature_map_.end()) {
+      signature = it->second;
+    }
+  }
+  return io::JoinPath(cache_dir_,
+                      strings::StrCat(FilePrefix(filename), signature, "_",
+                                      offset, kBlockSuffix));
+}
+
+bool DiskFileBlockCache::LoadBlock(const string& path, const string& filename,
+                                   string* data) {
+  if (max_staleness_ > 0) {
+    FileStatistics stat;
+    if (!env_->Stat(path, &stat).ok()) {
+      return false;
+    }
+    const int64 age = static_cast<int64>(env_->NowSeconds()) -
+                      stat.mtime_nsec / 1000000000;
+    if (age > static_cast<int64>(max_staleness_)) {
+      return false;
+    }
+  }
+  string contents;
+  if (!ReadFileToString(env_, path, &contents).ok()) {
+    return false;
+  }
+  if (contents.size() >= sizeof(uint32)) {
+    const size_t size = contents.size() - sizeof(uint32);
+    if (core::DecodeFixed32(contents.data() + size) ==
+        BlockChecksum(filename, contents.data(), size)) {
+      contents.resize(size);
+      *data = std::move(contents);
+      return true;
+    }
+  }
+  LOG(WARNING) << "Removing corrupt cached block " << path;
+  env_->DeleteFile(path).IgnoreError();
+  return false;
+}
+
+Status DiskFileBlockCache::StoreBlock(const string& path,
+                                      const string& filename,
+                                      const string& data) {
+  string contents = data;
+  char checksum[sizeof(uint32)];
+  core::EncodeFixed32(checksum,
+                      BlockChecksum(filename, data.data(), data.size()));
+  contents.append(checksum, sizeof(checksum));
+  // Readers in other processes only ever see complete blocks.
+  const string tmp_path =
+      strings::StrCat(path, ".", random::New64(), ".tmp");
+  TF_RETURN_IF_ERROR(WriteStringToFile(env_, tmp_path, contents));
+  Status s = env_->RenameFile(tmp_path, path);
+  if (!s.ok()) {
+    env_->DeleteFile(tmp_path).IgnoreError();
+    return s;
+  }
+  bool trim;
+  {
+    mutex_lock l(mu_);
+    cache_size_ += contents.size();
+    trim = cache_size_ > max_bytes_;
+  }
+  if (trim) {
+    Trim();
+  }
+  return Status::OK();
+}
+
+Status DiskFileBlockCache::GetBlock(const string& filename, size_t offset,
+                                    string* data) {
+  const string path = BlockPath(filename, offset);
+  if (LoadBlock(path, filename, data)) {
+    return Status::OK();
+  }
+  data->resize(block_size_);
+  size_t bytes_transferred;
+  TF_RETURN_IF_ERROR(block_fetcher_(filename, offset, block_size_, &(*data)[0],
+                                    &bytes_transferred));
+  data->resize(bytes_transferred);
+  Status s = StoreBlock(path, filename, *data);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to cache block " << path << ": " << s;
+  }
+  return Status::OK();
+}
+
+Status DiskFileBlockCache::Read(const string& filename, size_t offset,
+                                size_t n, char* buffer,
+                                size_t* bytes_transferred) {
+  *bytes_transferred = 0;
+  if (n == 0) {
+    return Status::OK();
+  }
+  if (!IsCacheEnabled()) {
+    return block_fetcher_(filename, offset, n, buffer, bytes_transferred);
+  }
+  // Calculate the block-aligned start and end of the read.
+  size_t start = block_size_ * (offset / block_size_);
+  size_t finish = block_size_ * ((offset + n) / block_size_);
+  if (finish < offset + n) {
+    finish += block_size_;
+  }
+  size_t total_bytes_transferred = 0;
+  string data;
+  for (size_t pos = start; pos < finish; pos += block_size_) {
+    TF_RETURN_IF_ERROR(GetBlock(filename, pos, &data));
+    if (offset >= pos + data.size()) {
+      // The requested offset is at or beyond the end of the file.
+      *bytes_transferred = total_bytes_transferred;
+      return errors::OutOfRange("EOF at offset ", offset, " in file ", filename,
+                                " at position ", pos, " with data size ",
+                                data.size());
+    }
+    size_t begin = offset > pos ? offset - pos : 0;
+    size_t end = std::min(data.size(), offset + n - pos);
+    if (begin < end) {
+      memcpy(&buffer[total_bytes_transferred], &data[begin], end - begin);
+      total_bytes_transferred += end - begin;
+    }
+    if (data.size() < block_size_) {
+      // The block was a partial block and thus signals EOF at its upper bound.
+      break;
+    }
+  }
+  *bytes_transferred = total_bytes_transferred;
+  return Status::OK();
+}
+
+bool DiskFileBlockCache::ValidateAndUpdateFileSignature(const string& filename,
+                                                        int64 file_signature) {
+  mutex_lock lock(mu_);
+  auto it = file_signature_map_.find(filename);
+  if (it != file_signature_map_.end()) {
+    if (it->second == file_signature) {
+      return true;
+    }
+    it->second = file_signature;
+    return false;
+  }
+  file_signature_map_[filename] = file_signature;
+  return true;
+}
+
+uint64 DiskFileBlockCache::ListBlocks(const string& prefix,
+                                      std::vector<BlockFile>* blocks) {
+  std::vector<string> children;
+  if (!env_->GetChildren(cache_dir_, &children).ok()) {
+    return 0;
+  }
+  uint64 total = 0;
+  for (const string& child : children) {
+    if (!str_util::StartsWith(child, prefix) ||
+        !str_util::EndsWith(child, kBlockSuffix)) {
+      continue;
+    }
+    BlockFile block;
+    block.path = io::JoinPath(cache_dir_, child);
+    FileStatistics stat;
+    // Another process may have removed the block in the meantime.
+    if (!env_->Stat(block.path, &stat).ok()) {
+      continue;
+    }
+    block.size = stat.length;
+    block.mtime_nsec = stat.mtime_nsec;
+    total += block.size;
+    blocks->push_back(std::move(block));
+  }
+  return total;
+}
+
+void DiskFileBlockCache::Trim() {
+  mutex_lock trim_lock(trim_mu_);
+  std::vector<BlockFile> blocks;
+  uint64 total = ListBlocks("", &blocks);
+  std::sort(blocks.begin(), blocks.end(),
+            [](const BlockFile& a, const BlockFile& b) {
+              return a.mtime_nsec < b.mtime_nsec;
+            });
+  const uint64 target = static_cast<uint64>(max_bytes_ * kTrimTarget);
+  for (const BlockFile& block : blocks) {
+    if (total <= target) break;
+    // If the delete fails, another process most likely removed it first.
+    env_->DeleteFile(block.path).IgnoreError();
+    total -= block.size;
+  }
+  mutex_lock l(mu_);
+  cache_size_ = total;
+}
+
+size_t DiskFileBlockCache::CacheSize() const {
+  mutex_lock lock(mu_);
+  return cache_size_;
+}
+
+void DiskFileBlockCache::RemoveFile(const string& filename) {
+  std::vector<BlockFile> blocks;
+  ListBlocks(FilePrefix(filename), &blocks);
+  uint64 removed = 0;
+  for (const BlockFile& block : blocks) {
+    if (env_->DeleteFile(block.path).ok()) {
+      removed += block.size;
+    }
+  }
+  mutex_lock lock(mu_);
+  cache_size_ -= std::min(cache_size_, removed);
+}
+
+void DiskFileBlockCache::Flush() {
+  std::vector<BlockFile> blocks;
+  ListBlocks("", &blocks);
+  for (const BlockFile& block : blocks) {
+    env_->DeleteFile(block.path).IgnoreError();
+  }
+  mutex_lock lock(mu_);
+  cache_size_ = 0;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,143 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_DISK_FILE_BLOCK_CACHE_H_
+#define TENSORFLOW_CORE_PLATFORM_CLOUD_DISK_FILE_BLOCK_CACHE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+/// \brief A block cache of file contents kept in a local directory.
+///
+/// Each block is stored in its own file, named after the remote file, its
+/// signature (e.g. the GCS object generation) and the block offset, and
+/// protected by a CRC32C checksum. Blocks are written to a temporary file and
+/// renamed into place, so several processes on a host can share the same
+/// directory, and the cache survives restarts of the processes using it.
+///
+/// Once the blocks in the directory exceed `max_bytes`, the least recently
+/// added blocks are removed. Blocks whose file signature changed are never
+/// read again and are eventually removed the same way.
+class DiskFileBlockCache : public FileBlockCache {
+ public:
+  DiskFileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
+                     const string& cache_dir, BlockFetcher block_fetcher,
+                     Env* env = Env::Default());
+
+  /// Read `n` bytes from `filename` starting at `offset` into `out`, with the
+  /// same semantics as `RamFileBlockCache::Read`, except that partial blocks
+  /// are not checked for consistency. Blocks that cannot be read from or
+  /// written to the cache directory are fetched from the underlying
+  /// filesystem instead.
+  Status Read(const string& filename, size_t offset, size_t n, char* buffer,
+              size_t* bytes_transferred) override;
+
+  // Records the signature of `filename`, which selects the cached blocks
+  // that reads use. Returns false if it differs from the recorded one.
+  bool ValidateAndUpdateFileSignature(const string& filename,
+                                      int64 file_signature) override
+      LOCKS_EXCLUDED(mu_);
+
+  /// Remove all cached blocks for `filename`.
+  void RemoveFile(const string& filename) override LOCKS_EXCLUDED(mu_);
+
+  /// Remove all cached data.
+  void Flush() override LOCKS_EXCLUDED(mu_);
+
+  /// Accessors for cache parameters.
+  size_t block_size() const override { return block_size_; }
+  size_t max_bytes() const override { return max_bytes_; }
+  uint64 max_staleness() const override { return max_staleness_; }
+
+  /// The size (in bytes) of the cache directory, as last seen by this
+  /// process.
+  size_t CacheSize() const override LOCKS_EXCLUDED(mu_);
+
+  // Returns true if the cache is enabled. If false, the BlockFetcher callback
+  // is always executed during Read.
+  bool IsCacheEnabled() const override {
+    return block_size_ > 0 && max_bytes_ > 0 && !cache_dir_.empty();
+  }
+
+ private:
+  /// A block file in the cache directory.
+  struct BlockFile {
+    string path;
+    uint64 size;
+    int64 mtime_nsec;
+  };
+
+  /// Returns the path of the block of `filename` at `offset`.
+  string BlockPath(const string& filename, size_t offset) LOCKS_EXCLUDED(mu_);
+
+  /// Returns the cached block at `path` in `data`, or false if it is
+  /// missing, stale or corrupt.
+  bool LoadBlock(const string& path, const string& filename, string* data);
+
+  /// Writes `data` as the block at `path`.
+  Status StoreBlock(const string& path, const string& filename,
+                    const string& data) LOCKS_EXCLUDED(mu_);
+
+  /// Returns the block of `filename` at `offset` in `data`, from the cache
+  /// directory if possible and from the underlying filesystem otherwise.
+  Status GetBlock(const string& filename, size_t offset, string* data);
+
+  /// Lists the block files in the cache directory whose names start with
+  /// `prefix`, and returns their combined size.
+  uint64 ListBlocks(const string& prefix, std::vector<BlockFile>* blocks);
+
+  /// Removes the least recently added blocks until the cache directory is
+  /// comfortably below `max_bytes_`.
+  void Trim() LOCKS_EXCLUDED(mu_, trim_mu_);
+
+  /// The size of the cached blocks, as well as the size of the reads from the
+  /// underlying filesystem.
+  const size_t block_size_;
+  /// The maximum number of bytes of blocks in the cache directory.
+  const size_t max_bytes_;
+  /// The maximum age of any cached block, in seconds. 0 means no limit.
+  const uint64 max_staleness_;
+  /// The directory holding the block files.
+  const string cache_dir_;
+  /// The callback to read a block from the underlying filesystem.
+  const BlockFetcher block_fetcher_;
+  Env* const env_;  // not owned
+
+  /// Serializes trimming of the cache directory within this process.
+  mutex trim_mu_;
+
+  /// Guards the cache size and the file signatures.
+  mutable mutex mu_;
+
+  /// The number of bytes in the cache directory, as of the last listing plus
+  /// the blocks this process wrote since.
+  uint64 cache_size_ GUARDED_BY(mu_) = 0;
+
+  // A filename->file_signature map.
+  std::map<string, int64> file_signature_map_ GUARDED_BY(mu_);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_CLOUD_DISK_FILE_BLOCK_CACHE_H_
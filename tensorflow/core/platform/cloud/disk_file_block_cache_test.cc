@@ -0,0 +1,199 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/disk_file_block_cache.h"
+#include <cstring>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/cloud/now_seconds_env.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+Status ReadCache(DiskFileBlockCache* cache, const string& filename,
+                 size_t offset, size_t n, std::vector<char>* out) {
+  out->clear();
+  out->resize(n, 0);
+  size_t bytes_transferred = 0;
+  Status status =
+      cache->Read(filename, offset, n, out->data(), &bytes_transferred);
+  EXPECT_LE(bytes_transferred, n);
+  out->resize(bytes_transferred, n);
+  return status;
+}
+
+// Returns a fresh cache directory for the current test.
+string CacheDir() {
+  const string dir = io::JoinPath(
+      testing::TmpDir(),
+      ::testing::UnitTest::GetInstance()->current_test_info()->name());
+  int64 undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  return dir;
+}
+
+// Returns the paths of the block files in `dir`.
+std::vector<string> BlockFiles(const string& dir) {
+  std::vector<string> children;
+  TF_CHECK_OK(Env::Default()->GetChildren(dir, &children));
+  std::vector<string> blocks;
+  for (const string& child : children) {
+    blocks.push_back(io::JoinPath(dir, child));
+  }
+  return blocks;
+}
+
+// A fetcher that fills each byte of a 40-byte file with its offset into the
+// file, and counts its calls.
+DiskFileBlockCache::BlockFetcher CountingFetcher(int* calls) {
+  return [calls](const string& filename, size_t offset, size_t n,
+                 char* buffer, size_t* bytes_transferred) {
+    ++*calls;
+    const size_t file_size = 40;
+    *bytes_transferred =
+        offset < file_size ? std::min(n, file_size - offset) : 0;
+    for (size_t i = 0; i < *bytes_transferred; ++i) {
+      buffer[i] = static_cast<char>(offset + i);
+    }
+    return Status::OK();
+  };
+}
+
+TEST(DiskFileBlockCacheTest, IsCacheEnabled) {
+  int calls = 0;
+  const string dir = CacheDir();
+  EXPECT_FALSE(
+      DiskFileBlockCache(0, 32, 0, dir, CountingFetcher(&calls))
+          .IsCacheEnabled());
+  EXPECT_FALSE(
+      DiskFileBlockCache(16, 0, 0, dir, CountingFetcher(&calls))
+          .IsCacheEnabled());
+  EXPECT_FALSE(
+      DiskFileBlockCache(16, 32, 0, "", CountingFetcher(&calls))
+          .IsCacheEnabled());
+  EXPECT_TRUE(DiskFileBlockCache(16, 32, 0, dir, CountingFetcher(&calls))
+                  .IsCacheEnabled());
+}
+
+TEST(DiskFileBlockCacheTest, SharedAcrossInstances) {
+  int calls = 0;
+  const string dir = CacheDir();
+  std::vector<char> out;
+  {
+    DiskFileBlockCache cache(16, 1024, 0, dir, CountingFetcher(&calls));
+    TF_EXPECT_OK(ReadCache(&cache, "file", 4, 20, &out));
+    EXPECT_EQ(calls, 2);
+  }
+  // A new cache on the same directory, as after a restart or in another
+  // process, reads the blocks from disk.
+  DiskFileBlockCache cache(16, 1024, 0, dir, CountingFetcher(&calls));
+  TF_EXPECT_OK(ReadCache(&cache, "file", 4, 20, &out));
+  EXPECT_EQ(calls, 2);
+  ASSERT_EQ(out.size(), 20);
+  for (size_t i = 0; i < out.size(); ++i) {
+    EXPECT_EQ(out[i], static_cast<char>(4 + i));
+  }
+}
+
+TEST(DiskFileBlockCacheTest, EndOfFile) {
+  int calls = 0;
+  DiskFileBlockCache cache(16, 1024, 0, CacheDir(), CountingFetcher(&calls));
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "file", 32, 16, &out));
+  EXPECT_EQ(out.size(), 8);
+  EXPECT_EQ(ReadCache(&cache, "file", 44, 4, &out).code(),
+            error::OUT_OF_RANGE);
+  EXPECT_EQ(ReadCache(&cache, "file", 48, 4, &out).code(),
+            error::OUT_OF_RANGE);
+}
+
+TEST(DiskFileBlockCacheTest, SignatureChange) {
+  int calls = 0;
+  DiskFileBlockCache cache(16, 1024, 0, CacheDir(), CountingFetcher(&calls));
+  std::vector<char> out;
+  EXPECT_TRUE(cache.ValidateAndUpdateFileSignature("file", 123));
+  TF_EXPECT_OK(ReadCache(&cache, "file", 0, 16, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "file", 0, 16, &out));
+  EXPECT_EQ(calls, 1);
+  EXPECT_FALSE(cache.ValidateAndUpdateFileSignature("file", 456));
+  TF_EXPECT_OK(ReadCache(&cache, "file", 0, 16, &out));
+  EXPECT_EQ(calls, 2);
+}
+
+TEST(DiskFileBlockCacheTest, CorruptBlock) {
+  int calls = 0;
+  const string dir = CacheDir();
+  DiskFileBlockCache cache(16, 1024, 0, dir, CountingFetcher(&calls));
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "file", 0, 16, &out));
+  std::vector<string> blocks = BlockFiles(dir);
+  ASSERT_EQ(blocks.size(), 1);
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), blocks[0], "garbage"));
+  TF_EXPECT_OK(ReadCache(&cache, "file", 0, 16, &out));
+  EXPECT_EQ(calls, 2);
+  ASSERT_EQ(out.size(), 16);
+  EXPECT_EQ(out[15], 15);
+}
+
+TEST(DiskFileBlockCacheTest, MaxBytes) {
+  int calls = 0;
+  const string dir = CacheDir();
+  // Each block file holds 16 bytes of data and a 4-byte checksum.
+  DiskFileBlockCache cache(16, 50, 0, dir, CountingFetcher(&calls));
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, 16, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "b", 0, 16, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "c", 0, 16, &out));
+  EXPECT_LE(cache.CacheSize(), 50);
+  EXPECT_EQ(BlockFiles(dir).size(), 2);
+}
+
+TEST(DiskFileBlockCacheTest, MaxStaleness) {
+  int calls = 0;
+  NowSecondsEnv env;
+  env.SetNowSeconds(Env::Default()->NowSeconds());
+  DiskFileBlockCache cache(16, 1024, 10, CacheDir(), CountingFetcher(&calls),
+                           &env);
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "file", 0, 16, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "file", 0, 16, &out));
+  EXPECT_EQ(calls, 1);
+  env.SetNowSeconds(env.NowSeconds() + 100);
+  TF_EXPECT_OK(ReadCache(&cache, "file", 0, 16, &out));
+  EXPECT_EQ(calls, 2);
+}
+
+TEST(DiskFileBlockCacheTest, RemoveFileAndFlush) {
+  int calls = 0;
+  const string dir = CacheDir();
+  DiskFileBlockCache cache(16, 1024, 0, dir, CountingFetcher(&calls));
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, 32, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "b", 0, 16, &out));
+  EXPECT_EQ(BlockFiles(dir).size(), 3);
+  cache.RemoveFile("a");
+  EXPECT_EQ(BlockFiles(dir).size(), 1);
+  EXPECT_EQ(cache.CacheSize(), 20);
+  cache.Flush();
+  EXPECT_EQ(BlockFiles(dir).size(), 0);
+  EXPECT_EQ(cache.CacheSize(), 0);
+}
+
+}  // namespace
+}  // namespace tensorflow
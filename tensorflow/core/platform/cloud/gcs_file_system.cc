@@ -28,6 +28,7 @@ limitations under the License.
 #include "absl/base/macros.h"
 #include "include/json/json.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/io/path.h"
@@ -35,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/cloud/curl_http_request.h"
+#include "tensorflow/core/platform/cloud/disk_file_block_cache.h"
 #include "tensorflow/core/platform/cloud/file_block_cache.h"
 #include "tensorflow/core/platform/cloud/google_auth_provider.h"
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
@@ -83,6 +85,29 @@ constexpr size_t kDefaultMaxCacheSize = 2 * kDefaultBlockSize;
 // will be evicted on the next read.
 constexpr char kMaxStaleness[] = "GCS_READ_CACHE_MAX_STALENESS";
 constexpr uint64 kDefaultMaxStaleness = 0;
+// The environment variable that sets how many blocks past a sequential read
+// are fetched in the background. Readahead is off by default, and is capped
+// by how many blocks fit in the cache.
+constexpr char kReadaheadBlocks[] = "GCS_READ_CACHE_READAHEAD_BLOCKS";
+constexpr size_t kDefaultReadaheadBlocks = 0;
+// The environment variable that overrides how many readahead requests may be
+// in flight at once, across all files.
+constexpr char kMaxReadaheadRequests[] =
+    "GCS_READ_CACHE_MAX_READAHEAD_REQUESTS";
+constexpr int kDefaultMaxReadaheadRequests = 16;
+// The environment variable that enables a second cache tier on local disk,
+// shared by all processes that use the same directory and kept across
+// restarts. Blocks are fetched from GCS into this directory, and from there
+// into the block cache in memory.
+constexpr char kDiskCachePath[] = "GCS_READ_CACHE_DISK_PATH";
+// The environment variable that overrides the max size of the disk cache.
+// Specified in MB.
+constexpr char kDiskCacheMaxSize[] = "GCS_READ_CACHE_DISK_MAX_SIZE_MB";
+constexpr size_t kDefaultDiskCacheMaxSize = 10240;
+// The environment variable that overrides how many threads run the
+// RandomAccessFile::ReadAsync() calls of all GCS files.
+constexpr char kAsyncReadThreads[] = "GCS_READ_ASYNC_THREADS";
+constexpr int64 kDefaultAsyncReadThreads = 32;
 // The environment variable that overrides the maximum age of entries in the
 // Stat cache. A value of 0 (the default) means nothing is cached.
 constexpr char kStatCacheMaxAge[] = "GCS_STAT_CACHE_MAX_AGE";
@@ -301,6 +326,22 @@ Status GetBoolValue(const Json::Value& parent, const char* name, bool* result) {
 }
 
 /// A GCS-based implementation of a random access file with an LRU block cache.
+// Returns the threads that run the ReadAsync() calls of all GCS files. Each
+// of them blocks on one HTTP request at a time, so their number bounds the
+// reads in flight.
+thread::ThreadPool* AsyncReadPool() {
+  static thread::ThreadPool* pool = [] {
+    int64 num_threads = kDefaultAsyncReadThreads;
+    const char* value = std::getenv(kAsyncReadThreads);
+    if (value && !strings::safe_strto64(value, &num_threads)) {
+      num_threads = kDefaultAsyncReadThreads;
+    }
+    return new thread::ThreadPool(Env::Default(), "gcs_read_async",
+                                  std::max<int64>(1, num_threads));
+  }();
+  return pool;
+}
+
 class GcsRandomAccessFile : public RandomAccessFile {
  public:
   using ReadFn =
@@ -316,6 +357,16 @@ class GcsRandomAccessFile : public RandomAccessFile {
     return read_fn_(filename_, offset, n, result, scratch);
   }
 
+  /// Runs the read on a thread pool shared by all GCS files.
+  void ReadAsync(uint64 offset, size_t n, char* scratch,
+                 ReadDoneCallback done) const override {
+    AsyncReadPool()->Schedule([this, offset, n, scratch, done]() {
+      StringPiece result;
+      Status s = Read(offset, n, &result, scratch);
+      done(s, result);
+    });
+  }
+
  private:
   /// The filename of this file.
   const string filename_;
@@ -671,7 +722,8 @@ GcsFileSystem::GcsFileSystem() {
   VLOG(1) << "GCS cache max size = " << max_bytes << " ; "
           << "block size = " << block_size << " ; "
           << "max staleness = " << max_staleness;
-  file_block_cache_ = MakeFileBlockCache(block_size, max_bytes, max_staleness);
+  file_block_cache_ = MakeFileBlockCache(block_size, max_bytes, max_staleness,
+                                         &disk_block_cache_);
   // Apply overrides for the stat cache max age and max entries, if provided.
   uint64 stat_cache_max_age = kStatCacheDefaultMaxAge;
   size_t stat_cache_max_entries = kStatCacheDefaultMaxEntries;
@@ -797,8 +849,8 @@ GcsFileSystem::GcsFileSystem(
     : auth_provider_(std::move(auth_provider)),
       http_request_factory_(std::move(http_request_factory)),
       zone_provider_(std::move(zone_provider)),
-      file_block_cache_(
-          MakeFileBlockCache(block_size, max_bytes, max_staleness)),
+      file_block_cache_(MakeFileBlockCache(block_size, max_bytes,
+                                           max_staleness, &disk_block_cache_)),
       stat_cache_(new StatCache(stat_cache_max_age, stat_cache_max_entries)),
       matching_paths_cache_(new MatchingPathsCache(
           matching_paths_cache_max_age, matching_paths_cache_max_entries)),
@@ -833,6 +885,10 @@ Status GcsFileSystem::NewRandomAccessFile(
             << "File signature has been changed. Refreshing the cache. Path: "
             << fname;
       }
+      if (disk_block_cache_ != nullptr) {
+        disk_block_cache_->ValidateAndUpdateFileSignature(
+            fname, stat.generation_number);
+      }
     }
     *result = StringPiece();
     size_t bytes_transferred;
@@ -854,7 +910,8 @@ void GcsFileSystem::ResetFileBlockCache(size_t block_size_bytes,
                                         uint64 max_staleness_secs) {
   mutex_lock l(block_cache_lock_);
   file_block_cache_ =
-      MakeFileBlockCache(block_size_bytes, max_bytes, max_staleness_secs);
+      MakeFileBlockCache(block_size_bytes, max_bytes, max_staleness_secs,
+                         &disk_block_cache_);
   if (stats_ != nullptr) {
     stats_->Configure(this, &throttle_, file_block_cache_.get());
   }
@@ -862,14 +919,47 @@ void GcsFileSystem::ResetFileBlockCache(size_t block_size_bytes,
 
 // A helper function to build a FileBlockCache for GcsFileSystem.
 std::unique_ptr<FileBlockCache> GcsFileSystem::MakeFileBlockCache(
-    size_t block_size, size_t max_bytes, uint64 max_staleness) {
+    size_t block_size, size_t max_bytes, uint64 max_staleness,
+    std::shared_ptr<FileBlockCache>* disk_block_cache) {
+  size_t readahead_blocks = kDefaultReadaheadBlocks;
+  int max_readahead_requests = kDefaultMaxReadaheadRequests;
+  uint64 value;
+  if (GetEnvVar(kReadaheadBlocks, strings::safe_strtou64, &value)) {
+    readahead_blocks = value;
+  }
+  if (GetEnvVar(kMaxReadaheadRequests, strings::safe_strtou64, &value)) {
+    max_readahead_requests = value;
+  }
+  FileBlockCache::BlockFetcher fetcher = [this](const string& filename,
+                                                size_t offset, size_t n,
+                                                char* buffer,
+                                                size_t* bytes_transferred) {
+    return LoadBufferFromGCS(filename, offset, n, buffer, bytes_transferred);
+  };
+  disk_block_cache->reset();
+  const char* disk_cache_path = std::getenv(kDiskCachePath);
+  if (disk_cache_path != nullptr && block_size > 0 && max_bytes > 0) {
+    size_t disk_max_bytes = kDefaultDiskCacheMaxSize * 1024 * 1024;
+    if (GetEnvVar(kDiskCacheMaxSize, strings::safe_strtou64, &value)) {
+      disk_max_bytes = value * 1024 * 1024;
+    }
+    // Both tiers use the same blocks, so each block read into memory is
+    // exactly one block of the disk cache.
+    std::shared_ptr<FileBlockCache> disk(
+        new DiskFileBlockCache(block_size, disk_max_bytes, max_staleness,
+                               disk_cache_path, std::move(fetcher)));
+    *disk_block_cache = disk;
+    fetcher = [disk](const string& filename, size_t offset, size_t n,
+                     char* buffer, size_t* bytes_transferred) {
+      Status s = disk->Read(filename, offset, n, buffer, bytes_transferred);
+      // Reads past the end of the file succeed with no bytes, as they do
+      // from GCS.
+      return errors::IsOutOfRange(s) ? Status::OK() : s;
+    };
+  }
   std::unique_ptr<FileBlockCache> file_block_cache(new RamFileBlockCache(
-      block_size, max_bytes, max_staleness,
-      [this](const string& filename, size_t offset, size_t n, char* buffer,
-             size_t* bytes_transferred) {
-        return LoadBufferFromGCS(filename, offset, n, buffer,
-                                 bytes_transferred);
-      }));
+      block_size, max_bytes, max_staleness, std::move(fetcher), Env::Default(),
+      readahead_blocks, max_readahead_requests));
   return file_block_cache;
 }
 
@@ -293,9 +293,11 @@ class GcsFileSystem : public FileSystem {
 
   Status RenameObject(const string& src, const string& target);
 
-  std::unique_ptr<FileBlockCache> MakeFileBlockCache(size_t block_size,
-                                                     size_t max_bytes,
-                                                     uint64 max_staleness);
+  /// Also sets `*disk_block_cache` to the local disk tier behind the
+  /// returned cache, or to nullptr if there is none.
+  std::unique_ptr<FileBlockCache> MakeFileBlockCache(
+      size_t block_size, size_t max_bytes, uint64 max_staleness,
+      std::shared_ptr<FileBlockCache>* disk_block_cache);
 
   /// Loads file contents from GCS for a given filename, offset, and length.
   Status LoadBufferFromGCS(const string& filename, size_t offset, size_t n,
@@ -311,6 +313,10 @@ class GcsFileSystem : public FileSystem {
   // block_cache_lock_ protects the file_block_cache_ pointer (Note that
   // FileBlockCache instances are themselves threadsafe).
   mutex block_cache_lock_;
+  // The optional disk tier that file_block_cache_ fetches its blocks from.
+  // Declared first, since the constructor initializes both in one call.
+  std::shared_ptr<FileBlockCache> disk_block_cache_
+      GUARDED_BY(block_cache_lock_);
   std::unique_ptr<FileBlockCache> file_block_cache_
       GUARDED_BY(block_cache_lock_);
   std::shared_ptr<ComputeEngineMetadataClient> compute_engine_metadata_client_;
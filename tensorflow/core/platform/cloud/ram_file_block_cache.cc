@@ -80,11 +80,17 @@ Status RamFileBlockCache::UpdateLRU(const Key& key,
   // in the cache, and our current block is not block size, this likely means
   // we have inconsistent state within the cache. Note: it's possible some
   // incomplete reads may still go undetected.
+  // Blocks that are still being fetched, or that were read ahead past the
+  // end of the file and are empty, say nothing about the file's size.
   if (block->data.size() < block_size_) {
     Key fmax = std::make_pair(key.first, std::numeric_limits<size_t>::max());
     auto fcmp = block_map_.upper_bound(fmax);
-    if (fcmp != block_map_.begin() && key < (--fcmp)->first) {
-      return errors::Internal("Block cache contents are inconsistent.");
+    while (fcmp != block_map_.begin() && key < (--fcmp)->first) {
+      mutex_lock l(fcmp->second->mu);
+      if (fcmp->second->state == FetchState::FINISHED &&
+          !fcmp->second->data.empty()) {
+        return errors::Internal("Block cache contents are inconsistent.");
+      }
     }
   }
 
@@ -172,6 +178,14 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
   if (finish < offset + n) {
     finish += block_size_;
   }
+  // Reads that continue from a cached block, or that start a file, are
+  // taken to be sequential and trigger readahead.
+  bool sequential = false;
+  if (readahead_blocks_ > 0) {
+    mutex_lock lock(mu_);
+    sequential = start == 0 || block_map_.count(std::make_pair(
+                                   filename, start - block_size_)) > 0;
+  }
   size_t total_bytes_transferred = 0;
   // Now iterate through the blocks, reading them one at a time.
   for (size_t pos = start; pos < finish; pos += block_size_) {
@@ -210,13 +224,38 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
     }
     if (data.size() < block_size_) {
       // The block was a partial block and thus signals EOF at its upper bound.
-      break;
+      *bytes_transferred = total_bytes_transferred;
+      return Status::OK();
     }
   }
   *bytes_transferred = total_bytes_transferred;
+  if (sequential) {
+    Readahead(filename, finish);
+  }
   return Status::OK();
 }
 
+void RamFileBlockCache::Readahead(const string& filename, size_t offset) {
+  for (size_t i = 0; i < readahead_blocks_; ++i) {
+    Key key = std::make_pair(filename, offset + i * block_size_);
+    {
+      mutex_lock lock(mu_);
+      if (num_readahead_requests_ >= max_readahead_requests_) return;
+      if (block_map_.count(key) > 0) continue;
+      ++num_readahead_requests_;
+    }
+    std::shared_ptr<Block> block = Lookup(key);
+    readahead_pool_->Schedule([this, key, block] {
+      // A failed fetch leaves the block in the ERROR state, and the read
+      // that needs it fetches it again.
+      MaybeFetch(key, block).IgnoreError();
+      mutex_lock lock(mu_);
+      --num_readahead_requests_;
+      Trim();
+    });
+  }
+}
+
 bool RamFileBlockCache::ValidateAndUpdateFileSignature(const string& filename,
                                                        int64 file_signature) {
   mutex_lock lock(mu_);
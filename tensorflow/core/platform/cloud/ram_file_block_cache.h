@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_RAM_FILE_BLOCK_CACHE_H_
 #define TENSORFLOW_CORE_PLATFORM_CLOUD_RAM_FILE_BLOCK_CACHE_H_
 
+#include <algorithm>
 #include <functional>
 #include <list>
 #include <map>
@@ -24,6 +25,7 @@ limitations under the License.
 #include <vector>
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/cloud/file_block_cache.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -49,22 +51,41 @@ class RamFileBlockCache : public FileBlockCache {
                                size_t* bytes_transferred)>
       BlockFetcher;
 
+  /// When `readahead_blocks` and `max_readahead_requests` are both positive,
+  /// a read that continues from the previous block of a file (or starts at
+  /// its beginning) also starts fetching the following `readahead_blocks`
+  /// blocks in the background. At most `max_readahead_requests` such fetches
+  /// are in flight at once, across all files, and readahead never fetches
+  /// more blocks than the cache can hold next to the block being read.
   RamFileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
-                    BlockFetcher block_fetcher, Env* env = Env::Default())
+                    BlockFetcher block_fetcher, Env* env = Env::Default(),
+                    size_t readahead_blocks = 0, int max_readahead_requests = 0)
       : block_size_(block_size),
         max_bytes_(max_bytes),
         max_staleness_(max_staleness),
         block_fetcher_(block_fetcher),
-        env_(env) {
+        env_(env),
+        readahead_blocks_(
+            IsCacheEnabled() && max_readahead_requests > 0 &&
+                    max_bytes / block_size > 1
+                ? std::min(readahead_blocks, max_bytes / block_size - 1)
+                : 0),
+        max_readahead_requests_(max_readahead_requests) {
     if (max_staleness_ > 0) {
       pruning_thread_.reset(env_->StartThread(ThreadOptions(), "TF_prune_FBC",
                                               [this] { Prune(); }));
     }
+    if (readahead_blocks_ > 0) {
+      readahead_pool_.reset(new thread::ThreadPool(
+          env_, "TF_readahead_FBC", max_readahead_requests_));
+    }
     VLOG(1) << "GCS file block cache is "
             << (IsCacheEnabled() ? "enabled" : "disabled");
   }
 
   ~RamFileBlockCache() override {
+    // Destroying readahead_pool_ waits for the fetches in flight.
+    readahead_pool_.reset();
     if (pruning_thread_) {
       stop_pruning_thread_.Notify();
       // Destroying pruning_thread_ will block until Prune() receives the above
@@ -130,6 +151,10 @@ class RamFileBlockCache : public FileBlockCache {
   const BlockFetcher block_fetcher_;
   /// The Env from which we read timestamps.
   Env* const env_;  // not owned
+  /// The number of blocks fetched ahead of sequential reads, or 0.
+  const size_t readahead_blocks_;
+  /// The maximum number of readahead fetches in flight.
+  const int max_readahead_requests_;
 
   /// \brief The key type for the file block cache.
   ///
@@ -196,6 +221,10 @@ class RamFileBlockCache : public FileBlockCache {
   /// Look up a Key in the block cache.
   std::shared_ptr<Block> Lookup(const Key& key) LOCKS_EXCLUDED(mu_);
 
+  /// Start fetching the `readahead_blocks_` blocks of `filename` from the
+  /// block-aligned `offset` on, skipping blocks that are already cached.
+  void Readahead(const string& filename, size_t offset) LOCKS_EXCLUDED(mu_);
+
   Status MaybeFetch(const Key& key, const std::shared_ptr<Block>& block)
       LOCKS_EXCLUDED(mu_);
 
@@ -219,6 +248,9 @@ class RamFileBlockCache : public FileBlockCache {
   /// Notification for stopping the cache pruning thread.
   Notification stop_pruning_thread_;
 
+  /// Runs the readahead fetches, if readahead is enabled.
+  std::unique_ptr<thread::ThreadPool> readahead_pool_;
+
   /// Guards access to the block map, LRU list, and cached byte count.
   mutable mutex mu_;
 
@@ -239,6 +271,9 @@ class RamFileBlockCache : public FileBlockCache {
   /// The combined number of bytes in all of the cached blocks.
   size_t cache_size_ GUARDED_BY(mu_) = 0;
 
+  /// The number of readahead fetches scheduled and not yet finished.
+  int num_readahead_requests_ GUARDED_BY(mu_) = 0;
+
   // A filename->file_signature map.
   std::map<string, int64> file_signature_map_ GUARDED_BY(mu_);
 };
@@ -560,5 +560,80 @@ TEST(RamFileBlockCacheTest, Flush) {
   EXPECT_EQ(calls, 2);
 }
 
+TEST(RamFileBlockCacheTest, ReadaheadSequentialReads) {
+  const size_t block_size = 16;
+  mutex mu;
+  std::set<size_t> calls;
+  auto fetcher = [&mu, &calls](const string& filename, size_t offset, size_t n,
+                               char* buffer, size_t* bytes_transferred) {
+    {
+      mutex_lock l(mu);
+      EXPECT_EQ(calls.find(offset), calls.end()) << "at offset " << offset;
+      calls.insert(offset);
+    }
+    memset(buffer, 'x', n);
+    *bytes_transferred = n;
+    return Status::OK();
+  };
+  std::vector<char> out;
+  {
+    RamFileBlockCache cache(block_size, 16 * block_size, 0, fetcher,
+                            Env::Default(), 2, 4);
+    // The first read starts the file, so it reads ahead blocks 1 and 2.
+    TF_EXPECT_OK(ReadCache(&cache, "", 0, block_size, &out));
+    // The second read continues from block 0, and reads ahead block 3.
+    TF_EXPECT_OK(ReadCache(&cache, "", block_size, block_size, &out));
+    EXPECT_EQ(out.size(), block_size);
+    // The cache waits for the fetches in flight when it is destroyed.
+  }
+  EXPECT_EQ(calls, std::set<size_t>({0, 16, 32, 48}));
+}
+
+TEST(RamFileBlockCacheTest, NoReadaheadForRandomReads) {
+  const size_t block_size = 16;
+  mutex mu;
+  std::set<size_t> calls;
+  auto fetcher = [&mu, &calls](const string& filename, size_t offset, size_t n,
+                               char* buffer, size_t* bytes_transferred) {
+    mutex_lock l(mu);
+    calls.insert(offset);
+    memset(buffer, 'x', n);
+    *bytes_transferred = n;
+    return Status::OK();
+  };
+  std::vector<char> out;
+  {
+    RamFileBlockCache cache(block_size, 16 * block_size, 0, fetcher,
+                            Env::Default(), 2, 4);
+    TF_EXPECT_OK(ReadCache(&cache, "", 4 * block_size, block_size, &out));
+    TF_EXPECT_OK(ReadCache(&cache, "", 8 * block_size, block_size, &out));
+  }
+  EXPECT_EQ(calls, std::set<size_t>({64, 128}));
+}
+
+TEST(RamFileBlockCacheTest, ReadaheadPastEndOfFile) {
+  // A 20-byte file, so that readahead fetches a partial and an empty block.
+  const size_t block_size = 16;
+  const size_t file_size = 20;
+  auto fetcher = [file_size](const string& filename, size_t offset, size_t n,
+                             char* buffer, size_t* bytes_transferred) {
+    const size_t bytes_to_copy =
+        offset < file_size ? std::min(n, file_size - offset) : 0;
+    memset(buffer, 'x', bytes_to_copy);
+    *bytes_transferred = bytes_to_copy;
+    return Status::OK();
+  };
+  RamFileBlockCache cache(block_size, 16 * block_size, 0, fetcher,
+                          Env::Default(), 2, 4);
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "", 0, block_size, &out));
+  // The empty block read ahead after the partial one does not make the
+  // partial block look inconsistent.
+  TF_EXPECT_OK(ReadCache(&cache, "", block_size, block_size, &out));
+  EXPECT_EQ(out.size(), file_size - block_size);
+  EXPECT_EQ(ReadCache(&cache, "", 2 * block_size, block_size, &out).code(),
+            error::OUT_OF_RANGE);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -159,6 +159,23 @@ class RetryingRandomAccessFile : public RandomAccessFile {
         retry_config_);
   }
 
+  void ReadAsync(uint64 offset, size_t n, char* scratch,
+                 ReadDoneCallback done) const override {
+    base_file_->ReadAsync(
+        offset, n, scratch,
+        [this, offset, n, scratch, done](const Status& s, StringPiece data) {
+          if (s.ok() || errors::IsOutOfRange(s)) {
+            done(s, data);
+            return;
+          }
+          // Falls back to a synchronous read, which retries the retriable
+          // errors and returns the others right away.
+          StringPiece result;
+          Status status = Read(offset, n, &result, scratch);
+          done(status, result);
+        });
+  }
+
  private:
   std::unique_ptr<RandomAccessFile> base_file_;
   const RetryConfig retry_config_;
@@ -225,6 +225,38 @@ TEST(RetryingFileSystemTest, NewRandomAccessFile_SuccessWith3rdTry) {
   TF_EXPECT_OK(random_access_file->Read(0, 10, &result, scratch));
 }
 
+TEST(RetryingFileSystemTest, NewRandomAccessFile_ReadAsyncRetries) {
+  // Configure the mock base random access file. The default ReadAsync() calls
+  // Read(), and the retries go through Read() as well.
+  ExpectedCalls expected_file_calls(
+      {std::make_tuple("Read", errors::Unavailable("Something is wrong")),
+       std::make_tuple("Read", errors::Unavailable("Wrong again")),
+       std::make_tuple("Read", Status::OK())});
+  std::unique_ptr<RandomAccessFile> base_file(
+      new MockRandomAccessFile(expected_file_calls));
+
+  // Configure the mock base file system.
+  ExpectedCalls expected_fs_calls(
+      {std::make_tuple("NewRandomAccessFile", Status::OK())});
+  std::unique_ptr<MockFileSystem> base_fs(
+      new MockFileSystem(expected_fs_calls));
+  base_fs->random_access_file_to_return = std::move(base_file);
+  RetryingFileSystem<MockFileSystem> fs(
+      std::move(base_fs), RetryConfig(0 /* init_delay_time_us */));
+
+  // Retrieve the wrapped random access file.
+  std::unique_ptr<RandomAccessFile> random_access_file;
+  TF_EXPECT_OK(fs.NewRandomAccessFile("filename.txt", &random_access_file));
+
+  // Use it and check the results.
+  Status status = errors::Unknown("Not called");
+  char scratch[10];
+  random_access_file->ReadAsync(
+      0, 10, scratch,
+      [&status](const Status& s, StringPiece data) { status = s; });
+  TF_EXPECT_OK(status);
+}
+
 TEST(RetryingFileSystemTest, NewRandomAccessFile_AllRetriesFailed) {
   // Configure the mock base random access file.
   ExpectedCalls expected_file_calls = CreateRetriableErrors("Read", 11);
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_PLATFORM_CPU_INFO_H_
 
 #include <string>
+#include <vector>
 
 // TODO(ahentz): This is not strictly required here but, for historical
 // reasons, many people depend on cpu_info.h in order to use kLittleEndian.
@@ -39,6 +40,11 @@ int NumSchedulableCPUs();
 // on the CPU
 int NumHyperthreadsPerCore();
 
+// If possible, restricts the current thread to run on the given CPUs.
+// Returns false if the affinity could not be set, e.g. if the platform does
+// not support it.
+bool SetCurrentThreadCpuAffinity(const std::vector<int>& cpus);
+
 // Mostly ISA related features that we care about
 enum CPUFeature {
   // Do not change numeric assignments.
@@ -391,6 +391,9 @@ class DeviceTracerImpl : public DeviceTracer,
 
   mutex mu_;
   bool enabled_ GUARDED_BY(mu_);
+  // The trace collector replaced while tracing, restored by `Stop()`.
+  const tracing::TraceCollector* previous_trace_collector_ GUARDED_BY(mu_) =
+      nullptr;
   int64 start_walltime_us_ GUARDED_BY(mu_);
   int64 end_walltime_us_ GUARDED_BY(mu_);
   uint64_t start_timestamp_ GUARDED_BY(mu_);
@@ -430,6 +433,7 @@ Status DeviceTracerImpl::Start() {
   }
 
   // Register as a TraceEngine to receive ScopedAnnotations.
+  previous_trace_collector_ = tracing::GetTraceCollector();
   tracing::SetTraceCollector(this);
 
   // Intercept launch and memcpy calls to capture the Op name annotation.
@@ -478,7 +482,8 @@ Status DeviceTracerImpl::Stop() {
     return Status::OK();
   }
   CUPTI_CALL(Unsubscribe(subscriber_));
-  tracing::SetTraceCollector(nullptr);
+  tracing::SetTraceCollector(previous_trace_collector_);
+  previous_trace_collector_ = nullptr;
   TF_RETURN_IF_ERROR(cupti_manager_->DisableTrace());
   end_walltime_us_ = NowInUsec();
   CUPTI_CALL(GetTimestamp(&end_timestamp_));
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -395,6 +396,11 @@ struct ThreadOptions {
   size_t stack_size = 0;  // 0: use system default value
   /// Guard area size to use near thread stacks to use (in bytes)
   size_t guard_size = 0;  // 0: use system default value
+  /// NUMA node the thread is pinned to, if supported by the platform.
+  int numa_node = port::kNUMANoAffinity;
+  /// CPUs the thread is restricted to, if supported by the platform, or
+  /// empty for no restriction. Applied after numa_node.
+  std::vector<int> cpu_affinity;
 };
 
 /// A utility routine: copy contents of `src` in file system `src_fs`
@@ -51,6 +51,13 @@ void FileSystem::FlushCaches() {}
 
 RandomAccessFile::~RandomAccessFile() {}
 
+void RandomAccessFile::ReadAsync(uint64 offset, size_t n, char* scratch,
+                                 ReadDoneCallback done) const {
+  StringPiece result;
+  Status s = Read(offset, n, &result, scratch);
+  done(s, result);
+}
+
 WritableFile::~WritableFile() {}
 
 FileSystemRegistry::~FileSystemRegistry() {}
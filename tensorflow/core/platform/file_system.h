@@ -239,6 +239,24 @@ class RandomAccessFile {
   virtual Status Read(uint64 offset, size_t n, StringPiece* result,
                       char* scratch) const = 0;
 
+  /// \brief Called when a `ReadAsync` completes, with the status and the data
+  /// that `Read` would have returned.
+  typedef std::function<void(const Status&, StringPiece)> ReadDoneCallback;
+
+  /// \brief Reads up to `n` bytes from the file starting at `offset`, with
+  /// the semantics of `Read`, and calls `done` once the read completes.
+  ///
+  /// `done` may be called before `ReadAsync` returns, and from any thread.
+  /// `scratch[0..n-1]` and the file itself must stay live until then.
+  ///
+  /// The default implementation calls `Read` synchronously. Files with slow
+  /// reads, such as remote ones, override it so that callers can overlap
+  /// several reads without a thread per read.
+  ///
+  /// Safe for concurrent use by multiple threads.
+  virtual void ReadAsync(uint64 offset, size_t n, char* scratch,
+                         ReadDoneCallback done) const;
+
  private:
   TF_DISALLOW_COPY_AND_ASSIGN(RandomAccessFile);
 };
@@ -0,0 +1,45 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_PERF_COUNTERS_H_
+#define TENSORFLOW_CORE_PLATFORM_PERF_COUNTERS_H_
+
+#include "tensorflow/core/platform/platform.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace port {
+
+// The values of the hardware performance counters of a thread, counted since
+// the counters of the thread were opened.
+struct PerfCounterValues {
+  int64 cycles = 0;
+  int64 instructions = 0;
+  // Last level cache references and misses.
+  int64 cache_references = 0;
+  int64 cache_misses = 0;
+};
+
+// Returns true iff the hardware performance counters can be read on this
+// platform. On Linux, this depends on the perf_event_paranoid setting.
+bool PerfCountersEnabled();
+
+// Reads the hardware performance counters of the calling thread, opening them
+// on the first call from the thread. Returns false if they cannot be read.
+bool ReadThreadPerfCounters(PerfCounterValues* values);
+
+}  // namespace port
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_PLATFORM_PERF_COUNTERS_H_
@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/perf_counters.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -76,5 +77,22 @@ TEST(TestCPUFeature, TestFeature) {
   LOG(INFO) << "has_avx2 = " << has_avx2;
 }
 
+TEST(Port, ReadThreadPerfCounters) {
+  PerfCounterValues before;
+  if (!ReadThreadPerfCounters(&before)) {
+    // The counters are not available on this platform or to this process.
+    EXPECT_FALSE(PerfCountersEnabled());
+    return;
+  }
+  volatile int64 sum = 0;
+  for (int i = 0; i < 1000000; ++i) sum += i;
+  PerfCounterValues after;
+  ASSERT_TRUE(ReadThreadPerfCounters(&after));
+  EXPECT_GT(after.cycles, before.cycles);
+  EXPECT_GT(after.instructions - before.instructions, 1000000);
+  EXPECT_GE(after.cache_references, before.cache_references);
+  EXPECT_GE(after.cache_misses, before.cache_misses);
+}
+
 }  // namespace port
 }  // namespace tensorflow
@@ -29,9 +29,11 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/lib/core/error_codes.pb.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/load_library.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/posix/posix_file_system.h"
 
 namespace tensorflow {
@@ -40,10 +42,21 @@ namespace {
 
 class StdThread : public Thread {
  public:
-  // name and thread_options are both ignored.
+  // name and thread_options other than numa_node and cpu_affinity are
+  // ignored.
   StdThread(const ThreadOptions& thread_options, const string& name,
             std::function<void()> fn)
-      : thread_(fn) {}
+      : thread_([thread_options, fn]() {
+          if (thread_options.numa_node != port::kNUMANoAffinity) {
+            port::NUMASetThreadNodeAffinity(thread_options.numa_node);
+          }
+          if (!thread_options.cpu_affinity.empty() &&
+              !port::SetCurrentThreadCpuAffinity(
+                  thread_options.cpu_affinity)) {
+            LOG(WARNING) << "Failed to set the CPU affinity of a thread";
+          }
+          fn();
+        }) {}
   ~StdThread() override { thread_.join(); }
 
  private:
@@ -19,17 +19,24 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/perf_counters.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/types.h"
 
 #if defined(__linux__) && !defined(__ANDROID__)
+#include <linux/perf_event.h>
 #include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <sys/sysinfo.h>
 #endif
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+
+#include <vector>
 #ifdef TF_USE_SNAPPY
 #include "snappy.h"
 #endif
@@ -74,19 +81,237 @@ int NumHyperthreadsPerCore() {
   return (ht_per_core > 0) ? ht_per_core : 1;
 }
 
-bool NUMAEnabled() {
-  // Not yet implemented: coming soon.
+bool SetCurrentThreadCpuAffinity(const std::vector<int>& cpus) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (int cpu : cpus) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    CPU_SET(cpu, &cpuset);
+  }
+  if (sched_setaffinity(0, sizeof(cpu_set_t), &cpuset) != 0) {
+    perror("sched_setaffinity");
+    return false;
+  }
+  return true;
+#else
   return false;
+#endif
 }
 
-int NUMANumNodes() { return 1; }
+#if defined(__linux__) && !defined(__ANDROID__)
+namespace {
+
+// Memory policy constants of the mbind and get_mempolicy syscalls, from
+// <numaif.h>, which comes with libnuma rather than with the C library.
+constexpr int kMpolBind = 2;
+constexpr int kMpolFNode = 1 << 0;
+constexpr int kMpolFAddr = 1 << 1;
+
+// Parses a sysfs list of ranges like "0-3,8,10-11" into `values`.
+bool ParseSysfsList(const char* path, std::vector<int>* values) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) return false;
+  char buf[4096];
+  const bool read = fgets(buf, sizeof(buf), file) != nullptr;
+  fclose(file);
+  if (!read) return false;
+  values->clear();
+  const char* p = buf;
+  while (*p != '\0' && *p != '\n') {
+    char* end;
+    const long first = strtol(p, &end, 10);
+    if (end == p) return false;
+    long last = first;
+    p = end;
+    if (*p == '-') {
+      last = strtol(p + 1, &end, 10);
+      if (end == p + 1) return false;
+      p = end;
+    }
+    for (long i = first; i <= last; ++i) values->push_back(i);
+    if (*p == ',') ++p;
+  }
+  return true;
+}
+
+// A NUMA node with CPUs. NUMA functions index nodes in the order of this
+// list, which skips memory-only nodes.
+struct NUMANode {
+  int id;  // Kernel node id, for mbind.
+  std::vector<int> cpus;
+};
+
+struct NUMATopology {
+  std::vector<NUMANode> nodes;
+  // Affinity of the thread that first used the NUMA functions, restored by
+  // NUMASetThreadNodeAffinity(kNUMANoAffinity).
+  cpu_set_t default_affinity;
+};
+
+const NUMATopology& GetNUMATopology() {
+  static const NUMATopology* topology = [] {
+    NUMATopology* t = new NUMATopology;
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &t->default_affinity) != 0) {
+      CPU_ZERO(&t->default_affinity);
+    }
+    std::vector<int> node_ids;
+    if (!ParseSysfsList("/sys/devices/system/node/online", &node_ids)) {
+      return t;
+    }
+    for (int id : node_ids) {
+      NUMANode node;
+      node.id = id;
+      char path[128];
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+               id);
+      if (ParseSysfsList(path, &node.cpus) && !node.cpus.empty()) {
+        t->nodes.push_back(std::move(node));
+      }
+    }
+    return t;
+  }();
+  return *topology;
+}
+
+}  // namespace
+#endif  // defined(__linux__) && !defined(__ANDROID__)
+
+bool NUMAEnabled() { return NUMANumNodes() > 1; }
+
+int NUMANumNodes() {
+#if defined(__linux__) && !defined(__ANDROID__)
+  const int num_nodes = GetNUMATopology().nodes.size();
+  return num_nodes > 0 ? num_nodes : 1;
+#else
+  return 1;
+#endif
+}
 
-void NUMASetThreadNodeAffinity(int node) {}
+void NUMASetThreadNodeAffinity(int node) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  if (!NUMAEnabled()) return;
+  const NUMATopology& topology = GetNUMATopology();
+  cpu_set_t cpuset;
+  if (node == kNUMANoAffinity) {
+    cpuset = topology.default_affinity;
+  } else {
+    CHECK_GE(node, 0);
+    CHECK_LT(node, static_cast<int>(topology.nodes.size()));
+    CPU_ZERO(&cpuset);
+    for (int cpu : topology.nodes[node].cpus) CPU_SET(cpu, &cpuset);
+  }
+  if (sched_setaffinity(0, sizeof(cpu_set_t), &cpuset) != 0) {
+    perror("sched_setaffinity");
+  }
+#endif
+}
 
 int NUMAGetThreadNodeAffinity() {
+#if defined(__linux__) && !defined(__ANDROID__)
+  if (!NUMAEnabled()) return kNUMANoAffinity;
+  cpu_set_t cpuset;
+  if (sched_getaffinity(0, sizeof(cpu_set_t), &cpuset) != 0) {
+    return kNUMANoAffinity;
+  }
+  const NUMATopology& topology = GetNUMATopology();
+  for (int node = 0; node < static_cast<int>(topology.nodes.size()); ++node) {
+    int num_cpus_in_node = 0;
+    for (int cpu : topology.nodes[node].cpus) {
+      if (CPU_ISSET(cpu, &cpuset)) ++num_cpus_in_node;
+    }
+    if (num_cpus_in_node > 0 && num_cpus_in_node == CPU_COUNT(&cpuset)) {
+      return node;
+    }
+  }
+#endif
   return kNUMANoAffinity;
 }
 
+#if defined(__linux__) && !defined(__ANDROID__)
+namespace {
+
+// The hardware performance counters of the thread that created it, opened as
+// a perf event group so that they are read together.
+class ThreadPerfCounters {
+ public:
+  ThreadPerfCounters() {
+    const uint64 configs[kNumCounters] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES};
+    for (int i = 0; i < kNumCounters; ++i) {
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = configs[i];
+      attr.read_format = PERF_FORMAT_GROUP;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      const int group_fd = i == 0 ? -1 : fds_[0];
+      fds_[i] = syscall(__NR_perf_event_open, &attr, 0 /* calling thread */,
+                        -1 /* any cpu */, group_fd, 0 /* flags */);
+      if (fds_[i] < 0) {
+        Close();
+        return;
+      }
+    }
+  }
+
+  ~ThreadPerfCounters() { Close(); }
+
+  bool ok() const { return fds_[0] >= 0; }
+
+  bool Read(PerfCounterValues* values) const {
+    // The group leader reads the number of counters followed by the value of
+    // each counter, in the order they were opened.
+    uint64 buffer[1 + kNumCounters];
+    if (read(fds_[0], buffer, sizeof(buffer)) != sizeof(buffer) ||
+        buffer[0] != kNumCounters) {
+      return false;
+    }
+    values->cycles = buffer[1];
+    values->instructions = buffer[2];
+    values->cache_references = buffer[3];
+    values->cache_misses = buffer[4];
+    return true;
+  }
+
+ private:
+  static constexpr int kNumCounters = 4;
+
+  void Close() {
+    for (int& fd : fds_) {
+      if (fd >= 0) close(fd);
+      fd = -1;
+    }
+  }
+
+  int fds_[kNumCounters] = {-1, -1, -1, -1};
+};
+
+}  // namespace
+#endif  // defined(__linux__) && !defined(__ANDROID__)
+
+bool PerfCountersEnabled() {
+#if defined(__linux__) && !defined(__ANDROID__)
+  static const bool enabled = ThreadPerfCounters().ok();
+  return enabled;
+#else
+  return false;
+#endif
+}
+
+bool ReadThreadPerfCounters(PerfCounterValues* values) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  if (!PerfCountersEnabled()) return false;
+  static thread_local ThreadPerfCounters counters;
+  return counters.ok() && counters.Read(values);
+#else
+  return false;
+#endif
+}
+
 void* AlignedMalloc(size_t size, int minimum_alignment) {
 #if defined(__ANDROID__)
   return memalign(minimum_alignment, size);
@@ -115,12 +340,57 @@ void* Realloc(void* ptr, size_t size) { return realloc(ptr, size); }
 void Free(void* ptr) { free(ptr); }
 
 void* NUMAMalloc(int node, size_t size, int minimum_alignment) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  if (NUMAEnabled()) {
+    // Memory is mapped directly so that a policy binding it to `node` can be
+    // set before its pages are touched. Mappings are page-aligned, which
+    // satisfies minimum_alignment.
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) return nullptr;
+    const std::vector<NUMANode>& nodes = GetNUMATopology().nodes;
+    if (node >= 0 && node < static_cast<int>(nodes.size())) {
+      const int kBitsPerWord = 8 * sizeof(unsigned long);
+      const int id = nodes[node].id;
+      std::vector<unsigned long> mask(id / kBitsPerWord + 1, 0);
+      mask[id / kBitsPerWord] |= 1UL << (id % kBitsPerWord);
+      if (syscall(SYS_mbind, ptr, size, kMpolBind, mask.data(),
+                  mask.size() * kBitsPerWord + 1, 0) != 0) {
+        VLOG(1) << "mbind to NUMA node " << node << " failed: "
+                << strerror(errno);
+      }
+    }
+    return ptr;
+  }
+#endif
   return AlignedMalloc(size, minimum_alignment);
 }
 
-void NUMAFree(void* ptr, size_t size) { Free(ptr); }
+void NUMAFree(void* ptr, size_t size) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  if (NUMAEnabled()) {
+    munmap(ptr, size);
+    return;
+  }
+#endif
+  Free(ptr);
+}
 
-int NUMAGetMemAffinity(const void* addr) { return kNUMANoAffinity; }
+int NUMAGetMemAffinity(const void* addr) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  if (NUMAEnabled()) {
+    int id = -1;
+    if (syscall(SYS_get_mempolicy, &id, nullptr, 0, addr,
+                kMpolFNode | kMpolFAddr) == 0) {
+      const std::vector<NUMANode>& nodes = GetNUMATopology().nodes;
+      for (int node = 0; node < static_cast<int>(nodes.size()); ++node) {
+        if (nodes[node].id == id) return node;
+      }
+    }
+  }
+#endif
+  return kNUMANoAffinity;
+}
 
 void MallocExtension_ReleaseToSystem(std::size_t num_bytes) {
   // No-op.
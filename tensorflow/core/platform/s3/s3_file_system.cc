@@ -14,8 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/platform/s3/s3_file_system.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/file_system_helper.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/s3/aws_crypto.h"
 #include "tensorflow/core/platform/s3/aws_logging.h"
@@ -28,15 +30,23 @@ limitations under the License.
 #include <aws/core/utils/logging/LogSystemInterface.h>
 #include <aws/s3/S3Client.h>
 #include <aws/s3/S3Errors.h>
+#include <aws/s3/model/AbortMultipartUploadRequest.h>
+#include <aws/s3/model/CompleteMultipartUploadRequest.h>
+#include <aws/s3/model/CompletedMultipartUpload.h>
+#include <aws/s3/model/CompletedPart.h>
 #include <aws/s3/model/CopyObjectRequest.h>
+#include <aws/s3/model/CreateMultipartUploadRequest.h>
 #include <aws/s3/model/DeleteObjectRequest.h>
 #include <aws/s3/model/GetObjectRequest.h>
 #include <aws/s3/model/HeadBucketRequest.h>
 #include <aws/s3/model/HeadObjectRequest.h>
 #include <aws/s3/model/ListObjectsRequest.h>
 #include <aws/s3/model/PutObjectRequest.h>
+#include <aws/s3/model/UploadPartRequest.h>
 
+#include <algorithm>
 #include <cstdlib>
+#include <deque>
 
 namespace tensorflow {
 
@@ -44,6 +54,21 @@ namespace {
 static const char* kS3FileSystemAllocationTag = "S3FileSystemAllocation";
 static const size_t kS3ReadAppendableFileBufferSize = 1024 * 1024;
 static const int kS3GetChildrenMaxKeys = 100;
+// S3 rejects multipart uploads with parts (other than the last) below 5MB.
+static const int64 kS3MinMultipartUploadPartSizeMB = 5;
+static const int64 kS3DefaultMultipartUploadPartSizeMB = 16;
+static const int64 kS3DefaultMultipartUploadMaxParallelParts = 4;
+
+// Returns the value of the environment variable `name` as an integer, or
+// `default_value` if it is not set or not a valid integer.
+int64 GetEnvInt64(const char* name, int64 default_value) {
+  const char* value = getenv(name);
+  int64 result;
+  if (value && strings::safe_strto64(value, &result)) {
+    return result;
+  }
+  return default_value;
+}
 
 Aws::Client::ClientConfiguration& GetDefaultClientConfig() {
   static mutex cfg_lock(LINKER_INITIALIZED);
@@ -198,6 +223,17 @@ class S3RandomAccessFile : public RandomAccessFile {
   std::shared_ptr<Aws::S3::S3Client> s3_client_;
 };
 
+// Writes an S3 object.
+//
+// Files are spooled into a local temporary file. Once it holds `part_size`
+// bytes, the file is uploaded as a multipart upload: the temporary file is
+// sent in the background as the next part while the following data is spooled
+// into a new one, with at most `max_parallel_parts` parts in flight. Close()
+// then only has to upload the last part. Smaller files are uploaded from the
+// temporary file with a single PutObject on every Sync() and on Close().
+//
+// Once the multipart upload has started, the object only becomes visible on
+// Close(), and Sync() just waits for the parts in flight.
 class S3WritableFile : public WritableFile {
  public:
   S3WritableFile(const string& bucket, const string& object,
@@ -206,39 +242,76 @@ class S3WritableFile : public WritableFile {
         object_(object),
         s3_client_(s3_client),
         sync_needed_(true),
-        outfile_(Aws::MakeShared<Aws::Utils::TempFile>(
-            kS3FileSystemAllocationTag, "/tmp/s3_filesystem_XXXXXX",
-            std::ios_base::binary | std::ios_base::trunc | std::ios_base::in |
-                std::ios_base::out)) {}
+        closed_(false),
+        outfile_(NewTempFile()),
+        next_part_number_(1) {
+    const int64 part_size_mb =
+        GetEnvInt64("S3_MULTIPART_UPLOAD_PART_SIZE_MB",
+                    kS3DefaultMultipartUploadPartSizeMB);
+    // A part size of 0 disables multipart uploads.
+    part_size_ = part_size_mb <= 0
+                     ? 0
+                     : std::max(part_size_mb, kS3MinMultipartUploadPartSizeMB) *
+                           1024 * 1024;
+    max_parallel_parts_ = std::max<int64>(
+        1, GetEnvInt64("S3_MULTIPART_UPLOAD_MAX_PARALLEL_PARTS",
+                       kS3DefaultMultipartUploadMaxParallelParts));
+  }
 
-  Status Append(StringPiece data) override {
-    if (!outfile_) {
-      return errors::FailedPrecondition(
-          "The internal temporary file is not writable.");
+  ~S3WritableFile() override {
+    if (!upload_id_.empty()) {
+      // The file was not closed, so do not leave the parts uploaded so far
+      // behind in the bucket.
+      WaitForParts(0).IgnoreError();
+      AbortMultipartUpload();
     }
+  }
+
+  Status Append(StringPiece data) override {
+    TF_RETURN_IF_ERROR(CheckWritable());
     sync_needed_ = true;
-    outfile_->write(data.data(), data.size());
-    if (!outfile_->good()) {
-      return errors::Internal(
-          "Could not append to the internal temporary file.");
+    while (!data.empty()) {
+      size_t n = data.size();
+      if (part_size_ > 0) {
+        n = std::min(n, part_size_ - SpooledSize());
+      }
+      outfile_->write(data.data(), n);
+      if (!outfile_->good()) {
+        return errors::Internal(
+            "Could not append to the internal temporary file.");
+      }
+      data.remove_prefix(n);
+      if (part_size_ > 0 && SpooledSize() >= part_size_) {
+        TF_RETURN_IF_ERROR(UploadPart());
+      }
     }
     return Status::OK();
   }
 
   Status Close() override {
-    if (outfile_) {
-      TF_RETURN_IF_ERROR(Sync());
-      outfile_.reset();
+    if (closed_) {
+      return upload_status_;
     }
+    Status status;
+    if (upload_id_.empty()) {
+      status = Sync();
+    } else {
+      status = CompleteMultipartUpload();
+    }
+    if (!status.ok()) {
+      return status;
+    }
+    closed_ = true;
+    outfile_.reset();
     return Status::OK();
   }
 
   Status Flush() override { return Sync(); }
 
   Status Sync() override {
-    if (!outfile_) {
-      return errors::FailedPrecondition(
-          "The internal temporary file is not writable.");
+    TF_RETURN_IF_ERROR(CheckWritable());
+    if (!upload_id_.empty()) {
+      return WaitForParts(0);
     }
     if (!sync_needed_) {
       return Status::OK();
@@ -256,15 +329,155 @@ class S3WritableFile : public WritableFile {
       return errors::Unknown(putObjectOutcome.GetError().GetExceptionName(),
                              ": ", putObjectOutcome.GetError().GetMessage());
     }
+    sync_needed_ = false;
     return Status::OK();
   }
 
  private:
+  Status CheckWritable() const {
+    if (closed_) {
+      return errors::FailedPrecondition("The file ", object_,
+                                        " is already closed.");
+    }
+    if (!outfile_) {
+      return errors::FailedPrecondition(
+          "The internal temporary file is not writable.");
+    }
+    return Status::OK();
+  }
+
+  // Returns the number of bytes in the temporary file.
+  size_t SpooledSize() const {
+    return static_cast<size_t>(static_cast<long>(outfile_->tellp()));
+  }
+
+  // Returns a new temporary file, which is deleted when the last reference to
+  // it is dropped.
+  static std::shared_ptr<Aws::Utils::TempFile> NewTempFile() {
+    return Aws::MakeShared<Aws::Utils::TempFile>(
+        kS3FileSystemAllocationTag, "/tmp/s3_filesystem_XXXXXX",
+        std::ios_base::binary | std::ios_base::trunc | std::ios_base::in |
+            std::ios_base::out);
+  }
+
+  // Starts uploading the temporary file as the next part of the multipart
+  // upload, which is created first if needed, and spools the following data
+  // into a new temporary file.
+  Status UploadPart() {
+    if (upload_id_.empty()) {
+      Aws::S3::Model::CreateMultipartUploadRequest request;
+      request.WithBucket(bucket_.c_str()).WithKey(object_.c_str());
+      auto outcome = this->s3_client_->CreateMultipartUpload(request);
+      if (!outcome.IsSuccess()) {
+        return errors::Unknown(outcome.GetError().GetExceptionName(), ": ",
+                               outcome.GetError().GetMessage());
+      }
+      upload_id_ = outcome.GetResult().GetUploadId();
+    }
+    // Bounds the local disk used by the parts in flight.
+    TF_RETURN_IF_ERROR(WaitForParts(max_parallel_parts_ - 1));
+    Aws::S3::Model::UploadPartRequest request;
+    request.WithBucket(bucket_.c_str())
+        .WithKey(object_.c_str())
+        .WithUploadId(upload_id_)
+        .WithPartNumber(next_part_number_++);
+    const long size = outfile_->tellp();
+    outfile_->seekg(0);
+    request.SetBody(outfile_);
+    request.SetContentLength(size);
+    // The request, and thus the temporary file, is kept alive by the callable
+    // until the part has been sent.
+    pending_parts_.emplace_back(request.GetPartNumber(),
+                                this->s3_client_->UploadPartCallable(request));
+    outfile_ = NewTempFile();
+    return Status::OK();
+  }
+
+  // Waits until at most `max_pending` parts are in flight, and returns the
+  // first error of any finished part.
+  Status WaitForParts(size_t max_pending) {
+    while (pending_parts_.size() > max_pending) {
+      const int part_number = pending_parts_.front().first;
+      auto outcome = pending_parts_.front().second.get();
+      pending_parts_.pop_front();
+      if (!outcome.IsSuccess()) {
+        upload_status_.Update(errors::Unknown(
+            outcome.GetError().GetExceptionName(), ": ",
+            outcome.GetError().GetMessage(), " when uploading part ",
+            part_number, " of ", object_));
+        continue;
+      }
+      completed_parts_.push_back(Aws::S3::Model::CompletedPart()
+                                     .WithPartNumber(part_number)
+                                     .WithETag(outcome.GetResult().GetETag()));
+    }
+    return upload_status_;
+  }
+
+  // Uploads the remaining data as the last part and makes the object visible.
+  Status CompleteMultipartUpload() {
+    Status status;
+    if (SpooledSize() > 0) {
+      status = UploadPart();
+    }
+    status.Update(WaitForParts(0));
+    if (status.ok()) {
+      Aws::S3::Model::CompleteMultipartUploadRequest request;
+      request.WithBucket(bucket_.c_str())
+          .WithKey(object_.c_str())
+          .WithUploadId(upload_id_)
+          .WithMultipartUpload(
+              Aws::S3::Model::CompletedMultipartUpload().WithParts(
+                  completed_parts_));
+      auto outcome = this->s3_client_->CompleteMultipartUpload(request);
+      if (outcome.IsSuccess()) {
+        upload_id_.clear();
+        return Status::OK();
+      }
+      status = errors::Unknown(outcome.GetError().GetExceptionName(), ": ",
+                               outcome.GetError().GetMessage());
+    }
+    // Parts cannot be re-sent once their data is dropped, so the upload is
+    // abandoned; callers have to write the file again.
+    AbortMultipartUpload();
+    upload_status_.Update(status);
+    closed_ = true;
+    return status;
+  }
+
+  void AbortMultipartUpload() {
+    Aws::S3::Model::AbortMultipartUploadRequest request;
+    request.WithBucket(bucket_.c_str())
+        .WithKey(object_.c_str())
+        .WithUploadId(upload_id_);
+    auto outcome = this->s3_client_->AbortMultipartUpload(request);
+    if (!outcome.IsSuccess()) {
+      LOG(WARNING) << "Failed to abort the multipart upload of " << object_
+                   << ": " << outcome.GetError().GetExceptionName() << ": "
+                   << outcome.GetError().GetMessage();
+    }
+    upload_id_.clear();
+  }
+
   string bucket_;
   string object_;
   std::shared_ptr<Aws::S3::S3Client> s3_client_;
   bool sync_needed_;
+  bool closed_;
+  // Spools the data not yet handed to an upload.
   std::shared_ptr<Aws::Utils::TempFile> outfile_;
+
+  // The size of the parts of multipart uploads, or 0 if they are disabled.
+  size_t part_size_;
+  size_t max_parallel_parts_;
+  // The id of the multipart upload in progress, if any.
+  Aws::String upload_id_;
+  int next_part_number_;
+  std::deque<std::pair<int, Aws::S3::Model::UploadPartOutcomeCallable>>
+      pending_parts_;
+  Aws::Vector<Aws::S3::Model::CompletedPart> completed_parts_;
+  // The first error of the multipart upload.
+  Status upload_status_;
 };
 
 class S3ReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
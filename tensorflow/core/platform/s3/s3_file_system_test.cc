@@ -106,6 +106,29 @@ TEST_F(S3FileSystemTest, NewWritableFile) {
   EXPECT_EQ("content1,content2", content);
 }
 
+TEST_F(S3FileSystemTest, NewWritableFile_MultipartUpload) {
+  // Uploads the file as two full 5MB parts and a partial one.
+  setenv("S3_MULTIPART_UPLOAD_PART_SIZE_MB", "5", 1);
+  std::unique_ptr<WritableFile> writer;
+  const string fname = TmpDir("MultipartWritableFile");
+  TF_EXPECT_OK(s3fs.NewWritableFile(fname, &writer));
+  unsetenv("S3_MULTIPART_UPLOAD_PART_SIZE_MB");
+  string expected;
+  for (int i = 0; i < 11; ++i) {
+    const string chunk(1024 * 1024, 'a' + i);
+    TF_EXPECT_OK(writer->Append(chunk));
+    expected += chunk;
+  }
+  TF_EXPECT_OK(writer->Sync());
+  TF_EXPECT_OK(writer->Append("tail"));
+  expected += "tail";
+  TF_EXPECT_OK(writer->Close());
+
+  string content;
+  TF_EXPECT_OK(ReadAll(fname, &content));
+  EXPECT_EQ(expected, content);
+}
+
 TEST_F(S3FileSystemTest, NewAppendableFile) {
   std::unique_ptr<WritableFile> writer;
 
@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/perf_counters.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -63,6 +64,11 @@ int NUMANumNodes() { return 1; }
 
 void NUMASetThreadNodeAffinity(int node) {}
 
+bool SetCurrentThreadCpuAffinity(const std::vector<int>& cpus) {
+  // Not yet implemented.
+  return false;
+}
+
 int NUMAGetThreadNodeAffinity() { return kNUMANoAffinity; }
 
 void* AlignedMalloc(size_t size, int minimum_alignment) {
@@ -153,5 +159,9 @@ int NumHyperthreadsPerCore() {
   return (ht_per_core > 0) ? ht_per_core : 1;
 }
 
+bool PerfCountersEnabled() { return false; }
+
+bool ReadThreadPerfCounters(PerfCounterValues* values) { return false; }
+
 }  // namespace port
 }  // namespace tensorflow
@@ -685,6 +685,9 @@ string TFCode::FormatNode(CodeNode* node, const Options& opts,
   if (opts.select.find(kShown[8]) != opts.select.end()) {
     attrs.push_back(strings::Printf("%s N/A in code view", kShown[8]));
   }
+  if (opts.select.find(kShown[14]) != opts.select.end()) {
+    attrs.push_back(strings::Printf("%s N/A in code view", kShown[14]));
+  }
 
   return strings::Printf("%s%s (%s)\n", string(indent, ' ').c_str(),
                          node->name().c_str(),
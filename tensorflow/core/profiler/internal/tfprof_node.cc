@@ -76,6 +76,10 @@ void ExecStep::AddTimeStats(const string& dev, const NodeExecStats& step_stat) {
       exec_.set_run_count(exec_.run_count() + 1);
     }
   }
+  if (step_stat.has_hardware_counters()) {
+    AddHardwareCounters(step_stat.hardware_counters(),
+                        exec_.mutable_hardware_counters());
+  }
 }
 
 void ExecStep::AddMemoryStats(const string& dev,
@@ -101,6 +105,9 @@ void ExecStep::AddMemoryStats(const string& dev,
     exec_mem.set_allocator_bytes_in_use(
         std::max(static_cast<int64>(exec_mem.allocator_bytes_in_use()),
                  static_cast<int64>(mem.allocator_bytes_in_use())));
+    exec_mem.set_allocator_largest_free_block_bytes(std::max(
+        static_cast<int64>(exec_mem.allocator_largest_free_block_bytes()),
+        static_cast<int64>(mem.allocator_largest_free_block_bytes())));
     for (const auto& alloc : mem.allocation_records()) {
       allocations_.push_back(alloc);
     }
@@ -287,6 +294,15 @@ TensorShapeProto VecToShapeProto(const std::vector<int64>& shape_vec) {
   return shape_pb;
 }
 
+void AddHardwareCounters(const HardwareCounters& counters,
+                         HardwareCounters* total) {
+  total->set_cycles(total->cycles() + counters.cycles());
+  total->set_instructions(total->instructions() + counters.instructions());
+  total->set_cache_references(total->cache_references() +
+                              counters.cache_references());
+  total->set_cache_misses(total->cache_misses() + counters.cache_misses());
+}
+
 bool IsPlacedOnAccelerator(const string& device) {
   return device.find("gpu") != device.npos ||
          device.find("sycl") != device.npos;
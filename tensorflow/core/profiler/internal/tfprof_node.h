@@ -40,6 +40,10 @@ std::vector<int64> ShapeProtoToVec(const TensorShapeProto& shape_pb);
 
 TensorShapeProto VecToShapeProto(const std::vector<int64>& shape_vec);
 
+// Adds each of the hardware performance `counters` to the one in `total`.
+void AddHardwareCounters(const HardwareCounters& counters,
+                         HardwareCounters* total);
+
 class TFGraphNode;
 
 class CallStack {
@@ -100,6 +104,11 @@ class ExecStep {
   int64 accelerator_exec_micros() const;
   // The cpu execution time of an op.
   int64 cpu_exec_micros() const;
+  // The hardware performance counters of the cpu executions of an op. Empty
+  // unless they were recorded with TF_PROFILE_HARDWARE_COUNTERS.
+  const HardwareCounters& hardware_counters() const {
+    return exec_.hardware_counters();
+  }
 
   const std::map<string, std::vector<std::pair<int64, int64>>>& op_execs()
       const {
@@ -183,6 +192,14 @@ class ExecStep {
     }
     return bytes_in_use;
   }
+  std::map<int64, int64> allocator_largest_free_block_bytes() const {
+    std::map<int64, int64> largest_free_block_bytes;
+    for (const ExecMemory& exec : memory_execs_) {
+      largest_free_block_bytes[exec.memory_micros()] =
+          exec.allocator_largest_free_block_bytes();
+    }
+    return largest_free_block_bytes;
+  }
 
   const std::vector<AllocationRecord>& allocations() const {
     return allocations_;
@@ -568,6 +585,31 @@ class TFGraphNode {
     return total_micros / execs_.size();
   }
 
+  // The hardware performance counters of the cpu execution of a step, or
+  // average of multiple step, when step < 0.
+  HardwareCounters hardware_counters(int64 step) const {
+    HardwareCounters counters;
+    if (step >= 0) {
+      auto exec = execs_.find(step);
+      if (exec != execs_.end()) {
+        counters = exec->second.hardware_counters();
+      }
+      return counters;
+    }
+    if (execs_.empty()) {
+      return counters;
+    }
+    for (const auto& exec : execs_) {
+      AddHardwareCounters(exec.second.hardware_counters(), &counters);
+    }
+    const int64 num_steps = execs_.size();
+    counters.set_cycles(counters.cycles() / num_steps);
+    counters.set_instructions(counters.instructions() / num_steps);
+    counters.set_cache_references(counters.cache_references() / num_steps);
+    counters.set_cache_misses(counters.cache_misses() / num_steps);
+    return counters;
+  }
+
   int64 requested_bytes(int64 step) const { GRAPH_NODE_BYTES(requested); }
   int64 peak_bytes(int64 step) const { GRAPH_NODE_BYTES(peak); }
   int64 residual_bytes(int64 step) const { GRAPH_NODE_BYTES(residual); }
@@ -645,6 +687,14 @@ class TFGraphNode {
     }
     return exec->second.allocator_bytes_in_use();
   }
+  const std::map<int64, int64> allocator_largest_free_block_bytes(
+      int64 step) const {
+    auto exec = execs_.find(step);
+    if (exec == execs_.end()) {
+      return empty_bytes_in_use_;
+    }
+    return exec->second.allocator_largest_free_block_bytes();
+  }
 
   const std::vector<AllocationRecord>& allocations(int64 step) const {
     auto exec = execs_.find(step);
@@ -777,6 +827,7 @@ class TFMultiGraphNode {
     exec_micros_ = 0;
     accelerator_exec_micros_ = 0;
     cpu_exec_micros_ = 0;
+    hardware_counters_.Clear();
 
     requested_bytes_ = 0;
     peak_bytes_ = 0;
@@ -804,6 +855,7 @@ class TFMultiGraphNode {
       exec_micros_ += node->exec_micros(step);
       accelerator_exec_micros_ += node->accelerator_exec_micros(step);
       cpu_exec_micros_ += node->cpu_exec_micros(step);
+      AddHardwareCounters(node->hardware_counters(step), &hardware_counters_);
 
       requested_bytes_ += node->requested_bytes(step);
       peak_bytes_ += node->peak_bytes(step);
@@ -840,6 +892,9 @@ class TFMultiGraphNode {
   int64 exec_micros() const { return exec_micros_; }
   int64 accelerator_exec_micros() const { return accelerator_exec_micros_; }
   int64 cpu_exec_micros() const { return cpu_exec_micros_; }
+  const HardwareCounters& hardware_counters() const {
+    return hardware_counters_;
+  }
 
   int64 requested_bytes() const { return requested_bytes_; }
   int64 peak_bytes() const { return peak_bytes_; }
@@ -891,6 +946,7 @@ class TFMultiGraphNode {
   int64 exec_micros_;
   int64 accelerator_exec_micros_;
   int64 cpu_exec_micros_;
+  HardwareCounters hardware_counters_;
 
   int64 requested_bytes_;
   int64 peak_bytes_;
@@ -79,6 +79,33 @@ string FormatAcceleratorExecTime(const ShowMultiNode* node,
                   accu_pct, pct)
                   .c_str());
 }
+// Formats the hardware performance counters of the op with the rates derived
+// from them, which tell compute bound ops from memory bound ones.
+string FormatHardwareCounters(const ShowMultiNode* node) {
+  // The bytes transferred from memory by a last level cache miss.
+  const int64 kCacheLineBytes = 64;
+  const HardwareCounters& counters = node->node->hardware_counters();
+  if (counters.cycles() <= 0) {
+    return strings::Printf("%30s", "-- hardware counters");
+  }
+  double miss_pct = 0.0;
+  if (counters.cache_references() > 0) {
+    miss_pct = 100.0 * counters.cache_misses() / counters.cache_references();
+  }
+  string bandwidth = "--";
+  if (node->node->cpu_exec_micros() > 0) {
+    bandwidth = strings::StrCat(
+        FormatMemory(counters.cache_misses() * kCacheLineBytes * 1000000 /
+                     node->node->cpu_exec_micros()),
+        "/sec");
+  }
+  return strings::Printf(
+      "%s cycles (%.2f IPC, %.2f flops/cycle, %.2f%% cache misses, %s)",
+      FormatNumber(counters.cycles()).c_str(),
+      1.0 * counters.instructions() / counters.cycles(),
+      1.0 * node->node->float_ops() / counters.cycles(), miss_pct,
+      bandwidth.c_str());
+}
 }  // namespace
 
 void TFOp::AddNode(TFGraphNode* node) {
@@ -317,6 +344,10 @@ string TFOp::FormatNode(OpNode* node, OpNode* root, const Options& opts) const {
   string node_str = strings::Printf("%-25s%s\n", node->name().c_str(),
                                     str_util::Join(attrs, ", ").c_str());
 
+  if (opts.select.find(kShown[14]) != opts.select.end()) {
+    attrs.push_back(FormatHardwareCounters(node));
+  }
+
   if (opts.select.find(kShown[8]) != opts.select.end()) {
     string input_shape_str = FormatInputShapes(node->proto());
     if (!input_shape_str.empty()) {
@@ -155,6 +155,10 @@ string TFMultiShow::FormatLegend(const Options& opts) const {
   if (opts.select.find(kShown[7]) != opts.select.end()) {
     legends.push_back("op occurrence (run|defined)");
   }
+  if (opts.select.find(kShown[14]) != opts.select.end()) {
+    legends.push_back(
+        "hardware counters (IPC, flops/cycle, cache misses, memory bandwidth)");
+  }
   if (opts.select.find(kShown[8]) != opts.select.end()) {
     legends.push_back("input shapes");
   }
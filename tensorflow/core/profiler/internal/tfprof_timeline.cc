@@ -89,11 +89,15 @@ void ChromeTraceFormatter::EmitFlowEnd(const string& name, int64 ts, int64 pid,
 
 void ChromeTraceFormatter::EmitCounter(
     const string& category, const string& name, int64 pid, int64 ts,
-    const string& device, int64 bytes,
+    const string& device, int64 bytes, int64 largest_free_block_bytes,
     const std::map<int64, std::vector<string>>& tensor_mem) {
   Json::Value event = CreateEvent("C", category, "Allocated Bytes", pid, 0, ts);
   Json::Value args(Json::objectValue);
   args["Allocator Bytes in Use"] = Json::Int64(bytes);
+  // Negative if the allocator does not track its largest free block.
+  if (largest_free_block_bytes >= 0) {
+    args["Largest Free Block"] = Json::Int64(largest_free_block_bytes);
+  }
   event["args"] = args;
   events_.push_back(event);
 
@@ -169,6 +173,11 @@ void MemoryTracker::TrackNode(int64 step, const GraphNode* node) {
     if (bytes_in_use.first <= 0) continue;
     dev.allocations[bytes_in_use.first] = bytes_in_use.second;
   }
+  for (const auto& free_block :
+       node->node->allocator_largest_free_block_bytes(step)) {
+    if (free_block.first <= 0 || free_block.second <= 0) continue;
+    dev.largest_free_blocks[free_block.first] = free_block.second;
+  }
 }
 
 void Timeline::AllocateTimeNodes(GraphNode* gnode) {
@@ -297,8 +306,14 @@ void Timeline::GenerateGraphTimeline(const std::vector<GraphNode*>& gnodes) {
           tensor_mem[it->second].push_back(tensor_alloc_it.first);
         }
       }
+      int64 largest_free_block_bytes = -1;
+      auto free_block = device.largest_free_blocks.upper_bound(ts);
+      if (free_block != device.largest_free_blocks.begin()) {
+        largest_free_block_bytes = (--free_block)->second;
+      }
       chrome_formatter_.EmitCounter("Memory", "Memory Series", pid, ts,
-                                    dev.first, cur_bytes_in_use, tensor_mem);
+                                    dev.first, cur_bytes_in_use,
+                                    largest_free_block_bytes, tensor_mem);
     }
     if (IsPlacedOnAccelerator(dev.first)) {
       fprintf(stdout, "%s peak memory: %.2f MB\n", dev.first.c_str(),
@@ -50,6 +50,7 @@ class ChromeTraceFormatter {
 
   void EmitCounter(const string& category, const string& name, int64 pid,
                    int64 ts, const string& device, int64 bytes,
+                   int64 largest_free_block_bytes,
                    const std::map<int64, std::vector<string>>& tensor_mem);
 
   string Format();
@@ -107,6 +108,8 @@ class MemoryTracker {
     std::map<string, std::map<int64, int64>> tensor_allocs;
     // ground truth memory stats. time->bytes.
     std::map<int64, int64> allocations;
+    // the largest free block of the allocator, if known. time->bytes.
+    std::map<int64, int64> largest_free_blocks;
     // tracked allocations, might miss some bytes.
     std::map<int64, int64> tracked_allocations;
   };
@@ -341,6 +341,11 @@ static const char* const kOccurrence =
     "occurrence: The number of times it occurs";
 static const char* const kInputShapes =
     "input shape: The shape of input tensors";
+static const char* const kHardwareCounters =
+    "hardware_counters: The cpu cycles of the operation, with the instructions "
+    "and float operations per cycle, the last level cache miss rate and the "
+    "memory bandwidth implied by the misses. Only in op view, and only "
+    "recorded if TF_PROFILE_HARDWARE_COUNTERS is set.";
 static const char* const kDevice = "device: which device is placed on.";
 static const char* const kFloatOps =
     "flops: Number of float operations. Note: Please read the implementation "
@@ -418,6 +423,8 @@ string QueryDoc(const string& cmd, const Options& opts) {
       helps.push_back(kResidualBytes);
     } else if (s == kShown[13]) {
       helps.push_back(kOutputBytes);
+    } else if (s == kShown[14]) {
+      helps.push_back(kHardwareCounters);
     } else {
       helps.push_back("Unknown select: " + s);
     }
@@ -65,7 +65,8 @@ static const char* const kShown[] = {"bytes",          "micros",
                                      "op_types",       "occurrence",
                                      "input_shapes",   "accelerator_micros",
                                      "cpu_micros",     "peak_bytes",
-                                     "residual_bytes", "output_bytes"};
+                                     "residual_bytes", "output_bytes",
+                                     "hardware_counters"};
 
 static const char* const kCmds[] = {
     "scope", "graph", "code", "op", "advise", "set", "help",
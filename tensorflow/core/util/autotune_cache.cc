@@ -0,0 +1,151 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/autotune_cache.h"
+
+#include <map>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+constexpr int AutotuneCache::kVersion;
+
+AutotuneCache::AutotuneCache(const string& path) : path_(path) {
+  mutex_lock l(mu_);
+  if (!Env::Default()->FileExists(path_).ok()) {
+    return;
+  }
+  Status s = LoadLocked(path_);
+  if (s.ok()) {
+    VLOG(1) << "Loaded " << entries_.size() << " autotune results from "
+            << path_;
+  } else {
+    LOG(WARNING) << "Failed to load the autotune cache: " << s;
+  }
+}
+
+AutotuneCache* AutotuneCache::Global() {
+  static AutotuneCache* cache = [] {
+    string path;
+    Status s = ReadStringFromEnvVar("TF_AUTOTUNE_CACHE_FILE", "", &path);
+    if (!s.ok()) {
+      LOG(WARNING) << s;
+    }
+    return path.empty() ? new AutotuneCache() : new AutotuneCache(path);
+  }();
+  return cache;
+}
+
+string AutotuneCache::MapKey(StringPiece device, StringPiece key) {
+  return strings::StrCat(device, "\n", key);
+}
+
+bool AutotuneCache::Find(StringPiece device, StringPiece key,
+                         AutotuneCacheEntry* entry) const {
+  mutex_lock l(mu_);
+  auto it = entries_.find(MapKey(device, key));
+  if (it == entries_.end()) {
+    return false;
+  }
+  *entry = it->second;
+  return true;
+}
+
+void AutotuneCache::Insert(const AutotuneCacheEntry& entry) {
+  mutex_lock l(mu_);
+  entries_[MapKey(entry.device(), entry.key())] = entry;
+  if (persistent()) {
+    Status s = SaveLocked(path_);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to save the autotune cache: " << s;
+    }
+  }
+}
+
+int64 AutotuneCache::size() const {
+  mutex_lock l(mu_);
+  return entries_.size();
+}
+
+Status AutotuneCache::Load(const string& path) {
+  mutex_lock l(mu_);
+  return LoadLocked(path);
+}
+
+Status AutotuneCache::Save(const string& path) {
+  mutex_lock l(mu_);
+  return SaveLocked(path);
+}
+
+Status AutotuneCache::LoadLocked(const string& path) {
+  AutotuneCacheFile file;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(Env::Default(), path, &file));
+  if (file.version() != kVersion) {
+    return errors::FailedPrecondition("The autotune cache ", path,
+                                      " has version ", file.version(),
+                                      ", expected ", kVersion);
+  }
+  for (const AutotuneCacheEntry& entry : file.entries()) {
+    entries_.emplace(MapKey(entry.device(), entry.key()), entry);
+  }
+  return Status::OK();
+}
+
+Status AutotuneCache::SaveLocked(const string& path) {
+  Env* env = Env::Default();
+  // Pick up what other processes have saved since we last loaded the file.
+  // If the file has another version, it's overwritten.
+  if (env->FileExists(path).ok()) {
+    Status s = LoadLocked(path);
+    if (!s.ok()) {
+      LOG(WARNING) << "Overwriting the autotune cache: " << s;
+    }
+  }
+  // Sort the entries so that saving the same results twice gives the same
+  // file.
+  std::map<string, const AutotuneCacheEntry*> sorted_entries;
+  for (const auto& entry : entries_) {
+    sorted_entries[entry.first] = &entry.second;
+  }
+  AutotuneCacheFile file;
+  file.set_version(kVersion);
+  for (const auto& entry : sorted_entries) {
+    *file.add_entries() = *entry.second;
+  }
+  // Write to a temporary file first, so that concurrent readers never see a
+  // partially written cache.
+  const string tmp_path =
+      strings::StrCat(path, ".tmp", strings::Hex(random::New64()));
+  TF_RETURN_IF_ERROR(WriteBinaryProto(env, tmp_path, file));
+  Status s = env->RenameFile(tmp_path, path);
+  if (!s.ok()) {
+    env->DeleteFile(tmp_path).IgnoreError();
+  }
+  return s;
+}
+
+string AutotuneDeviceKey(StringPiece model, int cc_major, int cc_minor,
+                         StringPiece dnn_version) {
+  return strings::StrCat(model, ";sm_", cc_major, ".", cc_minor, ";cudnn_",
+                         dnn_version);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,98 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_UTIL_AUTOTUNE_CACHE_H_
+#define TENSORFLOW_CORE_UTIL_AUTOTUNE_CACHE_H_
+
+#include <unordered_map>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/autotune_cache.pb.h"
+
+namespace tensorflow {
+
+// A store of autotuning results, e.g. the fastest cuDNN algorithm of each
+// convolution, keyed by the kind of device and by an autotuner-defined key
+// describing the operation.
+//
+// The global store is backed by the file named by the TF_AUTOTUNE_CACHE_FILE
+// environment variable, if set: the file is loaded on first use, and every new
+// result is merged into it. Processes that share the file, e.g. on a network
+// file system, then don't autotune the same operations again. Files written
+// with another version of the keys are ignored.
+//
+// This class is thread-safe.
+class AutotuneCache {
+ public:
+  // Version of the file format and of the keys the autotuners use. Bump it
+  // when a key stops identifying the same operation.
+  static constexpr int kVersion = 1;
+
+  // Creates an empty store that isn't backed by a file.
+  AutotuneCache() {}
+
+  // Creates a store backed by the file at `path`, and loads it if it exists.
+  explicit AutotuneCache(const string& path);
+
+  // Returns the process-wide store.
+  static AutotuneCache* Global();
+
+  // Whether new results are written to a file.
+  bool persistent() const { return !path_.empty(); }
+
+  // Looks up the result for `key` on `device`. Returns false if there is none.
+  bool Find(StringPiece device, StringPiece key,
+            AutotuneCacheEntry* entry) const;
+
+  // Adds or replaces a result, and saves the store if it's persistent. Errors
+  // saving the store are logged: they only cost autotuning again later.
+  void Insert(const AutotuneCacheEntry& entry);
+
+  // Adds the results stored in `path` that aren't in the store yet.
+  Status Load(const string& path);
+
+  // Writes all results to `path`, after loading the ones other processes
+  // have written to it since. The file is replaced atomically, so readers
+  // never see a partial file.
+  Status Save(const string& path);
+
+  int64 size() const;
+
+ private:
+  static string MapKey(StringPiece device, StringPiece key);
+
+  Status LoadLocked(const string& path) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status SaveLocked(const string& path) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const string path_;
+  mutable mutex mu_;
+  std::unordered_map<string, AutotuneCacheEntry> entries_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AutotuneCache);
+};
+
+// Returns the device part of the AutotuneCache keys for a GPU, e.g.
+// "Tesla V100-SXM2-16GB;sm_7.0;cudnn_7.1.4".
+string AutotuneDeviceKey(StringPiece model, int cc_major, int cc_minor,
+                         StringPiece dnn_version);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_AUTOTUNE_CACHE_H_
@@ -0,0 +1,103 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/autotune_cache.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+AutotuneCacheEntry MakeEntry(const string& device, const string& key,
+                             int64 algorithm) {
+  AutotuneCacheEntry entry;
+  entry.set_device(device);
+  entry.set_key(key);
+  entry.set_algorithm(algorithm);
+  entry.set_tensor_ops_enabled(true);
+  entry.set_algorithm_no_scratch(-1);
+  entry.set_scratch_bytes(1024);
+  return entry;
+}
+
+TEST(AutotuneCacheTest, FindAndInsert) {
+  AutotuneCache cache;
+  EXPECT_FALSE(cache.persistent());
+  AutotuneCacheEntry entry;
+  EXPECT_FALSE(cache.Find("gpu", "conv", &entry));
+
+  cache.Insert(MakeEntry("gpu", "conv", 1));
+  ASSERT_TRUE(cache.Find("gpu", "conv", &entry));
+  EXPECT_EQ(1, entry.algorithm());
+  EXPECT_TRUE(entry.tensor_ops_enabled());
+  EXPECT_EQ(1024, entry.scratch_bytes());
+  // Results are per device.
+  EXPECT_FALSE(cache.Find("other_gpu", "conv", &entry));
+
+  cache.Insert(MakeEntry("gpu", "conv", 2));
+  ASSERT_TRUE(cache.Find("gpu", "conv", &entry));
+  EXPECT_EQ(2, entry.algorithm());
+  EXPECT_EQ(1, cache.size());
+}
+
+TEST(AutotuneCacheTest, SharesResultsThroughFile) {
+  const string path = io::JoinPath(testing::TmpDir(), "autotune_cache.pb");
+  Env::Default()->DeleteFile(path).IgnoreError();
+
+  // Two processes autotune different convolutions with the same file.
+  AutotuneCache first(path);
+  AutotuneCache second(path);
+  EXPECT_TRUE(first.persistent());
+  first.Insert(MakeEntry("gpu", "conv1", 1));
+  second.Insert(MakeEntry("gpu", "conv2", 2));
+
+  // A later process sees the results of both.
+  AutotuneCache third(path);
+  EXPECT_EQ(2, third.size());
+  AutotuneCacheEntry entry;
+  ASSERT_TRUE(third.Find("gpu", "conv1", &entry));
+  EXPECT_EQ(1, entry.algorithm());
+  ASSERT_TRUE(third.Find("gpu", "conv2", &entry));
+  EXPECT_EQ(2, entry.algorithm());
+}
+
+TEST(AutotuneCacheTest, IgnoresOtherVersions) {
+  const string path =
+      io::JoinPath(testing::TmpDir(), "autotune_cache_old.pb");
+  AutotuneCacheFile file;
+  file.set_version(AutotuneCache::kVersion - 1);
+  *file.add_entries() = MakeEntry("gpu", "conv", 1);
+  TF_ASSERT_OK(WriteBinaryProto(Env::Default(), path, file));
+
+  AutotuneCache cache;
+  EXPECT_FALSE(cache.Load(path).ok());
+  AutotuneCache persistent(path);
+  EXPECT_EQ(0, persistent.size());
+
+  // Saving replaces the old file.
+  TF_ASSERT_OK(persistent.Save(path));
+  TF_ASSERT_OK(cache.Load(path));
+}
+
+TEST(AutotuneCacheTest, DeviceKey) {
+  EXPECT_EQ("Tesla V100-SXM2-16GB;sm_7.0;cudnn_7.1.4",
+            AutotuneDeviceKey("Tesla V100-SXM2-16GB", 7, 0, "7.1.4"));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/util/batch_util.h"
 
+#include <string.h>
+
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -143,6 +145,42 @@ Status CopyElementToSlice(Tensor element, Tensor* parent, int64 index) {
   }
 }
 
+// Copies elements into consecutive slices of parent, starting with the
+// index^th slice.
+Status CopyElementsToSlices(std::vector<Tensor> elements, Tensor* parent,
+                            int64 index) {
+  if (elements.empty()) return Status::OK();
+  if (index + static_cast<int64>(elements.size()) > parent->dim_size(0)) {
+    return errors::Internal("CopyElementsToSlices Cannot copy ",
+                            elements.size(), " elements from slice ", index,
+                            " of a batch of ", parent->dim_size(0));
+  }
+  for (const Tensor& element : elements) {
+    TF_RETURN_IF_ERROR(ValidateInput(*parent, element, index));
+    if (element.dtype() != parent->dtype()) {
+      return errors::Internal("CopyElementsToSlices Cannot copy an element of ",
+                              DataTypeString(element.dtype()), " to a batch ",
+                              "of ", DataTypeString(parent->dtype()));
+    }
+  }
+  if (DataTypeCanUseMemcpy(parent->dtype())) {
+    const size_t slice_bytes = parent->NumElements() / parent->dim_size(0) *
+                               DataTypeSize(parent->dtype());
+    char* dst = const_cast<char*>(parent->tensor_data().data()) +
+                index * slice_bytes;
+    for (const Tensor& element : elements) {
+      memcpy(dst, element.tensor_data().data(), slice_bytes);
+      dst += slice_bytes;
+    }
+    return Status::OK();
+  }
+  for (size_t i = 0; i < elements.size(); ++i) {
+    TF_RETURN_IF_ERROR(
+        CopyElementToSlice(std::move(elements[i]), parent, index + i));
+  }
+  return Status::OK();
+}
+
 // Copies the index^th slice of parent (in the 0th dimension) into element.
 Status CopySliceToElement(const Tensor& parent, Tensor* element, int64 index) {
   TF_RETURN_IF_ERROR(ValidateInput(parent, *element, index));
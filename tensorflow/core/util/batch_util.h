@@ -15,6 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_UTIL_BATCH_UTIL_H_
 #define TENSORFLOW_CORE_UTIL_BATCH_UTIL_H_
 
+#include <vector>
+
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
 
@@ -29,6 +31,15 @@ namespace batch_util {
 // for DT_STRING tensors.
 Status CopyElementToSlice(Tensor element, Tensor* parent, int64 index);
 
+// Copies elements into consecutive slices of parent (in the 0th dimension),
+// starting with the index^th slice. Elements of types that can be copied
+// with memcpy are copied without dispatching on their type again.
+//
+// NOTE: As with CopyElementToSlice(), the elements may be moved from when
+// they hold the only reference to their buffers.
+Status CopyElementsToSlices(std::vector<Tensor> elements, Tensor* parent,
+                            int64 index);
+
 // Copies the index^th slice of parent (in the 0th dimension) into element.
 Status CopySliceToElement(const Tensor& parent, Tensor* element, int64 index);
 
@@ -0,0 +1,133 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/csv_fast_parsing.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace csv {
+namespace {
+
+// Parses `str` as [-]digits[.digits] into an integer mantissa and the number
+// of digits after the point. Returns false if `str` has another form, or if
+// the mantissa exceeds `max_mantissa` or the fraction `max_fraction_digits`.
+bool ParseDecimal(StringPiece str, uint64 max_mantissa,
+                  int max_fraction_digits, bool* negative, uint64* mantissa,
+                  int* fraction_digits) {
+  // The strings:: functions reject inputs this long.
+  if (str.size() >= strings::kFastToBufferSize) return false;
+  const char* p = str.data();
+  const char* const end = p + str.size();
+  *negative = p != end && *p == '-';
+  if (*negative) ++p;
+  const char* const integer_begin = p;
+  uint64 m = 0;
+  for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+    m = m * 10 + (*p - '0');
+    if (m > max_mantissa) return false;
+  }
+  if (p == integer_begin) return false;
+  *fraction_digits = 0;
+  if (p != end && *p == '.') {
+    ++p;
+    const char* const fraction_begin = p;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+      m = m * 10 + (*p - '0');
+      if (m > max_mantissa) return false;
+    }
+    *fraction_digits = p - fraction_begin;
+    if (*fraction_digits == 0 || *fraction_digits > max_fraction_digits) {
+      return false;
+    }
+  }
+  *mantissa = m;
+  return p == end;
+}
+
+}  // namespace
+
+const char* FindFieldEnd(const char* begin, const char* end, char delim,
+                         bool use_quote_delim) {
+  const char quote = use_quote_delim ? '"' : delim;
+  const char* p = begin;
+#ifdef __SSE2__
+  const __m128i delims = _mm_set1_epi8(delim);
+  const __m128i quotes = _mm_set1_epi8(quote);
+  const __m128i newlines = _mm_set1_epi8('\n');
+  const __m128i returns = _mm_set1_epi8('\r');
+  for (; end - p >= 16; p += 16) {
+    const __m128i chars =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i matches = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chars, delims),
+                     _mm_cmpeq_epi8(chars, quotes)),
+        _mm_or_si128(_mm_cmpeq_epi8(chars, newlines),
+                     _mm_cmpeq_epi8(chars, returns)));
+    const int mask = _mm_movemask_epi8(matches);
+    if (mask != 0) return p + __builtin_ctz(mask);
+  }
+#endif
+  for (; p != end; ++p) {
+    const char c = *p;
+    if (c == delim || c == quote || c == '\n' || c == '\r') return p;
+  }
+  return end;
+}
+
+bool ParseFloat(StringPiece str, float* value) {
+  // Mantissas up to 2^24 and powers of ten up to 10^10 are exact floats, so
+  // a single division rounds correctly.
+  static const float kPowersOfTen[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f,
+                                       1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+  bool negative;
+  uint64 mantissa;
+  int fraction_digits;
+  if (!ParseDecimal(str, 1 << 24, 10, &negative, &mantissa,
+                    &fraction_digits)) {
+    return strings::safe_strtof(str, value);
+  }
+  const float result =
+      static_cast<float>(mantissa) / kPowersOfTen[fraction_digits];
+  *value = negative ? -result : result;
+  return true;
+}
+
+bool ParseDouble(StringPiece str, double* value) {
+  // Mantissas up to 2^53 and powers of ten up to 10^22 are exact doubles, so
+  // a single division rounds correctly.
+  static const double kPowersOfTen[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  bool negative;
+  uint64 mantissa;
+  int fraction_digits;
+  if (!ParseDecimal(str, uint64{1} << 53, 22, &negative, &mantissa,
+                    &fraction_digits)) {
+    return strings::safe_strtod(str, value);
+  }
+  const double result =
+      static_cast<double>(mantissa) / kPowersOfTen[fraction_digits];
+  *value = negative ? -result : result;
+  return true;
+}
+
+}  // namespace csv
+}  // namespace tensorflow
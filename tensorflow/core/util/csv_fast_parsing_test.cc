@@ -0,0 +1,104 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/csv_fast_parsing.h"
+
+#include <cmath>
+
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace csv {
+namespace {
+
+// Returns the offset of FindFieldEnd() in `str`.
+size_t FieldEnd(const string& str, char delim, bool use_quote_delim) {
+  return FindFieldEnd(str.data(), str.data() + str.size(), delim,
+                      use_quote_delim) -
+         str.data();
+}
+
+TEST(CsvFastParsingTest, FindFieldEnd) {
+  EXPECT_EQ(0, FieldEnd("", ',', true));
+  EXPECT_EQ(3, FieldEnd("abc", ',', true));
+  EXPECT_EQ(3, FieldEnd("abc,def", ',', true));
+  EXPECT_EQ(3, FieldEnd("abc\ndef", ',', true));
+  EXPECT_EQ(3, FieldEnd("abc\rdef", ',', true));
+  EXPECT_EQ(3, FieldEnd("abc\"def", ',', true));
+  EXPECT_EQ(7, FieldEnd("abc\"def", ',', false));
+  EXPECT_EQ(3, FieldEnd("abc|d,f", '|', true));
+}
+
+TEST(CsvFastParsingTest, FindFieldEndInLongFields) {
+  // Covers every position of the end in and after the vectorized loop.
+  for (int length = 0; length < 70; ++length) {
+    for (char end : {',', '\n', '\r', '"'}) {
+      string str(length, 'x');
+      str += end;
+      str += "yyyyyyyyyyyyyyyyyyyyyyyy,";
+      EXPECT_EQ(length, FieldEnd(str, ',', true)) << length << " " << end;
+    }
+    EXPECT_EQ(length, FieldEnd(string(length, 'x'), ',', true));
+  }
+}
+
+TEST(CsvFastParsingTest, FindFieldEndWithHighBytes) {
+  string str = "\xe4\xbd\xa0\xe5\xa5\xbd\xe4\xb8\x96\xe7\x95\x8c\xff\x80\x01";
+  EXPECT_EQ(str.size(), FieldEnd(str, ',', true));
+  EXPECT_EQ(4, FieldEnd(str, '\xa5', true));
+}
+
+TEST(CsvFastParsingTest, ParseMatchesStrto) {
+  const char* const kInputs[] = {
+      "0",        "-0",          "1",         "-1",         "3.25",
+      "-3.25",    "0.1",         "1234.5678", "16777216",   "16777217",
+      "9007199254740993",        "0.30000000000000004",     "1.",
+      ".5",       "-.5",         "1e10",      "1.5E-3",     "+2",
+      " 3",       "3 ",          "inf",       "-Infinity",  "nan",
+      "0x1p3",    "1.2.3",       "--1",       "-",          ".",
+      "",         "abc",         "1,5",       "1e400",      "123456789012",
+      "0.000000000000000000001", "99999999999999999999999999.5"};
+  for (const char* input : kInputs) {
+    float expected_float = 0, actual_float = 0;
+    const bool float_ok = strings::safe_strtof(input, &expected_float);
+    EXPECT_EQ(float_ok, ParseFloat(input, &actual_float)) << input;
+    if (float_ok && !std::isnan(expected_float)) {
+      EXPECT_EQ(expected_float, actual_float) << input;
+    }
+
+    double expected_double = 0, actual_double = 0;
+    const bool double_ok = strings::safe_strtod(input, &expected_double);
+    EXPECT_EQ(double_ok, ParseDouble(input, &actual_double)) << input;
+    if (double_ok && !std::isnan(expected_double)) {
+      EXPECT_EQ(expected_double, actual_double) << input;
+    }
+  }
+}
+
+TEST(CsvFastParsingTest, ParseOnlyReadsTheField) {
+  // The field is not terminated by a NUL.
+  const char buffer[] = "12.5,7";
+  float float_value;
+  EXPECT_TRUE(ParseFloat(StringPiece(buffer, 4), &float_value));
+  EXPECT_EQ(12.5f, float_value);
+  double double_value;
+  EXPECT_TRUE(ParseDouble(StringPiece(buffer, 2), &double_value));
+  EXPECT_EQ(12.0, double_value);
+}
+
+}  // namespace
+}  // namespace csv
+}  // namespace tensorflow
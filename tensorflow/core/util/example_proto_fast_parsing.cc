@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include <cstring>
 #include <vector>
 
 #include "tensorflow/core/example/example.pb.h"
@@ -27,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/util/presized_cuckoo_map.h"
@@ -60,6 +62,105 @@ constexpr uint8 kVarintTag(uint32 tag) { return (tag << 3) | 0; }
 constexpr uint8 kDelimitedTag(uint32 tag) { return (tag << 3) | 2; }
 constexpr uint8 kFixed32Tag(uint32 tag) { return (tag << 3) | 5; }
 
+template <typename T>
+class LimitedArraySlice {
+ public:
+  LimitedArraySlice(T* begin, size_t num_elements)
+      : current_(begin), end_(begin + num_elements) {}
+
+  // May return negative if there were push_back calls after slice was filled.
+  int64 EndDistance() const { return end_ - current_; }
+
+  // Attempts to push value to the back of this. If the slice has
+  // already been filled, this method has no effect on the underlying data, but
+  // it changes the number returned by EndDistance into negative values.
+  void push_back(T&& value) {
+    if (EndDistance() > 0) *current_ = std::move(value);
+    ++current_;
+  }
+
+  // Returns the storage for the next `n` values, which then count as pushed
+  // back, or nullptr without changing the slice if fewer than `n` remain.
+  T* Extend(size_t n) {
+    if (EndDistance() < static_cast<int64>(n)) return nullptr;
+    T* result = current_;
+    current_ += n;
+    return result;
+  }
+
+ private:
+  T* current_;
+  T* end_;
+};
+
+// Appends `n` packed little-endian floats stored at `data` to `float_list`.
+template <typename Result>
+void AppendPackedFloats(const uint8* data, size_t n, Result* float_list) {
+  for (size_t i = 0; i < n; ++i) {
+    uint32 buffer32;
+    protobuf::io::CodedInputStream::ReadLittleEndian32FromArray(
+        data + i * sizeof(float), &buffer32);
+    float_list->push_back(bit_cast<float>(buffer32));
+  }
+}
+
+// Dense fixed-length features are copied straight into the output tensor.
+void AppendPackedFloats(const uint8* data, size_t n,
+                        LimitedArraySlice<float>* float_list) {
+  float* out = port::kLittleEndian ? float_list->Extend(n) : nullptr;
+  if (out == nullptr) {
+    AppendPackedFloats<LimitedArraySlice<float>>(data, n, float_list);
+    return;
+  }
+  std::memcpy(out, data, n * sizeof(float));
+}
+
+void AppendPackedFloats(const uint8* data, size_t n,
+                        SmallVector<float>* float_list) {
+  if (!port::kLittleEndian) {
+    AppendPackedFloats<SmallVector<float>>(data, n, float_list);
+    return;
+  }
+  size_t size = float_list->size();
+  float_list->resize(size + n);
+  std::memcpy(float_list->data() + size, data, n * sizeof(float));
+}
+
+// Decodes the packed varints in [`begin`, `end`) and appends them to
+// `int64_list`, returning false if the data is malformed.
+//
+// Int64 features frequently hold small values, so eight bytes are tested at a
+// time and decoded without branching when each of them is a single-byte
+// varint.
+template <typename Result>
+bool AppendPackedVarints(const uint8* begin, const uint8* end,
+                         Result* int64_list) {
+  const uint8* p = begin;
+  while (p < end) {
+    if (end - p >= 8) {
+      uint64 word;
+      std::memcpy(&word, p, sizeof(word));
+      if ((word & 0x8080808080808080ULL) == 0) {
+        for (int i = 0; i < 8; ++i) {
+          int64_list->push_back(static_cast<int64>(p[i]));
+        }
+        p += 8;
+        continue;
+      }
+    }
+    // Slow path for a single varint, which is at most 10 bytes long.
+    uint64 value = 0;
+    for (int shift = 0;; shift += 7) {
+      if (p == end || shift >= 70) return false;
+      uint8 byte = *p++;
+      value |= static_cast<uint64>(byte & 0x7F) << shift;
+      if (byte < 0x80) break;
+    }
+    int64_list->push_back(static_cast<int64>(value));
+  }
+  return true;
+}
+
 namespace parsed {
 
 // ParseDataType has to be called first, then appropriate ParseZzzzList.
@@ -159,15 +260,16 @@ class Feature {
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
         uint32 packed_length;
         if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
-
-        while (!stream.ExpectAtEnd()) {
-          uint32 buffer32;
-          if (!stream.ReadLittleEndian32(&buffer32)) return false;
-          float_list->push_back(bit_cast<float>(buffer32));
+        if (packed_length % sizeof(float) != 0) return false;
+        if (packed_length > 0) {
+          const void* data;
+          int size;
+          if (!stream.GetDirectBufferPointer(&data, &size)) return false;
+          if (static_cast<uint32>(size) < packed_length) return false;
+          AppendPackedFloats(static_cast<const uint8*>(data),
+                             packed_length / sizeof(float), float_list);
+          if (!stream.Skip(packed_length)) return false;
         }
-
-        stream.PopLimit(packed_limit);
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kFixed32Tag(1))) return false;
@@ -201,15 +303,17 @@ class Feature {
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
         uint32 packed_length;
         if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
-
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64>(n));
+        if (packed_length > 0) {
+          const void* data;
+          int size;
+          if (!stream.GetDirectBufferPointer(&data, &size)) return false;
+          if (static_cast<uint32>(size) < packed_length) return false;
+          const uint8* begin = static_cast<const uint8*>(data);
+          if (!AppendPackedVarints(begin, begin + packed_length, int64_list)) {
+            return false;
+          }
+          if (!stream.Skip(packed_length)) return false;
         }
-
-        stream.PopLimit(packed_limit);
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kVarintTag(1))) return false;
@@ -445,28 +549,6 @@ struct SeededHasher {
   uint64 seed{0xDECAFCAFFE};
 };
 
-template <typename T>
-class LimitedArraySlice {
- public:
-  LimitedArraySlice(T* begin, size_t num_elements)
-      : current_(begin), end_(begin + num_elements) {}
-
-  // May return negative if there were push_back calls after slice was filled.
-  int64 EndDistance() const { return end_ - current_; }
-
-  // Attempts to push value to the back of this. If the slice has
-  // already been filled, this method has no effect on the underlying data, but
-  // it changes the number returned by EndDistance into negative values.
-  void push_back(T&& value) {
-    if (EndDistance() > 0) *current_ = std::move(value);
-    ++current_;
-  }
-
- private:
-  T* current_;
-  T* end_;
-};
-
 void LogDenseFeatureDataLoss(StringPiece feature_name) {
   LOG(WARNING) << "Data loss! Feature '" << feature_name
                << "' is present in multiple concatenated "
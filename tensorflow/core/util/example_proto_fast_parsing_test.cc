@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <limits>
 #include <utility>
 
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
@@ -249,6 +250,38 @@ static string ExampleWithSomeFeatures() {
 
 TEST(FastParse, SomeFeatures) { TestCorrectness(ExampleWithSomeFeatures()); }
 
+TEST(FastParse, PackedInt64Varints) {
+  Example example;
+  Int64List* int64_list =
+      (*example.mutable_features()->mutable_feature())["int64_list"]
+          .mutable_int64_list();
+  // Runs of single-byte varints of different lengths, separated by varints of
+  // up to ten bytes.
+  const std::vector<int64> separators = {128, 300, 1LL << 35, -1,
+                                         std::numeric_limits<int64>::min()};
+  for (int64 separator : separators) {
+    for (int i = 0; i < 11; ++i) {
+      int64_list->add_value(i * 11);
+    }
+    int64_list->add_value(separator);
+  }
+  for (int i = 0; i < 5; ++i) {
+    int64_list->add_value(127 - i);
+  }
+  TestCorrectness(Serialize(example));
+}
+
+TEST(FastParse, PackedFloats) {
+  Example example;
+  FloatList* float_list =
+      (*example.mutable_features()->mutable_feature())["float_list"]
+          .mutable_float_list();
+  for (int i = 0; i < 37; ++i) {
+    float_list->add_value(i * 0.25f - 3.0f);
+  }
+  TestCorrectness(Serialize(example));
+}
+
 static void AddDenseFeature(const char* feature_name, DataType dtype,
                             PartialTensorShape shape, bool variable_length,
                             size_t elements_per_stride,
@@ -321,6 +354,43 @@ TEST(FastParse, StatsCollection) {
   }
 }
 
+TEST(FastParse, DenseFixedLengthNumeric) {
+  const int kNumValues = 19;
+  Example example;
+  auto* features = example.mutable_features()->mutable_feature();
+  for (int i = 0; i < kNumValues; ++i) {
+    (*features)["float_list"].mutable_float_list()->add_value(i * 0.5f);
+    (*features)["int64_list"].mutable_int64_list()->add_value(i * 1000);
+  }
+  std::vector<string> serialized(3, Serialize(example));
+
+  FastParseExampleConfig config;
+  AddDenseFeature("float_list", DT_FLOAT, {kNumValues}, false, kNumValues,
+                  &config);
+  AddDenseFeature("int64_list", DT_INT64, {kNumValues}, false, kNumValues,
+                  &config);
+
+  Result result;
+  TF_CHECK_OK(FastParseExample(config, serialized, {}, nullptr, &result));
+  ASSERT_EQ(2, result.dense_values.size());
+  auto floats = result.dense_values[0].matrix<float>();
+  auto int64s = result.dense_values[1].matrix<int64>();
+  for (int b = 0; b < 3; ++b) {
+    for (int i = 0; i < kNumValues; ++i) {
+      EXPECT_EQ(i * 0.5f, floats(b, i));
+      EXPECT_EQ(i * 1000, int64s(b, i));
+    }
+  }
+
+  FastParseExampleConfig config_too_long;
+  AddDenseFeature("float_list", DT_FLOAT, {kNumValues + 1}, false,
+                  kNumValues + 1, &config_too_long);
+  Result result_too_long;
+  EXPECT_FALSE(FastParseExample(config_too_long, serialized, {}, nullptr,
+                                &result_too_long)
+                   .ok());
+}
+
 string RandStr(random::SimplePhilox* rng) {
   static const char key_char_lookup[] =
       "0123456789{}~`!@#$%^&*()"
@@ -197,6 +197,33 @@ string* GetStringBackingBuffer(const Tensor& val) {
   return const_cast<string*>(val.flat<string>().data());
 }
 
+// Hands out the range of a memory-mapped data file holding a single tensor,
+// and keeps the mapping alive until the tensor buffer is released.  Owned by,
+// and deleted together with, that tensor buffer.
+class MappedDataAllocator : public Allocator {
+ public:
+  MappedDataAllocator(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                      const char* data)
+      : region_(std::move(region)), data_(data) {}
+
+  string Name() override { return "MappedDataAllocator"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return const_cast<char*>(data_);
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    DCHECK_EQ(ptr, data_);
+    delete this;
+  }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const char* const data_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MappedDataAllocator);
+};
+
 Status ParseEntryProto(StringPiece key, StringPiece value,
                        protobuf::MessageLite* out) {
   if (!out->ParseFromArray(value.data(), value.size())) {
@@ -713,9 +740,10 @@ Status MergeBundles(Env* env, gtl::ArraySlice<string> prefixes,
 
 // Interface for reading a tensor bundle.
 
-BundleReader::BundleReader(Env* env, StringPiece prefix)
+BundleReader::BundleReader(Env* env, StringPiece prefix, const Options& options)
     : env_(env),
       prefix_(prefix),
+      options_(options),
       metadata_(nullptr),
       table_(nullptr),
       iter_(nullptr) {
@@ -794,6 +822,12 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
 }
 
 Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
+  if (options_.use_mmap && DataTypeCanUseMemcpy(entry.dtype())) {
+    bool mapped = false;
+    TF_RETURN_IF_ERROR(GetMappedValue(entry, val, &mapped));
+    if (mapped) return Status::OK();
+  }
+
   Tensor* ret = val;
   const TensorShape stored_shape(TensorShape(entry.shape()));
   if (val->NumElements() == 0) {
@@ -876,6 +910,70 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   return Status::OK();
 }
 
+Status BundleReader::GetMappedValue(const BundleEntryProto& entry, Tensor* val,
+                                    bool* mapped) {
+  *mapped = false;
+  auto it = mapped_data_.find(entry.shard_id());
+  if (it == mapped_data_.end()) {
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    const Status s = env_->NewReadOnlyMemoryRegionFromFile(
+        DataFilename(prefix_, entry.shard_id(), num_shards_), &region);
+    if (!s.ok()) {
+      // Not all file systems support mapping; fall back to regular reads.
+      VLOG(1) << "Unable to memory-map shard " << entry.shard_id() << " of "
+              << prefix_ << ": " << s;
+    }
+    it = mapped_data_
+             .emplace(entry.shard_id(),
+                      std::shared_ptr<ReadOnlyMemoryRegion>(region.release()))
+             .first;
+  }
+  const std::shared_ptr<ReadOnlyMemoryRegion>& region = it->second;
+  if (region == nullptr) return Status::OK();
+
+  const TensorShape stored_shape(entry.shape());
+  const uint64 expected_size =
+      stored_shape.num_elements() * DataTypeSize(entry.dtype());
+  if (entry.size() != expected_size) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                            "; stored size ", entry.size(),
+                            "; expected size ", expected_size);
+  }
+  if (entry.offset() + entry.size() > region->length()) {
+    return errors::DataLoss("Bundle entry for key ", key(), " at offset ",
+                            entry.offset(), " of size ", entry.size(),
+                            " extends past the end of its data file of ",
+                            region->length(), " bytes");
+  }
+  const char* data = static_cast<const char*>(region->data()) + entry.offset();
+  const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the restored bytes ", actual_crc32c);
+  }
+
+  if (stored_shape.num_elements() > 0 &&
+      reinterpret_cast<uintptr_t>(data) % EIGEN_MAX_ALIGN_BYTES == 0) {
+    // The allocator is owned by the tensor buffer from here on.
+    *val = Tensor(new MappedDataAllocator(region, data), entry.dtype(),
+                  stored_shape);
+  } else {
+    if (val->NumElements() == 0) {
+      *val = Tensor(entry.dtype(), stored_shape);
+    }
+    if (val->TotalBytes() != entry.size()) {
+      return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                              "; stored size ", entry.size(),
+                              "; expected size ", val->TotalBytes());
+    }
+    memcpy(GetBackingBuffer(*val), data, entry.size());
+  }
+  *mapped = true;
+  return Status::OK();
+}
+
 Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -1061,6 +1159,20 @@ Status BundleReader::LookupTensorShape(StringPiece key, TensorShape* shape) {
   return LookupDtypeAndShape(key, &ignored, shape);
 }
 
+Status BundleReader::LookupShardId(StringPiece key, int32* shard_id) {
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  *shard_id = entry.slices_size() > 0 ? -1 : entry.shard_id();
+  return Status::OK();
+}
+
+Status BundleReader::LookupChecksum(StringPiece key, uint32* crc32c) {
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  *crc32c = entry.crc32c();
+  return Status::OK();
+}
+
 string BundleReader::DebugString() {
   // Format used below emulates that of TensorSliceReader::DebugString().
   string shape_str;
@@ -1078,6 +1190,51 @@ string BundleReader::DebugString() {
   return shape_str;
 }
 
+RestoredTensorPool* RestoredTensorPool::Global() {
+  static RestoredTensorPool* pool = new RestoredTensorPool;
+  return pool;
+}
+
+Tensor RestoredTensorPool::Share(const Tensor& tensor, uint32 crc32c) {
+  if (!DataTypeCanUseMemcpy(tensor.dtype())) return tensor;
+  const StringPiece data = tensor.tensor_data();
+  mutex_lock l(mu_);
+  const auto range = tensors_.equal_range(crc32c);
+  for (auto it = range.first; it != range.second; ++it) {
+    const Tensor& pooled = it->second;
+    if (pooled.dtype() == tensor.dtype() && pooled.shape() == tensor.shape() &&
+        pooled.tensor_data() == data) {
+      return pooled;
+    }
+  }
+  if (tensors_.size() >= sweep_size_) {
+    SweepLocked();
+    sweep_size_ = std::max<size_t>(2 * tensors_.size(), 64);
+  }
+  tensors_.emplace(crc32c, tensor);
+  return tensor;
+}
+
+void RestoredTensorPool::Sweep() {
+  mutex_lock l(mu_);
+  SweepLocked();
+}
+
+void RestoredTensorPool::SweepLocked() {
+  for (auto it = tensors_.begin(); it != tensors_.end();) {
+    if (it->second.RefCountIsOne()) {
+      it = tensors_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+size_t RestoredTensorPool::size() {
+  mutex_lock l(mu_);
+  return tensors_.size();
+}
+
 FileOutputBuffer::~FileOutputBuffer() { delete file_; }
 
 Status FileOutputBuffer::Append(StringPiece data) {
@@ -64,6 +64,7 @@ limitations under the License.
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -77,6 +78,8 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
 #include "tensorflow/core/util/tensor_slice_set.h"
@@ -181,7 +184,20 @@ Status MergeBundles(Env* env, gtl::ArraySlice<string> prefixes,
 // All threads accessing the same BundleReader must synchronize.
 class BundleReader {
  public:
-  BundleReader(Env* const env, StringPiece prefix);
+  struct Options {
+    Options() {}
+    // If true, data files are memory-mapped read-only (when the file system
+    // supports it), and Lookup() of a full, non-string tensor whose data is
+    // suitably aligned in the file returns a tensor backed directly by the
+    // mapped pages instead of a copy.  Such tensors keep the mapping alive
+    // after the reader is destroyed and MUST NOT be modified.  Bundles
+    // written with BundleWriter::Options::data_alignment set to
+    // EIGEN_MAX_ALIGN_BYTES are always suitably aligned; other tensors are
+    // copied out of the mapping.
+    bool use_mmap{false};
+  };
+  BundleReader(Env* const env, StringPiece prefix,
+               const Options& options = Options());
   ~BundleReader();
 
   // Is ok() iff the reader construction is successful (completed the read of
@@ -236,6 +252,21 @@ class BundleReader {
   Status LookupTensorSlices(StringPiece key, std::vector<TensorSlice>* slices)
       TF_MUST_USE_RESULT;
 
+  // Looks up the data file shard that holds the tensor keyed by "key".  Sets
+  // "shard_id" to -1 for partitioned tensors, whose slices may be stored in
+  // several shards.
+  // REQUIRES: status().ok()
+  Status LookupShardId(StringPiece key, int32* shard_id) TF_MUST_USE_RESULT;
+
+  // Looks up the crc32c checksum of the contents of the tensor keyed by
+  // "key".
+  // REQUIRES: status().ok()
+  Status LookupChecksum(StringPiece key, uint32* crc32c) TF_MUST_USE_RESULT;
+
+  // Returns the number of data file shards in the bundle.
+  // REQUIRES: status().ok()
+  int num_shards() const { return num_shards_; }
+
   // Looks up a specific slice of a partitioned tensor.
   // It is only required that the stored slices cover the requested slice,
   // namely "slice_spec" is a subset of the union of the stored slices.
@@ -274,6 +305,13 @@ class BundleReader {
   Status GetValue(const BundleEntryProto& entry,
                   Tensor* val) TF_MUST_USE_RESULT;
 
+  // Reads the tensor value described by "entry" from the memory-mapped data
+  // file, if that file can be mapped.  Sets "*mapped" to true iff "val" has
+  // been filled in.
+  // REQUIRES: options_.use_mmap && DataTypeCanUseMemcpy(entry.dtype())
+  Status GetMappedValue(const BundleEntryProto& entry, Tensor* val,
+                        bool* mapped) TF_MUST_USE_RESULT;
+
   // Reads the slice described by "slice_spec".  The corresponding full tensor
   // has key "ful_tensor_key" and metadata proto "full_tensor_entry".
   // REQUIRES: full_tensor_entry.slices_size() > 0
@@ -284,6 +322,7 @@ class BundleReader {
 
   Env* env_;  // Not owned.
   const string prefix_;
+  const Options options_;
 
   Status status_;
   RandomAccessFile* metadata_;  // Owned.
@@ -291,6 +330,11 @@ class BundleReader {
   table::Iterator* iter_;
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32, io::InputBuffer*> data_;
+  // The memory-mapped data files, if options_.use_mmap.  A null region
+  // records that the shard could not be mapped.  Shared with the tensors
+  // that are backed by the mapped pages.
+  std::unordered_map<int32, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
@@ -305,6 +349,36 @@ class BundleReader {
   TF_DISALLOW_COPY_AND_ASSIGN(BundleReader);
 };
 
+// A process-wide pool of restored tensors, which lets the tensors with equal
+// contents share one buffer, e.g. the unchanged variables of two versions of a
+// model loaded side by side.  Shared buffers must not be modified in place.
+// Resource variables copy a shared tensor before modifying it, and ref
+// variables copy it on assignment, since it is never their only reference.
+class RestoredTensorPool {
+ public:
+  static RestoredTensorPool* Global();
+
+  // Returns a tensor equal to "tensor", whose contents have the checksum
+  // "crc32c", that shares the buffer of an equal pooled tensor if there is
+  // one.  Otherwise adds "tensor" to the pool and returns it.
+  Tensor Share(const Tensor& tensor, uint32 crc32c);
+
+  // Drops the pooled tensors that are used nowhere else.  Also done as the
+  // pool grows.
+  void Sweep();
+
+  // Returns the number of pooled tensors.
+  size_t size();
+
+ private:
+  void SweepLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutex mu_;
+  std::unordered_multimap<uint32, Tensor> tensors_ GUARDED_BY(mu_);
+  // Size of the pool at which Share() sweeps it.
+  size_t sweep_size_ GUARDED_BY(mu_) = 64;
+};
+
 // A buffering wrapper for a WritableFile.  Useful if the caller wishes to issue
 // small writes to a file (e.g. writing out a list of small varints).
 // External synchronization must be used in the presence of concurrent callers.
@@ -830,6 +830,86 @@ TEST(TensorBundleTest, VersionTest) {
   }
 }
 
+TEST(TensorBundleTest, MemoryMappedRead) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = EIGEN_MAX_ALIGN_BYTES;
+    BundleWriter writer(Env::Default(), Prefix("mmap_aligned"), opts);
+    TF_EXPECT_OK(writer.Add("int8", Constant<int8>(1, TensorShape({3}))));
+    TF_EXPECT_OK(writer.Add("float", Constant_2x3<float>(2)));
+    TF_EXPECT_OK(writer.Add("string", Constant_2x3<string>("foo")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    // Without alignment, "float" follows the 3 bytes of "int8".
+    BundleWriter writer(Env::Default(), Prefix("mmap_unaligned"));
+    TF_EXPECT_OK(writer.Add("int8", Constant<int8>(1, TensorShape({3}))));
+    TF_EXPECT_OK(writer.Add("float", Constant_2x3<float>(2)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options options;
+  options.use_mmap = true;
+  for (const char* prefix : {"mmap_aligned", "mmap_unaligned"}) {
+    BundleReader reader(Env::Default(), Prefix(prefix), options);
+    TF_ASSERT_OK(reader.status());
+    Expect<int8>(&reader, "int8", Constant<int8>(1, TensorShape({3})));
+    Expect<float>(&reader, "float", Constant_2x3<float>(2));
+  }
+  Tensor mapped;
+  {
+    BundleReader reader(Env::Default(), Prefix("mmap_aligned"), options);
+    TF_ASSERT_OK(reader.status());
+    Expect<string>(&reader, "string", Constant_2x3<string>("foo"));
+    TF_ASSERT_OK(reader.Lookup("float", &mapped));
+  }
+  // The mapped tensor outlives the reader.
+  test::ExpectTensorEqual<float>(mapped, Constant_2x3<float>(2));
+}
+
+TEST(TensorBundleTest, SharesEqualRestoredTensors) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("shared_v1"));
+    TF_EXPECT_OK(writer.Add("same", Constant<float>(1, TensorShape({64}))));
+    TF_EXPECT_OK(writer.Add("changed", Constant<float>(2, TensorShape({64}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter writer(Env::Default(), Prefix("shared_v2"));
+    TF_EXPECT_OK(writer.Add("same", Constant<float>(1, TensorShape({64}))));
+    TF_EXPECT_OK(writer.Add("changed", Constant<float>(3, TensorShape({64}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  RestoredTensorPool pool;
+  auto restore = [&pool](const string& prefix, const string& key) {
+    BundleReader reader(Env::Default(), Prefix(prefix));
+    TF_CHECK_OK(reader.status());
+    Tensor tensor;
+    TF_CHECK_OK(reader.Lookup(key, &tensor));
+    uint32 crc32c;
+    TF_CHECK_OK(reader.LookupChecksum(key, &crc32c));
+    return pool.Share(tensor, crc32c);
+  };
+  Tensor same_v1 = restore("shared_v1", "same");
+  Tensor changed_v1 = restore("shared_v1", "changed");
+  Tensor same_v2 = restore("shared_v2", "same");
+  Tensor changed_v2 = restore("shared_v2", "changed");
+  EXPECT_EQ(same_v1.tensor_data().data(), same_v2.tensor_data().data());
+  EXPECT_NE(changed_v1.tensor_data().data(), changed_v2.tensor_data().data());
+  test::ExpectTensorEqual<float>(changed_v2,
+                                 Constant<float>(3, TensorShape({64})));
+  EXPECT_EQ(3, pool.size());
+
+  // Unloading the first version leaves only the tensors of the second one.
+  same_v1 = Tensor();
+  changed_v1 = Tensor();
+  pool.Sweep();
+  EXPECT_EQ(2, pool.size());
+  same_v2 = Tensor();
+  changed_v2 = Tensor();
+  pool.Sweep();
+  EXPECT_EQ(0, pool.size());
+}
+
 class TensorBundleAlignmentTest : public ::testing::Test {
  protected:
   template <typename T>
@@ -38,6 +38,11 @@ ADD_BOOL_CUDNN_FLAG(CudnnUseAutotune, TF_CUDNN_USE_AUTOTUNE, true);
 // statistically the best cudnnRNNAlgo_t and cudnnMathType_t.
 // The flag is disabled when TF_DEBUG_CUDNN_RNN is turned on.
 ADD_BOOL_CUDNN_FLAG(CudnnRnnUseAutotune, TF_CUDNN_RNN_USE_AUTOTUNE, true);
+// Whether CudnnRNNCanonicalToParams may reuse its output while its inputs
+// are the same buffers, which is only correct if their contents never change,
+// as in frozen inference graphs.
+ADD_BOOL_CUDNN_FLAG(CudnnRnnCacheFrozenParams,
+                    TF_CUDNN_RNN_CACHE_FROZEN_PARAMS, false);
 ADD_BOOL_CUDNN_FLAG(CudnnDisableConv1x1Optimization,
                     TF_CUDNN_DISABLE_CONV_1X1_OPTIMIZATION, false);
 
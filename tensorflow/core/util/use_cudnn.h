@@ -34,6 +34,7 @@ enum class FP16ConvMode {
 bool CanUseCudnn();
 bool CudnnUseAutotune();
 bool CudnnRnnUseAutotune();
+bool CudnnRnnCacheFrozenParams();
 bool CudnnDisableConv1x1Optimization();
 FP16ConvMode CudnnConvComputeMode();
 bool DebugCudnnRnn();
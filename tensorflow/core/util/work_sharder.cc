@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/util/work_sharder.h"
 
+#include <algorithm>
+#include <atomic>
+
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/platform/logging.h"
 
@@ -22,6 +25,17 @@ namespace tensorflow {
 
 /* ABSL_CONST_INIT */ thread_local int per_thread_max_parallism = 1000000;
 
+namespace {
+
+// If total * cost_per_unit is small, it is not worth shard too much. Let us
+// assume each cost unit is 1ns, kMinCostPerShard=10000 is 10us.
+const int64 kMinCostPerShard = 10000;
+
+// A saturated ShardCostFeedback tries one more shard after this many calls.
+const int kProbeInterval = 8;
+
+}  // namespace
+
 void SetPerThreadMaxParallelism(int max_parallelism) {
   CHECK_LE(0, max_parallelism);
   per_thread_max_parallism = max_parallelism;
@@ -50,6 +64,84 @@ void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
               max_parallelism);
 }
 
+ShardCostFeedback::ShardCostFeedback(int64 initial_cost_per_unit)
+    : cost_per_unit_(std::max(int64{1}, initial_cost_per_unit)),
+      max_parallelism_(1000000) {}
+
+int64 ShardCostFeedback::cost_per_unit() const {
+  mutex_lock l(mu_);
+  return cost_per_unit_;
+}
+
+int ShardCostFeedback::max_parallelism() const {
+  mutex_lock l(mu_);
+  return max_parallelism_;
+}
+
+void ShardCostFeedback::Record(int64 total, int num_shards,
+                               int64 compute_nsec, int64 dispatch_delay_nsec) {
+  const int64 measured = std::max(int64{1}, compute_nsec / total);
+  mutex_lock l(mu_);
+  cost_per_unit_ =
+      measured_ ? cost_per_unit_ + (measured - cost_per_unit_) / 4 : measured;
+  measured_ = true;
+  // The workers are saturated when the shards wait longer to start than
+  // they take to run, so using fewer shards would not be any slower.
+  if (num_shards > 1 && dispatch_delay_nsec > compute_nsec / num_shards) {
+    max_parallelism_ = std::max(1, num_shards / 2);
+    num_calls_at_max_ = 0;
+  } else if (num_shards >= max_parallelism_ &&
+             ++num_calls_at_max_ >= kProbeInterval) {
+    ++max_parallelism_;
+    num_calls_at_max_ = 0;
+  }
+}
+
+void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
+           ShardCostFeedback* feedback,
+           std::function<void(int64, int64)> work) {
+  CHECK_GE(total, 0);
+  if (total == 0) {
+    return;
+  }
+  max_parallelism =
+      std::min({max_parallelism, GetPerThreadMaxParallelism(),
+                feedback->max_parallelism(), workers->NumThreads() + 1});
+  // The number of units worth a shard of their own.
+  const int64 units_per_shard =
+      std::max(int64{1}, kMinCostPerShard / feedback->cost_per_unit());
+  const int num_shards = std::max<int>(
+      1, std::min(static_cast<int64>(max_parallelism),
+                  total / units_per_shard));
+  const int64 block_size = (total + num_shards - 1) / num_shards;
+  const int num_shards_used = (total + block_size - 1) / block_size;
+
+  Env* env = Env::Default();
+  std::atomic<int64> worker_compute_nsec(0);
+  std::atomic<int64> dispatch_delay_nsec(0);
+  BlockingCounter counter(num_shards_used - 1);
+  const int64 schedule_nsec = env->NowNanos();
+  for (int64 start = block_size; start < total; start += block_size) {
+    const int64 limit = std::min(start + block_size, total);
+    workers->Schedule([&, start, limit]() {
+      const int64 start_nsec = env->NowNanos();
+      dispatch_delay_nsec += start_nsec - schedule_nsec;
+      work(start, limit);
+      worker_compute_nsec += env->NowNanos() - start_nsec;
+      counter.DecrementCount();
+    });
+  }
+  // Inline execute the 1st shard.
+  const int64 start_nsec = env->NowNanos();
+  work(0, std::min(block_size, total));
+  const int64 compute_nsec = env->NowNanos() - start_nsec;
+  counter.Wait();
+
+  feedback->Record(
+      total, num_shards_used, compute_nsec + worker_compute_nsec,
+      num_shards_used > 1 ? dispatch_delay_nsec / (num_shards_used - 1) : 0);
+}
+
 // DEPRECATED: Prefer threadpool->TransformRangeConcurrently, which allows you
 // to directly specify the shard size.
 void Sharder::Do(int64 total, int64 cost_per_unit, const Work& work,
@@ -57,11 +149,6 @@ void Sharder::Do(int64 total, int64 cost_per_unit, const Work& work,
   cost_per_unit = std::max(int64{1}, cost_per_unit);
   // We shard [0, total) into "num_shards" shards.
   //   1 <= num_shards <= num worker threads
-  //
-  // If total * cost_per_unit is small, it is not worth shard too
-  // much. Let us assume each cost unit is 1ns, kMinCostPerShard=10000
-  // is 10us.
-  static const int64 kMinCostPerShard = 10000;
   const int num_shards =
       std::max<int>(1, std::min(static_cast<int64>(max_parallelism),
                                 total * cost_per_unit / kMinCostPerShard));
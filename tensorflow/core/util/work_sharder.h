@@ -19,6 +19,9 @@ limitations under the License.
 #include <functional>
 
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -57,6 +60,49 @@ namespace tensorflow {
 void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
            int64 cost_per_unit, std::function<void(int64, int64)> work);
 
+// Learns the cost per unit of work of one Shard() call site from the calls
+// it made, for kernels whose cost per unit depends on their inputs, and
+// limits the number of shards when the workers are too busy with other work
+// to start them promptly. Typically a member of the kernel. Thread-safe.
+class ShardCostFeedback {
+ public:
+  // "initial_cost_per_unit", in nanoseconds, is used until a call was
+  // measured.
+  explicit ShardCostFeedback(int64 initial_cost_per_unit);
+
+  // The estimated nanoseconds to complete a unit of work.
+  int64 cost_per_unit() const;
+
+  // The number of shards from which the workers were saturated.
+  int max_parallelism() const;
+
+  // Records that a call to Shard() split "total" units of work into
+  // "num_shards" shards, which took "compute_nsec" to complete in total, and
+  // whose shards given to the workers started on average
+  // "dispatch_delay_nsec" after they were scheduled. Called by Shard().
+  void Record(int64 total, int num_shards, int64 compute_nsec,
+              int64 dispatch_delay_nsec);
+
+ private:
+  mutable mutex mu_;
+  bool measured_ GUARDED_BY(mu_) = false;
+  int64 cost_per_unit_ GUARDED_BY(mu_);
+  int max_parallelism_ GUARDED_BY(mu_);
+  // The number of calls since max_parallelism_ was last changed that used
+  // max_parallelism_ shards without saturating the workers.
+  int num_calls_at_max_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShardCostFeedback);
+};
+
+// Like the Shard() above, but with the cost per unit measured by "feedback"
+// from the earlier calls rather than estimated by the caller, and with at
+// most feedback->max_parallelism() shards.
+//
+// REQUIRES: feedback != nullptr
+void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
+           ShardCostFeedback* feedback, std::function<void(int64, int64)> work);
+
 // Each thread has an associated option to express the desired maximum
 // parallelism. Its default is a very large quantity.
 //
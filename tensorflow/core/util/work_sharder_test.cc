@@ -89,6 +89,45 @@ TEST(Shard, OverflowTest) {
   }
 }
 
+TEST(Shard, CostFeedback) {
+  thread::ThreadPool threads(Env::Default(), "test", 4);
+  ShardCostFeedback feedback(1);
+  EXPECT_EQ(1, feedback.cost_per_unit());
+  for (int i = 0; i < 3; ++i) {
+    mutex mu;
+    std::vector<bool> work(100, false);
+    Shard(100, &threads, work.size(), &feedback,
+          [&mu, &work](int64 start, int64 limit) {
+            Env::Default()->SleepForMicroseconds(100 * (limit - start));
+            mutex_lock l(mu);
+            for (; start < limit; ++start) {
+              EXPECT_FALSE(work[start]);
+              work[start] = true;
+            }
+          });
+    for (bool done : work) {
+      EXPECT_TRUE(done);
+    }
+  }
+  // Each unit sleeps for 100us.
+  EXPECT_GE(feedback.cost_per_unit(), 100000);
+}
+
+TEST(Shard, CostFeedbackSaturation) {
+  ShardCostFeedback feedback(1000);
+  // The shards waited longer to start than they ran.
+  feedback.Record(100, 8, 8000, 2000);
+  EXPECT_EQ(4, feedback.max_parallelism());
+  EXPECT_EQ(80, feedback.cost_per_unit());
+  feedback.Record(100, 4, 8000, 1000);
+  EXPECT_EQ(4, feedback.max_parallelism());
+  // After enough calls without saturation, one more shard is tried.
+  for (int i = 1; i < 8; ++i) {
+    feedback.Record(100, 4, 8000, 1000);
+  }
+  EXPECT_EQ(5, feedback.max_parallelism());
+}
+
 void BM_Sharding(int iters, int arg) {
   thread::ThreadPool threads(Env::Default(), "test", 16);
   const int64 total = 1LL << 30;
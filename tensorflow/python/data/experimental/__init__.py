@@ -35,7 +35,9 @@ See [Importing Data](https://tensorflow.org/guide/datasets) for an overview.
 @@choose_from_datasets
 @@copy_to_device
 @@dense_to_sparse_batch
+@@dynamic_shard
 @@enumerate_dataset
+@@from_data_service
 @@get_next_as_optional
 @@get_single_element
 @@group_by_reducer
@@ -54,6 +56,7 @@ See [Importing Data](https://tensorflow.org/guide/datasets) for an overview.
 @@scan
 @@set_stats_aggregator
 @@shuffle_and_repeat
+@@snapshot
 @@StatsAggregator
 @@unbatch
 @@unique
@@ -71,6 +74,8 @@ from tensorflow.python.data.experimental.ops.batching import dense_to_sparse_bat
 from tensorflow.python.data.experimental.ops.batching import map_and_batch
 from tensorflow.python.data.experimental.ops.batching import unbatch
 from tensorflow.python.data.experimental.ops.counter import Counter
+from tensorflow.python.data.experimental.ops.data_service import dynamic_shard
+from tensorflow.python.data.experimental.ops.data_service import from_data_service
 from tensorflow.python.data.experimental.ops.enumerate_ops import enumerate_dataset
 from tensorflow.python.data.experimental.ops.error_ops import ignore_errors
 from tensorflow.python.data.experimental.ops.get_single_element import get_single_element
@@ -98,6 +103,7 @@ from tensorflow.python.data.experimental.ops.readers import SqlDataset
 from tensorflow.python.data.experimental.ops.resampling import rejection_resample
 from tensorflow.python.data.experimental.ops.scan_ops import scan
 from tensorflow.python.data.experimental.ops.shuffle_ops import shuffle_and_repeat
+from tensorflow.python.data.experimental.ops.snapshot import snapshot
 from tensorflow.python.data.experimental.ops.stats_ops import latency_stats
 from tensorflow.python.data.experimental.ops.stats_ops import set_stats_aggregator
 from tensorflow.python.data.experimental.ops.stats_ops import StatsAggregator
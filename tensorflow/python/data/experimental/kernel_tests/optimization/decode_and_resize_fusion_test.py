@@ -0,0 +1,70 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the `DecodeAndResizeFusion` optimization."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import numpy as np
+
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import dtypes
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import image_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.platform import test
+
+
+class DecodeAndResizeFusionTest(test_base.DatasetTestBase):
+
+  def _preprocessedImages(self, fuse):
+    np.random.seed(42)
+    images = [
+        image_ops.encode_jpeg(
+            constant_op.constant(
+                np.random.randint(256, size=(80, 96, 3)), dtype=dtypes.uint8))
+        for _ in range(3)
+    ]
+
+    def preprocess(contents):
+      image = image_ops.decode_and_crop_jpeg(contents, [8, 16, 64, 64])
+      image = math_ops.cast(image, dtypes.float32)
+      image = image_ops.resize_bilinear(array_ops.expand_dims(image, 0),
+                                        [48, 40])
+      image = array_ops.squeeze(image, [0])
+      return (image - 127.5) * (1. / 127.5)
+
+    dataset = dataset_ops.Dataset.from_tensor_slices(
+        array_ops.stack(images)).map(preprocess)
+    options = dataset_ops.Options()
+    options.experimental_decode_and_resize_fusion = fuse
+    dataset = dataset.with_options(options)
+
+    get_next = dataset.make_one_shot_iterator().get_next()
+    with self.cached_session() as sess:
+      return [sess.run(get_next) for _ in range(3)]
+
+  def testFusedMatchesUnfused(self):
+    fused = self._preprocessedImages(fuse=True)
+    unfused = self._preprocessedImages(fuse=False)
+    for fused_image, unfused_image in zip(fused, unfused):
+      self.assertEqual((48, 40, 3), fused_image.shape)
+      self.assertAllClose(unfused_image, fused_image, atol=1e-5)
+
+
+if __name__ == "__main__":
+  test.main()
@@ -38,9 +38,11 @@ from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import bitwise_ops
 from tensorflow.python.ops import check_ops
 from tensorflow.python.ops import clip_ops
+from tensorflow.python.ops import gen_image_ops
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import nn
 from tensorflow.python.ops import parsing_ops
+from tensorflow.python.ops import string_ops
 from tensorflow.python.platform import test
 
 
@@ -262,6 +264,56 @@ def _generate_parse_single_example_test_case():
   return parse_single_example_fn, parse_example_factory
 
 
+def _generate_image_test_cases():
+
+  def image_dataset_factory():
+    return dataset_ops.Dataset.from_tensors(
+        np.random.rand(10, 4, 6, 3).astype(np.float32)).repeat(5)
+
+  def resize_fn(resize_op):
+    return lambda x: array_ops.squeeze(
+        resize_op(array_ops.expand_dims(x, 0), [8, 12]), [0])
+
+  return [
+      ("ResizeArea", resize_fn(gen_image_ops.resize_area),
+       image_dataset_factory),
+      ("ResizeBicubic", resize_fn(gen_image_ops.resize_bicubic),
+       image_dataset_factory),
+      ("ResizeBilinear", resize_fn(gen_image_ops.resize_bilinear),
+       image_dataset_factory),
+      ("ResizeNearestNeighbor",
+       resize_fn(gen_image_ops.resize_nearest_neighbor), image_dataset_factory),
+      ("AdjustContrast", lambda x: gen_image_ops.adjust_contrastv2(x, 2.0),
+       image_dataset_factory),
+      ("AdjustHue", lambda x: gen_image_ops.adjust_hue(x, 0.2),
+       image_dataset_factory),
+      ("AdjustSaturation", lambda x: gen_image_ops.adjust_saturation(x, 0.5),
+       image_dataset_factory),
+      ("RGBToHSV", gen_image_ops.rgb_to_hsv, image_dataset_factory),
+      ("HSVToRGB", gen_image_ops.hsv_to_rgb, image_dataset_factory),
+  ]
+
+
+def _generate_string_test_cases():
+
+  def string_dataset_factory():
+    return dataset_ops.Dataset.from_tensor_slices([" 1.5", "2 ", " 3.25 ",
+                                                   "4"]).repeat(5)
+
+  def to_number(x):
+    return parsing_ops.string_to_number(string_ops.string_strip(x))
+
+  return [
+      ("AsString", lambda x: string_ops.as_string(to_number(x)),
+       string_dataset_factory),
+      ("StringStrip", string_ops.string_strip, string_dataset_factory),
+      ("StringToHashBucketFast",
+       lambda x: string_ops.string_to_hash_bucket_fast(x, 10),
+       string_dataset_factory),
+      ("StringToNumber", to_number, string_dataset_factory),
+  ]
+
+
 def _generate_optimization_test_cases():
 
   def base_dataset_factory():
@@ -292,12 +344,19 @@ def _generate_optimization_test_cases():
       ("Unpack", array_ops.unstack, base_dataset_factory),
       ("UnpackNegativeAxis", lambda x: array_ops.unstack(x, axis=-1),
        base_dataset_factory),
+      ("ExpandDims", lambda x: array_ops.expand_dims(x, 1),
+       base_dataset_factory),
+      ("ExpandDimsNegativeAxis", lambda x: array_ops.expand_dims(x, -1),
+       base_dataset_factory),
+      ("Squeeze", lambda x: array_ops.squeeze(array_ops.expand_dims(x, 0),
+                                              [0]), base_dataset_factory),
       # Parsing ops
       ("DecodeCSV", csv_test_case[0], csv_test_case[1]),
       ("ParseSingleExample", parse_fn, parse_base),
       ("ParseSingleExampleDenseOutputOnly", dense_output_only_parse_fn,
        parse_base),
-  ] + _generate_cwise_test_cases()
+  ] + (_generate_cwise_test_cases() + _generate_image_test_cases() +
+       _generate_string_test_cases())
 
   return [{
       "testcase_name":
@@ -146,6 +146,31 @@ class ModelDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
           (np.median(deltas), np.mean(deltas), np.std(deltas), np.min(deltas),
            np.max(deltas)))
 
+  def testModelPrefetch(self):
+    k = 1024 * 1024
+    dataset = dataset_ops.Dataset.from_tensors((np.random.rand(1, 4 * k),
+                                                np.random.rand(4 * k,
+                                                               1))).repeat()
+    dataset = dataset.map(math_ops.matmul)
+    dataset = dataset.prefetch(optimization.AUTOTUNE)
+    dataset = dataset_ops._ModelDataset(dataset)
+    iterator = dataset.make_one_shot_iterator()
+    get_next = iterator.get_next()
+
+    deltas = []
+    with self.cached_session() as sess:
+      for _ in range(5):
+        sess.run(get_next.op)
+      for _ in range(1000):
+        start = time.time()
+        sess.run(get_next.op)
+        end = time.time()
+        deltas.append(end - start)
+
+    print("%f (median), %f (mean), %f (stddev), %f (min), %f (max)\n" %
+          (np.median(deltas), np.mean(deltas), np.std(deltas), np.min(deltas),
+           np.max(deltas)))
+
   def testModelNested(self):
     k = 1024 * 1024
     a = (np.random.rand(1, 8 * k), np.random.rand(8 * k, 1))
@@ -208,6 +233,22 @@ class ModelDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(get_next)
 
+  def testModelParallelMapOnPrivatePool(self):
+    # The map function runs on the thread pool of the model iterator, whose
+    # share of the CPUs follows how long the consumer waits for elements.
+    dataset = dataset_ops.Dataset.range(1000).map(
+        lambda x: x * x, num_parallel_calls=optimization.AUTOTUNE)
+    dataset = dataset_ops._ModelDataset(dataset)
+    iterator = dataset.make_one_shot_iterator()
+    get_next = iterator.get_next()
+
+    with self.cached_session() as sess:
+      for i in range(1000):
+        self.assertEqual(i * i, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+
 
 if __name__ == "__main__":
   test.main()
@@ -17,6 +17,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import numpy as np
+
 from tensorflow.core.protobuf import config_pb2
 from tensorflow.python.data.experimental.ops import prefetching_ops
 from tensorflow.python.data.kernel_tests import test_base
@@ -26,7 +28,11 @@ from tensorflow.python.framework import errors
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.framework import test_util
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import string_ops
 from tensorflow.python.platform import test
+from tensorflow.python.util import compat
 
 
 class PrefetchToDeviceTest(test_base.DatasetTestBase):
@@ -174,6 +180,29 @@ class PrefetchToDeviceTest(test_base.DatasetTestBase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(next_element)
 
+  def testPrefetchToDeviceGpuMixedComponents(self):
+    if not test_util.is_gpu_available():
+      self.skipTest("No GPU available")
+
+    # Large enough elements that several copies are in flight, and a string
+    # component that stays in host memory.
+    host_dataset = dataset_ops.Dataset.range(100).map(
+        lambda x: (array_ops.fill([1024, 64], math_ops.to_float(x)),
+                   string_ops.as_string(x)))
+    device_dataset = host_dataset.apply(
+        prefetching_ops.prefetch_to_device("/gpu:0", buffer_size=4))
+
+    iterator = device_dataset.make_one_shot_iterator()
+    next_element = iterator.get_next()
+
+    with self.cached_session() as sess:
+      for i in range(100):
+        values, string = sess.run(next_element)
+        self.assertAllEqual(np.full([1024, 64], i, np.float32), values)
+        self.assertEqual(compat.as_bytes(str(i)), string)
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(next_element)
+
   def testPrefetchToDeviceWithReInit(self):
     host_dataset = dataset_ops.Dataset.range(10)
     device_dataset = host_dataset.apply(
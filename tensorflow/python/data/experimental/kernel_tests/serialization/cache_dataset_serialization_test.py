@@ -85,24 +85,16 @@ class CacheDatasetSerializationTest(
         ds_fn, [5], 8, verify_exhausted=False, save_checkpoint_at_end=False)
     self.assertSequenceEqual(outputs, range(8))
 
-    if is_memory:
-      outputs = outputs[:5]
-      outputs.extend(
-          self.gen_outputs(
-              ds_fn, [],
-              self.num_outputs - 5,
-              ckpt_saved=True,
-              verify_exhausted=False))
-      self.assertSequenceEqual(outputs, self.expected_outputs())
-    else:
-      # Restoring from checkpoint and running GetNext should return
-      # `AlreadExistsError` now because the lockfile already exists.
-      with self.assertRaises(errors.AlreadyExistsError):
+    # Restoring from the checkpoint resumes writing the file cache, even though
+    # the first iterator left the lockfile of its last shard behind.
+    outputs = outputs[:5]
+    outputs.extend(
         self.gen_outputs(
             ds_fn, [],
             self.num_outputs - 5,
             ckpt_saved=True,
-            verify_exhausted=False)
+            verify_exhausted=False))
+    self.assertSequenceEqual(outputs, self.expected_outputs())
 
   @parameterized.named_parameters(
       ('Memory', True),
@@ -248,6 +240,29 @@ class CacheDatasetSerializationTest(
         ds_fn, [], self.num_outputs, verify_exhausted=False)
     self.assertSequenceEqual(outputs, list(range(10)) * 3)
 
+  def testCheckpointShuffledReads(self):
+    filename = os.path.join(self.get_temp_dir(), self.cache_file_prefix)
+
+    def ds_fn():
+      return dataset_ops.Dataset.range(self.range_size).cache(
+          filename, shuffle_reads=True).repeat(self.num_repeats)
+
+    # Write the complete cache, read 3 elements of the second epoch from it and
+    # save ckpt.
+    outputs = self.gen_outputs(ds_fn, [], 13, verify_exhausted=False)
+    self.assertSequenceEqual(outputs[:10], range(10))
+
+    # The restored reader continues in the order of the saved one, so the
+    # second epoch produces every element exactly once.
+    outputs.extend(
+        self.gen_outputs(
+            ds_fn, [],
+            self.num_outputs - 13,
+            ckpt_saved=True,
+            verify_exhausted=False))
+    self.assertItemsEqual(outputs[10:20], range(10))
+    self.assertItemsEqual(outputs[20:], range(10))
+
 
 if __name__ == '__main__':
   test.main()
@@ -0,0 +1,125 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for `tf.data.experimental.snapshot()`."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+from tensorflow.python.data.experimental.ops import snapshot
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.platform import gfile
+from tensorflow.python.platform import test
+
+
+class SnapshotTest(test_base.DatasetTestBase):
+
+  def _readAll(self, dataset):
+    with self.session(graph=ops.get_default_graph()) as sess:
+      next_element = dataset.make_one_shot_iterator().get_next()
+      elements = []
+      while True:
+        try:
+          elements.append(sess.run(next_element))
+        except errors.OutOfRangeError:
+          return elements
+
+  def _snapshotDirectories(self, path):
+    return [d for d in gfile.ListDirectory(path)
+            if gfile.IsDirectory(os.path.join(path, d))]
+
+  def testWriteThenRead(self):
+    path = self.get_temp_dir()
+    for compression in ["", "GZIP"]:
+      with ops.Graph().as_default():
+        dataset = dataset_ops.Dataset.range(100).map(
+            lambda x: (x, math_ops.square(x)))
+        dataset = dataset.apply(
+            snapshot.snapshot(path, compression=compression, num_shards=3))
+        expected = [(x, x * x) for x in range(100)]
+        # The first pass writes the snapshot, the second one reads it.
+        self.assertEqual(expected, self._readAll(dataset))
+        self.assertEqual(expected, self._readAll(dataset))
+      self.assertEqual(1, len(self._snapshotDirectories(path)))
+      snapshot_dir = os.path.join(path, self._snapshotDirectories(path)[0])
+      self.assertEqual(
+          4, len(gfile.ListDirectory(snapshot_dir)),
+          "Expected 3 shards and the metadata file.")
+      gfile.DeleteRecursively(snapshot_dir)
+
+  def testReadsSnapshotInsteadOfInput(self):
+    path = self.get_temp_dir()
+    with ops.Graph().as_default():
+      dataset = dataset_ops.Dataset.range(10).apply(
+          snapshot.snapshot(path, num_shards=4))
+      self.assertEqual(list(range(10)), self._readAll(dataset))
+    snapshot_dir = os.path.join(path, self._snapshotDirectories(path)[0])
+    # Drop all shards but the first one from the snapshot, which then only
+    # holds every 4th element.
+    metadata = os.path.join(snapshot_dir, "snapshot.metadata")
+    lines = gfile.GFile(metadata).read().split("\n")
+    with gfile.GFile(metadata, "w") as f:
+      f.write("\n".join(lines[:2]))
+    with ops.Graph().as_default():
+      dataset = dataset_ops.Dataset.range(10).apply(
+          snapshot.snapshot(path, num_shards=4))
+      self.assertEqual([0, 4, 8], self._readAll(dataset))
+    # A different input pipeline gets a new snapshot.
+    with ops.Graph().as_default():
+      dataset = dataset_ops.Dataset.range(5).apply(snapshot.snapshot(path))
+      self.assertEqual(list(range(5)), self._readAll(dataset))
+    self.assertEqual(2, len(self._snapshotDirectories(path)))
+
+  def testShuffleShards(self):
+    path = self.get_temp_dir()
+    with ops.Graph().as_default():
+      dataset = dataset_ops.Dataset.range(100).apply(
+          snapshot.snapshot(path, num_shards=10, shuffle_shards=True, seed=1))
+      self.assertEqual(list(range(100)), self._readAll(dataset))
+      shuffled = self._readAll(dataset)
+      self.assertEqual(list(range(100)), sorted(shuffled))
+      # The shards are read round robin, and each holds every 10th element.
+      self.assertEqual(list(range(10)), sorted(x % 10 for x in shuffled[:10]))
+      # The order of the shards only depends on the seed.
+      self.assertEqual(shuffled, self._readAll(dataset))
+
+  def testPartialIterationDoesNotPublish(self):
+    path = self.get_temp_dir()
+    with ops.Graph().as_default():
+      dataset = dataset_ops.Dataset.range(10).apply(snapshot.snapshot(path))
+      next_element = dataset.make_one_shot_iterator().get_next()
+      with self.session() as sess:
+        self.assertEqual(0, sess.run(next_element))
+    for directory in self._snapshotDirectories(path):
+      self.assertEqual([], gfile.ListDirectory(os.path.join(path, directory)))
+
+  def testUnserializableInput(self):
+    dataset = dataset_ops.Dataset.from_generator(lambda: [1, 2, 3],
+                                                 output_types=dtypes.int64)
+    dataset = dataset.apply(snapshot.snapshot(self.get_temp_dir()))
+    iterator = dataset.make_initializable_iterator()
+    with self.cached_session() as sess:
+      with self.assertRaisesOpError("can be serialized"):
+        sess.run(iterator.initializer)
+
+
+if __name__ == "__main__":
+  test.main()
@@ -126,6 +126,27 @@ class StatsDatasetTest(stats_dataset_test_base.StatsDatasetTestBase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(next_element)
 
+  def testShuffleBufferedBytes(self):
+    stats_aggregator = stats_ops.StatsAggregator()
+    dataset = dataset_ops.Dataset.range(10).shuffle(10).apply(
+        stats_ops.set_stats_aggregator(stats_aggregator))
+    iterator = dataset.make_initializable_iterator()
+    next_element = iterator.get_next()
+    summary_t = stats_aggregator.get_summary()
+
+    with self.cached_session() as sess:
+      sess.run(iterator.initializer)
+      for i in range(10):
+        sess.run(next_element)
+        summary_str = sess.run(summary_t)
+        # Each buffered element is a scalar int64 tensor.
+        self._assertSummaryHasScalarValue(
+            summary_str,
+            "Iterator::SetStatsAggregator::Shuffle::buffered_bytes",
+            float(8 * (9 - i)))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(next_element)
+
   def testFilteredElementsStats(self):
     stats_aggregator = stats_ops.StatsAggregator()
     dataset = dataset_ops.Dataset.range(101).filter(
@@ -0,0 +1,219 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Datasets backed by the tf.data service."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import tensor_shape
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import gen_experimental_dataset_ops
+from tensorflow.python.util.tf_export import tf_export
+
+
+class _DataServiceDataset(dataset_ops.DatasetSource):
+  """A `Dataset` whose elements are produced by tf.data service workers."""
+
+  def __init__(self, dispatcher_address, dataset_fn, num_splits, job_name,
+               max_outstanding_requests):
+    """See `from_data_service()` for details."""
+    super(_DataServiceDataset, self).__init__()
+    # The dataset of a split is built in a graph of its own, which the workers
+    # import and run with the index of their split fed to `split`.
+    with ops.Graph().as_default() as g:
+      split = array_ops.placeholder(dtypes.int64, shape=[], name="split_index")
+      dataset = dataset_fn(split)
+      if not isinstance(dataset, dataset_ops.Dataset):
+        raise TypeError("`dataset_fn` must return a `Dataset`.")
+      variant = dataset._as_variant_tensor()  # pylint: disable=protected-access
+    self._output_classes = dataset.output_classes
+    self._output_shapes = dataset.output_shapes
+    self._output_types = dataset.output_types
+    self._dispatcher_address = ops.convert_to_tensor(
+        dispatcher_address, dtype=dtypes.string, name="dispatcher_address")
+    self._job_name = ops.convert_to_tensor(
+        job_name if job_name is not None else "", dtype=dtypes.string,
+        name="job_name")
+    self._graph_def = ops.convert_to_tensor(
+        g.as_graph_def().SerializeToString(), dtype=dtypes.string,
+        name="graph_def")
+    self._dataset_tensor = ops.convert_to_tensor(
+        variant.name, dtype=dtypes.string, name="dataset_tensor")
+    self._split_tensor = ops.convert_to_tensor(
+        split.name, dtype=dtypes.string, name="split_tensor")
+    self._num_splits = ops.convert_to_tensor(
+        num_splits, dtype=dtypes.int64, name="num_splits")
+    self._max_outstanding_requests = max_outstanding_requests
+
+  def _as_variant_tensor(self):
+    return gen_experimental_dataset_ops.experimental_data_service_dataset(
+        self._dispatcher_address,
+        self._job_name,
+        self._graph_def,
+        self._dataset_tensor,
+        self._split_tensor,
+        self._num_splits,
+        max_outstanding_requests=self._max_outstanding_requests,
+        **dataset_ops.flat_structure(self))
+
+  @property
+  def output_classes(self):
+    return self._output_classes
+
+  @property
+  def output_shapes(self):
+    return self._output_shapes
+
+  @property
+  def output_types(self):
+    return self._output_types
+
+
+@tf_export("data.experimental.from_data_service")
+def from_data_service(dispatcher_address, dataset_fn, num_splits,
+                      job_name=None, max_outstanding_requests=4):
+  """Creates a `Dataset` whose elements are produced by the tf.data service.
+
+  The tf.data service runs input pipelines on a pool of CPU workers, so that
+  preprocessing is not limited by the CPUs of the host consuming the elements.
+  It consists of a dispatcher and any number of workers registered with it,
+  each started with the `data_service_server` binary:
+
+  ```sh
+  data_service_server --role=dispatcher --port=5000
+  data_service_server --role=worker --port=5001 \
+      --dispatcher_address=dispatcher:5000
+  ```
+
+  The input is divided into `num_splits` splits, and `dataset_fn` builds the
+  dataset of split `i` from a scalar `tf.int64` tensor holding `i`:
+
+  ```python
+  def dataset_fn(split):
+    return (tf.data.TFRecordDataset(tf.gather(filenames, split))
+            .map(expensive_preprocessing).batch(32))
+
+  dataset = tf.data.experimental.from_data_service(
+      "dispatcher:5000", dataset_fn, num_splits=len(filenames))
+  ```
+
+  The dispatcher hands out each split once to a worker, which produces all
+  elements of the dataset of the split. The returned dataset fetches them from
+  all workers, in the order they arrive, until the splits are exhausted.
+  Datasets created with the same `job_name` share the splits of one job, e.g.
+  to divide an epoch between several consumers.
+
+  The service keeps its state in memory and does not recover from failures:
+  the splits handed to a failed worker are lost. The graph built by
+  `dataset_fn` must be serializable, e.g. it cannot use
+  `tf.data.Dataset.from_generator`, and iterators of the returned dataset
+  cannot be checkpointed.
+
+  Args:
+    dispatcher_address: A `tf.string` scalar `tf.Tensor`, the "host:port" of
+      the dispatcher.
+    dataset_fn: A function mapping a scalar `tf.int64` tensor, the index of a
+      split, to the `Dataset` of the split.
+    num_splits: A `tf.int64` scalar `tf.Tensor`, the number of splits.
+    job_name: (Optional.) A `tf.string` scalar `tf.Tensor`. Datasets with the
+      same job name share one job.
+    max_outstanding_requests: (Optional.) The maximum number of elements
+      requested from the workers or buffered at once.
+
+  Returns:
+    A `Dataset`.
+  """
+  return _DataServiceDataset(dispatcher_address, dataset_fn, num_splits,
+                             job_name, max_outstanding_requests)
+
+
+class _DynamicShardDataset(dataset_ops.DatasetSource):
+  """A `Dataset` of the split indices handed out by the tf.data service."""
+
+  def __init__(self, dispatcher_address, job_name, num_splits, worker_name):
+    """See `dynamic_shard()` for details."""
+    super(_DynamicShardDataset, self).__init__()
+    self._dispatcher_address = ops.convert_to_tensor(
+        dispatcher_address, dtype=dtypes.string, name="dispatcher_address")
+    self._job_name = ops.convert_to_tensor(
+        job_name, dtype=dtypes.string, name="job_name")
+    self._num_splits = ops.convert_to_tensor(
+        num_splits, dtype=dtypes.int64, name="num_splits")
+    self._worker_name = ops.convert_to_tensor(
+        worker_name, dtype=dtypes.string, name="worker_name")
+
+  def _as_variant_tensor(self):
+    return gen_experimental_dataset_ops.experimental_dynamic_shard_dataset(
+        self._dispatcher_address,
+        self._job_name,
+        self._num_splits,
+        self._worker_name,
+        **dataset_ops.flat_structure(self))
+
+  @property
+  def output_classes(self):
+    return ops.Tensor
+
+  @property
+  def output_shapes(self):
+    return tensor_shape.scalar()
+
+  @property
+  def output_types(self):
+    return dtypes.int64
+
+
+@tf_export("data.experimental.dynamic_shard")
+def dynamic_shard(dispatcher_address, job_name, num_splits, worker_name):
+  """Creates a `Dataset` of split indices handed out on demand by a dispatcher.
+
+  Unlike `tf.data.Dataset.shard`, which assigns a fixed part of the input to
+  each worker, the workers of a job ask the tf.data service dispatcher (see
+  `tf.data.experimental.from_data_service`) for the next unprocessed split
+  whenever they need one. Each split `0, ..., num_splits - 1` is produced by
+  exactly one worker, and workers that finish their splits early take over the
+  remaining ones instead of idling at the end of an epoch:
+
+  ```python
+  filenames = tf.constant([...])
+  dataset = tf.data.experimental.dynamic_shard(
+      "dispatcher:5000", "train_epoch_0", num_splits=tf.size(filenames),
+      worker_name="worker_%d" % task_index)
+  dataset = dataset.flat_map(
+      lambda split: tf.data.TFRecordDataset(tf.gather(filenames, split)))
+  ```
+
+  The dispatcher remembers the splits it handed out to each `worker_name`, and
+  an iterator restored from a checkpoint replays the splits that were handed
+  out to it after the checkpoint, so a restarted worker neither skips nor
+  duplicates splits. The dispatcher itself keeps this state in memory.
+
+  Args:
+    dispatcher_address: A `tf.string` scalar `tf.Tensor`, the "host:port" of
+      the dispatcher.
+    job_name: A `tf.string` scalar `tf.Tensor`. The datasets with the same job
+      name share its splits.
+    num_splits: A `tf.int64` scalar `tf.Tensor`, the number of splits.
+    worker_name: A `tf.string` scalar `tf.Tensor`, which identifies this worker
+      across restarts.
+
+  Returns:
+    A `Dataset` of scalar `tf.int64` split indices.
+  """
+  return _DynamicShardDataset(dispatcher_address, job_name, num_splits,
+                              worker_name)
@@ -0,0 +1,112 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Snapshot dataset transformations."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.util import random_seed
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import gen_experimental_dataset_ops
+from tensorflow.python.util.tf_export import tf_export
+
+
+class _SnapshotDataset(dataset_ops.UnaryDataset):
+  """A `Dataset` that materializes its input to a snapshot on disk."""
+
+  def __init__(self, input_dataset, path, compression, num_shards,
+               shuffle_shards, seed):
+    """See `snapshot()` for details."""
+    super(_SnapshotDataset, self).__init__(input_dataset)
+    self._input_dataset = input_dataset
+    self._path = ops.convert_to_tensor(path, dtype=dtypes.string, name="path")
+    self._compression = compression if compression is not None else ""
+    self._num_shards = num_shards
+    self._shuffle_shards = shuffle_shards
+    self._seed, self._seed2 = random_seed.get_seed(seed)
+
+  def _as_variant_tensor(self):
+    return gen_experimental_dataset_ops.experimental_snapshot_dataset(
+        self._input_dataset._as_variant_tensor(),  # pylint: disable=protected-access
+        path=self._path,
+        seed=self._seed,
+        seed2=self._seed2,
+        compression=self._compression,
+        num_shards=self._num_shards,
+        shuffle_shards=self._shuffle_shards,
+        **dataset_ops.flat_structure(self))
+
+  @property
+  def output_classes(self):
+    return self._input_dataset.output_classes
+
+  @property
+  def output_shapes(self):
+    return self._input_dataset.output_shapes
+
+  @property
+  def output_types(self):
+    return self._input_dataset.output_types
+
+
+@tf_export("data.experimental.snapshot")
+def snapshot(path, compression=None, num_shards=8, shuffle_shards=False,
+             seed=None):
+  """Materializes a `Dataset` to a snapshot on disk, and reads it back later.
+
+  The snapshot of the input dataset is kept in a subdirectory of `path` named
+  after a fingerprint of the graph of the input dataset, so jobs running the
+  same input pipeline share it, while changing the pipeline starts a new
+  snapshot:
+
+  ```python
+  dataset = tf.data.TFRecordDataset(filenames).map(expensive_preprocessing)
+  dataset = dataset.apply(tf.data.experimental.snapshot("/data/snapshots"))
+  ```
+
+  While no snapshot exists, the elements of the input dataset are passed
+  through and written to `num_shards` new shards in the background, element
+  `i` going to shard `i % num_shards`. The snapshot becomes visible once the
+  input dataset is exhausted, and iterators created afterwards read it instead
+  of running the input pipeline. Unless `shuffle_shards` is set, they read
+  the elements in the order they were written. Several jobs may write the same
+  snapshot at once, in which case the first to finish publishes its shards.
+
+  The input dataset must be serializable, e.g. it cannot use
+  `tf.data.Dataset.from_generator` or stateful functions, and iterators that
+  write a snapshot cannot be checkpointed.
+
+  Args:
+    path: A `tf.string` scalar `tf.Tensor`, the directory holding snapshots.
+    compression: (Optional.) The compression of the shards of new snapshots,
+      one of `""` (no compression), `"ZLIB"`, or `"GZIP"`.
+    num_shards: (Optional.) The number of shards of new snapshots.
+    shuffle_shards: (Optional.) Whether to read the shards of a snapshot in a
+      random order.
+    seed: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the random
+      seed that shuffles the shards. See `tf.set_random_seed` for behavior.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    `tf.data.Dataset.apply`.
+  """
+
+  def _apply_fn(dataset):
+    return _SnapshotDataset(dataset, path, compression, num_shards,
+                            shuffle_shards, seed)
+
+  return _apply_fn
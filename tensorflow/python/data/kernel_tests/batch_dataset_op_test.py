@@ -116,6 +116,26 @@ class BatchDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
       with self.assertRaises(errors.InvalidArgumentError):
         sess.run(get_next)
 
+  @parameterized.named_parameters(
+      ('preallocated', 4),
+      ('collected', 1 << 20),
+  )
+  def testBatchStringsWithRemainder(self, batch_size):
+    # Batches of up to 2**14 elements are preallocated, and the last batch is
+    # a prefix of its preallocated rows. Larger batches are allocated once the
+    # number of elements is known.
+    iterator = dataset_ops.Dataset.range(10).map(
+        string_ops.as_string).batch(batch_size).make_one_shot_iterator()
+    get_next = iterator.get_next()
+
+    with self.cached_session() as sess:
+      expected = [compat.as_bytes(str(i)) for i in range(10)]
+      for start in range(0, 10, batch_size):
+        self.assertAllEqual(expected[start:start + batch_size],
+                            sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
   def testBatchSparse(self):
 
     def _sparse(i):
@@ -200,6 +200,48 @@ class FileCacheDatasetTest(test_base.DatasetTestBase):
       self.assertAllEqual(elements, elements_itr1)
       self.assertAllEqual(elements, elements_itr2)
 
+  def testShuffledReads(self):
+    filename_placeholder = array_ops.placeholder(dtypes.string, shape=[])
+    cache_dataset = dataset_ops.Dataset.range(100).cache(
+        filename_placeholder, shuffle_reads=True)
+
+    iterator1 = cache_dataset.make_initializable_iterator()
+    iterator2 = cache_dataset.make_initializable_iterator()
+    get_next1 = iterator1.get_next()
+    get_next2 = iterator2.get_next()
+
+    with self.cached_session() as sess:
+      # Elements that are being written to the cache are produced in order.
+      sess.run(
+          iterator1.initializer,
+          feed_dict={filename_placeholder: self.cache_prefix})
+      self.assertEqual(list(range(100)), [sess.run(get_next1)
+                                          for _ in range(100)])
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next1)
+
+      # Readers of the written cache run concurrently, each in its own order.
+      sess.run(
+          iterator1.initializer,
+          feed_dict={filename_placeholder: self.cache_prefix})
+      sess.run(
+          iterator2.initializer,
+          feed_dict={filename_placeholder: self.cache_prefix})
+      elements_itr1 = []
+      elements_itr2 = []
+      for _ in range(100):
+        elements_itr1.append(sess.run(get_next1))
+        elements_itr2.append(sess.run(get_next2))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next1)
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next2)
+
+      self.assertItemsEqual(range(100), elements_itr1)
+      self.assertItemsEqual(range(100), elements_itr2)
+      self.assertNotEqual(list(range(100)), elements_itr1)
+      self.assertNotEqual(elements_itr1, elements_itr2)
+
 
 class MemoryCacheDatasetTest(test_base.DatasetTestBase):
 
@@ -44,6 +44,20 @@ class PrefetchDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(get_next)
 
+  @parameterized.parameters((16), (64))
+  def testRefillsFullBuffer(self, buffer_size):
+    # The prefetch thread is woken to refill the buffer once a batch of its
+    # slots are free, which must not drop or reorder elements.
+    iterator = dataset_ops.Dataset.range(1000).map(
+        lambda x: x * x).prefetch(buffer_size).make_one_shot_iterator()
+    get_next = iterator.get_next()
+
+    with self.cached_session() as sess:
+      for m in range(1000):
+        self.assertEqual(m * m, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
   @parameterized.parameters((-2), (-42))
   def testInvalidBufferSize(self, buffer_size):
     buffer_size_t = array_ops.placeholder(dtypes.int64, shape=[])
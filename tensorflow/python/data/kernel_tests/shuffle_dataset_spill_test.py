@@ -0,0 +1,81 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for spilling the buffer of `Dataset.shuffle()` to disk."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+import tempfile
+
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.platform import test
+
+# The spill options are read once per process, when the first shuffle
+# iterator is created.
+_SPILL_DIR = tempfile.mkdtemp()
+os.environ["TF_DATA_SHUFFLE_SPILL_DIR"] = _SPILL_DIR
+os.environ["TF_DATA_SHUFFLE_MEMORY_LIMIT_MB"] = "1"
+
+# Elements of 256KB, so that a buffer of 20 elements spills most of them.
+_ELEMENT_SIZE = 64 * 1024
+
+
+def _make_dataset(num_elements, buffer_size, seed):
+  return dataset_ops.Dataset.range(num_elements).map(
+      lambda x: array_ops.fill([_ELEMENT_SIZE], math_ops.cast(
+          x, dtypes.float32))).shuffle(buffer_size, seed=seed)
+
+
+class ShuffleDatasetSpillTest(test_base.DatasetTestBase):
+
+  def testProducesPermutation(self):
+    iterator = _make_dataset(50, 20, seed=37).repeat(2).make_one_shot_iterator()
+    get_next = iterator.get_next()
+
+    with self.cached_session() as sess:
+      for _ in range(2):
+        values = []
+        for _ in range(50):
+          element = sess.run(get_next)
+          self.assertTrue((element == element[0]).all())
+          values.append(int(element[0]))
+        self.assertEqual(list(range(50)), sorted(values))
+        self.assertNotEqual(list(range(50)), values)
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+    # The spill file is deleted once the buffer no longer spills elements.
+    self.assertEqual([], os.listdir(_SPILL_DIR))
+
+  def testMatchesInMemoryOrder(self):
+    # Spilling only changes where elements are held, not the shuffle order.
+    spilled = _make_dataset(30, 20, seed=11).map(lambda x: x[0])
+    in_memory = dataset_ops.Dataset.range(30).map(
+        lambda x: math_ops.cast(x, dtypes.float32)).shuffle(20, seed=11)
+    spilled_next = spilled.make_one_shot_iterator().get_next()
+    in_memory_next = in_memory.make_one_shot_iterator().get_next()
+
+    with self.cached_session() as sess:
+      for _ in range(30):
+        self.assertEqual(*sess.run([spilled_next, in_memory_next]))
+
+
+if __name__ == "__main__":
+  test.main()
@@ -768,18 +768,22 @@ class Dataset(object):
     """
     return ShuffleDataset(self, buffer_size, seed, reshuffle_each_iteration)
 
-  def cache(self, filename=""):
+  def cache(self, filename="", shuffle_reads=False):
     """Caches the elements in this dataset.
 
     Args:
       filename: A `tf.string` scalar `tf.Tensor`, representing the name of a
         directory on the filesystem to use for caching tensors in this Dataset.
         If a filename is not provided, the dataset will be cached in memory.
+      shuffle_reads: (Optional.) A boolean, which if true indicates that every
+        iterator over a completely written file cache produces the cached
+        elements in a new random order. Elements that are being written to the
+        cache, and elements cached in memory, are produced in input order.
 
     Returns:
       Dataset: A `Dataset`.
     """
-    return CacheDataset(self, filename)
+    return CacheDataset(self, filename, shuffle_reads)
 
   def take(self, count):
     """Creates a `Dataset` with at most `count` elements from this dataset.
@@ -1404,6 +1408,10 @@ class Options(object):
       ("experimental_autotune", bool,
        "Whether to dynamically adjust the values of tunable parameters (e.g. "
        "degrees of parallelism)."),
+      ("experimental_decode_and_resize_fusion", bool,
+       "Whether to fuse JPEG decoding, cropping, resizing and normalization "
+       "in map transformations into a single op. The fused op may decode the "
+       "image at a reduced scale, which changes the outputs slightly."),
       ("experimental_deterministic", bool,
        "Whether the outputs need to be produced in deterministic order."),
       ("experimental_filter_fusion", bool,
@@ -1467,10 +1475,10 @@ class Options(object):
   def _static_optimizations(self):
     """Produces the list of enabled static optimizations."""
     experimental_optimizations = [
-        "filter_fusion", "hoist_random_uniform", "latency_all_edges",
-        "map_and_batch_fusion", "map_and_filter_fusion", "map_fusion",
-        "map_parallelization", "map_vectorization", "noop_elimination",
-        "shuffle_and_repeat_fusion"
+        "decode_and_resize_fusion", "filter_fusion", "hoist_random_uniform",
+        "latency_all_edges", "map_and_batch_fusion", "map_and_filter_fusion",
+        "map_fusion", "map_parallelization", "map_vectorization",
+        "noop_elimination", "shuffle_and_repeat_fusion"
     ]
     result = []
     for exp_opt in experimental_optimizations:
@@ -1503,6 +1511,7 @@ class Options(object):
     for other in [self, options]:
       for name in [
           "experimental_autotune",
+          "experimental_decode_and_resize_fusion",
           "experimental_deterministic",
           "experimental_filter_fusion",
           "experimental_hoist_random_uniform",
@@ -2272,17 +2281,19 @@ class RangeDataset(DatasetSource):
 class CacheDataset(UnaryDataset):
   """A `Dataset` that caches elements of its input."""
 
-  def __init__(self, input_dataset, filename):
+  def __init__(self, input_dataset, filename, shuffle_reads=False):
     """See `Dataset.cache()` for details."""
     super(CacheDataset, self).__init__(input_dataset)
     self._input_dataset = input_dataset
     self._filename = ops.convert_to_tensor(
         filename, dtype=dtypes.string, name="filename")
+    self._shuffle_reads = shuffle_reads
 
   def _as_variant_tensor(self):
     return gen_dataset_ops.cache_dataset(
         self._input_dataset._as_variant_tensor(),  # pylint: disable=protected-access
         filename=self._filename,
+        shuffle_reads=self._shuffle_reads,
         **flat_structure(self))
 
   @property
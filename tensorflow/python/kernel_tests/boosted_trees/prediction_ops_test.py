@@ -1058,6 +1058,83 @@ class PredictionOpsTest(test_util.TensorFlowTestCase):
       logits = session.run(predict_op)
       self.assertAllClose(expected_logits, logits)
 
+  def testPredictionAfterDeserialize(self):
+    """Tests predicting with an ensemble replaced under the same stamp."""
+    with self.cached_session() as session:
+      tree_ensemble_config = boosted_trees_pb2.TreeEnsemble()
+      text_format.Merge("""
+        trees {
+          nodes {
+            bucketized_split {
+              feature_id: 0
+              threshold: 49
+              left_id: 1
+              right_id: 2
+            }
+          }
+          nodes {
+            leaf {
+              scalar: 1.0
+            }
+          }
+          nodes {
+            leaf {
+              scalar: 2.0
+            }
+          }
+        }
+        tree_weights: 1.0
+      """, tree_ensemble_config)
+      tree_ensemble = boosted_trees_ops.TreeEnsemble(
+          'ensemble',
+          stamp_token=3,
+          serialized_proto=tree_ensemble_config.SerializeToString())
+      tree_ensemble_handle = tree_ensemble.resource_handle
+      resources.initialize_resources(resources.shared_resources()).run()
+
+      # Enough examples for several blocks of examples per tree.
+      feature_0_values = list(range(200))
+      predict_op = boosted_trees_ops.predict(
+          tree_ensemble_handle,
+          bucketized_features=[feature_0_values],
+          logits_dimension=1)
+      expected_logits = [[1.0 if value <= 49 else 2.0]
+                         for value in feature_0_values]
+      self.assertAllClose(expected_logits, session.run(predict_op))
+
+      # Add a second tree, keeping the stamp.
+      text_format.Merge("""
+        trees {
+          nodes {
+            bucketized_split {
+              feature_id: 0
+              threshold: 149
+              left_id: 1
+              right_id: 2
+            }
+          }
+          nodes {
+            leaf {
+              scalar: 0.0
+            }
+          }
+          nodes {
+            leaf {
+              scalar: 10.0
+            }
+          }
+        }
+        tree_weights: 0.5
+      """, tree_ensemble_config)
+      session.run(
+          tree_ensemble.deserialize(
+              stamp_token=3,
+              serialized_proto=tree_ensemble_config.SerializeToString()))
+      expected_logits = [[(1.0 if value <= 49 else 2.0) +
+                          (0.0 if value <= 149 else 5.0)]
+                         for value in feature_0_values]
+      self.assertAllClose(expected_logits, session.run(predict_op))
+
 
 class FeatureContribsOpsTest(test_util.TensorFlowTestCase):
   """Tests feature contribs ops for model understanding."""
@@ -17,6 +17,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import numpy as np
+
 from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import test_util
@@ -391,6 +393,32 @@ class StatsOpsTest(test_util.TensorFlowTestCase):
           ],
           result.eval())
 
+  def testMakeStatsSummaryManyFeatures(self):
+    """Tests MakeStatsSummary with enough features to be sharded."""
+    with self.cached_session():
+      max_splits = 5
+      num_buckets = 7
+      num_features = 64
+      batch_size = 1000
+      rng = np.random.RandomState(0)
+      node_ids = rng.randint(max_splits, size=batch_size).astype(np.int32)
+      gradients = rng.randn(batch_size, 1).astype(np.float32)
+      hessians = rng.rand(batch_size, 1).astype(np.float32)
+      bucketized_features = rng.randint(
+          num_buckets, size=[num_features, batch_size]).astype(np.int32)
+
+      expected = np.zeros([num_features, max_splits, num_buckets, 2])
+      for feature in range(num_features):
+        for i in range(batch_size):
+          bucket = bucketized_features[feature, i]
+          expected[feature, node_ids[i], bucket, 0] += gradients[i, 0]
+          expected[feature, node_ids[i], bucket, 1] += hessians[i, 0]
+
+      result = boosted_trees_ops.make_stats_summary(
+          node_ids, gradients, hessians, list(bucketized_features),
+          max_splits, num_buckets)
+      self.assertAllClose(expected, result.eval())
+
   def _verify_precision(self, length):
     with self.cached_session():
       max_splits = 1
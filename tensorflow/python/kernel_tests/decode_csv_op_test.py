@@ -144,6 +144,17 @@ class DecodeCSVOpTest(test.TestCase):
 
     self._test(args, expected_out)
 
+  def testEscapedQuotesInSeveralFields(self):
+    args = {
+        "records": ['"a""b",x,"""c""","""",y', 'd,"e""",f,"",g'],
+        "record_defaults": [[""], [""], [""], [""], [""]]
+    }
+
+    expected_out = [[b'a"b', b"d"], [b"x", b'e"'], [b'"c"', b"f"],
+                    [b'"', b""], [b"y", b"g"]]
+
+    self._test(args, expected_out)
+
   def testMultiRecords(self):
     args = {
         "records": ["1.0,4,aa", "0.2,5,bb", "3,6,cc"],
@@ -32,10 +32,12 @@ from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import data_flow_ops
 from tensorflow.python.ops import embedding_ops
 from tensorflow.python.ops import gradient_checker
+from tensorflow.python.ops import gradients_impl
 from tensorflow.python.ops import init_ops
 from tensorflow.python.ops import linalg_ops
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import partitioned_variables
+from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.ops import state_ops
 from tensorflow.python.ops import variable_scope
 from tensorflow.python.ops import variables
@@ -508,6 +510,44 @@ class EmbeddingLookupTest(test.TestCase):
             x, x_shape, y, y_shape, x_init_value=x_init_value)
       self.assertLess(err, 1e-3)
 
+  def testGradientsShardedDivPartitioningResourceVariable(self):
+    with self.cached_session():
+      p = [
+          resource_variable_ops.ResourceVariable(
+              array_ops.ones([3, 1], dtype=dtypes.float32)),
+          resource_variable_ops.ResourceVariable(
+              array_ops.ones([2, 1], dtype=dtypes.float32))
+      ]
+      ids = constant_op.constant([4, 0, 4], dtype=dtypes.int32)
+      y = embedding_ops.embedding_lookup(p, ids, partition_strategy="div")
+      grads = gradients_impl.gradients(math_ops.reduce_sum(y), p)
+      variables.global_variables_initializer().run()
+      self.assertAllEqual([[1], [1], [1]], y.eval())
+      self.assertAllEqual([[1], [0], [0]],
+                          ops.convert_to_tensor(grads[0]).eval())
+      self.assertAllEqual([[0], [2]], ops.convert_to_tensor(grads[1]).eval())
+
+  def testShardedLookupOnOneDeviceSkipsStitch(self):
+    with ops.Graph().as_default() as g:
+      ids = constant_op.constant([0, 1, 1, 7], dtype=dtypes.int32)
+      with ops.device("/cpu:0"):
+        p = [array_ops.zeros([4, 3]), array_ops.zeros([4, 3])]
+      embedding_ops.embedding_lookup(p, ids)
+      op_types = set(op.type for op in g.get_operations())
+      self.assertIn("ShardedGather", op_types)
+      self.assertNotIn("DynamicStitch", op_types)
+
+    with ops.Graph().as_default() as g:
+      ids = constant_op.constant([0, 1, 1, 7], dtype=dtypes.int32)
+      p = []
+      for task in range(2):
+        with ops.device("/job:ps/task:%d" % task):
+          p.append(array_ops.zeros([4, 3]))
+      embedding_ops.embedding_lookup(p, ids)
+      op_types = set(op.type for op in g.get_operations())
+      self.assertNotIn("ShardedGather", op_types)
+      self.assertIn("DynamicStitch", op_types)
+
   def testConstructionNonSharded(self):
     with ops.Graph().as_default():
       p = variables.Variable(
@@ -733,6 +773,30 @@ class EmbeddingLookupSparseTest(test.TestCase):
             x, x_shape, y, y_shape, x_init_value=x_init_value)
       self.assertLess(err, 1e-5 if dtype == dtypes.float64 else 2e-3)
 
+  def testGradientsEmbeddingLookupSparseWeights(self):
+    vocab_size = 12
+    batch_size = 4
+    param_shape = [2, 3]
+    sp_ids, sp_weights, _, weights, _ = (self._RandomIdsAndWeights(
+        batch_size, vocab_size))
+
+    for combiner in ["sum", "mean", "sqrtn"]:
+      with self.cached_session():
+        x, params, feed_dict = _EmbeddingParams(
+            1, vocab_size, shape=param_shape, dtype=dtypes.float64)
+        w = constant_op.constant(weights, dtypes.float64)
+        y = embedding_ops.embedding_lookup_sparse(
+            x,
+            sp_ids,
+            sparse_tensor.SparseTensor(sp_weights.indices, w,
+                                       sp_weights.dense_shape),
+            combiner=combiner)
+        y_shape = [batch_size] + list(params[_PName(0) + ":0"].shape[1:])
+        err = gradient_checker.compute_gradient_error(
+            w, weights.shape, y, y_shape, x_init_value=weights,
+            extra_feed_dict=feed_dict)
+      self.assertLess(err, 1e-5)
+
   def testIncompatibleShapes(self):
     with self.cached_session():
       x, _, _ = _EmbeddingParams(1, 10, dtype=dtypes.float32)
@@ -372,6 +372,21 @@ class FIFOQueueTest(test.TestCase):
       self.assertAllEqual(elems[0:4], dequeued_t.eval())
       self.assertAllEqual(elems[4:8], dequeued_t.eval())
 
+  def testDequeueManyAfterSingleEnqueues(self):
+    with self.cached_session():
+      q = data_flow_ops.FIFOQueue(10, (dtypes_lib.int32, dtypes_lib.string),
+                                  ((2,), ()))
+      elems = [([i, -i], str(i).encode("ascii")) for i in range(6)]
+      for x, s in elems:
+        q.enqueue((x, s)).run()
+      dequeued_t = q.dequeue_many(3)
+
+      for begin in (0, 3):
+        x, s = self.evaluate(dequeued_t)
+        self.assertAllEqual([e[0] for e in elems[begin:begin + 3]], x)
+        self.assertAllEqual([e[1] for e in elems[begin:begin + 3]], s)
+      self.assertEqual(0, q.size().eval())
+
   def testDequeueUpToNoBlocking(self):
     with self.cached_session():
       q = data_flow_ops.FIFOQueue(10, dtypes_lib.float32, ())
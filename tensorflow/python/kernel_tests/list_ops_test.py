@@ -349,6 +349,48 @@ class ListOpsTest(test_util.TensorFlowTestCase):
       s1 = list_ops.tensor_list_stack(t1, element_dtype=dtypes.int32)
       self.assertAllEqual(self.evaluate(s1), [0, 1, 2, 3])
 
+  @test_util.run_in_graph_and_eager_modes
+  def testModifyingSharedListDoesNotChangeIt(self):
+    l = list_ops.tensor_list_from_tensor(
+        constant_op.constant([1.0, 2.0]), element_shape=scalar_shape())
+    l_pushed = list_ops.tensor_list_push_back(l, constant_op.constant(3.0))
+    l_set = list_ops.tensor_list_set_item(l, 0, 4.0)
+    l_popped, e = list_ops.tensor_list_pop_back(
+        l, element_dtype=dtypes.float32)
+    t = list_ops.tensor_list_stack(l, element_dtype=dtypes.float32)
+    t_pushed = list_ops.tensor_list_stack(
+        l_pushed, element_dtype=dtypes.float32)
+    t_set = list_ops.tensor_list_stack(l_set, element_dtype=dtypes.float32)
+    t_popped = list_ops.tensor_list_stack(
+        l_popped, element_dtype=dtypes.float32)
+    self.assertAllEqual(self.evaluate(t), [1.0, 2.0])
+    self.assertAllEqual(self.evaluate(t_pushed), [1.0, 2.0, 3.0])
+    self.assertAllEqual(self.evaluate(t_set), [4.0, 2.0])
+    self.assertAllEqual(self.evaluate(t_popped), [1.0])
+    self.assertAllEqual(self.evaluate(e), 2.0)
+
+  @test_util.run_in_graph_and_eager_modes
+  def testGraphStackAndGatherVectorsInLoop(self):
+    with self.cached_session():
+      t1 = list_ops.empty_tensor_list(
+          element_shape=constant_op.constant([3], dtype=dtypes.int32),
+          element_dtype=dtypes.int32)
+      i = constant_op.constant(0, dtype=dtypes.int32)
+
+      def body(i, t1):
+        t1 = list_ops.tensor_list_push_back(t1, array_ops.fill([3], i))
+        i += 1
+        return i, t1
+
+      i, t1 = control_flow_ops.while_loop(lambda i, t1: math_ops.less(i, 100),
+                                          body, [i, t1])
+      s1 = list_ops.tensor_list_stack(t1, element_dtype=dtypes.int32)
+      g1 = list_ops.tensor_list_gather(t1, [99, 0, 50],
+                                       element_dtype=dtypes.int32)
+      self.assertAllEqual(self.evaluate(s1),
+                          [[j, j, j] for j in range(100)])
+      self.assertAllEqual(self.evaluate(g1), [[99] * 3, [0] * 3, [50] * 3])
+
   def testGraphStackSwitchDtype(self):
     with self.cached_session():
       list_ = list_ops.empty_tensor_list(
@@ -324,6 +324,31 @@ class IndexTableFromFile(test.TestCase):
       lookup_ops.tables_initializer().run()
       self.assertAllEqual((1, 2, 3), ids.eval())
 
+  def test_string_index_table_from_file_of_many_blocks(self):
+    # The file is read in blocks of 1MB, so the lines below span several
+    # blocks, and some cross the boundary between two of them.
+    vocab_size = 300000
+    vocabulary_file = self._createVocabFile(
+        "f2i_vocab_large.txt",
+        values=["word%d\t%d" % (i, 2 * i) for i in range(vocab_size)])
+    keys = ["word0", "word99999", "word150000", "word299999", "tarkus"]
+    with self.cached_session():
+      table = lookup_ops.index_table_from_file(
+          vocabulary_file=vocabulary_file,
+          key_column_index=0,
+          value_column_index=lookup_ops.TextFileIndex.LINE_NUMBER)
+      ids = table.lookup(constant_op.constant(keys))
+      truncated_table = lookup_ops.index_table_from_file(
+          vocabulary_file=vocabulary_file,
+          vocab_size=150001,
+          key_column_index=0,
+          value_column_index=lookup_ops.TextFileIndex.LINE_NUMBER)
+      truncated_ids = truncated_table.lookup(constant_op.constant(keys))
+
+      lookup_ops.tables_initializer().run()
+      self.assertAllEqual((0, 99999, 150000, 299999, -1), ids.eval())
+      self.assertAllEqual((0, 99999, 150000, -1, -1), truncated_ids.eval())
+
   def test_string_index_table_from_multicolumn_file_custom_delimiter(self):
     vocabulary_file = self._createVocabFile(
         "f2i_vocab1.txt", values=("brain 300", "salad 20", "surgery 1"))
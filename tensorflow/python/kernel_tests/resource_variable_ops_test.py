@@ -238,6 +238,18 @@ class ResourceVariableOpsTest(test_util.TensorFlowTestCase):
     read = resource_variable_ops.read_variable_op(handle, dtype=dtypes.int32)
     self.assertEqual(self.evaluate(read), [[3]])
 
+  def testScatterAddDoesNotChangeOutstandingRead(self):
+    if os.environ.get(
+        "TF_RESOURCE_VARIABLE_SPARSE_UPDATE_IN_PLACE", "0") != "0":
+      self.skipTest("Sparse updates write into outstanding reads.")
+    with context.eager_mode():
+      v = resource_variable_ops.ResourceVariable([[1], [2]])
+      before = v.read_value()
+      v.scatter_add(ops.IndexedSlices(
+          constant_op.constant([[3]]), constant_op.constant([1])))
+      self.assertAllEqual(before, [[1], [2]])
+      self.assertAllEqual(v.read_value(), [[1], [5]])
+
   @test_util.run_in_graph_and_eager_modes
   def testScatterSub(self):
     handle = resource_variable_ops.var_handle_op(
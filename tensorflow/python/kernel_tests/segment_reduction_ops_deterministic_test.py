@@ -0,0 +1,81 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for segment sums with TF_DETERMINISTIC_SEGMENT_REDUCTIONS set."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+import numpy as np
+
+from tensorflow.python.framework import constant_op
+from tensorflow.python.ops import math_ops
+from tensorflow.python.platform import test
+
+
+# The flag is read once per process, so it is set before any kernel runs.
+os.environ["TF_DETERMINISTIC_SEGMENT_REDUCTIONS"] = "1"
+
+
+class DeterministicSegmentSumTest(test.TestCase):
+
+  def _testReproducible(self, fn, np_ans):
+    with self.cached_session(use_gpu=True) as sess:
+      result = fn()
+      first = sess.run(result)
+      self.assertAllClose(np_ans, first, rtol=1e-3, atol=1e-3)
+      for _ in range(5):
+        self.assertAllEqual(first, sess.run(result))
+
+  def testSegmentSum(self):
+    np.random.seed(0)
+    np_x = np.random.randn(20000, 8).astype(np.float32)
+    # A few large segments, which the atomic kernel sums in no fixed order.
+    indices = np.sort(np.random.randint(0, 4, size=20000))
+    np_ans = np.zeros([4, 8], dtype=np.float32)
+    np.add.at(np_ans, indices, np_x)
+    x = constant_op.constant(np_x)
+    self._testReproducible(
+        lambda: math_ops.segment_sum(x, indices), np_ans)
+
+  def testUnsortedSegmentSum(self):
+    np.random.seed(0)
+    np_x = np.random.randn(20000, 8).astype(np.float32)
+    indices = np.random.randint(-1, 4, size=20000)
+    np_ans = np.zeros([5, 8], dtype=np.float32)
+    np.add.at(np_ans, indices, np_x)
+    x = constant_op.constant(np_x)
+    # Negative ids are dropped; np.add.at wrapped them into the last row.
+    self._testReproducible(
+        lambda: math_ops.unsorted_segment_sum(x, indices, num_segments=4),
+        np_ans[:4])
+
+  def testUnsortedSegmentSumMultiDimIds(self):
+    np_x = np.arange(24, dtype=np.float32).reshape(3, 4, 2)
+    indices = np.array([[0, 2, 2, 1], [1, 0, 5, 2], [2, 2, 0, 1]])
+    np_ans = np.zeros([3, 2], dtype=np.float32)
+    for i, j in np.ndindex(*indices.shape):
+      if indices[i, j] < 3:
+        np_ans[indices[i, j]] += np_x[i, j]
+    x = constant_op.constant(np_x)
+    self._testReproducible(
+        lambda: math_ops.unsorted_segment_sum(x, indices, num_segments=3),
+        np_ans)
+
+
+if __name__ == "__main__":
+  test.main()
@@ -244,6 +244,31 @@ class SegmentReductionOpTest(SegmentReductionHelper):
             delta=1)
       self.assertAllClose(jacob_t, jacob_n)
 
+  def testLargeInput(self):
+    # Large enough for the segments to be reduced by several threads.
+    np.random.seed(0)
+    np_x = np.random.randn(3000, 32).astype(np.float32)
+    indices = np.sort(np.random.randint(0, 500, size=3000))
+    ops_list = [(np.add, math_ops.segment_sum),
+                (np.ndarray.__mul__, math_ops.segment_prod),
+                (np.minimum, math_ops.segment_min),
+                (np.maximum, math_ops.segment_max)]
+    for use_gpu in [True, False]:
+      with self.cached_session(use_gpu=use_gpu):
+        for np_op, tf_op in ops_list:
+          np_ans = self._segmentReduce(indices, np_x, np_op)
+          tf_ans = tf_op(data=np_x, segment_ids=indices).eval()
+          self.assertAllClose(np_ans, tf_ans, rtol=1e-4, atol=1e-4)
+
+  def testLargeInputNotIncreasing(self):
+    indices = np.repeat(np.arange(1000), 4)
+    indices[2500] = 0
+    with self.cached_session(use_gpu=False):
+      s = math_ops.segment_sum(
+          data=np.ones([4000, 16], dtype=np.float32), segment_ids=indices)
+      with self.assertRaisesOpError("segment ids are not increasing"):
+        s.eval()
+
 
 class UnsortedSegmentTest(SegmentReductionHelper):
 
@@ -414,6 +439,35 @@ class UnsortedSegmentTest(SegmentReductionHelper):
             r"segment_ids\[0,0\] = %d is out of range \[0, 2\)" % bad[0][0]):
           unsorted.eval()
 
+  def testLargeInput(self):
+    # Large enough for the rows to be grouped by segment on several threads.
+    np.random.seed(0)
+    np_x = np.random.randn(4000, 16).astype(np.float32)
+    indices = np.random.randint(-1, 300, size=4000)
+    num_segments = 310
+    lowest = np.finfo(np.float32).min
+    for use_gpu in [True, False]:
+      with self.cached_session(use_gpu=use_gpu):
+        for np_op, tf_op, initial_value in [
+            (np.add, math_ops.unsorted_segment_sum, 0),
+            (np.maximum, math_ops.unsorted_segment_max, lowest)]:
+          # Negative ids are dropped, so reduce them into an extra segment.
+          np_ans = self._segmentReduce(
+              np.where(indices < 0, num_segments, indices), np_x, np_op,
+              num_segments=num_segments + 1, initial_value=initial_value)
+          tf_ans = tf_op(np_x, indices, num_segments=num_segments).eval()
+          self.assertAllClose(np_ans[:num_segments], tf_ans)
+
+  def testLargeInputBadIndices(self):
+    indices = np.zeros([3000], dtype=np.int32)
+    indices[2000] = 7
+    with self.session(use_gpu=False):
+      unsorted = math_ops.unsorted_segment_sum(
+          np.ones([3000, 16], dtype=np.float32), indices, num_segments=2)
+      with self.assertRaisesOpError(
+          r"segment_ids\[2000\] = 7 is out of range \[0, 2\)"):
+        unsorted.eval()
+
   def testEmptySecondDimension(self):
     dtypes = [np.float16, np.float32, np.float64, np.int64, np.int32,
               np.complex64, np.complex128]
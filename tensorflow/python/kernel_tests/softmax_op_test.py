@@ -236,6 +236,19 @@ class SoftmaxTest(test.TestCase):
           tf_softmax = sess.run(y, feed_dict={x: ones})
         self.assertAllClose(tf_softmax, np_softmax)
 
+  def testLongRowsWithInfinities(self):
+    # Rows that span several blocks of the online normalizer, with blocks
+    # whose maximum is -inf and blocks whose maximum is not the row's.
+    for cols in [127, 129, 1000, 4097, 9000]:
+      features = np.random.rand(3, cols).astype(np.float32)
+      features[0, :200] = -np.inf
+      features[1, ::7] = -np.inf
+      features[2, -1] = 20.
+      for use_gpu in [False, True]:
+        self._testSoftmax(features, use_gpu=use_gpu)
+        self._testSoftmax(features, log=True, use_gpu=use_gpu)
+        self._testSoftmax(features.astype(np.float64), use_gpu=use_gpu)
+
 
 if __name__ == "__main__":
   test.main()
@@ -352,6 +352,33 @@ class SparseCrossOpTest(test.TestCase):
       all_values_are_different = len(out.values) == len(set(out.values))
       self.assertTrue(all_values_are_different)
 
+  def test_hashed_large_batch(self):
+    """Tests hashed output with a batch large enough to force multithreading."""
+    batch_size = 5000
+    col1 = []
+    col2 = []
+    for b in range(batch_size):
+      col1.append(['batch%d-FC1-F1' % b, 'batch%d-FC1-F2' % b])
+      col2.append(['batch%d-FC2-F1' % b])
+    dense = constant_op.constant([['F%d' % (b % 7)] for b in range(batch_size)])
+
+    op = sparse_ops.sparse_cross_hashed(
+        [self._sparse_tensor(col1),
+         self._sparse_tensor(col2), dense],
+        num_buckets=1000)
+    with self.cached_session() as sess:
+      out = sess.run(op)
+      self.assertEqual(2 * batch_size, len(out.values))
+      # Each row has the same crosses as when it is crossed on its own.
+      for b in [0, 1, batch_size // 2, batch_size - 1]:
+        row_op = sparse_ops.sparse_cross_hashed(
+            [self._sparse_tensor([col1[b]]),
+             self._sparse_tensor([col2[b]]),
+             constant_op.constant([['F%d' % (b % 7)]])],
+            num_buckets=1000)
+        row_out = sess.run(row_op)
+        self.assertAllEqual(row_out.values, out.values[2 * b:2 * b + 2])
+
   def _assert_sparse_tensor_empty(self, sp):
     self.assertEquals(0, sp.indices.size)
     self.assertEquals(0, sp.values.size)
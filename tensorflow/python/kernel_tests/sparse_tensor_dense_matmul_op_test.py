@@ -32,7 +32,10 @@ from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.framework import tensor_shape
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import control_flow_ops
+from tensorflow.python.ops import gen_sparse_ops
+from tensorflow.python.ops import gradients_impl
 from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import sparse_grad  # pylint: disable=unused-import
 from tensorflow.python.ops import sparse_ops
 from tensorflow.python.platform import app
 from tensorflow.python.platform import test
@@ -243,6 +246,136 @@ class SparseTensorDenseMatMulTest(test.TestCase):
             y = y.transpose() if adjoint_b else y
             self._testMatmul(x, y, adjoint_a, adjoint_b)
 
+  # Tests products large enough to be sharded over the rows of the output.
+  def testLargeParallel(self):
+    np.random.seed(127)  # Repeatable results
+    for np_dtype in (np.float32, np.complex64):
+      x = _maybe_complex(np.random.rand(300, 200).astype(np_dtype))
+      x[np.abs(x) < 0.5] = 0
+      y = _maybe_complex(np.random.randn(200, 64).astype(np_dtype))
+      self._testMatmul(x, y)
+      self._testMatmul(x.transpose(), y, adjoint_a=True)
+      self._testMatmul(x, y.transpose(), adjoint_b=True)
+      self._testMatmul(
+          x.transpose(), y.transpose(), adjoint_a=True, adjoint_b=True)
+
+
+class CSRSparseMatrixDenseMatMulTest(test.TestCase):
+
+  def _assign(self, x, indices_dtype=np.int64):
+    x_indices = np.vstack(np.where(x)).astype(indices_dtype).T
+    x_values = x[np.where(x)]
+    handle = gen_sparse_ops.csr_sparse_matrix_handle(
+        dtype=dtypes.as_dtype(x.dtype))
+    assign = gen_sparse_ops.assign_csr_sparse_matrix(
+        handle, x_indices, x_values, np.array(x.shape, dtype=np.int64))
+    return handle, assign
+
+  def _testMatmul(self, x, y, adjoint_a=False, adjoint_b=False):
+    x_mat = np.matrix(x)
+    if adjoint_a:
+      x_mat = x_mat.H
+    y_mat = np.matrix(y)
+    if adjoint_b:
+      y_mat = y_mat.H
+    np_ans = x_mat * y_mat
+
+    with self.cached_session(use_gpu=False) as sess:
+      handle, assign = self._assign(x)
+      sess.run(assign)
+      product = gen_sparse_ops.csr_sparse_matrix_dense_mat_mul(
+          handle, y, adjoint_a=adjoint_a, adjoint_b=adjoint_b)
+      self.assertEqual(product.get_shape()[1], np_ans.shape[1])
+      # The second run reuses the cached matrix (and adjoint).
+      for _ in range(2):
+        self.assertAllClose(np_ans, product.eval(), rtol=1e-4, atol=1e-4)
+
+  def testBasic(self):
+    np.random.seed(127)  # Repeatable results
+    for np_dtype in (np.int32, np.float32, np.float64, np.complex64,
+                     np.complex128):
+      x = _maybe_complex(np.random.rand(10, 12).astype(np_dtype))
+      x[np.abs(x) < 0.5] = 0  # Make it sparse
+      y = _maybe_complex(np.random.randn(12, 20).astype(np_dtype))
+      self._testMatmul(x, y)
+      self._testMatmul(x.transpose(), y, adjoint_a=True)
+      self._testMatmul(x, y.transpose(), adjoint_b=True)
+      self._testMatmul(
+          x.transpose(), y.transpose(), adjoint_a=True, adjoint_b=True)
+
+  def testUnsortedIndices(self):
+    with self.cached_session(use_gpu=False) as sess:
+      handle = gen_sparse_ops.csr_sparse_matrix_handle(dtype=dtypes.float32)
+      sess.run(
+          gen_sparse_ops.assign_csr_sparse_matrix(
+              handle, np.array([[2, 0], [0, 1], [2, 1]], dtype=np.int32),
+              np.array([1, 2, 3], dtype=np.float32),
+              np.array([3, 2], dtype=np.int64)))
+      product = gen_sparse_ops.csr_sparse_matrix_dense_mat_mul(
+          handle, np.array([[1, 1], [1, 2]], dtype=np.float32))
+      self.assertAllEqual([[2, 4], [0, 0], [4, 7]], product.eval())
+
+  def testReassign(self):
+    with self.cached_session(use_gpu=False) as sess:
+      handle, assign = self._assign(np.eye(3, dtype=np.float32))
+      sess.run(assign)
+      y = np.arange(6, dtype=np.float32).reshape(3, 2)
+      product = gen_sparse_ops.csr_sparse_matrix_dense_mat_mul(
+          handle, y, adjoint_a=True)
+      self.assertAllEqual(y, product.eval())
+      # Reassigning drops the cached adjoint.
+      sess.run(
+          gen_sparse_ops.assign_csr_sparse_matrix(
+              handle, np.array([[0, 2]], dtype=np.int64),
+              np.array([5], dtype=np.float32),
+              np.array([3, 3], dtype=np.int64)))
+      self.assertAllEqual([[0, 0], [0, 0], [0, 5]], product.eval())
+
+  def testUnassigned(self):
+    with self.cached_session(use_gpu=False):
+      handle = gen_sparse_ops.csr_sparse_matrix_handle(dtype=dtypes.float32)
+      with self.assertRaisesOpError("unassigned CSR sparse matrix"):
+        gen_sparse_ops.csr_sparse_matrix_dense_mat_mul(
+            handle, np.ones([2, 2], dtype=np.float32)).eval()
+
+  def testInvalidIndices(self):
+    with self.cached_session(use_gpu=False) as sess:
+      handle = gen_sparse_ops.csr_sparse_matrix_handle(dtype=dtypes.float32)
+      with self.assertRaisesOpError(
+          "k .10. from index.0,1. out of bounds .>=2."):
+        sess.run(
+            gen_sparse_ops.assign_csr_sparse_matrix(
+                handle, np.array([[1, 10]], dtype=np.int64),
+                np.array([10], dtype=np.float32),
+                np.array([3, 2], dtype=np.int64)))
+
+  def testInnerDimensionMismatch(self):
+    with self.cached_session(use_gpu=False) as sess:
+      handle, assign = self._assign(np.eye(3, dtype=np.float32))
+      sess.run(assign)
+      with self.assertRaisesOpError("inner dimension does not match: 3 vs. 2"):
+        gen_sparse_ops.csr_sparse_matrix_dense_mat_mul(
+            handle, np.ones([2, 4], dtype=np.float32)).eval()
+
+  def testGradient(self):
+    np.random.seed(127)  # Repeatable results
+    x = np.random.rand(4, 5).astype(np.float64)
+    x[x < 0.5] = 0
+    grad = np.random.randn(4, 3).astype(np.float64)
+    with self.cached_session(use_gpu=False) as sess:
+      handle, assign = self._assign(x)
+      sess.run(assign)
+      for adjoint_b in (False, True):
+        y = constant_op.constant(
+            np.random.randn(3, 5) if adjoint_b else np.random.randn(5, 3))
+        product = gen_sparse_ops.csr_sparse_matrix_dense_mat_mul(
+            handle, y, adjoint_b=adjoint_b)
+        y_grad, = gradients_impl.gradients(product, y, grad_ys=grad)
+        expected = np.matrix(x).T * np.matrix(grad)
+        if adjoint_b:
+          expected = expected.T
+        self.assertAllClose(expected, y_grad.eval())
+
 
 def _sparse_tensor_dense_vs_dense_matmul_benchmark_dense(x, y, adjoint_a,
                                                          adjoint_b):
@@ -160,6 +160,29 @@ class TopKTest(test.TestCase):
       values = -np.sort(-inputs, axis=1)[:, :k]
       self._validateTopK(inputs, k, values, indices)
 
+  def testStableSelect(self):
+    # Long enough rows, and large enough k, to select the top k rather than
+    # sorting the rows or keeping a heap of the top k.
+    b = 3
+    n = 5000
+    for k in [100, 2500]:
+      inputs = np.random.permutation(
+          np.linspace(0, 3, b * n, dtype=np.int32)).reshape(b, n)
+      indices = np.argsort(-inputs, axis=1, kind="mergesort")[:, :k]
+      values = -np.sort(-inputs, axis=1)[:, :k]
+      self._validateTopK(inputs, k, values, indices)
+      self._validateTopK(inputs, k, values, indices, sorted=False)
+
+  def testLongRow(self):
+    # A single row is split over threads on CPU.
+    n = 1 << 20
+    inputs = np.random.permutation(
+        np.linspace(0, 100, n, dtype=np.float32)).reshape(1, n)
+    for k in [10, 1000]:
+      indices = np.argsort(-inputs, axis=1)[:, :k]
+      values = -np.sort(-inputs, axis=1)[:, :k]
+      self._validateTopK(inputs, k, values, indices)
+
   def testTopAll(self):
     inputs = [[0.1, 0.3, 0.2, 0.4], [0.1, 0.3, 0.3, 0.2]]
     self._validateTopK(inputs, 4, [[0.4, 0.3, 0.2, 0.1], [0.3, 0.3, 0.2, 0.1]],
@@ -210,6 +233,23 @@ class TopKTest(test.TestCase):
 
 class TopKBenchmark(test.Benchmark):
 
+  def _benchmarkTopK(self, m, n, k, use_gpu):
+    name = "m_%d_n_%d_k_%g_use_gpu_%s" % (m, n, k, use_gpu)
+    device = "/%s:0" % ("gpu" if use_gpu else "cpu")
+    with ops.Graph().as_default():
+      with ops.device(device):
+        x = random_ops.random_uniform((m, n))
+        v = resource_variable_ops.ResourceVariable(x)
+        op = nn_ops.top_k(v, k)
+      with session.Session() as sess:
+        v.initializer.run()
+        r = self.run_op_benchmark(sess, op, min_iters=100, name=name)
+        gb_processed_input = m * n / 1.0e9
+        throughput = gb_processed_input / r["wall_time"]
+        print("Benchmark: %s \t wall_time: %0.03g s \t "
+              "Throughput: %0.03g GB/s" % (name, r["wall_time"], throughput))
+        sys.stdout.flush()
+
   def benchmarkTopK(self):
     for (m, n, p, use_gpu) in itertools.product(
         [128],
@@ -219,22 +259,15 @@ class TopKBenchmark(test.Benchmark):
       k = int(p * n)
       if k == 0:
         continue
-      name = "m_%d_n_%d_k_%g_use_gpu_%s" % (m, n, k, use_gpu)
-      device = "/%s:0" % ("gpu" if use_gpu else "cpu")
-      with ops.Graph().as_default():
-        with ops.device(device):
-          x = random_ops.random_uniform((m, n))
-          v = resource_variable_ops.ResourceVariable(x)
-          op = nn_ops.top_k(v, k)
-        with session.Session() as sess:
-          v.initializer.run()
-          r = self.run_op_benchmark(sess, op, min_iters=100, name=name)
-          gb_processed_input = m * n / 1.0e9
-          throughput = gb_processed_input / r["wall_time"]
-          print("Benchmark: %s \t wall_time: %0.03g s \t "
-                "Throughput: %0.03g GB/s" % (name, r["wall_time"], throughput))
-          sys.stdout.flush()
+      self._benchmarkTopK(m, n, k, use_gpu)
 
+  def benchmarkTopKLongRows(self):
+    for (m, n, k, use_gpu) in itertools.product(
+        [1, 8],
+        [1 << 20, 1 << 24],
+        [10, 100, 1000, 10000],
+        [False, True]):
+      self._benchmarkTopK(m, n, k, use_gpu)
 
 if __name__ == "__main__":
   test.main()
@@ -26,6 +26,16 @@ from tensorflow.python.ops import gen_array_ops
 from tensorflow.python.platform import test
 
 
+def _UniqueInOrder(x):
+  """Returns unique(x) with the values in order of first occurrence."""
+  values, first, inverse, counts = np.unique(
+      x, return_index=True, return_inverse=True, return_counts=True)
+  order = np.argsort(first)
+  ids = np.empty_like(order)
+  ids[order] = np.arange(len(order))
+  return values[order], ids[inverse], counts[order]
+
+
 class UniqueTest(test.TestCase):
 
   def testInt32(self):
@@ -62,6 +72,26 @@ class UniqueTest(test.TestCase):
     for i in range(len(x)):
       self.assertEqual(x[i], tf_y[tf_idx[i]].decode('ascii'))
 
+  def testLargeInput(self):
+    # Large enough to be deduplicated in parallel on CPU.
+    for dtype in [np.int32, np.int64]:
+      x = np.random.randint(-5000, high=5000, size=100000).astype(dtype)
+      with self.cached_session(use_gpu=True) as sess:
+        y, idx = array_ops.unique(x, out_idx=dtypes.int64)
+        tf_y, tf_idx = sess.run([y, idx])
+      np_y, np_idx, _ = _UniqueInOrder(x)
+      self.assertAllEqual(np_y, tf_y)
+      self.assertAllEqual(np_idx, tf_idx)
+
+  def testLargeString(self):
+    x = [str(i) for i in np.random.randint(1000, size=50000)]
+    with self.cached_session() as sess:
+      y, idx = array_ops.unique(x)
+      tf_y, tf_idx = sess.run([y, idx])
+    np_y, np_idx, _ = _UniqueInOrder(x)
+    self.assertAllEqual([v.encode('ascii') for v in np_y], tf_y)
+    self.assertAllEqual(np_idx, tf_idx)
+
   def testInt32Axis(self):
     for dtype in [np.int32, np.int64]:
       x = np.array([[1, 0, 0], [1, 0, 0], [2, 0, 0]])
@@ -133,6 +163,18 @@ class UniqueWithCountsTest(test.TestCase):
       v = [1 if x[i] == value.decode('ascii') else 0 for i in range(7000)]
       self.assertEqual(count, sum(v))
 
+  def testLargeInput(self):
+    for dtype, out_idx in [(np.int32, dtypes.int32), (np.int64, dtypes.int64)]:
+      x = np.random.randint(-1 << 30, high=1 << 30, size=100000).astype(dtype)
+      x[::3] = 7
+      with self.cached_session(use_gpu=True) as sess:
+        y, idx, count = array_ops.unique_with_counts(x, out_idx=out_idx)
+        tf_y, tf_idx, tf_count = sess.run([y, idx, count])
+      np_y, np_idx, np_count = _UniqueInOrder(x)
+      self.assertAllEqual(np_y, tf_y)
+      self.assertAllEqual(np_idx, tf_idx)
+      self.assertAllEqual(np_count, tf_count)
+
   def testInt32Axis(self):
     for dtype in [np.int32, np.int64]:
       x = np.array([[1, 0, 0], [1, 0, 0], [2, 0, 0]])
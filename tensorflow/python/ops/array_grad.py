@@ -21,12 +21,15 @@ from __future__ import print_function
 from tensorflow.python import pywrap_tensorflow
 from tensorflow.python.eager import context
 from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.framework import tensor_util
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import control_flow_util
 from tensorflow.python.ops import gen_array_ops
+from tensorflow.python.ops import gen_data_flow_ops
+from tensorflow.python.ops import gen_resource_variable_ops
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import sparse_ops
 
@@ -475,6 +478,58 @@ def _GatherV2Grad(op, grad):
   return [params_grad, None, None]
 
 
+def _ShardedGatherGrads(grad, indices, shard_shapes, partition_strategy):
+  """Splits the gradient of a sharded gather into one per shard."""
+  num_shards = len(shard_shapes)
+  flat_ids = array_ops.reshape(indices, [-1])
+  size = array_ops.expand_dims(array_ops.size(flat_ids), 0)
+  values = array_ops.reshape(
+      grad, array_ops.concat([size, shard_shapes[0][1:]], 0))
+  if partition_strategy == b"mod":
+    assignments = flat_ids % num_shards
+    new_ids = flat_ids // num_shards
+  else:
+    num_ids = math_ops.add_n(
+        [math_ops.cast(shape[0], flat_ids.dtype) for shape in shard_shapes])
+    ids_per_shard = num_ids // num_shards
+    extras = num_ids % num_shards
+    assignments = math_ops.maximum(flat_ids // (ids_per_shard + 1),
+                                   (flat_ids - extras) // ids_per_shard)
+    new_ids = array_ops.where(assignments < extras,
+                              flat_ids % (ids_per_shard + 1),
+                              (flat_ids - extras) % ids_per_shard)
+  assignments = math_ops.cast(assignments, dtypes.int32)
+  shard_ids = gen_data_flow_ops.dynamic_partition(new_ids, assignments,
+                                                  num_shards)
+  shard_values = gen_data_flow_ops.dynamic_partition(values, assignments,
+                                                     num_shards)
+  return [
+      ops.IndexedSlices(v, i, shape)
+      for v, i, shape in zip(shard_values, shard_ids, shard_shapes)
+  ]
+
+
+@ops.RegisterGradient("ShardedGather")
+def _ShardedGatherGrad(op, grad):
+  """Gradient for ShardedGather op."""
+  params = op.inputs[:-1]
+  shard_shapes = []
+  for p in params:
+    with ops.colocate_with(p):
+      shard_shapes.append(array_ops.shape(p))
+  return _ShardedGatherGrads(grad, op.inputs[-1], shard_shapes,
+                             op.get_attr("partition_strategy")) + [None]
+
+
+@ops.RegisterGradient("ResourceShardedGather")
+def _ResourceShardedGatherGrad(op, grad):
+  """Gradient for ResourceShardedGather op."""
+  handles = op.inputs[:-1]
+  shard_shapes = [gen_resource_variable_ops.variable_shape(h) for h in handles]
+  return _ShardedGatherGrads(grad, op.inputs[-1], shard_shapes,
+                             op.get_attr("partition_strategy")) + [None]
+
+
 @ops.RegisterGradient("GatherNd")
 def _GatherNdGrad(op, grad):
   ref = op.inputs[0]
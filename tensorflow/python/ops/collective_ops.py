@@ -22,7 +22,7 @@ from tensorflow.python.ops import gen_collective_ops
 
 
 def all_reduce(t, group_size, group_key, instance_key, merge_op, final_op,
-               subdiv_offsets=(0,)):
+               subdiv_offsets=(0,), implementation='', wire_format=''):
   """Reduces tensors collectively, across devices.
 
   Args:
@@ -38,6 +38,13 @@ def all_reduce(t, group_size, group_key, instance_key, merge_op, final_op,
     subdiv_offsets: a list of integer offsets into the tensor at which each
       independent subdivision should begin.  Use [0] if no subdivision should
       be done.
+    implementation: name of the registered collective implementation to use,
+      e.g. 'RingReduce' or 'HierarchicalReduce'.  All Ops in the instance
+      must agree.  If empty, the runtime picks one.
+    wire_format: format of the values sent between tasks.  If 'fp16', float
+      values are sent as halves, which halves the bytes on the network at
+      the cost of precision.  Only supported by the 'RingReduce'
+      implementation on CPU devices.  All Ops in the instance must agree.
 
   Returns:
     An Op implementing the distributed reduction.
@@ -55,7 +62,9 @@ def all_reduce(t, group_size, group_key, instance_key, merge_op, final_op,
                                               instance_key=instance_key,
                                               merge_op=merge_op,
                                               final_op=final_op,
-                                              subdiv_offsets=subdiv_offsets)
+                                              subdiv_offsets=subdiv_offsets,
+                                              implementation=implementation,
+                                              wire_format=wire_format)
 
 
 def broadcast_send(t, shape, dtype, group_size, group_key, instance_key):
@@ -29,6 +29,9 @@ from tensorflow.python.ops import clip_ops
 # Imports gradient definitions.
 from tensorflow.python.ops import data_flow_grad  # pylint: disable=unused-import
 from tensorflow.python.ops import data_flow_ops
+from tensorflow.python.ops import gen_array_ops
+from tensorflow.python.ops import gen_math_ops
+from tensorflow.python.ops import gen_resource_variable_ops
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.ops import sparse_ops
@@ -81,6 +84,18 @@ def _clip(params, ids, max_norm):
             else math_ops.range(ids_rank, params_rank)))
 
 
+def _params_on_one_device(params):
+  """Whether all of `params` are placed on the same device."""
+  if any(isinstance(p, resource_variable_ops.ResourceVariable)
+         for p in params):
+    if not all(isinstance(p, resource_variable_ops.ResourceVariable)
+               for p in params):
+      return False
+  elif not all(isinstance(p, ops.Tensor) for p in params):
+    return False
+  return all(p.device == params[0].device for p in params[1:])
+
+
 def _embedding_lookup_and_transform(params,
                                     ids,
                                     partition_strategy="mod",
@@ -138,6 +153,20 @@ def _embedding_lookup_and_transform(params,
       # params. Similar to the case np > 1 where parallel_dynamic_stitch is
       # outside the scioe of all with ops.colocate_with(params[p]).
       return array_ops.identity(result)
+    elif (not transform_fn and partition_strategy in ("mod", "div") and
+          _params_on_one_device(params)):
+      # All the shards are on one device, so gather each row straight from
+      # its shard instead of partitioning the ids and stitching the results.
+      with ops.colocate_with(params[0]):
+        if isinstance(params[0], resource_variable_ops.ResourceVariable):
+          result = gen_resource_variable_ops.resource_sharded_gather(
+              [p.handle for p in params], ids, dtype=params[0].dtype,
+              partition_strategy=partition_strategy, name=name)
+        else:
+          result = gen_array_ops.sharded_gather(
+              params, ids, partition_strategy=partition_strategy, name=name)
+        result = _clip(result, ids, max_norm)
+      return array_ops.identity(result)
     else:
       # Flatten the ids. There are two cases where we need to do this.
       # - There is more than one params tensor.
@@ -424,6 +453,10 @@ def embedding_lookup_sparse(params,
 
   with ops.name_scope(name, "embedding_lookup_sparse",
                       params + [sp_ids]) as name:
+    if _can_fuse_embedding_lookup_sparse(params, sp_ids, max_norm):
+      return _fused_embedding_lookup_sparse(params[0], sp_ids, sp_weights,
+                                            combiner, name)
+
     segment_ids = sp_ids.indices[:, 0]
     if segment_ids.dtype != dtypes.int32:
       segment_ids = math_ops.cast(segment_ids, dtypes.int32)
@@ -491,6 +524,45 @@ def embedding_lookup_sparse(params,
     return embeddings
 
 
+def _can_fuse_embedding_lookup_sparse(params, sp_ids, max_norm):
+  """Whether `_fused_embedding_lookup_sparse` supports the arguments."""
+  return (len(params) == 1 and max_norm is None and
+          params[0].dtype.base_dtype in (dtypes.float32, dtypes.float64) and
+          sp_ids.values.dtype in (dtypes.int32, dtypes.int64))
+
+
+def _fused_embedding_lookup_sparse(params, sp_ids, sp_weights, combiner,
+                                   name):
+  """Computes `embedding_lookup_sparse` of a single tensor with one kernel.
+
+  The embeddings of the ids are accumulated directly into the rows of the
+  output, instead of being gathered into a `[nnz, dim]` tensor first.
+
+  Args:
+    params: A single tensor or variable of embeddings.
+    sp_ids: `SparseTensor` of ids, as in `embedding_lookup_sparse`.
+    sp_weights: `SparseTensor` of weights or `None`.
+    combiner: One of "mean", "sqrtn" and "sum".
+    name: The name of the output.
+
+  Returns:
+    The combined embeddings, as returned by `embedding_lookup_sparse`.
+  """
+  dtype = params.dtype.base_dtype
+  ids = sp_ids.values
+  segment_ids = sp_ids.indices[:, 0]
+  if sp_weights is None:
+    weights = array_ops.ones_like(ids, dtype=dtype)
+  else:
+    weights = math_ops.cast(sp_weights.values, dtype)
+  # Like the segment reductions, only produce rows up to the last one with ids.
+  num_rows = math_ops.maximum(math_ops.reduce_max(segment_ids) + 1, 0)
+  with ops.colocate_with(params):
+    return gen_math_ops.fused_embedding_lookup_sparse(
+        params, ids, segment_ids, weights, num_rows, combiner=combiner,
+        name=name)
+
+
 @tf_export("nn.safe_embedding_lookup_sparse")
 def safe_embedding_lookup_sparse(embedding_weights,
                                  sparse_ids,
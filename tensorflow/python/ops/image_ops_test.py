@@ -3133,6 +3133,38 @@ class JpegTest(test_util.TensorFlowTestCase):
             lambda e: "Invalid JPEG data or crop window" in str(e)):
           sess.run(result)
 
+  def testGpuDecodeMatchesCpu(self):
+    if not test.is_gpu_available():
+      self.skipTest("No GPU available")
+    # The image is large enough for the inverse DCT to run on the GPU, which
+    # computes it in floating point.
+    path = "tensorflow/core/lib/jpeg/testdata/medium.jpg"
+    with self.test_session(use_gpu=True) as sess:
+      jpeg0 = io_ops.read_file(path)
+      for channels in 0, 1, 3:
+        for fancy_upscaling in True, False:
+          images = []
+          for device in "/cpu:0", "/gpu:0":
+            with ops.device(device):
+              images.append(
+                  image_ops.decode_jpeg(
+                      jpeg0,
+                      channels=channels,
+                      fancy_upscaling=fancy_upscaling,
+                      dct_method="INTEGER_ACCURATE"))
+              images.append(
+                  image_ops.decode_and_crop_jpeg(
+                      jpeg0, [7, 9, 100, 120],
+                      channels=channels,
+                      fancy_upscaling=fancy_upscaling,
+                      dct_method="INTEGER_ACCURATE"))
+          cpu_image, cpu_crop, gpu_image, gpu_crop = sess.run(images)
+          for cpu, gpu in (cpu_image, gpu_image), (cpu_crop, gpu_crop):
+            self.assertEqual(cpu.shape, gpu.shape)
+            self.assertLess(self.averageError(cpu, gpu), 0.5)
+            self.assertAllClose(
+                cpu.astype(int), gpu.astype(int), rtol=0, atol=4)
+
   def testSynthetic(self):
     with self.test_session(use_gpu=True) as sess:
       # Encode it, then decode it, then encode it
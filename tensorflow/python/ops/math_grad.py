@@ -242,6 +242,48 @@ def _SparseSegmentSqrtNGrad(op, grad):
                                               dim0), None, None)
 
 
+@ops.RegisterGradient("FusedEmbeddingLookupSparse")
+def _FusedEmbeddingLookupSparseGrad(op, grad):
+  """Gradient for FusedEmbeddingLookupSparse."""
+  params, ids, segment_ids, weights, num_rows = op.inputs
+  combiner = op.get_attr("combiner")
+  unique_ids, unique_idx = array_ops.unique(ids)
+  params_grad = gen_math_ops.fused_embedding_lookup_sparse_grad(
+      grad, unique_idx, segment_ids, weights,
+      array_ops.size(unique_ids, out_type=dtypes.int32), combiner=combiner)
+  params_grad = ops.IndexedSlices(params_grad, unique_ids,
+                                  array_ops.shape(params))
+
+  # d output[r] / d weights[e] follows from output[r] = sum / z(r), where z
+  # is 1, sum(weights) or sqrt(sum(weights^2)) over the row. These ops are
+  # pruned from the graph unless the gradient of the weights is used.
+  num_entries = array_ops.size(ids)
+  flat_grad = array_ops.reshape(
+      grad, array_ops.stack([array_ops.shape(grad)[0], -1]))
+  row_grad = array_ops.gather(flat_grad, segment_ids)
+  embeddings = array_ops.reshape(
+      array_ops.gather(params, ids), array_ops.stack([num_entries, -1]))
+  weights_grad = math_ops.reduce_sum(row_grad * embeddings, axis=1)
+  if combiner != b"sum":
+    if combiner == b"mean":
+      z = math_ops.unsorted_segment_sum(weights, segment_ids, num_rows)
+    else:
+      z = math_ops.sqrt(
+          math_ops.unsorted_segment_sum(weights * weights, segment_ids,
+                                        num_rows))
+    entry_z = array_ops.gather(z, segment_ids)
+    flat_output = array_ops.reshape(
+        op.outputs[0], array_ops.stack([array_ops.shape(grad)[0], -1]))
+    output_grad = math_ops.reduce_sum(
+        row_grad * array_ops.gather(flat_output, segment_ids), axis=1)
+    if combiner == b"mean":
+      weights_grad = (weights_grad - output_grad) / entry_z
+    else:
+      weights_grad = (weights_grad / entry_z -
+                      output_grad * weights / (entry_z * entry_z))
+  return (params_grad, None, None, weights_grad, None)
+
+
 @ops.RegisterGradient("SparseSegmentSqrtNWithNumSegments")
 def _SparseSegmentSqrtNWithNumSegmentsGrad(op, grad):
   """Gradient for SparseSegmentSqrtNWithNumSegments."""
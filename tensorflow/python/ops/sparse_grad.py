@@ -201,6 +201,33 @@ def _SparseTensorDenseMatMulGrad(op, grad):
   return (None, a_values_grad, None, b_grad)
 
 
+ops.NotDifferentiable("CSRSparseMatrixHandle")
+ops.NotDifferentiable("AssignCSRSparseMatrix")
+
+
+@ops.RegisterGradient("CSRSparseMatrixDenseMatMul")
+def _CSRSparseMatrixDenseMatMulGrad(op, grad):
+  """Gradients for the dense tensor in the CSRSparseMatrixDenseMatMul op.
+
+  The values of the sparse matrix live in a resource, so only the dense
+  operand gets a gradient.
+
+  Args:
+    op: the CSRSparseMatrixDenseMatMul op
+    grad: the incoming gradient
+
+  Returns:
+    Gradients for (a, b), where the gradient for the resource `a` is None.
+  """
+  adj_a = op.get_attr("adjoint_a")
+  adj_b = op.get_attr("adjoint_b")
+  b_grad = gen_sparse_ops.csr_sparse_matrix_dense_mat_mul(
+      op.inputs[0], grad, adjoint_a=not adj_a)
+  if adj_b:
+    b_grad = array_ops.transpose(b_grad, conjugate=True)
+  return (None, b_grad)
+
+
 @ops.RegisterGradient("SparseDenseCwiseAdd")
 def _SparseDenseCwiseAddGrad(unused_op, unused_grad):
   raise NotImplementedError("Gradient for SparseDenseCwiseAdd is currently not"
@@ -286,6 +286,65 @@ class TrainingOpsTest(TensorFlowTestCase):
       self.assertShapeEqual(out, apply_adam)
       self.assertAllCloseAccordingToType(new_var, out)
 
+  def testResourceMultiApplyAdam(self):
+    for dtype, use_gpu in itertools.product(
+        [np.float16, np.float32, np.float64], [False, True]):
+      # Sizes that span several chunks of the fused kernels, and an empty
+      # variable.
+      sizes = [100, 0, 70000, 3]
+      var = [(np.arange(n) % 100 / 100).astype(dtype) for n in sizes]
+      m = [(np.arange(1, n + 1) % 100 / 100).astype(dtype) for n in sizes]
+      v = [(np.arange(n) % 100 / 10 + 1).astype(dtype) for n in sizes]
+      grad = [np.cos(np.arange(n)).astype(dtype) for n in sizes]
+      self.setUp()
+      with self.session(use_gpu=use_gpu):
+        var_t = [resource_variable_ops.ResourceVariable(x) for x in var]
+        m_t = [resource_variable_ops.ResourceVariable(x) for x in m]
+        v_t = [resource_variable_ops.ResourceVariable(x) for x in v]
+        variables.global_variables_initializer().run()
+
+        beta1 = np.array(0.9, dtype=dtype)
+        beta2 = np.array(0.999, dtype=dtype)
+        lr = np.array(0.001, dtype=dtype)
+        epsilon = np.array(1e-8, dtype=dtype)
+        training_ops.resource_multi_apply_adam(
+            [x.handle for x in var_t], [x.handle for x in m_t],
+            [x.handle for x in v_t], beta1, beta2, lr, beta1, beta2, epsilon,
+            grad).run()
+        for i in range(len(sizes)):
+          new_var, new_m, new_v = self._adamUpdateNumpy(
+              var[i], grad[i], 1, m[i], v[i], lr, beta1, beta2, epsilon)
+          self.assertAllCloseAccordingToType(new_m, m_t[i].eval())
+          self.assertAllCloseAccordingToType(new_v, v_t[i].eval())
+          self.assertAllCloseAccordingToType(new_var, var_t[i].eval())
+
+  def testResourceMultiApplyMomentum(self):
+    for dtype, use_gpu, use_nesterov in itertools.product(
+        [np.float16, np.float32, np.float64], [False, True], [False, True]):
+      sizes = [100, 70000]
+      var = [(np.arange(n) % 100 / 100).astype(dtype) for n in sizes]
+      accum = [(np.arange(1, n + 1) % 100 / 100).astype(dtype) for n in sizes]
+      grad = [np.cos(np.arange(n)).astype(dtype) for n in sizes]
+      lr = np.array(0.01, dtype=dtype)
+      momentum = np.array(0.9, dtype=dtype)
+      self.setUp()
+      with self.session(use_gpu=use_gpu):
+        var_t = [resource_variable_ops.ResourceVariable(x) for x in var]
+        accum_t = [resource_variable_ops.ResourceVariable(x) for x in accum]
+        variables.global_variables_initializer().run()
+
+        training_ops.resource_multi_apply_momentum(
+            [x.handle for x in var_t], [x.handle for x in accum_t], lr,
+            momentum, grad, use_nesterov=use_nesterov).run()
+        for i in range(len(sizes)):
+          new_accum = accum[i] * momentum + grad[i]
+          if use_nesterov:
+            new_var = var[i] - grad[i] * lr - new_accum * momentum * lr
+          else:
+            new_var = var[i] - new_accum * lr
+          self.assertAllCloseAccordingToType(new_accum, accum_t[i].eval())
+          self.assertAllCloseAccordingToType(new_var, var_t[i].eval())
+
   def _adamUpdateNumpy(self, param, g_t, t, m, v, alpha, beta1, beta2, epsilon):
     alpha_t = alpha * np.sqrt(1 - beta2**t) / (1 - beta1**t)
 
@@ -1004,6 +1004,87 @@ CUDADriver::ContextGetSharedMemConfig(CudaContext* context) {
   return true;
 }
 
+#if CUDA_VERSION >= 10000
+/* static */ port::Status CUDADriver::BeginStreamCapture(CudaContext* context,
+                                                         CUstream stream) {
+  ScopedActivateContext activation(context);
+#if CUDA_VERSION >= 10010
+  CUresult res =
+      cuStreamBeginCapture(stream, CU_STREAM_CAPTURE_MODE_THREAD_LOCAL);
+#else
+  CUresult res = cuStreamBeginCapture(stream);
+#endif
+  if (res != CUDA_SUCCESS) {
+    return port::Status(
+        port::error::INTERNAL,
+        port::Printf("could not begin capture on stream %p: %s", stream,
+                     ToString(res).c_str()));
+  }
+  return port::Status::OK();
+}
+
+/* static */ port::Status CUDADriver::EndStreamCapture(CudaContext* context,
+                                                       CUstream stream,
+                                                       CUgraph* graph) {
+  ScopedActivateContext activation(context);
+  CUresult res = cuStreamEndCapture(stream, graph);
+  if (res != CUDA_SUCCESS) {
+    return port::Status(
+        port::error::INTERNAL,
+        port::Printf("could not end capture on stream %p: %s", stream,
+                     ToString(res).c_str()));
+  }
+  return port::Status::OK();
+}
+
+/* static */ port::Status CUDADriver::InstantiateGraph(
+    CudaContext* context, CUgraph graph, CUgraphExec* graph_exec) {
+  ScopedActivateContext activation(context);
+  char log[256] = {0};
+  CUresult res = cuGraphInstantiate(graph_exec, graph, /*phErrorNode=*/nullptr,
+                                    log, sizeof(log));
+  if (res != CUDA_SUCCESS) {
+    return port::Status(
+        port::error::INTERNAL,
+        port::Printf("could not instantiate CUDA graph: %s: %s",
+                     ToString(res).c_str(), log));
+  }
+  return port::Status::OK();
+}
+
+/* static */ port::Status CUDADriver::LaunchGraph(CudaContext* context,
+                                                  CUgraphExec graph_exec,
+                                                  CUstream stream) {
+  ScopedActivateContext activation(context);
+  CUresult res = cuGraphLaunch(graph_exec, stream);
+  if (res != CUDA_SUCCESS) {
+    return port::Status(
+        port::error::INTERNAL,
+        port::Printf("could not launch CUDA graph on stream %p: %s", stream,
+                     ToString(res).c_str()));
+  }
+  return port::Status::OK();
+}
+
+/* static */ void CUDADriver::DestroyGraph(CudaContext* context,
+                                           CUgraph graph) {
+  ScopedActivateContext activation(context);
+  CUresult res = cuGraphDestroy(graph);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy CUDA graph: " << ToString(res);
+  }
+}
+
+/* static */ void CUDADriver::DestroyGraphExec(CudaContext* context,
+                                               CUgraphExec graph_exec) {
+  ScopedActivateContext activation(context);
+  CUresult res = cuGraphExecDestroy(graph_exec);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy CUDA graph executable: " << ToString(res);
+  }
+}
+#endif  // CUDA_VERSION >= 10000
+
 /* static */ bool CUDADriver::SynchronizeContext(CudaContext* context) {
   ScopedActivateContext activation(context);
   CUresult res = cuCtxSynchronize();
@@ -305,6 +305,38 @@ class CUDADriver {
   static bool WaitStreamOnEvent(CudaContext* context, CUstream stream,
                                 CUevent event);
 
+#if CUDA_VERSION >= 10000
+  // Starts recording the operations subsequently enqueued on stream into a
+  // graph instead of running them, via cuStreamBeginCapture. On CUDA 10.1 and
+  // later the capture is thread-local, so unsafe calls made by other threads
+  // don't invalidate it.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__STREAM.html
+  static port::Status BeginStreamCapture(CudaContext* context,
+                                         CUstream stream);
+
+  // Stops the capture started on stream and hands the recorded graph to the
+  // caller, via cuStreamEndCapture. The graph must be released with
+  // DestroyGraph.
+  static port::Status EndStreamCapture(CudaContext* context, CUstream stream,
+                                       CUgraph* graph);
+
+  // Creates an executable graph from graph via cuGraphInstantiate. The result
+  // must be released with DestroyGraphExec.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__GRAPH.html
+  static port::Status InstantiateGraph(CudaContext* context, CUgraph graph,
+                                       CUgraphExec* graph_exec);
+
+  // Enqueues graph_exec onto stream via cuGraphLaunch.
+  static port::Status LaunchGraph(CudaContext* context, CUgraphExec graph_exec,
+                                  CUstream stream);
+
+  // Releases a graph via cuGraphDestroy.
+  static void DestroyGraph(CudaContext* context, CUgraph graph);
+
+  // Releases an executable graph via cuGraphExecDestroy.
+  static void DestroyGraphExec(CudaContext* context, CUgraphExec graph_exec);
+#endif  // CUDA_VERSION >= 10000
+
   // Blocks the calling thread until the operations enqueued onto stream have
   // been completed, via cuStreamSynchronize.
   //
@@ -40,6 +40,7 @@ limitations under the License.
 #include "tensorflow/stream_executor/lib/path.h"
 #include "tensorflow/stream_executor/lib/process_state.h"
 #include "tensorflow/stream_executor/lib/ptr_util.h"
+#include "tensorflow/stream_executor/lib/status_macros.h"
 #include "tensorflow/stream_executor/lib/statusor.h"
 #include "tensorflow/stream_executor/lib/str_util.h"
 #include "tensorflow/stream_executor/lib/stringprintf.h"
@@ -752,6 +753,78 @@ port::Status CUDAExecutor::BlockHostUntilDone(Stream *stream) {
   return CUDADriver::SynchronizeStream(context_, AsCUDAStreamValue(stream));
 }
 
+#if CUDA_VERSION >= 10000
+namespace {
+
+// Owns a CUgraphExec recorded by CUDAExecutor::EndGraphCapture.
+class CUDAGraphExec : public internal::GraphExecInterface {
+ public:
+  CUDAGraphExec(CudaContext *context, CUgraphExec graph_exec)
+      : context_(context), graph_exec_(graph_exec) {}
+  ~CUDAGraphExec() override {
+    CUDADriver::DestroyGraphExec(context_, graph_exec_);
+  }
+
+  CUgraphExec graph_exec() const { return graph_exec_; }
+
+ private:
+  CudaContext *context_;
+  CUgraphExec graph_exec_;
+};
+
+}  // namespace
+#endif  // CUDA_VERSION >= 10000
+
+bool CUDAExecutor::SupportsGraphCapture() const {
+#if CUDA_VERSION >= 10000
+  // The driver must be recent enough too, since it may be older than the
+  // toolkit we were built with.
+  int driver_version = 0;
+  return CUDADriver::GetDriverVersion(&driver_version) &&
+         driver_version >= 10000;
+#else
+  return false;
+#endif
+}
+
+port::Status CUDAExecutor::BeginGraphCapture(Stream *stream) {
+#if CUDA_VERSION >= 10000
+  return CUDADriver::BeginStreamCapture(context_, AsCUDAStreamValue(stream));
+#else
+  return internal::StreamExecutorInterface::BeginGraphCapture(stream);
+#endif
+}
+
+port::StatusOr<std::unique_ptr<internal::GraphExecInterface>>
+CUDAExecutor::EndGraphCapture(Stream *stream) {
+#if CUDA_VERSION >= 10000
+  CUgraph graph = nullptr;
+  SE_RETURN_IF_ERROR(CUDADriver::EndStreamCapture(
+      context_, AsCUDAStreamValue(stream), &graph));
+  CUgraphExec graph_exec = nullptr;
+  port::Status status =
+      CUDADriver::InstantiateGraph(context_, graph, &graph_exec);
+  // The executable graph doesn't refer to the graph it was created from.
+  CUDADriver::DestroyGraph(context_, graph);
+  SE_RETURN_IF_ERROR(status);
+  return std::unique_ptr<internal::GraphExecInterface>(
+      new CUDAGraphExec(context_, graph_exec));
+#else
+  return internal::StreamExecutorInterface::EndGraphCapture(stream);
+#endif
+}
+
+port::Status CUDAExecutor::LaunchGraph(
+    Stream *stream, const internal::GraphExecInterface &graph) {
+#if CUDA_VERSION >= 10000
+  return CUDADriver::LaunchGraph(
+      context_, static_cast<const CUDAGraphExec &>(graph).graph_exec(),
+      AsCUDAStreamValue(stream));
+#else
+  return internal::StreamExecutorInterface::LaunchGraph(stream, graph);
+#endif
+}
+
 blas::BlasSupport *CUDAExecutor::CreateBlas() {
   PluginRegistry *registry = PluginRegistry::Instance();
   port::StatusOr<PluginRegistry::BlasFactory> status =
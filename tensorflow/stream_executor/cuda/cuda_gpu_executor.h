@@ -175,6 +175,16 @@ class CUDAExecutor : public internal::StreamExecutorInterface {
 
   port::Status BlockHostUntilDone(Stream *stream) override;
 
+  bool SupportsGraphCapture() const override;
+
+  port::Status BeginGraphCapture(Stream *stream) override;
+
+  port::StatusOr<std::unique_ptr<internal::GraphExecInterface>> EndGraphCapture(
+      Stream *stream) override;
+
+  port::Status LaunchGraph(Stream *stream,
+                           const internal::GraphExecInterface &graph) override;
+
   int PlatformDeviceCount() override { return CUDADriver::GetDeviceCount(); }
 
   port::Status EnablePeerAccessTo(StreamExecutorInterface *other) override;
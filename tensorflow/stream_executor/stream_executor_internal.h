@@ -81,6 +81,18 @@ class EventInterface {
   SE_DISALLOW_COPY_AND_ASSIGN(EventInterface);
 };
 
+// Platform-dependent handle to an executable graph of device operations that
+// was recorded from a stream (see StreamExecutorInterface::EndGraphCapture).
+// Destroying the handle releases the graph.
+class GraphExecInterface {
+ public:
+  GraphExecInterface() {}
+  virtual ~GraphExecInterface() {}
+
+ private:
+  SE_DISALLOW_COPY_AND_ASSIGN(GraphExecInterface);
+};
+
 // Pointer-to-implementation object type (i.e. the KernelBase class delegates to
 // this interface) with virtual destruction. This class exists for the
 // platform-dependent code to hang any kernel data/resource info/functionality
@@ -263,6 +275,24 @@ class StreamExecutorInterface {
 
   virtual int64 GetDeviceLoad() { return -1; }
 
+  // Graph capture is optional; platforms that don't support it keep these
+  // defaults, which report UNIMPLEMENTED.
+  virtual bool SupportsGraphCapture() const { return false; }
+  virtual port::Status BeginGraphCapture(Stream *stream) {
+    return port::Status(port::error::UNIMPLEMENTED,
+                        "graph capture is not supported on this platform");
+  }
+  virtual port::StatusOr<std::unique_ptr<GraphExecInterface>> EndGraphCapture(
+      Stream *stream) {
+    return port::Status(port::error::UNIMPLEMENTED,
+                        "graph capture is not supported on this platform");
+  }
+  virtual port::Status LaunchGraph(Stream *stream,
+                                   const GraphExecInterface &graph) {
+    return port::Status(port::error::UNIMPLEMENTED,
+                        "graph capture is not supported on this platform");
+  }
+
   virtual bool DeviceMemoryUsage(int64 *free, int64 *total) const {
     return false;
   }
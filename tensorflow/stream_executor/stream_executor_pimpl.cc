@@ -309,6 +309,24 @@ bool StreamExecutor::SupportsRng() const {
   return implementation_->SupportsRng();
 }
 
+bool StreamExecutor::SupportsGraphCapture() const {
+  return implementation_->SupportsGraphCapture();
+}
+
+port::Status StreamExecutor::BeginGraphCapture(Stream *stream) {
+  return implementation_->BeginGraphCapture(stream);
+}
+
+port::StatusOr<std::unique_ptr<internal::GraphExecInterface>>
+StreamExecutor::EndGraphCapture(Stream *stream) {
+  return implementation_->EndGraphCapture(stream);
+}
+
+port::Status StreamExecutor::LaunchGraph(
+    Stream *stream, const internal::GraphExecInterface &graph) {
+  return implementation_->LaunchGraph(stream, graph);
+}
+
 bool StreamExecutor::SupportsDnn() const {
   return implementation_->SupportsDnn();
 }
@@ -464,6 +464,27 @@ class StreamExecutor {
   // underlying platform.
   dnn::DnnSupport *AsDnn();
 
+  // Returns whether the underlying platform can record the operations enqueued
+  // on a stream into a graph that can be replayed with a single launch.
+  bool SupportsGraphCapture() const;
+
+  // Starts recording the operations subsequently enqueued on stream into a
+  // graph instead of executing them. Every operation enqueued until
+  // EndGraphCapture must be capturable by the platform; host callbacks and
+  // host synchronization (e.g. BlockHostUntilDone) are not.
+  port::Status BeginGraphCapture(Stream *stream);
+
+  // Stops the capture started by BeginGraphCapture on stream and returns the
+  // recorded operations as an executable graph. None of the operations have
+  // run when this returns; launch the graph with LaunchGraph to run them.
+  // The graph keeps the device addresses that were used at capture time.
+  port::StatusOr<std::unique_ptr<internal::GraphExecInterface>>
+  EndGraphCapture(Stream *stream);
+
+  // Enqueues all the operations of graph onto stream at once.
+  port::Status LaunchGraph(Stream *stream,
+                           const internal::GraphExecInterface &graph);
+
   // Turns StreamExecutor operation tracing on or off.
   void EnableTracing(bool enable);
 
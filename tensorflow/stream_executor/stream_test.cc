@@ -199,5 +199,21 @@ TEST_F(StreamTest, FailedSubStreamAfterReturnNotReused) {
   EXPECT_EQ(sub_stream2, sub_stream3);
 }
 
+TEST_F(StreamTest, GraphCaptureUnsupported) {
+  std::unique_ptr<StreamExecutor> executor = NewStreamExecutor();
+  Stream stream(executor.get());
+  stream.Init();
+  EXPECT_TRUE(stream.ok());
+
+  // The host platform doesn't record graphs, so callers must fall back to
+  // enqueueing the work directly.
+  EXPECT_FALSE(executor->SupportsGraphCapture());
+  EXPECT_EQ(port::error::UNIMPLEMENTED,
+            executor->BeginGraphCapture(&stream).code());
+  EXPECT_EQ(port::error::UNIMPLEMENTED,
+            executor->EndGraphCapture(&stream).status().code());
+  EXPECT_TRUE(stream.ok());
+}
+
 }  // namespace
 }  // namespace stream_executor
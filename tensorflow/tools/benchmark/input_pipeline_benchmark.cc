@@ -0,0 +1,313 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A C++ binary to benchmark a tf.data input pipeline standalone, and to find
+// the stage that limits its throughput.
+//
+// See README.md for usage instructions.
+
+#include "tensorflow/tools/benchmark/input_pipeline_benchmark.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/graph_runner.h"
+#include "tensorflow/core/common_runtime/process_function_library_runtime.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/graph_def_util.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace input_pipeline_benchmark {
+
+namespace {
+
+const char kNumParallelCalls[] = "num_parallel_calls";
+
+// Computes the stats of the stages from the model of a run that lasted
+// `wall_nanos`.
+void SummarizeModel(data::model::Model* model, int64 wall_nanos,
+                    BenchmarkResult* result) {
+  double max_busy_fraction = -1;
+  for (const data::model::Model::NodeStats& node : model->GetNodeStats()) {
+    StageStats stage;
+    stage.name = node.name;
+    stage.num_elements = node.num_elements;
+    stage.parallelism = std::max<int64>(node.parallelism, 1);
+    if (node.num_elements > 0) {
+      stage.micros_per_element =
+          node.processing_time_nanos / 1000.0 / node.num_elements;
+    }
+    if (wall_nanos > 0) {
+      stage.busy_fraction = static_cast<double>(node.processing_time_nanos) /
+                            wall_nanos / stage.parallelism;
+    }
+    if (stage.busy_fraction > max_busy_fraction) {
+      max_busy_fraction = stage.busy_fraction;
+      result->bottleneck = stage.name;
+    }
+    result->stages.push_back(std::move(stage));
+  }
+}
+
+}  // namespace
+
+Status RunInputPipeline(const GraphDef& graph_def, const string& dataset_node,
+                        int64 num_elements, int num_threads,
+                        BenchmarkResult* result) {
+  *result = BenchmarkResult();
+  Env* env = Env::Default();
+  GraphDef graph_def_with_defaults = graph_def;
+  TF_RETURN_IF_ERROR(AddDefaultAttrsToGraphDef(&graph_def_with_defaults,
+                                               *OpRegistry::Global(), 0));
+  Graph graph(OpRegistry::Global());
+  TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(
+      GraphConstructorOptions(), graph_def_with_defaults, &graph));
+
+  SessionOptions options;
+  std::vector<Device*> devices;
+  TF_RETURN_IF_ERROR(DeviceFactory::GetFactory(DEVICE_CPU)->CreateDevices(
+      options, "/job:localhost/replica:0/task:0", &devices));
+  DeviceMgr device_mgr(devices);
+  Device* device = devices[0];
+  FunctionLibraryDefinition flib_def(OpRegistry::Global(),
+                                     graph_def_with_defaults.library());
+  thread::ThreadPool pool(env, "input_pipeline_benchmark", num_threads);
+  ProcessFunctionLibraryRuntime pflr(&device_mgr, env, TF_GRAPH_DEF_VERSION,
+                                     &flib_def, OptimizerOptions(), &pool);
+  FunctionLibraryRuntime* lib = pflr.GetFLR(device->name());
+
+  // The variant tensor of the dataset owns it, and lives as long as the
+  // graph runner.
+  GraphRunner graph_runner(device);
+  std::vector<Tensor> outputs;
+  TF_RETURN_IF_ERROR(
+      graph_runner.Run(&graph, lib, {}, {dataset_node}, &outputs));
+  DatasetBase* dataset;
+  TF_RETURN_IF_ERROR(GetDatasetFromVariantTensor(outputs[0], &dataset));
+
+  IteratorContext::Params params;
+  params.env = env;
+  params.runner = [&pool](std::function<void()> c) {
+    pool.Schedule(std::move(c));
+  };
+  params.lib = lib;
+  params.allocator_getter = [device](AllocatorAttributes attrs) {
+    return device->GetAllocator(attrs);
+  };
+  std::shared_ptr<data::model::Model> model =
+      std::make_shared<data::model::Model>();
+  params.model = model;
+  IteratorContext ctx(std::move(params));
+  std::unique_ptr<IteratorBase> iterator;
+  TF_RETURN_IF_ERROR(dataset->MakeIterator(&ctx, "Iterator", &iterator));
+
+  const uint64 start_nanos = env->NowNanos();
+  bool end_of_sequence = false;
+  while (result->num_elements < num_elements) {
+    std::vector<Tensor> element;
+    TF_RETURN_IF_ERROR(iterator->GetNext(&ctx, &element, &end_of_sequence));
+    if (end_of_sequence) {
+      break;
+    }
+    ++result->num_elements;
+  }
+  const int64 wall_nanos = env->NowNanos() - start_nanos;
+  if (wall_nanos > 0) {
+    result->elements_per_second = result->num_elements * 1e9 / wall_nanos;
+  }
+  // The stats are collected before the iterator is destroyed, which removes
+  // its nodes from the model.
+  SummarizeModel(model.get(), wall_nanos, result);
+  return Status::OK();
+}
+
+Status SetParallelism(int64 parallelism, GraphDef* graph_def,
+                      int* num_rewritten) {
+  *num_rewritten = 0;
+  std::vector<NodeDef> constants;
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    const OpDef* op_def;
+    TF_RETURN_IF_ERROR(OpRegistry::Global()->LookUpOpDef(node.op(), &op_def));
+    DataType dtype = DT_INVALID;
+    for (const OpDef::ArgDef& arg : op_def->input_arg()) {
+      if (arg.name() == kNumParallelCalls) {
+        dtype = arg.type();
+      }
+    }
+    if (dtype == DT_INVALID) {
+      continue;
+    }
+    NameRangeMap inputs;
+    TF_RETURN_IF_ERROR(NameRangesForNode(node, *op_def, &inputs, nullptr));
+    const int index = inputs[kNumParallelCalls].first;
+    if (index >= node.input_size()) {
+      return errors::InvalidArgument("Node ", node.name(), " has no ",
+                                     kNumParallelCalls, " input");
+    }
+    // The original constant may have other consumers, so a new one is added.
+    Tensor value(dtype, TensorShape({}));
+    if (dtype == DT_INT32) {
+      value.scalar<int32>()() = parallelism;
+    } else {
+      value.scalar<int64>()() = parallelism;
+    }
+    NodeDef constant;
+    TF_RETURN_IF_ERROR(
+        NodeDefBuilder(strings::StrCat(node.name(), "/", kNumParallelCalls,
+                                       "_", parallelism),
+                       "Const")
+            .Attr("dtype", dtype)
+            .Attr("value", value)
+            .Finalize(&constant));
+    node.set_input(index, constant.name());
+    constants.push_back(std::move(constant));
+    ++*num_rewritten;
+  }
+  for (NodeDef& constant : constants) {
+    *graph_def->add_node() = std::move(constant);
+  }
+  return Status::OK();
+}
+
+string FormatResult(const BenchmarkResult& result) {
+  size_t width = strlen("Stage");
+  for (const StageStats& stage : result.stages) {
+    width = std::max(width, stage.name.size());
+  }
+  string output = strings::Printf(
+      "%lld elements, %.1f elements/sec\n"
+      "%-*s %10s %11s %12s %8s\n",
+      static_cast<long long>(result.num_elements), result.elements_per_second,
+      static_cast<int>(width), "Stage", "Elements", "Parallelism",
+      "us/element", "Busy");
+  for (const StageStats& stage : result.stages) {
+    strings::Appendf(&output, "%-*s %10lld %11lld %12.2f %7.1f%%%s\n",
+                     static_cast<int>(width), stage.name.c_str(),
+                     static_cast<long long>(stage.num_elements),
+                     static_cast<long long>(stage.parallelism),
+                     stage.micros_per_element, stage.busy_fraction * 100,
+                     stage.name == result.bottleneck ? "  <- bottleneck" : "");
+  }
+  return output;
+}
+
+int Main(int argc, char** argv) {
+  string graph = "";
+  string dataset_node = "";
+  int64 num_elements = 1000;
+  int num_threads = port::NumSchedulableCPUs();
+  string parallelism_sweep = "";
+
+  std::vector<Flag> flag_list = {
+      Flag("graph", &graph, "GraphDef file name, binary or text"),
+      Flag("dataset_node", &dataset_node,
+           "name of the node producing the dataset to benchmark"),
+      Flag("num_elements", &num_elements,
+           "number of elements to produce in each run"),
+      Flag("num_threads", &num_threads,
+           "number of threads for the functions and parallel datasets"),
+      Flag("parallelism_sweep", &parallelism_sweep,
+           "comma-separated values of num_parallel_calls to run the parallel "
+           "datasets with, e.g. 1,2,4,8; empty to run the graph as is"),
+  };
+  string usage = Flags::Usage(argv[0], flag_list);
+  const bool parse_result = Flags::Parse(&argc, argv, flag_list);
+  if (!parse_result || graph.empty() || dataset_node.empty()) {
+    LOG(ERROR) << usage;
+    return -1;
+  }
+  ::tensorflow::port::InitMain(argv[0], &argc, &argv);
+
+  GraphDef graph_def;
+  Status s = ReadBinaryProto(Env::Default(), graph, &graph_def);
+  if (!s.ok()) {
+    s = ReadTextProto(Env::Default(), graph, &graph_def);
+  }
+  if (!s.ok()) {
+    LOG(ERROR) << "Could not read " << graph << ": " << s;
+    return -1;
+  }
+
+  std::vector<int64> parallelisms;
+  if (!str_util::SplitAndParseAsInts(parallelism_sweep, ',', &parallelisms)) {
+    LOG(ERROR) << "Invalid --parallelism_sweep: " << parallelism_sweep;
+    return -1;
+  }
+
+  if (parallelisms.empty()) {
+    BenchmarkResult result;
+    s = RunInputPipeline(graph_def, dataset_node, num_elements, num_threads,
+                         &result);
+    if (!s.ok()) {
+      LOG(ERROR) << "Benchmark failed: " << s;
+      return -1;
+    }
+    LOG(INFO) << "\n" << FormatResult(result);
+    return 0;
+  }
+
+  string scaling = strings::Printf("%11s %14s  %s\n", "Parallelism",
+                                   "Elements/sec", "Bottleneck");
+  for (int64 parallelism : parallelisms) {
+    GraphDef rewritten = graph_def;
+    int num_rewritten;
+    s = SetParallelism(parallelism, &rewritten, &num_rewritten);
+    if (s.ok() && num_rewritten == 0) {
+      s = errors::InvalidArgument("The graph has no parallel dataset");
+    }
+    BenchmarkResult result;
+    if (s.ok()) {
+      s = RunInputPipeline(rewritten, dataset_node, num_elements, num_threads,
+                           &result);
+    }
+    if (!s.ok()) {
+      LOG(ERROR) << "Benchmark with parallelism " << parallelism
+                 << " failed: " << s;
+      return -1;
+    }
+    LOG(INFO) << "Parallelism " << parallelism << ":\n"
+              << FormatResult(result);
+    strings::Appendf(&scaling, "%11lld %14.1f  %s\n",
+                     static_cast<long long>(parallelism),
+                     result.elements_per_second, result.bottleneck.c_str());
+  }
+  LOG(INFO) << "Scaling:\n" << scaling;
+  return 0;
+}
+
+}  // namespace input_pipeline_benchmark
+}  // namespace tensorflow
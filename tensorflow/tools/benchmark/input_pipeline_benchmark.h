@@ -0,0 +1,76 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_TOOLS_BENCHMARK_INPUT_PIPELINE_BENCHMARK_H_
+#define TENSORFLOW_TOOLS_BENCHMARK_INPUT_PIPELINE_BENCHMARK_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace input_pipeline_benchmark {
+
+// How busy an iterator of the input pipeline was during a benchmark.
+struct StageStats {
+  // The sequence of iterators leading up to the iterator, e.g.
+  // "Iterator::Prefetch::Map".
+  string name;
+  int64 num_elements = 0;
+  int64 parallelism = 1;
+  // The time spent producing the elements, excluding the time spent in the
+  // inputs, per element.
+  double micros_per_element = 0;
+  // The fraction of the time of the benchmark during which the threads of
+  // the iterator were producing elements. The iterator whose fraction is the
+  // highest limits the throughput of the pipeline.
+  double busy_fraction = 0;
+};
+
+struct BenchmarkResult {
+  int64 num_elements = 0;
+  double elements_per_second = 0;
+  // Sorted by name, so that the inputs of an iterator follow it.
+  std::vector<StageStats> stages;
+  // The name of the busiest stage.
+  string bottleneck;
+};
+
+// Runs the dataset produced by `dataset_node` in `graph_def` standalone on
+// the CPU, with `num_threads` threads for its functions and parallel
+// iterators, until it produced `num_elements` elements or reached the end of
+// its sequence. Stateful ops in the graph, e.g. iterators, are not supported.
+Status RunInputPipeline(const GraphDef& graph_def, const string& dataset_node,
+                        int64 num_elements, int num_threads,
+                        BenchmarkResult* result);
+
+// Sets the `num_parallel_calls` of all the parallel datasets of `graph_def`
+// to `parallelism`, and returns their number in `num_rewritten`.
+Status SetParallelism(int64 parallelism, GraphDef* graph_def,
+                      int* num_rewritten);
+
+// Returns a human-readable table of the stages of `result`.
+string FormatResult(const BenchmarkResult& result);
+
+// Handles all setup and argument parsing.
+int Main(int argc, char** argv);
+
+}  // namespace input_pipeline_benchmark
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_TOOLS_BENCHMARK_INPUT_PIPELINE_BENCHMARK_H_
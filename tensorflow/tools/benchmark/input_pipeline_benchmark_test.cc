@@ -0,0 +1,125 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/tools/benchmark/input_pipeline_benchmark.h"
+
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace input_pipeline_benchmark {
+namespace {
+
+template <typename T>
+void AddConst(const string& name, T value, GraphDef* graph_def) {
+  Tensor tensor(DataTypeToEnum<T>::value, TensorShape({}));
+  tensor.scalar<T>()() = value;
+  TF_CHECK_OK(NodeDefBuilder(name, "Const")
+                  .Attr("dtype", DataTypeToEnum<T>::value)
+                  .Attr("value", tensor)
+                  .Finalize(graph_def->add_node()));
+}
+
+// Returns range(100).map(x * 2, num_parallel_calls=2).batch(10).
+GraphDef CreateGraphDef() {
+  GraphDef graph_def;
+  *graph_def.mutable_library()->add_function() = test::function::XTimesTwo();
+  const std::vector<DataType> types = {DT_INT64};
+  std::vector<TensorShapeProto> shapes(1);
+  AddConst<int64>("start", 0, &graph_def);
+  AddConst<int64>("stop", 100, &graph_def);
+  AddConst<int64>("step", 1, &graph_def);
+  TF_CHECK_OK(NodeDefBuilder("range", "RangeDataset")
+                  .Input("start", 0, DT_INT64)
+                  .Input("stop", 0, DT_INT64)
+                  .Input("step", 0, DT_INT64)
+                  .Attr("output_types", types)
+                  .Attr("output_shapes", shapes)
+                  .Finalize(graph_def.add_node()));
+  AddConst<int32>("num_parallel_calls", 2, &graph_def);
+  NameAttrList f;
+  f.set_name("XTimesTwo");
+  (*f.mutable_attr())["T"].set_type(DT_INT64);
+  TF_CHECK_OK(NodeDefBuilder("map", "ParallelMapDataset")
+                  .Input("range", 0, DT_VARIANT)
+                  .Input(gtl::ArraySlice<NodeDefBuilder::NodeOut>())
+                  .Input("num_parallel_calls", 0, DT_INT32)
+                  .Attr("f", f)
+                  .Attr("Targuments", DataTypeVector())
+                  .Attr("output_types", types)
+                  .Attr("output_shapes", shapes)
+                  .Finalize(graph_def.add_node()));
+  AddConst<int64>("batch_size", 10, &graph_def);
+  shapes[0].add_dim()->set_size(-1);
+  TF_CHECK_OK(NodeDefBuilder("batch", "BatchDataset")
+                  .Input("map", 0, DT_VARIANT)
+                  .Input("batch_size", 0, DT_INT64)
+                  .Attr("output_types", types)
+                  .Attr("output_shapes", shapes)
+                  .Finalize(graph_def.add_node()));
+  return graph_def;
+}
+
+TEST(InputPipelineBenchmarkTest, RunsToEndOfSequence) {
+  BenchmarkResult result;
+  TF_ASSERT_OK(RunInputPipeline(CreateGraphDef(), "batch", 1000, 4, &result));
+  EXPECT_EQ(10, result.num_elements);
+  EXPECT_GT(result.elements_per_second, 0);
+  bool found_map = false;
+  for (const StageStats& stage : result.stages) {
+    if (stage.name == "Iterator::Batch::ParallelMap") {
+      found_map = true;
+      EXPECT_EQ(100, stage.num_elements);
+      EXPECT_EQ(2, stage.parallelism);
+    }
+  }
+  EXPECT_TRUE(found_map);
+  EXPECT_FALSE(result.bottleneck.empty());
+  EXPECT_NE(string::npos, FormatResult(result).find("<- bottleneck"));
+}
+
+TEST(InputPipelineBenchmarkTest, StopsAfterNumElements) {
+  BenchmarkResult result;
+  TF_ASSERT_OK(RunInputPipeline(CreateGraphDef(), "batch", 3, 4, &result));
+  EXPECT_EQ(3, result.num_elements);
+}
+
+TEST(InputPipelineBenchmarkTest, SetParallelism) {
+  GraphDef graph_def = CreateGraphDef();
+  const int num_nodes = graph_def.node_size();
+  int num_rewritten;
+  TF_ASSERT_OK(SetParallelism(8, &graph_def, &num_rewritten));
+  EXPECT_EQ(1, num_rewritten);
+  ASSERT_EQ(num_nodes + 1, graph_def.node_size());
+  const NodeDef& constant = graph_def.node(num_nodes);
+  EXPECT_EQ("map/num_parallel_calls_8", constant.name());
+  EXPECT_EQ(DT_INT32, constant.attr().at("dtype").type());
+
+  BenchmarkResult result;
+  TF_ASSERT_OK(RunInputPipeline(graph_def, "batch", 1000, 4, &result));
+  for (const StageStats& stage : result.stages) {
+    if (stage.name == "Iterator::Batch::ParallelMap") {
+      EXPECT_EQ(8, stage.parallelism);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace input_pipeline_benchmark
+}  // namespace tensorflow
@@ -331,16 +331,19 @@ Status TransformGraph(const std::vector<string>& inputs,
       if (ignore_errors) {
         LOG(ERROR) << transform_name << ": Ignoring error "
                    << transform_result.error_message();
-        transformed_graph_def = *graph_def;
+        // Keep the input graph as it is.
+        continue;
       } else {
         return transform_result;
       }
     }
-    // Copy over the library from the original input graph.
-    *transformed_graph_def.mutable_library() = graph_def->library();
+    // Move over the library from the original input graph.
+    transformed_graph_def.mutable_library()->Swap(graph_def->mutable_library());
     TF_RETURN_IF_ERROR(IsGraphValid(transformed_graph_def));
 
-    *graph_def = transformed_graph_def;
+    // Graphs can hold gigabytes of constants, so the transformed graph is
+    // swapped in instead of copied, and the input graph freed.
+    graph_def->Swap(&transformed_graph_def);
   }
   return Status::OK();
 }
@@ -17,8 +17,10 @@ limitations under the License.
 
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
 namespace graph_transforms {
@@ -36,27 +38,38 @@ void RecordMatchedNodes(const NodeMatch& match,
   }
 }
 
-inline uint64 Hash64String(const string& input) {
-  return Hash64(input.data(), input.size());
-}
-}  // namespace
-
-void MatchedNodesAsArray(const NodeMatch& match, std::vector<NodeDef>* result) {
+// Like MatchedNodesAsArray(), but without copying the nodes or the matches,
+// which can hold large tensors.
+void MatchedNodePointers(const NodeMatch& match,
+                         std::vector<const NodeDef*>* result) {
   std::set<string> found_nodes;
-  std::vector<NodeMatch> current_matches = {match};
+  std::vector<const NodeMatch*> current_matches = {&match};
   while (!current_matches.empty()) {
-    std::vector<NodeMatch> next_matches;
-    for (const NodeMatch& current_match : current_matches) {
-      if (found_nodes.count(current_match.node.name())) {
+    std::vector<const NodeMatch*> next_matches;
+    for (const NodeMatch* current_match : current_matches) {
+      if (found_nodes.count(current_match->node.name())) {
         continue;
       }
-      found_nodes.insert(current_match.node.name());
-      result->push_back(current_match.node);
-      for (const NodeMatch& input_match : current_match.inputs) {
-        next_matches.push_back(input_match);
+      found_nodes.insert(current_match->node.name());
+      result->push_back(&current_match->node);
+      for (const NodeMatch& input_match : current_match->inputs) {
+        next_matches.push_back(&input_match);
       }
     }
-    current_matches = next_matches;
+    current_matches = std::move(next_matches);
+  }
+}
+
+inline uint64 Hash64String(const string& input) {
+  return Hash64(input.data(), input.size());
+}
+}  // namespace
+
+void MatchedNodesAsArray(const NodeMatch& match, std::vector<NodeDef>* result) {
+  std::vector<const NodeDef*> nodes;
+  MatchedNodePointers(match, &nodes);
+  for (const NodeDef* node : nodes) {
+    result->push_back(*node);
   }
 }
 
@@ -364,101 +377,138 @@ Status ReplaceMatchingOpTypes(
                                const std::set<string>&, std::vector<NodeDef>*)>&
         node_generator,
     const ReplaceMatchingOpTypesOptions& options, GraphDef* output_graph_def) {
-  // Start off by retrieving all the matching subgraphs.
-  GraphMatcher matcher(input_graph_def);
+  // Start off by retrieving all the matching subgraphs. The matcher keeps a
+  // sorted copy of the graph, so it's released as soon as it's done.
   std::vector<NodeMatch> matches;
-  TF_RETURN_IF_ERROR(matcher.GetOpTypeMatches(pattern, &matches));
+  {
+    GraphMatcher matcher(input_graph_def);
+    TF_RETURN_IF_ERROR(matcher.GetOpTypeMatches(pattern, &matches));
+  }
 
   // Do some housekeeping so we can easily look up the resulting matches given
   // a node name.
   std::set<string> matched_nodes;
-  std::map<string, const NodeMatch*> matches_by_head_name;
-  for (const NodeMatch& match : matches) {
-    matches_by_head_name[match.node.name()] = &match;
-    RecordMatchedNodes(match, &matched_nodes);
+  std::map<string, int> match_index_by_head_name;
+  for (int i = 0; i < matches.size(); ++i) {
+    match_index_by_head_name[matches[i].node.name()] = i;
+    RecordMatchedNodes(matches[i], &matched_nodes);
   }
   std::map<string, std::vector<const NodeDef*>> outputs_map;
   MapNodesToOutputs(input_graph_def, &outputs_map);
-
-  // Go through all the nodes in the input graph, see if they are part of a
-  // match or if they can be left untouched.
-  output_graph_def->Clear();
+  // The matches in the order of their first nodes in the input graph.
+  std::vector<int> match_order;
   for (const NodeDef& input_node : input_graph_def.node()) {
-    if (matches_by_head_name.count(input_node.name())) {
-      // This node is the beginning of a match, so call the replacement function
-      // after setting up some information it will need.
-      const NodeMatch* match = matches_by_head_name[input_node.name()];
-      std::vector<NodeDef> matched_nodes_array;
-      MatchedNodesAsArray(*match, &matched_nodes_array);
-      // This tells us whether a node is part of the current match.
-      std::set<string> matched_nodes_lookup;
-      for (const NodeDef& matched_node : matched_nodes_array) {
-        matched_nodes_lookup.insert(matched_node.name());
-      }
-      // These are helper arrays that the replacement function can use to tell
-      // whether it can safely remove an internal node (because nothing outside
-      // of the match uses it) or whether external nodes depend on it.
-      std::set<string> input_nodes;
-      std::set<string> output_nodes;
-      for (const NodeDef& matched_node : matched_nodes_array) {
-        // Look through all of this node's inputs, and if any of them come from
-        // outside the match, then this should be noted as one of the external
-        // inputs of the subgraph.
-        for (const string& input_name : matched_node.input()) {
-          string input_node_name = NodeNameFromInput(input_name);
-          if (!matched_nodes_lookup.count(input_node_name)) {
-            input_nodes.insert(matched_node.name());
-          }
-        }
-        // Do a reverse input lookup, to see which other nodes use the current
-        // one as an input. If any of those nodes are outside the match
-        // subgraph, then the current node is marked as an output node that
-        // shouldn't be removed.
-        if (outputs_map.count(matched_node.name())) {
-          for (const NodeDef* dependent_node :
-               outputs_map[matched_node.name()]) {
-            if (!matched_nodes_lookup.count(dependent_node->name())) {
-              output_nodes.insert(matched_node.name());
-            }
-          }
+    auto match_index = match_index_by_head_name.find(input_node.name());
+    if (match_index != match_index_by_head_name.end()) {
+      match_order.push_back(match_index->second);
+    }
+  }
+
+  // Calls the replacement function for one match, after setting up some
+  // information it will need.
+  std::vector<std::vector<NodeDef>> new_nodes_by_match(matches.size());
+  std::vector<Status> statuses(matches.size());
+  auto replace_match = [&](int i) {
+    const NodeMatch& match = matches[i];
+    std::vector<const NodeDef*> matched_nodes_array;
+    MatchedNodePointers(match, &matched_nodes_array);
+    // This tells us whether a node is part of the current match.
+    std::set<string> matched_nodes_lookup;
+    for (const NodeDef* matched_node : matched_nodes_array) {
+      matched_nodes_lookup.insert(matched_node->name());
+    }
+    // These are helper arrays that the replacement function can use to tell
+    // whether it can safely remove an internal node (because nothing outside
+    // of the match uses it) or whether external nodes depend on it.
+    std::set<string> input_nodes;
+    std::set<string> output_nodes;
+    for (const NodeDef* matched_node : matched_nodes_array) {
+      // Look through all of this node's inputs, and if any of them come from
+      // outside the match, then this should be noted as one of the external
+      // inputs of the subgraph.
+      for (const string& input_name : matched_node->input()) {
+        string input_node_name = NodeNameFromInput(input_name);
+        if (!matched_nodes_lookup.count(input_node_name)) {
+          input_nodes.insert(matched_node->name());
         }
       }
-      // Call the generator function and add all the returned nodes to the
-      // graph.
-      std::vector<NodeDef> new_nodes;
-      TF_RETURN_IF_ERROR(
-          node_generator(*match, input_nodes, output_nodes, &new_nodes));
-      std::set<string> new_node_names;
-      for (const NodeDef& new_node : new_nodes) {
-        new_node_names.insert(new_node.name());
-      }
-      // Check to make sure the generator function preserved all of the nodes
-      // that are used elsewhere in the graph, and add them back in if not.
-      bool abort_replacement = false;
-      if (!options.allow_inconsistencies) {
-        for (const string& expected_output : output_nodes) {
-          if (!new_node_names.count(expected_output)) {
-            LOG(WARNING) << "Expected " << expected_output
-                         << " to be preserved.";
-            abort_replacement = true;
+      // Do a reverse input lookup, to see which other nodes use the current
+      // one as an input. If any of those nodes are outside the match
+      // subgraph, then the current node is marked as an output node that
+      // shouldn't be removed.
+      auto outputs = outputs_map.find(matched_node->name());
+      if (outputs != outputs_map.end()) {
+        for (const NodeDef* dependent_node : outputs->second) {
+          if (!matched_nodes_lookup.count(dependent_node->name())) {
+            output_nodes.insert(matched_node->name());
           }
         }
       }
-      if (abort_replacement) {
-        LOG(WARNING) << "Generator function didn't preserve needed nodes, "
-                     << "copying old replacements back in instead.";
-        std::vector<NodeDef> old_nodes;
-        MatchedNodesAsArray(*match, &old_nodes);
-        for (const NodeDef& old_node : old_nodes) {
-          NodeDef* added_node = output_graph_def->mutable_node()->Add();
-          *added_node = old_node;
-        }
-      } else {
-        for (const NodeDef& new_node : new_nodes) {
-          NodeDef* added_node = output_graph_def->mutable_node()->Add();
-          *added_node = new_node;
+    }
+    // Call the generator function.
+    std::vector<NodeDef>& new_nodes = new_nodes_by_match[i];
+    statuses[i] = node_generator(match, input_nodes, output_nodes, &new_nodes);
+    if (!statuses[i].ok()) return;
+    std::set<string> new_node_names;
+    for (const NodeDef& new_node : new_nodes) {
+      new_node_names.insert(new_node.name());
+    }
+    // Check to make sure the generator function preserved all of the nodes
+    // that are used elsewhere in the graph, and add them back in if not.
+    bool abort_replacement = false;
+    if (!options.allow_inconsistencies) {
+      for (const string& expected_output : output_nodes) {
+        if (!new_node_names.count(expected_output)) {
+          LOG(WARNING) << "Expected " << expected_output
+                       << " to be preserved.";
+          abort_replacement = true;
         }
       }
+    }
+    if (abort_replacement) {
+      LOG(WARNING) << "Generator function didn't preserve needed nodes, "
+                   << "copying old replacements back in instead.";
+      new_nodes.clear();
+      MatchedNodesAsArray(match, &new_nodes);
+    }
+  };
+  if (options.num_threads > 1 && match_order.size() > 1) {
+    thread::ThreadPool thread_pool(Env::Default(), "replace_matching_op_types",
+                                   options.num_threads);
+    // Generators typically decode and re-encode tensors, so each match is
+    // expensive enough to be scheduled on its own.
+    const int64 kCostPerMatch = 1000000;
+    thread_pool.ParallelFor(
+        match_order.size(), kCostPerMatch,
+        [&replace_match, &match_order](int64 begin, int64 end) {
+          for (int64 i = begin; i < end; ++i) {
+            replace_match(match_order[i]);
+          }
+        });
+  } else {
+    for (int i : match_order) {
+      replace_match(i);
+      if (!statuses[i].ok()) break;
+    }
+  }
+  // Report the error of the first failing match in graph order, like a
+  // sequential replacement would.
+  for (int i : match_order) {
+    TF_RETURN_IF_ERROR(statuses[i]);
+  }
+
+  // Go through all the nodes in the input graph, see if they are part of a
+  // match or if they can be left untouched.
+  output_graph_def->Clear();
+  for (const NodeDef& input_node : input_graph_def.node()) {
+    auto match_index = match_index_by_head_name.find(input_node.name());
+    if (match_index != match_index_by_head_name.end()) {
+      // This node is the beginning of a match, so add all the nodes that
+      // replace it to the graph. They're moved rather than copied, since
+      // they can hold large tensors.
+      for (NodeDef& new_node : new_nodes_by_match[match_index->second]) {
+        output_graph_def->mutable_node()->Add()->Swap(&new_node);
+      }
     } else if (!matched_nodes.count(input_node.name())) {
       // This node isn't part of any match, so just copy it over.
       NodeDef* added_node = output_graph_def->mutable_node()->Add();
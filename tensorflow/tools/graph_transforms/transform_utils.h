@@ -183,6 +183,11 @@ struct ReplaceMatchingOpTypesOptions {
   // Whether to raise an error if the graph is left with dangling inputs. If you
   // enable this option, you must fix inconsistencies in a later pass.
   bool allow_inconsistencies;
+
+  // If greater than 1, calls the replacement function for different matches
+  // on this many threads, so it must be safe to call concurrently. The
+  // resulting graph is the same as with a single thread.
+  int32 num_threads;
 };
 
 // Replaces all of the matching sub-graphs with new ops. This calls into the
@@ -21,6 +21,8 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -488,6 +490,80 @@ class TransformUtilsTest : public ::testing::Test {
     }
   }
 
+  void TestReplaceMatchingOpTypesInParallel() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    std::vector<Output> consts;
+    for (int i = 0; i < 20; ++i) {
+      Tensor data(DT_FLOAT, TensorShape({10}));
+      test::FillIota<float>(&data, i);
+      consts.push_back(Const(root.WithOpName(strings::StrCat("const_", i)),
+                             Input::Initializer(data)));
+    }
+    Output sum = AddN(root.WithOpName("output"), consts);
+
+    GraphDef graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&graph_def));
+
+    // Doubles the values of the constants, with an error for some of them.
+    auto double_const = [](const NodeMatch& match,
+                           const std::set<string>& input_nodes,
+                           const std::set<string>& output_nodes,
+                           std::vector<NodeDef>* new_nodes) {
+      const NodeDef& node = match.node;
+      if (node.name() == "const_7" || node.name() == "const_13") {
+        return errors::InvalidArgument("Bad node ", node.name());
+      }
+      Tensor tensor;
+      if (!tensor.FromProto(node.attr().at("value").tensor())) {
+        return errors::InvalidArgument("Bad tensor in ", node.name());
+      }
+      tensor.flat<float>() = tensor.flat<float>() * 2.0f;
+      NodeDef new_node = node;
+      SetNodeTensorAttr<float>("value", tensor, &new_node);
+      new_nodes->push_back(new_node);
+      return Status::OK();
+    };
+    auto double_valid_const =
+        [&double_const](const NodeMatch& match,
+                        const std::set<string>& input_nodes,
+                        const std::set<string>& output_nodes,
+                        std::vector<NodeDef>* new_nodes) {
+          if (match.node.name() == "const_7" ||
+              match.node.name() == "const_13") {
+            new_nodes->push_back(match.node);
+            return Status::OK();
+          }
+          return double_const(match, input_nodes, output_nodes, new_nodes);
+        };
+
+    ReplaceMatchingOpTypesOptions parallel_options;
+    parallel_options.allow_inconsistencies = false;
+    parallel_options.num_threads = 4;
+
+    GraphDef serial_graph_def;
+    TF_ASSERT_OK(ReplaceMatchingOpTypes(graph_def, {"Const"},
+                                        double_valid_const, {},
+                                        &serial_graph_def));
+    GraphDef parallel_graph_def;
+    TF_ASSERT_OK(ReplaceMatchingOpTypes(graph_def, {"Const"},
+                                        double_valid_const, parallel_options,
+                                        &parallel_graph_def));
+    EXPECT_EQ(serial_graph_def.DebugString(),
+              parallel_graph_def.DebugString());
+    EXPECT_NE(graph_def.DebugString(), parallel_graph_def.DebugString());
+
+    // The error is the one of the first match in graph order, as when the
+    // matches are replaced one after another.
+    GraphDef failed_graph_def;
+    Status status = ReplaceMatchingOpTypes(graph_def, {"Const"}, double_const,
+                                           parallel_options, &failed_graph_def);
+    EXPECT_TRUE(errors::IsInvalidArgument(status));
+    EXPECT_TRUE(str_util::StrContains(status.error_message(), "const_7"))
+        << status;
+  }
+
   void TestMatchedNodesAsArray() {
     NodeMatch fourth;
     fourth.node.set_name("fourth");
@@ -1106,6 +1182,10 @@ TEST_F(TransformUtilsTest, TestReplaceMatchingOpTypes) {
   TestReplaceMatchingOpTypes();
 }
 
+TEST_F(TransformUtilsTest, TestReplaceMatchingOpTypesInParallel) {
+  TestReplaceMatchingOpTypesInParallel();
+}
+
 TEST_F(TransformUtilsTest, TestMatchedNodesAsArray) {
   TestMatchedNodesAsArray();
 }
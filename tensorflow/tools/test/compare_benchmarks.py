@@ -0,0 +1,64 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Flags the benchmarks that regressed against a baseline.
+
+Both files are the JSON TestResults written by run_and_gather_logs, e.g. by
+the tf_cc_logged_benchmark targets with --test_log_output_dir:
+
+  compare_benchmarks --baseline=old.json --results=new.json --threshold=0.05
+
+Exits with status 1 if a benchmark regressed.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import sys
+
+from tensorflow.python.platform import app
+from tensorflow.tools.test import compare_benchmarks_lib
+
+FLAGS = None
+
+
+def main(unused_args):
+  comparisons = compare_benchmarks_lib.compare(
+      compare_benchmarks_lib.read_test_results(FLAGS.baseline),
+      compare_benchmarks_lib.read_test_results(FLAGS.results),
+      FLAGS.threshold)
+  print(compare_benchmarks_lib.format_comparisons(comparisons))
+  regressions = [c.name for c in comparisons if c.regressed]
+  if regressions:
+    print("%d of %d benchmarks regressed by more than %.1f%%" %
+          (len(regressions), len(comparisons), FLAGS.threshold * 100))
+    sys.exit(1)
+
+
+if __name__ == "__main__":
+  parser = argparse.ArgumentParser()
+  parser.add_argument(
+      "--baseline", type=str, default="",
+      help="TestResults JSON file of the baseline.")
+  parser.add_argument(
+      "--results", type=str, default="",
+      help="TestResults JSON file to compare against the baseline.")
+  parser.add_argument(
+      "--threshold", type=float, default=0.05,
+      help="Relative slowdown of the wall time above which a benchmark is "
+      "reported as a regression.")
+  FLAGS, unparsed = parser.parse_known_args()
+  app.run(main=main, argv=[sys.argv[0]] + unparsed)
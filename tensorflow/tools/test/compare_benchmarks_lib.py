@@ -0,0 +1,93 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Library for comparing benchmark results against a baseline."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import collections
+
+from google.protobuf import json_format
+
+from tensorflow.core.util import test_log_pb2
+from tensorflow.python.platform import gfile
+
+# The comparison of a benchmark with its baseline. `wall_time` and
+# `baseline_wall_time` are None if the benchmark is missing from the results
+# or from the baseline, and `regressed` is True if it got slower by more than
+# the threshold.
+Comparison = collections.namedtuple(
+    "Comparison", ["name", "baseline_wall_time", "wall_time", "ratio",
+                   "regressed"])
+
+
+def read_test_results(path):
+  """Reads the TestResults written as JSON by run_and_gather_logs."""
+  test_results = test_log_pb2.TestResults()
+  json_format.Parse(gfile.GFile(path).read(), test_results)
+  return test_results
+
+
+def wall_times(test_results):
+  """Returns a dict of the wall time per iteration of each benchmark."""
+  return {entry.name: entry.wall_time
+          for entry in test_results.entries.entry}
+
+
+def compare(baseline, results, threshold):
+  """Compares the wall times of `results` against those of `baseline`.
+
+  Args:
+    baseline: The TestResults to compare against.
+    results: The TestResults to compare.
+    threshold: The relative slowdown above which a benchmark has regressed,
+      e.g. 0.05 for 5%.
+
+  Returns:
+    A list of Comparison, sorted by benchmark name.
+  """
+  baseline_times = wall_times(baseline)
+  times = wall_times(results)
+  comparisons = []
+  for name in sorted(set(baseline_times) | set(times)):
+    baseline_time = baseline_times.get(name)
+    time = times.get(name)
+    ratio = None
+    if baseline_time and time is not None:
+      ratio = time / baseline_time
+    comparisons.append(
+        Comparison(name=name, baseline_wall_time=baseline_time,
+                   wall_time=time, ratio=ratio,
+                   regressed=ratio is not None and ratio > 1 + threshold))
+  return comparisons
+
+
+def format_comparisons(comparisons):
+  """Returns a table of the comparisons, for printing."""
+
+  def format_time(t):
+    return "N/A" if t is None else "%.3e" % t
+
+  width = max([len("Benchmark")] + [len(c.name) for c in comparisons])
+  lines = ["%-*s %12s %12s %8s" % (width, "Benchmark", "Baseline(s)",
+                                   "Time(s)", "Ratio")]
+  for c in comparisons:
+    lines.append("%-*s %12s %12s %8s%s" % (
+        width, c.name, format_time(c.baseline_wall_time),
+        format_time(c.wall_time),
+        "N/A" if c.ratio is None else "%.3f" % c.ratio,
+        "  REGRESSION" if c.regressed else ""))
+  return "\n".join(lines)
@@ -0,0 +1,72 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for compare_benchmarks_lib."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+from google.protobuf import json_format
+
+from tensorflow.core.util import test_log_pb2
+from tensorflow.python.platform import gfile
+from tensorflow.python.platform import googletest
+from tensorflow.tools.test import compare_benchmarks_lib
+
+
+def _test_results(wall_times):
+  test_results = test_log_pb2.TestResults()
+  for name, wall_time in wall_times.items():
+    entry = test_results.entries.entry.add()
+    entry.name = name
+    entry.wall_time = wall_time
+  return test_results
+
+
+class CompareBenchmarksTest(googletest.TestCase):
+
+  def testCompare(self):
+    baseline = _test_results({"BM_A": 1.0, "BM_B": 2.0, "BM_C": 1.0})
+    results = _test_results({"BM_A": 1.1, "BM_B": 2.02, "BM_D": 1.0})
+    comparisons = compare_benchmarks_lib.compare(baseline, results, 0.05)
+    self.assertEqual(["BM_A", "BM_B", "BM_C", "BM_D"],
+                     [c.name for c in comparisons])
+    self.assertAlmostEqual(1.1, comparisons[0].ratio)
+    self.assertTrue(comparisons[0].regressed)
+    self.assertFalse(comparisons[1].regressed)
+    # Benchmarks missing on either side are reported but not compared.
+    self.assertIsNone(comparisons[2].wall_time)
+    self.assertIsNone(comparisons[2].ratio)
+    self.assertIsNone(comparisons[3].baseline_wall_time)
+    self.assertFalse(comparisons[3].regressed)
+
+    table = compare_benchmarks_lib.format_comparisons(comparisons)
+    self.assertIn("REGRESSION", table.splitlines()[1])
+    self.assertNotIn("REGRESSION", table.splitlines()[2])
+
+  def testReadTestResults(self):
+    path = os.path.join(googletest.GetTempDir(), "results.json")
+    gfile.GFile(path, "w").write(
+        json_format.MessageToJson(_test_results({"BM_A": 0.5})))
+    self.assertEqual(
+        {"BM_A": 0.5},
+        compare_benchmarks_lib.wall_times(
+            compare_benchmarks_lib.read_test_results(path)))
+
+
+if __name__ == "__main__":
+  googletest.main()